@@ -39,6 +39,11 @@ llvm::cl::opt<std::string> executionBackend(
     "backend",
     llvm::cl::desc("Backend to use, e.g., Interpreter, CPU, OpenCL:"),
     llvm::cl::Optional, llvm::cl::init("Interpreter"), llvm::cl::cat(mnistCat));
+llvm::cl::opt<unsigned> numReplicas(
+    "num-replicas",
+    llvm::cl::desc("Number of devices training shards of each batch in "
+                   "parallel, each shard having the minibatch size"),
+    llvm::cl::Optional, llvm::cl::init(1), llvm::cl::cat(mnistCat));
 } // namespace
 
 unsigned loadMNIST(Tensor &imageInputs, Tensor &labelInputs) {
@@ -121,6 +126,29 @@ void trainModel(ExecutionEngine &EE, PlaceholderBindings &bindings, Function *F,
   TC.L2Decay = 0.001;
   TC.batchSize = minibatchSize;
 
+  // This variable records the number of the next sample to be used for
+  // training.
+  size_t sampleCounter = 0;
+
+  if (numReplicas > 1) {
+    DataParallelTrainer trainer(EE, F, TC, numReplicas);
+    CompilationContext cctx;
+    trainer.compile(cctx);
+    bindings.allocate(EE.getModule().getPlaceholders());
+
+    LOG(INFO) << "Training on " << numReplicas << " devices.";
+    for (int epoch = 0; epoch < 60; epoch++) {
+      LOG(INFO) << "Training - epoch #" << epoch;
+      timer.startTimer();
+      // Each step trains on numReplicas minibatches, so there are fewer
+      // steps for the same number of samples.
+      trainer.runBatch(bindings, numIterations / numReplicas, sampleCounter,
+                       {inputPH, selectedPH}, {&imageInputs, &labelInputs});
+      timer.stopTimer();
+    }
+    return;
+  }
+
   Function *TF = glow::differentiate(F, TC);
 
   EE.compile(CompilationMode::Train);
@@ -128,9 +156,6 @@ void trainModel(ExecutionEngine &EE, PlaceholderBindings &bindings, Function *F,
 
   LOG(INFO) << "Training.";
 
-  // This variable records the number of the next sample to be used for
-  // training.
-  size_t sampleCounter = 0;
   auto tfName = TF->getName();
 
   for (int epoch = 0; epoch < 60; epoch++) {
@@ -211,7 +236,8 @@ void testMNIST() {
   createModel(EEI_, F, inferBindings, minibatchSize, A, E, selected);
   inferBindings.allocate(inferMod.getPlaceholders());
 
-  ExecutionEngine EET_(executionBackend);
+  ExecutionEngine EET_(executionBackend, /* deviceMemory */ 0,
+                       /* ignoreUserDeviceConfig */ false, numReplicas);
   auto &trainMod = EET_.getModule();
   Function *TF = trainMod.createFunction("mnist");
   createModel(EET_, TF, trainingBindings, minibatchSize, A, E, selected);
@@ -269,7 +295,8 @@ void testMNISTLoadAndTraining() {
 
   // Load the model a second time for training.
   // TODO: remove once EE2 is able to compile in different modes.
-  ExecutionEngine EET_(executionBackend);
+  ExecutionEngine EET_(executionBackend, /* deviceMemory */ 0,
+                       /* ignoreUserDeviceConfig */ false, numReplicas);
   auto &trainMod = EET_.getModule();
   auto *TF = trainMod.createFunction("lenet_mnist_train");
   glow::Caffe2ModelLoader trainingLoader("lenet_mnist/predict_net.pb",
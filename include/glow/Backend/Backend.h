@@ -19,6 +19,7 @@
 #include "glow/Backend/CompiledFunction.h"
 #include "glow/Backends/BackendOptions.h"
 #include "glow/Base/Traits.h"
+#include "glow/CodeGen/MemoryAllocator.h"
 #include "glow/Optimizer/GraphOptimizer/CompilationContext.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPassPipeline.h"
 #include "glow/Optimizer/IROptimizer/IRFunctionPassPipeline.h"
@@ -73,6 +74,14 @@ public:
   // \returns backend name.
   virtual std::string getBackendName() const = 0;
 
+  /// \returns a string identifying everything besides the Function and its
+  /// BackendOptions that affects the code this backend generates, such as the
+  /// target or the compiler version. Compiled functions cached under one
+  /// fingerprint are never reused under another.
+  virtual std::string getCompilationFingerprint() const {
+    return getBackendName();
+  }
+
   /// Generate code for a vector of functions, \p functions. Each compilation
   /// has its own settings in \p opts. This allows the compiler to
   /// support shared constants between functions.
@@ -302,6 +311,21 @@ public:
     return false;
   };
 
+  /// \returns true if only the nodes supported by this backend in the
+  /// \p toTy precision should be converted to it from float when the
+  /// PrecisionConfiguration asks for convertToFP16, keeping the others in
+  /// float. Otherwise, all the nodes allowed by the PrecisionConfiguration are
+  /// converted.
+  virtual bool convertsOnlySupportedNodesToFloat16(ElemKind toTy) const {
+    return false;
+  }
+
+  /// \returns the strategy used to assign the offsets of the activations of
+  /// the functions compiled by this backend.
+  virtual MemoryPlanner getActivationsMemoryPlanner() const {
+    return MemoryPlanner::LiveSize;
+  }
+
   /// \returns an array of raw objects which are statically allocated and
   /// initialized by the backend and which can be used for various purposes,
   /// for example to store object files (binary code) which are compiled with
@@ -18,6 +18,7 @@
 
 #include "glow/CodeGen/MemoryAllocator.h"
 #include "glow/IR/IR.h"
+#include "glow/Support/Memory.h"
 
 #include "llvm/Support/CommandLine.h"
 
@@ -26,6 +27,9 @@
 extern llvm::cl::opt<bool> reuseActivationsMemory;
 
 namespace glow {
+
+class PlaceholderBindings;
+
 namespace runtime {
 
 /// An enum to indicate what type each symbol in the bundle is.
@@ -68,6 +72,8 @@ class RuntimeBundle {
   SymbolTableTy symbolTable_;
   /// Pointer to memory containing the weights for execution.
   uint8_t *constants_{nullptr};
+  /// Whether constants_ was mapped by largeAlloc.
+  bool constantsMapped_{false};
   /// Amount of memory needed for weights.
   size_t constantWeightVarsMemSize_{0};
   /// Amount of memory needed for mutable vars.
@@ -103,7 +109,9 @@ public:
   /// given function \p F and and copies weights to their address as specified
   /// by offsets contained in symbolTable_.
   void collectConstants(const IRFunction *F);
-  void collectConstants(const Module *M);
+  /// Same as above, placing the block of memory as \p policy says.
+  void collectConstants(const Module *M,
+                        const LargeAllocPolicy &policy = LargeAllocPolicy());
 #if FACEBOOK_INTERNAL
   void collectConstants(const FXIRWrapper *F);
 #endif
@@ -113,6 +121,16 @@ public:
   /// Sets the input and output flags for each symbol in the symbolBundle.
   void setInputsandOutputs();
 
+  /// Binds every Placeholder in the symbol table that is found in \p module
+  /// to an unowned Tensor in \p bindings viewing \p ioBuffer at the
+  /// Placeholder's offset, replacing any Tensor bound before. \p ioBuffer
+  /// must hold getMutableWeightSize() bytes, be aligned to TensorAlignment and
+  /// outlive \p bindings. Backends that support it run directly on
+  /// \p ioBuffer instead of copying inputs into and outputs out of their own
+  /// mutable weights area.
+  void bindIOBuffer(const Module &module, PlaceholderBindings &bindings,
+                    uint8_t *ioBuffer) const;
+
   /// Computes offsets and total allocation for Constants, Placeholders, and
   /// Activations to build runtime symbol table. Returns RuntimeBundle.
   static runtime::RuntimeBundle create(const IRFunction &F,
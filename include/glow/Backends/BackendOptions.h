@@ -62,6 +62,10 @@ struct BackendOptions {
   /// Insert TraceEvents between all instructions for profiling.
   bool autoInstrument{false};
 
+  /// With autoInstrument, also record the hardware performance counters
+  /// around all instructions, on the backends supporting it (CPU).
+  bool autoInstrumentCounters{false};
+
   /// Use a serialized precompiled function instead of compiling.
   bool useDeserialize{false};
 
@@ -84,6 +88,7 @@ struct BackendOptions {
     std::string dump_str;
     PRINT_VALUE(collectConstants, dump_str)
     PRINT_VALUE(autoInstrument, dump_str)
+    PRINT_VALUE(autoInstrumentCounters, dump_str)
     PRINT_VALUE(useDeserialize, dump_str)
 
     dump_str.append("backendSpecificOpts:\n");
@@ -136,6 +136,12 @@ public:
     }
   }
 
+  /// \returns the number of runs of all the networks handed to the device with
+  /// runFunction() whose result callback was not called yet, the depth of its
+  /// queue. The executor routes the runs of a network replicated on several
+  /// devices to the least loaded one. Devices that don't track it return 0.
+  virtual uint64_t getNumOutstandingRuns() const { return 0; }
+
   /// Load the provided module into the device, readyCB will be called when
   /// ready to use.
   /// \p functions contains the list of functions to load, keyed by their name
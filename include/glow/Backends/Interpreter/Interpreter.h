@@ -66,6 +66,8 @@ public:
 
   bool shouldLower(const Node *N) const override;
 
+  bool supportsPartialTensors() const override { return true; }
+
   Expected<bool> transformPostLowering(
       Function *F, CompilationContext &cctx,
       const glow::runtime::DeviceInfo *devInfo = nullptr) const override;
@@ -25,8 +25,11 @@
 
 #include "llvm/ADT/ArrayRef.h"
 
+#include <functional>
+#include <limits>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace glow {
 
@@ -41,6 +44,37 @@ class Constant;
 #define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME)
 #include "glow/AutoGenInstr.def"
 
+/// The tensors of the values of an IRFunction, resolved once when it is
+/// compiled. Every value with a tensor gets a slot, the activations live at
+/// the offsets of the memory plan of the runtime bundle in a single buffer,
+/// and the operands of every instruction are mapped to their slots, so that
+/// the execution looks no tensor up by hashing.
+struct InterpreterTensorPlan {
+  /// The values with a tensor: the weights, then the activations and the
+  /// tensor views in the order of the instructions, so that every view comes
+  /// after its source.
+  std::vector<const Value *> values;
+  /// The slot of every value, for the values which are not operands of the
+  /// instruction being executed.
+  std::unordered_map<const Value *, unsigned> slots;
+  /// The offset in the activations buffer of the activation of every slot.
+  std::vector<uint64_t> offsets;
+  /// The size in bytes of the activations buffer.
+  uint64_t activationsSize{0};
+  /// The slots of the operands of all the instructions, in order. Those of
+  /// the i-th instruction start at operandsBegin[i].
+  std::vector<unsigned> operandSlots;
+  std::vector<size_t> operandsBegin;
+  /// The slot of the source of every tensor view, -1 for the other values.
+  std::vector<int> viewSources;
+  /// The indices of the operands of every instruction which only compute
+  /// along their first dimension, so that the instruction may skip the rows
+  /// padding partial inputs. Those of the i-th instruction are in
+  /// [rowOperandsBegin[i], rowOperandsBegin[i + 1]).
+  std::vector<unsigned> rowOperands;
+  std::vector<size_t> rowOperandsBegin;
+};
+
 /// Function "compiled" for execution by the interpreter.
 class InterpreterFunction final : public CompiledFunction,
                                   public IRInstructionProcessingHandler {
@@ -50,6 +84,12 @@ class InterpreterFunction final : public CompiledFunction,
   /// Maps Value.name to tensors for constants.
   std::unordered_map<std::string, Tensor *> constants_;
 
+  /// The tensors of the values of F_.
+  InterpreterTensorPlan plan_;
+
+  /// Number of threads the large kernels may split their work across.
+  unsigned intraOpThreads_;
+
 public:
   InterpreterFunction(std::unique_ptr<IRFunction> F,
                       runtime::RuntimeBundle &&bundle);
@@ -70,6 +110,10 @@ public:
   /// Get reference to IR function.
   IRFunction *getIR() { return F_.get(); }
 
+  /// Set the number of threads the large kernels may split their work across
+  /// to \p numThreads.
+  void setIntraOpThreads(unsigned numThreads) { intraOpThreads_ = numThreads; }
+
   /// Read trace events out of this func and write them into /p context
   void translateTraceEvents(ExecutionContext *context) const override;
 
@@ -82,19 +126,43 @@ public:
 
 /// An InterpreterFunction bound to a specific invocation.
 class BoundInterpreterFunction : public IRInstructionProcessingHandler {
-  /// Maps values to Tensors, that are owned by this class.
-  std::unordered_map<const Value *, Tensor *> tensors_;
-
-  /// Maps values to Tensors, that are *not* owned by this class.
-  std::unordered_map<const Value *, Tensor *> externalTensors_;
-
   /// A reference to the constant map from the owning InterpreterFunction.
   const std::unordered_map<std::string, Tensor *> &constants_;
 
+  /// A reference to the tensor plan from the owning InterpreterFunction.
+  const InterpreterTensorPlan &plan_;
+
+  /// The tensor of every slot of plan_.
+  std::vector<Tensor *> slotTensors_;
+
+  /// The unowned tensors of the activations and tensor views, by slot.
+  std::vector<Tensor> viewTensors_;
+
+  /// The buffer of the activations.
+  void *activations_{nullptr};
+
+  /// The number of leading rows of every slot which hold computed data, when
+  /// the execution has partial inputs. The other rows are only padding.
+  std::vector<dim_t> validRows_;
+  bool hasPartialRows_{false};
+
+  /// The tensors of the row operands narrowed to their valid rows for the
+  /// instruction being executed, and the slots and tensors they replace.
+  std::vector<Tensor> rowTensors_;
+  std::vector<std::pair<unsigned, Tensor *>> narrowedSlots_;
+
+  /// The instruction being executed and the slots of its operands.
+  const Instruction *curInstr_{nullptr};
+  const unsigned *curSlots_{nullptr};
+
+  /// Number of threads the large kernels may split their work across.
+  unsigned numThreads_;
+
 public:
-  explicit BoundInterpreterFunction(
-      const std::unordered_map<std::string, Tensor *> &constants)
-      : constants_(constants) {}
+  BoundInterpreterFunction(
+      const std::unordered_map<std::string, Tensor *> &constants,
+      const InterpreterTensorPlan &plan, unsigned numThreads = 1)
+      : constants_(constants), plan_(plan), numThreads_(numThreads) {}
 
   ~BoundInterpreterFunction();
 
@@ -110,19 +178,36 @@ public:
   }
 
 private:
-  /// Allocate a tensor to back the value \p v. Do not allocate anything if a
-  /// tensor is already allocated for \p v.
-  /// \returns a tensor for \p v.
-  Tensor *getOrCreateTensor(const Value *v);
-
-  /// Allocate an unowned tensor to back the value \p v. The source tensor of
-  /// the unowned tensor is provided by \p src.
-  /// \returns a tensor for \p v.
-  Tensor *getOrCreateUnownedTensor(const Value *v, const Value *src,
-                                   llvm::ArrayRef<dim_t> offsets);
-
-  /// If a tensor is allocated for \p v then delete it.
-  void deleteTensor(const Value *v);
+  /// Resolve the slots of plan_ to the tensors of \p F bound in \p bindings,
+  /// to the constants and to the activations buffer.
+  void resolveTensors(IRFunction *F, PlaceholderBindings *bindings);
+
+  /// \returns the slot of the value \p slot is a view of, \p slot itself if
+  /// it is not a tensor view.
+  unsigned getRootSlot(unsigned slot) const;
+
+  /// Zero the padding rows of the value of \p slot up to row \p rows, all of
+  /// them by default, so that its first \p rows rows are valid.
+  void fillRows(unsigned slot,
+                dim_t rows = std::numeric_limits<dim_t>::max());
+
+  /// Prepare the operands of the \p instrIdx-th instruction \p I for its
+  /// execution with partial inputs: narrow its row operands to their valid
+  /// rows and zero the padding of the other operands it reads. \returns the
+  /// number of rows \p I computes, or 0 if it has no row operands.
+  dim_t narrowRows(size_t instrIdx, const Instruction &I);
+
+  /// Restore the operands narrowed by narrowRows() after the execution of the
+  /// \p instrIdx-th instruction \p I, which computed \p rows rows.
+  void restoreRows(size_t instrIdx, const Instruction &I, dim_t rows);
+
+  /// Run \p body on contiguous chunks [begin, end) of [0, \p numTasks),
+  /// split across up to numThreads_ threads when the work of the tasks, of
+  /// about \p taskWork inner iterations each, is large enough to be worth
+  /// it. The first chunk runs on the calling thread. \p body must not look
+  /// tensors up, as it may run on other threads.
+  void parallelFor(dim_t numTasks, uint64_t taskWork,
+                   const std::function<void(dim_t, dim_t)> &body) const;
 
   /// @name BoundInterpreterFunction methods. This is a list of method
   /// declerations that are used by the interpreter to dispatch different
@@ -212,6 +297,16 @@ private:
   template <typename ElemTy>
   void fwdBatchMatMulInstFloatImpl(const BatchMatMulInst *I);
 
+  template <typename ElemTy>
+  void fwdScaledDotProductAttentionInstFloatImpl(
+      const ScaledDotProductAttentionInst *I);
+
+  template <typename ElemTy>
+  void fwdFusedSGDInstFloatImpl(const FusedSGDInst *I);
+
+  template <typename IndexTy>
+  void fwdBeamSearchStepInstImpl(const BeamSearchStepInst *I);
+
   template <typename ElemTy, typename AccumulatorTy,
             typename BiasElemTy = int32_t>
   void fwdFullyConnectedInstQuantizedImpl(const FullyConnectedInst *I);
@@ -445,6 +540,10 @@ private:
   void fwdFusedRowwiseQuantizedSparseLengthsWeightedSumImpl(
       const FusedRowwiseQuantizedSparseLengthsWeightedSumInst *I);
 
+  template <typename TI>
+  void fwdProductQuantizedSparseLengthsWeightedSumImpl(
+      const ProductQuantizedSparseLengthsWeightedSumInst *I);
+
   template <typename T>
   void fwdNonMaxSuppressionInstImpl(glow::NonMaxSuppressionInst const *I);
 
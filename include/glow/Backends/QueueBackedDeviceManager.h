@@ -35,6 +35,9 @@ protected:
   /// Identifier for next run.
   std::atomic<RunIdentifierTy> nextIdentifier_{1};
 
+  /// Number of runs posted to workThread_ whose callback was not called yet.
+  std::atomic<uint64_t> outstandingRuns_{0};
+
 public:
   explicit QueueBackedDeviceManager(const DeviceConfig &config,
                                     unsigned numThreads = 1)
@@ -51,8 +54,8 @@ public:
   /// ready to use
   void addNetwork(const Module *module, FunctionMapTy functions,
                   ReadyCBTy callback) override {
-    workThread_.submit([this, module, f = std::move(functions),
-                        c = std::move(callback)]() mutable {
+    workThread_.post([this, module, f = std::move(functions),
+                      c = std::move(callback)]() mutable {
       addNetworkImpl(module, std::move(f), std::move(c));
     });
   }
@@ -61,7 +64,7 @@ public:
   /// up space on the device.
   void evictNetwork(std::string functionName,
                     EvictFunctionCBTy evictCB) override {
-    workThread_.submit([this, functionName, evictCB] {
+    workThread_.post([this, functionName, evictCB] {
       evictNetworkImpl(functionName, evictCB);
     });
   }
@@ -75,6 +78,13 @@ public:
                               std::unique_ptr<ExecutionContext> context,
                               ResultCBTy callback) override {
     RunIdentifierTy id = nextIdentifier_++;
+    outstandingRuns_++;
+    ResultCBTy done = [this, callback = std::move(callback)](
+                          RunIdentifierTy runId, Error err,
+                          std::unique_ptr<ExecutionContext> resultCtx) {
+      outstandingRuns_--;
+      callback(runId, std::move(err), std::move(resultCtx));
+    };
 
     if (glow::flags::useInferencePerspectiveTrace) {
       auto *traceContext = context.get()->getTraceContext();
@@ -85,9 +95,9 @@ public:
       }
     }
 
-    workThread_.submit([this, id, functionName = std::move(functionName),
-                        context = std::move(context),
-                        callback = std::move(callback)]() mutable {
+    workThread_.post([this, id, functionName = std::move(functionName),
+                      context = std::move(context),
+                      callback = std::move(done)]() mutable {
       if (glow::flags::useInferencePerspectiveTrace) {
         auto *traceContext = context.get()->getTraceContext();
         if (traceContext) {
@@ -98,12 +108,24 @@ public:
         }
       }
 
+      // Don't tie the device up with runs cancelled while waiting for it.
+      if (context->isCancelled()) {
+        callback(id,
+                 MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_CANCELLED,
+                          "Run of " + functionName +
+                              " cancelled before reaching the device"),
+                 std::move(context));
+        return;
+      }
+
       runFunctionImpl(id, std::move(functionName), std::move(context),
                       std::move(callback));
     });
     return id;
   }
 
+  uint64_t getNumOutstandingRuns() const override { return outstandingRuns_; }
+
   /// Stops execution and shuts down the Device.
   Error stop(bool block = true) override {
     workThread_.stop(block);
@@ -45,6 +45,37 @@ public:
 
   /// Releases the device buffer associated with \p tensor.
   virtual bool releaseDeviceTensor(void *locationContext) = 0;
+
+  /// \returns whether this device copies its resident tensors directly to
+  /// \p peer in transferToPeer(), without staging them on the host.
+  virtual bool
+  canTransferToPeer(const DeviceTensorTransferManager &peer) const {
+    return false;
+  }
+
+  /// Moves \p tensor, resident on this device, to \p peer and calls
+  /// \p resultCB once it is resident there. Devices with device-to-device
+  /// copies override this. By default the tensor is staged through its host
+  /// buffer, which the executor allocates for intermediates with
+  /// DeviceManager::allocateDeviceIOBuffer so that devices can pin it.
+  virtual void
+  transferToPeer(Tensor &tensor, DeviceTensorTransferManager &peer,
+                 std::function<void(Error)> resultCB = GLOW_DRT_DEFAULT_CB) {
+    if (&peer == this) {
+      resultCB(Error::success());
+      return;
+    }
+    Tensor *T = &tensor;
+    DeviceTensorTransferManager *dest = &peer;
+    auto stagedCB = [T, dest, resultCB](Error err) {
+      if (err) {
+        resultCB(std::move(err));
+        return;
+      }
+      dest->transferToDevice(*T, /* locationContext */ nullptr, resultCB);
+    };
+    transferFromDevice(tensor, /* release */ true, std::move(stagedCB));
+  }
 };
 
 } // namespace glow
@@ -164,6 +164,9 @@ private:
 
   template <class ElemTy> friend class Handle;
 
+  /// The TensorPool allocates buffers of its size classes and retypes them.
+  friend class TensorPool;
+
   /// \returns a pointer to the tensor data buffer.
   char *getData() const { return data_; }
 
@@ -791,8 +794,7 @@ public:
     assert(getElementType() == t->getElementType() && "Invalid element type");
     assert(t->getUnpaddedSizeInBytes() == getUnpaddedSizeInBytes() &&
            "Do not support copying between different unpadded sized tensors");
-    size_t bufferSize = type_.getSizeInBytes();
-    std::copy(&t->getData()[0], &t->getData()[bufferSize], getData());
+    std::memcpy(getData(), t->getData(), type_.getSizeInBytes());
   }
 
   /// Update the raw data of the tensor from a raw buffer \p data.
@@ -1300,7 +1302,104 @@ public:
     return tensor_->isInBounds(indices);
   }
 
-  void clear(ElemTy value = 0) { std::fill(begin(), end(), value); }
+  /// \returns true if the elements of the tensor are laid out without padding,
+  /// in which case the bulk operations below run over the raw buffer.
+  bool isContiguous() const { return size() == actualSize(); }
+
+  void clear(ElemTy value = 0) {
+    if (isContiguous()) {
+      std::fill_n(tensor_->getRawDataPointer<ElemTy>(), getRealNumElements(),
+                  value);
+      return;
+    }
+    std::fill(begin(), end(), value);
+  }
+
+  /// Sets every element of the tensor to the element of \p src at the same
+  /// position converted to ElemTy. \p src must have the same shape.
+  template <class SrcElemTy>
+  void copyConvertedFrom(const Handle<SrcElemTy> &src) {
+    assert(dims() == src.dims() && "Different shapes");
+    if (getRealNumElements() == 0) {
+      return;
+    }
+    if (isContiguous() && src.isContiguous()) {
+      const SrcElemTy *srcData = &src.raw(0);
+      ElemTy *destData = tensor_->getRawDataPointer<ElemTy>();
+      for (size_t i = 0, e = getRealNumElements(); i < e; i++) {
+        destData[i] = ElemTy(srcData[i]);
+      }
+      return;
+    }
+    std::transform(src.begin(), src.end(), begin(),
+                   [](SrcElemTy v) { return ElemTy(v); });
+  }
+
+  /// Clamps every element of the tensor to [\p low, \p high].
+  void clip(ElemTy low, ElemTy high) {
+    assert(!(high < low) && "Invalid range");
+    auto clamp = [low, high](ElemTy v) {
+      return v < low ? low : (high < v ? high : v);
+    };
+    if (isContiguous()) {
+      ElemTy *data = tensor_->getRawDataPointer<ElemTy>();
+      for (size_t i = 0, e = getRealNumElements(); i < e; i++) {
+        data[i] = clamp(data[i]);
+      }
+      return;
+    }
+    std::transform(begin(), end(), begin(), clamp);
+  }
+
+  /// \returns the minimum and the maximum of the elements of the tensor, which
+  /// must not be empty. Unlike minMaxArg() this keeps no position, so that the
+  /// loop vectorizes.
+  std::pair<ElemTy, ElemTy> minMax() const {
+    assert(getRealNumElements() && "Empty tensor");
+    if (!isContiguous()) {
+      ElemTy min = *begin();
+      ElemTy max = min;
+      for (auto v : *this) {
+        min = v < min ? v : min;
+        max = max < v ? v : max;
+      }
+      return {min, max};
+    }
+    const ElemTy *data = &raw(0);
+    ElemTy min = data[0];
+    ElemTy max = data[0];
+    for (size_t i = 1, e = getRealNumElements(); i < e; i++) {
+      min = data[i] < min ? data[i] : min;
+      max = max < data[i] ? data[i] : max;
+    }
+    return {min, max};
+  }
+
+  /// \returns the sum of the elements of the tensor, accumulated in double in
+  /// a few independent partial sums for the loop to vectorize.
+  double sum() const {
+    if (!isContiguous()) {
+      double sum = 0;
+      for (auto v : *this) {
+        sum += double(v);
+      }
+      return sum;
+    }
+    constexpr size_t lanes = 4;
+    double partial[lanes] = {0};
+    const ElemTy *data = tensor_->getRawDataPointer<ElemTy>();
+    const size_t n = getRealNumElements();
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      for (size_t l = 0; l < lanes; l++) {
+        partial[l] += double(data[i + l]);
+      }
+    }
+    for (; i < n; i++) {
+      partial[0] += double(data[i]);
+    }
+    return (partial[0] + partial[1]) + (partial[2] + partial[3]);
+  }
 
   /// Returns reference to a meaningful data element. This method does not
   /// address padding elements.
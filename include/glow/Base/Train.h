@@ -34,6 +34,14 @@ struct TrainingConfig {
   float learningRate{0.01f};
   float momentum{0.0};
   unsigned batchSize{1};
+  /// Activation checkpointing: when set, the backward pass only reads the
+  /// forward activations selected as checkpoints, and recomputes the others
+  /// from the nearest checkpoints, trading compute for memory.
+  bool checkpointActivations{false};
+  /// Bytes of forward activations kept as checkpoints when
+  /// checkpointActivations is set. With 0, about the square root of the
+  /// number of activations read by the backward pass are kept, evenly spaced.
+  uint64_t checkpointMemoryBudget{0};
 };
 
 } // namespace glow
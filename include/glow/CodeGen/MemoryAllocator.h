@@ -77,6 +77,31 @@ struct Segment {
   bool contains(uint64_t idx) const { return idx >= begin && idx < end; }
 };
 
+/// Strategies used by MemoryAllocator::allocateAll to assign the offsets of
+/// the segments, knowing the live ranges of all of them.
+enum class MemoryPlanner {
+  /// Allocate first the largest segments alive at the point of maximum live
+  /// size, trying several orders and keeping the best one.
+  LiveSize,
+  /// Allocate the segments by decreasing size, each at the lowest offset that
+  /// is free during its live range.
+  GreedyBySize,
+  /// Allocate the segments by decreasing size, each in the smallest gap that
+  /// is free during its live range and fits it.
+  BestFit,
+  /// Start from the best of the other planners and search other allocation
+  /// orders. The search stops when the search budget is spent, so it only
+  /// goes far for small functions.
+  Search,
+};
+
+/// \returns the name of the memory planner \p planner.
+const char *getMemoryPlannerName(MemoryPlanner planner);
+
+/// Set \p planner to the memory planner named \p name. \returns false if there
+/// is no such planner.
+bool getMemoryPlannerFromName(const std::string &name, MemoryPlanner &planner);
+
 /// Allocates segments of memory.
 /// Each allocation is associated with a user-defined handle, typically
 /// representing a client-specific object, e.g. a handle can be a `Value *` and
@@ -193,6 +218,20 @@ public:
   /// \returns the name of the memory region.
   const std::string &getName() const { return name_; }
 
+  /// Set the strategy used by \ref allocateAll to \p planner.
+  void setPlanner(MemoryPlanner planner) { planner_ = planner; }
+
+  /// \returns the strategy used by \ref allocateAll.
+  MemoryPlanner getPlanner() const { return planner_; }
+
+  /// Set the budget of MemoryPlanner::Search to \p budget. It is counted in
+  /// overlap checks between pairs of segments, so an allocation order of N
+  /// segments costs about N * N of it.
+  void setSearchBudget(uint64_t budget) { searchBudget_ = budget; }
+
+  /// \returns the budget of MemoryPlanner::Search.
+  uint64_t getSearchBudget() const { return searchBudget_; }
+
 private:
   /// The name of the memory region.
   std::string name_;
@@ -222,6 +261,12 @@ private:
   /// The alignment boundary for each segment allocation.
   size_t alignment_;
 
+  /// The strategy used by \ref allocateAll.
+  MemoryPlanner planner_{MemoryPlanner::LiveSize};
+
+  /// The budget of MemoryPlanner::Search, see \ref setSearchBudget.
+  uint64_t searchBudget_{1 << 26};
+
   /// Maps allocated addresses to the currently associated handles.
   std::unordered_map<uint64_t, Handle> addrToHandleMap_;
 
@@ -18,13 +18,17 @@
 
 namespace glow {
 
+class Backend;
 class Function;
 struct PrecisionConfiguration;
 
 /// Converts all inputs and outputs of a function \p F from Float to Float16,
-/// and from UInt8FusedQTy to UInt8FusedFP16QTy, based on \p precConfig.
+/// and from UInt8FusedQTy to UInt8FusedFP16QTy, based on \p precConfig. If
+/// \p B is not null, only the nodes \p B supports once converted are
+/// converted from Float.
 void convertFunctionToFloat16(Function *F,
-                              const PrecisionConfiguration &precConfig);
+                              const PrecisionConfiguration &precConfig,
+                              const Backend *B = nullptr);
 
 /// Converts all inputs and outputs of a function \p F from Float to BFloat16,
 /// and from UInt8FusedQTy to UInt8FusedBFloat16QTy, based on \p precConfig.
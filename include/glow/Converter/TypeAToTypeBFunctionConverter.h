@@ -24,6 +24,7 @@
 
 namespace glow {
 
+class Backend;
 class Function;
 class Module;
 
@@ -41,6 +42,9 @@ protected:
   ElemKind srcKind_;
   /// Precision configuration used during conversion.
   const PrecisionConfiguration &precConfig_;
+  /// If not null, only the nodes this backend supports once converted are
+  /// converted.
+  const Backend *B_;
 
   /// If the element type of \p out is srcKind_ returns a similarly shaped type
   /// using dstKind_. Otherwise returns nullptr.
@@ -68,9 +72,11 @@ protected:
 
 public:
   /// Create a type converter from \p fromKind to \p toKind for \p F given
-  /// \p precConfig.
+  /// \p precConfig. If \p B is not null, nodes that \p B does not support
+  /// once converted are kept in \p fromKind.
   TypeAToTypeBFunctionConverter(Function &F, ElemKind fromKind, ElemKind toKind,
-                                const PrecisionConfiguration &precConfig);
+                                const PrecisionConfiguration &precConfig,
+                                const Backend *B = nullptr);
 
   /// Convert and clip all Storage nodes used by the function.
   void convertAndClipStorage();
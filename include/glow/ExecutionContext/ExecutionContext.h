@@ -21,6 +21,10 @@
 
 #include "llvm/ADT/STLExtras.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
+
 namespace glow {
 namespace runtime {
 class DeviceManager;
@@ -40,12 +44,35 @@ public:
   }
 };
 
+/// Shared between a client and the runs it started, cancel() asks these runs
+/// to stop: requests not yet dispatched are dropped and partitions not yet
+/// started are skipped, the run completing with a RUNTIME_REQUEST_CANCELLED
+/// Error. Partitions already running on a device finish.
+class CancellationToken {
+  std::atomic<bool> cancelled_{false};
+
+public:
+  /// Cancels the runs holding this token. Thread safe.
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+  /// \returns whether cancel() has been called.
+  bool isCancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+};
+
 /// The runtime context for a single execution (Inferance or Training) in the
 /// the Glow Execution Engine or HostManager. This class includes the mapping
 /// between Input/Output Placeholders and the materialized Tensors used for this
 /// run, the set of Device specific details required to execute the function,
 /// and stores TraceEvents that were generated as a result of the run.
 class ExecutionContext {
+public:
+  /// Callback notified of an output Placeholder of the run and the Tensor
+  /// holding its result.
+  using OutputReadyCBTy = std::function<void(const Placeholder *, Tensor &)>;
+
+private:
   std::unique_ptr<PlaceholderBindings> placeholderBindings_;
   std::unique_ptr<DeviceBindings> deviceBindings_;
 
@@ -68,6 +95,12 @@ class ExecutionContext {
   /// Mark if this context belongs to the last node.
   bool lastNode_{true};
 
+  /// Notified of each output as soon as it is computed (optional).
+  OutputReadyCBTy outputReadyCB_;
+
+  /// Cancels the run when triggered (optional).
+  std::shared_ptr<CancellationToken> cancellationToken_;
+
 public:
   ExecutionContext()
       : placeholderBindings_(glow::make_unique<PlaceholderBindings>()) {}
@@ -193,6 +226,36 @@ public:
   bool isLastNode() const { return lastNode_; }
 
   void setLastNode(bool isLastNode) { lastNode_ = isLastNode; }
+
+  /// Sets \p cb to be called by the Executor for every output Placeholder
+  /// bound in this context as soon as the partition computing it finishes,
+  /// ahead of the result callback of the whole run. Outputs computed by
+  /// different partitions may be notified concurrently from different threads.
+  /// The Tensor must not be modified or released before the run completes.
+  void setOutputReadyCallback(OutputReadyCBTy cb) {
+    outputReadyCB_ = std::move(cb);
+  }
+
+  /// \returns the callback notified of each computed output, may be empty.
+  const OutputReadyCBTy &getOutputReadyCallback() const {
+    return outputReadyCB_;
+  }
+
+  /// Sets the \p token cancelling the runs of this context. It stays set for
+  /// later runs until replaced.
+  void setCancellationToken(std::shared_ptr<CancellationToken> token) {
+    cancellationToken_ = std::move(token);
+  }
+
+  /// \returns the token cancelling the runs of this context, may be null.
+  const std::shared_ptr<CancellationToken> &getCancellationToken() const {
+    return cancellationToken_;
+  }
+
+  /// \returns whether the run of this context has been cancelled.
+  bool isCancelled() const {
+    return cancellationToken_ && cancellationToken_->isCancelled();
+  }
 };
 
 } // namespace glow
@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_EXECUTIONCONTEXT_TRACEANALYSIS_H
+#define GLOW_EXECUTIONCONTEXT_TRACEANALYSIS_H
+
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Support/Error.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace glow {
+
+/// Critical path analysis of the REQUEST level events that the HostManager
+/// and the Executor log for each inference request: the time it waited in
+/// the queue, the run of the network and one event per partition of its DAG
+/// with the partition's parents. The timeline of each request is rebuilt
+/// from these events and its latency is split along its critical path, the
+/// chain of partitions each of which was the last parent to finish before
+/// the next one could start, into queue wait, dispatch, transfer, device and
+/// callback time. Events are added with addTraceEvents(), possibly from many
+/// traces, and dump() prints the blame aggregated over all requests.
+class RequestTraceAnalysis final {
+public:
+  /// Name of the event of the time a request waited in the HostManager queue.
+  static constexpr const char *kQueueEvent = "glow.request.queue";
+  /// Name of the event from the dispatch of a request to the Executor until
+  /// its result is handed to its callback.
+  static constexpr const char *kRunEvent = "glow.request.run";
+  /// Name of the event of a partition of a request, from the Executor
+  /// dispatching it until the DeviceManager returned its result.
+  static constexpr const char *kPartitionEvent = "glow.request.partition";
+
+  /// A partition of a request.
+  struct Partition {
+    std::string node;
+    std::vector<std::string> parents;
+    std::string device;
+    uint64_t start{0};
+    uint64_t end{0};
+    /// Time until the partition was handed to its DeviceManager.
+    uint64_t dispatch{0};
+    /// Time of the copies traced while the partition ran on its device.
+    uint64_t transfer{0};
+  };
+
+  /// Latency of a request split along its critical path, in microseconds.
+  /// The parts add up to the latency.
+  struct Blame {
+    uint64_t queue{0};
+    /// Dispatch of the partitions, including the wait of each partition for
+    /// the Executor to handle the result of its parent.
+    uint64_t dispatch{0};
+    uint64_t transfer{0};
+    uint64_t device{0};
+    /// Time from the last partition finishing to the result callback.
+    uint64_t callback{0};
+
+    uint64_t getTotal() const {
+      return queue + dispatch + transfer + device + callback;
+    }
+  };
+
+  /// Timeline of a request.
+  struct Request {
+    std::string id;
+    std::string network;
+    /// Time the request was received by the HostManager.
+    uint64_t received{0};
+    /// Time the request was dispatched to the Executor.
+    uint64_t dispatched{0};
+    /// Time the result was handed to the callback.
+    uint64_t finished{0};
+    bool hasQueue{false};
+    bool hasRun{false};
+    std::vector<Partition> partitions;
+    /// Indices in partitions of the critical path, first partition first.
+    std::vector<size_t> criticalPath;
+    Blame blame;
+
+    uint64_t getLatency() const { return finished - received; }
+  };
+
+  /// Add the request events of \p events. Request ids are unique per
+  /// HostManager, so events from different processes should be added with
+  /// different \p source names.
+  void addTraceEvents(const std::list<TraceEvent> &events,
+                      llvm::StringRef source = "");
+
+  /// Rebuild the timeline and critical path of every request with both a
+  /// queue and a run event. The others are counted as incomplete.
+  void analyze();
+
+  /// \returns the analyzed requests, in the order of their ids.
+  const std::vector<Request> &getRequests() const { return requests_; }
+
+  /// \returns the number of requests missing their queue or run event.
+  size_t getNumIncomplete() const { return numIncomplete_; }
+
+  /// Print the latency distribution, the blame of each phase and partition
+  /// summed over all requests, and the \p numSlowest slowest requests.
+  void dump(llvm::raw_ostream &os, unsigned numSlowest = 10) const;
+
+  /// \returns the events of the Chrome trace JSON file \p fileName, either
+  /// an array of events as written by TraceEvent::dumpTraceEvents() or an
+  /// object with a "traceEvents" array.
+  static Expected<std::list<TraceEvent>> loadTrace(llvm::StringRef fileName);
+
+  /// \returns the time spent in the COPY level events of \p events, either
+  /// complete events or pairs of begin and end events of the same thread.
+  static uint64_t getCopyTime(const std::list<TraceEvent> &events);
+
+private:
+  /// Requests being collected, keyed by source and id.
+  std::map<std::string, Request> pending_;
+
+  /// Requests analyzed by analyze().
+  std::vector<Request> requests_;
+
+  /// Number of requests missing their queue or run event.
+  size_t numIncomplete_{0};
+};
+
+} // namespace glow
+
+#endif // GLOW_EXECUTIONCONTEXT_TRACEANALYSIS_H
@@ -22,6 +22,7 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -41,6 +42,7 @@ struct TraceEvent {
     COPY = 0x04,     // Memory copies and DMA.
     OPERATOR = 0x08, // Backend operator instrumentation only.
     DEBUG = 0x10,    // Full debug events with extra information.
+    COMPILE = 0x20,  // Compilation phases, e.g. the passes of pass managers.
     STANDARD = REQUEST | RUNTIME | COPY |
                OPERATOR, // Glow runtime events and backend operator events.
   };
@@ -99,6 +101,21 @@ struct TraceEvent {
                   const std::string &processName = "",
                   const std::map<int, std::string> &threadNames = {});
 
+  /// Writes \p event to \p os as an object of the Chrome trace format.
+  static void dumpTraceEvent(llvm::raw_ostream &os, const TraceEvent &event);
+
+  /// Writes to \p os the metadata object of the Chrome trace format naming
+  /// the \p type (e.g. "thread_name") \p id as \p name.
+  static void dumpMetadataEvent(llvm::raw_ostream &os, llvm::StringRef type,
+                                int id, llvm::StringRef name);
+
+  /// Writes to \p os a table of the operator events of \p events summed per
+  /// operator kind, with the instructions per cycle, the last level cache
+  /// misses per thousand instructions and the memory bandwidth of these misses
+  /// when the events have hardware counters.
+  static void dumpOperatorSummary(llvm::raw_ostream &os,
+                                  const std::list<TraceEvent> &events);
+
   /// Return the current time in microseconds in the timestamp domain.
   static uint64_t now();
 
@@ -125,6 +142,10 @@ struct TraceInfo {
   /// The size of each item in the backing Tensor.
   size_t dataSize{0};
 
+  /// Names of the hardware counters recorded after the timestamp of each auto
+  /// instrumentation event, in order. Empty if counters are not recorded.
+  std::vector<std::string> counterNames;
+
   struct Event {
     size_t startIndex;
     size_t endIndex;
@@ -169,30 +190,59 @@ public:
   int getRequestID() const { return requestID_; }
 };
 
+class TraceEventBuffer;
+
 /// A context for storing TraceEvents throughout a run (ie. between
 /// partitioned CompiledFunctions).
 class TraceContext {
   /// The list of materialized Events filled out with timestamp and metadata.
   std::list<TraceEvent> traceEvents_;
 
+  /// The buffers of the events logged by each thread and not yet moved to
+  /// traceEvents_. A thread only appends to its own buffer, so logging takes
+  /// no lock once the buffer of the thread exists.
+  std::vector<std::unique_ptr<TraceEventBuffer>> buffers_;
+
+  /// Lock around buffers_, taken when a thread logs its first event and when
+  /// the buffers are flushed.
+  std::mutex buffersLock_;
+
+  /// Unique id of this context, identifies it in the per-thread cache of
+  /// buffers.
+  const uint64_t id_;
+
   /// Human readable name mapping for trace Threads.
   std::map<int, std::string> threadNames_;
 
   /// The detail level of tracing for this run.
   int traceLevel_{TraceLevel::NONE};
 
-  /// Lock around traceEvents_.
+  /// Lock around traceEvents_ and threadNames_.
   std::mutex lock_;
 
   /// The TracePerspectiveData structure with additional data to
   /// TraceContext to collect trace events from different perspectives.
   TracePerspectiveData tracePerspectiveData_;
 
+  /// \returns the buffer of the calling thread.
+  TraceEventBuffer &getThreadBuffer();
+
 public:
-  TraceContext(int level) : traceLevel_(level) {}
+  TraceContext(int level);
+
+  ~TraceContext();
 
   /// \returns TraceEvents for the last run.
-  std::list<TraceEvent> &getTraceEvents() { return traceEvents_; }
+  std::list<TraceEvent> &getTraceEvents() {
+    flushEventBuffers();
+    return traceEvents_;
+  }
+
+  /// Moves the events of the per-thread buffers to the list of
+  /// getTraceEvents(), interleaving the threads by timestamp while keeping the
+  /// events of each thread in logging order. Must not run concurrently with
+  /// the logging of events into this context.
+  void flushEventBuffers();
 
   /// \returns the level of verbosity allowed for TraceEvents.
   int getTraceLevel() { return traceLevel_; }
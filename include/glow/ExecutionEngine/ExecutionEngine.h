@@ -27,6 +27,7 @@
 
 #include "llvm/ADT/ArrayRef.h"
 
+#include <future>
 #include <memory>
 #include <unordered_map>
 
@@ -144,6 +145,19 @@ public:
   /// name.
   void run(PlaceholderBindings &bindings, llvm::StringRef name);
 
+  /// Starts a single execution of the function with the given \p name with
+  /// \p context, which must stay alive until it is done. If \p name is empty
+  /// there must be a single compiled function. \returns a future which is
+  /// ready when the execution is done.
+  std::future<void> runAsync(ExecutionContext &context,
+                             llvm::StringRef name = "");
+
+  /// Runs the function with the given \p name once for each of \p contexts,
+  /// all at the same time, and waits for all the runs to finish. The runs are
+  /// spread over the devices holding a copy of the function.
+  void runConcurrently(llvm::ArrayRef<ExecutionContext *> contexts,
+                       llvm::StringRef name);
+
   /// \returns a reference to the backend with name \p backendName owned by the
   /// Provisioner inside of \ref hostManager_.
   Backend &getBackend(llvm::StringRef backendName) const;
@@ -195,6 +209,87 @@ void runBatch(ExecutionEngine &EE, PlaceholderBindings &bindings,
               llvm::ArrayRef<Placeholder *> ph, llvm::ArrayRef<Tensor *> inputs,
               llvm::StringRef name = "");
 
+/// Like runBatch, but the slices of the next iteration are loaded into a
+/// second ExecutionContext while the current iteration runs, so that the
+/// copies of the inputs overlap with the compute. The second context views
+/// the tensors of \p bindings apart from the ones of \p ph, so the iterations
+/// still update the same weights one after the other. At the end the tensors
+/// of \p ph in \p bindings may hold the slices of any iteration.
+void runBatchAsync(ExecutionEngine &EE, PlaceholderBindings &bindings,
+                   size_t iterations, size_t &sampleCounter,
+                   llvm::ArrayRef<Placeholder *> ph,
+                   llvm::ArrayRef<Tensor *> inputs, llvm::StringRef name = "");
+
+/// Like evalBatch, but the samples of the next minibatch are loaded into a
+/// second ExecutionContext while the current one runs, and \p cb is called on
+/// the samples of a minibatch while the next one runs. Both contexts own
+/// their \p inputPH and \p outputPH tensors.
+void evalBatchAsync(
+    ExecutionEngine &EE, PlaceholderBindings &bindings, size_t numMinibatchRuns,
+    size_t &sampleCounter, Placeholder *inputPH, Placeholder *outputPH,
+    Tensor &samplesInput, Tensor &labelsInput, llvm::StringRef name,
+    std::function<void(const Tensor &sampleIn, const Tensor &sampleOut,
+                       const Tensor &label, size_t sampleIndex)> &&cb);
+
+/// Trains a Function with data parallelism over the devices of an
+/// ExecutionEngine. The gradients of each shard of a batch are computed by a
+/// copy of the differentiated Function on each device, then summed on the
+/// host, and a single SGD update is applied to the weights with the summed
+/// gradients. A step over numReplicas shards is thus the same as a step of
+/// the differentiated Function over the whole batch.
+class DataParallelTrainer {
+  /// A trainable weight, the placeholder of its gradient for one shard and
+  /// the one of its summed gradient.
+  struct Param {
+    Placeholder *weight;
+    Placeholder *grad;
+    Placeholder *sum;
+  };
+
+  ExecutionEngine &EE_;
+
+  /// Number of shards of a batch, each run on a different device.
+  unsigned numReplicas_;
+
+  /// Name of the Function computing the gradients of one shard.
+  std::string gradName_;
+
+  /// Name of the Function applying SGD to the weights with the summed
+  /// gradients.
+  std::string updateName_;
+
+  std::vector<Param> params_;
+
+  /// Placeholders of the gradient Function which are written by it, and thus
+  /// need a tensor for each replica. The others are read only and shared.
+  std::vector<Placeholder *> replicaPlaceholders_;
+  std::vector<Placeholder *> sharedPlaceholders_;
+
+  /// Sums the gradients of \p replicas into the summed gradients of
+  /// \p bindings, with one thread per replica summing a part of each.
+  void allReduce(PlaceholderBindings &bindings,
+                 llvm::ArrayRef<std::unique_ptr<ExecutionContext>> replicas);
+
+public:
+  /// Adds to the Module of \p EE the Functions training \p F over
+  /// \p numReplicas shards with \p config, whose batchSize is the one of a
+  /// shard, i.e. of the inputs of \p F. \p EE must have at least
+  /// \p numReplicas devices.
+  DataParallelTrainer(ExecutionEngine &EE, Function *F,
+                      const TrainingConfig &config, unsigned numReplicas);
+
+  /// Compiles the Functions of the Module of the ExecutionEngine with
+  /// \p cctx, copying them on numReplicas devices.
+  void compile(CompilationContext &cctx);
+
+  /// Like runBatch, runs \p iterations training steps on the weights of
+  /// \p bindings, loading consecutive slices of \p inputs into the
+  /// placeholders \p ph. Each step consumes numReplicas batches of \p ph.
+  void runBatch(PlaceholderBindings &bindings, size_t iterations,
+                size_t &sampleCounter, llvm::ArrayRef<Placeholder *> ph,
+                llvm::ArrayRef<Tensor *> inputs);
+};
+
 /// Runs \p numMinibatchRuns iterations of the compiled function called \p name.
 /// The method updates a global counter and future invocations of this method
 /// continue running iterations of the batch at the next available slice.
@@ -37,6 +37,8 @@ struct ONNX_TRAITS {
 
 namespace glow {
 
+class ZipWriter;
+
 /// Unique set of visited nodes.
 using ReportedNodes = std::unordered_set<const Node *>;
 
@@ -86,8 +88,14 @@ class ONNXModelWriter : public CommonOperatorWriter<ONNX_TRAITS> {
   /// Map from static PH names to the type it was originally loaded with.
   const std::map<std::string, Type> *staticPlaceholderTypes_;
   /// A dedicated list of initializers in case the tensors get too big and don't
-  /// fit into the model.
+  /// fit into the model. In zip mode they are written to \ref zipWriter_ and
+  /// dropped as soon as they are complete, see \ref flushInitializers().
   std::list<TensorType> initializers_;
+  /// Writer of the zip archive in zip mode, opened before the graph is
+  /// visited so that initializers are streamed to it.
+  std::unique_ptr<ZipWriter> zipWriter_;
+  /// Number of initializers already written to \ref zipWriter_.
+  size_t numZipInitializers_{0};
   /// Holds all Functions from a DAG that are being written when in dagMode_.
   llvm::SmallSet<Function *, 6> functionsFromDAG_;
   /// Holds all constant folding Functions that have been processed.
@@ -121,6 +129,16 @@ class ONNXModelWriter : public CommonOperatorWriter<ONNX_TRAITS> {
   /// the \p graph or to a separate list.
   TensorType *addInitializer(GraphType &graph);
 
+  /// In zip mode, opens the zip archive \p name that initializers are
+  /// streamed to. \returns an error if the output is a string.
+  Error startZipArchive(llvm::StringRef name);
+
+  /// In zip mode, writes the initializers of \ref initializers_ to
+  /// \ref zipWriter_ and frees them, so that the payloads of a large model are
+  /// not all held in memory at once. Pointers returned by addInitializer()
+  /// must not be used after this is called.
+  void flushInitializers();
+
   /// Special case node writer for Glow convolutions with quantized inputs and
   /// outputs.
   Error writeTensorwiseQuantizedConvolution(const ConvolutionNode *node,
@@ -246,6 +264,8 @@ public:
       const std::map<std::string, Type> *staticPlaceholderTypes = nullptr,
       std::string *outputStringPtr = nullptr);
 
+  ~ONNXModelWriter();
+
 private:
   /// \returns error for the unexpected node kind.
   static Error writeUnexpectedKind(const Node *node) {
@@ -32,12 +32,15 @@ extern size_t MaxActiveRequests;
 extern size_t MaxActiveRequestsPerInstance;
 extern size_t MaxQueueSize;
 extern size_t ExecutorThreads;
+extern bool ExecutorWorkStealing;
+extern bool ExecutorInlineSingleNode;
 extern bool DelayAndRecordConstantModification;
 extern bool UseTrackedDummyQuantParams;
 extern bool EnablePartialTensors;
 extern bool UseCustomOpsForExport;
 extern std::string BackendSpecificOpts;
 extern bool EnableLoadBalancedPartitioning;
+extern std::string PartitionerCostProfile;
 extern bool SkipProvisioning;
 extern bool DisableLayoutVerifying;
 extern bool DisableFreeCompilationResource;
@@ -63,6 +66,9 @@ extern bool ConvertFusedScaleOffsetToFP32;
 // Debug Constants
 extern int32_t NumDebugTracesPerDump;
 extern bool DumpDebugTraces;
+extern int32_t TraceSampleRate;
+extern int32_t TraceOverheadBudgetPercent;
+extern std::string TraceStreamFile;
 extern bool LogPartition;
 extern bool DumpPartition;
 extern bool DumpCompilationLog;
@@ -83,6 +89,7 @@ extern bool SparseNNPartitioningPairLNWithSLS;
 extern bool SparseNNPartitioningPairTileWithSLS;
 extern std::string SparseNNPartitioningPairSLSWith;
 extern int32_t SparseNNPartitioningConcatSplitSize;
+extern int64_t SparseNNPartitioningShardTableKBytes;
 extern bool SparseNNParallelizeReshapeOnBatchDim;
 
 // Dag Optimizer Constants
@@ -106,6 +113,7 @@ namespace nnpi {
 namespace flags {
 extern int32_t ModelParallelSplitAlignment;
 extern int32_t NumParallelChunks;
+extern int32_t AutoParallelCores;
 extern bool LowerAllBatchMatMul;
 extern bool AcceptUnarySLS;
 extern bool SpecializeAllOneSLS;
@@ -155,20 +163,40 @@ namespace glow {
 namespace runtime {
 namespace flags {
 extern unsigned CPUMemory;
+extern unsigned CPUIntraOpThreads;
+extern unsigned CPUDeviceThreads;
+extern bool CPUWinogradConv;
+extern bool CPUIm2ColConv;
+extern unsigned CPUSplitCacheBytes;
+extern unsigned CPUSparseFCMinZeroBlocksPercent;
+extern int32_t CPURowAlignmentBytes;
+extern std::string CPUMemoryPlanner;
+extern uint64_t CPUHugePageConstantsBytes;
+extern bool CPUExplicitHugePages;
+extern int32_t CPUConstantsNumaNode;
 
 extern unsigned HabanaMemory;
+extern unsigned HabanaRunners;
+extern unsigned HabanaWaiters;
 
 extern unsigned NNPIMemory;
 extern unsigned NNPITimeoutMs;
 
 extern std::string AvailableDevices;
 extern unsigned InterpreterMemory;
+extern unsigned InterpreterIntraOpThreads;
 extern bool EnableP2P;
 extern bool EnableDRT;
+extern bool DRTPrefetchInputs;
 extern unsigned DeviceInitTimeoutMs;
 extern uint64_t BigTableThresholdBytes;
 extern unsigned SanitizeInputsPercent;
+extern unsigned SanitizeInputsTables;
+extern unsigned DedupInputsMinPercent;
 extern unsigned NumCompilationThreads;
+extern uint64_t LLVMRunBufferCacheBytes;
+extern std::string CompiledFunctionCacheDir;
+extern unsigned DeferredWeightsInFlight;
 } // namespace flags
 } // namespace runtime
 } // namespace glow
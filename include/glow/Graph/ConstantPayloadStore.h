@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_GRAPH_CONSTANTPAYLOADSTORE_H
+#define GLOW_GRAPH_CONSTANTPAYLOADSTORE_H
+
+#include "glow/Base/Tensor.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace glow {
+
+/// Process-wide store of Constant payloads, in which payloads of identical
+/// bytes are kept once, see Constant::sharePayload(). A payload stays in the
+/// store as long as some Constant refers to it.
+class ConstantPayloadStore {
+  /// Stored payloads, keyed by the hash of their bytes.
+  std::unordered_multimap<size_t, std::weak_ptr<const Tensor>> payloads_;
+
+  /// Mutex protecting payloads_.
+  std::mutex mutex_;
+
+  ConstantPayloadStore() = default;
+
+public:
+  /// \returns the process-wide store.
+  static ConstantPayloadStore &get();
+
+  /// \returns the stored payload of the same bytes as \p T if there is one,
+  /// otherwise stores \p T and returns it. \p T must be owned.
+  std::shared_ptr<const Tensor> intern(Tensor &&T);
+
+  /// \returns the number of payloads held by the store.
+  size_t getNumPayloads();
+};
+
+} // namespace glow
+
+#endif // GLOW_GRAPH_CONSTANTPAYLOADSTORE_H
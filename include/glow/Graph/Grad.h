@@ -47,6 +47,12 @@ public:
   bool hasGradient(NodeValue activation);
 };
 
+/// \returns true if \p N is a copy of a forward node which differentiate()
+/// recomputes for the backward pass when checkpointing activations (see
+/// TrainingConfig::checkpointActivations). Such copies must not be merged with
+/// the nodes they copy, or the activations would be kept alive again.
+bool isRecomputedNode(const Node &N);
+
 } // namespace glow
 
 #endif // GLOW_GRAPH_GRAD_H
@@ -28,6 +28,7 @@
 #include "llvm/ADT/ilist_node.h"
 
 #include <list>
+#include <memory>
 #include <vector>
 
 namespace glow {
@@ -80,6 +81,9 @@ class Module final {
   PlaceholderList placeholders_;
   /// Deterministic PRNG used to initialize weights in this module.
   PseudoRNG PRNG_;
+  /// Buffers that unowned Constant payloads of the module point into, e.g.
+  /// memory-mapped weight files.
+  std::vector<std::shared_ptr<void>> externalPayloadBuffers_;
 
   /// Module log context that stores all logs related to this module.
   LogContext moduleLogCtx_{nullptr};
@@ -196,6 +200,10 @@ public:
   /// Erase the constant \p I from the Module.
   void eraseConstant(ConstList::iterator I);
 
+  /// Share the payloads of the Constants of the Module with the identical
+  /// payloads of the Constants of any Module, see Constant::sharePayload().
+  void shareConstantPayloads();
+
   /// Erase the placeholder \p I from the Module.
   /// Note: we only provide an iterator version of this, as erasing Placeholders
   /// is often unsafe.
@@ -210,6 +218,12 @@ public:
 
   const ConstList &getConstants() const { return constants_; }
 
+  /// Keep \p buffer alive as long as the module, for the unowned Constant
+  /// payloads pointing into it.
+  void addExternalPayloadBuffer(std::shared_ptr<void> buffer) {
+    externalPayloadBuffers_.push_back(std::move(buffer));
+  }
+
   /// \returns the list of placeholders that the Module owns.
   PlaceholderList &getPlaceholders() { return placeholders_; }
 
@@ -346,6 +360,10 @@ class Function : public IRContainer {
   /// The state of this function.
   FunctionState state_;
 
+  /// Number of changes made to the nodes of this function, see
+  /// Node::getChangeStamp.
+  uint64_t changeStamp_{0};
+
 public:
   Function(Module *parent, llvm::StringRef Name = {})
       : IRContainer(Name), parent_(parent), state_(FunctionState::FuncCreated) {
@@ -372,6 +390,14 @@ public:
   /// Gets the state of the function.
   FunctionState getState() { return state_; }
 
+  /// \returns the number of changes made to the nodes of this function so far.
+  /// A node whose Node::getChangeStamp is larger changed since the function
+  /// had this stamp.
+  uint64_t getChangeStamp() const { return changeStamp_; }
+
+  /// Count a new change to the nodes of this function. \returns its stamp.
+  uint64_t nextChangeStamp() { return ++changeStamp_; }
+
   std::string getFilename() { return getName().rsplit('/').second.str(); }
 
   /// Return the log context.
@@ -732,6 +758,27 @@ public:
       llvm::StringRef name, NodeValue input, NodeValue W, NodeValue B,
       TypeRef outTy, quantization::Schema schema, bool transposeWeight = false);
 
+  /// Create an Int4GroupwiseQuantizedFullyConnected node multiplying the float
+  /// 2D \p input by the transpose of the 4-bit quantized weights \p W,
+  /// dequantized in groups of \p groupSize columns with the \p scales and
+  /// \p offsets, and adding the float bias \p B.
+  Int4GroupwiseQuantizedFullyConnectedNode *
+  createInt4GroupwiseQuantizedFullyConnected(llvm::StringRef name,
+                                             NodeValue input, NodeValue W,
+                                             NodeValue scales,
+                                             NodeValue offsets, NodeValue B,
+                                             unsigned_t groupSize);
+
+  /// Create an Int4GroupwiseQuantizedFullyConnected node computing the same
+  /// as a FullyConnected node of float 2D \p input, float constant weights
+  /// \p W and bias \p B. \p W is transposed and quantized to 4 bits in groups
+  /// of \p groupSize elements of the input dimension at creation time.
+  Int4GroupwiseQuantizedFullyConnectedNode *
+  createInt4GroupwiseQuantizedFullyConnected(llvm::StringRef name,
+                                             NodeValue input, Constant *W,
+                                             NodeValue B,
+                                             unsigned_t groupSize);
+
   /// Implement an operation that computes the row-wise dot product of its
   /// inputs. Consequently, \p X and \p Y must be either 1D or 2D tensors. This
   /// lowered to a Mul node, and is followed by a BatchedReduceAdd if \p X and
@@ -1261,6 +1308,16 @@ public:
   BatchMatMulNode *createBatchMatMul(llvm::StringRef name, NodeValue lhs,
                                      NodeValue rhs);
 
+  /// Creates and \returns a ScaledDotProductAttentionNode computing
+  /// SoftMax(\p query x \p key^T * \p scale + \p mask) x \p value for each
+  /// batch. \p query is {N, Lq, D}, \p key is {N, Lk, D} and \p value is
+  /// {N, Lk, Dv}. Each dimension of \p mask is either 1 or that of the
+  /// {N, Lq, Lk} scores, an unmasked attention uses a {1, 1, 1} zero mask.
+  ScaledDotProductAttentionNode *
+  createScaledDotProductAttention(llvm::StringRef name, NodeValue query,
+                                  NodeValue key, NodeValue value,
+                                  NodeValue mask, float scale);
+
   /// Create a node, performing Norm operation. Output type is based on the
   /// input \p p type with dimensions specified with \p axes removed.
   VectorNormNode *createVectorNorm(llvm::StringRef name, NodeValue input,
@@ -1544,6 +1601,25 @@ public:
       bool useFP16Accumulation = false,
       LengthsMode lengthsMode = LengthsMode::Variable, float avgLength = NAN);
 
+  /// Same as \ref createSparseLengthsWeightedSum(), but the rows of the table
+  /// are product-quantized: row r is the concatenation of the subvectors
+  /// codebooks[s][codes[r][s]] of every subspace s. \p codes is a UInt8ITy
+  /// {numRows, numSubspaces} tensor and \p codebooks a float {numSubspaces,
+  /// numCentroids, subDim} tensor.
+  ProductQuantizedSparseLengthsWeightedSumNode *
+  createProductQuantizedSparseLengthsWeightedSum(
+      llvm::StringRef name, NodeValue codes, NodeValue codebooks,
+      NodeValue weights, NodeValue indices, NodeValue lengths);
+
+  /// Same as \ref createProductQuantizedSparseLengthsWeightedSum(), but
+  /// expects the float table \p data, which is product-quantized internally
+  /// into \p numSubspaces subspaces of \p numCentroids centroids each.
+  ProductQuantizedSparseLengthsWeightedSumNode *
+  createProductQuantizedSparseLengthsWeightedSum(
+      llvm::StringRef name, Tensor &data, unsigned_t numSubspaces,
+      NodeValue weights, NodeValue indices, NodeValue lengths,
+      unsigned_t numCentroids = 256);
+
   /// Given a vector of segment lengths, calculates offsets of each segment and
   /// packs them next to the lengths. For the input vector of length N the
   /// output is a Nx2 matrix with (offset, lengths) packaged for each segment.
@@ -1658,11 +1734,37 @@ public:
   IntLookupTableNode *createIntSigmoid(llvm::StringRef name, NodeValue input,
                                        TypeRef outTy);
 
+  /// Create quantized HardSwish.
+  IntLookupTableNode *createIntHardSwish(llvm::StringRef name, NodeValue input,
+                                         TypeRef outTy);
+
+  /// Create quantized GeLU, with the tanh approximation of the lowered Gelu.
+  IntLookupTableNode *createIntGelu(llvm::StringRef name, NodeValue input,
+                                    TypeRef outTy);
+
+  /// Create quantized Swish.
+  IntLookupTableNode *createIntSwish(llvm::StringRef name, NodeValue input,
+                                     TypeRef outTy);
+
+  /// Create quantized erf.
+  IntLookupTableNode *createIntErf(llvm::StringRef name, NodeValue input,
+                                   TypeRef outTy);
+
   TopKNode *createTopK(llvm::StringRef name, NodeValue input, unsigned_t k);
 
   TopKNode *createTopK(llvm::StringRef name, NodeValue input, unsigned_t k,
                        ElemKind outIndicesTyKind);
 
+  /// Creates a step of a beam search over \p logits {B, V}, the scores of the
+  /// next token of each of the B beams, whose log probabilities are
+  /// \p scores {B}. The B best candidates give the new scores, their tokens
+  /// and their beams, as \p indicesTy, and the rows of \p state {B, ...} are
+  /// reordered by their beams, see BeamSearchStepNode.
+  BeamSearchStepNode *
+  createBeamSearchStep(llvm::StringRef name, NodeValue logits,
+                       NodeValue scores, NodeValue state,
+                       ElemKind indicesTy = ElemKind::Int64ITy);
+
   /// Given \p rpnMaxLevel , \p rpnMinLevel and \p rpnPostNmsTopN
   /// CollectRpnProposals merges rois in the \p roisIN based on \p roisProbIn
   /// and returns top proposals limited to rpnPostNmsTopN total, size (n x B),
@@ -2573,6 +2675,15 @@ public:
   /// False otherwise.
   bool verify(const Backend *backend = nullptr) const;
 
+  /// Verify the correctness of the \p nodes of the Function only, e.g. the
+  /// ones a transformation created or mutated: their own checks, inputs,
+  /// users, types and layouts, checked as in verify() with \p backend. Checks
+  /// spanning the whole Function, like the uniqueness of names or of the
+  /// writers of placeholders, are left to verify(). \returns true when the
+  /// nodes are valid. False otherwise.
+  bool verifyNodes(llvm::ArrayRef<const Node *> nodes,
+                   const Backend *backend = nullptr) const;
+
   /// Dump a textual representation of the Function into provided output stream.
   void dump() const;
 
@@ -2640,6 +2751,9 @@ using VariableGradientsList =
 /// the procedure adds code to record the last gradient value: a list of
 /// (var, grad_var) pairs associating variables with their gradient variables.
 /// This feature is used by the gradient-check unit tests.
+/// If \p config enables checkpointActivations then the backward pass reads
+/// only the forward activations picked as checkpoints under its memory
+/// budget, and the others are recomputed from them.
 /// \returns a new function with the name \p newFuncName.
 Function *differentiate(Function *F, const TrainingConfig &config,
                         llvm::StringRef newFuncName = "",
@@ -41,6 +41,24 @@ template <bool is_const_iter> class NodeValueIteratorImpl;
 using NodeValueIterator = NodeValueIteratorImpl<false>;
 using NodeValueConstIterator = NodeValueIteratorImpl<true>;
 
+/// Properties shared by all the nodes of a kind. Every node class describes
+/// its kind with a static getKindInfo(), and Node::getNodeKindInfo() reads
+/// them from a table indexed by kind, so that the generic graph algorithms
+/// do not dispatch on the kind to query them.
+struct NodeKindInfo {
+  /// Number of inputs of the nodes, not counting their variadic inputs.
+  unsigned numFixedInputs{0};
+  /// Whether the nodes have variadic inputs, in which case the number of
+  /// inputs of every node is computed by its class.
+  bool hasVariadicInputs{false};
+  /// Whether the nodes have side effects.
+  bool hasSideEffects{false};
+  /// Whether the nodes are canonical, i.e. not backend specific.
+  bool isCanonical{false};
+  /// Whether the nodes are data parallel.
+  bool isDataParallel{false};
+};
+
 /// Represents a node in the compute graph.
 class Node : public Named,
              public Kinded,
@@ -61,6 +79,10 @@ protected:
   /// Link to the fusion group this node belongs to.
   const Node *parentFusionGroup_{nullptr};
 
+  /// Stamp of the parent function at the last change of this node, see
+  /// getChangeStamp.
+  uint64_t changeStamp_{0};
+
 public:
   Node(Kinded::Kind k, llvm::StringRef name)
       : Named(name), Kinded(k), predicate_(this, nullptr), parent_(nullptr) {}
@@ -87,6 +109,13 @@ public:
   /// Set the link to the function that holds this node.
   void setParent(Function *parent) { parent_ = parent; }
 
+  /// \returns the Function::getChangeStamp of the parent function at the last
+  /// time this node was added to it, or had its inputs, its users or the types
+  /// of its results changed.
+  uint64_t getChangeStamp() const { return changeStamp_; }
+  /// Record that this node changed, see getChangeStamp.
+  void markChanged();
+
   /// \returns the nullable parent fusion group of the current node.
   const Node *getParentFusionGroup() const { return parentFusionGroup_; }
   /// Assigns a parent fusion group to the current node.
@@ -106,6 +135,9 @@ public:
   bool isCanonical() const;
   bool isDataParallel() const;
 
+  /// \returns the properties of the nodes of kind \p kind.
+  static const NodeKindInfo &getNodeKindInfo(Kinded::Kind kind);
+
   /// \returns true if this input is being overwritten by the node.
   bool isOverwrittenNthInput(unsigned idx) const;
 
@@ -338,8 +370,8 @@ public:
   /// Base type of the iterator.
   using iterator =
       typename std::conditional<is_const_iter,
-                                std::list<NodeUse>::const_iterator,
-                                std::list<NodeUse>::iterator>::type;
+                                Node::UseListTy::const_iterator,
+                                Node::UseListTy::iterator>::type;
   /// Type of the NodeValue that this iterator is filtering for.
   using NodeValueTy = typename std::conditional<is_const_iter, const NodeValue,
                                                 NodeValue>::type;
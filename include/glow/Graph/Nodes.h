@@ -24,6 +24,7 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/Support/Casting.h"
 
+#include <memory>
 #include <tuple>
 
 namespace glow {
@@ -56,6 +57,11 @@ public:
   bool isCanonical() const { return true; }
   bool isDataParallel() const { return false; }
   Node *clone() const;
+  static constexpr NodeKindInfo getKindInfo() {
+    return {/* numFixedInputs */ 0, /* hasVariadicInputs */ false,
+            /* hasSideEffects */ false, /* isCanonical */ true,
+            /* isDataParallel */ false};
+  }
   /// @}
 
   /// \returns result type of the storage.
@@ -84,6 +90,15 @@ class Constant : public Storage {
   /// The tensor payload that the constant holds.
   Tensor payload_;
 
+  /// The ConstantPayloadStore payload viewed by payload_, if it is shared with
+  /// other Constants, see sharePayload().
+  std::shared_ptr<const Tensor> sharedPayload_;
+
+  /// Cache of getPayloadHash(), valid if hasPayloadHash_. It is reset by the
+  /// accessors that can modify the payload.
+  mutable size_t payloadHash_{0};
+  mutable bool hasPayloadHash_{false};
+
 public:
   /// Create a new constant and initialize its payload.
   Constant(llvm::StringRef name, TypeRef Ty, const std::string &layout)
@@ -107,14 +122,25 @@ public:
   void ensureIsOwned() {
     if (payload_.isUnowned()) {
       payload_ = payload_.clone();
+      sharedPayload_.reset();
     }
   }
 
+  /// Replace the owned payload by a view of the payload of the same bytes of
+  /// the process-wide ConstantPayloadStore, so that identical payloads of
+  /// Constants across Modules are kept once. The payload is copied back if it
+  /// is modified through getPayloadMutable() or assign().
+  void sharePayload();
+
+  /// \returns whether the payload is shared through the ConstantPayloadStore.
+  bool isPayloadShared() const { return sharedPayload_ != nullptr; }
+
   /// \returns a mutable reference to the payload tensor. If the payload tensor
   /// is unowned then it will be converted to an owned copy before returning.
   Tensor &getPayloadMutable() {
     /// Make sure the payload is owned before handing out a mutable reference.
     ensureIsOwned();
+    hasPayloadHash_ = false;
 
     assert(!payload_.isUnowned() &&
            "Can only modify Constants with owned payloads");
@@ -125,6 +151,7 @@ public:
   const Tensor &getPayload() const { return payload_; }
 
   template <class ElemTy = float> Handle<ElemTy> getHandle() {
+    hasPayloadHash_ = false;
     return getPayload().getHandle<ElemTy>();
   }
 
@@ -132,10 +159,17 @@ public:
     // Make sure when we assign the output type of constant is matching its
     // payload.
     assert(t->getType().isEqual(payload_.getType()));
+    if (sharedPayload_) {
+      ensureIsOwned();
+    }
     payload_.assign(t);
+    hasPayloadHash_ = false;
   }
 
-  void setPayloadType(TypeRef ty) { payload_.setType(ty); }
+  void setPayloadType(TypeRef ty) {
+    payload_.setType(ty);
+    hasPayloadHash_ = false;
+  }
 
   bool isDataParallel() const { return false; }
 
@@ -143,7 +177,18 @@ public:
 
   llvm::hash_code getHash() const;
 
-  void clearPayload() { payload_.release(); }
+  /// \returns a hash of the type and of all the bytes of the payload, which is
+  /// computed once and kept until the payload is modified through this
+  /// Constant. A payload modified through a Tensor or Handle obtained before
+  /// then keeps the old hash, so equal hashes don't imply equal payloads and
+  /// users must still compare them.
+  llvm::hash_code getPayloadHash() const;
+
+  void clearPayload() {
+    payload_.release();
+    sharedPayload_.reset();
+    hasPayloadHash_ = false;
+  }
 
   bool verify() const;
 };
@@ -162,6 +207,11 @@ class Placeholder : public Storage {
   /// before the first network run and will be reused by following runs.
   bool isStatic_{false};
 
+  /// Shuffle of the dimensions of the Tensor loaded for a static placeholder,
+  /// which is transposed with it to the shape of the placeholder. Empty if
+  /// the loaded Tensor already has the shape of the placeholder.
+  std::vector<unsigned_t> loadShuffle_;
+
 public:
   /// Create a new placeholder.
   Placeholder(llvm::StringRef name, TypeRef Ty, bool isTrainable,
@@ -184,6 +234,16 @@ public:
   /// Get the status of the isStatic_ flag.
   bool isStatic() const { return isStatic_; }
 
+  /// Set the shuffle \p shuffle transposing the Tensor loaded for this static
+  /// placeholder to its shape.
+  void setLoadShuffle(llvm::ArrayRef<unsigned_t> shuffle) {
+    loadShuffle_.assign(shuffle.begin(), shuffle.end());
+  }
+
+  /// \returns the shuffle transposing the Tensor loaded for this static
+  /// placeholder to its shape, empty if there is none.
+  llvm::ArrayRef<unsigned_t> getLoadShuffle() const { return loadShuffle_; }
+
   /// Sets whether or not associated Tensors should be zeroed.
   void setAllocZero(bool on = true) { allocZero_ = on; }
 
@@ -19,8 +19,11 @@
 #include "glow/ExecutionContext/TraceEvents.h"
 #include "glow/Graph/Graph.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
 
+#include <deque>
 #include <list>
+#include <memory>
 #include <unordered_map>
 
 namespace glow {
@@ -28,6 +31,186 @@ namespace glow {
 class Tensor;
 class Placeholder;
 
+/// Map from Placeholders to the Tensors that back them. Entries are found
+/// through a flat open-addressing index into a deque of entries, so that a
+/// lookup costs a probe of the index and no walk of a bucket list. Pointers
+/// and iterators to an entry stay valid until the entry is erased, including
+/// across insertions and moves of the map.
+class PlaceholderMap final {
+public:
+  using value_type = std::pair<Placeholder *, Tensor>;
+
+private:
+  using EntriesTy = std::deque<value_type>;
+
+  /// The entries, erased entries having a null Placeholder. The deque keeps
+  /// its entries in place as entries are added, and itself lives on the heap
+  /// so that it stays in place as the map is moved.
+  std::unique_ptr<EntriesTy> entries_;
+
+  /// Positions of the erased entries of entries_, reused by insertions.
+  std::vector<size_t> freeEntries_;
+
+  /// Maps Placeholders to the positions of their entries in entries_.
+  llvm::DenseMap<Placeholder *, size_t> index_;
+
+  /// Iterator over the entries of the map that skips the erased entries.
+  template <bool IsConst> class IteratorImpl {
+    friend PlaceholderMap;
+    using EntriesPtrTy = typename std::conditional<IsConst, const EntriesTy *,
+                                                   EntriesTy *>::type;
+    EntriesPtrTy entries_{nullptr};
+    size_t pos_{0};
+
+    IteratorImpl(EntriesPtrTy entries, size_t pos)
+        : entries_(entries), pos_(pos) {
+      skipErased();
+    }
+
+    void skipErased() {
+      while (entries_ && pos_ < entries_->size() &&
+             !(*entries_)[pos_].first) {
+        pos_++;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PlaceholderMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference =
+        typename std::conditional<IsConst, const value_type &,
+                                  value_type &>::type;
+    using pointer = typename std::conditional<IsConst, const value_type *,
+                                              value_type *>::type;
+
+    IteratorImpl() = default;
+
+    /// Allow the conversion of iterators to const iterators.
+    template <bool WasConst,
+              typename = typename std::enable_if<IsConst && !WasConst>::type>
+    IteratorImpl(const IteratorImpl<WasConst> &other)
+        : entries_(other.entries_), pos_(other.pos_) {}
+
+    reference operator*() const { return (*entries_)[pos_]; }
+    pointer operator->() const { return &(*entries_)[pos_]; }
+
+    IteratorImpl &operator++() {
+      pos_++;
+      skipErased();
+      return *this;
+    }
+    IteratorImpl operator++(int) {
+      IteratorImpl it = *this;
+      ++*this;
+      return it;
+    }
+
+    /// Iterators are compared by position, as the end iterator of a map is at
+    /// the end of its entries when it is created.
+    bool operator==(const IteratorImpl &other) const {
+      return pos_ == other.pos_;
+    }
+    bool operator!=(const IteratorImpl &other) const {
+      return !(*this == other);
+    }
+
+    template <bool> friend class IteratorImpl;
+  };
+
+  /// \returns the entries, created if the map has none.
+  EntriesTy &getEntries() {
+    if (!entries_) {
+      entries_.reset(new EntriesTy());
+    }
+    return *entries_;
+  }
+
+public:
+  using iterator = IteratorImpl<false>;
+  using const_iterator = IteratorImpl<true>;
+
+  PlaceholderMap() = default;
+  PlaceholderMap(PlaceholderMap &&other) = default;
+  PlaceholderMap &operator=(PlaceholderMap &&other) = default;
+
+  iterator begin() { return iterator(entries_.get(), 0); }
+  iterator end() {
+    return iterator(entries_.get(), entries_ ? entries_->size() : 0);
+  }
+  const_iterator begin() const { return const_iterator(entries_.get(), 0); }
+  const_iterator end() const {
+    return const_iterator(entries_.get(), entries_ ? entries_->size() : 0);
+  }
+
+  /// \returns the number of Placeholders in the map.
+  size_t size() const { return index_.size(); }
+
+  /// \returns whether the map has no Placeholder.
+  bool empty() const { return index_.empty(); }
+
+  /// Reserve room for \p n Placeholders in the index of the map.
+  void reserve(size_t n) { index_.reserve(n); }
+
+  /// \returns the entry of \p P, or end() if \p P is not in the map.
+  iterator find(Placeholder *P) {
+    auto it = index_.find(P);
+    return it == index_.end() ? end() : iterator(entries_.get(), it->second);
+  }
+  const_iterator find(Placeholder *P) const {
+    auto it = index_.find(P);
+    return it == index_.end() ? end()
+                              : const_iterator(entries_.get(), it->second);
+  }
+
+  /// \returns 1 if \p P is in the map, 0 otherwise.
+  size_t count(Placeholder *P) const { return index_.count(P); }
+
+  /// Maps \p P to \p T if \p P is not in the map yet. \returns the entry of
+  /// \p P and whether it was added.
+  std::pair<iterator, bool> emplace(Placeholder *P, Tensor &&T) {
+    auto ret = index_.insert({P, 0});
+    if (!ret.second) {
+      return {iterator(entries_.get(), ret.first->second), false};
+    }
+    auto &entries = getEntries();
+    size_t pos;
+    if (freeEntries_.empty()) {
+      pos = entries.size();
+      entries.emplace_back(P, std::move(T));
+    } else {
+      pos = freeEntries_.back();
+      freeEntries_.pop_back();
+      entries[pos].first = P;
+      entries[pos].second = std::move(T);
+    }
+    ret.first->second = pos;
+    return {iterator(entries_.get(), pos), true};
+  }
+
+  /// Removes \p P and its Tensor from the map. \returns the number of
+  /// removed entries.
+  size_t erase(Placeholder *P) {
+    auto it = index_.find(P);
+    if (it == index_.end()) {
+      return 0;
+    }
+    auto &entry = (*entries_)[it->second];
+    entry.first = nullptr;
+    entry.second = Tensor();
+    freeEntries_.push_back(it->second);
+    index_.erase(it);
+    return 1;
+  }
+
+  /// Removes all the Placeholders and their Tensors from the map.
+  void clear() {
+    entries_.reset();
+    freeEntries_.clear();
+    index_.clear();
+  }
+};
+
 /// This class provides a mapping between some graph nodes, which are a symbolic
 /// representation of some computation, and concrete tensors that represent the
 /// inputs and outputs to the graph. The PlaceholderBindings owns the tensors
@@ -39,7 +222,7 @@ class Placeholder;
 class PlaceholderBindings final {
 public:
   /// Maps placeholders to the tensors that back them.
-  using PlaceholderMap = std::unordered_map<Placeholder *, Tensor>;
+  using PlaceholderMap = glow::PlaceholderMap;
   using PlaceholderMapIterator = PlaceholderMap::iterator;
 
 private:
@@ -231,6 +231,10 @@ bool checkSameLayout(llvm::StringRef srcLayoutStr,
 bool verifyLayouts(const Function &F, TensorLayoutCommon &TLC,
                    bool verbose = true);
 
+/// Verifies the layouts of the inputs of the node \p N using layout
+/// requirements interface \p TLC. if \p verbose then print out verbose report.
+bool verifyLayouts(const Node &N, TensorLayoutCommon &TLC, bool verbose = true);
+
 } // end namespace glow
 
 #endif // GLOW_GRAPH_TENSORLAYOUT_H
@@ -16,26 +16,35 @@
 #ifndef GLOW_GRAPH_USEDEF_H
 #define GLOW_GRAPH_USEDEF_H
 
-#include <list>
+#include "llvm/ADT/SmallVector.h"
+
+#include <algorithm>
 
 namespace glow {
 
 /// A UseDef is something that can be an operand for an instruction.
 template <typename UserTy, typename Use> class UseDef {
+public:
+  /// Type of the list of users. Most values have one or two users, which are
+  /// kept inline instead of in a node allocated per use.
+  using UseListTy = llvm::SmallVector<Use, 2>;
+
+private:
   /// A list of users. Notice that the same user may appear twice in the list.
   /// This is typically a very short list.
-  std::list<Use> users_{};
+  UseListTy users_{};
 
 public:
   UseDef() = default;
 
-  /// Removes the use \p U from the uselist.
+  /// Removes the use \p U from the uselist, keeping the order of the other
+  /// uses. This invalidates the iterators on the uselist.
   void removeUse(Use U) {
     auto it = std::find(users_.begin(), users_.end(), U);
     assert(it != users_.end() && "User not in list");
     users_.erase(it);
   }
-  /// Adds the use \p U.
+  /// Adds the use \p U. This invalidates the iterators on the uselist.
   void addUse(Use U) { users_.push_back(U); }
 
   /// \returns True if the value has some users.
@@ -58,10 +67,10 @@ public:
   }
 
   /// \returns the list of users for this value.
-  std::list<Use> &getUsers() { return users_; }
+  UseListTy &getUsers() { return users_; }
 
   /// \returns the list of users for this value.
-  const std::list<Use> &getUsers() const { return users_; }
+  const UseListTy &getUsers() const { return users_; }
 };
 
 } // namespace glow
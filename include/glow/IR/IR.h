@@ -115,6 +115,18 @@ public:
   void dumpInContext() const;
 };
 
+/// Properties shared by all the instructions of a kind. Every instruction
+/// class describes its kind with a static getKindInfo(), and
+/// Instruction::getInstrKindInfo() reads them from a table indexed by kind.
+struct InstrKindInfo {
+  /// Number of operands known at the instruction definition time.
+  unsigned numFixedOperands{0};
+  /// Whether the instructions are canonical, i.e. not backend specific.
+  bool isCanonical{false};
+  /// Whether the instructions are data parallel.
+  bool isDataParallel{false};
+};
+
 /// This represents an instruction in our IR.
 class Instruction : public Value, public TaggedListNode<Instruction> {
 public:
@@ -202,6 +214,9 @@ public:
   /// \returns True if this instruction is data parallel.
   bool isDataParallel() const;
 
+  /// \returns the properties of the instructions of kind \p kind.
+  static const InstrKindInfo &getInstrKindInfo(Kinded::Kind kind);
+
   /// Sets the ith operand at index \p idx to the value \p v.
   void setOperand(unsigned idx, Value *v);
 
@@ -371,6 +386,9 @@ private:
   /// A list of unique instruction names use by the function.
   llvm::StringSet<> stringTable_;
 
+  /// Whether the graph is scheduled for the smallest peak activation memory.
+  bool minimizePeakMemory_{false};
+
   /// Perform scheduling on the graph.
   /// \returns computed schedule in the \p Schedule parameter.
   void scheduleGraph(NodesPtrList &Schedule);
@@ -396,6 +414,11 @@ public:
   /// It allows Backend \p B to custom translate from a Node to Instruction IR.
   void generateIR(const Backend &B);
 
+  /// Schedule the graph for the smallest peak activation memory in
+  /// generateIR if \p minimize is set, whatever the scheduler selected on the
+  /// command line.
+  void setMinimizePeakMemory(bool minimize) { minimizePeakMemory_ = minimize; }
+
   /// Wipe out the content of the function. This allows the function to be used
   /// again for another round of code generation.
   void clear();
@@ -49,7 +49,7 @@ public:
         std::forward_iterator_tag,
         typename std::conditional<is_const_iter, const Use, Use>::type>;
     using reference = typename BASE::reference;
-    using UseList = std::list<Use>;
+    using UseList = Value::UseListTy;
     using value =
         typename std::conditional<is_const_iter, const Value, Value>::type;
     using iterator =
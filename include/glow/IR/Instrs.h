@@ -95,6 +95,12 @@ public:
     return k->getKind() == Kinded::Kind::FusionGroupInstKind;
   }
 
+  /// The operands are those of the fused instructions, none is fixed.
+  static constexpr InstrKindInfo getKindInfo() {
+    return {/* numFixedOperands */ 0, /* isCanonical */ true,
+            /* isDataParallel */ false};
+  }
+
   /// Returns a refernce to the vector of instructions making up the fused
   /// instruction.
   const std::vector<Instruction *> &getInstrs() const { return instrs_; }
@@ -52,9 +52,19 @@ class Caffe2ModelLoader
   /// \p tensors.
   Error loadWeightsFromNet(caffe2::NetDef &net);
 
+  /// Load the weight tensors from the 'init' file \p filename. Binary files
+  /// are parsed a few ops at a time and each batch of ops is loaded before
+  /// the next one is parsed, so that the whole NetDef is never held in memory
+  /// and the file may be larger than \ref MAX_PROTO_SIZE.
+  Error loadWeightsFromFile(const std::string &filename);
+
   /// Loads an individual weight \p op.
   Error loadWeight(const caffe2::OperatorDef &op);
 
+  /// Fills \p T with the values of the GivenTensor*Fill weight \p op. Does
+  /// not modify the loader, so that it can run on the loader threads.
+  Error loadGivenTensorFill(const caffe2::OperatorDef &op, Tensor &T);
+
   /// Load the structure of the network from the 'net' file.
   Error loadNetwork(caffe2::NetDef &net);
 
@@ -23,12 +23,17 @@
 #include "onnx/onnx_pb.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
 
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace ONNX_NAMESPACE {
@@ -508,6 +513,14 @@ protected:
   /// Load the network initializers from the GraphProto.
   Error loadInitializers(ONNX_NAMESPACE::GraphProto &net);
 
+  /// Loads into \p T the initializer \p in, whose payload is in an external
+  /// data file relative to the directory of the model. The file is mapped
+  /// copy-on-write for the lifetime of the Module, and \p T is an unowned
+  /// view into the mapping, so that the payload is only paged in once read.
+  /// Payloads with custom strides or misaligned for their element type are
+  /// copied instead.
+  Error loadExternalTensor(const ONNX_NAMESPACE::TensorProto &in, Tensor *T);
+
   /// Given some initializer \p in, check if it has some constant folding node
   /// associated with it in \p net. If so, deserializes the Function if not
   /// already done, performs the constant folding, and \returns the Constant
@@ -612,6 +625,22 @@ protected:
                   bool clipQuantRangeToFP16 = false);
 
   friend class ONNXIFIModelLoader;
+  friend class ONNXModelCache;
+
+  /// Loads the ONNX model \p modelDef, parsed from \p modelDescFilename,
+  /// into \p F with the inputs \p tensorNames of types \p types. The
+  /// initializers found in \p sharedConstants are loaded from the Constants
+  /// they name in the Module of \p F, the others are deserialized from
+  /// \p modelDef and the names of their new Constants are added to
+  /// \p sharedConstants. If \p errPtr is not null then if an error occurs it
+  /// will get assigned there otherwise if an error occurs it will abort. \p B
+  /// will be used during function verification after loading.
+  ONNXModelLoader(ONNX_NAMESPACE::ModelProto &modelDef,
+                  const std::string &modelDescFilename,
+                  llvm::ArrayRef<const char *> tensorNames,
+                  llvm::ArrayRef<TypeRef> types, Function &F,
+                  llvm::StringMap<std::string> &sharedConstants,
+                  Error *errPtr = nullptr, const Backend *B = nullptr);
 
   /// \returns success if the folding of operator \p op in the loader
   /// \p loader is successful. The folding utility uses temporary
@@ -725,10 +754,62 @@ public:
                   const std::string *inputStringPtr = nullptr);
 
 private:
+  /// Directory that the locations of external data files are relative to.
+  std::string externalDataDir_;
+  /// External data files mapped so far, by path.
+  llvm::StringMap<std::shared_ptr<llvm::WritableMemoryBuffer>>
+      externalDataFiles_;
   /// Per-node options that may be specified in a proto.
   BackendSpecificNodeInfo *perNodeOpts_{nullptr};
   /// Map from static PH names to the type it was originally loaded with.
   std::map<std::string, Type> *staticPlaceholderTypes_;
+  /// Map from initializer names to the names of the Constants they were
+  /// loaded into by an earlier load of the same model, see ONNXModelCache.
+  llvm::StringMap<std::string> *sharedConstants_{nullptr};
+};
+
+/// Cache of ONNX models which are loaded several times into a Module with
+/// different input types, e.g. one Function per batch size. Every model is
+/// parsed once, and the Functions loaded from it into the same Module share
+/// the Constants of its initializers instead of deserializing them again.
+/// Glow types are fixed when nodes are created, so the graph of every
+/// Function is still built from the cached proto for its own input types.
+/// The optimizer may rewrite in place the Constants that have a single user,
+/// so all the Functions of a model are expected to be loaded before any of
+/// them is optimized.
+class ONNXModelCache {
+public:
+  /// Loads the ONNX model \p modelDescFilename into a new Function \p funName
+  /// of \p mod with the inputs \p tensorNames of types \p types, which may
+  /// differ from the model in their first (batch) dimension. The model is
+  /// only parsed the first time it is loaded. \p B will be used during
+  /// function verification after loading. \returns the new Function.
+  Expected<Function *> load(const std::string &modelDescFilename,
+                            llvm::ArrayRef<const char *> tensorNames,
+                            llvm::ArrayRef<TypeRef> types, Module &mod,
+                            llvm::StringRef funName,
+                            const Backend *B = nullptr);
+
+  /// Forgets the Constants of \p mod, which must be called before \p mod is
+  /// destroyed if the cache outlives it.
+  void erase(const Module &mod);
+
+  /// Drops all the parsed models.
+  void clear();
+
+private:
+  /// A parsed model and the Constants of its initializers in every Module it
+  /// was loaded into.
+  struct Entry {
+    std::unique_ptr<ONNX_NAMESPACE::ModelProto> modelDef;
+    std::unordered_map<const Module *, llvm::StringMap<std::string>> constants;
+  };
+
+  /// Models loaded so far, by file name.
+  llvm::StringMap<Entry> entries_;
+
+  /// Serializes the loads and the updates of \ref entries_.
+  std::mutex mutex_;
 };
 
 } // namespace glow
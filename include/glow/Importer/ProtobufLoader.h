@@ -31,6 +31,7 @@
 
 #include <google/protobuf/text_format.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -56,6 +57,16 @@ void setConstantFoldLoaderOpsFlag(bool flag);
 /// Returns true if constant-folding for loader Ops is enabled.
 bool getConstantFoldLoaderOpsFlag();
 
+/// Sets to \p numThreads the number of threads deserializing the tensors of
+/// the models, 0 for one per hardware thread.
+void setLoaderThreads(unsigned numThreads);
+
+/// Runs \p task on the indices [0, \p numTasks) on the loader threads, see
+/// setLoaderThreads. The tasks must not modify the loader or its Module.
+/// \returns the error of the first failing task by index, if any.
+Error runLoaderTasks(size_t numTasks,
+                     const std::function<Error(size_t)> &task);
+
 /// Returns true iff all elements of \p a are the same.
 bool isArrayConstant(const llvm::ArrayRef<size_t> a);
 
@@ -25,12 +25,19 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <memory>
 
 namespace glow {
 
 /// Loads TensorFlowLite models.
 class TFLiteModelLoader {
 
+  /// Private mapping of the model file which \ref model_ points into, shared
+  /// with the module when Constants point into it.
+  std::shared_ptr<llvm::WritableMemoryBuffer> modelData_;
+
   /// TensorFlowLite model object.
   const tflite::Model *model_{nullptr};
 
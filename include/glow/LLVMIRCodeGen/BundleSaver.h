@@ -90,6 +90,10 @@ protected:
       const std::vector<std::string> &bundleObjects);
   /// Save weights for the bundle.
   virtual void saveWeights(llvm::StringRef weightsFileName);
+  /// Save the weights file \p weightsFileName compressed, see
+  /// WeightsCompression.h, into \p compressedFileName.
+  virtual void saveCompressedWeights(llvm::StringRef weightsFileName,
+                                     llvm::StringRef compressedFileName);
   /// Save header file for the bundle.
   virtual void saveHeader(llvm::StringRef headerFileName);
   /// Emit config for a bundle.
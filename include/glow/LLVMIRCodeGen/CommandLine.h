@@ -71,6 +71,57 @@ extern llvm::cl::list<std::string> llvmCompilerOptions;
 /// Option to create an asm file from llvm compiler.
 extern llvm::cl::opt<bool> llvmSaveAsm;
 
+/// Float MatMul kernels of libjit, which differ in their register block.
+enum class LibjitMatMulKernel {
+  /// Pick the kernel from the features of the target CPU.
+  Auto,
+  /// Kernel that suits any target.
+  Generic,
+  /// Kernel for the 16 ymm registers of AVX2.
+  AVX2,
+  /// Kernel for the 32 ymm registers of AVX-512 (with AVX512VL).
+  AVX512,
+};
+
+/// Option to force the libjit float MatMul kernel used by the LLVMBackend.
+extern llvm::cl::opt<LibjitMatMulKernel> libjitMatMulKernel;
+
+/// Option to use the AVX512-VNNI int8 kernels of libjit when the target
+/// supports them.
+extern llvm::cl::opt<bool> libjitVNNI;
+
+/// Option to use the int8 kernels of libjit tuned for ARM when generating code
+/// for AArch64, or for ARM with NEON or MVE.
+extern llvm::cl::opt<bool> libjitARM;
+
+/// Option to move data parallel instructions next to the ones they can be
+/// stacked with into a single kernel.
+extern llvm::cl::opt<bool> fuseDataParallelInstrs;
+
+/// Option to run stacked data parallel kernels over tiles of this many
+/// elements, one instruction after the other; 0 disables tiling.
+extern llvm::cl::opt<unsigned> dataParallelTileSize;
+
+/// Option to split stacked data parallel kernels into tasks of this many
+/// elements for the intra-op threads; 0 disables splitting.
+extern llvm::cl::opt<unsigned> dataParallelTaskSize;
+
+/// Option to split the optimized LLVM module into this many parts compiled to
+/// machine code concurrently.
+extern llvm::cl::opt<unsigned> llvmCodeGenThreads;
+
+/// Option to keep the object files compiled by the JIT in this directory and
+/// reuse them for identical modules, see JITObjectCache.
+extern llvm::cl::opt<std::string> llvmJITCacheDir;
+
+/// Option to only read and optimize the libjit functions used by the generated
+/// code.
+extern llvm::cl::opt<bool> libjitLazyLoad;
+
+/// Option to use the AVX512-BF16 bfloat16 kernels of libjit when the target
+/// supports them.
+extern llvm::cl::opt<bool> libjitAVX512BF16;
+
 /// Option to set float ABI. Used as -float-abi=<abi-type>.
 extern llvm::cl::opt<llvm::FloatABI::ABIType> floatABI;
 
@@ -83,4 +134,17 @@ extern llvm::cl::opt<bool> bundleAPIVerbose;
 /// Option to add other external object files to the bundle.
 extern llvm::cl::list<std::string> bundleObjectsOpt;
 
+/// Option to keep the intra-op thread pool runtime in the bundle.
+extern llvm::cl::opt<bool> bundleParallelRuntime;
+
+/// Option to also save the constant weights of the bundle compressed.
+extern llvm::cl::opt<bool> bundleCompressWeights;
+
+/// Option to minimize the peak activation memory of the bundle.
+extern llvm::cl::opt<bool> bundleMinMemory;
+
+/// Options to run the first convolutions of the bundle in patches.
+extern llvm::cl::opt<unsigned> bundlePatchLayers;
+extern llvm::cl::opt<unsigned> bundlePatchCount;
+
 #endif // GLOW_LLVMIRCODEGEN_COMMANDLINE_H
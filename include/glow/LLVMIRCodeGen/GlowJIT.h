@@ -19,6 +19,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
 #if LLVM_VERSION_MAJOR >= 13
@@ -32,6 +33,7 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Mangler.h"
 #include "llvm/Support/DynamicLibrary.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include <algorithm>
@@ -58,6 +60,8 @@ namespace orc {
 class GlowJIT {
 private:
   std::unique_ptr<llvm::TargetMachine> TM_;
+  /// Cache of the objects compiled from the modules, may be null.
+  std::unique_ptr<llvm::ObjectCache> cache_;
   const DataLayout DL_;
   std::unique_ptr<llvm::LLVMContext> ctx_;
 #if FACEBOOK_INTERNAL && LLVM_VERSION_MAJOR < 8
@@ -107,7 +111,10 @@ private:
   std::string mangle(const std::string &name);
 
 public:
-  GlowJIT(std::unique_ptr<llvm::TargetMachine> TM);
+  /// Creates a JIT compiling for \p TM, looking up and saving objects in
+  /// \p cache if given.
+  GlowJIT(std::unique_ptr<llvm::TargetMachine> TM,
+          std::unique_ptr<llvm::ObjectCache> cache = nullptr);
   ~GlowJIT();
 
   TargetMachine &getTargetMachine() { return *TM_; }
@@ -118,6 +125,10 @@ public:
 
   ModuleHandle addModule(std::unique_ptr<Module> M);
 
+  /// Add the already compiled object file \p obj. The object must not have
+  /// static constructors or destructors.
+  ModuleHandle addObjectFile(std::unique_ptr<MemoryBuffer> obj);
+
   void removeModule(ModuleHandle H);
 
   void setContext(std::unique_ptr<llvm::LLVMContext> ctx);
@@ -140,6 +151,8 @@ class GlowJITOrcV2 {
   friend class GlowJITDefGenerator;
 
   std::unique_ptr<llvm::TargetMachine> tm_;
+  /// Cache of the objects compiled from the modules, may be null.
+  std::unique_ptr<llvm::ObjectCache> cache_;
   const llvm::DataLayout dl_;
 #if LLVM_VERSION_MAJOR < 13
   std::shared_ptr<llvm::orc::SymbolStringPool> ssp_;
@@ -169,13 +182,20 @@ class GlowJITOrcV2 {
                             const llvm::orc::SymbolLookupSet &LookupSet);
 
 public:
-  GlowJITOrcV2(std::unique_ptr<llvm::TargetMachine> tm);
+  /// Creates a JIT compiling for \p tm, looking up and saving objects in
+  /// \p cache if given.
+  GlowJITOrcV2(std::unique_ptr<llvm::TargetMachine> tm,
+               std::unique_ptr<llvm::ObjectCache> cache = nullptr);
   virtual ~GlowJITOrcV2();
 
   llvm::JITSymbol findSymbol(const std::string &name);
 
   void setContext(std::unique_ptr<llvm::LLVMContext> ctx);
   void addModule(std::unique_ptr<llvm::Module> M);
+
+  /// Add the already compiled object file \p obj. The object must not have
+  /// static constructors or destructors.
+  void addObjectFile(std::unique_ptr<llvm::MemoryBuffer> obj);
 };
 using GlowJIT = GlowJITOrcV2;
 
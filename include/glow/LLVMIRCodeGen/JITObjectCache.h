@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_LLVMIRCODEGEN_JITOBJECTCACHE_H
+#define GLOW_LLVMIRCODEGEN_JITOBJECTCACHE_H
+
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Target/TargetMachine.h"
+
+#include <memory>
+#include <string>
+
+namespace glow {
+
+/// An llvm::ObjectCache keeping the object files compiled by the JIT in a
+/// directory, so that identical modules, e.g. of duplicated partitions or of
+/// the same network after a restart, are only compiled once. Objects are
+/// keyed by the hash of the module's bitcode and of the options of the target
+/// machine compiling it. Files are written atomically, so the directory can be
+/// shared by concurrent compilations and processes.
+class JITObjectCache : public llvm::ObjectCache {
+  /// Directory holding the objects.
+  std::string dir_;
+  /// The part of the key describing the target machine.
+  std::string targetKey_;
+
+  /// \returns the path of the object of \p M in dir_.
+  std::string getPath(const llvm::Module &M) const;
+
+public:
+  /// Creates a cache in \p dir, created if needed, for the objects compiled by
+  /// \p TM.
+  JITObjectCache(llvm::StringRef dir, const llvm::TargetMachine &TM);
+
+  /// Saves the object \p obj compiled from \p M.
+  void notifyObjectCompiled(const llvm::Module *M,
+                            llvm::MemoryBufferRef obj) override;
+
+  /// \returns the object compiled from \p M before, or null.
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *M) override;
+};
+
+/// \returns a JITObjectCache for the objects compiled by \p TM in the
+/// -llvm-jit-cache-dir directory, or null if that option is not set.
+std::unique_ptr<JITObjectCache>
+createJITObjectCache(const llvm::TargetMachine &TM);
+
+} // namespace glow
+
+#endif // GLOW_LLVMIRCODEGEN_JITOBJECTCACHE_H
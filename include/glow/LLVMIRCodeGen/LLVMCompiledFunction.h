@@ -21,6 +21,9 @@
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Backend/CompiledFunction.h"
 
+#include <mutex>
+#include <vector>
+
 namespace glow {
 /// A Glow IR function compiled using LLVM.
 class LLVMCompiledFunction : public CompiledFunction {
@@ -28,6 +31,9 @@ public:
   LLVMCompiledFunction(std::unique_ptr<GlowJIT> JIT,
                        runtime::RuntimeBundle &&runtimeBundle);
 
+  /// Frees the run buffers kept for reuse.
+  virtual ~LLVMCompiledFunction() override;
+
   /// \name CompiledFunction interface
   ///@{
   virtual Error execute(ExecutionContext *context) override;
@@ -50,6 +56,22 @@ protected:
   virtual void updatePlaceholders(PlaceholderBindings *bindings,
                                   uint8_t *weightsAddress);
 
+  /// \returns the start of the caller provided buffer that the tensors in
+  /// \p bindings were bound to by RuntimeBundle::bindIOBuffer(), or nullptr
+  /// if any of this function's Placeholders live elsewhere. A non-null result
+  /// can be used as the mutable weights area as is.
+  uint8_t *getBoundIOBuffer(const PlaceholderBindings *bindings) const;
+
+  /// \returns a buffer of \p size bytes for a single run, taken from
+  /// \p cache if it holds one and freshly allocated otherwise.
+  uint8_t *acquireRunBuffer(std::vector<uint8_t *> &cache, size_t size);
+
+  /// Returns \p buffer of \p size bytes to \p cache for reuse by later runs,
+  /// or frees it if keeping it would retain more than
+  /// -glow_llvm_run_buffer_cache_bytes for this function.
+  void releaseRunBuffer(std::vector<uint8_t *> &cache, uint8_t *buffer,
+                        size_t size);
+
   /// The LLVM JIT engine. The jit must be initialized after the ctor
   /// initializes the LLVM backends.
   std::unique_ptr<GlowJIT> JIT_;
@@ -57,6 +79,18 @@ protected:
   /// The JIT can be accessed from multiple threads but is not thread safe,
   /// JITLock_ protects it.
   std::mutex JITLock_;
+
+  /// Activations and mutable weights buffers of finished runs, kept so the
+  /// next runs don't pay for allocating and faulting in fresh memory. Each
+  /// concurrent run takes its own buffers. Protected by runBuffersLock_.
+  std::vector<uint8_t *> freeActivations_;
+  std::vector<uint8_t *> freeMutableWeights_;
+
+  /// Total size of the buffers in freeActivations_ and freeMutableWeights_.
+  size_t retainedRunBufferBytes_{0};
+
+  /// Protects the run buffer caches.
+  std::mutex runBuffersLock_;
 };
 } // end namespace glow
 
@@ -146,6 +146,10 @@ protected:
   std::string mainEntryName_;
   /// Base name of the saved bundle file, without extension.
   std::string savedBundleName_;
+  /// Whether the glow_parallel_runtime_ functions of libjit are kept.
+  bool preserveParallelRuntime_{false};
+  /// Whether the glow_weights_ functions of libjit are kept.
+  bool preserveWeightsDecompressor_{false};
   /// Instruction number for the module.
   std::unique_ptr<InstructionNumbering> instrNumbering_;
   /// Value holding the base address of the activations memory area.
@@ -335,6 +339,25 @@ protected:
   createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
              llvm::Value *numElements) const;
 
+  /// Create LLVM IR for the for loop from \p start to \p end (exclusive) with
+  /// the step \p step, which runs at least once. The loop is marked for
+  /// vectorization if \p vectorize.
+  /// \returns a pair of basic blocks. The first BB is the BB of the loop body,
+  /// the second BB is the loop exit BB.
+  std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
+  createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
+             llvm::Value *start, llvm::Value *end, llvm::Value *step,
+             bool vectorize) const;
+
+  /// Emit a call of the stacked \p kernel, whose arguments are \p buffers
+  /// followed by the range of elements to process, over the \p numElements
+  /// elements of its instructions. The call is split into tasks of
+  /// dataParallelTaskSize elements run by libjit_parallel_for.
+  void emitDataParallelKernelCall(llvm::IRBuilder<> &builder,
+                                  llvm::Function *kernel,
+                                  llvm::ArrayRef<llvm::Value *> buffers,
+                                  dim_t numElements);
+
   /// \returns the backing tensor associated to the IR constant value \p value.
   Tensor getTensorForConstantValue(Value *value);
 
@@ -378,6 +401,14 @@ public:
                                       const glow::Instruction *I);
   /// Emit LLVM-IR for the whole IRFunction.
   virtual void generateLLVMIRForModule(llvm::IRBuilder<> &builder);
+  /// Fill \p order with the instructions of the IRFunction in the order in
+  /// which to generate their code. Data parallel instructions are moved right
+  /// after the previous bundle of data parallel instructions they can be
+  /// stacked with, if no instruction in between depends on them, so that
+  /// producer-consumer chains of element-wise instructions interleaved with
+  /// other instructions run in a single loop.
+  void
+  scheduleDataParallelInstrs(llvm::SmallVectorImpl<const Instruction *> &order);
   /// Helper function to create a new CallInst, with the specified \p builder,
   /// \p callee, and \p args. Verifies that the function signature is correct,
   /// and then creates and \returns the CallInst.
@@ -408,6 +439,26 @@ public:
   virtual llvm::Function *
   getFunction(const std::string &name,
               llvm::ArrayRef<glow::ElemKind> elemTyArray);
+  /// \returns the name of the libjit float MatMul kernel to call, whose
+  /// register block is sized for the vector registers of the target CPU.
+  virtual std::string getMatMulKernelName() const;
+  /// \returns the name of the libjit int8 kernel to call in place of the
+  /// kernel \p name for the element types \p elemTyArray, which is the
+  /// AVX512-VNNI variant of the kernel when the target CPU supports it, or the
+  /// ARM variant when generating code for AArch64 or for ARM with NEON/MVE.
+  virtual std::string
+  getInt8KernelName(const std::string &name,
+                    llvm::ArrayRef<glow::ElemKind> elemTyArray) const;
+  /// \returns the name of the libjit bfloat16 kernel to call in place of the
+  /// kernel \p name, which is the AVX512-BF16 variant of the kernel when the
+  /// target CPU supports it.
+  virtual std::string getBFloat16KernelName(const std::string &name) const;
+  /// \returns the name of the libjit float16 kernel to call in place of the
+  /// kernel \p name for the element types \p elemTyArray, which is the F16C
+  /// variant of the kernel when the target CPU supports it.
+  virtual std::string
+  getFloat16KernelName(const std::string &name,
+                       llvm::ArrayRef<glow::ElemKind> elemTyArray) const;
   /// \returns current LLVM function.
   virtual llvm::Function *getLLVMFunction();
   /// Optimize the function \p F and the module that owns it. Use the target
@@ -421,6 +472,12 @@ public:
   virtual void performBackendOptimizations();
   /// Insert debug traces in appropriate places.
   virtual void performDebugInstrumentation();
+  /// \returns whether -llvm-code-instrumentation asks for debug traces.
+  static bool hasDebugInstrumentation();
+  /// Read the bodies of the functions of the lazily loaded libjit module that
+  /// the generated code may use, and drop the others. With -libjit-lazy-load
+  /// disabled, or with debug instrumentation, all of them are read.
+  void materializeLibjit();
   /// \returns allocations info.
   virtual AllocationsInfo &getAllocationsInfo() { return allocationsInfo_; }
   /// \returns the name of the bundle, to be used for filename when saving.
@@ -432,6 +489,17 @@ public:
   llvm::StringRef getSavedBundleName() const;
   /// Set the base name of the saved bundle file.
   void setSavedBundleName(const std::string &name);
+  /// Keep the glow_parallel_runtime_ functions of libjit, which let a bundle
+  /// run its kernels on a thread pool, if \p preserve is set. They are
+  /// removed otherwise.
+  void setPreserveParallelRuntime(bool preserve) {
+    preserveParallelRuntime_ = preserve;
+  }
+  /// Keep the glow_weights_ functions of libjit, which decode the compressed
+  /// weights of a bundle, if \p preserve is set. They are removed otherwise.
+  void setPreserveWeightsDecompressor(bool preserve) {
+    preserveWeightsDecompressor_ = preserve;
+  }
   /// \returns the name of the main entry point.
   /// When JITting, it will be "main". In case of bundling it will be the name
   /// of the bundle.
@@ -0,0 +1,46 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_LLVMIRCODEGEN_PERFCOUNTERS_H
+#define GLOW_LLVMIRCODEGEN_PERFCOUNTERS_H
+
+#include "llvm/ADT/ArrayRef.h"
+
+#include <cstdint>
+
+// This file contains the hardware performance counters the JIT code reads
+// around the instrumented instructions when auto instrumentation records
+// counters, see BackendOptions::autoInstrumentCounters. The counters are the
+// perf_event counters of the thread running the function, so the work of
+// operators split across worker threads is only partially counted.
+
+namespace glow {
+
+/// \returns the names of the counters read by glow_read_perf_counters, in
+/// order.
+llvm::ArrayRef<const char *> getPerfCounterNames();
+
+/// Makes glow_read_perf_counters available to the JIT code.
+void registerPerfCountersSymbol();
+
+} // namespace glow
+
+/// Writes to \p counters the first \p numCounters counters of the calling
+/// thread, opening them on its first call on the thread. Counters that can't
+/// be read, e.g. when perf_event is not supported or not allowed, read as 0.
+extern "C" void glow_read_perf_counters(uint64_t *counters,
+                                        uint64_t numCounters);
+
+#endif // GLOW_LLVMIRCODEGEN_PERFCOUNTERS_H
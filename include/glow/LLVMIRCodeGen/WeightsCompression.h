@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_LLVMIRCODEGEN_WEIGHTSCOMPRESSION_H
+#define GLOW_LLVMIRCODEGEN_WEIGHTSCOMPRESSION_H
+
+#include "llvm/ADT/ArrayRef.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace glow {
+
+/// Format of the compressed constant weights of bundles, decoded by the
+/// glow_weights_ functions of libjit (see libjit_weights.cpp). All integers
+/// are little endian. A file header of kWeightsHeaderSize bytes:
+///   uint32 magic, uint32 version, uint64 decoded size
+/// is followed by blocks of at most kWeightsBlockSize decoded bytes, each
+/// made of a header of kWeightsBlockHeaderSize bytes:
+///   uint8 method, uint8[3] reserved, uint32 decoded size,
+///   uint32 encoded size, uint32 reserved, uint64 destination offset
+/// and the encoded size bytes of the payload. Blocks are independent so they
+/// can be decoded one at a time from a small scratch buffer.
+enum class WeightsBlockMethod : uint8_t {
+  /// The payload is the decoded bytes.
+  Raw = 0,
+  /// All the bytes are zero, there is no payload.
+  Zero = 1,
+  /// For each group of 8 bytes, a mask byte whose bit i is set when byte i of
+  /// the group is not zero, followed by the non-zero bytes.
+  Bitmask = 2,
+  /// 128 bytes holding the 4-bit code length of each byte value, the low
+  /// nibble first, followed by the canonical Huffman codes of the bytes,
+  /// most significant bit first.
+  Huffman = 3,
+};
+
+constexpr uint32_t kWeightsMagic = 0x5a574c47; // "GLWZ"
+constexpr uint32_t kWeightsVersion = 1;
+constexpr size_t kWeightsHeaderSize = 16;
+constexpr size_t kWeightsBlockHeaderSize = 24;
+constexpr size_t kWeightsBlockSize = 64 * 1024;
+
+/// \returns \p data compressed in the format above. Each block uses the
+/// method giving the smallest payload.
+std::vector<uint8_t> compressWeights(llvm::ArrayRef<uint8_t> data);
+
+} // namespace glow
+
+#endif // GLOW_LLVMIRCODEGEN_WEIGHTSCOMPRESSION_H
@@ -22,6 +22,8 @@
 #include "glow/Support/Error.h"
 
 namespace glow {
+class TraceContext;
+
 namespace runtime {
 struct PartitionConfig;
 struct PrePartitionedConfig;
@@ -80,6 +82,29 @@ struct PrecisionConfiguration {
   /// Whether to convert indices in FusedRowwiseSLWS to Int64ITy.
   bool convertIndicesToInt64{false};
 
+  /// Whether to quantize the float Constant weights of FullyConnected nodes to
+  /// 4 bits, keeping the activations float, for the backends which support
+  /// Int4GroupwiseQuantizedFullyConnected.
+  bool convertFCWeightsToInt4{false};
+
+  /// Whether to quantize the float Constant weights of FullyConnected nodes to
+  /// int8, quantizing the activations at run time, for the backends which
+  /// support DynamicQuantizedFullyConnected.
+  bool convertFCToDynamicQuantized{false};
+
+  /// If convertFCWeightsToInt4, the number of weights of a row sharing a scale
+  /// and offset. Must be even.
+  unsigned int4FCGroupSize{64};
+
+  /// Whether to product-quantize the float Constant tables of
+  /// SparseLengthsWeightedSum nodes, for the backends which support
+  /// ProductQuantizedSparseLengthsWeightedSum.
+  bool convertSLWSTablesToPQ{false};
+
+  /// If convertSLWSTablesToPQ, the number of columns of the tables encoded by
+  /// each byte code. Must divide the number of columns of the tables.
+  unsigned pqSLWSSubspaceDim{4};
+
   /// If convertToFP16, whether to convert input Placeholders.
   bool convertPlaceholdersToFP16{false};
 
@@ -154,6 +179,11 @@ struct PrecisionConfiguration {
     PRINT_VALUE(convert4BitFusedToFP32, dump_str)
     PRINT_VALUE(convert8BitFusedToFP32, dump_str)
     PRINT_VALUE(convertIndicesToInt64, dump_str)
+    PRINT_VALUE(convertFCWeightsToInt4, dump_str)
+    PRINT_VALUE(convertFCToDynamicQuantized, dump_str)
+    PRINT_VALUE(int4FCGroupSize, dump_str)
+    PRINT_VALUE(convertSLWSTablesToPQ, dump_str)
+    PRINT_VALUE(pqSLWSSubspaceDim, dump_str)
     PRINT_VALUE(convertPlaceholdersToFP16, dump_str)
     PRINT_VALUE(convertConstantsToFP16, dump_str)
     PRINT_VALUE(skipBiasFp32tofp16Convert, dump_str)
@@ -182,6 +212,11 @@ struct OptimizationOptions {
   /// If true, perform compile-time deduplication of Constants.
   bool enableConstantDeduplication{true};
 
+  /// If true, the graph passes supporting it only revisit the nodes that
+  /// changed since their last run in the same pass pipeline, instead of the
+  /// whole Function, see FunctionPass::isIncremental.
+  bool enableIncrementalGraphOptimization{false};
+
   /// For all Splats in the Function being optimized, if they are used by any
   /// Nodes listed in this set, then they will be materialized into Constants
   /// during Constant Folding.
@@ -253,6 +288,17 @@ struct OptimizationOptions {
   /// the SparseNN partitioning scheme
   unsigned int sparseNNPartitioningSchemeSLSTableKBytesPerCard{0};
 
+  /// When non-zero, SparseNN partitioning scheme splits the tables of
+  /// FusedRowwiseQuantizedSparseLengthsWeightedSum nodes larger than this many
+  /// KBytes row-wise into shards, so they can be spread over several cards
+  unsigned int sparseNNPartitioningShardTableKBytes{0};
+
+  /// Rows of SLS embedding tables to serve from a separate hot table, keyed by
+  /// the name of the table, see selectHotSLSTableRows(). SparseNN partitioning
+  /// places hot tables like any other table, while the lookups of all other
+  /// rows go to the full cold table, which may be sharded.
+  std::map<std::string, std::vector<dim_t>> sparseNNPartitioningHotTableRows;
+
   /// The number of cores to assign to SLS partition when using SparseNN
   /// partitioning scheme
   unsigned int sparseNNPartitioningSchemeNumCoresSLS{1};
@@ -261,6 +307,12 @@ struct OptimizationOptions {
   /// partitioning scheme
   unsigned int sparseNNPartitioningSchemeNumCoresOther{1};
 
+  /// Expected number of lookups per inference into each SLS embedding table,
+  /// keyed by the name of the table. When not empty, SparseNN partitioning
+  /// balances the expected lookup bandwidth across cards in addition to
+  /// fitting the tables into their memory. See accumulateSLSTableLookups().
+  std::map<std::string, uint64_t> sparseNNPartitioningTableLookups;
+
   /// The algorithm used for Placement tagging in DAG Optimizer
   std::string DAGOptimizerPlacementTaggingAlgorithm;
 
@@ -306,6 +358,7 @@ struct OptimizationOptions {
     std::string dump_str;
     PRINT_VALUE(enableConstantFolding, dump_str)
     PRINT_VALUE(enableConstantDeduplication, dump_str)
+    PRINT_VALUE(enableIncrementalGraphOptimization, dump_str)
     PRINT_VALUE(delayAndRecordConstantModification, dump_str)
     PRINT_VALUE(skipBackendSupportCheck, dump_str)
     PRINT_VALUE(foldElemKindConversionIntoIO, dump_str)
@@ -393,6 +446,11 @@ struct CompilationContext {
   /// support.
   runtime::DeferredWeightLoader *deferredWeightLoader{nullptr};
 
+  /// If set, the pass managers log a TraceLevel::COMPILE event to this trace
+  /// for every pass they run, with the size of the IR before and after the
+  /// pass and the peak memory usage of the process.
+  TraceContext *traceContext{nullptr};
+
   /// Whether to print out issues/logging during compilation. Used for example
   /// to disable printing issues encountered during ConstantFolding.
   bool verboseCompile{true};
@@ -412,6 +470,14 @@ struct CompilationContext {
   /// Enables Device Resident Tensor optimization.
   bool enableDRT{false};
 
+  /// If non-zero, the tensors passed between the partitions of a network are
+  /// owned by the DAG and allocated this many times, e.g. 2 for double
+  /// buffering, instead of once per execution state. At most this many runs of
+  /// the network are in flight, each on its own set of intermediate buffers,
+  /// so consecutive runs overlap in different partitions. Ignored when P2P or
+  /// DRT is enabled.
+  unsigned pipelineDepth{0};
+
   /// Number of times a function should be replicated on a device. This is
   /// enabled for single partition networks. For advanced replication setups use
   /// user-defined partitioning.
@@ -436,6 +502,12 @@ struct CompilationContext {
   /// Whether to save constant data into the serialized DAG.
   bool saveConstantInSerializeCompiledDAG{false};
 
+  /// If not empty, HostManager::addNetwork writes a snapshot of the network
+  /// to this directory, which HostManager::addNetworkFromSnapshot adds again
+  /// without optimizing it and, where the backend serializes its compiled
+  /// functions, without compiling it.
+  std::string networkSnapshotDir;
+
   /// Whether to call the DAG optimizer after the DAG is created in HostManager.
   bool callDAGOptimizer{false};
 
@@ -469,6 +541,7 @@ struct CompilationContext {
     dump_str.append(optimizationOpts.dump());
     PRINT_VALUE(enableP2P, dump_str)
     PRINT_VALUE(enableDRT, dump_str)
+    PRINT_VALUE(pipelineDepth, dump_str)
     PRINT_VALUE(callDAGOptimizer, dump_str)
     PRINT_VALUE(useDAGOptimizerAOTMode, dump_str)
     return dump_str;
@@ -487,6 +560,19 @@ struct CompilationContext {
                       "Can only use the precisionModeKindSet as a whitelist in "
                       "convertToFP16 mode.");
 
+    RETURN_ERR_IF_NOT(!precisionConfig.convertFCWeightsToInt4 ||
+                          (precisionConfig.int4FCGroupSize > 0 &&
+                           precisionConfig.int4FCGroupSize % 2 == 0),
+                      ErrorValue::ErrorCode::COMPILE_CONTEXT_MALFORMED,
+                      "The int4 FullyConnected group size must be a positive "
+                      "even number.\n");
+
+    RETURN_ERR_IF_NOT(!precisionConfig.convertSLWSTablesToPQ ||
+                          precisionConfig.pqSLWSSubspaceDim > 0,
+                      ErrorValue::ErrorCode::COMPILE_CONTEXT_MALFORMED,
+                      "The product quantization subspace size must be "
+                      "positive.\n");
+
     switch (precisionConfig.quantMode) {
     case QuantizationMode::Profile:
       RETURN_ERR_IF_NOT(bindings,
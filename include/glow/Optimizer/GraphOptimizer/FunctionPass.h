@@ -19,9 +19,12 @@
 #include "glow/PassManager/Pass.h"
 #include "glow/PassManager/PassConfig.h"
 
+#include "llvm/ADT/ArrayRef.h"
+
 namespace glow {
 
 class Function;
+class Node;
 struct CompilationContext;
 enum class FunctionPassID;
 
@@ -59,7 +62,27 @@ public:
 /// Class used for all passes over Functions. All passes over Functions should
 /// derive from this class, implementing the pass logic and additionally can add
 /// logic for running before and after the pass runs.
-using FunctionPass = Pass<Function, FunctionPassConfig>;
+class FunctionPass : public Pass<Function, FunctionPassConfig> {
+public:
+  /// Constructor.
+  FunctionPass(llvm::StringRef name) : Pass(name) {}
+
+  /// \returns whether the pass can run on some of the nodes of a Function
+  /// with runOnNodes. This requires the pass to only transform a node based
+  /// on the node, its inputs and users, and the inputs of its inputs.
+  virtual bool isIncremental() const { return false; }
+
+  /// \returns whether an incremental pass may transform \p N. Only the
+  /// changed nodes the pass is interested in are given to runOnNodes.
+  virtual bool isInterestedIn(const Node &N) const { return true; }
+
+  /// Run the pass on the \p nodes of \p F, which all belong to \p F and
+  /// satisfy isInterestedIn. \returns whether the pass modifies \p F.
+  virtual bool runOnNodes(Function *F, llvm::ArrayRef<Node *> nodes,
+                          const CompilationContext &cctx) {
+    return run(F, cctx);
+  }
+};
 
 } // namespace glow
 
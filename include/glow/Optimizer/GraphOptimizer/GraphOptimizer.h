@@ -209,6 +209,32 @@ parallelizeOps(Function *F,
                const llvm::DenseMap<Node *, ParallelTransformKind> &parOpts,
                size_t numOfChunks = 1, size_t modelParallelSplitAlignment = 1);
 
+/// Cost model of a backend used by planParallelization(). Times are in any
+/// unit as long as they are consistent.
+struct ParallelCostModel {
+  /// Number of cores running the chunks of a node concurrently.
+  unsigned numCores{1};
+  /// Time of a multiply-accumulate on one core.
+  double timePerOp{1.0};
+  /// Time of copying a byte through the Slices and Concats of a split.
+  double timePerByte{1.0};
+  /// Fixed time of running a chunk.
+  double timePerChunk{0.0};
+};
+
+/// Fill \p numOfChunksMap and \p parOpts for parallelizeOps() from
+/// \p costModel instead of per node settings. FullyConnected, MatMul,
+/// BatchMatMul and Convolution nodes get the data or model parallel split and
+/// the number of chunks minimizing their estimated time: the chunks run in
+/// rounds of costModel.numCores, plus the time of slicing the non-constant
+/// inputs and concatenating the result, the slice being free when the input
+/// is produced by a node split the same way. Relu, Clip, Quantize,
+/// Dequantize and RescaleQuantized nodes mirror the split of their input so
+/// that the Concat and Slices between them fold away.
+void planParallelization(Function *F, const ParallelCostModel &costModel,
+                         llvm::DenseMap<Node *, size_t> &numOfChunksMap,
+                         llvm::DenseMap<Node *, ParallelTransformKind> &parOpts);
+
 /// Update quantized Relu output types found in \p F that have negative min to
 /// have min of zero. This normally happens during graph optz, but during AOT
 /// the qparams can not be calculated AOT because all qparams are dummies.
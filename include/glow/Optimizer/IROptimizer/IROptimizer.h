@@ -35,10 +35,11 @@ void optimize(IRFunction &M, const Backend &B, bool shouldShareBuffers);
 /// Helper to generate and optimize IR from given Function \p F. \p
 /// shouldShareBuffers signifies whether to use the share buffers optimization.
 /// Backend /p B is used to allow for custom lowering from Node to
-/// Instruction IR.
-std::unique_ptr<IRFunction> generateAndOptimizeIR(IRContainer *F,
-                                                  const Backend &B,
-                                                  bool shouldShareBuffers);
+/// Instruction IR. If \p minimizePeakMemory is set, the graph is scheduled
+/// for the smallest peak activation memory.
+std::unique_ptr<IRFunction>
+generateAndOptimizeIR(IRContainer *F, const Backend &B, bool shouldShareBuffers,
+                      bool minimizePeakMemory = false);
 } // namespace glow
 
 #endif // GLOW_OPTIMIZER_IROPTIMIZER_IROPTIMIZER_H
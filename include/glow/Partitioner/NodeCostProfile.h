@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_PARTITIONER_NODECOSTPROFILE_H
+#define GLOW_PARTITIONER_NODECOSTPROFILE_H
+
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Support/Error.h"
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace glow {
+
+/// Measured latencies of Nodes, keyed by backend and Node name, which the
+/// Partitioner uses in place of its roofline estimates when balancing
+/// partitions. A profile is built by running a model once per backend with
+/// auto-instrumentation and feeding the resulting TraceEvents to
+/// addTraceEvents(), and is persisted as YAML with save() and load().
+class NodeCostProfile final {
+public:
+  /// Record a single measured latency \p latencyUs in microseconds for the
+  /// Node named \p nodeName running on backend \p backendName.
+  void record(llvm::StringRef backendName, llvm::StringRef nodeName,
+              double latencyUs);
+
+  /// Record the latency of every operator event in \p events, traced while
+  /// running on backend \p backendName. Operator events are Complete events
+  /// carrying a "kind" argument, as emitted for auto-instrumented functions,
+  /// and are named after the instruction and thus the Node they come from.
+  void addTraceEvents(llvm::StringRef backendName,
+                      const std::list<TraceEvent> &events);
+
+  /// \returns the mean measured latency in microseconds of the Node named
+  /// \p nodeName on backend \p backendName, or None if it was never measured.
+  llvm::Optional<double> getLatencyUs(llvm::StringRef backendName,
+                                      llvm::StringRef nodeName) const;
+
+  /// \returns the number of (backend, Node) pairs with a measured latency.
+  size_t size() const;
+
+  /// \returns whether no latency was recorded.
+  bool empty() const { return entries_.empty(); }
+
+  /// Write the profile to the YAML file \p fileName.
+  Error save(llvm::StringRef fileName) const;
+
+  /// \returns the profile read from the YAML file \p fileName.
+  static Expected<NodeCostProfile> load(llvm::StringRef fileName);
+
+private:
+  /// Accumulated measurements of a single Node.
+  struct Entry {
+    double totalUs{0};
+    uint64_t count{0};
+  };
+
+  /// Measurements keyed by backend name, then Node name.
+  std::map<std::string, std::map<std::string, Entry>> entries_;
+};
+
+} // namespace glow
+
+#endif // GLOW_PARTITIONER_NODECOSTPROFILE_H
@@ -16,6 +16,7 @@
 #ifndef GLOW_PARTITIONER_PARTITIONER_H
 #define GLOW_PARTITIONER_PARTITIONER_H
 
+#include "glow/Partitioner/NodeCostProfile.h"
 #include "glow/Partitioner/PartitionerBase.h"
 #include "glow/Support/Error.h"
 
@@ -70,6 +71,10 @@ class Partitioner final : public PartitionerBase {
   /// The struct contain user-defined partition info.
   PartitionConfig partitionConfig_;
 
+  /// Measured Node latencies used in place of the roofline estimates, loaded
+  /// from flags::PartitionerCostProfile unless set with setCostProfile().
+  std::shared_ptr<const NodeCostProfile> costProfile_;
+
   /// Get the representative function (the one with the largest input) and
   /// update the memSize.
   static Function *selectRepFunc(Module *parent, uint64_t &memSize);
@@ -105,7 +110,9 @@ class Partitioner final : public PartitionerBase {
 
   /// Partition a function \p F based on backends \p backends. \returns the
   /// final partition result(or an err) and a map between partitions and backend
-  /// names. \p cctx is used for functions optimization.
+  /// names. \p cctx is used for functions optimization. Independent branches
+  /// assigned to different backends end up in partitions that don't depend
+  /// on each other, so that they can run concurrently.
   Expected<DAGListTy>
   backendBasedPartition(FunctionToBackendNameMap &funcToBackend, Function *F,
                         std::vector<Backend *> &backends,
@@ -155,6 +162,11 @@ public:
   /// Set contextCount_ to provided /p count.
   void setContextCount(unsigned count) { contextCount_ = count; }
 
+  /// Use the measured Node latencies in \p profile to balance partitions.
+  void setCostProfile(std::shared_ptr<const NodeCostProfile> profile) {
+    costProfile_ = std::move(profile);
+  }
+
   /// Based on \p partitionConfig passed into Partitioner, do user-defined
   /// partition.
   Expected<DAGListTy>
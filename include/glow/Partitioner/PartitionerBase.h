@@ -41,16 +41,15 @@ protected:
   /// Given the node-function mapping \p mapping, do the actual partitioning. If
   /// \p saveDAG is true, the DAG will be generated. \returns the final
   /// partitions or an empty partition (If \p saveDAG is false). Normally this
-  /// is done by cloning Nodes from each Function in \p funcs into other new
-  /// Functions representing each partition. However if \p skipCloning we skip
-  /// this cloning, as it is assumed that the Functions are already partitioned
-  /// correctly and so we do not need to clone their Nodes into new Functions.
-  /// \p nodeInfo represents any info mapped to Nodes, so when cloning Nodes we
-  /// need to update this map.
+  /// is done by moving Nodes from each Function in \p funcs into other new
+  /// Functions representing each partition, which leaves \p funcs empty.
+  /// However if \p skipCloning we skip this move, as it is assumed that the
+  /// Functions are already partitioned correctly and so we do not need to move
+  /// their Nodes into new Functions. Info mapped to the Nodes, such as the
+  /// BackendSpecificNodeInfo, stays valid as the Nodes are moved.
   DAGListTy doPartitioning(llvm::StringRef funcName,
                            std::vector<Function *> funcs, Module *module,
                            NodeToFunctionMap &mapping, bool saveDAG,
-                           BackendSpecificNodeInfo &nodeInfo,
                            bool skipCloning = false);
 };
 } // namespace glow
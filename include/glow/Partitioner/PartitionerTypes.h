@@ -21,6 +21,8 @@
 
 namespace glow {
 
+class NodeCostProfile;
+
 using namespace runtime;
 
 using NodesSet = std::set<Node *>;
@@ -93,6 +95,9 @@ struct BackendInfo {
   float peakPCIeBw;
   /// Backend pointer.
   Backend *backend = nullptr;
+  /// Measured Node latencies which take precedence over the roofline
+  /// estimates when not null.
+  const NodeCostProfile *costProfile = nullptr;
   /// The non-supported nodes kind.
   std::set<Kinded::Kind> nonSupportedNodesKinds;
   /// The supported nodes kind.
@@ -107,12 +112,16 @@ struct SLSTableInfo {
   unsigned int deviceId;
   NodeValue slsResult;
   uint64_t cost;
+  /// Expected bytes read from the table per inference, 0 if unknown.
+  uint64_t lookupBytes{0};
 };
 
 struct SLSDeviceInfo {
   unsigned int deviceId;
   uint64_t memAvailableInBytes;
   size_t currentCost;
+  /// Expected bytes read per inference from the tables on the device.
+  uint64_t currentLookupBytes{0};
 };
 
 /// A mapping of newly-created functions along with a set of nodes sets. The
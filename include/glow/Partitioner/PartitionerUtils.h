@@ -17,9 +17,13 @@
 #define GLOW_PARTITIONER_PARTITIONUTILS_H
 
 #include "glow/Graph/Graph.h"
+#include "glow/Graph/PlaceholderBindings.h"
 #include "glow/Partitioner/PartitionerTypes.h"
 #include "llvm/ADT/DenseMap.h"
 
+#include <map>
+#include <unordered_map>
+
 namespace glow {
 /// Visit nodes if Function \p F in BFS order and return the nodes by levels
 /// (the longest distance between one node and the root).
@@ -39,7 +43,18 @@ uint64_t getOutMemPerNode(const NodesSet &nodes, const Node *node);
 /// Given a node, \returns the NodeSet of inputs of this node.
 NodesSet getInputs(const Node *node);
 
-/// Return the estimated op computation time based on \p backendInfo.
+/// \returns the number of arithmetic ops \p node performs, counting a multiply
+/// and an add per MAC of the matrix multiplications and convolutions and an op
+/// per output element of the data parallel nodes.
+uint64_t getNodeFlops(const Node *node);
+
+/// \returns the number of bytes \p node reads and writes, as used by the
+/// roofline estimate of getNodeComputeTime().
+uint64_t getNodeBytesMoved(const Node *node);
+
+/// Return the estimated op computation time in seconds based on \p
+/// backendInfo. The latency measured in backendInfo.costProfile is used when
+/// there is one for \p node, otherwise it is estimated from the roofline.
 float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo);
 
 /// Given a node, \returns the memory usage of its inputs (i.e. Storage input).
@@ -74,7 +89,8 @@ void printSlsTableInfo(std::vector<SLSTableInfo>::iterator start,
 void printSlsTableInfo(std::vector<SLSTableInfo> &slsTables,
                        bool verbose_only = true);
 
-/// Print deviceId, used_memory, free_memory, cost, node_size, cost/used_memory.
+/// Print deviceId, used_memory, free_memory, cost, node_size, cost/used_memory
+/// and lookup_bytes.
 /// Used memeory is calculated using \p nodesets and \p contextCount. If
 /// verbose_only is true, we use VLOG(1), otherwise we use LOG(INFO).
 void printSlsDeviceInfo(const std::vector<SLSDeviceInfo> &slsDevices,
@@ -84,6 +100,53 @@ void printSlsDeviceInfo(const std::vector<SLSDeviceInfo> &slsDevices,
 // Returns whether \p node is an SLS node
 bool isSLSNode(const Node *node);
 
+/// Add the number of lookups made into each SLS embedding table of \p F by
+/// the indices bound in \p bindings to \p tableLookups, keyed by the name of
+/// the table. Calling it on a sample of inference requests and dividing by
+/// the number of samples gives OptimizationOptions'
+/// sparseNNPartitioningTableLookups.
+void accumulateSLSTableLookups(const Function &F,
+                               const PlaceholderBindings &bindings,
+                               std::map<std::string, uint64_t> &tableLookups);
+
+/// Same as accumulateSLSTableLookups(), but counts the lookups of every row
+/// of each table in \p rowLookups.
+void accumulateSLSTableRowLookups(
+    const Function &F, const PlaceholderBindings &bindings,
+    std::map<std::string, std::unordered_map<dim_t, uint64_t>> &rowLookups);
+
+/// \returns the at most \p maxHotRows most looked up rows of each table in
+/// \p rowLookups, most frequent first.
+std::map<std::string, std::vector<dim_t>> selectHotSLSTableRows(
+    const std::map<std::string, std::unordered_map<dim_t, uint64_t>>
+        &rowLookups,
+    size_t maxHotRows);
+
+/// For every FusedRowwiseQuantizedSparseLengthsWeightedSum node in \p F whose
+/// Constant table has rows in \p hotRows, copy those rows into a compact hot
+/// table. Indices are remapped onto it by a Gather from a per-row remap, and
+/// indices without a hot row are looked up in the original table, now the
+/// cold table, with the weights of hot rows set to zero on either side. The
+/// two pooled results are summed up to replace the original node. \returns
+/// the number of tables split.
+Expected<unsigned>
+splitHotSLSTableRows(Function *F,
+                     const std::map<std::string, std::vector<dim_t>> &hotRows);
+
+/// \returns the expected bytes read per inference from the table of SLS node
+/// \p node given the lookups per inference \p tableLookups, 0 if unknown.
+uint64_t getSLSTableLookupBytes(
+    const Node *node, const std::map<std::string, uint64_t> &tableLookups);
+
+/// Split the Constant table of every
+/// FusedRowwiseQuantizedSparseLengthsWeightedSum node in \p F larger than
+/// \p maxShardBytes row-wise into shards of at most \p maxShardBytes. Each
+/// shard gets its own SLS node, which looks up the indices falling into its
+/// rows with zero weight for all others, and the partial pooled results are
+/// summed up to replace the original node. \returns the number of tables
+/// sharded.
+Expected<unsigned> shardLargeSLSTables(Function *F, uint64_t maxShardBytes);
+
 // Returns whether all inputs to \p node are of the kind \p kind
 bool checkNodeInputsAllKind(const Node *node, glow::Kinded::Kind kind);
 
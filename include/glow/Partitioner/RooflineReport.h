@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_PARTITIONER_ROOFLINEREPORT_H
+#define GLOW_PARTITIONER_ROOFLINEREPORT_H
+
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Runtime/RuntimeTypes.h"
+#include "glow/Support/Error.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <list>
+#include <map>
+#include <string>
+
+namespace glow {
+
+/// Per-Node efficiency report, comparing the operator latencies measured with
+/// auto-instrumentation to the roofline bound of the device: the larger of
+/// the time to perform the Node's ops at peak compute and the time to move
+/// its bytes at peak bandwidth, see getNodeComputeTime(). Nodes are added
+/// with addFunction(), measurements with addTraceEvents(), and the Nodes
+/// whose efficiency is below the threshold are flagged by dump().
+class RooflineReport final {
+public:
+  /// Roofline metrics and measurements of a single Node.
+  struct Entry {
+    std::string kind;
+    uint64_t flops{0};
+    uint64_t bytes{0};
+    /// Roofline bound of the Node in microseconds.
+    double rooflineUs{0};
+    /// Whether the bound is set by the peak compute rather than bandwidth.
+    bool computeBound{false};
+    double totalUs{0};
+    uint64_t count{0};
+
+    /// \returns the mean measured latency in microseconds.
+    double getMeasuredUs() const { return count ? totalUs / count : 0; }
+
+    /// \returns the fraction of the roofline bound the Node reaches, 0 if it
+    /// was never measured.
+    double getEfficiency() const;
+  };
+
+  /// Create a report for the device described by \p deviceInfo, flagging the
+  /// Nodes that reach less than \p efficiencyThreshold of the roofline.
+  RooflineReport(const runtime::DeviceInfo &deviceInfo,
+                 double efficiencyThreshold);
+
+  /// Add every Node of \p F to the report.
+  void addFunction(const Function *F);
+
+  /// Record the latency of every operator event in \p events, matched to the
+  /// added Nodes by name as in NodeCostProfile::addTraceEvents().
+  void addTraceEvents(const std::list<TraceEvent> &events);
+
+  /// \returns the entry of the Node named \p nodeName, nullptr if it was not
+  /// added.
+  const Entry *getEntry(llvm::StringRef nodeName) const;
+
+  /// \returns whether the measured Node \p entry is below the threshold.
+  bool isFlagged(const Entry &entry) const;
+
+  /// Print the measured Nodes to \p os, slowest first.
+  void dump(llvm::raw_ostream &os) const;
+
+  /// Write the report to the file \p fileName.
+  Error save(llvm::StringRef fileName) const;
+
+private:
+  /// Device the roofline bounds are computed for.
+  runtime::DeviceInfo deviceInfo_;
+
+  /// Efficiency below which Nodes are flagged.
+  double efficiencyThreshold_;
+
+  /// Entries keyed by Node name.
+  std::map<std::string, Entry> entries_;
+};
+
+} // namespace glow
+
+#endif // GLOW_PARTITIONER_ROOFLINEREPORT_H
@@ -22,6 +22,8 @@
 #include "llvm/Support/CommandLine.h"
 
 #include <atomic>
+#include <unordered_map>
+#include <vector>
 
 namespace glow {
 
@@ -56,12 +58,37 @@ struct PassManagerOptions {
 
   llvm::cl::opt<unsigned> stopAfterPassNumOpt;
 
+  llvm::cl::opt<bool> timePassesOpt;
+
   PassManagerOptions(const char *id);
   /// Helper to check if \p otherStr is in \p strList.
   static bool listContainsString(const llvm::cl::list<std::string> &strList,
                                  llvm::StringRef otherStr);
 };
 
+/// Statistics about the runs of a pass in a run of a pass manager.
+struct PassStatistics {
+  /// Name of the pass.
+  std::string name;
+  /// Number of times the pass ran.
+  unsigned numRuns{0};
+  /// Number of runs of the pass that modified the IR.
+  unsigned numChanges{0};
+  /// Total wall time of the runs of the pass, in microseconds. The time of a
+  /// pass includes the time of the passes it runs, e.g. a DCE required before
+  /// it.
+  uint64_t totalTimeUs{0};
+  /// Total change of the size of the IR, e.g. the number of nodes of a
+  /// Function, over the runs of the pass.
+  int64_t sizeDelta{0};
+  /// Peak resident memory of the process at the end of the last run of the
+  /// pass, in kilobytes.
+  uint64_t maxRSSKB{0};
+  /// Total growth of the peak resident memory of the process during the runs
+  /// of the pass, in kilobytes.
+  uint64_t maxRSSGrowthKB{0};
+};
+
 /// The base class for pass managers. It contains most of the logic common for
 /// all pass managers, but provides a number of hooks that can be overridden by
 /// concrete pass manager to customize the behavior.
@@ -76,6 +103,28 @@ protected:
   size_t passIdx_ = 0;
   /// The Backend we have for backend-specific verification.
   const Backend *backend_;
+  /// Change stamp of the IR container before the last run of every pass ID in
+  /// the current run of the pipeline, for the pass managers running passes
+  /// incrementally.
+  std::unordered_map<unsigned, uint64_t> lastRunStamps_;
+  /// Statistics of the passes of the last run of the pipeline, in the order
+  /// in which they first ran. Only collected when the passes are timed or
+  /// traced.
+  std::vector<PassStatistics> passStats_;
+  /// Position in passStats_ of the statistics of every pass name.
+  std::unordered_map<std::string, size_t> passStatsIdx_;
+
+  /// \returns whether to collect the statistics of the passes run given
+  /// \p cctx.
+  bool shouldCollectPassStatistics(const CompilationContext &cctx) const;
+
+  /// Record in passStats_, and in the trace of \p cctx if any, the run of
+  /// pass \p P on \p C that started at \p startTime, with the IR of size
+  /// \p sizeBefore and the peak resident memory \p maxRSSBefore, and that
+  /// modified the IR if \p changed.
+  void recordPassRun(IRContainer *C, const CompilationContext &cctx,
+                     const PassBase &P, uint64_t startTime, size_t sizeBefore,
+                     uint64_t maxRSSBefore, bool changed);
 
   /// Logic to execute before pass \p P is run on \p C, given \p cctx. \returns
   /// if \p C was modified.
@@ -133,6 +182,9 @@ protected:
   virtual void dumpIR(IRContainer *C, llvm::raw_ostream &os,
                       const std::string &outputFileName) const = 0;
 
+  /// \returns the size of the IR of \p C, e.g. its number of nodes.
+  virtual size_t getIRSize(IRContainer *C) const = 0;
+
 public:
   /// Constructor.
   PassManagerBase(llvm::StringRef name) : Named(name) {}
@@ -141,6 +193,18 @@ public:
   /// Dump a textual representation of the Manager to \p os.
   void dump(llvm::raw_ostream &os = llvm::outs()) const;
 
+  /// \returns the statistics of the passes of the last run of the pipeline.
+  /// Only collected when the option to time the passes is set, or when the
+  /// CompilationContext of the run has a trace logging TraceLevel::COMPILE
+  /// events.
+  const std::vector<PassStatistics> &getPassStatistics() const {
+    return passStats_;
+  }
+
+  /// Dump a table of the statistics of the passes of the last run of the
+  /// pipeline to \p os.
+  void dumpPassStatistics(llvm::raw_ostream &os = llvm::outs()) const;
+
   /// \returns the result of verification for a provided IR container \p C.
   virtual bool verify(IRContainer &C) const = 0;
 
@@ -271,6 +335,8 @@ public:
   void dumpIR(IRContainer *C, llvm::raw_ostream &os,
               const std::string &outputFileName) const override;
 
+  size_t getIRSize(IRContainer *C) const override;
+
   /// Get options of this pass manager.
   const PassManagerOptions &getOptions() const override { return options_; }
 
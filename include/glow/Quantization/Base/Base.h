@@ -21,6 +21,8 @@
 #include "glow/Base/Traits.h"
 #include "glow/Base/Type.h"
 
+#include "llvm/ADT/StringMap.h"
+
 #include <algorithm>
 #include <cassert>
 #include <cstdlib>
@@ -247,6 +249,19 @@ enum Calibration {
   KLMinimization
 };
 
+/// Precision of a specific node, which takes precedence over the options of the
+/// Function for that node, see QuantizationConfiguration::nodePrecisions.
+enum class NodePrecision {
+  /// Quantized with the precision of the QuantizationConfiguration.
+  Quantized,
+  /// Quantized channelwise if supported for the node, e.g. for Convolution.
+  ChannelwiseQuantized,
+  /// Not quantized and converted to float16.
+  FP16,
+  /// Not quantized nor converted.
+  FP32,
+};
+
 /// Configuration for Profiling, passed into \ref profileQuantization().
 struct ProfilingConfiguration {
   /// Number of bins used to compute the histogram during profiling.
@@ -302,8 +317,30 @@ struct QuantizationConfiguration {
   /// If true, don't apply quantization to FC bias inputs.
   bool skipQuantizeFCBias{false};
 
+  /// Precisions of specific nodes, by node name, e.g. as chosen by the
+  /// precision-tuner tool. A node found here is quantized only if its
+  /// precision is Quantized or ChannelwiseQuantized, channelwise regardless of
+  /// enableChannelwise for the latter, and converted to float16 if its
+  /// precision is FP16, even if the Function is not converted to float16.
+  llvm::StringMap<NodePrecision> nodePrecisions;
+
   QuantizationConfiguration() = default;
   QuantizationConfiguration(llvm::ArrayRef<NodeProfilingInfo> i) : infos(i) {}
+
+  /// \returns the precision of the node named \p name in nodePrecisions, or
+  /// nullptr if it follows the options of the Function.
+  const NodePrecision *getNodePrecision(llvm::StringRef name) const {
+    auto it = nodePrecisions.find(name);
+    return it == nodePrecisions.end() ? nullptr : &it->second;
+  }
+
+  /// \returns whether the precision of any node in nodePrecisions is \p P.
+  bool hasNodePrecision(NodePrecision P) const {
+    return std::any_of(nodePrecisions.begin(), nodePrecisions.end(),
+                       [P](const llvm::StringMapEntry<NodePrecision> &entry) {
+                         return entry.getValue() == P;
+                       });
+  }
 };
 
 /// \returns the tensor average value based on the profiling info \p profParams.
@@ -542,9 +579,8 @@ void tensorRowwiseQuantization(const Tensor &input, Tensor &output,
   for (dim_t i = 0; i < idim.height; i++) {
     auto slice = srcH.extractSlice(i);
     auto rSrc = slice.getHandle<float>();
-    auto res = rSrc.minMaxArg();
-    float min = rSrc.raw(res.first);
-    float max = rSrc.raw(res.second);
+    float min, max;
+    std::tie(min, max) = rSrc.minMax();
 
     // Handle rowwise quantization for FCs.
     if (offsetIsInt32) {
@@ -625,9 +661,8 @@ void tensorFusedRowwiseQuantization(const Tensor &input, Tensor &output) {
   for (dim_t i = 0, e = input.dims()[0]; i < e; i++) {
     auto slice = srcH.extractSlice(i);
     auto rSrc = slice.getHandle<float>();
-    auto res = rSrc.minMaxArg();
-    float min = rSrc.raw(res.first);
-    float max = rSrc.raw(res.second);
+    float min, max;
+    std::tie(min, max) = rSrc.minMax();
 
     float range;
     switch (outputType) {
@@ -677,6 +712,36 @@ void tensorFusedRowwiseQuantization(const Tensor &input, Tensor &output) {
   }
 }
 
+/// Quantize the rows of the float tensor \p input to 4 bits in groups of
+/// \p groupSize columns, for Int4GroupwiseQuantizedFullyConnected. Row i of
+/// \p output packs the quantized row i of \p input two values per byte, the
+/// even columns in the low nibbles. Every group is quantized over its range,
+/// and dequantized as scale * q + offset with the float16 \p scales and
+/// \p offsets of the group. The quantization uses the scales and offsets
+/// rounded to float16, so that it matches the dequantization.
+/// \pre input.dims().size() == 2
+/// \pre output.dims() == {input.dims()[0], (input.dims()[1] + 1) / 2}
+/// \pre scales.dims() == offsets.dims() ==
+///      {input.dims()[0], ceil(input.dims()[1] / groupSize)}
+void tensorInt4GroupwiseQuantization(const Tensor &input, Tensor &output,
+                                     Tensor &scales, Tensor &offsets,
+                                     dim_t groupSize);
+
+/// Product-quantize the rows of the float tensor \p input, for
+/// ProductQuantizedSparseLengthsWeightedSum. Every row is split into
+/// codes.dims()[1] subvectors of codebooks.dims()[2] elements. The
+/// codebooks.dims()[1] centroids of each subspace are found with
+/// \p numIterations iterations of k-means over at most \p maxTrainingRows
+/// rows evenly spread over \p input, and element {r, s} of \p codes is the
+/// centroid of \p codebooks closest to subvector s of row r.
+/// \pre input.dims().size() == 2
+/// \pre codes.dims() == {input.dims()[0], numSubspaces} of UInt8ITy
+/// \pre codebooks.dims() == {numSubspaces, numCentroids, subDim} of FloatTy
+/// \pre numSubspaces * subDim == input.dims()[1] and numCentroids <= 256
+void tensorProductQuantization(const Tensor &input, Tensor &codes,
+                               Tensor &codebooks, unsigned numIterations = 10,
+                               dim_t maxTrainingRows = 65536);
+
 /// Generic function to compute the quantization parameters for an input
 /// floating-point tensor \p tensor with given schema \p qSchema and type
 /// \p qTy. A separate set of quantization parameters (scale, offset) will
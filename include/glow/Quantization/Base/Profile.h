@@ -18,6 +18,7 @@
 #define GLOW_QUANTIZATION_BASE_PROFILE_H
 
 #include "glow/Base/Tensor.h"
+#include "glow/Quantization/Base/Base.h"
 
 namespace glow {
 namespace quantization {
@@ -50,6 +51,15 @@ std::vector<float> rescaleHistogram(const std::vector<float> &srcHist,
                                     const float destHistMin,
                                     const float destHistMax);
 
+/// Combine into the profile \p dest of a tensor the profile \p src of the same
+/// tensor collected on other inputs, with as many histogram bins. The range of
+/// \p dest is extended to include the range of \p src and the two histograms,
+/// rescaled to that range with rescaleHistogram, are summed. A profile which
+/// has not seen any value, and thus has a min greater than its max, is
+/// ignored.
+void combineTensorProfilingParams(TensorProfilingParams &dest,
+                                  const TensorProfilingParams &src);
+
 } // namespace quantization
 } // namespace glow
 
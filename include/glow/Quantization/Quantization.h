@@ -86,6 +86,13 @@ Node *replaceQuantizedTanhWithLookupTable(Function &F, const TanhNode &TN,
 Node *replaceQuantizedSigmoidWithLookupTable(Function &F, const SigmoidNode &SN,
                                              Schema schema = Asymmetric);
 
+/// Support the quantized unary elementwise \p node inside \p F, one of
+/// HardSwish, Gelu, Swish, Erf, Sigmoid, Tanh, Exp or Log, by replacing it with
+/// an IntLookupTable mapping the quantized type of its input to the quantized
+/// type of its result. \returns the IntLookupTable, or nullptr if \p node is
+/// of another kind or is a Log of input range containing negative values.
+Node *replaceQuantizedUnaryWithLookupTable(Function &F, const Node &node);
+
 } // namespace quantization
 } // namespace glow
 
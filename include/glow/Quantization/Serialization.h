@@ -35,6 +35,49 @@ bool deserializeProfilingInfosFromYaml(
     llvm::StringRef fileName, llvm::hash_code &graphPreLowerHash,
     std::vector<NodeProfilingInfo> &profilingInfos);
 
+/// Serialize into the file named \p fileName the hash \p graphPreLowerHash
+/// of the graph pre lowering and the profiling information \p profilingInfos
+/// in the compact binary profile format, where every histogram is stored as
+/// a packed array of floats.
+void serializeProfilingInfosToBinary(
+    llvm::StringRef fileName, llvm::hash_code graphPreLowerHash,
+    std::vector<NodeProfilingInfo> &profilingInfos);
+
+/// Deserialize from the file named \p fileName in the binary profile format
+/// the hash \p graphPreLowerHash of the graph pre lowering and the profiling
+/// information \p profilingInfos.
+bool deserializeProfilingInfosFromBinary(
+    llvm::StringRef fileName, llvm::hash_code &graphPreLowerHash,
+    std::vector<NodeProfilingInfo> &profilingInfos);
+
+/// Serialize into the file named \p fileName the hash \p graphPreLowerHash
+/// of the graph pre lowering and the profiling information \p profilingInfos,
+/// in the binary profile format if \p fileName has the extension ".bin" and in
+/// YAML otherwise.
+void serializeProfilingInfos(llvm::StringRef fileName,
+                             llvm::hash_code graphPreLowerHash,
+                             std::vector<NodeProfilingInfo> &profilingInfos);
+
+/// Deserialize from the file named \p fileName, in the binary profile format
+/// or in YAML as detected from its content, the hash \p graphPreLowerHash of
+/// the graph pre lowering and the profiling information \p profilingInfos.
+bool deserializeProfilingInfos(llvm::StringRef fileName,
+                               llvm::hash_code &graphPreLowerHash,
+                               std::vector<NodeProfilingInfo> &profilingInfos);
+
+/// Serialize into the YAML file named \p fileName the precisions of specific
+/// nodes \p nodePrecisions, by node name.
+void serializeNodePrecisions(
+    llvm::StringRef fileName,
+    const llvm::StringMap<quantization::NodePrecision> &nodePrecisions);
+
+/// Deserialize from the YAML file named \p fileName the precisions of specific
+/// nodes \p nodePrecisions, by node name. \returns false if the file does not
+/// exist.
+bool deserializeNodePrecisions(
+    llvm::StringRef fileName,
+    llvm::StringMap<quantization::NodePrecision> &nodePrecisions);
+
 } // namespace glow
 
 #endif
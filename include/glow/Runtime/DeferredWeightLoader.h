@@ -23,7 +23,12 @@
 #include "glow/Support/Register.h"
 #include "glow/Support/Support.h"
 
+#include <list>
+#include <memory>
+
 namespace glow {
+class ZipReader;
+
 namespace runtime {
 
 /// A base class for deferred weight loaders. This allows for large weights to
@@ -51,12 +56,56 @@ public:
   /// Gets the Tensor for the current weight.
   virtual Tensor *getTensor() = 0;
 
+  /// \returns whether the Tensors of the loaded weights stay valid after the
+  /// next weights are loaded, until the loader is given another source. The
+  /// Provisioner then transfers several weights to the devices while loading
+  /// the next ones.
+  virtual bool keepsLoadedWeights() const { return false; }
+
   virtual ~DeferredWeightLoader() = default;
 
 protected:
   std::map<std::string, glow::Type> typeInfo_;
 };
 
+/// A deferred weight loader reading the weights from a zip archive written by
+/// ZipWriter. Every weight is a record of its raw payload named by the weight,
+/// and the weights are loaded in the order of their names in the type info.
+/// The archive is memory-mapped, and the Tensors of the uncompressed records
+/// point into the mapping instead of owning a copy of their payload.
+class ZipDeferredWeightLoader final : public DeferredWeightLoader {
+public:
+  ZipDeferredWeightLoader();
+  ~ZipDeferredWeightLoader() override;
+
+  Error loadNextWeight() override;
+
+  /// Accepts the path of the archive as a const char * \p loaderObject.
+  Error setSrc(void *loaderObject) override;
+
+  void setTypeInfo(std::map<std::string, Type> info) override;
+
+  std::string getName() override { return name_; }
+
+  Tensor *getTensor() override {
+    return name_.empty() ? nullptr : &weights_.back();
+  }
+
+  bool keepsLoadedWeights() const override { return true; }
+
+private:
+  /// Reader of the records of the mapped archive.
+  std::unique_ptr<ZipReader> zip_;
+  /// Names of the weights, in loading order.
+  std::vector<std::string> names_;
+  /// Position in \ref names_ of the next weight to load.
+  size_t next_{0};
+  /// Name of the current weight, empty once all weights are loaded.
+  std::string name_;
+  /// Tensors of the weights loaded from the current archive.
+  std::list<Tensor> weights_;
+};
+
 class DeferredWeightLoaderRegistry final {
 public:
   void registerLoader(DeferredWeightLoader *loader);
@@ -16,7 +16,10 @@
 #ifndef GLOW_RUNTIME_HEALTHMONITOR_H
 #define GLOW_RUNTIME_HEALTHMONITOR_H
 
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace glow {
@@ -28,13 +31,18 @@ public:
   /// Dtor.
   virtual ~DeviceHealthMonitor() = default;
 
-  /// Start monitoring the device health
+  /// Start monitoring the device health. Monitors report the changes of health
+  /// of the devices with DeviceHealthMonitorRegistry::reportDeviceHealth().
   virtual void start() = 0;
 };
 
 /// Registry of StatsExporters.
 class DeviceHealthMonitorRegistry final {
 public:
+  /// Callback of the health signals, called with the ID of the device, see
+  /// DeviceConfig::deviceID, and whether it is healthy.
+  using DeviceHealthCB = std::function<void(unsigned deviceID, bool healthy)>;
+
   /// Start all the device health monitors
   void start() {
     for (auto *monitor : monitors_) {
@@ -48,12 +56,30 @@ public:
   /// Revoke a DeviceHealthMonitor.
   void revokeDeviceHealthMonitor(DeviceHealthMonitor *exporter);
 
+  /// Register \p callback as the listener of the health signals of \p owner,
+  /// replacing any previous one.
+  void addListener(const void *owner, DeviceHealthCB callback);
+
+  /// Revoke the listener of \p owner. When this returns the listener is not
+  /// running and won't be called anymore.
+  void removeListener(const void *owner);
+
+  /// Called by the monitors to tell the listeners that the device \p deviceID
+  /// became healthy or not, per \p healthy.
+  void reportDeviceHealth(unsigned deviceID, bool healthy);
+
   /// Static singleton DeviceHealthMonitor.
   static std::shared_ptr<DeviceHealthMonitorRegistry> Monitors();
 
 private:
   /// Registered StatsExporters.
   std::vector<DeviceHealthMonitor *> monitors_;
+
+  /// Listeners of the health signals by owner.
+  std::unordered_map<const void *, DeviceHealthCB> listeners_;
+
+  /// Mutex around listeners_, held while they are called.
+  std::mutex listenersLock_;
 };
 
 } // namespace glow
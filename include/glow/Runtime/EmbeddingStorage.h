@@ -0,0 +1,154 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_EMBEDDINGSTORAGE_H
+#define GLOW_RUNTIME_EMBEDDINGSTORAGE_H
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "glow/Base/Tensor.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Support/Error.h"
+#include "glow/Support/ThreadPool.h"
+
+#include "llvm/ADT/ArrayRef.h"
+
+namespace glow {
+namespace runtime {
+
+/*
+ * Embedding table stored in a file, for tables too large for host memory.
+ * The file holds the rows back to back, each in the layout of the rows of
+ * the table tensor, e.g. the fused rowwise quantized rows of a
+ * UInt8FusedQTy table. Rows are read with batched positioned reads issued
+ * concurrently, behind an LRU cache of recently used rows in memory.
+ */
+class EmbeddingTableFile {
+public:
+  /// Opens the table \p fileName of rows of \p rowSize bytes, caching up to
+  /// \p cacheRows rows in memory and reading with \p numReadThreads threads.
+  static Expected<std::shared_ptr<EmbeddingTableFile>>
+  open(const std::string &fileName, size_t rowSize, size_t cacheRows,
+       unsigned numReadThreads = 4);
+
+  ~EmbeddingTableFile();
+
+  /// Copies the rows \p rows, sorted without duplicates, to consecutive rows
+  /// of \p dst. Rows missing from the cache are read in one read per run of
+  /// consecutive rows, with the reads issued concurrently.
+  Error readRows(llvm::ArrayRef<uint64_t> rows, uint8_t *dst);
+
+  const std::string &getFileName() const { return fileName_; }
+  size_t getNumRows() const { return numRows_; }
+  size_t getRowSize() const { return rowSize_; }
+
+  /// \returns the number of rows served by the cache.
+  uint64_t getNumCacheHits() const { return numCacheHits_; }
+  /// \returns the number of rows read from the file.
+  uint64_t getNumRowsRead() const { return numRowsRead_; }
+  /// \returns the number of reads issued to the file.
+  uint64_t getNumReads() const { return numReads_; }
+
+private:
+  EmbeddingTableFile(const std::string &fileName, int fd, size_t numRows,
+                     size_t rowSize, size_t cacheRows,
+                     unsigned numReadThreads);
+
+  /// Reads the \p numRows rows starting at \p row into \p dst. \returns
+  /// false on a read error.
+  bool readRange(uint64_t row, size_t numRows, uint8_t *dst);
+
+  std::string fileName_;
+  int fd_;
+  size_t numRows_;
+  size_t rowSize_;
+  size_t cacheRows_;
+  ThreadPool readPool_;
+
+  /// Guards the cache.
+  std::mutex cacheMutex_;
+  /// Cached rows with the slot of cacheData_ holding them, most recently used
+  /// first.
+  std::list<std::pair<uint64_t, size_t>> lru_;
+  std::unordered_map<uint64_t, std::list<std::pair<uint64_t, size_t>>::iterator>
+      cache_;
+  std::vector<uint8_t> cacheData_;
+
+  std::atomic<uint64_t> numCacheHits_{0};
+  std::atomic<uint64_t> numRowsRead_{0};
+  std::atomic<uint64_t> numReads_{0};
+};
+
+/// Writes the rows of \p table to \p fileName in the format
+/// EmbeddingTableFile reads.
+Error writeEmbeddingTableFile(const std::string &fileName,
+                              const Tensor &table);
+
+/*
+ * Fetches the rows used by an SLS from an EmbeddingTableFile before the
+ * run. The table input of the SLS is a Placeholder with at least as many
+ * rows as the SLS has indices: it is bound to a compact table of the rows
+ * the request uses, and the indices to indices remapped into it. Indices are
+ * checked against the rows of the file, so the fetch must run before the
+ * input sanitizers, which then check the remapped indices.
+ */
+class EmbeddingRowFetcher {
+public:
+  EmbeddingRowFetcher(std::shared_ptr<EmbeddingTableFile> table,
+                      Placeholder *dataPH, Placeholder *indicesPH);
+
+  /// Binds the table and indices to the fetched rows and remapped indices
+  /// owned by \p storage, which must outlive the run. The original inputs
+  /// are not modified.
+  Error fetch(PlaceholderBindings &bindings, std::vector<Tensor> &storage);
+
+  std::string toString();
+
+private:
+  std::shared_ptr<EmbeddingTableFile> table_;
+  Placeholder *dataPH_{nullptr};
+  Placeholder *indicesPH_{nullptr};
+};
+
+using EmbeddingRowFetcherPtr = std::shared_ptr<EmbeddingRowFetcher>;
+
+/// Map from the name of a table Placeholder to the file holding it.
+using EmbeddingTableFileMap =
+    std::unordered_map<std::string, std::shared_ptr<EmbeddingTableFile>>;
+
+//
+// Public utility functions
+//
+
+/// \returns the fetchers of the SLS and EmbeddingBag nodes of \p function
+/// whose table is one of \p tables.
+Expected<std::vector<EmbeddingRowFetcherPtr>>
+getEmbeddingRowFetchers(const Function &function,
+                        const EmbeddingTableFileMap &tables);
+Error fetchEmbeddingRows(const std::vector<EmbeddingRowFetcherPtr> &fetchers,
+                         PlaceholderBindings &bindings,
+                         std::vector<Tensor> &storage);
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_EMBEDDINGSTORAGE_H
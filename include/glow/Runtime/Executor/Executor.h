@@ -47,12 +47,20 @@ public:
   /// and prevent new requests from being initiated.
   virtual void shutdown() = 0;
 
-  /// Setup context pool for new network.
+  /// Setup context pool for new network. If \p pipelineDepth is non-zero the
+  /// tensors passed between the network's DAG nodes are shared by the pool in
+  /// \p pipelineDepth sets, see CompilationContext::pipelineDepth.
   virtual void createPool(const DAGNode *root, unsigned poolSize,
-                          bool enableP2P, bool enableDRT) = 0;
+                          bool enableP2P, bool enableDRT,
+                          unsigned pipelineDepth = 0) = 0;
 
   /// Free the context pool for given network.
   virtual void freePool(const DAGNode *root) = 0;
+
+  /// \returns the number of bytes of host and device buffers held by the
+  /// context pool of the network rooted at \p root for the tensors passed
+  /// between its DAG nodes.
+  virtual uint64_t getBufferBytes(const DAGNode *root) const { return 0; }
 };
 
 } // namespace runtime
@@ -17,47 +17,138 @@
 #define GLOW_RUNTIME_EXECUTOR_NETWORKEXECUTIONSTATE_H
 
 #include "glow/Runtime/RuntimeTypes.h"
+#include "glow/Runtime/StatsExporter.h"
 #include "glow/Support/TensorPool.h"
 #include "glow/Support/ThreadPool.h"
 
+#include <atomic>
+#include <deque>
 #include <mutex>
 
 namespace glow {
 namespace runtime {
 
+class NetworkExecutionStatePool;
+
+/// Flat form of the DAG of a network, built once when the pool of its states
+/// is created since the DAG doesn't change after addNetwork(). The nodes are
+/// numbered in topological waves, the nodes of a wave only depending on nodes
+/// of earlier waves, and the states keep the per-run data of a node at its
+/// index, so that dispatching a node involves no walk or lookup of the DAG.
+class ExecutionPlan final {
+public:
+  /// A node of the DAG.
+  struct Step {
+    /// The node.
+    DAGNode *node{nullptr};
+    /// Wave of the node, 0 for the nodes that run as soon as a run starts.
+    unsigned wave{0};
+    /// Number of parents of the node.
+    unsigned numParents{0};
+    /// Indices of the children of the node.
+    std::vector<unsigned> children;
+    /// The devices the node was assigned to when the plan was built.
+    std::vector<std::pair<DeviceIDTy, DeviceManager *>> devices;
+  };
+
+  /// Builds the plan of the DAG under \p root, whose nodes run on
+  /// \p devices.
+  ExecutionPlan(const DAGNode *root, const DeviceManagerMapTy &devices);
+
+  /// \returns the root of the DAG.
+  const DAGNode *getRoot() const { return root_; }
+
+  /// \returns the nodes of the DAG, in topological waves.
+  llvm::ArrayRef<Step> getSteps() const { return steps_; }
+
+  /// \returns the node at index \p idx.
+  const Step &getStep(unsigned idx) const { return steps_[idx]; }
+
+  /// \returns the indices of the children of the root.
+  llvm::ArrayRef<unsigned> getRootSteps() const { return rootSteps_; }
+
+  /// \returns the DeviceManager of ID \p id running the node at \p idx,
+  /// or nullptr if there is none. Devices the node was moved to after the
+  /// plan was built are looked up in the map of devices.
+  DeviceManager *getDevice(unsigned idx, DeviceIDTy id) const;
+
+private:
+  /// Root of the DAG.
+  const DAGNode *root_;
+
+  /// Nodes of the DAG.
+  std::vector<Step> steps_;
+
+  /// Indices of the children of the root.
+  std::vector<unsigned> rootSteps_;
+
+  /// Map of all available DeviceManagers.
+  const DeviceManagerMapTy &devices_;
+};
+
 /// This class keeps track of the state of execution for a run (identified
 /// by the runId).
 class NetworkExecutionState final {
 public:
-  /// Constructor.
-  explicit NetworkExecutionState(const DAGNode *root, bool enableDRT,
+  /// Constructor. The state runs the DAG described by \p plan.
+  explicit NetworkExecutionState(const ExecutionPlan &plan, bool enableDRT,
                                  bool enableP2P, int64_t state_id);
 
   const DAGNode *getRoot() { return root_; }
 
+  /// \returns the plan of the DAG run by this state.
+  const ExecutionPlan &getPlan() const { return plan_; }
+
+  /// \returns the pool that owns this state, if any.
+  NetworkExecutionStatePool *getPool() const { return pool_; }
+
   /// Destructor.
   ~NetworkExecutionState();
 
   /// Does the BFS traversal and initializes the NetworkExecutionState. Takes in
   /// a map of all deviceManagers \p devices , and \p staticAssignment , a map
   /// between each node an a deviceManager. If this is an empty map no
-  /// assignment is made.
+  /// assignment is made. No buffers are allocated for
+  /// \p pipelinePlaceholders, they are bound to the pool's pipeline buffers
+  /// for every run with bindPipelineBuffers().
   void init(const DeviceManagerMapTy &devices,
-            std::unordered_map<DAGNode *, DeviceIDTy> &staticAssignment);
+            std::unordered_map<DAGNode *, DeviceIDTy> &staticAssignment,
+            llvm::ArrayRef<Placeholder *> pipelinePlaceholders = {});
 
   /// Binds the state to a new run. This moves the result ctx and cb to be owned
   /// by the networkExecutionState for the duration of the run.
   void bind(std::unique_ptr<ExecutionContext> resultCtx, ResultCBTy cb,
             RunIdentifierTy runId);
 
-  /// \returns a unique pointer to an input bindings for \p node. This should
-  /// not be called at the same time as insertIntoNodeCtx().
-  std::unique_ptr<ExecutionContext>
-  getUniqueNodeContextPtr(const DAGNode *node);
+  /// Points this run's pipeline Placeholders at \p buffers, set \p slot of
+  /// the pool's pipeline buffers, in the order given to init(). Placeholders
+  /// the caller bound in the result context keep using the caller's tensors.
+  void bindPipelineBuffers(unsigned slot, llvm::ArrayRef<void *> buffers);
+
+  /// \returns the set of pipeline buffers bound by bindPipelineBuffers().
+  unsigned getPipelineSlot() const { return pipelineSlot_; }
+
+  /// \returns whether this state uses the pool's pipeline buffers.
+  bool isPipelined() const { return !pipelinePlaceholders_.empty(); }
+
+  /// Start transferring the inputs of the run that no DAG node produces to
+  /// the devices of the nodes that read them, for every node that doesn't run
+  /// right away. The transfers overlap with the first nodes, and a node's
+  /// device finds its inputs already resident when the node runs. Only has an
+  /// effect with Device Resident Tensors and a static device assignment.
+  void prefetchInputs();
 
-  /// Returns the intermediateContext back to the networkExecutionState after
-  /// completion so it can be re-used.
-  void returnUniqueNodeContextPtr(const DAGNode *node,
+  /// Release the device copies made by prefetchInputs() once the run is done.
+  void releasePrefetchedInputs();
+
+  /// \returns a unique pointer to an input bindings for the node at index
+  /// \p step of the plan. This should not be called at the same time as
+  /// insertIntoNodeCtx().
+  std::unique_ptr<ExecutionContext> getUniqueNodeContextPtr(unsigned step);
+
+  /// Returns the intermediateContext of the node at index \p step back to the
+  /// networkExecutionState after completion so it can be re-used.
+  void returnUniqueNodeContextPtr(unsigned step,
                                   std::unique_ptr<ExecutionContext> ctx);
 
   /// Increment the count of inflight nodes by \p increment (default is 1).
@@ -68,10 +159,15 @@ public:
   /// operation.
   bool decrementInflightNodes(unsigned decrement = 1);
 
-  /// Increment the count of completed parent nodes for \p node. \returns
-  /// true if all parents are done after the increment operation, false
-  /// otherwise.
-  bool incrementNodeParentsDone(const DAGNode *node, unsigned increment = 1);
+  /// Increment the count of completed parent nodes for the node at index
+  /// \p step of the plan. \returns true if all parents are done after the
+  /// increment operation, false otherwise. Nodes with a single parent have no
+  /// counter to update.
+  bool incrementNodeParentsDone(unsigned step, unsigned increment = 1);
+
+  /// Call the output ready callback of the result context, if any, for each
+  /// output of the run computed by the node at index \p step of the plan.
+  void notifyOutputsReady(unsigned step);
 
   /// Move all events from the provided vector into the top level resultContxt.
   void insertIntoTraceContext(TraceContext *runCtx);
@@ -94,10 +190,37 @@ public:
   /// \returns the run ID for the execution.
   RunIdentifierTy getRunId() const { return runId_; }
 
+  /// \returns the number of bytes of the intermediate buffers allocated by
+  /// this state.
+  uint64_t getBufferBytes() const { return bufferBytes_; }
+
   /// Whether or not this node has been initialized.
   bool initialized_{false};
 
 private:
+  friend class NetworkExecutionStatePool;
+
+  /// Points the tensors of the Placeholders bound in resultCtx_ at the
+  /// caller's tensors.
+  void bindExternalIO();
+
+  /// Record \p binding, the binding of \p PH in a node context, so it can be
+  /// pointed at the caller's tensor for \p PH.
+  void addExternalPlaceholder(
+      Placeholder *PH, PlaceholderBindings::PlaceholderMap::iterator binding);
+
+  /// Plan of the DAG run by this state.
+  const ExecutionPlan &plan_;
+
+  /// The NetworkExecutionStatePool that owns this state.
+  NetworkExecutionStatePool *pool_{nullptr};
+
+  /// Index of this state inside the NetworkExecutionStatePool that owns it.
+  uint32_t poolIndex_{0};
+
+  /// Set of pipeline buffers used by the current run.
+  unsigned pipelineSlot_{0};
+
   /// The run identifier for this execution of a DAG.
   RunIdentifierTy runId_;
 
@@ -112,13 +235,32 @@ private:
   /// Whether Peer to Peer optimization is enabled for the state.
   bool enableP2P_;
 
+  /// Cleared once a device refuses a prefetch so it isn't tried again.
+  std::atomic<bool> prefetchSupported_{true};
+
+  /// For every node that doesn't run right away, the bindings of its inputs
+  /// that are prefetched by prefetchInputs(), along with the device they're
+  /// transferred to.
+  std::vector<
+      std::pair<DeviceManager *,
+                std::vector<PlaceholderBindings::PlaceholderMap::iterator>>>
+      prefetchInputs_;
+
+  /// Tensors transferred by prefetchInputs() during the current run, along
+  /// with the device holding them.
+  std::vector<std::pair<DeviceManager *, Tensor *>> prefetchedInputs_;
+
+  /// The non-static Placeholders written by each node of the plan.
+  std::vector<std::vector<Placeholder *>> nodeOutputs_;
+
   /// The ExecutionContext object containing the results of the execution
   /// (i.e. the outputs of the DAGNodes that have no children).
   std::unique_ptr<ExecutionContext> resultCtx_;
 
-  /// Counters for how many of each nodes parents are done. These are needed
-  /// in order to determine when a node is ready to be executed.
-  std::unordered_map<const DAGNode *, std::atomic<unsigned>> nodeParentsDone_;
+  /// Counters for how many of each nodes parents are done, indexed like the
+  /// nodes of the plan. These are needed in order to determine when a node is
+  /// ready to be executed.
+  std::unique_ptr<std::atomic<unsigned>[]> nodeParentsDone_;
 
   /// Count of current inflight nodes.
   std::atomic<unsigned> inflightNodes_;
@@ -136,6 +278,9 @@ private:
   /// Map of all buffers allocated for intermediate contexts.
   std::unordered_map<Placeholder *, void *> buffers_;
 
+  /// Total size in bytes of the buffers in buffers_.
+  uint64_t bufferBytes_{0};
+
   /// Map from buffer to device that allocated it, used at destruction to
   /// free buffers.
   std::unordered_map<void *, DeviceManager *> deviceAllocations_;
@@ -157,32 +302,158 @@ private:
   /// Mapping of a placeholder to its position in externalPlaceholders_.
   std::unordered_map<Placeholder *, int> externalPlaceholdersIdx_;
 
-  /// Input contexts for all of the nodes. These are gradually
-  /// populated as a node's parents finish.
-  std::unordered_map<const DAGNode *, std::unique_ptr<ExecutionContext>>
-      intermediateContexts_;
+  /// For each Placeholder passed to init() as a pipeline Placeholder, the
+  /// bindings in the node contexts that have to point at the run's pipeline
+  /// buffer.
+  std::vector<std::vector<PlaceholderBindings::PlaceholderMap::iterator>>
+      pipelinePlaceholders_;
+
+  /// Input contexts for all of the nodes, indexed like the nodes of the plan.
+  /// These are gradually populated as a node's parents finish.
+  std::vector<std::unique_ptr<ExecutionContext>> intermediateContexts_;
 };
 
+/// Pool of NetworkExecutionStates for a single network. Free states are kept
+/// on a lock-free stack so that concurrent requests can acquire and release
+/// states without serializing on a mutex. All states must be added with
+/// addNewState() before the pool is shared between threads.
 class NetworkExecutionStatePool {
 public:
-  NetworkExecutionState *getNextNetworkExecutionState() {
-    std::lock_guard<std::mutex> lock(stateLock_);
-    auto nextState = availableStates_.front();
-    availableStates_.pop_front();
-    return nextState;
-  }
-
+  /// String consts for exporting pool usage through the StatsExporter. Hits
+  /// are states handed out right away, misses are states handed out after
+  /// waiting for another run to return one, and exhaustions are requests for
+  /// which no state became available at all.
+  static constexpr const char *kStatePoolHits = "glow.executor.state_pool.hits";
+  static constexpr const char *kStatePoolMisses =
+      "glow.executor.state_pool.misses";
+  static constexpr const char *kStatePoolExhausted =
+      "glow.executor.state_pool.exhausted";
+
+  /// Creates the pool of the states running the DAG under \p root, whose
+  /// nodes run on \p devices.
+  NetworkExecutionStatePool(const DAGNode *root,
+                            const DeviceManagerMapTy &devices);
+
+  /// \returns the plan of the DAG run by the states of the pool.
+  const ExecutionPlan &getPlan() const { return plan_; }
+
+  /// Flushes any counters that haven't been exported yet.
+  ~NetworkExecutionStatePool();
+
+  /// \returns a free state from the pool. If none is free, briefly waits for
+  /// one to be returned and \returns nullptr if the pool stays exhausted.
+  NetworkExecutionState *getNextNetworkExecutionState();
+
+  /// Add \p state to the pool. Not thread safe with respect to other calls.
   void addNewState(std::unique_ptr<NetworkExecutionState> state);
 
-  void returnNetworkExecutionState(NetworkExecutionState *state) {
-    std::lock_guard<std::mutex> lock(stateLock_);
-    availableStates_.push_back(state);
+  /// Return \p state, which was handed out by this pool, to the free list.
+  void returnNetworkExecutionState(NetworkExecutionState *state);
+
+  /// Allocate \p depth sets of buffers on \p device for the Placeholders
+  /// that DAG nodes under \p root pass to other DAG nodes. Must be called
+  /// before any state is added, and the states must be initialized with
+  /// getPipelinePlaceholders(). Every run then holds one set for its whole
+  /// duration, so at most \p depth runs are in flight but they can overlap
+  /// in different nodes of the DAG.
+  void createPipelineBuffers(const DAGNode *root, unsigned depth,
+                             DeviceManager *device);
+
+  /// \returns the Placeholders that have pipeline buffers, in the order of
+  /// the buffers in each set.
+  llvm::ArrayRef<Placeholder *> getPipelinePlaceholders() const {
+    return pipelinePlaceholders_;
   }
 
+  /// \returns whether the states of this pool use pipeline buffers.
+  bool hasPipelineBuffers() const { return !pipelineBuffers_.empty(); }
+
+  /// Bind a free set of pipeline buffers to \p state and \returns true. If
+  /// all sets are in use, queues \p state and \returns false; it is bound
+  /// and handed back by releasePipelineBuffers() once a set frees up.
+  bool acquirePipelineBuffers(NetworkExecutionState *state);
+
+  /// Release the set of pipeline buffers bound to \p state. \returns the
+  /// oldest queued state, which now holds that set and can start running, or
+  /// nullptr if none was waiting.
+  NetworkExecutionState *releasePipelineBuffers(NetworkExecutionState *state);
+
+  /// \returns the total number of states owned by the pool.
+  size_t getNumStates() const { return states_.size(); }
+
+  /// \returns the number of states handed out without waiting.
+  uint64_t getNumHits() const { return numHits_; }
+
+  /// \returns the number of states handed out after waiting.
+  uint64_t getNumMisses() const { return numMisses_; }
+
+  /// \returns the number of requests for which no state was available.
+  uint64_t getNumExhausted() const { return numExhausted_; }
+
+  /// \returns the number of bytes of the intermediate and pipeline buffers
+  /// held by the states of the pool.
+  uint64_t getBufferBytes() const { return bufferBytes_; }
+
 private:
+  /// Pop a state off the free list, \returns nullptr if it is empty.
+  NetworkExecutionState *tryPop();
+
+  /// Export counts accumulated since the last flush.
+  void flushStats();
+
+  /// Plan of the DAG run by the states of the pool.
+  ExecutionPlan plan_;
+
+  /// Number of times getNextNetworkExecutionState() retries before giving up
+  /// on an empty pool.
+  static constexpr unsigned kMaxAcquireRetries = 64;
+
+  /// Number of hits accumulated locally before they are exported.
+  static constexpr uint64_t kStatsFlushInterval = 1024;
+
+  /// All states owned by the pool. Index i is referred to as i + 1 in the
+  /// free list, 0 meaning the end of the list.
   std::vector<std::unique_ptr<NetworkExecutionState>> states_;
-  std::deque<NetworkExecutionState *> availableStates_;
-  std::mutex stateLock_;
+
+  /// For each state, the free list link to the next free state.
+  std::deque<std::atomic<uint32_t>> nextFree_;
+
+  /// Head of the free list. The low 32 bits hold the index of the first free
+  /// state and the high 32 bits a tag that is bumped on every update to make
+  /// compare-and-swap immune to ABA.
+  std::atomic<uint64_t> head_{0};
+
+  /// Usage counters, and the values they had at the last flush.
+  std::atomic<uint64_t> numHits_{0};
+  std::atomic<uint64_t> numMisses_{0};
+  std::atomic<uint64_t> numExhausted_{0};
+  std::atomic<uint64_t> flushedHits_{0};
+
+  /// Keeps the stats exporter registry alive as long as the pool.
+  std::shared_ptr<StatsExporterRegistry> statsExporterRegistry_;
+
+  /// Placeholders passed between DAG nodes that have pipeline buffers.
+  std::vector<Placeholder *> pipelinePlaceholders_;
+
+  /// pipelineBuffers_[s][i] is the buffer of set s for
+  /// pipelinePlaceholders_[i].
+  std::vector<std::vector<void *>> pipelineBuffers_;
+
+  /// Total size in bytes of the buffers of the states and the pipeline
+  /// buffers.
+  uint64_t bufferBytes_{0};
+
+  /// Device that allocated the pipeline buffers.
+  DeviceManager *pipelineDevice_{nullptr};
+
+  /// Sets of pipeline buffers not bound to any run.
+  std::vector<unsigned> freePipelineSlots_;
+
+  /// States waiting for a set of pipeline buffers, oldest first.
+  std::deque<NetworkExecutionState *> pipelineWaiters_;
+
+  /// Protects freePipelineSlots_ and pipelineWaiters_.
+  std::mutex pipelineLock_;
 };
 
 } // namespace runtime
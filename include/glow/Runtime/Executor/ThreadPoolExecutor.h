@@ -24,6 +24,7 @@
 #include "folly/Synchronized.h"
 #include "folly/executors/CPUThreadPoolExecutor.h"
 #include "glow/Runtime/Executor/Executor.h"
+#include "glow/Support/WorkStealingThreadPool.h"
 
 namespace glow {
 namespace runtime {
@@ -60,18 +61,25 @@ private:
 /// handle and process multiple concurrent execution runs.
 class ThreadPoolExecutor final : public Executor {
 public:
-  /// Constructor.
+  /// Constructor. If \p workStealing is set, results returned by the
+  /// DeviceManagers are handled on a WorkStealingThreadPool, and DAG nodes
+  /// made ready by a finished node are dispatched from the completing worker
+  /// with any extra ready nodes left on its deque for idle workers to steal.
   explicit ThreadPoolExecutor(const DeviceManagerMapTy &deviceManagers,
                               unsigned numWorkers = kNumWorkers,
-                              const std::string &name = "");
+                              const std::string &name = "",
+                              bool workStealing = false);
 
   /// Setup context pool for new network.
   void createPool(const DAGNode *root, unsigned poolSize, bool enableP2P,
-                  bool enableDRT) override;
+                  bool enableDRT, unsigned pipelineDepth = 0) override;
 
   /// Free the context pool for specified network.
   void freePool(const DAGNode *root) override;
 
+  /// See Executor::getBufferBytes.
+  uint64_t getBufferBytes(const DAGNode *root) const override;
+
   /// See Executor::run. A particular invocation is specified completely by
   /// the triple (roots, bindings, runId).
   void run(const DAGNode *root, std::unique_ptr<ExecutionContext> context,
@@ -81,28 +89,40 @@ public:
 
   void shutdown() override;
 
+  /// \returns whether this executor uses work-stealing dispatch.
+  bool isWorkStealing() const { return workStealingPool_ != nullptr; }
+
 private:
-  /// Execute the DAG node specified by \p node within the run corresponding to
-  /// \p state.
-  void executeDAGNode(NetworkExecutionState *executionState, DAGNode *node);
+  /// Schedule \p fn on whichever thread pool this executor is using.
+  void schedule(folly::Func fn);
+
+  /// Start executing the root's children for the run bound to \p state.
+  void startRun(NetworkExecutionState *state);
+
+  /// Execute the DAG node at index \p step of the plan of \p executionState
+  /// within the run corresponding to that state.
+  void executeDAGNode(NetworkExecutionState *executionState, unsigned step);
 
   /// Handle the result returned asynchronously by the DeviceManager.
   /// \p executionState is tracks the state of the run that the node that
   /// finished executing belongs to, \p err is the Error returned by the
   /// DeviceManager, \p ctx is the ExecutionContext that contains the outputs
-  /// produced by \p node during the run.
+  /// produced during the run by the node at index \p step of the plan.
   ///
   /// The main purpose of this function is to help move computation off of the
   /// DeviceManager thread pool on onto the one owned by this class.
   void handleDeviceManagerResult(NetworkExecutionState *executionState,
                                  Error err,
                                  std::unique_ptr<ExecutionContext> ctx,
-                                 const DAGNode *node);
+                                 unsigned step);
 
   /// The default number of workers in the thread pool.
   constexpr static unsigned kNumWorkers = 3;
-  /// The thread pool used to drive execution.
-  folly::CPUThreadPoolExecutor threadPool_;
+  /// The thread pool used to drive execution. Null if workStealingPool_ is
+  /// used instead.
+  std::unique_ptr<folly::CPUThreadPoolExecutor> threadPool_;
+  /// The work-stealing thread pool used to drive execution, if enabled.
+  std::unique_ptr<WorkStealingThreadPool> workStealingPool_;
 
   /// Map of networkExecutionState pools for each network.
   folly::Synchronized<std::unordered_map<
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_HOSTMANAGER_EXECUTIONCONTEXTPOOL_H
+#define GLOW_RUNTIME_HOSTMANAGER_EXECUTIONCONTEXTPOOL_H
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Support/TensorPool.h"
+
+#include <memory>
+#include <vector>
+
+namespace glow {
+namespace runtime {
+
+class DeviceManager;
+
+/// Hands out ExecutionContexts for the runs of a network, with a Tensor bound
+/// to each of the non-static Placeholders of the network's Module. The Tensors
+/// come from a TensorPool and go back to it when the PlaceholderBindings of a
+/// context are destroyed, usually when the result callback of the run is done
+/// with the context, so that serving requests allocates no Tensor in steady
+/// state. The contexts must be destroyed before the pool. When given a device,
+/// the Tensors use its IO buffers, see DeviceManager::allocateDeviceIOBuffer(),
+/// which the device may pin so that it transfers the inputs and outputs of the
+/// runs without staging copies; the pool must then be destroyed before the
+/// device.
+class ExecutionContextPool final {
+  /// The Module of the network, which owns the Placeholders.
+  std::shared_ptr<Module> module_;
+
+  /// The Placeholders bound in the contexts.
+  std::vector<Placeholder *> placeholders_;
+
+  /// Pool of the Tensors bound in the contexts.
+  TensorPool tensorPool_;
+
+public:
+  /// Constructor. Reserves the Tensors of \p count contexts for the
+  /// Placeholders of \p module, in IO buffers of \p device if not null.
+  ExecutionContextPool(std::shared_ptr<Module> module, size_t count,
+                       DeviceManager *device = nullptr);
+
+  /// \returns a context with a Tensor bound to each Placeholder of the
+  /// network. The Tensors of the Placeholders that are marked as allocZero are
+  /// zeroed, the others hold the data of a previous run.
+  std::unique_ptr<ExecutionContext> get();
+
+  /// \returns the Placeholders bound in the contexts.
+  llvm::ArrayRef<Placeholder *> getPlaceholders() const {
+    return placeholders_;
+  }
+
+  /// \returns the statistics of the pool of the Tensors of the contexts.
+  const TensorPool::Stats &getStats() { return tensorPool_.getStats(); }
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_HOSTMANAGER_EXECUTIONCONTEXTPOOL_H
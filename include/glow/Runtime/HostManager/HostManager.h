@@ -20,6 +20,11 @@
 #include "glow/Backends/DeviceManager.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Runtime/Executor/Executor.h"
+#include "glow/Runtime/HostManager/ExecutionContextPool.h"
+#include "glow/Runtime/HostManager/RequestBatcher.h"
+#include "glow/Runtime/HostManager/ResultCache.h"
+#include "glow/Runtime/HostManager/SequenceLoop.h"
+#include "glow/Runtime/HostManager/ShapeBuckets.h"
 #include "glow/Runtime/Provisioner/Provisioner.h"
 #include "glow/Runtime/RuntimeTypes.h"
 #include "glow/Runtime/StatsExporter.h"
@@ -28,10 +33,18 @@
 #include <map>
 #include <mutex>
 #include <queue>
+#include <set>
 #include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
+// The awaitable runNetworkAsync is only available to C++20 code with
+// coroutines; Glow itself builds without them.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define GLOW_HAS_COROUTINES 1
+#endif
+
 #if FACEBOOK_INTERNAL
 namespace folly {
 struct dynamic;
@@ -40,6 +53,49 @@ struct dynamic;
 
 namespace glow {
 namespace runtime {
+/// Memory held for a network added to a HostManager, in bytes.
+struct NetworkMemoryUsage {
+  /// Constant weights of the network's partitions.
+  uint64_t constantBytes{0};
+  /// Mutable weights, i.e. inputs, outputs and tensors passed between
+  /// partitions, as laid out by the partitions' RuntimeBundles.
+  uint64_t mutableWeightBytes{0};
+  /// Peak activation memory of the partitions.
+  uint64_t activationBytes{0};
+  /// Buffers held by the Executor's execution states for the tensors passed
+  /// between partitions.
+  uint64_t hostBytes{0};
+  /// Growth of the process' peak resident memory while the network was
+  /// compiled and provisioned. Zero if it was already higher or is unknown.
+  uint64_t compileTransientBytes{0};
+  /// Constant, mutable and activation bytes placed on each device the
+  /// network's partitions were loaded on.
+  std::map<DeviceIDTy, uint64_t> deviceBytes;
+};
+
+/// Memory of a device owned by a HostManager, in bytes.
+struct DeviceMemoryUsage {
+  /// Memory of the device, as reported by its DeviceManager.
+  uint64_t maximumBytes{0};
+  /// Free memory, as reported by its DeviceManager.
+  uint64_t availableBytes{0};
+  /// maximumBytes - availableBytes.
+  uint64_t usedBytes{0};
+  /// Part of the memory of the device accounted to the networks of the
+  /// HostManager, see NetworkMemoryUsage::deviceBytes.
+  uint64_t networkBytes{0};
+};
+
+#ifdef GLOW_HAS_COROUTINES
+template <typename Executor> class RunNetworkAwaitable;
+
+/// The default executor of runNetworkAsync, which resumes the awaiting
+/// coroutine on the thread completing the run.
+struct ResumeInline {
+  template <typename F> void post(F &&fn) { fn(); }
+};
+#endif
+
 /// The HostManager serves as an entry point into the Runtime environment. It
 /// provides an interface to add, run, and evict networks from the host. It
 /// handles DeviceManager initialization, houses the Executor, and calls into
@@ -56,6 +112,29 @@ class HostManager final {
     /// use an atomic refcount rather than just store a shared_ptr for thread
     /// safety.
     std::atomic<size_t> refcount{0};
+
+    /// Coalesces requests for this network when request batching is enabled.
+    std::unique_ptr<RequestBatcher> batcher;
+
+    /// Results of recent runs of this network when result caching is
+    /// enabled. Shared with the callbacks of the runs filling it.
+    std::shared_ptr<ResultCache> resultCache;
+
+    /// Moving average of the time in microseconds a run of this network
+    /// takes from dispatch to completion. Zero until the first run completes.
+    std::atomic<uint64_t> latencyEstimate{0};
+
+    /// Time in microseconds requests spent queued before being dispatched.
+    LatencyHistogram queueWaitLatency;
+
+    /// Time in microseconds from dispatch to the Executor returning a result.
+    LatencyHistogram executionLatency;
+
+    /// Time in microseconds spent in the user's result callback.
+    LatencyHistogram callbackLatency;
+
+    /// See NetworkMemoryUsage::compileTransientBytes.
+    uint64_t compileTransientBytes{0};
   };
   /// Container for inference requests waiting in the queue.
   struct InferRequest {
@@ -77,20 +156,30 @@ class HostManager final {
     /// Timestamp for request creation.
     uint64_t startTime;
 
+    /// Time by which the request has to complete, 0 if it has no deadline.
+    uint64_t deadline;
+
     // Define greater than operator to allow sorting in priority_heap for queue
-    // reqests. If priority is the same fall back to order of submission.
+    // reqests. Within the same priority the earliest deadline goes first,
+    // requests without a deadline go last, and ties fall back to order of
+    // submission.
     bool operator>(const InferRequest &inferReq) const {
-      if (priority == inferReq.priority) {
-        return requestID > inferReq.requestID;
+      if (priority != inferReq.priority) {
+        return priority > inferReq.priority;
       }
-      return priority > inferReq.priority;
+      if (deadline != inferReq.deadline) {
+        return deadline == 0 ||
+               (inferReq.deadline != 0 && deadline > inferReq.deadline);
+      }
+      return requestID > inferReq.requestID;
     }
     InferRequest(std::string networkName,
                  std::unique_ptr<ExecutionContext> context, ResultCBTy callback,
-                 uint64_t priority, uint64_t requestID, uint64_t startTime = 0)
+                 uint64_t priority, uint64_t requestID, uint64_t startTime = 0,
+                 uint64_t deadline = 0)
         : networkName{networkName}, context{std::move(context)},
           callback{callback}, priority{priority}, requestID{requestID},
-          startTime{startTime} {}
+          startTime{startTime}, deadline{deadline} {}
   };
 
   /// Count of current in-flight networks being run. Atomic to allow
@@ -101,14 +190,49 @@ class HostManager final {
   /// concurrency in runNetwork.
   std::atomic<size_t> totalRequestCount_{0};
 
-  /// Priority queue for queued requests. This is a min-heap so lowest value is
-  /// popped first.
-  std::priority_queue<InferRequest, std::vector<InferRequest>,
-                      std::greater<InferRequest>>
-      inferQueue_;
+  /// Queued requests and fair-share scheduling state of a single network.
+  struct NetworkQueue {
+    /// Priority queue for queued requests. This is a min-heap so lowest value
+    /// is popped first.
+    std::priority_queue<InferRequest, std::vector<InferRequest>,
+                        std::greater<InferRequest>>
+        requests;
+
+    /// Scheduling options for the network.
+    NetworkSchedulingConfig config;
+
+    /// Number of the network's requests dispatched and not yet completed.
+    size_t activeRequests{0};
+
+    /// Virtual time at which the network is next due for a dispatch. Advances
+    /// by kSchedulingStride / weight on every dispatch.
+    uint64_t pass{0};
+
+    /// \returns true if the network has a request that may be dispatched.
+    bool isReady() const {
+      return !requests.empty() && (config.maxActiveRequests == 0 ||
+                                   activeRequests < config.maxActiveRequests);
+    }
+  };
+
+  /// Virtual time advanced by a dispatch for a network of weight 1.
+  static constexpr uint64_t kSchedulingStride = 1 << 20;
+
+  /// Per-network queues, keyed by network name. Requests are dispatched by
+  /// lowest priority first. Among networks whose next requests have the same
+  /// priority, the one with the lowest pass goes first (stride scheduling),
+  /// so each network gets dispatches in proportion to its weight.
+  std::unordered_map<std::string, NetworkQueue> inferQueues_;
+
+  /// Total number of requests in inferQueues_.
+  size_t numQueuedRequests_{0};
 
-  /// Lock for the priority queue above. Please make sure whenever you want to
-  /// access inferQueue_, you take a lock. Usage is the same as
+  /// Pass of the network that was dispatched last. A network that becomes
+  /// backlogged starts here so it can't bank credit while idle.
+  uint64_t schedulingVirtualTime_{0};
+
+  /// Lock for the queues above. Please make sure whenever you want to
+  /// access inferQueues_, you take a lock. Usage is the same as
   /// std::shared_mutex
   std::shared_timed_mutex inferQueueLock_;
 
@@ -124,6 +248,28 @@ class HostManager final {
   /// removeNetwork can all be called concurrently, a guard is needed.
   std::shared_timed_mutex networkLock_;
 
+  /// Maps the name of a network swapped out by replaceNetwork() to the name
+  /// of the version in networks_ now serving its requests. Protected by
+  /// networkLock_.
+  std::unordered_map<std::string, std::string> networkRoutes_;
+
+  /// Names of the networks a replaceNetwork() call is working on. Protected by
+  /// networkLock_.
+  std::set<std::string> replacingNetworks_;
+
+  /// Count of versions created by replaceNetwork(), used to name them.
+  std::atomic<size_t> networkVersionCount_{0};
+
+  /// Shape buckets of the networks added by addShapeBucketedNetwork(), by
+  /// the name requests use for them. Protected by networkLock_.
+  std::unordered_map<std::string, std::shared_ptr<const ShapeBuckets>>
+      shapeBuckets_;
+
+  /// Loops of the networks added by addSequenceLoopNetwork(), by the name
+  /// requests use for them. Protected by networkLock_.
+  std::unordered_map<std::string, std::shared_ptr<const SequenceLoop>>
+      sequenceLoops_;
+
   /// A map of DeviceManagers by deviceID. An ordered map is used here to allow
   /// a stable iteration order over devices.
   DeviceManagerMapTy devices_;
@@ -131,6 +277,19 @@ class HostManager final {
   /// A vector of devices available for new networks to be added to.
   std::vector<DeviceIDTy> availableDevices_;
 
+  /// The devices marked unhealthy, with whether they were in
+  /// availableDevices_ before. Protected by healthLock_.
+  std::map<DeviceIDTy, bool> unhealthyDevices_;
+
+  /// Serializes the changes of health of the devices.
+  std::mutex healthLock_;
+
+  /// Adds the partition \p node of the network of \p module to the healthy
+  /// device of its backend with the most available memory that doesn't run it
+  /// yet, see markDeviceUnhealthy(). Must be called holding healthLock_ and a
+  /// lock on networkLock_.
+  Error addToHealthyDevice(DAGNode &node, const Module &module);
+
   /// A single threaded threadpool used by init() when initializing devices.
   ThreadPool threadPool_{1};
 
@@ -157,6 +316,53 @@ class HostManager final {
   static constexpr const char *kDeviceMemoryMax =
       "glow.devices.maximum_memory.total";
 
+  /// Prefixes of the keys the memory of each device is exported under,
+  /// followed by the device ID.
+  static constexpr const char *kDeviceUsedMemory = "glow.device.used_memory";
+  static constexpr const char *kDeviceAvailableMemory =
+      "glow.device.available_memory";
+
+  /// Prefixes of the keys the memory of each network is exported under,
+  /// followed by the network name, see NetworkMemoryUsage.
+  static constexpr const char *kNetworkConstantMemory =
+      "glow.network.constant_memory";
+  static constexpr const char *kNetworkMutableMemory =
+      "glow.network.mutable_memory";
+  static constexpr const char *kNetworkActivationMemory =
+      "glow.network.activation_memory";
+  static constexpr const char *kNetworkHostMemory = "glow.network.host_memory";
+  static constexpr const char *kNetworkCompileTransientMemory =
+      "glow.network.compile_transient_memory";
+
+  /// String const for the number of requests shed because their deadline
+  /// could not be met.
+  static constexpr const char *kRequestsShed = "glow.requests_shed";
+
+  /// String const for the number of requests dropped from the queue because
+  /// they were cancelled.
+  static constexpr const char *kRequestsCancelled = "glow.requests_cancelled";
+
+  /// Prefixes of the keys of the number of requests served from and missing
+  /// the result cache, and of its size in bytes, followed by the network
+  /// name, see setResultCache().
+  static constexpr const char *kResultCacheHits = "glow.result_cache.hits";
+  static constexpr const char *kResultCacheMisses = "glow.result_cache.misses";
+  static constexpr const char *kResultCacheBytes = "glow.result_cache.bytes";
+
+  /// Prefixes of the keys latency histograms are exported under, followed by
+  /// the network name, or for kDeviceLatency the partition name.
+  static constexpr const char *kQueueWaitLatency = "glow.latency.queue_wait";
+  static constexpr const char *kExecutionLatency = "glow.latency.execution";
+  static constexpr const char *kCallbackLatency = "glow.latency.callback";
+  static constexpr const char *kDeviceLatency = "glow.latency.device";
+
+  /// Number of completed requests between automatic exports of the latency
+  /// histograms.
+  static constexpr uint64_t kHistogramExportInterval = 1024;
+
+  /// Count of completed requests, used to periodically export histograms.
+  std::atomic<uint64_t> numCompletedRequests_{0};
+
   /// String const for logging device fatal errors.
   static constexpr const char *kDeviceFatalError =
       "glow.devices.fatal_compilation_error";
@@ -165,15 +371,84 @@ class HostManager final {
   /// This must be called while holding the a lock on networkLock_.
   void cleanupAddNetwork(llvm::ArrayRef<std::string> names);
 
+  /// \returns the name in networks_ of the version of \p networkName that
+  /// new requests should run on. This must be called while holding a lock on
+  /// networkLock_.
+  std::string getRoutedName(const std::string &networkName) const;
+
+  /// Removes the network named \p name in networks_, see removeNetwork().
+  /// \p name is not routed to a newer version.
+  Error removeNetworkImpl(std::string name);
+
+  /// \returns a RequestBatcher for \p network, named \p name in networks_,
+  /// using \p config.
+  std::unique_ptr<RequestBatcher>
+  createBatcher(const NetworkData &network, const std::string &name,
+                const RequestBatchingConfig &config);
+
   /// Set of networks in the process of being added.
   std::set<std::string> processingNetworks_;
 
   /// Method to dispatch a new run to the executor.
   void dispatchNextRun();
 
-  /// Method to calculate and export aggregate memory usage counters.
+  /// Implementation of runNetwork. If \p allowBatching is false the request
+  /// is queued as is, even if request batching is enabled for the network.
+  RunIdentifierTy runNetworkImpl(llvm::StringRef networkName,
+                                 std::unique_ptr<ExecutionContext> context,
+                                 ResultCBTy callback, uint64_t priority,
+                                 uint64_t deadline, bool allowBatching);
+
+  /// Pop the next request to dispatch according to the fair-share policy and
+  /// count it as active for its network. Must be called with inferQueueLock_
+  /// held. \returns None if no network has a request that may be dispatched.
+  llvm::Optional<InferRequest> popNextRequest();
+
+  /// Mark a dispatched request of \p networkName as completed.
+  void releaseNetworkSlot(llvm::StringRef networkName);
+
+  /// \returns true if a run of \p network started now can't finish before
+  /// \p deadline, based on the network's recent latency.
+  static bool missesDeadline(const NetworkData &network, uint64_t deadline);
+
+  /// Fold the run time \p duration of a completed run into the latency
+  /// estimate of \p network.
+  static void updateLatencyEstimate(NetworkData &network, uint64_t duration);
+
+  /// Fail the request for \p networkName with \p runID because its
+  /// \p deadline can't be met, passing \p context back to \p callback.
+  void shedRequest(llvm::StringRef networkName, RunIdentifierTy runID,
+                   uint64_t deadline, std::unique_ptr<ExecutionContext> context,
+                   ResultCBTy callback);
+
+  /// Fail the request for \p networkName with \p runID because it was
+  /// cancelled while queued, passing \p context back to \p callback.
+  void dropCancelledRequest(llvm::StringRef networkName, RunIdentifierTy runID,
+                            std::unique_ptr<ExecutionContext> context,
+                            ResultCBTy callback);
+
+  /// State of a request of a network added by addSequenceLoopNetwork(), kept
+  /// across the runs of its steps.
+  struct SequenceLoopRun;
+
+  /// Run the current step of \p run on \p stepCtx, then the following ones
+  /// until the last step, or the first that fails, calls the request's
+  /// callback.
+  void runSequenceLoopStep(std::shared_ptr<SequenceLoopRun> run,
+                           std::unique_ptr<ExecutionContext> stepCtx);
+
+  /// Method to calculate and export aggregate memory usage counters, and the
+  /// counters of each device and network. This must be called while holding
+  /// a lock on networkLock_ or before the HostManager is shared.
   void exportMemoryCounters();
 
+  /// \returns the memory usage of \p network. This must be called while
+  /// holding a lock on networkLock_.
+  NetworkMemoryUsage computeNetworkMemoryUsage(const NetworkData &network);
+
+  /// Zero the memory counters exported for the network \p name.
+  void clearNetworkMemoryCounters(llvm::StringRef name);
+
   /// Queue size stat update
   void reportCurrentQueueSize(int32_t queueSize);
 
@@ -208,6 +483,15 @@ public:
   /// optimized based on \p cctx.
   Error addNetwork(std::unique_ptr<Module> module, CompilationContext &cctx);
 
+  /// Adds the network snapshotted in directory \p dir by addNetwork with
+  /// CompilationContext::networkSnapshotDir set. The optimized and partitioned
+  /// DAG of the snapshot is loaded and provisioned without being optimized
+  /// again, and its partitions are deserialized instead of compiled when the
+  /// snapshot holds the compiled functions of all of them. Other options are
+  /// taken from \p cctx. \returns an Error containing the results of the
+  /// operation.
+  Error addNetworkFromSnapshot(llvm::StringRef dir, CompilationContext &cctx);
+
 /// Adds the already partitioned FX \p FXIR network to the host and does the
 /// necessary setup work. This includes provisioning, compiling and
 /// initializing backends. Requires a  DAG \p networks to be provided.
@@ -226,6 +510,81 @@ public:
   /// \returns an Error indicating success or failure of the operation.
   Error removeNetwork(llvm::StringRef networkName);
 
+  /// Replaces the network \p networkName with the single Function in
+  /// \p module without making it unavailable. The new version is compiled
+  /// with \p cctx and provisioned next to the old one, which keeps serving
+  /// requests meanwhile, so devices need memory for both. Once the new version
+  /// is ready, new requests for \p networkName are routed to it and the old
+  /// version is removed when its outstanding requests are done; this call
+  /// returns after that. Request batching, result caching and scheduling
+  /// options carry over, the cached results don't.
+  /// Requests for the new version must bind the Placeholders of \p module,
+  /// which can be looked up by name in getNetworkDAG()'s module. \returns an
+  /// Error if \p networkName doesn't exist, is already being replaced, or the
+  /// new version can't be added, in which case the old one stays in place.
+  Error replaceNetwork(llvm::StringRef networkName,
+                       std::unique_ptr<Module> module,
+                       CompilationContext &cctx);
+
+  /// Builds the Module of a network for \p batchSize rows, see
+  /// addShapeBucketedNetwork().
+  using BucketModuleBuilderTy =
+      std::function<Expected<std::unique_ptr<Module>>(dim_t batchSize)>;
+
+  /// Adds the network \p networkName compiled for every batch size in
+  /// \p batchSizes. The Module of each batch size is built by \p buildModule
+  /// and must have a single Function, whose Placeholders all have the batch
+  /// dimension as dimension 0 and are named the same for all batch sizes.
+  /// Each batch size is added as a network of its own with \p cctx. Requests
+  /// for \p networkName bind tensors to Placeholders of these names with any
+  /// number of rows up to the largest batch size; they run on the smallest
+  /// batch size that fits them, padded with zeros, see ShapeBuckets.
+  /// removeNetwork() removes all the batch sizes, and getNetworkDAG() \returns
+  /// the DAG of the largest one. \returns an Error if \p networkName is taken
+  /// or a batch size fails to be added, in which case none are added.
+  Error addShapeBucketedNetwork(llvm::StringRef networkName,
+                                llvm::ArrayRef<dim_t> batchSizes,
+                                const BucketModuleBuilderTy &buildModule,
+                                CompilationContext &cctx);
+
+  /// Adds the network \p networkName running the recurrent cell of \p module
+  /// over sequences of any length, see SequenceLoop. \p module must have a
+  /// single Function computing one step, which is compiled with \p cctx and
+  /// added as a network of its own. A request for \p networkName runs it once
+  /// per step of its sequence, one step after the other, as described by
+  /// \p config; its callback is called after the last step, or the first one
+  /// that fails. removeNetwork() removes the cell, and getNetworkDAG()
+  /// \returns its DAG. \returns an Error if \p networkName is taken or the
+  /// cell can't be added.
+  Error addSequenceLoopNetwork(llvm::StringRef networkName,
+                               std::unique_ptr<Module> module,
+                               const SequenceLoopConfig &config,
+                               CompilationContext &cctx);
+
+  /// Enables request batching for \p networkName using \p config, or
+  /// disables it if \p config is None. While enabled, requests that fit the
+  /// network's batch dimension are combined into a single run, see
+  /// RequestBatcher. \returns an Error if the network doesn't exist or still
+  /// has outstanding runs.
+  Error setRequestBatching(llvm::StringRef networkName,
+                           llvm::Optional<RequestBatchingConfig> config);
+
+  /// Enables caching the results of \p networkName using \p config, or
+  /// disables it if \p config is None. While enabled, a request whose inputs
+  /// are the same as those of a recent successful run gets a copy of its
+  /// outputs without being queued, see ResultCache. Only networks whose
+  /// outputs depend on their inputs alone should be cached. Cached results are
+  /// dropped whenever this is called. \returns an Error if the network
+  /// doesn't exist.
+  Error setResultCache(llvm::StringRef networkName,
+                       llvm::Optional<ResultCacheConfig> config);
+
+  /// Sets the fair-share scheduling options of \p networkName to \p config.
+  /// Takes effect for requests dispatched from then on. \returns an Error if
+  /// the network doesn't exist or \p config is invalid.
+  Error setNetworkScheduling(llvm::StringRef networkName,
+                             const NetworkSchedulingConfig &config);
+
   /// Update the list of available devices.
   void setAvailableDevices(const std::vector<DeviceIDTy> &devices);
 
@@ -256,9 +615,20 @@ public:
   /// The parameter \p priority is used to indicate queueing priority, priority
   /// is lowest number first and in case of a tie the request that was submitted
   /// first will go first.
-  RunIdentifierTy runNetwork(llvm::StringRef networkName,
-                             std::unique_ptr<ExecutionContext> context,
-                             ResultCBTy callback, uint64_t priority = 0);
+  /// If \p deadline is non-zero it is the TraceEvent::now() timestamp by which
+  /// the request must complete. Requests of the same priority are dispatched
+  /// earliest deadline first, and a request that can no longer meet its
+  /// deadline given the network's recent latency is refused instead of run.
+  /// If \p cancellationToken is given it is set on \p context, see
+  /// ExecutionContext::setCancellationToken(). Once it is cancelled the
+  /// request is dropped if still queued, and else the partitions of the
+  /// network not yet started are skipped; either way \p callback gets a
+  /// RUNTIME_REQUEST_CANCELLED Error.
+  RunIdentifierTy
+  runNetwork(llvm::StringRef networkName,
+             std::unique_ptr<ExecutionContext> context, ResultCBTy callback,
+             uint64_t priority = 0, uint64_t deadline = 0,
+             std::shared_ptr<CancellationToken> cancellationToken = nullptr);
 
   /// A wrapper around runNetwork that provides a blocking interface for an
   /// inference request. Runs the network provided in \p networkName using \p
@@ -275,6 +645,22 @@ public:
   Error runNetworkBlocking(llvm::StringRef networkName,
                            PlaceholderBindings &bindings);
 
+#ifdef GLOW_HAS_COROUTINES
+  /// \returns an awaitable running the network \p networkName with
+  /// \p context, like runNetwork with \p priority and \p deadline. Awaiting
+  /// it suspends the coroutine until the run is done and \returns its Error;
+  /// \p context, which must outlive the co_await, is then filled with the
+  /// context of the run as in runNetworkBlocking. The coroutine is resumed
+  /// with \p executor->post() if given, and else on the thread completing the
+  /// run, so that there is no thread hop and no allocation per request.
+  template <typename Executor = ResumeInline>
+  RunNetworkAwaitable<Executor>
+  runNetworkAsync(llvm::StringRef networkName,
+                  std::unique_ptr<ExecutionContext> &context,
+                  Executor *executor = nullptr, uint64_t priority = 0,
+                  uint64_t deadline = 0);
+#endif
+
   /// Initialize the HostManager with the given \p configs creating one
   /// DeviceManager for each config listed.
   Error init(std::vector<std::unique_ptr<DeviceConfig>> configs);
@@ -282,6 +668,25 @@ public:
   /// Get the network DAG for \p network if it exists.
   Expected<DAG *> getNetworkDAG(llvm::StringRef network);
 
+  /// \returns a pool of ExecutionContexts for the runs of \p network, with the
+  /// Tensors of \p count contexts allocated upfront, see ExecutionContextPool.
+  /// The contexts bind all the non-static Placeholders of the Module of
+  /// \p network; for a shape bucketed network these are the Placeholders of
+  /// the largest batch size. The Tensors are IO buffers of the device running
+  /// the first partition of \p network, which reads the inputs, so that it
+  /// can transfer them without staging copies; the pool must be destroyed
+  /// before the HostManager. \returns an Error if \p network doesn't exist.
+  Expected<std::unique_ptr<ExecutionContextPool>>
+  createExecutionContextPool(llvm::StringRef network, size_t count);
+
+  /// \returns the memory held for \p network, or an Error if it doesn't
+  /// exist. Tensors the caller keeps in its own PlaceholderBindings, e.g.
+  /// from createExecutionContextPool(), are not included.
+  Expected<NetworkMemoryUsage> getNetworkMemoryUsage(llvm::StringRef network);
+
+  /// \returns the memory usage of every device, keyed by device ID.
+  std::map<DeviceIDTy, DeviceMemoryUsage> getDeviceMemoryUsage();
+
   /// \returns a non-owning pointer to the TraceContext.
   TraceContext *getTraceContext() { return hostTraceContext_.get(); }
 
@@ -292,6 +697,11 @@ public:
     return traceContext;
   }
 
+  /// Export the latency histograms of every network and partition through
+  /// the StatsExporterRegistry. This is also done automatically every
+  /// kHistogramExportInterval completed requests.
+  void exportLatencyHistograms();
+
   /// Triggers start tracing of all active devices \returns Error if fails.
   Error startDeviceTrace();
 
@@ -309,6 +719,25 @@ public:
   /// \returns the number of devices the HostManager owns.
   size_t numDevices() const { return devices_.size(); }
 
+  /// \returns the DeviceInfo of the device \p deviceID, or an Error if the
+  /// HostManager owns no such device.
+  Expected<DeviceInfo> getDeviceInfo(DeviceIDTy deviceID) const;
+
+  /// Marks the device \p deviceID unhealthy, which the HostManager does when
+  /// a DeviceHealthMonitor reports it. New networks are not added to it, and
+  /// the partitions on it run on their other devices. A partition without any
+  /// other device is added to the healthy device of its backend with the most
+  /// available memory, from the function the Provisioner compiled for it,
+  /// without compiling it again. \returns an Error if there is no such device
+  /// or some partitions could not be moved; their runs fail until the device
+  /// is healthy again.
+  Error markDeviceUnhealthy(DeviceIDTy deviceID);
+
+  /// Marks the device \p deviceID healthy again after markDeviceUnhealthy().
+  /// The partitions that were moved off it stay on both devices. \returns an
+  /// Error if there is no such device.
+  Error markDeviceHealthy(DeviceIDTy deviceID);
+
   ~HostManager();
 
   /// String const for logging current queue size in glow
@@ -316,6 +745,73 @@ public:
       "glow.queue.current.occupancy.10k";
 };
 
+#ifdef GLOW_HAS_COROUTINES
+/// Awaitable of HostManager::runNetworkAsync. The run is started when the
+/// coroutine suspends, and whichever of the suspension and the completion
+/// callback comes last resumes the coroutine, so a run completing before the
+/// suspension finishes doesn't suspend at all.
+template <typename Executor> class RunNetworkAwaitable final {
+public:
+  RunNetworkAwaitable(HostManager &hostManager, llvm::StringRef networkName,
+                      std::unique_ptr<ExecutionContext> &context,
+                      Executor *executor, uint64_t priority, uint64_t deadline)
+      : hostManager_(hostManager), networkName_(networkName.str()),
+        context_(context), executor_(executor), priority_(priority),
+        deadline_(deadline) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    hostManager_.runNetwork(
+        networkName_, std::move(context_),
+        [this](RunIdentifierTy, Error err,
+               std::unique_ptr<ExecutionContext> resultContext) {
+          err_ = std::move(err);
+          context_ = std::move(resultContext);
+          if (done_.exchange(true, std::memory_order_acq_rel)) {
+            resume();
+          }
+        },
+        priority_, deadline_);
+    // The awaitable may be destroyed as soon as the run completes, so it
+    // isn't accessed after this.
+    return !done_.exchange(true, std::memory_order_acq_rel);
+  }
+
+  Error await_resume() { return std::move(err_); }
+
+private:
+  void resume() {
+    std::coroutine_handle<> handle = handle_;
+    if (executor_) {
+      executor_->post([handle]() { handle.resume(); });
+    } else {
+      handle.resume();
+    }
+  }
+
+  HostManager &hostManager_;
+  std::string networkName_;
+  std::unique_ptr<ExecutionContext> &context_;
+  Executor *executor_;
+  uint64_t priority_;
+  uint64_t deadline_;
+  std::coroutine_handle<> handle_;
+  Error err_ = Error::empty();
+  /// Set by the first of the suspension and the completion of the run.
+  std::atomic<bool> done_{false};
+};
+
+template <typename Executor>
+RunNetworkAwaitable<Executor> HostManager::runNetworkAsync(
+    llvm::StringRef networkName, std::unique_ptr<ExecutionContext> &context,
+    Executor *executor, uint64_t priority, uint64_t deadline) {
+  return RunNetworkAwaitable<Executor>(*this, networkName, context, executor,
+                                       priority, deadline);
+}
+#endif
+
 /// If the device config file specified in loadDeviceConfigsFileOpt is
 /// available, load \p configs from the file. Otherwise, create \p numDevices
 /// number of devices based on \p backendName.
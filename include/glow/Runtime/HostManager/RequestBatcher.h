@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_HOSTMANAGER_REQUESTBATCHER_H
+#define GLOW_RUNTIME_HOSTMANAGER_REQUESTBATCHER_H
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Runtime/RuntimeTypes.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace glow {
+namespace runtime {
+
+/// Coalesces requests for a single network into one larger run. The network
+/// must have been compiled with its batch dimension as dimension 0 of every
+/// input and output Placeholder. A request is batchable when every tensor in
+/// its PlaceholderBindings matches its Placeholder's type except for
+/// dimension 0, which must be the same for all of the request's tensors and
+/// no larger than the Placeholder's. Pending requests are concatenated along
+/// dimension 0 into a new ExecutionContext, padded with zeros, and submitted
+/// once they fill the batch or the oldest one has waited maxWaitUs. On
+/// completion the outputs are sliced back into each request's own tensors and
+/// every request's callback is called.
+class RequestBatcher final {
+public:
+  /// Function used to submit a combined batch for execution.
+  using SubmitFnTy =
+      std::function<void(std::unique_ptr<ExecutionContext>, ResultCBTy,
+                         uint64_t priority, uint64_t deadline)>;
+
+  /// Constructor. \p dag is the network requests are batched for, \p config
+  /// the batching limits and \p submit is called with each combined batch.
+  RequestBatcher(const DAG &dag, const RequestBatchingConfig &config,
+                 SubmitFnTy submit);
+
+  /// Destructor. Submits any pending requests and stops the timer thread.
+  ~RequestBatcher();
+
+  /// \returns the number of rows (dimension 0) \p context contributes to a
+  /// batch, or 0 if \p context cannot be batched.
+  dim_t getBatchRows(const ExecutionContext &context) const;
+
+  /// Queue \p context to be run in a batch. The request must be batchable,
+  /// see getBatchRows(). \p callback is called with \p runId once the batch
+  /// containing the request is done. A batch is submitted with the lowest
+  /// \p priority and earliest non-zero \p deadline of its requests.
+  void enqueue(std::unique_ptr<ExecutionContext> context, ResultCBTy callback,
+               RunIdentifierTy runId, uint64_t priority, uint64_t deadline);
+
+  /// Submit all pending requests right away.
+  void flush();
+
+  /// \returns the configuration used by this batcher.
+  const RequestBatchingConfig &getConfig() const { return config_; }
+
+  /// String const for exporting the number of requests per submitted batch.
+  static constexpr const char *kBatchedRequests =
+      "glow.host_manager.batched_requests";
+
+private:
+  /// A request waiting to be batched.
+  struct PendingRequest {
+    std::unique_ptr<ExecutionContext> context;
+    ResultCBTy callback;
+    RunIdentifierTy runId;
+    uint64_t priority;
+    uint64_t deadline;
+    dim_t rows;
+  };
+
+  /// Combine \p batch into a single ExecutionContext and submit it.
+  void submitBatch(std::vector<PendingRequest> batch);
+
+  /// Copy the results in \p batchCtx back into the requests in \p batch and
+  /// call their callbacks with \p err.
+  void scatterResults(std::vector<PendingRequest> &batch, Error err,
+                      std::unique_ptr<ExecutionContext> batchCtx);
+
+  /// Main loop of the timer thread that submits batches that waited too long.
+  void timerMain();
+
+  /// \returns true if \p context binds exactly the same Placeholders as the
+  /// requests currently pending. Must be called with mtx_ held.
+  bool matchesPending(const ExecutionContext &context) const;
+
+  /// Batching limits.
+  RequestBatchingConfig config_;
+
+  /// Function used to submit combined batches.
+  SubmitFnTy submit_;
+
+  /// Names of the Placeholders the network writes to.
+  std::unordered_set<std::string> outputNames_;
+
+  /// Requests waiting to be submitted, all binding the same Placeholders.
+  std::vector<PendingRequest> pending_;
+
+  /// Total rows in pending_.
+  dim_t pendingRows_{0};
+
+  /// Maximum rows for the batch in pending_.
+  dim_t pendingCapacity_{0};
+
+  /// Time the oldest request in pending_ was queued.
+  std::chrono::steady_clock::time_point oldestPending_;
+
+  /// Whether the timer thread should exit.
+  bool stopping_{false};
+
+  /// Protects all pending state and stopping_.
+  std::mutex mtx_;
+
+  /// Wakes up the timer thread when a batch starts or the batcher stops.
+  std::condition_variable cv_;
+
+  /// Thread submitting batches whose oldest request timed out.
+  std::thread timer_;
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_HOSTMANAGER_REQUESTBATCHER_H
@@ -0,0 +1,117 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_HOSTMANAGER_RESULTCACHE_H
+#define GLOW_RUNTIME_HOSTMANAGER_RESULTCACHE_H
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Runtime/RuntimeTypes.h"
+
+#include "llvm/ADT/Optional.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace glow {
+namespace runtime {
+
+/// Memoizes the results of the runs of a single network, so that a request
+/// with the same inputs as a recent one gets a copy of its outputs instead of
+/// being run. Requests are keyed by a hash of the contents of their input
+/// tensors, and a cached result is only used if its inputs are equal to the
+/// request's. Results expire ttlUs after their run completes, and the least
+/// recently used ones are evicted to keep the inputs and outputs held under
+/// maxBytes. All methods are thread safe.
+class ResultCache final {
+public:
+  /// Constructor. \p dag is the network results are cached for and \p config
+  /// the limits of the cache.
+  ResultCache(const DAG &dag, const ResultCacheConfig &config);
+
+  /// \returns the key of the inputs of \p context, or None if its results
+  /// can't be cached, e.g. because some of its tensors are on a device or
+  /// partial.
+  llvm::Optional<uint64_t> getKey(const ExecutionContext &context) const;
+
+  /// Copy the cached outputs of the run of the inputs of \p context, whose
+  /// key is \p key, into the outputs of \p context. \returns false if there
+  /// is no such result, or if it expired or doesn't match the outputs of
+  /// \p context, in which case \p context is left as is.
+  bool lookup(uint64_t key, ExecutionContext &context);
+
+  /// Cache the outputs of the successful run of \p context, whose key is
+  /// \p key.
+  void insert(uint64_t key, const ExecutionContext &context);
+
+  /// \returns the number of bytes of the tensors of the cached results.
+  uint64_t getSizeInBytes() const;
+
+  /// \returns the configuration used by this cache.
+  const ResultCacheConfig &getConfig() const { return config_; }
+
+private:
+  /// The tensors bound to Placeholders.
+  using TensorsTy = std::vector<std::pair<Placeholder *, Tensor>>;
+
+  /// A cached result.
+  struct Entry {
+    uint64_t key;
+    /// TraceEvent::now() timestamp after which the result is stale.
+    uint64_t expiry;
+    TensorsTy inputs;
+    TensorsTy outputs;
+    uint64_t bytes;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  /// \returns true if the Placeholder \p PH is read by the network.
+  bool isInput(const Placeholder *PH) const;
+
+  /// \returns true if the inputs of \p context are those of \p entry and its
+  /// outputs can receive those of \p entry. Must be called with mtx_ held.
+  bool matches(const Entry &entry, const ExecutionContext &context) const;
+
+  /// Remove \p it from the cache. Must be called with mtx_ held.
+  void erase(EntryList::iterator it);
+
+  /// Cache limits.
+  ResultCacheConfig config_;
+
+  /// Names of the Placeholders the network writes to, and of those it also
+  /// reads.
+  std::unordered_set<std::string> outputNames_;
+  std::unordered_set<std::string> inOutNames_;
+
+  /// Cached results, most recently used first, and their index by key.
+  EntryList entries_;
+  std::unordered_map<uint64_t, EntryList::iterator> index_;
+
+  /// Total bytes of the entries.
+  uint64_t bytes_{0};
+
+  /// Protects the entries.
+  mutable std::mutex mtx_;
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_HOSTMANAGER_RESULTCACHE_H
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_HOSTMANAGER_SEQUENCELOOP_H
+#define GLOW_RUNTIME_HOSTMANAGER_SEQUENCELOOP_H
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Runtime/RuntimeTypes.h"
+#include "glow/Support/Error.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace glow {
+
+class Module;
+class Placeholder;
+
+namespace runtime {
+
+/// Describes how the requests of a network added by
+/// HostManager::addSequenceLoopNetwork() iterate its cell over a sequence.
+struct SequenceLoopConfig {
+  /// Placeholders of the cell reading one step of the sequence. A request
+  /// binds to each of them a tensor of as many rows (dimension 0) as it has
+  /// steps, each row having the type of the Placeholder.
+  std::vector<std::string> stepInputs;
+  /// Placeholders the cell writes one step of its results to, bound by
+  /// requests like stepInputs.
+  std::vector<std::string> stepOutputs;
+  /// Pairs of {input, output} Placeholders of the recurrent state, of the
+  /// same type. Each step reads in the input what the previous one wrote in
+  /// the output. A request binds the initial state to the input and gets the
+  /// final state in the output.
+  std::vector<std::pair<std::string, std::string>> states;
+  /// Longest sequence a request may have, or 0 for any length.
+  dim_t maxSteps{0};
+};
+
+/// Runs the requests of a network made of a recurrent cell, compiled once for
+/// a single step, for the actual length of their sequences instead of
+/// unrolling the recurrence over the longest one. The Placeholders of the
+/// cell not listed in the SequenceLoopConfig are bound by requests with the
+/// type of the Placeholder and are the same for all the steps. Steps run one
+/// after the other on the same context, whose step inputs and outputs are
+/// views of the rows of the tensors of the request, so no rows are copied.
+class SequenceLoop final {
+public:
+  /// \returns the loop of \p config over the cell network \p networkName,
+  /// compiled into \p dag, whose Placeholders are in \p module, or an Error
+  /// if \p config doesn't match them.
+  static Expected<std::unique_ptr<SequenceLoop>>
+  create(const SequenceLoopConfig &config, const std::string &networkName,
+         const DAG &dag, const Module &module);
+
+  /// \returns the name of the cell network.
+  const std::string &getNetworkName() const { return networkName_; }
+
+  /// \returns the number of steps of \p context, or an Error if its tensors
+  /// don't match the Placeholders of the cell.
+  Expected<dim_t> getNumSteps(const ExecutionContext &context) const;
+
+  /// \returns the context running the steps of \p context, holding the
+  /// recurrent state initialized from \p context.
+  std::unique_ptr<ExecutionContext>
+  createStepContext(const ExecutionContext &context) const;
+
+  /// Binds the step inputs and outputs of \p stepCtx to step \p step of
+  /// \p context.
+  void bindStep(const ExecutionContext &context, ExecutionContext &stepCtx,
+                dim_t step) const;
+
+  /// Makes the state written by the last step of \p stepCtx the input of the
+  /// next one.
+  void nextStep(ExecutionContext &stepCtx) const;
+
+  /// Copies the final state of \p stepCtx, or the initial state of \p context
+  /// if \p stepCtx is null because there were no steps, into the state
+  /// outputs of \p context.
+  void finish(const ExecutionContext *stepCtx, ExecutionContext &context) const;
+
+  /// String const for exporting the number of steps per request.
+  static constexpr const char *kSteps =
+      "glow.host_manager.sequence_loop_steps";
+
+private:
+  SequenceLoop(const SequenceLoopConfig &config, std::string networkName)
+      : config_(config), networkName_(std::move(networkName)) {}
+
+  SequenceLoopConfig config_;
+  std::string networkName_;
+  /// Placeholders of the cell in the order of config_.stepInputs and
+  /// config_.stepOutputs.
+  std::vector<Placeholder *> stepPlaceholders_;
+  /// {input, output} Placeholders of the cell in the order of
+  /// config_.states.
+  std::vector<std::pair<Placeholder *, Placeholder *>> statePlaceholders_;
+  /// The other Placeholders of the cell bound by requests.
+  std::vector<Placeholder *> otherPlaceholders_;
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_HOSTMANAGER_SEQUENCELOOP_H
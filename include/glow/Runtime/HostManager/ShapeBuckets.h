@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_HOSTMANAGER_SHAPEBUCKETS_H
+#define GLOW_RUNTIME_HOSTMANAGER_SHAPEBUCKETS_H
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Runtime/RuntimeTypes.h"
+#include "glow/Support/Error.h"
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace glow {
+
+class Module;
+class Placeholder;
+
+namespace runtime {
+
+/// Routes the requests of a network compiled for several batch sizes, or shape
+/// buckets, to the smallest bucket they fit in. Every bucket is a network of
+/// its own whose Placeholders all have the batch dimension as dimension 0, and
+/// the Placeholders of all buckets have the same names. A request binds a
+/// tensor to a Placeholder of every one of these names, all with the same
+/// number of rows (dimension 0) and otherwise the type of the Placeholders.
+/// Its inputs are padded with zeros up to the batch size of the bucket it runs
+/// on, and the leading rows of the bucket's outputs are copied back into its
+/// tensors.
+class ShapeBuckets final {
+public:
+  /// A network compiled for a single batch size.
+  struct Bucket {
+    /// Number of rows of the Placeholders of the network.
+    dim_t batchSize;
+    /// Name of the network.
+    std::string networkName;
+    /// Placeholders of the network.
+    std::vector<Placeholder *> placeholders;
+    /// Names of the Placeholders the network reads from.
+    std::unordered_set<std::string> inputNames;
+    /// Names of the Placeholders the network writes to.
+    std::unordered_set<std::string> outputNames;
+  };
+
+  /// Add the network \p networkName, compiled into \p dag for \p batchSize
+  /// rows, whose Placeholders are in \p module. Buckets must be added by
+  /// increasing batch size. \returns an Error if the Placeholders of the
+  /// network don't match those of the buckets already added.
+  Error addBucket(dim_t batchSize, const std::string &networkName,
+                  const DAG &dag, const Module &module);
+
+  /// \returns the buckets, by increasing batch size.
+  const std::vector<Bucket> &getBuckets() const { return buckets_; }
+
+  /// \returns the bucket \p context runs on and sets \p rows to the number of
+  /// rows of its tensors, or an Error if \p context doesn't fit any bucket.
+  Expected<const Bucket *> getBucket(const ExecutionContext &context,
+                                     dim_t &rows) const;
+
+  /// \returns a context binding the Placeholders of \p bucket to the \p rows
+  /// rows of the tensors of \p context, padded with zeros.
+  std::unique_ptr<ExecutionContext> pad(const Bucket &bucket,
+                                        const ExecutionContext &context,
+                                        dim_t rows) const;
+
+  /// Copy the first \p rows rows of the outputs of \p bucket in \p bucketCtx
+  /// into the tensors of \p context.
+  void unpad(const Bucket &bucket, const ExecutionContext &bucketCtx,
+             ExecutionContext &context, dim_t rows) const;
+
+  /// String const for exporting the number of padded rows per request.
+  static constexpr const char *kPaddedRows =
+      "glow.host_manager.shape_bucket_padded_rows";
+
+private:
+  /// Buckets by increasing batch size.
+  std::vector<Bucket> buckets_;
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_HOSTMANAGER_SHAPEBUCKETS_H
@@ -16,6 +16,7 @@
 #ifndef GLOW_RUNTIME_INPUTSANITIZER_H
 #define GLOW_RUNTIME_INPUTSANITIZER_H
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -73,6 +74,37 @@ private:
   Placeholder *offsetsPH_{nullptr};
 };
 
+/*
+ * Deduplication of the indices of a weighted SparseLengthsSum before the
+ * run: the indices of each segment are sorted and the duplicates merged by
+ * adding their weights, so the kernel gathers each row of a segment once and
+ * in increasing order. Results may differ from the original inputs by
+ * floating point rounding.
+ */
+class InputDeduplicator {
+public:
+  InputDeduplicator(Placeholder *indicesPH, Placeholder *weightsPH,
+                    Placeholder *lengthsPH);
+
+  /// Binds the inputs to deduplicated copies owned by \p storage, which must
+  /// outlive the run, when at least DedupInputsMinPercent percent of the
+  /// indices are duplicates. The original inputs are not modified.
+  Error deduplicate(PlaceholderBindings &bindings,
+                    std::vector<Tensor> &storage);
+
+  std::string toString();
+
+private:
+  Placeholder *indicesPH_{nullptr};
+  Placeholder *weightsPH_{nullptr};
+  Placeholder *lengthsPH_{nullptr};
+  /// Number of runs left before measuring the duplicate rate again, set when
+  /// it was too low for the deduplication to pay off.
+  std::atomic<unsigned> skipRuns_{0};
+};
+
+using InputDeduplicatorPtr = std::shared_ptr<InputDeduplicator>;
+
 //
 // Public utility functions
 //
@@ -80,6 +112,12 @@ std::vector<InputSanitizerPtr> getInputSanitizers(const Function &function);
 Error sanitizeInputs(const std::vector<InputSanitizerPtr> &sanitizers,
                      const PlaceholderBindings &bindings);
 
+std::vector<InputDeduplicatorPtr>
+getInputDeduplicators(const Function &function);
+Error deduplicateInputs(const std::vector<InputDeduplicatorPtr> &deduplicators,
+                        PlaceholderBindings &bindings,
+                        std::vector<Tensor> &storage);
+
 } // namespace runtime
 } // namespace glow
 
@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_RUNTIME_PROVISIONER_COMPILEDFUNCTIONCACHE_H
+#define GLOW_RUNTIME_PROVISIONER_COMPILEDFUNCTIONCACHE_H
+
+#include "glow/Backend/BlockStreamBase.h"
+#include "glow/Backends/BackendOptions.h"
+#include "glow/Support/Error.h"
+
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <string>
+#include <vector>
+
+namespace glow {
+
+class Backend;
+class Function;
+
+namespace runtime {
+
+/// On-disk store of serialized compiled functions, used by the Provisioner to
+/// skip backend compilation when the same Function is provisioned again, e.g.
+/// after a process restart. Entries are keyed by getKey() and live in one
+/// file per key under the cache directory. Only backends whose
+/// CompiledFunction implements serialize() and deserialize() benefit.
+class CompiledFunctionCache final {
+public:
+  /// Version of the key and entry format. Bump it to invalidate all entries.
+  static constexpr unsigned kFormatVersion = 1;
+
+  /// Constructor, storing entries in directory \p dir.
+  explicit CompiledFunctionCache(llvm::StringRef dir) : dir_(dir.str()) {}
+
+  /// \returns a stable key for compiling \p F with \p backend and \p opts.
+  /// The key covers the structure of \p F, the payload of every Constant it
+  /// uses, Backend::getCompilationFingerprint() and \p opts. The name of \p F
+  /// and BackendOptions::useDeserialize are ignored. Must be called before
+  /// \p F is compiled, as compilation may modify it.
+  static std::string getKey(const Function &F, const Backend &backend,
+                            const BackendOptions &opts);
+
+  /// \returns the data stored under \p key, or None if there is none.
+  llvm::Optional<std::vector<char>> load(llvm::StringRef key) const;
+
+  /// Store the contents of \p stream under \p key, replacing any existing
+  /// entry. The entry is written to a temporary file and renamed into place
+  /// so concurrent readers never see a partial entry.
+  Error store(llvm::StringRef key, BlockStreamBase &stream) const;
+
+  /// \returns the directory entries are stored in.
+  llvm::StringRef getDirectory() const { return dir_; }
+
+private:
+  /// \returns the path of the entry for \p key.
+  std::string getPath(llvm::StringRef key) const;
+
+  /// Directory entries are stored in.
+  std::string dir_;
+};
+
+} // namespace runtime
+} // namespace glow
+
+#endif // GLOW_RUNTIME_PROVISIONER_COMPILEDFUNCTIONCACHE_H
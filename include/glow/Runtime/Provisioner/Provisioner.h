@@ -19,8 +19,10 @@
 #include "glow/Backend/Backend.h"
 #include "glow/Backend/BlockStreamBase.h"
 #include "glow/Backends/DeviceManager.h"
+#include "glow/Runtime/Provisioner/CompiledFunctionCache.h"
 #include "glow/Runtime/RuntimeTypes.h"
 #include "glow/Support/Error.h"
+#include "glow/Support/ThreadPool.h"
 
 #include <map>
 
@@ -128,6 +130,8 @@ public:
   ///             free up compilation resources
   ///             move corresponding compiled function from `compiledFunctions`
   ///             to `Provisioner::functions_`
+  ///             release the payloads of the Constants no other Function
+  ///             still to be added uses, unless cctx.skipModuleStrip
   Error provision(DAGListTy &networks, Module &module,
                   CompilationContext &cctx);
 
@@ -151,6 +155,14 @@ public:
   Error evictFunction(llvm::StringRef name, DeviceManager *device,
                       unsigned replicaCount);
 
+  /// Add the function \p name compiled by an earlier provision, and its
+  /// replications, to \p device without compiling it again, e.g. to move it
+  /// off a failed device. Its constants come from the compiled function if it
+  /// keeps them, and from \p module otherwise. \returns an Error if there is
+  /// no such function or the device can't add it.
+  Error addCompiledFunction(llvm::StringRef name, const Module &module,
+                            DeviceManager *device);
+
   /// \returns a reference to the backend with name \p backendName.
   Backend &getBackend(llvm::StringRef backendName) const;
 
@@ -175,16 +187,29 @@ public:
       std::unordered_map<std::string, std::unique_ptr<BlockStreamBase>>>
   getAllSerializedFunctionsMap();
 
+  /// \returns the serialization of the compiled function \p name, or null if
+  /// there is no such function or its backend does not serialize it.
+  std::unique_ptr<BlockStreamBase> serializeFunction(llvm::StringRef name);
+
   // Clean up all stored serializedFunctionMap_.
   void cleanUpSerializedFunctionMap();
 
+  /// String const for exporting the compile time of each partition in
+  /// microseconds.
+  static constexpr const char *kPartitionCompileTimeUs =
+      "glow.provisioner.partition_compile_time_us";
+
 private:
   /// Map of backends for all devices, one backend per device type.
   std::unordered_map<std::string, std::unique_ptr<Backend>> backends_;
 
-  /// Map of compiledFunction unique pointers. This maintains
-  /// ownership of the functions.
-  std::unordered_map<std::string, std::unique_ptr<CompiledFunction>> functions_;
+  /// Map of compiledFunction pointers. This maintains ownership of the
+  /// functions. Identical functions provisioned together share a pointer.
+  std::unordered_map<std::string, std::shared_ptr<CompiledFunction>> functions_;
+
+  /// Pool compiling partitions in parallel, shared by all backends and all
+  /// concurrent provision calls. Sized by flags::NumCompilationThreads.
+  std::unique_ptr<ThreadPool> compilePool_;
 
   /// Map of serialized function pointers, storing all serialized functions on
   /// backends.
@@ -192,6 +217,10 @@ private:
   std::unordered_map<std::string, std::unique_ptr<BlockStreamBase>>
       serializedFunctionMap_;
 
+  /// Persistent cache of serialized compiled functions, null unless
+  /// flags::CompiledFunctionCacheDir is set.
+  std::unique_ptr<CompiledFunctionCache> compiledFunctionCache_;
+
   /// Set of active functions - these are functions that are currently being
   /// compiled/added to devices.
   std::set<std::string> activeFunctions_;
@@ -21,7 +21,11 @@
 #include "glow/Backends/BackendOptions.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Support/Error.h"
+#include "glow/Support/LatencyHistogram.h"
 
+#include "llvm/ADT/STLExtras.h"
+
+#include <limits>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -85,6 +89,9 @@ struct DeviceRuntimeInfo {
 
   unsigned outstandingInferences{0};
   std::chrono::time_point<std::chrono::steady_clock> lastUsedTimestamp;
+  /// Whether the device is healthy, see HostManager::markDeviceUnhealthy().
+  /// Runs only go to an unavailable device if all the devices are.
+  bool available{true};
 };
 
 /// Individual Node in the DAG for a given network. This contains all the
@@ -138,6 +145,10 @@ struct DAGNode {
   /// Size of constants and placeholders used by the function.
   uint64_t size{0};
 
+  /// Time in microseconds from handing a run of this node to a DeviceManager
+  /// to the DeviceManager calling back with the result.
+  LatencyHistogram deviceLatency;
+
   /// Backend Hints object, this is populated by the Partitioner and is used
   /// to communicated hints to the compiler, like SRAM pinning and resource
   /// reservation.
@@ -155,19 +166,36 @@ struct DAGNode {
   /// devices with the same amount of work remaining, we pick the one that's
   /// least recently used as expect the work there will finish first.
   DeviceIDTy getNextDevice() {
+    return getNextDevice([](DeviceIDTy) { return uint64_t(0); });
+  }
+
+  /// Same as getNextDevice(), where the outstanding work on a device is the
+  /// larger of the runs of this node it has and \p deviceLoad of its ID, the
+  /// runs of all the networks queued on it, so that the replicas of a network
+  /// on devices busy with other networks are avoided. Unavailable devices are
+  /// the most loaded.
+  DeviceIDTy
+  getNextDevice(llvm::function_ref<uint64_t(DeviceIDTy)> deviceLoad) {
     const std::lock_guard<std::mutex> g(lock);
 
+    auto getLoad = [&](const decltype(deviceRuntimeInfos)::value_type &info) {
+      if (!info.second.available) {
+        return std::numeric_limits<uint64_t>::max();
+      }
+      return std::max<uint64_t>(info.second.outstandingInferences,
+                                deviceLoad(info.first));
+    };
     auto selected = deviceRuntimeInfos.begin();
+    uint64_t selectedLoad = getLoad(*selected);
     auto iter = deviceRuntimeInfos.begin();
 
     for (++iter; iter != deviceRuntimeInfos.end(); ++iter) {
-      if (selected->second.outstandingInferences >
-              iter->second.outstandingInferences ||
-          (selected->second.outstandingInferences ==
-               iter->second.outstandingInferences &&
-           selected->second.lastUsedTimestamp <
-               iter->second.lastUsedTimestamp)) {
+      uint64_t load = getLoad(*iter);
+      if (selectedLoad > load ||
+          (selectedLoad == load && selected->second.lastUsedTimestamp <
+                                       iter->second.lastUsedTimestamp)) {
         selected = iter;
+        selectedLoad = load;
       }
     }
 
@@ -269,6 +297,45 @@ struct HostConfig {
   size_t maxQueueSize{100};
   /// Number of threads to allocate to the Executor.
   size_t executorThreads{3};
+  /// Whether the Executor should use per-thread work-stealing queues, so that
+  /// DAG nodes made ready by a finished node are picked up by the same thread
+  /// and idle threads steal the rest.
+  bool executorWorkStealing{false};
+  /// Whether the Constants of the added networks share their payloads with the
+  /// identical payloads of the Constants of other networks, once the networks
+  /// are optimized, see Module::shareConstantPayloads().
+  bool shareConstantPayloads{false};
+};
+
+/// Options for coalescing requests to a single network into larger runs, see
+/// HostManager::setRequestBatching().
+struct RequestBatchingConfig {
+  /// Maximum number of rows (dimension 0) in a combined batch. Zero means
+  /// the batch size the network's Placeholders were compiled with.
+  dim_t maxBatchSize{0};
+  /// Maximum time in microseconds a request waits for others to join it.
+  uint64_t maxWaitUs{0};
+};
+
+/// Options for memoizing the results of a single network, see
+/// HostManager::setResultCache().
+struct ResultCacheConfig {
+  /// Time in microseconds a result stays cached after its run completes.
+  uint64_t ttlUs{1000000};
+  /// Maximum number of bytes of the inputs and outputs of the cached results.
+  /// The least recently used results are evicted to stay under it.
+  uint64_t maxBytes{64 << 20};
+};
+
+/// Fair-share scheduling options for a single network, see
+/// HostManager::setNetworkScheduling().
+struct NetworkSchedulingConfig {
+  /// Relative share of dispatches the network gets while several networks
+  /// with requests of the same priority are waiting. Must be positive.
+  unsigned weight{1};
+  /// Maximum number of the network's requests running at once. Zero means
+  /// only HostConfig::maxActiveRequests applies.
+  size_t maxActiveRequests{0};
 };
 
 /// This is struct for user defined partition.
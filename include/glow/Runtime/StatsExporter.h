@@ -16,6 +16,8 @@
 #ifndef GLOW_RUNTIME_STATSEXPORTER_H
 #define GLOW_RUNTIME_STATSEXPORTER_H
 
+#include "glow/Support/LatencyHistogram.h"
+
 #include "llvm/ADT/StringRef.h"
 
 #include <memory>
@@ -38,6 +40,12 @@ public:
 
   /// Set a counter.  May be called concurrently.
   virtual void setCounter(llvm::StringRef key, int64_t value) = 0;
+
+  /// Export the current state of \p histogram.  May be called concurrently.
+  /// The default implementation sets counters for the count and the p50, p99
+  /// and p999 values, suffixed to \p key.
+  virtual void addHistogram(llvm::StringRef key,
+                            const LatencyHistogram &histogram);
 };
 
 /// Registry of StatsExporters.
@@ -52,6 +60,9 @@ public:
   /// Set a counter for all registered StatsExporters.
   void setCounter(llvm::StringRef key, int64_t value);
 
+  /// Export a histogram to all registered StatsExporters.
+  void addHistogram(llvm::StringRef key, const LatencyHistogram &histogram);
+
   /// Register a StatsExporter.
   void registerStatsExporter(StatsExporter *exporter);
 
@@ -18,6 +18,8 @@
 
 #include "glow/ExecutionContext/TraceEvents.h"
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -46,6 +48,87 @@ public:
   virtual void exportTrace(TraceContext *context) = 0;
 };
 
+/// Policy of continuous sampled tracing. One request in sampleRate is traced
+/// at the STANDARD level and the others at the REQUEST level only, so that the
+/// requests slower than the p99 latency still have a coarse trace to export.
+/// Exports stop while the time spent exporting exceeds overheadBudget times
+/// the time spent running the requests.
+class TraceSampler {
+public:
+  TraceSampler(unsigned sampleRate, double overheadBudget);
+
+  /// \returns the level to trace the next request at.
+  TraceLevel getRequestTraceLevel();
+
+  /// Records the \p latency of a request traced at \p level. \returns whether
+  /// its trace should be exported, that is if the request was sampled or is
+  /// slower than the p99 of the recent requests, and within the budget.
+  bool shouldExport(TraceLevel level, uint64_t latency);
+
+  /// Records \p overhead microseconds spent exporting a trace.
+  void recordOverhead(uint64_t overhead);
+
+  /// \returns the p99 latency of the recent requests, 0 until enough requests
+  /// were recorded.
+  uint64_t getTailLatency();
+
+private:
+  /// One request in sampleRate_ is traced at the STANDARD level.
+  const unsigned sampleRate_;
+
+  /// Fraction of the run time that exporting traces may take.
+  const double overheadBudget_;
+
+  /// Number of requests given a trace level.
+  std::atomic<uint64_t> numRequests_{0};
+
+  /// Whether the exports are over the budget.
+  std::atomic<bool> overBudget_{false};
+
+  /// Lock around the members below.
+  std::mutex mutex_;
+
+  /// Latencies of the recent requests, a ring indexed by numLatencies_.
+  std::vector<uint64_t> latencies_;
+
+  /// Number of latencies recorded.
+  uint64_t numLatencies_{0};
+
+  /// The p99 of latencies_, computed periodically.
+  uint64_t tailLatency_{0};
+
+  /// The time spent running and exporting the recent requests, both halved
+  /// periodically so that old requests weigh less.
+  uint64_t runTime_{0};
+  uint64_t exportTime_{0};
+};
+
+/// TraceExporter streaming the exported traces to a file in the Chrome trace
+/// format. The file holds a JSON array that is never closed, which the trace
+/// viewers accept, so each trace is appended as it is exported instead of
+/// rewriting a whole file.
+class ChromeTraceStreamExporter final : public TraceExporter {
+public:
+  explicit ChromeTraceStreamExporter(llvm::StringRef filename);
+
+  ~ChromeTraceStreamExporter() override;
+
+  /// Exported traces are chosen by the TraceSampler.
+  bool shouldTrace() override { return false; }
+
+  void exportTrace(TraceContext *context) override;
+
+private:
+  /// The stream to the trace file, nullptr if it can't be opened.
+  std::unique_ptr<llvm::raw_fd_ostream> os_;
+
+  /// Thread names already written to the trace file.
+  std::map<int, std::string> threadNames_;
+
+  /// Lock around os_ and threadNames_.
+  std::mutex mutex_;
+};
+
 /// Registry of TraceExporters.
 class TraceExporterRegistry final {
 public:
@@ -55,6 +138,19 @@ public:
   /// Export events from the given TraceContext
   void exportTrace(TraceContext *tcontext);
 
+  /// Sets the policy of continuous sampled tracing to \p sampler, nullptr
+  /// disables it.
+  void setSampler(std::shared_ptr<TraceSampler> sampler);
+
+  /// \returns the policy of continuous sampled tracing, nullptr if disabled.
+  std::shared_ptr<TraceSampler> getSampler();
+
+  /// Exports \p tcontext, the trace of a request traced at \p level as chosen
+  /// by the TraceSampler and run in \p latency microseconds, if the sampler
+  /// selects it. The time spent exporting counts toward the overhead budget.
+  void exportSampledTrace(TraceContext *tcontext, TraceLevel level,
+                          uint64_t latency);
+
   /// Register a TraceExporter.
   void registerTraceExporter(TraceExporter *exporter);
 
@@ -68,6 +164,9 @@ private:
   /// Registered TraceExporters.
   std::vector<TraceExporter *> exporters_;
   std::mutex mutex_;
+
+  /// Policy of continuous sampled tracing, nullptr if disabled.
+  std::shared_ptr<TraceSampler> sampler_;
 };
 
 } // namespace glow
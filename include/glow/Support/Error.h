@@ -322,6 +322,8 @@ public:
     RUNTIME_DEVICE_NONRECOVERABLE,
     // Runtime error, network busy to perform any operation on it.
     RUNTIME_NET_BUSY,
+    // Runtime error, the request was cancelled by its client.
+    RUNTIME_REQUEST_CANCELLED,
     // Device error, not supported.
     DEVICE_FEATURE_NOT_SUPPORTED,
     // Compilation error; node unsupported after optimizations.
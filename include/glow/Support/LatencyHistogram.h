@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_SUPPORT_LATENCYHISTOGRAM_H
+#define GLOW_SUPPORT_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace glow {
+
+/// Lock-free histogram of non-negative integer values, typically latencies
+/// in microseconds. Buckets are log-linear in the style of HdrHistogram:
+/// values below kSubBuckets get a bucket each, and every power of two above
+/// that is split into kSubBuckets equal buckets, bounding the relative error
+/// of any reported percentile by 1 / kSubBuckets. Recording is a handful of
+/// relaxed atomic increments and may be done concurrently from any thread.
+/// Readers see an approximate snapshot while values are being recorded.
+class LatencyHistogram final {
+public:
+  /// log2 of the number of buckets per power of two.
+  static constexpr unsigned kSubBucketBits = 4;
+  static constexpr unsigned kSubBuckets = 1u << kSubBucketBits;
+  /// Number of buckets needed to cover every uint64_t value.
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  /// Record a single occurrence of \p value.
+  void record(uint64_t value);
+
+  /// \returns the number of values recorded.
+  uint64_t getCount() const { return count_.load(std::memory_order_relaxed); }
+
+  /// \returns the sum of all values recorded.
+  uint64_t getSum() const { return sum_.load(std::memory_order_relaxed); }
+
+  /// \returns the largest value recorded, or 0 if there are none.
+  uint64_t getMax() const { return max_.load(std::memory_order_relaxed); }
+
+  /// \returns the value at quantile \p q in [0, 1], e.g. 0.99 for p99. The
+  /// result is the upper bound of the bucket holding that value, capped by
+  /// getMax(). \returns 0 if no values were recorded.
+  uint64_t getPercentile(double q) const;
+
+  /// Clear all recorded values. Values recorded concurrently may be lost.
+  void reset();
+
+  /// \returns the index of the bucket \p value falls into.
+  static size_t getBucketIndex(uint64_t value);
+
+  /// \returns the largest value that falls into bucket \p idx.
+  static uint64_t getBucketUpperBound(size_t idx);
+
+private:
+  /// Number of values per bucket.
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+
+  /// Total number of recorded values.
+  std::atomic<uint64_t> count_{0};
+
+  /// Sum of recorded values.
+  std::atomic<uint64_t> sum_{0};
+
+  /// Largest recorded value.
+  std::atomic<uint64_t> max_{0};
+};
+
+} // namespace glow
+
+#endif // GLOW_SUPPORT_LATENCYHISTOGRAM_H
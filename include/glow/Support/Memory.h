@@ -44,6 +44,28 @@ inline void *alignedAlloc(size_t size, size_t align) {
 /// Free aligned memory.
 inline void alignedFree(void *p) { glow_aligned_free(p); }
 
+/// Placement of the large, long-lived buffers such as the constant weights of
+/// a network, see largeAlloc.
+struct LargeAllocPolicy {
+  /// Buffers of at least this many bytes are placed on huge pages; 0 keeps
+  /// all of them on regular pages.
+  size_t hugePageMinBytes{0};
+  /// Whether to try the reserved huge pages of the system before the
+  /// transparent ones.
+  bool explicitHugePages{false};
+  /// The NUMA node the buffers are bound to, negative for no binding.
+  int numaNode{-1};
+};
+
+/// Allocate \p size bytes of memory aligned to TensorAlignment, placed as
+/// \p policy says where the system allows it and on regular heap memory
+/// otherwise. \p mapped is set to whether the memory was mapped for the
+/// policy, in which case it must be freed by largeFree, else by alignedFree.
+void *largeAlloc(size_t size, const LargeAllocPolicy &policy, bool &mapped);
+
+/// Free the memory \p p of \p size bytes mapped by largeAlloc.
+void largeFree(void *p, size_t size);
+
 /// Rounds up \p size to the nearest \p alignment.
 inline size_t alignedSize(size_t size, size_t alignment) {
   size_t mod = size % alignment;
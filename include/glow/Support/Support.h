@@ -241,6 +241,10 @@ Expected<int> getIntFromStr(llvm::StringRef input);
 /// Convert a string to float. \returns the float or Error if problem parsing.
 Expected<float> getFloatFromStr(llvm::StringRef input);
 
+/// \returns the peak resident memory of the process in kilobytes, or 0 if it
+/// is not known on this platform.
+uint64_t getMaxRSSKB();
+
 /// A helper type for creating compile-time strings.
 template <char... letters> struct string_t {
   static char const *str() {
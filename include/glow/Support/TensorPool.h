@@ -19,36 +19,79 @@
 #include "glow/Base/Tensor.h"
 #include "llvm/ADT/Optional.h"
 
+#include <array>
 #include <atomic>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace glow {
 
+/// A pool of Tensors, reused across the Types of equal or close sizes. The
+/// buffers of the pool are sized by size classes, see getSizeClass(), and a
+/// buffer is handed out for any Type of its size class. The available buffers
+/// are spread over shards, each with its own lock: a thread returns buffers to
+/// and takes buffers from its home shard, and falls back to the other shards
+/// when its own has none of the size class, so that concurrent threads rarely
+/// contend for a lock. The buffers come from alignedAlloc() by default, or
+/// from the allocation functions given at construction, e.g. to use the
+/// pinned IO buffers of a device.
 class TensorPool final {
+public:
+  /// Allocates a buffer of the given number of bytes for the pool.
+  using BufferAllocFn = std::function<void *(size_t)>;
+  /// Frees a buffer allocated by the BufferAllocFn of the pool.
+  using BufferFreeFn = std::function<void(void *)>;
+
 private:
-  struct TypeHash {
-    size_t operator()(const Type &t) const { return t.equals_hash(); }
-  };
+  /// Number of shards of the available buffers.
+  static constexpr size_t numShards = 8;
 
-  struct TypeEquals {
-    bool operator()(const Type &a, const Type &b) const { return a.isEqual(b); }
+  /// The available buffers of the threads whose home shard this is.
+  struct Shard {
+    /// A stack of available Tensors per size class.
+    std::unordered_map<size_t, std::vector<Tensor>> buffers;
+
+    /// Mutex around buffers.
+    std::mutex lock;
   };
-  /// A stack of available Tensors per Type.
-  std::unordered_map<Type, std::vector<Tensor>, TypeHash, TypeEquals> pools_;
+  std::array<Shard, numShards> shards_;
+
+  /// The size classes that were ever available in the pool.
+  std::unordered_set<size_t> sizeClasses_;
 
-  /// Mutex around pools_;
-  std::mutex lock_;
+  /// Mutex around sizeClasses_.
+  std::mutex sizeClassesLock_;
 
   /// Whether or not to allow allocation of new buffers if the pool is empty.
   const bool preventInlineAllocs_{false};
 
+  /// Allocation function of the buffers, alignedAlloc() if not set. Tensors
+  /// of buffers it allocates are unowned and their buffers are freed by
+  /// freeFn_ when the pool is cleared.
+  const BufferAllocFn allocFn_;
+
+  /// Frees the buffers of allocFn_.
+  const BufferFreeFn freeFn_;
+
+  /// \returns the home shard of the calling thread.
+  Shard &getHomeShard();
+
+  /// Records that the size class \p sizeClass is available in the pool.
+  void addSizeClass(size_t sizeClass);
+
+  /// \returns a new Tensor of type \p ty managed by this pool, with a buffer
+  /// of the size of its size class.
+  Tensor allocate(TypeRef ty);
+
 public:
   /// Statistics relating to the usage of the pool.
   struct Stats {
-    /// The total number of Types that has ever been available in this pool.
+    /// The total number of size classes that has ever been available in this
+    /// pool.
     std::atomic<uint64_t> totalTypes{0};
     /// The number of Tensors currently allocated and available.
     std::atomic<uint64_t> currentBuffers{0};
@@ -63,21 +106,49 @@ public:
     std::atomic<uint64_t> totalReclaims{0};
     /// The total number of times a Tensor was freed (e.g. via clear()).
     std::atomic<uint64_t> totalFrees{0};
+    /// The total number of times a Tensor was retrieved from the available
+    /// buffers rather than allocated, totalHits / totalGets is the hit rate.
+    std::atomic<uint64_t> totalHits{0};
+    /// The number of the hits that were served by a shard other than the home
+    /// shard of the retrieving thread.
+    std::atomic<uint64_t> sharedHits{0};
+    /// The total number of bytes of the buffers retrieved from the pool beyond
+    /// the size of the requested Types, the cost of the size classes.
+    std::atomic<uint64_t> totalWastedBytes{0};
+    /// The number of bytes of the buffers allocated by the pool and not freed
+    /// yet, whether they are available or handed out.
+    std::atomic<uint64_t> allocatedBytes{0};
+    /// The number of bytes of the buffers currently available in the pool.
+    std::atomic<uint64_t> availableBytes{0};
   } stats_;
 
   TensorPool(bool preventAllocs = false)
       : preventInlineAllocs_{preventAllocs} {}
 
+  /// Constructor of a pool whose buffers are allocated by \p allocFn and freed
+  /// by \p freeFn.
+  TensorPool(BufferAllocFn allocFn, BufferFreeFn freeFn,
+             bool preventAllocs = false)
+      : preventInlineAllocs_{preventAllocs}, allocFn_(std::move(allocFn)),
+        freeFn_(std::move(freeFn)) {}
+
   ~TensorPool() { clear(); }
 
-  /// Retrieve a Tensor with type \p ty from the pool - this type must have
-  /// previously been added by initialize. If the pool is empty this will
+  /// \returns the size class of the Types of \p size bytes, which is the size
+  /// of the buffers that hold them: the next power of two up to 64 bytes, and
+  /// above that the next multiple of a quarter of the next power of two, so
+  /// that no more than a quarter of a large buffer is wasted.
+  static size_t getSizeClass(size_t size);
+
+  /// Retrieve a Tensor with type \p ty from the pool, reusing a buffer of any
+  /// Type of the same size class. If the pool has no such buffer this will
   /// allocate a new Tensor unless preventAllocs was set true at construction
   /// time.
   llvm::Optional<Tensor> get(TypeRef ty);
 
   /// Return a Tensor \p t to the pool. This Tensor must have been previously
-  /// allocated by this TensorPool.
+  /// allocated by this TensorPool and still have a Type of the size class it
+  /// was retrieved with.
   void reclaim(Tensor &&t);
 
   /// Add \p count elements of the provided type \p ty to the pool.
@@ -18,14 +18,21 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <queue>
 #include <set>
 #include <thread>
+#include <type_traits>
 #include <vector>
 
+#include "llvm/ADT/StringRef.h"
+
 namespace glow {
 
 namespace threads {
@@ -35,6 +42,14 @@ size_t getThreadId();
 /// Returns a unique id associated with a new virtual thread (i.e. a device
 /// tid).
 size_t createThreadId();
+
+/// Parses the list of CPUs and CPU ranges \p list, such as "0-3,8", into
+/// \p cpus. \returns false if \p list is malformed.
+bool parseCPUList(llvm::StringRef list, std::vector<unsigned> &cpus);
+
+/// Restricts the current thread to run on the CPUs \p cpus. \returns false if
+/// the system doesn't allow it.
+bool setAffinity(const std::vector<unsigned> &cpus);
 } // namespace threads
 
 #ifdef WIN32
@@ -60,11 +75,196 @@ shared_function<std::decay_t<F>> make_shared_function(F &&f) {
 }
 #endif
 
+/// A move-only void() callable. Callables of up to kInlineSize bytes, such as
+/// lambdas with a few captures or a std::packaged_task, are stored inline so
+/// that creating and moving the task allocates nothing; larger ones are moved
+/// to the heap.
+class InlineTask final {
+public:
+  static constexpr size_t kInlineSize = 6 * sizeof(void *);
+
+  InlineTask() = default;
+
+  template <typename F, typename = typename std::enable_if<!std::is_same<
+                            typename std::decay<F>::type, InlineTask>::value>::
+                            type>
+  InlineTask(F &&fn) {
+    using Fn = typename std::decay<F>::type;
+    init<Fn>(std::forward<F>(fn),
+             std::integral_constant<
+                 bool, sizeof(Fn) <= kInlineSize &&
+                           alignof(Fn) <= alignof(std::max_align_t) &&
+                           std::is_nothrow_move_constructible<Fn>::value>());
+  }
+
+  InlineTask(InlineTask &&other) noexcept { moveFrom(other); }
+
+  InlineTask &operator=(InlineTask &&other) noexcept {
+    if (this != &other) {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  InlineTask(const InlineTask &) = delete;
+  InlineTask &operator=(const InlineTask &) = delete;
+
+  ~InlineTask() { reset(); }
+
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+  void operator()() { invoke_(storage_); }
+
+  /// Destroy the callable, leaving the task empty.
+  void reset() {
+    if (manage_) {
+      manage_(nullptr, storage_);
+    }
+    invoke_ = nullptr;
+    manage_ = nullptr;
+  }
+
+private:
+  /// Store \p fn in storage_.
+  template <typename Fn, typename F> void init(F &&fn, std::true_type) {
+    new (storage_) Fn(std::forward<F>(fn));
+    invoke_ = [](void *s) { (*static_cast<Fn *>(s))(); };
+    manage_ = [](void *dst, void *src) {
+      if (dst) {
+        new (dst) Fn(std::move(*static_cast<Fn *>(src)));
+      }
+      static_cast<Fn *>(src)->~Fn();
+    };
+  }
+
+  /// Store a pointer to a heap copy of \p fn in storage_.
+  template <typename Fn, typename F> void init(F &&fn, std::false_type) {
+    *reinterpret_cast<Fn **>(storage_) = new Fn(std::forward<F>(fn));
+    invoke_ = [](void *s) { (**static_cast<Fn **>(s))(); };
+    manage_ = [](void *dst, void *src) {
+      if (dst) {
+        *static_cast<Fn **>(dst) = *static_cast<Fn **>(src);
+      } else {
+        delete *static_cast<Fn **>(src);
+      }
+    };
+  }
+
+  void moveFrom(InlineTask &other) {
+    if (other.manage_) {
+      other.manage_(storage_, other.storage_);
+    }
+    invoke_ = other.invoke_;
+    manage_ = other.manage_;
+    other.invoke_ = nullptr;
+    other.manage_ = nullptr;
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+  /// Calls the callable in the storage.
+  void (*invoke_)(void *){nullptr};
+  /// Moves the callable of the second storage into the first one, if not
+  /// null, and destroys it.
+  void (*manage_)(void *, void *){nullptr};
+};
+
+/// A bounded multi-producer, multi-consumer lock-free queue (Vyukov). Each
+/// slot has a sequence number telling whether it is free for the producer of
+/// a given position or holds the element for the consumer of that position,
+/// so that producers and consumers only contend on their own index.
+template <typename T> class BoundedMPMCQueue final {
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+public:
+  /// Constructor. \p capacity must be a power of two.
+  explicit BoundedMPMCQueue(size_t capacity)
+      : cells_(new Cell[capacity]), mask_(capacity - 1) {
+    for (size_t i = 0; i < capacity; i++) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Move \p value into the queue. \returns false, leaving \p value
+  /// untouched, if the queue is full.
+  bool tryPush(T &&value) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = intptr_t(seq) - intptr_t(pos);
+      if (diff == 0) {
+        if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Move the oldest element of the queue into \p value. \returns false if
+  /// the queue is empty.
+  bool tryPop(T &value) {
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = intptr_t(seq) - intptr_t(pos + 1);
+      if (diff == 0) {
+        if (dequeuePos_.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos_.load(std::memory_order_relaxed);
+      }
+    }
+    value = std::move(cell->value);
+    // Release what the moved-from element may still hold.
+    cell->value = T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// \returns true if there is no element ready to be popped. This is exact
+  /// only when called by the single consumer of the queue.
+  bool empty() const {
+    size_t pos = dequeuePos_.load(std::memory_order_acquire);
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire) !=
+           pos + 1;
+  }
+
+private:
+  std::unique_ptr<Cell[]> cells_;
+  const size_t mask_;
+  /// The producer and consumer indices are on their own cache lines.
+  alignas(64) std::atomic<size_t> enqueuePos_{0};
+  alignas(64) std::atomic<size_t> dequeuePos_{0};
+};
+
 /// An executor that runs Tasks on a single thread.
 class ThreadExecutor final {
 public:
-  /// Constructor. Initializes one thread backed by the workQueue_.
-  explicit ThreadExecutor(const std::string &name = "");
+  /// Constructor. Initializes one thread backed by the workQueue_. When it
+  /// runs out of work, the thread checks for new work \p spinIterations
+  /// times, yielding in between, before sleeping until work is added, which
+  /// trades CPU time for the latency of waking it up.
+  explicit ThreadExecutor(const std::string &name = "",
+                          unsigned spinIterations = 0);
 
   /// Destructor. Signals the thread to stop and waits for exit.
   ~ThreadExecutor();
@@ -72,37 +272,63 @@ public:
   /// Submit \p fn as a work item for the thread pool.
   /// \p fn must be a lambda with void return type and arguments.
   template <typename F> std::future<void> submit(F &&fn) {
-    // Add fn to the work queue.
-    std::unique_lock<std::mutex> lock(workQueueMtx_);
-
 #ifdef WIN32
     std::packaged_task<void(void)> task(make_shared_function(std::move(fn)));
 #else
     std::packaged_task<void(void)> task(std::move(fn));
 #endif
 
-    auto future = task.get_future();
-    workQueue_.push(std::move(task));
-    lock.unlock();
-    queueNotEmpty_.notify_one();
-    return future;
+    return submit(std::move(task));
   }
 
   /// Submit \p task as a work item for the thread pool.
   std::future<void> submit(std::packaged_task<void(void)> &&task);
 
+  /// Submit \p fn as a work item without a future to report its completion.
+  /// Small callables are queued without allocating, on a lock-free queue.
+  /// Work items of both post() and submit() run in the order they were added
+  /// by each thread.
+  template <typename F> void post(F &&fn) {
+    post(InlineTask(std::forward<F>(fn)));
+  }
+
+  /// Submit \p task as a work item without a future.
+  void post(InlineTask &&task);
+
   void stop(bool block = false);
 
 protected:
   /// Main loop run by the workers in the thread pool.
   void threadPoolWorkerMain();
 
+  /// Pop the next work item into \p task. \returns false if there is none.
+  bool popTask(InlineTask &task);
+
+  /// Wake up the worker if it is sleeping, after work was added.
+  void notifyWorker();
+
+  /// Number of work items the lock-free queue holds, a power of two.
+  static constexpr size_t kQueueCapacity = 1024;
+
   /// Flag checked in between work items to determine whether we should stop and
   /// exit.
   std::atomic<bool> shouldStop_{false};
 
-  /// Queue of work items.
-  std::queue<std::packaged_task<void(void)>> workQueue_;
+  /// Lock-free queue of work items.
+  BoundedMPMCQueue<InlineTask> taskQueue_{kQueueCapacity};
+
+  /// Work items added while taskQueue_ was full, or before those are done.
+  std::queue<InlineTask> workQueue_;
+
+  /// Number of items in workQueue_. While it isn't zero, new items go to
+  /// workQueue_ too, to keep them in order.
+  std::atomic<size_t> workQueueSize_{0};
+
+  /// Number of times to check for work before sleeping.
+  const unsigned spinIterations_;
+
+  /// Whether the worker is about to sleep or is sleeping on queueNotEmpty_.
+  std::atomic<bool> sleeping_{false};
 
   /// Mutex to coordinate access to the work queue.
   std::mutex workQueueMtx_;
@@ -119,8 +345,10 @@ protected:
 class ThreadPool final {
 public:
   /// Constructor. Initializes a thread pool with \p numWorkers
-  /// threads and has them all run ThreadPool::threadPoolWorkerMain.
-  ThreadPool(unsigned numWorkers = kNumWorkers, const std::string &name = "");
+  /// threads and has them all run ThreadPool::threadPoolWorkerMain. Idle
+  /// workers check for work \p spinIterations times before sleeping.
+  ThreadPool(unsigned numWorkers = kNumWorkers, const std::string &name = "",
+             unsigned spinIterations = 0);
 
   /// Destructor. Signals to all threads to stop and waits for all of them
   /// to exit.
@@ -144,6 +372,12 @@ public:
   /// Submit \p task as a work item for the thread pool.
   std::future<void> submit(std::packaged_task<void(void)> &&task);
 
+  /// Submit \p fn as a work item for the thread pool, without a future to
+  /// report its completion. See ThreadExecutor::post.
+  template <typename F> void post(F &&fn) {
+    getExecutor()->post(std::forward<F>(fn));
+  }
+
   /// Returns a ThreadExecutor that can be accessed directly, allowing
   /// submitting multiple tasks to the same thread.
   ThreadExecutor *getExecutor() {
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef GLOW_SUPPORT_WORKSTEALINGTHREADPOOL_H
+#define GLOW_SUPPORT_WORKSTEALINGTHREADPOOL_H
+
+#include "folly/Function.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace glow {
+
+/// A single-producer, multi-consumer lock-free deque (Chase-Lev). The owning
+/// worker pushes and pops at the bottom; any other thread may steal from the
+/// top. Elements are raw pointers whose ownership is transferred by the
+/// caller. Buffers replaced during growth are retired and only freed on
+/// destruction, since a concurrent thief may still be reading from them.
+template <typename T> class WorkStealingDeque final {
+  /// Fixed size circular buffer backing the deque.
+  struct Buffer {
+    explicit Buffer(int64_t capacity)
+        : capacity(capacity), mask(capacity - 1),
+          slots(new std::atomic<T *>[capacity]) {}
+
+    T *get(int64_t i) const {
+      return slots[i & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t i, T *item) {
+      slots[i & mask].store(item, std::memory_order_relaxed);
+    }
+
+    /// \returns a buffer of twice the size holding the elements [\p top,
+    /// \p bottom).
+    Buffer *grow(int64_t top, int64_t bottom) const {
+      Buffer *newBuffer = new Buffer(capacity * 2);
+      for (int64_t i = top; i < bottom; i++) {
+        newBuffer->put(i, get(i));
+      }
+      return newBuffer;
+    }
+
+    const int64_t capacity;
+    const int64_t mask;
+    std::unique_ptr<std::atomic<T *>[]> slots;
+  };
+
+public:
+  /// Constructor. \p initialCapacity must be a power of two.
+  explicit WorkStealingDeque(int64_t initialCapacity = 256)
+      : buffer_(new Buffer(initialCapacity)) {
+    retired_.emplace_back(buffer_.load(std::memory_order_relaxed));
+  }
+
+  /// Push \p item onto the bottom of the deque. Must only be called by the
+  /// owning thread.
+  void push(T *item) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Buffer *buf = buffer_.load(std::memory_order_relaxed);
+    if (b - t > buf->capacity - 1) {
+      buf = buf->grow(t, b);
+      retired_.emplace_back(buf);
+      buffer_.store(buf, std::memory_order_release);
+    }
+    buf->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Pop an item from the bottom of the deque. Must only be called by the
+  /// owning thread. \returns nullptr if the deque is empty.
+  T *pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Buffer *buf = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // Deque was already empty.
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    T *item = buf->get(b);
+    if (t == b) {
+      // Last element, race against thieves for it.
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        item = nullptr;
+      }
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  /// Steal an item from the top of the deque. May be called from any thread.
+  /// \returns nullptr if the deque was empty or the steal lost a race.
+  T *steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    Buffer *buf = buffer_.load(std::memory_order_consume);
+    T *item = buf->get(t);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+  /// \returns an approximation of the number of items in the deque.
+  size_t sizeApprox() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? b - t : 0;
+  }
+
+private:
+  /// Index one past the last element, only written by the owner.
+  std::atomic<int64_t> bottom_{0};
+  /// Index of the first element, advanced by pop() and steal().
+  std::atomic<int64_t> top_{0};
+  /// The currently active buffer.
+  std::atomic<Buffer *> buffer_;
+  /// All buffers allocated by this deque, including the active one.
+  std::vector<std::unique_ptr<Buffer>> retired_;
+};
+
+/// Thread pool where every worker owns a WorkStealingDeque. Work added from a
+/// worker thread is pushed onto that worker's own deque and executed LIFO, so
+/// follow-up work stays on the thread (and cache) that produced it. Work added
+/// from outside the pool goes into a shared injection queue. A worker that
+/// runs out of local work takes from the injection queue and then steals from
+/// the top of its peers' deques.
+class WorkStealingThreadPool final {
+public:
+  using Task = folly::Function<void()>;
+
+  /// Constructor. Spawns \p numWorkers threads, named \p name if non-empty.
+  explicit WorkStealingThreadPool(unsigned numWorkers,
+                                  const std::string &name = "");
+
+  /// Destructor. Stops the pool and joins all workers.
+  ~WorkStealingThreadPool();
+
+  /// Schedule \p fn for execution on the pool.
+  void add(Task fn);
+
+  /// Signal workers to exit once all queued work has been drained.
+  void stop();
+
+  /// Wait for all workers to exit. stop() must have been called first.
+  void join();
+
+  /// \returns the number of workers in the pool.
+  size_t getNumWorkers() const { return workers_.size(); }
+
+  /// \returns the number of tasks that were executed by a worker other than
+  /// the one they were queued on.
+  uint64_t getNumSteals() const {
+    return numSteals_.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// Per worker state.
+  struct Worker {
+    WorkStealingDeque<Task> deque;
+    std::thread thread;
+  };
+
+  /// Main loop run by the worker with index \p idx.
+  void workerMain(unsigned idx);
+
+  /// Find the next task for worker \p idx, or \returns nullptr if there is
+  /// currently no work anywhere in the pool.
+  Task *findTask(unsigned idx);
+
+  /// Workers owned by this pool. Const after construction.
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /// Tasks added from threads that are not workers of this pool.
+  std::deque<Task *> injectionQueue_;
+
+  /// Number of tasks queued but not yet picked up by a worker.
+  std::atomic<int64_t> pending_{0};
+
+  /// Number of tasks that were stolen from a peer's deque.
+  std::atomic<uint64_t> numSteals_{0};
+
+  /// Whether the pool has been asked to stop.
+  std::atomic<bool> stopping_{false};
+
+  /// Protects injectionQueue_ and is used with idleCV_ for idle workers.
+  std::mutex mtx_;
+
+  /// Signalled whenever new work is available or the pool is stopping.
+  std::condition_variable idleCV_;
+};
+
+} // namespace glow
+
+#endif // GLOW_SUPPORT_WORKSTEALINGTHREADPOOL_H
@@ -18,11 +18,15 @@
 
 #include <fstream>
 #include <iostream>
+#include <list>
 #include <memory>
 #include <string>
 
 #include <glog/logging.h>
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
 #include "miniz.h"
 
 namespace glow {
@@ -74,18 +78,39 @@ class ZipReader {
   std::unique_ptr<mz_zip_archive> ar_;
   std::string archive_name_;
   std::unique_ptr<FileAdapter> in_;
+  /// Private mapping of the archive file, when the reader maps it.
+  std::unique_ptr<llvm::WritableMemoryBuffer> mapping_;
+  /// Data of the records extracted for views, owned by the reader.
+  std::list<std::string> extracted_;
   void valid(const char *what, const char *info = "");
-  size_t read(uint64_t pos, char *buf, size_t n) {
-    return in_->read(pos, buf, n, "reading file");
-  }
+  size_t read(uint64_t pos, char *buf, size_t n);
   size_t getRecordID(const std::string &name);
+  /// \returns whether the record \p name is stored uncompressed, in which case
+  /// its data is the \p size bytes at \p offset in the archive file.
+  bool getStoredRecordLocation(const std::string &name, uint64_t &offset,
+                               uint64_t &size);
 
 public:
-  explicit ZipReader(const std::string &file_name);
+  /// Opens the archive \p file_name. If \p mapFile then the archive is
+  /// memory-mapped, and the views of its uncompressed records point into the
+  /// mapping instead of holding a copy of their data.
+  explicit ZipReader(const std::string &file_name, bool mapFile = false);
   ~ZipReader();
   void init();
   std::string getRecord(const std::string &name);
   bool hasRecord(const std::string &name);
+  /// \returns the name of the folder all the records of the archive are in.
+  const std::string &getArchiveName() const { return archive_name_; }
+  /// \returns a view of the data of the record \p name, valid for the
+  /// lifetime of the reader. The record is extracted into a buffer owned by
+  /// the reader unless the archive is mapped and the record is uncompressed.
+  llvm::ArrayRef<char> getRecordView(const std::string &name) {
+    return getMutableRecordView(name);
+  }
+  /// \returns a view of the data of the record \p name like getRecordView.
+  /// The mapping of the archive is private, so modifying the data through
+  /// the view does not modify the archive file.
+  llvm::MutableArrayRef<char> getMutableRecordView(const std::string &name);
 };
 
 /// Zip Writer
@@ -91,11 +91,13 @@ void Backend::autoInstrument(TraceInfo &traceInfo, IRFunction *IR) const {
   std::string name = F->getName().str() + "_instrumentation";
   Placeholder *backingPH = F->getParent()->getPlaceholderByNameSlow(name);
 
+  // Each event is a row of the timestamp and the hardware counters, if any.
   auto &varmap = IR->getVariableMap();
   auto type = F->getParent()->uniqueType(
       ElemKind::Int64ITy,
-      {numEvents, (dim_t)getTraceEventDataSize() /
-                      Type::getElementSize(ElemKind::Int64ITy)});
+      {numEvents, (dim_t)(getTraceEventDataSize() /
+                              Type::getElementSize(ElemKind::Int64ITy) +
+                          traceInfo.counterNames.size())});
 
   WeightVar *backingWeight = nullptr;
 
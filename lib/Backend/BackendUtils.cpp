@@ -15,6 +15,7 @@
  */
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Graph/FXIRWrapper.h"
+#include "glow/Graph/PlaceholderBindings.h"
 #include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
 #include "glow/Support/Debug.h"
@@ -49,6 +50,7 @@ glow::runtime::RuntimeBundle::operator=(glow::runtime::RuntimeBundle &&rhs) {
 
   std::swap(symbolTable_, rhs.symbolTable_);
   std::swap(constants_, rhs.constants_);
+  std::swap(constantsMapped_, rhs.constantsMapped_);
   std::swap(constantWeightVarsMemSize_, rhs.constantWeightVarsMemSize_);
   std::swap(mutableWeightVarsMemSize_, rhs.mutableWeightVarsMemSize_);
   std::swap(activationsMemSize_, rhs.activationsMemSize_);
@@ -67,11 +69,17 @@ void glow::runtime::RuntimeBundle::freeConstants() {
   DCHECK(isValid_);
 
   if (constants_) {
-    glow::alignedFree(constants_);
+    if (constantsMapped_) {
+      glow::largeFree(constants_, constantWeightVarsMemSize_);
+    } else {
+      glow::alignedFree(constants_);
+    }
     constants_ = nullptr;
+    constantsMapped_ = false;
   }
 }
-void glow::runtime::RuntimeBundle::collectConstants(const Module *M) {
+void glow::runtime::RuntimeBundle::collectConstants(
+    const Module *M, const LargeAllocPolicy &policy) {
   DCHECK(isValid_);
 
   // At compile time condense constants to a single block of memory.
@@ -83,8 +91,8 @@ void glow::runtime::RuntimeBundle::collectConstants(const Module *M) {
   }
 
   assert(constants_ == nullptr && "constants already allocated");
-  constants_ =
-      (uint8_t *)alignedAlloc(constantWeightVarsMemSize_, TensorAlignment);
+  constants_ = (uint8_t *)largeAlloc(constantWeightVarsMemSize_, policy,
+                                     constantsMapped_);
 
   for (const auto &symbol : symbolTable_) {
     llvm::StringRef name = symbol.first;
@@ -129,10 +137,10 @@ void glow::runtime::RuntimeBundle::collectConstants(const FXIRWrapper *F) {
       continue;
     }
 
-    auto mapToConstants = F->getMapNodeNameToStorage();
-    assert(mapToConstants.find(name.str()) != mapToConstants.end());
-    const auto *wt = mapToConstants[name.str()];
-    const auto *c = llvm::dyn_cast<const Constant>(wt);
+    const auto &mapToConstants = F->getMapNodeNameToStorage();
+    auto it = mapToConstants.find(name);
+    assert(it != mapToConstants.end());
+    const auto *c = llvm::dyn_cast<const Constant>(it->second);
     if (!c) {
       continue;
     }
@@ -153,6 +161,29 @@ size_t glow::runtime::RuntimeBundle::getValueOffset(const Named *v) const {
   return it->second.offset;
 }
 
+void runtime::RuntimeBundle::bindIOBuffer(const Module &module,
+                                          PlaceholderBindings &bindings,
+                                          uint8_t *ioBuffer) const {
+  DCHECK(isValid_);
+  DCHECK_EQ(reinterpret_cast<uintptr_t>(ioBuffer) % TensorAlignment, 0)
+      << "IO buffer must be aligned to " << TensorAlignment;
+  for (const auto &symbol : symbolTable_) {
+    if (symbol.second.symbolCategory != SymbolCategory::Placeholder) {
+      continue;
+    }
+    Placeholder *PH = module.getPlaceholderByNameSlow(symbol.first);
+    if (!PH) {
+      continue;
+    }
+    DCHECK_LE(symbol.second.offset + symbol.second.size,
+              mutableWeightVarsMemSize_);
+    if (bindings.count(PH)) {
+      bindings.erase(PH);
+    }
+    bindings.insert(PH, Tensor(ioBuffer + symbol.second.offset, PH->getType()));
+  }
+}
+
 const runtime::RuntimeSymbolInfo &
 runtime::RuntimeBundle::getSymbolInfo(const Named *v) const {
   DCHECK(isValid_);
@@ -557,8 +588,27 @@ void allocateActivations(const glow::IRFunction::InstListTy &instrs,
   // does not work together with the function "allocate()" which could have
   // been used with the original allocator.
   MemoryAllocator activationsAllocator("mem", 0, allocator.getAlignment());
+  activationsAllocator.setPlanner(allocator.getPlanner());
+  activationsAllocator.setSearchBudget(allocator.getSearchBudget());
   uint64_t activationsSize = activationsAllocator.allocateAll(allocList);
 
+  // Report the peak activation memory of every planner, to pick the one each
+  // backend uses.
+  if (VLOG_IS_ON(1)) {
+    for (auto planner : {MemoryPlanner::LiveSize, MemoryPlanner::GreedyBySize,
+                         MemoryPlanner::BestFit, MemoryPlanner::Search}) {
+      MemoryAllocator plannerAllocator("mem", 0, allocator.getAlignment());
+      plannerAllocator.setPlanner(planner);
+      plannerAllocator.setSearchBudget(allocator.getSearchBudget());
+      uint64_t plannerSize = plannerAllocator.allocateAll(allocList);
+      VLOG(1) << "Memory planner " << getMemoryPlannerName(planner)
+              << ": peak activation memory " << plannerSize
+              << " bytes, efficiency "
+              << plannerAllocator.getAllocationEfficiency()
+              << (planner == allocator.getPlanner() ? " (used)" : "");
+    }
+  }
+
   // Allocate a contiguous segment for the activations of the current function.
   // The individual buffers within this segment are placed according to the
   // logic of allocateAll for better efficiency.
@@ -19,10 +19,12 @@
 #include "CPULLVMIRGen.h"
 
 #include "glow/Backend/BackendUtils.h"
+#include "glow/Flags/Flags.h"
 #include "glow/Graph/Graph.h"
 #include "glow/IR/Instrs.h"
 #include "glow/LLVMIRCodeGen/LLVMIRGen.h"
 #include "glow/Support/Debug.h"
+#include "glow/Support/Support.h"
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
@@ -52,6 +54,32 @@ static const unsigned char libjit_bc[] = {
 };
 static const size_t libjit_bc_size = sizeof(libjit_bc);
 
+/// \returns whether the operand types of the IntNBitSplitEmbeddingBags or
+/// IntNBitSplitEmbeddingWeightedBags node \p NI are supported, apart from the
+/// indice weights. Both nodes share the indices of these operands.
+static bool isSplitEmbeddingBagsSupported(const NodeInfo &NI) {
+  return NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::DevWeightsIdx) ==
+             ElemKind::UInt8ITy &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::UvmWeightsIdx) ==
+             ElemKind::UInt8ITy &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::WeightsPlacementsIdx) ==
+             ElemKind::Int32ITy &&
+         (NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::WeightsOffsetsIdx) ==
+              ElemKind::Int32ITy ||
+          NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::WeightsOffsetsIdx) ==
+              ElemKind::Int64ITy) &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::WeightsTysIdx) ==
+             ElemKind::UInt8ITy &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::DimOffsetsIdx) ==
+             ElemKind::Int32ITy &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::IndicesIdx) ==
+             ElemKind::Int32ITy &&
+         NI.getInElemTy(IntNBitSplitEmbeddingBagsNode::OffsetsIdx) ==
+             ElemKind::Int32ITy &&
+         NI.getOutElemTy(IntNBitSplitEmbeddingBagsNode::ResultIdx) ==
+             ElemKind::FloatTy;
+}
+
 bool CPUBackend::isOpSupported(const NodeInfo &NI) const {
   switch (NI.getKind()) {
 
@@ -62,6 +90,158 @@ bool CPUBackend::isOpSupported(const NodeInfo &NI) const {
   case Kinded::Kind::CPUConvDKKC8NodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::FloatTy});
 
+  case Kinded::Kind::CPUConvWinogradNodeKind:
+  case Kinded::Kind::CPUConvIm2ColNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::FloatTy});
+
+  case Kinded::Kind::CPUFullyConnectedPackedNodeKind:
+    return NI.getInElemTy(CPUFullyConnectedPackedNode::InputIdx) ==
+               ElemKind::Int8QTy &&
+           NI.getInElemTy(CPUFullyConnectedPackedNode::WeightsIdx) ==
+               ElemKind::UInt8QTy &&
+           NI.getInElemTy(CPUFullyConnectedPackedNode::ColTermsIdx) ==
+               ElemKind::Int32ITy &&
+           NI.getOutElemTy(CPUFullyConnectedPackedNode::ResultIdx) ==
+               ElemKind::Int8QTy;
+
+  case Kinded::Kind::CPUFullyConnectedSparseNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy},
+        {CPUFullyConnectedSparseNode::BlockRowsIdx,
+         CPUFullyConnectedSparseNode::BlockPtrIdx}) &&
+           NI.getInElemTy(CPUFullyConnectedSparseNode::BlockRowsIdx) ==
+               ElemKind::Int32ITy &&
+           NI.getInElemTy(CPUFullyConnectedSparseNode::BlockPtrIdx) ==
+               ElemKind::Int32ITy;
+
+  case Kinded::Kind::IntNBitSplitEmbeddingBagsNodeKind:
+    return isSplitEmbeddingBagsSupported(NI);
+
+  case Kinded::Kind::IntNBitSplitEmbeddingWeightedBagsNodeKind:
+    return isSplitEmbeddingBagsSupported(NI) &&
+           NI.getInElemTy(
+               IntNBitSplitEmbeddingWeightedBagsNode::IndiceWeightIdx) ==
+               ElemKind::FloatTy;
+
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+  case Kinded::Kind::FusedSGDNodeKind:
+  case Kinded::Kind::LSTMUnitNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::FloatTy});
+
+  case Kinded::Kind::BeamSearchStepNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::FloatTy}, {BeamSearchStepNode::StateIdx},
+               {BeamSearchStepNode::TokensIdx,
+                BeamSearchStepNode::PrevIndicesIdx,
+                BeamSearchStepNode::NewStateIdx}) &&
+           NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+               NI.getOutElemTy(BeamSearchStepNode::PrevIndicesIdx) &&
+           ((NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+             ElemKind::Int64ITy) ||
+            (NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+             ElemKind::Int32ITy));
+
+  case Kinded::Kind::DynamicQuantizedFullyConnectedNodeKind:
+    return NI.getInElemTy(DynamicQuantizedFullyConnectedNode::InputIdx) ==
+               ElemKind::FloatTy &&
+           NI.getInElemTy(DynamicQuantizedFullyConnectedNode::WeightsIdx) ==
+               ElemKind::Int8QTy &&
+           NI.getInElemTy(DynamicQuantizedFullyConnectedNode::BiasIdx) ==
+               ElemKind::FloatTy &&
+           NI.getOutElemTy(DynamicQuantizedFullyConnectedNode::ResultIdx) ==
+               ElemKind::FloatTy;
+
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy},
+        {Int4GroupwiseQuantizedFullyConnectedNode::WeightsIdx,
+         Int4GroupwiseQuantizedFullyConnectedNode::ScalesIdx,
+         Int4GroupwiseQuantizedFullyConnectedNode::OffsetsIdx});
+
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::FloatTy},
+               {ProductQuantizedSparseLengthsWeightedSumNode::CodesIdx,
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx,
+                ProductQuantizedSparseLengthsWeightedSumNode::LengthsIdx}) &&
+           (NI.getInElemTy(
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx) ==
+                ElemKind::Int64ITy ||
+            NI.getInElemTy(
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx) ==
+                ElemKind::Int32ITy);
+
+  // Nodes with bfloat16 kernels in libjit, computing in float.
+  case Kinded::Kind::FullyConnectedNodeKind:
+  case Kinded::Kind::MatMulNodeKind:
+  case Kinded::Kind::AddNodeKind:
+  case Kinded::Kind::SubNodeKind:
+  case Kinded::Kind::MulNodeKind:
+  case Kinded::Kind::MaxNodeKind:
+  case Kinded::Kind::MinNodeKind:
+  case Kinded::Kind::SplatNodeKind:
+  case Kinded::Kind::ConcatNodeKind:
+  case Kinded::Kind::InsertTensorNodeKind:
+  case Kinded::Kind::SliceNodeKind:
+  case Kinded::Kind::TransposeNodeKind:
+  case Kinded::Kind::TouchNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::BFloat16Ty}) ||
+           LLVMBackend::isOpSupported(NI);
+
+  // Copies, which only move the bits of the elements.
+  case Kinded::Kind::SaveNodeKind:
+  case Kinded::Kind::ReshapeNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::BFloat16Ty, ElemKind::Float16Ty}) ||
+           LLVMBackend::isOpSupported(NI);
+
+  // Nodes with float16 kernels in libjit, accumulating in float.
+  case Kinded::Kind::SparseLengthsSumNodeKind:
+    return (NI.allInputsAndOutputsHaveSameElemKind(
+                {ElemKind::Float16Ty}, {SparseLengthsSumNode::IndicesIdx,
+                                        SparseLengthsSumNode::LengthsIdx}) &&
+            (NI.getInElemTy(SparseLengthsSumNode::IndicesIdx) ==
+                 ElemKind::Int64ITy ||
+             NI.getInElemTy(SparseLengthsSumNode::IndicesIdx) ==
+                 ElemKind::Int32ITy) &&
+            NI.getInElemTy(SparseLengthsSumNode::LengthsIdx) ==
+                ElemKind::Int32ITy) ||
+           LLVMBackend::isOpSupported(NI);
+
+  case Kinded::Kind::SparseLengthsWeightedSumNodeKind:
+    return (NI.allInputsAndOutputsHaveSameElemKind(
+                {ElemKind::Float16Ty},
+                {SparseLengthsWeightedSumNode::IndicesIdx,
+                 SparseLengthsWeightedSumNode::LengthsIdx}) &&
+            (NI.getInElemTy(SparseLengthsWeightedSumNode::IndicesIdx) ==
+                 ElemKind::Int64ITy ||
+             NI.getInElemTy(SparseLengthsWeightedSumNode::IndicesIdx) ==
+                 ElemKind::Int32ITy) &&
+            NI.getInElemTy(SparseLengthsWeightedSumNode::LengthsIdx) ==
+                ElemKind::Int32ITy) ||
+           LLVMBackend::isOpSupported(NI);
+
+  case Kinded::Kind::EmbeddingBagNodeKind:
+    return (NI.allInputsAndOutputsHaveSameElemKind(
+                {ElemKind::Float16Ty},
+                {EmbeddingBagNode::IndicesIdx, EmbeddingBagNode::OffsetsIdx}) &&
+            NI.getInElemTy(EmbeddingBagNode::IndicesIdx) ==
+                ElemKind::Int32ITy &&
+            NI.getInElemTy(EmbeddingBagNode::OffsetsIdx) ==
+                ElemKind::Int32ITy) ||
+           LLVMBackend::isOpSupported(NI);
+
+  case Kinded::Kind::ConvertToNodeKind:
+    return (NI.getInElemTy(ConvertToNode::InputIdx) == ElemKind::FloatTy &&
+            (NI.getOutElemTy(ConvertToNode::ResultIdx) ==
+                 ElemKind::BFloat16Ty ||
+             NI.getOutElemTy(ConvertToNode::ResultIdx) ==
+                 ElemKind::Float16Ty)) ||
+           ((NI.getInElemTy(ConvertToNode::InputIdx) == ElemKind::BFloat16Ty ||
+             NI.getInElemTy(ConvertToNode::InputIdx) == ElemKind::Float16Ty) &&
+            NI.getOutElemTy(ConvertToNode::ResultIdx) == ElemKind::FloatTy) ||
+           LLVMBackend::isOpSupported(NI);
+
   // Delegate everything else to the LLVM backend.
   default:
     return LLVMBackend::isOpSupported(NI);
@@ -77,7 +257,19 @@ bool CPUBackend::shouldLower(const Node *N) const {
   case Kinded::Kind::FullyConnectedNodeKind:
   case Kinded::Kind::ConvolutionNodeKind:
   case Kinded::Kind::SparseLengthsSumNodeKind:
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind:
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind:
     return false;
+  // Kept whole for the fused libjit kernels, lowered for other types.
+  case Kinded::Kind::GeluNodeKind:
+  case Kinded::Kind::LayerNormalizationNodeKind:
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+  case Kinded::Kind::FusedSGDNodeKind:
+  case Kinded::Kind::LSTMUnitNodeKind:
+    return !NodeInfo(*N).allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy});
+  case Kinded::Kind::BeamSearchStepNodeKind:
+    return !isOpSupported(NodeInfo(*N));
   default:
     return true;
   }
@@ -128,6 +320,34 @@ std::unique_ptr<CompiledFunction> CPUBackend::createCompiledFunction(
                                         std::move(runtimeBundle));
 }
 
+Expected<std::unique_ptr<CompiledFunction>>
+CPUBackend::compile(Function *F, const BackendOptions &opts) const {
+  unsigned numThreads = runtime::flags::CPUIntraOpThreads;
+  auto it = opts.backendSpecificOpts.find(kIntraOpThreadsOpt);
+  if (it != opts.backendSpecificOpts.end()) {
+    int val;
+    ASSIGN_VALUE_OR_RETURN_ERR(val, getIntFromStr(it->second));
+    RETURN_ERR_IF_NOT(val > 0, strFormat("%s must be positive, got %d",
+                                         kIntraOpThreadsOpt, val));
+    numThreads = val;
+  }
+
+  std::unique_ptr<CompiledFunction> compiledFunc;
+  ASSIGN_VALUE_OR_RETURN_ERR(compiledFunc, LLVMBackend::compile(F, opts));
+  static_cast<CPUFunction *>(compiledFunc.get())
+      ->setIntraOpThreads(numThreads);
+  return Expected<std::unique_ptr<CompiledFunction>>(std::move(compiledFunc));
+}
+
+llvm::StringMap<std::string>
+CPUBackend::getSupportedCompiledFunctionOptions() const {
+  llvm::StringMap<std::string> options;
+  options[kIntraOpThreadsOpt] =
+      "Number of threads the kernels of the network may split their work "
+      "across. Defaults to -glow_cpu_intra_op_threads.";
+  return options;
+}
+
 std::unique_ptr<LLVMIRGen>
 CPUBackend::createIRGen(const IRFunction *IR,
                         AllocationsInfo &allocationsInfo) const {
@@ -158,11 +378,22 @@ bool CPUBackend::canDoIndexTypeDemotion(
   return fromTy == ElemKind::Int64ITy && toTy == ElemKind::Int32ITy;
 }
 
+bool CPUBackend::convertsOnlySupportedNodesToFloat16(ElemKind toTy) const {
+  return toTy == ElemKind::BFloat16Ty || toTy == ElemKind::Float16Ty;
+}
+
+MemoryPlanner CPUBackend::getActivationsMemoryPlanner() const {
+  // Unknown names are rejected by the flag validator, keep the default for
+  // them anyway.
+  MemoryPlanner planner = MemoryPlanner::LiveSize;
+  getMemoryPlannerFromName(glow::runtime::flags::CPUMemoryPlanner, planner);
+  return planner;
+}
+
 std::unique_ptr<FunctionPassPipeline>
 CPUBackend::getOptimizationPipeline() const {
   auto pipeline = Backend::getOptimizationPipeline();
-  pipeline->pushFront(
-      {FunctionPassID::ReplaceQuantizedHardSwishWithLookupTable});
+  pipeline->pushFront({FunctionPassID::ReplaceQuantizedUnaryWithLookupTable});
   return pipeline;
 }
 
@@ -71,9 +71,26 @@ public:
   canDoIndexTypeDemotion(ElemKind fromTy, ElemKind toTy,
                          PrecisionConfiguration &precConfig) const override;
 
+  /// The CPU backend only has kernels for a few bfloat16 nodes, the others are
+  /// kept in float.
+  bool convertsOnlySupportedNodesToFloat16(ElemKind toTy) const override;
+
+  /// The CPU backend picks the planner with -glow_cpu_memory_planner.
+  MemoryPlanner getActivationsMemoryPlanner() const override;
+
   llvm::ArrayRef<llvm::MemoryBufferRef> getObjectRegistry() const override;
+
+  Expected<std::unique_ptr<CompiledFunction>>
+  compile(Function *F, const BackendOptions &opts) const override;
+
+  llvm::StringMap<std::string>
+  getSupportedCompiledFunctionOptions() const override;
   /// @}
 
+  /// Name of the backend specific option setting the number of threads the
+  /// kernels of a network may split their work across.
+  static constexpr const char *kIntraOpThreadsOpt = "CPUIntraOpThreads";
+
 public:
   /// @name LLVMBackend methods.
   /// This is the implementation of the LLVMBackend interface.
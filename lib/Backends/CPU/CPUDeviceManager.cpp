@@ -18,8 +18,15 @@
 
 #include "glow/Flags/Flags.h"
 
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <mutex>
+
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 namespace glow {
@@ -30,6 +37,12 @@ static llvm::cl::opt<unsigned, /* ExternalStorage */ true> GlowCPUMemoryOpt(
     llvm::cl::desc("CPU DeviceManager maximum memory in kilobytes."),
     llvm::cl::location(flags::CPUMemory));
 
+/// Serializes the collection of constants across all CPU devices. A compiled
+/// function added to several devices, e.g. the replicas of a saturated host,
+/// has a single RuntimeBundle, so the first device collects its constant
+/// weights and the others reuse them.
+static std::mutex sharedConstantsLock;
+
 DeviceManager *createCPUDeviceManager(const DeviceConfig &config) {
   if (flags::CPUMemory) {
     // Convert command line GlowCPUMemory to bytes from kilobytes.
@@ -40,6 +53,81 @@ DeviceManager *createCPUDeviceManager(const DeviceConfig &config) {
   return new CPUDeviceManager(config);
 }
 
+unsigned CPUDeviceManager::getNumThreads(const DeviceConfig &config) {
+  auto it = config.parameters.find("numThreads");
+  if (it == config.parameters.end()) {
+    return std::max(1u, flags::CPUDeviceThreads);
+  }
+  int numThreads = 0;
+  if (!llvm::to_integer(it->second, numThreads) || numThreads <= 0) {
+    LOG(ERROR) << "Invalid numThreads parameter for CPU device: "
+               << it->second << ", using 1";
+    return 1;
+  }
+  return numThreads;
+}
+
+LargeAllocPolicy
+CPUDeviceManager::getConstantsPolicy(const DeviceConfig &config) {
+  LargeAllocPolicy policy;
+  policy.hugePageMinBytes = flags::CPUHugePageConstantsBytes;
+  policy.explicitHugePages = flags::CPUExplicitHugePages;
+  policy.numaNode = flags::CPUConstantsNumaNode;
+  auto it = config.parameters.find("numaNode");
+  if (it != config.parameters.end() &&
+      (!llvm::to_integer(it->second, policy.numaNode) ||
+       policy.numaNode < -1)) {
+    LOG(ERROR) << "Invalid numaNode parameter for CPU device: " << it->second
+               << ", using no binding";
+    policy.numaNode = -1;
+  }
+  return policy;
+}
+
+std::vector<unsigned> CPUDeviceManager::getCPUSet(const DeviceConfig &config,
+                                                  int numaNode) {
+  std::vector<unsigned> cpus;
+  auto it = config.parameters.find("cpuSet");
+  if (it != config.parameters.end()) {
+    if (!threads::parseCPUList(it->second, cpus)) {
+      LOG(ERROR) << "Invalid cpuSet parameter for CPU device: " << it->second
+                 << ", using any CPU";
+      cpus.clear();
+    }
+    return cpus;
+  }
+  if (numaNode < 0) {
+    return cpus;
+  }
+  std::string path =
+      strFormat("/sys/devices/system/node/node%d/cpulist", numaNode);
+  auto buffer = llvm::MemoryBuffer::getFile(path);
+  if (!buffer || !threads::parseCPUList(buffer.get()->getBuffer(), cpus)) {
+    LOG(ERROR) << "Failed to read the CPUs of NUMA node " << numaNode
+               << ", using any CPU";
+    cpus.clear();
+  }
+  return cpus;
+}
+
+void CPUDeviceManager::pinThreads(const std::vector<unsigned> &cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+  std::atomic<bool> pinned{true};
+  workThread_
+      .runOnAllThreads([&cpus, &pinned]() {
+        if (!threads::setAffinity(cpus)) {
+          pinned = false;
+        }
+      })
+      .wait();
+  if (!pinned) {
+    LOG(ERROR) << "Failed to pin the threads of CPU device "
+               << config_.deviceID;
+  }
+}
+
 uint64_t CPUDeviceManager::getMaximumMemory() const { return maxMemoryBytes_; }
 
 uint64_t CPUDeviceManager::getAvailableMemory() const {
@@ -67,11 +155,13 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
                                       ReadyCBTy readyCB) {
   DCHECK(readyCB != nullptr);
 
+  std::unique_lock<std::shared_timed_mutex> lock(functionsLock_);
   uint64_t allFunctionsMemoryBytes{0};
 
   // First check for uniqueness of the function name.
   for (const auto &func : functions) {
     if (functions_.count(func.first) != 0) {
+      lock.unlock();
       readyCB(
           module,
           MAKE_ERR(
@@ -83,6 +173,7 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
     }
 
     if (func.second->getCompileBackendName() != "CPU") {
+      lock.unlock();
       readyCB(
           module,
           MAKE_ERR(
@@ -98,6 +189,7 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
   }
 
   if (usedMemoryBytes_ + allFunctionsMemoryBytes > maxMemoryBytes_) {
+    lock.unlock();
     readyCB(module,
             MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_OUT_OF_DEVICE_MEMORY,
                      "Failed to add network: not enough memory"));
@@ -106,8 +198,12 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
 
   // Add to the function name lookup map.
   for (const auto &func : functions) {
-    if (func.second->getRuntimeBundle().getConstants() == nullptr) {
-      func.second->getRuntimeBundle().collectConstants(module);
+    {
+      std::lock_guard<std::mutex> constantsLock(sharedConstantsLock);
+      if (func.second->getRuntimeBundle().getConstants() == nullptr) {
+        func.second->getRuntimeBundle().collectConstants(module,
+                                                         constantsPolicy_);
+      }
     }
     functions_.emplace(func.first, func.second);
   }
@@ -117,6 +213,7 @@ void CPUDeviceManager::addNetworkImpl(const Module *module,
 
   // Export change in memory usage.
   exportMemoryCounters();
+  lock.unlock();
 
   // Fire the ready CB.
   readyCB(module, Error::success());
@@ -126,11 +223,13 @@ void CPUDeviceManager::evictNetworkImpl(std::string functionName,
                                         EvictFunctionCBTy evictCB) {
   DCHECK(evictCB != nullptr);
 
+  std::unique_lock<std::shared_timed_mutex> lock(functionsLock_);
   auto it = functions_.find(functionName);
   if (it != functions_.end()) {
     usedMemoryBytes_ -= it->second->getRuntimeBundle().getConstantWeightSize();
     functions_.erase(it);
   } else {
+    lock.unlock();
     evictCB(functionName,
             MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
                      strFormat("Could not find function with name %s to evict",
@@ -139,6 +238,7 @@ void CPUDeviceManager::evictNetworkImpl(std::string functionName,
   }
   // Export change in memory usage.
   exportMemoryCounters();
+  lock.unlock();
 
   evictCB(functionName, Error::success());
 }
@@ -153,8 +253,17 @@ void CPUDeviceManager::runFunctionImpl(
   if (context->getTraceContext()) {
     context->getTraceContext()->setThreadName("CPU DeviceManager");
   }
-  auto funcIt = functions_.find(function);
-  if (funcIt == functions_.end()) {
+  // The function can't be evicted while it's running, so it's safe to use
+  // after the lock is released.
+  CompiledFunction *func = nullptr;
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(functionsLock_);
+    auto funcIt = functions_.find(function);
+    if (funcIt != functions_.end()) {
+      func = funcIt->second;
+    }
+  }
+  if (!func) {
     dmRun.addArg("reason", "function not found");
     TRACE_EVENT_SCOPE_END_NAMED(dmRun);
     resultCB(id,
@@ -164,9 +273,8 @@ void CPUDeviceManager::runFunctionImpl(
     return;
   }
 
-  CompiledFunction *func = funcIt->second;
-
-  // Run that function.
+  // Run that function. CPUFunctions are re-entrant: every run gets its own
+  // activations and mutable weights, so runs on other threads don't clash.
   auto executeErr = func->execute(context.get());
 
   // End the TraceEvent early to avoid time in the CB.
@@ -20,23 +20,54 @@
 #include "glow/Runtime/StatsExporter.h"
 
 #include <atomic>
+#include <shared_mutex>
 
 namespace glow {
 namespace runtime {
 
-/// A class controlling a single CPU thread of execution driving the JIT
-/// backend. Many CPUFunctions may be added, but only one inference is executed
-/// at a time.
+/// A class controlling the CPU threads of execution driving the JIT backend.
+/// Many CPUFunctions may be added, and up to one inference per execution
+/// thread runs at a time. The number of threads is taken from the "numThreads"
+/// device parameter, defaulting to -glow_cpu_device_threads. The constant
+/// weights of the networks are bound to the NUMA node of the "numaNode" device
+/// parameter, defaulting to -glow_cpu_constants_numa_node, and the threads run
+/// on the CPUs of that node or of the "cpuSet" device parameter, a list of
+/// CPUs and CPU ranges such as "0-7,16-23". The activations are first touched
+/// by these threads, so the kernel allocates them on their node.
 class CPUDeviceManager : public QueueBackedDeviceManager {
   /// Compiled function list by name.
   FunctionMapTy functions_;
 
+  /// Protects functions_. Runs take it shared so they can execute
+  /// concurrently, adding and evicting networks takes it exclusively.
+  mutable std::shared_timed_mutex functionsLock_;
+
   /// String constant for logging number of in-use devices.
   static constexpr const char *kDevicesUsedCPU = "glow.devices_used.cpu";
 
+  /// \returns the number of execution threads requested by \p config.
+  static unsigned getNumThreads(const DeviceConfig &config);
+
+  /// \returns the placement of the constant weights requested by \p config.
+  static LargeAllocPolicy getConstantsPolicy(const DeviceConfig &config);
+
+  /// Placement of the constant weights of the networks of this device.
+  const LargeAllocPolicy constantsPolicy_;
+
+  /// \returns the CPUs the threads of the device requested by \p config run
+  /// on, which are the CPUs of the "cpuSet" device parameter, else the CPUs of
+  /// the NUMA node \p numaNode if not negative, else none for any CPU.
+  static std::vector<unsigned> getCPUSet(const DeviceConfig &config,
+                                         int numaNode);
+
+  /// Restricts the threads of the device to run on \p cpus, unless empty.
+  void pinThreads(const std::vector<unsigned> &cpus);
+
 public:
   explicit CPUDeviceManager(const DeviceConfig &config)
-      : QueueBackedDeviceManager(config) {
+      : QueueBackedDeviceManager(config, getNumThreads(config)),
+        constantsPolicy_(getConstantsPolicy(config)) {
+    pinThreads(getCPUSet(config, constantsPolicy_.numaNode));
     statsExporterRegistry_->incrementCounter(kDevicesUsedCPU);
     exportMemoryCounters();
   }
@@ -15,16 +15,89 @@
  */
 #include "CPUFunction.h"
 
+#include "glow/Flags/Flags.h"
 #include "glow/Graph/PlaceholderBindings.h"
 #include "glow/Support/Compiler.h"
 #include "glow/Support/Memory.h"
+#include "glow/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <thread>
 
 using namespace glow;
 
+namespace {
+/// Names of the parallel runtime hooks defined in libjit.
+constexpr const char *kParallelForHookName = "glow_cpu_parallel_for_hook";
+constexpr const char *kParallelThreadsName = "glow_cpu_parallel_threads";
+
+/// Body of a parallel loop in libjit, see libjit_parallel_for.
+using ParallelBodyTy = void (*)(void *ctx, dim_t begin, dim_t end);
+using ParallelForTy = void (*)(dim_t numTasks, unsigned numThreads,
+                               ParallelBodyTy body, void *ctx);
+
+/// \returns the pool of worker threads shared by the kernels of all CPU
+/// functions.
+ThreadPool &getIntraOpThreadPool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()),
+                         "CPUIntraOp");
+  return pool;
+}
+
+/// Host side of libjit_parallel_for. Splits [0, \p numTasks) into up to
+/// \p numThreads contiguous chunks, runs the first one on the calling thread
+/// and the others on the intra-op pool, and returns once all are done.
+void parallelFor(dim_t numTasks, unsigned numThreads, ParallelBodyTy body,
+                 void *ctx) {
+  const dim_t numChunks = std::min<dim_t>(numTasks, numThreads);
+  std::vector<std::future<void>> chunks;
+  chunks.reserve(numChunks - 1);
+  for (dim_t i = 1; i < numChunks; i++) {
+    const dim_t begin = numTasks * i / numChunks;
+    const dim_t end = numTasks * (i + 1) / numChunks;
+    chunks.push_back(getIntraOpThreadPool().submit(
+        [body, ctx, begin, end]() { body(ctx, begin, end); }));
+  }
+  body(ctx, 0, numTasks / numChunks);
+  for (auto &chunk : chunks) {
+    chunk.wait();
+  }
+}
+} // namespace
+
 CPUFunction::CPUFunction(std::unique_ptr<GlowJIT> JIT,
                          runtime::RuntimeBundle &&runtimeBundle)
-    : LLVMCompiledFunction(std::move(JIT), std::move(runtimeBundle)) {}
+    : LLVMCompiledFunction(std::move(JIT), std::move(runtimeBundle)),
+      intraOpThreads_(runtime::flags::CPUIntraOpThreads) {}
+
+Error CPUFunction::installParallelRuntime() {
+  std::lock_guard<std::mutex> lock(JITLock_);
+  if (parallelRuntimeInstalled_) {
+    return Error::success();
+  }
+  // Both hooks are defined in libjit, so they are only missing if libjit
+  // wasn't linked in; the code then has no parallel kernels either.
+  auto hookSym = JIT_->findSymbol(kParallelForHookName);
+  auto threadsSym = JIT_->findSymbol(kParallelThreadsName);
+  if (hookSym && threadsSym) {
+    auto hookAddr = hookSym.getAddress();
+    auto threadsAddr = threadsSym.getAddress();
+    if (!hookAddr || !threadsAddr) {
+      llvm::Error err =
+          llvm::joinErrors(hookAddr.takeError(), threadsAddr.takeError());
+      return MAKE_ERR(strFormat("Failed to get parallel runtime address: %s",
+                                llvm::toString(std::move(err)).data()));
+    }
+    *reinterpret_cast<ParallelForTy *>(hookAddr.get()) = &parallelFor;
+    *reinterpret_cast<unsigned *>(threadsAddr.get()) = intraOpThreads_;
+  }
+  parallelRuntimeInstalled_ = true;
+  return Error::success();
+}
 
 Error CPUFunction::execute(ExecutionContext *context) {
+  if (!parallelRuntimeInstalled_) {
+    RETURN_IF_ERR(installParallelRuntime());
+  }
   return LLVMCompiledFunction::execute(context);
 }
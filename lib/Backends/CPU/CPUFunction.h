@@ -23,6 +23,8 @@
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Backend/CompiledFunction.h"
 
+#include <atomic>
+
 namespace glow {
 /// A Glow IR function compiled for the CPU using LLVM.
 class CPUFunction final : public LLVMCompiledFunction {
@@ -39,6 +41,24 @@ public:
   virtual std::string getCompileBackendName() const override { return "CPU"; }
   ///@}
   //
+
+  /// Sets the number of threads the kernels of this function may split their
+  /// work across to \p numThreads. Must be called before the first execute().
+  void setIntraOpThreads(unsigned numThreads) { intraOpThreads_ = numThreads; }
+
+  /// \returns the number of threads the kernels of this function may use.
+  unsigned getIntraOpThreads() const { return intraOpThreads_; }
+
+private:
+  /// Points the parallel runtime hooks in the JIT'd code at the host's
+  /// intra-op thread pool.
+  Error installParallelRuntime();
+
+  /// Number of threads kernels may split their work across; 1 is serial.
+  unsigned intraOpThreads_;
+
+  /// Whether installParallelRuntime() already ran. Set under JITLock_.
+  std::atomic<bool> parallelRuntimeInstalled_{false};
 };
 } // end namespace glow
 
@@ -16,10 +16,14 @@
 
 #include "CPULLVMIRGen.h"
 
+#include "glow/Flags/Flags.h"
 #include "glow/IR/Instrs.h"
 #include "glow/LLVMIRCodeGen/LLVMBackend.h"
 #include "glow/Quantization/Base/Base.h"
 
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/Target/TargetMachine.h"
+
 using namespace glow;
 using llvm::cast;
 
@@ -34,6 +38,33 @@ CPULLVMIRGen::CPULLVMIRGen(const IRFunction *F,
                            llvm::ArrayRef<llvm::MemoryBufferRef> objectRegistry)
     : LLVMIRGen(F, allocationsInfo, mainEntryName, libjitBC, objectRegistry) {}
 
+bool CPULLVMIRGen::canBePartOfDataParallelKernel(
+    const glow::Instruction *I) const {
+  // Int8 lookup tables are mapped by a vectorized libjit kernel rather than
+  // one element at a time in the data parallel loops.
+  if (auto *LT = llvm::dyn_cast<IntLookupTableInst>(I)) {
+    if (LT->getDest()->getElementType() == ElemKind::Int8QTy) {
+      return false;
+    }
+  }
+  return LLVMIRGen::canBePartOfDataParallelKernel(I);
+}
+
+std::string CPULLVMIRGen::getLookupTableKernelName() const {
+  auto arch = TM_->getTargetTriple().getArch();
+  if (arch != llvm::Triple::x86 && arch != llvm::Triple::x86_64) {
+    return "intlookuptable";
+  }
+  const llvm::MCSubtargetInfo *STI = TM_->getMCSubtargetInfo();
+  if (!STI->checkFeatures("+avx512bw,+avx512vbmi")) {
+    return "intlookuptable";
+  }
+  // libjit only provides the VBMI kernel when built for x86.
+  return llmodule_->getFunction("libjit_intlookuptable_vbmi_i8")
+             ? "intlookuptable_vbmi"
+             : "intlookuptable";
+}
+
 void CPULLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
   // TODO: Add here any backend specific logic.
   LLVMIRGen::generateLLVMIRForModule(builder);
@@ -117,6 +148,234 @@ void CPULLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
                 depthStripsVal});
     break;
   }
+  case Kinded::Kind::CPUConvWinogradInstKind: {
+    auto *CI = cast<CPUConvWinogradInst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *bias = CI->getBias();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *pads = emitConstDimTArray(builder, CI->getPads());
+
+    auto *F = getFunction("conv_winograd", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims, pads});
+    break;
+  }
+  case Kinded::Kind::CPUConvIm2ColInstKind: {
+    auto *CI = cast<CPUConvIm2ColInst>(I);
+    auto *dest = CI->getDest();
+    auto *src = CI->getSrc();
+    auto *filter = CI->getFilter();
+    auto *bias = CI->getBias();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *filterPtr = emitValueAddress(builder, filter);
+    auto *biasPtr = emitValueAddress(builder, bias);
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+    auto *kernels = emitConstDimTArray(builder, CI->getKernels());
+    auto *strides = emitConstDimTArray(builder, CI->getStrides());
+    auto *pads = emitConstDimTArray(builder, CI->getPads());
+    auto *dilation = emitConstDimTArray(builder, CI->getDilation());
+
+    auto *F = getFunction("conv_im2col", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
+                kernels, strides, pads, dilation});
+    break;
+  }
+  case Kinded::Kind::CPUFullyConnectedPackedInstKind: {
+    auto *FCI = cast<CPUFullyConnectedPackedInst>(I);
+    auto *dest = FCI->getDest();
+    auto *src = FCI->getSrc();
+    auto *weights = FCI->getWeights();
+    auto *colTerms = FCI->getColTerms();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *weightsPtr = emitValueAddress(builder, weights);
+    auto *colTermsPtr = emitValueAddress(builder, colTerms);
+    auto *destDims = emitValueDims(builder, dest);
+    auto *srcDims = emitValueDims(builder, src);
+
+    auto *destTy = dest->getType();
+    auto *weightsTy = weights->getType();
+
+    // The input and bias offsets are folded into the column terms. The packed
+    // weights are stored as w + 128, pass the offset of the original weights.
+    auto *destOffset = emitConstI32(builder, destTy->getOffset());
+    auto *weightsOffset = emitConstI32(builder, weightsTy->getOffset() - 128);
+
+    float matMulScale = src->getType()->getScale() * weightsTy->getScale();
+    auto outScaleParam = quantization::quantizeScaleOffset32To8(
+        matMulScale / destTy->getScale(), 0);
+    auto *outPre = emitConstI32(builder, outScaleParam.pre);
+    auto *outPost = emitConstI32(builder, outScaleParam.post);
+    auto *outScale = emitConstI32(builder, outScaleParam.scale);
+
+    auto kernelName = getInt8KernelName("fc_packed", {ElemKind::Int8QTy});
+    auto *F = getFunction(kernelName, ElemKind::Int8QTy);
+    createCall(builder, F,
+               {destPtr, srcPtr, weightsPtr, colTermsPtr, destDims, srcDims,
+                destOffset, weightsOffset, outPre, outPost, outScale});
+    break;
+  }
+  case Kinded::Kind::CPUFullyConnectedSparseInstKind: {
+    auto *FCI = cast<CPUFullyConnectedSparseInst>(I);
+    auto *dest = FCI->getDest();
+    auto *src = FCI->getSrc();
+    auto *F = getFunction("fc_sparse", dest->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, dest), emitValueAddress(builder, src),
+                emitValueAddress(builder, FCI->getValues()),
+                emitValueAddress(builder, FCI->getBlockRows()),
+                emitValueAddress(builder, FCI->getBlockPtr()),
+                emitValueAddress(builder, FCI->getBias()),
+                emitConstDimT(builder, src->dims()[0]),
+                emitConstDimT(builder, src->dims()[1]),
+                emitConstDimT(builder, dest->dims()[1])});
+    break;
+  }
+  case Kinded::Kind::IntNBitSplitEmbeddingBagsInstKind:
+  case Kinded::Kind::IntNBitSplitEmbeddingWeightedBagsInstKind: {
+    // Both instructions share their operands apart from the indice weights,
+    // which are null for the unweighted one.
+    auto emitTBE = [&](const auto *TBE, llvm::Value *indiceWeightsPtr) {
+      auto *dest = TBE->getDest();
+      auto *weightsOffsets = TBE->getWeightsOffsets();
+      dim_t numTables = TBE->getDimOffsets()->size() - 1;
+      dim_t numBatches = (TBE->getOffsets()->size() - 1) / numTables;
+      bool meanPooling =
+          TBE->getPoolingMode() == SplitEmbeddingPoolingMode::EP_MEAN;
+      auto *F = getFunction("int_nbit_split_embedding_bags",
+                            {dest->getElementType(),
+                             weightsOffsets->getElementType()});
+      createCall(
+          builder, F,
+          {emitValueAddress(builder, dest),
+           emitValueAddress(builder, TBE->getDevWeights()),
+           emitValueAddress(builder, TBE->getUvmWeights()),
+           emitValueAddress(builder, TBE->getWeightsPlacements()),
+           emitValueAddress(builder, weightsOffsets),
+           emitValueAddress(builder, TBE->getWeightsTys()),
+           emitValueAddress(builder, TBE->getDimOffsets()),
+           emitValueAddress(builder, TBE->getIndices()),
+           emitValueAddress(builder, TBE->getOffsets()), indiceWeightsPtr,
+           emitConstDimT(builder, numTables),
+           emitConstDimT(builder, numBatches),
+           emitConstDimT(builder, dest->dims()[1]),
+           emitConstI1(builder, meanPooling),
+           emitConstI1(builder, glow::flags::ConvertFusedScaleOffsetToFP32),
+           emitConstI32(builder, runtime::flags::CPURowAlignmentBytes)});
+    };
+    if (auto *TBE = llvm::dyn_cast<IntNBitSplitEmbeddingBagsInst>(I)) {
+      emitTBE(TBE, llvm::ConstantPointerNull::get(
+                       builder.getFloatTy()->getPointerTo()));
+    } else {
+      auto *TWBE = cast<IntNBitSplitEmbeddingWeightedBagsInst>(I);
+      emitTBE(TWBE, emitValueAddress(builder, TWBE->getIndiceWeight()));
+    }
+    break;
+  }
+
+  case Kinded::Kind::ScaledDotProductAttentionInstKind: {
+    auto *SDPA = cast<ScaledDotProductAttentionInst>(I);
+    auto *dest = SDPA->getDest();
+    auto *query = SDPA->getQuery();
+    auto *key = SDPA->getKey();
+    auto *value = SDPA->getValues();
+    auto *mask = SDPA->getMask();
+    auto *F =
+        getFunction("scaled_dot_product_attention", dest->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, dest),
+                emitValueAddress(builder, query),
+                emitValueAddress(builder, key),
+                emitValueAddress(builder, value),
+                emitValueAddress(builder, mask), emitValueDims(builder, mask),
+                emitConstDimT(builder, query->dims()[0]),
+                emitConstDimT(builder, query->dims()[1]),
+                emitConstDimT(builder, key->dims()[1]),
+                emitConstDimT(builder, query->dims()[2]),
+                emitConstDimT(builder, value->dims()[2]),
+                emitConstF32(builder, SDPA->getScale())});
+    break;
+  }
+
+  case Kinded::Kind::DynamicQuantizedFullyConnectedInstKind: {
+    auto *FC = cast<DynamicQuantizedFullyConnectedInst>(I);
+    auto *dest = FC->getDest();
+    auto *src = FC->getSrc();
+    auto *weights = FC->getWeights();
+    auto *F = getFunction("dynamic_quantized_fc", dest->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, dest), emitValueAddress(builder, src),
+                emitValueAddress(builder, weights),
+                emitValueAddress(builder, FC->getBias()),
+                emitConstDimT(builder, src->dims()[0]),
+                emitConstDimT(builder, src->dims()[1]),
+                emitConstDimT(builder, dest->dims()[1]),
+                emitConstF32(builder, weights->getType()->getScale()),
+                emitConstI32(builder, weights->getType()->getOffset())});
+    break;
+  }
+
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedInstKind: {
+    auto *FC = cast<Int4GroupwiseQuantizedFullyConnectedInst>(I);
+    auto *dest = FC->getDest();
+    auto *src = FC->getSrc();
+    auto *F = getFunction("int4_groupwise_fc", dest->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, dest), emitValueAddress(builder, src),
+                emitValueAddress(builder, FC->getWeights()),
+                emitValueAddress(builder, FC->getScales()),
+                emitValueAddress(builder, FC->getOffsets()),
+                emitValueAddress(builder, FC->getBias()),
+                emitConstDimT(builder, src->dims()[0]),
+                emitConstDimT(builder, src->dims()[1]),
+                emitConstDimT(builder, dest->dims()[1]),
+                emitConstDimT(builder, FC->getGroupSize())});
+    break;
+  }
+
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumInstKind: {
+    auto *PQ = cast<ProductQuantizedSparseLengthsWeightedSumInst>(I);
+    auto *dest = PQ->getDest();
+    auto *codebooks = PQ->getCodebooks();
+    auto *indices = PQ->getIndices();
+    auto *lengths = PQ->getLengths();
+    auto *F = getFunction("product_quantized_sparse_lengths_weighted_sum",
+                          {dest->getElementType(), indices->getElementType()});
+    createCall(builder, F,
+               {emitValueAddress(builder, dest),
+                emitValueAddress(builder, PQ->getCodes()),
+                emitValueAddress(builder, codebooks),
+                emitValueAddress(builder, PQ->getWeights()),
+                emitValueAddress(builder, indices),
+                emitValueAddress(builder, lengths),
+                emitConstDimT(builder, lengths->dims()[0]),
+                emitConstDimT(builder, codebooks->dims()[0]),
+                emitConstDimT(builder, codebooks->dims()[1]),
+                emitConstDimT(builder, codebooks->dims()[2])});
+    break;
+  }
+
+  case Kinded::Kind::IntLookupTableInstKind: {
+    auto *LT = cast<IntLookupTableInst>(I);
+    auto *dest = LT->getDest();
+    auto *F = getFunction(getLookupTableKernelName(), dest->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, dest),
+                emitValueAddress(builder, LT->getSrc()),
+                emitValueAddress(builder, LT->getMapping()),
+                emitConstDimT(builder, dest->size())});
+    break;
+  }
   default:
     LLVMIRGen::generateLLVMIRForInstr(builder, I);
   }
@@ -48,6 +48,14 @@ public:
       llvm::Value *loopCount) override;
   /// Emit LLVM-IR for the whole IRFunction.
   virtual void generateLLVMIRForModule(llvm::IRBuilder<> &builder) override;
+  /// \returns true if \p I can be part of a data parallel kernel.
+  virtual bool
+  canBePartOfDataParallelKernel(const glow::Instruction *I) const override;
+
+private:
+  /// \returns the name of the libjit kernel of the int8 lookup tables, using
+  /// the AVX512-VBMI byte permutations when the target supports them.
+  std::string getLookupTableKernelName() const;
 };
 
 } // namespace glow
@@ -34,6 +34,41 @@ BB.newBackendSpecificInstr("CPUConvDKKC8")
     .addMember(MemberType::Unsigned, "Group")
     .autoIRGen();
 
+BB.newBackendSpecificInstr("CPUConvWinograd")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUConvIm2Col")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Filter", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::VectorUnsigned, "Dilation")
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUFullyConnectedPacked")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Weights", OperandKind::In)
+    .addOperand("ColTerms", OperandKind::In)
+    .autoIRGen();
+
+BB.newBackendSpecificInstr("CPUFullyConnectedSparse")
+    .addOperand("Dest", OperandKind::Out)
+    .addOperand("Src", OperandKind::In)
+    .addOperand("Values", OperandKind::In)
+    .addOperand("BlockRows", OperandKind::In)
+    .addOperand("BlockPtr", OperandKind::In)
+    .addOperand("Bias", OperandKind::In)
+    .autoIRGen();
+
 BB.includeBackendSpecificVerification("glow/CPUSpecificInstrsVerification.h");
 
 #endif // GLOW_WITH_CPU
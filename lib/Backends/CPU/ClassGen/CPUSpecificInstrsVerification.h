@@ -33,4 +33,71 @@ void CPUConvDKKC8Inst::verify() const {
          "Invalid Element Type");
 }
 
+void CPUConvWinogradInst::verify() const {
+  assert(getFilter()->dims()[0] == 36 && "Invalid transformed filter");
+  assert(getFilter()->dims()[1] == getSrc()->dims()[3] &&
+         "Invalid transformed filter");
+  assert(getFilter()->dims()[2] == getDest()->dims()[3] &&
+         "Invalid transformed filter");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+}
+
+void CPUConvIm2ColInst::verify() const {
+  assert(getFilter()->dims()[0] ==
+             getKernels()[0] * getKernels()[1] * getSrc()->dims()[3] &&
+         "Invalid transposed filter");
+  assert(getFilter()->dims()[1] == getDest()->dims()[3] &&
+         "Invalid transposed filter");
+  assert(getDest()->getElementType() == getSrc()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getFilter()->getElementType() &&
+         "Invalid Element Type");
+  assert(getDest()->getElementType() == getBias()->getElementType() &&
+         "Invalid Element Type");
+}
+
+void CPUFullyConnectedPackedInst::verify() const {
+  assert(getSrc()->dims()[0] == getDest()->dims()[0] &&
+         "Mismatching batch size");
+  assert(getWeights()->dims()[0] == (getDest()->dims()[1] + 15) / 16 &&
+         "Invalid packed weights column blocks");
+  assert(getWeights()->dims()[1] == (getSrc()->dims()[1] + 3) / 4 &&
+         "Invalid packed weights depth");
+  assert(getDest()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getSrc()->getElementType() == ElemKind::Int8QTy &&
+         "Invalid Element Type");
+  assert(getWeights()->getElementType() == ElemKind::UInt8QTy &&
+         "Invalid Element Type");
+  assert(getColTerms()->getElementType() == ElemKind::Int32ITy &&
+         "Invalid Element Type");
+}
+
+void CPUFullyConnectedSparseInst::verify() const {
+  assert(getSrc()->dims()[0] == getDest()->dims()[0] &&
+         "Mismatching batch size");
+  assert(getValues()->dims()[1] == 8 && "Invalid block size");
+  assert(getBlockRows()->dims()[0] == getValues()->dims()[0] &&
+         "Invalid block rows");
+  assert(getBlockPtr()->dims()[0] == (getDest()->dims()[1] + 7) / 8 + 1 &&
+         "Invalid block pointers");
+  assert(getDest()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getSrc()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getValues()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+  assert(getBlockRows()->getElementType() == ElemKind::Int32ITy &&
+         "Invalid Element Type");
+  assert(getBlockPtr()->getElementType() == ElemKind::Int32ITy &&
+         "Invalid Element Type");
+  assert(getBias()->getElementType() == ElemKind::FloatTy &&
+         "Invalid Element Type");
+}
+
 #endif // GLOW_WITH_CPU
@@ -33,6 +33,53 @@ BB.newBackendSpecificNode("CPUConvDKKC8")
     .setDocstring("This is a cpu-specific convolution implementation where the "
                   "filter is transposed to the shape [D/8, K, K, C, 8]");
 
+BB.newBackendSpecificNode("CPUConvWinograd")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific 3x3 stride-1 convolution using "
+                  "Winograd F(4x4, 3x3), where the filter is transformed "
+                  "ahead of time to the shape [36, C, D]");
+
+BB.newBackendSpecificNode("CPUConvIm2Col")
+    .addInput("Input")
+    .addInput("Filter")
+    .addInput("Bias")
+    .addMember(MemberType::VectorUnsigned, "Kernels")
+    .addMember(MemberType::VectorUnsigned, "Strides")
+    .addMember(MemberType::VectorUnsigned, "Pads")
+    .addMember(MemberType::VectorUnsigned, "Dilation")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific convolution computed as a matrix "
+                  "product of the im2col input with the filter transposed "
+                  "ahead of time to the shape [K * K * C, D]");
+
+BB.newBackendSpecificNode("CPUFullyConnectedPacked")
+    .addInput("Input")
+    .addInput("Weights")
+    .addInput("ColTerms")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific int8 FullyConnected whose constant "
+                  "weights are packed ahead of time as uint8 in the shape "
+                  "[N/16, K/4, 16, 4], and whose bias and offset terms are "
+                  "folded into the int32 per-column ColTerms");
+
+BB.newBackendSpecificNode("CPUFullyConnectedSparse")
+    .addInput("Input")
+    .addInput("Values")
+    .addInput("BlockRows")
+    .addInput("BlockPtr")
+    .addInput("Bias")
+    .addResultFromCtorArg()
+    .setDocstring("This is a cpu-specific float FullyConnected whose constant "
+                  "weights {K, N} are stored ahead of time as the non-zero "
+                  "1x8 blocks of 8 consecutive output columns of a row: for "
+                  "the output columns [8 * b, 8 * b + 8), the blocks "
+                  "[BlockPtr[b], BlockPtr[b + 1]) hold the weights of the "
+                  "rows BlockRows[p] in Values[p]");
+
 BB.includeBackendSpecificVerification("glow/CPUSpecificNodesVerification.h");
 
 #endif // GLOW_WITH_CPU
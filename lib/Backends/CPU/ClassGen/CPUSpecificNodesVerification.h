@@ -30,4 +30,87 @@ bool CPUConvDKKC8Node::verify() const {
   return expectCompareTrue("Invalid output dimensions", exp, odim, this);
 }
 
+bool CPUConvWinogradNode::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(idim.h, idim.w, {3, 3}, {1, 1},
+                                           getPads());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, getBias().dims()[0]);
+  bool isValid =
+      expectCompareTrue("Invalid output dimensions", exp, odim, this);
+  const dim_t filterDims[] = {36, idim.c, odim.c};
+  isValid &= expectCompareTrue("Invalid transformed filter dimensions",
+                               getFilter().dims(),
+                               llvm::makeArrayRef(filterDims), this);
+  return isValid;
+}
+
+bool CPUConvIm2ColNode::verify() const {
+  ShapeNHWC idim(getInput().getType()->dims());
+  ShapeNHWC odim(getResult().getType()->dims());
+  auto outSz = calculateConvPoolOutputDims(
+      idim.h, idim.w, getKernels(), getStrides(), getPads(), getDilation());
+  ShapeNHWC exp(idim.n, outSz.first, outSz.second, getBias().dims()[0]);
+  bool isValid =
+      expectCompareTrue("Invalid output dimensions", exp, odim, this);
+  const dim_t filterDims[] = {getKernels()[0] * getKernels()[1] * idim.c,
+                              odim.c};
+  isValid &= expectCompareTrue("Invalid transposed filter dimensions",
+                               getFilter().dims(),
+                               llvm::makeArrayRef(filterDims), this);
+  return isValid;
+}
+
+bool CPUFullyConnectedPackedNode::verify() const {
+  auto idim = getInput().dims();
+  auto wdim = getWeights().dims();
+  auto odim = getResult().dims();
+  bool isValid = expectCompareTrue("Input must be 2D", idim.size(), size_t(2),
+                                   this) &&
+                 expectCompareTrue("Weights must be 4D", wdim.size(),
+                                   size_t(4), this) &&
+                 expectCompareTrue("Result must be 2D", odim.size(), size_t(2),
+                                   this);
+  if (!isValid) {
+    return false;
+  }
+  isValid &= expectCompareTrue("Mismatching batch size", idim[0], odim[0],
+                               this);
+  isValid &= expectCompareTrue("Invalid packed weights column blocks",
+                               wdim[0], (odim[1] + 15) / 16, this);
+  isValid &= expectCompareTrue("Invalid packed weights depth", wdim[1],
+                               (idim[1] + 3) / 4, this);
+  isValid &= expectCompareTrue("Invalid packed weights block",
+                               wdim[2] * wdim[3], dim_t(64), this);
+  isValid &= expectCompareTrue("Invalid column terms size",
+                               getColTerms().dims()[0], wdim[0] * 16, this);
+  return isValid;
+}
+
+bool CPUFullyConnectedSparseNode::verify() const {
+  auto idim = getInput().dims();
+  auto vdim = getValues().dims();
+  auto odim = getResult().dims();
+  bool isValid = expectCompareTrue("Input must be 2D", idim.size(), size_t(2),
+                                   this) &&
+                 expectCompareTrue("Values must be 2D", vdim.size(),
+                                   size_t(2), this) &&
+                 expectCompareTrue("Result must be 2D", odim.size(), size_t(2),
+                                   this);
+  if (!isValid) {
+    return false;
+  }
+  isValid &= expectCompareTrue("Mismatching batch size", idim[0], odim[0],
+                               this);
+  isValid &= expectCompareTrue("Invalid block size", vdim[1], dim_t(8), this);
+  isValid &= expectCompareTrue("Invalid block rows size",
+                               getBlockRows().dims()[0], vdim[0], this);
+  isValid &= expectCompareTrue("Invalid block pointers size",
+                               getBlockPtr().dims()[0], (odim[1] + 7) / 8 + 1,
+                               this);
+  isValid &= expectCompareTrue("Invalid bias size", getBias().dims()[0],
+                               odim[1], this);
+  return isValid;
+}
+
 #endif // GLOW_WITH_CPU
@@ -34,3 +34,36 @@ Error ONNXModelWriter::writeCPUConvDKKC8(const CPUConvDKKC8Node *node,
 
   return writeAllWithNode("CPUConvDKKC8", node, graph, proto);
 }
+
+Error ONNXModelWriter::writeCPUConvWinograd(const CPUConvWinogradNode *node,
+                                            GraphType &graph) {
+  auto *proto = graph.add_node();
+  // Add dictionary entries.
+  addValueAttribute(proto, "pads", node->getPads());
+
+  return writeAllWithNode("CPUConvWinograd", node, graph, proto);
+}
+
+Error ONNXModelWriter::writeCPUConvIm2Col(const CPUConvIm2ColNode *node,
+                                          GraphType &graph) {
+  auto *proto = graph.add_node();
+  // Add dictionary entries.
+  addValueAttribute(proto, "kernel_shape", node->getKernels());
+  addValueAttribute(proto, "strides", node->getStrides());
+  addValueAttribute(proto, "pads", node->getPads());
+  addValueAttribute(proto, "dilation", node->getDilation());
+
+  return writeAllWithNode("CPUConvIm2Col", node, graph, proto);
+}
+
+Error ONNXModelWriter::writeCPUFullyConnectedPacked(
+    const CPUFullyConnectedPackedNode *node, GraphType &graph) {
+  auto *proto = graph.add_node();
+  return writeAllWithNode("CPUFullyConnectedPacked", node, graph, proto);
+}
+
+Error ONNXModelWriter::writeCPUFullyConnectedSparse(
+    const CPUFullyConnectedSparseNode *node, GraphType &graph) {
+  auto *proto = graph.add_node();
+  return writeAllWithNode("CPUFullyConnectedSparse", node, graph, proto);
+}
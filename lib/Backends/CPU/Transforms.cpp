@@ -16,8 +16,11 @@
 
 #include "CPUBackend.h"
 
+#include "glow/Flags/Flags.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Nodes.h"
+#include "glow/Optimizer/GraphOptimizer/NodeSplitting.h"
+#include "glow/Quantization/Base/Base.h"
 
 using namespace glow;
 using llvm::dyn_cast;
@@ -90,6 +93,304 @@ static Node *optimizeCPUConv(ConvolutionNode *CN, Function *F) {
       CN->getBias(), CN->getKernels(), CN->getStrides(), CN->getPads(), group));
 }
 
+/// Try to replace a 3x3 stride-1 float Convolution by a CPUConvWinograd node,
+/// which computes 4x4 output tiles with Winograd F(4x4, 3x3), using 36
+/// instead of 144 multiplications per tile and channel pair, see
+/// libjit_conv_winograd_f. The 3x3 filter g of every pair of output channel d
+/// and input channel c is transformed ahead of time to U = G * g * GT, stored
+/// in the layout [36, C, D].
+static Node *
+optimizeCPUWinogradConv(ConvolutionNode *CN, Function *F,
+                        llvm::DenseMap<Constant *, Constant *> &filters) {
+  if (!glow::runtime::flags::CPUWinogradConv || CN->hasFusedActivation() ||
+      CN->getLayout() != NHWC || CN->getGroup() != 1) {
+    return nullptr;
+  }
+  auto isOne = [](unsigned_t i) { return i == 1; };
+  auto isThree = [](unsigned_t i) { return i == 3; };
+  if (!std::all_of(CN->getKernels().begin(), CN->getKernels().end(),
+                   isThree) ||
+      !std::all_of(CN->getStrides().begin(), CN->getStrides().end(), isOne) ||
+      !std::all_of(CN->getDilation().begin(), CN->getDilation().end(),
+                   isOne)) {
+    return nullptr;
+  }
+
+  Constant *filter = dyn_cast<Constant>(CN->getFilter());
+  if (!filter || filter->getElementType() != ElemKind::FloatTy ||
+      CN->getInput().getElementType() != ElemKind::FloatTy ||
+      CN->getBias().getElementType() != ElemKind::FloatTy) {
+    return nullptr;
+  }
+
+  // The matrix products of the transformed tiles are too small to pay off
+  // with few channels.
+  auto dims = filter->dims();
+  dim_t D = dims[0];
+  dim_t C = dims[3];
+  if (C < 16 || D < 16) {
+    return nullptr;
+  }
+
+  // Winograd F(4x4, 3x3) filter transform matrix.
+  const double G[6][3] = {{1. / 4, 0, 0},
+                          {-1. / 6, -1. / 6, -1. / 6},
+                          {-1. / 6, 1. / 6, -1. / 6},
+                          {1. / 24, 1. / 12, 1. / 6},
+                          {1. / 24, -1. / 12, 1. / 6},
+                          {0, 0, 1}};
+  // The chunks of a split convolution share the transformed filter.
+  Constant *&filterT = filters[filter];
+  if (filterT) {
+    return F->addNode(new CPUConvWinogradNode(CN->getName(),
+                                              CN->getResult().getType(),
+                                              CN->getInput(), filterT,
+                                              CN->getBias(), CN->getPads()));
+  }
+  auto *M = F->getParent();
+  filterT = M->createConstant(ElemKind::FloatTy, {36, C, D},
+                              filter->getName().str() + "_winograd");
+  auto FH = filter->getPayload().getHandle<float>();
+  auto TH = filterT->getPayloadMutable().getHandle<float>();
+  for (dim_t d = 0; d < D; d++) {
+    for (dim_t c = 0; c < C; c++) {
+      // U = G * g * GT.
+      double Gg[6][3];
+      for (dim_t i = 0; i < 6; i++) {
+        for (dim_t j = 0; j < 3; j++) {
+          Gg[i][j] = 0;
+          for (dim_t k = 0; k < 3; k++) {
+            Gg[i][j] += G[i][k] * FH.at({d, k, j, c});
+          }
+        }
+      }
+      for (dim_t i = 0; i < 6; i++) {
+        for (dim_t j = 0; j < 6; j++) {
+          double u = 0;
+          for (dim_t k = 0; k < 3; k++) {
+            u += Gg[i][k] * G[j][k];
+          }
+          TH.at({i * 6 + j, c, d}) = float(u);
+        }
+      }
+    }
+  }
+
+  return F->addNode(new CPUConvWinogradNode(CN->getName(),
+                                            CN->getResult().getType(),
+                                            CN->getInput(), filterT,
+                                            CN->getBias(), CN->getPads()));
+}
+
+/// Try to replace a float Convolution with group 1 by a CPUConvIm2Col node,
+/// which computes it as the matrix product of the im2col input with the
+/// filter, see libjit_conv_im2col_f. The filter [D, KH, KW, C] is transposed
+/// ahead of time to [KH * KW * C, D]. This is profitable as soon as there are
+/// enough output channels and enough values in each input window to fill the
+/// vectors of the matrix product, which covers 1x1 and large-channel
+/// convolutions where the direct loop nest is slowest.
+static Node *
+optimizeCPUIm2ColConv(ConvolutionNode *CN, Function *F,
+                      llvm::DenseMap<Constant *, Constant *> &filters) {
+  if (!glow::runtime::flags::CPUIm2ColConv || CN->hasFusedActivation() ||
+      CN->getLayout() != NHWC || CN->getGroup() != 1) {
+    return nullptr;
+  }
+
+  Constant *filter = dyn_cast<Constant>(CN->getFilter());
+  if (!filter || filter->getElementType() != ElemKind::FloatTy ||
+      CN->getInput().getElementType() != ElemKind::FloatTy ||
+      CN->getBias().getElementType() != ElemKind::FloatTy) {
+    return nullptr;
+  }
+
+  auto dims = filter->dims();
+  dim_t D = dims[0];
+  dim_t rowSize = dims[1] * dims[2] * dims[3];
+  if (D < 16 || rowSize < 16) {
+    return nullptr;
+  }
+
+  // The chunks of a split convolution share the transposed filter.
+  Constant *&filterT = filters[filter];
+  if (!filterT) {
+    auto *M = F->getParent();
+    filterT = M->createConstant(ElemKind::FloatTy, {rowSize, D},
+                                filter->getName().str() + "_im2col");
+    auto FH = filter->getPayload().getHandle<float>();
+    auto TH = filterT->getPayloadMutable().getHandle<float>();
+    for (dim_t d = 0; d < D; d++) {
+      for (dim_t k = 0; k < rowSize; k++) {
+        TH.at({k, d}) = FH.raw(d * rowSize + k);
+      }
+    }
+  }
+
+  return F->addNode(new CPUConvIm2ColNode(
+      CN->getName(), CN->getResult().getType(), CN->getInput(), filterT,
+      CN->getBias(), CN->getKernels(), CN->getStrides(), CN->getPads(),
+      CN->getDilation()));
+}
+
+/// Try to replace an int8 FullyConnected, or an int8 2D MatMul, with constant
+/// weights by a CPUFullyConnectedPacked node. The weights {K, N} are packed
+/// ahead of time as uint8 (w + 128) in the layout [N/16, K/4, 16, 4] used by
+/// the libjit packed int8 GEMM, so that the kernel doesn't repack them on every
+/// call. The bias, the input offset and the weights offset only depend on the
+/// column, and are folded into the per-column int32 ColTerms:
+///   K * inOffset * wOffset - inOffset * colSum(w) + scaledBias.
+/// \p input, \p weights and \p bias are the operands of \p N, \p bias may be
+/// null.
+static Node *optimizeCPUInt8FC(Node *N, NodeValue input, NodeValue weights,
+                               NodeValue bias, Function *F) {
+  auto *M = F->getParent();
+  TypeRef outTy = N->getNthResult(0).getType();
+  if (input.getElementType() != ElemKind::Int8QTy ||
+      weights.getElementType() != ElemKind::Int8QTy ||
+      outTy->getElementType() != ElemKind::Int8QTy ||
+      input.dims().size() != 2 || weights.dims().size() != 2) {
+    return nullptr;
+  }
+
+  Constant *W = dyn_cast<Constant>(weights);
+  if (!W) {
+    return nullptr;
+  }
+  Constant *B = bias.getNode() ? dyn_cast<Constant>(bias) : nullptr;
+  if (bias.getNode() && (!B || (B->getElementType() != ElemKind::Int8QTy &&
+                                B->getElementType() != ElemKind::Int32QTy))) {
+    return nullptr;
+  }
+
+  dim_t K = weights.dims()[0];
+  dim_t numCols = weights.dims()[1];
+  dim_t colBlocks = (numCols + 15) / 16;
+  dim_t depthBlocks = (K + 3) / 4;
+  int32_t inOffset = input.getType()->getOffset();
+  int32_t wOffset = W->getType()->getOffset();
+  float matMulScale = input.getType()->getScale() * W->getType()->getScale();
+
+  // Packed weights keep the scale of the original weights, the offset moves
+  // with the values.
+  auto *packedW = M->createConstant(
+      ElemKind::UInt8QTy, {colBlocks, depthBlocks, 16, 4},
+      W->getType()->getScale(), wOffset + 128, W->getName().str() + "_packed");
+  auto *colTerms = M->createConstant(ElemKind::Int32ITy, {colBlocks * 16},
+                                     W->getName().str() + "_colterms");
+  packedW->getPayloadMutable().zero();
+  colTerms->getPayloadMutable().zero();
+
+  auto WH = W->getPayload().getHandle<int8_t>();
+  auto PH = packedW->getPayloadMutable().getHandle<uint8_t>();
+  auto CH = colTerms->getPayloadMutable().getHandle<int32_t>();
+
+  // Scale the bias to the scale of the matrix product like libjit_fc does.
+  auto biasParam = quantization::quantizeScaleOffset32To8(
+      B ? B->getType()->getScale() / matMulScale : 1.f, 0);
+  for (dim_t j = 0; j < numCols; j++) {
+    int64_t colSum = 0;
+    for (dim_t k = 0; k < K; k++) {
+      int8_t w = WH.at({k, j});
+      colSum += w;
+      PH.at({j / 16, k / 4, j % 16, k % 4}) = uint8_t(int32_t(w) + 128);
+    }
+    int64_t term = int64_t(K) * inOffset * wOffset - inOffset * colSum;
+    if (B) {
+      int32_t biasVal = B->getElementType() == ElemKind::Int8QTy
+                            ? B->getPayload().getHandle<int8_t>().raw(j)
+                            : B->getPayload().getHandle<int32_t>().raw(j);
+      term += biasParam.transform(biasVal - B->getType()->getOffset());
+    }
+    CH.raw(j) = int32_t(term);
+  }
+
+  return F->addNode(new CPUFullyConnectedPackedNode(N->getName(), outTy, input,
+                                                    packedW, colTerms));
+}
+
+/// Number of consecutive output columns of a block of the block-sparse
+/// FullyConnected weights.
+constexpr dim_t sparseFCBlock = 8;
+
+/// Try to replace a float FullyConnected whose constant weights {K, N} are
+/// mostly made of all-zero 1x8 blocks by a CPUFullyConnectedSparse node, which
+/// skips the zero blocks, see libjit_fc_sparse_f. The weights are stored in
+/// the block compressed sparse row (BSR) format, the rows being the blocks of
+/// 8 output columns: the non-zero blocks of the block b are the ones in
+/// [BlockPtr[b], BlockPtr[b + 1]), Values[p] holding the 8 weights of the row
+/// BlockRows[p] of the weights, the last block padded with zeros. The node is
+/// only created when at least CPUSparseFCMinZeroBlocksPercent of the blocks
+/// are zero, below that the dense matrix product is faster.
+static Node *optimizeCPUSparseFC(FullyConnectedNode *FCN, Function *F) {
+  unsigned minZeroPercent =
+      glow::runtime::flags::CPUSparseFCMinZeroBlocksPercent;
+  Constant *W = dyn_cast<Constant>(FCN->getWeights());
+  if (!minZeroPercent || !W || W->getElementType() != ElemKind::FloatTy ||
+      FCN->getInput().getElementType() != ElemKind::FloatTy ||
+      FCN->getBias().getElementType() != ElemKind::FloatTy ||
+      FCN->getResult().getElementType() != ElemKind::FloatTy) {
+    return nullptr;
+  }
+
+  dim_t K = W->dims()[0];
+  dim_t N = W->dims()[1];
+  dim_t numBlocks = (N + sparseFCBlock - 1) / sparseFCBlock;
+  auto WH = W->getPayload().getHandle<float>();
+  auto isZeroBlock = [&](dim_t k, dim_t b) {
+    for (dim_t j = b * sparseFCBlock; j < std::min(N, (b + 1) * sparseFCBlock);
+         j++) {
+      if (WH.at({k, j}) != 0) {
+        return false;
+      }
+    }
+    return true;
+  };
+  dim_t numNonZero = 0;
+  for (dim_t b = 0; b < numBlocks; b++) {
+    for (dim_t k = 0; k < K; k++) {
+      numNonZero += !isZeroBlock(k, b);
+    }
+  }
+  // Require a non-zero block so that the constants aren't empty.
+  dim_t numTotal = numBlocks * K;
+  if (!numNonZero ||
+      (numTotal - numNonZero) * 100 < minZeroPercent * numTotal) {
+    return nullptr;
+  }
+
+  auto *M = F->getParent();
+  auto *values =
+      M->createConstant(ElemKind::FloatTy, {numNonZero, sparseFCBlock},
+                        W->getName().str() + "_bsr_values");
+  auto *blockRows = M->createConstant(ElemKind::Int32ITy, {numNonZero},
+                                      W->getName().str() + "_bsr_rows");
+  auto *blockPtr = M->createConstant(ElemKind::Int32ITy, {numBlocks + 1},
+                                     W->getName().str() + "_bsr_ptr");
+  values->getPayloadMutable().zero();
+  auto VH = values->getPayloadMutable().getHandle<float>();
+  auto RH = blockRows->getPayloadMutable().getHandle<int32_t>();
+  auto PH = blockPtr->getPayloadMutable().getHandle<int32_t>();
+  dim_t p = 0;
+  for (dim_t b = 0; b < numBlocks; b++) {
+    PH.raw(b) = p;
+    for (dim_t k = 0; k < K; k++) {
+      if (isZeroBlock(k, b)) {
+        continue;
+      }
+      for (dim_t j = b * sparseFCBlock;
+           j < std::min(N, (b + 1) * sparseFCBlock); j++) {
+        VH.at({p, j % sparseFCBlock}) = WH.at({k, j});
+      }
+      RH.raw(p++) = k;
+    }
+  }
+  PH.raw(numBlocks) = p;
+
+  return F->addNode(new CPUFullyConnectedSparseNode(
+      FCN->getName(), FCN->getResult().getType(), FCN->getInput(), values,
+      blockRows, blockPtr, FCN->getBias()));
+}
+
 /// Merge Max and Splat nodes into target-specific CPUMaxSplat node.
 /// For quantized network, sinkRescaleQuantizedNode transformation might have
 /// merged Rescale into Max node. In this case we need to pull it out, since
@@ -98,6 +399,12 @@ static Node *optimizeCPUMaxSplat(MaxNode *MN, Function *F) {
   SplatNode *splat;
   NodeValue input;
 
+  // libjit only has the float and int8 kernels of CPUMaxSplat.
+  auto elemTy = MN->getResult().getElementType();
+  if (elemTy != ElemKind::FloatTy && elemTy != ElemKind::Int8QTy) {
+    return nullptr;
+  }
+
   // One of the inputs must be Splat.
   if ((splat = dyn_cast<SplatNode>(MN->getLHS()))) {
     input = MN->getRHS();
@@ -125,15 +432,138 @@ static Node *optimizeCPUMaxSplat(MaxNode *MN, Function *F) {
       new CPUMaxSplatNode(MN->getName(), input, splat->getValue()));
 }
 
+/// Split the NHWC Convolution and pool nodes of \p F whose operands don't
+/// fit in \p cacheBytes along the batch, then the height of their result, so
+/// that the operands of each chunk, the filter included, fit in the cache.
+/// Each chunk still runs its kernel on the intra-op thread pool. Nodes whose
+/// other operands than the input take more than half of the cache are left
+/// whole since fewer rows would not make them fit. \returns whether \p F
+/// changed.
+static Expected<bool> splitCPUNodesForCache(Function *F, unsigned cacheBytes) {
+  auto constraint = SplitNodeMaxMemConstraint(cacheBytes);
+  bool changed = false;
+  auto &nodes = F->getNodes();
+  for (auto it = nodes.rbegin(), e = nodes.rend(); it != e;) {
+    Node *node = &*(it++);
+    NodeValue input;
+    int64_t kernelH, strideH;
+    if (auto *CN = dyn_cast<ConvolutionNode>(node)) {
+      if (CN->getLayout() != NHWC) {
+        continue;
+      }
+      input = CN->getInput();
+      kernelH = (CN->getKernels()[0] - 1) * CN->getDilation()[0] + 1;
+      strideH = CN->getStrides()[0];
+    } else if (auto *PN = dyn_cast<MaxPoolNode>(node)) {
+      if (PN->getLayout() != NHWC) {
+        continue;
+      }
+      input = PN->getInput();
+      kernelH = PN->getKernels()[0];
+      strideH = PN->getStrides()[0];
+    } else if (auto *PN = dyn_cast<AvgPoolNode>(node)) {
+      if (PN->getLayout() != NHWC) {
+        continue;
+      }
+      input = PN->getInput();
+      kernelH = PN->getKernels()[0];
+      strideH = PN->getStrides()[0];
+    } else {
+      continue;
+    }
+    if (node->getTotMemSize() <= cacheBytes) {
+      continue;
+    }
+
+    // Bytes of a row of the input and of the results, and of the operands,
+    // like the filter, which are not split.
+    auto outDims = node->getNthResult(0).dims();
+    auto inDims = input.dims();
+    dim_t N = outDims[ShapeNHWC::DimN];
+    dim_t H = outDims[ShapeNHWC::DimH];
+    int64_t inRowBytes = input.getType()->getSizeInBytes() /
+                         (inDims[ShapeNHWC::DimN] * inDims[ShapeNHWC::DimH]);
+    int64_t outBytes = 0;
+    for (unsigned i = 0, e = node->getNumResults(); i < e; i++) {
+      outBytes += node->getNthResult(i).getType()->getSizeInBytes();
+    }
+    int64_t outRowBytes = outBytes / (N * H);
+    int64_t fixedBytes = node->getTotMemSize() - outBytes -
+                         input.getType()->getSizeInBytes();
+    if (fixedBytes * 2 > cacheBytes) {
+      continue;
+    }
+
+    // A chunk of n samples and r rows reads (r - 1) * strideH + kernelH rows
+    // of each input sample.
+    int64_t budget = int64_t(cacheBytes) - fixedBytes;
+    int64_t sampleBytes =
+        H * outRowBytes + ((H - 1) * strideH + kernelH) * inRowBytes;
+    dim_t chunkN = N;
+    dim_t chunkH = H;
+    if (sampleBytes <= budget) {
+      chunkN = budget / sampleBytes;
+    } else {
+      chunkN = 1;
+      int64_t rows = (budget - (kernelH - strideH) * inRowBytes) /
+                     (outRowBytes + strideH * inRowBytes);
+      if (rows < 1) {
+        continue;
+      }
+      chunkH = rows;
+    }
+    std::vector<size_t> splitDims;
+    std::vector<dim_t> chunkSizes;
+    if (chunkN < N) {
+      splitDims.push_back(ShapeNHWC::DimN);
+      chunkSizes.push_back(chunkN);
+    }
+    if (chunkH < H) {
+      splitDims.push_back(ShapeNHWC::DimH);
+      chunkSizes.push_back(chunkH);
+    }
+    if (splitDims.empty()) {
+      continue;
+    }
+
+    SplitNodeByChunkSize splitOption(splitDims, chunkSizes);
+    std::vector<Node *> splitNodes;
+    ASSIGN_VALUE_OR_RETURN_ERR(splitNodes,
+                               splitNode(node, &splitOption, &constraint));
+    changed |= !splitNodes.empty();
+  }
+  return changed;
+}
+
 Expected<bool>
 CPUBackend::transformPostLowering(Function *F, CompilationContext &,
                                   const glow::runtime::DeviceInfo *) const {
   LOG_SCOPE(F->getLogContext(), "CPUBackend::transformPostLowering")
 
   bool changed = false;
+  if (unsigned cacheBytes = glow::runtime::flags::CPUSplitCacheBytes) {
+    ASSIGN_VALUE_OR_RETURN_ERR(changed, splitCPUNodesForCache(F, cacheBytes));
+  }
+
+  // Transformed filters of the convolutions, by original filter.
+  llvm::DenseMap<Constant *, Constant *> winogradFilters;
+  llvm::DenseMap<Constant *, Constant *> im2colFilters;
   for (auto &node : F->getNodes()) {
-    // Try to replace generic convolution with cpu-optimized version.
+    // Try to replace generic convolution with cpu-optimized version: Winograd
+    // for 3x3 stride-1 convolutions, the im2col matrix product for the other
+    // convolutions with enough channels, DKKC8 for grouped convolutions with
+    // groups of 64 channels, and the direct convolution otherwise.
     if (auto *CN = dyn_cast<ConvolutionNode>(&node)) {
+      if (Node *WCN = optimizeCPUWinogradConv(CN, F, winogradFilters)) {
+        CN->getResult().replaceAllUsesOfWith(WCN);
+        changed = true;
+        continue;
+      }
+      if (Node *ICN = optimizeCPUIm2ColConv(CN, F, im2colFilters)) {
+        CN->getResult().replaceAllUsesOfWith(ICN);
+        changed = true;
+        continue;
+      }
       if (Node *NCN = optimizeCPUConv(CN, F)) {
         CN->getResult().replaceAllUsesOfWith(NCN);
         changed = true;
@@ -141,6 +571,30 @@ CPUBackend::transformPostLowering(Function *F, CompilationContext &,
       }
     }
 
+    // Try to pre-pack the constant weights of int8 FullyConnected and MatMul.
+    if (auto *FCN = dyn_cast<FullyConnectedNode>(&node)) {
+      if (Node *PFC = optimizeCPUInt8FC(FCN, FCN->getInput(),
+                                        FCN->getWeights(), FCN->getBias(), F)) {
+        FCN->getResult().replaceAllUsesOfWith(PFC);
+        changed = true;
+        continue;
+      }
+      // Skip the zero blocks of sparse float weights.
+      if (Node *SFC = optimizeCPUSparseFC(FCN, F)) {
+        FCN->getResult().replaceAllUsesOfWith(SFC);
+        changed = true;
+        continue;
+      }
+    }
+    if (auto *MMN = dyn_cast<MatMulNode>(&node)) {
+      if (Node *PFC = optimizeCPUInt8FC(MMN, MMN->getLHS(), MMN->getRHS(),
+                                        NodeValue(), F)) {
+        MMN->getResult().replaceAllUsesOfWith(PFC);
+        changed = true;
+        continue;
+      }
+    }
+
     // Merge Max and Splat nodes into CPUMaxSplat.
     if (auto *MN = dyn_cast<MaxNode>(&node)) {
       if (Node *MSN = optimizeCPUMaxSplat(MN, F)) {
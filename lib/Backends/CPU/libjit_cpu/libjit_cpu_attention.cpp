@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <float.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../../LLVMIRCodeGen/libjit/libjit_defs.h"
+
+namespace {
+/// Number of queries computed together, which share the loads of the keys
+/// and values.
+const dim_t attentionQueryBlock = 8;
+
+/// Number of keys whose scores are computed at once. The scores of a block of
+/// queries and keys are all that is kept of the attention scores.
+const dim_t attentionKeyBlock = 64;
+
+/// State of a scaled dot-product attention kernel, see
+/// libjit_scaled_dot_product_attention_f.
+struct AttentionArgs {
+  float *dest;
+  const float *query;
+  const float *key;
+  const float *value;
+  const float *mask;
+  dim_t maskStrides[3];
+  dim_t numQueryBlocks;
+  dim_t Lq;
+  dim_t Lk;
+  dim_t D;
+  dim_t Dv;
+  float scale;
+};
+
+/// \returns the dot product of the \p size elements of \p a and \p b.
+inline float dot(const float *a, const float *b, dim_t size) {
+  float8 sum8 = BroadcastFloat8(0.0f);
+  dim_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    sum8 += LoaduFloat8(a + i) * LoaduFloat8(b + i);
+  }
+  float sum = libjit_reduce_add_float8(sum8);
+  for (; i < size; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+/// Multiply the \p size elements of \p dest by \p alpha.
+inline void scaleRow(float *dest, dim_t size, float alpha) {
+  const float8 alpha8 = BroadcastFloat8(alpha);
+  dim_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    StoreuFloat8(dest + i, LoaduFloat8(dest + i) * alpha8);
+  }
+  for (; i < size; i++) {
+    dest[i] *= alpha;
+  }
+}
+
+/// Accumulate into \p dest the \p size elements of \p src times \p alpha.
+inline void axpy(float *dest, const float *src, dim_t size, float alpha) {
+  const float8 alpha8 = BroadcastFloat8(alpha);
+  dim_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    AdduFloat8(dest + i, LoaduFloat8(src + i) * alpha8);
+  }
+  for (; i < size; i++) {
+    dest[i] += alpha * src[i];
+  }
+}
+
+/// Compute the attention of the query blocks [\p begin, \p end), where block
+/// b covers queries of batch b / numQueryBlocks. The keys are visited in
+/// blocks, keeping for every query the running max and sum of the
+/// exponentials of its scores, and accumulating the output unnormalized in
+/// \p dest. Whenever the max of a query grows, its sum and output are
+/// rescaled, which takes one exponential per block instead of per score.
+void libjit_attention_blocks(void *ctx, dim_t begin, dim_t end) {
+  const AttentionArgs &a = *static_cast<AttentionArgs *>(ctx);
+  float scores[attentionQueryBlock][attentionKeyBlock];
+  float max[attentionQueryBlock];
+  float sum[attentionQueryBlock];
+
+  for (dim_t block = begin; block < end; block++) {
+    const dim_t n = block / a.numQueryBlocks;
+    const dim_t qStart = (block % a.numQueryBlocks) * attentionQueryBlock;
+    const dim_t numQueries = MIN(attentionQueryBlock, a.Lq - qStart);
+    const float *query = a.query + (n * a.Lq + qStart) * a.D;
+    const float *key = a.key + n * a.Lk * a.D;
+    const float *value = a.value + n * a.Lk * a.Dv;
+    const float *mask = a.mask + n * a.maskStrides[0];
+    float *dest = a.dest + (n * a.Lq + qStart) * a.Dv;
+
+    memset(dest, 0, numQueries * a.Dv * sizeof(float));
+    for (dim_t q = 0; q < numQueries; q++) {
+      max[q] = -FLT_MAX;
+      sum[q] = 0;
+    }
+
+    for (dim_t kStart = 0; kStart < a.Lk; kStart += attentionKeyBlock) {
+      const dim_t numKeys = MIN(attentionKeyBlock, a.Lk - kStart);
+
+      // Scores of the block, one key at a time so that it stays in L1.
+      for (dim_t k = 0; k < numKeys; k++) {
+        const float *keyRow = key + (kStart + k) * a.D;
+        for (dim_t q = 0; q < numQueries; q++) {
+          scores[q][k] =
+              dot(query + q * a.D, keyRow, a.D) * a.scale +
+              mask[(qStart + q) * a.maskStrides[1] +
+                   (kStart + k) * a.maskStrides[2]];
+        }
+      }
+
+      // Exponentials of the scores, relative to the running max.
+      for (dim_t q = 0; q < numQueries; q++) {
+        float *row = scores[q];
+        float blockMax = row[0];
+        for (dim_t k = 1; k < numKeys; k++) {
+          blockMax = MAX(blockMax, row[k]);
+        }
+        if (blockMax > max[q]) {
+          const float correction = libjit_exp_poly(max[q] - blockMax);
+          sum[q] *= correction;
+          scaleRow(dest + q * a.Dv, a.Dv, correction);
+          max[q] = blockMax;
+        }
+        const float8 max8 = BroadcastFloat8(max[q]);
+        float8 sum8 = BroadcastFloat8(0.0f);
+        dim_t k = 0;
+        for (; k + 8 <= numKeys; k += 8) {
+          const float8 e = libjit_exp_poly_float8(LoaduFloat8(row + k) - max8);
+          sum8 += e;
+          StoreuFloat8(row + k, e);
+        }
+        sum[q] += libjit_reduce_add_float8(sum8);
+        for (; k < numKeys; k++) {
+          row[k] = libjit_exp_poly(row[k] - max[q]);
+          sum[q] += row[k];
+        }
+      }
+
+      // Accumulate the values, one at a time so that it stays in L1.
+      for (dim_t k = 0; k < numKeys; k++) {
+        const float *valueRow = value + (kStart + k) * a.Dv;
+        for (dim_t q = 0; q < numQueries; q++) {
+          axpy(dest + q * a.Dv, valueRow, a.Dv, scores[q][k]);
+        }
+      }
+    }
+
+    for (dim_t q = 0; q < numQueries; q++) {
+      scaleRow(dest + q * a.Dv, a.Dv, 1.0f / sum[q]);
+    }
+  }
+}
+} // namespace
+
+extern "C" {
+
+/// Scaled dot-product attention of \p numBatches batches of \p Lq queries of
+/// \p D elements against \p Lk keys of \p D elements and values of \p Dv
+/// elements, writing a {numBatches, Lq, Dv} \p dest. The \p mask of
+/// dimensions \p maskDims is added to the scores, broadcast along its
+/// dimensions of size 1. The full {numBatches, Lq, Lk} scores are never
+/// materialized, see libjit_attention_blocks.
+void libjit_scaled_dot_product_attention_f(
+    float *dest, const float *query, const float *key, const float *value,
+    const float *mask, const dim_t *maskDims, dim_t numBatches, dim_t Lq,
+    dim_t Lk, dim_t D, dim_t Dv, float scale) {
+  const dim_t numQueryBlocks =
+      (Lq + attentionQueryBlock - 1) / attentionQueryBlock;
+  AttentionArgs args{dest,
+                     query,
+                     key,
+                     value,
+                     mask,
+                     {maskDims[0] == 1 ? 0 : maskDims[1] * maskDims[2],
+                      maskDims[1] == 1 ? 0 : maskDims[2],
+                      maskDims[2] == 1 ? 0 : (dim_t)1},
+                     numQueryBlocks,
+                     Lq,
+                     Lk,
+                     D,
+                     Dv,
+                     scale};
+  libjit_parallel_for(numBatches * numQueryBlocks, libjit_attention_blocks,
+                      &args);
+}
+
+} // extern "C"
@@ -24,6 +24,13 @@
 
 #include "../../../LLVMIRCodeGen/libjit/libjit_defs.h"
 
+extern "C" {
+// Defined in libjit_matmul.cpp.
+void libjit_matmul_serial_f(float *c, const float *a, const float *b,
+                            const dim_t *cDims, const dim_t *aDims,
+                            const dim_t *bDims);
+}
+
 namespace {
 // Initialize the convolution output frame for slice \p N with the bias \p
 // biasW.
@@ -250,6 +257,242 @@ void libjit_convDKKC8_foreach_xy_pixels_filter(
   }       // For each X in the output.
 }
 
+/// Winograd F(4x4, 3x3) convolution: every 4x4 output tile is computed from a
+/// 6x6 input tile as Y = AT * [U . (BT * d * B)] * A, where U = G * g * GT is
+/// the transformed 3x3 filter g, see Lavin and Gray, "Fast Algorithms for
+/// Convolutional Neural Networks". The products of the 36 tile positions are
+/// summed over the input channels, so each position is a matrix product of
+/// the [tiles, C] transformed inputs with the [C, D] transformed filter.
+constexpr dim_t winogradTile = 4;
+constexpr dim_t winogradInTile = winogradTile + 2;
+constexpr dim_t winogradPositions = winogradInTile * winogradInTile;
+/// Number of tiles transformed and multiplied at once. Bounds the scratch
+/// memory while keeping the matrix products large enough to be efficient.
+constexpr dim_t winogradTileBlock = 64;
+
+/// Computes \p r = BT * \p d for the 6 values \p d read with \p stride.
+LIBJIT_ALWAYS_INLINE void libjit_winograd_input_1d(const float *d, dim_t stride,
+                                                   float *r, dim_t rstride) {
+  float d0 = d[0], d1 = d[stride], d2 = d[2 * stride], d3 = d[3 * stride],
+        d4 = d[4 * stride], d5 = d[5 * stride];
+  r[0] = 4 * d0 - 5 * d2 + d4;
+  r[rstride] = -4 * d1 - 4 * d2 + d3 + d4;
+  r[2 * rstride] = 4 * d1 - 4 * d2 - d3 + d4;
+  r[3 * rstride] = -2 * d1 - d2 + 2 * d3 + d4;
+  r[4 * rstride] = 2 * d1 - d2 - 2 * d3 + d4;
+  r[5 * rstride] = 4 * d1 - 5 * d3 + d5;
+}
+
+/// Computes \p y = AT * \p m for the 6 values \p m read with \p stride.
+LIBJIT_ALWAYS_INLINE void libjit_winograd_output_1d(const float *m,
+                                                    dim_t stride, float *y,
+                                                    dim_t ystride) {
+  float m0 = m[0], m1 = m[stride], m2 = m[2 * stride], m3 = m[3 * stride],
+        m4 = m[4 * stride], m5 = m[5 * stride];
+  y[0] = m0 + m1 + m2 + m3 + m4;
+  y[ystride] = m1 - m2 + 2 * m3 - 2 * m4;
+  y[2 * ystride] = m1 + m2 + 4 * m3 + 4 * m4;
+  y[3 * ystride] = m1 - m2 + 8 * m3 - 8 * m4 + m5;
+}
+
+/// State of one libjit_conv_winograd_f call, shared by its parallel loops.
+struct WinogradArgs {
+  float *outW;
+  const float *inW, *filterW, *biasW;
+  const dim_t *outWdims, *inWdims;
+  dim_t padT, padL, tilesW;
+  /// Sample in the batch and first tile of the current block.
+  dim_t n, tileBegin, numTiles;
+  /// Transformed inputs [36, winogradTileBlock, C] and products
+  /// [36, winogradTileBlock, D] of the current block.
+  float *V, *M;
+};
+
+/// Transforms the input tiles [\p begin, \p end) of the current block.
+void libjit_winograd_input_tiles(void *ctx, dim_t begin, dim_t end) {
+  const WinogradArgs &a = *static_cast<WinogradArgs *>(ctx);
+  dim_t C = a.inWdims[3];
+  dim_t H = a.inWdims[1];
+  dim_t W = a.inWdims[2];
+  for (dim_t t = begin; t < end; t++) {
+    dim_t tile = a.tileBegin + t;
+    sdim_t y0 = sdim_t(tile / a.tilesW * winogradTile) - sdim_t(a.padT);
+    sdim_t x0 = sdim_t(tile % a.tilesW * winogradTile) - sdim_t(a.padL);
+    bool inside = y0 >= 0 && x0 >= 0 && y0 + winogradInTile <= H &&
+                  x0 + winogradInTile <= W;
+    float *V = a.V + t * C;
+    dim_t posStride = winogradTileBlock * C;
+    for (dim_t c = 0; c < C; c++) {
+      float d[winogradPositions];
+      if (inside) {
+        const float *in =
+            &a.inW[libjit_getXYZW(a.inWdims, a.n, dim_t(y0), dim_t(x0), c)];
+        for (dim_t i = 0; i < winogradInTile; i++) {
+          for (dim_t j = 0; j < winogradInTile; j++) {
+            d[i * winogradInTile + j] = in[(i * W + j) * C];
+          }
+        }
+      } else {
+        // Zero padding and the rows and columns past the last tile.
+        for (dim_t i = 0; i < winogradInTile; i++) {
+          for (dim_t j = 0; j < winogradInTile; j++) {
+            sdim_t y = y0 + sdim_t(i);
+            sdim_t x = x0 + sdim_t(j);
+            bool valid = y >= 0 && x >= 0 && y < sdim_t(H) && x < sdim_t(W);
+            d[i * winogradInTile + j] =
+                valid ? a.inW[libjit_getXYZW(a.inWdims, a.n, dim_t(y),
+                                             dim_t(x), c)]
+                      : 0;
+          }
+        }
+      }
+      // V = BT * d * B, first along the columns then along the rows.
+      float tmp[winogradPositions];
+      for (dim_t j = 0; j < winogradInTile; j++) {
+        libjit_winograd_input_1d(&d[j], winogradInTile, &tmp[j],
+                                 winogradInTile);
+      }
+      for (dim_t i = 0; i < winogradInTile; i++) {
+        libjit_winograd_input_1d(&tmp[i * winogradInTile], 1,
+                                 &V[i * winogradInTile * posStride + c],
+                                 posStride);
+      }
+    }
+  }
+}
+
+/// Computes the products of the tile positions [\p begin, \p end) of the
+/// current block.
+void libjit_winograd_products(void *ctx, dim_t begin, dim_t end) {
+  const WinogradArgs &a = *static_cast<WinogradArgs *>(ctx);
+  dim_t C = a.inWdims[3];
+  dim_t D = a.outWdims[3];
+  dim_t vDims[] = {a.numTiles, C};
+  dim_t uDims[] = {C, D};
+  dim_t mDims[] = {a.numTiles, D};
+  for (dim_t p = begin; p < end; p++) {
+    libjit_matmul_serial_f(a.M + p * winogradTileBlock * D,
+                           a.V + p * winogradTileBlock * C,
+                           a.filterW + p * C * D, mDims, vDims, uDims);
+  }
+}
+
+/// Transforms the products of the output tiles [\p begin, \p end) of the
+/// current block, adds the bias and stores the result.
+void libjit_winograd_output_tiles(void *ctx, dim_t begin, dim_t end) {
+  const WinogradArgs &a = *static_cast<WinogradArgs *>(ctx);
+  dim_t D = a.outWdims[3];
+  dim_t outH = a.outWdims[1];
+  dim_t outW = a.outWdims[2];
+  dim_t posStride = winogradTileBlock * D;
+  for (dim_t t = begin; t < end; t++) {
+    dim_t tile = a.tileBegin + t;
+    dim_t y0 = tile / a.tilesW * winogradTile;
+    dim_t x0 = tile % a.tilesW * winogradTile;
+    const float *M = a.M + t * D;
+    for (dim_t d = 0; d < D; d++) {
+      // Y = AT * M * A, first along the columns then along the rows.
+      float tmp[winogradTile * winogradInTile];
+      for (dim_t j = 0; j < winogradInTile; j++) {
+        libjit_winograd_output_1d(&M[j * posStride + d],
+                                  winogradInTile * posStride, &tmp[j],
+                                  winogradInTile);
+      }
+      float y[winogradTile * winogradTile];
+      for (dim_t i = 0; i < winogradTile; i++) {
+        libjit_winograd_output_1d(&tmp[i * winogradInTile], 1,
+                                  &y[i * winogradTile], 1);
+      }
+      for (dim_t i = 0; i < winogradTile && y0 + i < outH; i++) {
+        for (dim_t j = 0; j < winogradTile && x0 + j < outW; j++) {
+          a.outW[libjit_getXYZW(a.outWdims, a.n, y0 + i, x0 + j, d)] =
+              y[i * winogradTile + j] + a.biasW[d];
+        }
+      }
+    }
+  }
+}
+
+/// Number of output pixels a libjit_conv_im2col_f task gathers and multiplies
+/// at once.
+constexpr dim_t im2colPixelBlock = 64;
+
+/// State of one libjit_conv_im2col_f call, shared by its parallel loop.
+struct Im2ColArgs {
+  float *outW;
+  const float *inW, *filterW, *biasW;
+  const dim_t *outWdims, *inWdims, *kernelSizes, *strides, *pads, *dilation;
+  /// Whether the input rows can be used as the matrix of the product directly,
+  /// which is the case for 1x1 convolutions with stride 1 and no padding.
+  bool direct;
+};
+
+/// Computes the output pixels of the blocks [\p begin, \p end), numbered
+/// across the whole batch.
+void libjit_conv_im2col_blocks(void *ctx, dim_t begin, dim_t end) {
+  const Im2ColArgs &a = *static_cast<Im2ColArgs *>(ctx);
+  dim_t C = a.inWdims[3];
+  dim_t D = a.outWdims[3];
+  dim_t KH = a.kernelSizes[0];
+  dim_t KW = a.kernelSizes[1];
+  dim_t rowSize = KH * KW * C;
+  dim_t outPixels = a.outWdims[1] * a.outWdims[2];
+  dim_t numPixels = a.outWdims[0] * outPixels;
+
+  float *cols = nullptr;
+  if (!a.direct) {
+    libjit_aligned_malloc((void **)&cols, 64,
+                          im2colPixelBlock * rowSize * sizeof(float));
+  }
+  for (dim_t b = begin; b < end; b++) {
+    dim_t p0 = b * im2colPixelBlock;
+    dim_t numRows = MIN(im2colPixelBlock, numPixels - p0);
+    const float *A = a.inW + p0 * C;
+    if (!a.direct) {
+      // Gather the [KH, KW, C] input window of every pixel into a row, with
+      // zeros for the padding.
+      for (dim_t r = 0; r < numRows; r++) {
+        dim_t n = (p0 + r) / outPixels;
+        dim_t oy = (p0 + r) % outPixels / a.outWdims[2];
+        dim_t ox = (p0 + r) % a.outWdims[2];
+        float *row = cols + r * rowSize;
+        for (dim_t ky = 0; ky < KH; ky++) {
+          sdim_t y = sdim_t(oy * a.strides[0] + ky * a.dilation[0]) -
+                     sdim_t(a.pads[0]);
+          for (dim_t kx = 0; kx < KW; kx++, row += C) {
+            sdim_t x = sdim_t(ox * a.strides[1] + kx * a.dilation[1]) -
+                       sdim_t(a.pads[1]);
+            if (y < 0 || x < 0 || y >= sdim_t(a.inWdims[1]) ||
+                x >= sdim_t(a.inWdims[2])) {
+              memset(row, 0, C * sizeof(float));
+              continue;
+            }
+            memcpy(row,
+                   &a.inW[libjit_getXYZW(a.inWdims, n, dim_t(y), dim_t(x), 0)],
+                   C * sizeof(float));
+          }
+        }
+      }
+      A = cols;
+    }
+
+    // Output pixels are consecutive rows of D values.
+    float *out = a.outW + p0 * D;
+    dim_t outDims[] = {numRows, D};
+    dim_t aDims[] = {numRows, rowSize};
+    dim_t filterDims[] = {rowSize, D};
+    libjit_matmul_serial_f(out, A, a.filterW, outDims, aDims, filterDims);
+    for (dim_t r = 0; r < numRows; r++) {
+      for (dim_t d = 0; d < D; d++) {
+        out[r * D + d] += a.biasW[d];
+      }
+    }
+  }
+  if (cols) {
+    libjit_aligned_free(cols);
+  }
+}
+
 } // namespace
 
 extern "C" {
@@ -270,6 +513,25 @@ void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
       (pixelScanFirst ? &libjit_convDKKC8_foreach_xy_pixels_filter
                       : &libjit_convDKKC8_foreach_xy_filter_pixels);
 
+  // Each task convolves one strip of output channels of one group. Strips
+  // write disjoint output channels, so they are split across threads.
+  dim_t stripSize = 8 * numDepthRegs * depthStrips;
+  dim_t stripsPerG = (outCperG + stripSize - 1) / stripSize;
+
+  struct Args {
+    decltype(eachPixelConv) conv;
+    dim_t n;
+    unsigned numDepthRegs, depthStrips, sizeGroupY;
+    dim_t inCperG, outCperG, stripSize, stripsPerG;
+    float *outW;
+    const float *inW, *filterW, *biasW;
+    const dim_t *outWdims, *inWdims, *filterWdims, *biasWdims;
+    const dim_t *kernelSizes, *strides, *pads;
+  } args{eachPixelConv, 0, numDepthRegs, depthStrips, sizeGroupY,
+         inCperG, outCperG, stripSize, stripsPerG, outW, inW, filterW,
+         biasW, outWdims, inWdims, filterWdims, biasWdims, kernelSizes,
+         strides, pads};
+
   // For each input in the batch:
   for (dim_t n = 0; n < inWdims[0]; n++) {
 
@@ -277,24 +539,87 @@ void libjit_convDKKC8_f(float *outW, const float *inW, const float *filterW,
     // Later we will accumulate values into this slice.
     libjit_conv_init_output_with_bias(n, outW, biasW, outWdims, biasWdims);
 
-    // For each group of input channels:
-    for (dim_t g = 0; g < group; g++) {
+    // For each group of input channels and each strip of output channels,
+    // process [numDepthRegs x float8] elements per output channel.
+    args.n = n;
+    libjit_parallel_for(
+        group * stripsPerG,
+        [](void *ctx, dim_t begin, dim_t end) {
+          const Args &a = *static_cast<Args *>(ctx);
+          for (dim_t t = begin; t < end; t++) {
+            dim_t g = t / a.stripsPerG;
+            dim_t d = g * a.outCperG + (t % a.stripsPerG) * a.stripSize;
+            dim_t endChannelIndex = (g + 1) * a.outCperG;
+
+            // Perform the convolution for each pixel.
+            a.conv(a.n, d, a.numDepthRegs, a.depthStrips, a.sizeGroupY,
+                   a.inCperG, a.outW, a.inW, a.filterW, a.biasW, a.outWdims,
+                   a.inWdims, a.filterWdims, a.biasWdims, a.kernelSizes,
+                   a.strides, a.pads, g, endChannelIndex);
+          }
+        },
+        &args);
+  } // For each N, the sample in the batch.
+}
 
-      // For each output channel, process [numDepthRegs x float8] elements.
-      dim_t startChannelIndex = g * outCperG;
-      dim_t endChannelIndex = (g + 1) * outCperG;
-      for (dim_t d = startChannelIndex; d < endChannelIndex;
-           d += 8 * numDepthRegs * depthStrips) {
+/// Convolution with a 3x3 filter and stride 1 using Winograd F(4x4, 3x3), see
+/// WinogradArgs. \p filterW is the filter transformed at compile time, with
+/// shape [36, C, D]: the 6x6 transformed filter G * g * GT of every pair of
+/// input channel c and output channel d is stored at [i * 6 + j, c, d].
+void libjit_conv_winograd_f(float *outW, const float *inW,
+                            const float *filterW, const float *biasW,
+                            const dim_t *outWdims, const dim_t *inWdims,
+                            const dim_t *pads) {
+  dim_t C = inWdims[3];
+  dim_t D = outWdims[3];
+  dim_t tilesH = (outWdims[1] + winogradTile - 1) / winogradTile;
+  dim_t tilesW = (outWdims[2] + winogradTile - 1) / winogradTile;
+
+  float *V = nullptr;
+  float *M = nullptr;
+  libjit_aligned_malloc((void **)&V, 64,
+                        winogradPositions * winogradTileBlock * C *
+                            sizeof(float));
+  libjit_aligned_malloc((void **)&M, 64,
+                        winogradPositions * winogradTileBlock * D *
+                            sizeof(float));
+
+  WinogradArgs args{outW,    inW,    filterW, biasW, outWdims, inWdims,
+                    pads[0], pads[1], tilesW, 0,     0,        0,
+                    V,       M};
+  // For each input in the batch and each block of tiles:
+  for (dim_t n = 0; n < inWdims[0]; n++) {
+    for (dim_t t = 0; t < tilesH * tilesW; t += winogradTileBlock) {
+      args.n = n;
+      args.tileBegin = t;
+      args.numTiles = MIN(winogradTileBlock, tilesH * tilesW - t);
+      libjit_parallel_for(args.numTiles, libjit_winograd_input_tiles, &args);
+      libjit_parallel_for(winogradPositions, libjit_winograd_products, &args);
+      libjit_parallel_for(args.numTiles, libjit_winograd_output_tiles, &args);
+    }
+  }
 
-        // Perform the convolution for each pixel.
-        eachPixelConv(n, d, numDepthRegs, depthStrips, sizeGroupY, inCperG,
-                      outW, inW, filterW, biasW, outWdims, inWdims, filterWdims,
-                      biasWdims, kernelSizes, strides, pads, g,
-                      endChannelIndex);
+  libjit_aligned_free(M);
+  libjit_aligned_free(V);
+}
 
-      } // For each D (the depth, or the output channel).
-    }   // for each G, the group
-  }     // For each N, the sample in the batch.
+/// Convolution with group 1 computed as the matrix product of the im2col
+/// matrix of the input, with one [KH, KW, C] window per output pixel, and
+/// \p filterW, the filter transposed at compile time to [KH * KW * C, D].
+/// Blocks of output pixels are split across threads.
+void libjit_conv_im2col_f(float *outW, const float *inW, const float *filterW,
+                          const float *biasW, const dim_t *outWdims,
+                          const dim_t *inWdims, const dim_t *kernelSizes,
+                          const dim_t *strides, const dim_t *pads,
+                          const dim_t *dilation) {
+  bool direct = kernelSizes[0] == 1 && kernelSizes[1] == 1 &&
+                strides[0] == 1 && strides[1] == 1 && pads[0] == 0 &&
+                pads[1] == 0 && pads[2] == 0 && pads[3] == 0;
+  Im2ColArgs args{outW,    inW,         filterW, biasW, outWdims, inWdims,
+                  kernelSizes, strides, pads,  dilation, direct};
+  dim_t numPixels = outWdims[0] * outWdims[1] * outWdims[2];
+  libjit_parallel_for((numPixels + im2colPixelBlock - 1) / im2colPixelBlock,
+                      libjit_conv_im2col_blocks, &args);
 }
 
 } // extern "C"
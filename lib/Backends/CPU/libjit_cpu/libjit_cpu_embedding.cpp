@@ -0,0 +1,462 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../../LLVMIRCodeGen/libjit/libjit_defs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIBJIT_F16C_KERNELS
+#define LIBJIT_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+
+namespace {
+/// Row types of the tables, mirrors glow::SplitEmbeddingSparseType.
+enum SparseType : uint8_t {
+  EST_FLOAT = 0,
+  EST_FLOAT16 = 1,
+  EST_INT8 = 2,
+  EST_INT4 = 3,
+};
+
+/// Placement of a table whose rows live in the device weights, mirrors
+/// glow::WeightsPlacement::HOST. Tables placed elsewhere use the UVM weights.
+const int32_t placementHost = 3;
+
+/// \returns the size in bytes of the per-row scale and offset of quantized
+/// rows, stored as floats if \p scaleOffsetFP32 and as halves otherwise.
+inline dim_t scaleOffsetBytes(bool scaleOffsetFP32) {
+  return 2 * (scaleOffsetFP32 ? sizeof(float) : sizeof(uint16_t));
+}
+
+/// \returns the size in bytes of a row of \p numDims elements of type \p ty,
+/// padded to \p rowAlignment bytes.
+inline dim_t paddedRowBytes(dim_t numDims, uint8_t ty, bool scaleOffsetFP32,
+                            dim_t rowAlignment) {
+  dim_t bytes = 0;
+  switch (ty) {
+  case EST_FLOAT:
+    bytes = numDims * sizeof(float);
+    break;
+  case EST_FLOAT16:
+    bytes = numDims * sizeof(uint16_t);
+    break;
+  case EST_INT8:
+    bytes = numDims + scaleOffsetBytes(scaleOffsetFP32);
+    break;
+  case EST_INT4:
+    bytes = numDims / 2 + scaleOffsetBytes(scaleOffsetFP32);
+    break;
+  }
+  return (bytes + rowAlignment - 1) / rowAlignment * rowAlignment;
+}
+
+/// Accumulate into \p dest the \p numDims elements of the row \p row of type
+/// \p ty, multiplied by \p weight.
+inline void accumulateRow(float *dest, const uint8_t *row, dim_t numDims,
+                          uint8_t ty, bool scaleOffsetFP32, float weight) {
+  if (ty == EST_FLOAT) {
+    const float8 weight8 = BroadcastFloat8(weight);
+    const float *data = (const float *)row;
+    dim_t k = 0;
+    for (; k + 8 <= numDims; k += 8) {
+      AdduFloat8(dest + k, LoaduFloat8(data + k) * weight8);
+    }
+    for (; k < numDims; k++) {
+      dest[k] += weight * data[k];
+    }
+    return;
+  }
+  if (ty == EST_FLOAT16) {
+    for (dim_t k = 0; k < numDims; k++) {
+      uint16_t h;
+      memcpy(&h, row + k * sizeof(h), sizeof(h));
+      dest[k] += weight * libjit_fp16_to_fp32(h);
+    }
+    return;
+  }
+
+  // Quantized rows start with their scale and offset.
+  float scale, offset;
+  if (scaleOffsetFP32) {
+    memcpy(&scale, row, sizeof(float));
+    memcpy(&offset, row + sizeof(float), sizeof(float));
+  } else {
+    uint16_t h[2];
+    memcpy(h, row, sizeof(h));
+    scale = libjit_fp16_to_fp32(h[0]);
+    offset = libjit_fp16_to_fp32(h[1]);
+  }
+  const uint8_t *data = row + scaleOffsetBytes(scaleOffsetFP32);
+  if (ty == EST_INT8) {
+    libjit_fused_rowwise_accumulate_8bit(dest, data, numDims, weight * scale,
+                                         weight * offset);
+  } else if (ty == EST_INT4) {
+    libjit_fused_rowwise_accumulate_4bit(dest, data, numDims, weight * scale,
+                                         weight * offset);
+  }
+}
+
+/// State of a table-batched embedding bags kernel, with weights offsets of
+/// type \p WOT.
+template <typename WOT> struct TBEArgs {
+  float *dest;
+  const uint8_t *devWeights;
+  const uint8_t *uvmWeights;
+  const int32_t *weightsPlacements;
+  const WOT *weightsOffsets;
+  const uint8_t *weightsTys;
+  const int32_t *dimOffsets;
+  const int32_t *indices;
+  const int32_t *offsets;
+  const float *indiceWeights;
+  dim_t numBatches;
+  dim_t totalDims;
+  bool meanPooling;
+  bool scaleOffsetFP32;
+  dim_t rowAlignment;
+};
+
+/// Compute the bags [\p begin, \p end), where bag t * numBatches + b pools
+/// the rows of table t for batch b. Consecutive bags share a table, so the
+/// row size and type are only looked up again when moving to the next table.
+template <typename WOT>
+void libjit_tbe_bags(void *ctx, dim_t begin, dim_t end) {
+  const TBEArgs<WOT> &a = *static_cast<TBEArgs<WOT> *>(ctx);
+  for (dim_t bag = begin; bag < end;) {
+    const dim_t t = bag / a.numBatches;
+    const dim_t tableEnd = MIN(end, (t + 1) * a.numBatches);
+    const dim_t dimStart = a.dimOffsets[t];
+    const dim_t numDims = a.dimOffsets[t + 1] - dimStart;
+    const uint8_t ty = a.weightsTys[t];
+    const dim_t rowBytes =
+        paddedRowBytes(numDims, ty, a.scaleOffsetFP32, a.rowAlignment);
+    const uint8_t *table =
+        (a.weightsPlacements[t] == placementHost ? a.devWeights
+                                                 : a.uvmWeights) +
+        a.weightsOffsets[t];
+    // Prefetching runs ahead across the bags of this table in the range.
+    const dim_t lastIndex = a.offsets[tableEnd];
+
+    for (; bag < tableEnd; bag++) {
+      const dim_t b = bag - t * a.numBatches;
+      float *out = a.dest + b * a.totalDims + dimStart;
+      memset(out, 0, numDims * sizeof(float));
+      const dim_t indicesStart = a.offsets[bag];
+      const dim_t indicesEnd = a.offsets[bag + 1];
+      for (dim_t i = indicesStart; i < indicesEnd; i++) {
+        if (i + fusedRowwisePrefetchDistance < lastIndex) {
+          libjit_prefetch_row(
+              table + a.indices[i + fusedRowwisePrefetchDistance] * rowBytes,
+              rowBytes);
+        }
+        const float weight = a.indiceWeights ? a.indiceWeights[i] : 1.0f;
+        accumulateRow(out, table + a.indices[i] * rowBytes, numDims, ty,
+                      a.scaleOffsetFP32, weight);
+      }
+      if (a.meanPooling && indicesEnd > indicesStart) {
+        const float scale = 1.0f / (indicesEnd - indicesStart);
+        for (dim_t d = 0; d < numDims; d++) {
+          out[d] *= scale;
+        }
+      }
+    }
+  }
+}
+
+/// Table-batched embedding bags over \p numTables tables with \p numBatches
+/// bags each. The bags of all tables are computed in a single parallel loop,
+/// see IntNBitSplitEmbeddingBagsNode for the layout of the operands.
+template <typename WOT>
+void libjit_int_nbit_split_embedding_bags_generic(
+    float *dest, const uint8_t *devWeights, const uint8_t *uvmWeights,
+    const int32_t *weightsPlacements, const WOT *weightsOffsets,
+    const uint8_t *weightsTys, const int32_t *dimOffsets,
+    const int32_t *indices, const int32_t *offsets, const float *indiceWeights,
+    dim_t numTables, dim_t numBatches, dim_t totalDims, bool meanPooling,
+    bool scaleOffsetFP32, int32_t rowAlignment) {
+  TBEArgs<WOT> args{dest, devWeights, uvmWeights, weightsPlacements,
+                    weightsOffsets, weightsTys, dimOffsets, indices, offsets,
+                    indiceWeights, numBatches, totalDims, meanPooling,
+                    scaleOffsetFP32, (dim_t)rowAlignment};
+  libjit_parallel_for(numTables * numBatches, libjit_tbe_bags<WOT>, &args);
+}
+
+/// Number of columns of the float16 bags accumulated at once, sized for the
+/// accumulators to stay in L1.
+const dim_t fp16BagBlock = 256;
+
+/// Pool into the row \p dest of \p lineSize halves the rows \p indices
+/// [\p begin, \p end) of \p data, multiplied by the halves \p weights if
+/// given. The sums are accumulated in float and rounded once to half.
+template <typename IT>
+void libjit_fp16_bag(uint16_t *dest, const uint16_t *data,
+                     const uint16_t *weights, const IT *indices, dim_t begin,
+                     dim_t end, dim_t lineSize) {
+  float acc[fp16BagBlock];
+  for (dim_t k0 = 0; k0 < lineSize; k0 += fp16BagBlock) {
+    const dim_t n = MIN(fp16BagBlock, lineSize - k0);
+    memset(acc, 0, n * sizeof(float));
+    for (dim_t j = begin; j < end; j++) {
+      const float weight = weights ? libjit_fp16_to_fp32(weights[j]) : 1.0f;
+      const uint16_t *row = data + indices[j] * lineSize + k0;
+      for (dim_t k = 0; k < n; k++) {
+        acc[k] += weight * libjit_fp16_to_fp32(row[k]);
+      }
+    }
+    for (dim_t k = 0; k < n; k++) {
+      dest[k0 + k] = libjit_fp32_to_fp16(acc[k]);
+    }
+  }
+}
+
+#ifdef LIBJIT_F16C_KERNELS
+/// Same as libjit_fp16_bag, converting 8 halves at a time with F16C.
+template <typename IT>
+LIBJIT_F16C_TARGET void
+libjit_fp16_bag_f16c(uint16_t *dest, const uint16_t *data,
+                     const uint16_t *weights, const IT *indices, dim_t begin,
+                     dim_t end, dim_t lineSize) {
+  float acc[fp16BagBlock];
+  for (dim_t k0 = 0; k0 < lineSize; k0 += fp16BagBlock) {
+    const dim_t n = MIN(fp16BagBlock, lineSize - k0);
+    memset(acc, 0, n * sizeof(float));
+    for (dim_t j = begin; j < end; j++) {
+      const float weight = weights ? libjit_fp16_to_fp32(weights[j]) : 1.0f;
+      const __m256 weight8 = _mm256_set1_ps(weight);
+      const uint16_t *row = data + indices[j] * lineSize + k0;
+      dim_t k = 0;
+      for (; k + 8 <= n; k += 8) {
+        const __m256 r = _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + k)));
+        _mm256_storeu_ps(acc + k, _mm256_add_ps(_mm256_loadu_ps(acc + k),
+                                                _mm256_mul_ps(weight8, r)));
+      }
+      for (; k < n; k++) {
+        acc[k] += weight * libjit_fp16_to_fp32(row[k]);
+      }
+    }
+    dim_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(dest + k0 + k),
+          _mm256_cvtps_ph(_mm256_loadu_ps(acc + k), _MM_FROUND_TO_NEAREST_INT));
+    }
+    for (; k < n; k++) {
+      dest[k0 + k] = libjit_fp32_to_fp16(acc[k]);
+    }
+  }
+}
+#endif
+
+/// Pool the rows of \p data into \p segments bags of \p lineSize halves at
+/// \p dest, bag i taking the next lengths[i] of \p indices, with the bag
+/// kernel \p bag.
+template <typename IT, typename BagFn>
+void libjit_fp16_lengths_bags(BagFn bag, uint16_t *dest, const uint16_t *data,
+                              const uint16_t *weights, const IT *indices,
+                              const int32_t *lengths, dim_t segments,
+                              dim_t lineSize) {
+  dim_t curIndex = 0;
+  for (dim_t i = 0; i < segments; i++) {
+    bag(dest + i * lineSize, data, weights, indices, curIndex,
+        curIndex + lengths[i], lineSize);
+    curIndex += lengths[i];
+  }
+}
+
+/// Pool the rows of \p data into the bags of \p lineSize halves at \p dest,
+/// bag i taking \p indices [offsets[i], offsets[i + 1]), with the bag kernel
+/// \p bag. Without \p hasEndOffset the last bag ends at \p totalLength.
+template <typename BagFn>
+void libjit_fp16_offsets_bags(BagFn bag, uint16_t *dest, const uint16_t *data,
+                              const uint16_t *weights, const int32_t *indices,
+                              const int32_t *offsets, dim_t segments,
+                              dim_t lineSize, dim_t totalLength,
+                              bool hasEndOffset) {
+  if (hasEndOffset) {
+    --segments;
+  }
+  for (dim_t i = 0; i < segments; i++) {
+    const dim_t end =
+        !hasEndOffset && i == segments - 1 ? totalLength : offsets[i + 1];
+    bag(dest + i * lineSize, data, weights, indices, offsets[i], end,
+        lineSize);
+  }
+}
+
+/// State of a product-quantized SparseLengthsWeightedSum kernel, with indices
+/// of type \p IT.
+template <typename IT> struct PQSLWSArgs {
+  float *dest;
+  const uint8_t *codes;
+  const float *codebooks;
+  const float *weights;
+  const IT *indices;
+  const int32_t *lengths;
+  dim_t numSubspaces;
+  dim_t numCentroids;
+  dim_t subDim;
+};
+
+/// Compute the segments [\p begin, \p end) of a product-quantized
+/// SparseLengthsWeightedSum. The rows are never decoded: every code selects a
+/// subvector of the codebook of its subspace, which is small enough to stay
+/// in cache, and only the code rows are read from the table.
+template <typename IT>
+void libjit_pq_slws_segments(void *ctx, dim_t begin, dim_t end) {
+  const PQSLWSArgs<IT> &a = *static_cast<PQSLWSArgs<IT> *>(ctx);
+  const dim_t outDim = a.numSubspaces * a.subDim;
+  dim_t curIdx = 0;
+  for (dim_t i = 0; i < begin; i++) {
+    curIdx += a.lengths[i];
+  }
+  dim_t lastIdx = curIdx;
+  for (dim_t i = begin; i < end; i++) {
+    lastIdx += a.lengths[i];
+  }
+
+  for (dim_t i = begin; i < end; i++) {
+    float *out = a.dest + i * outDim;
+    memset(out, 0, outDim * sizeof(float));
+    for (dim_t j = 0, e = a.lengths[i]; j < e; j++, curIdx++) {
+      if (curIdx + fusedRowwisePrefetchDistance < lastIdx) {
+        libjit_prefetch_row(
+            a.codes +
+                a.indices[curIdx + fusedRowwisePrefetchDistance] *
+                    a.numSubspaces,
+            a.numSubspaces);
+      }
+      const float weight = a.weights[curIdx];
+      const uint8_t *codes = a.codes + a.indices[curIdx] * a.numSubspaces;
+      for (dim_t s = 0; s < a.numSubspaces; s++) {
+        const float *centroid =
+            a.codebooks + (s * a.numCentroids + codes[s]) * a.subDim;
+        float *outSub = out + s * a.subDim;
+        for (dim_t k = 0; k < a.subDim; k++) {
+          outSub[k] += weight * centroid[k];
+        }
+      }
+    }
+  }
+}
+
+template <typename IT>
+void libjit_product_quantized_sparse_lengths_weighted_sum_generic(
+    float *dest, const uint8_t *codes, const float *codebooks,
+    const float *weights, const IT *indices, const int32_t *lengths,
+    dim_t segments, dim_t numSubspaces, dim_t numCentroids, dim_t subDim) {
+  PQSLWSArgs<IT> args{dest,    codes,        codebooks,    weights, indices,
+                      lengths, numSubspaces, numCentroids, subDim};
+  libjit_parallel_for(segments, libjit_pq_slws_segments<IT>, &args);
+}
+} // namespace
+
+extern "C" {
+
+void libjit_product_quantized_sparse_lengths_weighted_sum_f_i32(
+    float *dest, const uint8_t *codes, const float *codebooks,
+    const float *weights, const int32_t *indices, const int32_t *lengths,
+    dim_t segments, dim_t numSubspaces, dim_t numCentroids, dim_t subDim) {
+  libjit_product_quantized_sparse_lengths_weighted_sum_generic(
+      dest, codes, codebooks, weights, indices, lengths, segments,
+      numSubspaces, numCentroids, subDim);
+}
+
+void libjit_product_quantized_sparse_lengths_weighted_sum_f_u(
+    float *dest, const uint8_t *codes, const float *codebooks,
+    const float *weights, const size_t *indices, const int32_t *lengths,
+    dim_t segments, dim_t numSubspaces, dim_t numCentroids, dim_t subDim) {
+  libjit_product_quantized_sparse_lengths_weighted_sum_generic(
+      dest, codes, codebooks, weights, indices, lengths, segments,
+      numSubspaces, numCentroids, subDim);
+}
+
+void libjit_int_nbit_split_embedding_bags_f_i32(
+    float *dest, const uint8_t *devWeights, const uint8_t *uvmWeights,
+    const int32_t *weightsPlacements, const int32_t *weightsOffsets,
+    const uint8_t *weightsTys, const int32_t *dimOffsets,
+    const int32_t *indices, const int32_t *offsets, const float *indiceWeights,
+    dim_t numTables, dim_t numBatches, dim_t totalDims, bool meanPooling,
+    bool scaleOffsetFP32, int32_t rowAlignment) {
+  libjit_int_nbit_split_embedding_bags_generic(
+      dest, devWeights, uvmWeights, weightsPlacements, weightsOffsets,
+      weightsTys, dimOffsets, indices, offsets, indiceWeights, numTables,
+      numBatches, totalDims, meanPooling, scaleOffsetFP32, rowAlignment);
+}
+
+void libjit_int_nbit_split_embedding_bags_f_u(
+    float *dest, const uint8_t *devWeights, const uint8_t *uvmWeights,
+    const int32_t *weightsPlacements, const int64_t *weightsOffsets,
+    const uint8_t *weightsTys, const int32_t *dimOffsets,
+    const int32_t *indices, const int32_t *offsets, const float *indiceWeights,
+    dim_t numTables, dim_t numBatches, dim_t totalDims, bool meanPooling,
+    bool scaleOffsetFP32, int32_t rowAlignment) {
+  libjit_int_nbit_split_embedding_bags_generic(
+      dest, devWeights, uvmWeights, weightsPlacements, weightsOffsets,
+      weightsTys, dimOffsets, indices, offsets, indiceWeights, numTables,
+      numBatches, totalDims, meanPooling, scaleOffsetFP32, rowAlignment);
+}
+
+/// Float16 SparseLengthsSum, SparseLengthsWeightedSum and EmbeddingBag
+/// kernels. The tables stay in half precision and every row is widened to
+/// float in registers, so that the rows read from memory are half the size of
+/// float rows. Use the variants \p SUFFIX with the bag kernel \p BAG.
+#define DEFINE_FP16_BAG_KERNELS(SUFFIX, BAG)                                   \
+  void libjit_sparse_lengths_sum##SUFFIX##_fp16_u(                             \
+      uint16_t *dest, const uint16_t *data, const int64_t *indices,            \
+      const int32_t *lengths, dim_t segments, dim_t lineSize) {                \
+    libjit_fp16_lengths_bags(BAG<int64_t>, dest, data, nullptr, indices,       \
+                             lengths, segments, lineSize);                     \
+  }                                                                            \
+  void libjit_sparse_lengths_sum##SUFFIX##_fp16_i32(                           \
+      uint16_t *dest, const uint16_t *data, const int32_t *indices,            \
+      const int32_t *lengths, dim_t segments, dim_t lineSize) {                \
+    libjit_fp16_lengths_bags(BAG<int32_t>, dest, data, nullptr, indices,       \
+                             lengths, segments, lineSize);                     \
+  }                                                                            \
+  void libjit_sparse_lengths_weighted_sum##SUFFIX##_fp16_u(                    \
+      uint16_t *dest, const uint16_t *data, const uint16_t *weights,           \
+      const int64_t *indices, const int32_t *lengths, dim_t segments,          \
+      dim_t lineSize) {                                                        \
+    libjit_fp16_lengths_bags(BAG<int64_t>, dest, data, weights, indices,       \
+                             lengths, segments, lineSize);                     \
+  }                                                                            \
+  void libjit_sparse_lengths_weighted_sum##SUFFIX##_fp16_i32(                  \
+      uint16_t *dest, const uint16_t *data, const uint16_t *weights,           \
+      const int32_t *indices, const int32_t *lengths, dim_t segments,          \
+      dim_t lineSize) {                                                        \
+    libjit_fp16_lengths_bags(BAG<int32_t>, dest, data, weights, indices,       \
+                             lengths, segments, lineSize);                     \
+  }                                                                            \
+  void libjit_embedding_bag##SUFFIX##_fp16(                                    \
+      uint16_t *dest, const uint16_t *data, const uint16_t *weights,           \
+      const int32_t *indices, const int32_t *offsets, dim_t segments,          \
+      dim_t lineSize, dim_t totalLength, bool hasEndOffset) {                  \
+    libjit_fp16_offsets_bags(BAG<int32_t>, dest, data, weights, indices,       \
+                             offsets, segments, lineSize, totalLength,         \
+                             hasEndOffset);                                    \
+  }
+
+DEFINE_FP16_BAG_KERNELS(, libjit_fp16_bag)
+#ifdef LIBJIT_F16C_KERNELS
+DEFINE_FP16_BAG_KERNELS(_f16c, libjit_fp16_bag_f16c)
+#endif
+#undef DEFINE_FP16_BAG_KERNELS
+
+} // extern "C"
@@ -0,0 +1,322 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../../../LLVMIRCodeGen/libjit/libjit_defs.h"
+
+namespace {
+/// Number of output channels of a task of the int4 FullyConnected kernel.
+const dim_t int4FCChannelBlock = 8;
+
+/// Number of input rows computed together, which share the dequantization of
+/// the weights.
+const dim_t int4FCRowBlock = 4;
+
+/// Number of output channels of a task of the dynamic quantized
+/// FullyConnected kernel, whose accumulators are kept in registers.
+const dim_t dynamicFCChannelBlock = 64;
+
+/// Number of output columns of a block of the block-sparse FullyConnected
+/// weights, one float8 vector.
+const dim_t sparseFCBlock = 8;
+
+/// Number of input rows computed together by the block-sparse FullyConnected,
+/// which share the loads of the weights.
+const dim_t sparseFCRowBlock = 4;
+
+/// Vector of 8 int8 weights.
+typedef int8_t char8 __attribute__((vector_size(8)));
+
+/// State of an int4 groupwise quantized FullyConnected kernel, see
+/// libjit_int4_groupwise_fc_f.
+struct Int4FCArgs {
+  float *dest;
+  const float *input;
+  const uint8_t *weights;
+  const uint16_t *scales;
+  const uint16_t *offsets;
+  const float *bias;
+  dim_t M;
+  dim_t K;
+  dim_t N;
+  dim_t groupSize;
+};
+
+/// Compute the output channels of the channel blocks [\p begin, \p end). The
+/// weights of a channel are dequantized 16 at a time, straight from their
+/// packed nibbles, and multiplied with the matching elements of
+/// int4FCRowBlock input rows, so that the weights are only read from memory
+/// in their 4-bit form.
+void libjit_int4_fc_channels(void *ctx, dim_t begin, dim_t end) {
+  const Int4FCArgs &a = *static_cast<Int4FCArgs *>(ctx);
+  const dim_t numGroups = (a.K + a.groupSize - 1) / a.groupSize;
+  const dim_t rowBytes = (a.K + 1) / 2;
+
+  for (dim_t j = begin * int4FCChannelBlock;
+       j < MIN(end * int4FCChannelBlock, a.N); j++) {
+    const uint8_t *w = a.weights + j * rowBytes;
+    for (dim_t i0 = 0; i0 < a.M; i0 += int4FCRowBlock) {
+      const dim_t numRows = MIN(int4FCRowBlock, a.M - i0);
+      float8 acc8[int4FCRowBlock];
+      float acc[int4FCRowBlock];
+      for (dim_t r = 0; r < int4FCRowBlock; r++) {
+        acc8[r] = BroadcastFloat8(0.0f);
+        acc[r] = 0;
+      }
+      for (dim_t g = 0; g < numGroups; g++) {
+        const float scale = libjit_fp16_to_fp32(a.scales[j * numGroups + g]);
+        const float offset = libjit_fp16_to_fp32(a.offsets[j * numGroups + g]);
+        const float8 scale8 = BroadcastFloat8(scale);
+        const float8 offset8 = BroadcastFloat8(offset);
+        const dim_t gEnd = MIN((g + 1) * a.groupSize, a.K);
+        // Groups are of even size, so they start on a byte.
+        dim_t k = g * a.groupSize;
+        for (; k + 16 <= gEnd; k += 16) {
+          uchar8 q;
+          memcpy(&q, w + k / 2, sizeof(q));
+          const uchar8 lo = q & (uint8_t)0x0f;
+          const uchar8 hi = q >> (uint8_t)4;
+          const uchar8 first =
+              __builtin_shufflevector(lo, hi, 0, 8, 1, 9, 2, 10, 3, 11);
+          const uchar8 second =
+              __builtin_shufflevector(lo, hi, 4, 12, 5, 13, 6, 14, 7, 15);
+          const float8 w0 =
+              __builtin_convertvector(first, float8) * scale8 + offset8;
+          const float8 w1 =
+              __builtin_convertvector(second, float8) * scale8 + offset8;
+          for (dim_t r = 0; r < numRows; r++) {
+            const float *x = a.input + (i0 + r) * a.K + k;
+            acc8[r] += w0 * LoaduFloat8(x) + w1 * LoaduFloat8(x + 8);
+          }
+        }
+        for (; k < gEnd; k++) {
+          const uint8_t q = (k % 2) ? (w[k / 2] >> 4) : (w[k / 2] & 0x0f);
+          const float wk = scale * q + offset;
+          for (dim_t r = 0; r < numRows; r++) {
+            acc[r] += wk * a.input[(i0 + r) * a.K + k];
+          }
+        }
+      }
+      for (dim_t r = 0; r < numRows; r++) {
+        a.dest[(i0 + r) * a.N + j] =
+            libjit_reduce_add_float8(acc8[r]) + acc[r] + a.bias[j];
+      }
+    }
+  }
+}
+
+/// State of a block-sparse FullyConnected kernel, see libjit_fc_sparse_f.
+struct SparseFCArgs {
+  float *dest;
+  const float *input;
+  const float *values;
+  const int32_t *blockRows;
+  const int32_t *blockPtr;
+  const float *bias;
+  dim_t M;
+  dim_t K;
+  dim_t N;
+};
+
+/// Compute the output columns of the blocks [\p begin, \p end). Only the
+/// non-zero blocks of the weights are visited: each is a float8 vector of the
+/// weights of one input element, broadcast and accumulated into the outputs
+/// of sparseFCRowBlock input rows.
+void libjit_fc_sparse_blocks(void *ctx, dim_t begin, dim_t end) {
+  const SparseFCArgs &a = *static_cast<SparseFCArgs *>(ctx);
+  for (dim_t b = begin; b < end; b++) {
+    const dim_t j0 = b * sparseFCBlock;
+    const dim_t numCols = MIN(sparseFCBlock, a.N - j0);
+    float biasBlock[sparseFCBlock] = {0};
+    memcpy(biasBlock, a.bias + j0, numCols * sizeof(float));
+    const float8 bias8 = LoaduFloat8(biasBlock);
+    for (dim_t i0 = 0; i0 < a.M; i0 += sparseFCRowBlock) {
+      const dim_t numRows = MIN(sparseFCRowBlock, a.M - i0);
+      float8 acc8[sparseFCRowBlock];
+      for (dim_t r = 0; r < sparseFCRowBlock; r++) {
+        acc8[r] = bias8;
+      }
+      const float *x = a.input + i0 * a.K;
+      for (int32_t p = a.blockPtr[b]; p < a.blockPtr[b + 1]; p++) {
+        const float8 w8 = LoaduFloat8(a.values + p * sparseFCBlock);
+        const dim_t k = a.blockRows[p];
+        for (dim_t r = 0; r < numRows; r++) {
+          acc8[r] += BroadcastFloat8(x[r * a.K + k]) * w8;
+        }
+      }
+      for (dim_t r = 0; r < numRows; r++) {
+        float *dest = a.dest + (i0 + r) * a.N + j0;
+        if (numCols == sparseFCBlock) {
+          StoreuFloat8(dest, acc8[r]);
+          continue;
+        }
+        float out[sparseFCBlock];
+        StoreuFloat8(out, acc8[r]);
+        memcpy(dest, out, numCols * sizeof(float));
+      }
+    }
+  }
+}
+
+/// State of a dynamic quantized FullyConnected kernel, see
+/// libjit_dynamic_quantized_fc_f.
+struct DynamicFCArgs {
+  float *dest;
+  const float *input;
+  const int8_t *weights;
+  const float *bias;
+  dim_t K;
+  dim_t N;
+  dim_t numChannelBlocks;
+  float wScale;
+  int32_t wOffset;
+};
+
+/// \returns the scale of the symmetric int8 quantization of the \p size
+/// elements of \p x, the one chooseQuantizationParams picks for their range.
+inline float getSymmetricScale(const float *x, dim_t size) {
+  float8 min8 = BroadcastFloat8(0.0f);
+  float8 max8 = BroadcastFloat8(0.0f);
+  dim_t k = 0;
+  for (; k + 8 <= size; k += 8) {
+    const float8 x8 = LoaduFloat8(x + k);
+    min8 = libjit_min_float8(min8, x8);
+    max8 = libjit_max_float8(max8, x8);
+  }
+  float min = 0, max = 0;
+  for (dim_t i = 0; i < 8; i++) {
+    min = MIN(min, min8[i]);
+    max = MAX(max, max8[i]);
+  }
+  for (; k < size; k++) {
+    min = MIN(min, x[k]);
+    max = MAX(max, x[k]);
+  }
+  const float scale = MAX(min / -128.0f, max / 127.0f);
+  return scale == 0 ? 0.1f : scale;
+}
+
+/// Compute the tasks [\p begin, \p end), task t computing the block of
+/// dynamicFCChannelBlock output channels t % numChannelBlocks of the input
+/// row t / numChannelBlocks. The row is quantized symmetrically to int8 with
+/// the scale of its range, as it is read, and multiplied with the int8
+/// weights accumulating in int32, before the result is dequantized and the
+/// bias added.
+void libjit_dynamic_fc_blocks(void *ctx, dim_t begin, dim_t end) {
+  const DynamicFCArgs &a = *static_cast<DynamicFCArgs *>(ctx);
+  for (dim_t task = begin; task < end; task++) {
+    const dim_t i = task / a.numChannelBlocks;
+    const dim_t j0 = (task % a.numChannelBlocks) * dynamicFCChannelBlock;
+    const dim_t numCols = MIN(dynamicFCChannelBlock, a.N - j0);
+    const dim_t numVecs = numCols / 8;
+    const float *x = a.input + i * a.K;
+    const float scale = getSymmetricScale(x, a.K);
+
+    int32x8 acc8[dynamicFCChannelBlock / 8];
+    int32_t acc[8];
+    for (dim_t v = 0; v < dynamicFCChannelBlock / 8; v++) {
+      acc8[v] = (int32x8){0};
+    }
+    for (dim_t t = 0; t < 8; t++) {
+      acc[t] = 0;
+    }
+    int32_t rowSum = 0;
+    for (dim_t k = 0; k < a.K; k++) {
+      const int32_t q = libjit_clip_i8((int32_t)nearbyintf(x[k] / scale));
+      rowSum += q;
+      const int32x8 q8 = (int32x8){0} + q;
+      const int8_t *w = a.weights + k * a.N + j0;
+      for (dim_t v = 0; v < numVecs; v++) {
+        char8 w8;
+        memcpy(&w8, w + v * 8, sizeof(w8));
+        acc8[v] += q8 * __builtin_convertvector(w8, int32x8);
+      }
+      for (dim_t t = numVecs * 8; t < numCols; t++) {
+        acc[t - numVecs * 8] += q * w[t];
+      }
+    }
+
+    // The input offset is 0, so the weight offset only contributes its
+    // product with the sum of the quantized row.
+    const float outScale = scale * a.wScale;
+    const int32_t correction = a.wOffset * rowSum;
+    float *dest = a.dest + i * a.N + j0;
+    const float *bias = a.bias + j0;
+    for (dim_t v = 0; v < numVecs; v++) {
+      StoreuFloat8(dest + v * 8,
+                   libjit_int_to_float(acc8[v] - correction) *
+                           BroadcastFloat8(outScale) +
+                       LoaduFloat8(bias + v * 8));
+    }
+    for (dim_t t = numVecs * 8; t < numCols; t++) {
+      dest[t] = (acc[t - numVecs * 8] - correction) * outScale + bias[t];
+    }
+  }
+}
+} // namespace
+
+extern "C" {
+
+/// FullyConnected of the {M, K} float \p input and the {N, K} 4-bit weights
+/// \p weights, packed two per byte with the even elements in the low nibbles,
+/// adding the float \p bias and writing the {M, N} float \p dest. The weights
+/// of a row are dequantized in groups of \p groupSize elements with the
+/// {N, numGroups} float16 \p scales and \p offsets. The weights are never
+/// dequantized in memory, see libjit_int4_fc_channels.
+void libjit_int4_groupwise_fc_f(float *dest, const float *input,
+                                const uint8_t *weights, const uint16_t *scales,
+                                const uint16_t *offsets, const float *bias,
+                                dim_t M, dim_t K, dim_t N, dim_t groupSize) {
+  Int4FCArgs args{dest, input, weights, scales, offsets,
+                  bias, M,     K,       N,      groupSize};
+  libjit_parallel_for((N + int4FCChannelBlock - 1) / int4FCChannelBlock,
+                      libjit_int4_fc_channels, &args);
+}
+
+/// FullyConnected of the {M, K} float \p input and the {K, N} float weights
+/// stored as their non-zero 1x8 blocks, adding the float \p bias and writing
+/// the {M, N} float \p dest. The blocks of the output columns
+/// [8 * b, 8 * b + 8) are [\p blockPtr[b], \p blockPtr[b + 1]), the block p
+/// holding in \p values[8 * p] the 8 weights of the row \p blockRows[p], see
+/// libjit_fc_sparse_blocks.
+void libjit_fc_sparse_f(float *dest, const float *input, const float *values,
+                        const int32_t *blockRows, const int32_t *blockPtr,
+                        const float *bias, dim_t M, dim_t K, dim_t N) {
+  SparseFCArgs args{dest, input, values, blockRows, blockPtr, bias, M, K, N};
+  libjit_parallel_for((N + sparseFCBlock - 1) / sparseFCBlock,
+                      libjit_fc_sparse_blocks, &args);
+}
+
+/// FullyConnected of the {M, K} float \p input and the {K, N} int8 weights
+/// \p weights of scale \p wScale and offset \p wOffset, adding the float
+/// \p bias and writing the {M, N} float \p dest. Every row of the input is
+/// quantized symmetrically to int8 at run time with the scale of its range,
+/// see libjit_dynamic_fc_blocks.
+void libjit_dynamic_quantized_fc_f(float *dest, const float *input,
+                                   const int8_t *weights, const float *bias,
+                                   dim_t M, dim_t K, dim_t N, float wScale,
+                                   int32_t wOffset) {
+  const dim_t numChannelBlocks =
+      (N + dynamicFCChannelBlock - 1) / dynamicFCChannelBlock;
+  DynamicFCArgs args{dest, input,           weights, bias, K,
+                     N,    numChannelBlocks, wScale,  wOffset};
+  libjit_parallel_for(M * numChannelBlocks, libjit_dynamic_fc_blocks, &args);
+}
+
+} // extern "C"
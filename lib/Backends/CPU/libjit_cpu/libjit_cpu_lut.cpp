@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../../LLVMIRCodeGen/libjit/libjit_defs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIBJIT_VBMI_KERNELS
+#define LIBJIT_VBMI_TARGET                                                     \
+  __attribute__((target("avx512f,avx512bw,avx512vbmi")))
+#endif
+
+namespace {
+/// Number of elements of a task of the lookup table kernels.
+const dim_t lookupTableBlock = 16384;
+
+/// State of an int8 lookup table kernel, see libjit_intlookuptable_i8.
+struct LookupTableArgs {
+  int8_t *dest;
+  const int8_t *src;
+  const int8_t *mapping;
+  dim_t size;
+};
+
+/// Maps the elements of the blocks [\p begin, \p end) with the table of
+/// \p ctx, one element at a time.
+void libjit_lookup_blocks(void *ctx, dim_t begin, dim_t end) {
+  const LookupTableArgs &a = *static_cast<const LookupTableArgs *>(ctx);
+  const dim_t last = MIN(end * lookupTableBlock, a.size);
+  for (dim_t i = begin * lookupTableBlock; i < last; i++) {
+    a.dest[i] = a.mapping[a.src[i] + 128];
+  }
+}
+
+#ifdef LIBJIT_VBMI_KERNELS
+/// \returns the entries of the table \p table0 - \p table3, held in four
+/// registers, at the positions \p src offset by 128. The low 7 bits of the
+/// unsigned position pick an entry of the lower or upper two registers with a
+/// permutation, and the top bit picks between the two results.
+LIBJIT_VBMI_TARGET inline __m512i lookup64(__m512i src, __m512i table0,
+                                           __m512i table1, __m512i table2,
+                                           __m512i table3) {
+  __m512i idx = _mm512_xor_si512(src, _mm512_set1_epi8((char)0x80));
+  __m512i low = _mm512_permutex2var_epi8(table0, idx, table1);
+  __m512i high = _mm512_permutex2var_epi8(table2, idx, table3);
+  return _mm512_mask_blend_epi8(_mm512_movepi8_mask(idx), low, high);
+}
+
+/// Maps the elements of the blocks [\p begin, \p end) with the table of
+/// \p ctx, 64 elements at a time, see lookup64.
+LIBJIT_VBMI_TARGET void libjit_lookup_blocks_vbmi(void *ctx, dim_t begin,
+                                                  dim_t end) {
+  const LookupTableArgs &a = *static_cast<const LookupTableArgs *>(ctx);
+  const __m512i table0 = _mm512_loadu_si512(a.mapping);
+  const __m512i table1 = _mm512_loadu_si512(a.mapping + 64);
+  const __m512i table2 = _mm512_loadu_si512(a.mapping + 128);
+  const __m512i table3 = _mm512_loadu_si512(a.mapping + 192);
+  const dim_t last = MIN(end * lookupTableBlock, a.size);
+  dim_t i = begin * lookupTableBlock;
+  for (; i + 64 <= last; i += 64) {
+    __m512i src = _mm512_loadu_si512(a.src + i);
+    _mm512_storeu_si512(a.dest + i,
+                        lookup64(src, table0, table1, table2, table3));
+  }
+  if (i < last) {
+    __mmask64 tail = _cvtu64_mask64(~0ULL >> (64 - (last - i)));
+    __m512i src = _mm512_maskz_loadu_epi8(tail, a.src + i);
+    _mm512_mask_storeu_epi8(a.dest + i, tail,
+                            lookup64(src, table0, table1, table2, table3));
+  }
+}
+#endif
+} // namespace
+
+extern "C" {
+
+/// Writes to the \p size elements of \p dest the entries of the 256-entry
+/// table \p mapping at the positions given by the \p size elements of \p src,
+/// offset by 128.
+void libjit_intlookuptable_i8(int8_t *dest, const int8_t *src,
+                              const int8_t *mapping, dim_t size) {
+  LookupTableArgs args{dest, src, mapping, size};
+  libjit_parallel_for((size + lookupTableBlock - 1) / lookupTableBlock,
+                      libjit_lookup_blocks, &args);
+}
+
+#ifdef LIBJIT_VBMI_KERNELS
+/// Same as libjit_intlookuptable_i8, with the byte permutations of
+/// AVX512-VBMI, see libjit_lookup_blocks_vbmi.
+void libjit_intlookuptable_vbmi_i8(int8_t *dest, const int8_t *src,
+                                   const int8_t *mapping, dim_t size) {
+  LookupTableArgs args{dest, src, mapping, size};
+  libjit_parallel_for((size + lookupTableBlock - 1) / lookupTableBlock,
+                      libjit_lookup_blocks_vbmi, &args);
+}
+#endif
+
+} // extern "C"
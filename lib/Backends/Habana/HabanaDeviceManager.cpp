@@ -26,6 +26,7 @@
 #include "synapse.h"
 
 #include <glog/logging.h>
+#include <algorithm>
 #include <limits>
 
 using namespace glow;
@@ -39,8 +40,21 @@ static llvm::cl::opt<unsigned, /* ExternalStorage */ true> GlowHabanaMemoryOpt(
     llvm::cl::desc("Amount of DRAM to allocate per Habana device in kilobytes"),
     llvm::cl::location(flags::HabanaMemory));
 
+static llvm::cl::opt<unsigned, /* ExternalStorage */ true> GlowHabanaRunnersOpt(
+    "glow-habana-runners",
+    llvm::cl::desc("Number of threads enqueueing the runs of each Habana "
+                   "device"),
+    llvm::cl::location(flags::HabanaRunners));
+
+static llvm::cl::opt<unsigned, /* ExternalStorage */ true> GlowHabanaWaitersOpt(
+    "glow-habana-waiters",
+    llvm::cl::desc("Number of threads waiting for the runs of each Habana "
+                   "device and copying their outputs"),
+    llvm::cl::location(flags::HabanaWaiters));
+
 DeviceManager *createHabanaDeviceManager(const DeviceConfig &config) {
-  return new HabanaDeviceManager(config);
+  return new HabanaDeviceManager(config, std::max(flags::HabanaRunners, 1u),
+                                 std::max(flags::HabanaWaiters, 1u));
 }
 } // namespace runtime
 } // namespace glow
@@ -351,10 +365,10 @@ void HabanaDeviceManager::runFunctionImpl(RunIdentifierTy runId,
 
   // Give the handle to the wait thread pool to wait on and call the callback
   // for.
-  waitPool_->submit([this, runId, function, ioBufferPool,
-                     functionName = std::move(functionName),
-                     ctx = std::move(ctx),
-                     resultCB = std::move(resultCB)]() mutable {
+  waitPool_->post([this, runId, function, ioBufferPool,
+                   functionName = std::move(functionName),
+                   ctx = std::move(ctx),
+                   resultCB = std::move(resultCB)]() mutable {
     DCHECK(resultCB != nullptr);
 
     TRACE_EVENT_SCOPE(ctx->getTraceContext(), TraceLevel::RUNTIME,
@@ -435,9 +449,9 @@ HabanaDeviceManager::runFunction(std::string functionName,
   DCHECK(resultCB != nullptr);
 
   RunIdentifierTy runId = runIdentifier_++;
-  runPool_->submit([this, runId, functionName = std::move(functionName),
-                    ctx = std::move(ctx),
-                    resultCB = std::move(resultCB)]() mutable {
+  runPool_->post([this, runId, functionName = std::move(functionName),
+                  ctx = std::move(ctx),
+                  resultCB = std::move(resultCB)]() mutable {
     runFunctionImpl(runId, std::move(functionName), std::move(ctx),
                     std::move(resultCB));
   });
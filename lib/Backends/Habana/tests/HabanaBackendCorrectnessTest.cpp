@@ -33,6 +33,7 @@ std::set<std::string> glow::backendTestBlacklist = {
     "nonSquareKernelConvTest/0",
     "nonSquarePaddingConvTest/0",
     "nonSquareStrideConvTest/0",
+    "quantizationProfileTest/0",
     "quantizedConvTest/0",
     "smallConv/0",
     "softmaxGradTest/0",
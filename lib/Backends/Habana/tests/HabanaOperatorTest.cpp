@@ -316,6 +316,7 @@ std::set<std::string> glow::backendTestBlacklist = {
     "PyTorchMultipleLayerLSTMFP16/0",
     "DynamicQuantizedFullyConnectedBasic/0",
     "DynamicQuantizedFullyConnectedStrongWeights/0",
+    "DynamicQuantizedFullyConnected_Float/0",
     "DynamicRowwiseQuantizedFullyConnectedBasic/0",
     "matmulQuantized_InterpCompareParClone/0",
     "MaxPool/0",
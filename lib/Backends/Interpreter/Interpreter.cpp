@@ -66,6 +66,7 @@ Interpreter::compileIRWithoutConstants(std::unique_ptr<IRFunction> IR) const {
   MemoryAllocator constantWeightsAllocator("ConstantWeights", 0);
   MemoryAllocator placeholderWeightsAllocator("PlaceholderWeights", 0);
   MemoryAllocator activationsAllocator("Activations", 0);
+  activationsAllocator.setPlanner(getActivationsMemoryPlanner());
   runtime::RuntimeBundle bundle = runtime::RuntimeBundle::create(
       *IR, constantWeightsAllocator, placeholderWeightsAllocator,
       activationsAllocator);
@@ -169,6 +170,13 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
                DynamicRowwiseQuantizedFullyConnectedNode::OffsetsIdx) ==
                ElemKind::Int32ITy;
 
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+        {ElemKind::FloatTy},
+        {Int4GroupwiseQuantizedFullyConnectedNode::WeightsIdx,
+         Int4GroupwiseQuantizedFullyConnectedNode::ScalesIdx,
+         Int4GroupwiseQuantizedFullyConnectedNode::OffsetsIdx});
+
   case Kinded::Kind::MatMulNodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind(
         {ElemKind::FloatTy, ElemKind::Float16Ty, ElemKind::BFloat16Ty,
@@ -224,6 +232,8 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
          ElemKind::Int8QTy});
   case Kinded::Kind::LocalResponseNormalizationNodeKind:
   case Kinded::Kind::LayerNormalizationNodeKind:
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+  case Kinded::Kind::FusedSGDNodeKind:
   case Kinded::Kind::LogNodeKind:
   case Kinded::Kind::TanhNodeKind:
   case Kinded::Kind::ExpNodeKind:
@@ -569,6 +579,19 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
     }
   }
 
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::FloatTy},
+               {ProductQuantizedSparseLengthsWeightedSumNode::CodesIdx,
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx,
+                ProductQuantizedSparseLengthsWeightedSumNode::LengthsIdx}) &&
+           (NI.getInElemTy(
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx) ==
+                ElemKind::Int64ITy ||
+            NI.getInElemTy(
+                ProductQuantizedSparseLengthsWeightedSumNode::IndicesIdx) ==
+                ElemKind::Int32ITy);
+
   case Kinded::Kind::LengthsRangeFillNodeKind:
   case Kinded::Kind::LengthsToRangesNodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::Int32ITy});
@@ -669,6 +692,19 @@ bool Interpreter::isOpSupported(const NodeInfo &NI) const {
                 ElemKind::UInt8FusedFP16QTy);
   }
 
+  case Kinded::Kind::BeamSearchStepNodeKind:
+    return NI.allInputsAndOutputsHaveSameElemKind(
+               {ElemKind::FloatTy}, {BeamSearchStepNode::StateIdx},
+               {BeamSearchStepNode::TokensIdx,
+                BeamSearchStepNode::PrevIndicesIdx,
+                BeamSearchStepNode::NewStateIdx}) &&
+           NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+               NI.getOutElemTy(BeamSearchStepNode::PrevIndicesIdx) &&
+           ((NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+             ElemKind::Int64ITy) ||
+            (NI.getOutElemTy(BeamSearchStepNode::TokensIdx) ==
+             ElemKind::Int32ITy));
+
   case Kinded::Kind::TopKNodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind(
                {ElemKind::FloatTy, ElemKind::Float16Ty, ElemKind::BFloat16Ty,
@@ -1076,7 +1112,13 @@ bool Interpreter::shouldLower(const Node *N) const {
   case Kinded::Kind::FullyConnectedNodeKind:
   case Kinded::Kind::BatchNormalizationNodeKind:
   case Kinded::Kind::BucketizeNodeKind:
+  case Kinded::Kind::ScaledDotProductAttentionNodeKind:
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind:
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind:
+  case Kinded::Kind::FusedSGDNodeKind:
     return false;
+  case Kinded::Kind::BeamSearchStepNodeKind:
+    return !isOpSupported(NodeInfo(*N));
   case Kinded::Kind::LayerNormalizationNodeKind:
     return interpreter::flags::LowerLayerNormalization;
   case Kinded::Kind::BatchMatMulNodeKind:
@@ -16,18 +16,161 @@
 
 #include "glow/Backends/Interpreter/InterpreterFunction.h"
 
+#include "glow/Flags/Flags.h"
 #include "glow/IR/IR.h"
 #include "glow/IR/IRUtils.h"
 #include "glow/IR/Instrs.h"
+#include "glow/Support/Memory.h"
 #include "glow/Support/ThreadPool.h"
 
 #include "llvm/Support/Casting.h"
 
+#include <algorithm>
+#include <thread>
+
 using namespace glow;
 
+namespace {
+/// \returns the pool of worker threads shared by the kernels of all
+/// Interpreter functions.
+ThreadPool &getIntraOpThreadPool() {
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()),
+                         "InterpreterIntraOp");
+  return pool;
+}
+
+/// Minimum number of inner iterations of a chunk of a parallel kernel, below
+/// which handing it to another thread costs more than it saves.
+constexpr uint64_t kMinChunkWork = 1 << 16;
+
+/// \returns the values of the operands of \p I which only compute along their
+/// first dimension, whose rows depend only on the same rows of the others:
+/// the batch of the FCs, the segments of the SLS, and the operands of the
+/// data parallel instructions of the shape of their result.
+llvm::SmallVector<const Value *, 4> getRowValues(const Instruction &I) {
+  if (auto *FC = llvm::dyn_cast<FullyConnectedInst>(&I)) {
+    return {FC->getDest(), FC->getSrc()};
+  }
+  if (auto *FC = llvm::dyn_cast<RowwiseQuantizedFullyConnectedInst>(&I)) {
+    return {FC->getDest(), FC->getSrc()};
+  }
+  if (auto *FC = llvm::dyn_cast<Int4GroupwiseQuantizedFullyConnectedInst>(&I)) {
+    return {FC->getDest(), FC->getSrc()};
+  }
+  if (auto *SLS = llvm::dyn_cast<SparseLengthsSumInst>(&I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  if (auto *SLS = llvm::dyn_cast<SparseLengthsWeightedSumInst>(&I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  if (auto *SLS =
+          llvm::dyn_cast<RowwiseQuantizedSparseLengthsWeightedSumInst>(&I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  if (auto *SLS =
+          llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumInst>(
+              &I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  if (auto *SLS =
+          llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsSumInst>(&I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  if (auto *SLS =
+          llvm::dyn_cast<ProductQuantizedSparseLengthsWeightedSumInst>(&I)) {
+    return {SLS->getDest(), SLS->getLengths()};
+  }
+  // Splat and Touch read nothing, NonZero packs its result.
+  if (!I.isDataParallel() || llvm::isa<SplatInst>(&I) ||
+      llvm::isa<TouchInst>(&I) || llvm::isa<NonZeroInst>(&I)) {
+    return {};
+  }
+  llvm::SmallVector<const Value *, 4> values;
+  for (const auto &op : I.getOperands()) {
+    if (op.second == OperandKind::Out) {
+      for (const auto &other : I.getOperands()) {
+        if (other.first->dims() == op.first->dims()) {
+          values.push_back(other.first);
+        }
+      }
+      break;
+    }
+  }
+  return values;
+}
+
+/// Append to \p rowOperands the indices of the row operands of \p I, whose
+/// operands have the slots \p slots, if they all have the same rows, at least
+/// one of them is read, and none is a tensor view according to
+/// \p viewSources.
+void collectRowOperands(const Instruction &I, const unsigned *slots,
+                        const std::vector<int> &viewSources,
+                        std::vector<unsigned> &rowOperands) {
+  auto values = getRowValues(I);
+  if (values.empty() || values[0]->dims().empty()) {
+    return;
+  }
+  auto ops = I.getOperands();
+  size_t begin = rowOperands.size();
+  bool hasInput = false;
+  for (unsigned i = 0, e = ops.size(); i < e; i++) {
+    if (std::find(values.begin(), values.end(), ops[i].first) ==
+        values.end()) {
+      continue;
+    }
+    auto dims = ops[i].first->dims();
+    if (dims.empty() || dims[0] != values[0]->dims()[0] ||
+        viewSources[slots[i]] >= 0) {
+      rowOperands.resize(begin);
+      return;
+    }
+    hasInput |= ops[i].second != OperandKind::Out;
+    rowOperands.push_back(i);
+  }
+  if (!hasInput) {
+    rowOperands.resize(begin);
+  }
+}
+} // namespace
+
 InterpreterFunction::InterpreterFunction(std::unique_ptr<IRFunction> F,
                                          runtime::RuntimeBundle &&bundle)
-    : CompiledFunction(std::move(bundle)), F_(std::move(F)) {}
+    : CompiledFunction(std::move(bundle)), F_(std::move(F)),
+      intraOpThreads_(runtime::flags::InterpreterIntraOpThreads) {
+  auto addSlot = [&](const Value *v, uint64_t offset) {
+    plan_.slots[v] = plan_.values.size();
+    plan_.values.push_back(v);
+    plan_.offsets.push_back(offset);
+  };
+  for (const auto *W : F_->getWeights()) {
+    addSlot(W, 0);
+  }
+  for (const auto &I : F_->getInstrs()) {
+    if (llvm::isa<AllocActivationInst>(&I)) {
+      addSlot(&I, runtimeBundle_.getSymbolInfo(&I).offset);
+    } else if (llvm::isa<TensorViewInst>(&I)) {
+      addSlot(&I, 0);
+    }
+  }
+  plan_.activationsSize = runtimeBundle_.getActivationsSize();
+  for (const auto *v : plan_.values) {
+    auto *TV = llvm::dyn_cast<TensorViewInst>(v);
+    plan_.viewSources.push_back(TV ? int(plan_.slots.at(TV->getSrc())) : -1);
+  }
+  for (const auto &I : F_->getInstrs()) {
+    size_t begin = plan_.operandSlots.size();
+    plan_.operandsBegin.push_back(begin);
+    for (const auto &op : I.getOperands()) {
+      auto it = plan_.slots.find(op.first);
+      assert(it != plan_.slots.end() && "Operand without a tensor");
+      plan_.operandSlots.push_back(it->second);
+    }
+    plan_.rowOperandsBegin.push_back(plan_.rowOperands.size());
+    collectRowOperands(I, plan_.operandSlots.data() + begin, plan_.viewSources,
+                       plan_.rowOperands);
+  }
+  plan_.rowOperandsBegin.push_back(plan_.rowOperands.size());
+}
 
 InterpreterFunction::~InterpreterFunction() {
   for (const auto &p : constants_) {
@@ -57,7 +200,7 @@ void InterpreterFunction::addConstant(std::string name, Tensor *T) {
 }
 
 Error InterpreterFunction::execute(ExecutionContext *context) {
-  BoundInterpreterFunction boundFunc(constants_);
+  BoundInterpreterFunction boundFunc(constants_, plan_, intraOpThreads_);
   boundFunc.setIRInstructionProcessingHandler(
       getIRInstructionProcessingHandler());
   auto res = boundFunc.execute(F_.get(), context);
@@ -125,75 +268,194 @@ void InterpreterFunction::translateTraceEvents(
 }
 
 BoundInterpreterFunction::~BoundInterpreterFunction() {
-  // Delete the tensors that are owned by this backend.
-  for (const auto &p : tensors_) {
-    delete p.second;
+  if (activations_) {
+    alignedFree(activations_);
   }
-  tensors_.clear();
-  externalTensors_.clear();
 }
 
 Tensor *BoundInterpreterFunction::getTensor(const Value *v) const {
-  auto it = tensors_.find(v);
-  if (it != tensors_.end()) {
-    return it->second;
-  }
-  auto ic = constants_.find(std::string(v->getName()));
-  if (ic != constants_.end()) {
-    return ic->second;
+  // Operands of the instruction being executed are found without hashing.
+  if (curInstr_) {
+    auto ops = curInstr_->getOperands();
+    for (size_t i = 0, e = ops.size(); i < e; i++) {
+      if (ops[i].first == v) {
+        assert(slotTensors_[curSlots_[i]] && "Unknown key Value.");
+        return slotTensors_[curSlots_[i]];
+      }
+    }
   }
-
-  auto ie = externalTensors_.find(v);
-  assert(ie != externalTensors_.end() && "Unknown key Value.");
-  return ie->second;
+  auto it = plan_.slots.find(v);
+  assert(it != plan_.slots.end() && slotTensors_[it->second] &&
+         "Unknown key Value.");
+  return slotTensors_[it->second];
 }
 
-Tensor *BoundInterpreterFunction::getOrCreateTensor(const Value *v) {
-  auto ie = externalTensors_.find(v);
-  if (ie != externalTensors_.end()) {
-    return ie->second;
+void BoundInterpreterFunction::resolveTensors(IRFunction *F,
+                                              PlaceholderBindings *bindings) {
+  const size_t numSlots = plan_.values.size();
+  slotTensors_.assign(numSlots, nullptr);
+  viewTensors_.resize(numSlots);
+  if (plan_.activationsSize) {
+    activations_ = alignedAlloc(plan_.activationsSize, TensorAlignment);
   }
-  auto ic = constants_.find(std::string(v->getName()));
-  if (ic != constants_.end()) {
-    return ic->second;
+
+  // The concrete tensors that back the placeholder tensors. If a Placeholder
+  // has been aliased to the same Weight, the first one is used.
+  for (auto &ph : bindings->pairs()) {
+    auto it = plan_.slots.find(F->getWeightForNode(ph.first));
+    if (it != plan_.slots.end() && !slotTensors_[it->second]) {
+      slotTensors_[it->second] = &ph.second;
+    }
   }
 
-  // Pick the tensor.
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
-    auto *T = new Tensor(v->getType());
-    tensors_[v] = T;
-    return T;
+  for (size_t i = 0; i < numSlots; i++) {
+    const Value *v = plan_.values[i];
+    if (llvm::isa<AllocActivationInst>(v)) {
+      viewTensors_[i] = Tensor(static_cast<char *>(activations_) +
+                                   plan_.offsets[i],
+                               v->getType());
+      slotTensors_[i] = &viewTensors_[i];
+    } else if (auto *TV = llvm::dyn_cast<TensorViewInst>(v)) {
+      Tensor *src = slotTensors_[plan_.slots.at(TV->getSrc())];
+      if (src) {
+        viewTensors_[i] = src->getUnowned(TV->dims(), TV->getOffsets());
+        slotTensors_[i] = &viewTensors_[i];
+      }
+    } else if (!slotTensors_[i]) {
+      auto ic = constants_.find(std::string(v->getName()));
+      if (ic != constants_.end()) {
+        slotTensors_[i] = ic->second;
+      }
+    }
   }
-  return it->second;
 }
 
-Tensor *BoundInterpreterFunction::getOrCreateUnownedTensor(
-    const Value *v, const Value *src, llvm::ArrayRef<dim_t> offsets) {
-  assert(llvm::isa<TensorViewInst>(v) && "Expected a tensor view");
+unsigned BoundInterpreterFunction::getRootSlot(unsigned slot) const {
+  while (plan_.viewSources[slot] >= 0) {
+    slot = plan_.viewSources[slot];
+  }
+  return slot;
+}
 
-  // Pick the tensor.
-  auto it = tensors_.find(v);
+void BoundInterpreterFunction::fillRows(unsigned slot, dim_t rows) {
+  slot = getRootSlot(slot);
+  Tensor *T = slotTensors_[slot];
+  if (!T || T->dims().empty()) {
+    return;
+  }
+  rows = std::min(rows, T->dims()[0]);
+  dim_t &valid = validRows_[slot];
+  if (valid >= rows) {
+    return;
+  }
+  const size_t rowSize = T->getSizeInBytes() / T->dims()[0];
+  memset(T->getUnsafePtr() + valid * rowSize, 0, (rows - valid) * rowSize);
+  valid = rows;
+}
 
-  // Release unowned tensors before re-creating them.
-  if (it != tensors_.end()) {
-    deleteTensor(v);
+dim_t BoundInterpreterFunction::narrowRows(size_t instrIdx,
+                                           const Instruction &I) {
+  if (llvm::isa<TensorViewInst>(&I) || llvm::isa<DeallocActivationInst>(&I)) {
+    return 0;
+  }
+  auto ops = I.getOperands();
+  const unsigned *rowsBegin =
+      plan_.rowOperands.data() + plan_.rowOperandsBegin[instrIdx];
+  const unsigned *rowsEnd =
+      plan_.rowOperands.data() + plan_.rowOperandsBegin[instrIdx + 1];
+
+  // The rows computed are the valid rows of the row operands read, those of
+  // the other operands are zeroed before they are read.
+  dim_t rows = 0;
+  for (const unsigned *r = rowsBegin; r != rowsEnd; r++) {
+    if (ops[*r].second != OperandKind::Out) {
+      rows = std::max(rows, validRows_[curSlots_[*r]]);
+    }
+  }
+  for (unsigned i = 0, e = ops.size(); i < e; i++) {
+    if (std::find(rowsBegin, rowsEnd, i) != rowsEnd) {
+      if (ops[i].second != OperandKind::Out) {
+        fillRows(curSlots_[i], rows);
+      }
+    } else if (ops[i].second != OperandKind::Out ||
+               plan_.viewSources[curSlots_[i]] >= 0) {
+      fillRows(curSlots_[i]);
+    }
+  }
+  if (rowsBegin == rowsEnd || rows == ops[*rowsBegin].first->dims()[0]) {
+    return rows;
   }
 
-  auto *T = new Tensor();
-  *T = getTensor(src)->getUnowned(v->dims(), offsets);
-  tensors_[v] = T;
-  return T;
+  rowTensors_.clear();
+  rowTensors_.reserve(rowsEnd - rowsBegin);
+  for (const unsigned *r = rowsBegin; r != rowsEnd; r++) {
+    const unsigned slot = curSlots_[*r];
+    if (std::any_of(narrowedSlots_.begin(), narrowedSlots_.end(),
+                    [&](const std::pair<unsigned, Tensor *> &narrowed) {
+                      return narrowed.first == slot;
+                    })) {
+      continue;
+    }
+    Tensor *T = slotTensors_[slot];
+    llvm::SmallVector<dim_t, max_tensor_dimensions> dims(T->dims().begin(),
+                                                         T->dims().end());
+    dims[0] = rows;
+    rowTensors_.push_back(T->getUnowned(dims));
+    narrowedSlots_.emplace_back(slot, T);
+    slotTensors_[slot] = &rowTensors_.back();
+  }
+  return rows;
 }
 
-void BoundInterpreterFunction::deleteTensor(const Value *v) {
-  auto it = tensors_.find(v);
-  if (it == tensors_.end()) {
+void BoundInterpreterFunction::restoreRows(size_t instrIdx,
+                                           const Instruction &I, dim_t rows) {
+  if (llvm::isa<TensorViewInst>(&I) || llvm::isa<DeallocActivationInst>(&I)) {
     return;
   }
+  for (const auto &narrowed : narrowedSlots_) {
+    slotTensors_[narrowed.first] = narrowed.second;
+  }
+  narrowedSlots_.clear();
+
+  auto ops = I.getOperands();
+  const unsigned *rowsBegin =
+      plan_.rowOperands.data() + plan_.rowOperandsBegin[instrIdx];
+  const unsigned *rowsEnd =
+      plan_.rowOperands.data() + plan_.rowOperandsBegin[instrIdx + 1];
+  for (unsigned i = 0, e = ops.size(); i < e; i++) {
+    const unsigned slot = curSlots_[i];
+    // The roots of the views written were filled before.
+    if (ops[i].second == OperandKind::In || plan_.viewSources[slot] >= 0 ||
+        !slotTensors_[slot] || slotTensors_[slot]->dims().empty()) {
+      continue;
+    }
+    validRows_[slot] = std::find(rowsBegin, rowsEnd, i) != rowsEnd
+                           ? rows
+                           : slotTensors_[slot]->dims()[0];
+  }
+}
 
-  delete it->second;
-  tensors_.erase(it);
+void BoundInterpreterFunction::parallelFor(
+    dim_t numTasks, uint64_t taskWork,
+    const std::function<void(dim_t, dim_t)> &body) const {
+  const uint64_t numChunks = std::min<uint64_t>(
+      {numTasks, numThreads_, numTasks * taskWork / kMinChunkWork});
+  if (numChunks <= 1) {
+    body(0, numTasks);
+    return;
+  }
+  std::vector<std::future<void>> chunks;
+  chunks.reserve(numChunks - 1);
+  for (uint64_t i = 1; i < numChunks; i++) {
+    const dim_t begin = numTasks * i / numChunks;
+    const dim_t end = numTasks * (i + 1) / numChunks;
+    chunks.push_back(getIntraOpThreadPool().submit(
+        [&body, begin, end]() { body(begin, end); }));
+  }
+  body(0, numTasks / numChunks);
+  for (auto &chunk : chunks) {
+    chunk.wait();
+  }
 }
 
 Error BoundInterpreterFunction::execute(IRFunction *F,
@@ -205,9 +467,11 @@ Error BoundInterpreterFunction::execute(IRFunction *F,
 
     // Find all virtually padded tensors so they can be replaced.
     std::vector<Placeholder *> virtualPadded;
+    std::vector<size_t> unpaddedSizes;
     for (auto &ph : context->getPlaceholderBindings()->pairs()) {
       if (ph.second.getUnpaddedSizeInBytes() < ph.second.getSizeInBytes()) {
         virtualPadded.push_back(ph.first);
+        unpaddedSizes.push_back(ph.second.getUnpaddedSizeInBytes());
       }
     }
     // Replace all virtually padded tensors with real padding tensors.
@@ -223,22 +487,43 @@ Error BoundInterpreterFunction::execute(IRFunction *F,
       context->getPlaceholderBindings()->erase(ph);
       context->getPlaceholderBindings()->insert(ph, std::move(paddedTensor));
     }
-    // Register the concrete tensors that back the placeholder tensors.
-    for (auto &ph : context->getPlaceholderBindings()->pairs()) {
-      auto *w = F->getWeightForNode(ph.first);
-      // If the Placeholder has been aliased to the same Weight, just skip it.
-      if (externalTensors_.count(w)) {
+    resolveTensors(F, context->getPlaceholderBindings());
+
+    // Only the rows of the partial inputs which hold data are valid, the
+    // instructions computing along rows skip the others.
+    for (size_t i = 0, e = virtualPadded.size(); i < e; i++) {
+      Tensor *T = context->getPlaceholderBindings()->get(virtualPadded[i]);
+      auto it = plan_.slots.find(F->getWeightForNode(virtualPadded[i]));
+      if (it == plan_.slots.end() || slotTensors_[it->second] != T) {
         continue;
       }
-
-      externalTensors_[w] = &ph.second;
+      if (!hasPartialRows_) {
+        hasPartialRows_ = true;
+        validRows_.resize(slotTensors_.size());
+        for (size_t s = 0, n = slotTensors_.size(); s < n; s++) {
+          Tensor *ST = slotTensors_[s];
+          validRows_[s] = ST && !ST->dims().empty() ? ST->dims()[0] : 1;
+        }
+      }
+      size_t validSize = T->getSizeInBytes();
+      if (!T->dims().empty()) {
+        const size_t rowSize = T->getSizeInBytes() / T->dims()[0];
+        validRows_[it->second] = (unpaddedSizes[i] + rowSize - 1) / rowSize;
+        validSize = validRows_[it->second] * rowSize;
+      }
+      memset(T->getUnsafePtr() + unpaddedSizes[i], 0,
+             validSize - unpaddedSizes[i]);
     }
   }
 
   // Do the forward pass.
   auto &irInstructionProcessingHandler = getIRInstructionProcessingHandler();
   // Dispatch the interpreter on each instruction in the program.
+  size_t instrIdx = 0;
   for (const auto &I : F->getInstrs()) {
+    curInstr_ = &I;
+    curSlots_ = plan_.operandSlots.data() + plan_.operandsBegin[instrIdx];
+    const dim_t rows = hasPartialRows_ ? narrowRows(instrIdx, I) : 0;
     // Perform custom processing if needed and proceed with standard processing
     // if required.
     if (!irInstructionProcessingHandler ||
@@ -265,15 +550,18 @@ Error BoundInterpreterFunction::execute(IRFunction *F,
       irInstructionProcessingHandler(
           &I, IRInstructionProcessingStage::POSTPROCESSING, this);
     }
+    if (hasPartialRows_) {
+      restoreRows(instrIdx, I, rows);
+    }
+    instrIdx++;
   }
 
-  {
+  curInstr_ = nullptr;
 
-    TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "eraseTensors");
-    // Remove the concrete tensors that back the placeholder tensors.
-    for (auto &ph : context->getPlaceholderBindings()->pairs()) {
-      auto *w = F->getWeightForNode(ph.first);
-      externalTensors_.erase(w);
+  // Zero the rows of the outputs which were skipped.
+  if (hasPartialRows_) {
+    for (size_t i = 0, e = F->getWeights().size(); i < e; i++) {
+      fillRows(i);
     }
   }
 
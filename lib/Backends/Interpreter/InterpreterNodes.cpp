@@ -408,48 +408,47 @@ void BoundInterpreterFunction::fwdConvolutionInstFloatImpl(
 
   PaddingTLBR pdim(pads);
 
-  // For each input in the batch:
-  for (dim_t n = 0; n < idim.n; n++) {
-
-    // For each group of input channels:
-    for (dim_t g = 0; g < group; g++) {
-
-      // For each output channel in the group:
-      for (dim_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+  // For each input in the batch and each output channel, in parallel:
+  const uint64_t taskWork =
+      odim.h * odim.w * kdim.height * kdim.width * inCperG;
+  parallelFor(idim.n * odim.c, taskWork, [&](dim_t begin, dim_t end) {
+    for (dim_t t = begin; t < end; t++) {
+      const dim_t n = t / odim.c;
+      const dim_t d = t % odim.c;
+      const dim_t g = d / outCperG;
 
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -ssize_t(pdim.top);
-        for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
-          ssize_t y = -ssize_t(pdim.left);
-          for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
+      // For each convolution 'jump' in the input tensor:
+      ssize_t x = -ssize_t(pdim.top);
+      for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
+        ssize_t y = -ssize_t(pdim.left);
+        for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
 
-            // For each element in the convolution-filter:
-            float sum = 0;
-            for (dim_t fx = 0; fx < kdim.height; fx++) {
-              for (dim_t fy = 0; fy < kdim.width; fy++) {
-                sdim_t ox = x + fx * dilation[0];
-                sdim_t oy = y + fy * dilation[1];
+          // For each element in the convolution-filter:
+          float sum = 0;
+          for (dim_t fx = 0; fx < kdim.height; fx++) {
+            for (dim_t fy = 0; fy < kdim.width; fy++) {
+              sdim_t ox = x + fx * dilation[0];
+              sdim_t oy = y + fy * dilation[1];
 
-                // Ignore index access below zero (this is due to padding).
-                if (ox < 0 || oy < 0 || ox >= ssize_t(idim.h) ||
-                    oy >= ssize_t(idim.w)) {
-                  continue;
-                }
-                for (dim_t fd = 0; fd < inCperG; fd++) {
-                  sum += float(
-                      filterW.at({d, fx, fy, fd}) *
-                      inW.at({n, (dim_t)ox, (dim_t)oy, g * inCperG + fd}));
-                }
+              // Ignore index access below zero (this is due to padding).
+              if (ox < 0 || oy < 0 || ox >= ssize_t(idim.h) ||
+                  oy >= ssize_t(idim.w)) {
+                continue;
+              }
+              for (dim_t fd = 0; fd < inCperG; fd++) {
+                sum += float(
+                    filterW.at({d, fx, fy, fd}) *
+                    inW.at({n, (dim_t)ox, (dim_t)oy, g * inCperG + fd}));
               }
             }
+          }
 
-            sum += float(biasW.at({d}));
-            outW.at({n, ax, ay, d}) = ElemTy(sum);
-          } // W
-        }   // H
-      }     // C
-    }       // G
-  }         // N
+          sum += float(biasW.at({d}));
+          outW.at({n, ax, ay, d}) = ElemTy(sum);
+        } // W
+      }   // H
+    }
+  });
 }
 
 /// This is the quantized implementation of Convolution.
@@ -494,59 +493,59 @@ void BoundInterpreterFunction::fwdConvolutionInstQuantizedImpl(
   // multiplication part of the calculation.
   float matMulScale = inScale * filterScale;
 
-  // For each input in the batch:
-  for (dim_t n = 0; n < idim.n; n++) {
-    // For each group of input channels:
-    for (dim_t g = 0; g < group; g++) {
-
-      // For each output channel in the group:
-      for (dim_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+  // For each input in the batch and each output channel, in parallel:
+  const uint64_t taskWork =
+      odim.h * odim.w * kdim.height * kdim.width * inCperG;
+  parallelFor(idim.n * odim.c, taskWork, [&](dim_t begin, dim_t end) {
+    for (dim_t t = begin; t < end; t++) {
+      const dim_t n = t / odim.c;
+      const dim_t d = t % odim.c;
+      const dim_t g = d / outCperG;
 
-        // For each convolution 'jump' in the input tensor:
-        ssize_t x = -ssize_t(pdim.top);
-        for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
-          ssize_t y = -ssize_t(pdim.left);
-          for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
-
-            // For each element in the convolution-filter:
-            AccumulatorTy sum = 0;
-            for (dim_t fx = 0; fx < kdim.height; fx++) {
-              for (dim_t fy = 0; fy < kdim.width; fy++) {
-                sdim_t ox = x + fx * dilation[0];
-                sdim_t oy = y + fy * dilation[1];
+      // For each convolution 'jump' in the input tensor:
+      ssize_t x = -ssize_t(pdim.top);
+      for (dim_t ax = 0; ax < odim.h; x += sdim.height, ax++) {
+        ssize_t y = -ssize_t(pdim.left);
+        for (dim_t ay = 0; ay < odim.w; y += sdim.width, ay++) {
 
-                // Ignore index access below zero (this is due to padding).
-                if (ox < 0 || oy < 0 || ox >= ssize_t(idim.h) ||
-                    oy >= sdim_t(idim.w)) {
-                  continue;
-                }
-                for (dim_t fd = 0; fd < inCperG; fd++) {
+          // For each element in the convolution-filter:
+          AccumulatorTy sum = 0;
+          for (dim_t fx = 0; fx < kdim.height; fx++) {
+            for (dim_t fy = 0; fy < kdim.width; fy++) {
+              sdim_t ox = x + fx * dilation[0];
+              sdim_t oy = y + fy * dilation[1];
 
-                  AccumulatorTy F = filterW.at({d, fx, fy, fd});
-                  AccumulatorTy I =
-                      inW.at({n, (dim_t)ox, (dim_t)oy, g * inCperG + fd});
-                  // We represent the element multiplication with offset as
-                  // (value - offset).
-                  sum += (F - filterOffset) * (I - inOffset);
-                }
+              // Ignore index access below zero (this is due to padding).
+              if (ox < 0 || oy < 0 || ox >= ssize_t(idim.h) ||
+                  oy >= sdim_t(idim.w)) {
+                continue;
+              }
+              for (dim_t fd = 0; fd < inCperG; fd++) {
+
+                AccumulatorTy F = filterW.at({d, fx, fy, fd});
+                AccumulatorTy I =
+                    inW.at({n, (dim_t)ox, (dim_t)oy, g * inCperG + fd});
+                // We represent the element multiplication with offset as
+                // (value - offset).
+                sum += (F - filterOffset) * (I - inOffset);
               }
             }
+          }
 
-            // Scale the bias to match the scale of the matrix multiplication.
-            AccumulatorTy B = std::round(float(biasW.at({d}) - biasOffset) *
-                                         (biasScale / matMulScale));
+          // Scale the bias to match the scale of the matrix multiplication.
+          AccumulatorTy B = std::round(float(biasW.at({d}) - biasOffset) *
+                                       (biasScale / matMulScale));
 
-            // Add the bias.
-            sum += B;
+          // Add the bias.
+          sum += B;
 
-            // Scale the result back to the expected destination scale.
-            outW.at({n, ax, ay, d}) = quantization::clip<AccumulatorTy, ElemTy>(
-                std::round(float(sum) * (matMulScale / outScale) + outOffset));
-          } // W
-        }   // H
-      }     // C
-    }       // G
-  }         // N
+          // Scale the result back to the expected destination scale.
+          outW.at({n, ax, ay, d}) = quantization::clip<AccumulatorTy, ElemTy>(
+              std::round(float(sum) * (matMulScale / outScale) + outOffset));
+        } // W
+      }   // H
+    }
+  });
 }
 
 /// This is the floating point implementation of ConvTranspose.
@@ -2209,6 +2208,10 @@ void BoundInterpreterFunction::fwdHardSwishInst(const HardSwishInst *) {
   DCHECK(!"Found HardSwishInst but HardSwish is lowered on Interpreter");
 }
 
+void BoundInterpreterFunction::fwdGeluInst(const GeluInst *) {
+  DCHECK(!"Found GeluInst but Gelu is lowered on Interpreter");
+}
+
 template <typename ElemTy>
 void BoundInterpreterFunction::fwdSigmoidInstFloatImpl(const SigmoidInst *I) {
   staticAssertFloatingPointType(ElemTy);
@@ -2418,7 +2421,7 @@ void BoundInterpreterFunction::fwdTransposeInst(const TransposeInst *I) {
 }
 
 void BoundInterpreterFunction::fwdTensorViewInst(const TensorViewInst *I) {
-  getOrCreateUnownedTensor(I, I->getSrc(), I->getOffsets());
+  // Views are created with the tensors of their sources before the execution.
 }
 
 void BoundInterpreterFunction::fwdSplatInst(const glow::SplatInst *I) {
@@ -3380,9 +3383,11 @@ void BoundInterpreterFunction::fwdElementAddInstArithmeticImpl(
   auto outW = getWeightHandle<ElemTy>(I->getDest());
   auto lhsW = getWeightHandle<ElemTy>(I->getLHS());
   auto rhsW = getWeightHandle<ElemTy>(I->getRHS());
-  for (size_t i = 0, e = outW.size(); i < e; i++) {
-    outW.raw(i) = lhsW.raw(i) + rhsW.raw(i);
-  }
+  parallelFor(outW.size(), 1, [&](dim_t begin, dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      outW.raw(i) = lhsW.raw(i) + rhsW.raw(i);
+    }
+  });
 }
 
 void BoundInterpreterFunction::fwdElementAddInst(const ElementAddInst *I) {
@@ -4403,24 +4408,26 @@ void BoundInterpreterFunction::fwdMatMulInstQuantizedImpl(
   int32_t rhsOffset = rhsTy->getOffset();
   int32_t destOffset = destTy->getOffset();
 
-  // For each (x,y) in the destination matrix:
-  for (dim_t x = 0; x < destDim[0]; x++) {
-    for (dim_t y = 0; y < destDim[1]; y++) {
+  // For each (x,y) in the destination matrix, the rows in parallel:
+  parallelFor(destDim[0], destDim[1] * lhsDim[1], [&](dim_t begin, dim_t end) {
+    for (dim_t x = begin; x < end; x++) {
+      for (dim_t y = 0; y < destDim[1]; y++) {
 
-      // Perform DOT on the row an column.
-      AccumulatorTy sum = 0;
-      for (dim_t i = 0; i < lhsDim[1]; i++) {
-        AccumulatorTy L = lhs.at({x, i});
-        AccumulatorTy R = rhs.at({i, y});
-        // We represent the element multiplication with offset as
-        // (value - offset).
-        sum += (L - lhsOffset) * (R - rhsOffset);
-      }
+        // Perform DOT on the row an column.
+        AccumulatorTy sum = 0;
+        for (dim_t i = 0; i < lhsDim[1]; i++) {
+          AccumulatorTy L = lhs.at({x, i});
+          AccumulatorTy R = rhs.at({i, y});
+          // We represent the element multiplication with offset as
+          // (value - offset).
+          sum += (L - lhsOffset) * (R - rhsOffset);
+        }
 
-      dest.at({x, y}) = quantization::clip<AccumulatorTy, ElemTy>(
-          std::round(scale * sum + destOffset));
+        dest.at({x, y}) = quantization::clip<AccumulatorTy, ElemTy>(
+            std::round(scale * sum + destOffset));
+      }
     }
-  }
+  });
 }
 
 template <typename ElemTy>
@@ -4436,18 +4443,20 @@ void BoundInterpreterFunction::fwdMatMulInstFloatImpl(const MatMulInst *I) {
 
   dest.clear(0);
 
-  // For each (x,y) in the destination matrix:
-  for (dim_t x = 0; x < destDim[0]; x++) {
-    for (dim_t y = 0; y < destDim[1]; y++) {
+  // For each (x,y) in the destination matrix, the rows in parallel:
+  parallelFor(destDim[0], destDim[1] * lhsDim[1], [&](dim_t begin, dim_t end) {
+    for (dim_t x = begin; x < end; x++) {
+      for (dim_t y = 0; y < destDim[1]; y++) {
 
-      // Perform DOT on the row an column.
-      float sum = 0;
-      for (dim_t i = 0; i < lhsDim[1]; i++) {
-        sum += float(lhs.at({x, i}) * rhs.at({i, y}));
+        // Perform DOT on the row an column.
+        float sum = 0;
+        for (dim_t i = 0; i < lhsDim[1]; i++) {
+          sum += float(lhs.at({x, i}) * rhs.at({i, y}));
+        }
+        dest.at({x, y}) = ElemTy(sum);
       }
-      dest.at({x, y}) = ElemTy(sum);
     }
-  }
+  });
 }
 
 template <typename ElemTy>
@@ -4464,9 +4473,12 @@ void BoundInterpreterFunction::fwdBatchMatMulInstFloatImpl(
 
   dest.clear(0);
 
-  for (dim_t batch = 0; batch < destDim[0]; batch++) {
-    // For each (x,y) in the destination matrix:
-    for (dim_t x = 0; x < destDim[1]; x++) {
+  // For each row of each matrix of the batch, in parallel:
+  const uint64_t taskWork = destDim[2] * lhsDim[2];
+  parallelFor(destDim[0] * destDim[1], taskWork, [&](dim_t begin, dim_t end) {
+    for (dim_t t = begin; t < end; t++) {
+      const dim_t batch = t / destDim[1];
+      const dim_t x = t % destDim[1];
       for (dim_t y = 0; y < destDim[2]; y++) {
         // Perform DOT on the row an column.
         float sum = 0;
@@ -4476,7 +4488,7 @@ void BoundInterpreterFunction::fwdBatchMatMulInstFloatImpl(
         dest.at({batch, x, y}) = ElemTy(sum);
       }
     }
-  }
+  });
 }
 
 void BoundInterpreterFunction::fwdMatMulInst(const glow::MatMulInst *I) {
@@ -4501,6 +4513,98 @@ void BoundInterpreterFunction::fwdBatchMatMulInst(
                             I->getLHS()->getElementType(), I);
 }
 
+template <typename ElemTy>
+void BoundInterpreterFunction::fwdScaledDotProductAttentionInstFloatImpl(
+    const ScaledDotProductAttentionInst *I) {
+  staticAssertFloatingPointType(ElemTy);
+
+  auto query = getWeightHandle<ElemTy>(I->getQuery());
+  auto key = getWeightHandle<ElemTy>(I->getKey());
+  auto value = getWeightHandle<ElemTy>(I->getValues());
+  auto mask = getWeightHandle<ElemTy>(I->getMask());
+  auto dest = getWeightHandle<ElemTy>(I->getDest());
+  const float scale = I->getScale();
+
+  const dim_t numBatches = query.dims()[0];
+  const dim_t Lq = query.dims()[1];
+  const dim_t D = query.dims()[2];
+  const dim_t Lk = key.dims()[1];
+  const dim_t Dv = value.dims()[2];
+  auto maskDims = mask.dims();
+
+  // Scores of a single query.
+  std::vector<float> scores(Lk);
+  for (dim_t n = 0; n < numBatches; n++) {
+    for (dim_t q = 0; q < Lq; q++) {
+      for (dim_t k = 0; k < Lk; k++) {
+        float sum = 0;
+        for (dim_t d = 0; d < D; d++) {
+          sum += float(query.at({n, q, d})) * float(key.at({n, k, d}));
+        }
+        // Broadcast the mask along its dimensions of size 1.
+        scores[k] = sum * scale + float(mask.at({maskDims[0] == 1 ? 0 : n,
+                                                 maskDims[1] == 1 ? 0 : q,
+                                                 maskDims[2] == 1 ? 0 : k}));
+      }
+      const float max = *std::max_element(scores.begin(), scores.end());
+      float sum = 0;
+      for (dim_t k = 0; k < Lk; k++) {
+        scores[k] = std::exp(scores[k] - max);
+        sum += scores[k];
+      }
+      for (dim_t v = 0; v < Dv; v++) {
+        float res = 0;
+        for (dim_t k = 0; k < Lk; k++) {
+          res += scores[k] * float(value.at({n, k, v}));
+        }
+        dest.at({n, q, v}) = ElemTy(res / sum);
+      }
+    }
+  }
+}
+
+void BoundInterpreterFunction::fwdScaledDotProductAttentionInst(
+    const glow::ScaledDotProductAttentionInst *I) {
+  dispatchFloatingPointImpl(fwdScaledDotProductAttentionInstFloatImpl,
+                            I->getQuery()->getElementType(), I);
+}
+
+template <typename ElemTy>
+void BoundInterpreterFunction::fwdFusedSGDInstFloatImpl(
+    const FusedSGDInst *I) {
+  staticAssertFloatingPointType(ElemTy);
+
+  auto gradH = getWeightHandle<ElemTy>(I->getGradient());
+  auto weightH = getWeightHandle<ElemTy>(I->getWeight());
+  auto velocityH = getWeightHandle<ElemTy>(I->getVelocity());
+  auto updatedWeightH = getWeightHandle<ElemTy>(I->getUpdatedWeight());
+  auto updatedVelocityH = getWeightHandle<ElemTy>(I->getUpdatedVelocity());
+  const float L1Decay = I->getL1Decay();
+  const float L2Decay = I->getL2Decay();
+  const float learningRate = I->getLearningRate();
+  const float momentum = I->getMomentum();
+  const float batchSize = std::max(1u, I->getBatchSize());
+
+  // The same computation as the lowered SGD node, in a single pass. The
+  // updated values may alias the inputs.
+  for (dim_t i = 0, e = weightH.size(); i < e; i++) {
+    float w = float(weightH.raw(i));
+    float g = float(gradH.raw(i)) + L1Decay * (w >= 0 ? 1.f : -1.f) +
+              L2Decay * w;
+    float dx = -learningRate * (g / batchSize);
+    if (momentum > 0) {
+      dx += momentum * float(velocityH.raw(i));
+      updatedVelocityH.raw(i) = ElemTy(dx);
+    }
+    updatedWeightH.raw(i) = ElemTy(w + dx);
+  }
+}
+
+void BoundInterpreterFunction::fwdFusedSGDInst(const glow::FusedSGDInst *I) {
+  dispatchFloatingPointImpl(fwdFusedSGDInstFloatImpl,
+                            I->getWeight()->getElementType(), I);
+}
+
 void BoundInterpreterFunction::fwdReluGradInst(const glow::ReluGradInst *I) {
   DCHECK(!"Found ReluGradInst but ReluGrad is lowered on Interpreter");
 }
@@ -4542,27 +4646,30 @@ void BoundInterpreterFunction::fwdFullyConnectedInstQuantizedImpl(
 
   outW.clear(0);
 
-  for (dim_t i = 0; i < idim.height; i++) {
-    for (dim_t j = 0; j < odim.width; j++) {
-      AccumulatorTy sum = 0;
-      for (dim_t k = 0; k < idim.width; k++) {
-        AccumulatorTy W = weightsW.at({k, j});
-        AccumulatorTy A = inW.at({i, k});
-        sum += (W - weightsOffset) * (A - inOffset);
-      }
+  parallelFor(idim.height, odim.width * idim.width, [&](dim_t begin,
+                                                        dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      for (dim_t j = 0; j < odim.width; j++) {
+        AccumulatorTy sum = 0;
+        for (dim_t k = 0; k < idim.width; k++) {
+          AccumulatorTy W = weightsW.at({k, j});
+          AccumulatorTy A = inW.at({i, k});
+          sum += (W - weightsOffset) * (A - inOffset);
+        }
 
-      // Scale the bias to match the scale of the matrix multiplication.
-      AccumulatorTy B = std::round(float(biasW.at({j}) - biasOffset) *
-                                   (biasScale / matMulScale));
+        // Scale the bias to match the scale of the matrix multiplication.
+        AccumulatorTy B = std::round(float(biasW.at({j}) - biasOffset) *
+                                     (biasScale / matMulScale));
 
-      // Add the bias.
-      sum += B;
+        // Add the bias.
+        sum += B;
 
-      // Scale the result back to the expected destination scale.
-      outW.at({i, j}) = quantization::clip<AccumulatorTy, ElemTy>(
-          std::round(float(sum) * (matMulScale / outScale)) + outOffset);
+        // Scale the result back to the expected destination scale.
+        outW.at({i, j}) = quantization::clip<AccumulatorTy, ElemTy>(
+            std::round(float(sum) * (matMulScale / outScale)) + outOffset);
+      }
     }
-  }
+  });
 }
 
 template <typename ElemTy>
@@ -4580,16 +4687,19 @@ void BoundInterpreterFunction::fwdFullyConnectedInstFloatImpl(
 
   outW.clear(0);
 
-  for (dim_t i = 0; i < idim.height; i++) {
-    for (dim_t j = 0; j < odim.width; j++) {
-      float sum = 0;
-      for (dim_t k = 0; k < idim.width; k++) {
-        sum += float(inW.at({i, k})) * float(weightsW.at({k, j}));
-      }
+  parallelFor(idim.height, odim.width * idim.width, [&](dim_t begin,
+                                                        dim_t end) {
+    for (dim_t i = begin; i < end; i++) {
+      for (dim_t j = 0; j < odim.width; j++) {
+        float sum = 0;
+        for (dim_t k = 0; k < idim.width; k++) {
+          sum += float(inW.at({i, k})) * float(weightsW.at({k, j}));
+        }
 
-      outW.at({i, j}) = sum + float(biasW.at({j}));
+        outW.at({i, j}) = sum + float(biasW.at({j}));
+      }
     }
-  }
+  });
 }
 
 void BoundInterpreterFunction::fwdFullyConnectedInst(
@@ -4652,7 +4762,6 @@ void BoundInterpreterFunction::fwdDynRowwiseQuantizedFullyConnectedInstPreimpl(
   auto weightsW = weightsTensor->getHandle<int8_t>();
 
   /* Dynamic Quantization */
-  auto resultHandle = resultTensor->getHandle<float16_t>();
   auto offsetsW = wOffsetTensor->getHandle<int32_t>();
   dim_t N = inputTensor->dims()[0];
   dim_t L = inputTensor->dims()[1];
@@ -4662,10 +4771,18 @@ void BoundInterpreterFunction::fwdDynRowwiseQuantizedFullyConnectedInstPreimpl(
     // independently, and finally splice them together.
     for (dim_t i = 0; i < N; i++) {
       Tensor slicedInputTensor = inputTensor->getOwnedSlice({1, L}, {i, 0});
-      auto slicedInputHandle = slicedInputTensor.getHandle<float16_t>();
-      auto minMax = slicedInputHandle.minMaxArg();
-      auto qMin = slicedInputHandle.raw(minMax.first);
-      auto qMax = slicedInputHandle.raw(minMax.second);
+      float qMin, qMax;
+      if (slicedInputTensor.getElementType() == ElemKind::Float16Ty) {
+        auto slicedInputHandle = slicedInputTensor.getHandle<float16_t>();
+        auto minMax = slicedInputHandle.minMax();
+        qMin = minMax.first;
+        qMax = minMax.second;
+      } else {
+        auto slicedInputHandle = slicedInputTensor.getHandle<float>();
+        auto minMax = slicedInputHandle.minMax();
+        qMin = minMax.first;
+        qMax = minMax.second;
+      }
 
       // TODO Currently we only support symmetric quantization.
       // We should support both symmetric/asymmetric based of isSymmetric.
@@ -4678,8 +4795,16 @@ void BoundInterpreterFunction::fwdDynRowwiseQuantizedFullyConnectedInstPreimpl(
 
       auto biasW = biasTensor->getHandle<float>();
       auto scalesW = wScaleTensor->getHandle<float>();
-      fwdDynRowwiseQuantizedFullyConnectedInstImpl<int8_t, float16_t, int32_t>(
-          inW, resultHandle, i, weightsW, biasW, scalesW, offsetsW);
+      if (resultTensor->getElementType() == ElemKind::Float16Ty) {
+        auto resultHandle = resultTensor->getHandle<float16_t>();
+        fwdDynRowwiseQuantizedFullyConnectedInstImpl<int8_t, float16_t,
+                                                     int32_t>(
+            inW, resultHandle, i, weightsW, biasW, scalesW, offsetsW);
+      } else {
+        auto resultHandle = resultTensor->getHandle<float>();
+        fwdDynRowwiseQuantizedFullyConnectedInstImpl<int8_t, float, int32_t>(
+            inW, resultHandle, i, weightsW, biasW, scalesW, offsetsW);
+      }
     }
   }
 }
@@ -4725,6 +4850,34 @@ void BoundInterpreterFunction::fwdDynamicQuantizedFullyConnectedInst(
       &offsetTensor, isSymmetric, isPerBatchElement);
 }
 
+void BoundInterpreterFunction::fwdInt4GroupwiseQuantizedFullyConnectedInst(
+    const glow::Int4GroupwiseQuantizedFullyConnectedInst *I) {
+  auto inW = getWeightHandle<float>(I->getSrc());
+  auto outW = getWeightHandle<float>(I->getDest());
+  auto weightsW = getWeightHandle<uint8_t>(I->getWeights());
+  auto scalesW = getWeightHandle<float16_t>(I->getScales());
+  auto offsetsW = getWeightHandle<float16_t>(I->getOffsets());
+  auto biasW = getWeightHandle<float>(I->getBias());
+  const dim_t groupSize = I->getGroupSize();
+  const dim_t M = inW.dims()[0];
+  const dim_t K = inW.dims()[1];
+  const dim_t N = outW.dims()[1];
+
+  for (dim_t i = 0; i < M; i++) {
+    for (dim_t j = 0; j < N; j++) {
+      float sum = biasW.at({j});
+      for (dim_t k = 0; k < K; k++) {
+        const uint8_t packed = weightsW.at({j, k / 2});
+        const uint8_t q = (k % 2) ? (packed >> 4) : (packed & 0x0f);
+        const float W = float(scalesW.at({j, k / groupSize})) * q +
+                        float(offsetsW.at({j, k / groupSize}));
+        sum += W * inW.at({i, k});
+      }
+      outW.at({i, j}) = sum;
+    }
+  }
+}
+
 //===----------------------------------------------------------------------===//
 //                       Row-wise quantized FC
 //===----------------------------------------------------------------------===//
@@ -5282,15 +5435,25 @@ void BoundInterpreterFunction::fwdSparseLengthsSumInstFloatImpl(
   auto DH = data->getHandle<ElemTy>();
   auto OH = out->getHandle<ElemTy>();
 
-  size_t curIdx = 0;
-  for (size_t i = 0; i < segments; i++) {
-    for (size_t j = 0, e = LH.raw(i); j < e; j++) {
-      size_t offsetIn = IH.raw(curIdx++) * lineSize;
-      size_t offsetOut = i * lineSize;
-      for (size_t k = 0; k < lineSize; k++)
-        OH.raw(offsetOut++) += DH.raw(offsetIn++);
+  // The segments are summed in parallel, from the position of their first
+  // index.
+  std::vector<size_t> segmentBegin(segments);
+  for (size_t i = 0, curIdx = 0; i < segments; i++) {
+    segmentBegin[i] = curIdx;
+    curIdx += LH.raw(i);
+  }
+  const uint64_t taskWork = segments ? totalLength * lineSize / segments : 0;
+  parallelFor(segments, taskWork, [&](dim_t begin, dim_t end) {
+    for (size_t i = begin; i < end; i++) {
+      size_t curIdx = segmentBegin[i];
+      for (size_t j = 0, e = LH.raw(i); j < e; j++) {
+        size_t offsetIn = IH.raw(curIdx++) * lineSize;
+        size_t offsetOut = i * lineSize;
+        for (size_t k = 0; k < lineSize; k++)
+          OH.raw(offsetOut++) += DH.raw(offsetIn++);
+      }
     }
-  }
+  });
 }
 
 void BoundInterpreterFunction::fwdSparseLengthsSumInst(
@@ -5829,6 +5992,50 @@ void BoundInterpreterFunction::fwdFusedRowwiseQuantizedSparseLengthsSumInst(
   llvm_unreachable("Not supported");
 }
 
+template <typename TI>
+void BoundInterpreterFunction::fwdProductQuantizedSparseLengthsWeightedSumImpl(
+    const ProductQuantizedSparseLengthsWeightedSumInst *I) {
+  auto *out = getTensor(I->getDest());
+  auto *codes = getTensor(I->getCodes());
+  auto *codebooks = getTensor(I->getCodebooks());
+  auto *weights = getTensor(I->getWeights());
+  auto *indices = getTensor(I->getIndices());
+  auto *lengths = getTensor(I->getLengths());
+
+  out->zero();
+
+  auto CH = codes->getHandle<uint8_t>();
+  auto CBH = codebooks->getHandle<float>();
+  auto WH = weights->getHandle<float>();
+  auto IH = indices->getHandle<TI>();
+  auto LH = lengths->getHandle<int32_t>();
+  auto OH = out->getHandle<float>();
+
+  const dim_t segments = lengths->dims()[0];
+  const dim_t numSubspaces = codebooks->dims()[0];
+  const dim_t subDim = codebooks->dims()[2];
+
+  dim_t curIdx = 0;
+  for (dim_t i = 0; i < segments; i++) {
+    for (dim_t j = 0, e = LH.raw(i); j < e; j++) {
+      const float weight = WH.raw(curIdx);
+      const dim_t rowIdx = IH.raw(curIdx++);
+      for (dim_t s = 0; s < numSubspaces; s++) {
+        const dim_t code = CH.at({rowIdx, s});
+        for (dim_t k = 0; k < subDim; k++) {
+          OH.at({i, s * subDim + k}) += weight * CBH.at({s, code, k});
+        }
+      }
+    }
+  }
+}
+
+void BoundInterpreterFunction::fwdProductQuantizedSparseLengthsWeightedSumInst(
+    const ProductQuantizedSparseLengthsWeightedSumInst *I) {
+  dispatchIndexTypeImpl(fwdProductQuantizedSparseLengthsWeightedSumImpl,
+                        I->getIndices()->getElementType(), I);
+}
+
 template <typename T, typename AccumT, typename IndexT>
 void BoundInterpreterFunction::fwdEmbeddingBagByteRowwiseOffsetsImpl(
     const EmbeddingBagByteRowwiseOffsetsInst *I) {
@@ -6476,6 +6683,65 @@ void BoundInterpreterFunction::fwdTopKInst(const TopKInst *I) {
                                     indW->getElementType(), outW, indW, inW, k);
 }
 
+template <typename IndexTy>
+void BoundInterpreterFunction::fwdBeamSearchStepInstImpl(
+    const BeamSearchStepInst *I) {
+  auto logitsH = getWeightHandle<float>(I->getLogits());
+  auto scoresH = getWeightHandle<float>(I->getScores());
+  auto newScoresH = getWeightHandle<float>(I->getNewScores());
+  auto tokensH = getWeightHandle<IndexTy>(I->getTokens());
+  auto prevIndicesH = getWeightHandle<IndexTy>(I->getPrevIndices());
+  const dim_t beam = logitsH.dims()[0];
+  const dim_t vocab = logitsH.dims()[1];
+
+  // The score of candidate v of beam b is at b * V + v.
+  using Candidate = std::pair<float, dim_t>;
+  std::vector<Candidate> candidates;
+  candidates.reserve(beam * vocab);
+  for (dim_t b = 0; b < beam; b++) {
+    float max = logitsH.at({b, 0});
+    for (dim_t v = 1; v < vocab; v++) {
+      max = std::max(max, logitsH.at({b, v}));
+    }
+    float sum = 0;
+    for (dim_t v = 0; v < vocab; v++) {
+      sum += std::exp(logitsH.at({b, v}) - max);
+    }
+    const float logSum = max + std::log(sum);
+    for (dim_t v = 0; v < vocab; v++) {
+      candidates.emplace_back(scoresH.at({b}) + (logitsH.at({b, v}) - logSum),
+                              b * vocab + v);
+    }
+  }
+  std::partial_sort(candidates.begin(), candidates.begin() + beam,
+                    candidates.end(),
+                    [](const Candidate &a, const Candidate &c) {
+                      if (a.first != c.first) {
+                        return a.first > c.first;
+                      }
+                      return a.second < c.second;
+                    });
+
+  Tensor *state = getTensor(I->getState());
+  Tensor *newState = getTensor(I->getNewState());
+  const size_t rowSize = state->getSizeInBytes() / beam;
+  for (dim_t i = 0; i < beam; i++) {
+    const dim_t prev = candidates[i].second / vocab;
+    newScoresH.at({i}) = candidates[i].first;
+    tokensH.at({i}) = candidates[i].second % vocab;
+    prevIndicesH.at({i}) = prev;
+    std::copy(state->getUnsafePtr() + prev * rowSize,
+              state->getUnsafePtr() + (prev + 1) * rowSize,
+              newState->getUnsafePtr() + i * rowSize);
+  }
+}
+
+void BoundInterpreterFunction::fwdBeamSearchStepInst(
+    const BeamSearchStepInst *I) {
+  dispatchIndexTypeImpl(fwdBeamSearchStepInstImpl,
+                        I->getTokens()->getElementType(), I);
+}
+
 void BoundInterpreterFunction::fwdBatchedUnaryEmbeddingsBagsInst(
     const BatchedUnaryEmbeddingsBagsInst *I) {
   dispatchFloatingPointAndIndexImpl(fwdBatchedUnaryEmbeddingsBagsInstImpl,
@@ -6764,15 +7030,13 @@ void BoundInterpreterFunction::fwdArgMinInst(const ArgMinInst *I) {
 //                  Tensor allocation operations
 //===----------------------------------------------------------------------===//
 
+// The activations live in the buffer of the execution, at the offsets of the
+// memory plan of the function.
 void BoundInterpreterFunction::fwdAllocActivationInst(
-    const AllocActivationInst *I) {
-  getOrCreateTensor(I);
-}
+    const AllocActivationInst *I) {}
 
 void BoundInterpreterFunction::fwdDeallocActivationInst(
-    const DeallocActivationInst *I) {
-  deleteTensor(I->getSrc());
-}
+    const DeallocActivationInst *I) {}
 
 //===----------------------------------------------------------------------===//
 //                       Debug instructions
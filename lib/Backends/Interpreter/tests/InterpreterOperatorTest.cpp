@@ -18,13 +18,8 @@
 using namespace glow;
 
 std::set<std::string> glow::backendTestBlacklist = {
-    "GatherWithInt32PartialTensors/0",
-    "GatherWithInt64PartialTensors/0",
     "LayerNorm_Int8/0",
     "LayerNorm_Int8_With_Float16_Scale_Bias/0",
-    "RepeatedSLSWithPartialTensors_int32/0",
-    "RepeatedSLSWithPartialTensors_int64/0",
-    "RepeatedSLWSWithPartialTensors/0",
     "SigmoidSweep_Float16/0",
     "TanHSweep_Float16/0",
     "BatchNorm2D_FP16_NCHW/0",
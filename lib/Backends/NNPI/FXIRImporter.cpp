@@ -676,12 +676,18 @@ const char *FXNNPIImporter::getConstantName(llvm::StringRef name) const {
 }
 
 const void *FXNNPIImporter::getConstant(llvm::StringRef name) const {
+  // Look the name up once when it is the name of a Constant already, which is
+  // the common case.
+  auto it = constants_.find(name);
+  if (it != constants_.end()) {
+    return it->second;
+  }
   const char *baseName = getConstantName(name);
   if (!baseName) {
     return nullptr;
   }
   // There must be a constant with name baseName, so return it.
-  auto it = constants_.find(baseName);
+  it = constants_.find(baseName);
   CHECK(it != constants_.end())
       << "Should have found constant with name " << baseName;
   return it->second;
@@ -855,11 +861,12 @@ NNPIErrorCode FXNNPIImporter::addTensor(
     desc.attributes.constant = 1;
     switch (dtype) {
     case DTYPE::INT64: {
-      auto it = constants_.find(name);
-      CHECK(it != constants_.end()) << "Did not find constant for " << name;
-      const auto *pDataInt64 = static_cast<const int64_t *>(it->second);
-      const auto &size = std::accumulate(dims.begin(), dims.end(), 1,
-                                         [](int x, int y) { return x * y; });
+      // Weights are handed to NNPI in place, INT64 ones are narrowed into
+      // a copy.
+      const auto *pDataInt64 = static_cast<const int64_t *>(pRawData);
+      const size_t size =
+          std::accumulate(dims.begin(), dims.end(), size_t(1),
+                          [](size_t x, glow::dim_t y) { return x * y; });
       pDataInt32 = std::make_unique<int[]>(size);
       for (size_t i = 0; i < size; i++) {
         pDataInt32[i] = static_cast<int32_t>(pDataInt64[i]);
@@ -967,9 +974,9 @@ NNPINetwork FXNNPIImporter::importFunction(const folly::dynamic &FXIR,
 
   // Add constants.
   const auto &weights = mod["weights"];
-  for (const auto &key : weights.keys()) {
-    const auto &name = key.getString();
-    const auto &weight = weights[name];
+  for (const auto &item : weights.items()) {
+    const auto &name = item.first.getString();
+    const auto &weight = item.second;
     DBG("Importing Constant: " << name);
     CHECK(constants_.count(name)) << "Constant not found for weight " << name;
     LOG_NNPI_IF_ERROR_RETURN_INVALID_HANDLE(addTensor(name, weight),
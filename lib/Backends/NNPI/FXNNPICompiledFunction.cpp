@@ -22,6 +22,16 @@
 
 using namespace glow;
 
+/// \returns the Placeholders of \p M by name, to look many of them up without
+/// walking the Placeholders of \p M for each.
+static llvm::StringMap<Placeholder *> getPlaceholdersByName(const Module *M) {
+  llvm::StringMap<Placeholder *> placeholders;
+  for (auto *PH : M->getPlaceholders()) {
+    placeholders.try_emplace(PH->getName(), PH);
+  }
+  return placeholders;
+}
+
 NNPICompiledFunction::NNPICompiledFunction(
     const folly::dynamic &FXIR, const std::string &submod,
     const llvm::StringMap<const void *> &constants, Module *glowModule)
@@ -30,10 +40,11 @@ NNPICompiledFunction::NNPICompiledFunction(
       compilationOptions_({}) {
   std::memset(&config_, 0, sizeof(config_));
   std::memset(&devNetConfig_, 0, sizeof(devNetConfig_));
+  auto placeholders = getPlaceholdersByName(glowModule);
   for (const auto &info : runtimeBundle_.getSymbolTable()) {
     if (info.second.symbolCategory ==
         glow::runtime::SymbolCategory::Placeholder) {
-      auto PH = glowModule->getPlaceholderByNameSlow(info.first);
+      auto PH = placeholders.lookup(info.first);
       if (PH->isStatic()) {
         staticInputs_.insert(PH);
       }
@@ -61,13 +72,14 @@ Error NNPICompiledFunction::compileFX(
   network_ = importer.importFunction(FXIR, submod);
 
   // Setup partial inputs and padded Placeholders based on parsing from FXIR.
+  auto placeholders = getPlaceholdersByName(glowModule);
   for (const auto &str : importer.getAllowPartialPlaceholderNames()) {
-    if (auto *P = glowModule->getPlaceholderByNameSlow(str.getKey())) {
+    if (auto *P = placeholders.lookup(str.getKey())) {
       partialInputs_.insert(P);
     }
   }
   for (const auto &str : importer.getRequiresPaddingPlaceholderNames()) {
-    if (auto *P = glowModule->getPlaceholderByNameSlow(str.getKey())) {
+    if (auto *P = placeholders.lookup(str.getKey())) {
       paddedInputs_.insert(P);
     }
   }
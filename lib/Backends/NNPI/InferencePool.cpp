@@ -20,6 +20,7 @@
 #include "NNPIDeviceManager.h"
 #include "NNPIUtils.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -50,11 +51,29 @@ static bool isEmptyDeviceNetworkConfig(const NNPIDeviceNetworkConfig &cfg) {
   return true;
 }
 
+bool InferenceContextBudget::reserve(bool force) {
+  const std::lock_guard<std::mutex> lock(lock_);
+  if (!force && limit_ && used_ >= limit_) {
+    return false;
+  }
+  used_++;
+  return true;
+}
+
+void InferenceContextBudget::release(unsigned count) {
+  const std::lock_guard<std::mutex> lock(lock_);
+  DCHECK_GE(used_, count);
+  used_ -= count;
+}
+
 InferencePoolEnv::InferencePoolEnv()
     : deviceOptions_(nullptr), nnpiCompiledFunction_(nullptr),
       staticPlaceholderMap_(nullptr) {}
 
 InferencePoolEnv::~InferencePoolEnv() {
+  if (contextBudget_) {
+    contextBudget_->release(inferenceContexts_.size());
+  }
   if (deviceOptions_ && deviceOptions_->inferOnDevice) {
     if (deviceNetwork_ != NNPI_INVALID_NNPIHANDLE) {
       LOG_NNPI_INF_IF_ERROR(nnpiDeviceNetworkDestroy(deviceNetwork_),
@@ -70,8 +89,10 @@ Error InferencePoolEnv::init(NNPIAdapterContainer *adapter,
                              StaticPlaceholderMap *staticPlaceholderMap,
                              std::shared_ptr<NNPIDeviceOptions> deviceOptions,
                              const std::string &functionName,
-                             unsigned deviceId) {
+                             unsigned deviceId,
+                             InferenceContextBudget *contextBudget) {
   deviceOptions_ = deviceOptions;
+  contextBudget_ = contextBudget;
   deviceId_ = deviceId;
   functionName_ = functionName;
   device_ = device;
@@ -91,12 +112,12 @@ Error InferencePoolEnv::init(NNPIAdapterContainer *adapter,
       numWorkers, std::make_shared<folly::NamedThreadFactory>("NNPI-worker"));
   staticPlaceholderMap_ = staticPlaceholderMap;
 
-  inferenceContexts_.resize(numWorkers);
-  freeContexts_.resize(numWorkers);
-  if (inferenceContexts_.size() != numWorkers) {
-    return MAKE_ERR(strFormat(
-        "InferencePool failed to create inference contexts for function %s",
-        functionName.c_str()));
+  // There is at most one context per worker. Unless asked for fewer, all of
+  // them are created upfront.
+  maxContexts_ = numWorkers;
+  minContexts_ = deviceOptions_->minInferenceContexts;
+  if (minContexts_ == 0 || minContexts_ > maxContexts_) {
+    minContexts_ = maxContexts_;
   }
 
   // Create host network.
@@ -273,21 +294,18 @@ Error InferencePoolEnv::init(NNPIAdapterContainer *adapter,
     }
   }
 
-  for (auto &infCtx : inferenceContexts_) {
-    auto success = infCtx.init(
-        inputDesc_, outputDesc_,
-        nnpiCompiledFunction_->getCompiledNetworkHandle(),
-        nnpiCompiledFunction_->getCompilationConfig(), deviceNetwork_, adapter,
-        device, nnpiCompiledFunction_->getPartialInputs(),
-        nnpiCompiledFunction_->getPaddedInputs(),
-        nnpiCompiledFunction_->getStaticInputs(), staticPlaceholderMap_,
-        deviceOptions_, functionName_, deviceId_);
-    if (!success) {
+  for (unsigned i = 0; i < minContexts_; i++) {
+    auto infCtx = createInferenceContext();
+    if (!infCtx) {
       return MAKE_ERR(
           strFormat("Failed to initialize inferece context for function %s",
                     functionName.c_str()));
     }
-    freeContexts_.push_back(&infCtx);
+    // The contexts every network needs are not bounded by the budget.
+    contextBudget_->reserve(/* force */ true);
+    freeContexts_.emplace_back(infCtx.get(), Clock::now());
+    inferenceContexts_.push_back(std::move(infCtx));
+    numContexts_++;
   }
 
   if (deviceOptions_->inferOnDevice && hostNetwork != NNPI_INVALID_NNPIHANDLE) {
@@ -301,6 +319,94 @@ Error InferencePoolEnv::init(NNPIAdapterContainer *adapter,
   return Error::success();
 }
 
+std::unique_ptr<InferenceContext> InferencePoolEnv::createInferenceContext() {
+  auto infCtx = glow::make_unique<InferenceContext>();
+  auto success = infCtx->init(
+      inputDesc_, outputDesc_,
+      nnpiCompiledFunction_->getCompiledNetworkHandle(),
+      nnpiCompiledFunction_->getCompilationConfig(), deviceNetwork_, pAdapter_,
+      device_, nnpiCompiledFunction_->getPartialInputs(),
+      nnpiCompiledFunction_->getPaddedInputs(),
+      nnpiCompiledFunction_->getStaticInputs(), staticPlaceholderMap_,
+      deviceOptions_, functionName_, deviceId_);
+  if (!success) {
+    return nullptr;
+  }
+  return infCtx;
+}
+
+InferenceContext *InferencePoolEnv::acquireContext() {
+  std::unique_lock<std::mutex> lock(freeContextsLock_);
+  // Runs wait for a context: add one if the bounds allow it.
+  if (freeContexts_.empty() && numContexts_ < maxContexts_ &&
+      contextBudget_->reserve(/* force */ false)) {
+    numContexts_++;
+    lock.unlock();
+    auto infCtx = createInferenceContext();
+    lock.lock();
+    if (infCtx) {
+      LOG(INFO) << "Added inference context " << inferenceContexts_.size() + 1
+                << " of function " << functionName_;
+      inferenceContexts_.push_back(std::move(infCtx));
+      return inferenceContexts_.back().get();
+    }
+    LOG(WARNING) << "Failed to add an inference context to function "
+                 << functionName_;
+    numContexts_--;
+    contextBudget_->release(1);
+  }
+  // There are fewer contexts than workers, wait for one. Failing to create
+  // even the minimum of one context fails the initialization of the pool.
+  freeContextsCV_.wait(lock, [this]() { return !freeContexts_.empty(); });
+  auto *infCtx = freeContexts_.back().first;
+  freeContexts_.pop_back();
+  return infCtx;
+}
+
+std::vector<std::unique_ptr<InferenceContext>>
+InferencePoolEnv::takeIdleContexts() {
+  std::vector<std::unique_ptr<InferenceContext>> idleContexts;
+  const unsigned idleMs = deviceOptions_->inferenceContextIdleMs;
+  if (idleMs == 0) {
+    return idleContexts;
+  }
+  const auto idleSince = Clock::now() - std::chrono::milliseconds(idleMs);
+  // The least recently used contexts are first.
+  size_t numIdle = 0;
+  while (numIdle < freeContexts_.size() &&
+         numContexts_ - numIdle > minContexts_ &&
+         freeContexts_[numIdle].second < idleSince) {
+    auto *infCtx = freeContexts_[numIdle].first;
+    auto it = std::find_if(
+        inferenceContexts_.begin(), inferenceContexts_.end(),
+        [infCtx](const std::unique_ptr<InferenceContext> &ctx) {
+          return ctx.get() == infCtx;
+        });
+    DCHECK(it != inferenceContexts_.end());
+    idleContexts.push_back(std::move(*it));
+    inferenceContexts_.erase(it);
+    numIdle++;
+  }
+  if (numIdle) {
+    freeContexts_.erase(freeContexts_.begin(), freeContexts_.begin() + numIdle);
+    numContexts_ -= numIdle;
+    contextBudget_->release(numIdle);
+    LOG(INFO) << "Released " << numIdle << " idle inference contexts of "
+              << "function " << functionName_;
+  }
+  return idleContexts;
+}
+
+void InferencePoolEnv::releaseContext(InferenceContext *infCtx) {
+  std::vector<std::unique_ptr<InferenceContext>> idleContexts;
+  {
+    const std::lock_guard<std::mutex> lock(freeContextsLock_);
+    freeContexts_.emplace_back(infCtx, Clock::now());
+    idleContexts = takeIdleContexts();
+  }
+  freeContextsCV_.notify_one();
+}
+
 void InferencePoolEnv::stop(bool block) {
   workersPool_->stop();
   if (block) {
@@ -324,18 +430,9 @@ void InferencePoolEnv::execute(RunIdentifierTy runId,
       return;
     }
 
-    InferenceContext *infCtx = nullptr;
-    {
-      const std::lock_guard<std::mutex> lock(freeContextsLock_);
-      CHECK(!freeContexts_.empty());
-      infCtx = *freeContexts_.rbegin();
-      freeContexts_.pop_back();
-    }
+    InferenceContext *infCtx = acquireContext();
     infCtx->execute(runId, std::move(ctx), resultCB);
-    {
-      const std::lock_guard<std::mutex> lock(freeContextsLock_);
-      freeContexts_.push_back(infCtx);
-    }
+    releaseContext(infCtx);
   });
 }
 
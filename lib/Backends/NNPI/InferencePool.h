@@ -25,7 +25,10 @@
 #include "nnpi_inference.h"
 #include "nnpi_transformer.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -33,11 +36,43 @@ namespace glow {
 class NNPIAdapterContainer;
 namespace runtime {
 class NNPIDeviceBindings;
+/// Number of inference contexts of all the networks of a device, bounded by
+/// the MaxInferenceContexts device option.
+class InferenceContextBudget {
+  std::mutex lock_;
+  unsigned used_{0};
+  unsigned limit_{0};
+
+public:
+  /// Set the maximum number of contexts to \p limit, 0 for no limit.
+  void setLimit(unsigned limit) { limit_ = limit; }
+  /// Reserve a context. \returns false, reserving nothing, if the limit is
+  /// reached, unless \p force.
+  bool reserve(bool force);
+  /// Release \p count reserved contexts.
+  void release(unsigned count);
+};
+
+/// A pool of workers running the inferences of a network, with a pool of
+/// inference contexts which grows when runs wait for a context and shrinks
+/// when contexts stay unused, see the MinInferenceContexts and
+/// InferenceContextIdleMs device options.
 class InferencePoolEnv {
+  using Clock = std::chrono::steady_clock;
+
   std::unique_ptr<folly::CPUThreadPoolExecutor> workersPool_;
-  std::vector<InferenceContext> inferenceContexts_;
-  std::vector<InferenceContext *> freeContexts_;
+  std::vector<std::unique_ptr<InferenceContext>> inferenceContexts_;
+  /// Unused contexts and the last time they were used, most recently used
+  /// last.
+  std::vector<std::pair<InferenceContext *, Clock::time_point>> freeContexts_;
+  /// Number of contexts, including those being created.
+  unsigned numContexts_{0};
+  /// Bounds of the number of contexts.
+  unsigned minContexts_{0};
+  unsigned maxContexts_{0};
   std::mutex freeContextsLock_;
+  std::condition_variable freeContextsCV_;
+  InferenceContextBudget *contextBudget_{nullptr};
   NNPIDeviceNetwork deviceNetwork_;
   std::shared_ptr<NNPIDeviceOptions> deviceOptions_;
   unsigned deviceId_;
@@ -56,12 +91,26 @@ public:
              CompiledFunction *compiledFunction,
              StaticPlaceholderMap *staticPlaceholderMap,
              std::shared_ptr<NNPIDeviceOptions> deviceOptions,
-             const std::string &functionName, unsigned deviceId);
+             const std::string &functionName, unsigned deviceId,
+             InferenceContextBudget *contextBudget);
   InferenceContext *
   createDetachedInferenceContext(PlaceholderUsageMap &phUsage);
   void stop(bool block);
   void execute(RunIdentifierTy runId, std::unique_ptr<ExecutionContext> ctx,
                runtime::ResultCBTy resultCB);
+
+private:
+  /// \returns a new inference context of the network, nullptr on failure.
+  std::unique_ptr<InferenceContext> createInferenceContext();
+  /// \returns an unused context, creating one if all are in use and the
+  /// bounds allow it, else waiting for one.
+  InferenceContext *acquireContext();
+  /// Return \p infCtx to the unused contexts.
+  void releaseContext(InferenceContext *infCtx);
+  /// Destroy the contexts, beyond the minimum number, unused for longer than
+  /// the InferenceContextIdleMs device option. Called with freeContextsLock_
+  /// held, \returns the destroyed contexts to be freed after releasing it.
+  std::vector<std::unique_ptr<InferenceContext>> takeIdleContexts();
 };
 
 using InferencePoolMap = std::unordered_map<std::string, InferencePoolEnv>;
@@ -1379,8 +1379,29 @@ static Error setupPerNodeParallelizationConfigs(
   return Error::success();
 }
 
+/// Time of copying a byte, and fixed time of running a chunk, relative to a
+/// multiply-accumulate, used by the cost model of planParallelization().
+constexpr double kNNPITimePerByte = 4.0;
+constexpr double kNNPITimePerChunk = 16384.0;
+
+/// \returns the number of cores the parallelization planner should split the
+/// nodes for, from GlowNNPIAutoParallelCores or else the NNPIAutoParallelCores
+/// backend option in \p opts, 0 if it is not used.
+static Expected<int32_t> getAutoParallelCores(BackendOptions &opts) {
+  if (glow::nnpi::flags::AutoParallelCores) {
+    return glow::nnpi::flags::AutoParallelCores;
+  }
+  auto it = opts.backendSpecificOpts.find(std::string("NNPIAutoParallelCores"));
+  if (it == opts.backendSpecificOpts.end()) {
+    return 0;
+  }
+  return getIntFromStr(it->second);
+}
+
 /// Parallelize \p F. If this Function has backendSpecificNodeInfo in \p opts
-/// then this parallelization is done based on that. Else perform basic
+/// then this parallelization is done based on that. Else if a number of cores
+/// is given by GlowNNPIAutoParallelCores or NNPIAutoParallelCores then the
+/// splits are picked by planParallelization(). Else perform basic
 /// parallelization according to either GlowNNPINumParallelChunks, or if not
 /// specified then NNPINumParallelChunks found in
 /// backendOpts.backendSpecificOpts from \p opts. \returns whether \p F was
@@ -1395,10 +1416,19 @@ static Expected<bool> parallelizeFunction(Function *F, BackendOptions &opts) {
   const bool usePerNodeParallelizationSpec =
       opts.backendSpecificNodeInfo.find(F) !=
       opts.backendSpecificNodeInfo.end();
+  int32_t autoParallelCores = 0;
+  ASSIGN_VALUE_OR_RETURN_ERR(autoParallelCores, getAutoParallelCores(opts));
   if (usePerNodeParallelizationSpec) {
     // Only parallelize based on what is explicitly specified.
     RETURN_IF_ERR(setupPerNodeParallelizationConfigs(
         F, numChunks, parOpts, opts.backendSpecificNodeInfo));
+  } else if (autoParallelCores > 1) {
+    // Let the cost model pick the splits for the given number of cores.
+    ParallelCostModel costModel;
+    costModel.numCores = autoParallelCores;
+    costModel.timePerByte = kNNPITimePerByte;
+    costModel.timePerChunk = kNNPITimePerChunk;
+    planParallelization(F, costModel, numChunks, parOpts);
   } else {
     // Check for basic parallelization based on specified degree of parallelism.
     defaultNumParallelChunks = glow::nnpi::flags::NumParallelChunks;
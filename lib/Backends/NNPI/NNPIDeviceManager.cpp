@@ -68,6 +68,7 @@ NNPIDeviceManager::NNPIDeviceManager(
   if (flags::NNPITimeoutMs != 0) {
     deviceOptions_->inferTimeoutUs = flags::NNPITimeoutMs * 1000;
   }
+  contextBudget_.setLimit(deviceOptions_->maxInferenceContexts);
 }
 
 NNPIDeviceManager::~NNPIDeviceManager() {
@@ -183,7 +184,7 @@ void NNPIDeviceManager::addNetwork(const Module *module,
     usedMemoryBytes_ += functionCost_; // TODO:: static moduleSize.
     auto err = inferencePools_[func.first].init(
         pAdapter_, device_, func.second, &staticPlaceholders_, deviceOptions_,
-        func.first, deviceId_);
+        func.first, deviceId_, &contextBudget_);
     if (err) {
       functions_.erase(func.first);
       inferencePools_.erase(func.first);
@@ -59,6 +59,8 @@ class NNPIDeviceManager : public DeviceManager {
 
   /// NNPI Device id.
   unsigned deviceId_;
+  /// Inference contexts of the added networks, which must outlive them.
+  InferenceContextBudget contextBudget_;
   /// Inference objects kept per added network.
   InferencePoolMap inferencePools_;
 
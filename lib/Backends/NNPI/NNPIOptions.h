@@ -520,7 +520,8 @@ public:
   DECLARE_NNPI_OPTION(avxType, int, "AvxType",
                       "Force using a specific AVX type."
                       "\n  0 = No AVX. "
-                      "\n  1 = Use AVX512. ",
+                      "\n  1 = Use AVX512. "
+                      "\n  2 = Use AVX2. ",
                       "NNPI_AVX_TYPE", "-1");
   /// Disable DRT support.
   DECLARE_NNPI_OPTION(disableDRT, bool, "DisableDRT",
@@ -548,6 +549,27 @@ public:
       "\n 3 = All commands and pre/post processing are disabled.",
       "NNPI_DISABLE_COMMANDS", "0");
 
+  /// Number of inference contexts created with a network.
+  DECLARE_NNPI_OPTION(
+      minInferenceContexts, unsigned, "MinInferenceContexts",
+      "Number of inference contexts created with a network, more are created "
+      "up to NumOfWorkers while runs wait for a context (0 creates them all "
+      "upfront).",
+      "NNPI_MIN_INFERENCE_CONTEXTS", "0");
+  /// Idle time after which inference contexts are destroyed.
+  DECLARE_NNPI_OPTION(
+      inferenceContextIdleMs, unsigned, "InferenceContextIdleMs",
+      "Destroy the inference contexts of a network beyond "
+      "MinInferenceContexts which stay unused for this many milliseconds "
+      "(0 never destroys them).",
+      "NNPI_INFERENCE_CONTEXT_IDLE_MS", "0");
+  /// Maximum number of inference contexts of a device.
+  DECLARE_NNPI_OPTION(
+      maxInferenceContexts, unsigned, "MaxInferenceContexts",
+      "Maximum number of inference contexts of all the networks of a device, "
+      "beyond the MinInferenceContexts of each network (0 for no limit).",
+      "NNPI_MAX_INFERENCE_CONTEXTS", "0");
+
   /// Inference timeout threshold in us. Default UINT32_MAX means infinity.
   unsigned inferTimeoutUs{UINT32_MAX};
 
@@ -568,10 +590,15 @@ public:
     INIT_NNPI_OPTIONS(dumpRuntime, parameters);
     INIT_NNPI_OPTIONS(disableDeviceIOBuffer, parameters);
     INIT_NNPI_OPTIONS(disableCommands, parameters);
+    INIT_NNPI_OPTIONS(minInferenceContexts, parameters);
+    INIT_NNPI_OPTIONS(inferenceContextIdleMs, parameters);
+    INIT_NNPI_OPTIONS(maxInferenceContexts, parameters);
 
     if (avxType == -1) {
       if (isStringFoundInCpuInfo("avx512f")) {
         avxType.setVal(NNPI_AVX_AVX512);
+      } else if (isStringFoundInCpuInfo("avx2")) {
+        avxType.setVal(NNPI_AVX_AVX2);
       } else {
         avxType.setVal(NNPI_AVX_NONE);
       }
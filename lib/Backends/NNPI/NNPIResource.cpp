@@ -410,13 +410,20 @@ NNPIInferenceErrorCode NNPIResource::postInference(Tensor *t) {
   const bool upcastInt64 = t->getElementType() == glow::ElemKind::Int64ITy;
   size_t unpaddedSize = t->getUnpaddedSizeInBytes();
   if (upcastInt64) {
-    // TODO: add AVX implementation.
     const size_t outputSize = unpaddedSize / t->getType().getElementSize();
     int64_t *i64Data = reinterpret_cast<int64_t *>(tensorData);
     int32_t *i32Data = reinterpret_cast<int32_t *>(hostPtr_);
-    // Convert from end to start for the case where (tensorData == hostPtr_).
-    for (int64_t j = (outputSize - 1); j >= 0; j--) {
-      i64Data[j] = static_cast<int64_t>(i32Data[j]);
+    // The conversions go from end to start for the case where
+    // (tensorData == hostPtr_).
+    switch (deviceOptions_->avxType) {
+    case NNPI_AVX_AVX512:
+      convertI32toI64_AVX512(i32Data, i64Data, outputSize);
+      break;
+    case NNPI_AVX_AVX2:
+      convertI32toI64_AVX2(i32Data, i64Data, outputSize);
+      break;
+    default:
+      convertI32toI64(i32Data, i64Data, outputSize);
     }
   } else {
     if (tensorData != hostPtr_) {
@@ -542,6 +549,11 @@ bool NNPIResource::updateHostResourceFromTensor(
                              reinterpret_cast<int32_t *>(hostPtr_),
                              unpaddedSize / sizeof(int32_t));
       break;
+    case NNPI_AVX_AVX2:
+      convertI64toI32_AVX2(reinterpret_cast<const int64_t *>(tensorData),
+                           reinterpret_cast<int32_t *>(hostPtr_),
+                           unpaddedSize / sizeof(int32_t));
+      break;
     default:
       LOG(ERROR) << "Invalid avxType=" << deviceOptions_->avxType;
     }
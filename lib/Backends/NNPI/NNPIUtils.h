@@ -24,7 +24,7 @@
 
 using namespace std;
 
-enum NNPIAVXType { NNPI_AVX_NONE = 0, NNPI_AVX_AVX512 };
+enum NNPIAVXType { NNPI_AVX_NONE = 0, NNPI_AVX_AVX512, NNPI_AVX_AVX2 };
 
 inline void convertI64toI32(int64_t const *i64Data, int32_t *i32Data,
                             uint32_t elements) {
@@ -34,6 +34,21 @@ inline void convertI64toI32(int64_t const *i64Data, int32_t *i32Data,
 }
 void convertI64toI32_AVX512(int64_t const *i64Data, int32_t *i32Data,
                             uint32_t elements);
+void convertI64toI32_AVX2(int64_t const *i64Data, int32_t *i32Data,
+                          uint32_t elements);
+
+/// Converts from end to start, so that \p i32Data and \p i64Data may start
+/// at the same address.
+inline void convertI32toI64(int32_t const *i32Data, int64_t *i64Data,
+                            uint32_t elements) {
+  for (size_t i = elements; i-- > 0;) {
+    i64Data[i] = static_cast<int64_t>(i32Data[i]);
+  }
+}
+void convertI32toI64_AVX512(int32_t const *i32Data, int64_t *i64Data,
+                            uint32_t elements);
+void convertI32toI64_AVX2(int32_t const *i32Data, int64_t *i64Data,
+                          uint32_t elements);
 
 // Static Dot writer (not thread safe).
 class DotWriter {
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "NNPIUtils.h"
+#include <immintrin.h>
+
+void convertI64toI32_AVX2(int64_t const *i64Data, int32_t *i32Data,
+                          uint32_t elements) {
+  constexpr uint32_t vecSize = (sizeof(__m256i) / sizeof(int32_t));
+  const uint32_t fullIterations = (elements / vecSize);
+  const uint32_t tailElements = (elements % vecSize);
+  // Moves the low halves of the 64-bit elements to the low 128 bits.
+  const __m256i lowHalves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+  for (uint32_t i = 0; i < fullIterations; i++) {
+    __m256i lo = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(i64Data)),
+        lowHalves);
+    __m256i hi = _mm256_permutevar8x32_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(i64Data + 4)),
+        lowHalves);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(i32Data),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    i64Data += vecSize;
+    i32Data += vecSize;
+  }
+  convertI64toI32(i64Data, i32Data, tailElements);
+}
+
+void convertI32toI64_AVX2(int32_t const *i32Data, int64_t *i64Data,
+                          uint32_t elements) {
+  constexpr uint32_t vecSize = (sizeof(__m256i) / sizeof(int64_t));
+  const uint32_t fullIterations = (elements / vecSize);
+  const uint32_t tailElements = (elements % vecSize);
+
+  // Convert from end to start for the case where the data is converted in
+  // place: a vector only overwrites the elements of itself and of the vectors
+  // after it.
+  const uint32_t offset = fullIterations * vecSize;
+  convertI32toI64(i32Data + offset, i64Data + offset, tailElements);
+  for (uint32_t i = fullIterations; i-- > 0;) {
+    __m128i i32vec = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(i32Data + i * vecSize));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(i64Data + i * vecSize),
+                        _mm256_cvtepi32_epi64(i32vec));
+  }
+}
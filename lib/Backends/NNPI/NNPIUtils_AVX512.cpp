@@ -35,3 +35,26 @@ void convertI64toI32_AVX512(int64_t const *i64Data, int32_t *i32Data,
     _mm512_mask_cvtepi64_storeu_epi32(i32Data, masks[tailElements], i64vec);
   }
 }
+
+void convertI32toI64_AVX512(int32_t const *i32Data, int64_t *i64Data,
+                            uint32_t elements) {
+  constexpr uint32_t vecSize = (sizeof(__m512i) / sizeof(int64_t));
+  const uint32_t fullIterations = (elements / vecSize);
+  const uint32_t tailElements = (elements % vecSize);
+
+  // Convert from end to start for the case where the data is converted in
+  // place: a vector only overwrites the elements of itself and of the vectors
+  // after it.
+  if (tailElements > 0) {
+    const uint32_t offset = fullIterations * vecSize;
+    const __mmask8 tail = (1 << tailElements) - 1;
+    __m256i i32vec = _mm256_maskz_loadu_epi32(tail, i32Data + offset);
+    _mm512_mask_storeu_epi64(i64Data + offset, tail,
+                             _mm512_cvtepi32_epi64(i32vec));
+  }
+  for (uint32_t i = fullIterations; i-- > 0;) {
+    __m256i i32vec = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(i32Data + i * vecSize));
+    _mm512_storeu_si512(i64Data + i * vecSize, _mm512_cvtepi32_epi64(i32vec));
+  }
+}
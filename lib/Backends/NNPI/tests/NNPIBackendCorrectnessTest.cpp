@@ -36,6 +36,7 @@ struct BlacklistInitializer {
       {"nonSquareStrideConvTest/0", TestBlacklist::AnyDeviceAnyEngine},
       {"nonSquareKernelConvTest/0", TestBlacklist::AnyDeviceAnyEngine},
       {"nonSquarePaddingConvTest/0", TestBlacklist::AnyDeviceAnyEngine},
+      {"quantizationProfileTest/0", TestBlacklist::AnyDeviceAnyEngine},
       {"quantizedConvTest/0", TestBlacklist::AnyDeviceAnyEngine},
       {"softmaxGradTest/0", TestBlacklist::AnyDeviceAnyEngine},
       {"convOps/0", TestBlacklist::AnyDeviceHWEngine},
@@ -618,6 +618,8 @@ struct BlacklistInitializer {
        TestBlacklist::AnyDeviceAnyEngine},
       {"DynamicQuantizedFullyConnectedStrongWeights/0",
        TestBlacklist::AnyDeviceAnyEngine},
+      {"DynamicQuantizedFullyConnected_Float/0",
+       TestBlacklist::AnyDeviceAnyEngine},
       {"DynamicRowwiseQuantizedFullyConnectedBasic/0",
        TestBlacklist::AnyDeviceHWEngine},
       {"CmpNEQ_Int16QTy/0", TestBlacklist::AnyDeviceAnyEngine},
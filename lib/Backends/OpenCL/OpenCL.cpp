@@ -34,6 +34,7 @@
 #include "glow/Quantization/Base/Base.h"
 #include "glow/Support/Debug.h"
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
@@ -42,7 +43,11 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <chrono>
 #include <fstream>
+#include <functional>
+#include <list>
+#include <mutex>
 
 #define DEBUG_TYPE "opencl"
 
@@ -105,6 +110,12 @@ llvm::cl::opt<bool> clSpecializeConvolution(
     llvm::cl::desc("Aggressively specialize convolution kernel launches."),
     llvm::cl::init(false), llvm::cl::cat(OpenCLBackendCat));
 
+llvm::cl::opt<bool> clTuneConvolution(
+    "opencl-tune-convolution",
+    llvm::cl::desc("Pick the tiling of each NCHW convolution by timing the "
+                   "candidate tilings on the device at its first run."),
+    llvm::cl::init(false), llvm::cl::cat(OpenCLBackendCat));
+
 llvm::cl::opt<std::string> clDeviceProgramCacheDir(
     "opencl-program-cache-dir",
     llvm::cl::desc("The program disk cache directory for the "
@@ -199,12 +210,38 @@ std::string OpenCLFunction::deviceProgramCacheDir(cl_device_id deviceId) {
   return clDeviceProgramCacheDir;
 }
 
+/// \returns the string device info \p paramName of \p deviceId, empty if it
+/// cannot be queried.
+static std::string getDeviceInfoString(cl_device_id deviceId,
+                                       cl_device_info paramName) {
+  size_t size = 0;
+  if (clGetDeviceInfo(deviceId, paramName, 0, nullptr, &size) != CL_SUCCESS ||
+      size == 0) {
+    return "";
+  }
+  std::string info(size, '\0');
+  if (clGetDeviceInfo(deviceId, paramName, size, &info[0], nullptr) !=
+      CL_SUCCESS) {
+    return "";
+  }
+  // Drop the terminating null character.
+  info.resize(size - 1);
+  return info;
+}
+
 std::string
 OpenCLFunction::diskCacheProgramFileName(cl_device_id deviceId,
                                          const std::string &source,
                                          const std::string &options) {
+  // The binaries are specific to the device and to the driver which built
+  // them, which are identified by their names and versions.
   std::ostringstream hashString;
-  hashString << source << options;
+  hashString << getDeviceInfoString(deviceId, CL_DEVICE_VENDOR) << '\n'
+             << getDeviceInfoString(deviceId, CL_DEVICE_NAME) << '\n'
+             << getDeviceInfoString(deviceId, CL_DEVICE_VERSION) << '\n'
+             << getDeviceInfoString(deviceId, CL_DRIVER_VERSION) << '\n'
+             << options << '\n'
+             << source;
   return std::to_string(std::hash<std::string>{}(hashString.str())) + ".clb";
 }
 
@@ -278,13 +315,24 @@ void OpenCLFunction::saveProgramToDiskCache(std::string cacheDirectory,
   CHECK_EQ(errC, CL_SUCCESS)
       << "clGetProgramInfo for CL_PROGRAM_BINARIES failed.";
 
-  std::ofstream binFile(programPath.c_str(),
-                        std::ios::binary | std::ios::trunc);
-  CHECK(binFile) << "Error opening " << programPath << " for writing.";
-
-  binFile.write((const char *)bin.get(), binSize);
-  CHECK(binFile) << "Could not write binary to " << programPath << ".";
-  binFile.close();
+  // Write the binary to a file of a unique name which is then renamed, so that
+  // processes sharing the cache never load a partially written binary.
+  llvm::SmallString<128> tmpPath;
+  int fd;
+  std::error_code errc = llvm::sys::fs::createUniqueFile(
+      programPath + ".%%%%%%%%.tmp", fd, tmpPath);
+  CHECK(!errc) << "Error creating a temporary file for " << programPath << ".";
+  {
+    llvm::raw_fd_ostream binFile(fd, /* shouldClose */ true);
+    binFile.write((const char *)bin.get(), binSize);
+    binFile.close();
+    CHECK(!binFile.has_error())
+        << "Could not write binary to " << tmpPath.str().str() << ".";
+  }
+  errc = llvm::sys::fs::rename(tmpPath, programPath);
+  if (errc) {
+    llvm::sys::fs::remove(tmpPath);
+  }
 }
 
 cl_program
@@ -523,6 +571,79 @@ void OpenCLFunction::enqueueKernel(llvm::StringRef name,
       KernelLaunch(kernel, name.str(), kernelType, profile ? event : nullptr));
 }
 
+namespace {
+/// Workgroup sizes and work per thread of the NCHW convolution kernels, see
+/// kernels_fwd_conv.cl.
+struct ConvTiling {
+  size_t wgs0{16};
+  size_t wgs1{16};
+  size_t WPTN{4};
+  size_t WPTM{4};
+  size_t TSK{4};
+};
+
+/// Tilings picked by tuneConvTiling, by device and convolution parameters.
+std::unordered_map<std::string, ConvTiling> tunedConvTilings;
+std::mutex tunedConvTilingsMutex;
+
+/// \returns the tiling of the lowest time given by \p timeTiling among
+/// \p defaultTiling and the tilings the kernels support. \p timeTiling
+/// returns a negative time for the tilings the device cannot run.
+ConvTiling
+tuneConvTiling(const ConvTiling &defaultTiling,
+               const std::function<double(const ConvTiling &)> &timeTiling) {
+  ConvTiling best = defaultTiling;
+  double bestTime = timeTiling(defaultTiling);
+  for (size_t wgs0 : {8, 16}) {
+    for (size_t wgs1 : {8, 16}) {
+      for (size_t WPTN : {4, 8}) {
+        for (size_t WPTM : {4, 8}) {
+          for (size_t TSK : {4, 8}) {
+            // The tiles of both operands are loaded by all the threads of
+            // the workgroup, each loading the same number of elements.
+            if ((TSK * WPTM) % wgs0 || (TSK * WPTN) % wgs1) {
+              continue;
+            }
+            ConvTiling T{wgs0, wgs1, WPTN, WPTM, TSK};
+            double time = timeTiling(T);
+            if (time >= 0 && (bestTime < 0 || time < bestTime)) {
+              best = T;
+              bestTime = time;
+            }
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+
+/// \returns the average time in seconds of a few runs of \p kernel with the
+/// work sizes \p global and \p local on \p commands, after a warm-up run
+/// which also waits for the commands enqueued before.
+double timeKernel(cl_command_queue commands, cl_kernel kernel,
+                  llvm::ArrayRef<size_t> global, llvm::ArrayRef<size_t> local) {
+  constexpr unsigned numRuns = 3;
+  auto enqueue = [&]() {
+    return clEnqueueNDRangeKernel(commands, kernel, global.size(), nullptr,
+                                  &global[0], &local[0], 0, nullptr, nullptr);
+  };
+  if (enqueue() != CL_SUCCESS || clFinish(commands) != CL_SUCCESS) {
+    return -1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < numRuns; i++) {
+    if (enqueue() != CL_SUCCESS) {
+      clFinish(commands);
+      return -1;
+    }
+  }
+  clFinish(commands);
+  std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+  return time.count() / numRuns;
+}
+} // namespace
+
 void OpenCLFunction::executeNCHWConvolution(
     const ConvolutionInst *CC, ExecutionContext *executionContext,
     runtime::OpenCLDeviceBindings *devBindings) {
@@ -604,6 +725,7 @@ void OpenCLFunction::executeNCHWConvolution(
                         sizeof(dev_max_wg_size), &dev_max_wg_size, nullptr);
   CHECK_EQ(err, CL_SUCCESS) << "Could not execute clGetDeviceInfo";
 
+  ConvTiling tiling;
   size_t wg_size[3];
 
   for (int id = 0; id < 2; ++id) {
@@ -615,26 +737,10 @@ void OpenCLFunction::executeNCHWConvolution(
     }
     if (id == 1 && defaultVal * wg_size[0] > dev_max_wg_size)
       defaultVal = dev_max_wg_size / wg_size[0];
-    addIntOption(options, "workgroup_size_" + std::to_string(id), defaultVal);
     wg_size[id] = defaultVal;
   }
-  // The tile-size in dimension K.
-  // Should be tunable.
-  addStringOption(options, "TSK", "4");
-  addIntOption(options, "TSK_UNROLL", 1);
-
-  // WPTN and WPTM should be tunable.
-  size_t WPTN = 4;
-  size_t WPTM = 4;
-  // The work-per-thread in dimension N.
-  addIntOption(options, "WPTN", WPTN);
-  // The work-per-thread in dimension M.
-  addIntOption(options, "WPTM", WPTM);
-
-  // Vector width in dimensions M and M.
-  // VWN and VWM should be tunable.
-  addStringOption(options, "VWM", "4");
-  addStringOption(options, "VWN", "4");
+  tiling.wgs0 = wg_size[0];
+  tiling.wgs1 = wg_size[1];
 
   // Generate a tailor-made convolution kernel using the provided options based
   // on the parameters of the current convolution.
@@ -648,57 +754,115 @@ void OpenCLFunction::executeNCHWConvolution(
                kernels_fwd_conv_cl_src_size);
   }
 
-  TRACE_EVENT_SCOPE_NAMED(executionContext->getTraceContext(),
-                          TraceLevel::RUNTIME, "convCreateProgram", cpEvent);
-  auto prog = createProgram(src, options, devBindings->commandQueue);
-  TRACE_EVENT_SCOPE_END_NAMED(cpEvent);
-
-  auto kernelName = isQuantized ? "conv_forward_mem_i8" : "conv_forward_mem";
-  auto kernel = createKernel(kernelName, prog);
-  setKernelArg(kernel, 0, devBindings->deviceBuffer);
-  setKernelArg<cl_uint>(kernel, 1, runtimeBundle_.getValueOffset(input));
-  setKernelArg<cl_uint>(kernel, 2, runtimeBundle_.getValueOffset(weights));
-  setKernelArg<cl_uint>(kernel, 3, runtimeBundle_.getValueOffset(bias));
-  setKernelArg<cl_uint>(kernel, 4, runtimeBundle_.getValueOffset(output));
-
-  // Extra options for quantized kernel
-  if (isQuantized) {
-    auto inputTy = CC->getSrc()->getType();
-    auto outputTy = CC->getDest()->getType();
-    auto biasTy = CC->getBias()->getType();
-    auto weightsTy = CC->getFilter()->getType();
-    setKernelArg(kernel, 5, weightsTy->getOffset());
-    setKernelArg(kernel, 6, weightsTy->getScale());
-    setKernelArg(kernel, 7, inputTy->getOffset());
-    setKernelArg(kernel, 8, inputTy->getScale());
-    setKernelArg(kernel, 9, outputTy->getOffset());
-    setKernelArg(kernel, 10, outputTy->getScale());
-    setKernelArg(kernel, 11, biasTy->getOffset());
-    setKernelArg(kernel, 12, biasTy->getScale());
+  // \returns the kernel of the convolution with the tiling \p T, with its
+  // arguments set.
+  auto createConvKernel = [&](const ConvTiling &T) {
+    std::vector<std::string> tiledOptions = options;
+    addIntOption(tiledOptions, "workgroup_size_0", T.wgs0);
+    addIntOption(tiledOptions, "workgroup_size_1", T.wgs1);
+    // The tile-size in dimension K.
+    addIntOption(tiledOptions, "TSK", T.TSK);
+    addIntOption(tiledOptions, "TSK_UNROLL", 1);
+    // The work-per-thread in dimension N.
+    addIntOption(tiledOptions, "WPTN", T.WPTN);
+    // The work-per-thread in dimension M.
+    addIntOption(tiledOptions, "WPTM", T.WPTM);
+    // Vector width in dimensions M and M, which the kernels fix to 4.
+    addStringOption(tiledOptions, "VWM", "4");
+    addStringOption(tiledOptions, "VWN", "4");
+
+    TRACE_EVENT_SCOPE_NAMED(executionContext->getTraceContext(),
+                            TraceLevel::RUNTIME, "convCreateProgram", cpEvent);
+    auto prog = createProgram(src, tiledOptions, devBindings->commandQueue);
+    TRACE_EVENT_SCOPE_END_NAMED(cpEvent);
+
+    auto kernelName = isQuantized ? "conv_forward_mem_i8" : "conv_forward_mem";
+    auto kernel = createKernel(kernelName, prog);
+    setKernelArg(kernel, 0, devBindings->deviceBuffer);
+    setKernelArg<cl_uint>(kernel, 1, runtimeBundle_.getValueOffset(input));
+    setKernelArg<cl_uint>(kernel, 2, runtimeBundle_.getValueOffset(weights));
+    setKernelArg<cl_uint>(kernel, 3, runtimeBundle_.getValueOffset(bias));
+    setKernelArg<cl_uint>(kernel, 4, runtimeBundle_.getValueOffset(output));
+
+    // Extra options for quantized kernel
+    if (isQuantized) {
+      auto inputTy = CC->getSrc()->getType();
+      auto outputTy = CC->getDest()->getType();
+      auto biasTy = CC->getBias()->getType();
+      auto weightsTy = CC->getFilter()->getType();
+      setKernelArg(kernel, 5, weightsTy->getOffset());
+      setKernelArg(kernel, 6, weightsTy->getScale());
+      setKernelArg(kernel, 7, inputTy->getOffset());
+      setKernelArg(kernel, 8, inputTy->getScale());
+      setKernelArg(kernel, 9, outputTy->getOffset());
+      setKernelArg(kernel, 10, outputTy->getScale());
+      setKernelArg(kernel, 11, biasTy->getOffset());
+      setKernelArg(kernel, 12, biasTy->getScale());
+    }
+    return kernel;
+  };
+
+  // \returns the global work size of the convolution with the tiling \p T.
+  auto getConvGlobal = [&](const ConvTiling &T) {
+    size_t N_FW_ = odim.h * odim.w;
+    size_t M_FW_ = odim.c / group;
+    size_t fw_div_N = T.WPTN * T.wgs0;
+    size_t fw_div_M = T.WPTM * T.wgs1;
+    return std::vector<size_t>{((N_FW_ - 1) / fw_div_N + 1) * T.wgs0,
+                               ((M_FW_ - 1) / fw_div_M + 1) * T.wgs1,
+                               idim.n * group};
+  };
+
+  // \returns the largest workgroup size of \p kernel on the device.
+  auto getKernelMaxWorkgroupSize = [&](cl_kernel kernel) {
+    size_t max_kern_wg_size;
+    clGetKernelWorkGroupInfo(kernel, devBindings->deviceId,
+                             CL_KERNEL_WORK_GROUP_SIZE,
+                             sizeof(max_kern_wg_size), &max_kern_wg_size,
+                             nullptr);
+    return max_kern_wg_size;
+  };
+
+  if (clTuneConvolution) {
+    // The tuned tilings are shared by the functions of the process, for the
+    // convolutions of the same parameters on the same device.
+    std::ostringstream shape;
+    shape << devBindings->deviceId << (isQuantized ? " i8" : " f");
+    for (const auto &opt : options) {
+      shape << ' ' << opt;
+    }
+    std::lock_guard<std::mutex> lock(tunedConvTilingsMutex);
+    auto it = tunedConvTilings.find(shape.str());
+    if (it == tunedConvTilings.end()) {
+      tiling = tuneConvTiling(
+          tiling, [&](const ConvTiling &T) -> double {
+            if (T.wgs0 > WIS[0] || T.wgs1 > WIS[1] ||
+                T.wgs0 * T.wgs1 > dev_max_wg_size) {
+              return -1;
+            }
+            cl_kernel kernel = createConvKernel(T);
+            double time = -1;
+            if (T.wgs0 * T.wgs1 <= getKernelMaxWorkgroupSize(kernel)) {
+              time = timeKernel(devBindings->commandQueue, kernel,
+                                getConvGlobal(T), {T.wgs0, T.wgs1, 1});
+            }
+            clReleaseKernel(kernel);
+            return time;
+          });
+      it = tunedConvTilings.emplace(shape.str(), tiling).first;
+    }
+    tiling = it->second;
   }
 
-  // Compute proper parameters for global work and workgroups.
-  auto fw_wgs0 = wg_size[0];
-  auto fw_wgs1 = wg_size[1];
-  int fw_wptn = WPTN;
-  int fw_wptm = WPTM;
-  int fw_div_N = fw_wptn * fw_wgs0;
-  int fw_div_M = fw_wptm * fw_wgs1;
-  int N_FW_ = odim.h * odim.w;
-  int M_FW_ = odim.c / group;
-  size_t max_kern_wg_size;
-  clGetKernelWorkGroupInfo(kernel, devBindings->deviceId,
-                           CL_KERNEL_WORK_GROUP_SIZE, sizeof(max_kern_wg_size),
-                           &max_kern_wg_size, nullptr);
-  CHECK_LE(fw_wgs0 * fw_wgs1, max_kern_wg_size) << "Bad workgroup size";
+  auto kernel = createConvKernel(tiling);
+  CHECK_LE(tiling.wgs0 * tiling.wgs1, getKernelMaxWorkgroupSize(kernel))
+      << "Bad workgroup size";
 
   // Set the size of a workgroup.
-  std::vector<size_t> local = {fw_wgs0, fw_wgs1, 1};
+  std::vector<size_t> local = {tiling.wgs0, tiling.wgs1, 1};
 
   // Set the global work size.
-  std::vector<size_t> global = {((N_FW_ - 1) / fw_div_N + 1) * fw_wgs0,
-                                ((M_FW_ - 1) / fw_div_M + 1) * fw_wgs1,
-                                idim.n * group};
+  std::vector<size_t> global = getConvGlobal(tiling);
 
   enqueueKernel(CC->getName(), devBindings->commandQueue, kernel,
                 devBindings->deviceId, global, local,
@@ -757,6 +921,11 @@ Error OpenCLFunction::execute(ExecutionContext *context) {
 
   kernelProfiling_ = clDoProfile || getTraceInfo().autoInstrumented;
 
+  // Host buffers of the results of the operators computed on the host, kept
+  // alive until the queue is drained at the end of the run so that their
+  // copies to the device overlap with the following kernels.
+  std::list<Tensor> hostResults;
+
   TRACE_EVENT_SCOPE_NAMED(context, TraceLevel::RUNTIME, "enqueueKernels",
                           enqueueEvent);
   for (const auto &I : F_->getInstrs()) {
@@ -1599,11 +1768,11 @@ Error OpenCLFunction::execute(ExecutionContext *context) {
     }
 
     if (auto *DP = dyn_cast<DebugPrintInst>(&I)) {
-      clFinish(commands);
       auto *V = DP->getSrc();
       // Allocate a temporary tensor to hold the value.
       Tensor T(V->getType());
-      // Load the current value of the variable into host memory.
+      // Load the current value of the variable into host memory, after the
+      // previous commands of the in-order queue.
       copyValueFromDevice(V, clBindings, T.getUnsafePtr());
       clFinish(commands);
       llvm::outs() << I.getName() << ": ";
@@ -1637,14 +1806,16 @@ Error OpenCLFunction::execute(ExecutionContext *context) {
     // For TopKInst, we perform the computation on the host side, as sorting on
     // GPU is complex and we may not get too much benefit from it. We copy the
     // tensor from GPU memory to host memory, perform the computation, and then
-    // copy the results back to GPU memory.
+    // copy the results back to GPU memory. Only the copy of the input is waited
+    // for, the copies of the results are queued before the following kernels.
     if (auto *TK = dyn_cast<TopKInst>(&I)) {
-      clFinish(commands);
       auto *destDev = TK->getValues();
       auto *indDev = TK->getIndices();
       auto *srcDev = TK->getInput();
-      Tensor destT(destDev->getType());
-      Tensor indT(indDev->getType());
+      hostResults.emplace_back(destDev->getType());
+      Tensor &destT = hostResults.back();
+      hostResults.emplace_back(indDev->getType());
+      Tensor &indT = hostResults.back();
       Tensor srcT(srcDev->getType());
       size_t k = TK->getK();
 
@@ -1659,7 +1830,6 @@ Error OpenCLFunction::execute(ExecutionContext *context) {
       }
       copyValueToDevice(destDev, clBindings, destT.getUnsafePtr());
       copyValueToDevice(indDev, clBindings, indT.getUnsafePtr());
-      clFinish(commands);
       continue;
     }
 
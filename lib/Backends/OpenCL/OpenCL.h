@@ -139,7 +139,8 @@ private:
   std::string deviceProgramCacheDir(cl_device_id deviceId);
 
   /// Returns the (hashed) file name of a cached pre-built program for the
-  /// given source and set of build options.
+  /// given source and set of build options, built for \p deviceId by its
+  /// current driver.
   /// \returns the filename (without directory).
   std::string diskCacheProgramFileName(cl_device_id deviceId,
                                        const std::string &source,
@@ -596,8 +596,9 @@ void OpenCLDeviceManager::copyInputsToDevice(
     }
   }
 
-  // Do it!
-  clFinish(devBindings->commandQueue);
+  // The copies are not waited for: the run command queue is in-order, so the
+  // kernels of the run start after them, and the inputs of the context stay
+  // alive until the run is drained.
 }
 
 void OpenCLDeviceManager::copyOutputsFromDevice(
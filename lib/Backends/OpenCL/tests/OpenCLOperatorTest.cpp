@@ -235,6 +235,7 @@ std::set<std::string> glow::backendTestBlacklist = {
     "PyTorchMultipleLayerLSTMFP16/0",
     "DynamicQuantizedFullyConnectedBasic/0",
     "DynamicQuantizedFullyConnectedStrongWeights/0",
+    "DynamicQuantizedFullyConnected_Float/0",
     "DynamicRowwiseQuantizedFullyConnectedBasic/0",
     "AdaptiveAvgPool/0",
     "FP16AdaptiveAvgPool/0",
@@ -493,6 +494,7 @@ std::set<std::string> glow::backendTestBlacklist = {
     "RepeatedSLSWithPartialTensors_int32/0",
     "RepeatedSLSWithPartialTensors_int64/0",
     "RepeatedSLWSWithPartialTensors/0",
+    "FCWithPartialBatch/0",
     "GatherWithInt32PartialTensors/0",
     "GatherWithInt64PartialTensors/0",
     "ChannelwiseQuantizedConv2D_Int8_BiasInt8_FFT/0",
@@ -20,6 +20,8 @@
 
 #include "llvm/Support/CommandLine.h"
 
+#include <array>
+
 #ifndef WITH_PNG
 #error "Using Glow's PNG library requires installing libpng"
 #endif
@@ -505,10 +507,29 @@ std::tuple<dim_t, dim_t, bool> glow::getPpmInfo(const char *filename) {
   return std::make_tuple(height, width, isGray);
 }
 
-bool glow::readPngImage(Tensor *T, const char *filename,
-                        std::pair<float, float> range,
-                        llvm::ArrayRef<float> mean,
-                        llvm::ArrayRef<float> stddev) {
+namespace {
+
+/// The 8-bit pixels of a decoded image, in rows of \p rowBytes bytes holding
+/// \p width pixels of \p pixelStride bytes each, whose first \p numChannels
+/// bytes are the color channels in RGB order.
+struct DecodedImage {
+  std::vector<uint8_t> pixels;
+  size_t rowBytes{0};
+  dim_t height{0};
+  dim_t width{0};
+  dim_t numChannels{0};
+  dim_t pixelStride{0};
+};
+
+/// Lookup tables turning the 8-bit values of each color channel into their
+/// normalized float values.
+using PixelTables = std::array<std::array<float, 256>, 3>;
+
+} // namespace
+
+/// Decodes the PNG image \p filename into \p image. \returns true if an error
+/// occurred.
+static bool decodePngImage(const char *filename, DecodedImage &image) {
   unsigned char header[8];
   // open file and test for it being a png.
   FILE *fp = fopen(filename, "rb");
@@ -574,6 +595,14 @@ bool glow::readPngImage(Tensor *T, const char *filename,
 
   png_read_update_info(png_ptr, info_ptr);
 
+  // Decode all the rows into one buffer.
+  size_t rowBytes = png_get_rowbytes(png_ptr, info_ptr);
+  image.pixels.resize(rowBytes * height);
+  std::vector<png_bytep> row_pointers(height);
+  for (dim_t y = 0; y < height; y++) {
+    row_pointers[y] = image.pixels.data() + y * rowBytes;
+  }
+
   // Error during image read.
   if (setjmp(png_jmpbuf(png_ptr))) {
     png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
@@ -581,47 +610,22 @@ bool glow::readPngImage(Tensor *T, const char *filename,
     return true;
   }
 
-  auto *row_pointers = (png_bytep *)malloc(sizeof(png_bytep) * height);
-  for (dim_t y = 0; y < height; y++) {
-    row_pointers[y] = (png_byte *)malloc(png_get_rowbytes(png_ptr, info_ptr));
-  }
-
-  png_read_image(png_ptr, row_pointers);
+  png_read_image(png_ptr, row_pointers.data());
   png_read_end(png_ptr, info_ptr);
-
-  T->reset(ElemKind::FloatTy, {height, width, numChannels});
-  auto H = T->getHandle<>();
-
-  float scale = ((range.second - range.first) / 255.0);
-  float bias = range.first;
-
-  for (dim_t row_n = 0; row_n < height; row_n++) {
-    png_byte *row = row_pointers[row_n];
-    for (dim_t col_n = 0; col_n < width; col_n++) {
-      png_byte *ptr =
-          &(row[col_n * (hasAlpha ? (numChannels + 1) : numChannels)]);
-      for (dim_t i = 0; i < numChannels; i++) {
-        float val = float(ptr[i]);
-        val = (val - mean[i]) / stddev[i];
-        H.at({row_n, col_n, i}) = val * scale + bias;
-      }
-    }
-  }
-
-  for (dim_t y = 0; y < height; y++) {
-    free(row_pointers[y]);
-  }
-  free(row_pointers);
   png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp)NULL);
   fclose(fp);
 
+  image.rowBytes = rowBytes;
+  image.height = height;
+  image.width = width;
+  image.numChannels = numChannels;
+  image.pixelStride = hasAlpha ? (numChannels + 1) : numChannels;
   return false;
 }
 
-bool glow::readPpmImage(Tensor *T, const char *filename,
-                        std::pair<float, float> range,
-                        llvm::ArrayRef<float> mean,
-                        llvm::ArrayRef<float> stddev) {
+/// Decodes the PPM image \p filename into \p image. \returns true if an error
+/// occurred.
+static bool decodePpmImage(const char *filename, DecodedImage &image) {
   bool isGray;
   dim_t height, width;
   FILE *fp = fopen(filename, "rb");
@@ -632,36 +636,142 @@ bool glow::readPpmImage(Tensor *T, const char *filename,
   // Get PPM info.
   std::tie(height, width, isGray) = getPpmInfo(fp, filename);
   const dim_t numChannels = isGray ? 1 : 3;
-  T->reset(ElemKind::FloatTy, {height, width, numChannels});
 
   // Skip a single byte of space.
   fgetc(fp);
 
-  // Read pixels and do pre-processing.
-  auto H = T->getHandle<>();
+  image.pixels.resize(height * width * numChannels);
+  if (!image.pixels.empty() &&
+      fread(image.pixels.data(), image.pixels.size(), 1, fp) != 1) {
+    fclose(fp);
+    return true;
+  }
+  fclose(fp);
+
+  image.rowBytes = width * numChannels;
+  image.height = height;
+  image.width = width;
+  image.numChannels = numChannels;
+  image.pixelStride = numChannels;
+  return false;
+}
+
+/// Fills \p tables with the values of the \p numChannels channels normalized
+/// to \p range with \p mean and \p stddev, the same values as computing
+/// ((val - mean) / stddev) * scale + bias for every pixel.
+static void initPixelTables(PixelTables &tables, dim_t numChannels,
+                            std::pair<float, float> range,
+                            llvm::ArrayRef<float> mean,
+                            llvm::ArrayRef<float> stddev) {
   float scale = ((range.second - range.first) / 255.0);
   float bias = range.first;
-  unsigned char *buf =
-      (unsigned char *)malloc(width * numChannels * sizeof(unsigned char));
-  for (dim_t h = 0; h < height; h++) {
-    if (fread(buf, width * numChannels, 1, fp) != 1) {
-      free(buf);
-      fclose(fp);
-      return true;
+  for (dim_t c = 0; c < numChannels; c++) {
+    for (unsigned v = 0; v < 256; v++) {
+      float val = float(v);
+      val = (val - mean[c]) / stddev[c];
+      tables[c][v] = val * scale + bias;
     }
-    for (dim_t w = 0; w < width; w++) {
-      for (dim_t c = 0; c < numChannels; c++) {
-        float val = float(buf[w * numChannels + c]);
-        H.at({h, w, c}) = ((val - mean[c]) / stddev[c]) * scale + bias;
+  }
+}
+
+/// Normalizes the pixels of \p image with \p tables and stores them into
+/// \p dst in the channel order \p order and in the layout \p layout (NCHW,
+/// otherwise HWC), all in one pass over the image.
+static void convertImage(const DecodedImage &image, const PixelTables &tables,
+                         ImageChannelOrder order, ImageLayout layout,
+                         float *dst) {
+  const dim_t height = image.height;
+  const dim_t width = image.width;
+  const dim_t numChannels = image.numChannels;
+  const dim_t stride = image.pixelStride;
+  for (dim_t y = 0; y < height; y++) {
+    const uint8_t *row = image.pixels.data() + y * image.rowBytes;
+    for (dim_t c = 0; c < numChannels; c++) {
+      const dim_t outC =
+          order == ImageChannelOrder::BGR ? numChannels - 1 - c : c;
+      const float *table = tables[c].data();
+      const uint8_t *src = row + c;
+      if (layout == ImageLayout::NCHW) {
+        float *out = dst + (outC * height + y) * width;
+        for (dim_t x = 0; x < width; x++) {
+          out[x] = table[src[x * stride]];
+        }
+      } else {
+        float *out = dst + y * width * numChannels + outC;
+        for (dim_t x = 0; x < width; x++) {
+          out[x * numChannels] = table[src[x * stride]];
+        }
       }
     }
   }
+}
 
-  free(buf);
-  fclose(fp);
+/// Decodes the PNG or PPM image \p filename into \p image, and checks it.
+static void decodePngPpmImage(llvm::StringRef filename, DecodedImage &image) {
+  bool isPNG = isPngFormat(filename.data());
+  CHECK(isPNG || isPpmFormat(filename.data())) << "Unrecognized image format";
+  bool loadSuccess = isPNG ? !decodePngImage(filename.data(), image)
+                           : !decodePpmImage(filename.data(), image);
+  CHECK(loadSuccess) << "Error reading input image from file: "
+                     << filename.str();
+}
+
+/// Reads the image \p filename with \p decode into the tensor \p T of shape
+/// HWC, normalized to \p range with \p mean and \p stddev. \returns true if
+/// an error occurred.
+static bool readImage(bool (*decode)(const char *, DecodedImage &), Tensor *T,
+                      const char *filename, std::pair<float, float> range,
+                      llvm::ArrayRef<float> mean,
+                      llvm::ArrayRef<float> stddev) {
+  DecodedImage image;
+  if (decode(filename, image)) {
+    return true;
+  }
+  T->reset(ElemKind::FloatTy, {image.height, image.width, image.numChannels});
+  PixelTables tables;
+  initPixelTables(tables, image.numChannels, range, mean, stddev);
+  convertImage(image, tables, ImageChannelOrder::RGB, ImageLayout::NHWC,
+               reinterpret_cast<float *>(T->getUnsafePtr()));
   return false;
 }
 
+bool glow::readPngImage(Tensor *T, const char *filename,
+                        std::pair<float, float> range,
+                        llvm::ArrayRef<float> mean,
+                        llvm::ArrayRef<float> stddev) {
+  return readImage(decodePngImage, T, filename, range, mean, stddev);
+}
+
+bool glow::readPpmImage(Tensor *T, const char *filename,
+                        std::pair<float, float> range,
+                        llvm::ArrayRef<float> mean,
+                        llvm::ArrayRef<float> stddev) {
+  return readImage(decodePpmImage, T, filename, range, mean, stddev);
+}
+
+/// Preprocesses the decoded \p image into \p dst, see
+/// readPngPpmImageAndPreprocess.
+static void preprocessImage(const DecodedImage &image,
+                            ImageNormalizationMode imageNormMode,
+                            ImageChannelOrder imageChannelOrder,
+                            ImageLayout imageLayout, llvm::ArrayRef<float> mean,
+                            llvm::ArrayRef<float> stddev, float *dst) {
+  // PNG images are RGB, so shuffle mean and stddev values to be in RGB order
+  // as well, prior applying them to input image.
+  std::vector<float> meanRGB(mean);
+  std::vector<float> stddevRGB(stddev);
+  if (imageChannelOrder == ImageChannelOrder::BGR) {
+    std::reverse(meanRGB.begin(), meanRGB.end());
+    std::reverse(stddevRGB.begin(), stddevRGB.end());
+  }
+  auto range = normModeToRange(imageNormMode, ImgDataRange::U8);
+  PixelTables tables;
+  initPixelTables(tables, image.numChannels, range, meanRGB, stddevRGB);
+  // PNG/PPM images are NHWC and RGB, the channels are reordered and
+  // transposed to the requested layout while normalizing them.
+  convertImage(image, tables, imageChannelOrder, imageLayout, dst);
+}
+
 bool glow::writePngImage(Tensor *T, const char *filename,
                          std::pair<float, float> range,
                          llvm::ArrayRef<float> mean,
@@ -775,50 +885,17 @@ void glow::readPngPpmImageAndPreprocess(Tensor &imageData,
                                         ImageLayout imageLayout,
                                         llvm::ArrayRef<float> mean,
                                         llvm::ArrayRef<float> stddev) {
-
-  // PNG images are RGB, so shuffle mean and stddev values to be in RGB order
-  // as well, prior applying them to input image.
-  std::vector<float> meanRGB(mean);
-  std::vector<float> stddevRGB(stddev);
-  if (imageChannelOrder == ImageChannelOrder::BGR) {
-    std::reverse(meanRGB.begin(), meanRGB.end());
-    std::reverse(stddevRGB.begin(), stddevRGB.end());
-  }
-
-  bool isPNG = isPngFormat(filename.data());
-  CHECK(isPNG || isPpmFormat(filename.data())) << "Unrecognized image format";
-  auto range = normModeToRange(imageNormMode, ImgDataRange::U8);
-  bool loadSuccess = isPNG ? !readPngImage(&imageData, filename.data(), range,
-                                           meanRGB, stddevRGB)
-                           : !readPpmImage(&imageData, filename.data(), range,
-                                           meanRGB, stddevRGB);
-  CHECK(loadSuccess) << "Error reading input image from file: "
-                     << filename.str();
-  dim_t imgHeight = imageData.dims()[0];
-  dim_t imgWidth = imageData.dims()[1];
-  dim_t numChannels = imageData.dims()[2];
-
-  // PNG/PPM images are NHWC and RGB.  Convert if needed.
-  // Convert to requested channel ordering.
-  if (imageChannelOrder == ImageChannelOrder::BGR) {
-    Tensor swizzled(imageData.getType());
-    auto IH = imageData.getHandle();
-    auto SH = swizzled.getHandle();
-    for (unsigned z = 0; z < numChannels; z++) {
-      for (unsigned y = 0; y < imgHeight; y++) {
-        for (unsigned x = 0; x < imgWidth; x++) {
-          SH.at({y, x, numChannels - 1 - z}) = IH.at({y, x, z});
-        }
-      }
-    }
-    imageData = std::move(swizzled);
-  }
-  // Convert to requested layout.
+  DecodedImage image;
+  decodePngPpmImage(filename, image);
   if (imageLayout == ImageLayout::NCHW) {
-    Tensor transposed;
-    imageData.transpose(&transposed, {2u, 0u, 1u});
-    imageData = std::move(transposed);
+    imageData.reset(ElemKind::FloatTy,
+                    {image.numChannels, image.height, image.width});
+  } else {
+    imageData.reset(ElemKind::FloatTy,
+                    {image.height, image.width, image.numChannels});
   }
+  preprocessImage(image, imageNormMode, imageChannelOrder, imageLayout, mean,
+                  stddev, reinterpret_cast<float *>(imageData.getUnsafePtr()));
 }
 
 /// Entry point for the PNG/PPM images loader.
@@ -883,17 +960,18 @@ void glow::readPngPpmImagesAndPreprocess(
     LOG(FATAL) << "Unexpected layout\n";
   }
   inputImageData.reset(ElemKind::FloatTy, batchDims);
-  auto IIDH = inputImageData.getHandle<>();
+  auto *batchData = reinterpret_cast<float *>(inputImageData.getUnsafePtr());
+  const size_t sliceSize = numChannels * imgHeight * imgWidth;
 
-  // Read images into local tensors and add to batch.
+  // Preprocess the images directly into their slice of the batch.
+  DecodedImage image;
   for (size_t n = 0; n < filenames.size(); n++) {
-    Tensor localCopy;
-    readPngPpmImageAndPreprocess(localCopy, filenames[n], imageNormMode,
-                                 imageChannelOrder, imageLayout, mean, stddev);
-    DCHECK(std::equal(localCopy.dims().begin(), localCopy.dims().end(),
-                      inputImageData.dims().begin() + 1))
+    decodePngPpmImage(filenames[n], image);
+    CHECK(image.height == imgHeight && image.width == imgWidth &&
+          image.numChannels == numChannels)
         << "All images must have the same dimensions";
-    IIDH.insertSlice(localCopy, n);
+    preprocessImage(image, imageNormMode, imageChannelOrder, imageLayout, mean,
+                    stddev, batchData + n * sliceSize);
   }
 }
 
@@ -18,10 +18,18 @@
 
 #include "glow/Base/Type.h"
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/NativeFormatting.h"
 #include "llvm/Support/raw_ostream.h"
 #include <glog/logging.h>
 
+#include <thread>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define GLOW_TENSOR_F16C
+#endif
+
 using namespace glow;
 
 namespace {
@@ -247,6 +255,43 @@ transposeGenericImpl(const Handle<ElemTy> &src, Handle<ElemTy> &dest,
   }
 }
 
+/// Number of rows and columns of the tiles transposeLastTwoDims copies at once,
+/// sized for a tile of the source and of the destination to stay in L1.
+static constexpr dim_t transposeTileSize = 16;
+
+/// Transposes the last two dimensions of \p src into \p dest, both of which
+/// must be contiguous, keeping the other dimensions in place. Each matrix is
+/// copied tile by tile on the raw buffers, so that the rows of a tile are read
+/// and written as a whole rather than one strided element at a time.
+template <class ElemTy>
+static void transposeLastTwoDims(const Handle<ElemTy> &src,
+                                 Handle<ElemTy> &dest) {
+  const dim_t numDims = src.dims().size();
+  const dim_t rows = src.dims()[numDims - 2];
+  const dim_t cols = src.dims()[numDims - 1];
+  const dim_t matrixSize = rows * cols;
+  if (matrixSize == 0) {
+    return;
+  }
+  const ElemTy *srcData = &src.raw(0);
+  ElemTy *destData = &dest.raw(0);
+  for (dim_t offset = 0, e = src.size(); offset < e; offset += matrixSize) {
+    const ElemTy *srcMatrix = srcData + offset;
+    ElemTy *destMatrix = destData + offset;
+    for (dim_t i0 = 0; i0 < rows; i0 += transposeTileSize) {
+      const dim_t i1 = std::min(i0 + transposeTileSize, rows);
+      for (dim_t j0 = 0; j0 < cols; j0 += transposeTileSize) {
+        const dim_t j1 = std::min(j0 + transposeTileSize, cols);
+        for (dim_t j = j0; j < j1; j++) {
+          for (dim_t i = i0; i < i1; i++) {
+            destMatrix[j * rows + i] = srcMatrix[i * cols + j];
+          }
+        }
+      }
+    }
+  }
+}
+
 /// Faster function for transposing a tensor for important/common tensor
 /// shapes. If a transpose successfully occurs, the function \returns true;
 /// otherwise it \returns false, representing no transpose occurred and some
@@ -257,6 +302,21 @@ static bool tryTransposeFastImpl(const Handle<ElemTy> &src,
                                  Handle<ElemTy> &dest,
                                  llvm::ArrayRef<unsigned_t> shuffle) {
   const dim_t numDims = dest.dims().size();
+
+  // Swap the last two dimensions of contiguous tensors on the raw buffers.
+  if (numDims >= 2 && src.isContiguous() && dest.isContiguous() &&
+      shuffle[numDims - 2] == numDims - 1 &&
+      shuffle[numDims - 1] == numDims - 2) {
+    bool keepsOtherDims = true;
+    for (dim_t i = 0; i + 2 < numDims; i++) {
+      keepsOtherDims &= shuffle[i] == i;
+    }
+    if (keepsOtherDims) {
+      transposeLastTwoDims(src, dest);
+      return true;
+    }
+  }
+
   dim_t srcCoorArr[max_tensor_dimensions];
   dim_t destCoorArr[max_tensor_dimensions] = {0};
   auto srcCoor = llvm::ArrayRef<dim_t>(srcCoorArr, numDims);
@@ -350,6 +410,111 @@ static bool isTiledImpl(const Tensor *tensor, unsigned_t axis, dim_t size,
   return true;
 }
 
+/// Number of bytes of the converted tensors handed to each thread; smaller
+/// tensors are converted on the calling thread.
+static constexpr size_t parallelConversionBytes = 16 << 20;
+
+/// Calls \p fn(begin, end) on ranges of the \p numRows rows of a tensor of
+/// \p numBytes. Payloads of whole models can take long to convert at load
+/// time, so large tensors are split across the hardware threads.
+static void forEachRowRange(dim_t numRows, size_t numBytes,
+                            llvm::function_ref<void(dim_t, dim_t)> fn) {
+  size_t numThreads = std::min<size_t>(
+      {size_t(numRows), numBytes / parallelConversionBytes + 1,
+       std::max(1u, std::thread::hardware_concurrency())});
+  if (numThreads <= 1) {
+    fn(0, numRows);
+    return;
+  }
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < numThreads; t++) {
+    threads.emplace_back(fn, numRows * t / numThreads,
+                         numRows * (t + 1) / numThreads);
+  }
+  fn(0, numRows / numThreads);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+#ifdef GLOW_TENSOR_F16C
+/// Converts the \p n floats of \p src to the halves of \p dst, 8 at a time
+/// with F16C. Rounds to nearest even like float16_t.
+__attribute__((target("avx,f16c"))) static void
+convertToFloat16F16C(const float *src, float16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i *>(dst + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < n; i++) {
+    dst[i] = float16_t(src[i]);
+  }
+}
+
+/// Converts the \p n halves of \p src to the floats of \p dst, 8 at a time
+/// with F16C.
+__attribute__((target("avx,f16c"))) static void
+convertFromFloat16F16C(const float16_t *src, float *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(dst + i,
+                     _mm256_cvtph_ps(_mm_loadu_si128(
+                         reinterpret_cast<const __m128i *>(src + i))));
+  }
+  for (; i < n; i++) {
+    dst[i] = float(src[i]);
+  }
+}
+
+/// \returns whether the host supports the F16C conversions.
+static bool hasF16C() {
+  static const bool hasIt =
+      __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+  return hasIt;
+}
+#endif
+
+/// Converts the \p n elements of \p src to the elements of \p dst, where
+/// one of the element types is float16_t and the other float.
+template <class DstTy, class SrcTy>
+static void convertFloat16Range(const SrcTy *src, DstTy *dst, size_t n) {
+#ifdef GLOW_TENSOR_F16C
+  if (hasF16C()) {
+    if (std::is_same<DstTy, float16_t>::value) {
+      convertToFloat16F16C(reinterpret_cast<const float *>(src),
+                           reinterpret_cast<float16_t *>(dst), n);
+    } else {
+      convertFromFloat16F16C(reinterpret_cast<const float16_t *>(src),
+                             reinterpret_cast<float *>(dst), n);
+    }
+    return;
+  }
+#endif
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = DstTy(src[i]);
+  }
+}
+
+/// Converts \p src to \p dst, one of the element types being float16_t and
+/// the other float.
+template <class DstTy, class SrcTy>
+static void convertFloat16(const Tensor &src, Tensor &dst) {
+  auto srcH = src.getHandle<SrcTy>();
+  auto dstH = dst.getHandle<DstTy>();
+  size_t numElements = src.getRealNumElements();
+  if (!srcH.isContiguous() || !dstH.isContiguous() || numElements == 0) {
+    dstH.copyConvertedFrom(srcH);
+    return;
+  }
+  const SrcTy *srcData = &srcH.raw(0);
+  DstTy *dstData = &dstH.raw(0);
+  forEachRowRange(numElements, dst.getSizeInBytes(), [&](dim_t b, dim_t e) {
+    convertFloat16Range(srcData + b, dstData + b, e - b);
+  });
+}
+
 /// \returns a tensor with UInt8FusedQTy from \p T, whose type should be
 /// UInt4FusedFP16QTy, UInt4FusedQTy, or UInt8FusedFP16QTy.
 template <class scaleOffsetTy = float16_t>
@@ -370,25 +535,31 @@ static Tensor convertToUInt8FusedQTy(const Tensor *T) {
   Tensor tmp(ElemKind::UInt8FusedQTy, {numTotalRows, numTotalColumns}, 1.0, 0);
   auto srcH = T->getHandle<uint8_t>();
   auto dstH = tmp.getHandle<uint8_t>();
-  for (dim_t row = 0; row < T->dims()[0]; row++) {
-    // Copy scale and offset from src to dst.
-    scaleOffsetTy scale, offset;
-    std::tie(scale, offset) =
-        srcH.getFusedScaleOffsetFromRow<scaleOffsetTy>(row);
-    dstH.setFusedScaleOffsetInRow<float>(row, static_cast<float>(scale),
-                                         static_cast<float>(offset));
-    for (dim_t column = 0; column < dataCol; column++) {
-      if (is4Bit) {
-        auto src = srcH.at({row, column});
+  const uint8_t *srcData = &srcH.raw(0);
+  uint8_t *dstData = &dstH.raw(0);
+  const dim_t srcWidth = T->dims()[1];
+  forEachRowRange(numTotalRows, tmp.getSizeInBytes(), [&](dim_t b, dim_t e) {
+    for (dim_t row = b; row < e; row++) {
+      // Copy scale and offset from src to dst.
+      scaleOffsetTy scale, offset;
+      std::tie(scale, offset) =
+          srcH.getFusedScaleOffsetFromRow<scaleOffsetTy>(row);
+      dstH.setFusedScaleOffsetInRow<float>(row, static_cast<float>(scale),
+                                           static_cast<float>(offset));
+      const uint8_t *srcRow = srcData + row * srcWidth;
+      uint8_t *dstRow = dstData + row * numTotalColumns;
+      if (!is4Bit) {
+        memcpy(dstRow, srcRow, dataCol);
+        continue;
+      }
+      for (dim_t column = 0; column < dataCol; column++) {
         // Even column in new data uses value from LSB 4-bit from src data.
-        dstH.at({row, column * 2}) = src & 0x0F;
+        dstRow[column * 2] = srcRow[column] & 0x0F;
         // Odd column in new data uses value from MSB 4-bit from dst data.
-        dstH.at({row, column * 2 + 1}) = (src >> 4) & 0x0F;
-      } else {
-        dstH.at({row, column}) = srcH.at({row, column});
+        dstRow[column * 2 + 1] = (srcRow[column] >> 4) & 0x0F;
       }
     }
-  }
+  });
   return tmp;
 }
 
@@ -405,16 +576,20 @@ static Tensor convertToUInt4FusedQTy(const Tensor *T) {
   Tensor tmp(ElemKind::UInt4FusedQTy, {numTotalRows, numTotalColumns}, 1.0, 0);
   auto srcH = T->getHandle<uint8_t>();
   auto dstH = tmp.getHandle<uint8_t>();
-  for (dim_t row = 0; row < T->dims()[0]; row++) {
-    // Copy scale and offset from src to dst.
-    float16_t scale, offset;
-    std::tie(scale, offset) = srcH.getFusedScaleOffsetFromRow<float16_t>(row);
-    dstH.setFusedScaleOffsetInRow<float>(row, static_cast<float>(scale),
-                                         static_cast<float>(offset));
-    for (dim_t column = 0; column < dataCol; column++) {
-      dstH.at({row, column}) = srcH.at({row, column});
+  const uint8_t *srcData = &srcH.raw(0);
+  uint8_t *dstData = &dstH.raw(0);
+  const dim_t srcWidth = T->dims()[1];
+  forEachRowRange(numTotalRows, tmp.getSizeInBytes(), [&](dim_t b, dim_t e) {
+    for (dim_t row = b; row < e; row++) {
+      // Copy scale and offset from src to dst.
+      float16_t scale, offset;
+      std::tie(scale, offset) = srcH.getFusedScaleOffsetFromRow<float16_t>(row);
+      dstH.setFusedScaleOffsetInRow<float>(row, static_cast<float>(scale),
+                                           static_cast<float>(offset));
+      memcpy(dstData + row * numTotalColumns, srcData + row * srcWidth,
+             dataCol);
     }
-  }
+  });
   return tmp;
 }
 } // namespace
@@ -855,42 +1030,48 @@ Tensor Tensor::getCopyConvertedToType(ElemKind newKind) const {
 
   if (!isQuantizedElemKind(newKind)) {
     Tensor tmp(newKind, dims());
+    if (origKind == newKind) {
+      tmp.copyRawFrom(this);
+      return tmp;
+    }
+    // Converts this from SRC to the DEST elements of tmp.
+#define CONVERT(DEST, SRC)                                                     \
+  tmp.getHandle<DEST>().copyConvertedFrom(getHandle<SRC>())
     switch (newKind) {
     case ElemKind::Float16Ty:
-      tmp.copyWithCast<float16_t, float>(this);
+      convertFloat16<float16_t, float>(*this, tmp);
       break;
     case ElemKind::BFloat16Ty:
-      tmp.copyWithCast<bfloat16_t, float>(this);
+      CONVERT(bfloat16_t, float);
       break;
-
     case ElemKind::FloatTy:
-      if (getElementType() == ElemKind::Int32ITy) {
-        tmp.copyWithCast<float, int32_t>(this);
-      } else if (getElementType() == ElemKind::Int64ITy) {
-        tmp.copyWithCast<float, int64_t>(this);
-      } else if (getElementType() == ElemKind::Float16Ty) {
-        tmp.copyWithCast<float, float16_t>(this);
-      } else if (getElementType() == ElemKind::BFloat16Ty) {
-        tmp.copyWithCast<float, bfloat16_t>(this);
-      } else if (getElementType() == ElemKind::FloatTy) {
-        tmp.copyRawFrom(this);
+      if (origKind == ElemKind::Int32ITy) {
+        CONVERT(float, int32_t);
+      } else if (origKind == ElemKind::Int64ITy) {
+        CONVERT(float, int64_t);
+      } else if (origKind == ElemKind::Float16Ty) {
+        convertFloat16<float, float16_t>(*this, tmp);
+      } else if (origKind == ElemKind::BFloat16Ty) {
+        CONVERT(float, bfloat16_t);
       } else {
         llvm_unreachable("Invalid conversion to FLOAT.");
       }
       break;
 
     case ElemKind::Int32ITy:
-      if (getElementType() == ElemKind::Int64ITy) {
-        tmp.copyWithCast<int32_t, int64_t>(this);
-      } else if (getElementType() == ElemKind::FloatTy) {
-        tmp.copyWithCast<int32_t, float>(this);
+      if (origKind == ElemKind::Int64ITy) {
+        CONVERT(int32_t, int64_t);
+      } else if (origKind == ElemKind::FloatTy) {
+        CONVERT(int32_t, float);
       } else {
         llvm_unreachable("Invalid conversion from FLOAT.");
       }
       break;
     case ElemKind::Int64ITy:
-      if (getElementType() == ElemKind::Int32ITy) {
-        tmp.copyWithCast<int64_t, int32_t>(this);
+      if (origKind == ElemKind::Int32ITy) {
+        CONVERT(int64_t, int32_t);
+      } else if (origKind == ElemKind::FloatTy) {
+        CONVERT(int64_t, float);
       } else {
         llvm_unreachable("Invalid conversion from FLOAT.");
       }
@@ -899,6 +1080,7 @@ Tensor Tensor::getCopyConvertedToType(ElemKind newKind) const {
     default:
       llvm_unreachable("Type not supported");
     }
+#undef CONVERT
     return tmp;
   }
 
@@ -925,22 +1107,26 @@ Tensor Tensor::getCopyConvertedToType(ElemKind newKind) const {
                                           (dim_t)sizeof(float16_t))},
              1.0, 0);
 
+  const size_t srcWidth = dims()[1];
   const size_t dstWidth = tmp.dims()[1];
   auto srcH = getHandle<uint8_t>();
   auto dstH = tmp.getHandle<uint8_t>();
-  for (dim_t i = 0, e = dims()[0]; i < e; i++) {
-    // Copy the scale/offset from src to dst.
-    float scale, offset;
-    std::tie(scale, offset) = srcH.getFusedScaleOffsetFromRow<float>(i);
-    dstH.setFusedScaleOffsetInRow<float16_t>(i, static_cast<float16_t>(scale),
-                                             static_cast<float16_t>(offset));
-
-    // Copy over the row's uint8 data from src to dst; scales and offsets were
-    // already copied over above.
-    for (dim_t j = 0, f = dstWidth - 2 * sizeof(float16_t); j < f; j++) {
-      dstH.at({i, j}) = srcH.at({i, j});
+  const uint8_t *srcData = &srcH.raw(0);
+  uint8_t *dstData = &dstH.raw(0);
+  forEachRowRange(dims()[0], tmp.getSizeInBytes(), [&](dim_t b, dim_t e) {
+    for (dim_t i = b; i < e; i++) {
+      // Copy the scale/offset from src to dst.
+      float scale, offset;
+      std::tie(scale, offset) = srcH.getFusedScaleOffsetFromRow<float>(i);
+      dstH.setFusedScaleOffsetInRow<float16_t>(
+          i, static_cast<float16_t>(scale), static_cast<float16_t>(offset));
+
+      // Copy over the row's uint8 data from src to dst; scales and offsets
+      // were already copied over above.
+      memcpy(dstData + i * dstWidth, srcData + i * srcWidth,
+             dstWidth - 2 * sizeof(float16_t));
     }
-  }
+  });
   return tmp;
 }
 
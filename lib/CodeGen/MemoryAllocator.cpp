@@ -22,6 +22,10 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <numeric>
+#include <random>
+
 #define DEBUG_TYPE "memory-allocator"
 
 using namespace glow;
@@ -42,6 +46,26 @@ static_assert(std::is_unsigned<decltype(MemoryAllocator::npos)>{},
 
 const uint64_t MemoryAllocator::npos = -1;
 
+/// Names of the memory planners, in the order of MemoryPlanner.
+static const char *memoryPlannerNames[] = {"livesize", "greedy-by-size",
+                                           "best-fit", "search"};
+
+const char *glow::getMemoryPlannerName(MemoryPlanner planner) {
+  return memoryPlannerNames[static_cast<size_t>(planner)];
+}
+
+bool glow::getMemoryPlannerFromName(const std::string &name,
+                                    MemoryPlanner &planner) {
+  for (size_t idx = 0; idx <= static_cast<size_t>(MemoryPlanner::Search);
+       idx++) {
+    if (name == memoryPlannerNames[idx]) {
+      planner = static_cast<MemoryPlanner>(idx);
+      return true;
+    }
+  }
+  return false;
+}
+
 float MemoryAllocator::getAllocationEfficiency() const {
   if (maxUsedSize_ != 0) {
     return static_cast<float>(maxLiveSize_) / static_cast<float>(maxUsedSize_);
@@ -448,6 +472,110 @@ static uint64_t SameOrder(size_t buffIdx,
 static std::vector<MemAllocStrategy> memAllocStrategies = {
     MaxLiveSizeMaxBuffSize, MaxLiveSizeMaxBuffTime, SameOrder};
 
+/// Utility function to find the address of the segment \p currSegId in the
+/// buffers described by \p buffInfoArray, given the segments \p idSegMap which
+/// are already allocated. With \p bestFit the segment goes into the smallest
+/// gap between the segments alive at the same time which fits it, otherwise it
+/// goes into the lowest one. \returns the start address of the segment.
+static uint64_t
+findSegmentAddress(size_t currSegId, const std::vector<BuffInfo> &buffInfoArray,
+                   const std::unordered_map<size_t, Segment> &idSegMap,
+                   bool bestFit) {
+  // ---------------------------------------------------------------------------
+  // Find previously allocated segments which overlap with the current segment
+  // in time, that is segments which are alive at the same time with the
+  // current segment. We keep only those segments and store them in buffers.
+  // We also sort the found segments in increasing order of the stop address.
+  // Note: The number of previous segments is usually small.
+  // ---------------------------------------------------------------------------
+  typedef std::pair<uint64_t, uint64_t> AddressPair;
+
+  // We initialize the "previous segments" buffers with a virtual segment of
+  // size 0 since this will simplify the logic used in the following section.
+  std::vector<AddressPair> prevSegAddr = {AddressPair(0, 0)};
+  for (const auto &idSeg : idSegMap) {
+
+    // Previously allocated segment.
+    auto prevSegId = idSeg.first;
+    auto prevSeg = idSeg.second;
+
+    // Verify if the previous segment overlaps with current segment in time.
+    bool overlap = intervalsOverlap(buffInfoArray[currSegId].timeStart,
+                                    buffInfoArray[currSegId].timeStop,
+                                    buffInfoArray[prevSegId].timeStart,
+                                    buffInfoArray[prevSegId].timeStop);
+
+    // If segment overlaps with previous then store the previous segment.
+    if (overlap) {
+      prevSegAddr.emplace_back(prevSeg.begin, prevSeg.end);
+    }
+  }
+
+  // Order segments in the increasing order of the stop address.
+  std::sort(prevSegAddr.begin(), prevSegAddr.end(),
+            [](const AddressPair &a, const AddressPair &b) {
+              return a.second < b.second;
+            });
+
+  // ---------------------------------------------------------------------------
+  // Find a position for the current segment by trying to allocate at the
+  // end of all the previously allocated segments which were previously
+  // found. Since the previous segments are ordered by their stop address
+  // in ascending order this procedure is guaranteed to find a place at
+  // least at the end of the last segment.
+  // ---------------------------------------------------------------------------
+  const uint64_t currSegSize = buffInfoArray[currSegId].size;
+  uint64_t bestSegAddrStart = MemoryAllocator::npos;
+  uint64_t bestGapSize = MemoryAllocator::npos;
+  for (size_t prevSegIdx = 0; prevSegIdx < prevSegAddr.size(); prevSegIdx++) {
+
+    // Try to place current segment after this previously allocated segment.
+    uint64_t currSegAddrStart = prevSegAddr[prevSegIdx].second;
+    uint64_t currSegAddrStop = currSegAddrStart + currSegSize;
+
+    // Verify if this placement overlaps with all the other segments.
+    // Note that this verification with all the previous segments is required
+    // because the previous segments can overlap between themselves. For the
+    // best fit we also find the size of the gap starting at this placement,
+    // up to the next segment.
+    bool overlap = false;
+    uint64_t gapStop = MemoryAllocator::npos;
+    for (size_t ovrSegIdx = 0; ovrSegIdx < prevSegAddr.size(); ovrSegIdx++) {
+      const auto &ovrSeg = prevSegAddr[ovrSegIdx];
+      // Check overlap.
+      overlap = overlap || intervalsOverlap(currSegAddrStart, currSegAddrStop,
+                                            ovrSeg.first, ovrSeg.second);
+      // Early break if overlaps.
+      if (overlap) {
+        break;
+      }
+      if (ovrSeg.first >= currSegAddrStart && ovrSeg.second > ovrSeg.first) {
+        gapStop = std::min(gapStop, ovrSeg.first);
+      }
+    }
+
+    // If no overlap than we found the solution for the placement, unless we
+    // look for the smallest gap. The gap at the end of the last segment is
+    // unbounded so it is only picked when no other gap fits.
+    if (!overlap) {
+      if (!bestFit) {
+        return currSegAddrStart;
+      }
+      uint64_t gapSize = gapStop == MemoryAllocator::npos
+                             ? MemoryAllocator::npos
+                             : gapStop - currSegAddrStart;
+      if (bestSegAddrStart == MemoryAllocator::npos || gapSize < bestGapSize ||
+          (gapSize == bestGapSize && currSegAddrStart < bestSegAddrStart)) {
+        bestSegAddrStart = currSegAddrStart;
+        bestGapSize = gapSize;
+      }
+    }
+  }
+  assert(bestSegAddrStart != MemoryAllocator::npos &&
+         "No placement found for the segment!");
+  return bestSegAddrStart;
+}
+
 /// Utility function to allocate all the segments at once using the given
 /// \p strategy and the memory size \p memorySize. The buffer information
 /// is incapsulated in the array \p buffInfoArray and the buffer liveness
@@ -477,77 +605,10 @@ static uint64_t allocateAllWithStrategy(
     assert(idSegMap.find(currSegId) == idSegMap.end() &&
            "Segment previously allocated!");
 
-    // -------------------------------------------------------------------------
-    // Find previously allocated segments which overlap with the current segment
-    // in time, that is segments which are alive at the same time with the
-    // current segment. We keep only those segments and store them in buffers.
-    // We also sort the found segments in increasing order of the stop address.
-    // Note: The number of previous segments is usually small.
-    // -------------------------------------------------------------------------
-    typedef std::pair<uint64_t, uint64_t> AddressPair;
-
-    // We initialize the "previous segments" buffers with a virtual segment of
-    // size 0 since this will simplify the logic used in the following section.
-    std::vector<AddressPair> prevSegAddr = {AddressPair(0, 0)};
-    for (const auto &idSeg : idSegMap) {
-
-      // Previously allocated segment.
-      auto prevSegId = idSeg.first;
-      auto prevSeg = idSeg.second;
-
-      // Verify if the previous segment overlaps with current segment in time.
-      bool overlap = intervalsOverlap(buffInfoArray[currSegId].timeStart,
-                                      buffInfoArray[currSegId].timeStop,
-                                      buffInfoArray[prevSegId].timeStart,
-                                      buffInfoArray[prevSegId].timeStop);
-
-      // If segment overlaps with previous then store the previous segment.
-      if (overlap) {
-        prevSegAddr.emplace_back(prevSeg.begin, prevSeg.end);
-      }
-    }
-
-    // Order segments in the increasing order of the stop address.
-    std::sort(prevSegAddr.begin(), prevSegAddr.end(),
-              [](const AddressPair &a, const AddressPair &b) {
-                return a.second < b.second;
-              });
-
-    // -------------------------------------------------------------------------
-    // Find a position for the current segment by trying to allocate at the
-    // end of all the previously allocated segments which were previously
-    // found. Since the previous segments are ordered by their stop address
-    // in ascending order this procedure is guaranteed to find a place at
-    // least at the end of the last segment.
-    // -------------------------------------------------------------------------
-    uint64_t currSegAddrStart = 0;
-    uint64_t currSegAddrStop = 0;
-    for (size_t prevSegIdx = 0; prevSegIdx < prevSegAddr.size(); prevSegIdx++) {
-
-      // Try to place current segment after this previously allocated segment.
-      currSegAddrStart = prevSegAddr[prevSegIdx].second;
-      currSegAddrStop = currSegAddrStart + buffInfoArray[currSegId].size;
-
-      // Verify if this placement overlaps with all the other segments.
-      // Note that this verification with all the previous segments is required
-      // because the previous segments can overlap between themselves.
-      bool overlap = false;
-      for (size_t ovrSegIdx = 0; ovrSegIdx < prevSegAddr.size(); ovrSegIdx++) {
-        // Check overlap.
-        overlap = overlap || intervalsOverlap(currSegAddrStart, currSegAddrStop,
-                                              prevSegAddr[ovrSegIdx].first,
-                                              prevSegAddr[ovrSegIdx].second);
-        // Early break if overlaps.
-        if (overlap) {
-          break;
-        }
-      }
-
-      // If no overlap than we found the solution for the placement.
-      if (!overlap) {
-        break;
-      }
-    }
+    // Find a position for the current segment.
+    uint64_t currSegAddrStart = findSegmentAddress(
+        currSegId, buffInfoArray, idSegMap, /* bestFit */ false);
+    uint64_t currSegAddrStop = currSegAddrStart + buffInfoArray[currSegId].size;
 
     // Update maximum used size.
     usedSizeMax = std::max(usedSizeMax, currSegAddrStop);
@@ -586,6 +647,102 @@ static uint64_t allocateAllWithStrategy(
   return usedSizeMax;
 }
 
+/// Utility function to allocate all the segments at once in the order \p order
+/// of their IDs, using the memory size \p memorySize. The buffers are
+/// described by \p buffInfoArray and \p bestFit selects how the segments are
+/// placed, see findSegmentAddress. At the end of the allocation the segments
+/// are written in \p idSegMap. \returns the memory used by the segments or
+/// MemoryAllocator::npos if it exceeds \p memorySize.
+static uint64_t
+allocateAllInOrder(uint64_t memorySize,
+                   const std::vector<BuffInfo> &buffInfoArray,
+                   const std::vector<size_t> &order, bool bestFit,
+                   std::unordered_map<size_t, Segment> &idSegMap) {
+  uint64_t usedSizeMax = 0;
+  for (size_t currSegId : order) {
+    uint64_t currSegAddrStart =
+        findSegmentAddress(currSegId, buffInfoArray, idSegMap, bestFit);
+    uint64_t currSegAddrStop = currSegAddrStart + buffInfoArray[currSegId].size;
+    usedSizeMax = std::max(usedSizeMax, currSegAddrStop);
+    if (usedSizeMax > memorySize) {
+      return MemoryAllocator::npos;
+    }
+    idSegMap.insert(
+        std::make_pair(currSegId, Segment(currSegAddrStart, currSegAddrStop)));
+  }
+  return usedSizeMax;
+}
+
+/// \returns the IDs of the buffers \p buffInfoArray by decreasing size, then
+/// by decreasing live interval.
+static std::vector<size_t>
+getDecreasingSizeOrder(const std::vector<BuffInfo> &buffInfoArray) {
+  std::vector<size_t> order(buffInfoArray.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const auto &buffA = buffInfoArray[a];
+    const auto &buffB = buffInfoArray[b];
+    if (buffA.size != buffB.size) {
+      return buffA.size > buffB.size;
+    }
+    return buffA.timeStop - buffA.timeStart > buffB.timeStop - buffB.timeStart;
+  });
+  return order;
+}
+
+/// Utility function to search for an allocation using less memory than
+/// \p usedSizeMax, which is used by the segments \p idSegMap. Starting from
+/// the allocation \p order, the search moves one segment at a time in the order
+/// and keeps the new order when the first fit allocation does not use more
+/// memory. The search costs about N * N per order for N buffers, and stops when
+/// \p budget is spent or when the memory used is \p liveSizeMax, which is the
+/// best possible. The buffers are described by \p buffInfoArray and must fit
+/// in \p memorySize. \returns the memory used by the best allocation found,
+/// whose segments are in \p idSegMap.
+static uint64_t searchAllocation(uint64_t memorySize,
+                                 const std::vector<BuffInfo> &buffInfoArray,
+                                 uint64_t liveSizeMax, uint64_t budget,
+                                 std::vector<size_t> order,
+                                 std::unordered_map<size_t, Segment> &idSegMap,
+                                 uint64_t usedSizeMax) {
+  const uint64_t buffNum = buffInfoArray.size();
+  if (buffNum < 2) {
+    return usedSizeMax;
+  }
+  // Fixed seed, so that the allocation is the same for every compilation.
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dist(0, buffNum - 1);
+  uint64_t currSize = usedSizeMax;
+  const uint64_t numOrders = budget / (buffNum * buffNum);
+  for (uint64_t iter = 0; iter < numOrders && usedSizeMax > liveSizeMax;
+       iter++) {
+    size_t from = dist(gen);
+    size_t to = dist(gen);
+    if (from == to) {
+      continue;
+    }
+    std::vector<size_t> newOrder = order;
+    size_t id = newOrder[from];
+    newOrder.erase(newOrder.begin() + from);
+    newOrder.insert(newOrder.begin() + to, id);
+
+    std::unordered_map<size_t, Segment> idSegMapTemp;
+    uint64_t usedSize = allocateAllInOrder(
+        memorySize, buffInfoArray, newOrder, /* bestFit */ false, idSegMapTemp);
+    if (usedSize == MemoryAllocator::npos || usedSize > currSize) {
+      continue;
+    }
+    // Equal sizes are accepted to move across plateaus.
+    order = std::move(newOrder);
+    currSize = usedSize;
+    if (usedSize < usedSizeMax) {
+      usedSizeMax = usedSize;
+      idSegMap = std::move(idSegMapTemp);
+    }
+  }
+  return usedSizeMax;
+}
+
 void MemoryAllocator::mapHandlesToIds(
     const std::list<Allocation> &allocList,
     std::unordered_map<Handle, size_t> &handleToIdMap,
@@ -722,35 +879,72 @@ uint64_t MemoryAllocator::allocateAll(const std::list<Allocation> &allocList,
   uint64_t usedSizeMax = std::numeric_limits<uint64_t>::max();
 
   // Iterate all the available strategies and pick the optimal one.
-  size_t strategyNum = memAllocStrategies.size();
-  for (size_t strategyIdx = 0; strategyIdx < strategyNum; strategyIdx++) {
+  if (planner_ == MemoryPlanner::LiveSize ||
+      planner_ == MemoryPlanner::Search) {
+    size_t strategyNum = memAllocStrategies.size();
+    for (size_t strategyIdx = 0; strategyIdx < strategyNum; strategyIdx++) {
+
+      // Allocate segments using current strategy.
+      std::unordered_map<size_t, Segment> idSegMapTemp;
+      auto strategy = memAllocStrategies[strategyIdx];
+      uint64_t usedSize =
+          allocateAllWithStrategy(effectiveMemorySize, buffInfoArray,
+                                  liveInfoArray, idSegMapTemp, strategy);
+
+      // If available memory is exceeded then we return early, unless other
+      // planners are going to be tried.
+      if (usedSize == MemoryAllocator::npos) {
+        if (planner_ == MemoryPlanner::LiveSize) {
+          return MemoryAllocator::npos;
+        }
+        continue;
+      }
 
-    // Allocate segments using current strategy.
-    std::unordered_map<size_t, Segment> idSegMapTemp;
-    auto strategy = memAllocStrategies[strategyIdx];
-    uint64_t usedSize =
-        allocateAllWithStrategy(effectiveMemorySize, buffInfoArray,
-                                liveInfoArray, idSegMapTemp, strategy);
+      // If maximum efficiency is reached we update and break early.
+      if (usedSize == liveSizeMax) {
+        usedSizeMax = usedSize;
+        idSegMap = idSegMapTemp;
+        break;
+      }
 
-    // If available memory is exceeded then we return early.
-    if (usedSize == MemoryAllocator::npos) {
-      return MemoryAllocator::npos;
+      // If new optimal is obtained we update.
+      if (usedSize < usedSizeMax) {
+        usedSizeMax = usedSize;
+        idSegMap = idSegMapTemp;
+      }
     }
+  }
 
-    // If maximum efficiency is reached we update and break early.
-    if (usedSize == liveSizeMax) {
-      usedSizeMax = usedSize;
-      idSegMap = idSegMapTemp;
-      break;
+  // Allocate the segments by decreasing size, with the first fit and the best
+  // fit placements.
+  const auto sizeOrder = getDecreasingSizeOrder(buffInfoArray);
+  for (bool bestFit : {false, true}) {
+    if ((planner_ == MemoryPlanner::GreedyBySize && bestFit) ||
+        (planner_ == MemoryPlanner::BestFit && !bestFit) ||
+        planner_ == MemoryPlanner::LiveSize || usedSizeMax == liveSizeMax) {
+      continue;
     }
-
-    // If new optimal is obtained we update.
+    std::unordered_map<size_t, Segment> idSegMapTemp;
+    uint64_t usedSize = allocateAllInOrder(effectiveMemorySize, buffInfoArray,
+                                           sizeOrder, bestFit, idSegMapTemp);
     if (usedSize < usedSizeMax) {
       usedSizeMax = usedSize;
-      idSegMap = idSegMapTemp;
+      idSegMap = std::move(idSegMapTemp);
     }
   }
 
+  if (planner_ == MemoryPlanner::Search &&
+      usedSizeMax != MemoryAllocator::npos) {
+    usedSizeMax =
+        searchAllocation(effectiveMemorySize, buffInfoArray, liveSizeMax,
+                         searchBudget_, sizeOrder, idSegMap, usedSizeMax);
+  }
+
+  // If available memory is exceeded by all the planners then we return.
+  if (usedSizeMax == MemoryAllocator::npos) {
+    return MemoryAllocator::npos;
+  }
+
   // Update the segments, handles and the max used/live memory.
   assert(idSegMap.size() == (allocList.size() / 2) && "Segments are invalid!");
   for (const auto &idSeg : idSegMap) {
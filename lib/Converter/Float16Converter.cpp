@@ -68,16 +68,21 @@ convertFusedRowwiseQuantizedInputs(Function *F,
 }
 
 void glow::convertFunctionToFloat16(Function *F,
-                                    const PrecisionConfiguration &precConfig) {
-  DCHECK(precConfig.convertToFP16 || precConfig.convertFusedToFP16)
+                                    const PrecisionConfiguration &precConfig,
+                                    const Backend *B) {
+  const bool convertNodes =
+      precConfig.convertToFP16 ||
+      precConfig.quantConfig.hasNodePrecision(
+          quantization::NodePrecision::FP16);
+  DCHECK(convertNodes || precConfig.convertFusedToFP16)
       << "Expected to convert at least one of FloatTy or UInt8FusedQTy.";
 
   // Convert FloatTy to Float16Ty or BFloat16Ty.
   ElemKind destTy =
       PrecisionConfiguration::getElementType(precConfig.float16Format);
   TypeAToTypeBFunctionConverter converter(*F, ElemKind::FloatTy, destTy,
-                                          precConfig);
-  if (precConfig.convertToFP16) {
+                                          precConfig, B);
+  if (convertNodes) {
     converter.convert();
 
     // Storage nodes are not converted + clipped directly -- they need to be
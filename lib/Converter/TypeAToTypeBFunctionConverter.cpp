@@ -16,6 +16,7 @@
 
 #include "glow/Converter/TypeAToTypeBFunctionConverter.h"
 
+#include "glow/Backend/Backend.h"
 #include "glow/Base/Tensor.h"
 #include "glow/Graph/Graph.h"
 
@@ -23,9 +24,9 @@ using namespace glow;
 
 TypeAToTypeBFunctionConverter::TypeAToTypeBFunctionConverter(
     Function &F, ElemKind fromKind, ElemKind toKind,
-    const PrecisionConfiguration &precConfig)
+    const PrecisionConfiguration &precConfig, const Backend *B)
     : FunctionConverter(F), mod_(*F.getParent()), dstKind_(toKind),
-      srcKind_(fromKind), precConfig_(precConfig) {}
+      srcKind_(fromKind), precConfig_(precConfig), B_(B) {}
 
 bool TypeAToTypeBFunctionConverter::canConvert(const Node &node) const {
   // For some ops, if we're converting to FP16/BFloat16 and the bias is FP32 and
@@ -67,12 +68,46 @@ bool TypeAToTypeBFunctionConverter::canConvert(const Node &node) const {
 #undef QUANT_INPUT_FLOAT_BIAS_CASE
   }
 
+  // Nodes with a precision are converted to float16 only if it is FP16, and
+  // regardless of the node kind. The others are only converted if the
+  // Function is.
+  const quantization::NodePrecision *nodePrecision = nullptr;
+  if (srcKind_ == ElemKind::FloatTy &&
+      (dstKind_ == ElemKind::Float16Ty || dstKind_ == ElemKind::BFloat16Ty)) {
+    nodePrecision =
+        precConfig_.quantConfig.getNodePrecision(node.getName());
+    if (nodePrecision ? *nodePrecision != quantization::NodePrecision::FP16
+                      : !precConfig_.convertToFP16) {
+      return false;
+    }
+  }
+
   const bool inSet = precConfig_.precisionModeKindSet.count(node.getKind());
   const bool allowConversion = precConfig_.useSetAsWhitelist ? inSet : !inSet;
 
-  if (!allowConversion) {
+  if (!nodePrecision && !allowConversion) {
     return false;
   }
+
+  // Only convert the node if the backend supports the newly converted node.
+  if (B_) {
+    std::vector<TypeRef> inputTypes;
+    std::vector<TypeRef> outputTypes;
+    for (unsigned idx = 0, end = node.getNumInputs(); idx != end; ++idx) {
+      TypeRef targetTy = getTargetTypeForInput(node, idx);
+      inputTypes.push_back(targetTy ? targetTy
+                                    : node.getNthInput(idx).getType());
+    }
+    for (unsigned idx = 0, end = node.getNumResults(); idx != end; ++idx) {
+      NodeValue val = node.getNthResult(idx);
+      TypeRef targetTy = getTargetTypeForOutput(val);
+      outputTypes.push_back(targetTy ? targetTy : val.getType());
+    }
+    if (!B_->isOpSupported(
+            NodeInfo(node.getKind(), inputTypes, outputTypes))) {
+      return false;
+    }
+  }
   return FunctionConverter::canConvert(node);
 }
 
@@ -0,0 +1,355 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/ExecutionContext/TraceAnalysis.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace glow;
+
+namespace {
+
+/// \returns the numeric argument \p key of \p event, 0 if it is missing.
+uint64_t getNumericArg(const TraceEvent &event, const char *key) {
+  auto it = event.args.find(key);
+  if (it == event.args.end()) {
+    return 0;
+  }
+  return std::strtoull(it->second.c_str(), nullptr, /* base */ 10);
+}
+
+/// \returns the argument \p key of \p event, empty if it is missing.
+std::string getArg(const TraceEvent &event, const char *key) {
+  auto it = event.args.find(key);
+  return it != event.args.end() ? it->second : "";
+}
+
+/// \returns \p a - \p b, or 0 if \p b is later than \p a.
+uint64_t getElapsed(uint64_t a, uint64_t b) { return a > b ? a - b : 0; }
+
+/// \returns the device time of \p partition, what remains of its duration
+/// once its dispatch and transfers are accounted for.
+uint64_t getDeviceTime(const RequestTraceAnalysis::Partition &partition) {
+  uint64_t duration = getElapsed(partition.end, partition.start);
+  return getElapsed(duration, partition.dispatch + partition.transfer);
+}
+
+/// \returns the \p q quantile of the sorted \p values.
+uint64_t getQuantile(const std::vector<uint64_t> &values, double q) {
+  if (values.empty()) {
+    return 0;
+  }
+  size_t idx = std::min(values.size() - 1, size_t(q * values.size()));
+  return values[idx];
+}
+
+} // namespace
+
+void RequestTraceAnalysis::addTraceEvents(const std::list<TraceEvent> &events,
+                                          llvm::StringRef source) {
+  for (const auto &event : events) {
+    if (event.level != TraceLevel::REQUEST ||
+        event.type != TraceEvent::CompleteType) {
+      continue;
+    }
+    bool isQueue = event.name == kQueueEvent;
+    bool isRun = event.name == kRunEvent;
+    bool isPartition = event.name == kPartitionEvent;
+    if (!isQueue && !isRun && !isPartition) {
+      continue;
+    }
+    std::string id = getArg(event, "request");
+    auto &request = pending_[source.str() + ":" + id];
+    request.id = source.empty() ? id : source.str() + ":" + id;
+    uint64_t end = event.timestamp + event.duration;
+    if (isQueue) {
+      request.hasQueue = true;
+      request.received = event.timestamp;
+      request.network = getArg(event, "network");
+    } else if (isRun) {
+      request.hasRun = true;
+      request.dispatched = event.timestamp;
+      request.finished = end;
+    } else {
+      Partition partition;
+      partition.node = getArg(event, "node");
+      llvm::SmallVector<llvm::StringRef, 4> parents;
+      llvm::StringRef(getArg(event, "parents"))
+          .split(parents, ',', /* MaxSplit */ -1, /* KeepEmpty */ false);
+      for (auto parent : parents) {
+        partition.parents.push_back(parent.str());
+      }
+      partition.device = getArg(event, "device");
+      partition.start = event.timestamp;
+      partition.end = end;
+      partition.dispatch = getNumericArg(event, "dispatch");
+      partition.transfer = getNumericArg(event, "transfer");
+      request.partitions.push_back(std::move(partition));
+    }
+  }
+}
+
+void RequestTraceAnalysis::analyze() {
+  for (auto &it : pending_) {
+    Request &request = it.second;
+    if (!request.hasQueue || !request.hasRun) {
+      numIncomplete_++;
+      continue;
+    }
+
+    // Walk back from the last partition to finish through the parent that
+    // finished last, the one the partition had to wait for.
+    auto &partitions = request.partitions;
+    std::map<std::string, size_t> byNode;
+    for (size_t i = 0; i < partitions.size(); i++) {
+      byNode[partitions[i].node] = i;
+    }
+    auto &path = request.criticalPath;
+    if (!partitions.empty()) {
+      size_t cur = 0;
+      for (size_t i = 1; i < partitions.size(); i++) {
+        if (partitions[i].end > partitions[cur].end) {
+          cur = i;
+        }
+      }
+      path.push_back(cur);
+      // A malformed trace could have cycles, a path is never longer than
+      // the number of partitions.
+      while (path.size() < partitions.size()) {
+        bool found = false;
+        size_t next = 0;
+        for (const auto &parent : partitions[cur].parents) {
+          auto parentIt = byNode.find(parent);
+          if (parentIt == byNode.end()) {
+            continue;
+          }
+          size_t idx = parentIt->second;
+          if (!found || partitions[idx].end > partitions[next].end) {
+            next = idx;
+            found = true;
+          }
+        }
+        if (!found) {
+          break;
+        }
+        path.push_back(next);
+        cur = next;
+      }
+      std::reverse(path.begin(), path.end());
+    }
+
+    Blame &blame = request.blame;
+    blame.queue = getElapsed(request.dispatched, request.received);
+    uint64_t prevEnd = request.dispatched;
+    for (size_t idx : path) {
+      const Partition &partition = partitions[idx];
+      blame.dispatch +=
+          getElapsed(partition.start, prevEnd) + partition.dispatch;
+      blame.transfer += partition.transfer;
+      blame.device += getDeviceTime(partition);
+      prevEnd = std::max(prevEnd, partition.end);
+    }
+    blame.callback = getElapsed(request.finished, prevEnd);
+    requests_.push_back(std::move(request));
+  }
+  pending_.clear();
+}
+
+void RequestTraceAnalysis::dump(llvm::raw_ostream &os,
+                                unsigned numSlowest) const {
+  os << llvm::formatv("Requests: {0} ({1} incomplete)\n", requests_.size(),
+                      numIncomplete_);
+  if (requests_.empty()) {
+    return;
+  }
+
+  std::vector<uint64_t> latencies;
+  Blame total;
+  for (const auto &request : requests_) {
+    latencies.push_back(request.getLatency());
+    total.queue += request.blame.queue;
+    total.dispatch += request.blame.dispatch;
+    total.transfer += request.blame.transfer;
+    total.device += request.blame.device;
+    total.callback += request.blame.callback;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  os << llvm::formatv("Latency (us): p50 {0} p90 {1} p99 {2} max {3}\n\n",
+                      getQuantile(latencies, 0.5), getQuantile(latencies, 0.9),
+                      getQuantile(latencies, 0.99), latencies.back());
+
+  double totalUs = std::max<uint64_t>(total.getTotal(), 1);
+  double numRequests = requests_.size();
+  os << llvm::formatv("{0,-10} {1,14} {2,12} {3,7}\n", "Phase",
+                      "Total (us)", "Mean (us)", "Share");
+  std::pair<const char *, uint64_t> phases[] = {
+      {"queue", total.queue},       {"dispatch", total.dispatch},
+      {"transfer", total.transfer}, {"device", total.device},
+      {"callback", total.callback},
+  };
+  for (const auto &phase : phases) {
+    os << llvm::formatv("{0,-10} {1,14} {2,12:f1} {3,6:f1}%\n", phase.first,
+                        phase.second, phase.second / numRequests,
+                        100 * phase.second / totalUs);
+  }
+
+  // Device time of the partitions on the critical paths.
+  struct PartitionBlame {
+    uint64_t count{0};
+    uint64_t device{0};
+    uint64_t transfer{0};
+  };
+  std::map<std::string, PartitionBlame> partitions;
+  for (const auto &request : requests_) {
+    for (size_t idx : request.criticalPath) {
+      const Partition &partition = request.partitions[idx];
+      auto &entry = partitions[partition.node];
+      entry.count++;
+      entry.device += getDeviceTime(partition);
+      entry.transfer += partition.transfer;
+    }
+  }
+  std::vector<std::pair<std::string, PartitionBlame>> sorted(
+      partitions.begin(), partitions.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+    return a.second.device + a.second.transfer >
+           b.second.device + b.second.transfer;
+  });
+  os << llvm::formatv("\n{0,-32} {1,8} {2,14} {3,14}\n",
+                      "Partition on critical path", "Count", "Device (us)",
+                      "Transfer (us)");
+  for (const auto &entry : sorted) {
+    os << llvm::formatv("{0,-32} {1,8} {2,14} {3,14}\n", entry.first,
+                        entry.second.count, entry.second.device,
+                        entry.second.transfer);
+  }
+
+  std::vector<const Request *> slowest;
+  for (const auto &request : requests_) {
+    slowest.push_back(&request);
+  }
+  std::sort(slowest.begin(), slowest.end(),
+            [](const Request *a, const Request *b) {
+              return a->getLatency() > b->getLatency();
+            });
+  slowest.resize(std::min<size_t>(slowest.size(), numSlowest));
+  if (slowest.empty()) {
+    return;
+  }
+  os << llvm::formatv("\nSlowest requests (us):\n{0,-12} {1,-20} {2,9} {3,9} "
+                      "{4,9} {5,9} {6,9} {7,9}  {8}\n",
+                      "Request", "Network", "Latency", "Queue", "Dispatch",
+                      "Transfer", "Device", "Callback", "Critical path");
+  for (const Request *request : slowest) {
+    std::vector<llvm::StringRef> path;
+    for (size_t idx : request->criticalPath) {
+      path.push_back(request->partitions[idx].node);
+    }
+    const Blame &blame = request->blame;
+    os << llvm::formatv(
+        "{0,-12} {1,-20} {2,9} {3,9} {4,9} {5,9} {6,9} {7,9}  {8}\n",
+        request->id, request->network, request->getLatency(), blame.queue,
+        blame.dispatch, blame.transfer, blame.device, blame.callback,
+        llvm::join(path.begin(), path.end(), " -> "));
+  }
+}
+
+uint64_t
+RequestTraceAnalysis::getCopyTime(const std::list<TraceEvent> &events) {
+  uint64_t total = 0;
+  // Start times of the begin events not ended yet, per thread and name.
+  std::map<std::pair<int, std::string>, std::vector<uint64_t>> open;
+  for (const auto &event : events) {
+    if (event.level != TraceLevel::COPY) {
+      continue;
+    }
+    if (event.type == TraceEvent::CompleteType) {
+      total += event.duration;
+    } else if (event.type == TraceEvent::BeginType) {
+      open[{event.tid, event.name}].push_back(event.timestamp);
+    } else if (event.type == TraceEvent::EndType) {
+      auto &starts = open[{event.tid, event.name}];
+      if (!starts.empty()) {
+        total += getElapsed(event.timestamp, starts.back());
+        starts.pop_back();
+      }
+    }
+  }
+  return total;
+}
+
+Expected<std::list<TraceEvent>>
+RequestTraceAnalysis::loadTrace(llvm::StringRef fileName) {
+  auto bufferOrErr = llvm::MemoryBuffer::getFile(fileName);
+  RETURN_ERR_IF_NOT(bufferOrErr, "Unable to read the trace " + fileName.str());
+  auto parsed = llvm::json::parse((*bufferOrErr)->getBuffer());
+  if (!parsed) {
+    return MAKE_ERR("Invalid trace " + fileName.str() + ": " +
+                    llvm::toString(parsed.takeError()));
+  }
+  const llvm::json::Array *array = parsed->getAsArray();
+  if (!array) {
+    if (const auto *object = parsed->getAsObject()) {
+      array = object->getArray("traceEvents");
+    }
+  }
+  RETURN_ERR_IF_NOT(array, "Trace " + fileName.str() +
+                               " does not have an array of events");
+
+  std::list<TraceEvent> events;
+  for (const auto &value : *array) {
+    const auto *object = value.getAsObject();
+    if (!object) {
+      continue;
+    }
+    auto name = object->getString("name");
+    auto type = object->getString("ph");
+    if (!name || !type || type->empty()) {
+      continue;
+    }
+    TraceLevel level = TraceLevel::NONE;
+    if (auto cat = object->getString("cat")) {
+      for (auto candidate : {TraceLevel::REQUEST, TraceLevel::RUNTIME,
+                             TraceLevel::COPY, TraceLevel::OPERATOR,
+                             TraceLevel::DEBUG, TraceLevel::COMPILE}) {
+        if (*cat == TraceEvent::traceLevelToString(candidate)) {
+          level = candidate;
+        }
+      }
+    }
+    uint64_t timestamp = object->getNumber("ts").getValueOr(0);
+    int tid = object->getInteger("tid").getValueOr(0);
+    TraceEvent event(*name, level, timestamp, type->front(), tid);
+    event.duration = object->getNumber("dur").getValueOr(0);
+    if (const auto *args = object->getObject("args")) {
+      for (const auto &arg : *args) {
+        if (auto str = arg.second.getAsString()) {
+          event.args[arg.first.str()] = str->str();
+        } else if (auto num = arg.second.getAsNumber()) {
+          event.args[arg.first.str()] = llvm::formatv("{0}", *num).str();
+        }
+      }
+    }
+    events.push_back(std::move(event));
+  }
+  return events;
+}
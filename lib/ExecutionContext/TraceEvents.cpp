@@ -16,22 +16,150 @@
 
 #include "glow/ExecutionContext/TraceEvents.h"
 #include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/Support/Memory.h"
 #include "glow/Support/ThreadPool.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FormatVariadic.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <atomic>
+#include <cstdlib>
 #include <fstream>
 #include <glog/logging.h>
+#include <thread>
 
 namespace glow {
 
-void writeMetadataHelper(llvm::raw_fd_ostream &file, llvm::StringRef type,
-                         int id, llvm::StringRef name) {
-  file << "{\"cat\": \"__metadata\", \"ph\":\"" << TraceEvent::MetadataType
-       << "\", \"ts\":0, \"pid\":0, \"tid\":" << id << ", \"name\":\""
-       << type.str() << "\", \"args\": {\"name\":\"" << name.str() << "\"} }";
+namespace {
+/// Number of events a TraceEventBuffer reserves room for when created.
+constexpr size_t kTraceEventBufferReserve = 1024;
+
+/// A fixed size record of a TraceEvent in a TraceEventBuffer.
+struct BufferedTraceEvent {
+  uint64_t timestamp;
+  uint64_t duration;
+  /// Index of the name in the names of the buffer.
+  uint32_t name;
+  /// Index of the arguments in the arguments of the buffer, -1 if none.
+  int32_t args;
+  int tid;
+  int id;
+  TraceLevel level;
+  char type;
+};
+
+/// Source of the ids of the TraceContexts.
+std::atomic<uint64_t> nextTraceContextId{1};
+
+/// The buffer the calling thread last logged into, with the id of its
+/// TraceContext. The buffer is only used when the id matches, so the cache is
+/// never dereferenced after its context is destroyed.
+struct ThreadBufferCache {
+  uint64_t contextId{0};
+  TraceEventBuffer *buffer{nullptr};
+};
+thread_local ThreadBufferCache threadBufferCache;
+} // namespace
+
+/// The events logged by one thread into a TraceContext. Names are interned so
+/// that the events are fixed size records, and the storage is kept across
+/// flushes.
+class TraceEventBuffer {
+public:
+  explicit TraceEventBuffer(std::thread::id owner) : owner(owner) {
+    events.reserve(kTraceEventBufferReserve);
+  }
+
+  /// The thread appending to this buffer.
+  const std::thread::id owner;
+
+  /// The events, in logging order.
+  std::vector<BufferedTraceEvent> events;
+
+  /// The interned names of the events, indexed by BufferedTraceEvent::name.
+  std::vector<llvm::StringRef> names;
+
+  /// Index of each name in names. Its keys back the entries of names.
+  llvm::StringMap<uint32_t> nameIndex;
+
+  /// The arguments of the events that have any.
+  std::vector<std::map<std::string, std::string>> args;
+
+  /// Appends an event with the given fields.
+  void append(llvm::StringRef name, TraceLevel level, char type,
+              uint64_t timestamp, uint64_t duration,
+              std::map<std::string, std::string> &&eventArgs, int tid,
+              int id) {
+    auto it = nameIndex.insert(std::make_pair(name, names.size())).first;
+    if (it->second == names.size()) {
+      names.push_back(it->getKey());
+    }
+    int32_t argsIndex = -1;
+    if (!eventArgs.empty()) {
+      argsIndex = args.size();
+      args.push_back(std::move(eventArgs));
+    }
+    events.push_back(
+        {timestamp, duration, it->second, argsIndex, tid, id, level, type});
+  }
+
+  /// \returns the TraceEvent of the buffered event \p ev.
+  TraceEvent materialize(const BufferedTraceEvent &ev) {
+    TraceEvent res(names[ev.name], ev.level, ev.timestamp, ev.type, ev.tid,
+                   ev.id);
+    res.duration = ev.duration;
+    if (ev.args >= 0) {
+      res.args = std::move(args[ev.args]);
+    }
+    return res;
+  }
+
+  /// Removes all events, keeping the storage.
+  void clear() {
+    events.clear();
+    names.clear();
+    nameIndex.clear();
+    args.clear();
+  }
+};
+
+void TraceEvent::dumpMetadataEvent(llvm::raw_ostream &os, llvm::StringRef type,
+                                   int id, llvm::StringRef name) {
+  os << "{\"cat\": \"__metadata\", \"ph\":\"" << TraceEvent::MetadataType
+     << "\", \"ts\":0, \"pid\":0, \"tid\":" << id << ", \"name\":\""
+     << type.str() << "\", \"args\": {\"name\":\"" << name.str() << "\"} }";
+}
+
+void TraceEvent::dumpTraceEvent(llvm::raw_ostream &os,
+                                const TraceEvent &event) {
+  os << "{\"name\": \"" << event.name;
+  os << "\", \"cat\": \"" << traceLevelToString(event.level) << "\",";
+  os << "\"ph\": \"" << event.type;
+  os << "\", \"ts\": " << event.timestamp;
+  os << ", \"pid\": 0";
+  os << ", \"tid\": " << event.tid;
+
+  if (event.type == CompleteType) {
+    os << ", \"dur\": " << event.duration;
+  }
+
+  if (event.id != -1) {
+    os << ", \"id\": \"" << event.id << "\"";
+  }
+
+  if (!event.args.empty()) {
+    os << ", \"args\": {";
+    bool firstArg{true};
+    for (auto &pair : event.args) {
+      // Start with a comma unless it's the first item in the list.
+      os << (firstArg ? "" : ", ");
+      firstArg = false;
+      os << "\"" << pair.first << "\" : \"" << pair.second << "\"";
+    }
+    os << "}";
+  }
+  os << "}";
 }
 
 void TraceEvent::dumpTraceEvents(
@@ -53,52 +181,71 @@ void TraceEvent::dumpTraceEvents(
 
   file << "[\n";
   /// Set up process name metadata.
-  writeMetadataHelper(file, "process_name", 0,
-                      processName.empty() ? "glow" : processName);
+  dumpMetadataEvent(file, "process_name", 0,
+                    processName.empty() ? "glow" : processName);
 
   /// And thread name metadata.
   for (const auto &nameMap : threadNames) {
     // Put thread name ahead of thread ID so chrome will group thread with the
     // same prefix together.
     file << ",\n";
-    writeMetadataHelper(
+    dumpMetadataEvent(
         file, "thread_name", nameMap.first,
         llvm::formatv("{1}: {0,7}", nameMap.first, nameMap.second).str());
   }
 
   for (const auto &event : events) {
     file << ",\n";
+    dumpTraceEvent(file, event);
+  }
+  file << "\n]";
+  file.close();
+}
 
-    file << "{\"name\": \"" << event.name;
-    file << "\", \"cat\": \"" << traceLevelToString(event.level) << "\",";
-    file << "\"ph\": \"" << event.type;
-    file << "\", \"ts\": " << event.timestamp;
-    file << ", \"pid\": 0";
-    file << ", \"tid\": " << event.tid;
-
-    if (event.type == CompleteType) {
-      file << ", \"dur\": " << event.duration;
-    }
-
-    if (event.id != -1) {
-      file << ", \"id\": \"" << event.id << "\"";
+void TraceEvent::dumpOperatorSummary(llvm::raw_ostream &os,
+                                     const std::list<TraceEvent> &events) {
+  struct KindSummary {
+    uint64_t count{0};
+    uint64_t duration{0};
+    std::map<std::string, uint64_t> counters;
+  };
+  std::map<std::string, KindSummary> kinds;
+  for (const auto &event : events) {
+    if (event.level != OPERATOR || event.type != CompleteType) {
+      continue;
     }
-
-    if (!event.args.empty()) {
-      file << ", \"args\": {";
-      bool firstArg{true};
-      for (auto &pair : event.args) {
-        // Start with a comma unless it's the first item in the list.
-        file << (firstArg ? "" : ", ");
-        firstArg = false;
-        file << "\"" << pair.first << "\" : \"" << pair.second << "\"";
+    auto kindIt = event.args.find("kind");
+    auto &summary =
+        kinds[kindIt != event.args.end() ? kindIt->second : event.name];
+    summary.count++;
+    summary.duration += event.duration;
+    for (const auto &arg : event.args) {
+      if (arg.first != "kind") {
+        summary.counters[arg.first] += std::strtoull(arg.second.c_str(),
+                                                     nullptr, /* base */ 10);
       }
-      file << "}";
     }
-    file << "}";
   }
-  file << "\n]";
-  file.close();
+
+  os << llvm::formatv("{0,-28} {1,8} {2,12} {3,6} {4,9} {5,10}\n", "Kind",
+                      "Count", "Time (us)", "IPC", "LLC MPKI", "LLC MB/s");
+  for (const auto &kind : kinds) {
+    const auto &summary = kind.second;
+    auto getCounter = [&](const char *name) -> double {
+      auto it = summary.counters.find(name);
+      return it != summary.counters.end() ? it->second : 0;
+    };
+    double cycles = getCounter("cycles");
+    double instructions = getCounter("instructions");
+    double misses = getCounter("llc_misses");
+    // Each miss transfers a 64 byte cache line, so bytes per microsecond is
+    // MB/s.
+    os << llvm::formatv(
+        "{0,-28} {1,8} {2,12} {3,6:f2} {4,9:f2} {5,10:f1}\n", kind.first,
+        summary.count, summary.duration, cycles ? instructions / cycles : 0.0,
+        instructions ? misses * 1000 / instructions : 0.0,
+        summary.duration ? misses * 64 / summary.duration : 0.0);
+  }
 }
 
 uint64_t TraceEvent::now() {
@@ -121,6 +268,8 @@ llvm::StringRef TraceEvent::traceLevelToString(TraceLevel level) {
     return "Operator";
   case DEBUG:
     return "Debug";
+  case COMPILE:
+    return "Compile";
   case STANDARD:
     return "Standard";
   }
@@ -128,6 +277,60 @@ llvm::StringRef TraceEvent::traceLevelToString(TraceLevel level) {
   return "Unknown";
 }
 
+TraceContext::TraceContext(int level)
+    : id_(nextTraceContextId++), traceLevel_(level) {}
+
+TraceContext::~TraceContext() = default;
+
+TraceEventBuffer &TraceContext::getThreadBuffer() {
+  if (threadBufferCache.contextId == id_) {
+    return *threadBufferCache.buffer;
+  }
+  auto self = std::this_thread::get_id();
+  std::lock_guard<std::mutex> l(buffersLock_);
+  TraceEventBuffer *buffer = nullptr;
+  for (auto &b : buffers_) {
+    if (b->owner == self) {
+      buffer = b.get();
+      break;
+    }
+  }
+  if (!buffer) {
+    buffers_.push_back(glow::make_unique<TraceEventBuffer>(self));
+    buffer = buffers_.back().get();
+  }
+  threadBufferCache.contextId = id_;
+  threadBufferCache.buffer = buffer;
+  return *buffer;
+}
+
+void TraceContext::flushEventBuffers() {
+  std::lock_guard<std::mutex> l(buffersLock_);
+  // Merge the buffers, taking at each step the earliest of their next events.
+  std::vector<size_t> heads(buffers_.size(), 0);
+  while (true) {
+    size_t next = buffers_.size();
+    uint64_t nextTimestamp = 0;
+    for (size_t i = 0, e = buffers_.size(); i < e; i++) {
+      const auto &events = buffers_[i]->events;
+      if (heads[i] < events.size() &&
+          (next == buffers_.size() ||
+           events[heads[i]].timestamp < nextTimestamp)) {
+        next = i;
+        nextTimestamp = events[heads[i]].timestamp;
+      }
+    }
+    if (next == buffers_.size()) {
+      break;
+    }
+    auto &buffer = *buffers_[next];
+    traceEvents_.push_back(buffer.materialize(buffer.events[heads[next]++]));
+  }
+  for (auto &b : buffers_) {
+    b->clear();
+  }
+}
+
 void TraceContext::logTraceEvent(
     llvm::StringRef name, TraceLevel level, char type,
     std::map<std::string, std::string> additionalAttributes, size_t tid,
@@ -144,20 +347,16 @@ void TraceContext::logTraceEvent(
     return;
   }
 
-  TraceEvent ev(name, level, timestamp, type, tid,
-                std::move(additionalAttributes), id);
-  {
-    std::lock_guard<std::mutex> l(lock_);
-    traceEvents_.push_back(std::move(ev));
-  }
+  getThreadBuffer().append(name, level, type, timestamp, 0,
+                           std::move(additionalAttributes), tid, id);
 }
 
 void TraceContext::logTraceEvent(TraceEvent &&ev) {
   if (!shouldLog(ev.level)) {
     return;
   }
-  std::lock_guard<std::mutex> l(lock_);
-  traceEvents_.push_back(std::move(ev));
+  getThreadBuffer().append(ev.name, ev.level, ev.type, ev.timestamp,
+                           ev.duration, std::move(ev.args), ev.tid, ev.id);
 }
 
 void TraceContext::logCompleteTraceEvent(
@@ -175,12 +374,9 @@ void TraceContext::logCompleteTraceEvent(
     return;
   }
 
-  TraceEvent ev(name, level, startTimestamp, TraceEvent::now() - startTimestamp,
-                tid, std::move(additionalAttributes));
-  {
-    std::lock_guard<std::mutex> l(lock_);
-    traceEvents_.push_back(std::move(ev));
-  }
+  getThreadBuffer().append(name, level, TraceEvent::CompleteType,
+                           startTimestamp, TraceEvent::now() - startTimestamp,
+                           std::move(additionalAttributes), tid, -1);
 }
 
 void TraceContext::setThreadName(int tid, llvm::StringRef name) {
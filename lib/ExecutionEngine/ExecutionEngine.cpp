@@ -23,7 +23,9 @@
 
 #include "llvm/ADT/STLExtras.h"
 
+#include <algorithm>
 #include <future>
+#include <thread>
 
 using namespace glow;
 
@@ -123,29 +125,36 @@ void glow::updateInputPlaceholdersByName(PlaceholderBindings &bindings,
   }
 }
 
+std::future<void> ExecutionEngine::runAsync(ExecutionContext &context,
+                                            llvm::StringRef name) {
+  if (name.empty()) {
+    assert((compiledFunctions_.size() == 1 || allowMultiFunction_) &&
+           "Expected exactly one compiled function.");
+    name = *compiledFunctions_.begin();
+  }
+  std::unique_ptr<ExecutionContext> contextPtr(&context);
+  auto runPromise = std::make_shared<std::promise<void>>();
+  auto fut = runPromise->get_future();
+  bool ensureOutputsOnHost = ensureOutputsOnHost_;
+  hostManager_->runNetwork(
+      name, std::move(contextPtr),
+      [runPromise, ensureOutputsOnHost](
+          runtime::RunIdentifierTy, Error err,
+          std::unique_ptr<ExecutionContext> contextPtr) {
+        if (ensureOutputsOnHost) {
+          contextPtr->getPlaceholderBindings()->ensureOnHost();
+        }
+        // Don't delete context.
+        contextPtr.release();
+        EXIT_ON_ERR(std::move(err));
+        runPromise->set_value();
+      });
+  return fut;
+}
+
 void ExecutionEngine::runInternal(ExecutionContext &context,
                                   llvm::StringRef name) {
-  std::unique_ptr<ExecutionContext> contextPtr(&context);
-  std::unique_ptr<ExecutionContext> contextOut;
-  std::promise<void> runPromise;
-  auto fut = runPromise.get_future();
-  Error runErr = Error::empty();
-  hostManager_->runNetwork(name, std::move(contextPtr),
-                           [&runPromise, &runErr, &contextOut](
-                               runtime::RunIdentifierTy, Error err,
-                               std::unique_ptr<ExecutionContext> contextPtr) {
-                             contextOut = std::move(contextPtr);
-                             runErr = std::move(err);
-                             runPromise.set_value();
-                           });
-
-  fut.wait();
-  if (ensureOutputsOnHost_) {
-    contextOut->getPlaceholderBindings()->ensureOnHost();
-  }
-  // Don't delete context.
-  contextOut.release();
-  EXIT_ON_ERR(std::move(runErr));
+  runAsync(context, name).wait();
 }
 
 void ExecutionEngine::run(ExecutionContext &context) {
@@ -176,6 +185,17 @@ void ExecutionEngine::run(PlaceholderBindings &bindings, llvm::StringRef name) {
   context.movePlaceholderBindings().release();
 }
 
+void ExecutionEngine::runConcurrently(
+    llvm::ArrayRef<ExecutionContext *> contexts, llvm::StringRef name) {
+  std::vector<std::future<void>> futures;
+  for (auto *context : contexts) {
+    futures.push_back(runAsync(*context, name));
+  }
+  for (auto &fut : futures) {
+    fut.wait();
+  }
+}
+
 void glow::runBatch(ExecutionEngine &EE, PlaceholderBindings &bindings,
                     size_t iterations, size_t &sampleCounter,
                     llvm::ArrayRef<Placeholder *> ph,
@@ -216,6 +236,138 @@ void glow::runBatch(ExecutionEngine &EE, PlaceholderBindings &bindings,
   }
 }
 
+DataParallelTrainer::DataParallelTrainer(ExecutionEngine &EE, Function *F,
+                                         const TrainingConfig &config,
+                                         unsigned numReplicas)
+    : EE_(EE), numReplicas_(numReplicas) {
+  CHECK_GT(numReplicas, 0) << "Expected at least one replica";
+  auto &mod = EE.getModule();
+  VariableGradientsList varGrads;
+  Function *gradF = differentiate(F, config, F->getName().str() + "_dp_grad",
+                                  &varGrads);
+  gradName_ = gradF->getName().str();
+
+  // The gradients of the shards are summed, so SGD averages them over the
+  // samples of all the shards.
+  Function *updateF = mod.createFunction(F->getName().str() + "_dp_update");
+  updateName_ = updateF->getName().str();
+  for (auto &varGrad : varGrads) {
+    Placeholder *W = varGrad.first;
+    if (!W->isTraining()) {
+      continue;
+    }
+    CHECK(W->getElementType() == ElemKind::FloatTy)
+        << "Only float weights can be trained, got " << W->getName().str();
+    auto *sum = mod.createPlaceholder(W->getType(),
+                                      "sum_grad_" + W->getName().str(), false);
+    auto *SGD = new SGDNode(W->getName(), sum, W, config.L1Decay,
+                            config.L2Decay, config.learningRate,
+                            config.momentum, config.batchSize * numReplicas);
+    updateF->addNode(SGD);
+    updateF->createSave("update_" + W->getName().str(),
+                        SGD->getUpdatedWeight(), W);
+    params_.push_back({W, varGrad.second, sum});
+  }
+
+  // Find the placeholders now since compiling may change the Functions.
+  for (auto *PH : gradF->findPlaceholders()) {
+    if (getOutputSave(gradF, PH)) {
+      replicaPlaceholders_.push_back(PH);
+    } else {
+      sharedPlaceholders_.push_back(PH);
+    }
+  }
+}
+
+void DataParallelTrainer::compile(CompilationContext &cctx) {
+  cctx.compMode = CompilationMode::Train;
+  cctx.saturateHost = true;
+  cctx.saturateKDevices = numReplicas_;
+  EE_.compile(cctx);
+}
+
+void DataParallelTrainer::allReduce(
+    PlaceholderBindings &bindings,
+    llvm::ArrayRef<std::unique_ptr<ExecutionContext>> replicas) {
+  auto sumPart = [&](unsigned part) {
+    for (const auto &param : params_) {
+      Tensor *sumT = bindings.get(param.sum);
+      float *sum = reinterpret_cast<float *>(sumT->getUnsafePtr());
+      size_t begin = sumT->size() * part / numReplicas_;
+      size_t end = sumT->size() * (part + 1) / numReplicas_;
+      for (size_t r = 0; r < replicas.size(); r++) {
+        Tensor *gradT = replicas[r]->getPlaceholderBindings()->get(param.grad);
+        const float *grad =
+            reinterpret_cast<const float *>(gradT->getUnsafePtr());
+        for (size_t i = begin; i < end; i++) {
+          sum[i] = r ? sum[i] + grad[i] : grad[i];
+        }
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned part = 1; part < numReplicas_; part++) {
+    threads.emplace_back(sumPart, part);
+  }
+  sumPart(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void DataParallelTrainer::runBatch(PlaceholderBindings &bindings,
+                                   size_t iterations, size_t &sampleCounter,
+                                   llvm::ArrayRef<Placeholder *> ph,
+                                   llvm::ArrayRef<Tensor *> inputs) {
+  assert(!inputs.empty() && "No inputs");
+  assert(inputs.size() == ph.size() &&
+         "The number of inputs does not match the number of placeholders");
+  // This is the size of one shard of the batch.
+  size_t shardSize = ph[0]->getType()->dims()[0];
+
+  // The replicas own the tensors written by the gradient Function, and view
+  // the other ones, e.g. the weights, in \p bindings.
+  bindings.allocate(EE_.getModule().getPlaceholders());
+  std::vector<std::unique_ptr<ExecutionContext>> replicas;
+  std::vector<ExecutionContext *> contexts;
+  for (unsigned r = 0; r < numReplicas_; r++) {
+    replicas.push_back(glow::make_unique<ExecutionContext>());
+    contexts.push_back(replicas.back().get());
+    auto *replicaBindings = replicas.back()->getPlaceholderBindings();
+    for (auto *PH : sharedPlaceholders_) {
+      if (std::find(ph.begin(), ph.end(), PH) == ph.end()) {
+        replicaBindings->insert(PH, bindings.get(PH)->getUnowned());
+      }
+    }
+    for (auto *PH : replicaPlaceholders_) {
+      replicaBindings->allocate(PH);
+    }
+    for (auto *PH : ph) {
+      replicaBindings->allocate(PH);
+    }
+  }
+
+  for (size_t j = 0; j < iterations; j++) {
+    // Load the consecutive shards of the step into the replicas.
+    for (unsigned r = 0; r < numReplicas_; r++) {
+      for (size_t i = 0, e = ph.size(); i < e; i++) {
+        auto *backingTensor =
+            replicas[r]->getPlaceholderBindings()->get(ph[i]);
+        assert(backingTensor->dims().drop_front() ==
+                   inputs[i]->dims().drop_front() &&
+               "Invalid slice size");
+        size_t slc = (sampleCounter + r * shardSize) % inputs[i]->dims()[0];
+        backingTensor->copyConsecutiveSlices(inputs[i], slc);
+      }
+    }
+
+    EE_.runConcurrently(contexts, gradName_);
+    allReduce(bindings, replicas);
+    EE_.run(bindings, updateName_);
+    sampleCounter += shardSize * numReplicas_;
+  }
+}
+
 void glow::evalBatch(
     ExecutionEngine &EE, PlaceholderBindings &bindings, size_t numMinibatchRuns,
     size_t &sampleCounter, Placeholder *inputPH, Placeholder *outputPH,
@@ -265,6 +417,121 @@ void glow::evalBatch(
   }
 }
 
+/// Runs \p iterations iterations of the function \p name, alternating two
+/// ExecutionContexts: one with \p bindings, and one whose bindings view the
+/// tensors of \p bindings, apart from those of \p ownPH which it owns.
+/// \p fill loads the inputs of an iteration into its bindings while the
+/// previous iteration runs, and \p done is called with the bindings of an
+/// iteration once it is done, while the next one runs. The iterations run one
+/// after the other, so they can update the tensors they share, e.g. weights.
+static void runDoubleBuffered(
+    ExecutionEngine &EE, PlaceholderBindings &bindings, size_t iterations,
+    llvm::ArrayRef<Placeholder *> ownPH, llvm::StringRef name,
+    const std::function<void(PlaceholderBindings &, size_t)> &fill,
+    const std::function<void(PlaceholderBindings &, size_t)> &done) {
+  if (!iterations) {
+    return;
+  }
+  auto secondBindings = glow::make_unique<PlaceholderBindings>();
+  for (auto &entry : bindings.pairs()) {
+    if (std::find(ownPH.begin(), ownPH.end(), entry.first) == ownPH.end()) {
+      secondBindings->insert(entry.first, entry.second.getUnowned());
+    }
+  }
+  for (auto *PH : ownPH) {
+    secondBindings->allocate(PH);
+  }
+  std::unique_ptr<PlaceholderBindings> bindingsPtr(&bindings);
+  ExecutionContext first(std::move(bindingsPtr));
+  ExecutionContext second(std::move(secondBindings));
+  ExecutionContext *contexts[2] = {&first, &second};
+
+  fill(*first.getPlaceholderBindings(), 0);
+  std::future<void> running = EE.runAsync(first, name);
+  for (size_t j = 0; j < iterations; j++) {
+    ExecutionContext *next = contexts[(j + 1) % 2];
+    bool hasNext = j + 1 < iterations;
+    if (hasNext) {
+      fill(*next->getPlaceholderBindings(), j + 1);
+    }
+    running.wait();
+    if (hasNext) {
+      running = EE.runAsync(*next, name);
+    }
+    done(*contexts[j % 2]->getPlaceholderBindings(), j);
+  }
+  // Don't delete bindings.
+  first.movePlaceholderBindings().release();
+}
+
+void glow::runBatchAsync(ExecutionEngine &EE, PlaceholderBindings &bindings,
+                         size_t iterations, size_t &sampleCounter,
+                         llvm::ArrayRef<Placeholder *> ph,
+                         llvm::ArrayRef<Tensor *> inputs,
+                         llvm::StringRef name) {
+  // This is the size of one batch (the number of samples in the batch).
+  size_t batchSize = ph[0]->getType()->dims()[0];
+
+  assert(!inputs.empty() && "No inputs");
+  assert(inputs.size() == ph.size() &&
+         "The number of inputs does not match the number of placeholders");
+
+  auto fill = [&](PlaceholderBindings &iterBindings, size_t j) {
+    for (size_t i = 0, e = ph.size(); i < e; i++) {
+      auto *backingTensor = iterBindings.get(ph[i]);
+      assert(backingTensor && "Can't find the backing tensor");
+      auto dim = inputs[i]->dims();
+      assert(backingTensor->dims().drop_front() == dim.drop_front() &&
+             "Invalid slice size");
+      size_t slc = (sampleCounter + j * batchSize) % dim[0];
+      backingTensor->copyConsecutiveSlices(inputs[i], slc);
+    }
+  };
+  runDoubleBuffered(EE, bindings, iterations, ph, name, fill,
+                    [](PlaceholderBindings &, size_t) {});
+  sampleCounter += iterations * batchSize;
+}
+
+void glow::evalBatchAsync(
+    ExecutionEngine &EE, PlaceholderBindings &bindings, size_t numMinibatchRuns,
+    size_t &sampleCounter, Placeholder *inputPH, Placeholder *outputPH,
+    Tensor &samplesInput, Tensor &labelsInput, llvm::StringRef name,
+    std::function<void(const Tensor &sampleIn, const Tensor &sampleOut,
+                       const Tensor &label, size_t sampleIndex)> &&cb) {
+  // The number of samples in a minibatch (a single function run)
+  size_t minibatchSize = inputPH->getType()->dims()[0];
+
+  assert(samplesInput.dims()[0] == labelsInput.dims()[0] &&
+         "The number of sample inputs does not match the number of labels");
+
+  auto LIH = labelsInput.getHandle<int64_t>();
+  auto dim = samplesInput.dims();
+  auto fill = [&](PlaceholderBindings &iterBindings, size_t j) {
+    auto *backingTensor = iterBindings.get(inputPH);
+    assert(backingTensor && "Can't find the backing tensor");
+    assert(backingTensor->dims().drop_front() == dim.drop_front() &&
+           "Invalid slice size");
+    size_t slc = (sampleCounter + j * minibatchSize) % dim[0];
+    backingTensor->copyConsecutiveSlices(&samplesInput, slc);
+  };
+  auto done = [&](PlaceholderBindings &iterBindings, size_t j) {
+    size_t firstSample = sampleCounter + j * minibatchSize;
+    auto inputH = iterBindings.get(inputPH)->getHandle();
+    auto outputH = iterBindings.get(outputPH)->getHandle();
+    for (unsigned i = 0; i < minibatchSize; i++) {
+      auto sampleInputTensor = inputH.extractSlice(i);
+      auto sampleOutputTensor = outputH.extractSlice(i);
+      // If index is out of bounds of samples/labels first dimension, it is
+      // wrapped around to be consistent with "copyConsecutiveSlices".
+      auto labelTensor = LIH.extractSlice((firstSample + i) % dim[0]);
+      cb(sampleInputTensor, sampleOutputTensor, labelTensor, firstSample + i);
+    }
+  };
+  runDoubleBuffered(EE, bindings, numMinibatchRuns, {inputPH, outputPH}, name,
+                    fill, done);
+  sampleCounter += numMinibatchRuns * minibatchSize;
+}
+
 void ExecutionEngine::compile(CompilationMode mode) {
   CompilationContext cctx;
   cctx.compMode = mode;
@@ -735,6 +735,9 @@ Error ONNXModelWriter::writeFunction() {
         // Also include the layout in the initializer to be loaded later.
         addAttrToDocString(tensorProto, layoutSignifier, C->getLayout());
       }
+      // The initializer is complete, stream it out in zip mode instead of
+      // keeping its payload until the end.
+      flushInitializers();
     } else if (kind == Kinded::Kind::SaveNodeKind) {
       // Save node case, find input and use its name as a global output,
       // output only shape.
@@ -896,34 +899,25 @@ Error ONNXModelWriter::finalizeAndWriteProto(llvm::StringRef name) {
   }
 
   if (zipMode_) {
-    RETURN_ERR_IF_NOT(
-        outputStringPtr_ == nullptr,
-        "OnnxModelWriter write to string for zip mode not supported");
+    RETURN_ERR_IF_NOT(zipWriter_, "Zip archive " + name.str() + " not opened");
+    // Most initializers were already streamed out when written, write the
+    // remaining ones. Records are looked up by name so their count can come
+    // after them.
+    flushInitializers();
     const bool compressed = false;
-    ZipWriter zip(&ff_, name.str());
-    std::stringstream ss;
-    ss << initializers_.size() << "\n";
-    zip.writeRecord("weights", ss.str().c_str(), ss.str().size(), compressed);
+    std::string numWeights = std::to_string(numZipInitializers_) + "\n";
+    zipWriter_->writeRecord("weights", numWeights.c_str(), numWeights.size(),
+                            compressed);
     std::string largeBuffer;
-    int i = 0;
-    // This part is probably quite inefficient as we are deserializing the
-    // protobuf to a char buffer and then put it to zip stream. I didn't dig
-    // enough to see if we can deserialize it into zip stream directly.
-    for (const auto &t : initializers_) {
-      std::stringstream nm;
-      nm << "weight_" << i++;
-      t.SerializeToString(&largeBuffer);
-      zip.writeRecord(nm.str(), largeBuffer.c_str(), largeBuffer.size(),
-                      compressed);
-    }
     if (textMode_) {
       google::protobuf::TextFormat::PrintToString(modelProto_, &largeBuffer);
     } else {
       modelProto_.SerializeToString(&largeBuffer);
     }
-    zip.writeRecord("model", largeBuffer.c_str(), largeBuffer.size(),
-                    compressed);
-    zip.writeEndOfFile();
+    zipWriter_->writeRecord("model", largeBuffer.c_str(), largeBuffer.size(),
+                            compressed);
+    zipWriter_->writeEndOfFile();
+    zipWriter_.reset();
     ff_.flush();
     ff_.close();
     return Error::success();
@@ -966,6 +960,7 @@ ONNXModelWriter::ONNXModelWriter(
       addMetadataProp(prop.getKey().str(), prop.second);
     }
 
+    RETURN_IF_ERR(startZipArchive(F_->getName()));
     RETURN_IF_ERR(writeFunction());
 
     return finalizeAndWriteProto(F_->getName());
@@ -1098,6 +1093,7 @@ ONNXModelWriter::ONNXModelWriter(
 
     RETURN_ERR_IF_NOT(dagList.size() == 1, "Expect only one DAG.");
     const auto &dag = *dagList.begin();
+    RETURN_IF_ERR(startZipArchive(dag.root->name));
 
     Module &mod = *dag.root->module;
 
@@ -1124,6 +1120,33 @@ ONNXModelWriter::ONNXModelWriter(
   }
 }
 
+ONNXModelWriter::~ONNXModelWriter() = default;
+
+Error ONNXModelWriter::startZipArchive(llvm::StringRef name) {
+  if (!zipMode_) {
+    return Error::success();
+  }
+  RETURN_ERR_IF_NOT(
+      outputStringPtr_ == nullptr,
+      "OnnxModelWriter write to string for zip mode not supported");
+  zipWriter_ = glow::make_unique<ZipWriter>(&ff_, name.str());
+  return Error::success();
+}
+
+void ONNXModelWriter::flushInitializers() {
+  if (!zipWriter_) {
+    return;
+  }
+  const bool compressed = false;
+  std::string buffer;
+  for (const auto &t : initializers_) {
+    t.SerializeToString(&buffer);
+    zipWriter_->writeRecord("weight_" + std::to_string(numZipInitializers_++),
+                            buffer.c_str(), buffer.size(), compressed);
+  }
+  initializers_.clear();
+}
+
 ONNXModelWriter::TensorType *ONNXModelWriter::addInitializer(GraphType &g) {
   if (zipMode_) {
     initializers_.emplace_back();
@@ -2437,6 +2460,7 @@ DEF_ALL_WRITER_NODE(Cos)
 DEF_ALL_WRITER_NODE(LSTMUnit)
 DEF_ALL_WRITER_NODE(DynamicQuantizedFullyConnected)
 DEF_ALL_WRITER_NODE(DynamicRowwiseQuantizedFullyConnected)
+DEF_ALL_WRITER_NODE(Int4GroupwiseQuantizedFullyConnected)
 DEF_ALL_WRITER_NODE(Erf)
 DEF_ALL_WRITER_NODE(Min)
 DEF_ALL_WRITER_NODE(Max)
@@ -2477,6 +2501,7 @@ DEF_ALL_WRITER_NODE(RowwiseQuantizedSparseLengthsWeightedSum)
 DEF_ALL_WRITER_NODE(FusedRowwiseQuantizedSparseLengthsSum)
 DEF_ALL_WRITER_NODE(EmbeddingBagByteRowwiseOffsets)
 DEF_ALL_WRITER_NODE(FusedRowwiseQuantizedSparseLengthsWeightedSum)
+DEF_ALL_WRITER_NODE(ProductQuantizedSparseLengthsWeightedSum)
 DEF_ALL_WRITER_NODE(NonMaxSuppression)
 DEF_ALL_WRITER_NODE(TFLiteDetectionPostProcess)
 DEF_ALL_WRITER_NODE(TFLiteCustomOperator)
@@ -2488,6 +2513,7 @@ DEF_ALL_WRITER_NODE(BatchedUnaryEmbeddingsBags)
 DEF_ALL_WRITER_NODE(IntNBitSplitEmbeddingBags)
 DEF_ALL_WRITER_NODE(IntNBitSplitEmbeddingWeightedBags)
 DEF_ALL_WRITER_NODE(PermutePooledEmbeddings)
+DEF_ALL_WRITER_NODE(ScaledDotProductAttention)
 
 Error ONNXModelWriter::writeClip(const ClipNode *node, GraphType &graph) {
   auto *proto = graph.add_node();
@@ -2731,6 +2757,8 @@ DEF_UNSUPPORTED_STORAGE(Storage)
 DEF_UNSUPPORTED_NODE(BatchedPairwiseDotProduct)
 DEF_UNSUPPORTED_NODE(Broadcast)
 DEF_UNSUPPORTED_NODE(SGD)
+DEF_UNSUPPORTED_NODE(FusedSGD)
+DEF_UNSUPPORTED_NODE(BeamSearchStep)
 DEF_UNSUPPORTED_NODE(SparseLabelSplit)
 // Artificial node.
 DEF_UNSUPPORTED_NODE(Save)
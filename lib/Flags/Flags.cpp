@@ -43,12 +43,15 @@ size_t MaxActiveRequests = 48;
 size_t MaxActiveRequestsPerInstance = 48;
 size_t MaxQueueSize = 200;
 size_t ExecutorThreads = 10;
+bool ExecutorWorkStealing = false;
+bool ExecutorInlineSingleNode = false;
 bool DelayAndRecordConstantModification = false;
 bool UseTrackedDummyQuantParams = false;
 bool EnablePartialTensors = true;
 bool UseCustomOpsForExport = true;
 std::string BackendSpecificOpts = "";
 bool EnableLoadBalancedPartitioning = true;
+std::string PartitionerCostProfile = "";
 bool SkipProvisioning = false;
 bool DisableLayoutVerifying = false;
 bool DisableFreeCompilationResource = false;
@@ -74,6 +77,9 @@ bool ConvertFusedScaleOffsetToFP32 = false;
 // Debug Constants
 int32_t NumDebugTracesPerDump = 100;
 bool DumpDebugTraces = false;
+int32_t TraceSampleRate = 0;
+int32_t TraceOverheadBudgetPercent = 1;
+std::string TraceStreamFile = "";
 bool LogPartition = true;
 bool DumpPartition = false;
 bool DumpCompilationLog = false;
@@ -94,6 +100,7 @@ bool SparseNNPartitioningPairLNWithSLS = false;
 bool SparseNNPartitioningPairTileWithSLS = false;
 std::string SparseNNPartitioningPairSLSWith = "";
 int32_t SparseNNPartitioningConcatSplitSize = 1;
+int64_t SparseNNPartitioningShardTableKBytes = 0;
 bool SparseNNParallelizeReshapeOnBatchDim = true;
 
 // Dag Optimizer Constants
@@ -112,6 +119,7 @@ namespace nnpi {
 namespace flags {
 int32_t ModelParallelSplitAlignment = 1;
 int32_t NumParallelChunks = 0; // Zero val for an ugly hack in NNPI.cpp
+int32_t AutoParallelCores = 0;
 bool LowerAllBatchMatMul = false;
 bool AcceptUnarySLS = false;
 bool SpecializeAllOneSLS = false;
@@ -163,18 +171,38 @@ namespace runtime {
 namespace flags {
 
 unsigned CPUMemory = 0;
+unsigned CPUIntraOpThreads = 1;
+unsigned CPUDeviceThreads = 1;
+bool CPUWinogradConv = true;
+bool CPUIm2ColConv = true;
+unsigned CPUSplitCacheBytes = 0;
+unsigned CPUSparseFCMinZeroBlocksPercent = 70;
+int32_t CPURowAlignmentBytes = 16;
+std::string CPUMemoryPlanner = "livesize";
+uint64_t CPUHugePageConstantsBytes = 0;
+bool CPUExplicitHugePages = false;
+int32_t CPUConstantsNumaNode = -1;
 unsigned HabanaMemory = 7 << 20;
+unsigned HabanaRunners = 1;
+unsigned HabanaWaiters = 1;
 unsigned NNPIMemory = 16 << 20;
 unsigned NNPITimeoutMs = 0;
 
 std::string AvailableDevices = "";
 unsigned InterpreterMemory = 0;
+unsigned InterpreterIntraOpThreads = 1;
 bool EnableP2P = false;
 bool EnableDRT = false;
+bool DRTPrefetchInputs = true;
 unsigned DeviceInitTimeoutMs = 5000;
 unsigned SanitizeInputsPercent = 0;
+unsigned SanitizeInputsTables = 0;
+unsigned DedupInputsMinPercent = 0;
 uint64_t BigTableThresholdBytes = 104857600; // 100MB
 unsigned NumCompilationThreads = 1;
+uint64_t LLVMRunBufferCacheBytes = 64 << 20;
+std::string CompiledFunctionCacheDir = "";
+unsigned DeferredWeightsInFlight = 4;
 } // namespace flags
 } // namespace runtime
 } // namespace glow
@@ -242,6 +270,30 @@ DEFINE_validator(glow_num_debug_traces_per_dump, [](const char *, int32_t val) {
   glow::flags::NumDebugTracesPerDump = val;
   return true;
 });
+DEFINE_int32(glow_trace_sample_rate, glow::flags::TraceSampleRate,
+             "Continuously trace one request in this many, plus the requests "
+             "slower than the p99 latency. 0 disables sampled tracing.");
+DEFINE_validator(glow_trace_sample_rate, [](const char *, int32_t val) {
+  glow::flags::TraceSampleRate = val;
+  return val >= 0;
+});
+DEFINE_int32(glow_trace_overhead_budget_percent,
+             glow::flags::TraceOverheadBudgetPercent,
+             "Percentage of the request run time that exporting sampled "
+             "traces may take.");
+DEFINE_validator(glow_trace_overhead_budget_percent,
+                 [](const char *, int32_t val) {
+                   glow::flags::TraceOverheadBudgetPercent = val;
+                   return val >= 0;
+                 });
+DEFINE_string(glow_trace_stream_file, glow::flags::TraceStreamFile,
+              "File the sampled traces are streamed to in the Chrome trace "
+              "format.");
+DEFINE_validator(glow_trace_stream_file,
+                 [](const char *, const std::string &val) {
+                   glow::flags::TraceStreamFile = val;
+                   return true;
+                 });
 DEFINE_string(glow_onnxifi_backend, glow::onnxifi::flags::BackendName,
               "Glow backend used for ONNXIFI");
 DEFINE_validator(glow_onnxifi_backend,
@@ -384,6 +436,18 @@ DEFINE_validator(glow_sparsenn_partitioning_concat_split_size,
                    glow::flags::SparseNNPartitioningConcatSplitSize = val;
                    return true;
                  });
+DEFINE_int32(glow_sparsenn_partitioning_shard_table_kbytes,
+             glow::flags::SparseNNPartitioningShardTableKBytes,
+             "Shard SLS tables larger than this many KBytes row-wise across "
+             "SLS partitions, 0 to disable");
+DEFINE_validator(glow_sparsenn_partitioning_shard_table_kbytes,
+                 [](const char *, const int32_t val) {
+                   if (val < 0) {
+                     return false;
+                   }
+                   glow::flags::SparseNNPartitioningShardTableKBytes = val;
+                   return true;
+                 });
 DEFINE_bool(glow_sparsenn_parallelize_reshape_on_batch_dim,
             glow::flags::SparseNNParallelizeReshapeOnBatchDim,
             "Force parallelizing the reshape operators on the batch dimension");
@@ -492,6 +556,21 @@ DEFINE_validator(glow_executor_threads, [](const char *, int32_t val) {
   glow::flags::ExecutorThreads = val;
   return true;
 });
+DEFINE_bool(glow_executor_work_stealing, glow::flags::ExecutorWorkStealing,
+            "Use per-thread work-stealing queues in the host manager's "
+            "executor instead of a single shared queue");
+DEFINE_validator(glow_executor_work_stealing, [](const char *, bool val) {
+  glow::flags::ExecutorWorkStealing = val;
+  return true;
+});
+DEFINE_bool(glow_executor_inline_single_node,
+            glow::flags::ExecutorInlineSingleNode,
+            "Handle the results of networks of a single partition on the "
+            "device's thread instead of moving them to the executor's");
+DEFINE_validator(glow_executor_inline_single_node, [](const char *, bool val) {
+  glow::flags::ExecutorInlineSingleNode = val;
+  return true;
+});
 DEFINE_bool(glow_partitioner_enable_load_balance,
             glow::flags::EnableLoadBalancedPartitioning,
             "Enable a partitioner pass to optimize for load balance in "
@@ -501,6 +580,15 @@ DEFINE_validator(glow_partitioner_enable_load_balance,
                    glow::flags::EnableLoadBalancedPartitioning = val;
                    return true;
                  });
+DEFINE_string(glow_partitioner_cost_profile,
+              glow::flags::PartitionerCostProfile,
+              "YAML file of measured per-node latencies the partitioner uses "
+              "instead of its roofline estimates, see NodeCostProfile");
+DEFINE_validator(glow_partitioner_cost_profile,
+                 [](const char *, const std::string &val) {
+                   glow::flags::PartitionerCostProfile = val;
+                   return true;
+                 });
 DEFINE_bool(glow_skip_provisioning, glow::flags::SkipProvisioning,
             "Skip provisioning. Used for AOT opts or debugging.");
 DEFINE_validator(glow_skip_provisioning, [](const char *, bool val) {
@@ -678,6 +766,14 @@ DEFINE_validator(glow_nnpi_num_parallel_chunks, [](const char *, int32_t val) {
   glow::nnpi::flags::NumParallelChunks = val;
   return true;
 });
+DEFINE_int32(glow_nnpi_auto_parallel_cores,
+             glow::nnpi::flags::AutoParallelCores,
+             "Number of cores for which NNPI picks the parallel splits with "
+             "its cost model, 0 to use the explicit number of chunks");
+DEFINE_validator(glow_nnpi_auto_parallel_cores, [](const char *, int32_t val) {
+  glow::nnpi::flags::AutoParallelCores = val;
+  return true;
+});
 DEFINE_int32(glow_nnpi_model_parallel_split_alignment,
              glow::nnpi::flags::ModelParallelSplitAlignment,
              "Alignment value for model parallel splits");
@@ -734,12 +830,133 @@ DEFINE_validator(glow_interpreter_memory, [](const char *, int32_t val) {
   glow::runtime::flags::InterpreterMemory = val;
   return true;
 });
+DEFINE_int32(glow_interpreter_intra_op_threads,
+             glow::runtime::flags::InterpreterIntraOpThreads,
+             "Number of threads large Interpreter kernels may split work "
+             "across");
+DEFINE_validator(glow_interpreter_intra_op_threads,
+                 [](const char *, int32_t val) {
+                   if (val <= 0) {
+                     return false;
+                   }
+                   glow::runtime::flags::InterpreterIntraOpThreads = val;
+                   return true;
+                 });
 DEFINE_int32(glow_cpu_memory, glow::runtime::flags::CPUMemory,
              "Amount of DRAM to allocate per CPU in KiB");
 DEFINE_validator(glow_cpu_memory, [](const char *, int32_t val) {
   glow::runtime::flags::CPUMemory = val;
   return true;
 });
+DEFINE_int32(glow_cpu_intra_op_threads,
+             glow::runtime::flags::CPUIntraOpThreads,
+             "Default number of threads CPU kernels may split work across");
+DEFINE_validator(glow_cpu_intra_op_threads, [](const char *, int32_t val) {
+  if (val <= 0) {
+    return false;
+  }
+  glow::runtime::flags::CPUIntraOpThreads = val;
+  return true;
+});
+DEFINE_int32(glow_cpu_device_threads, glow::runtime::flags::CPUDeviceThreads,
+             "Number of concurrent execution threads per CPU device");
+DEFINE_validator(glow_cpu_device_threads, [](const char *, int32_t val) {
+  if (val <= 0) {
+    return false;
+  }
+  glow::runtime::flags::CPUDeviceThreads = val;
+  return true;
+});
+DEFINE_bool(glow_cpu_winograd_conv, glow::runtime::flags::CPUWinogradConv,
+            "Run eligible 3x3 stride-1 float convolutions on CPU with "
+            "Winograd F(4x4, 3x3)");
+DEFINE_validator(glow_cpu_winograd_conv, [](const char *, bool val) {
+  glow::runtime::flags::CPUWinogradConv = val;
+  return true;
+});
+DEFINE_bool(glow_cpu_im2col_conv, glow::runtime::flags::CPUIm2ColConv,
+            "Run eligible float convolutions on CPU as an im2col matrix "
+            "product");
+DEFINE_validator(glow_cpu_im2col_conv, [](const char *, bool val) {
+  glow::runtime::flags::CPUIm2ColConv = val;
+  return true;
+});
+DEFINE_int32(glow_cpu_split_cache_bytes,
+             glow::runtime::flags::CPUSplitCacheBytes,
+             "Split the convolutions and pools on CPU, along the batch and "
+             "the height, in chunks whose operands fit in this many bytes, "
+             "e.g. the L2 cache size. 0 to disable.");
+DEFINE_validator(glow_cpu_split_cache_bytes, [](const char *, int32_t val) {
+  if (val < 0) {
+    return false;
+  }
+  glow::runtime::flags::CPUSplitCacheBytes = val;
+  return true;
+});
+DEFINE_int32(glow_cpu_sparse_fc_min_zero_blocks_percent,
+             glow::runtime::flags::CPUSparseFCMinZeroBlocksPercent,
+             "Run the float FullyConnected on CPU whose constant weights have "
+             "at least this percentage of all-zero 1x8 blocks with a "
+             "block-sparse kernel. 0 to disable.");
+DEFINE_validator(glow_cpu_sparse_fc_min_zero_blocks_percent,
+                 [](const char *, int32_t val) {
+                   if (val < 0 || val > 100) {
+                     return false;
+                   }
+                   glow::runtime::flags::CPUSparseFCMinZeroBlocksPercent = val;
+                   return true;
+                 });
+DEFINE_int32(glow_cpu_row_alignment_bytes,
+             glow::runtime::flags::CPURowAlignmentBytes,
+             "Row alignment in bytes of the tables of IntNBitSplitEmbedding "
+             "bags on CPU.");
+DEFINE_validator(glow_cpu_row_alignment_bytes, [](const char *, int32_t val) {
+  if (val < 1 || (val & (val - 1))) {
+    return false;
+  }
+  glow::runtime::flags::CPURowAlignmentBytes = val;
+  return true;
+});
+DEFINE_string(glow_cpu_memory_planner, glow::runtime::flags::CPUMemoryPlanner,
+              "Strategy placing the activations on CPU: livesize, "
+              "greedy-by-size, best-fit or search.");
+DEFINE_validator(glow_cpu_memory_planner,
+                 [](const char *, const std::string &val) {
+                   if (val != "livesize" && val != "greedy-by-size" &&
+                       val != "best-fit" && val != "search") {
+                     return false;
+                   }
+                   glow::runtime::flags::CPUMemoryPlanner = val;
+                   return true;
+                 });
+DEFINE_uint64(glow_cpu_huge_page_constants_bytes,
+              glow::runtime::flags::CPUHugePageConstantsBytes,
+              "Minimum size in bytes of the constant weights of a CPU network "
+              "placed on huge pages, 0 to keep them on regular pages");
+DEFINE_validator(glow_cpu_huge_page_constants_bytes,
+                 [](const char *, uint64_t val) {
+                   glow::runtime::flags::CPUHugePageConstantsBytes = val;
+                   return true;
+                 });
+DEFINE_bool(glow_cpu_explicit_huge_pages,
+            glow::runtime::flags::CPUExplicitHugePages,
+            "Place the CPU constant weights on the reserved huge pages of the "
+            "system when there are enough, else on transparent huge pages");
+DEFINE_validator(glow_cpu_explicit_huge_pages, [](const char *, bool val) {
+  glow::runtime::flags::CPUExplicitHugePages = val;
+  return true;
+});
+DEFINE_int32(glow_cpu_constants_numa_node,
+             glow::runtime::flags::CPUConstantsNumaNode,
+             "NUMA node the constant weights of the CPU devices are bound to, "
+             "-1 for no binding. Overridden by the numaNode device parameter.");
+DEFINE_validator(glow_cpu_constants_numa_node, [](const char *, int32_t val) {
+  if (val < -1) {
+    return false;
+  }
+  glow::runtime::flags::CPUConstantsNumaNode = val;
+  return true;
+});
 
 DEFINE_int32(glow_habana_memory, glow::runtime::flags::HabanaMemory,
              "Amount of DRAM to allocate per Habana device in KiB");
@@ -748,10 +965,36 @@ DEFINE_validator(glow_habana_memory, [](const char *, int32_t val) {
   return true;
 });
 
+DEFINE_int32(glow_habana_runners, glow::runtime::flags::HabanaRunners,
+             "Number of threads enqueueing the runs of each Habana device");
+DEFINE_validator(glow_habana_runners, [](const char *, int32_t val) {
+  if (val <= 0) {
+    return false;
+  }
+  glow::runtime::flags::HabanaRunners = val;
+  return true;
+});
+
+DEFINE_int32(glow_habana_waiters, glow::runtime::flags::HabanaWaiters,
+             "Number of threads waiting for the runs of each Habana device "
+             "and copying their outputs");
+DEFINE_validator(glow_habana_waiters, [](const char *, int32_t val) {
+  if (val <= 0) {
+    return false;
+  }
+  glow::runtime::flags::HabanaWaiters = val;
+  return true;
+});
+
 DEFINE_int32(
     glow_num_compilation_threads, glow::runtime::flags::NumCompilationThreads,
-    "Maximum number of threads to spawn per call to Backend::compileFunctions");
+    "Maximum number of threads used to compile partitions in parallel, "
+    "shared by all backends in a Provisioner and also used per call to "
+    "Backend::compileFunctions");
 DEFINE_validator(glow_num_compilation_threads, [](const char *, int32_t val) {
+  if (val <= 0) {
+    return false;
+  }
   glow::runtime::flags::NumCompilationThreads = val;
   return true;
 });
@@ -774,6 +1017,13 @@ DEFINE_validator(glow_enable_drt, [](const char *, bool val) {
   glow::runtime::flags::EnableDRT = val;
   return true;
 });
+DEFINE_bool(glow_drt_prefetch_inputs, glow::runtime::flags::DRTPrefetchInputs,
+            "With device resident tensors, transfer the inputs of later "
+            "partitions to their devices while earlier partitions run");
+DEFINE_validator(glow_drt_prefetch_inputs, [](const char *, bool val) {
+  glow::runtime::flags::DRTPrefetchInputs = val;
+  return true;
+});
 DEFINE_int32(glow_device_init_timeout_ms,
              glow::runtime::flags::DeviceInitTimeoutMs,
              "Timeout threshold for device initialization in milliseconds. "
@@ -792,6 +1042,36 @@ DEFINE_validator(glow_partition_big_table_threshold_bytes,
                    glow::runtime::flags::BigTableThresholdBytes = val;
                    return true;
                  });
+DEFINE_uint64(glow_llvm_run_buffer_cache_bytes,
+              glow::runtime::flags::LLVMRunBufferCacheBytes,
+              "Maximum bytes of activations and mutable weights buffers each "
+              "LLVM compiled function keeps for reuse across runs");
+DEFINE_validator(glow_llvm_run_buffer_cache_bytes,
+                 [](const char *, uint64_t val) {
+                   glow::runtime::flags::LLVMRunBufferCacheBytes = val;
+                   return true;
+                 });
+DEFINE_string(glow_compiled_function_cache_dir,
+              glow::runtime::flags::CompiledFunctionCacheDir,
+              "Directory used to persist compiled functions across process "
+              "restarts. Empty disables the cache");
+DEFINE_validator(glow_compiled_function_cache_dir,
+                 [](const char *, const std::string &val) {
+                   glow::runtime::flags::CompiledFunctionCacheDir = val;
+                   return true;
+                 });
+DEFINE_int32(glow_deferred_weights_in_flight,
+             glow::runtime::flags::DeferredWeightsInFlight,
+             "Maximum number of deferred weights being transferred to the "
+             "devices while the next ones are loaded");
+DEFINE_validator(glow_deferred_weights_in_flight,
+                 [](const char *, int32_t val) {
+                   if (val < 1) {
+                     return false;
+                   }
+                   glow::runtime::flags::DeferredWeightsInFlight = val;
+                   return true;
+                 });
 DEFINE_int32(glow_enable_sanitize_inputs,
              glow::runtime::flags::SanitizeInputsPercent,
              "Sanitize a percentage of inferences");
@@ -803,6 +1083,30 @@ DEFINE_validator(glow_enable_sanitize_inputs, [](const char *, int32_t val) {
   glow::runtime::flags::SanitizeInputsPercent = val;
   return true;
 });
+DEFINE_int32(glow_sanitize_inputs_tables,
+             glow::runtime::flags::SanitizeInputsTables,
+             "Number of tables sanitized per sanitized inference, 0 for all");
+DEFINE_validator(glow_sanitize_inputs_tables, [](const char *, int32_t val) {
+  if (val < 0) {
+    return false;
+  }
+
+  glow::runtime::flags::SanitizeInputsTables = val;
+  return true;
+});
+DEFINE_int32(glow_dedup_inputs_min_percent,
+             glow::runtime::flags::DedupInputsMinPercent,
+             "Deduplicate the indices of weighted SLS inputs when at least "
+             "this percentage of them are duplicates, 0 to disable");
+DEFINE_validator(glow_dedup_inputs_min_percent,
+                 [](const char *, int32_t val) {
+                   if (val < 0 || val > 100) {
+                     return false;
+                   }
+
+                   glow::runtime::flags::DedupInputsMinPercent = val;
+                   return true;
+                 });
 
 DEFINE_bool(glow_dump_partition, glow::flags::DumpPartition,
             "Enable dumping the graph of each partition");
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Graph/ConstantPayloadStore.h"
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <cstring>
+
+using namespace glow;
+
+ConstantPayloadStore &ConstantPayloadStore::get() {
+  static ConstantPayloadStore store;
+  return store;
+}
+
+/// \returns the bytes of the payload \p T.
+static llvm::StringRef getBytes(const Tensor &T) {
+  return llvm::StringRef(T.getUnsafePtr(), T.getSizeInBytes());
+}
+
+std::shared_ptr<const Tensor> ConstantPayloadStore::intern(Tensor &&T) {
+  assert(!T.isUnowned() && "Only owned payloads can be stored");
+  llvm::StringRef bytes = getBytes(T);
+  size_t hash = llvm::hash_value(bytes);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto range = payloads_.equal_range(hash);
+  for (auto it = range.first; it != range.second;) {
+    auto payload = it->second.lock();
+    if (!payload) {
+      // No Constant refers to this payload anymore.
+      it = payloads_.erase(it);
+      continue;
+    }
+    if (getBytes(*payload) == bytes) {
+      return payload;
+    }
+    ++it;
+  }
+
+  std::shared_ptr<const Tensor> payload(new Tensor(std::move(T)));
+  payloads_.emplace(hash, payload);
+  return payload;
+}
+
+size_t ConstantPayloadStore::getNumPayloads() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t count = 0;
+  for (auto it = payloads_.begin(); it != payloads_.end();) {
+    if (it->second.expired()) {
+      it = payloads_.erase(it);
+    } else {
+      ++count;
+      ++it;
+    }
+  }
+  return count;
+}
@@ -70,12 +70,18 @@ FXIRWrapper::getInputNodeName(const FXNode &node, bool optional,
 }
 
 const void *FXIRWrapper::getConstant(llvm::StringRef name) {
+  // Look the name up once when it is the name of a Constant already, which is
+  // the common case.
+  auto it = constants_.find(name);
+  if (it != constants_.end()) {
+    return it->second;
+  }
   const char *baseName = getConstantName(name);
   if (!baseName) {
     return nullptr;
   }
   // There must be a constant with name baseName, so return it.
-  auto it = constants_.find(baseName);
+  it = constants_.find(baseName);
   CHECK(it != constants_.end())
       << "Should have found constant with name " << baseName;
   return it->second;
@@ -26,6 +26,9 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <cmath>
+#include <unordered_set>
+
 using namespace glow;
 
 using llvm::cast;
@@ -51,6 +54,141 @@ NodeValue GraphGradMapper::getGradient(NodeValue activation) {
   return map_[activation];
 }
 
+bool glow::isRecomputedNode(const Node &N) {
+  // Lowering derives the names of the new nodes from the lowered one, so the
+  // marker survives it.
+  return N.getName().find("_recompute") != llvm::StringRef::npos;
+}
+
+//===----------------------------------------------------------------------===//
+//        Activation checkpointing.
+//===----------------------------------------------------------------------===//
+
+/// \returns true if the forward node \p N can be computed a second time for
+/// the backward pass and give the same results.
+static bool canRecompute(const Node *N) {
+  return !isa<Storage>(N) && !N->hasSideEffects() && !isa<TouchNode>(N);
+}
+
+/// \returns the checkpoints among \p activations, the forward values read by
+/// the backward pass in post order. Activations which can't be recomputed are
+/// always checkpoints. The others are split into segments of about the same
+/// size, and the last value of each segment is a checkpoint, so that at most
+/// one segment is recomputed at a time. The number of segments is given by
+/// the memory budget of \p conf, or is the square root of the number of
+/// activations if there is none.
+static std::unordered_set<NodeValue>
+selectCheckpoints(llvm::ArrayRef<NodeValue> activations,
+                  const TrainingConfig &conf) {
+  std::unordered_set<NodeValue> checkpoints;
+  if (activations.empty()) {
+    return checkpoints;
+  }
+  uint64_t totalBytes = 0;
+  for (const NodeValue &V : activations) {
+    totalBytes += V.getType()->getSizeInBytes();
+  }
+  uint64_t budget = conf.checkpointMemoryBudget;
+  if (budget >= totalBytes) {
+    checkpoints.insert(activations.begin(), activations.end());
+    return checkpoints;
+  }
+
+  uint64_t numCheckpoints =
+      budget ? budget * activations.size() / totalBytes
+             : uint64_t(std::lround(std::sqrt(double(activations.size()))));
+  uint64_t segmentBytes = totalBytes / (numCheckpoints + 1);
+  uint64_t keptBytes = 0;
+  uint64_t curSegment = 0;
+  for (const NodeValue &V : activations) {
+    uint64_t bytes = V.getType()->getSizeInBytes();
+    if (!canRecompute(V.getNode())) {
+      checkpoints.insert(V);
+      keptBytes += bytes;
+      continue;
+    }
+    curSegment += bytes;
+    if (curSegment >= segmentBytes &&
+        (!budget || keptBytes + bytes <= budget)) {
+      checkpoints.insert(V);
+      keptBytes += bytes;
+      curSegment = 0;
+    }
+  }
+  return checkpoints;
+}
+
+/// \returns the value to use in place of the forward value \p V in the
+/// backward pass of \p G: \p V itself if it is a checkpoint or can't be
+/// recomputed, and a copy of it computed from the nearest checkpoints
+/// otherwise. The nodes of the forward pass are \p forward, and \p clones
+/// maps them to the copies already created.
+static NodeValue
+getRecomputedValue(Function *G, NodeValue V,
+                   const std::unordered_set<Node *> &forward,
+                   const std::unordered_set<NodeValue> &checkpoints,
+                   std::unordered_map<Node *, Node *> &clones) {
+  Node *N = V.getNode();
+  if (!forward.count(N) || !canRecompute(N) || checkpoints.count(V)) {
+    return V;
+  }
+  auto it = clones.find(N);
+  if (it == clones.end()) {
+    Node *C = N->clone();
+    C->setName(DECORATE_NODE_NAME(N, "recompute"));
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      C->setNthInput(i, getRecomputedValue(G, N->getNthInput(i), forward,
+                                           checkpoints, clones));
+    }
+    G->addNode(C);
+    it = clones.insert({N, C}).first;
+  }
+  return NodeValue(it->second, V.getResNo());
+}
+
+/// Makes the backward pass of \p G read only checkpointed activations of the
+/// forward pass made of the nodes \p nodes, in post order, and recompute the
+/// other activations it needs. The checkpoints are picked under the memory
+/// budget of \p conf.
+static void recomputeActivations(Function *G, const TrainingConfig &conf,
+                                 llvm::ArrayRef<Node *> nodes) {
+  std::unordered_set<Node *> forward(nodes.begin(), nodes.end());
+  std::vector<Node *> backward;
+  for (auto &N : G->getNodes()) {
+    if (!forward.count(&N)) {
+      backward.push_back(&N);
+    }
+  }
+
+  // Collect the activations read by the backward pass, in post order.
+  std::unordered_set<NodeValue> used;
+  for (Node *N : backward) {
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      NodeValue V = N->getNthInput(i);
+      if (forward.count(V.getNode()) && !isa<Storage>(V.getNode())) {
+        used.insert(V);
+      }
+    }
+  }
+  std::vector<NodeValue> activations;
+  for (Node *N : nodes) {
+    for (unsigned i = 0, e = N->getNumResults(); i < e; i++) {
+      if (used.count(NodeValue(N, i))) {
+        activations.push_back(NodeValue(N, i));
+      }
+    }
+  }
+
+  auto checkpoints = selectCheckpoints(activations, conf);
+  std::unordered_map<Node *, Node *> clones;
+  for (Node *N : backward) {
+    for (unsigned i = 0, e = N->getNumInputs(); i < e; i++) {
+      N->setNthInput(i, getRecomputedValue(G, N->getNthInput(i), forward,
+                                           checkpoints, clones));
+    }
+  }
+}
+
 //===----------------------------------------------------------------------===//
 //        Code for automatically generating the back propagation code.
 //===----------------------------------------------------------------------===//
@@ -488,6 +626,10 @@ Function *glow::differentiate(Function *F, const TrainingConfig &conf,
     G->addNode(I);
   }
 
+  if (conf.checkpointActivations) {
+    recomputeActivations(G, conf, nodes);
+  }
+
   return G;
 }
 
@@ -36,7 +36,9 @@
 #include <corecrt_math_defines.h>
 #endif
 #include <float.h>
+#include <atomic>
 #include <fstream>
+#include <thread>
 #include <unordered_set>
 
 using namespace glow;
@@ -1246,6 +1248,43 @@ Function::createRowwiseQuantizedFullyConnected(llvm::StringRef name,
       name, outTy, input, qWeights, scales, offsets, B));
 }
 
+Int4GroupwiseQuantizedFullyConnectedNode *
+Function::createInt4GroupwiseQuantizedFullyConnected(
+    llvm::StringRef name, NodeValue input, NodeValue W, NodeValue scales,
+    NodeValue offsets, NodeValue B, unsigned_t groupSize) {
+  auto OT = getParent()->uniqueTypeWithNewShape(
+      input.getType(), {input.dims()[0], W.dims()[0]});
+  return addNode(new Int4GroupwiseQuantizedFullyConnectedNode(
+      name, OT, input, W, scales, offsets, B, groupSize));
+}
+
+Int4GroupwiseQuantizedFullyConnectedNode *
+Function::createInt4GroupwiseQuantizedFullyConnected(llvm::StringRef name,
+                                                     NodeValue input,
+                                                     Constant *W, NodeValue B,
+                                                     unsigned_t groupSize) {
+  // The weights are quantized along the input dimension, which is the rows
+  // of the FullyConnected weights.
+  Tensor wt;
+  W->getPayload().transpose(&wt, {1, 0});
+  const dim_t numRows = wt.dims()[0];
+  const dim_t numCols = wt.dims()[1];
+  const dim_t numGroups = (numCols + groupSize - 1) / groupSize;
+
+  auto *qWeights = getParent()->createConstant(
+      ElemKind::UInt8ITy, {numRows, (numCols + 1) / 2}, "weights.i4gqfc");
+  auto *scales = getParent()->createConstant(
+      ElemKind::Float16Ty, {numRows, numGroups}, "scales.i4gqfc");
+  auto *offsets = getParent()->createConstant(
+      ElemKind::Float16Ty, {numRows, numGroups}, "offsets.i4gqfc");
+  quantization::tensorInt4GroupwiseQuantization(
+      wt, qWeights->getPayloadMutable(), scales->getPayloadMutable(),
+      offsets->getPayloadMutable(), groupSize);
+
+  return createInt4GroupwiseQuantizedFullyConnected(
+      name, input, qWeights, scales, offsets, B, groupSize);
+}
+
 ReluNode *Function::createRelu(llvm::StringRef name, TypeRef outTy,
                                NodeValue input) {
   return addNode(new ReluNode(name, outTy, input));
@@ -2154,6 +2193,15 @@ BatchMatMulNode *Function::createBatchMatMul(llvm::StringRef name,
   return addNode(new BatchMatMulNode(name, OT, LHS, RHS));
 }
 
+ScaledDotProductAttentionNode *Function::createScaledDotProductAttention(
+    llvm::StringRef name, NodeValue query, NodeValue key, NodeValue value,
+    NodeValue mask, float scale) {
+  auto OT = getParent()->uniqueTypeWithNewShape(
+      value.getType(), {query.dims()[0], query.dims()[1], value.dims()[2]});
+  return addNode(new ScaledDotProductAttentionNode(name, OT, query, key, value,
+                                                   mask, scale));
+}
+
 BatchedReduceAddNode *
 Function::createBatchedReduceAdd(llvm::StringRef name, TypeRef outTy,
                                  NodeValue batch,
@@ -2588,6 +2636,37 @@ Function::createFusedRowwiseQuantizedSparseLengthsSum(
       avgLength);
 }
 
+ProductQuantizedSparseLengthsWeightedSumNode *
+Function::createProductQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, NodeValue codes, NodeValue codebooks,
+    NodeValue weights, NodeValue indices, NodeValue lengths) {
+  auto outTy = getParent()->uniqueType(
+      ElemKind::FloatTy,
+      {lengths.dims()[0], codebooks.dims()[0] * codebooks.dims()[2]});
+  return addNode(new ProductQuantizedSparseLengthsWeightedSumNode(
+      name, outTy, codes, codebooks, weights, indices, lengths));
+}
+
+ProductQuantizedSparseLengthsWeightedSumNode *
+Function::createProductQuantizedSparseLengthsWeightedSum(
+    llvm::StringRef name, Tensor &data, unsigned_t numSubspaces,
+    NodeValue weights, NodeValue indices, NodeValue lengths,
+    unsigned_t numCentroids) {
+  const dim_t numRows = data.dims()[0];
+  const dim_t numCols = data.dims()[1];
+  assert(numCols % numSubspaces == 0 &&
+         "Subspaces must divide the rows of the table evenly.");
+  auto *codes = getParent()->createConstant(
+      ElemKind::UInt8ITy, {numRows, numSubspaces}, "codes");
+  auto *codebooks = getParent()->createConstant(
+      ElemKind::FloatTy, {numSubspaces, numCentroids, numCols / numSubspaces},
+      "codebooks");
+  quantization::tensorProductQuantization(data, codes->getPayloadMutable(),
+                                          codebooks->getPayloadMutable());
+  return createProductQuantizedSparseLengthsWeightedSum(
+      name, codes, codebooks, weights, indices, lengths);
+}
+
 EmbeddingNode *Function::createEmbedding(llvm::StringRef name,
                                          NodeValue weights, NodeValue indices,
                                          int32_t padIdx, bool scale,
@@ -2868,6 +2947,35 @@ IntLookupTableNode *Function::createIntSigmoid(llvm::StringRef name,
   return createIntLookupTable(name, input, func, outTy);
 }
 
+IntLookupTableNode *Function::createIntHardSwish(llvm::StringRef name,
+                                                 NodeValue input,
+                                                 TypeRef outTy) {
+  auto func = [](float x) -> float {
+    return x * std::min(std::max(x + 3.0f, 0.0f), 6.0f) / 6.0f;
+  };
+  return createIntLookupTable(name, input, func, outTy);
+}
+
+IntLookupTableNode *Function::createIntGelu(llvm::StringRef name,
+                                            NodeValue input, TypeRef outTy) {
+  auto func = [](float x) -> float {
+    const float alpha = M_2_SQRTPI * M_SQRT1_2;
+    return 0.5f * x * (1.0f + tanhf(alpha * (x + 0.044715f * x * x * x)));
+  };
+  return createIntLookupTable(name, input, func, outTy);
+}
+
+IntLookupTableNode *Function::createIntSwish(llvm::StringRef name,
+                                             NodeValue input, TypeRef outTy) {
+  auto func = [](float x) -> float { return x / (1.0f + expf(-x)); };
+  return createIntLookupTable(name, input, func, outTy);
+}
+
+IntLookupTableNode *Function::createIntErf(llvm::StringRef name,
+                                           NodeValue input, TypeRef outTy) {
+  return createIntLookupTable(name, input, erff, outTy);
+}
+
 TopKNode *Function::createTopK(llvm::StringRef name, NodeValue input,
                                unsigned_t k, ElemKind outIndicesTyKind) {
   auto inDims = input.dims();
@@ -2885,6 +2993,16 @@ TopKNode *Function::createTopK(llvm::StringRef name, NodeValue input,
   return createTopK(name, input, k, ElemKind::Int64ITy);
 }
 
+BeamSearchStepNode *Function::createBeamSearchStep(llvm::StringRef name,
+                                                   NodeValue logits,
+                                                   NodeValue scores,
+                                                   NodeValue state,
+                                                   ElemKind indicesTy) {
+  auto indicesTyRef = getParent()->uniqueType(indicesTy, scores.dims());
+  return addNode(new BeamSearchStepNode(name, scores.getType(), indicesTyRef,
+                                        indicesTyRef, logits, scores, state));
+}
+
 ArgMaxNode *Function::createArgMax(llvm::StringRef name, NodeValue input,
                                    unsigned_t axis, bool keepDims,
                                    ElemKind elemTy) {
@@ -4101,8 +4219,8 @@ std::vector<NodeValue> Function::createSingleDirectionLSTM(
 
     auto lstmUnitNode =
         addNode(new LSTMUnitNode(name("lstm_unit", t), result, C));
-    H = lstmUnitNode->getNthResult(0);
-    C = lstmUnitNode->getNthResult(1);
+    H = lstmUnitNode->getnewH();
+    C = lstmUnitNode->getnewC();
 
     Hs.push_back(
         createReshape(name("H_reshape", t), H, {1, H.dims()[0], H.dims()[1]})
@@ -6051,6 +6169,12 @@ void Module::eraseConstant(ConstList::iterator I) {
   constants_.erase(I);
 }
 
+void Module::shareConstantPayloads() {
+  for (auto *C : constants_) {
+    C->sharePayload();
+  }
+}
+
 void Module::erasePlaceholder(PlaceholderList::iterator I) {
   if (I == placeholders_.end()) {
     return;
@@ -6411,24 +6535,6 @@ Module *Module::clone(Module *M) const {
   return M;
 }
 
-/// \returns True if \p n is a storage node (constant or placeholder) of the
-/// function \p F.
-static bool isGraphStorageNode(Node *n, const Function *F) {
-  auto &vars = F->getParent()->getConstants();
-  auto &placeholders = F->getParent()->getPlaceholders();
-
-  if (Constant *V = dyn_cast<Constant>(n)) {
-    return std::find(vars.begin(), vars.end(), V) != vars.end();
-  }
-
-  if (Placeholder *P = dyn_cast<Placeholder>(n)) {
-    return std::find(placeholders.begin(), placeholders.end(), P) !=
-           placeholders.end();
-  }
-
-  return false;
-}
-
 /// Insert \p node in \p nameToNode and report an error if the insertion fails.
 /// \returns True if \p node was inserted into \p nameToNode. False otherwise.
 /// When true is returned that means that \p nameToNode had no other nodes
@@ -6454,6 +6560,156 @@ insertAndReport(std::unordered_map<std::string, const Node *> &nameToNode,
   return true;
 }
 
+namespace {
+/// The nodes, storage and types of a Function, to check in constant time that
+/// the nodes and types its nodes reference belong to it.
+struct FunctionMembers {
+  std::unordered_set<const Node *> nodes;
+  std::unordered_set<const Node *> storage;
+  std::unordered_set<const Type *> types;
+
+  explicit FunctionMembers(const Function &F) {
+    for (const auto &N : F.getNodes()) {
+      nodes.insert(&N);
+    }
+    for (const auto *C : F.getParent()->getConstants()) {
+      storage.insert(C);
+    }
+    for (const auto *PH : F.getParent()->getPlaceholders()) {
+      storage.insert(PH);
+    }
+    for (const auto &T : F.getParent()->getTypes()) {
+      types.insert(&T);
+    }
+  }
+};
+} // namespace
+
+/// Verifies \p N of \p F on its own: its inputs and users, the types and
+/// volumes of its inputs and results, and the checks of the node itself.
+/// \p members are the members of \p F. \returns true when \p N is valid.
+static bool verifyNodeOfFunction(const Function &F, const Node &N,
+                                 const FunctionMembers &members) {
+  bool isValid = true;
+  // Any node referenced by the node should be part of the Graph. Nodes that
+  // aren't members are compared to the nodes of the Graph one by one.
+  for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+    auto &input = N.getNthInput(idx);
+    // Verify each input of N.
+    isValid &= verifyNodeInput(N, idx);
+    bool foundNode = members.nodes.count(input.getNode()) ||
+                     members.storage.count(input.getNode()) ||
+                     std::find(F.getNodes().begin(), F.getNodes().end(),
+                               *input) != F.getNodes().end();
+    isValid &= expectCompareTrue(
+        "Every node referenced by one of the graph nodes should be part of "
+        "the graph",
+        foundNode, true, &N);
+  }
+
+  // Check that all uses of the node refer to this node.
+  for (const auto &U : N.getUsers()) {
+    isValid &= expectCompareTrue<const Node *>(
+        "All uses of a node should refer to this node", U.get()->getNode(), &N,
+        &N);
+  }
+
+  // Check that all types used by the node belong to the parent module.
+  auto &types = F.getParent()->getTypes();
+  for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
+    auto ty = N.getType(idx);
+    bool foundType = members.types.count(ty) ||
+                     std::find(types.begin(), types.end(), *ty) != types.end();
+    isValid &= expectCompareTrue(
+        "Every type used by one of the graph nodes should be part of "
+        "the graph",
+        foundType, true, &N);
+  }
+
+  // Check that there are no zero volume tensors.
+  for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+    auto dims = N.getNthInput(idx).dims();
+    if (std::find(dims.begin(), dims.end(), 0) != dims.end()) {
+      LOG(ERROR) << "Found 0 volume input in the " << idx << " input to node "
+                 << N.toString() << " with dims " << dims;
+      return false;
+    }
+  }
+  for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
+    auto dims = N.getNthResult(idx).dims();
+    if (std::find(dims.begin(), dims.end(), 0) != dims.end()) {
+      LOG(ERROR) << "Found 0 volume result in the " << idx
+                 << " result from node " << N.toString() << " with dims "
+                 << dims;
+      return false;
+    }
+  }
+
+  isValid &= expectCompareTrue("Node is not linked to the function it belongs",
+                               N.getParent(), &F, &N);
+  isValid &= N.verify();
+  return isValid;
+}
+
+/// Functions with at least this many nodes to verify have them verified on
+/// several threads.
+static constexpr size_t parallelVerifyMinNodes = 4096;
+
+/// Verifies the \p nodes of \p F with verifyNodeOfFunction(), on several
+/// threads when there are many of them. \returns true when they are valid.
+static bool verifyNodesImpl(const Function &F,
+                            llvm::ArrayRef<const Node *> nodes,
+                            const FunctionMembers &members) {
+  size_t numThreads =
+      std::min<size_t>(nodes.size() / parallelVerifyMinNodes + 1,
+                       std::max(1u, std::thread::hardware_concurrency()));
+  if (numThreads <= 1) {
+    bool isValid = true;
+    for (const auto *N : nodes) {
+      isValid &= verifyNodeOfFunction(F, *N, members);
+    }
+    return isValid;
+  }
+  // Nodes only read the graph while verifying themselves.
+  std::atomic<bool> isValid{true};
+  auto verifyRange = [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (!verifyNodeOfFunction(F, *nodes[i], members)) {
+        isValid = false;
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < numThreads; t++) {
+    threads.emplace_back(verifyRange, nodes.size() * t / numThreads,
+                         nodes.size() * (t + 1) / numThreads);
+  }
+  verifyRange(0, nodes.size() / numThreads);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return isValid;
+}
+
+bool Function::verifyNodes(llvm::ArrayRef<const Node *> nodes,
+                           const Backend *backend) const {
+  bool isValid = true;
+  // Same layout requirements as verify().
+  TensorLayoutCommon *TLC = nullptr;
+  if (!backend) {
+    TLC = &CanonicalTensorLayout::getInstance();
+  } else if (backend->getTensorLayoutRequirements().isEnabled()) {
+    TLC = &backend->getTensorLayoutRequirements();
+  }
+  if (TLC && !glow::flags::DisableLayoutVerifying) {
+    for (const auto *N : nodes) {
+      isValid &= verifyLayouts(*N, *TLC);
+    }
+  }
+  isValid &= verifyNodesImpl(*this, nodes, FunctionMembers(*this));
+  return isValid;
+}
+
 bool Function::verify(const Backend *backend) const {
   bool isValid = true;
   // Check if the layout verifying is disabled, which will accept all layout for
@@ -6489,81 +6745,16 @@ bool Function::verify(const Backend *backend) const {
     isValid &= insertAndReport(nameToNode, N, *this);
   }
 
-  // Any node referenced by one of the graph nodes should be part of the
-  // Graph.
-  for (const auto &N : nodes_) {
-    for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
-      auto &input = N.getNthInput(idx);
-      // Verify each input of N.
-      isValid &= verifyNodeInput(N, idx);
-      bool foundNode =
-          std::find(nodes_.begin(), nodes_.end(), *input) != nodes_.end();
-      isValid &= expectCompareTrue(
-          "Every node referenced by one of the graph nodes should be part of "
-          "the graph",
-          foundNode || isGraphStorageNode(input, this), true, &N);
-    }
-  }
-
-  // Check that all uses of each node refer to this node.
+  FunctionMembers members(*this);
+  std::vector<const Node *> nodes;
+  nodes.reserve(nodes_.size());
   for (const auto &N : nodes_) {
-    for (const auto &U : N.getUsers()) {
-      isValid &= expectCompareTrue<const Node *>(
-          "All uses of a node should refer to this node", U.get()->getNode(),
-          &N, &N);
-      ;
-    }
-  }
-
-  // Check that all types used by nodes belong to the parent module.
-  auto &types = getParent()->getTypes();
-  for (const auto &N : nodes_) {
-    for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
-      auto ty = N.getType(idx);
-      bool foundType =
-          std::find(types.begin(), types.end(), *ty) != types.end();
-      isValid &= expectCompareTrue(
-          "Every type used by one of the graph nodes should be part of "
-          "the graph",
-          foundType, true, &N);
-    }
-  }
-
-  // Check that there are no zero volume tensors
-  for (const auto &N : nodes_) {
-    // Check inputs
-    for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
-      auto dims = N.getNthInput(idx).dims();
-      for (auto dim : dims) {
-        if (dim == 0) {
-          LOG(ERROR) << "Found 0 volume input in the " << idx
-                     << " input to node " << N.toString() << " with dims "
-                     << dims;
-          return false;
-        }
-      }
-    }
-
-    // Check results
-    for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
-      auto dims = N.getNthResult(idx).dims();
-      for (auto dim : dims) {
-        if (dim == 0) {
-          LOG(ERROR) << "Found 0 volume result in the " << idx
-                     << " result from node " << N.toString() << " with dims "
-                     << dims;
-          return false;
-        }
-      }
-    }
+    nodes.push_back(&N);
   }
+  isValid &= verifyNodesImpl(*this, nodes, members);
 
   std::unordered_map<const Placeholder *, const Node *> placeholderWrittenTo;
   for (const auto &N : nodes_) {
-    isValid &=
-        expectCompareTrue("Node is not linked to the function it belongs",
-                          N.getParent(), this, &N);
-    isValid &= N.verify();
     // Make sure all the placeholders are at most written once, and that
     // constants are never written to.
     for (size_t idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
@@ -40,6 +40,13 @@ void Node::setType(unsigned idx, TypeRef ty) {
 void Node::setTypeUnsafe(unsigned idx, TypeRef ty) {
   assert(idx < getNumResults() && "Result number does not exist.");
   types_[idx] = ty;
+  markChanged();
+}
+
+void Node::markChanged() {
+  if (parent_) {
+    changeStamp_ = parent_->nextChangeStamp();
+  }
 }
 
 ElemKind Node::getElementType(unsigned resNo) const {
@@ -116,11 +123,34 @@ void Node::visit(Node *parent, NodeWalker *visitor) {
   }
 }
 
+namespace {
+/// The properties of the nodes of every kind, indexed by kind. The kinds of
+/// the instructions and values have empty entries.
+constexpr NodeKindInfo nodeKindInfos[] = {
+#define DEF_INSTR(CLASS, NAME) NodeKindInfo(),
+#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME) DEF_INSTR(CLASS, NAME)
+#define DEF_VALUE(CLASS, NAME) DEF_INSTR(CLASS, NAME)
+#include "glow/AutoGenInstr.def"
+#define DEF_NODE(CLASS, NAME) CLASS::getKindInfo(),
+#include "glow/AutoGenNodes.def"
+};
+} // namespace
+
+const NodeKindInfo &Node::getNodeKindInfo(Kinded::Kind kind) {
+  assert(static_cast<size_t>(kind) < llvm::array_lengthof(nodeKindInfos) &&
+         "Invalid kind");
+  return nodeKindInfos[static_cast<size_t>(kind)];
+}
+
 //===----------------------------------------------------------------------===//
 //                     Debug description methods
 //===----------------------------------------------------------------------===//
 
 unsigned Node::getNumInputs() const {
+  const NodeKindInfo &info = getNodeKindInfo(getKind());
+  if (!info.hasVariadicInputs) {
+    return info.numFixedInputs;
+  }
   switch (getKind()) {
 #define DEF_NODE(CLASS, NAME)                                                  \
   case glow::Kinded::Kind::CLASS##Kind:                                        \
@@ -201,36 +231,15 @@ std::string Node::getOutputName(unsigned idx) const {
 }
 
 bool Node::hasSideEffects() const {
-  switch (getKind()) {
-#define DEF_NODE(CLASS, NAME)                                                  \
-  case glow::Kinded::Kind::CLASS##Kind:                                        \
-    return static_cast<const CLASS *>(this)->hasSideEffects();
-#include "glow/AutoGenNodes.def"
-  default:
-    llvm_unreachable("Unhandled node");
-  }
+  return getNodeKindInfo(getKind()).hasSideEffects;
 }
 
 bool Node::isCanonical() const {
-  switch (getKind()) {
-#define DEF_NODE(CLASS, NAME)                                                  \
-  case glow::Kinded::Kind::CLASS##Kind:                                        \
-    return static_cast<const CLASS *>(this)->isCanonical();
-#include "glow/AutoGenNodes.def"
-  default:
-    llvm_unreachable("Unhandled node");
-  }
+  return getNodeKindInfo(getKind()).isCanonical;
 }
 
 bool Node::isDataParallel() const {
-  switch (getKind()) {
-#define DEF_NODE(CLASS, NAME)                                                  \
-  case glow::Kinded::Kind::CLASS##Kind:                                        \
-    return static_cast<const CLASS *>(this)->isDataParallel();
-#include "glow/AutoGenNodes.def"
-  default:
-    llvm_unreachable("Unhandled node");
-  }
+  return getNodeKindInfo(getKind()).isDataParallel;
 }
 
 // NOTE: This is used in conjunction with assuming the 1st input is LHS, and 2nd
@@ -402,6 +411,7 @@ Function *llvm::ilist_traits<Node>::getContainingFunction() {
 void llvm::ilist_traits<Node>::addNodeToList(Node *node) {
   assert(node->getParent() == nullptr && "Already in a list!");
   node->setParent(getContainingFunction());
+  node->markChanged();
 }
 
 void llvm::ilist_traits<Node>::removeNodeFromList(Node *node) {
@@ -419,6 +429,8 @@ void llvm::ilist_traits<Node>::transferNodesFromList(
     return;
 
   // Update the parent fields in the nodes.
-  for (; first != last; ++first)
+  for (; first != last; ++first) {
     first->setParent(ThisParent);
+    first->markChanged();
+  }
 }
@@ -139,6 +139,7 @@ void NodeHandle::setOperand(Node *v, unsigned resNo) {
 
   if (node_) {
     node_->removeUse(NodeUse(this));
+    node_->markChanged();
     node_ = nullptr;
     resNo_ = 0;
   }
@@ -147,6 +148,10 @@ void NodeHandle::setOperand(Node *v, unsigned resNo) {
     node_ = v;
     resNo_ = resNo;
     v->addUse(NodeUse(this));
+    v->markChanged();
+  }
+  if (parent_) {
+    parent_->markChanged();
   }
 }
 
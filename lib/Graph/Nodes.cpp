@@ -16,6 +16,7 @@
 
 #include "glow/Graph/Nodes.h"
 #include "glow/Base/Type.h"
+#include "glow/Graph/ConstantPayloadStore.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/VerifierHelper.h"
 #include "glow/Support/Support.h"
@@ -31,6 +32,27 @@ llvm::hash_code Constant::getHash() const {
   return llvm::hash_combine(getName(), getType());
 }
 
+llvm::hash_code Constant::getPayloadHash() const {
+  if (!hasPayloadHash_) {
+    const char *data = payload_.getUnsafePtr();
+    llvm::StringRef bytes(data, data ? payload_.getSizeInBytes() : 0);
+    payloadHash_ = llvm::hash_combine(getType(), bytes);
+    hasPayloadHash_ = true;
+  }
+  return payloadHash_;
+}
+
+void Constant::sharePayload() {
+  // Unowned payloads are already held outside of the Constant.
+  if (payload_.isUnowned() || !payload_.getUnsafePtr()) {
+    return;
+  }
+  Type payloadTy = payload_.getType();
+  size_t unpaddedSize = payload_.getUnpaddedSizeInBytes();
+  sharedPayload_ = ConstantPayloadStore::get().intern(std::move(payload_));
+  payload_ = Tensor(sharedPayload_->getUnsafePtr(), &payloadTy, unpaddedSize);
+}
+
 llvm::hash_code Placeholder::getHash() const {
   return llvm::hash_combine(getName());
 }
@@ -128,6 +150,9 @@ std::string Placeholder::getDebugDesc(bool skipUsers) const {
       .addParam("Output", *getType())
       .addParam("Trainable", isTraining())
       .addParam("Static", isStatic());
+  if (!loadShuffle_.empty()) {
+    db.addParam("LoadShuffle", getLoadShuffle());
+  }
   if (!skipUsers) {
     db.addParam("Users", getNumUsers());
   }
@@ -1108,6 +1133,46 @@ bool BatchMatMulNode::verify() const {
   return isValid;
 }
 
+bool ScaledDotProductAttentionNode::verify() const {
+  auto query = getQuery();
+  auto key = getKey();
+  auto value = getValues();
+  auto mask = getMask();
+  auto dest = getResult();
+
+  bool isValid = true;
+  for (auto NV : {query, key, value, mask, dest}) {
+    isValid &= expectCompareTrue("Operands must be 3 dimensional.",
+                                 NV.dims().size(), size_t(3), this);
+  }
+  if (!isValid) {
+    return false;
+  }
+
+  const dim_t N = query.dims()[0];
+  const dim_t Lq = query.dims()[1];
+  const dim_t Lk = key.dims()[1];
+  isValid &= expectCompareTrue("Key must be {N, Lk, D}.", key.dims(),
+                               {N, Lk, query.dims()[2]}, this);
+  isValid &= expectCompareTrue("Value must be {N, Lk, Dv}.", value.dims(),
+                               {N, Lk, value.dims()[2]}, this);
+  isValid &= expectCompareTrue("Result must be {N, Lq, Dv}.", dest.dims(),
+                               {N, Lq, value.dims()[2]}, this);
+  const dim_t scoreDims[] = {N, Lq, Lk};
+  for (size_t i = 0; i < 3; i++) {
+    isValid &= expectCompareTrue(
+        "Mask dimensions must be 1 or those of the scores.",
+        mask.dims()[i] == 1 || mask.dims()[i] == scoreDims[i], true, this);
+  }
+
+  auto elemType = dest.getType()->getElementType();
+  isValid &= checkType(query, elemType, this);
+  isValid &= checkType(key, elemType, this);
+  isValid &= checkType(value, elemType, this);
+  isValid &= checkType(mask, elemType, this);
+  return isValid;
+}
+
 bool SigmoidNode::verify() const {
   return verifyActivation(getInput(), getResult());
 }
@@ -1892,6 +1957,52 @@ bool FusedRowwiseQuantizedSparseLengthsSumNode::verify() const {
       getUseFP16Accumulation());
 }
 
+bool ProductQuantizedSparseLengthsWeightedSumNode::verify() const {
+  NodeValue codes = getCodes();
+  NodeValue codebooks = getCodebooks();
+  NodeValue weights = getWeights();
+  NodeValue indices = getIndices();
+  NodeValue lengths = getLengths();
+  NodeValue result = getResult();
+  bool isValid = checkType(result, ElemKind::FloatTy, this);
+  isValid &= checkType(codes, ElemKind::UInt8ITy, this);
+  isValid &= checkType(codebooks, ElemKind::FloatTy, this);
+  isValid &= checkType(weights, ElemKind::FloatTy, this);
+  isValid &=
+      checkType(indices, {ElemKind::Int64ITy, ElemKind::Int32ITy}, this);
+  isValid &= checkType(lengths, ElemKind::Int32ITy, this);
+  isValid &= expectCompareTrue("Codes must be 2 dimensional",
+                               codes.dims().size(), size_t(2), this);
+  isValid &= expectCompareTrue("Codebooks must be 3 dimensional",
+                               codebooks.dims().size(), size_t(3), this);
+  isValid &= expectCompareTrue("Weights must be a 1D vector",
+                               weights.dims().size(), size_t(1), this);
+  isValid &= expectCompareTrue("Indices must be a 1D vector",
+                               indices.dims().size(), size_t(1), this);
+  isValid &= expectCompareTrue("Lengths must be a 1D vector",
+                               lengths.dims().size(), size_t(1), this);
+  isValid &= expectCompareTrue("Result must be 2 dimensional",
+                               result.dims().size(), size_t(2), this);
+  // Wrap this in isValid to prevent potential segfault if the inputs are
+  // incorrectly shaped.
+  if (!isValid) {
+    return false;
+  }
+  isValid &= expectCompareTrue("Weights and Indices must have the same size",
+                               weights.dims()[0], indices.dims()[0], this);
+  isValid &= expectCompareTrue("Codes must have one code per subspace",
+                               codes.dims()[1], codebooks.dims()[0], this);
+  isValid &= expectCompareTrue("Codes can only address 256 centroids",
+                               codebooks.dims()[1], dim_t(256), this,
+                               CompareOperatorLessEqual<dim_t>());
+  isValid &= expectCompareTrue("Result must have one row per segment",
+                               result.dims()[0], lengths.dims()[0], this);
+  isValid &= expectCompareTrue(
+      "Result rows must be made of the subvectors of all subspaces",
+      result.dims()[1], codebooks.dims()[0] * codebooks.dims()[2], this);
+  return isValid;
+}
+
 bool LengthsToRangesNode::verify() const {
   bool isValid = checkType(getResult(), getLengths().getElementType(), this);
   isValid &= checkType(getLengths(), ElemKind::Int32ITy, this);
@@ -1996,6 +2107,12 @@ bool SGDNode::verify() const {
   return checkSameType(getGradient(), getWeight(), this);
 }
 
+bool FusedSGDNode::verify() const {
+  bool isValid = checkSameType(getGradient(), getWeight(), this);
+  isValid &= checkSameType(getVelocity(), getWeight(), this);
+  return isValid;
+}
+
 bool QuantizationProfileNode::verify() const {
   // Make sure that input tensor is a floating point type.
   bool isValid = checkType(getInput(), ElemKind::FloatTy, this);
@@ -2119,6 +2236,38 @@ bool TopKNode::verify() const {
   return isValid;
 }
 
+bool BeamSearchStepNode::verify() const {
+  NodeValue logits = getLogits();
+  NodeValue scores = getScores();
+  bool isValid = checkType(logits, ElemKind::FloatTy, this);
+  isValid &= expectCompareTrue("Logits must be 2D", logits.dims().size(),
+                               size_t(2), this);
+  isValid &= expectCompareTrue("Scores must be 1D", scores.dims().size(),
+                               size_t(1), this);
+  if (!isValid) {
+    return false;
+  }
+  const dim_t beam = logits.dims()[0];
+  isValid &= checkType(scores, ElemKind::FloatTy, this);
+  isValid &= checkSameType(scores, getNewScores(), this);
+  isValid &= expectCompareTrue("Scores must have a row per beam",
+                               scores.dims()[0], beam, this);
+  isValid &= expectCompareTrue("Logits must have at least one token",
+                               logits.dims()[1], dim_t(0), this,
+                               CompareOperatorGreaterThan<dim_t>());
+  isValid &= checkSameType(getTokens(), getPrevIndices(), this);
+  isValid &= checkType(
+      getTokens(),
+      llvm::ArrayRef<ElemKind>({ElemKind::Int64ITy, ElemKind::Int32ITy}), this);
+  isValid &= checkSameShape(getTokens(), scores, this);
+  isValid &= checkSameType(getState(), getNewState(), this);
+  isValid &= expectCompareTrue("State must have a row per beam",
+                               getState().dims().size() > 0 &&
+                                   getState().dims()[0] == beam,
+                               true, this);
+  return isValid;
+}
+
 bool ArgMaxNode::verify() const {
   bool isValid = true;
 
@@ -2206,6 +2355,56 @@ bool DynamicQuantizedFullyConnectedNode::verify() const {
   return isValid;
 }
 
+bool Int4GroupwiseQuantizedFullyConnectedNode::verify() const {
+  auto src = getInput();
+  auto weights = getWeights();
+  auto scales = getScales();
+  auto offsets = getOffsets();
+  auto bias = getBias();
+  auto dest = getResult();
+  const dim_t groupSize = getGroupSize();
+
+  bool isValid = expectCompareTrue("Inputs should be 2D tensor",
+                                   src.dims().size(), size_t(2), this);
+  isValid &= expectCompareTrue("Weights should be 2D tensor",
+                               weights.dims().size(), size_t(2), this);
+  isValid &= expectCompareTrue("Result should be 2D tensor", dest.dims().size(),
+                               size_t(2), this);
+  isValid &= expectCompareTrue("Bias should be 1D tensor", bias.dims().size(),
+                               size_t(1), this);
+  isValid &=
+      expectCompareTrue("Group size should be positive", groupSize, dim_t(0),
+                        this, CompareOperatorGreaterThan<dim_t>());
+  if (!isValid) {
+    return false;
+  }
+
+  // Groups start at byte boundaries of the packed weights.
+  isValid &= expectCompareTrue("Group size should be even", groupSize % 2,
+                               dim_t(0), this);
+  const dim_t N = dest.dims()[1];
+  const dim_t K = src.dims()[1];
+  const dim_t numGroups = (K + groupSize - 1) / groupSize;
+  isValid &= expectCompareTrue("Mismatch on expected source dimension 0",
+                               src.dims()[0], dest.dims()[0], this);
+  isValid &= expectCompareTrue("Weights must be {N, (K + 1) / 2}",
+                               weights.dims(), {N, (K + 1) / 2}, this);
+  isValid &= expectCompareTrue("Scales must be {N, numGroups}", scales.dims(),
+                               {N, numGroups}, this);
+  isValid &= expectCompareTrue("Offsets must be {N, numGroups}",
+                               offsets.dims(), {N, numGroups}, this);
+  isValid &= expectCompareTrue("Inconsistent bias/dest sizes", bias.dims()[0],
+                               N, this);
+
+  isValid &= checkType(src, ElemKind::FloatTy, this);
+  isValid &= checkType(weights, ElemKind::UInt8ITy, this);
+  isValid &= checkType(scales, ElemKind::Float16Ty, this);
+  isValid &= checkType(offsets, ElemKind::Float16Ty, this);
+  isValid &= checkType(bias, ElemKind::FloatTy, this);
+  isValid &= checkType(dest, ElemKind::FloatTy, this);
+  return isValid;
+}
+
 bool DynamicRowwiseQuantizedFullyConnectedNode::verify() const {
   auto src = getInput();
   auto weights = getWeights();
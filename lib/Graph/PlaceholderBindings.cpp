@@ -134,7 +134,11 @@ void PlaceholderBindings::clear() {
 }
 
 void PlaceholderBindings::erase(Placeholder *P) {
-  auto &T = map_[P];
+  auto it = map_.find(P);
+  if (it == map_.end()) {
+    return;
+  }
+  auto &T = it->second;
   if (auto *tensorPool = T.getOwningPool()) {
     tensorPool->reclaim(std::move(T));
   }
@@ -143,6 +147,7 @@ void PlaceholderBindings::erase(Placeholder *P) {
 
 PlaceholderBindings PlaceholderBindings::clone() const {
   PlaceholderBindings cloned;
+  cloned.map_.reserve(map_.size());
   for (auto &PH : map_) {
     Placeholder *P = PH.first;
     cloned.insert(P, PH.second.clone());
@@ -154,6 +159,7 @@ PlaceholderBindings PlaceholderBindings::clone() const {
 PlaceholderBindings
 PlaceholderBindings::clone(const PlaceholderList &newPHs) const {
   PlaceholderBindings cloned;
+  cloned.map_.reserve(map_.size());
   for (const auto &PH : map_) {
     Placeholder *P = PH.first;
     const Tensor &T = PH.second;
@@ -17,6 +17,7 @@
 #include <ctype.h>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 #include <glog/logging.h>
 
@@ -26,15 +27,41 @@
 
 using namespace glow;
 
+/// Layouts parsed by checkSameLayout. Verification parses the same few
+/// layout strings for every input of every node, so they are parsed once per
+/// thread.
+static thread_local std::unordered_map<std::string, TensorLayoutDescription>
+    parsedLayouts;
+
+/// Maximum number of layouts kept in parsedLayouts.
+static constexpr size_t maxParsedLayouts = 1024;
+
+/// \returns the description parsed from \p str, cached in
+/// parsedLayouts.
+static const TensorLayoutDescription &getParsedLayout(llvm::StringRef str) {
+  auto it = parsedLayouts.find(str.str());
+  if (it == parsedLayouts.end()) {
+    it = parsedLayouts.emplace(str.str(), TensorLayoutDescription(str.str()))
+             .first;
+  }
+  return it->second;
+}
+
 /// Checks if two layout descriptions \p lhs and \p rhs describe the same layout
 /// for a value of the type \p ty \returns true if layouts are the same.
 bool glow::checkSameLayout(llvm::StringRef srcLayoutStr,
                            llvm::StringRef destLayoutStr, TypeRef ty,
                            const Node *parent, const std::string &prefix,
                            const TensorLayoutCommon &TLC, bool verbose) {
-  auto srcLayout = TensorLayoutDescription(srcLayoutStr.str());
-  auto destLayout = TensorLayoutDescription(destLayoutStr.str());
-  // Are layouts literally the same?
+  // Are layouts literally the same? Equal strings parse to the same layout.
+  if (srcLayoutStr == destLayoutStr) {
+    return true;
+  }
+  if (parsedLayouts.size() + 2 > maxParsedLayouts) {
+    parsedLayouts.clear();
+  }
+  const auto &srcLayout = getParsedLayout(srcLayoutStr);
+  const auto &destLayout = getParsedLayout(destLayoutStr);
   if (srcLayout.isSameLayout(destLayout)) {
     return true;
   }
@@ -66,15 +93,22 @@ bool glow::verifyLayouts(const Function &F, TensorLayoutCommon &TLC,
                          bool verbose) {
   bool isValid = true;
   for (const auto &N : F.getNodes()) {
-    for (unsigned idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
-      auto input = N.getNthInput(idx);
-      auto producerLayout =
-          TLC.getNthResultLayoutRequirements(input.getNode(), input.getResNo());
-      auto consumerLayout = TLC.getNthInputLayoutRequirements(&N, idx);
-      std::string inputName = strFormat("input %d", idx);
-      isValid &= checkSameLayout(producerLayout, consumerLayout,
-                                 input.getType(), &N, inputName, TLC, verbose);
-    }
+    isValid &= verifyLayouts(N, TLC, verbose);
+  }
+  return isValid;
+}
+
+bool glow::verifyLayouts(const Node &N, TensorLayoutCommon &TLC,
+                         bool verbose) {
+  bool isValid = true;
+  for (unsigned idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+    auto input = N.getNthInput(idx);
+    auto producerLayout =
+        TLC.getNthResultLayoutRequirements(input.getNode(), input.getResNo());
+    auto consumerLayout = TLC.getNthInputLayoutRequirements(&N, idx);
+    std::string inputName = strFormat("input %d", idx);
+    isValid &= checkSameLayout(producerLayout, consumerLayout, input.getType(),
+                               &N, inputName, TLC, verbose);
   }
   return isValid;
 }
@@ -708,6 +742,8 @@ static bool acceptsAnyInputLayout(const glow::Node *node) {
   case Kinded::Kind::TileNodeKind:
   case Kinded::Kind::InsertTensorNodeKind:
   case Kinded::Kind::SGDNodeKind:
+  case Kinded::Kind::FusedSGDNodeKind:
+  case Kinded::Kind::BeamSearchStepNodeKind:
   case Kinded::Kind::BroadcastNodeKind:
   case Kinded::Kind::GaussianFillNodeKind:
   case Kinded::Kind::SpaceToDepthNodeKind:
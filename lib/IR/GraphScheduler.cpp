@@ -29,9 +29,17 @@ llvm::cl::opt<SchedulerKind> graphScheduler(
                                 "Use ChildMemSizeBased"),
                      clEnumValN(SchedulerKind::TopologicalSortBased,
                                 "topological-sort-based",
-                                "Use TopologicalSortBased")),
+                                "Use TopologicalSortBased"),
+                     clEnumValN(SchedulerKind::PeakMemoryBased,
+                                "peak-memory-based", "Use PeakMemoryBased")),
     llvm::cl::init(SchedulerKind::ChildMemSizeBased),
     llvm::cl::cat(graphSchedulerCat));
+
+llvm::cl::opt<unsigned> graphSchedulerSearchBudget(
+    "graph-scheduler-search-budget",
+    llvm::cl::desc("Maximum number of node executions simulated by the "
+                   "peak-memory-based scheduler"),
+    llvm::cl::init(1 << 24), llvm::cl::cat(graphSchedulerCat));
 } // namespace
 
 namespace glow {
@@ -42,6 +50,9 @@ Scheduler *createScheduler(SchedulerKind schedulerKind, Function &G,
     return new ChildMemSizeBasedScheduler(G, scheduled);
   case SchedulerKind::TopologicalSortBased:
     return new TopologicalSortBasedScheduler(G, scheduled);
+  case SchedulerKind::PeakMemoryBased:
+    return new PeakMemoryBasedScheduler(G, scheduled,
+                                        graphSchedulerSearchBudget);
   }
   llvm_unreachable("unreachable");
 }
@@ -65,7 +76,9 @@ void IRFunction::scheduleGraph(NodesPtrList &Schedule) {
   (void)numVars;
   (void)numPlaceholders;
   std::unique_ptr<Scheduler> scheduler{
-      createScheduler(graphScheduler, *getGraph(), Schedule)};
+      createScheduler(minimizePeakMemory_ ? SchedulerKind::PeakMemoryBased
+                                          : graphScheduler,
+                      *getGraph(), Schedule)};
   scheduler->schedule();
   assert(scheduler->getSchedule().size() ==
              getGraph()->getNodes().size() + numPlaceholders + numVars &&
@@ -28,6 +28,8 @@ enum class SchedulerKind {
   ChildMemSizeBased,
   /// Performs a standard topological search
   TopologicalSortBased,
+  /// Searches for the schedule with the smallest peak activation memory.
+  PeakMemoryBased,
 };
 
 class Scheduler {
@@ -104,6 +106,32 @@ public:
   void schedule() override;
 };
 
+/// This is a scheduler that minimizes the peak size of the activations live
+/// at any point of the schedule over the whole graph, rather than one node's
+/// children at a time. It starts from the best of the schedules of the other
+/// schedulers and of a greedy list scheduling, then moves nodes within their
+/// dependencies as long as the peak and the total live memory do not grow.
+/// The search stops after \p searchBudget simulated node executions.
+class PeakMemoryBasedScheduler : public Scheduler {
+  /// Maximum number of node executions simulated by the search.
+  uint64_t searchBudget_;
+
+public:
+  PeakMemoryBasedScheduler(Function &G, NodesPtrList &Schedule,
+                           uint64_t searchBudget = 1 << 24)
+      : Scheduler(G, Schedule), searchBudget_(searchBudget) {}
+
+  ~PeakMemoryBasedScheduler() override = default;
+
+  void schedule() override;
+};
+
+/// \returns the peak number of bytes of the results of the nodes of \p G live
+/// when executing them in the order of \p schedule. A result is live from the
+/// execution of its node until the execution of its last user in \p G.
+/// Storage nodes are not counted.
+int64_t getSchedulePeakMemory(Function &G, const NodesPtrList &schedule);
+
 Scheduler *createScheduler(SchedulerKind schedulerKind, Function &G,
                            NodesPtrList &scheduled);
 
@@ -51,6 +51,24 @@ bool Instruction::classof(const Value *V) {
   return V->getKind() >= First_Instruction && V->getKind() <= Last_Instruction;
 }
 
+namespace {
+/// The properties of the instructions of every kind, indexed by kind. The
+/// kinds of the values have empty entries and the kinds of the nodes, which
+/// follow those of the instructions, have none.
+constexpr InstrKindInfo instrKindInfos[] = {
+#define DEF_INSTR(CLASS, NAME) CLASS::getKindInfo(),
+#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME) DEF_INSTR(CLASS, NAME)
+#define DEF_VALUE(CLASS, NAME) InstrKindInfo(),
+#include "glow/AutoGenInstr.def"
+};
+} // namespace
+
+const InstrKindInfo &Instruction::getInstrKindInfo(Kinded::Kind kind) {
+  assert(static_cast<size_t>(kind) < llvm::array_lengthof(instrKindInfos) &&
+         "Invalid instruction kind");
+  return instrKindInfos[static_cast<size_t>(kind)];
+}
+
 void Use::setOperand(Value *other) { use_->setOperand(idx_, other); }
 
 InstructionOperand Use::getOperand() { return use_->getOperand(idx_); }
@@ -104,16 +122,7 @@ Instruction::Operand Instruction::getOperand(unsigned idx) const {
 }
 
 unsigned Instruction::getNumFixedOperands() const {
-  switch (getKind()) {
-#define DEF_INSTR(CLASS, NAME)                                                 \
-  case glow::Kinded::Kind::CLASS##Kind:                                        \
-    return static_cast<const CLASS *>(this)->getNumFixedOperands();
-#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME) DEF_INSTR(CLASS, NAME)
-#define DEF_VALUE(CLASS, NAME)
-#include "glow/AutoGenInstr.def"
-  default:
-    llvm_unreachable("Unhandled instruction");
-  }
+  return getInstrKindInfo(getKind()).numFixedOperands;
 }
 
 unsigned Instruction::getNumInputs() const {
@@ -408,39 +417,11 @@ Value *IRFunction::getWeightForNode(const Storage *V) const {
 }
 
 bool Instruction::isCanonical() const {
-  switch (getKind()) {
-  default:
-    llvm_unreachable("Unknown value kind");
-    break;
-#define DEF_INSTR(CLASS, NAME)                                                 \
-  case Kinded::Kind::CLASS##Kind: {                                            \
-    auto *X = llvm::cast<const CLASS>(this);                                   \
-    return X->isCanonical();                                                   \
-    break;                                                                     \
-  }
-#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME) DEF_INSTR(CLASS, NAME)
-#define DEF_VALUE(CLASS, NAME)
-#include "glow/AutoGenInstr.def"
-  }
-  return false;
+  return getInstrKindInfo(getKind()).isCanonical;
 }
 
 bool Instruction::isDataParallel() const {
-  switch (getKind()) {
-  default:
-    llvm_unreachable("Unknown value kind");
-    break;
-#define DEF_INSTR(CLASS, NAME)                                                 \
-  case Kinded::Kind::CLASS##Kind: {                                            \
-    auto *X = llvm::cast<const CLASS>(this);                                   \
-    return X->isDataParallel();                                                \
-    break;                                                                     \
-  }
-#define DEF_BACKEND_SPECIFIC_INSTR(CLASS, NAME) DEF_INSTR(CLASS, NAME)
-#define DEF_VALUE(CLASS, NAME)
-#include "glow/AutoGenInstr.def"
-  }
-  return false;
+  return getInstrKindInfo(getKind()).isDataParallel;
 }
 
 Instruction *Instruction::clone() const {
@@ -141,6 +141,13 @@ dim_t TopKInst::getScratchSize() const {
   return (2 * N * elemSize);
 }
 
+dim_t BeamSearchStepInst::getScratchSize() const {
+  // Allocate enough scratch space to hold the value and index of the B best
+  // candidates.
+  dim_t B = getScores()->dims()[0];
+  return 2 * B * sizeof(int64_t);
+}
+
 dim_t AudioSpectrogramInst::getWinOutScratchSize() const {
   dim_t spectrogramLen = getSpectrogram()->dims()[1];
   dim_t fftLen = (spectrogramLen - 1) * 2;
@@ -154,7 +161,9 @@ dim_t AudioSpectrogramInst::getFftOutScratchSize() const {
 }
 
 dim_t MFCCInst::getScratchSize() const {
-  return getFilterBankCount() * sizeof(float);
+  // The Mel powers and the square roots of a spectrogram window.
+  dim_t spectrogramLen = getSpectrogram()->dims()[1];
+  return (getFilterBankCount() + spectrogramLen) * sizeof(float);
 }
 
 dim_t TFLiteDetectionPostProcessInst::getScratchSize() const {
@@ -176,6 +185,7 @@ dim_t TFLiteDetectionPostProcessInst::getScratchSize() const {
     scratchSize += numBoxes * sizeof(int32_t);
     scratchSize += numBoxes * sizeof(float);
     scratchSize += numBoxes * sizeof(int32_t);
+    scratchSize += 5 * numBoxes * sizeof(float);
   } else {
     // Compute scratch size for fast NMS.
     scratchSize += numBoxes * sizeof(float);
@@ -185,6 +195,7 @@ dim_t TFLiteDetectionPostProcessInst::getScratchSize() const {
     scratchSize += numBoxes * sizeof(int32_t);
     scratchSize += numBoxes * sizeof(float);
     scratchSize += numBoxes * sizeof(int32_t);
+    scratchSize += 5 * numBoxes * sizeof(float);
   }
   return scratchSize;
 }
@@ -0,0 +1,356 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GraphScheduler.h"
+
+#include "glow/Support/Debug.h"
+
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <random>
+
+#define DEBUG_TYPE "graph-scheduler"
+
+namespace glow {
+namespace {
+/// Peak and sum over the schedule of the bytes of live results. Schedules are
+/// compared by peak first, the sum favoring shorter live ranges among
+/// schedules of the same peak.
+using ScheduleCost = std::pair<int64_t, int64_t>;
+
+/// Dependencies and result sizes of the nodes of a function. Nodes are
+/// referred to by their position in the function.
+class ScheduleGraph {
+public:
+  /// Nodes of the function.
+  std::vector<Node *> nodes;
+  /// Position of every node of the function.
+  std::unordered_map<const Node *, unsigned> index;
+  /// Bytes of the results of every node.
+  std::vector<int64_t> resultSize;
+  /// Nodes whose results every node reads, once per use.
+  std::vector<std::vector<unsigned>> dataInputs;
+  /// Number of uses of the results of every node.
+  std::vector<unsigned> numUses;
+  /// Nodes that have to execute before every node.
+  std::vector<std::vector<unsigned>> preds;
+  /// Nodes that have to execute after every node.
+  std::vector<std::vector<unsigned>> succs;
+
+  explicit ScheduleGraph(Function &G) {
+    for (auto &N : G.getNodes()) {
+      index[&N] = nodes.size();
+      nodes.push_back(&N);
+      int64_t size = 0;
+      for (size_t idx = 0, e = N.getNumResults(); idx < e; ++idx) {
+        size += N.getType(idx)->getSizeInBytes();
+      }
+      resultSize.push_back(size);
+    }
+    const size_t n = nodes.size();
+    dataInputs.resize(n);
+    numUses.resize(n);
+    preds.resize(n);
+    succs.resize(n);
+
+    for (unsigned i = 0; i < n; i++) {
+      Node *N = nodes[i];
+      for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+        addDataInput(N->getNthInput(idx).getNode(), i);
+      }
+      if (N->hasPredicate()) {
+        addDataInput(N->getPredicate().getNode(), i);
+      }
+      // Like ChildMemSizeBasedScheduler, run a node mutating one of its
+      // inputs after all the other users of the input in the function.
+      for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+        if (!N->isOverwrittenNthInput(idx)) {
+          continue;
+        }
+        for (NodeUse &use : N->getNthInput(idx).getNode()->getUsers()) {
+          Node *user = use.getUser();
+          if (user != N && user->getParent() == &G) {
+            addEdge(index.at(user), i);
+          }
+        }
+      }
+    }
+  }
+
+  /// \returns the cost of running the nodes in \p order.
+  ScheduleCost evaluate(const std::vector<unsigned> &order) const {
+    std::vector<unsigned> remaining = numUses;
+    int64_t live = 0;
+    ScheduleCost cost{0, 0};
+    for (unsigned i : order) {
+      live += resultSize[i];
+      cost.first = std::max(cost.first, live);
+      for (unsigned input : dataInputs[i]) {
+        if (--remaining[input] == 0) {
+          live -= resultSize[input];
+        }
+      }
+      if (numUses[i] == 0) {
+        live -= resultSize[i];
+      }
+      cost.second += live;
+    }
+    return cost;
+  }
+
+  /// \returns whether \p order runs every node once and after its
+  /// predecessors.
+  bool isValid(const std::vector<unsigned> &order) const {
+    if (order.size() != nodes.size()) {
+      return false;
+    }
+    std::vector<int> pos(nodes.size(), -1);
+    for (unsigned p = 0; p < order.size(); p++) {
+      if (pos[order[p]] != -1) {
+        return false;
+      }
+      pos[order[p]] = p;
+    }
+    for (unsigned i = 0; i < nodes.size(); i++) {
+      for (unsigned pred : preds[i]) {
+        if (pos[pred] >= pos[i]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// \returns the positions of the nodes of \p schedule that belong to the
+  /// function, in the order of \p schedule.
+  std::vector<unsigned> getOrder(const NodesPtrList &schedule) const {
+    std::vector<unsigned> order;
+    for (const Node *N : schedule) {
+      auto it = index.find(N);
+      if (it != index.end()) {
+        order.push_back(it->second);
+      }
+    }
+    return order;
+  }
+
+private:
+  /// Record that node \p i reads the result of \p input, if it is a node of
+  /// the function.
+  void addDataInput(const Node *input, unsigned i) {
+    auto it = index.find(input);
+    if (it == index.end()) {
+      return;
+    }
+    dataInputs[i].push_back(it->second);
+    numUses[it->second]++;
+    addEdge(it->second, i);
+  }
+
+  /// Record that node \p from has to execute before node \p to.
+  void addEdge(unsigned from, unsigned to) {
+    if (std::find(preds[to].begin(), preds[to].end(), from) !=
+        preds[to].end()) {
+      return;
+    }
+    preds[to].push_back(from);
+    succs[from].push_back(to);
+  }
+};
+
+/// \returns a schedule of \p graph built by running at every step, out of the
+/// nodes whose predecessors have all run, the one that grows the live memory
+/// the least. Ties are broken by the position of the nodes in \p priority.
+/// \returns an empty schedule if the dependencies have a cycle.
+std::vector<unsigned> greedySchedule(const ScheduleGraph &graph,
+                                     const std::vector<unsigned> &priority) {
+  const size_t n = graph.nodes.size();
+  std::vector<unsigned> rank(n, n);
+  for (unsigned p = 0; p < priority.size(); p++) {
+    rank[priority[p]] = p;
+  }
+  std::vector<unsigned> numPreds(n);
+  std::vector<unsigned> ready;
+  for (unsigned i = 0; i < n; i++) {
+    numPreds[i] = graph.preds[i].size();
+    if (numPreds[i] == 0) {
+      ready.push_back(i);
+    }
+  }
+  std::vector<unsigned> remaining = graph.numUses;
+  std::vector<unsigned> order;
+  while (!ready.empty()) {
+    size_t best = 0;
+    int64_t bestDelta = 0;
+    for (size_t r = 0; r < ready.size(); r++) {
+      const unsigned i = ready[r];
+      int64_t delta = graph.numUses[i] ? graph.resultSize[i] : 0;
+      for (unsigned input : graph.dataInputs[i]) {
+        if (--remaining[input] == 0) {
+          delta -= graph.resultSize[input];
+        }
+      }
+      for (unsigned input : graph.dataInputs[i]) {
+        remaining[input]++;
+      }
+      if (r == 0 || delta < bestDelta ||
+          (delta == bestDelta && rank[i] < rank[ready[best]])) {
+        best = r;
+        bestDelta = delta;
+      }
+    }
+    const unsigned i = ready[best];
+    ready.erase(ready.begin() + best);
+    order.push_back(i);
+    for (unsigned input : graph.dataInputs[i]) {
+      remaining[input]--;
+    }
+    for (unsigned succ : graph.succs[i]) {
+      if (--numPreds[succ] == 0) {
+        ready.push_back(succ);
+      }
+    }
+  }
+  if (order.size() != n) {
+    order.clear();
+  }
+  return order;
+}
+
+/// Improve \p order, of cost \p cost, by moving random nodes to random
+/// positions between their predecessors and successors, keeping the moves
+/// that do not increase the cost. The search stops after \p budget simulated
+/// node executions, or when no move has decreased the cost for a while.
+void searchSchedule(const ScheduleGraph &graph, std::vector<unsigned> &order,
+                    ScheduleCost &cost, uint64_t budget) {
+  const size_t n = order.size();
+  if (n < 2) {
+    return;
+  }
+  std::vector<unsigned> pos(n);
+  for (unsigned p = 0; p < n; p++) {
+    pos[order[p]] = p;
+  }
+  // Fixed seed, so that the schedule is the same across compilations.
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<unsigned> pickPos(0, n - 1);
+  const size_t maxStaleMoves = 16 * n;
+  for (size_t staleMoves = 0; budget >= n && staleMoves < maxStaleMoves;
+       staleMoves++) {
+    const unsigned from = pickPos(gen);
+    const unsigned i = order[from];
+    unsigned lo = 0;
+    unsigned hi = n - 1;
+    for (unsigned pred : graph.preds[i]) {
+      lo = std::max(lo, pos[pred] + 1);
+    }
+    for (unsigned succ : graph.succs[i]) {
+      hi = std::min(hi, pos[succ] - 1);
+    }
+    if (lo == hi) {
+      continue;
+    }
+    unsigned to = std::uniform_int_distribution<unsigned>(lo, hi - 1)(gen);
+    if (to >= from) {
+      to++;
+    }
+    auto move = [&](unsigned src, unsigned dst) {
+      if (dst < src) {
+        std::rotate(order.begin() + dst, order.begin() + src,
+                    order.begin() + src + 1);
+      } else {
+        std::rotate(order.begin() + src, order.begin() + src + 1,
+                    order.begin() + dst + 1);
+      }
+      for (unsigned p = std::min(src, dst), e = std::max(src, dst); p <= e;
+           p++) {
+        pos[order[p]] = p;
+      }
+    };
+    move(from, to);
+    budget -= n;
+    const ScheduleCost newCost = graph.evaluate(order);
+    if (newCost > cost) {
+      move(to, from);
+      continue;
+    }
+    if (newCost < cost) {
+      staleMoves = 0;
+    }
+    cost = newCost;
+  }
+}
+} // namespace
+
+int64_t getSchedulePeakMemory(Function &G, const NodesPtrList &schedule) {
+  ScheduleGraph graph(G);
+  return graph.evaluate(graph.getOrder(schedule)).first;
+}
+
+void PeakMemoryBasedScheduler::schedule() {
+  ScheduleGraph graph(G_);
+
+  // The schedule of ChildMemSizeBasedScheduler, used as is if the graph has
+  // dependencies this scheduler can not honor.
+  NodesPtrList childMemSizeSchedule = scheduled_;
+  ChildMemSizeBasedScheduler(G_, childMemSizeSchedule).schedule();
+  auto childMemSizeOrder = graph.getOrder(childMemSizeSchedule);
+
+  NodesPtrList topologicalSchedule;
+  TopologicalSortBasedScheduler(G_, topologicalSchedule).schedule();
+  auto topologicalOrder = graph.getOrder(topologicalSchedule);
+
+  std::vector<unsigned> bestOrder;
+  ScheduleCost bestCost;
+  for (auto *order : {&childMemSizeOrder, &topologicalOrder}) {
+    if (!graph.isValid(*order)) {
+      continue;
+    }
+    auto cost = graph.evaluate(*order);
+    DEBUG_GLOW(llvm::dbgs() << "Candidate schedule peak: " << cost.first
+                            << "\n");
+    if (bestOrder.empty() || cost < bestCost) {
+      bestOrder = *order;
+      bestCost = cost;
+    }
+  }
+  auto greedyOrder = greedySchedule(graph, childMemSizeOrder);
+  if (greedyOrder.empty()) {
+    for (Node *N : childMemSizeSchedule) {
+      if (graph.index.count(N)) {
+        scheduled_.push_back(N);
+      }
+    }
+    return;
+  }
+  auto greedyCost = graph.evaluate(greedyOrder);
+  DEBUG_GLOW(llvm::dbgs() << "Greedy schedule peak: " << greedyCost.first
+                          << "\n");
+  if (bestOrder.empty() || greedyCost < bestCost) {
+    bestOrder = std::move(greedyOrder);
+    bestCost = greedyCost;
+  }
+
+  searchSchedule(graph, bestOrder, bestCost, searchBudget_);
+  DEBUG_GLOW(llvm::dbgs() << "Searched schedule peak: " << bestCost.first
+                          << "\n");
+  for (unsigned i : bestOrder) {
+    scheduled_.push_back(graph.nodes[i]);
+  }
+}
+} // namespace glow
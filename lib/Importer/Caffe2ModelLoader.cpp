@@ -2452,62 +2452,76 @@ static Error fillTensor(Tensor &T, ElemKind kind, llvm::ArrayRef<dim_t> dim,
   return Error::success();
 }
 
+/// \returns whether the weight op of type \p typeName is a GivenTensor*Fill
+/// op, whose values only depend on the op, see loadGivenTensorFill.
+static bool isGivenTensorFill(llvm::StringRef typeName) {
+  return typeName == "GivenTensorFill" || typeName == "GivenTensorFp16Fill" ||
+         typeName == "GivenTensorIntFill" || typeName == "GivenTensorInt64Fill";
+}
+
+Error Caffe2ModelLoader::loadGivenTensorFill(const caffe2::OperatorDef &op,
+                                             Tensor &T) {
+  ArgumentDictionaryTy dict = loadArgumentMap(op);
+  const std::string &typeName = op.type();
+  /*
+   * op {
+   *   output: "conv1_w"
+   *   name: ""
+   *   type: "GivenTensorFill"
+   *   arg {
+   *     name: "shape"
+   *     ints: 96
+   *     ints: 3
+   *     ints: 11
+   *     ints: 11
+   *   }
+   *   arg {
+   *     name: "values"
+   *     floats: -0.028315347
+   *     ...
+   *   }
+   * }
+   */
+
+  // Note: Explicitly allow for an empty dim here, representing a scalar value
+  // will be loaded below.
+  std::vector<dim_t> dim;
+  ASSIGN_VALUE_OR_RETURN_ERR(
+      dim, getShape<dim_t>(dict["shape"], /* allowEmptyShape */ true));
+  auto const &values = dict["values"];
+  RETURN_ERR_IF_NOT(
+      op.output_size() == 1,
+      opErrMsg(
+          op, strFormat(
+                  "GivenTensorFill must have exactly 1 output, but found %d ",
+                  op.output_size())));
+  if (typeName == "GivenTensorFill") {
+    RETURN_IF_ERR(
+        fillTensor<float>(T, ElemKind::FloatTy, dim, values->floats()));
+  } else if (typeName == "GivenTensorFp16Fill") {
+    RETURN_IF_ERR(
+        fillTensor<float16_t>(T, ElemKind::Float16Ty, dim, values->floats()));
+  } else if (typeName == "GivenTensorIntFill") {
+    RETURN_IF_ERR(
+        fillTensor<int32_t>(T, ElemKind::Int32ITy, dim, values->ints()));
+  } else if (typeName == "GivenTensorInt64Fill") {
+    RETURN_IF_ERR(
+        fillTensor<int64_t>(T, ElemKind::Int64ITy, dim, values->ints()));
+  } else {
+    return MAKE_ERR(
+        strFormat("Unhandled tensor fill type: %s", typeName.c_str()));
+  }
+  return Error::success();
+}
+
 Error Caffe2ModelLoader::loadWeight(const caffe2::OperatorDef &op) {
   ArgumentDictionaryTy dict = loadArgumentMap(op);
   const std::string &typeName = op.type();
   const std::string &opName = loadOperatorName(op);
   // Load tensors with values:
-  if (typeName == "GivenTensorFill" || typeName == "GivenTensorFp16Fill" ||
-      typeName == "GivenTensorIntFill" || typeName == "GivenTensorInt64Fill") {
-    /*
-     * op {
-     *   output: "conv1_w"
-     *   name: ""
-     *   type: "GivenTensorFill"
-     *   arg {
-     *     name: "shape"
-     *     ints: 96
-     *     ints: 3
-     *     ints: 11
-     *     ints: 11
-     *   }
-     *   arg {
-     *     name: "values"
-     *     floats: -0.028315347
-     *     ...
-     *   }
-     * }
-     */
-
-    // Note: Explicitly allow for an empty dim here, representing a scalar value
-    // will be loaded below.
-    std::vector<dim_t> dim;
-    ASSIGN_VALUE_OR_RETURN_ERR(
-        dim, getShape<dim_t>(dict["shape"], /* allowEmptyShape */ true));
-    auto const &values = dict["values"];
-    RETURN_ERR_IF_NOT(
-        op.output_size() == 1,
-        opErrMsg(
-            op, strFormat(
-                    "GivenTensorFill must have exactly 1 output, but found %d ",
-                    op.output_size())));
+  if (isGivenTensorFill(typeName)) {
     Tensor T;
-    if (typeName == "GivenTensorFill") {
-      RETURN_IF_ERR(
-          fillTensor<float>(T, ElemKind::FloatTy, dim, values->floats()));
-    } else if (typeName == "GivenTensorFp16Fill") {
-      RETURN_IF_ERR(
-          fillTensor<float16_t>(T, ElemKind::Float16Ty, dim, values->floats()));
-    } else if (typeName == "GivenTensorIntFill") {
-      RETURN_IF_ERR(
-          fillTensor<int32_t>(T, ElemKind::Int32ITy, dim, values->ints()));
-    } else if (typeName == "GivenTensorInt64Fill") {
-      RETURN_IF_ERR(
-          fillTensor<int64_t>(T, ElemKind::Int64ITy, dim, values->ints()));
-    } else {
-      return MAKE_ERR(
-          strFormat("Unhandled tensor fill type: %s", typeName.c_str()));
-    }
+    RETURN_IF_ERR(loadGivenTensorFill(op, T));
     RETURN_IF_ERR(createAndRegisterConstant(op.output().Get(0), std::move(T)));
     return Error::success();
   }
@@ -2923,12 +2937,113 @@ Error Caffe2ModelLoader::loadWeight(const caffe2::OperatorDef &op) {
 }
 
 Error Caffe2ModelLoader::loadWeightsFromNet(caffe2::NetDef &net) {
-  for (auto &op : net.op()) {
+  // Fill the tensors of the GivenTensor*Fill ops on the loader threads, then
+  // load all the ops in order, so that the Constants are created in the same
+  // order as when loading serially.
+  std::vector<int> fillOps;
+  for (int i = 0; i < net.op_size(); i++) {
+    if (isGivenTensorFill(net.op(i).type())) {
+      fillOps.push_back(i);
+    }
+  }
+  std::vector<Tensor> tensors(fillOps.size());
+  RETURN_IF_ERR(runLoaderTasks(fillOps.size(), [&](size_t i) {
+    return loadGivenTensorFill(net.op(fillOps[i]), tensors[i]);
+  }));
+
+  size_t nextFill = 0;
+  for (int i = 0; i < net.op_size(); i++) {
+    const auto &op = net.op(i);
+    if (nextFill < fillOps.size() && fillOps[nextFill] == i) {
+      RETURN_IF_ERR(createAndRegisterConstant(op.output().Get(0),
+                                              std::move(tensors[nextFill++])));
+      continue;
+    }
     RETURN_IF_ERR(loadWeight(op));
   }
   return Error::success();
 }
 
+/// Serialized size of the ops of the init net that are parsed before being
+/// loaded, which bounds the memory held by the parsed protos.
+static constexpr size_t weightsChunkBytes = 256 << 20;
+
+Error Caffe2ModelLoader::loadWeightsFromFile(const std::string &filename) {
+  if (filename.find(".pbtxt") != std::string::npos) {
+    caffe2::NetDef weightsDef;
+    ASSIGN_VALUE_OR_RETURN_ERR(weightsDef, loadProtoFile(filename));
+    return loadWeightsFromNet(weightsDef);
+  }
+
+  std::ifstream ff(filename, std::ios::in | std::ios::binary);
+  RETURN_ERR_IF_NOT(ff,
+                    strFormat("Can't find the model or network files for %s",
+                              filename.c_str()));
+  google::protobuf::io::IstreamInputStream filestr(&ff);
+
+  // Ops parsed but not loaded yet, and their serialized size.
+  caffe2::NetDef chunk;
+  size_t chunkBytes = 0;
+  while (true) {
+    // Every field gets its own CodedInputStream, so that only the size of a
+    // single op is bound by the byte limit of the stream. The stream hands
+    // the bytes it buffered but did not read back to the file on destruction.
+    google::protobuf::io::CodedInputStream codedstr(&filestr);
+#if GOOGLE_PROTOBUF_VERSION >= 3002000
+    codedstr.SetTotalBytesLimit(MAX_PROTO_SIZE);
+#else
+    codedstr.SetTotalBytesLimit(MAX_PROTO_SIZE, MAX_PROTO_SIZE);
+#endif
+    const uint32_t tag = codedstr.ReadTag();
+    if (tag == 0) {
+      RETURN_ERR_IF_NOT(codedstr.ConsumedEntireMessage(),
+                        "Failed to parse the network descriptor.");
+      break;
+    }
+
+    // Only the ops of the init net are loaded, skip the other fields.
+    const uint32_t fieldNumber = tag >> 3;
+    const uint32_t wireType = tag & 7;
+    uint64_t value;
+    uint32_t size;
+    bool parsed = false;
+    switch (wireType) {
+    case 0: // Varint.
+      parsed = codedstr.ReadVarint64(&value);
+      break;
+    case 1: // 64-bit.
+      parsed = codedstr.Skip(8);
+      break;
+    case 2: // Length-delimited.
+      if (!codedstr.ReadVarint32(&size)) {
+        break;
+      }
+      if (fieldNumber != caffe2::NetDef::kOpFieldNumber) {
+        parsed = codedstr.Skip(size);
+        break;
+      }
+      {
+        auto limit = codedstr.PushLimit(size);
+        parsed = chunk.add_op()->ParseFromCodedStream(&codedstr);
+        codedstr.PopLimit(limit);
+      }
+      chunkBytes += size;
+      break;
+    case 5: // 32-bit.
+      parsed = codedstr.Skip(4);
+      break;
+    }
+    RETURN_ERR_IF_NOT(parsed, "Failed to parse the network descriptor.");
+
+    if (chunkBytes >= weightsChunkBytes) {
+      RETURN_IF_ERR(loadWeightsFromNet(chunk));
+      chunk.Clear();
+      chunkBytes = 0;
+    }
+  }
+  return loadWeightsFromNet(chunk);
+}
+
 Caffe2ModelLoader::Caffe2ModelLoader(Function &F, Error *errPtr)
     : CommonOperatorLoader({}, {}, &F, errPtr) {
   deleteUnusedConstants();
@@ -2957,10 +3072,7 @@ Caffe2ModelLoader::Caffe2ModelLoader(
     ASSIGN_VALUE_OR_RETURN_ERR(networkDef, loadProtoFile(netDescFilename));
 
     // The caffe2 weights that we are deserializing.
-    caffe2::NetDef weightsDef;
-    ASSIGN_VALUE_OR_RETURN_ERR(weightsDef, loadProtoFile(netWeightFilename));
-
-    RETURN_IF_ERR(loadWeightsFromNet(weightsDef));
+    RETURN_IF_ERR(loadWeightsFromFile(netWeightFilename));
     RETURN_IF_ERR(loadNetwork(networkDef));
 
     // This is to ensure that the same processing done with
@@ -3073,10 +3185,7 @@ Caffe2ModelLoader::Caffe2ModelLoader(const std::string &netDescFilename,
     ASSIGN_VALUE_OR_RETURN_ERR(networkDef, loadProtoFile(netDescFilename));
 
     // The caffe2 weights that we are deserializing.
-    caffe2::NetDef weightsDef;
-    ASSIGN_VALUE_OR_RETURN_ERR(weightsDef, loadProtoFile(netWeightFilename));
-
-    RETURN_IF_ERR(loadWeightsFromNet(weightsDef));
+    RETURN_IF_ERR(loadWeightsFromFile(netWeightFilename));
 
     return initWithModule(networkDef, funNamePrefix, PPC);
   };
@@ -26,6 +26,7 @@
 
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Path.h"
 
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/tokenizer.h"
@@ -878,6 +879,16 @@ ONNXModelLoader::getTensorType(const ONNX_NAMESPACE::TensorProto &in) {
 
   case ONNX_NAMESPACE::TensorProto::UINT8:
   case ONNX_NAMESPACE::TensorProto::INT8:
+    // Like in loadTensor, scale and offset are inputs of the operators when
+    // there is no doc string.
+    if (!in.has_doc_string()) {
+      return Type(in.data_type() == ONNX_NAMESPACE::TensorProto::INT8
+                      ? ElemKind::Int8QTy
+                      : ElemKind::UInt8QTy,
+                  dim, 1 /* scale*/, 0 /* offset*/);
+    }
+    return parseTypeFromDocString(in.doc_string(), dim, useGlowCustomOps_);
+
   case ONNX_NAMESPACE::TensorProto::INT16:
     return parseTypeFromDocString(in.doc_string(), dim, useGlowCustomOps_);
 
@@ -1222,14 +1233,16 @@ ONNXModelLoader::loadProto(const std::string &filename, bool zipMode,
     RETURN_ERR_IF_NOT(
         inputStringPtr == nullptr,
         "OnnxModelLoader load from string for zip mode not supported");
-    ZipReader zip(filename);
-    std::string buffer = zip.getRecord("model");
+    // Map the archive so that the records are parsed in place.
+    ZipReader zip(filename, /* mapFile */ true);
+    llvm::ArrayRef<char> buffer = zip.getRecordView("model");
     // Try to parse as a protocol buffer first.
-    parseNet = MP.ParseFromString(buffer);
+    parseNet = MP.ParseFromArray(buffer.data(), buffer.size());
     // Try to parse a textual representation first.
     if (!parseNet) {
       // If it is not a protocol buffer, try to parse as a text format.
-      parseNet = parser.ParseFromString(buffer, &MP);
+      parseNet = parser.ParseFromString(
+          std::string(buffer.data(), buffer.size()), &MP);
     }
     if (!parseNet) {
       RETURN_ERR_IF_NOT(false, "Failed to parse ModelProto",
@@ -1241,9 +1254,9 @@ ONNXModelLoader::loadProto(const std::string &filename, bool zipMode,
     for (size_t i = 0; i < numWeights; ++i) {
       std::stringstream ss;
       ss << "weight_" << i;
-      buffer = zip.getRecord(ss.str());
+      buffer = zip.getRecordView(ss.str());
       auto *t = MP.mutable_graph()->add_initializer();
-      t->ParseFromString(buffer);
+      t->ParseFromArray(buffer.data(), buffer.size());
     }
     return MP;
   }
@@ -6127,9 +6140,120 @@ Expected<Constant *> ONNXModelLoader::replaySerializedConstFold(
   return runDeserializedConstFold(in.name(), subgraph->output(resNo).name());
 }
 
+Error ONNXModelLoader::loadExternalTensor(const ONNX_NAMESPACE::TensorProto &in,
+                                          Tensor *T) {
+  std::string location;
+  uint64_t offset = 0;
+  uint64_t length = 0;
+  bool hasLength = false;
+  for (const auto &keyVal : in.external_data()) {
+    if (keyVal.key() == "location") {
+      location = keyVal.value();
+    } else if (keyVal.key() == "offset") {
+      RETURN_ERR_IF_NOT(
+          !llvm::StringRef(keyVal.value()).getAsInteger(10, offset),
+          strFormat("Invalid external data offset of %s", in.name().c_str()));
+    } else if (keyVal.key() == "length") {
+      RETURN_ERR_IF_NOT(
+          !llvm::StringRef(keyVal.value()).getAsInteger(10, length),
+          strFormat("Invalid external data length of %s", in.name().c_str()));
+      hasLength = true;
+    }
+  }
+  RETURN_ERR_IF_NOT(!location.empty(),
+                    strFormat("No external data location for %s",
+                              in.name().c_str()),
+                    ErrorValue::ErrorCode::MODEL_LOADER_INVALID_PROTOBUF);
+
+  llvm::SmallString<128> path(externalDataDir_);
+  llvm::sys::path::append(path, location);
+  auto &file = externalDataFiles_[path];
+  if (!file) {
+    // Mapped private, so that passes modifying payloads in place only copy the
+    // pages they write to.
+    auto fileOrErr = llvm::WritableMemoryBuffer::getFile(path);
+    RETURN_ERR_IF_NOT(fileOrErr,
+                      strFormat("Can't open the external data file %s: %s",
+                                path.c_str(),
+                                fileOrErr.getError().message().c_str()),
+                      ErrorValue::ErrorCode::MODEL_LOADER_INVALID_PROTOBUF);
+    file = std::move(*fileOrErr);
+    mod_.addExternalPayloadBuffer(file);
+  }
+
+  Type ty;
+  ASSIGN_VALUE_OR_RETURN_ERR(ty, getTensorType(in));
+  const uint64_t size = hasLength ? length : ty.getSizeInBytes();
+  RETURN_ERR_IF_NOT(offset <= file->getBufferSize() &&
+                        size <= file->getBufferSize() - offset,
+                    strFormat("External data of %s is out of the bounds of %s",
+                              in.name().c_str(), path.c_str()),
+                    ErrorValue::ErrorCode::MODEL_LOADER_INVALID_PROTOBUF);
+
+  char *payload = file->getBufferStart() + offset;
+  const bool hasCustomStrides =
+      in.has_doc_string() && !getStridesFromDocString(in.doc_string()).empty();
+  if (!hasCustomStrides && size == ty.getSizeInBytes() &&
+      reinterpret_cast<uintptr_t>(payload) % ty.getElementSize() == 0) {
+    *T = Tensor(payload, &ty);
+    return Error::success();
+  }
+  return loadTensor(in, T, useGlowCustomOps_, std::string(payload, size));
+}
+
+/// \returns whether the initializer \p in is the result of a constant folding
+/// to replay, see replaySerializedConstFold.
+static bool hasSerializedConstFold(const ONNX_NAMESPACE::TensorProto &in) {
+  for (const auto &keyVal : in.external_data()) {
+    if (keyVal.key() == "ConstFoldNodeName") {
+      return true;
+    }
+  }
+  return false;
+}
+
 Error ONNXModelLoader::loadInitializers(ONNX_NAMESPACE::GraphProto &net) {
+  // Deserialize the payloads of the initializers held in the proto on the
+  // loader threads. Their Constants are still created below in the order of
+  // the initializers.
+  const int numInitializers = net.initializer_size();
+  //
+  // Initializers already loaded by an earlier load of the same model are
+  // taken from their Constants, as long as these still hold their payload.
+  llvm::StringMap<Constant *> sharedConstants;
+  if (sharedConstants_) {
+    llvm::StringMap<Constant *> constantsByName;
+    for (Constant *C : mod_.getConstants()) {
+      constantsByName[C->getName()] = C;
+    }
+    for (const auto &kv : *sharedConstants_) {
+      auto it = constantsByName.find(kv.getValue());
+      if (it != constantsByName.end() &&
+          it->second->getPayload().getUnsafePtr()) {
+        sharedConstants[kv.getKey()] = it->second;
+      }
+    }
+  }
+  std::vector<int> preloaded;
+  if (!loadIntoExistingModule_) {
+    for (int i = 0; i < numInitializers; i++) {
+      const auto &in = net.initializer(i);
+      if (in.data_location() != ONNX_NAMESPACE::TensorProto::EXTERNAL &&
+          !hasSerializedConstFold(in) && !sharedConstants.count(in.name())) {
+        preloaded.push_back(i);
+      }
+    }
+  }
+  std::vector<Tensor> tensors(preloaded.size());
+  RETURN_IF_ERR(runLoaderTasks(preloaded.size(), [&](size_t i) {
+    return loadTensor(net.initializer(preloaded[i]), &tensors[i],
+                      useGlowCustomOps_);
+  }));
+  size_t nextPreloaded = 0;
+
   // Load the network initializers:
-  for (const auto &in : net.initializer()) {
+  for (int i = 0; i < numInitializers; i++) {
+    const auto &in = net.initializer(i);
     // Replay any constant folding that occurred from previous optimization if
     // necessary. foldedC will be left as nullptr if no constant folding occurs.
     Constant *foldedC;
@@ -6142,9 +6266,17 @@ Error ONNXModelLoader::loadInitializers(ONNX_NAMESPACE::GraphProto &net) {
     }
 
     // If we already an existing module then expect to find Constants already
-    // existing for each initializer.
-    if (foldedC || loadIntoExistingModule_) {
-      Constant *C = foldedC ? foldedC : mod_.getConstantByName(in.name());
+    // existing for each initializer. The same goes for the initializers
+    // shared with an earlier load of the model.
+    auto sharedIt = sharedConstants.find(in.name());
+    if (foldedC || sharedIt != sharedConstants.end() ||
+        loadIntoExistingModule_) {
+      Constant *C = foldedC;
+      if (!C) {
+        C = sharedIt != sharedConstants.end()
+                ? sharedIt->second
+                : mod_.getConstantByName(in.name());
+      }
       Type ty;
       ASSIGN_VALUE_OR_RETURN_ERR(ty, getTensorType(in));
 
@@ -6165,8 +6297,19 @@ Error ONNXModelLoader::loadInitializers(ONNX_NAMESPACE::GraphProto &net) {
     // If we are loading into an existing module then we would expect this
     // initializer doesn't have any data associated with it.
     Tensor T;
-    RETURN_IF_ERR(loadTensor(in, &T, useGlowCustomOps_));
+    if (nextPreloaded < preloaded.size() && preloaded[nextPreloaded] == i) {
+      T = std::move(tensors[nextPreloaded++]);
+    } else if (in.data_location() == ONNX_NAMESPACE::TensorProto::EXTERNAL) {
+      RETURN_IF_ERR(loadExternalTensor(in, &T));
+    } else {
+      RETURN_IF_ERR(loadTensor(in, &T, useGlowCustomOps_));
+    }
     RETURN_IF_ERR(createAndRegisterConstant(in.name(), std::move(T), layout));
+    if (sharedConstants_) {
+      if (auto *C = getConstantByNameOrNull(in.name())) {
+        (*sharedConstants_)[in.name()] = C->getName().str();
+      }
+    }
   }
 
   return Error::success();
@@ -6437,6 +6580,8 @@ ONNXModelLoader::ONNXModelLoader(const std::string &modelDescFilename,
     constFoldInLoader_ = false;
   }
 
+  externalDataDir_ = llvm::sys::path::parent_path(modelDescFilename).str();
+
   auto setup = [&]() -> Error {
     ONNX_NAMESPACE::ModelProto modelDef;
     ASSIGN_VALUE_OR_RETURN_ERR(
@@ -6453,6 +6598,33 @@ ONNXModelLoader::ONNXModelLoader(const std::string &modelDescFilename,
   }
 }
 
+ONNXModelLoader::ONNXModelLoader(ONNX_NAMESPACE::ModelProto &modelDef,
+                                 const std::string &modelDescFilename,
+                                 llvm::ArrayRef<const char *> tensorNames,
+                                 llvm::ArrayRef<TypeRef> types, Function &F,
+                                 llvm::StringMap<std::string> &sharedConstants,
+                                 Error *errPtr, const Backend *B)
+    : CommonOperatorLoader(tensorNames, types, &F, errPtr),
+      staticPlaceholderTypes_(nullptr), sharedConstants_(&sharedConstants) {
+  // if errPtr already contains an error then don't continue with constructor
+  if (errPtr && *errPtr) {
+    return;
+  }
+
+  externalDataDir_ = llvm::sys::path::parent_path(modelDescFilename).str();
+
+  auto setup = [&]() -> Error {
+    return loadModel(modelDef, tensorNames, types, B,
+                     /* loadInputsAsPlaceholdersForOnnx */ true);
+  };
+
+  if (errPtr) {
+    *errPtr = setup();
+  } else {
+    EXIT_ON_ERR(setup());
+  }
+}
+
 /// \returns a metadata prop found at \p key in \p modelDef.
 static const char *getMetadataProp(const ONNX_NAMESPACE::ModelProto &modelDef,
                                    llvm::StringRef key) {
@@ -6663,6 +6835,8 @@ ONNXModelLoader::ONNXModelLoader(
     constFoldInLoader_ = false;
   }
 
+  externalDataDir_ = llvm::sys::path::parent_path(modelDescFilename).str();
+
   auto setup = [&]() -> Error {
     ONNX_NAMESPACE::ModelProto modelDef;
     ASSIGN_VALUE_OR_RETURN_ERR(
@@ -6804,3 +6978,43 @@ ONNXModelLoader::ONNXModelLoader(
     EXIT_ON_ERR(setup());
   }
 }
+
+Expected<Function *>
+ONNXModelCache::load(const std::string &modelDescFilename,
+                     llvm::ArrayRef<const char *> tensorNames,
+                     llvm::ArrayRef<TypeRef> types, Module &mod,
+                     llvm::StringRef funName, const Backend *B) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry &entry = entries_[modelDescFilename];
+  if (!entry.modelDef) {
+    ONNX_NAMESPACE::ModelProto modelDef;
+    ASSIGN_VALUE_OR_RETURN_ERR(
+        modelDef, ONNXModelLoader::loadProto(modelDescFilename,
+                                             /* zipMode */ false,
+                                             /* inputStringPtr */ nullptr));
+    entry.modelDef =
+        std::make_unique<ONNX_NAMESPACE::ModelProto>(std::move(modelDef));
+  }
+
+  Function *F = mod.createFunction(funName);
+  Error err(Error::success());
+  ONNXModelLoader loader(*entry.modelDef, modelDescFilename, tensorNames,
+                         types, *F, entry.constants[&mod], &err, B);
+  if (err) {
+    mod.eraseFunction(F);
+    return std::move(err);
+  }
+  return F;
+}
+
+void ONNXModelCache::erase(const Module &mod) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &entry : entries_) {
+    entry.getValue().constants.erase(&mod);
+  }
+}
+
+void ONNXModelCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
@@ -15,8 +15,12 @@
  */
 
 #include "glow/Importer/ProtobufLoader.h"
+#include "glow/Support/ThreadPool.h"
 #include "llvm/Support/CommandLine.h"
+
+#include <atomic>
 #include <string>
+#include <thread>
 
 namespace glow {
 
@@ -28,6 +32,12 @@ static llvm::cl::opt<bool> isConstFoldLoaderOps(
         "Performs constant folding on ONNX and Caffe Operators while loading."),
     llvm::cl::init(true), llvm::cl::cat(loaderOptCat));
 
+static llvm::cl::opt<unsigned> loaderThreads(
+    "loader-threads",
+    llvm::cl::desc("Number of threads deserializing the tensors of the models "
+                   "while loading, 0 for one per hardware thread."),
+    llvm::cl::init(0), llvm::cl::cat(loaderOptCat));
+
 bool isArrayConstant(llvm::ArrayRef<size_t> a) {
   for (size_t i = 1; i < a.size(); i++)
     if (a[0] != a[i])
@@ -39,6 +49,57 @@ void setConstantFoldLoaderOpsFlag(bool flag) { isConstFoldLoaderOps = flag; }
 
 bool getConstantFoldLoaderOpsFlag() { return isConstFoldLoaderOps; }
 
+void setLoaderThreads(unsigned numThreads) { loaderThreads = numThreads; }
+
+Error runLoaderTasks(size_t numTasks,
+                     const std::function<Error(size_t)> &task) {
+  size_t numThreads = loaderThreads ? loaderThreads
+                                    : std::thread::hardware_concurrency();
+  numThreads = std::min(numThreads, numTasks);
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < numTasks; i++) {
+      RETURN_IF_ERR(task(i));
+    }
+    return Error::success();
+  }
+
+  std::vector<Error> errs;
+  errs.reserve(numTasks);
+  for (size_t i = 0; i < numTasks; i++) {
+    errs.emplace_back(Error::empty());
+  }
+  // Tasks are handed out one at a time, as tensors vary a lot in size.
+  std::atomic<size_t> nextTask{0};
+  ThreadPool pool(numThreads, "loader");
+  std::vector<std::future<void>> futures;
+  for (size_t t = 0; t < numThreads; t++) {
+    futures.push_back(pool.submit([&]() {
+      for (size_t i = nextTask++; i < numTasks; i = nextTask++) {
+        errs[i] = task(i);
+      }
+    }));
+  }
+  for (auto &future : futures) {
+    future.wait();
+  }
+
+  Error firstErr = Error::empty();
+  for (auto &err : errs) {
+    if (!err) {
+      continue;
+    }
+    if (!firstErr) {
+      firstErr = std::move(err);
+    } else {
+      ERR_TO_VOID(std::move(err));
+    }
+  }
+  if (firstErr) {
+    return firstErr;
+  }
+  return Error::success();
+}
+
 bool ProtobufLoader::isConstantFoldable(llvm::ArrayRef<NodeValue> inputs,
                                         std::string typeName) const {
   int numInputs = inputs.size();
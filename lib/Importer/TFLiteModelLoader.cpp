@@ -24,9 +24,9 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 
-#include <fstream>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 using namespace glow;
@@ -122,31 +122,24 @@ llvm::cl::opt<std::string> tfliteDumpGraphOpt(
     llvm::cl::init(""), llvm::cl::Optional,
     llvm::cl::cat(tfliteModelLoaderCat));
 
-/// Function to read a TensorFlowLite model from the file \p modelFilename into
-/// the data buffer \p modelData provided by the caller. The \p modelData buffer
-/// is allocated and initialized by this function but the caller must ensure its
-/// existence through the graph loading process. \returns the TensorFlowLite
-/// model object or Error in case something went wrong.
-Expected<const tflite::Model *> readModel(std::vector<char> &modelData,
-                                          const std::string &modelFilename) {
-  // Open file.
-  std::ifstream modelFile;
-  modelFile.open(modelFilename, std::ios::binary);
-  RETURN_ERR_IF_NOT(modelFile.is_open(),
-                    strFormat("TensorFlowLite: Error opening model file '%s'!",
-                              modelFilename.c_str()));
-  // Get model size.
-  modelFile.seekg(0, std::ios::end);
-  std::streamsize modelSize = modelFile.tellg();
-  modelFile.seekg(0, std::ios::beg);
-  // Read model data.
-  modelData = std::vector<char>(modelSize);
-  RETURN_ERR_IF_NOT(modelFile.read(modelData.data(), modelSize),
-                    strFormat("TensorFlowLite: Error reading model file '%s'!",
-                              modelFilename.c_str()));
-  modelFile.close();
+/// Function to map a TensorFlowLite model from the file \p modelFilename into
+/// the data buffer \p modelData provided by the caller. The mapping is private
+/// so that the Constants pointing into it can be modified in place without
+/// modifying the file. The caller must ensure the existence of \p modelData
+/// through the graph loading process. \returns the TensorFlowLite model
+/// object or Error in case something went wrong.
+Expected<const tflite::Model *>
+readModel(std::shared_ptr<llvm::WritableMemoryBuffer> &modelData,
+          const std::string &modelFilename) {
+  auto modelDataOrErr = llvm::WritableMemoryBuffer::getFile(modelFilename);
+  RETURN_ERR_IF_NOT(modelDataOrErr,
+                    strFormat("TensorFlowLite: Error opening model file '%s': "
+                              "%s!",
+                              modelFilename.c_str(),
+                              modelDataOrErr.getError().message().c_str()));
+  modelData = std::move(*modelDataOrErr);
   // Return model object.
-  return tflite::GetModel(modelData.data());
+  return tflite::GetModel(modelData->getBufferStart());
 }
 
 /// Function to convert the UINT8 data from the buffer \p inpPtr to INT8 format
@@ -936,6 +929,10 @@ Error TFLiteModelLoader::loadInputPlaceholders() {
 
 Error TFLiteModelLoader::loadConstants() {
   const auto *tensors = graph_->tensors();
+  // Buffers Constants point into, and whether the module keeps the model
+  // data alive for them.
+  std::unordered_set<uint32_t> mappedBuffers;
+  bool mapped = false;
   for (size_t idx = 0, idxEnd = tensors->size(); idx < idxEnd; ++idx) {
     // Get tensor data and size. A TensorFlowLite model tensor is a constant
     // if it has data stored in the model.
@@ -954,10 +951,26 @@ Error TFLiteModelLoader::loadConstants() {
         strFormat("TensorFlowLite: Tensor '%s' mismatch between shape based "
                   "size (%zu bytes) and actual data size (%lu bytes)!",
                   name.c_str(), type.getSizeInBytes(), dataAndSize.second));
-    Tensor T = Tensor(type);
-    T.copyRawFrom(dataAndSize.first);
+    const bool convertUint8 =
+        tfliteUint8ToInt8Opt && (tensor->type() == tflite::TensorType_UINT8);
+    // Point into the model data instead of copying it, unless the data has to
+    // be converted, is misaligned, or another Constant already points to the
+    // buffer and could see the in place modifications of this one.
+    const auto address = reinterpret_cast<uintptr_t>(dataAndSize.first);
+    Tensor T;
+    if (!convertUint8 && address % type.getElementSize() == 0 &&
+        mappedBuffers.insert(tensor->buffer()).second) {
+      if (!mapped) {
+        mod_.addExternalPayloadBuffer(modelData_);
+        mapped = true;
+      }
+      T = Tensor(const_cast<char *>(dataAndSize.first), &type);
+    } else {
+      T = Tensor(type);
+      T.copyRawFrom(dataAndSize.first);
+    }
     // Convert UINT8 data to INT8 data.
-    if (tfliteUint8ToInt8Opt && (tensor->type() == tflite::TensorType_UINT8)) {
+    if (convertUint8) {
       convertUint8ToInt8(reinterpret_cast<uint8_t *>(T.getUnsafePtr()),
                          reinterpret_cast<int8_t *>(T.getUnsafePtr()),
                          dataAndSize.second);
@@ -3203,8 +3216,7 @@ TFLiteModelLoader::TFLiteModelLoader(const std::string &modelFilename,
     : F_(F), mod_(*F->getParent()) {
   auto setup = [&]() -> Error {
     // Read model.
-    std::vector<char> modelData;
-    ASSIGN_VALUE_OR_RETURN_ERR(model_, readModel(modelData, modelFilename));
+    ASSIGN_VALUE_OR_RETURN_ERR(model_, readModel(modelData_, modelFilename));
 
     // TODO: Verify model integrity using flatbuffers::Verifier class.
 
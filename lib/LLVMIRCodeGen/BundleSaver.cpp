@@ -17,6 +17,7 @@
 #include "glow/LLVMIRCodeGen/BundleSaver.h"
 #include "glow/LLVMIRCodeGen/CommandLine.h"
 #include "glow/LLVMIRCodeGen/LLVMBackend.h"
+#include "glow/LLVMIRCodeGen/WeightsCompression.h"
 
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/PlaceholderBindings.h"
@@ -34,6 +35,7 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <glog/logging.h>
@@ -146,6 +148,55 @@ static const char *staticApiCommonDefines = R"RAW(
 #define GLOW_GET_ADDR(mutableBaseAddr, placeholderOff)  (((uint8_t*)(mutableBaseAddr)) + placeholderOff)
 )RAW";
 
+/// Header file declarations of the parallel runtime, see libjit_parallel.cpp.
+static const char *parallelRuntimeApi = R"RAW(
+#ifndef _GLOW_BUNDLE_PARALLEL_RUNTIME
+#define _GLOW_BUNDLE_PARALLEL_RUNTIME
+// Creates a thread running entry(arg). Returns 0 on success.
+typedef int (*glow_thread_create_t)(void (*entry)(void *), void *arg);
+// Yields the processor to other threads.
+typedef void (*glow_thread_yield_t)(void);
+
+// Starts the intra-op thread pool shared by the bundles of the application,
+// with numThreads threads in total including the thread calling the bundles.
+// The numThreads - 1 workers are created with the create function. The
+// workers spin while waiting for work, calling yield if it is not NULL.
+// Returns 0 on success or the error of create.
+int glow_parallel_runtime_init(unsigned numThreads,
+                               glow_thread_create_t create,
+                               glow_thread_yield_t yield);
+
+// Stops the thread pool. Must not be called while a bundle runs.
+void glow_parallel_runtime_shutdown(void);
+#endif
+)RAW";
+
+static const char *weightsDecompressorApi = R"RAW(
+#ifndef _GLOW_BUNDLE_WEIGHTS_DECOMPRESSOR
+#define _GLOW_BUNDLE_WEIGHTS_DECOMPRESSOR
+// Sizes of the header of the compressed weights file and of the header of
+// each of its blocks (bytes).
+#define GLOW_WEIGHTS_HEADER_SIZE        16
+#define GLOW_WEIGHTS_BLOCK_HEADER_SIZE  24
+
+// Decodes the srcSize bytes of the compressed weights file into constantWeight,
+// a buffer of dstSize bytes. Returns 0 on success.
+int glow_weights_decompress(const uint8_t *src, uint64_t srcSize,
+                            uint8_t *constantWeight, uint64_t dstSize);
+
+// Returns the size of the block starting with the blockHeader bytes, header
+// included, or -1 if it is malformed. Together with the function below it
+// decodes the weights one block at a time, e.g. while streaming them from
+// flash through a buffer of 64 KiB plus a block header.
+int64_t glow_weights_block_size(const uint8_t *blockHeader);
+
+// Decodes a whole block into constantWeight, a buffer of dstSize bytes.
+// Returns 0 on success.
+int glow_weights_decompress_block(const uint8_t *block,
+                                  uint8_t *constantWeight, uint64_t dstSize);
+#endif
+)RAW";
+
 /// Utility function to serialize a binary file to text file as a C array.
 static void serializeBinaryToText(llvm::StringRef binFileName,
                                   llvm::StringRef txtFileName) {
@@ -177,7 +228,20 @@ BundleSaver::BundleSaver(const LLVMBackend &llvmBackend,
                                                    llvmTargetFeatures.end());
   irgen_->setBundleName(bundleName.str());
   irgen_->setOutputDir(outputDir);
+  irgen_->setPreserveParallelRuntime(bundleParallelRuntime);
+  irgen_->setPreserveWeightsDecompressor(bundleCompressWeights);
   irgen_->setObjectRegistry(llvmBackend.getObjectRegistry());
+  allocationsInfo_.getActivationsAllocator().setPlanner(
+      llvmBackend.getActivationsMemoryPlanner());
+  if (bundleMinMemory) {
+    // The search starts from the best of the other planners. Bundles are
+    // compiled ahead of time, so it can afford a much larger budget than the
+    // default.
+    allocationsInfo_.getActivationsAllocator().setPlanner(
+        MemoryPlanner::Search);
+    allocationsInfo_.getActivationsAllocator().setSearchBudget(uint64_t(1)
+                                                               << 32);
+  }
   // Use the bundle code model as a code model for the TargetMachine.
   auto opts = llvmBackend.getOptions();
   opts.setCodeModel(opts.getBundleCodeModel());
@@ -273,6 +337,29 @@ void BundleSaver::saveWeights(llvm::StringRef weightsFileName) {
   weightsFile.close();
 }
 
+void BundleSaver::saveCompressedWeights(llvm::StringRef weightsFileName,
+                                        llvm::StringRef compressedFileName) {
+  auto weightsOrErr = llvm::MemoryBuffer::getFile(weightsFileName);
+  CHECK(weightsOrErr) << "Could not read the bundle weights file: "
+                      << weightsFileName.str();
+  auto data = (*weightsOrErr)->getBuffer();
+  std::vector<uint8_t> compressed = compressWeights(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size()));
+  std::error_code EC;
+  llvm::raw_fd_ostream compressedFile(compressedFileName, EC,
+                                      llvm::sys::fs::OF_None);
+  CHECK(!EC) << "Could not open the output file for saving the compressed "
+                "bundle weights with file name: "
+             << compressedFileName.str();
+  compressedFile.write(reinterpret_cast<const char *>(compressed.data()),
+                       compressed.size());
+  CHECK(!compressedFile.has_error()) << "Could not write bytes";
+  compressedFile.close();
+  DEBUG_GLOW(llvm::dbgs() << "Compressed the bundle weights from "
+                          << data.size() << " to " << compressed.size()
+                          << " bytes\n");
+}
+
 void BundleSaver::saveHeader(llvm::StringRef headerFileName) {
   auto bundleName = irgen_->getBundleName();
   auto bundleNameUpper = llvm::StringRef(bundleName).upper();
@@ -403,6 +490,14 @@ void BundleSaver::saveHeader(llvm::StringRef headerFileName) {
                   savedIRFunction.entryName.c_str());
   }
 
+  if (bundleParallelRuntime) {
+    modelApi += parallelRuntimeApi;
+  }
+
+  if (bundleCompressWeights) {
+    modelApi += weightsDecompressorApi;
+  }
+
   // Get bundle header extra content.
   std::string headerExtra = irgen_->getBundleHeaderExtra();
 
@@ -552,6 +647,8 @@ void BundleSaver::produceBundle() {
   bundleCodeOutput = (outputDir + "/" + savedBundleName + extension).str();
   auto bundleWeightsBinOut =
       (outputDir + "/" + savedBundleName + ".weights.bin").str();
+  auto bundleWeightsZBinOut =
+      (outputDir + "/" + savedBundleName + ".weights.z.bin").str();
   auto bundleHeaderOutput = (outputDir + "/" + savedBundleName + ".h").str();
   DEBUG_GLOW(llvm::dbgs() << "Producing a bundle:\n"
                           << "saved bundle name: " << savedBundleName << "\n"
@@ -676,6 +773,9 @@ void BundleSaver::produceBundle() {
   // Output weights.
   if (saveWeights_) {
     saveWeights(bundleWeightsBinOut);
+    if (bundleCompressWeights) {
+      saveCompressedWeights(bundleWeightsBinOut, bundleWeightsZBinOut);
+    }
   }
   // Header file.
   if (saveHeader_) {
@@ -687,6 +787,11 @@ void BundleSaver::produceBundle() {
       auto bundleWeightsTxtOut =
           (outputDir + "/" + savedBundleName + ".weights.txt").str();
       serializeBinaryToText(bundleWeightsBinOut, bundleWeightsTxtOut);
+      if (bundleCompressWeights) {
+        auto bundleWeightsZTxtOut =
+            (outputDir + "/" + savedBundleName + ".weights.z.txt").str();
+        serializeBinaryToText(bundleWeightsZBinOut, bundleWeightsZTxtOut);
+      }
     }
   }
 }
@@ -92,6 +92,76 @@ llvm::cl::opt<bool> llvmSaveAsm(
     llvm::cl::desc("Create and save asm file along with Bundle object file."),
     llvm::cl::init(false), llvm::cl::cat(getLLVMBackendCat()));
 
+llvm::cl::opt<LibjitMatMulKernel> libjitMatMulKernel(
+    "libjit-matmul-kernel",
+    llvm::cl::desc("Float MatMul kernel of libjit to use"),
+    llvm::cl::values(
+        clEnumValN(LibjitMatMulKernel::Auto, "auto",
+                   "Pick the kernel from the target CPU features (default)"),
+        clEnumValN(LibjitMatMulKernel::Generic, "generic",
+                   "Kernel that suits any target"),
+        clEnumValN(LibjitMatMulKernel::AVX2, "avx2", "Kernel for AVX2"),
+        clEnumValN(LibjitMatMulKernel::AVX512, "avx512",
+                   "Kernel for AVX-512")),
+    llvm::cl::init(LibjitMatMulKernel::Auto),
+    llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<bool> libjitVNNI(
+    "libjit-vnni",
+    llvm::cl::desc("Use the AVX512-VNNI int8 kernels of libjit when the "
+                   "target supports them"),
+    llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<bool> libjitARM(
+    "libjit-arm",
+    llvm::cl::desc("Use the int8 kernels of libjit tuned for ARM when "
+                   "generating code for AArch64, or for ARM with NEON or MVE"),
+    llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<bool> fuseDataParallelInstrs(
+    "llvm-fuse-data-parallel-instrs",
+    llvm::cl::desc("Move data parallel instructions next to the ones they can "
+                   "be stacked with into a single kernel"),
+    llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<unsigned> dataParallelTileSize(
+    "llvm-data-parallel-tile-size",
+    llvm::cl::desc("Number of elements of the tiles over which stacked data "
+                   "parallel kernels run one instruction after the other, 0 "
+                   "to run all instructions for every element instead"),
+    llvm::cl::init(0), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<unsigned> dataParallelTaskSize(
+    "llvm-data-parallel-task-size",
+    llvm::cl::desc("Number of elements of the tasks that stacked data "
+                   "parallel kernels are split into across the intra-op "
+                   "threads, 0 to never split them"),
+    llvm::cl::init(1 << 16), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<unsigned> llvmCodeGenThreads(
+    "llvm-codegen-threads",
+    llvm::cl::desc("Number of threads compiling the optimized LLVM module to "
+                   "machine code, each on its own part of the module"),
+    llvm::cl::init(1), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<std::string> llvmJITCacheDir(
+    "llvm-jit-cache-dir",
+    llvm::cl::desc("Directory keeping the object files compiled by the JIT, "
+                   "reused when compiling identical modules"),
+    llvm::cl::init(""), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<bool> libjitLazyLoad(
+    "libjit-lazy-load",
+    llvm::cl::desc("Only read and optimize the libjit functions used by the "
+                   "generated code instead of the whole library"),
+    llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
+
+llvm::cl::opt<bool> libjitAVX512BF16(
+    "libjit-avx512bf16",
+    llvm::cl::desc("Use the AVX512-BF16 bfloat16 kernels of libjit when the "
+                   "target supports them"),
+    llvm::cl::init(true), llvm::cl::cat(getLLVMBackendCat()));
+
 llvm::cl::opt<llvm::FloatABI::ABIType>
     floatABI("float-abi", llvm::cl::desc("Option to set float ABI type"),
              llvm::cl::values(clEnumValN(llvm::FloatABI::Default, "default",
@@ -119,6 +189,41 @@ llvm::cl::opt<bool> bundleAPIVerbose(
     llvm::cl::desc("Print more details in the bundle API header file"),
     llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
 
+llvm::cl::opt<bool> bundleParallelRuntime(
+    "bundle-parallel-runtime",
+    llvm::cl::desc("Keep in the bundle an intra-op thread pool the kernels "
+                   "split their work across once the application starts it "
+                   "with glow_parallel_runtime_init()"),
+    llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
+
+llvm::cl::opt<bool> bundleCompressWeights(
+    "bundle-compress-weights",
+    llvm::cl::desc("Also save the constant weights of the bundle compressed "
+                   "and keep in the bundle the glow_weights_decompress() "
+                   "functions decoding them"),
+    llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
+
+llvm::cl::opt<bool> bundleMinMemory(
+    "bundle-min-memory",
+    llvm::cl::desc("Minimize the peak activation memory of the bundle, at the "
+                   "expense of compile time: schedule the graph with the "
+                   "peak-memory-based scheduler and place the activations "
+                   "with an extended search"),
+    llvm::cl::init(false), llvm::cl::cat(bundleSaverCat));
+
+llvm::cl::opt<unsigned> bundlePatchLayers(
+    "bundle-patch-layers",
+    llvm::cl::desc("Run the first convolutions of the bundle, up to this "
+                   "number of them, and the nodes feeding them in horizontal "
+                   "patches so their activations are never whole. The "
+                   "default 0 disables it"),
+    llvm::cl::init(0), llvm::cl::cat(bundleSaverCat));
+
+llvm::cl::opt<unsigned> bundlePatchCount(
+    "bundle-patch-count",
+    llvm::cl::desc("Number of patches of -bundle-patch-layers"),
+    llvm::cl::init(4), llvm::cl::cat(bundleSaverCat));
+
 llvm::cl::list<std::string> bundleObjectsOpt(
     "bundle-objects",
     llvm::cl::desc("Comma separated list of names of other object files which "
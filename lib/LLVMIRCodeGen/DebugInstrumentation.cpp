@@ -381,6 +381,10 @@ private:
 
 } // namespace
 
+bool LLVMIRGen::hasDebugInstrumentation() {
+  return !llvmIrInstrumentation.empty();
+}
+
 void LLVMIRGen::performDebugInstrumentation() {
   DebugInstrumentation debugInstrumentation(*this);
   debugInstrumentation.run();
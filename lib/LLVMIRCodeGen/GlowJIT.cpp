@@ -329,8 +329,10 @@ createLookupResolver(llvm::orc::ExecutionSession &ES,
 }
 #endif
 
-GlowJIT::GlowJIT(std::unique_ptr<llvm::TargetMachine> TM)
-    : TM_(std::move(TM)), DL_(TM_->createDataLayout()),
+GlowJIT::GlowJIT(std::unique_ptr<llvm::TargetMachine> TM,
+                 std::unique_ptr<llvm::ObjectCache> cache)
+    : TM_(std::move(TM)), cache_(std::move(cache)),
+      DL_(TM_->createDataLayout()),
 #if FACEBOOK_INTERNAL && LLVM_VERSION_MAJOR < 8
       ES_(SSP_),
       resolver_(createLookupResolver(
@@ -374,7 +376,7 @@ GlowJIT::GlowJIT(std::unique_ptr<llvm::TargetMachine> TM)
           NotifyLoadedFunctor()),
 #endif
 #endif
-      compileLayer_(objectLayer_, SimpleCompiler(*TM_)) {
+      compileLayer_(objectLayer_, SimpleCompiler(*TM_, cache_.get())) {
   //  When passing a null pointer to LoadLibraryPermanently, we request to
   //  'load' the host process itself, making its exported symbols available for
   //  execution.
@@ -428,6 +430,16 @@ GlowJIT::ModuleHandle GlowJIT::addModule(std::unique_ptr<llvm::Module> M) {
   return K;
 }
 
+GlowJIT::ModuleHandle
+GlowJIT::addObjectFile(std::unique_ptr<MemoryBuffer> obj) {
+  // The key is shared between the object layer and vModKeys_, so that symbols
+  // of the object are resolved from the other modules and vice versa.
+  auto K = ES_.allocateVModule();
+  cantFail(objectLayer_.addObject(K, std::move(obj)));
+  vModKeys_.insert(K);
+  return K;
+}
+
 void GlowJIT::removeModule(GlowJIT::ModuleHandle H) {
   vModKeys_.erase(H);
   cantFail(compileLayer_.removeModule(H));
@@ -549,8 +561,10 @@ llvm::orc::JITDylib &createJITDylib(llvm::orc::ExecutionSession &es) {
 //******************************************************************************
 // GlowJITOrcV2
 //******************************************************************************
-GlowJITOrcV2::GlowJITOrcV2(std::unique_ptr<llvm::TargetMachine> tm)
-    : tm_(std::move(tm)), dl_(tm_->createDataLayout()),
+GlowJITOrcV2::GlowJITOrcV2(std::unique_ptr<llvm::TargetMachine> tm,
+                           std::unique_ptr<llvm::ObjectCache> cache)
+    : tm_(std::move(tm)), cache_(std::move(cache)),
+      dl_(tm_->createDataLayout()),
 #if LLVM_VERSION_MAJOR >= 13
       es_(std::move(*llvm::orc::SelfExecutorProcessControl::Create())),
 #else
@@ -560,7 +574,8 @@ GlowJITOrcV2::GlowJITOrcV2(std::unique_ptr<llvm::TargetMachine> tm)
       objectLayer_(
           es_, []() { return std::make_unique<llvm::SectionMemoryManager>(); }),
       compileLayer_(es_, objectLayer_,
-                    std::make_unique<llvm::orc::SimpleCompiler>(*tm_)),
+                    std::make_unique<llvm::orc::SimpleCompiler>(
+                        *tm_, cache_.get())),
       mangler_(es_, dl_) {
 
   cantFail(cxxSymbolOverride_.enable(jd_, mangler_));
@@ -655,6 +670,10 @@ void GlowJITOrcV2::addModule(std::unique_ptr<llvm::Module> m) {
   }
 }
 
+void GlowJITOrcV2::addObjectFile(std::unique_ptr<llvm::MemoryBuffer> obj) {
+  cantFail(objectLayer_.add(jd_, std::move(obj)));
+}
+
 } // namespace glow
 #else
 #error Unsupported GLOW_JIT_ORC_VERSION
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/LLVMIRCodeGen/JITObjectCache.h"
+#include "glow/LLVMIRCodeGen/CommandLine.h"
+#include "glow/Support/Debug.h"
+#include "glow/Support/Memory.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "jit-object-cache"
+
+using namespace glow;
+
+/// Version of the cache, to be bumped when the key or the objects change in
+/// ways the key does not capture.
+static constexpr unsigned kJITObjectCacheVersion = 1;
+
+JITObjectCache::JITObjectCache(llvm::StringRef dir,
+                               const llvm::TargetMachine &TM)
+    : dir_(dir.str()) {
+  llvm::raw_string_ostream os(targetKey_);
+  os << kJITObjectCacheVersion << ';' << LLVM_VERSION_STRING << ';'
+     << TM.getTargetTriple().str() << ';' << TM.getTargetCPU() << ';'
+     << TM.getTargetFeatureString() << ';' << int(TM.getOptLevel()) << ';'
+     << int(TM.getRelocationModel()) << ';' << int(TM.getCodeModel()) << ';';
+  os.flush();
+  if (auto err = llvm::sys::fs::create_directories(dir_)) {
+    DEBUG_GLOW(llvm::dbgs() << "Could not create the JIT object cache " << dir_
+                            << ": " << err.message() << "\n");
+  }
+}
+
+std::string JITObjectCache::getPath(const llvm::Module &M) const {
+  llvm::SmallString<0> key(targetKey_);
+  llvm::raw_svector_ostream os(key);
+  llvm::WriteBitcodeToFile(M, os);
+  auto hash = llvm::SHA1::hash(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(key.data()), key.size()));
+  llvm::SmallString<128> path(dir_);
+  llvm::sys::path::append(path, llvm::toHex(hash, /* LowerCase */ true) + ".o");
+  return path.str().str();
+}
+
+void JITObjectCache::notifyObjectCompiled(const llvm::Module *M,
+                                          llvm::MemoryBufferRef obj) {
+  std::string path = getPath(*M);
+  // Write to a temporary file renamed into place, so that readers never see
+  // a partial object.
+  int fd;
+  llvm::SmallString<128> tmpPath;
+  if (llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%%%", fd, tmpPath)) {
+    DEBUG_GLOW(llvm::dbgs() << "Could not write " << path << "\n");
+    return;
+  }
+  {
+    llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+    os << obj.getBuffer();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(tmpPath, path)) {
+    llvm::sys::fs::remove(tmpPath);
+  }
+}
+
+std::unique_ptr<llvm::MemoryBuffer>
+JITObjectCache::getObject(const llvm::Module *M) {
+  std::string path = getPath(*M);
+  auto bufOrErr = llvm::MemoryBuffer::getFile(path);
+  if (!bufOrErr) {
+    DEBUG_GLOW(llvm::dbgs() << "JIT object cache miss: " << path << "\n");
+    return nullptr;
+  }
+  DEBUG_GLOW(llvm::dbgs() << "JIT object cache hit: " << path << "\n");
+  return std::move(*bufOrErr);
+}
+
+std::unique_ptr<JITObjectCache>
+glow::createJITObjectCache(const llvm::TargetMachine &TM) {
+  if (llvmJITCacheDir.empty()) {
+    return nullptr;
+  }
+  return glow::make_unique<JITObjectCache>(llvmJITCacheDir, TM);
+}
@@ -17,19 +17,36 @@
 #include "glow/LLVMIRCodeGen/LLVMBackend.h"
 #include "glow/LLVMIRCodeGen/BundleSaver.h"
 #include "glow/LLVMIRCodeGen/CommandLine.h"
+#include "glow/LLVMIRCodeGen/JITObjectCache.h"
 #include "glow/LLVMIRCodeGen/LLVMCompiledFunction.h"
+#include "glow/LLVMIRCodeGen/PerfCounters.h"
 
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Graph/Utils.h"
 #include "glow/IR/Instrs.h"
+#include "glow/Optimizer/GraphOptimizer/NodeSplitting.h"
 #include "glow/Optimizer/IROptimizer/IROptimizer.h"
 #include "glow/Support/Debug.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#if LLVM_VERSION_MAJOR >= 14
+#include "llvm/MC/TargetRegistry.h"
+#else
+#include "llvm/Support/TargetRegistry.h"
+#endif
 #include "llvm/Support/Host.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+
+#include <thread>
+
+#define DEBUG_TYPE "jit"
 
 using namespace glow;
 
@@ -80,6 +97,8 @@ bool LLVMBackend::isOpSupported(const NodeInfo &NI) const {
         {ElemKind::FloatTy, ElemKind::Int8QTy});
 
   case Kinded::Kind::HardSwishNodeKind:
+  case Kinded::Kind::GeluNodeKind:
+  case Kinded::Kind::LayerNormalizationNodeKind:
   case Kinded::Kind::AdaptiveAvgPoolNodeKind:
     return NI.allInputsAndOutputsHaveSameElemKind({ElemKind::FloatTy});
 
@@ -446,9 +465,12 @@ bool LLVMBackend::isOpSupported(const NodeInfo &NI) const {
             ElemKind::FloatTy);
 
   case Kinded::Kind::FusedRowwiseQuantizedSparseLengthsWeightedSumNodeKind:
-    return (NI.getInElemTy(
-                FusedRowwiseQuantizedSparseLengthsWeightedSumNode::DataIdx) ==
-            ElemKind::UInt8FusedQTy) &&
+    return ((NI.getInElemTy(
+                 FusedRowwiseQuantizedSparseLengthsWeightedSumNode::DataIdx) ==
+             ElemKind::UInt8FusedQTy) ||
+            (NI.getInElemTy(
+                 FusedRowwiseQuantizedSparseLengthsWeightedSumNode::DataIdx) ==
+             ElemKind::UInt4FusedQTy)) &&
            (NI.getInElemTy(FusedRowwiseQuantizedSparseLengthsWeightedSumNode::
                                WeightsIdx) == ElemKind::FloatTy) &&
            ((NI.getInElemTy(FusedRowwiseQuantizedSparseLengthsWeightedSumNode::
@@ -675,6 +697,79 @@ void LLVMBackend::emitJitMain(LLVMIRGen &irgen) const {
   irgen.generateFunctionDebugInfo(func);
 }
 
+/// \returns a copy of the target machine \p TM, to compile on another thread.
+static std::unique_ptr<llvm::TargetMachine>
+cloneTargetMachine(const llvm::TargetMachine &TM) {
+  return std::unique_ptr<llvm::TargetMachine>(
+      TM.getTarget().createTargetMachine(
+          TM.getTargetTriple().str(), TM.getTargetCPU(),
+          TM.getTargetFeatureString(), TM.Options, TM.getRelocationModel(),
+          TM.getCodeModel(), TM.getOptLevel()));
+}
+
+/// Split the optimized module \p M into \p numParts parts, and compile them
+/// to object files concurrently for the target \p TM. LLVM contexts are not
+/// thread safe, so every part is moved through bitcode into a context of its
+/// own. Parts found in \p cache, if given, are not compiled again. \returns
+/// the object files.
+static std::vector<std::unique_ptr<llvm::MemoryBuffer>>
+compileModuleInParallel(std::unique_ptr<llvm::Module> M,
+                        const llvm::TargetMachine &TM, unsigned numParts,
+                        llvm::ObjectCache *cache) {
+  std::vector<llvm::SmallString<0>> bitcodes;
+  auto addPart = [&](std::unique_ptr<llvm::Module> part) {
+    bitcodes.emplace_back();
+    llvm::raw_svector_ostream os(bitcodes.back());
+    llvm::WriteBitcodeToFile(*part, os);
+  };
+#if LLVM_VERSION_MAJOR >= 13
+  llvm::SplitModule(*M, numParts, addPart);
+#else
+  llvm::SplitModule(std::move(M), numParts, addPart);
+#endif
+
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers(bitcodes.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0, e = bitcodes.size(); i < e; i++) {
+    threads.emplace_back([&, i]() {
+      llvm::LLVMContext ctx;
+      auto part = llvm::cantFail(
+          llvm::parseBitcodeFile(
+              llvm::MemoryBufferRef(bitcodes[i].str(), "part"), ctx),
+          "Could not read a part of the module");
+      if (cache) {
+        buffers[i] = cache->getObject(part.get());
+        if (buffers[i]) {
+          return;
+        }
+      }
+      auto partTM = cloneTargetMachine(TM);
+      llvm::SmallString<0> object;
+      llvm::raw_svector_ostream os(object);
+      llvm::legacy::PassManager PM;
+#if FACEBOOK_INTERNAL && LLVM_VERSION_MAJOR < 8
+      partTM->addPassesToEmitFile(
+          PM, os, llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile);
+#elif LLVM_VERSION_MAJOR < 10
+      partTM->addPassesToEmitFile(
+          PM, os, nullptr,
+          llvm::TargetMachine::CodeGenFileType::CGFT_ObjectFile);
+#else
+      partTM->addPassesToEmitFile(PM, os, nullptr, llvm::CGFT_ObjectFile);
+#endif
+      PM.run(*part);
+      buffers[i] = llvm::MemoryBuffer::getMemBufferCopy(object.str());
+      if (cache) {
+        cache->notifyObjectCompiled(part.get(), buffers[i]->getMemBufferRef());
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return buffers;
+}
+
 std::unique_ptr<CompiledFunction>
 LLVMBackend::compileIR(std::unique_ptr<IRFunction> IR) const {
   auto function = compileIRWithoutConstants(IR.get());
@@ -687,6 +782,8 @@ LLVMBackend::compileIR(std::unique_ptr<IRFunction> IR) const {
 std::unique_ptr<CompiledFunction>
 LLVMBackend::compileIRWithoutConstants(IRFunction *IR) const {
   AllocationsInfo allocationsInfo;
+  allocationsInfo.getActivationsAllocator().setPlanner(
+      getActivationsMemoryPlanner());
   std::unique_ptr<LLVMIRGen> irgen = createIRGen(IR, allocationsInfo);
   llvm::SmallVector<std::string, 8> targetFeatures(llvmTargetFeatures.begin(),
                                                    llvmTargetFeatures.end());
@@ -701,13 +798,29 @@ LLVMBackend::compileIRWithoutConstants(IRFunction *IR) const {
   emitJitMain(*irgen);
   irgen->finishCodeGen();
   // Hand over the module to JIT for the machine code generation.
-  auto JIT = glow::make_unique<GlowJIT>(irgen->takeTargetMachine());
+  const llvm::TargetMachine &TM = irgen->getTargetMachine();
+  std::unique_ptr<JITObjectCache> cache = createJITObjectCache(TM);
+  JITObjectCache *cachePtr = cache.get();
+  auto JIT =
+      glow::make_unique<GlowJIT>(irgen->takeTargetMachine(), std::move(cache));
   JIT->setContext(irgen->takeLLVMContext());
-  JIT->addModule(irgen->borrowModule());
+  auto module = irgen->borrowModule();
+  // Objects added directly to the JIT do not get their static constructors
+  // run, so modules having some are always compiled as a whole.
+  if (llvmCodeGenThreads > 1 && !module->getNamedGlobal("llvm.global_ctors") &&
+      !module->getNamedGlobal("llvm.global_dtors")) {
+    for (auto &object : compileModuleInParallel(
+             std::move(module), TM, llvmCodeGenThreads, cachePtr)) {
+      JIT->addObjectFile(std::move(object));
+    }
+  } else {
+    JIT->addModule(std::move(module));
+  }
   // Build runtimeBundle object containing offsets and allocation sizes.
   MemoryAllocator constantAllocator("ConstantWeights", 0);
   MemoryAllocator placeholderAllocator("Placeholders", 0);
   MemoryAllocator activationsAllocator("Activations", 0);
+  activationsAllocator.setPlanner(getActivationsMemoryPlanner());
   auto runtimeInfo = runtime::RuntimeBundle::create(
       *IR, constantAllocator, placeholderAllocator, activationsAllocator);
   return createCompiledFunction(std::move(JIT), std::move(runtimeInfo));
@@ -719,6 +832,11 @@ LLVMBackend::compile(Function *F, const BackendOptions &opts) const {
   auto IR = generateAndOptimizeIR(F, *this, shouldShareBuffers());
 
   if (opts.autoInstrument) {
+    if (opts.autoInstrumentCounters) {
+      registerPerfCountersSymbol();
+      auto names = getPerfCounterNames();
+      traceInfo.counterNames.assign(names.begin(), names.end());
+    }
     autoInstrument(traceInfo, IR.get());
   }
 
@@ -733,12 +851,50 @@ LLVMBackend::compile(Function *F, const BackendOptions &opts) const {
   return Expected<std::unique_ptr<CompiledFunction>>(std::move(compiledFunc));
 }
 
+/// Split the first -bundle-patch-layers convolutions of \p F, and the nodes
+/// feeding them, in -bundle-patch-count patches along the height. Each patch
+/// only needs the slice of the input it reads, halo included, so the patches
+/// can be scheduled one after the other and the activations of the early
+/// layers, the largest ones in most vision models, are never alive whole. The
+/// split stops at the nodes with several users.
+static void splitBundlePatchLayers(Function *F) {
+  if (!bundlePatchLayers || bundlePatchCount < 2) {
+    return;
+  }
+  ConvolutionNode *lastConv = nullptr;
+  unsigned numConvs = 0;
+  GraphPostOrderVisitor visitor(*F);
+  for (auto *N : visitor.getPostOrder()) {
+    auto *CN = llvm::dyn_cast<ConvolutionNode>(N);
+    if (!CN || CN->getParent() != F) {
+      continue;
+    }
+    lastConv = CN;
+    if (++numConvs == bundlePatchLayers) {
+      break;
+    }
+  }
+  if (!lastConv || lastConv->getLayout() != NHWC ||
+      lastConv->getResult().dims()[ShapeNHWC::DimH] < bundlePatchCount) {
+    return;
+  }
+  SplitNodeByNumChunks splitOption({ShapeNHWC::DimH}, {bundlePatchCount});
+  auto splitMap = EXIT_ON_ERR(splitNodeRecursively(
+      lastConv, splitOption, /* maxDepth */ F->getNodes().size(),
+      /* singleUseOnly */ true));
+  DEBUG_GLOW(llvm::dbgs() << "Split " << splitMap.size()
+                          << " nodes of the bundle in " << bundlePatchCount
+                          << " patches\n");
+}
+
 void LLVMBackend::save(Function *F, llvm::StringRef outputDir,
                        llvm::StringRef bundleName,
                        llvm::StringRef mainEntryName) const {
   llvm::SmallVector<std::string, 8> targetFeatures(llvmTargetFeatures.begin(),
                                                    llvmTargetFeatures.end());
-  auto IR = generateAndOptimizeIR(F, *this, shouldShareBuffers());
+  splitBundlePatchLayers(F);
+  auto IR = generateAndOptimizeIR(F, *this, shouldShareBuffers(),
+                                  /* minimizePeakMemory */ bundleMinMemory);
   auto bundleSaver = createBundleSaver(*this, outputDir, bundleName);
   bundleSaver->save(mainEntryName, IR.get());
   bundleSaver->produceBundle();
@@ -750,7 +906,9 @@ void LLVMBackend::saveFunctions(llvm::ArrayRef<BundleEntry> entries,
   auto bundleSaver = createBundleSaver(*this, outputDir, bundleName);
   std::vector<std::unique_ptr<glow::IRFunction>> irFunctions;
   for (auto &entry : entries) {
-    auto IR = generateAndOptimizeIR(entry.func, *this, shouldShareBuffers());
+    splitBundlePatchLayers(entry.func);
+    auto IR = generateAndOptimizeIR(entry.func, *this, shouldShareBuffers(),
+                                    /* minimizePeakMemory */ bundleMinMemory);
     bundleSaver->save(entry.name, IR.get());
     irFunctions.emplace_back(std::move(IR));
   }
@@ -15,6 +15,7 @@
  */
 #include "glow/LLVMIRCodeGen/LLVMCompiledFunction.h"
 
+#include "glow/Flags/Flags.h"
 #include "glow/Graph/PlaceholderBindings.h"
 #include "glow/Support/Compiler.h"
 #include "glow/Support/Memory.h"
@@ -26,6 +27,43 @@ LLVMCompiledFunction::LLVMCompiledFunction(
     std::unique_ptr<GlowJIT> JIT, runtime::RuntimeBundle &&runtimeBundle)
     : CompiledFunction(std::move(runtimeBundle)), JIT_(std::move(JIT)) {}
 
+LLVMCompiledFunction::~LLVMCompiledFunction() {
+  for (auto *buffer : freeActivations_) {
+    alignedFree(buffer);
+  }
+  for (auto *buffer : freeMutableWeights_) {
+    alignedFree(buffer);
+  }
+}
+
+uint8_t *LLVMCompiledFunction::acquireRunBuffer(std::vector<uint8_t *> &cache,
+                                                size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(runBuffersLock_);
+    if (!cache.empty()) {
+      uint8_t *buffer = cache.back();
+      cache.pop_back();
+      retainedRunBufferBytes_ -= size;
+      return buffer;
+    }
+  }
+  return (uint8_t *)alignedAlloc(size, TensorAlignment);
+}
+
+void LLVMCompiledFunction::releaseRunBuffer(std::vector<uint8_t *> &cache,
+                                            uint8_t *buffer, size_t size) {
+  {
+    std::lock_guard<std::mutex> lock(runBuffersLock_);
+    if (retainedRunBufferBytes_ + size <=
+        runtime::flags::LLVMRunBufferCacheBytes) {
+      cache.push_back(buffer);
+      retainedRunBufferBytes_ += size;
+      return;
+    }
+  }
+  alignedFree(buffer);
+}
+
 void LLVMCompiledFunction::collectConstants(const Module *module) {
   runtimeBundle_.collectConstants(module);
 }
@@ -70,26 +108,66 @@ void LLVMCompiledFunction::updatePlaceholders(
   }
 }
 
+uint8_t *LLVMCompiledFunction::getBoundIOBuffer(
+    const PlaceholderBindings *bindings) const {
+  uint8_t *base = nullptr;
+  size_t numBound = 0;
+  for (auto &PH : bindings->pairs()) {
+    auto it = runtimeBundle_.getSymbolTable().find(PH.first->getName().str());
+    if (it == runtimeBundle_.getSymbolTable().end()) {
+      continue;
+    }
+    if (PH.second.isDeviceResident()) {
+      return nullptr;
+    }
+    uint8_t *start = (uint8_t *)PH.second.getUnsafePtr() - it->second.offset;
+    if (base && start != base) {
+      return nullptr;
+    }
+    base = start;
+    numBound++;
+  }
+  // Every Placeholder must be bound since the function writes all of them,
+  // and the JIT'd code assumes an aligned base address.
+  size_t numPlaceholders = 0;
+  for (const auto &symbol : runtimeBundle_.getSymbolTable()) {
+    if (symbol.second.symbolCategory == runtime::SymbolCategory::Placeholder) {
+      numPlaceholders++;
+    }
+  }
+  if (!base || numBound != numPlaceholders ||
+      reinterpret_cast<uintptr_t>(base) % TensorAlignment != 0) {
+    return nullptr;
+  }
+  return base;
+}
+
 Error LLVMCompiledFunction::execute(ExecutionContext *context) {
   uint8_t *baseActivationsAddress{nullptr};
 
   /// Base address for Mutable weights memory block, Inputs and Outputs.
   uint8_t *baseMutableWeightVarsAddress{nullptr};
 
+  /// If the bindings already live in a buffer laid out like the mutable
+  /// weights area, run on it directly.
+  uint8_t *ioBuffer = getBoundIOBuffer(context->getPlaceholderBindings());
+
   {
     TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "allocBuffers");
     if (runtimeBundle_.getActivationsSize() != 0) {
-      baseActivationsAddress = (uint8_t *)alignedAlloc(
-          runtimeBundle_.getActivationsSize(), TensorAlignment);
+      baseActivationsAddress = acquireRunBuffer(
+          freeActivations_, runtimeBundle_.getActivationsSize());
     }
 
-    if (runtimeBundle_.getMutableWeightSize() != 0) {
-      baseMutableWeightVarsAddress = (uint8_t *)alignedAlloc(
-          runtimeBundle_.getMutableWeightSize(), TensorAlignment);
+    if (ioBuffer) {
+      baseMutableWeightVarsAddress = ioBuffer;
+    } else if (runtimeBundle_.getMutableWeightSize() != 0) {
+      baseMutableWeightVarsAddress = acquireRunBuffer(
+          freeMutableWeights_, runtimeBundle_.getMutableWeightSize());
     }
   }
 
-  {
+  if (!ioBuffer) {
     TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "loadPlaceholders");
     loadPlaceholders(context->getPlaceholderBindings(),
                      baseMutableWeightVarsAddress);
@@ -129,7 +207,7 @@ Error LLVMCompiledFunction::execute(ExecutionContext *context) {
     return MAKE_ERR("Error getting address");
   }
 
-  {
+  if (!ioBuffer) {
     TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "updatePlaceholders");
     updatePlaceholders(context->getPlaceholderBindings(),
                        baseMutableWeightVarsAddress);
@@ -137,8 +215,14 @@ Error LLVMCompiledFunction::execute(ExecutionContext *context) {
 
   {
     TRACE_EVENT_SCOPE(context, TraceLevel::RUNTIME, "freeBuffers");
-    alignedFree(baseMutableWeightVarsAddress);
-    alignedFree(baseActivationsAddress);
+    if (!ioBuffer && baseMutableWeightVarsAddress) {
+      releaseRunBuffer(freeMutableWeights_, baseMutableWeightVarsAddress,
+                       runtimeBundle_.getMutableWeightSize());
+    }
+    if (baseActivationsAddress) {
+      releaseRunBuffer(freeActivations_, baseActivationsAddress,
+                       runtimeBundle_.getActivationsSize());
+    }
   }
 
   {
@@ -170,30 +254,43 @@ void LLVMCompiledFunction::translateTraceEvents(
     DCHECK(backingTensor) << "Could not get backing tensor for Placeholder: "
                           << backing.first->getName().str();
 
+    // The rows of the auto instrumentation hold the hardware counters after
+    // the timestamp, if recorded.
+    auto dims = backingTensor->dims();
+    size_t rowSize = traceInfo.dataSize;
+    size_t numCounters = 0;
+    if (dims.size() > 1 && dims[1] > 1) {
+      numCounters =
+          std::min<size_t>(dims[1] - 1, traceInfo.counterNames.size());
+      rowSize = dims[1] * sizeof(uint64_t);
+    }
     auto &traceEvents = traceContext->getTraceEvents();
     for (const TraceInfo::Event &event : backing.second) {
       // If it's a complete event grab both timestamps.
       if (event.type == TraceEvent::CompleteType) {
+        const char *startRow =
+            backingTensor->getUnsafePtr() + event.startIndex * rowSize;
+        const char *endRow =
+            backingTensor->getUnsafePtr() + event.endIndex * rowSize;
         uint64_t start{0}, end{0};
-        memcpy(&start,
-               backingTensor->getUnsafePtr() +
-                   (event.startIndex * traceInfo.dataSize),
-               traceInfo.dataSize);
-        memcpy(&end,
-               backingTensor->getUnsafePtr() +
-                   (event.endIndex * traceInfo.dataSize),
-               traceInfo.dataSize);
-        traceEvents.push_back({event.name,
-                               TraceLevel::OPERATOR,
-                               start,
-                               end - start,
-                               tid,
-                               {{"kind", event.kind}}});
+        memcpy(&start, startRow, traceInfo.dataSize);
+        memcpy(&end, endRow, traceInfo.dataSize);
+        std::map<std::string, std::string> args{{"kind", event.kind}};
+        for (size_t i = 0; i < numCounters; i++) {
+          uint64_t startCount{0}, endCount{0};
+          memcpy(&startCount, startRow + (i + 1) * sizeof(uint64_t),
+                 sizeof(uint64_t));
+          memcpy(&endCount, endRow + (i + 1) * sizeof(uint64_t),
+                 sizeof(uint64_t));
+          args[traceInfo.counterNames[i]] =
+              std::to_string(endCount - startCount);
+        }
+        traceEvents.push_back({event.name, TraceLevel::OPERATOR, start,
+                               end - start, tid, std::move(args)});
       } else {
         uint64_t ts{0};
         memcpy(&ts,
-               backingTensor->getUnsafePtr() +
-                   (event.startIndex * traceInfo.dataSize),
+               backingTensor->getUnsafePtr() + (event.startIndex * rowSize),
                traceInfo.dataSize);
         traceEvents.push_back({event.name,
                                TraceLevel::OPERATOR,
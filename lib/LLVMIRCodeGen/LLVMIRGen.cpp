@@ -26,16 +26,20 @@
 #include "glow/IR/Instrs.h"
 #include "glow/Quantization/Base/Base.h"
 
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IRReader/IRReader.h"
+#include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Target/TargetMachine.h"
 
+#include <mutex>
+
 using namespace glow;
 using llvm::cast;
 using llvm::dyn_cast;
@@ -81,8 +85,10 @@ LLVMIRGen::LLVMIRGen(const IRFunction *F, AllocationsInfo &allocationsInfo,
   setMainEntryName(mainEntryName);
 }
 
-/// Mutex to protect LLVM's TargetRegistry.
-static std::mutex initTargetMutex;
+/// Guards the one-time registration of LLVM's targets. TargetRegistry is not
+/// thread safe while targets are being registered, but lookups and target
+/// machine creation are safe to run concurrently afterwards.
+static std::once_flag initTargetsOnce;
 
 void LLVMIRGen::initTargetOptions(llvm::TargetOptions &targetOpts,
                                   const LLVMBackendOptions &backendOpts) {
@@ -95,13 +101,12 @@ void LLVMIRGen::initTargetOptions(llvm::TargetOptions &targetOpts,
 }
 
 void LLVMIRGen::initTargetMachine(const LLVMBackendOptions &opts) {
-  // LLVM's TargetRegistry is not thread safe so we add a critical section.
-  std::lock_guard<std::mutex> g(initTargetMutex);
-
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmPrinters();
-  llvm::InitializeAllAsmParsers();
+  std::call_once(initTargetsOnce, []() {
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+  });
 
   llvm::TargetOptions targetOpts;
   // Initialize target options in a backend-specific way.
@@ -194,31 +199,53 @@ void LLVMIRGen::loadBaseAddresses(llvm::IRBuilder<> &builder) {
   offsetsArray_ = F->args().begin() + 3;
 }
 
-// Search for the standard library bitcode file on disk and load it into an
-// LLVM module. We search for the standard library around the current executable
-// and also in the current directory.
+// Load the compiled-in image of the standard library into an LLVM module. The
+// bodies of its functions are only read when materialized, see
+// LLVMIRGen::materializeLibjit().
 static std::unique_ptr<llvm::Module>
 loadStandardLibrary(llvm::LLVMContext *ctx, llvm::StringRef filename,
                     llvm::StringRef libjitBC) {
-  using llvm::sys::path::append;
-  using llvm::sys::path::parent_path;
-
-  llvm::SMDiagnostic error;
-
-  // Parse the compiled-in image of libjit and return the resulting Module.
-  // checking for and reporting errors from parseIR.
-
-  auto mod = llvm::parseIR(
-      llvm::MemoryBufferRef(
-          llvm::StringRef(reinterpret_cast<const char *>(libjitBC.data()),
-                          libjitBC.size()),
-          "libjit.bc"),
-      error, *ctx);
+  auto modOrErr = llvm::getOwningLazyBitcodeModule(
+      llvm::MemoryBuffer::getMemBuffer(libjitBC, filename,
+                                       /* RequiresNullTerminator */ false),
+      *ctx);
+  if (!modOrErr) {
+    llvm::errs() << "LLVMIRGen: " << llvm::toString(modOrErr.takeError())
+                 << "\n";
+    return nullptr;
+  }
+  return std::move(*modOrErr);
+}
 
-  if (!mod) {
-    error.print("LLVMIRGen", llvm::errs());
+void LLVMIRGen::materializeLibjit() {
+  llvm::Module &M = getModule();
+  auto materialize = [](llvm::Error err) {
+    CHECK(!err) << "Unable to load the JIT library: "
+                << llvm::toString(std::move(err));
+  };
+  if (!libjitLazyLoad || hasDebugInstrumentation()) {
+    materialize(M.materializeAll());
+    return;
+  }
+  // Only read the libjit functions used by the generated code, directly or
+  // not, and the ones kept in the final module. The others would be parsed
+  // and optimized only to be removed once internalized.
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (auto &F : M) {
+      if (F.isMaterializable() && (!F.use_empty() || preserveSymbol(F))) {
+        materialize(F.materialize());
+        changed = true;
+      }
+    }
   }
-  return mod;
+  for (auto it = M.begin(), e = M.end(); it != e;) {
+    llvm::Function &F = *it++;
+    if (F.isMaterializable()) {
+      F.eraseFromParent();
+    }
+  }
+  materialize(M.materializeAll());
 }
 
 /// Register a diagnostics handler that prevents the compiler from printing to
@@ -259,9 +286,8 @@ llvm::Type *LLVMIRGen::getElementType(llvm::IRBuilder<> &builder,
   case ElemKind::FloatTy:
     return builder.getFloatTy();
   case ElemKind::Float16Ty:
-    llvm_unreachable("Not implemented");
   case ElemKind::BFloat16Ty:
-    llvm_unreachable("Not implemented");
+    return builder.getInt16Ty();
   case ElemKind::Float64Ty:
     return builder.getDoubleTy();
   case ElemKind::Int8QTy:
@@ -330,6 +356,7 @@ void LLVMIRGen::performCodeGen() {
 }
 
 void LLVMIRGen::finishCodeGen() {
+  materializeLibjit();
   if (dumpLLVMIR) {
     llvm::outs() << "LLVM module before optimizations:\n";
     llmodule_->print(llvm::outs(), nullptr);
@@ -673,7 +700,7 @@ llvm::Value *LLVMIRGen::emitConst(llvm::IRBuilder<> &builder, float val,
   case ElemKind::Float16Ty:
     llvm_unreachable("Not implemented");
   case ElemKind::BFloat16Ty:
-    llvm_unreachable("Not implemented");
+    return builder.getInt16(bfloat16(val).storage());
   case ElemKind::Float64Ty:
     return llvm::ConstantFP::get(llvm::Type::getDoubleTy(getLLVMContext()),
                                  val);
@@ -777,6 +804,129 @@ llvm::Function *LLVMIRGen::getFunction(const std::string &name,
   return getFunction(name, llvm::ArrayRef<ElemKind>{elemTy});
 }
 
+std::string LLVMIRGen::getMatMulKernelName() const {
+  std::string name = "matmul";
+  switch (libjitMatMulKernel) {
+  case LibjitMatMulKernel::Auto: {
+    auto arch = TM_->getTargetTriple().getArch();
+    if (arch != llvm::Triple::x86 && arch != llvm::Triple::x86_64) {
+      break;
+    }
+    // The AVX-512 kernel relies on AVX512VL for its 32 ymm registers.
+    const llvm::MCSubtargetInfo *STI = TM_->getMCSubtargetInfo();
+    if (STI->checkFeatures("+avx512f,+avx512vl")) {
+      name = "matmul_avx512";
+    } else if (STI->checkFeatures("+avx2")) {
+      name = "matmul_avx2";
+    }
+    break;
+  }
+  case LibjitMatMulKernel::Generic:
+    break;
+  case LibjitMatMulKernel::AVX2:
+    name = "matmul_avx2";
+    break;
+  case LibjitMatMulKernel::AVX512:
+    name = "matmul_avx512";
+    break;
+  }
+  // Backends with their own libjit may only provide the generic kernel.
+  auto fullName = createName("libjit_" + name, ElemKind::FloatTy);
+  if (!llmodule_->getFunction(fullName)) {
+    return "matmul";
+  }
+  return name;
+}
+
+/// \returns true if the 2D NHWC convolution from \p srcDims to \p destDims
+/// with filter \p kernels and \p group groups is a depthwise 3x3 or 5x5
+/// convolution, and the libjit of \p M has the depthwise kernel \p name for
+/// the element types \p elemTys.
+static bool useDepthwiseConv2dKernel(const llvm::Module &M,
+                                     const std::string &name,
+                                     llvm::ArrayRef<ElemKind> elemTys,
+                                     llvm::ArrayRef<dim_t> srcDims,
+                                     llvm::ArrayRef<dim_t> destDims,
+                                     llvm::ArrayRef<unsigned_t> kernels,
+                                     unsigned_t group) {
+  if (srcDims.size() != 4 || group != srcDims[3] || group != destDims[3] ||
+      kernels[0] != kernels[1] || (kernels[0] != 3 && kernels[0] != 5)) {
+    return false;
+  }
+  auto fullName = "libjit_" + name;
+  for (auto elTy : elemTys) {
+    fullName = createName(fullName, elTy);
+  }
+  return M.getFunction(fullName) != nullptr;
+}
+
+std::string
+LLVMIRGen::getInt8KernelName(const std::string &name,
+                             llvm::ArrayRef<glow::ElemKind> elemTyArray) const {
+  const llvm::Triple &triple = TM_->getTargetTriple();
+  auto arch = triple.getArch();
+  const llvm::MCSubtargetInfo *STI = TM_->getMCSubtargetInfo();
+  std::string suffix;
+  if (arch == llvm::Triple::x86 || arch == llvm::Triple::x86_64) {
+    if (!libjitVNNI ||
+        !STI->checkFeatures("+avx512bw,+avx512vl,+avx512vnni")) {
+      return name;
+    }
+    suffix = "_vnni";
+  } else if (triple.isAArch64() || triple.isARM() || triple.isThumb()) {
+    // 32-bit ARM cores without NEON or MVE have no vector units for the
+    // ARM kernels to make use of.
+    if (!libjitARM || (!triple.isAArch64() && !STI->checkFeatures("+neon") &&
+                       !STI->checkFeatures("+mve"))) {
+      return name;
+    }
+    suffix = "_arm";
+  } else {
+    return name;
+  }
+  // The variant may be missing, e.g. libjit only provides the VNNI kernels
+  // when built for x86.
+  auto fullName = "libjit_" + name + suffix;
+  for (auto elTy : elemTyArray) {
+    fullName = createName(fullName, elTy);
+  }
+  return llmodule_->getFunction(fullName) ? name + suffix : name;
+}
+
+std::string LLVMIRGen::getBFloat16KernelName(const std::string &name) const {
+  auto arch = TM_->getTargetTriple().getArch();
+  if (!libjitAVX512BF16 ||
+      (arch != llvm::Triple::x86 && arch != llvm::Triple::x86_64)) {
+    return name;
+  }
+  const llvm::MCSubtargetInfo *STI = TM_->getMCSubtargetInfo();
+  if (!STI->checkFeatures("+avx512bw,+avx512vl,+avx512bf16")) {
+    return name;
+  }
+  // libjit only provides the AVX512-BF16 kernels when built for x86.
+  auto fullName =
+      createName("libjit_" + name + "_avx512bf16", ElemKind::BFloat16Ty);
+  return llmodule_->getFunction(fullName) ? name + "_avx512bf16" : name;
+}
+
+std::string LLVMIRGen::getFloat16KernelName(
+    const std::string &name, llvm::ArrayRef<glow::ElemKind> elemTyArray) const {
+  auto arch = TM_->getTargetTriple().getArch();
+  if (arch != llvm::Triple::x86 && arch != llvm::Triple::x86_64) {
+    return name;
+  }
+  const llvm::MCSubtargetInfo *STI = TM_->getMCSubtargetInfo();
+  if (!STI->checkFeatures("+avx,+f16c")) {
+    return name;
+  }
+  // Only the backends whose libjit provides the F16C kernels have them.
+  auto fullName = "libjit_" + name + "_f16c";
+  for (auto elTy : elemTyArray) {
+    fullName = createName(fullName, elTy);
+  }
+  return llmodule_->getFunction(fullName) ? name + "_f16c" : name;
+}
+
 llvm::Function *LLVMIRGen::getLLVMFunction() { return llvmF_; }
 
 llvm::CallInst *LLVMIRGen::createCall(llvm::IRBuilder<> &builder,
@@ -853,8 +1003,16 @@ LLVMIRGen::createUncheckedCall(llvm::IRBuilder<> &builder,
 std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
 LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
                       llvm::Value *numElements) const {
+  return createLoop(builder, ctx, builder.getIntN(DIM_T_BITWIDTH, 0),
+                    numElements, builder.getIntN(DIM_T_BITWIDTH, 1),
+                    /* vectorize */ true);
+}
+
+std::pair<llvm::BasicBlock *, llvm::BasicBlock *>
+LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
+                      llvm::Value *start, llvm::Value *end, llvm::Value *step,
+                      bool vectorize) const {
   auto dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
-  auto *initVal = llvm::ConstantInt::get(dimTTy, 0);
 
   // Make the new basic block for the loop header. Insert it after current
   // block.
@@ -870,20 +1028,25 @@ LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
 
   // Create the PHI node with an entry for initial value.
   llvm::PHINode *var = builder.CreatePHI(dimTTy, 2);
-  var->addIncoming(initVal, preheaderBB);
+  var->addIncoming(start, preheaderBB);
 
   // Emit the step value.
-  auto *stepVal = llvm::ConstantInt::get(dimTTy, 1);
-  auto *nextVal = builder.CreateAdd(var, stepVal, "nextvar", /* HasNUW */ true,
+  auto *nextVal = builder.CreateAdd(var, step, "nextvar", /* HasNUW */ true,
                                     /* HasNSW */ true);
   // Compute the end condition.
-  auto *endCond = builder.CreateICmpULT(nextVal, numElements, "loopcond");
+  auto *endCond = builder.CreateICmpULT(nextVal, end, "loopcond");
 
   // Create the "after loop" block and insert it.
   auto *afterBB = llvm::BasicBlock::Create(ctx, "afterloop", func);
 
   // Insert the conditional branch at the end of the loopBB.
   auto *backEdge = builder.CreateCondBr(endCond, loopBB, afterBB);
+  // Add a new entry to the PHI node for the backedge.
+  var->addIncoming(nextVal, loopBB);
+  builder.SetInsertPoint(afterBB);
+  if (!vectorize) {
+    return std::make_pair(loopBB, afterBB);
+  }
   // Add explicit loop llvm.loop.vectorize.enable metadata to the generated
   // loop to help the LLVM vectorizer. Without this metadata, LLVM loop
   // vectorizer bails on long data-parallel loops with a lot of operations. This
@@ -906,9 +1069,6 @@ LLVMIRGen::createLoop(llvm::IRBuilder<> &builder, llvm::LLVMContext &ctx,
   // Set the first operand to itself.
   loopMD->replaceOperandWith(0, loopMD);
   backEdge->setMetadata(llvm::LLVMContext::MD_loop, loopMD);
-  // Add a new entry to the PHI node for the backedge.
-  var->addIncoming(nextVal, loopBB);
-  builder.SetInsertPoint(afterBB);
   return std::make_pair(loopBB, afterBB);
 }
 
@@ -932,10 +1092,16 @@ void LLVMIRGen::emitDataParallelKernelImpl(
   if (bundle.empty()) {
     return;
   }
-  // Create stacked kernel function type.
+  // Create stacked kernel function type. The buffers are followed by the
+  // range [begin, end) of the elements to process.
+  auto *dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
+  llvm::SmallVector<llvm::Type *, 32> kernelArgTypes(argTypes.begin(),
+                                                     argTypes.end());
+  kernelArgTypes.push_back(dimTTy);
+  kernelArgTypes.push_back(dimTTy);
   llvm::Type *voidTy = llvm::Type::getVoidTy(getLLVMContext());
   llvm::FunctionType *kernelFuncTy =
-      llvm::FunctionType::get(voidTy, argTypes, false);
+      llvm::FunctionType::get(voidTy, kernelArgTypes, false);
   auto *kernelFunc =
       llvm::Function::Create(kernelFuncTy, llvm::Function::InternalLinkage,
                              "libjit_stacked_kernel", llmodule_.get());
@@ -949,38 +1115,147 @@ void LLVMIRGen::emitDataParallelKernelImpl(
   llvm::BasicBlock *entryBB =
       llvm::BasicBlock::Create(getLLVMContext(), "entry", kernelFunc);
   llvm::IRBuilder<> kernelBuilder(entryBB);
+  llvm::Value *begin = kernelFunc->args().begin() + argTypes.size();
+  llvm::Value *end = kernelFunc->args().begin() + argTypes.size() + 1;
+  auto *one = kernelBuilder.getIntN(DIM_T_BITWIDTH, 1);
   // Number of tensor elements.
-  auto *numElements =
-      emitValueSize(kernelBuilder, bundle[0]->getOperand(0).first);
-  // Create a loop inside the stacked kernel function being generated.
-  auto loopBBs = createLoop(kernelBuilder, getLLVMContext(), numElements);
-
-  // Get the index parameter of the loop.
-  // This is the PHI node of the BB.
-  auto *kernelLoopIdx = dyn_cast<llvm::PHINode>(loopBBs.first->begin());
-  assert(kernelLoopIdx && "Could not find the loop index");
-  // Insert the body of the loop right after the PHI node.
-  kernelBuilder.SetInsertPoint(loopBBs.first->getFirstNonPHIOrDbg());
-  // Iterate over stacked instructions and create a kernel invocations per
-  // instruction.
-  for (auto &BI : bundle) {
-    // Name of the stacked operation to be invoked.
-    assert(canBePartOfDataParallelKernel(BI) &&
-           "Data parallel operation is expected");
-    generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
-                                       bufferToArgNum, kernelLoopIdx);
-  }
-  kernelBuilder.SetInsertPoint(loopBBs.second);
+  const dim_t numElements = bundle[0]->getOperand(0).first->size();
+  const dim_t tileSize = dataParallelTileSize;
+
+  if (!tileSize || bundle.size() == 1 || numElements <= tileSize) {
+    // Create a loop inside the stacked kernel function being generated.
+    auto loopBBs =
+        createLoop(kernelBuilder, getLLVMContext(), begin, end, one, true);
+
+    // Get the index parameter of the loop.
+    // This is the PHI node of the BB.
+    auto *kernelLoopIdx = dyn_cast<llvm::PHINode>(loopBBs.first->begin());
+    assert(kernelLoopIdx && "Could not find the loop index");
+    // Insert the body of the loop right after the PHI node.
+    kernelBuilder.SetInsertPoint(loopBBs.first->getFirstNonPHIOrDbg());
+    // Iterate over stacked instructions and create a kernel invocations per
+    // instruction.
+    for (auto &BI : bundle) {
+      // Name of the stacked operation to be invoked.
+      assert(canBePartOfDataParallelKernel(BI) &&
+             "Data parallel operation is expected");
+      generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
+                                         bufferToArgNum, kernelLoopIdx);
+    }
+    kernelBuilder.SetInsertPoint(loopBBs.second);
+  } else {
+    // Run the instructions one after the other over tiles of the elements, so
+    // that the results an instruction reads from the previous ones are still
+    // in the cache, and so that every inner loop is small enough to vectorize
+    // on its own.
+    auto *tileSizeVal = kernelBuilder.getIntN(DIM_T_BITWIDTH, tileSize);
+    auto tileLoopBBs = createLoop(kernelBuilder, getLLVMContext(), begin, end,
+                                  tileSizeVal, false);
+    auto *tileStart = dyn_cast<llvm::PHINode>(tileLoopBBs.first->begin());
+    assert(tileStart && "Could not find the tile loop index");
+    // Move the increment of the tile loop to its own block, after which the
+    // loops over the tile are inserted.
+    auto *tileLatchBB = tileLoopBBs.first->splitBasicBlock(
+        tileLoopBBs.first->getFirstNonPHIOrDbg(), "tilelatch");
+    tileLoopBBs.first->getTerminator()->eraseFromParent();
+    kernelBuilder.SetInsertPoint(tileLoopBBs.first);
+    auto *nextTileStart = kernelBuilder.CreateAdd(tileStart, tileSizeVal);
+    auto *tileEnd = kernelBuilder.CreateSelect(
+        kernelBuilder.CreateICmpULT(nextTileStart, end), nextTileStart, end,
+        "tileend");
+    for (auto &BI : bundle) {
+      assert(canBePartOfDataParallelKernel(BI) &&
+             "Data parallel operation is expected");
+      auto loopBBs = createLoop(kernelBuilder, getLLVMContext(), tileStart,
+                                tileEnd, one, true);
+      auto *kernelLoopIdx = dyn_cast<llvm::PHINode>(loopBBs.first->begin());
+      assert(kernelLoopIdx && "Could not find the loop index");
+      kernelBuilder.SetInsertPoint(loopBBs.first->getFirstNonPHIOrDbg());
+      generateLLVMIRForDataParallelInstr(kernelBuilder, BI, kernelFunc,
+                                         bufferToArgNum, kernelLoopIdx);
+      kernelBuilder.SetInsertPoint(loopBBs.second);
+    }
+    kernelBuilder.CreateBr(tileLatchBB);
+    kernelBuilder.SetInsertPoint(tileLoopBBs.second);
+  }
   // Add a return.
   kernelBuilder.CreateRetVoid();
 
   setCurrentDebugLocation(builder, *bundle.begin());
   // Emit a call of the kernel.
-  createUncheckedCall(builder, kernelFunc, buffers);
+  emitDataParallelKernelCall(builder, kernelFunc, buffers, numElements);
   // Emit debug info for the generated data-parallel kernel.
   generateFunctionDebugInfo(kernelFunc);
 }
 
+void LLVMIRGen::emitDataParallelKernelCall(
+    llvm::IRBuilder<> &builder, llvm::Function *kernel,
+    llvm::ArrayRef<llvm::Value *> buffers, dim_t numElements) {
+  auto *numElementsVal = builder.getIntN(DIM_T_BITWIDTH, numElements);
+  const dim_t taskSize = dataParallelTaskSize;
+  const dim_t numTasks = taskSize ? (numElements + taskSize - 1) / taskSize : 1;
+  if (numTasks <= 1) {
+    llvm::SmallVector<llvm::Value *, 32> args(buffers.begin(), buffers.end());
+    args.push_back(builder.getIntN(DIM_T_BITWIDTH, 0));
+    args.push_back(numElementsVal);
+    createUncheckedCall(builder, kernel, args);
+    return;
+  }
+
+  // The tasks get the buffers of the kernel in an array, which they pass on
+  // to the kernel with the range of elements of the task.
+  auto *dimTTy = builder.getIntNTy(DIM_T_BITWIDTH);
+  auto *int8PtrTy = builder.getInt8PtrTy();
+  auto *taskTy = llvm::FunctionType::get(
+      builder.getVoidTy(), {int8PtrTy, dimTTy, dimTTy}, /* isVarArg */ false);
+  auto *task =
+      llvm::Function::Create(taskTy, llvm::Function::InternalLinkage,
+                             "libjit_stacked_kernel_task", llmodule_.get());
+  llvm::IRBuilder<> taskBuilder(
+      llvm::BasicBlock::Create(getLLVMContext(), "entry", task));
+  llvm::Value *taskArgs = task->args().begin();
+  auto *bufferArray =
+      taskBuilder.CreateBitCast(taskArgs, int8PtrTy->getPointerTo());
+  llvm::SmallVector<llvm::Value *, 32> args;
+  for (size_t i = 0, e = buffers.size(); i < e; i++) {
+    auto *addr = taskBuilder.CreateConstInBoundsGEP1_64(int8PtrTy, bufferArray,
+                                                        i);
+    args.push_back(taskBuilder.CreateBitCast(
+        taskBuilder.CreateLoad(int8PtrTy, addr), buffers[i]->getType()));
+  }
+  auto *taskSizeVal = taskBuilder.getIntN(DIM_T_BITWIDTH, taskSize);
+  args.push_back(
+      taskBuilder.CreateMul(task->args().begin() + 1, taskSizeVal, "begin"));
+  auto *end = taskBuilder.CreateMul(task->args().begin() + 2, taskSizeVal);
+  args.push_back(taskBuilder.CreateSelect(
+      taskBuilder.CreateICmpULT(end, numElementsVal), end, numElementsVal,
+      "end"));
+  createUncheckedCall(taskBuilder, kernel, args);
+  taskBuilder.CreateRetVoid();
+
+  // The array of buffers is allocated once in the entry block of the caller.
+  llvm::BasicBlock &callerEntryBB =
+      builder.GetInsertBlock()->getParent()->getEntryBlock();
+  llvm::IRBuilder<> allocaBuilder(&callerEntryBB, callerEntryBB.begin());
+  auto *bufferArrayTy = llvm::ArrayType::get(int8PtrTy, buffers.size());
+  auto *callerBufferArray =
+      allocaBuilder.CreateAlloca(bufferArrayTy, nullptr, "kernel.buffers");
+  for (size_t i = 0, e = buffers.size(); i < e; i++) {
+    auto *addr = builder.CreateConstInBoundsGEP2_64(bufferArrayTy,
+                                                    callerBufferArray, 0, i);
+    builder.CreateStore(builder.CreateBitCast(buffers[i], int8PtrTy), addr);
+  }
+  auto *parallelFor = getFunction("parallel_for");
+  auto *parallelForTy = parallelFor->getFunctionType();
+  createUncheckedCall(
+      builder, parallelFor,
+      {builder.getIntN(DIM_T_BITWIDTH, numTasks),
+       builder.CreateBitCast(task, parallelForTy->getParamType(1)),
+       builder.CreateBitCast(callerBufferArray,
+                             parallelForTy->getParamType(2))});
+  generateFunctionDebugInfo(task);
+}
+
 /// Emit the function that implements a data-parallel kernel and calls it.
 ///
 /// The generated kernel functions get buffers as their parameters. The buffers
@@ -1046,13 +1321,21 @@ void LLVMIRGen::emitDataParallelKernel(
 /// \param allocationsInfo information about allocations
 /// \param bundle current bundle of stacked instructions
 /// \param op the operand to be checked for overlaps with the \p bundle.
+/// \param I the instruction \p op belongs to.
 static bool isOverlappingWithAnyBundleBufferOperands(
     AllocationsInfo &allocationsInfo,
-    llvm::SmallVectorImpl<const Instruction *> &bundle,
+    llvm::SmallVectorImpl<const Instruction *> &bundle, const Instruction *I,
     const Instruction::Operand &op) {
   auto *buf = op.first;
   auto addr1 = allocationsInfo.allocatedAddress_[buf];
   auto size1 = buf->getSizeInBytes();
+  const size_t numElements =
+      bundle.empty() ? 0 : bundle[0]->getOperand(0).first->size();
+  // Instructions using an operand of the size of the kernel at other indices
+  // than the loop index.
+  auto hasNonElementwiseOperand = [](const Instruction *I) {
+    return isa<IntLookupTableInst>(I) || isa<LookupTableInst>(I);
+  };
   for (auto bi : bundle) {
     for (auto bop : bi->getOperands()) {
       // Only input operands never interfere.
@@ -1060,6 +1343,13 @@ static bool isOverlappingWithAnyBundleBufferOperands(
         continue;
       }
       auto buf2 = bop.first;
+      // The same buffer is passed once to the kernel, e.g. for instructions
+      // computing in-place after ShareBuffers, and only its element at the
+      // loop index is accessed by the instructions of the kernel.
+      if (buf == buf2 && buf->size() == numElements &&
+          !hasNonElementwiseOperand(I) && !hasNonElementwiseOperand(bi)) {
+        continue;
+      }
       auto addr2 = allocationsInfo.allocatedAddress_[buf2];
       auto size2 = buf2->getSizeInBytes();
       if (addr1 == addr2 && size1 == size2) {
@@ -1067,8 +1357,6 @@ static bool isOverlappingWithAnyBundleBufferOperands(
         // cannot be within the same bundle because the buffer pointers are
         // "noalias" qualified, so the kernel operations can be reordered by
         // LLVM's optimizations.
-        // TODO investigate if removing "noalias" can be used to create bigger
-        // and faster bundles.
         return true;
       }
       if ((addr1 >= addr2 && addr1 < addr2 + size2) ||
@@ -1091,62 +1379,141 @@ template <typename T, typename... Args> bool matchPair(T a, T b, Args... args) {
   return a == b || matchPair(a, args...);
 }
 
+/// \returns whether the data parallel instruction \p I can be added to the
+/// bundle \p bundle of data parallel instructions.
+static bool
+isBundleCompatible(AllocationsInfo &allocationsInfo,
+                   llvm::SmallVectorImpl<const Instruction *> &bundle,
+                   const Instruction *I) {
+  if (bundle.empty()) {
+    return true;
+  }
+  // Check if shapes have the same amount of elements.
+  if (I->getOperand(0).first->size() !=
+      bundle.back()->getOperand(0).first->size()) {
+    return false;
+  }
+
+  // Check all mutated operands of the current instruction. Their memory
+  // regions should not have a non-exact overlap with any operands of the
+  // bundled instructions. In case this condition does not hold, the current
+  // instruction cannot be included into the data-parallel bundle, because
+  // overlapping operand buffers are not data parallel.
+  for (auto &op : I->getOperands()) {
+    // If the mutated operand buffer overlaps with any buffer already used by
+    // the bundle, the current instruction cannot become a part of the bundle.
+    if (isOverlappingWithAnyBundleBufferOperands(allocationsInfo, bundle, I,
+                                                 op)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// \returns whether \p I and \p J access overlapping memory regions, at least
+/// one of them writing it, so that their order matters.
+static bool hasMemoryDependency(AllocationsInfo &allocationsInfo,
+                                const Instruction *I, const Instruction *J) {
+  for (const auto &op1 : I->getOperands()) {
+    auto addr1 = allocationsInfo.allocatedAddress_[op1.first];
+    auto size1 = op1.first->getSizeInBytes();
+    for (const auto &op2 : J->getOperands()) {
+      if (op1.second == OperandKind::In && op2.second == OperandKind::In) {
+        continue;
+      }
+      // Addresses are relative to the memory area of the buffers, so buffers
+      // of different areas may conservatively be found to overlap.
+      auto addr2 = allocationsInfo.allocatedAddress_[op2.first];
+      auto size2 = op2.first->getSizeInBytes();
+      if (addr1 < addr2 + size2 && addr2 < addr1 + size1) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/// \returns whether instructions can not be moved across \p I, because of its
+/// side effects.
+static bool isSchedulingBarrier(const Instruction *I) {
+  return isa<TraceEventInst>(I) || isa<DebugPrintInst>(I) ||
+         isa<InstrumentInst>(I);
+}
+
+/// \returns whether \p I has no code generated for it.
+static bool isMemoryManagementInstr(const Instruction *I) {
+  return isa<AllocActivationInst>(I) || isa<DeallocActivationInst>(I) ||
+         isa<TensorViewInst>(I);
+}
+
+void LLVMIRGen::scheduleDataParallelInstrs(
+    llvm::SmallVectorImpl<const Instruction *> &order) {
+  // Instructions of the last bundle in order, which are also the instructions
+  // of order from bundleEnd - bundle.size() that are data parallel.
+  llvm::SmallVector<const Instruction *, 32> bundle;
+  // Position in order after the last instruction of the bundle.
+  size_t bundleEnd = 0;
+  for (auto &I : F_->getInstrs()) {
+    if (!fuseDataParallelInstrs || !canBePartOfDataParallelKernel(&I)) {
+      order.push_back(&I);
+      if (isSchedulingBarrier(&I)) {
+        bundle.clear();
+      }
+      continue;
+    }
+    // Move the instruction right after the last bundle if no instruction
+    // since then depends on it, e.g. the epilogue of an operator whose
+    // instructions were interleaved with others by the scheduler.
+    bool canJoinBundle =
+        !bundle.empty() && isBundleCompatible(allocationsInfo_, bundle, &I);
+    for (size_t pos = bundleEnd; canJoinBundle && pos < order.size(); pos++) {
+      canJoinBundle = isMemoryManagementInstr(order[pos]) ||
+                      !hasMemoryDependency(allocationsInfo_, &I, order[pos]);
+    }
+    if (canJoinBundle) {
+      order.insert(order.begin() + bundleEnd, &I);
+      bundle.push_back(&I);
+      bundleEnd++;
+      continue;
+    }
+    order.push_back(&I);
+    bundle.clear();
+    bundle.push_back(&I);
+    bundleEnd = order.size();
+  }
+}
+
 void LLVMIRGen::generateLLVMIRForModule(llvm::IRBuilder<> &builder) {
   // Go over the instructions and try to group them into bundles.
-  auto &instrs = F_->getInstrs();
+  llvm::SmallVector<const Instruction *, 32> instrs;
+  scheduleDataParallelInstrs(instrs);
 
   // Group instructions into bundles of shape compatible data parallel
   // instructions and emit them.
   llvm::SmallVector<const Instruction *, 32> bundle;
-  for (auto &I : instrs) {
-    if (!canBePartOfDataParallelKernel(&I)) {
+  for (auto *I : instrs) {
+    if (!canBePartOfDataParallelKernel(I)) {
       // Ignore memory management instructions as they are handled by the
       // MemoryManager and are NOPs for a JIT.
-      if (isa<AllocActivationInst>(&I) || isa<DeallocActivationInst>(&I) ||
-          isa<TensorViewInst>(&I)) {
-        generateLLVMIRForInstr(builder, &I);
+      if (isMemoryManagementInstr(I)) {
+        generateLLVMIRForInstr(builder, I);
         continue;
       }
       emitDataParallelKernel(builder, bundle);
       bundle.clear();
-      generateLLVMIRForInstr(builder, &I);
+      generateLLVMIRForInstr(builder, I);
       continue;
     }
 
-    // This is a data parallel instruction.
-
-    // Check if the current instruction is shape compatible with the bundle.
-    bool isBundleCompatible = true;
-    if (!bundle.empty()) {
-      auto val = I.getOperand(0).first;
-      auto bundleVal = bundle.back()->getOperand(0).first;
-      // Check if shapes have the same amount of elements.
-      isBundleCompatible = val->size() == bundleVal->size();
-    }
-
-    // Check all mutated operands of the current instruction. Their memory
-    // regions should not have a non-exact overlap with any operands of the
-    // bundled instructions. In case this condition does not hold, the current
-    // instruction cannot be included into the data-parallel bundle, because
-    // overlapping operand buffers are not data parallel.
-    for (auto &op : I.getOperands()) {
-      // If the mutated operand buffer overlaps with any buffer already used by
-      // the bundle, the current instruction cannot become a part of the bundle.
-      if (isOverlappingWithAnyBundleBufferOperands(allocationsInfo_, bundle,
-                                                   op)) {
-        isBundleCompatible = false;
-        break;
-      }
-    }
-
-    // If the instruction cannot be added to the current bundle, emit the kernel
-    // for the current bundle and start a new bundle.
-    if (!isBundleCompatible) {
+    // This is a data parallel instruction. If the instruction cannot be added
+    // to the current bundle, emit the kernel for the current bundle and start
+    // a new bundle.
+    if (!isBundleCompatible(allocationsInfo_, bundle, I)) {
       emitDataParallelKernel(builder, bundle);
       bundle.clear();
     }
     // Add a data parallel instruction to the bundle.
-    bundle.push_back(&I);
+    bundle.push_back(I);
   }
 
   emitDataParallelKernel(builder, bundle);
@@ -1478,6 +1845,27 @@ void LLVMIRGen::generateLLVMIRForDataParallelInstr(
     break;
   }
 
+  case Kinded::Kind::GeluInstKind: {
+    auto *GI = cast<GeluInst>(I);
+    auto *src = GI->getSrc();
+    auto *dest = GI->getDest();
+    auto *srcPtr = emitBufferAddress(builder, src, kernel, bufferToArgNum);
+    auto *destPtr = emitBufferAddress(builder, dest, kernel, bufferToArgNum);
+
+    auto *F = getFunction("element_gelu", dest->getElementType());
+    llvm::CallInst *stackedOpCall = nullptr;
+    if (dest->getElementType() == ElemKind::FloatTy) {
+      stackedOpCall = createCall(builder, F, {loopCount, srcPtr});
+    } else {
+      LOG(FATAL) << "Type is not supported";
+    }
+    auto *elementTy = getElementType(builder, dest);
+    auto *destAddr =
+        builder.CreateGEP(elementTy, destPtr, loopCount, "buffer.element.addr");
+    builder.CreateStore(stackedOpCall, destAddr);
+    break;
+  }
+
   case Kinded::Kind::ElementIsNaNInstKind: {
     auto *AN = cast<ElementIsNaNInst>(I);
     auto *src = AN->getSrc();
@@ -1636,10 +2024,14 @@ void LLVMIRGen::generateLLVMIRForDataParallelInstr(
     break;                                                                     \
   }
     ARITHMETIC_BINARY_OP_CASE(ElementAdd, "element_add", ElemKind::FloatTy,
-                              ElemKind::Int32ITy, ElemKind::Int64ITy);
-    ARITHMETIC_BINARY_OP_CASE(ElementSub, "element_sub", ElemKind::FloatTy);
-    ARITHMETIC_BINARY_OP_CASE(ElementMax, "element_max", ElemKind::FloatTy);
-    ARITHMETIC_BINARY_OP_CASE(ElementMin, "element_min", ElemKind::FloatTy);
+                              ElemKind::BFloat16Ty, ElemKind::Int32ITy,
+                              ElemKind::Int64ITy);
+    ARITHMETIC_BINARY_OP_CASE(ElementSub, "element_sub", ElemKind::FloatTy,
+                              ElemKind::BFloat16Ty);
+    ARITHMETIC_BINARY_OP_CASE(ElementMax, "element_max", ElemKind::FloatTy,
+                              ElemKind::BFloat16Ty);
+    ARITHMETIC_BINARY_OP_CASE(ElementMin, "element_min", ElemKind::FloatTy,
+                              ElemKind::BFloat16Ty);
     ARITHMETIC_BINARY_OP_CASE(ElementPow, "element_pow", ElemKind::FloatTy);
 #undef ARITHMETIC_BINARY_OP_CASE
 
@@ -1833,7 +2225,8 @@ void LLVMIRGen::generateLLVMIRForDataParallelInstr(
       builder.CreateStore(stackedOpCall, destAddr);
     } else if (lhs->getType()->getElementType() == ElemKind::Int64ITy ||
                lhs->getType()->getElementType() == ElemKind::Int32ITy ||
-               lhs->getType()->getElementType() == ElemKind::FloatTy) {
+               lhs->getType()->getElementType() == ElemKind::FloatTy ||
+               lhs->getType()->getElementType() == ElemKind::BFloat16Ty) {
       auto *stackedOpCall = createUncheckedCall(
           builder, F, {loopCount, lhsPtr, rhsPtr, pointerNull});
       auto *destAddr = builder.CreateGEP(elementTy, destPtr, loopCount,
@@ -1974,7 +2367,15 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *lhsDims = emitValueDims(builder, lhs);
     auto *rhsDims = emitValueDims(builder, rhs);
 
-    auto *F = getFunction("matmul", dest->getElementType());
+    std::string kernelName = "matmul";
+    if (dest->getElementType() == ElemKind::FloatTy) {
+      kernelName = getMatMulKernelName();
+    } else if (dest->getElementType() == ElemKind::Int8QTy) {
+      kernelName = getInt8KernelName(kernelName, {ElemKind::Int8QTy});
+    } else if (dest->getElementType() == ElemKind::BFloat16Ty) {
+      kernelName = getBFloat16KernelName(kernelName);
+    }
+    auto *F = getFunction(kernelName, dest->getElementType());
 
     if (lhs->getType()->isQuantizedType()) {
       auto *destTy = dest->getType();
@@ -2069,15 +2470,24 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
       auto *outPost = emitConstI32(builder, outScaleParam.post);
       auto *outScale = emitConstI32(builder, outScaleParam.scale);
 
-      auto *F =
-          getFunction("fc", {dest->getElementType(), bias->getElementType()});
+      llvm::SmallVector<ElemKind, 2> elemTys = {dest->getElementType(),
+                                                bias->getElementType()};
+      std::string kernelName = "fc";
+      if (dest->getElementType() == ElemKind::Int8QTy) {
+        kernelName = getInt8KernelName(kernelName, elemTys);
+      }
+      auto *F = getFunction(kernelName, elemTys);
       createCall(builder, F,
                  {destPtr, srcPtr, weightsPtr, biasPtr, destDims, srcDims,
                   weightsDims, biasDims, destOffset, srcOffset, weightsOffset,
                   biasOffset, biasPre, biasPost, biasScale, outPre, outPost,
                   outScale});
     } else {
-      auto *F = getFunction("fc", dest->getElementType());
+      std::string kernelName = "fc";
+      if (dest->getElementType() == ElemKind::BFloat16Ty) {
+        kernelName = getBFloat16KernelName(kernelName);
+      }
+      auto *F = getFunction(kernelName, dest->getElementType());
       createCall(builder, F,
                  {destPtr, srcPtr, weightsPtr, biasPtr, destDims, srcDims,
                   weightsDims, biasDims});
@@ -2439,8 +2849,19 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
       // Emit parameters for fused activation.
       auto *actArgsQuant = emitConstQuantActivationArgs(builder, CI);
 
-      auto *F = getFunction("conv2d",
-                            {dest->getElementType(), bias->getElementType()});
+      // Depthwise convolutions have their own kernel unless the target has
+      // a variant of the generic one.
+      std::string name = getInt8KernelName(
+          "conv2d", {dest->getElementType(), bias->getElementType()});
+      if (name == "conv2d" &&
+          useDepthwiseConv2dKernel(
+              *llmodule_, "depthwise_conv2d",
+              {dest->getElementType(), bias->getElementType()}, src->dims(),
+              dest->dims(), CI->getKernels(), CI->getGroup())) {
+        name = "depthwise_conv2d";
+      }
+      auto *F =
+          getFunction(name, {dest->getElementType(), bias->getElementType()});
 
       createCall(builder, F,
                  {destPtr,     srcPtr,     filterPtr,  biasPtr,   destDims,
@@ -2454,7 +2875,14 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
       // Emit parameters for fused activation.
       auto *actArgsFloat = emitConstFloatActivationArgs(builder, CI);
 
-      auto *F = getFunction("conv2d", dest->getElementType());
+      auto *F = getFunction(
+          useDepthwiseConv2dKernel(*llmodule_, "depthwise_conv2d",
+                                   {dest->getElementType()}, src->dims(),
+                                   dest->dims(), CI->getKernels(),
+                                   CI->getGroup())
+              ? "depthwise_conv2d"
+              : "conv2d",
+          dest->getElementType());
 
       createCall(builder, F,
                  {destPtr, srcPtr, filterPtr, biasPtr, destDims, srcDims,
@@ -2645,9 +3073,21 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
         emitConstArray(builder, outputScaleV, builder.getInt32Ty());
 
     bool isConv3D = (srcTy->dims().size() == 5);
-    auto *F = getFunction(isConv3D ? "channelwise_quantized_conv3d"
-                                   : "channelwise_quantized_conv2d",
-                          {dest->getElementType(), bias->getElementType()});
+    std::string name = "channelwise_quantized_conv3d";
+    if (!isConv3D) {
+      name = getInt8KernelName(
+          "channelwise_quantized_conv2d",
+          {dest->getElementType(), bias->getElementType()});
+    }
+    if (name == "channelwise_quantized_conv2d" &&
+        useDepthwiseConv2dKernel(
+            *llmodule_, "channelwise_quantized_depthwise_conv2d",
+            {dest->getElementType(), bias->getElementType()}, src->dims(),
+            dest->dims(), CQCI->getKernels(), CQCI->getGroup())) {
+      name = "channelwise_quantized_depthwise_conv2d";
+    }
+    auto *F =
+        getFunction(name, {dest->getElementType(), bias->getElementType()});
 
     auto *actType = emitConstI32(builder, CQCI->getFusedActivation());
     auto *actArgsQuant = emitConstQuantActivationArgs(builder, CQCI);
@@ -2778,7 +3218,11 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *strides = emitConstDimTArray(builder, PM->getStrides());
     auto *pads = emitConstDimTArray(builder, PM->getPads());
 
-    auto *F = getFunction("max_pool", dest->getElementType());
+    std::string kernelName = "max_pool";
+    if (src->getType()->isQuantizedType()) {
+      kernelName = getInt8KernelName(kernelName, dest->getElementType());
+    }
+    auto *F = getFunction(kernelName, dest->getElementType());
 
     if (src->getType()->isQuantizedType()) {
       auto *destOffset = emitConstI32(builder, dest->getType()->getOffset());
@@ -2883,7 +3327,11 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *pads = emitConstDimTArray(builder, PA->getPads());
     auto *countIncludePads = emitConstI1(builder, PA->getCountIncludePads());
 
-    auto *F = getFunction("avg_pool", dest->getElementType());
+    std::string kernelName = "avg_pool";
+    if (src->getType()->isQuantizedType()) {
+      kernelName = getInt8KernelName(kernelName, dest->getElementType());
+    }
+    auto *F = getFunction(kernelName, dest->getElementType());
 
     if (src->getType()->isQuantizedType()) {
       auto *destTy = dest->getType();
@@ -2996,6 +3444,25 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::LayerNormalizationInstKind: {
+    auto *LN = cast<LayerNormalizationInst>(I);
+    auto *dest = LN->getDest();
+    auto *src = LN->getSrc();
+    auto *scale = LN->getScale();
+    auto *destPtr = emitValueAddress(builder, dest);
+    auto *srcPtr = emitValueAddress(builder, src);
+    auto *scalePtr = emitValueAddress(builder, scale);
+    auto *biasPtr = emitValueAddress(builder, LN->getBias());
+    // Each row of the Src is normalized over as many elements as the Scale.
+    auto *numRows = emitConstDimT(builder, src->size() / scale->size());
+    auto *rowSize = emitConstDimT(builder, scale->size());
+    auto *epsilon = emitConstF32(builder, LN->getEpsilon());
+    auto *F = getFunction("layer_norm", dest->getElementType());
+    createCall(builder, F,
+               {destPtr, srcPtr, scalePtr, biasPtr, numRows, rowSize, epsilon});
+    break;
+  }
+
   case Kinded::Kind::SoftMaxGradInstKind: {
     auto *SMG = cast<SoftMaxGradInst>(I);
     auto *srcGrad = SMG->getSrcGrad();
@@ -3014,6 +3481,39 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::FusedSGDInstKind: {
+    auto *SGD = cast<FusedSGDInst>(I);
+    auto *weight = SGD->getWeight();
+    auto *F = getFunction("fused_sgd", weight->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, SGD->getUpdatedWeight()),
+                emitValueAddress(builder, SGD->getUpdatedVelocity()),
+                emitValueAddress(builder, SGD->getGradient()),
+                emitValueAddress(builder, weight),
+                emitValueAddress(builder, SGD->getVelocity()),
+                emitConstDimT(builder, weight->size()),
+                emitConstF32(builder, SGD->getL1Decay()),
+                emitConstF32(builder, SGD->getL2Decay()),
+                emitConstF32(builder, SGD->getLearningRate()),
+                emitConstF32(builder, SGD->getMomentum()),
+                emitConstDimT(builder, SGD->getBatchSize())});
+    break;
+  }
+
+  case Kinded::Kind::LSTMUnitInstKind: {
+    auto *LU = cast<LSTMUnitInst>(I);
+    auto *C = LU->getC();
+    auto *F = getFunction("lstm_unit", C->getElementType());
+    createCall(builder, F,
+               {emitValueAddress(builder, LU->getnewC()),
+                emitValueAddress(builder, LU->getnewH()),
+                emitValueAddress(builder, LU->getInput()),
+                emitValueAddress(builder, C),
+                emitConstDimT(builder, C->dims()[0]),
+                emitConstDimT(builder, C->dims()[1])});
+    break;
+  }
+
   case Kinded::Kind::TopKInstKind: {
     auto *TI = cast<TopKInst>(I);
     auto *input = TI->getInput();
@@ -3034,6 +3534,32 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     break;
   }
 
+  case Kinded::Kind::BeamSearchStepInstKind: {
+    auto *BSS = cast<BeamSearchStepInst>(I);
+    auto *logits = BSS->getLogits();
+    auto *state = BSS->getState();
+    auto *int8PtrTy = builder.getInt8PtrTy();
+    auto *F = getFunction("beam_search_step",
+                          {logits->getElementType(),
+                           BSS->getTokens()->getElementType()});
+    createCall(
+        builder, F,
+        {emitValueAddress(builder, BSS->getNewScores()),
+         emitValueAddress(builder, BSS->getTokens()),
+         emitValueAddress(builder, BSS->getPrevIndices()),
+         builder.CreateBitCast(emitValueAddress(builder, BSS->getNewState()),
+                               int8PtrTy),
+         emitValueAddress(builder, logits),
+         emitValueAddress(builder, BSS->getScores()),
+         builder.CreateBitCast(emitValueAddress(builder, state), int8PtrTy),
+         emitValueAddress(builder, BSS->getScratch()),
+         emitConstDimT(builder, logits->dims()[0]),
+         emitConstDimT(builder, logits->dims()[1]),
+         emitConstDimT(builder,
+                       state->getSizeInBytes() / logits->dims()[0])});
+    break;
+  }
+
   case Kinded::Kind::SpaceToDepthInstKind: {
     auto *SI = cast<SpaceToDepthInst>(I);
     auto *dest = SI->getDest();
@@ -3370,7 +3896,12 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *lengthsPtr = emitValueAddress(builder, lengths);
     auto *segments = emitConstDimT(builder, lengths->dims()[0]);
     auto *lineSize = emitConstDimT(builder, data->size() / data->dims()[0]);
-    auto *F = getFunction("sparse_lengths_sum",
+    std::string kernelName = "sparse_lengths_sum";
+    if (dest->getElementType() == ElemKind::Float16Ty) {
+      kernelName = getFloat16KernelName(
+          kernelName, {dest->getElementType(), indices->getElementType()});
+    }
+    auto *F = getFunction(kernelName,
                           {dest->getElementType(), indices->getElementType()});
     createCall(builder, F,
                {destPtr, dataPtr, indicesPtr, lengthsPtr, segments, lineSize});
@@ -3391,7 +3922,12 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *lengthsPtr = emitValueAddress(builder, lengths);
     auto *segments = emitConstDimT(builder, lengths->dims()[0]);
     auto *lineSize = emitConstDimT(builder, data->size() / data->dims()[0]);
-    auto *F = getFunction("sparse_lengths_weighted_sum",
+    std::string kernelName = "sparse_lengths_weighted_sum";
+    if (dest->getElementType() == ElemKind::Float16Ty) {
+      kernelName = getFloat16KernelName(
+          kernelName, {dest->getElementType(), indices->getElementType()});
+    }
+    auto *F = getFunction(kernelName,
                           {dest->getElementType(), indices->getElementType()});
     createCall(builder, F,
                {destPtr, dataPtr, weightsPtr, indicesPtr, lengthsPtr, segments,
@@ -3438,7 +3974,11 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *segments = emitConstDimT(builder, offsets->dims()[0]);
     auto *totalLength = emitConstDimT(builder, indices->dims()[0]);
     auto *lineSize = emitConstDimT(builder, data->size() / data->dims()[0]);
-    auto *F = getFunction("embedding_bag", dest->getElementType());
+    std::string kernelName = "embedding_bag";
+    if (dest->getElementType() == ElemKind::Float16Ty) {
+      kernelName = getFloat16KernelName(kernelName, dest->getElementType());
+    }
+    auto *F = getFunction(kernelName, dest->getElementType());
     createCall(builder, F,
                {destPtr, dataPtr, weightsPtr, indicesPtr, offsetsPtr, segments,
                 lineSize, totalLength, hasEndOffset});
@@ -3516,7 +4056,11 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *segments = emitConstDimT(builder, lengths->dims()[0]);
     auto *inLineSize = emitConstDimT(builder, data->size() / data->dims()[0]);
     auto *outLineSize = emitConstDimT(builder, dest->size() / dest->dims()[0]);
-    auto *F = getFunction("fused_rowwise_quantized_sparse_lengths_weighted_sum",
+    const char *kernelName =
+        data->getElementType() == ElemKind::UInt4FusedQTy
+            ? "fused_rowwise_quantized_4bit_sparse_lengths_weighted_sum"
+            : "fused_rowwise_quantized_sparse_lengths_weighted_sum";
+    auto *F = getFunction(kernelName,
                           {dest->getElementType(), indices->getElementType()});
     createCall(builder, F,
                {destPtr, dataPtr, weightsPtr, indicesPtr, lengthsPtr, segments,
@@ -3709,6 +4253,15 @@ void LLVMIRGen::generateLLVMIRForInstr(llvm::IRBuilder<> &builder,
     auto *data = TEI->getData();
     auto *offset = emitConstDimT(builder, TEI->getIndex());
     auto *dataPtr = emitValueAddress(builder, data);
+    // Rows wider than a timestamp also hold hardware counters, see
+    // BackendOptions::autoInstrumentCounters.
+    dim_t rowSize = data->dims().size() > 1 ? data->dims()[1] : 1;
+    if (rowSize > 1) {
+      auto *F = getFunction("write_counters");
+      createCall(builder, F,
+                 {dataPtr, offset, emitConstDimT(builder, rowSize)});
+      break;
+    }
     auto *F = getFunction("write_timestamp");
     createCall(builder, F, {dataPtr, offset});
     break;
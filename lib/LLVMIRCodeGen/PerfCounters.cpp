@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/LLVMIRCodeGen/PerfCounters.h"
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DynamicLibrary.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace glow;
+
+namespace {
+/// Names of the counters, in the order they are read.
+const char *const perfCounterNames[] = {"cycles", "instructions",
+                                        "llc_misses"};
+constexpr size_t numPerfCounters =
+    sizeof(perfCounterNames) / sizeof(perfCounterNames[0]);
+
+#ifdef __linux__
+/// The counters of a thread, read together as a perf_event group.
+class ThreadPerfCounters {
+  /// The file descriptor of the group leader, -1 if it can't be opened.
+  int leader_{-1};
+
+  /// The file descriptors of the other members of the group.
+  int members_[numPerfCounters - 1];
+
+  /// Opens the counter \p config in the group of \p groupFd, -1 for a new
+  /// group. \returns its file descriptor, -1 on error.
+  static int open(uint64_t config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, /* pid */ 0, /* cpu */ -1,
+                   groupFd, /* flags */ 0);
+  }
+
+public:
+  ThreadPerfCounters() {
+    static const uint64_t configs[] = {PERF_COUNT_HW_CPU_CYCLES,
+                                       PERF_COUNT_HW_INSTRUCTIONS,
+                                       PERF_COUNT_HW_CACHE_MISSES};
+    leader_ = open(configs[0], -1);
+    if (leader_ < 0) {
+      LOG_FIRST_N(WARNING, 1)
+          << "Unable to open the hardware performance counters, they will "
+             "read as 0. Check /proc/sys/kernel/perf_event_paranoid.";
+      return;
+    }
+    for (size_t i = 1; i < numPerfCounters; i++) {
+      members_[i - 1] = open(configs[i], leader_);
+    }
+    ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  ~ThreadPerfCounters() {
+    if (leader_ < 0) {
+      return;
+    }
+    for (int fd : members_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    close(leader_);
+  }
+
+  /// Writes to \p counters the first \p numCounters counters.
+  void read(uint64_t *counters, uint64_t numCounters) {
+    memset(counters, 0, numCounters * sizeof(uint64_t));
+    if (leader_ < 0) {
+      return;
+    }
+    // The group is read as its number of counters followed by their values,
+    // in the order they were opened. Members that failed to open are absent.
+    uint64_t values[1 + numPerfCounters];
+    ssize_t size = ::read(leader_, values, sizeof(values));
+    if (size < (ssize_t)sizeof(uint64_t)) {
+      return;
+    }
+    uint64_t next = 1;
+    for (uint64_t i = 0; i < numCounters && i < numPerfCounters; i++) {
+      if (i == 0 || members_[i - 1] >= 0) {
+        counters[i] = next <= values[0] ? values[next] : 0;
+        next++;
+      }
+    }
+  }
+};
+#endif
+} // namespace
+
+llvm::ArrayRef<const char *> glow::getPerfCounterNames() {
+  return perfCounterNames;
+}
+
+void glow::registerPerfCountersSymbol() {
+  llvm::sys::DynamicLibrary::AddSymbol(
+      "glow_read_perf_counters",
+      reinterpret_cast<void *>(&glow_read_perf_counters));
+}
+
+extern "C" void glow_read_perf_counters(uint64_t *counters,
+                                        uint64_t numCounters) {
+#ifdef __linux__
+  thread_local ThreadPerfCounters threadCounters;
+  threadCounters.read(counters, numCounters);
+#else
+  memset(counters, 0, numCounters * sizeof(uint64_t));
+#endif
+}
@@ -58,6 +58,12 @@ bool LLVMIRGen::preserveSymbol(const llvm::GlobalValue &GV) {
   // start with libjit_.
   if (name.empty() || name.startswith("libjit_"))
     return false;
+  // The parallel runtime and the weights decoder of bundles are only kept
+  // when requested.
+  if (name.startswith("glow_parallel_runtime_"))
+    return preserveParallelRuntime_;
+  if (name.startswith("glow_weights_"))
+    return preserveWeightsDecompressor_;
   return true;
 }
 
@@ -0,0 +1,189 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/LLVMIRCodeGen/WeightsCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <queue>
+
+using namespace glow;
+
+namespace {
+
+/// Maximum length of a Huffman code, so that lengths fit in a nibble.
+constexpr unsigned kMaxCodeLength = 15;
+
+void putU32(std::vector<uint8_t> &out, uint32_t val) {
+  for (unsigned i = 0; i < 4; i++) {
+    out.push_back(uint8_t(val >> (8 * i)));
+  }
+}
+
+void putU64(std::vector<uint8_t> &out, uint64_t val) {
+  putU32(out, uint32_t(val));
+  putU32(out, uint32_t(val >> 32));
+}
+
+std::vector<uint8_t> encodeBitmask(llvm::ArrayRef<uint8_t> data) {
+  std::vector<uint8_t> out;
+  for (size_t group = 0; group < data.size(); group += 8) {
+    size_t maskPos = out.size();
+    out.push_back(0);
+    for (size_t i = 0; i < 8 && group + i < data.size(); i++) {
+      if (data[group + i]) {
+        out[maskPos] |= 1 << i;
+        out.push_back(data[group + i]);
+      }
+    }
+  }
+  return out;
+}
+
+/// \returns the Huffman code lengths of the bytes with counts \p freq, at
+/// most kMaxCodeLength. Counts are halved until the tree is shallow enough.
+std::array<uint8_t, 256> getCodeLengths(const std::array<uint64_t, 256> &freq) {
+  std::array<uint8_t, 256> lengths{};
+  for (unsigned shift = 0;; shift++) {
+    lengths.fill(0);
+    using Item = std::pair<uint64_t, unsigned>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    // Nodes 0-255 are the leaves, the others are created while merging.
+    std::vector<unsigned> parent(256, 0);
+    for (unsigned sym = 0; sym < 256; sym++) {
+      if (freq[sym]) {
+        queue.push({std::max<uint64_t>(freq[sym] >> shift, 1), sym});
+      }
+    }
+    if (queue.size() == 1) {
+      lengths[queue.top().second] = 1;
+      return lengths;
+    }
+    while (queue.size() > 1) {
+      Item a = queue.top();
+      queue.pop();
+      Item b = queue.top();
+      queue.pop();
+      unsigned node = parent.size();
+      parent.push_back(node);
+      parent[a.second] = node;
+      parent[b.second] = node;
+      queue.push({a.first + b.first, node});
+    }
+    unsigned root = queue.top().second;
+    unsigned maxLength = 0;
+    for (unsigned sym = 0; sym < 256; sym++) {
+      if (!freq[sym]) {
+        continue;
+      }
+      unsigned length = 0;
+      for (unsigned node = sym; node != root; node = parent[node]) {
+        length++;
+      }
+      lengths[sym] = length;
+      maxLength = std::max(maxLength, length);
+    }
+    if (maxLength <= kMaxCodeLength) {
+      return lengths;
+    }
+  }
+}
+
+std::vector<uint8_t> encodeHuffman(llvm::ArrayRef<uint8_t> data) {
+  std::array<uint64_t, 256> freq{};
+  for (uint8_t byte : data) {
+    freq[byte]++;
+  }
+  std::array<uint8_t, 256> lengths = getCodeLengths(freq);
+
+  // Assign the canonical codes: shorter codes first, then by byte value.
+  std::array<unsigned, kMaxCodeLength + 1> count{};
+  for (uint8_t length : lengths) {
+    count[length]++;
+  }
+  count[0] = 0;
+  std::array<uint32_t, kMaxCodeLength + 2> nextCode{};
+  for (unsigned length = 1; length <= kMaxCodeLength; length++) {
+    nextCode[length + 1] = (nextCode[length] + count[length]) << 1;
+  }
+  std::array<uint32_t, 256> codes{};
+  for (unsigned sym = 0; sym < 256; sym++) {
+    if (lengths[sym]) {
+      codes[sym] = nextCode[lengths[sym]]++;
+    }
+  }
+
+  std::vector<uint8_t> out;
+  for (unsigned sym = 0; sym < 256; sym += 2) {
+    out.push_back(lengths[sym] | (lengths[sym + 1] << 4));
+  }
+  uint8_t bits = 0;
+  unsigned numBits = 0;
+  for (uint8_t byte : data) {
+    for (int bit = lengths[byte] - 1; bit >= 0; bit--) {
+      bits = (bits << 1) | ((codes[byte] >> bit) & 1);
+      if (++numBits == 8) {
+        out.push_back(bits);
+        bits = 0;
+        numBits = 0;
+      }
+    }
+  }
+  if (numBits) {
+    out.push_back(bits << (8 - numBits));
+  }
+  return out;
+}
+
+} // namespace
+
+std::vector<uint8_t> glow::compressWeights(llvm::ArrayRef<uint8_t> data) {
+  std::vector<uint8_t> out;
+  putU32(out, kWeightsMagic);
+  putU32(out, kWeightsVersion);
+  putU64(out, data.size());
+  for (size_t offset = 0; offset < data.size(); offset += kWeightsBlockSize) {
+    auto block =
+        data.slice(offset, std::min(kWeightsBlockSize, data.size() - offset));
+    WeightsBlockMethod method = WeightsBlockMethod::Raw;
+    std::vector<uint8_t> payload(block.begin(), block.end());
+    if (std::all_of(block.begin(), block.end(),
+                    [](uint8_t byte) { return byte == 0; })) {
+      method = WeightsBlockMethod::Zero;
+      payload.clear();
+    } else {
+      std::vector<uint8_t> bitmask = encodeBitmask(block);
+      if (bitmask.size() < payload.size()) {
+        method = WeightsBlockMethod::Bitmask;
+        payload = std::move(bitmask);
+      }
+      std::vector<uint8_t> huffman = encodeHuffman(block);
+      if (huffman.size() < payload.size()) {
+        method = WeightsBlockMethod::Huffman;
+        payload = std::move(huffman);
+      }
+    }
+    out.push_back(uint8_t(method));
+    out.insert(out.end(), 3, 0);
+    putU32(out, block.size());
+    putU32(out, payload.size());
+    putU32(out, 0);
+    putU64(out, offset);
+    out.insert(out.end(), payload.begin(), payload.end());
+  }
+  return out;
+}
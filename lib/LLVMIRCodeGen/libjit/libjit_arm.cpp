@@ -0,0 +1,456 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Int8 kernels for ARM targets, called in place of the generic ones by the
+// LLVM backends when generating code for AArch64, or for ARM with NEON or MVE
+// (see LLVMIRGen::getInt8KernelName). libjit is compiled to bitcode for the
+// host, so the NEON/MVE intrinsics are not available here. Instead the inner
+// loops of these kernels run over contiguous elements with 16-bit operands
+// and 32-bit accumulators, which the LLVM vectorizers map to the widening
+// multiply-accumulate instructions (SMLAL, VMLADAV, ...) once the bundle is
+// compiled for the ARM target. The generic kernels accumulate several output
+// channels across strided filter rows, which does not vectorize.
+// The kernels do not allocate memory, the buffers they need are on the stack.
+
+#include "libjit_defs.h"
+
+namespace {
+
+/// Number of channels (or columns) processed together with accumulators on
+/// the stack.
+constexpr dim_t kBlock = 64;
+
+/// Maximum number of filter elements (kernel height x width) of the depthwise
+/// convolutions whose filter is repacked on the stack.
+constexpr dim_t kMaxDepthwiseWindow = 25;
+
+/// \returns sum((a[i] - aOffset) * (b[i] - bOffset)) for i in [0, n). The
+/// offset values fit in 16 bits since the operands and offsets are int8.
+LIBJIT_ALWAYS_INLINE int32_t libjit_dot_arm_i8(const int8_t *a, int16_t aOffset,
+                                               const int8_t *b, int16_t bOffset,
+                                               dim_t n) {
+  int32_t sum = 0;
+  for (dim_t i = 0; i < n; i++) {
+    int16_t x = int16_t(a[i]) - aOffset;
+    int16_t y = int16_t(b[i]) - bOffset;
+    sum += int32_t(x) * int32_t(y);
+  }
+  return sum;
+}
+
+/// Quantization parameters of a convolution, either per tensor (a stride of
+/// 0 in the arrays) or per output channel.
+struct ConvQuantParams {
+  const int32_t *filterOffsets;
+  const int32_t *biasOffsets;
+  const int32_t *biasPre;
+  const int32_t *biasPost;
+  const int32_t *biasScale;
+  const int32_t *outPre;
+  const int32_t *outPost;
+  const int32_t *outScale;
+  dim_t stride;
+};
+
+/// \returns the output value of channel \p d of a convolution from the
+/// accumulated products \p sum and the bias \p bias.
+LIBJIT_ALWAYS_INLINE int8_t libjit_conv_out_arm_i8(
+    int32_t sum, int32_t bias, dim_t d, const ConvQuantParams &qp,
+    int32_t outOffset, int32_t actType, const int32_t *actArgs) {
+  dim_t p = d * qp.stride;
+  sum += libjit_scale<int32_t>(bias - qp.biasOffsets[p], qp.biasPre[p],
+                               qp.biasPost[p], qp.biasScale[p], 0);
+  int32_t scaledSum = libjit_scale<int32_t>(sum, qp.outPre[p], qp.outPost[p],
+                                            qp.outScale[p], outOffset);
+  scaledSum = libjit_activation_i32(scaledSum, outOffset, actType, actArgs);
+  return libjit_clip_i8(scaledSum);
+}
+
+/// Depthwise convolution, with one output channel per input channel. The
+/// filter of kBlock channels is repacked as [kernel_h][kernel_w][kBlock] with
+/// the filter offsets subtracted so that the channels are innermost.
+template <typename BiasElemTy>
+void libjit_depthwise_conv2d_arm_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const BiasElemTy *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *kernels, const dim_t *strides, const dim_t *pads,
+    const dim_t *dilation, int32_t outOffset, int32_t inOffset,
+    const ConvQuantParams &qp, int32_t actType, const int32_t *actArgs) {
+  dim_t channels = inWdims[3];
+  dim_t kernel_h = kernels[0];
+  dim_t kernel_w = kernels[1];
+  dim_t window = kernel_h * kernel_w;
+  int16_t packed[kMaxDepthwiseWindow * kBlock];
+  int32_t acc[kBlock];
+  for (dim_t c0 = 0; c0 < channels; c0 += kBlock) {
+    dim_t len = MIN(kBlock, channels - c0);
+    for (dim_t f = 0; f < window; f++) {
+      for (dim_t c = 0; c < len; c++) {
+        dim_t p = (c0 + c) * qp.stride;
+        packed[f * kBlock + c] =
+            int16_t(filterW[(c0 + c) * window + f]) - qp.filterOffsets[p];
+      }
+    }
+    for (dim_t n = 0; n < inWdims[0]; n++) {
+      ssize_t x = -(ssize_t)pads[0];
+      for (dim_t ax = 0; ax < outWdims[1]; x += strides[0], ax++) {
+        ssize_t y = -(ssize_t)pads[1];
+        for (dim_t ay = 0; ay < outWdims[2]; y += strides[1], ay++) {
+          for (dim_t c = 0; c < len; c++) {
+            acc[c] = 0;
+          }
+          for (dim_t fx = 0; fx < kernel_h; fx++) {
+            ssize_t ox = x + fx * dilation[0];
+            if (ox < 0 || ox >= (ssize_t)inWdims[1]) {
+              continue;
+            }
+            for (dim_t fy = 0; fy < kernel_w; fy++) {
+              ssize_t oy = y + fy * dilation[1];
+              if (oy < 0 || oy >= (ssize_t)inWdims[2]) {
+                continue;
+              }
+              const int8_t *in =
+                  inW + libjit_getXYZW(inWdims, n, ox, oy, c0);
+              const int16_t *f = packed + (fx * kernel_w + fy) * kBlock;
+              for (dim_t c = 0; c < len; c++) {
+                int16_t v = int16_t(in[c]) - int16_t(inOffset);
+                acc[c] += int32_t(v) * int32_t(f[c]);
+              }
+            }
+          }
+          int8_t *out = outW + libjit_getXYZW(outWdims, n, ax, ay, c0);
+          for (dim_t c = 0; c < len; c++) {
+            out[c] = libjit_conv_out_arm_i8(acc[c], biasW[c0 + c], c0 + c, qp,
+                                            outOffset, actType, actArgs);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Quantized 2D convolution in the NHWC layout. Each output value is the sum
+/// of dot products along the input channels, which are contiguous in both the
+/// input and the filter.
+template <typename BiasElemTy>
+void libjit_conv2d_arm_generic(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const BiasElemTy *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *filterWdims, const dim_t *kernels, const dim_t *strides,
+    const dim_t *pads, dim_t group, const dim_t *dilation, int32_t outOffset,
+    int32_t inOffset, const ConvQuantParams &qp, int32_t actType,
+    const int32_t *actArgs) {
+  dim_t inCperG = inWdims[3] / group;
+  dim_t outCperG = outWdims[3] / group;
+  dim_t kernel_h = kernels[0];
+  dim_t kernel_w = kernels[1];
+  if (inCperG == 1 && outCperG == 1 &&
+      kernel_h * kernel_w <= kMaxDepthwiseWindow) {
+    libjit_depthwise_conv2d_arm_i8(outW, inW, filterW, biasW, outWdims,
+                                   inWdims, kernels, strides, pads, dilation,
+                                   outOffset, inOffset, qp, actType, actArgs);
+    return;
+  }
+  for (dim_t n = 0; n < inWdims[0]; n++) {
+    ssize_t x = -(ssize_t)pads[0];
+    for (dim_t ax = 0; ax < outWdims[1]; x += strides[0], ax++) {
+      ssize_t y = -(ssize_t)pads[1];
+      for (dim_t ay = 0; ay < outWdims[2]; y += strides[1], ay++) {
+        int8_t *out = outW + libjit_getXYZW(outWdims, n, ax, ay, 0);
+        for (dim_t g = 0; g < group; g++) {
+          for (dim_t d = g * outCperG; d < (g + 1) * outCperG; d++) {
+            int16_t filterOffset = qp.filterOffsets[d * qp.stride];
+            int32_t sum = 0;
+            for (dim_t fx = 0; fx < kernel_h; fx++) {
+              ssize_t ox = x + fx * dilation[0];
+              if (ox < 0 || ox >= (ssize_t)inWdims[1]) {
+                continue;
+              }
+              for (dim_t fy = 0; fy < kernel_w; fy++) {
+                ssize_t oy = y + fy * dilation[1];
+                if (oy < 0 || oy >= (ssize_t)inWdims[2]) {
+                  continue;
+                }
+                const int8_t *in =
+                    inW + libjit_getXYZW(inWdims, n, ox, oy, g * inCperG);
+                const int8_t *f =
+                    filterW + libjit_getXYZW(filterWdims, d, fx, fy, 0);
+                sum += libjit_dot_arm_i8(in, inOffset, f, filterOffset,
+                                         inCperG);
+              }
+            }
+            out[d] = libjit_conv_out_arm_i8(sum, biasW[d], d, qp, outOffset,
+                                            actType, actArgs);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// FullyConnected with int8 precision, see libjit_fc_generic. The weights are
+/// [in_w][out_w], so kBlock output columns are accumulated together along
+/// the contiguous rows of the weights.
+template <typename BiasElemTy>
+void libjit_fc_arm_generic(int8_t *outW, const int8_t *inW,
+                           const int8_t *weightsW, const BiasElemTy *biasW,
+                           const dim_t *outWdims, const dim_t *inWdims,
+                           const dim_t *weightsWdims, int32_t outOffset,
+                           int32_t inOffset, int32_t weightsOffset,
+                           int32_t biasOffset, int32_t biasPre,
+                           int32_t biasPost, int32_t biasScale, int32_t outPre,
+                           int32_t outPost, int32_t outScale) {
+  dim_t in_w = inWdims[1];
+  dim_t out_h = outWdims[0];
+  dim_t out_w = outWdims[1];
+  int32_t acc[kBlock];
+  for (dim_t i = 0; i < out_h; i++) {
+    const int8_t *in = inW + i * in_w;
+    for (dim_t j0 = 0; j0 < out_w; j0 += kBlock) {
+      dim_t len = MIN(kBlock, out_w - j0);
+      for (dim_t j = 0; j < len; j++) {
+        acc[j] = 0;
+      }
+      for (dim_t k = 0; k < in_w; k++) {
+        int16_t v = int16_t(in[k]) - int16_t(inOffset);
+        const int8_t *w = weightsW + k * weightsWdims[1] + j0;
+        for (dim_t j = 0; j < len; j++) {
+          int16_t wv = int16_t(w[j]) - int16_t(weightsOffset);
+          acc[j] += int32_t(v) * int32_t(wv);
+        }
+      }
+      int8_t *out = outW + i * out_w + j0;
+      for (dim_t j = 0; j < len; j++) {
+        int32_t sum = acc[j] + libjit_scale<int32_t>(biasW[j0 + j] - biasOffset,
+                                                     biasPre, biasPost,
+                                                     biasScale, 0);
+        out[j] = libjit_clip_i8(
+            libjit_scale<int32_t>(sum, outPre, outPost, outScale, outOffset));
+      }
+    }
+  }
+}
+
+} // namespace
+
+extern "C" {
+
+void libjit_conv2d_arm_i8_i32(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int32_t *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *filterWdims, const dim_t *biasWdims, const dim_t *kernelSizes,
+    const dim_t *strides, const dim_t *pads, dim_t group, int32_t outOffset,
+    int32_t inOffset, int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
+    int32_t biasPost, int32_t biasScale, int32_t outPre, int32_t outPost,
+    int32_t outScale, unsigned depthUnroll, const dim_t *dilation,
+    int32_t actType, const int32_t *actArgs) {
+  ConvQuantParams qp{&filterOffset, &biasOffset, &biasPre, &biasPost,
+                     &biasScale,    &outPre,     &outPost, &outScale,
+                     0};
+  libjit_conv2d_arm_generic(outW, inW, filterW, biasW, outWdims, inWdims,
+                            filterWdims, kernelSizes, strides, pads, group,
+                            dilation, outOffset, inOffset, qp, actType,
+                            actArgs);
+}
+
+void libjit_conv2d_arm_i8_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const dim_t *outWdims, const dim_t *inWdims, const dim_t *filterWdims,
+    const dim_t *biasWdims, const dim_t *kernelSizes, const dim_t *strides,
+    const dim_t *pads, dim_t group, int32_t outOffset, int32_t inOffset,
+    int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
+    int32_t biasPost, int32_t biasScale, int32_t outPre, int32_t outPost,
+    int32_t outScale, unsigned depthUnroll, const dim_t *dilation,
+    int32_t actType, const int32_t *actArgs) {
+  ConvQuantParams qp{&filterOffset, &biasOffset, &biasPre, &biasPost,
+                     &biasScale,    &outPre,     &outPost, &outScale,
+                     0};
+  libjit_conv2d_arm_generic(outW, inW, filterW, biasW, outWdims, inWdims,
+                            filterWdims, kernelSizes, strides, pads, group,
+                            dilation, outOffset, inOffset, qp, actType,
+                            actArgs);
+}
+
+void libjit_channelwise_quantized_conv2d_arm_i8_i32(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int32_t *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *filterWdims, const dim_t *biasWdims, const dim_t *kernels,
+    const dim_t *strides, const dim_t *pads, dim_t group, const dim_t *dilation,
+    int32_t outOffset, int32_t inOffset, int32_t *filterOffsetsPtr,
+    int32_t *biasOffsetsPtr, const int32_t *biasPrePtr,
+    const int32_t *biasPostPtr, const int32_t *biasScalePtr,
+    const int32_t *outPrePtr, const int32_t *outPostPtr,
+    const int32_t *outScalePtr, int32_t actType, const int32_t *actArgs) {
+  ConvQuantParams qp{filterOffsetsPtr, biasOffsetsPtr, biasPrePtr,
+                     biasPostPtr,      biasScalePtr,   outPrePtr,
+                     outPostPtr,       outScalePtr,    1};
+  libjit_conv2d_arm_generic(outW, inW, filterW, biasW, outWdims, inWdims,
+                            filterWdims, kernels, strides, pads, group,
+                            dilation, outOffset, inOffset, qp, actType,
+                            actArgs);
+}
+
+void libjit_channelwise_quantized_conv2d_arm_i8_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const dim_t *outWdims, const dim_t *inWdims, const dim_t *filterWdims,
+    const dim_t *biasWdims, const dim_t *kernels, const dim_t *strides,
+    const dim_t *pads, dim_t group, const dim_t *dilation, int32_t outOffset,
+    int32_t inOffset, int32_t *filterOffsetsPtr, int32_t *biasOffsetsPtr,
+    const int32_t *biasPrePtr, const int32_t *biasPostPtr,
+    const int32_t *biasScalePtr, const int32_t *outPrePtr,
+    const int32_t *outPostPtr, const int32_t *outScalePtr, int32_t actType,
+    const int32_t *actArgs) {
+  ConvQuantParams qp{filterOffsetsPtr, biasOffsetsPtr, biasPrePtr,
+                     biasPostPtr,      biasScalePtr,   outPrePtr,
+                     outPostPtr,       outScalePtr,    1};
+  libjit_conv2d_arm_generic(outW, inW, filterW, biasW, outWdims, inWdims,
+                            filterWdims, kernels, strides, pads, group,
+                            dilation, outOffset, inOffset, qp, actType,
+                            actArgs);
+}
+
+/// Same as libjit_fc_i8_i32, for ARM targets.
+void libjit_fc_arm_i8_i32(int8_t *outW, const int8_t *inW,
+                          const int8_t *weightsW, const int32_t *biasW,
+                          const dim_t *outWdims, const dim_t *inWdims,
+                          const dim_t *weightsWdims, const dim_t *biasWdims,
+                          int32_t outOffset, int32_t inOffset,
+                          int32_t weightsOffset, int32_t biasOffset,
+                          int32_t biasPre, int32_t biasPost, int32_t biasScale,
+                          int32_t outPre, int32_t outPost, int32_t outScale) {
+  libjit_fc_arm_generic(outW, inW, weightsW, biasW, outWdims, inWdims,
+                        weightsWdims, outOffset, inOffset, weightsOffset,
+                        biasOffset, biasPre, biasPost, biasScale, outPre,
+                        outPost, outScale);
+}
+
+/// Same as libjit_fc_i8_i8, for ARM targets.
+void libjit_fc_arm_i8_i8(int8_t *outW, const int8_t *inW,
+                         const int8_t *weightsW, const int8_t *biasW,
+                         const dim_t *outWdims, const dim_t *inWdims,
+                         const dim_t *weightsWdims, const dim_t *biasWdims,
+                         int32_t outOffset, int32_t inOffset,
+                         int32_t weightsOffset, int32_t biasOffset,
+                         int32_t biasPre, int32_t biasPost, int32_t biasScale,
+                         int32_t outPre, int32_t outPost, int32_t outScale) {
+  libjit_fc_arm_generic(outW, inW, weightsW, biasW, outWdims, inWdims,
+                        weightsWdims, outOffset, inOffset, weightsOffset,
+                        biasOffset, biasPre, biasPost, biasScale, outPre,
+                        outPost, outScale);
+}
+
+/// Same as libjit_max_pool_i8, for ARM targets. The maximum is taken over
+/// all the channels of an input pixel at once.
+void libjit_max_pool_arm_i8(const int8_t *inW, int8_t *outW,
+                            const dim_t *inWdims, const dim_t *outWdims,
+                            dim_t *kernelSizes, dim_t *strides, dim_t *pads,
+                            int32_t outOffset) {
+  dim_t channels = inWdims[3];
+  for (dim_t n = 0; n < inWdims[0]; n++) {
+    ssize_t i_h_min = -(ssize_t)pads[0];
+    for (dim_t o_h = 0; o_h < outWdims[1]; o_h++, i_h_min += strides[0]) {
+      ssize_t f_h_min = libjit_conv_flt_min(i_h_min);
+      ssize_t f_h_max =
+          libjit_conv_flt_max(inWdims[1], kernelSizes[0], i_h_min);
+      ssize_t i_w_min = -(ssize_t)pads[1];
+      for (dim_t o_w = 0; o_w < outWdims[2]; o_w++, i_w_min += strides[1]) {
+        ssize_t f_w_min = libjit_conv_flt_min(i_w_min);
+        ssize_t f_w_max =
+            libjit_conv_flt_max(inWdims[2], kernelSizes[1], i_w_min);
+        int8_t *out = outW + libjit_getXYZW(outWdims, n, o_h, o_w, 0);
+        if (f_h_min >= f_h_max || f_w_min >= f_w_max) {
+          // Empty pooling window.
+          for (dim_t c = 0; c < channels; c++) {
+            out[c] = static_cast<int8_t>(outOffset);
+          }
+          continue;
+        }
+        for (dim_t c = 0; c < channels; c++) {
+          out[c] = -128;
+        }
+        for (ssize_t f_h = f_h_min; f_h < f_h_max; f_h++) {
+          for (ssize_t f_w = f_w_min; f_w < f_w_max; f_w++) {
+            const int8_t *in = inW + libjit_getXYZW(inWdims, n, i_h_min + f_h,
+                                                    i_w_min + f_w, 0);
+            for (dim_t c = 0; c < channels; c++) {
+              out[c] = MAX(out[c], in[c]);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Same as libjit_avg_pool_i8, for ARM targets. The sums of kBlock channels
+/// of an input pixel are accumulated at once.
+void libjit_avg_pool_arm_i8(const int8_t *inW, int8_t *outW,
+                            const dim_t *inWdims, const dim_t *outWdims,
+                            dim_t *kernelSizes, dim_t *strides, dim_t *pads,
+                            bool countIncludePads, int32_t outOffset,
+                            int32_t inOffset, int32_t outPre, int32_t outPost,
+                            int32_t outScale) {
+  dim_t channels = inWdims[3];
+  int32_t acc[kBlock];
+  for (dim_t n = 0; n < inWdims[0]; n++) {
+    ssize_t i_h_min = -(ssize_t)pads[0];
+    for (dim_t o_h = 0; o_h < outWdims[1]; o_h++, i_h_min += strides[0]) {
+      ssize_t f_h_min = libjit_conv_flt_min(i_h_min);
+      ssize_t f_h_max =
+          libjit_conv_flt_max(inWdims[1], kernelSizes[0], i_h_min);
+      ssize_t f_h_len = libjit_conv_flt_len(f_h_min, f_h_max);
+      ssize_t i_w_min = -(ssize_t)pads[1];
+      for (dim_t o_w = 0; o_w < outWdims[2]; o_w++, i_w_min += strides[1]) {
+        ssize_t f_w_min = libjit_conv_flt_min(i_w_min);
+        ssize_t f_w_max =
+            libjit_conv_flt_max(inWdims[2], kernelSizes[1], i_w_min);
+        ssize_t f_w_len = libjit_conv_flt_len(f_w_min, f_w_max);
+        int32_t area = f_h_len * f_w_len;
+        int8_t *out = outW + libjit_getXYZW(outWdims, n, o_h, o_w, 0);
+        for (dim_t c0 = 0; c0 < channels; c0 += kBlock) {
+          dim_t len = MIN(kBlock, channels - c0);
+          for (dim_t c = 0; c < len; c++) {
+            acc[c] = 0;
+          }
+          for (ssize_t f_h = f_h_min; f_h < f_h_max; f_h++) {
+            for (ssize_t f_w = f_w_min; f_w < f_w_max; f_w++) {
+              const int8_t *in = inW + libjit_getXYZW(inWdims, n, i_h_min + f_h,
+                                                      i_w_min + f_w, c0);
+              for (dim_t c = 0; c < len; c++) {
+                acc[c] += in[c];
+              }
+            }
+          }
+          for (dim_t c = 0; c < len; c++) {
+            int32_t sum = acc[c] - area * inOffset;
+            if (countIncludePads) {
+              sum = libjit_scale<int32_t>(sum, outPre, outPost, outScale,
+                                          outOffset);
+              out[c0 + c] = libjit_clip_i8(sum);
+            } else if (area == 0) {
+              out[c0 + c] = outOffset;
+            } else {
+              sum = libjit_scale<int32_t>(sum, outPre, outPost, outScale, 0);
+              sum = libjit_div_round_i32(sum, area) + outOffset;
+              out[c0 + c] = libjit_clip_i8(sum);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+}
@@ -238,6 +238,189 @@ void libjit_channelwise_quantized_conv2d_generic(
   }         // N
 }
 
+/// Number of channels processed together by the depthwise convolutions. Their
+/// filter is repacked on the stack for a block of channels.
+constexpr dim_t kDepthwiseBlock = 64;
+
+/// \returns true if the \p K x \p K window at (\p x, \p y) with \p dilation
+/// is fully inside the \p inWdims input, so its taps need no bounds checks.
+template <dim_t K>
+LIBJIT_ALWAYS_INLINE bool
+libjit_depthwise_window_inside(sdim_t x, sdim_t y, const dim_t *inWdims,
+                               const dim_t *dilation) {
+  return x >= 0 && y >= 0 &&
+         x + sdim_t((K - 1) * dilation[0]) < (sdim_t)inWdims[1] &&
+         y + sdim_t((K - 1) * dilation[1]) < (sdim_t)inWdims[2];
+}
+
+/// Float depthwise convolution in NHWC, with one output channel per input
+/// channel and a \p K x \p K filter. The filter of kDepthwiseBlock channels is
+/// repacked as [K][K][kDepthwiseBlock] so that the channels are innermost and
+/// contiguous in the input, the filter and the accumulators. The taps are
+/// accumulated in the same order as libjit_conv2d_f.
+template <dim_t K>
+void libjit_depthwise_conv2d_f_impl(float *outW, const float *inW,
+                                    const float *filterW, const float *biasW,
+                                    const dim_t *outWdims, const dim_t *inWdims,
+                                    const dim_t *strides, const dim_t *pads,
+                                    const dim_t *dilation, int32_t actType,
+                                    const float *actArgs) {
+  constexpr dim_t window = K * K;
+  dim_t channels = inWdims[3];
+  float packed[window * kDepthwiseBlock];
+  float acc[kDepthwiseBlock];
+  for (dim_t c0 = 0; c0 < channels; c0 += kDepthwiseBlock) {
+    dim_t len = MIN(kDepthwiseBlock, channels - c0);
+    for (dim_t f = 0; f < window; f++) {
+      for (dim_t c = 0; c < len; c++) {
+        packed[f * kDepthwiseBlock + c] = filterW[(c0 + c) * window + f];
+      }
+    }
+    for (dim_t n = 0; n < inWdims[0]; n++) {
+      sdim_t x = -(sdim_t)pads[0];
+      for (dim_t ax = 0; ax < outWdims[1]; x += strides[0], ax++) {
+        sdim_t y = -(sdim_t)pads[1];
+        for (dim_t ay = 0; ay < outWdims[2]; y += strides[1], ay++) {
+          for (dim_t c = 0; c < len; c++) {
+            acc[c] = biasW[c0 + c];
+          }
+          bool inside =
+              libjit_depthwise_window_inside<K>(x, y, inWdims, dilation);
+          for (dim_t fx = 0; fx < K; fx++) {
+            sdim_t ox = x + fx * dilation[0];
+            if (!inside && (ox < 0 || ox >= (sdim_t)inWdims[1])) {
+              continue;
+            }
+            for (dim_t fy = 0; fy < K; fy++) {
+              sdim_t oy = y + fy * dilation[1];
+              if (!inside && (oy < 0 || oy >= (sdim_t)inWdims[2])) {
+                continue;
+              }
+              const float *in = inW + libjit_getXYZW(inWdims, n, ox, oy, c0);
+              const float *f = packed + (fx * K + fy) * kDepthwiseBlock;
+              for (dim_t c = 0; c < len; c++) {
+                acc[c] += in[c] * f[c];
+              }
+            }
+          }
+          float *out = outW + libjit_getXYZW(outWdims, n, ax, ay, c0);
+          for (dim_t c = 0; c < len; c++) {
+            out[c] = libjit_activation_f(acc[c], actType, actArgs);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Quantization parameters of an int8 depthwise convolution, either per
+/// tensor (a stride of 0 in the arrays) or per channel.
+struct DepthwiseQuantParams {
+  const int32_t *filterOffsets;
+  const int32_t *biasOffsets;
+  const int32_t *biasPre;
+  const int32_t *biasPost;
+  const int32_t *biasScale;
+  const int32_t *outPre;
+  const int32_t *outPost;
+  const int32_t *outScale;
+  dim_t stride;
+};
+
+/// Int8 depthwise convolution in NHWC with a \p K x \p K filter, see
+/// libjit_depthwise_conv2d_f_impl. The filter offsets are subtracted when
+/// repacking the filter, and the bias, the requantization and the activation
+/// are applied to the int32 accumulators of a block of channels at once.
+template <dim_t K, typename BiasElemTy>
+void libjit_depthwise_conv2d_i8_impl(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const BiasElemTy *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *strides, const dim_t *pads, const dim_t *dilation,
+    int32_t outOffset, int32_t inOffset, const DepthwiseQuantParams &qp,
+    int32_t actType, const int32_t *actArgs) {
+  constexpr dim_t window = K * K;
+  dim_t channels = inWdims[3];
+  int16_t packed[window * kDepthwiseBlock];
+  int32_t acc[kDepthwiseBlock];
+  for (dim_t c0 = 0; c0 < channels; c0 += kDepthwiseBlock) {
+    dim_t len = MIN(kDepthwiseBlock, channels - c0);
+    for (dim_t f = 0; f < window; f++) {
+      for (dim_t c = 0; c < len; c++) {
+        dim_t p = (c0 + c) * qp.stride;
+        packed[f * kDepthwiseBlock + c] =
+            int16_t(filterW[(c0 + c) * window + f]) - qp.filterOffsets[p];
+      }
+    }
+    for (dim_t n = 0; n < inWdims[0]; n++) {
+      sdim_t x = -(sdim_t)pads[0];
+      for (dim_t ax = 0; ax < outWdims[1]; x += strides[0], ax++) {
+        sdim_t y = -(sdim_t)pads[1];
+        for (dim_t ay = 0; ay < outWdims[2]; y += strides[1], ay++) {
+          for (dim_t c = 0; c < len; c++) {
+            acc[c] = 0;
+          }
+          bool inside =
+              libjit_depthwise_window_inside<K>(x, y, inWdims, dilation);
+          for (dim_t fx = 0; fx < K; fx++) {
+            sdim_t ox = x + fx * dilation[0];
+            if (!inside && (ox < 0 || ox >= (sdim_t)inWdims[1])) {
+              continue;
+            }
+            for (dim_t fy = 0; fy < K; fy++) {
+              sdim_t oy = y + fy * dilation[1];
+              if (!inside && (oy < 0 || oy >= (sdim_t)inWdims[2])) {
+                continue;
+              }
+              const int8_t *in = inW + libjit_getXYZW(inWdims, n, ox, oy, c0);
+              const int16_t *f = packed + (fx * K + fy) * kDepthwiseBlock;
+              for (dim_t c = 0; c < len; c++) {
+                int16_t v = int16_t(in[c]) - int16_t(inOffset);
+                acc[c] += int32_t(v) * int32_t(f[c]);
+              }
+            }
+          }
+          int8_t *out = outW + libjit_getXYZW(outWdims, n, ax, ay, c0);
+          for (dim_t c = 0; c < len; c++) {
+            dim_t p = (c0 + c) * qp.stride;
+            int32_t bias = (int32_t)biasW[c0 + c] - qp.biasOffsets[p];
+            int32_t sum = acc[c] + libjit_scale<int32_t>(bias, qp.biasPre[p],
+                                                         qp.biasPost[p],
+                                                         qp.biasScale[p], 0);
+            int32_t scaledSum =
+                libjit_scale<int32_t>(sum, qp.outPre[p], qp.outPost[p],
+                                      qp.outScale[p], outOffset);
+            scaledSum =
+                libjit_activation_i32(scaledSum, outOffset, actType, actArgs);
+            out[c] = libjit_clip_i8(scaledSum);
+          }
+        }
+      }
+    }
+  }
+}
+
+/// Dispatches the int8 depthwise convolution with the \p kernels filter, 3x3
+/// or 5x5, to its specialization.
+template <typename BiasElemTy>
+void libjit_depthwise_conv2d_i8_generic(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const BiasElemTy *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *kernels, const dim_t *strides, const dim_t *pads,
+    const dim_t *dilation, int32_t outOffset, int32_t inOffset,
+    const DepthwiseQuantParams &qp, int32_t actType, const int32_t *actArgs) {
+  if (kernels[0] == 3) {
+    libjit_depthwise_conv2d_i8_impl<3>(outW, inW, filterW, biasW, outWdims,
+                                       inWdims, strides, pads, dilation,
+                                       outOffset, inOffset, qp, actType,
+                                       actArgs);
+  } else {
+    libjit_depthwise_conv2d_i8_impl<5>(outW, inW, filterW, biasW, outWdims,
+                                       inWdims, strides, pads, dilation,
+                                       outOffset, inOffset, qp, actType,
+                                       actArgs);
+  }
+}
+
 /// Generic template for channelwise quantized conv3d. The template allows
 /// choosing the element type and bias type.
 template <typename ElemTy, typename BiasElemTy>
@@ -561,6 +744,100 @@ void libjit_channelwise_quantized_conv2d_i8_i8(
       outPrePtr, outPostPtr, outScalePtr, actType, actArgs);
 }
 
+// The depthwise convolutions below take the arguments of the generic
+// convolution of the same type, so that the codegen only has to pick the
+// function. They support square 3x3 and 5x5 filters with one output channel
+// per input channel, see libjit_depthwise_conv2d_f_impl.
+void libjit_depthwise_conv2d_f(float *outW, const float *inW,
+                               const float *filterW, const float *biasW,
+                               const dim_t *outWdims, const dim_t *inWdims,
+                               const dim_t *filterWdims,
+                               const dim_t *biasWdims, const dim_t *kernelSizes,
+                               const dim_t *strides, const dim_t *pads,
+                               dim_t group, unsigned depthUnroll,
+                               const dim_t *dilation, int32_t actType,
+                               const float *actArgs) {
+  if (kernelSizes[0] == 3) {
+    libjit_depthwise_conv2d_f_impl<3>(outW, inW, filterW, biasW, outWdims,
+                                      inWdims, strides, pads, dilation,
+                                      actType, actArgs);
+  } else {
+    libjit_depthwise_conv2d_f_impl<5>(outW, inW, filterW, biasW, outWdims,
+                                      inWdims, strides, pads, dilation,
+                                      actType, actArgs);
+  }
+}
+
+void libjit_depthwise_conv2d_i8_i32(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int32_t *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *filterWdims, const dim_t *biasWdims, const dim_t *kernelSizes,
+    const dim_t *strides, const dim_t *pads, dim_t group, int32_t outOffset,
+    int32_t inOffset, int32_t filterOffset, int32_t biasOffset, int32_t biasPre,
+    int32_t biasPost, int32_t biasScale, int32_t outPre, int32_t outPost,
+    int32_t outScale, unsigned depthUnroll, const dim_t *dilation,
+    int32_t actType, const int32_t *actArgs) {
+  DepthwiseQuantParams qp{&filterOffset, &biasOffset, &biasPre, &biasPost,
+                          &biasScale,    &outPre,     &outPost, &outScale,
+                          0};
+  libjit_depthwise_conv2d_i8_generic<int32_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, kernelSizes, strides, pads,
+      dilation, outOffset, inOffset, qp, actType, actArgs);
+}
+
+void libjit_depthwise_conv2d_i8_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const dim_t *outWdims, const dim_t *inWdims, const dim_t *filterWdims,
+    const dim_t *biasWdims, const dim_t *kernelSizes, const dim_t *strides,
+    const dim_t *pads, dim_t group, int32_t outOffset, int32_t inOffset,
+    int32_t filterOffset, int32_t biasOffset, int32_t biasPre, int32_t biasPost,
+    int32_t biasScale, int32_t outPre, int32_t outPost, int32_t outScale,
+    unsigned depthUnroll, const dim_t *dilation, int32_t actType,
+    const int32_t *actArgs) {
+  DepthwiseQuantParams qp{&filterOffset, &biasOffset, &biasPre, &biasPost,
+                          &biasScale,    &outPre,     &outPost, &outScale,
+                          0};
+  libjit_depthwise_conv2d_i8_generic<int8_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, kernelSizes, strides, pads,
+      dilation, outOffset, inOffset, qp, actType, actArgs);
+}
+
+void libjit_channelwise_quantized_depthwise_conv2d_i8_i32(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW,
+    const int32_t *biasW, const dim_t *outWdims, const dim_t *inWdims,
+    const dim_t *filterWdims, const dim_t *biasWdims, const dim_t *kernels,
+    const dim_t *strides, const dim_t *pads, dim_t group, const dim_t *dilation,
+    int32_t outOffset, int32_t inOffset, int32_t *filterOffsetsPtr,
+    int32_t *biasOffsetsPtr, const int32_t *biasPrePtr,
+    const int32_t *biasPostPtr, const int32_t *biasScalePtr,
+    const int32_t *outPrePtr, const int32_t *outPostPtr,
+    const int32_t *outScalePtr, int32_t actType, const int32_t *actArgs) {
+  DepthwiseQuantParams qp{filterOffsetsPtr, biasOffsetsPtr, biasPrePtr,
+                          biasPostPtr,      biasScalePtr,   outPrePtr,
+                          outPostPtr,       outScalePtr,    1};
+  libjit_depthwise_conv2d_i8_generic<int32_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, kernels, strides, pads,
+      dilation, outOffset, inOffset, qp, actType, actArgs);
+}
+
+void libjit_channelwise_quantized_depthwise_conv2d_i8_i8(
+    int8_t *outW, const int8_t *inW, const int8_t *filterW, const int8_t *biasW,
+    const dim_t *outWdims, const dim_t *inWdims, const dim_t *filterWdims,
+    const dim_t *biasWdims, const dim_t *kernels, const dim_t *strides,
+    const dim_t *pads, dim_t group, const dim_t *dilation, int32_t outOffset,
+    int32_t inOffset, int32_t *filterOffsetsPtr, int32_t *biasOffsetsPtr,
+    const int32_t *biasPrePtr, const int32_t *biasPostPtr,
+    const int32_t *biasScalePtr, const int32_t *outPrePtr,
+    const int32_t *outPostPtr, const int32_t *outScalePtr, int32_t actType,
+    const int32_t *actArgs) {
+  DepthwiseQuantParams qp{filterOffsetsPtr, biasOffsetsPtr, biasPrePtr,
+                          biasPostPtr,      biasScalePtr,   outPrePtr,
+                          outPostPtr,       outScalePtr,    1};
+  libjit_depthwise_conv2d_i8_generic<int8_t>(
+      outW, inW, filterW, biasW, outWdims, inWdims, kernels, strides, pads,
+      dilation, outOffset, inOffset, qp, actType, actArgs);
+}
+
 void libjit_channelwise_quantized_conv3d_i8_i32(
     int8_t *outW, const int8_t *inW, const int8_t *filterW,
     const int32_t *biasW, const dim_t *outWdims, const dim_t *inWdims,
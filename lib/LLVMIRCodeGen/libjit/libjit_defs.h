@@ -35,9 +35,11 @@ typedef SSIZE_T ssize_t;
 #if defined(__clang__)
 using float4 = float __attribute__((ext_vector_type(4)));
 using float8 = float __attribute__((ext_vector_type(8)));
+using int32x8 = int32_t __attribute__((ext_vector_type(8)));
 #elif defined(__GNUC__) || defined(__GNUG__)
 using float4 = float __attribute__((vector_size(16)));
 using float8 = float __attribute__((vector_size(32)));
+using int32x8 = int32_t __attribute__((vector_size(32)));
 #endif
 
 /// Loads a simd float8 value from \p ptr.
@@ -252,6 +254,276 @@ int32_t libjit_div_round_i32(int32_t input, int32_t divider) {
 #define libjit_aligned_free(p) free(p)
 #endif
 
+/// Body of a parallel loop, run for the tasks in [begin, end) with the
+/// kernel-specific state \p ctx.
+typedef void (*libjit_parallel_body_t)(void *ctx, dim_t begin, dim_t end);
+
+extern "C" {
+/// Runs \p body for the tasks in [0, \p numTasks), splitting them across the
+/// host's intra-op worker threads when a parallel runtime is installed and
+/// serially otherwise. \p body must be safe to run concurrently on disjoint
+/// task ranges.
+void libjit_parallel_for(dim_t numTasks, libjit_parallel_body_t body,
+                         void *ctx);
+}
+
+/// Number of lookups ahead of the current one whose rows the embedding
+/// kernels prefetch. Rows are gathered at random from tables that are usually
+/// much larger than the caches, so loads would otherwise stall.
+static const dim_t fusedRowwisePrefetchDistance = 16;
+
+/// Vector of 8 quantized values of a fused rowwise row.
+typedef uint8_t uchar8 __attribute__((vector_size(8)));
+
+/// Prefetch the \p size bytes of the embedding row at \p row.
+LIBJIT_ALWAYS_INLINE void libjit_prefetch_row(const void *row, dim_t size) {
+  for (dim_t i = 0; i < size; i += 64) {
+    __builtin_prefetch((const char *)row + i, /* rw */ 0, /* locality */ 0);
+  }
+}
+
+/// Accumulate into \p dest the \p size elements of the 8-bit fused rowwise
+/// row \p row, dequantized with \p scale and \p offset which are already
+/// multiplied by the weight of the row.
+LIBJIT_ALWAYS_INLINE void
+libjit_fused_rowwise_accumulate_8bit(float *dest, const uint8_t *row,
+                                     dim_t size, float scale, float offset) {
+  const float8 scale8 = BroadcastFloat8(scale);
+  const float8 offset8 = BroadcastFloat8(offset);
+  dim_t k = 0;
+  for (; k + 8 <= size; k += 8) {
+    uchar8 q;
+    memcpy(&q, row + k, sizeof(q));
+    AdduFloat8(dest + k, __builtin_convertvector(q, float8) * scale8 + offset8);
+  }
+  for (; k < size; k++) {
+    dest[k] += scale * row[k] + offset;
+  }
+}
+
+/// Accumulate into \p dest the \p size elements of the 4-bit fused rowwise
+/// row \p row, dequantized with \p scale and \p offset which are already
+/// multiplied by the weight of the row. Element k is stored in the low nibble
+/// of byte k / 2 if k is even, and in its high nibble otherwise.
+LIBJIT_ALWAYS_INLINE void
+libjit_fused_rowwise_accumulate_4bit(float *dest, const uint8_t *row,
+                                     dim_t size, float scale, float offset) {
+  const float8 scale8 = BroadcastFloat8(scale);
+  const float8 offset8 = BroadcastFloat8(offset);
+  dim_t k = 0;
+  for (; k + 16 <= size; k += 16) {
+    uchar8 q;
+    memcpy(&q, row + k / 2, sizeof(q));
+    const uchar8 lo = q & (uint8_t)0x0f;
+    const uchar8 hi = q >> (uint8_t)4;
+    const uchar8 first =
+        __builtin_shufflevector(lo, hi, 0, 8, 1, 9, 2, 10, 3, 11);
+    const uchar8 second =
+        __builtin_shufflevector(lo, hi, 4, 12, 5, 13, 6, 14, 7, 15);
+    AdduFloat8(dest + k,
+               __builtin_convertvector(first, float8) * scale8 + offset8);
+    AdduFloat8(dest + k + 8,
+               __builtin_convertvector(second, float8) * scale8 + offset8);
+  }
+  for (; k < size; k++) {
+    const uint8_t q = (k % 2) ? (row[k / 2] >> 4) : (row[k / 2] & 0x0f);
+    dest[k] += scale * q + offset;
+  }
+}
+
+/// \returns the float value of the IEEE half precision number with bits \p h.
+LIBJIT_ALWAYS_INLINE float libjit_fp16_to_fp32(uint16_t h) {
+  const uint32_t sign = uint32_t(h & 0x8000) << 16;
+  const uint32_t exp = (h >> 10) & 0x1f;
+  const uint32_t mant = h & 0x3ff;
+  uint32_t bits;
+  if (exp == 0x1f) {
+    bits = sign | 0x7f800000 | (mant << 13);
+  } else if (exp != 0) {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  } else {
+    // Zero or subnormal, whose value is mant * 2^-24.
+    const float res = mant * 5.9604644775390625e-8f;
+    return sign ? -res : res;
+  }
+  float res;
+  memcpy(&res, &bits, sizeof(res));
+  return res;
+}
+
+/// \returns the bits of the IEEE half precision number closest to \p f, with
+/// ties rounded to even like glow::float16 does. Values too large for a half
+/// become infinities and NaNs become quiet NaNs.
+LIBJIT_ALWAYS_INLINE uint16_t libjit_fp32_to_fp16(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t abs = bits & 0x7fffffff;
+  if (abs > 0x7f800000) {
+    return sign | 0x7e00;
+  }
+  if (abs >= 0x47800000) {
+    return sign | 0x7c00;
+  }
+  if (abs >= 0x38800000) {
+    // Normal half, rebias the exponent and round the mantissa. A mantissa
+    // rounding up carries into the exponent, up to the infinity.
+    uint32_t r = abs - 0x38000000;
+    r += 0xfff + ((r >> 13) & 1);
+    return sign | (r >> 13);
+  }
+  if (abs <= 0x33000000) {
+    // At most half of the smallest subnormal, which rounds to zero.
+    return sign;
+  }
+  // Subnormal half, whose mantissa is the value times 2^24.
+  const uint32_t shift = 126 - (abs >> 23);
+  const uint32_t mant = (abs & 0x7fffff) | 0x800000;
+  const uint32_t rem = mant & ((1u << shift) - 1);
+  const uint32_t half = 1u << (shift - 1);
+  uint32_t q = mant >> shift;
+  if (rem > half || (rem == half && (q & 1))) {
+    q++;
+  }
+  return sign | q;
+}
+
+/// \returns the lanewise maximum of \p a and \p b.
+LIBJIT_ALWAYS_INLINE float8 libjit_max_float8(float8 a, float8 b) {
+  const int32x8 mask = a > b;
+  return (float8)((mask & (int32x8)a) | (~mask & (int32x8)b));
+}
+
+/// \returns the lanewise minimum of \p a and \p b.
+LIBJIT_ALWAYS_INLINE float8 libjit_min_float8(float8 a, float8 b) {
+  const int32x8 mask = a < b;
+  return (float8)((mask & (int32x8)a) | (~mask & (int32x8)b));
+}
+
+/// \returns the sum of the lanes of \p v.
+LIBJIT_ALWAYS_INLINE float libjit_reduce_add_float8(float8 v) {
+  float sum = 0;
+  for (unsigned i = 0; i < 8; i++) {
+    sum += v[i];
+  }
+  return sum;
+}
+
+/// \returns the maximum of the lanes of \p v.
+LIBJIT_ALWAYS_INLINE float libjit_reduce_max_float8(float8 v) {
+  float max = v[0];
+  for (unsigned i = 1; i < 8; i++) {
+    max = MAX(max, v[i]);
+  }
+  return max;
+}
+
+/// \returns the minimum of the lanes of \p v.
+LIBJIT_ALWAYS_INLINE float libjit_reduce_min_float8(float8 v) {
+  float min = v[0];
+  for (unsigned i = 1; i < 8; i++) {
+    min = MIN(min, v[i]);
+  }
+  return min;
+}
+
+/// Range of the arguments of the polynomial exp, outside of which 2^n would
+/// not fit in the exponent of a normal float.
+static const float libjit_exp_min = -87.0f;
+static const float libjit_exp_max = 88.0f;
+
+LIBJIT_ALWAYS_INLINE float libjit_int_to_float(int32_t v) { return v; }
+LIBJIT_ALWAYS_INLINE float8 libjit_int_to_float(int32x8 v) {
+  return __builtin_convertvector(v, float8);
+}
+
+/// \returns exp(\p x) for \p x in [libjit_exp_min, libjit_exp_max], with \p T
+/// float or float8 and \p IT the integer type of the same shape. The argument
+/// is split into n * ln(2) + r with |r| <= ln(2) / 2, exp(r) is approximated
+/// with the Cephes polynomial and 2^n is built in the exponent bits, which is
+/// accurate to about 2 ulp and has no branches, so that it vectorizes.
+template <typename T, typename IT>
+LIBJIT_ALWAYS_INLINE T libjit_exp_poly_clamped(T x) {
+  // Adding 1.5 * 2^23 rounds x / ln(2) to the closest integer n, which ends up
+  // in the low mantissa bits. Reading n back from the bits keeps this correct
+  // under -ffast-math, which would fold the subtraction of the constant.
+  const T t = x * 1.44269504f + 12582912.0f;
+  IT bits;
+  memcpy(&bits, &t, sizeof(bits));
+  bits = bits - 0x4B400000;
+  const T n = libjit_int_to_float(bits);
+  // ln(2) is split in two so that r is exact.
+  const T r = x - n * 0.693359375f + n * 2.12194440e-4f;
+  T p = r * 1.9875691500e-4f + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * (r * r) + r + 1.0f;
+  bits = (bits + 127) << 23;
+  T scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+/// \returns an approximation of exp(\p x), see libjit_exp_poly_clamped.
+/// Arguments are clamped to [libjit_exp_min, libjit_exp_max].
+LIBJIT_ALWAYS_INLINE float libjit_exp_poly(float x) {
+  return libjit_exp_poly_clamped<float, int32_t>(
+      MIN(MAX(x, libjit_exp_min), libjit_exp_max));
+}
+
+/// \returns an approximation of exp(\p x) in each lane, see
+/// libjit_exp_poly_clamped. Arguments are clamped to [libjit_exp_min,
+/// libjit_exp_max].
+LIBJIT_ALWAYS_INLINE float8 libjit_exp_poly_float8(float8 x) {
+  x = libjit_max_float8(x, BroadcastFloat8(libjit_exp_min));
+  x = libjit_min_float8(x, BroadcastFloat8(libjit_exp_max));
+  return libjit_exp_poly_clamped<float8, int32x8>(x);
+}
+
+/// Vectors of 8 bfloat16 numbers and of their widened bits.
+typedef uint16_t ushort8 __attribute__((vector_size(16)));
+typedef uint32_t uint32x8 __attribute__((vector_size(32)));
+
+/// \returns the float value of the bfloat16 number with bits \p b.
+LIBJIT_ALWAYS_INLINE float libjit_bf16_to_fp32(uint16_t b) {
+  const uint32_t bits = uint32_t(b) << 16;
+  float res;
+  memcpy(&res, &bits, sizeof(res));
+  return res;
+}
+
+/// \returns the bits of \p f as a bfloat16 number. The mantissa is truncated
+/// like glow::bfloat16 does, so that the CPU backend matches the Interpreter,
+/// and NaNs get their quiet bit set so that they stay NaNs.
+LIBJIT_ALWAYS_INLINE uint16_t libjit_fp32_to_bf16(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  const uint16_t res = bits >> 16;
+  return (bits & 0x7fffffff) > 0x7f800000 ? res | 0x40 : res;
+}
+
+/// \returns the 8 bfloat16 numbers at \p p as floats.
+LIBJIT_ALWAYS_INLINE float8 libjit_load_bf16_float8(const uint16_t *p) {
+  ushort8 b;
+  memcpy(&b, p, sizeof(b));
+  const uint32x8 bits = __builtin_convertvector(b, uint32x8) << 16;
+  float8 res;
+  memcpy(&res, &bits, sizeof(res));
+  return res;
+}
+
+/// Store \p v to the 8 bfloat16 numbers at \p p, see libjit_fp32_to_bf16.
+LIBJIT_ALWAYS_INLINE void libjit_store_bf16_float8(uint16_t *p, float8 v) {
+  uint32x8 bits;
+  memcpy(&bits, &v, sizeof(bits));
+  const uint32x8 nan = (uint32x8)((bits & 0x7fffffff) > 0x7f800000);
+  const uint32x8 res = (bits >> 16) | (nan & 0x40);
+  const ushort8 b = __builtin_convertvector(res, ushort8);
+  memcpy(p, &b, sizeof(b));
+}
+
 /// This function computes the minimum filter index based on the the minimum
 /// input index \p inp_min.
 LIBJIT_ALWAYS_INLINE ssize_t libjit_conv_flt_min(ssize_t inp_min) {
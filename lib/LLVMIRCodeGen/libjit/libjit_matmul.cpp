@@ -15,6 +15,16 @@
  */
 #include "libjit_defs.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIBJIT_VNNI_KERNELS
+#define LIBJIT_VNNI_TARGET                                                     \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+#define LIBJIT_BF16_KERNELS
+#define LIBJIT_BF16_TARGET                                                     \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512bf16")))
+#endif
+
 namespace {
 
 /// Macros for accessing submatrices of a matmul using the leading dimension.
@@ -35,20 +45,33 @@ void libjit_matmul_odd(int m, int n, int k, const float *a, int lda,
   }
 }
 
-/// Number of registers to use for rows of A in the dot-product kernel.
-constexpr int regsA = 4;
-/// Number of registers to use for columns of B in the dot-product kernel.
-constexpr int regsB = 3;
+/// Register blocks of the dot-product kernel. Each block is given as the
+/// number of registers to use for rows of A (regsA), and the number of
+/// registers to use for columns of B (regsB). The kernel keeps regsA * regsB
+/// accumulators, regsA values of A and one broadcast value of B in registers,
+/// so the block is sized for the register file of the target.
+///
+/// Generic block, leaving room for targets with few vector registers.
+constexpr int genericRegsA = 4;
+constexpr int genericRegsB = 3;
+/// Block for AVX2, which has 16 ymm registers: 12 accumulators, 2 + 1 loads.
+constexpr int avx2RegsA = 2;
+constexpr int avx2RegsB = 6;
+/// Block for AVX-512, which has 32 ymm registers: 24 accumulators, 4 + 1
+/// loads.
+constexpr int avx512RegsA = 4;
+constexpr int avx512RegsB = 6;
 
-/// Number of rows of A to process in the kernel.  Vector loads are used for A,
-/// so we load eight times as many floats as we use registers.
-constexpr int mr = regsA * 8;
-/// Number of columns of B to process in the kernel.
-constexpr int nr = regsB;
+/// \returns the number of rows of A to process in the kernel.  Vector loads
+/// are used for A, so we load eight times as many floats as we use registers.
+constexpr int getMR(int regsA) { return regsA * 8; }
+/// \returns the number of columns of B to process in the kernel.
+constexpr int getNR(int regsB) { return regsB; }
 
 /// Blocking parameters for the outer kernel.  We multiply mc x kc blocks of A
 /// with kc x nc panels of B (this approach is referred to as `gebp` in the
-/// literature).  TODO: Generalize these parameters for other cache sizes.
+/// literature).  mc must be a multiple of the mr of every register block.
+/// TODO: Generalize these parameters for other cache sizes.
 constexpr int mc = 256;
 constexpr int kc = 128;
 constexpr int nc = 4096;
@@ -112,6 +135,7 @@ void libjit_matmul_zdot(size_t k, const float *a, size_t lda, const float *b,
 template <size_t regsA>
 void pack_matrix_a(size_t m, size_t k, const float *a, size_t lda,
                    float *a_to) {
+  constexpr int mr = getMR(regsA);
   for (int i = 0; i < int(m) - mr + 1; i += mr) {
     for (size_t j = 0; j < k; j++) {
       const float *a_ij_pntr = &A(i, j);
@@ -129,6 +153,7 @@ void pack_matrix_a(size_t m, size_t k, const float *a, size_t lda,
 template <size_t regsB>
 void pack_matrix_b(size_t n, size_t k, const float *b, size_t ldb,
                    float *b_to) {
+  constexpr int nr = getNR(regsB);
   for (int j = 0; j < int(n) - nr + 1; j += nr) {
     for (size_t i = 0; i < k; i++) {
       for (size_t bi = 0; bi < regsB; bi++) {
@@ -142,8 +167,11 @@ void pack_matrix_b(size_t n, size_t k, const float *b, size_t ldb,
 /// because packed matrices need to be more more sensitive to cache locality,
 /// and N strides over the B matrix, which is very large and will blow out the
 /// cache.
+template <size_t regsA, size_t regsB>
 void libjit_matmul_inner_packed(int m, int n, int k, const float *packedA,
                                 const float *packedB, float *c, int ldc) {
+  constexpr int mr = getMR(regsA);
+  constexpr int nr = getNR(regsB);
   for (int j = 0; j < n - nr + 1; j += nr) {
     for (int i = 0; i < m - mr + 1; i += mr) {
       libjit_matmul_zdot<regsA, regsB>(k, &packedA[i * k], mr, &packedB[j * k],
@@ -154,8 +182,11 @@ void libjit_matmul_inner_packed(int m, int n, int k, const float *packedA,
 
 /// Inner kernel for non-packed matrices.  In these cases N is small, so it
 /// tends to be beneficial to retain locality in the A matrix.
+template <size_t regsA, size_t regsB>
 void libjit_matmul_inner_unpacked(int m, int n, int k, const float *a, int lda,
                                   const float *b, int ldb, float *c, int ldc) {
+  constexpr int mr = getMR(regsA);
+  constexpr int nr = getNR(regsB);
   for (int i = 0; i < m - mr + 1; i += mr) {
     for (int j = 0; j < n - nr + 1; j += nr) {
       libjit_matmul_dot<regsA, regsB>(k, &A(i, 0), lda, &B(0, j), ldb, &C(i, j),
@@ -166,10 +197,12 @@ void libjit_matmul_inner_unpacked(int m, int n, int k, const float *a, int lda,
 
 /// Compute a portion of C one block at a time.  Handle ragged edges with calls
 /// to a slow but general helper.
-template <bool pack>
+template <bool pack, size_t regsA, size_t regsB>
 void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
                          const float *b, int ldb, float *c, int ldc,
                          float *packedB) {
+  constexpr int mr = getMR(regsA);
+  constexpr int nr = getNR(regsB);
   // The tiling scheme naturally divides the input matrices into 2 parts each;
   // one tiled section, and three "ragged" edges.
   //
@@ -180,7 +213,8 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
   // --------------------    -------
   //
   // We can process this as 4 separate matrix multiplications.  A00*B00 is the
-  // perfectly-tiled portion, which we handly with a 4x16 dot-product kernel.
+  // perfectly-tiled portion, which we handly with a mr x nr dot-product
+  // kernel.
   // The ragged edges are (ideally) less critical, so we handle them with a call
   // to a general matrix-multiplication for odd sizes.
   float packedA[m * k] __attribute__((aligned(64)));
@@ -189,9 +223,11 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
   }
 
   if (pack) {
-    libjit_matmul_inner_packed(m, n, k, packedA, packedB, c, ldc);
+    libjit_matmul_inner_packed<regsA, regsB>(m, n, k, packedA, packedB, c,
+                                             ldc);
   } else {
-    libjit_matmul_inner_unpacked(m, n, k, a, lda, b, ldb, c, ldc);
+    libjit_matmul_inner_unpacked<regsA, regsB>(m, n, k, a, lda, b, ldb, c,
+                                               ldc);
   }
 
   sdim_t i = (m / mr) * mr;
@@ -216,7 +252,7 @@ void libjit_matmul_inner(int m, int n, int k, const float *a, int lda,
 /// \p c is a \p m x \p n column-major matrix.
 /// \p lda, \p ldb, and \p ldc are the leading dimensions of A, B, and C,
 /// respectively.
-template <bool pack>
+template <bool pack, size_t regsA, size_t regsB>
 void __attribute__((noinline))
 libjit_matmul_outer(dim_t m, dim_t n, dim_t k, const float *a, dim_t lda,
                     const float *b, dim_t ldb, float *c, dim_t ldc) {
@@ -234,8 +270,9 @@ libjit_matmul_outer(dim_t m, dim_t n, dim_t k, const float *a, dim_t lda,
       }
       for (dim_t i = 0; i < m; i += mc) {
         dim_t ib = MIN(m - i, mc);
-        libjit_matmul_inner<pack>(ib, jb, pb, &A(i, p), lda, &B(p, j), ldb,
-                                  &C(i, j), ldc, packedB);
+        libjit_matmul_inner<pack, regsA, regsB>(ib, jb, pb, &A(i, p), lda,
+                                                &B(p, j), ldb, &C(i, j), ldc,
+                                                packedB);
       }
     }
   }
@@ -249,6 +286,62 @@ libjit_matmul_outer(dim_t m, dim_t n, dim_t k, const float *a, dim_t lda,
 #undef B
 #undef A
 
+/// Performs the matrix multiplication c = a * b, where c, a, and b are
+/// row-major matrices, using the dot-product kernel with the register block
+/// \p regsA x \p regsB.
+/// \p c is a m x n matrix, so \p cDims = {m, n}
+/// \p a is a m x k matrix, so \p aDims = {m, k}
+/// \p b is a k x n matrix, so \p bDims = {k, n}
+template <size_t regsA, size_t regsB>
+void libjit_matmul_f_impl(float *c, const float *a, const float *b,
+                          const dim_t *cDims, const dim_t *aDims,
+                          const dim_t *bDims) {
+  constexpr int mr = getMR(regsA);
+  memset(c, 0, cDims[0] * cDims[1] * sizeof(float));
+  // Call the matrix multiplication routine with appropriate dimensions and
+  // leading dimensions. The "leading dimension" for a row-major matrix is equal
+  // to the number of columns in the matrix.  For a, this is k; for b and c,
+  // this is n.
+  //
+  // This "outer" helper assumes the matrices are given in column-major format
+  // (the packing algorithm is more effective with column-major matrices), while
+  // the input is row-major. So we compute C += B * A, which is equivalent.
+  //
+  // The matrix multiplication routine is heavily inspired by:
+  // https://github.com/flame/how-to-optimize-gemm
+  int m = cDims[1];
+  int n = cDims[0];
+  int k = aDims[1];
+
+  // Use the unpacked version which does not use extra HEAP or STACK which
+  // makes the memory usage predictable. This is very useful when building
+  // bundles (AOT) for MCU targets where the HEAP and STACK are relatively
+  // limited in size. By avoiding heap/stack usage the memory consumption
+  // is controlled and perfectly known (e.g. printed in the bundle API).
+  //
+  // Blocks of mr rows of the column-major result are independent, so they are
+  // split across the intra-op threads.
+  struct Args {
+    dim_t m, n, k;
+    const float *a;
+    dim_t lda;
+    const float *b;
+    dim_t ldb;
+    float *c;
+    dim_t ldc;
+  } args{dim_t(m), dim_t(n), dim_t(k), b, bDims[1], a, aDims[1], c, cDims[1]};
+  libjit_parallel_for(
+      (m + mr - 1) / mr,
+      [](void *ctx, dim_t begin, dim_t end) {
+        const Args &p = *static_cast<Args *>(ctx);
+        dim_t i = begin * mr;
+        dim_t ib = MIN(end * mr, p.m) - i;
+        libjit_matmul_outer<false, regsA, regsB>(ib, p.n, p.k, p.a + i, p.lda,
+                                                 p.b, p.ldb, p.c + i, p.ldc);
+      },
+      &args);
+}
+
 /// Generic template for FullyConnected. The template allows choosing the
 /// element type and bias type.
 template <typename ElemTy, typename BiasElemTy>
@@ -314,40 +407,528 @@ void libjit_rowwise_quantized_fc_generic(
     }
   }
 }
+
+/// Number of columns of B in a block of the packed int8 layout, one per
+/// int32 lane of a zmm register.
+constexpr dim_t packedI8NR = 16;
+/// Number of consecutive values along K of a column in a block of the packed
+/// int8 layout, multiplied and summed by a lane of vpdpbusd.
+constexpr dim_t packedI8KR = 4;
+
+/// The packed int8 GEMM kernels multiply the s8 values of A with B packed as
+/// u8 values (b + 128), as required by vpdpbusd. With sums over K, the result
+/// is then:
+///   sum((a - aOffset) * (b - bOffset))
+///     = sum(a * (b + 128)) - aOffset * sum(b) + K * aOffset * bOffset
+///       - (128 + bOffset) * sum(a)
+/// The terms depending only on the column of B, plus the bias scaled to the
+/// scale of the product, are stored as the column terms of B, padded with
+/// zeros to a multiple of packedI8NR. The last term is computed per row of A.
+///
+/// B is packed as [N / packedI8NR, K / packedI8KR, packedI8NR, packedI8KR],
+/// with N and K rounded up and padded with zeros, so that a block of columns
+/// is read sequentially. The CPU backend packs constant weights in the same
+/// layout at compile time.
+struct PackedI8GemmArgs {
+  dim_t m, n, k;
+  /// Row-major m x k matrix A.
+  const int8_t *a;
+  dim_t lda;
+  /// B in the packed layout.
+  const uint8_t *packedB;
+  /// Column terms of B.
+  const int32_t *colTerms;
+  int32_t bOffset;
+  /// Row-major m x n output.
+  int8_t *out;
+  dim_t ldo;
+  int32_t outOffset, outPre, outPost, outScale;
+};
+
+/// \returns K rounded up to the depth of the packed int8 layout.
+inline dim_t libjit_packed_i8_depth(dim_t k) {
+  return (k + packedI8KR - 1) / packedI8KR * packedI8KR;
+}
+
+/// Pack the \p k x \p n row-major matrix \p b into \p b_to, and store its
+/// column terms without bias into \p colTerms, see PackedI8GemmArgs.
+void pack_matrix_b_i8(dim_t k, dim_t n, const int8_t *b, dim_t ldb,
+                      int32_t aOffset, int32_t bOffset, uint8_t *b_to,
+                      int32_t *colTerms) {
+  dim_t kp = libjit_packed_i8_depth(k);
+  dim_t np = (n + packedI8NR - 1) / packedI8NR * packedI8NR;
+  for (dim_t jb = 0; jb < n; jb += packedI8NR) {
+    for (dim_t p = 0; p < kp; p += packedI8KR) {
+      for (dim_t j = jb; j < jb + packedI8NR; j++) {
+        for (dim_t q = p; q < p + packedI8KR; q++) {
+          *b_to++ = (j < n && q < k) ? uint8_t(b[q * ldb + j] + 128) : 0;
+        }
+      }
+    }
+  }
+  for (dim_t j = 0; j < np; j++) {
+    int32_t sum = 0;
+    for (dim_t q = 0; j < n && q < k; q++) {
+      sum += b[q * ldb + j];
+    }
+    colTerms[j] = j < n ? int32_t(k) * aOffset * bOffset - aOffset * sum : 0;
+  }
+}
+
+/// \returns the row term of the row \p row of A with \p k values, see
+/// PackedI8GemmArgs.
+inline int32_t libjit_packed_i8_row_term(const int8_t *row, dim_t k,
+                                         int32_t bOffset) {
+  int32_t sum = 0;
+  for (dim_t q = 0; q < k; q++) {
+    sum += row[q];
+  }
+  return -(128 + bOffset) * sum;
+}
+
+/// Compute the GEMM described by \p p in the packed layout without relying on
+/// any vector extension.
+void libjit_gemm_packed_i8(const PackedI8GemmArgs &p) {
+  dim_t kp = libjit_packed_i8_depth(p.k);
+  for (dim_t i = 0; i < p.m; i++) {
+    const int8_t *aRow = p.a + i * p.lda;
+    int32_t rowTerm = libjit_packed_i8_row_term(aRow, p.k, p.bOffset);
+    for (dim_t j = 0; j < p.n; j++) {
+      const uint8_t *bBlock = p.packedB + (j / packedI8NR) * packedI8NR * kp;
+      int32_t sum = p.colTerms[j] + rowTerm;
+      for (dim_t q = 0; q < p.k; q++) {
+        int32_t b = bBlock[(q / packedI8KR) * packedI8NR * packedI8KR +
+                           (j % packedI8NR) * packedI8KR + q % packedI8KR];
+        sum += int32_t(aRow[q]) * b;
+      }
+      int32_t scaled = libjit_scale<int32_t>(sum, p.outPre, p.outPost,
+                                             p.outScale, p.outOffset);
+      p.out[i * p.ldo + j] = libjit_clip_i8(scaled);
+    }
+  }
+}
+
+#ifdef LIBJIT_VNNI_KERNELS
+/// Number of rows of A computed at once by the VNNI kernel.
+constexpr dim_t vnniMR = 4;
+
+/// Compute the \p rows x packedI8NR block of the output at row \p i and
+/// column \p j of the GEMM described by \p p with AVX512-VNNI, and requantize
+/// it to int8. \p rowTerms are the row terms of the rows of the block.
+template <dim_t rows>
+LIBJIT_VNNI_TARGET void
+libjit_gemm_packed_i8_vnni_block(const PackedI8GemmArgs &p, dim_t i, dim_t j,
+                                 const int32_t *rowTerms) {
+  dim_t kp = libjit_packed_i8_depth(p.k);
+  __m512i acc[rows];
+  for (dim_t r = 0; r < rows; r++) {
+    acc[r] = _mm512_setzero_si512();
+  }
+  const uint8_t *bPtr = p.packedB + j * kp;
+  const int8_t *aPtr = p.a + i * p.lda;
+  dim_t q = 0;
+  for (; q + packedI8KR <= p.k; q += packedI8KR) {
+    __m512i bb = _mm512_loadu_si512(bPtr);
+    bPtr += packedI8NR * packedI8KR;
+    for (dim_t r = 0; r < rows; r++) {
+      int32_t a4;
+      memcpy(&a4, aPtr + r * p.lda + q, sizeof(a4));
+      acc[r] = _mm512_dpbusd_epi32(acc[r], bb, _mm512_set1_epi32(a4));
+    }
+  }
+  // The last values of K are padded with zeros.
+  if (q < p.k) {
+    __m512i bb = _mm512_loadu_si512(bPtr);
+    for (dim_t r = 0; r < rows; r++) {
+      int32_t a4 = 0;
+      memcpy(&a4, aPtr + r * p.lda + q, p.k - q);
+      acc[r] = _mm512_dpbusd_epi32(acc[r], bb, _mm512_set1_epi32(a4));
+    }
+  }
+
+  // Requantize the block, see libjit_scale().
+  __m512i colTerms = _mm512_loadu_si512(p.colTerms + j);
+  __m128i pre = _mm_cvtsi32_si128(p.outPre);
+  __m128i post = _mm_cvtsi32_si128(p.outPost);
+  __m512i scale = _mm512_set1_epi32(p.outScale);
+  __m512i rtn = _mm512_set1_epi32(p.outPost > 0 ? 1 << (p.outPost - 1) : 0);
+  __m512i offset = _mm512_set1_epi32(p.outOffset);
+  __mmask16 mask = p.n - j >= packedI8NR ? __mmask16(0xFFFF)
+                                         : __mmask16((1 << (p.n - j)) - 1);
+  for (dim_t r = 0; r < rows; r++) {
+    __m512i sum = _mm512_add_epi32(_mm512_add_epi32(acc[r], colTerms),
+                                   _mm512_set1_epi32(rowTerms[r]));
+    sum = _mm512_mullo_epi32(_mm512_sra_epi32(sum, pre), scale);
+    sum = _mm512_add_epi32(
+        _mm512_sra_epi32(_mm512_add_epi32(sum, rtn), post), offset);
+    _mm_mask_storeu_epi8(p.out + (i + r) * p.ldo + j, mask,
+                         _mm512_cvtsepi32_epi8(sum));
+  }
+}
+
+/// Compute the GEMM described by \p args in the packed layout with
+/// AVX512-VNNI. Blocks of vnniMR rows of the result are independent, so they
+/// are split across the intra-op threads.
+void libjit_gemm_packed_i8_vnni(const PackedI8GemmArgs &args) {
+  libjit_parallel_for(
+      (args.m + vnniMR - 1) / vnniMR,
+      [](void *ctx, dim_t begin, dim_t end) {
+        const PackedI8GemmArgs &p = *static_cast<PackedI8GemmArgs *>(ctx);
+        for (dim_t i = begin * vnniMR, e = MIN(end * vnniMR, p.m); i < e;) {
+          dim_t rows = MIN(e - i, vnniMR);
+          int32_t rowTerms[vnniMR];
+          for (dim_t r = 0; r < rows; r++) {
+            rowTerms[r] = libjit_packed_i8_row_term(p.a + (i + r) * p.lda, p.k,
+                                                    p.bOffset);
+          }
+          for (dim_t j = 0; j < p.n; j += packedI8NR) {
+            if (rows == vnniMR) {
+              libjit_gemm_packed_i8_vnni_block<vnniMR>(p, i, j, rowTerms);
+              continue;
+            }
+            for (dim_t r = 0; r < rows; r++) {
+              libjit_gemm_packed_i8_vnni_block<1>(p, i + r, j, rowTerms + r);
+            }
+          }
+          i += rows;
+        }
+      },
+      const_cast<PackedI8GemmArgs *>(&args));
+}
+
+/// Compute the int8 \p m x \p n row-major matrix \p out from the \p m x
+/// \p k row-major matrix \p a and the \p k x \p n row-major matrix \p b,
+/// like libjit_matmul_i8 and libjit_fc_generic, with AVX512-VNNI. B is packed
+/// on every call. \p biasTerms are the bias values already scaled to the
+/// scale of the matrix product, or nullptr if there is no bias.
+void libjit_gemm_i8_vnni(dim_t m, dim_t n, dim_t k, const int8_t *a, dim_t lda,
+                         const int8_t *b, dim_t ldb, const int32_t *biasTerms,
+                         int8_t *out, dim_t ldo, int32_t aOffset,
+                         int32_t bOffset, int32_t outOffset, int32_t outPre,
+                         int32_t outPost, int32_t outScale) {
+  dim_t np = (n + packedI8NR - 1) / packedI8NR * packedI8NR;
+  uint8_t *packedB = nullptr;
+  int32_t *colTerms = nullptr;
+  libjit_aligned_malloc((void **)&packedB, 64, np * libjit_packed_i8_depth(k));
+  libjit_aligned_malloc((void **)&colTerms, 64, np * sizeof(int32_t));
+  pack_matrix_b_i8(k, n, b, ldb, aOffset, bOffset, packedB, colTerms);
+  for (dim_t j = 0; biasTerms && j < n; j++) {
+    colTerms[j] += biasTerms[j];
+  }
+
+  PackedI8GemmArgs args{m,         n,      k,       a,       lda,
+                        packedB,   colTerms, bOffset, out,   ldo,
+                        outOffset, outPre, outPost, outScale};
+  libjit_gemm_packed_i8_vnni(args);
+
+  libjit_aligned_free(colTerms);
+  libjit_aligned_free(packedB);
+}
+
+/// FullyConnected with int8 precision using AVX512-VNNI, see
+/// libjit_fc_generic.
+template <typename BiasElemTy>
+void libjit_fc_i8_vnni(int8_t *outW, const int8_t *inW, const int8_t *weightsW,
+                       const BiasElemTy *biasW, const dim_t *outWdims,
+                       const dim_t *inWdims, const dim_t *weightsWdims,
+                       int32_t outOffset, int32_t inOffset,
+                       int32_t weightsOffset, int32_t biasOffset,
+                       int32_t biasPre, int32_t biasPost, int32_t biasScale,
+                       int32_t outPre, int32_t outPost, int32_t outScale) {
+  dim_t out_w = outWdims[1];
+  int32_t *biasTerms = nullptr;
+  libjit_aligned_malloc((void **)&biasTerms, 64, out_w * sizeof(int32_t));
+  for (dim_t j = 0; j < out_w; j++) {
+    biasTerms[j] = libjit_scale<int32_t>(biasW[j] - biasOffset, biasPre,
+                                         biasPost, biasScale, 0);
+  }
+  libjit_gemm_i8_vnni(outWdims[0], out_w, inWdims[1], inW, inWdims[1],
+                      weightsW, weightsWdims[1], biasTerms, outW, out_w,
+                      inOffset, weightsOffset, outOffset, outPre, outPost,
+                      outScale);
+  libjit_aligned_free(biasTerms);
+}
+#endif // LIBJIT_VNNI_KERNELS
+
+/// GEMM with bfloat16 operands and float accumulation, computing the \p m x
+/// \p n row-major matrix c = a * b + bias from the \p m x \p k row-major
+/// matrix a and the \p k x \p n row-major matrix b. \p bias is a row of \p n
+/// values added to every row of c, or nullptr.
+struct BF16GemmArgs {
+  dim_t m, n, k;
+  const uint16_t *a;
+  dim_t lda;
+  const uint16_t *b;
+  dim_t ldb;
+  const uint16_t *bias;
+  uint16_t *c;
+  dim_t ldc;
+};
+
+/// Number of columns of b packed together, and of c computed at once, by the
+/// bfloat16 kernels. The packed panel is read contiguously by every block of
+/// rows, instead of touching a new row of b, and page, for every value of K.
+constexpr dim_t bf16NR = 32;
+
+/// Number of rows of c computed at once by the bfloat16 kernel.
+constexpr dim_t bf16MR = 2;
+
+/// \returns K rounded up to the pairs of values of the packed AVX512-BF16
+/// layout, which is also enough for the plain layout.
+inline dim_t libjit_packed_bf16_depth(dim_t k) { return (k + 1) / 2 * 2; }
+
+/// Pack the columns [\p j, \p j + bf16NR) of b into \p packed, row after row,
+/// with zeros past the last column.
+void libjit_pack_bf16_panel(const BF16GemmArgs &p, dim_t j, uint16_t *packed) {
+  const dim_t cols = MIN(bf16NR, p.n - j);
+  for (dim_t q = 0; q < p.k; q++) {
+    memcpy(packed + q * bf16NR, p.b + q * p.ldb + j, cols * sizeof(uint16_t));
+    memset(packed + q * bf16NR + cols, 0, (bf16NR - cols) * sizeof(uint16_t));
+  }
+}
+
+/// Compute the \p rows x bf16NR block of c at row \p i and column \p j of the
+/// GEMM described by \p p from the panel of b \p packed, widening its values
+/// to floats as they are loaded.
+template <dim_t rows>
+void libjit_gemm_bf16_block(const BF16GemmArgs &p, const uint16_t *packed,
+                            dim_t i, dim_t j) {
+  constexpr dim_t vecs = bf16NR / 8;
+  const dim_t cols = MIN(bf16NR, p.n - j);
+  float bias[bf16NR] = {0};
+  for (dim_t col = 0; p.bias && col < cols; col++) {
+    bias[col] = libjit_bf16_to_fp32(p.bias[j + col]);
+  }
+  float8 acc[rows][vecs];
+  for (dim_t r = 0; r < rows; r++) {
+    for (dim_t v = 0; v < vecs; v++) {
+      acc[r][v] = LoaduFloat8(bias + v * 8);
+    }
+  }
+  for (dim_t q = 0; q < p.k; q++) {
+    float8 b[vecs];
+    for (dim_t v = 0; v < vecs; v++) {
+      b[v] = libjit_load_bf16_float8(packed + q * bf16NR + v * 8);
+    }
+    for (dim_t r = 0; r < rows; r++) {
+      const float8 a =
+          BroadcastFloat8(libjit_bf16_to_fp32(p.a[(i + r) * p.lda + q]));
+      for (dim_t v = 0; v < vecs; v++) {
+        acc[r][v] += a * b[v];
+      }
+    }
+  }
+  for (dim_t r = 0; r < rows; r++) {
+    uint16_t out[bf16NR];
+    for (dim_t v = 0; v < vecs; v++) {
+      libjit_store_bf16_float8(out + v * 8, acc[r][v]);
+    }
+    memcpy(p.c + (i + r) * p.ldc + j, out, cols * sizeof(uint16_t));
+  }
+}
+
+/// Compute the rows [\p i, \p i + \p rows) of the column panel \p j of the
+/// GEMM described by \p p from the panel of b \p packed, without relying on
+/// any vector extension but float8.
+void libjit_gemm_bf16_panel_rows(const BF16GemmArgs &p, const uint16_t *packed,
+                                 dim_t i, dim_t rows, dim_t j) {
+  if (rows == bf16MR) {
+    libjit_gemm_bf16_block<bf16MR>(p, packed, i, j);
+    return;
+  }
+  for (dim_t r = i; r < i + rows; r++) {
+    libjit_gemm_bf16_block<1>(p, packed, r, j);
+  }
+}
+
+/// Body of libjit_parallel_for computing the column panels [\p begin, \p end)
+/// of the GEMM described by \p ctx. Every panel of b is packed with \p pack,
+/// then all the rows of c are computed \p MR at a time with \p panelRows.
+template <dim_t MR,
+          void (*pack)(const BF16GemmArgs &, dim_t, uint16_t *),
+          void (*panelRows)(const BF16GemmArgs &, const uint16_t *, dim_t,
+                            dim_t, dim_t)>
+void libjit_gemm_bf16_panels(void *ctx, dim_t begin, dim_t end) {
+  const BF16GemmArgs &p = *static_cast<BF16GemmArgs *>(ctx);
+  uint16_t *packed = nullptr;
+  libjit_aligned_malloc((void **)&packed, 64,
+                        libjit_packed_bf16_depth(p.k) * bf16NR *
+                            sizeof(uint16_t));
+  for (dim_t panel = begin; panel < end; panel++) {
+    const dim_t j = panel * bf16NR;
+    pack(p, j, packed);
+    for (dim_t i = 0; i < p.m; i += MR) {
+      panelRows(p, packed, i, MIN(MR, p.m - i), j);
+    }
+  }
+  libjit_aligned_free(packed);
+}
+
+/// Compute the GEMM described by the arguments, see BF16GemmArgs. Panels of
+/// bf16NR columns of c are independent, so they are split across the intra-op
+/// threads and every thread streams its own part of b, which usually holds the
+/// weights.
+void libjit_gemm_bf16(dim_t m, dim_t n, dim_t k, const uint16_t *a, dim_t lda,
+                      const uint16_t *b, dim_t ldb, const uint16_t *bias,
+                      uint16_t *c, dim_t ldc) {
+  BF16GemmArgs args{m, n, k, a, lda, b, ldb, bias, c, ldc};
+  libjit_parallel_for((n + bf16NR - 1) / bf16NR,
+                      libjit_gemm_bf16_panels<bf16MR, libjit_pack_bf16_panel,
+                                              libjit_gemm_bf16_panel_rows>,
+                      &args);
+}
+
+#ifdef LIBJIT_BF16_KERNELS
+/// Number of rows of c computed at once by the AVX512-BF16 kernel.
+constexpr dim_t avx512BF16MR = 6;
+
+/// Pack the columns [\p j, \p j + bf16NR) of b into \p packed for the dot
+/// products of pairs of bfloat16 numbers: the values of rows 2q and 2q + 1 of
+/// every column are next to each other. Rows past K and columns past N are
+/// zeros.
+void libjit_pack_bf16_panel_pairs(const BF16GemmArgs &p, dim_t j,
+                                  uint16_t *packed) {
+  const dim_t cols = MIN(bf16NR, p.n - j);
+  const dim_t kp = libjit_packed_bf16_depth(p.k);
+  memset(packed, 0, kp * bf16NR * sizeof(uint16_t));
+  for (dim_t q = 0; q < p.k; q++) {
+    const uint16_t *bRow = p.b + q * p.ldb + j;
+    uint16_t *dst = packed + (q / 2) * 2 * bf16NR + q % 2;
+    for (dim_t col = 0; col < cols; col++) {
+      dst[col * 2] = bRow[col];
+    }
+  }
+}
+
+/// \returns the bfloat16 numbers selected by \p mask at \p p as floats.
+LIBJIT_BF16_TARGET inline __m512 libjit_load_bf16_ps(__mmask16 mask,
+                                                     const uint16_t *p) {
+  const __m512i b = _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(mask, p));
+  return _mm512_castsi512_ps(_mm512_slli_epi32(b, 16));
+}
+
+/// Store the float lanes of \p v selected by \p mask to the bfloat16 numbers at
+/// \p p, truncated like libjit_fp32_to_bf16.
+LIBJIT_BF16_TARGET inline void libjit_store_bf16_ps(uint16_t *p,
+                                                    __mmask16 mask, __m512 v) {
+  const __mmask16 nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+  __m512i bits = _mm512_srli_epi32(_mm512_castps_si512(v), 16);
+  bits = _mm512_mask_or_epi32(bits, nan, bits, _mm512_set1_epi32(0x40));
+  _mm256_mask_storeu_epi16(p, mask, _mm512_cvtepi32_epi16(bits));
+}
+
+/// Compute the \p rows x bf16NR block of c at row \p i and column \p j of the
+/// GEMM described by \p p with AVX512-BF16, from the panel of b \p packed by
+/// libjit_pack_bf16_panel_pairs.
+template <dim_t rows>
+LIBJIT_BF16_TARGET void
+libjit_gemm_bf16_avx512_block(const BF16GemmArgs &p, const uint16_t *packed,
+                              dim_t i, dim_t j) {
+  const dim_t cols = MIN(bf16NR, p.n - j);
+  __mmask16 mask[2];
+  for (dim_t v = 0; v < 2; v++) {
+    const dim_t vCols = cols > v * 16 ? MIN(cols - v * 16, 16) : 0;
+    mask[v] = vCols == 16 ? __mmask16(0xFFFF) : __mmask16((1 << vCols) - 1);
+  }
+  __m512 acc[rows][2];
+  for (dim_t v = 0; v < 2; v++) {
+    const __m512 bias =
+        p.bias ? libjit_load_bf16_ps(mask[v], p.bias + j + v * 16)
+               : _mm512_setzero_ps();
+    for (dim_t r = 0; r < rows; r++) {
+      acc[r][v] = bias;
+    }
+  }
+  const uint16_t *aPtr = p.a + i * p.lda;
+  for (dim_t q = 0; q < p.k; q += 2) {
+    const uint16_t *bPtr = packed + q * bf16NR;
+    const __m512bh b0 = (__m512bh)_mm512_loadu_si512(bPtr);
+    const __m512bh b1 = (__m512bh)_mm512_loadu_si512(bPtr + 32);
+    for (dim_t r = 0; r < rows; r++) {
+      // The last value of an odd K is paired with a zero.
+      uint32_t a2 = aPtr[r * p.lda + q];
+      if (q + 1 < p.k) {
+        a2 |= uint32_t(aPtr[r * p.lda + q + 1]) << 16;
+      }
+      const __m512bh aa = (__m512bh)_mm512_set1_epi32(a2);
+      acc[r][0] = _mm512_dpbf16_ps(acc[r][0], aa, b0);
+      acc[r][1] = _mm512_dpbf16_ps(acc[r][1], aa, b1);
+    }
+  }
+  for (dim_t r = 0; r < rows; r++) {
+    for (dim_t v = 0; v < 2; v++) {
+      libjit_store_bf16_ps(p.c + (i + r) * p.ldc + j + v * 16, mask[v],
+                           acc[r][v]);
+    }
+  }
+}
+
+/// Same as libjit_gemm_bf16_panel_rows, using AVX512-BF16.
+LIBJIT_BF16_TARGET void
+libjit_gemm_bf16_avx512_panel_rows(const BF16GemmArgs &p,
+                                   const uint16_t *packed, dim_t i, dim_t rows,
+                                   dim_t j) {
+  if (rows == avx512BF16MR) {
+    libjit_gemm_bf16_avx512_block<avx512BF16MR>(p, packed, i, j);
+    return;
+  }
+  for (dim_t r = i; r < i + rows; r++) {
+    libjit_gemm_bf16_avx512_block<1>(p, packed, r, j);
+  }
+}
+
+/// Same as libjit_gemm_bf16, using AVX512-BF16.
+void libjit_gemm_bf16_avx512(dim_t m, dim_t n, dim_t k, const uint16_t *a,
+                             dim_t lda, const uint16_t *b, dim_t ldb,
+                             const uint16_t *bias, uint16_t *c, dim_t ldc) {
+  BF16GemmArgs args{m, n, k, a, lda, b, ldb, bias, c, ldc};
+  libjit_parallel_for(
+      (n + bf16NR - 1) / bf16NR,
+      libjit_gemm_bf16_panels<avx512BF16MR, libjit_pack_bf16_panel_pairs,
+                              libjit_gemm_bf16_avx512_panel_rows>,
+      &args);
+}
+#endif // LIBJIT_BF16_KERNELS
 } // namespace
 
 extern "C" {
 
 /// Performs the matrix multiplication c = a * b, where c, a, and b are
-/// row-major matrices.
+/// row-major matrices, with a register block that suits any target.
 /// \p c is a m x n matrix, so \p cDims = {m, n}
 /// \p a is a m x k matrix, so \p aDims = {m, k}
 /// \p b is a k x n matrix, so \p bDims = {k, n}
 void libjit_matmul_f(float *c, const float *a, const float *b,
                      const dim_t *cDims, const dim_t *aDims,
                      const dim_t *bDims) {
+  libjit_matmul_f_impl<genericRegsA, genericRegsB>(c, a, b, cDims, aDims,
+                                                   bDims);
+}
+
+/// Same as libjit_matmul_f, but runs on the calling thread. Used by kernels
+/// that already split independent matrix products across threads.
+void libjit_matmul_serial_f(float *c, const float *a, const float *b,
+                            const dim_t *cDims, const dim_t *aDims,
+                            const dim_t *bDims) {
   memset(c, 0, cDims[0] * cDims[1] * sizeof(float));
-  // Call the matrix multiplication routine with appropriate dimensions and
-  // leading dimensions. The "leading dimension" for a row-major matrix is equal
-  // to the number of columns in the matrix.  For a, this is k; for b and c,
-  // this is n.
-  //
-  // This "outer" helper assumes the matrices are given in column-major format
-  // (the packing algorithm is more effective with column-major matrices), while
-  // the input is row-major. So we compute C += B * A, which is equivalent.
-  //
-  // The matrix multiplication routine is heavily inspired by:
-  // https://github.com/flame/how-to-optimize-gemm
-  int m = cDims[1];
-  int n = cDims[0];
-  int k = aDims[1];
+  // Column-major, see libjit_matmul_f_impl.
+  libjit_matmul_outer<false, genericRegsA, genericRegsB>(
+      cDims[1], cDims[0], aDims[1], b, bDims[1], a, aDims[1], c, cDims[1]);
+}
 
-  // Use the unpacked version which does not use extra HEAP or STACK which
-  // makes the memory usage predictable. This is very useful when building
-  // bundles (AOT) for MCU targets where the HEAP and STACK are relatively
-  // limited in size. By avoiding heap/stack usage the memory consumption
-  // is controlled and perfectly known (e.g. printed in the bundle API).
-  libjit_matmul_outer<false>(m, n, k, b, bDims[1], a, aDims[1], c, cDims[1]);
+/// Same as libjit_matmul_f, with a register block sized for AVX2 targets.
+void libjit_matmul_avx2_f(float *c, const float *a, const float *b,
+                          const dim_t *cDims, const dim_t *aDims,
+                          const dim_t *bDims) {
+  libjit_matmul_f_impl<avx2RegsA, avx2RegsB>(c, a, b, cDims, aDims, bDims);
+}
+
+/// Same as libjit_matmul_f, with a register block sized for AVX-512 targets.
+void libjit_matmul_avx512_f(float *c, const float *a, const float *b,
+                            const dim_t *cDims, const dim_t *aDims,
+                            const dim_t *bDims) {
+  libjit_matmul_f_impl<avx512RegsA, avx512RegsB>(c, a, b, cDims, aDims,
+                                                 bDims);
 }
 
 void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW, const int8_t *rhsW,
@@ -370,6 +951,21 @@ void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW, const int8_t *rhsW,
   }
 }
 
+#ifdef LIBJIT_VNNI_KERNELS
+/// Same as libjit_matmul_i8, using AVX512-VNNI.
+void libjit_matmul_vnni_i8(int8_t *outW, const int8_t *lhsW,
+                           const int8_t *rhsW, const dim_t *outWdims,
+                           const dim_t *lhsWdims, const dim_t *rhsWdims,
+                           int32_t outOffset, int32_t lhsOffset,
+                           int32_t rhsOffset, int32_t outPre, int32_t outPost,
+                           int32_t outScale) {
+  libjit_gemm_i8_vnni(outWdims[0], outWdims[1], lhsWdims[1], lhsW,
+                      lhsWdims[1], rhsW, rhsWdims[1], /* biasTerms */ nullptr,
+                      outW, outWdims[1], lhsOffset, rhsOffset, outOffset,
+                      outPre, outPost, outScale);
+}
+#endif // LIBJIT_VNNI_KERNELS
+
 /// FullyConnected with float precision.
 void libjit_fc_f(float *outW, const float *inW, const float *weightsW,
                  const float *biasW, const dim_t *outWdims,
@@ -391,6 +987,47 @@ void libjit_fc_f(float *outW, const float *inW, const float *weightsW,
   }
 }
 
+/// Performs the matrix multiplication c = a * b of bfloat16 row-major
+/// matrices with float accumulation, see libjit_matmul_f.
+void libjit_matmul_bfloat16(uint16_t *c, const uint16_t *a, const uint16_t *b,
+                            const dim_t *cDims, const dim_t *aDims,
+                            const dim_t *bDims) {
+  libjit_gemm_bf16(cDims[0], cDims[1], aDims[1], a, aDims[1], b, bDims[1],
+                   /* bias */ nullptr, c, cDims[1]);
+}
+
+/// FullyConnected with bfloat16 precision and float accumulation.
+void libjit_fc_bfloat16(uint16_t *outW, const uint16_t *inW,
+                        const uint16_t *weightsW, const uint16_t *biasW,
+                        const dim_t *outWdims, const dim_t *inWdims,
+                        const dim_t *weightsWdims, const dim_t *biasWdims) {
+  libjit_gemm_bf16(outWdims[0], outWdims[1], inWdims[1], inW, inWdims[1],
+                   weightsW, weightsWdims[1], biasW, outW, outWdims[1]);
+}
+
+#ifdef LIBJIT_BF16_KERNELS
+/// Same as libjit_matmul_bfloat16, using AVX512-BF16.
+void libjit_matmul_avx512bf16_bfloat16(uint16_t *c, const uint16_t *a,
+                                       const uint16_t *b, const dim_t *cDims,
+                                       const dim_t *aDims,
+                                       const dim_t *bDims) {
+  libjit_gemm_bf16_avx512(cDims[0], cDims[1], aDims[1], a, aDims[1], b,
+                          bDims[1], /* bias */ nullptr, c, cDims[1]);
+}
+
+/// Same as libjit_fc_bfloat16, using AVX512-BF16.
+void libjit_fc_avx512bf16_bfloat16(uint16_t *outW, const uint16_t *inW,
+                                   const uint16_t *weightsW,
+                                   const uint16_t *biasW,
+                                   const dim_t *outWdims, const dim_t *inWdims,
+                                   const dim_t *weightsWdims,
+                                   const dim_t *biasWdims) {
+  libjit_gemm_bf16_avx512(outWdims[0], outWdims[1], inWdims[1], inW,
+                          inWdims[1], weightsW, weightsWdims[1], biasW, outW,
+                          outWdims[1]);
+}
+#endif // LIBJIT_BF16_KERNELS
+
 /// FullyConnected with int8 precision and int32 bias.
 void libjit_fc_i8_i32(int8_t *outW, const int8_t *inW, const int8_t *weightsW,
                       const int32_t *biasW, const dim_t *outWdims,
@@ -421,6 +1058,73 @@ void libjit_fc_i8_i8(int8_t *outW, const int8_t *inW, const int8_t *weightsW,
       biasScale, outPre, outPost, outScale);
 }
 
+#ifdef LIBJIT_VNNI_KERNELS
+/// Same as libjit_fc_i8_i32, using AVX512-VNNI.
+void libjit_fc_vnni_i8_i32(int8_t *outW, const int8_t *inW,
+                           const int8_t *weightsW, const int32_t *biasW,
+                           const dim_t *outWdims, const dim_t *inWdims,
+                           const dim_t *weightsWdims, const dim_t *biasWdims,
+                           int32_t outOffset, int32_t inOffset,
+                           int32_t weightsOffset, int32_t biasOffset,
+                           int32_t biasPre, int32_t biasPost,
+                           int32_t biasScale, int32_t outPre, int32_t outPost,
+                           int32_t outScale) {
+  libjit_fc_i8_vnni<int32_t>(outW, inW, weightsW, biasW, outWdims, inWdims,
+                             weightsWdims, outOffset, inOffset, weightsOffset,
+                             biasOffset, biasPre, biasPost, biasScale, outPre,
+                             outPost, outScale);
+}
+
+/// Same as libjit_fc_i8_i8, using AVX512-VNNI.
+void libjit_fc_vnni_i8_i8(int8_t *outW, const int8_t *inW,
+                          const int8_t *weightsW, const int8_t *biasW,
+                          const dim_t *outWdims, const dim_t *inWdims,
+                          const dim_t *weightsWdims, const dim_t *biasWdims,
+                          int32_t outOffset, int32_t inOffset,
+                          int32_t weightsOffset, int32_t biasOffset,
+                          int32_t biasPre, int32_t biasPost, int32_t biasScale,
+                          int32_t outPre, int32_t outPost, int32_t outScale) {
+  libjit_fc_i8_vnni<int8_t>(outW, inW, weightsW, biasW, outWdims, inWdims,
+                            weightsWdims, outOffset, inOffset, weightsOffset,
+                            biasOffset, biasPre, biasPost, biasScale, outPre,
+                            outPost, outScale);
+}
+#endif // LIBJIT_VNNI_KERNELS
+
+/// FullyConnected or MatMul with int8 precision, whose weights and column
+/// terms \p colTermsW were packed by the CPU backend at compile time, see
+/// PackedI8GemmArgs.
+void libjit_fc_packed_i8(int8_t *outW, const int8_t *inW,
+                         const uint8_t *packedWeightsW,
+                         const int32_t *colTermsW, const dim_t *outWdims,
+                         const dim_t *inWdims, int32_t outOffset,
+                         int32_t weightsOffset, int32_t outPre,
+                         int32_t outPost, int32_t outScale) {
+  PackedI8GemmArgs args{outWdims[0], outWdims[1],    inWdims[1],
+                        inW,         inWdims[1],     packedWeightsW,
+                        colTermsW,   weightsOffset,  outW,
+                        outWdims[1], outOffset,      outPre,
+                        outPost,     outScale};
+  libjit_gemm_packed_i8(args);
+}
+
+#ifdef LIBJIT_VNNI_KERNELS
+/// Same as libjit_fc_packed_i8, using AVX512-VNNI.
+void libjit_fc_packed_vnni_i8(int8_t *outW, const int8_t *inW,
+                              const uint8_t *packedWeightsW,
+                              const int32_t *colTermsW, const dim_t *outWdims,
+                              const dim_t *inWdims, int32_t outOffset,
+                              int32_t weightsOffset, int32_t outPre,
+                              int32_t outPost, int32_t outScale) {
+  PackedI8GemmArgs args{outWdims[0], outWdims[1],    inWdims[1],
+                        inW,         inWdims[1],     packedWeightsW,
+                        colTermsW,   weightsOffset,  outW,
+                        outWdims[1], outOffset,      outPre,
+                        outPost,     outScale};
+  libjit_gemm_packed_i8_vnni(args);
+}
+#endif // LIBJIT_VNNI_KERNELS
+
 /// Rowwise quantized FullyConnected with int8 precision and int32 bias.
 void libjit_rowwise_quantized_fc_i8_i32(
     int8_t *outW, const int8_t *inW, const int8_t *weightsW,
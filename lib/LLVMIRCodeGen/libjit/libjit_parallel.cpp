@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Portable intra-op thread pool for bundles. The JIT installs its own host
+// side of libjit_parallel_for (see CPUFunction), bundles built with
+// -bundle-parallel-runtime keep the glow_parallel_runtime_ functions below so
+// the application can start this pool instead. It only relies on compiler
+// atomics: the application provides the function creating a thread, which
+// makes it usable on RTOS targets, and optionally a function yielding the
+// processor while the workers wait for work.
+
+#include "libjit_defs.h"
+
+/// Creates a thread running \p entry(\p arg). \returns 0 on success.
+typedef int (*glow_thread_create_t)(void (*entry)(void *), void *arg);
+/// Yields the processor to other threads.
+typedef void (*glow_thread_yield_t)(void);
+
+extern "C" {
+extern void (*glow_cpu_parallel_for_hook)(dim_t numTasks, unsigned numThreads,
+                                          libjit_parallel_body_t body,
+                                          void *ctx);
+extern unsigned glow_cpu_parallel_threads;
+}
+
+namespace {
+
+/// Maximum number of threads of the pool, including the calling thread.
+constexpr unsigned kMaxThreads = 64;
+
+/// State of the pool. A parallel loop is split into numChunks chunks which
+/// the workers and the calling thread claim from ticket, whose high 32 bits
+/// hold the generation of the loop and the low 32 bits the next chunk. Since
+/// a chunk is only claimed along with the generation it belongs to, a worker
+/// late from the previous loop can never run a chunk of the next one.
+struct ParallelRuntime {
+  glow_thread_yield_t yield;
+  unsigned numWorkers;
+  /// Number of workers that have not exited yet.
+  unsigned liveWorkers;
+  /// Set to stop the workers.
+  int stop;
+  /// Set while a loop runs on the pool. Loops started meanwhile, e.g. by
+  /// other application threads, run serially.
+  int busy;
+  uint64_t ticket;
+  /// Number of chunks of the current loop that are done.
+  unsigned doneChunks;
+  /// The current loop, only written while no chunk of it can be claimed.
+  libjit_parallel_body_t body;
+  void *ctx;
+  dim_t numTasks;
+  unsigned numChunks;
+};
+
+ParallelRuntime runtime;
+
+void waitForWork() {
+  if (runtime.yield) {
+    runtime.yield();
+  }
+}
+
+uint64_t loadTicket() {
+  return __atomic_load_n(&runtime.ticket, __ATOMIC_ACQUIRE);
+}
+
+/// Claims and runs the chunks of generation \p gen until none is left.
+void runChunks(uint32_t gen) {
+  uint64_t ticket = loadTicket();
+  while (uint32_t(ticket >> 32) == gen &&
+         uint32_t(ticket) < runtime.numChunks) {
+    if (!__atomic_compare_exchange_n(&runtime.ticket, &ticket, ticket + 1,
+                                     /* weak */ true, __ATOMIC_ACQ_REL,
+                                     __ATOMIC_ACQUIRE)) {
+      continue;
+    }
+    dim_t chunk = uint32_t(ticket);
+    dim_t begin = runtime.numTasks * chunk / runtime.numChunks;
+    dim_t end = runtime.numTasks * (chunk + 1) / runtime.numChunks;
+    runtime.body(runtime.ctx, begin, end);
+    __atomic_fetch_add(&runtime.doneChunks, 1, __ATOMIC_RELEASE);
+    ticket = loadTicket();
+  }
+}
+
+void workerMain(void *) {
+  uint32_t seen = uint32_t(loadTicket() >> 32);
+  while (!__atomic_load_n(&runtime.stop, __ATOMIC_ACQUIRE)) {
+    uint32_t gen = uint32_t(loadTicket() >> 32);
+    if (gen == seen) {
+      waitForWork();
+      continue;
+    }
+    runChunks(gen);
+    seen = gen;
+  }
+  __atomic_fetch_sub(&runtime.liveWorkers, 1, __ATOMIC_RELEASE);
+}
+
+/// libjit_parallel_for hook splitting [0, \p numTasks) into up to
+/// \p numThreads chunks run by the workers and the calling thread.
+void parallelFor(dim_t numTasks, unsigned numThreads,
+                 libjit_parallel_body_t body, void *ctx) {
+  int idle = 0;
+  if (!__atomic_compare_exchange_n(&runtime.busy, &idle, 1, /* weak */ false,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    body(ctx, 0, numTasks);
+    return;
+  }
+  unsigned numChunks = numThreads < runtime.numWorkers + 1
+                           ? numThreads
+                           : runtime.numWorkers + 1;
+  if (numTasks < numChunks) {
+    numChunks = numTasks;
+  }
+  runtime.body = body;
+  runtime.ctx = ctx;
+  runtime.numTasks = numTasks;
+  runtime.numChunks = numChunks;
+  runtime.doneChunks = 0;
+  uint32_t gen = uint32_t(runtime.ticket >> 32) + 1;
+  __atomic_store_n(&runtime.ticket, uint64_t(gen) << 32, __ATOMIC_RELEASE);
+  runChunks(gen);
+  while (__atomic_load_n(&runtime.doneChunks, __ATOMIC_ACQUIRE) != numChunks) {
+    waitForWork();
+  }
+  __atomic_store_n(&runtime.busy, 0, __ATOMIC_RELEASE);
+}
+
+} // namespace
+
+extern "C" {
+
+/// Starts the pool with \p numThreads threads in total, the thread calling the
+/// bundle being one of them, so \p numThreads - 1 are created with \p create.
+/// \p yield may be null, the workers then spin while waiting for work.
+/// \returns 0 on success, or the error of \p create, after which the threads
+/// already created are stopped. Weak so that several bundles of an
+/// application share one pool.
+__attribute__((weak)) int
+glow_parallel_runtime_init(unsigned numThreads, glow_thread_create_t create,
+                           glow_thread_yield_t yield) {
+  if (numThreads > kMaxThreads) {
+    numThreads = kMaxThreads;
+  }
+  runtime.yield = yield;
+  runtime.stop = 0;
+  runtime.numWorkers = 0;
+  for (unsigned i = 1; i < numThreads; i++) {
+    __atomic_fetch_add(&runtime.liveWorkers, 1, __ATOMIC_RELAXED);
+    int err = create(workerMain, nullptr);
+    if (err) {
+      __atomic_fetch_sub(&runtime.liveWorkers, 1, __ATOMIC_RELAXED);
+      __atomic_store_n(&runtime.stop, 1, __ATOMIC_RELEASE);
+      while (__atomic_load_n(&runtime.liveWorkers, __ATOMIC_ACQUIRE)) {
+        waitForWork();
+      }
+      return err;
+    }
+    runtime.numWorkers++;
+  }
+  glow_cpu_parallel_threads = numThreads;
+  glow_cpu_parallel_for_hook = parallelFor;
+  return 0;
+}
+
+/// Stops the threads of the pool and waits for them to exit. Must not be
+/// called while a bundle is running.
+__attribute__((weak)) void glow_parallel_runtime_shutdown(void) {
+  glow_cpu_parallel_for_hook = nullptr;
+  glow_cpu_parallel_threads = 1;
+  __atomic_store_n(&runtime.stop, 1, __ATOMIC_RELEASE);
+  while (__atomic_load_n(&runtime.liveWorkers, __ATOMIC_ACQUIRE)) {
+    waitForWork();
+  }
+  runtime.numWorkers = 0;
+}
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Decoder of the compressed constant weights of bundles, see
+// glow/LLVMIRCodeGen/WeightsCompression.h for the format. Bundles built with
+// -bundle-compress-weights keep the glow_weights_ functions below so the
+// application can decode the weights into the constantWeight region, either
+// from the whole compressed file or one block at a time.
+
+#include "libjit_defs.h"
+
+namespace {
+
+constexpr uint32_t kMagic = 0x5a574c47;
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kHeaderSize = 16;
+constexpr uint64_t kBlockHeaderSize = 24;
+constexpr unsigned kMaxCodeLength = 15;
+
+/// Error returned for malformed compressed weights.
+constexpr int kBadWeights = 1;
+
+uint32_t getU32(const uint8_t *p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+         (uint32_t(p[3]) << 24);
+}
+
+uint64_t getU64(const uint8_t *p) {
+  return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32);
+}
+
+int decodeBitmask(const uint8_t *src, uint32_t srcSize, uint8_t *dst,
+                  uint32_t dstSize) {
+  uint32_t pos = 0;
+  for (uint32_t group = 0; group < dstSize; group += 8) {
+    if (pos >= srcSize) {
+      return kBadWeights;
+    }
+    uint8_t mask = src[pos++];
+    for (uint32_t i = 0; i < 8 && group + i < dstSize; i++) {
+      if (mask & (1 << i)) {
+        if (pos >= srcSize) {
+          return kBadWeights;
+        }
+        dst[group + i] = src[pos++];
+      } else {
+        dst[group + i] = 0;
+      }
+    }
+  }
+  return 0;
+}
+
+int decodeHuffman(const uint8_t *src, uint32_t srcSize, uint8_t *dst,
+                  uint32_t dstSize) {
+  if (srcSize < 128) {
+    return kBadWeights;
+  }
+  // Canonical code tables: the number of codes of each length, and the byte
+  // values sorted by code length then value.
+  uint16_t count[kMaxCodeLength + 1] = {0};
+  uint8_t symbols[256];
+  for (unsigned sym = 0; sym < 256; sym++) {
+    count[(src[sym / 2] >> (4 * (sym % 2))) & 0xf]++;
+  }
+  uint16_t offsets[kMaxCodeLength + 1];
+  offsets[1] = 0;
+  for (unsigned length = 1; length < kMaxCodeLength; length++) {
+    offsets[length + 1] = offsets[length] + count[length];
+  }
+  for (unsigned sym = 0; sym < 256; sym++) {
+    unsigned length = (src[sym / 2] >> (4 * (sym % 2))) & 0xf;
+    if (length) {
+      symbols[offsets[length]++] = sym;
+    }
+  }
+
+  uint64_t bitPos = 128 * 8;
+  const uint64_t numBits = uint64_t(srcSize) * 8;
+  for (uint32_t i = 0; i < dstSize; i++) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    unsigned length = 1;
+    for (;; length++) {
+      if (length > kMaxCodeLength || bitPos >= numBits) {
+        return kBadWeights;
+      }
+      code |= (src[bitPos / 8] >> (7 - bitPos % 8)) & 1;
+      bitPos++;
+      if (code - first < count[length]) {
+        dst[i] = symbols[index + code - first];
+        break;
+      }
+      index += count[length];
+      first = (first + count[length]) << 1;
+      code <<= 1;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+extern "C" {
+
+/// \returns the size of the block of compressed weights starting at \p block,
+/// header included, reading only its first 24 byte header, or -1 if it is
+/// malformed.
+__attribute__((weak)) int64_t glow_weights_block_size(const uint8_t *block) {
+  if (block[0] > 3) {
+    return -1;
+  }
+  return int64_t(kBlockHeaderSize + getU32(block + 8));
+}
+
+/// Decodes the block of compressed weights \p block into \p dst, the
+/// constantWeight region of \p dstSize bytes. \returns 0 on success.
+__attribute__((weak)) int glow_weights_decompress_block(const uint8_t *block,
+                                                        uint8_t *dst,
+                                                        uint64_t dstSize) {
+  uint8_t method = block[0];
+  uint32_t decodedSize = getU32(block + 4);
+  uint32_t encodedSize = getU32(block + 8);
+  uint64_t offset = getU64(block + 16);
+  if (offset > dstSize || dstSize - offset < decodedSize) {
+    return kBadWeights;
+  }
+  const uint8_t *src = block + kBlockHeaderSize;
+  dst += offset;
+  switch (method) {
+  case 0:
+    if (encodedSize != decodedSize) {
+      return kBadWeights;
+    }
+    for (uint32_t i = 0; i < decodedSize; i++) {
+      dst[i] = src[i];
+    }
+    return 0;
+  case 1:
+    for (uint32_t i = 0; i < decodedSize; i++) {
+      dst[i] = 0;
+    }
+    return 0;
+  case 2:
+    return decodeBitmask(src, encodedSize, dst, decodedSize);
+  case 3:
+    return decodeHuffman(src, encodedSize, dst, decodedSize);
+  default:
+    return kBadWeights;
+  }
+}
+
+/// Decodes the \p srcSize bytes of compressed weights \p src into \p dst, the
+/// constantWeight region of \p dstSize bytes. \returns 0 on success.
+__attribute__((weak)) int glow_weights_decompress(const uint8_t *src,
+                                                  uint64_t srcSize,
+                                                  uint8_t *dst,
+                                                  uint64_t dstSize) {
+  if (srcSize < kHeaderSize || getU32(src) != kMagic ||
+      getU32(src + 4) != kVersion || getU64(src + 8) > dstSize) {
+    return kBadWeights;
+  }
+  for (uint64_t pos = kHeaderSize; pos < srcSize;) {
+    if (srcSize - pos < kBlockHeaderSize) {
+      return kBadWeights;
+    }
+    int64_t blockSize = glow_weights_block_size(src + pos);
+    if (blockSize < 0 || uint64_t(blockSize) > srcSize - pos) {
+      return kBadWeights;
+    }
+    if (int err = glow_weights_decompress_block(src + pos, dst, dstSize)) {
+      return err;
+    }
+    pos += blockSize;
+  }
+  return 0;
+}
+}
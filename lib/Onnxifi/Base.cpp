@@ -150,6 +150,8 @@ onnxStatus Backend::checkGraphCompatibility(const void *onnxModel,
 }
 
 bool Event::signal(onnxStatus status) {
+  onnxEventCallback callback;
+  void *callbackData;
   {
     std::lock_guard<std::mutex> guard(mutex_);
     if (fired_) {
@@ -157,8 +159,32 @@ bool Event::signal(onnxStatus status) {
     }
     status_ = status;
     fired_ = true;
+    callback = callback_;
+    callbackData = callbackData_;
   }
   cond_.notify_all();
+  // The callback may release the event so it must be the last use of this.
+  if (callback) {
+    callback(this, status, callbackData);
+  }
+  return true;
+}
+
+bool Event::setCallback(onnxEventCallback callback, void *userData) {
+  onnxStatus status;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (callback_) {
+      return false;
+    }
+    callback_ = callback;
+    callbackData_ = userData;
+    if (!fired_) {
+      return true;
+    }
+    status = status_;
+  }
+  callback(this, status, userData);
   return true;
 }
 
@@ -318,11 +344,26 @@ onnxStatus Graph::adjustInputs(uint32_t inputsCount,
     }
     bool processed = true;
     size_t onnxBytes = inOnnxTensorSize * elementSize;
-    if (!quantizedInput && !needsUpcast) {
-      if (inPhPtr->dims().equals(inOnnxTensorDims)) {
+    // The caller's buffer can be bound as is when it holds the elements of the
+    // placeholder: no upcast is needed, and quantized inputs are int8 with a
+    // single set of quantization parameters, which are the placeholder's.
+    const bool zeroCopyType =
+        !needsUpcast &&
+        (!quantizedInput || (inOnnxTensor.quantizationParams == 1 &&
+                             inOnnxTensor.dataType == ONNXIFI_DATATYPE_INT8));
+    if (zeroCopyType) {
+      // A buffer with another shape but as many elements has the same bytes
+      // as the placeholder tensor. Missing quantized buffers are filled with
+      // their offset below.
+      if ((inOnnxBuffer && inOnnxTensorSize == inPhPtr->getType()->size()) ||
+          (!quantizedInput && inPhPtr->dims().equals(inOnnxTensorDims))) {
         externalIOBindings.emplace_back(
             std::piecewise_construct, std::forward_as_tuple(inPhPtr),
             std::forward_as_tuple(inOnnxBuffer, inPhPtr->getType()));
+      } else if (quantizedInput) {
+        // Quantized inputs are padded with zeros below, not with their
+        // offset, so they are not bound as partial tensors.
+        processed = false;
       } else if (glow::flags::EnablePartialTensors &&
                  backendPtr_->getBackend().supportsPartialTensors()) {
         // We have a partial input buffer.  Create a padded unowned tensor that
@@ -523,9 +564,23 @@ onnxStatus Graph::setIOAndRun(uint32_t inputsCount,
       return ONNXIFI_STATUS_INVALID_SHAPE;
     }
 
+    // The outputs are written directly into the provided buffer, which must
+    // then have the element width of the placeholder.
+    auto type = outPhPtr->getType();
+    const unsigned outElementSize =
+        getOnnxTensorDescriptorElementSize(outOnnxTensor.dataType);
+    if (outElementSize && outElementSize != type->getElementSize()) {
+      LOG(ERROR) << "Output data width (" << outElementSize
+                 << ") is different from glow placeholder data width ("
+                 << type->getElementSize() << "), tensor: "
+                 << outOnnxTensor.name
+                 << ", onnxifi data type: " << outOnnxTensor.dataType
+                 << ", glow data type: " << type->getElementName().data();
+      return ONNXIFI_STATUS_INVALID_DATATYPE;
+    }
+
     // Set quantized output scale/output. Do not support channelwise quantized
     // output with multiple quantization parameters for now.
-    auto type = outPhPtr->getType();
     if (outOnnxTensor.quantizationParams == 1 && type->isQuantizedType()) {
       const_cast<float *>(outOnnxTensor.scales)[0] = type->getScale();
       const_cast<int32_t *>(outOnnxTensor.biases)[0] = type->getOffset();
@@ -77,6 +77,12 @@ protected:
 
 typedef Backend *BackendPtr;
 
+/// Callback run once an event is signalled, with the event, its status and
+/// the user data it was registered with. It runs on the thread signalling the
+/// event, so it should be short and must not wait on other events.
+typedef void (*onnxEventCallback)(onnxEvent event, onnxStatus status,
+                                  void *userData);
+
 class Event {
 public:
   Event() : fired_{false} {}
@@ -95,6 +101,12 @@ public:
   /// Check if event was signalled.
   bool isSignalled() { return fired_; }
 
+  /// Run \p callback with \p userData once the event is signalled, instead
+  /// of having a thread wait for it. If the event was already signalled then
+  /// \p callback runs immediately on the calling thread. \returns false if a
+  /// callback was already set.
+  bool setCallback(onnxEventCallback callback, void *userData);
+
   const std::string &getMessage() const { return message_; }
 
   void setMessage(const std::string &message) { message_ = message; }
@@ -107,6 +119,10 @@ private:
   /// Used to hold an onnxStatus that will be passed for the signaller of the
   /// event to a waiter. Should only be accessed while holding mutex_.
   onnxStatus status_ = ONNXIFI_STATUS_SUCCESS;
+  /// Callback run when the event is signalled and its user data. Should only
+  /// be accessed while holding mutex_.
+  onnxEventCallback callback_ = nullptr;
+  void *callbackData_ = nullptr;
 };
 
 typedef Event *EventPtr;
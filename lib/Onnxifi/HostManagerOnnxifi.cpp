@@ -108,6 +108,12 @@ static llvm::cl::opt<int32_t, true> GlowSparseNNPartitioningConcatSplitSizeOpt(
                    "specified size to move into SLS partition"),
     llvm::cl::location(glow::flags::SparseNNPartitioningConcatSplitSize));
 
+static llvm::cl::opt<int64_t, true> GlowSparseNNPartitioningShardTableKBytesOpt(
+    "glow_sparsenn_partitioning_shard_table_kbytes",
+    llvm::cl::desc("Shard SLS tables larger than this many KBytes row-wise "
+                   "across SLS partitions, 0 to disable"),
+    llvm::cl::location(glow::flags::SparseNNPartitioningShardTableKBytes));
+
 std::unique_ptr<runtime::HostManager>
 HostManagerBackend::createHostManager(llvm::StringRef backendName) {
   std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
@@ -128,6 +134,7 @@ HostManagerBackend::createHostManager(llvm::StringRef backendName) {
   hostConfig.maxActiveRequests = glow::flags::MaxActiveRequests;
   hostConfig.maxQueueSize = glow::flags::MaxQueueSize;
   hostConfig.executorThreads = glow::flags::ExecutorThreads;
+  hostConfig.executorWorkStealing = glow::flags::ExecutorWorkStealing;
 
   return glow::make_unique<runtime::HostManager>(std::move(configs),
                                                  hostConfig);
@@ -262,6 +269,8 @@ onnxStatus HostManagerBackend::addNetwork(
         glow::flags::SparseNNPartitioningPairSLSWith;
     cctx.optimizationOpts.sparseNNPartitioningConcatSplitSize =
         glow::flags::SparseNNPartitioningConcatSplitSize;
+    cctx.optimizationOpts.sparseNNPartitioningShardTableKBytes =
+        glow::flags::SparseNNPartitioningShardTableKBytes;
     cctx.optimizationOpts.sparseNNPartitioningSchemeNumCards =
         glow::flags::SparseNNPartitioningSchemeNumCards;
     cctx.optimizationOpts.sparseNNPartitioningSchemeSLSTableKBytesPerCard =
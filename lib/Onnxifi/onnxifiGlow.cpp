@@ -222,7 +222,8 @@ GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxGetBackendInfo)(
     return setBackendInfoString(
         infoValue, infoValueSize,
         "onnxSetIOAndRunGraphFunction onnxWaitEventForFunction "
-        "onnxReleaseTraceEventsFunction onnxGetCurrentBatchSizeFunction");
+        "onnxReleaseTraceEventsFunction onnxGetCurrentBatchSizeFunction "
+        "onnxSetEventCallbackFunction");
   default:
     return ONNXIFI_STATUS_UNSUPPORTED_PROPERTY;
   }
@@ -334,6 +335,33 @@ GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxWaitEvent)(onnxEvent event) {
   return glowEvent->wait();
 }
 
+/// Run \p callback with \p event, its status and \p userData once \p event
+/// is signalled, so that callers need not block a thread in onnxWaitEvent for
+/// each run in flight. The callback runs on the thread signalling the event,
+/// or immediately if the event was already signalled. At most one callback
+/// can be set per event.
+EXTERNC ONNXIFI_PUBLIC ONNXIFI_CHECK_RESULT onnxStatus ONNXIFI_ABI
+GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxSetEventCallback)(
+    onnxEvent event, glow::onnxifi::onnxEventCallback callback,
+    void *userData) {
+  auto &manager = glow::onnxifi::GlowOnnxifiManager::get();
+
+  if (!callback) {
+    return ONNXIFI_STATUS_INVALID_POINTER;
+  }
+
+  auto *glowEvent = static_cast<glow::onnxifi::EventPtr>(event);
+  if (!manager.isValid(glowEvent)) {
+    return ONNXIFI_STATUS_INVALID_EVENT;
+  }
+
+  if (!glowEvent->setCallback(callback, userData)) {
+    return ONNXIFI_STATUS_INVALID_STATE;
+  }
+
+  return ONNXIFI_STATUS_SUCCESS;
+}
+
 /// Wait until an ONNXIFI \p event is signalled or until \p timeoutMs
 /// milliseconds have elapsed. If \p timeoutMs is 0 then wait fallback to
 /// waiting indefinitely for the event to be signalled.
@@ -711,6 +739,9 @@ GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxGetExtensionFunctionAddress)(
           {"onnxGetCurrentBatchSizeFunction",
            reinterpret_cast<onnxExtensionFunctionPointer>(
                GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxGetCurrentBatchSize))},
+          {"onnxSetEventCallbackFunction",
+           reinterpret_cast<onnxExtensionFunctionPointer>(
+               GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxSetEventCallback))},
           {"onnxSetOptionFunction",
            reinterpret_cast<onnxExtensionFunctionPointer>(
                GLOW_ONNXIFI_LIBRARY_FUNCTION_WRAPPER(onnxSetOption))},
@@ -282,6 +282,83 @@ bool evaluateConstantOperation(Backend &backend, CompilationContext &cctx,
   return true;
 }
 
+/// Evaluates the constant operations \p nodes using the provided \p backend
+/// and the compilation context \p cctx. All the operations are evaluated by
+/// the same temporary function, so that the backend compiles and runs once
+/// for all of them, and the subgraphs they share are evaluated once.
+/// \p constResults gets the constant results of every node, and is left empty
+/// for the nodes whose results are not in a canonical layout. \returns false
+/// if the evaluation failed, in which case no Constant is created.
+bool evaluateConstantOperations(
+    Backend &backend, CompilationContext &cctx, llvm::ArrayRef<Node *> nodes,
+    std::vector<std::vector<Constant *>> &constResults) {
+  PlaceholderBindings bindings;
+  Module &mod = *nodes.front()->getParent()->getParent();
+  const std::string funName = std::string(constEvaluationFunctionName) +
+                              std::to_string(numFolds++) + "__";
+  // Create a temporary function to perform all the constant operations.
+  Function *constEvaluationF = mod.createFunction(funName);
+  // Mapping from existing nodes to the new ones, shared by all the operations.
+  NodeMap currToNew;
+  // Save nodes for each of the results of every operation.
+  std::vector<llvm::SmallVector<SaveNode *, 2>> savedResults(nodes.size());
+  ScopeGuard cleanup([&]() {
+    auto &vars = mod.getPlaceholders();
+    for (auto &nodeSavedResults : savedResults) {
+      for (auto *SN : nodeSavedResults) {
+        mod.erasePlaceholder(
+            std::find(vars.begin(), vars.end(), SN->getPlaceholder()));
+      }
+    }
+    mod.eraseFunction(constEvaluationF);
+  });
+
+  for (size_t i = 0, e = nodes.size(); i < e; ++i) {
+    Node *C = nodes[i];
+    assert(isConstantOperation(C, backend,
+                               /* enableQuantizeConstFolding */ false) &&
+           "Expected a constant expression");
+    auto it = currToNew.find(C);
+    Node *clonedC = it != currToNew.end()
+                        ? it->second
+                        : recursiveClone(constEvaluationF, C, currToNew);
+    // Leave the operations with results in a non-canonical layout unfolded,
+    // see bailOnNonCanonicalLayout.
+    bool isCanonical = true;
+    for (size_t idx = 0, e = clonedC->getNumResults(); idx < e; ++idx) {
+      isCanonical &=
+          isCanonicalLayout(clonedC->getNthResult(idx), backend, clonedC, idx);
+    }
+    if (!isCanonical) {
+      continue;
+    }
+    for (size_t idx = 0, e = clonedC->getNumResults(); idx < e; ++idx) {
+      auto *SN = constEvaluationF->createSave(clonedC->getName(),
+                                              clonedC->getNthResult(idx));
+      savedResults[i].emplace_back(SN);
+      bindings.allocate(SN->getPlaceholder());
+    }
+  }
+  if (ERR_TO_BOOL(executeConstantFunction(
+          backend, *constEvaluationF, bindings, cctx,
+          /* enableQuantizeConstFolding */ false))) {
+    return false;
+  }
+
+  // Get the results of the constant operations compile-time computation and
+  // create new constants from them.
+  constResults.resize(nodes.size());
+  for (size_t i = 0, e = nodes.size(); i < e; ++i) {
+    for (auto *SN : savedResults[i]) {
+      Tensor *outputTensor = bindings.get(SN->getPlaceholder());
+      constResults[i].emplace_back(mod.createConstant(
+          SN->getInput().getNode()->getName().str() + ".constfold",
+          std::move(*outputTensor)));
+    }
+  }
+  return true;
+}
+
 /// Check if function \p F consists of constant operations only.
 LLVM_ATTRIBUTE_USED
 Error verifyConstantFunction(Backend &backend, Function &F,
@@ -311,19 +388,10 @@ Error verifyConstantFunction(Backend &backend, Function &F,
   return Error::success();
 }
 
-/// Perform a compile-time constant folding of the node \p N using the provided
-/// \p backend. If \p record is not a nullptr then the Constant created is added
-/// to the map, pointing to the SaveNode that generated that Constant.
-/// \returns list of constants which are the result of the
-/// constant-folding. These constants correspond to results of the node. If no
-/// constant folding was possible an empty vector will be returned. If
-/// \p foldSingleSplats then single splat subgraphs will be forced to fold.
-bool constantFoldNodeImpl(
-    Backend &backend, Node *N, std::vector<Constant *> &constResults,
-    ConstantFoldingRecordMap *record = nullptr,
-    const CompilationContext &origCctx = CompilationContext(),
-    bool foldSingleSplats = false) {
-  CompilationContext cctx;
+/// Initialize \p cctx to compile the functions evaluating constant operations
+/// of a function compiled with \p origCctx.
+void initConstantFoldingContext(CompilationContext &cctx,
+                                const CompilationContext &origCctx) {
   // Do not recursively call constant folding.
   cctx.optimizationOpts.enableConstantFolding = false;
   cctx.optimizationOpts.enableConstantDeduplication = false;
@@ -338,10 +406,36 @@ bool constantFoldNodeImpl(
   cctx.optimizationOpts.materializeSplatsUsedBySet =
       origCctx.optimizationOpts.materializeSplatsUsedBySet;
   assert(!ERR_TO_BOOL(cctx.verify()) && "cctx for const folding must be valid");
+}
+
+/// Perform a compile-time constant folding of the node \p N using the provided
+/// \p backend. If \p record is not a nullptr then the Constant created is added
+/// to the map, pointing to the SaveNode that generated that Constant.
+/// \returns list of constants which are the result of the
+/// constant-folding. These constants correspond to results of the node. If no
+/// constant folding was possible an empty vector will be returned. If
+/// \p foldSingleSplats then single splat subgraphs will be forced to fold.
+bool constantFoldNodeImpl(
+    Backend &backend, Node *N, std::vector<Constant *> &constResults,
+    ConstantFoldingRecordMap *record = nullptr,
+    const CompilationContext &origCctx = CompilationContext(),
+    bool foldSingleSplats = false) {
+  CompilationContext cctx;
+  initConstantFoldingContext(cctx, origCctx);
   return evaluateConstantOperation(backend, cctx, N, constResults, record,
                                    foldSingleSplats);
 }
 
+/// Perform a compile-time constant folding of all the \p nodes using the
+/// provided \p backend, see evaluateConstantOperations.
+bool constantFoldNodesImpl(Backend &backend, llvm::ArrayRef<Node *> nodes,
+                           std::vector<std::vector<Constant *>> &constResults,
+                           const CompilationContext &origCctx) {
+  CompilationContext cctx;
+  initConstantFoldingContext(cctx, origCctx);
+  return evaluateConstantOperations(backend, cctx, nodes, constResults);
+}
+
 } // namespace
 
 Error glow::executeConstantFunction(Backend &backend, Function &F,
@@ -381,6 +475,7 @@ static bool constantFoldFun(Function *F, const CompilationContext &cctx,
   GraphPostOrderVisitor postOrderVisitor(*F);
   auto nodes = postOrderVisitor.getPostOrder();
   // Collect all non-trivial constant operations.
+  std::vector<Node *> foldableNodes;
   for (auto *N : nodes) {
     // Skip trivial nodes/operations that do not require any constant
     // computations.
@@ -405,9 +500,27 @@ static bool constantFoldFun(Function *F, const CompilationContext &cctx,
       continue;
     }
 
+    foldableNodes.push_back(N);
+  }
+
+  // Unless recording the subgraph of every Constant, compute all the constant
+  // values at once, which saves compiling a function per node. Fall back to
+  // computing them one at a time if that fails.
+  std::vector<std::vector<Constant *>> foldedResults;
+  const bool foldedAll =
+      !record && foldableNodes.size() > 1 &&
+      constantFoldNodesImpl(*backend, foldableNodes, foldedResults, cctx);
+  for (size_t i = 0, e = foldableNodes.size(); i < e; ++i) {
+    Node *N = foldableNodes[i];
     // Compute the constant value of the node.
     std::vector<Constant *> constResults;
-    if (!constantFoldNodeImpl(*backend, N, constResults, record, cctx)) {
+    if (foldedAll) {
+      constResults = std::move(foldedResults[i]);
+      if (constResults.empty()) {
+        continue;
+      }
+    } else if (!constantFoldNodeImpl(*backend, N, constResults, record,
+                                     cctx)) {
       continue;
     }
     // Replace all results of the original operation by the computed
@@ -420,10 +533,16 @@ static bool constantFoldFun(Function *F, const CompilationContext &cctx,
       // Replace the old result by the new constant result.
       N->getNthResult(idx).replaceAllUsesOfWith(constResult);
     }
-    // Perform Dead Code Elimination.
-    runDCEPass(F, cctx);
+    // Perform Dead Code Elimination. The nodes folded at once are only
+    // removed at the end, once none of them is needed anymore.
+    if (!foldedAll) {
+      runDCEPass(F, cctx);
+    }
     changed = true;
   }
+  if (foldedAll && changed) {
+    runDCEPass(F, cctx);
+  }
   return changed;
 }
 
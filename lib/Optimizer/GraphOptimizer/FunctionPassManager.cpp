@@ -17,8 +17,12 @@
 #include "glow/Optimizer/GraphOptimizer/FunctionPassManager.h"
 #include "glow/Optimizer/GraphOptimizer/FunctionPasses.h"
 
+#include "glow/Graph/Graph.h"
+
 #include <glog/logging.h>
 
+#include <unordered_set>
+
 namespace glow {
 
 /// The purpose of ThePassManager alias is to make the code of this pass manager
@@ -40,6 +44,11 @@ void ThePassManager::dumpIR(IRContainer *C, llvm::raw_ostream &os,
   static_cast<IRContainerTy *>(C)->dumpDAG(outputFileName);
 }
 
+template <>
+size_t ThePassManager::getIRSize(IRContainer *C) const {
+  return static_cast<IRContainerTy *>(C)->getNodes().size();
+}
+
 std::unique_ptr<ThePassManager::IRPassTy>
 createFunctionPass(ThePassManager::PassIDTy passID) {
   switch (passID) {
@@ -67,12 +76,47 @@ bool ThePassManager::runPassHook(const PassConfigBase &passConfig, PassBase &P,
       !(thePassConfig->getPassID() == PassIDTy::DCE &&
         thePassConfig->getDCERequiredMode() == DCERequiredMode::BeforePass) &&
       "Cannot specify DCE requires DCE before it.");
+  auto *F = static_cast<IRContainerTy *>(C);
   // Run DCE before this pass if it requires it.
   if (thePassConfig->getDCERequiredMode() == DCERequiredMode::BeforePass) {
-    runPass(getDCEPassConfig(), static_cast<IRContainerTy *>(C), cctx);
+    runPass(getDCEPassConfig(), F, cctx);
+  }
+  auto &FP = *static_cast<IRPassTy *>(&P);
+  if (!cctx.optimizationOpts.enableIncrementalGraphOptimization ||
+      !FP.isIncremental()) {
+    return FP.run(F, cctx);
+  }
+
+  // Run the whole pass the first time, and then only on the nodes that
+  // changed since its previous run, or whose inputs did.
+  const uint64_t stamp = F->getChangeStamp();
+  auto lastRunIt = lastRunStamps_.find(thePassConfig->getID());
+  if (lastRunIt == lastRunStamps_.end()) {
+    lastRunStamps_[thePassConfig->getID()] = stamp;
+    return FP.run(F, cctx);
+  }
+  const uint64_t lastRunStamp = lastRunIt->second;
+  lastRunIt->second = stamp;
+  std::unordered_set<const Node *> changedNodes;
+  for (auto &N : F->getNodes()) {
+    if (N.getChangeStamp() <= lastRunStamp) {
+      continue;
+    }
+    changedNodes.insert(&N);
+    for (auto &use : N.getUsers()) {
+      changedNodes.insert(use.getUser());
+    }
+  }
+  std::vector<Node *> nodes;
+  for (auto &N : F->getNodes()) {
+    if (changedNodes.count(&N) && FP.isInterestedIn(N)) {
+      nodes.push_back(&N);
+    }
+  }
+  if (nodes.empty()) {
+    return false;
   }
-  return static_cast<IRPassTy *>(&P)->run(static_cast<IRContainerTy *>(C),
-                                          cctx);
+  return FP.runOnNodes(F, nodes, cctx);
 }
 
 bool runDCEPass(ThePassManager::IRContainerTy *F,
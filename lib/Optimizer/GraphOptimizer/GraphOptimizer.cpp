@@ -22,6 +22,7 @@
 #include "glow/Converter/FusedRowwiseConverter.h"
 #include "glow/Converter/TypeAToTypeBFunctionConverter.h"
 #include "glow/Flags/Flags.h"
+#include "glow/Graph/Grad.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Log.h"
 #include "glow/Graph/Node.h"
@@ -38,6 +39,7 @@
 #include "glow/Quantization/Quantization.h"
 #include "glow/Runtime/RuntimeTypes.h"
 
+#include "llvm/ADT/iterator.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 
@@ -649,11 +651,11 @@ static TransposeNode *getTransposeNodeWithAllSameUserKind(Node *N) {
   return TN;
 }
 
-/// Code Sinking.
-bool SinkCode::run(Function *F, const CompilationContext &cctx) {
-  LOG_SCOPE(F->getLogContext(), getName());
+/// Code Sinking on the \p nodes of \p F.
+template <typename NodeRange>
+static bool sinkCode(Function *F, NodeRange &&nodes,
+                     const CompilationContext &cctx) {
   bool changed = false;
-  auto &nodes = F->getNodes();
   // For each node:
   for (auto &N : nodes) {
     auto *node = &N;
@@ -1250,6 +1252,49 @@ bool SinkCode::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
+bool SinkCode::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  return sinkCode(F, F->getNodes(), cctx);
+}
+
+bool SinkCode::isInterestedIn(const Node &N) const {
+  if (N.isArithmetic()) {
+    return true;
+  }
+  switch (N.getKind()) {
+  case Kinded::Kind::BatchNormalizationNodeKind:
+  case Kinded::Kind::ReluNodeKind:
+  case Kinded::Kind::ClipNodeKind:
+  case Kinded::Kind::LeakyReluNodeKind:
+  case Kinded::Kind::PReluNodeKind:
+  case Kinded::Kind::SigmoidNodeKind:
+  case Kinded::Kind::TileNodeKind:
+  case Kinded::Kind::PadNodeKind:
+  case Kinded::Kind::TanhNodeKind:
+  case Kinded::Kind::TransposeNodeKind:
+  case Kinded::Kind::ChannelShuffleNodeKind:
+  case Kinded::Kind::QuantizeNodeKind:
+  case Kinded::Kind::ConvertToNodeKind:
+  case Kinded::Kind::DequantizeNodeKind:
+  case Kinded::Kind::RescaleQuantizedNodeKind:
+  case Kinded::Kind::ConcatNodeKind:
+  case Kinded::Kind::SliceNodeKind:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool SinkCode::runOnNodes(Function *F, llvm::ArrayRef<Node *> nodes,
+                          const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  using NodeIterator = llvm::pointee_iterator<Node *const *>;
+  return sinkCode(F,
+                  llvm::make_range(NodeIterator(nodes.begin()),
+                                   NodeIterator(nodes.end())),
+                  cctx);
+}
+
 static bool
 gatherNodesForTanhHoisting(Function *F, NodeValue V,
                            std::unordered_set<SliceNode *> &slices) {
@@ -3534,23 +3579,10 @@ bool FoldSlicesIntoConstants::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
-/// Simplify and canonicalize arithmetic nodes by detecting simple arithmetic
-/// identities.
-bool OptimizeArithmeticNodes::run(Function *F, const CompilationContext &cctx) {
-  LOG_SCOPE(F->getLogContext(), getName());
+/// Simplify and canonicalize the arithmetic nodes of \p F in \p worklist,
+/// processed from the back, and the ones they simplify into.
+static bool optimizeArithmeticNodes(Function *F, std::vector<Node *> worklist) {
   bool changed = false;
-  // A worklist that contains the nodes to process.
-  std::vector<Node *> worklist;
-
-  // Add all of the arithmetic nodes to the worklist, with a node's
-  // dependencies added after itself so they are processed before the node.
-  GraphPreOrderVisitor visitor(*F);
-  worklist.reserve(visitor.getPreOrder().size());
-  for (auto *N : visitor.getPreOrder()) {
-    if (N->isArithmetic()) {
-      worklist.push_back(N);
-    }
-  }
   while (!worklist.empty()) {
     Node *N = worklist.back();
     assert(N->isArithmetic() && "Must be an Arithmetic node.");
@@ -3583,6 +3615,39 @@ bool OptimizeArithmeticNodes::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
+/// Simplify and canonicalize arithmetic nodes by detecting simple arithmetic
+/// identities.
+bool OptimizeArithmeticNodes::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  // A worklist that contains the nodes to process.
+  std::vector<Node *> worklist;
+
+  // Add all of the arithmetic nodes to the worklist, with a node's
+  // dependencies added after itself so they are processed before the node.
+  GraphPreOrderVisitor visitor(*F);
+  worklist.reserve(visitor.getPreOrder().size());
+  for (auto *N : visitor.getPreOrder()) {
+    if (N->isArithmetic()) {
+      worklist.push_back(N);
+    }
+  }
+  return optimizeArithmeticNodes(F, std::move(worklist));
+}
+
+bool OptimizeArithmeticNodes::isInterestedIn(const Node &N) const {
+  return N.isArithmetic();
+}
+
+bool OptimizeArithmeticNodes::runOnNodes(Function *F,
+                                         llvm::ArrayRef<Node *> nodes,
+                                         const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  // Process the nodes in the order of the Function, which is usually the
+  // order they were created in.
+  return optimizeArithmeticNodes(F, std::vector<Node *>(nodes.rbegin(),
+                                                        nodes.rend()));
+}
+
 /// Statically transpose Constants.
 bool TransposeConstants::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
@@ -3664,17 +3729,21 @@ struct CSEVisitor : NodeWalker {
   /// This callback is called after visiting the children of \p N.
   /// It means that all of its dependencies are processed already.
   void post(Node *parent, Node *N) override {
-    // Try to find a node equivalent to the current one.
-    auto FoundI = cseNodes_.find(N);
-    if (FoundI == cseNodes_.end()) {
-      // No node CSE-equivalent to the current one has been seen yet.
-      // Remember this node, so that the next occurrence can be
-      // replaced by this one.
-      cseNodes_.insert({N, N});
-      assert(cseNodes_.find(N) != cseNodes_.end());
+    // Activations recomputed for the backward pass must stay separate from
+    // the forward nodes they copy.
+    if (isRecomputedNode(*N)) {
+      return;
+    }
+
+    // Try to find a node equivalent to the current one. If no node
+    // CSE-equivalent to the current one has been seen yet, this remembers the
+    // node so that the next occurrence can be replaced by this one. The node
+    // is hashed once for both.
+    auto inserted = cseNodes_.emplace(N, N);
+    if (inserted.second) {
       return;
     }
-    Node *foundN = FoundI->second;
+    Node *foundN = inserted.first->second;
 
     // Same node cannot be visited.
     assert(N != foundN);
@@ -3706,24 +3775,12 @@ struct CSEVisitor : NodeWalker {
 
 /// A helper type for hashing Constant pointers when they are used as keys in
 /// hash maps for deduplication. The hash is based on the type of the Constant
-/// (element type, dimensions), as well as a constant number of elements from
-/// the backing Tensor to balance collisions with hash calclulation time.
+/// and all of its payload, see Constant::getPayloadHash(): it is computed once
+/// per Constant across the runs of the pass, and distinct payloads rarely
+/// collide so the full equality check in ConstsEqDedup is mostly done on
+/// duplicates.
 struct ConstsHasherDedup {
-  size_t operator()(Constant *V) const {
-    auto hash = llvm::hash_value(V->getType());
-    auto &T = V->getPayload();
-    // Only use the first 8 elements in the hash. It's likely that if two
-    // tensors have different content they will diverge quickly. Fall back to
-    // full equality check in ConstsEqDedup.
-    constexpr dim_t maxNumEls = 8;
-    dim_t numEls = std::min((dim_t)T.getType().size(), maxNumEls);
-    dim_t bufSize = T.getType().getElementSize() * numEls;
-    auto *data = T.getUnsafePtr();
-    for (size_t i = 0; i < bufSize; i++) {
-      hash = llvm::hash_combine(hash, data[i]);
-    }
-    return hash;
-  }
+  size_t operator()(Constant *V) const { return V->getPayloadHash(); }
 };
 
 /// A helper type implementing the Constants equality predicate that can be
@@ -3760,17 +3817,14 @@ static bool deduplicateConstants(Module *M) {
       continue;
     }
 
-    // Try to find a Constant that has the same data as the current one.
-    auto foundI = duplicateConstants.find(C);
-    if (foundI == duplicateConstants.end()) {
-      // No node equivalent to the current one has been seen yet. Remember
-      // this Constant, so that the next occurrence can be replaced by this
-      // one.
-      duplicateConstants.emplace(C, C);
-      assert(duplicateConstants.find(C) != duplicateConstants.end());
+    // Try to find a Constant that has the same data as the current one. If no
+    // node equivalent to the current one has been seen yet, this remembers the
+    // Constant so that the next occurrence can be replaced by this one.
+    auto inserted = duplicateConstants.emplace(C, C);
+    if (inserted.second) {
       continue;
     }
-    Constant *foundC = foundI->second;
+    Constant *foundC = inserted.first->second;
     assert(C != foundC && "Constants should not be visited multiple times.");
 
     // Replace current Constant by a found Constant, which is equivalent to
@@ -3951,9 +4005,275 @@ bool OptimizeTransposeIntoReshape::run(Function *F,
   return changed;
 }
 
-/// Eliminate nodes which don't do anything useful.
-bool EliminateNoop::run(Function *F, const CompilationContext &cctx) {
+/// \returns the shuffle of a Transpose with \p first followed by a Transpose
+/// with \p second.
+static llvm::SmallVector<unsigned_t, max_tensor_dimensions>
+composeShuffles(llvm::ArrayRef<unsigned_t> first,
+                llvm::ArrayRef<unsigned_t> second) {
+  llvm::SmallVector<unsigned_t, max_tensor_dimensions> shuffle;
+  for (unsigned_t idx : second) {
+    shuffle.push_back(first[idx]);
+  }
+  return shuffle;
+}
+
+/// \returns whether every element of the result of \p N only depends on the
+/// elements at the same position of its inputs, all of the shape of the
+/// result, so that \p N computes the same in any order of the dimensions.
+static bool isLayoutAgnostic(const Node &N) {
+  if (!N.isDataParallel() || N.hasSideEffects() || isa<Storage>(&N) ||
+      isa<CumSumNode>(&N) || N.getNumResults() != 1) {
+    return false;
+  }
+  auto dims = N.getNthResult(0).dims();
+  if (dims.size() < 2) {
+    return false;
+  }
+  for (unsigned idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+    if (N.getNthInput(idx).dims() != dims) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Try to change the order of the dimensions of the connected layout agnostic
+/// nodes \p region of \p F, \p inRegion holding the same nodes, to the one
+/// which moves the fewest bytes in the Transposes around the region, see
+/// MinimizeTransposes. \returns whether the region was changed.
+static bool
+minimizeRegionTransposes(Function *F, llvm::ArrayRef<Node *> region,
+                         const std::unordered_set<Node *> &inRegion) {
+  // The values used by the region which come from outside of it, and the uses
+  // of the results of the region outside of it.
+  std::vector<NodeValue> inputs;
+  std::vector<NodeUse> outUses;
+  for (Node *N : region) {
+    for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+      NodeValue in = N->getNthInput(idx);
+      if (!inRegion.count(in.getNode()) &&
+          std::find(inputs.begin(), inputs.end(), in) == inputs.end()) {
+        inputs.push_back(in);
+      }
+    }
+    for (auto &use : N->getUsers()) {
+      if (!inRegion.count(use.getUser())) {
+        outUses.push_back(use);
+      }
+    }
+  }
+
+  // \returns the Transpose producing \p in, if it transposes a value from
+  // outside of the region.
+  auto getInputTranspose = [&](NodeValue in) -> TransposeNode * {
+    auto *TN = dyn_cast<TransposeNode>(in);
+    return TN && !inRegion.count(TN->getInput().getNode()) ? TN : nullptr;
+  };
+  auto onlyUsedByRegion = [&](Node *N) {
+    return std::all_of(N->getUsers().begin(), N->getUsers().end(),
+                       [&](NodeUse &use) {
+                         return inRegion.count(use.getUser()) != 0;
+                       });
+  };
+
+  // \returns the bytes moved by the Transposes around the region when its
+  // tensors are transposed with \p shuffle from their current order. Splats
+  // and Constants are transposed for free, the Transposes of the inputs are
+  // composed with the new order and those of the outputs with its inverse,
+  // disappearing when they cancel out. The other inputs are transposed, like
+  // the results used by other nodes than Transposes.
+  auto getCost = [&](llvm::ArrayRef<unsigned_t> shuffle) {
+    bool identity = isIdentityShuffle(shuffle);
+    auto inverse = invertShuffle(shuffle);
+    uint64_t cost = 0;
+    for (NodeValue in : inputs) {
+      if (isa<Constant>(in) || isa<SplatNode>(in)) {
+        continue;
+      }
+      auto *TN = getInputTranspose(in);
+      if (identity) {
+        // Transposes also used outside of the region stay anyway.
+        if (TN && onlyUsedByRegion(TN)) {
+          cost += in.getType()->getSizeInBytes();
+        }
+        continue;
+      }
+      if (!TN ||
+          !isIdentityShuffle(composeShuffles(TN->getShuffle(), shuffle))) {
+        cost += in.getType()->getSizeInBytes();
+      }
+    }
+    std::unordered_set<Node *> transposedBack;
+    for (NodeUse &use : outUses) {
+      Node *N = use.get()->getNode();
+      if (auto *TN = dyn_cast<TransposeNode>(use.getUser())) {
+        if (identity ||
+            !isIdentityShuffle(composeShuffles(inverse, TN->getShuffle()))) {
+          cost += TN->getResult().getType()->getSizeInBytes();
+        }
+        continue;
+      }
+      if (!identity && transposedBack.insert(N).second) {
+        cost += N->getType(0)->getSizeInBytes();
+      }
+    }
+    return cost;
+  };
+
+  // The candidate orders are the ones cancelling a Transpose of an input or
+  // of an output.
+  std::vector<llvm::SmallVector<unsigned_t, max_tensor_dimensions>> candidates;
+  for (NodeValue in : inputs) {
+    if (auto *TN = getInputTranspose(in)) {
+      candidates.push_back(invertShuffle(TN->getShuffle()));
+    }
+  }
+  for (NodeUse &use : outUses) {
+    if (auto *TN = dyn_cast<TransposeNode>(use.getUser())) {
+      candidates.emplace_back(TN->getShuffle().begin(),
+                              TN->getShuffle().end());
+    }
+  }
+  auto dims = region.front()->getNthResult(0).dims();
+  llvm::SmallVector<unsigned_t, max_tensor_dimensions> best(dims.size());
+  std::iota(best.begin(), best.end(), 0);
+  uint64_t bestCost = getCost(best);
+  for (auto &shuffle : candidates) {
+    uint64_t cost = getCost(shuffle);
+    if (cost < bestCost) {
+      bestCost = cost;
+      best = shuffle;
+    }
+  }
+  if (isIdentityShuffle(best)) {
+    return false;
+  }
+
+  auto *M = F->getParent();
+  auto inverse = invertShuffle(best);
+  ShapeVector newDims;
+  for (unsigned_t idx : best) {
+    newDims.push_back(dims[idx]);
+  }
+  for (Node *N : region) {
+    N->setTypeUnsafe(0, M->uniqueTypeWithNewShape(N->getType(0), newDims));
+  }
+
+  // Transpose the inputs of the region.
+  std::vector<NodeValue> newInputs;
+  for (NodeValue in : inputs) {
+    NodeValue newIn;
+    auto newTy = M->uniqueTypeWithNewShape(in.getType(), newDims);
+    if (auto *C = dyn_cast<Constant>(in)) {
+      auto *NC = M->createConstant(newTy, C->getName().str() + ".transposed");
+      C->getPayload().transpose(&NC->getPayloadMutable(), best);
+      newIn = NC->getOutput();
+    } else if (auto *SN = dyn_cast<SplatNode>(in)) {
+      newIn = F->createSplat(SN->getName(), newTy, SN->getValue());
+    } else if (auto *TN = getInputTranspose(in)) {
+      auto shuffle = composeShuffles(TN->getShuffle(), best);
+      newIn = isIdentityShuffle(shuffle)
+                  ? TN->getInput()
+                  : F->createTranspose(TN->getName(), TN->getInput(), shuffle)
+                        ->getResult();
+    } else {
+      newIn = F->createTranspose(in.getNode()->getName().str() + ".transposed",
+                                 in, best)
+                  ->getResult();
+    }
+    newInputs.push_back(newIn);
+  }
+  for (Node *N : region) {
+    for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+      NodeValue in = N->getNthInput(idx);
+      if (!inRegion.count(in.getNode())) {
+        auto it = std::find(inputs.begin(), inputs.end(), in);
+        N->setNthInput(idx, newInputs[it - inputs.begin()]);
+      }
+    }
+  }
+
+  // Transpose the results back for their users outside of the region, and
+  // compose the Transposes using them with the inverse of the new order.
+  std::unordered_map<Node *, TransposeNode *> transposedBack;
+  for (NodeUse &use : outUses) {
+    Node *N = use.get()->getNode();
+    if (auto *TN = dyn_cast<TransposeNode>(use.getUser())) {
+      auto shuffle = composeShuffles(inverse, TN->getShuffle());
+      if (isIdentityShuffle(shuffle)) {
+        TN->getResult().replaceAllUsesOfWith(N->getNthResult(0));
+      } else {
+        TN->getResult().replaceAllUsesOfWith(F->createTranspose(
+            TN->getName(), N->getNthResult(0), shuffle, TN->getLayout()));
+      }
+      continue;
+    }
+    TransposeNode *&back = transposedBack[N];
+    if (!back) {
+      back = F->createTranspose(N->getName().str() + ".transposed",
+                                N->getNthResult(0), inverse);
+    }
+    use.get()->setOperand(back, TransposeNode::ResultIdx);
+  }
+  return true;
+}
+
+/// Choose the order of the dimensions of the layout agnostic nodes, e.g. the
+/// element-wise arithmetic and activations, minimizing the bytes moved by the
+/// Transposes of the graph. Unlike SinkCode, which moves Transposes one node
+/// at a time when all the inputs of the node are Transposes with the same
+/// shuffle, every connected region of layout agnostic nodes is considered as
+/// a whole: it can run in the order cancelling one of the Transposes around
+/// it, at the cost of transposing its other inputs and outputs. The order of
+/// the layout sensitive nodes, e.g. the convolutions and pools, is kept, so
+/// the Transposes the backends insert around their nodes to satisfy their
+/// layout requirements are minimized as well when the pass runs after the
+/// backend transforms.
+bool MinimizeTransposes::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
+
+  // Group the layout agnostic nodes into regions of connected nodes, which
+  // all have the same shape.
+  std::unordered_set<Node *> visited;
+  std::vector<std::vector<Node *>> regions;
+  for (auto &node : F->getNodes()) {
+    if (visited.count(&node) || !isLayoutAgnostic(node)) {
+      continue;
+    }
+    regions.emplace_back();
+    auto &region = regions.back();
+    std::vector<Node *> worklist{&node};
+    visited.insert(&node);
+    while (!worklist.empty()) {
+      Node *N = worklist.back();
+      worklist.pop_back();
+      region.push_back(N);
+      auto visit = [&](Node *next) {
+        if (!visited.count(next) && isLayoutAgnostic(*next)) {
+          visited.insert(next);
+          worklist.push_back(next);
+        }
+      };
+      for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+        visit(N->getNthInput(idx).getNode());
+      }
+      for (auto &use : N->getUsers()) {
+        visit(use.getUser());
+      }
+    }
+  }
+
+  bool changed = false;
+  for (auto &region : regions) {
+    std::unordered_set<Node *> inRegion(region.begin(), region.end());
+    changed |= minimizeRegionTransposes(F, region, inRegion);
+  }
+  return changed;
+}
+
+/// Eliminate the \p nodes of \p F which don't do anything useful.
+template <typename NodeRange>
+static bool eliminateNoop(Function *F, NodeRange &&nodes) {
   bool changed = false;
 
   auto isNoop = [](const Node &node, NodeValue &input,
@@ -3998,7 +4318,7 @@ bool EliminateNoop::run(Function *F, const CompilationContext &cctx) {
     return false;
   };
 
-  for (auto &node : F->getNodes()) {
+  for (auto &node : nodes) {
     NodeValue input, output;
     if (isNoop(node, input, output)) {
       assert(input != NodeValue() && output != NodeValue() &&
@@ -4011,6 +4331,35 @@ bool EliminateNoop::run(Function *F, const CompilationContext &cctx) {
   return changed;
 }
 
+/// Eliminate nodes which don't do anything useful.
+bool EliminateNoop::run(Function *F, const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  return eliminateNoop(F, F->getNodes());
+}
+
+bool EliminateNoop::isInterestedIn(const Node &N) const {
+  switch (N.getKind()) {
+  case Kinded::Kind::PadNodeKind:
+  case Kinded::Kind::SliceNodeKind:
+  case Kinded::Kind::TileNodeKind:
+  case Kinded::Kind::BroadcastNodeKind:
+  case Kinded::Kind::AvgPoolNodeKind:
+  case Kinded::Kind::MaxPoolNodeKind:
+  case Kinded::Kind::SelectNodeKind:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool EliminateNoop::runOnNodes(Function *F, llvm::ArrayRef<Node *> nodes,
+                               const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+  using NodeIterator = llvm::pointee_iterator<Node *const *>;
+  return eliminateNoop(F, llvm::make_range(NodeIterator(nodes.begin()),
+                                           NodeIterator(nodes.end())));
+}
+
 /// Optimize reshape nodes.
 bool OptimizeReshape::run(Function *F, const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
@@ -5712,7 +6061,10 @@ bool RaiseClipsAboveShapeNodes::run(Function *F,
 /// be opt-in and done alongside conversion of corresponding Tensors in
 /// PlaceholderBindings. If
 /// cctx.optimizationOpts.foldStaticPlaceholderConversions is set this will
-/// only change Placeholders marked as static.
+/// only change Placeholders marked as static. The weight transforms of static
+/// Placeholders (Transpose, RescaleQuantized) are folded as well, along with
+/// the conversions, and applied by the Provisioner when the weights are
+/// loaded instead of at every run.
 bool FoldElemKindConversionIntoInputs::run(Function *F,
                                            const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
@@ -5720,42 +6072,61 @@ bool FoldElemKindConversionIntoInputs::run(Function *F,
   bool changed = false;
   auto &nodes = F->getNodes();
 
-  for (auto it = nodes.begin(), e = nodes.end(); it != e; it++) {
-    Node *N = &*it;
-    // Handle conversion of inputs (conversion of Placeholders):
-    ConvertToNode *CTN = llvm::dyn_cast<ConvertToNode>(N);
-    QuantizeNode *QN = llvm::dyn_cast<QuantizeNode>(N);
-    if (CTN || QN) {
-      NodeValue in = CTN ? CTN->getInput() : QN->getInput();
-      Placeholder *P = llvm::dyn_cast<Placeholder>(in);
+  // Folding a node makes the Placeholder the input of the next node of a
+  // chain, which may come before it in the node list.
+  bool folded = true;
+  while (folded) {
+    folded = false;
+    for (auto it = nodes.begin(), e = nodes.end(); it != e;) {
+      Node *N = &*it++;
+      // Handle conversion of inputs (conversion of Placeholders):
+      ConvertToNode *CTN = llvm::dyn_cast<ConvertToNode>(N);
+      QuantizeNode *QN = llvm::dyn_cast<QuantizeNode>(N);
+      TransposeNode *TN = llvm::dyn_cast<TransposeNode>(N);
+      RescaleQuantizedNode *RQN = llvm::dyn_cast<RescaleQuantizedNode>(N);
+      if (!CTN && !QN && !TN && !RQN) {
+        continue;
+      }
+      Placeholder *P = llvm::dyn_cast<Placeholder>(N->getNthInput(0));
       if (!P || P->getUsers().size() != 1) {
         continue;
       }
       // If foldElemKindConversionIntoIO is not set and this is not a static
-      // placeholder then skip.
-      if (!cctx.optimizationOpts.foldElemKindConversionIntoIO &&
-          !P->isStatic()) {
+      // placeholder then skip. Only the Tensors of static placeholders are
+      // transformed when they are loaded.
+      if (!P->isStatic() &&
+          (TN || RQN || !cctx.optimizationOpts.foldElemKindConversionIntoIO)) {
         continue;
       }
 
-      // We have a conversion of a single-use placeholder to some other type, so
-      // it is safe to do the requested conversion.
-      NodeValue res = CTN ? CTN->getResult() : QN->getResult();
+      // We have a conversion of a single-use placeholder to some other type,
+      // so it is safe to do the requested conversion.
+      NodeValue res = N->getNthResult(0);
 
       // Convert the type of the Placeholder to the conversion type. If target
-      // type is fused call setTypeUnsafe because the shape can change in this
-      // case.
-      if (isFusedQuantizedElemKind(res.getElementType())) {
+      // type is fused or the node is a Transpose call setTypeUnsafe because
+      // the shape can change in this case.
+      if (TN) {
+        // The Transpose is composed with the shuffle of the loaded Tensor.
+        llvm::ArrayRef<unsigned_t> loadShuffle = P->getLoadShuffle();
+        std::vector<unsigned_t> shuffle;
+        for (unsigned_t idx : TN->getShuffle()) {
+          shuffle.push_back(loadShuffle.empty() ? idx : loadShuffle[idx]);
+        }
+        P->setLoadShuffle(shuffle);
+        P->setTypeUnsafe(Storage::OutputIdx, res.getType());
+      } else if (isFusedQuantizedElemKind(res.getElementType())) {
         P->setTypeUnsafe(Storage::OutputIdx, res.getType());
       } else {
         P->setType(Storage::OutputIdx, res.getType());
       }
 
-      // Replace all uses of the original ConvertTo to the Placeholder.
+      // Replace all uses of the original conversion to the Placeholder.
       res.replaceAllUsesOfWith(P);
+      F->eraseNode(N);
 
       changed = true;
-      continue;
+      folded = true;
     }
   }
   return changed;
@@ -6184,6 +6555,154 @@ bool FoldExpSumDivIntoSoftmax::run(Function *F,
   return changed;
 }
 
+/// \returns the Node producing \p NV, looking through Reshapes, or nullptr if
+/// any of the Nodes on the way has more than one user.
+static Node *getSingleUseProducer(NodeValue NV) {
+  Node *N = NV.getNode();
+  while (N->getNumUsers() == 1) {
+    auto *RN = dyn_cast<ReshapeNode>(N);
+    if (!RN) {
+      return N;
+    }
+    N = RN->getInput().getNode();
+  }
+  return nullptr;
+}
+
+/// \returns whether \p NV is a float Splat or uniform Constant, setting
+/// \p val to its value.
+static bool getUniformFloatValue(NodeValue NV, float &val) {
+  if (auto *SN = dyn_cast<SplatNode>(NV)) {
+    val = SN->getValue();
+    return true;
+  }
+  auto *C = dyn_cast<Constant>(NV);
+  return C && isUniformConstant<float>(*C, val);
+}
+
+/// Fold the attention pattern into a ScaledDotProductAttention, so that
+/// backends which don't lower it never materialize the scores. The Mul (or
+/// Div) by a splat and the Add of a mask are optional, and Reshapes may
+/// appear between any of the Nodes, e.g. around a SoftMax which only takes
+/// 2D inputs.
+///    Q   K^T
+///     \  /
+///   BatchMatMul                 Q   K   V
+///       |                        \  |  /
+///   Mul (scale)     -->   ScaledDotProductAttention
+///       |                           |
+///   Add (mask)                     OUT
+///       |
+///    SoftMax   V
+///        \    /
+///     BatchMatMul
+///          |
+///         OUT
+bool FoldScaledDotProductAttention::run(Function *F,
+                                        const CompilationContext &cctx) {
+  LOG_SCOPE(F->getLogContext(), getName());
+
+  bool changed = false;
+  for (auto &N : F->getNodes()) {
+    auto *outBMM = dyn_cast<BatchMatMulNode>(&N);
+    if (!outBMM || outBMM->getResult().getType()->isQuantizedType()) {
+      continue;
+    }
+    const auto probsDims = outBMM->getLHS().dims();
+    const dim_t numBatches = probsDims[0];
+    const dim_t Lq = probsDims[1];
+    const dim_t Lk = probsDims[2];
+
+    auto *SM = llvm::dyn_cast_or_null<SoftMaxNode>(
+        getSingleUseProducer(outBMM->getLHS()));
+    if (!SM || SM->getInput().dims().size() != 2 ||
+        SM->getInput().dims()[1] != Lk) {
+      continue;
+    }
+
+    Node *scores = getSingleUseProducer(SM->getInput());
+    NodeValue mask;
+    if (auto *AN = llvm::dyn_cast_or_null<AddNode>(scores)) {
+      Node *LHS = getSingleUseProducer(AN->getLHS());
+      if (LHS && (isa<BatchMatMulNode>(LHS) || isa<MulNode>(LHS) ||
+                  isa<DivNode>(LHS))) {
+        scores = LHS;
+        mask = AN->getRHS();
+      } else {
+        scores = getSingleUseProducer(AN->getRHS());
+        mask = AN->getLHS();
+      }
+    }
+
+    float scale = 1.0f;
+    float val;
+    if (auto *MN = llvm::dyn_cast_or_null<MulNode>(scores)) {
+      if (getUniformFloatValue(MN->getRHS(), val)) {
+        scores = getSingleUseProducer(MN->getLHS());
+      } else if (getUniformFloatValue(MN->getLHS(), val)) {
+        scores = getSingleUseProducer(MN->getRHS());
+      } else {
+        continue;
+      }
+      scale = val;
+    } else if (auto *DN = llvm::dyn_cast_or_null<DivNode>(scores)) {
+      if (!getUniformFloatValue(DN->getRHS(), val)) {
+        continue;
+      }
+      scores = getSingleUseProducer(DN->getLHS());
+      scale = 1.0f / val;
+    }
+
+    auto *scoresBMM = llvm::dyn_cast_or_null<BatchMatMulNode>(scores);
+    if (!scoresBMM || scoresBMM->getResult().dims() != probsDims) {
+      continue;
+    }
+
+    const TypeRef outTy = outBMM->getResult().getType();
+    NodeValue query = scoresBMM->getLHS();
+    NodeValue keyT = scoresBMM->getRHS();
+    if (query.getElementType() != outTy->getElementType() ||
+        (mask.getNode() &&
+         mask.getElementType() != outTy->getElementType())) {
+      continue;
+    }
+
+    NodeValue key;
+    auto *TN = dyn_cast<TransposeNode>(keyT);
+    if (TN && TN->getShuffle().equals({0, 2, 1})) {
+      key = TN->getInput();
+    } else {
+      key = F->createTranspose(keyT.getNode()->getName().str() + ".key", keyT,
+                               {0, 2, 1});
+    }
+
+    // The mask is laid out as the scores, as only Reshapes and element-wise
+    // Nodes are between both. Masks broadcast from 3D can stay unexpanded.
+    if (!mask.getNode()) {
+      mask = F->createSplat(outBMM->getName().str() + ".mask",
+                            F->getParent()->uniqueTypeWithNewShape(
+                                outTy, {1, 1, 1}),
+                            0.0f);
+    } else {
+      auto *BN = dyn_cast<BroadcastNode>(mask);
+      if (BN && BN->getInput().dims().size() == 3 &&
+          mask.dims() == probsDims) {
+        mask = BN->getInput();
+      } else if (mask.dims() != probsDims) {
+        mask = F->createReshape(outBMM->getName().str() + ".mask", mask,
+                                {numBatches, Lq, Lk});
+      }
+    }
+
+    auto *SDPA = F->createScaledDotProductAttention(
+        outBMM->getName().str() + ".attention", query, key,
+        outBMM->getRHS(), mask, scale);
+    outBMM->getResult().replaceAllUsesOfWith(SDPA);
+    changed = true;
+  }
+  return changed;
+}
+
 /// Local utility to remove identity Relu if fused into \p node.
 /// \returns true or false whether the Relu was removed or not.
 template <class NodeTy> static bool removeFusedIdentityRelu(Node *node) {
@@ -6543,31 +7062,22 @@ bool ReplaceZeroScaleFP16QuantNodes::run(Function *F,
   return changed;
 }
 
-bool ReplaceQuantizedHardSwishWithLookupTable::run(
-    Function *F, const CompilationContext &cctx) {
+bool ReplaceQuantizedUnaryWithLookupTable::run(Function *F,
+                                               const CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), getName());
 
   bool changed = false;
   for (auto &N : F->getNodes()) {
-    auto *HSN = dyn_cast<HardSwishNode>(&N);
-    CONTINUE_IF_NOT(HSN);
-
-    // Verify that input/output quantized.
-    NodeValue input = HSN->getInput();
-    NodeValue output = HSN->getResult();
+    // Lookup tables map between inputs and results of the same quantized
+    // type, of 256 entries for Int8QTy.
+    CONTINUE_IF_NOT(N.getNumInputs() == 1 && N.getNumResults() == 1);
+    ElemKind elemKind = N.getNthInput(0).getElementType();
+    CONTINUE_IF_NOT(elemKind == ElemKind::Int8QTy ||
+                    elemKind == ElemKind::Int16QTy);
+    CONTINUE_IF_NOT(N.getNthResult(0).getElementType() == elemKind);
 
-    CONTINUE_IF_NOT(input.getType()->isQuantizedType())
-    CONTINUE_IF_NOT(output.getType()->isQuantizedType())
-
-    // Replace HardSwish with LUT.
-    auto hard_swish_lambda = [](float a) {
-      int x = a + 3;
-      return a * (x > 6 ? 6 : ((x < 0) ? 0 : x)) / 6;
-    };
-    auto lookupTable = F->createIntLookupTable(
-        HSN->getName(), input, hard_swish_lambda, output.getType());
-    HSN->getResult().replaceAllUsesOfWith(lookupTable);
-    changed = true;
+    changed |=
+        quantization::replaceQuantizedUnaryWithLookupTable(*F, N) != nullptr;
   }
 
   return changed;
@@ -6601,6 +7111,130 @@ static void transformIndexTypeDemotion(const Backend &B, Function *F,
   }
 }
 
+/// Replace the FullyConnected nodes of \p F of float input and Constant float
+/// weights with Int4GroupwiseQuantizedFullyConnected nodes, where \p B
+/// supports them, quantizing the weights in groups of
+/// \p precConfig.int4FCGroupSize.
+static void convertFullyConnectedWeightsToInt4(
+    const Backend &B, Function *F, const PrecisionConfiguration &precConfig) {
+  const unsigned groupSize = precConfig.int4FCGroupSize;
+  for (auto &node : F->getNodes()) {
+    auto *FC = llvm::dyn_cast<FullyConnectedNode>(&node);
+    if (!FC) {
+      continue;
+    }
+    auto *W = llvm::dyn_cast<Constant>(FC->getWeights().getNode());
+    if (!W || W->getElementType() != ElemKind::FloatTy ||
+        FC->getInput().getElementType() != ElemKind::FloatTy ||
+        FC->getBias().getElementType() != ElemKind::FloatTy ||
+        FC->getResult().getElementType() != ElemKind::FloatTy) {
+      continue;
+    }
+    const dim_t K = W->dims()[0];
+    const dim_t N = W->dims()[1];
+    const dim_t numGroups = (K + groupSize - 1) / groupSize;
+    auto *types = F->getParent();
+    if (!B.isOpSupported(NodeInfo(
+            Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind,
+            {FC->getInput().getType(),
+             types->uniqueType(ElemKind::UInt8ITy, {N, (K + 1) / 2}),
+             types->uniqueType(ElemKind::Float16Ty, {N, numGroups}),
+             types->uniqueType(ElemKind::Float16Ty, {N, numGroups}),
+             FC->getBias().getType()},
+            {FC->getResult().getType()}))) {
+      continue;
+    }
+    auto *IFC = F->createInt4GroupwiseQuantizedFullyConnected(
+        FC->getName(), FC->getInput(), W, FC->getBias(), groupSize);
+    FC->getResult().replaceAllUsesOfWith(IFC->getResult());
+  }
+}
+
+/// Replace the SparseLengthsWeightedSum nodes of \p F of Constant float tables
+/// with ProductQuantizedSparseLengthsWeightedSum nodes, where \p B supports
+/// them, encoding \p precConfig.pqSLWSSubspaceDim columns per code. Tables
+/// of at most 256 rows are skipped, as their codebooks would be as large as
+/// the tables themselves.
+static void
+convertSLWSTablesToProductQuantized(const Backend &B, Function *F,
+                                   const PrecisionConfiguration &precConfig) {
+  constexpr dim_t numCentroids = 256;
+  const dim_t subDim = precConfig.pqSLWSSubspaceDim;
+  for (auto &node : F->getNodes()) {
+    auto *SLWS = llvm::dyn_cast<SparseLengthsWeightedSumNode>(&node);
+    if (!SLWS || SLWS->getLengthsMode() != LengthsMode::Variable) {
+      continue;
+    }
+    auto *data = llvm::dyn_cast<Constant>(SLWS->getData().getNode());
+    if (!data || data->getElementType() != ElemKind::FloatTy ||
+        data->dims().size() != 2 || data->dims()[0] <= numCentroids ||
+        data->dims()[1] % subDim != 0 ||
+        SLWS->getWeights().getElementType() != ElemKind::FloatTy ||
+        SLWS->getResult().getElementType() != ElemKind::FloatTy) {
+      continue;
+    }
+    const dim_t numSubspaces = data->dims()[1] / subDim;
+    auto *types = F->getParent();
+    if (!B.isOpSupported(NodeInfo(
+            Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind,
+            {types->uniqueType(ElemKind::UInt8ITy,
+                               {data->dims()[0], numSubspaces}),
+             types->uniqueType(ElemKind::FloatTy,
+                               {numSubspaces, numCentroids, subDim}),
+             SLWS->getWeights().getType(), SLWS->getIndices().getType(),
+             SLWS->getLengths().getType()},
+            {SLWS->getResult().getType()}))) {
+      continue;
+    }
+    auto *PQ = F->createProductQuantizedSparseLengthsWeightedSum(
+        SLWS->getName(), data->getPayloadMutable(), numSubspaces,
+        SLWS->getWeights(), SLWS->getIndices(), SLWS->getLengths(),
+        numCentroids);
+    SLWS->getResult().replaceAllUsesOfWith(PQ->getResult());
+  }
+}
+
+/// Replace the FullyConnected nodes of \p F of float input and Constant float
+/// weights with DynamicQuantizedFullyConnected nodes, where \p B supports
+/// them. The weights are quantized symmetrically to int8 with the range of
+/// their values.
+static void convertFullyConnectedToDynamicQuantized(const Backend &B,
+                                                    Function *F) {
+  for (auto &node : F->getNodes()) {
+    auto *FC = llvm::dyn_cast<FullyConnectedNode>(&node);
+    if (!FC) {
+      continue;
+    }
+    auto *W = llvm::dyn_cast<Constant>(FC->getWeights().getNode());
+    if (!W || W->getElementType() != ElemKind::FloatTy ||
+        FC->getInput().getElementType() != ElemKind::FloatTy ||
+        FC->getBias().getElementType() != ElemKind::FloatTy ||
+        FC->getResult().getElementType() != ElemKind::FloatTy) {
+      continue;
+    }
+    auto WH = W->getPayload().getHandle<float>();
+    auto minMax = WH.minMax();
+    auto qParams = quantization::chooseQuantizationParams(
+        {minMax.first, minMax.second},
+        quantization::Schema::Symmetric, ElemKind::Int8QTy);
+    auto qTy = F->getParent()->uniqueType(ElemKind::Int8QTy, W->dims(),
+                                          qParams.scale, qParams.offset);
+    if (!B.isOpSupported(NodeInfo(
+            Kinded::Kind::DynamicQuantizedFullyConnectedNodeKind,
+            {FC->getInput().getType(), qTy, FC->getBias().getType()},
+            {FC->getResult().getType()}))) {
+      continue;
+    }
+    Tensor qT = quantization::quantizeTensor(
+        W->getPayload(), {qParams.scale, qParams.offset}, ElemKind::Int8QTy);
+    auto *qW = F->getParent()->createConstant(W->getName().str() + ".int8",
+                                              std::move(qT));
+    auto *DQFC = F->createDynamicQuantizedFullyConnected(
+        FC->getName(), FC->getInput(), qW, FC->getBias());
+    FC->getResult().replaceAllUsesOfWith(DQFC->getResult());
+  }
+}
+
 void glow::transformForPrecisionMode(const Backend &B, Function *F,
                                      CompilationContext &cctx) {
   LOG_SCOPE(F->getLogContext(), "transformForPrecisionMode")
@@ -6630,14 +7264,41 @@ void glow::transformForPrecisionMode(const Backend &B, Function *F,
   }
   }
 
-  if (precConfig.convertToFP16) {
+  if (precConfig.convertToFP16 ||
+      precConfig.quantConfig.hasNodePrecision(
+          quantization::NodePrecision::FP16)) {
     LOG_SCOPE(F->getLogContext(), "glow::convertFunctionToFloat16")
-    convertFunctionToFloat16(F, precConfig);
+    ElemKind float16Kind =
+        PrecisionConfiguration::getElementType(precConfig.float16Format);
+    convertFunctionToFloat16(
+        F, precConfig,
+        B.convertsOnlySupportedNodesToFloat16(float16Kind) ? &B : nullptr);
     FunctionPassManager FPM("FP16GraphOptzFPM",
                             createFP16GraphOptimizationPassPipeline());
     FPM.run(F, cctx);
   }
 
+  // Quantize the remaining float FullyConnected weights to int8 and their
+  // activations at run time.
+  if (precConfig.convertFCToDynamicQuantized) {
+    LOG_SCOPE(F->getLogContext(),
+              "glow::convertFullyConnectedToDynamicQuantized");
+    convertFullyConnectedToDynamicQuantized(B, F);
+  }
+
+  // Quantize the remaining float FullyConnected weights to 4 bits.
+  if (precConfig.convertFCWeightsToInt4) {
+    LOG_SCOPE(F->getLogContext(), "glow::convertFullyConnectedWeightsToInt4");
+    convertFullyConnectedWeightsToInt4(B, F, precConfig);
+  }
+
+  // Product-quantize the float SparseLengthsWeightedSum tables.
+  if (precConfig.convertSLWSTablesToPQ) {
+    LOG_SCOPE(F->getLogContext(),
+              "glow::convertSLWSTablesToProductQuantized");
+    convertSLWSTablesToProductQuantized(B, F, precConfig);
+  }
+
   // By default, FP16 SLS accumulation is not enabled.
   // If requested, Force all ops in the SLS family to use FP16 accumulation.
   if (precConfig.forceFP16AccumSLS) {
@@ -7800,6 +8461,146 @@ Expected<std::unordered_map<Node *, ConcatNode *>> glow::parallelizeOps(
   return replacedMap;
 }
 
+/// \returns the time estimated by \p costModel for \p ops operations split in
+/// \p numChunks chunks, \p bytesMoved bytes being sliced and concatenated.
+static double getParallelTime(const ParallelCostModel &costModel, double ops,
+                              size_t numChunks, double bytesMoved) {
+  if (numChunks <= 1) {
+    return ops * costModel.timePerOp;
+  }
+  size_t rounds = (numChunks + costModel.numCores - 1) / costModel.numCores;
+  return rounds * (ops / numChunks * costModel.timePerOp +
+                   costModel.timePerChunk) +
+         bytesMoved * costModel.timePerByte;
+}
+
+void glow::planParallelization(
+    Function *F, const ParallelCostModel &costModel,
+    llvm::DenseMap<Node *, size_t> &numOfChunksMap,
+    llvm::DenseMap<Node *, ParallelTransformKind> &parOpts) {
+  if (costModel.numCores <= 1) {
+    return;
+  }
+
+  auto getBytes = [](NodeValue NV) {
+    return double(NV.getType()->getSizeInBytes());
+  };
+  // Slices of constants are folded at compile time.
+  auto getSlicedBytes = [&](NodeValue NV) {
+    return isa<Constant>(NV.getNode()) ? 0. : getBytes(NV);
+  };
+  // \returns whether \p NV is produced by a node split with \p kind in
+  // \p numChunks chunks.
+  auto isSplitAs = [&](NodeValue NV, ParallelTransformKind kind,
+                       size_t numChunks) {
+    auto kindIt = parOpts.find(NV.getNode());
+    auto chunksIt = numOfChunksMap.find(NV.getNode());
+    return kindIt != parOpts.end() && kindIt->second == kind &&
+           chunksIt != numOfChunksMap.end() && chunksIt->second == numChunks;
+  };
+
+  /// A possible split of a node: its kind, the size of the split dimension of
+  /// the result, the input split along with it and the other bytes moved.
+  struct Candidate {
+    ParallelTransformKind kind;
+    dim_t dimSize;
+    NodeValue splitInput;
+    double bytesMoved;
+  };
+
+  // Process the inputs of a node before it, so that it can mirror them.
+  GraphPostOrderVisitor visitor(*F);
+  for (auto *N : visitor.getPostOrder()) {
+    if (N->getParent() != F) {
+      continue;
+    }
+
+    if (isa<ReluNode>(N) || isa<ClipNode>(N) || isa<QuantizeNode>(N) ||
+        isa<DequantizeNode>(N) || isa<RescaleQuantizedNode>(N)) {
+      NodeValue input = N->getNthInput(0);
+      auto kindIt = parOpts.find(input.getNode());
+      if (kindIt == parOpts.end()) {
+        continue;
+      }
+      size_t numChunks = numOfChunksMap[input.getNode()];
+      size_t axis = kindIt->second == ParallelTransformKind::Data ? 0 : 1;
+      auto dims = N->getNthResult(0).dims();
+      if ((kindIt->second == ParallelTransformKind::Data ||
+           kindIt->second == ParallelTransformKind::Model) &&
+          dims.size() > axis && dims[axis] >= numChunks) {
+        parOpts[N] = kindIt->second;
+        numOfChunksMap[N] = numChunks;
+      }
+      continue;
+    }
+
+    double ops = 0;
+    llvm::SmallVector<Candidate, 2> candidates;
+    if (auto *FC = dyn_cast<FullyConnectedNode>(N)) {
+      auto outDims = FC->getResult().dims();
+      ops = double(outDims[0]) * FC->getInput().dims()[1] * outDims[1];
+      double outBytes = getBytes(FC->getResult());
+      candidates.push_back({ParallelTransformKind::Data, outDims[0],
+                            FC->getInput(), outBytes});
+      candidates.push_back({ParallelTransformKind::Model, outDims[1],
+                            NodeValue(),
+                            getSlicedBytes(FC->getWeights()) +
+                                getSlicedBytes(FC->getBias()) + outBytes});
+    } else if (auto *MM = dyn_cast<MatMulNode>(N)) {
+      auto outDims = MM->getResult().dims();
+      ops = double(outDims[0]) * MM->getLHS().dims()[1] * outDims[1];
+      double outBytes = getBytes(MM->getResult());
+      candidates.push_back({ParallelTransformKind::Data, outDims[0],
+                            MM->getLHS(), outBytes});
+      candidates.push_back({ParallelTransformKind::Model, outDims[1],
+                            NodeValue(),
+                            getSlicedBytes(MM->getRHS()) + outBytes});
+    } else if (auto *BMM = dyn_cast<BatchMatMulNode>(N)) {
+      auto outDims = BMM->getResult().dims();
+      ops = double(outDims[0]) * outDims[1] * BMM->getLHS().dims()[2] *
+            outDims[2];
+      candidates.push_back({ParallelTransformKind::Data, outDims[0],
+                            BMM->getLHS(),
+                            getSlicedBytes(BMM->getRHS()) +
+                                getBytes(BMM->getResult())});
+    } else if (auto *CN = dyn_cast<ConvolutionNode>(N)) {
+      auto filterDims = CN->getFilter().dims();
+      ops = double(CN->getResult().getType()->size()) *
+            (CN->getFilter().getType()->size() / filterDims[0]);
+      candidates.push_back({ParallelTransformKind::Data,
+                            CN->getResult().dims()[0], CN->getInput(),
+                            getBytes(CN->getResult())});
+    } else {
+      continue;
+    }
+
+    double bestTime = getParallelTime(costModel, ops, 1, 0);
+    ParallelTransformKind bestKind = ParallelTransformKind::None;
+    size_t bestChunks = 1;
+    for (const auto &candidate : candidates) {
+      size_t maxChunks = std::min<size_t>(costModel.numCores,
+                                          candidate.dimSize);
+      for (size_t numChunks = 2; numChunks <= maxChunks; numChunks++) {
+        double bytesMoved = candidate.bytesMoved;
+        if (candidate.splitInput.getNode() &&
+            !isSplitAs(candidate.splitInput, candidate.kind, numChunks)) {
+          bytesMoved += getSlicedBytes(candidate.splitInput);
+        }
+        double time = getParallelTime(costModel, ops, numChunks, bytesMoved);
+        if (time < bestTime) {
+          bestTime = time;
+          bestKind = candidate.kind;
+          bestChunks = numChunks;
+        }
+      }
+    }
+    if (bestKind != ParallelTransformKind::None) {
+      parOpts[N] = bestKind;
+      numOfChunksMap[N] = bestChunks;
+    }
+  }
+}
+
 void glow::updateQuantReluTypes(Function *F) {
   // A worklist that contains the nodes to process.
   std::vector<Node *> worklist;
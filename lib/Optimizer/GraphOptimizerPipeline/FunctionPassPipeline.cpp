@@ -68,6 +68,10 @@ createDefaultGraphOptimizationPassPipeline() {
       // is usually at most 2 or 3 iterations.
       {FunctionPassID::SinkCode, ConvergenceMode::UntilFixedPoint},
 
+      // Change the order of the dimensions of the regions of element-wise
+      // nodes when it cancels more Transposes around them than it adds.
+      {FunctionPassID::MinimizeTransposes},
+
       // ConvTranspose + BiasAdd
       {FunctionPassID::ConvTransposeBiasAddFold},
 
@@ -269,6 +273,9 @@ std::unique_ptr<FunctionPassPipeline> createDefaultFoldPassPipeline() {
       // Fold exp + reduce sum + div into softmax
       {FunctionPassID::FoldExpSumDivIntoSoftmax},
 
+      // Fold BatchMatMul + SoftMax + BatchMatMul into attention
+      {FunctionPassID::FoldScaledDotProductAttention},
+
       // Fold Arithmetic chain w/ constants into Batch Norm, when Conv preceeds.
       {FunctionPassID::FoldArithmeticChainUnderConvIntoBN,
        ConvergenceMode::OnePass,
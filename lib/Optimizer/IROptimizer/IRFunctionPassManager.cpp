@@ -40,6 +40,11 @@ void ThePassManager::dumpIR(IRContainer *C, llvm::raw_ostream &os,
   static_cast<IRContainerTy *>(C)->dump(os);
 }
 
+template <>
+size_t ThePassManager::getIRSize(IRContainer *C) const {
+  return static_cast<IRContainerTy *>(C)->getInstrs().size();
+}
+
 std::unique_ptr<ThePassManager::IRPassTy>
 createFunctionPass(ThePassManager::PassIDTy passID) {
   switch (passID) {
@@ -1142,8 +1142,16 @@ static bool tryToShareBuffersForInstr(
       if (!src) {
         src = srcOp.first;
       }
-      // Operands must be different, but of the same type.
-      if (destOp.first->getType() != srcOp.first->getType()) {
+      // Operands must be different, but of the same type. Quantized operands
+      // may only differ by their scale and offset, e.g. for an element-wise
+      // operation changing the quantization parameters of its input, as the
+      // operand sharing the buffer is then accessed through a view of its own
+      // type.
+      if (!destOp.first->getType()->isEqual(*srcOp.first->getType(),
+                                            /* allowDifferentShape */ false,
+                                            /* allowDifferentStrides */ false,
+                                            /* allowDifferentScaleOffset */
+                                            true)) {
         continue;
       }
 
@@ -1318,10 +1326,180 @@ static bool eliminateDeadStores(IRFunction &M) {
   return changed;
 }
 
+/// \returns the range [begin, end) of the elements of the origin of the operand
+/// \p opIdx of \p I which \p I may access. An InsertTensor only writes the
+/// slice of its destination at its offsets, and an ExtractTensor only reads the
+/// slice of its source at its offsets.
+static std::pair<size_t, size_t> getAccessedElements(Instruction *I,
+                                                     unsigned opIdx) {
+  Value *op = I->getOperand(opIdx).first;
+  const size_t begin = getOriginOffset(op);
+  llvm::ArrayRef<dim_t> offsets;
+  llvm::SmallVector<dim_t, max_tensor_dimensions> sliceDims;
+  if (auto *ITI = dyn_cast<InsertTensorInst>(I)) {
+    if (opIdx == 0) {
+      offsets = ITI->getOffsets();
+      sliceDims.append(ITI->getSrc()->dims().begin(),
+                       ITI->getSrc()->dims().end());
+      sliceDims[ITI->getAxis()] *= ITI->getCount();
+    }
+  } else if (auto *ETI = dyn_cast<ExtractTensorInst>(I)) {
+    if (opIdx == 1) {
+      offsets = ETI->getOffsets();
+      sliceDims.append(ETI->getDest()->dims().begin(),
+                       ETI->getDest()->dims().end());
+    }
+  }
+  if (offsets.empty()) {
+    return {begin, begin + op->getType()->size()};
+  }
+  // The slice lies between its first and its last element.
+  auto strides = op->getType()->strides();
+  const size_t first = getFlattenedOffset(strides, offsets);
+  size_t last = first;
+  for (size_t i = 0, e = sliceDims.size(); i < e; i++) {
+    last += (sliceDims[i] - 1) * strides[i];
+  }
+  return {begin + first, begin + last + 1};
+}
+
+/// Make all the instructions accessing \p src, the source of \p ITI, access
+/// the contiguous slice of the destination of \p ITI it is inserted into
+/// instead, so that \p ITI can be erased. Unlike the rewrite done by
+/// optimizeInserts for a single writer, no instruction is moved, so \p src may
+/// be written by several instructions and read by others than \p ITI, e.g.
+/// when the input of a Concat has other users. This is only possible if the
+/// slice is neither written nor read before \p ITI by other instructions
+/// while \p src is live, and if \p src is not written after \p ITI.
+/// \returns whether \p ITI can be erased.
+static bool aliasInsertSource(IRFunction &M, IRBuilder &B,
+                              InsertTensorInst *ITI, AllocActivationInst *src) {
+  Value *dest = getOrigin(ITI->getDest());
+  const size_t sliceBegin =
+      getOriginOffset(ITI->getDest()) +
+      getFlattenedOffset(ITI->getDest()->getType()->strides(),
+                         ITI->getOffsets());
+  const size_t sliceEnd = sliceBegin + src->getType()->size();
+  auto *destAlloc = dyn_cast<AllocActivationInst>(dest);
+  Instruction *destDealloc = nullptr;
+  if (destAlloc) {
+    for (const auto &U : ValueUses(destAlloc)) {
+      if (auto *DAI = dyn_cast<DeallocActivationInst>(U.get())) {
+        destDealloc = DAI;
+      }
+    }
+  }
+
+  // Positions of the instructions accessing src or the slice, the first
+  // instruction of the function being at position 1.
+  size_t pos = 0;
+  size_t srcPos = 0;
+  size_t destAllocPos = 0;
+  size_t destDeallocPos = 0;
+  size_t insertPos = 0;
+  size_t firstSrcAccessPos = 0;
+  size_t lastSrcAccessPos = 0;
+  Instruction *lastSrcAccess = nullptr;
+  // Position of the instructions accessing the slice, and whether they write
+  // it.
+  std::vector<std::pair<size_t, bool>> sliceAccesses;
+  for (auto &I : M.getInstrs()) {
+    pos++;
+    if (&I == src) {
+      srcPos = pos;
+    }
+    if (&I == destAlloc) {
+      destAllocPos = pos;
+    }
+    if (&I == destDealloc) {
+      destDeallocPos = pos;
+    }
+    if (&I == ITI) {
+      insertPos = pos;
+      continue;
+    }
+    if (isa<AllocActivationInst>(&I) || isa<DeallocActivationInst>(&I) ||
+        isa<TensorViewInst>(&I)) {
+      continue;
+    }
+    bool accessesSrc = false;
+    bool writesSrc = false;
+    bool accessesSlice = false;
+    bool writesSlice = false;
+    for (unsigned i = 0, e = I.getNumOperands(); i < e; i++) {
+      auto op = I.getOperand(i);
+      Value *origin = getOrigin(op.first);
+      if (origin == src) {
+        accessesSrc = true;
+        writesSrc |= op.second != OperandKind::In;
+      } else if (origin == dest) {
+        auto range = getAccessedElements(&I, i);
+        if (range.first < sliceEnd && sliceBegin < range.second) {
+          accessesSlice = true;
+          writesSlice |= op.second != OperandKind::In;
+        }
+      }
+    }
+    if (accessesSrc) {
+      // Bail if src is written after the insert, or if an instruction
+      // accesses both src and the slice.
+      if ((insertPos && writesSrc) || accessesSlice) {
+        return false;
+      }
+      if (!firstSrcAccessPos) {
+        firstSrcAccessPos = pos;
+      }
+      lastSrcAccessPos = pos;
+      lastSrcAccess = &I;
+    }
+    if (accessesSlice) {
+      sliceAccesses.emplace_back(pos, writesSlice);
+    }
+  }
+  if (!firstSrcAccessPos || firstSrcAccessPos > insertPos) {
+    return false;
+  }
+
+  // From the first access of src until it is not live anymore, the slice
+  // holds the value of src and may only be read after the insert.
+  const size_t endPos = std::max(lastSrcAccessPos, insertPos);
+  for (const auto &access : sliceAccesses) {
+    if (access.first >= firstSrcAccessPos && access.first <= endPos &&
+        (access.second || access.first < insertPos)) {
+      return false;
+    }
+  }
+
+  // The destination has to be allocated while src is live.
+  if (destAlloc && destAllocPos > srcPos) {
+    M.moveInstruction(src, destAlloc);
+  }
+  if (destDealloc && destDeallocPos < lastSrcAccessPos) {
+    M.moveInstruction(&*std::next(lastSrcAccess->getIterator()), destDealloc);
+  }
+
+  // The offsets of the slice in the origin of the destination.
+  std::vector<dim_t> offsets;
+  size_t remainder = sliceBegin;
+  for (dim_t stride : dest->getType()->strides()) {
+    offsets.push_back(remainder / stride);
+    remainder %= stride;
+  }
+  auto *TVI = B.createTensorViewInst((ITI->getName() + ".tv.dest").str(), dest,
+                                     src->getType(), offsets);
+  M.moveInstruction(&*std::next(src->getIterator()), TVI);
+  replaceAllNonDeallocUsersWith(src, TVI);
+  return true;
+}
+
 /// Replace InsertTensors that are only offset in the first dimension with
 /// writing directly into the destination using TensorViews with the same
 /// offsets. This is possible because this means the underlying memory is
-/// contiguous in this case.
+/// contiguous in this case. When the source of an InsertTensor is written by
+/// its only writer right before, the writer is moved to the InsertTensor and
+/// writes into the destination instead. Otherwise all the accesses of the
+/// source are made to the destination if no other instruction accesses that
+/// part of the destination meanwhile, see aliasInsertSource.
 bool optimizeInserts(IRFunction &M) {
   bool changed = false;
   auto &instrs = M.getInstrs();
@@ -1362,6 +1540,10 @@ bool optimizeInserts(IRFunction &M) {
     // user as we already know insertSourceAAI is one user, and so there must be
     // a dealloc.
     if (insertSourceAAI->getNumUsers() != 3) {
+      if (aliasInsertSource(M, B, ITI, insertSourceAAI)) {
+        erasedInstructions.insert(ITI);
+        changed = true;
+      }
       continue;
     }
 
@@ -1583,10 +1765,11 @@ bool performPeepholeOptimizations(IRFunction &M) {
 
 namespace glow {
 
-std::unique_ptr<IRFunction> generateAndOptimizeIR(IRContainer *F,
-                                                  const Backend &B,
-                                                  bool shouldShareBuffers) {
+std::unique_ptr<IRFunction>
+generateAndOptimizeIR(IRContainer *F, const Backend &B, bool shouldShareBuffers,
+                      bool minimizePeakMemory) {
   auto IR = glow::make_unique<IRFunction>(F);
+  IR->setMinimizePeakMemory(minimizePeakMemory);
   IR->generateIR(B);
 
   ::glow::optimize(*IR, B, shouldShareBuffers);
@@ -546,13 +546,43 @@ static void lowerSGDNode(Function *F, CompilationContext &cctx,
   NodeValue W = SGD.getWeight();
   NodeValue G = SGD.getGradient();
 
+  assert(W.dims() == G.dims() && "Invalid weight/gradient sizes for SGDNode");
+
+  // The momentum sum of the previous updates lives across runs. The velocity
+  // is not read without momentum, so any value of the right type will do.
+  float momentum = SGD.getMomentum();
+  Placeholder *Gsum = nullptr;
+  NodeValue velocity = G;
+  if (momentum > 0.0) {
+    Gsum = F->getParent()->createPlaceholder(
+        W.getType(), DECORATE_NODE_NAME(SGD, "gsum"), false);
+    Gsum->setAllocZero();
+    velocity = Gsum;
+  }
+
+  auto *FSGD = F->addNode(new FusedSGDNode(
+      DECORATE_NODE_NAME(SGD, "fused"), G, W, velocity, SGD.getL1Decay(),
+      SGD.getL2Decay(), SGD.getLearningRate(), momentum, SGD.getBatchSize()));
+  if (Gsum) {
+    F->createSave(DECORATE_NODE_NAME(SGD, "save", "gsum"),
+                  FSGD->getUpdatedVelocity(), Gsum);
+  }
+  replaceAllUsesOfWith(cctx.loweredInfoMap, SGD.getUpdatedWeight(),
+                       FSGD->getUpdatedWeight());
+}
+
+static void lowerFusedSGDNode(Function *F, CompilationContext &cctx,
+                              const FusedSGDNode &SGD) {
+  LOG_SCOPE(F->getLogContext(), "lowerFusedSGDNode")
+
+  NodeValue W = SGD.getWeight();
+  NodeValue G = SGD.getGradient();
+
   /// Described in the paper: Alex Krizhevsky [2014]
   // "One weird trick for parallelizing convolutional neural networks"
 
   float momentum = SGD.getMomentum();
 
-  assert(W.dims() == G.dims() && "Invalid weight/gradient sizes for SGDNode");
-
   float L1Decay = SGD.getL1Decay();
   float L2Decay = SGD.getL2Decay();
   float learningRate = SGD.getLearningRate();
@@ -602,18 +632,18 @@ static void lowerSGDNode(Function *F, CompilationContext &cctx,
   // http://ufldl.stanford.edu/tutorial/supervised/
   // OptimizationStochasticGradientDescent/
   if (momentum > 0.0) {
-    Placeholder *Gsum = F->getParent()->createPlaceholder(
-        W.getType(), DECORATE_NODE_NAME(SGD, "gsum"), false);
-    Gsum->setAllocZero();
-
     auto *momentumSplat = F->createSplat(
         DECORATE_NODE_NAME(SGD, "momentumSplat"), type, momentum);
     auto *GsumMult =
-        F->createMul(DECORATE_NODE_NAME(SGD, "GsumMult"), momentumSplat, Gsum);
+        F->createMul(DECORATE_NODE_NAME(SGD, "GsumMult"), momentumSplat,
+                     SGD.getVelocity());
 
     dx =
         F->createAdd(DECORATE_NODE_NAME(SGD, "dx_with_momentum"), GsumMult, dx);
-    F->createSave(DECORATE_NODE_NAME(SGD, "save", "gsum"), dx, Gsum);
+    replaceAllUsesOfWith(cctx.loweredInfoMap, SGD.getUpdatedVelocity(), dx);
+  } else {
+    replaceAllUsesOfWith(cctx.loweredInfoMap, SGD.getUpdatedVelocity(),
+                         SGD.getVelocity());
   }
 
   auto *newW = F->createAdd(DECORATE_NODE_NAME(SGD, "weight", "update"), W, dx);
@@ -1573,6 +1603,127 @@ static void lowerBatchMatMulNode(Function *F, CompilationContext &cctx,
   replaceAllUsesOfWith(cctx.loweredInfoMap, BMMN.getResult(), RN);
 }
 
+/// Implement ScaledDotProductAttention \p SDPAN in \p F via BatchMatMuls and a
+/// SoftMax over the materialized {N, Lq, Lk} scores.
+static void lowerScaledDotProductAttentionNode(
+    Function *F, CompilationContext &cctx,
+    const ScaledDotProductAttentionNode &SDPAN) {
+  LOG_SCOPE(F->getLogContext(), "lowerScaledDotProductAttentionNode")
+
+  auto name = SDPAN.getName().str();
+  NodeValue query = SDPAN.getQuery();
+  NodeValue key = SDPAN.getKey();
+  NodeValue mask = SDPAN.getMask();
+  const dim_t N = query.dims()[0];
+  const dim_t Lq = query.dims()[1];
+  const dim_t Lk = key.dims()[1];
+
+  auto *keyT = F->createTranspose(name + ".keyT", key, {0, 2, 1});
+  NodeValue scores = F->createBatchMatMul(name + ".scores", query, keyT);
+  if (SDPAN.getScale() != 1.0f) {
+    auto *scale =
+        F->createSplat(name + ".scale", scores.getType(), SDPAN.getScale());
+    scores = F->createMul(name + ".scaled", scores, scale);
+  }
+  auto *maskSplat = llvm::dyn_cast<SplatNode>(mask.getNode());
+  if (!maskSplat || maskSplat->getValue() != 0.0f) {
+    if (mask.dims() != scores.dims()) {
+      mask = F->createBroadcast(name + ".mask", mask, {N, Lq, Lk},
+                                /* axis */ 0);
+    }
+    scores = F->createAdd(name + ".masked", scores, mask);
+  }
+
+  // SoftMax is over the rows of a 2D input.
+  auto *selected = F->getParent()->createConstant(ElemKind::Int64ITy,
+                                                   {N * Lq, 1}, "selected");
+  auto *flat = F->createReshape(name + ".flat", scores, {N * Lq, Lk});
+  auto *SM = F->createSoftMax(name + ".softmax", flat, selected);
+  auto *probs = F->createReshape(name + ".probs", SM, {N, Lq, Lk});
+  auto *BMM =
+      F->createBatchMatMul(name + ".attention", probs, SDPAN.getValues());
+
+  replaceAllUsesOfWith(cctx.loweredInfoMap, SDPAN.getResult(), BMM);
+}
+
+/// Implement Int4GroupwiseQuantizedFullyConnected \p IFCN in \p F via a
+/// FullyConnected of the weights dequantized at compile time. \returns false
+/// if the weights or their scales and offsets are not Constants.
+static bool lowerInt4GroupwiseQuantizedFullyConnectedNode(
+    Function *F, CompilationContext &cctx,
+    const Int4GroupwiseQuantizedFullyConnectedNode &IFCN) {
+  auto *weights = llvm::dyn_cast<Constant>(IFCN.getWeights().getNode());
+  auto *scales = llvm::dyn_cast<Constant>(IFCN.getScales().getNode());
+  auto *offsets = llvm::dyn_cast<Constant>(IFCN.getOffsets().getNode());
+  if (!weights || !scales || !offsets) {
+    return false;
+  }
+  LOG_SCOPE(F->getLogContext(), "lowerInt4GroupwiseQuantizedFullyConnectedNode")
+
+  const dim_t N = IFCN.getResult().dims()[1];
+  const dim_t K = IFCN.getInput().dims()[1];
+  const dim_t groupSize = IFCN.getGroupSize();
+  auto *W = F->getParent()->createConstant(ElemKind::FloatTy, {K, N},
+                                           IFCN.getName().str() + ".weights");
+  auto WH = W->getPayloadMutable().getHandle<float>();
+  auto qH = weights->getPayload().getHandle<uint8_t>();
+  auto scalesH = scales->getPayload().getHandle<float16_t>();
+  auto offsetsH = offsets->getPayload().getHandle<float16_t>();
+  for (dim_t n = 0; n < N; n++) {
+    for (dim_t k = 0; k < K; k++) {
+      const uint8_t packed = qH.at({n, k / 2});
+      const uint8_t q = (k % 2) ? (packed >> 4) : (packed & 0x0f);
+      WH.at({k, n}) = float(scalesH.at({n, k / groupSize})) * q +
+                      float(offsetsH.at({n, k / groupSize}));
+    }
+  }
+
+  auto *FC =
+      F->createFullyConnected(IFCN.getName(), IFCN.getInput(), W,
+                              IFCN.getBias(), IFCN.getResult().getType());
+  replaceAllUsesOfWith(cctx.loweredInfoMap, IFCN.getResult(), FC);
+  return true;
+}
+
+/// Implement ProductQuantizedSparseLengthsWeightedSum \p PQN in \p F via a
+/// SparseLengthsWeightedSum of the table decoded at compile time. \returns
+/// false if the codes or the codebooks are not Constants.
+static bool lowerProductQuantizedSparseLengthsWeightedSumNode(
+    Function *F, CompilationContext &cctx,
+    const ProductQuantizedSparseLengthsWeightedSumNode &PQN) {
+  auto *codes = llvm::dyn_cast<Constant>(PQN.getCodes().getNode());
+  auto *codebooks = llvm::dyn_cast<Constant>(PQN.getCodebooks().getNode());
+  if (!codes || !codebooks) {
+    return false;
+  }
+  LOG_SCOPE(F->getLogContext(),
+            "lowerProductQuantizedSparseLengthsWeightedSumNode")
+
+  const dim_t numRows = codes->dims()[0];
+  const dim_t numSubspaces = codebooks->dims()[0];
+  const dim_t subDim = codebooks->dims()[2];
+  auto *data = F->getParent()->createConstant(
+      ElemKind::FloatTy, {numRows, numSubspaces * subDim},
+      PQN.getName().str() + ".data");
+  auto DH = data->getPayloadMutable().getHandle<float>();
+  auto CH = codes->getPayload().getHandle<uint8_t>();
+  auto CBH = codebooks->getPayload().getHandle<float>();
+  for (dim_t r = 0; r < numRows; r++) {
+    for (dim_t s = 0; s < numSubspaces; s++) {
+      const dim_t code = CH.at({r, s});
+      for (dim_t k = 0; k < subDim; k++) {
+        DH.at({r, s * subDim + k}) = CBH.at({s, code, k});
+      }
+    }
+  }
+
+  auto *SLWS = F->createSparseLengthsWeightedSum(
+      PQN.getName(), data, PQN.getWeights(), PQN.getIndices(),
+      PQN.getLengths());
+  replaceAllUsesOfWith(cctx.loweredInfoMap, PQN.getResult(), SLWS);
+  return true;
+}
+
 static void lowerSparseLengthsSumNode(Function *F, CompilationContext &cctx,
                                       const SparseLengthsSumNode &SLSN) {
   LOG_SCOPE(F->getLogContext(), "lowerSparseLengthsSumNode")
@@ -1925,8 +2076,52 @@ static void lowerLSTMUnitNode(Function *F, CompilationContext &cctx,
   auto newH =
       F->createMul(name("mulH"), inO, F->createTanh(name("tanh2"), newC));
 
-  replaceAllUsesOfWith(cctx.loweredInfoMap, LUN.getNthResult(0), newH);
-  replaceAllUsesOfWith(cctx.loweredInfoMap, LUN.getNthResult(1), newC);
+  replaceAllUsesOfWith(cctx.loweredInfoMap, LUN.getnewH(), newH);
+  replaceAllUsesOfWith(cctx.loweredInfoMap, LUN.getnewC(), newC);
+}
+
+static void lowerBeamSearchStepNode(Function *F, CompilationContext &cctx,
+                                    const BeamSearchStepNode &BSS) {
+  LOG_SCOPE(F->getLogContext(), "lowerBeamSearchStepNode");
+
+  NodeValue logits = BSS.getLogits();
+  const dim_t beam = logits.dims()[0];
+  const dim_t vocab = logits.dims()[1];
+
+  // The scores of all the candidates, flattened so that candidate v of beam b
+  // is at b * V + v, as ties are broken by TopK.
+  auto *selected = F->getParent()->createConstant(
+      ElemKind::Int64ITy, {beam, 1}, DECORATE_NODE_NAME(BSS, "selected"));
+  selected->getPayloadMutable().zero();
+  auto *LSM =
+      F->createLogSoftMax(DECORATE_NODE_NAME(BSS, "logsoftmax"), logits,
+                          selected);
+  auto *scores = F->createReshape(DECORATE_NODE_NAME(BSS, "scores"),
+                                  BSS.getScores(), {beam, 1});
+  auto *candidates = F->createNodeWithBroadcast<AddNode>(
+      DECORATE_NODE_NAME(BSS, "candidates"), /* axis */ -1, LSM, scores);
+  auto *flat = F->createReshape(DECORATE_NODE_NAME(BSS, "flat"), candidates,
+                                {beam * vocab});
+  auto *TK = F->createTopK(DECORATE_NODE_NAME(BSS, "topk"), flat, beam,
+                           BSS.getTokens().getElementType());
+
+  // The beam and token of each of the best candidates.
+  NodeValue indices = TK->getIndices();
+  auto *vocabSplat = F->createSplat(DECORATE_NODE_NAME(BSS, "vocab"),
+                                    indices.getType(), vocab);
+  auto *prev =
+      F->createDiv(DECORATE_NODE_NAME(BSS, "prev"), indices, vocabSplat);
+  auto *tokens = F->createSub(
+      DECORATE_NODE_NAME(BSS, "tokens"), indices,
+      F->createMul(DECORATE_NODE_NAME(BSS, "offset"), prev, vocabSplat));
+  auto *newState =
+      F->createGather(DECORATE_NODE_NAME(BSS, "state"), BSS.getState(), prev);
+
+  replaceAllUsesOfWith(cctx.loweredInfoMap, BSS.getNewScores(),
+                       TK->getValues());
+  replaceAllUsesOfWith(cctx.loweredInfoMap, BSS.getTokens(), tokens);
+  replaceAllUsesOfWith(cctx.loweredInfoMap, BSS.getPrevIndices(), prev);
+  replaceAllUsesOfWith(cctx.loweredInfoMap, BSS.getNewState(), newState);
 }
 
 static void lowerBroadcastNode(Function *F, CompilationContext &cctx,
@@ -2031,6 +2226,8 @@ bool glow::lowerNode(Function *F, Node *node, CompilationContext &cctx) {
     CASE_LOWER(TanhGrad);
     CASE_LOWER(SigmoidGrad);
     CASE_LOWER(SGD);
+    CASE_LOWER(FusedSGD);
+    CASE_LOWER(BeamSearchStep);
     CASE_LOWER(BatchNormalization);
     CASE_LOWER(LayerNormalization);
     CASE_LOWER(InstanceNormalization);
@@ -2045,6 +2242,7 @@ bool glow::lowerNode(Function *F, Node *node, CompilationContext &cctx) {
     CASE_LOWER(Tile);
     CASE_LOWER(ReplaceNaN);
     CASE_LOWER(BatchMatMul);
+    CASE_LOWER(ScaledDotProductAttention);
     CASE_LOWER(SparseLengthsSum);
     CASE_LOWER(FusedRowwiseQuantizedSparseLengthsSum);
     CASE_LOWER(BatchBoxCox);
@@ -2061,6 +2259,12 @@ bool glow::lowerNode(Function *F, Node *node, CompilationContext &cctx) {
     CASE_LOWER(Broadcast);
     CASE_LOWER(LogSoftMax);
     CASE_LOWER(HardSwish);
+  case Kinded::Kind::Int4GroupwiseQuantizedFullyConnectedNodeKind:
+    return lowerInt4GroupwiseQuantizedFullyConnectedNode(
+        F, cctx, *cast<Int4GroupwiseQuantizedFullyConnectedNode>(node));
+  case Kinded::Kind::ProductQuantizedSparseLengthsWeightedSumNodeKind:
+    return lowerProductQuantizedSparseLengthsWeightedSumNode(
+        F, cctx, *cast<ProductQuantizedSparseLengthsWeightedSumNode>(node));
   case Kinded::Kind::ConvolutionNodeKind: {
     ConvolutionNode *CN = cast<ConvolutionNode>(node);
     if (CN->getGroup() > 1) {
@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Partitioner/NodeCostProfile.h"
+#include "glow/IR/LLVMAPIMacros.h"
+
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <vector>
+
+using namespace glow;
+
+namespace {
+/// Serialized form of a single NodeCostProfile entry.
+struct NodeCostRecord {
+  std::string backend;
+  std::string node;
+  double latencyUs{0};
+  uint64_t count{0};
+};
+} // namespace
+
+LLVM_YAML_IS_SEQUENCE_VECTOR(NodeCostRecord);
+
+namespace llvm {
+namespace yaml {
+/// Mapping for NodeCostRecord yaml serializer.
+template <> struct MappingTraits<NodeCostRecord> {
+  static void mapping(IO &io, NodeCostRecord &record) {
+    io.mapRequired("Backend", record.backend);
+    io.mapRequired("Node", record.node);
+    io.mapRequired("LatencyUs", record.latencyUs);
+    io.mapRequired("Count", record.count);
+  }
+};
+} // namespace yaml
+} // namespace llvm
+
+void NodeCostProfile::record(llvm::StringRef backendName,
+                             llvm::StringRef nodeName, double latencyUs) {
+  auto &entry = entries_[backendName.str()][nodeName.str()];
+  entry.totalUs += latencyUs;
+  entry.count++;
+}
+
+void NodeCostProfile::addTraceEvents(llvm::StringRef backendName,
+                                     const std::list<TraceEvent> &events) {
+  for (const auto &event : events) {
+    if (event.type == TraceEvent::CompleteType && event.args.count("kind")) {
+      record(backendName, event.name, event.duration);
+    }
+  }
+}
+
+llvm::Optional<double>
+NodeCostProfile::getLatencyUs(llvm::StringRef backendName,
+                              llvm::StringRef nodeName) const {
+  auto backendIt = entries_.find(backendName.str());
+  if (backendIt == entries_.end()) {
+    return llvm::None;
+  }
+  auto nodeIt = backendIt->second.find(nodeName.str());
+  if (nodeIt == backendIt->second.end() || nodeIt->second.count == 0) {
+    return llvm::None;
+  }
+  return nodeIt->second.totalUs / nodeIt->second.count;
+}
+
+size_t NodeCostProfile::size() const {
+  size_t size = 0;
+  for (const auto &backend : entries_) {
+    size += backend.second.size();
+  }
+  return size;
+}
+
+Error NodeCostProfile::save(llvm::StringRef fileName) const {
+  std::vector<NodeCostRecord> records;
+  for (const auto &backend : entries_) {
+    for (const auto &node : backend.second) {
+      records.push_back({backend.first, node.first,
+                         node.second.totalUs / node.second.count,
+                         node.second.count});
+    }
+  }
+
+  std::error_code EC;
+  llvm::raw_fd_ostream outputStream(fileName, EC, GET_FS_OPENFLAGS(F_None));
+  RETURN_ERR_IF_NOT(!EC, "Error opening node cost profile '" + fileName.str() +
+                             "': " + EC.message());
+  llvm::yaml::Output yout(outputStream);
+  yout << records;
+  return Error::success();
+}
+
+Expected<NodeCostProfile> NodeCostProfile::load(llvm::StringRef fileName) {
+  auto bufOrErr = llvm::MemoryBuffer::getFileAsStream(fileName);
+  RETURN_ERR_IF_NOT(bufOrErr, "Unable to open node cost profile '" +
+                                  fileName.str() +
+                                  "': " + bufOrErr.getError().message());
+
+  std::vector<NodeCostRecord> records;
+  llvm::yaml::Input yin((*bufOrErr)->getBuffer());
+  yin >> records;
+  RETURN_ERR_IF_NOT(!yin.error(),
+                    "Error reading node cost profile '" + fileName.str() + "'");
+
+  NodeCostProfile profile;
+  for (const auto &record : records) {
+    auto &entry = profile.entries_[record.backend][record.node];
+    entry.totalUs += record.latencyUs * record.count;
+    entry.count += record.count;
+  }
+  return profile;
+}
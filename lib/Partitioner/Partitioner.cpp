@@ -310,28 +310,35 @@ Expected<DAGListTy> Partitioner::backendBasedPartition(
     }
   }
 
+  // Each node gets a stage, the largest number of backend changes on a path
+  // from the inputs of F to it, and the nodes of the same stage and backend
+  // form a partition. Independent branches of different backends, e.g. a
+  // sparse tower falling back to the CPU next to a dense one on an
+  // accelerator, are then partitions without dependencies between them,
+  // which the executor runs concurrently, instead of being interleaved
+  // level by level into a chain. An edge between two backends always goes
+  // to a later stage, so the partitions can't form a cycle.
   BFSLevel bfs = getBFSLevel(F);
-  size_t level = bfs.size();
+  llvm::DenseMap<Node *, unsigned> nodeStage;
+  std::map<std::pair<unsigned, std::string>, Function *> stageToFunction;
   int color = 0;
-  Function *newF;
-  newF = F->getParent()->createFunction(std::string(F->getName()) + "_part" +
-                                        std::to_string(++color));
-  auto backendName = nodeToBackendName[bfs[level - 1][0]];
-  if (cctx.precisionConfig.quantMode == QuantizationMode::Profile) {
-    // When profiling, all the partition backend is assigned to
-    // profilingBackend.
-    mapping.createPartition(newF, profilingBackend);
-    funcToBackend[newF] = profilingBackend;
-  } else {
-    mapping.createPartition(newF, backendName);
-    funcToBackend[newF] = backendName;
-  }
-  for (int i = level - 1; i >= 0; i--) {
-    for (size_t j = 0, e = bfs[i].size(); j < e; j++) {
-      Node *N = bfs[i][j];
-      auto bk = nodeToBackendName[N];
-      if (bk != backendName) {
-        backendName = bk;
+  for (int i = bfs.size() - 1; i >= 0; i--) {
+    for (Node *N : bfs[i]) {
+      const std::string &backendName = nodeToBackendName[N];
+      unsigned stage = 0;
+      for (size_t j = 0, e = N->getNumInputs(); j < e; j++) {
+        Node *in = N->getNthInput(j).getNode();
+        auto it = nodeStage.find(in);
+        if (it == nodeStage.end()) {
+          // Storage, which belongs to no partition.
+          continue;
+        }
+        bool changesBackend = nodeToBackendName[in] != backendName;
+        stage = std::max(stage, it->second + changesBackend);
+      }
+      nodeStage[N] = stage;
+      Function *&newF = stageToFunction[{stage, backendName}];
+      if (!newF) {
         newF = F->getParent()->createFunction(
             std::string(F->getName()) + "_part" + std::to_string(++color));
         if (cctx.precisionConfig.quantMode == QuantizationMode::Profile) {
@@ -362,8 +369,7 @@ Expected<DAGListTy> Partitioner::backendBasedPartition(
       mapping.appendLogicalDeviceID(func, logicalDeviceID++);
     }
   }
-  return doPartitioning(F->getName(), funcs, module_, mapping, genDAG,
-                        cctx.backendOpts.backendSpecificNodeInfo);
+  return doPartitioning(F->getName(), funcs, module_, mapping, genDAG);
 }
 
 void Partitioner::genBackendMap(
@@ -400,6 +406,7 @@ void Partitioner::genBackendMap(
           generateNodeKindsSet(deviceInfo_[i].nonSupportedNodes);
       backendInfo.supportedNodesKinds =
           generateNodeKindsSet(deviceInfo_[i].supportedNodes);
+      backendInfo.costProfile = costProfile_.get();
       if (hasBackends) {
         backendInfo.backend = backends_[i];
       } else {
@@ -644,9 +651,8 @@ Expected<DAGListTy> Partitioner::loadBalancedPartition(CompilationContext &cctx,
   RETURN_IF_ERR(logicalDevicesValidation(partitionMap, backendMap_));
   RETURN_IF_ERR(resourceCountValidation(partitionMap, backendMap_));
 
-  partitions =
-      doPartitioning(origName, {F_}, module_, partitionMap, /* saveDAG */ true,
-                     cctx.backendOpts.backendSpecificNodeInfo);
+  partitions = doPartitioning(origName, {F_}, module_, partitionMap,
+                              /* saveDAG */ true);
   module_->eraseFunction(F_);
 
   if (cctx.saturateHost &&
@@ -792,8 +798,7 @@ Partitioner::heterogeneousPartition(CompilationContext &cctx) {
 
   // Step 4 : do the real partitioning for the function list.
   partitions =
-      doPartitioning(origName, funcs, module_, mapping, /* saveDAG */ true,
-                     cctx.backendOpts.backendSpecificNodeInfo);
+      doPartitioning(origName, funcs, module_, mapping, /* saveDAG */ true);
 
   // Step 5 : Post-partition optimization - Adjust the logicalDevice for each
   // DAGNode.
@@ -922,8 +927,7 @@ Partitioner::partitionFromConfig(const PartitionConfig &partitionConfig,
 
   // Do partition.
   partitions = doPartitioning(F->getName(), {F}, module_, partitionMap,
-                              /* saveDAG */ true,
-                              cctx.backendOpts.backendSpecificNodeInfo);
+                              /* saveDAG */ true);
   module_->eraseFunction(F);
 
   // DAG validation.
@@ -1018,10 +1022,9 @@ Partitioner::setupPrepartitionedModule(CompilationContext &cctx) {
   }
 
   // Do partition.
-  DAGListTy partitions = doPartitioning(
-      config.funcName, funcs, module_, partitionMap,
-      /* saveDAG */ true, cctx.backendOpts.backendSpecificNodeInfo,
-      /* skipCloning */ true);
+  DAGListTy partitions =
+      doPartitioning(config.funcName, funcs, module_, partitionMap,
+                     /* saveDAG */ true, /* skipCloning */ true);
 
   // DAG validation.
   RETURN_IF_ERR(dagValidation(partitions[0]));
@@ -1236,15 +1239,19 @@ expandFrontier(Node *node, const NodeValue &value,
 }
 
 /// Helper function for SparseNN Partitioning scheme. Checks for each
-/// kind of SLS table and appends their metadata to the vector.
+/// kind of SLS table and appends their metadata to the vector. The expected
+/// lookup bandwidth of the table is taken from \p tableLookups.
 template <typename SLSType>
-static Error appendSLSTable(SLSType *SLS, std::vector<SLSTableInfo> &slsTables,
-                            bool doPerfModelBalance, Backend *backend,
-                            const std::vector<std::string> &pairSLSWith,
-                            bool concatTanhSinkApplied) {
+static Error
+appendSLSTable(SLSType *SLS, std::vector<SLSTableInfo> &slsTables,
+               bool doPerfModelBalance, Backend *backend,
+               const std::vector<std::string> &pairSLSWith,
+               bool concatTanhSinkApplied,
+               const std::map<std::string, uint64_t> &tableLookups) {
   uint64_t cost = 1;
   uint64_t numBytesInTable =
       (uint64_t)SLS->getData().getType()->getSizeInBytes();
+  uint64_t lookupBytes = getSLSTableLookupBytes(SLS, tableLookups);
 
   // If average length is available, then compute cost using perf model
   if (doPerfModelBalance) {
@@ -1309,6 +1316,7 @@ static Error appendSLSTable(SLSType *SLS, std::vector<SLSTableInfo> &slsTables,
   case Kinded::Kind::NODE_NAME_##Kind: {                                       \
     auto SLS = llvm::cast<NODE_NAME_>(cur);                                    \
     numBytesInTable += (uint64_t)SLS->getData().getType()->getSizeInBytes();   \
+    lookupBytes += getSLSTableLookupBytes(SLS, tableLookups);                  \
   }                                                                            \
     continue;
 
@@ -1333,8 +1341,8 @@ static Error appendSLSTable(SLSType *SLS, std::vector<SLSTableInfo> &slsTables,
     }
   }
 
-  slsTables.push_back(
-      {SLS, neighbors, frontier, numBytesInTable, 0, slsResult, cost});
+  slsTables.push_back({SLS, neighbors, frontier, numBytesInTable, 0, slsResult,
+                       cost, lookupBytes});
   return Error::success();
 }
 
@@ -1494,6 +1502,30 @@ Expected<DAGListTy> Partitioner::partitionSparseNN(CompilationContext &cctx) {
   // We fix this issue by iterating over the Function and finding Splat input
   // nodes with multiple users and just creating new Splats (by cloning) for
   // each user.
+  // Serve the hot rows of tables from compact tables of their own. This comes
+  // before sharding, which then splits the cold tables if they are too large.
+  if (!cctx.optimizationOpts.sparseNNPartitioningHotTableRows.empty()) {
+    unsigned numTieredTables;
+    ASSIGN_VALUE_OR_RETURN_ERR(
+        numTieredTables,
+        splitHotSLSTableRows(
+            F, cctx.optimizationOpts.sparseNNPartitioningHotTableRows));
+    LOG(INFO) << "Split hot rows off " << numTieredTables << " SLS tables";
+  }
+
+  // Shard tables too large for a single card row-wise, so that every shard
+  // is placed as a table of its own below.
+  if (cctx.optimizationOpts.sparseNNPartitioningShardTableKBytes) {
+    unsigned numShardedTables;
+    ASSIGN_VALUE_OR_RETURN_ERR(
+        numShardedTables,
+        shardLargeSLSTables(
+            F, uint64_t(cctx.optimizationOpts
+                            .sparseNNPartitioningShardTableKBytes) *
+                   1024));
+    LOG(INFO) << "Sharded " << numShardedTables << " SLS tables row-wise";
+  }
+
   for (auto &node : F->getNodes()) {
     cloneSplatInputIfNecessary(&node, F);
   }
@@ -1530,7 +1562,8 @@ Expected<DAGListTy> Partitioner::partitionSparseNN(CompilationContext &cctx) {
   case Kinded::Kind::NODE_NAME_##Kind:                                         \
     RETURN_IF_ERR(appendSLSTable<NODE_NAME_>(                                  \
         llvm::cast<NODE_NAME_>(&node), slsTables, doPerfModelBalance,          \
-        backends[0], pairSLSWith, concatTanhSinkApplied));                     \
+        backends[0], pairSLSWith, concatTanhSinkApplied,                       \
+        cctx.optimizationOpts.sparseNNPartitioningTableLookups));              \
     totalSLSTableSizes += slsTables.back().numBytesInTable;                    \
     continue;
 
@@ -1550,6 +1583,26 @@ Expected<DAGListTy> Partitioner::partitionSparseNN(CompilationContext &cctx) {
   LOG(INFO) << "Total size of all " << slsTables.size()
             << " SLS embedding tables: " << totalSLSTableSizes;
 
+  // Balance the tables on measured latencies if every one of them was
+  // profiled. Mixing them with estimates would compare unrelated units.
+  if (costProfile_ && !slsTables.empty()) {
+    const auto backendName = backends[0]->getBackendName();
+    bool allMeasured = std::all_of(
+        slsTables.begin(), slsTables.end(), [&](const SLSTableInfo &table) {
+          return costProfile_->getLatencyUs(backendName,
+                                            table.node->getName());
+        });
+    if (allMeasured) {
+      VLOG(1) << "Balancing SLS tables on measured latencies";
+      for (auto &table : slsTables) {
+        // Keep sub-microsecond resolution in the integer cost.
+        table.cost = std::max<uint64_t>(
+            1, *costProfile_->getLatencyUs(backendName, table.node->getName()) *
+                   1000);
+      }
+    }
+  }
+
   // Now determine all nodes that fit in the NonSLS partition, so we know its
   // total size and can better judge how much space is left for SLS
   // partitions.
@@ -1718,6 +1771,16 @@ Expected<DAGListTy> Partitioner::partitionSparseNN(CompilationContext &cctx) {
 }
 
 Expected<DAGListTy> Partitioner::partition(CompilationContext &cctx) {
+  if (!costProfile_ && !glow::flags::PartitionerCostProfile.empty()) {
+    NodeCostProfile profile;
+    ASSIGN_VALUE_OR_RETURN_ERR(
+        profile, NodeCostProfile::load(glow::flags::PartitionerCostProfile));
+    LOG(INFO) << "Loaded " << profile.size()
+              << " measured node latencies from "
+              << glow::flags::PartitionerCostProfile;
+    costProfile_ = std::make_shared<const NodeCostProfile>(std::move(profile));
+  }
+
   if (cctx.prepartitionedConfig &&
       cctx.prepartitionedConfig->funcs.size() != 0) {
     VLOG(1) << "Using prepartitioned config";
@@ -40,8 +40,7 @@ createDAGNodeFromFun(Function *F, NodeToFunctionMap &mapping) {
 // Current only partition the representative function.
 DAGListTy PartitionerBase::doPartitioning(
     llvm::StringRef funcName, std::vector<Function *> funcs, Module *module,
-    NodeToFunctionMap &mapping, bool saveDAG, BackendSpecificNodeInfo &nodeInfo,
-    bool skipCloning) {
+    NodeToFunctionMap &mapping, bool saveDAG, bool skipCloning) {
   DAGListTy partitions;
   // Add a dummy node to make sure that a DAG has a single entrance.
   DAGNodePtr DAGRoot = glow::make_unique<DAGNode>();
@@ -51,28 +50,17 @@ DAGListTy PartitionerBase::doPartitioning(
   DAGRoot->module = module;
   DAGNode *root = DAGRoot.get();
 
-  llvm::DenseMap<Node *, Node *> currToNew;
-
   if (!skipCloning) {
-    // Clone nodes into target partition. Update nodeInfo as necessary.
-    for (size_t i = 0, e = funcs.size(); i < e; i++) {
-      for (auto &N : funcs[i]->getNodes()) {
-        auto *clone = N.clone();
-        currToNew[&N] = clone;
-        mapping[&N]->addNode(clone);
-
-        // If needed, update NodeInfo to point old Node's info to clone.
-        auto itF = nodeInfo.find(funcs[i]);
-        if (itF == nodeInfo.end()) {
-          continue;
-        }
-        auto &currNodeInfo = itF->second;
-        auto itN = currNodeInfo.find(&N);
-        if (itN != currNodeInfo.end()) {
-          currNodeInfo[clone] = std::move(itN->second);
-          // Erase old NodeInfo; current Nodes will be eliminated later when
-          // input funcs will be erased.
-          currNodeInfo.erase(itN);
+    // Move the nodes into their target partition. The links between the nodes
+    // and any info keyed by them stay valid, and the input funcs are left
+    // empty, to be erased by the caller.
+    for (auto *F : funcs) {
+      auto &nodesList = F->getNodes();
+      for (auto it = nodesList.begin(), e = nodesList.end(); it != e;) {
+        Node *N = &*it++;
+        Function *subF = mapping[N];
+        if (subF != F) {
+          subF->takeOwnershipOfNode(N);
         }
       }
     }
@@ -159,24 +147,6 @@ DAGListTy PartitionerBase::doPartitioning(
     partitions.push_back(std::move(dag));
   }
 
-  if (!skipCloning) {
-    // Update links between nodes in the cloned functions. Add placeholders (and
-    // save nodes) where a link crosses a partition boundary.
-    for (auto *subF : mapping.getPartitions()) {
-      for (auto &N : subF->getNodes()) {
-        for (int inp = 0, e = N.getNumInputs(); inp < e; inp++) {
-          auto input = N.getNthInput(inp);
-          if (isa<Storage>(input.getNode())) {
-            continue;
-          }
-          // Link this node to the clone of its input.
-          auto *clone = currToNew[input.getNode()];
-          N.setNthInput(inp, NodeValue(clone, input.getResNo()));
-        }
-      }
-    }
-  }
-
   // For all DAGNode without parents, link them to the root DAG.
   for (auto *subF : mapping.getPartitions()) {
     if (funcDAG[subF]->parents.size() == 0) {
@@ -16,10 +16,12 @@
 #include "glow/Partitioner/PartitionerUtils.h"
 #include "glow/Backend/BackendUtils.h"
 #include "glow/Flags/Flags.h"
+#include "glow/Partitioner/NodeCostProfile.h"
 #include "glow/Partitioner/PartitionerTypes.h"
 #include "glow/Support/Support.h"
 #include <folly/String.h>
 
+#include <limits>
 #include <unordered_set>
 
 using llvm::isa;
@@ -191,22 +193,16 @@ uint64_t getNodeMemUsage(const Node *node) {
   return size;
 }
 
-float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
-  // This code assumes all ops are BW limited from SRAM; except
-  // if the input does not fit in SRAM -- then it is DRAM BW limited
-  float peakDramBw = backendInfo.peakDramBw;
-  float peakSramBw = backendInfo.peakSramBw;
-  uint64_t sramCapacity = backendInfo.sramCapacity;
-  float peakCompute = backendInfo.peakCompute;
-
+/// Accumulate in \p sizeDram and \p sizeSram the bytes \p node reads and
+/// writes from DRAM and SRAM, given an SRAM of \p sramCapacity bytes.
+static void getNodeMemoryTraffic(const Node *node, uint64_t sramCapacity,
+                                 uint64_t &sizeDram, uint64_t &sizeSram) {
   // compute memory side bytes for inputs from DRAM, SRAM.
   // TODO: think about whether this is better off computed inside a Node.
 
   int n = node->getNumInputs();
-  uint64_t sizeDram = 0;
-  uint64_t sizeSram = 0;
   if (node->getKind() == Kinded::Kind::SaveNodeKind) {
-    return 0.0f;
+    return;
   }
   // The memory bytes for embedding table lookups is data dependent,
   // so it needs to be calculated as per the number of indices accessed.
@@ -306,8 +302,17 @@ float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
       sizeSram += sizeOutput;
     }
   }
+}
+
+uint64_t getNodeBytesMoved(const Node *node) {
+  uint64_t sizeDram = 0;
+  uint64_t sizeSram = 0;
+  getNodeMemoryTraffic(node, std::numeric_limits<uint64_t>::max(), sizeDram,
+                       sizeSram);
+  return sizeDram + sizeSram;
+}
 
-  // Calculate compute ops. Currently only computed for Matmul, Conv, FC
+uint64_t getNodeFlops(const Node *node) {
   // TODO: think about whether this is better off computed inside a Node.
   uint64_t totalOps = 0;
   switch (node->getKind()) {
@@ -325,6 +330,13 @@ float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
     totalOps = 2 * inputDims[0] * inputDims[1] * wtDims[0];
     break;
   }
+  case Kinded::Kind::BatchMatMulNodeKind: {
+    auto *BMMN = llvm::dyn_cast<BatchMatMulNode>(node);
+    auto lhsDims = BMMN->getLHS().dims();
+    auto rhsDims = BMMN->getRHS().dims();
+    totalOps = 2 * lhsDims[0] * lhsDims[1] * lhsDims[2] * rhsDims[2];
+    break;
+  }
 #ifdef GLOW_WITH_HABANA
   case Kinded::Kind::HabanaFullyConnectedNodeKind: {
     auto *FCN = llvm::dyn_cast<HabanaFullyConnectedNode>(node);
@@ -349,6 +361,8 @@ float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
     auto inputChannels = CN->getInput().dims()[1];
     auto nGroups = CN->getGroup();
     totalOps *= (inputChannels * 1.0 / nGroups);
+    // A multiply and an add per MAC.
+    totalOps *= 2;
     break;
   }
 #ifdef GLOW_WITH_HABANA
@@ -367,12 +381,41 @@ float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
     auto inputChannels = CN->getInput().dims()[1];
     auto nGroups = CN->getGroup();
     totalOps *= (inputChannels * 1.0 / nGroups);
+    // A multiply and an add per MAC.
+    totalOps *= 2;
     break;
   }
 #endif
   default:
+    // Count an op per output element of the elementwise nodes.
+    if (node->isDataParallel() && node->getNumResults() > 0) {
+      totalOps = node->getType(0)->size();
+    }
     break;
   }
+  return totalOps;
+}
+
+float getNodeComputeTime(const Node *node, const BackendInfo &backendInfo) {
+  if (backendInfo.costProfile && backendInfo.backend) {
+    if (auto latencyUs = backendInfo.costProfile->getLatencyUs(
+            backendInfo.backend->getBackendName(), node->getName())) {
+      return *latencyUs * 1e-6f;
+    }
+  }
+
+  // This code assumes all ops are BW limited from SRAM; except
+  // if the input does not fit in SRAM -- then it is DRAM BW limited
+  float peakDramBw = backendInfo.peakDramBw;
+  float peakSramBw = backendInfo.peakSramBw;
+  uint64_t sramCapacity = backendInfo.sramCapacity;
+  float peakCompute = backendInfo.peakCompute;
+
+  // Compute memory side bytes for inputs from DRAM, SRAM.
+  uint64_t sizeDram = 0;
+  uint64_t sizeSram = 0;
+  getNodeMemoryTraffic(node, sramCapacity, sizeDram, sizeSram);
+  uint64_t totalOps = getNodeFlops(node);
 
   // Compute compute roofline as max of flops, DRAM, SRAM BW
   // See https://bit.ly/2UdJ3mz
@@ -620,7 +663,7 @@ void printSlsDeviceInfo(const std::vector<SLSDeviceInfo> &slsDevices,
                         const unsigned contextCount, bool verbose_only) {
   std::stringstream ss;
   ss << "(deviceId, used_memory(MB), free_memory(MB), cost, "
-        "node_size, cost/used_memory)"
+        "node_size, cost/used_memory, lookup_bytes)"
      << strFormat(" - %zu devices -", slsDevices.size()) << "\n";
   for (const auto &d : slsDevices) {
     const auto deviceId = d.deviceId;
@@ -632,7 +675,8 @@ void printSlsDeviceInfo(const std::vector<SLSDeviceInfo> &slsDevices,
         usedMem == 0 ? "nan" : std::to_string(d.currentCost / usedMem);
     ss << "    " << deviceId << "         " << usedMem << "         " << freeMem
        << "      " << d.currentCost << "      " << nodesets[deviceId].size()
-       << "      " << costPerUsedMemory << "\n";
+       << "      " << costPerUsedMemory << "      " << d.currentLookupBytes
+       << "\n";
   }
   if (verbose_only) {
     VLOG(1) << ss.str();
@@ -657,6 +701,314 @@ bool isSLSNode(const Node *node) {
           glow::Kinded::Kind::EmbeddingBagByteRowwiseOffsetsNodeKind);
 }
 
+/// \returns the table and indices inputs of SLS node \p node, or None if
+/// \p node is not an SLS node.
+static llvm::Optional<std::pair<NodeValue, NodeValue>>
+getSLSDataAndIndices(const Node *node) {
+  switch (node->getKind()) {
+#define SLS_DATA_AND_INDICES_CASE(NODE_NAME_)                                  \
+  case Kinded::Kind::NODE_NAME_##Kind: {                                       \
+    auto *SLS = llvm::cast<NODE_NAME_>(node);                                  \
+    return std::make_pair(SLS->getData(), SLS->getIndices());                  \
+  }
+    SLS_DATA_AND_INDICES_CASE(
+        FusedRowwiseQuantizedSparseLengthsWeightedSumNode);
+    SLS_DATA_AND_INDICES_CASE(FusedRowwiseQuantizedSparseLengthsSumNode);
+    SLS_DATA_AND_INDICES_CASE(RowwiseQuantizedSparseLengthsWeightedSumNode);
+    SLS_DATA_AND_INDICES_CASE(SparseLengthsSumNode);
+    SLS_DATA_AND_INDICES_CASE(SparseLengthsWeightedSumNode);
+    SLS_DATA_AND_INDICES_CASE(EmbeddingBagNode);
+    SLS_DATA_AND_INDICES_CASE(EmbeddingBagByteRowwiseOffsetsNode);
+#undef SLS_DATA_AND_INDICES_CASE
+  default:
+    return llvm::None;
+  }
+}
+
+void accumulateSLSTableLookups(const Function &F,
+                               const PlaceholderBindings &bindings,
+                               std::map<std::string, uint64_t> &tableLookups) {
+  for (const auto &node : F.getNodes()) {
+    auto dataAndIndices = getSLSDataAndIndices(&node);
+    if (!dataAndIndices) {
+      continue;
+    }
+    auto *indicesPH = llvm::dyn_cast<Placeholder>(dataAndIndices->second);
+    const Tensor *indices = indicesPH ? bindings.get(indicesPH) : nullptr;
+    if (!indices) {
+      continue;
+    }
+    // Partial tensors only hold the real number of lookups.
+    tableLookups[dataAndIndices->first.getNode()->getName().str()] +=
+        indices->getRealNumElements();
+  }
+}
+
+/// Count the lookups of every row by \p indices in \p rowLookups.
+template <typename IndexTy>
+static void
+accumulateRowLookups(const Tensor &indices,
+                     std::unordered_map<dim_t, uint64_t> &rowLookups) {
+  auto IH = indices.getHandle<IndexTy>();
+  for (size_t i = 0, e = IH.getRealNumElements(); i < e; i++) {
+    rowLookups[IH.raw(i)]++;
+  }
+}
+
+void accumulateSLSTableRowLookups(
+    const Function &F, const PlaceholderBindings &bindings,
+    std::map<std::string, std::unordered_map<dim_t, uint64_t>> &rowLookups) {
+  for (const auto &node : F.getNodes()) {
+    auto dataAndIndices = getSLSDataAndIndices(&node);
+    if (!dataAndIndices) {
+      continue;
+    }
+    auto *indicesPH = llvm::dyn_cast<Placeholder>(dataAndIndices->second);
+    const Tensor *indices = indicesPH ? bindings.get(indicesPH) : nullptr;
+    if (!indices) {
+      continue;
+    }
+    auto &tableRows =
+        rowLookups[dataAndIndices->first.getNode()->getName().str()];
+    if (indices->getElementType() == ElemKind::Int64ITy) {
+      accumulateRowLookups<int64_t>(*indices, tableRows);
+    } else {
+      accumulateRowLookups<int32_t>(*indices, tableRows);
+    }
+  }
+}
+
+std::map<std::string, std::vector<dim_t>> selectHotSLSTableRows(
+    const std::map<std::string, std::unordered_map<dim_t, uint64_t>>
+        &rowLookups,
+    size_t maxHotRows) {
+  std::map<std::string, std::vector<dim_t>> hotRows;
+  for (const auto &table : rowLookups) {
+    std::vector<std::pair<dim_t, uint64_t>> rows(table.second.begin(),
+                                                 table.second.end());
+    // Break ties by row so the selection is deterministic.
+    std::sort(rows.begin(), rows.end(),
+              [](const std::pair<dim_t, uint64_t> &l,
+                 const std::pair<dim_t, uint64_t> &r) {
+                return l.second != r.second ? l.second > r.second
+                                            : l.first < r.first;
+              });
+    rows.resize(std::min(rows.size(), maxHotRows));
+    auto &tableHotRows = hotRows[table.first];
+    for (const auto &row : rows) {
+      tableHotRows.push_back(row.first);
+    }
+  }
+  return hotRows;
+}
+
+uint64_t getSLSTableLookupBytes(
+    const Node *node, const std::map<std::string, uint64_t> &tableLookups) {
+  auto dataAndIndices = getSLSDataAndIndices(node);
+  if (!dataAndIndices) {
+    return 0;
+  }
+  const NodeValue &data = dataAndIndices->first;
+  auto it = tableLookups.find(data.getNode()->getName().str());
+  if (it == tableLookups.end() || data.dims()[0] == 0) {
+    return 0;
+  }
+  // Every lookup reads one full row, including any fused scale and offset.
+  const uint64_t rowBytes = data.getType()->getSizeInBytes() / data.dims()[0];
+  return it->second * rowBytes;
+}
+
+/// \returns a Constant of type \p ty named \p name with all elements set to
+/// the index \p value. Splats hold floats, which can't represent every row
+/// index of a large table.
+static Constant *createIndexConstant(Module &mod, TypeRef ty,
+                                     llvm::StringRef name, int64_t value) {
+  auto *C = mod.createConstant(ty, name);
+  if (ty->getElementType() == ElemKind::Int64ITy) {
+    C->getPayloadMutable().getHandle<int64_t>().clear(value);
+  } else {
+    C->getPayloadMutable().getHandle<int32_t>().clear(value);
+  }
+  return C;
+}
+
+Expected<unsigned> shardLargeSLSTables(Function *F, uint64_t maxShardBytes) {
+  RETURN_ERR_IF_NOT(maxShardBytes > 0, "SLS table shard size must be > 0");
+  std::vector<FusedRowwiseQuantizedSparseLengthsWeightedSumNode *> largeSLS;
+  for (auto &node : F->getNodes()) {
+    auto *SLS =
+        llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumNode>(
+            &node);
+    if (!SLS) {
+      continue;
+    }
+    auto *data = llvm::dyn_cast<Constant>(SLS->getData());
+    if (data && data->getType()->getSizeInBytes() > maxShardBytes) {
+      largeSLS.push_back(SLS);
+    }
+  }
+
+  Module &mod = *F->getParent();
+  for (auto *SLS : largeSLS) {
+    auto *data = llvm::cast<Constant>(SLS->getData());
+    const dim_t numRows = data->dims()[0];
+    const uint64_t rowBytes = data->getType()->getSizeInBytes() / numRows;
+    RETURN_ERR_IF_NOT(rowBytes <= maxShardBytes,
+                      strFormat("A row of SLS table %s does not fit in a "
+                                "shard of %lu bytes",
+                                data->getName().data(), maxShardBytes));
+    const dim_t rowsPerShard = maxShardBytes / rowBytes;
+    const dim_t numShards = (numRows + rowsPerShard - 1) / rowsPerShard;
+
+    NodeValue indices = SLS->getIndices();
+    NodeValue weights = SLS->getWeights();
+    TypeRef indicesTy = indices.getType();
+    const char *payload = data->getPayload().getUnsafePtr();
+    NodeValue pooled;
+    for (dim_t shard = 0; shard < numShards; shard++) {
+      const dim_t begin = shard * rowsPerShard;
+      const dim_t rows = std::min(rowsPerShard, numRows - begin);
+      const std::string suffix = "_shard" + std::to_string(shard);
+      const std::string prefix = SLS->getName().str() + suffix;
+
+      auto *shardData = mod.createConstant(
+          mod.uniqueTypeWithNewShape(data->getType(), {rows, data->dims()[1]}),
+          data->getName().str() + suffix);
+      memcpy(shardData->getPayloadMutable().getUnsafePtr(),
+             payload + begin * rowBytes, rows * rowBytes);
+
+      // Dispatch the indices: keep the weights of the ones in
+      // [begin, begin + rows) and clamp all indices into the shard.
+      auto *beginC = createIndexConstant(mod, indicesTy, prefix + "_begin",
+                                         begin);
+      auto *endC = createIndexConstant(mod, indicesTy, prefix + "_end",
+                                       begin + rows);
+      auto *lastC =
+          createIndexConstant(mod, indicesTy, prefix + "_last", rows - 1);
+      auto *zeroC = createIndexConstant(mod, indicesTy, prefix + "_zero", 0);
+      auto *inShard = F->createAnd(
+          prefix + "_in_shard",
+          F->createCmpLTE(prefix + "_above_begin", beginC, indices),
+          F->createCmpLT(prefix + "_below_end", indices, endC));
+      NodeValue localIndices =
+          F->createSub(prefix + "_local_indices", indices, beginC);
+      localIndices = F->createMax(prefix + "_clamp_low", localIndices, zeroC);
+      localIndices = F->createMin(prefix + "_clamp_high", localIndices, lastC);
+      auto *zeroWeights =
+          F->createSplat(prefix + "_zero_weights", weights.getType(), 0);
+      auto *shardWeights = F->createSelect(prefix + "_weights", inShard,
+                                           weights, zeroWeights);
+
+      auto *partial = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+          prefix, shardData, shardWeights, localIndices, SLS->getLengths(),
+          SLS->getUseFP16Accumulation(), SLS->getLengthsMode(),
+          SLS->getAvgLength());
+      pooled = pooled.getNode()
+                   ? F->createAdd(prefix + "_sum", pooled, partial)->getResult()
+                   : partial->getResult();
+    }
+    VLOG(1) << "Sharded SLS table " << data->getName().str() << " into "
+            << numShards << " shards of up to " << rowsPerShard << " rows";
+    SLS->getResult().replaceAllUsesOfWith(pooled);
+    F->eraseNode(SLS);
+  }
+  return largeSLS.size();
+}
+
+Expected<unsigned>
+splitHotSLSTableRows(Function *F,
+                     const std::map<std::string, std::vector<dim_t>> &hotRows) {
+  std::vector<FusedRowwiseQuantizedSparseLengthsWeightedSumNode *> tieredSLS;
+  for (auto &node : F->getNodes()) {
+    auto *SLS =
+        llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumNode>(
+            &node);
+    if (!SLS) {
+      continue;
+    }
+    auto *data = llvm::dyn_cast<Constant>(SLS->getData());
+    if (!data) {
+      continue;
+    }
+    auto it = hotRows.find(data->getName().str());
+    if (it != hotRows.end() && !it->second.empty()) {
+      tieredSLS.push_back(SLS);
+    }
+  }
+
+  Module &mod = *F->getParent();
+  for (auto *SLS : tieredSLS) {
+    auto *data = llvm::cast<Constant>(SLS->getData());
+    const auto &rows = hotRows.at(data->getName().str());
+    const dim_t numRows = data->dims()[0];
+    const uint64_t rowBytes = data->getType()->getSizeInBytes() / numRows;
+    NodeValue indices = SLS->getIndices();
+    NodeValue weights = SLS->getWeights();
+    TypeRef indicesTy = indices.getType();
+    const std::string prefix = SLS->getName().str();
+
+    // Copy the hot rows and map every row of the table to its hot row, or to
+    // -1 if it has none.
+    auto *hotData = mod.createConstant(
+        mod.uniqueTypeWithNewShape(data->getType(),
+                                   {(dim_t)rows.size(), data->dims()[1]}),
+        data->getName().str() + "_hot");
+    auto *remap = createIndexConstant(
+        mod, mod.uniqueTypeWithNewShape(indicesTy, {numRows}),
+        data->getName().str() + "_hot_remap", -1);
+    auto &remapPayload = remap->getPayloadMutable();
+    const char *payload = data->getPayload().getUnsafePtr();
+    char *hotPayload = hotData->getPayloadMutable().getUnsafePtr();
+    for (dim_t slot = 0, e = rows.size(); slot < e; slot++) {
+      const dim_t row = rows[slot];
+      RETURN_ERR_IF_NOT(row < numRows,
+                        strFormat("Hot row %lu out of range of SLS table %s",
+                                  (unsigned long)row, data->getName().data()));
+      if (indicesTy->getElementType() == ElemKind::Int64ITy) {
+        auto RH = remapPayload.getHandle<int64_t>();
+        RETURN_ERR_IF_NOT(RH.raw(row) == -1, "Duplicate hot SLS table row");
+        RH.raw(row) = slot;
+      } else {
+        auto RH = remapPayload.getHandle<int32_t>();
+        RETURN_ERR_IF_NOT(RH.raw(row) == -1, "Duplicate hot SLS table row");
+        RH.raw(row) = slot;
+      }
+      memcpy(hotPayload + slot * rowBytes, payload + row * rowBytes, rowBytes);
+    }
+
+    // Each side remaps the indices on its own so the hot and cold lookups
+    // don't depend on each other once placed in different partitions.
+    auto createTier = [&](bool hot) -> NodeValue {
+      const std::string tier = prefix + (hot ? "_hot" : "_cold");
+      auto *zeroC = createIndexConstant(mod, indicesTy, tier + "_zero", 0);
+      auto *slots = F->createGather(tier + "_remap", remap, indices);
+      auto *isHot = F->createCmpLTE(tier + "_is_hot", zeroC, slots);
+      auto *zeroWeights =
+          F->createSplat(tier + "_zero_weights", weights.getType(), 0);
+      auto *tierWeights =
+          F->createSelect(tier + "_weights", isHot, hot ? weights : zeroWeights,
+                          hot ? zeroWeights : weights);
+      NodeValue tierIndices =
+          hot ? F->createMax(tier + "_indices", slots, zeroC)->getResult()
+              : indices;
+      return F
+          ->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+              tier, hot ? hotData : data, tierWeights, tierIndices,
+              SLS->getLengths(), SLS->getUseFP16Accumulation(),
+              SLS->getLengthsMode(), SLS->getAvgLength())
+          ->getResult();
+    };
+    NodeValue hotPooled = createTier(/* hot */ true);
+    NodeValue coldPooled = createTier(/* hot */ false);
+    VLOG(1) << "Split " << rows.size() << " hot rows off SLS table "
+            << data->getName().str();
+    SLS->getResult().replaceAllUsesOfWith(
+        F->createAdd(prefix + "_tiers_sum", hotPooled, coldPooled));
+    F->eraseNode(SLS);
+  }
+  return tieredSLS.size();
+}
+
 bool checkNodeInputsAllKind(const Node *node, glow::Kinded::Kind kind) {
   bool allSameKind = true;
   for (auto i = 0; i < node->getNumInputs(); i++) {
@@ -692,6 +1044,7 @@ Error assignSlsTableToFirstAvailableDevice(
     const auto totalSize = meminfo.getTotalMemSize();
     if (d.memAvailableInBytes >= totalSize) {
       d.currentCost += (size_t)table.cost;
+      d.currentLookupBytes += table.lookupBytes;
       table.deviceId = deviceId;
       frontierValues[deviceId].insert(table.frontier.begin(),
                                       table.frontier.end());
@@ -712,6 +1065,14 @@ Error assignSlsTableToFirstAvailableDevice(
   return Error::success();
 }
 
+/// \returns whether any of \p slsTables has a known lookup bandwidth, in which
+/// case tables are balanced on it rather than on their cost.
+static bool hasLookupBytes(const std::vector<SLSTableInfo> &slsTables) {
+  return std::any_of(
+      slsTables.begin(), slsTables.end(),
+      [](const SLSTableInfo &table) { return table.lookupBytes > 0; });
+}
+
 Error assignSlsTablesToDevices(
     std::vector<SLSTableInfo> &slsTables,
     std::vector<SLSDeviceInfo> &slsDevices,
@@ -733,6 +1094,8 @@ Error assignSlsTablesToDevices(
     frontierValues.swap(frontierValuesCopy);
   });
 
+  const bool balanceLookups = hasLookupBytes(slsTables);
+
   // Now sort SLS tables by size decreasing
   VLOG(1) << "SLS tables sorted by size decreasing";
   std::sort(slsTables.begin(), slsTables.end(),
@@ -771,10 +1134,15 @@ Error assignSlsTablesToDevices(
   std::vector<NodesSet> nodesets(slsDevices.size());
   std::unordered_map<Node *, size_t> addedSLSNodes;
   while (slsTablesLeft < slsTableRight) {
-    // Sort devices by size increasingly.
+    // Sort devices by size increasingly. When lookup rates are known, spread
+    // the lookup bandwidth first so hot large tables don't share a card.
     std::sort(slsDevices.begin(), slsDevices.end(),
-              [&nodesets, contextCount](const SLSDeviceInfo &l,
-                                        const SLSDeviceInfo &r) {
+              [&nodesets, contextCount,
+               balanceLookups](const SLSDeviceInfo &l, const SLSDeviceInfo &r) {
+                if (balanceLookups &&
+                    l.currentLookupBytes != r.currentLookupBytes) {
+                  return l.currentLookupBytes < r.currentLookupBytes;
+                }
                 auto lTotalSize =
                     getGraphMemInfo(nodesets[l.deviceId], contextCount)
                         .getTotalMemSize();
@@ -805,7 +1173,10 @@ Error assignSlsTablesToDevices(
                          (slsTables.end() - slsTablesLeft), slsDevices.size());
   if (slsTablesLeft < slsTables.end()) {
     std::sort(slsTablesLeft, slsTables.end(),
-              [](const SLSTableInfo &l, const SLSTableInfo &r) {
+              [balanceLookups](const SLSTableInfo &l, const SLSTableInfo &r) {
+                if (balanceLookups && l.lookupBytes != r.lookupBytes) {
+                  return l.lookupBytes > r.lookupBytes;
+                }
                 return l.cost > r.cost;
               });
   }
@@ -815,7 +1186,11 @@ Error assignSlsTablesToDevices(
   while (slsTablesLeft < slsTables.end()) {
     // Sort devices by cost increasingly.
     std::sort(slsDevices.begin(), slsDevices.end(),
-              [](const SLSDeviceInfo &l, const SLSDeviceInfo &r) {
+              [balanceLookups](const SLSDeviceInfo &l, const SLSDeviceInfo &r) {
+                if (balanceLookups &&
+                    l.currentLookupBytes != r.currentLookupBytes) {
+                  return l.currentLookupBytes < r.currentLookupBytes;
+                }
                 return l.currentCost < r.currentCost;
               });
 
@@ -859,6 +1234,8 @@ Error assignSlsTablesToDevicesGreedy(
     frontierValues.swap(frontierValuesCopy);
   });
 
+  const bool balanceLookups = hasLookupBytes(slsTables);
+
   // Now sort SLS tables by size decreasing
   VLOG(1) << "SLS tables sorted by size decreasing" << std::endl;
   std::sort(slsTables.begin(), slsTables.end(),
@@ -876,7 +1253,11 @@ Error assignSlsTablesToDevicesGreedy(
 
     // Sort by cost increasing
     std::sort(slsDevices.begin(), slsDevices.end(),
-              [](const SLSDeviceInfo &l, const SLSDeviceInfo &r) {
+              [balanceLookups](const SLSDeviceInfo &l, const SLSDeviceInfo &r) {
+                if (balanceLookups &&
+                    l.currentLookupBytes != r.currentLookupBytes) {
+                  return l.currentLookupBytes < r.currentLookupBytes;
+                }
                 return l.currentCost < r.currentCost;
               });
 
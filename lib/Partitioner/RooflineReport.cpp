@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Partitioner/RooflineReport.h"
+#include "glow/IR/LLVMAPIMacros.h"
+#include "glow/Partitioner/PartitionerTypes.h"
+#include "glow/Partitioner/PartitionerUtils.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace glow;
+
+double RooflineReport::Entry::getEfficiency() const {
+  double measuredUs = getMeasuredUs();
+  return measuredUs > 0 ? rooflineUs / measuredUs : 0;
+}
+
+RooflineReport::RooflineReport(const runtime::DeviceInfo &deviceInfo,
+                               double efficiencyThreshold)
+    : deviceInfo_(deviceInfo), efficiencyThreshold_(efficiencyThreshold) {}
+
+void RooflineReport::addFunction(const Function *F) {
+  // Without a backend nor a cost profile getNodeComputeTime() is the roofline
+  // estimate.
+  BackendInfo backendInfo;
+  backendInfo.memSize = deviceInfo_.availableMemory;
+  backendInfo.sramCapacity = deviceInfo_.sramCapacity;
+  backendInfo.peakCompute = deviceInfo_.peakCompute;
+  backendInfo.peakDramBw = deviceInfo_.peakDramBw;
+  backendInfo.peakSramBw = deviceInfo_.peakSramBw;
+  backendInfo.peakPCIeBw = deviceInfo_.peakPCIeBw;
+  for (const auto &N : F->getNodes()) {
+    auto &entry = entries_[N.getName().str()];
+    entry.kind = N.getKindName();
+    entry.flops = getNodeFlops(&N);
+    entry.bytes = getNodeBytesMoved(&N);
+    double rooflineSec = getNodeComputeTime(&N, backendInfo);
+    double computeSec =
+        entry.flops / std::max<double>(deviceInfo_.peakCompute, 1e-6);
+    entry.rooflineUs = rooflineSec * 1e6;
+    entry.computeBound = entry.flops && computeSec >= rooflineSec;
+  }
+}
+
+void RooflineReport::addTraceEvents(const std::list<TraceEvent> &events) {
+  for (const auto &event : events) {
+    if (event.type != TraceEvent::CompleteType || !event.args.count("kind")) {
+      continue;
+    }
+    auto it = entries_.find(event.name);
+    if (it != entries_.end()) {
+      it->second.totalUs += event.duration;
+      it->second.count++;
+    }
+  }
+}
+
+const RooflineReport::Entry *
+RooflineReport::getEntry(llvm::StringRef nodeName) const {
+  auto it = entries_.find(nodeName.str());
+  return it == entries_.end() ? nullptr : &it->second;
+}
+
+bool RooflineReport::isFlagged(const Entry &entry) const {
+  return entry.count && entry.getEfficiency() < efficiencyThreshold_;
+}
+
+void RooflineReport::dump(llvm::raw_ostream &os) const {
+  std::vector<std::pair<const std::string *, const Entry *>> measured;
+  for (const auto &entry : entries_) {
+    if (entry.second.count) {
+      measured.emplace_back(&entry.first, &entry.second);
+    }
+  }
+  std::sort(measured.begin(), measured.end(),
+            [](const std::pair<const std::string *, const Entry *> &a,
+               const std::pair<const std::string *, const Entry *> &b) {
+              return a.second->getMeasuredUs() > b.second->getMeasuredUs();
+            });
+
+  os << strFormat("%-40s %-24s %14s %14s %10s %12s %12s %8s %-8s\n",
+                  "Node", "Kind", "FLOPs", "Bytes", "FLOPs/B", "Measured us",
+                  "Roofline us", "Eff %", "Bound");
+  unsigned numFlagged = 0;
+  for (const auto &p : measured) {
+    const Entry &entry = *p.second;
+    bool flagged = isFlagged(entry);
+    numFlagged += flagged;
+    os << strFormat(
+        "%-40s %-24s %14llu %14llu %10.2f %12.2f %12.2f %8.2f %-8s%s\n",
+        p.first->c_str(), entry.kind.c_str(), (unsigned long long)entry.flops,
+        (unsigned long long)entry.bytes,
+        entry.bytes ? (double)entry.flops / entry.bytes : 0.0,
+        entry.getMeasuredUs(), entry.rooflineUs, entry.getEfficiency() * 100,
+        entry.computeBound ? "compute" : "memory", flagged ? " <<" : "");
+  }
+  os << strFormat("%u of %zu measured nodes below %.1f%% of the roofline\n",
+                  numFlagged, measured.size(), efficiencyThreshold_ * 100);
+}
+
+Error RooflineReport::save(llvm::StringRef fileName) const {
+  std::error_code EC;
+  llvm::raw_fd_ostream outputStream(fileName, EC, GET_FS_OPENFLAGS(F_None));
+  RETURN_ERR_IF_NOT(!EC, "Error opening roofline report '" + fileName.str() +
+                             "': " + EC.message());
+  dump(outputStream);
+  return Error::success();
+}
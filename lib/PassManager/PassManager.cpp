@@ -15,6 +15,10 @@
  */
 
 #include "glow/PassManager/PassManager.h"
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/Support/Format.h"
 
 #include <glog/logging.h>
 
@@ -105,7 +109,14 @@ PassManagerOptions::PassManagerOptions(const char *id)
               "Number of passes to run before preventing running any "
               "passes. Used for debugging."),
           llvm::cl::init(std::numeric_limits<unsigned>::max()),
-          llvm::cl::cat(passManagerCat)} {}
+          llvm::cl::cat(passManagerCat)},
+
+      timePassesOpt{
+          llvm::StringRef(staticStrFormat("time-%s-passes", id)),
+          llvm::cl::desc("Print the time, the change of the size of the IR and "
+                         "the peak memory usage of every pass run by the pass "
+                         "manager after every run of its pipeline."),
+          llvm::cl::Optional, llvm::cl::cat(passManagerCat)} {}
 
 void PassManagerBase::dump(llvm::raw_ostream &os) const {
   os << getOptions().passManagerID << "PassManager " << getName()
@@ -113,6 +124,75 @@ void PassManagerBase::dump(llvm::raw_ostream &os) const {
      << "; Current globalPassCounter: " << globalPassCounter() << "\n";
 }
 
+void PassManagerBase::dumpPassStatistics(llvm::raw_ostream &os) const {
+  uint64_t totalTimeUs = 0;
+  for (const auto &stats : passStats_) {
+    totalTimeUs += stats.totalTimeUs;
+  }
+  os << getOptions().passManagerID << "PassManager " << getName()
+     << ": pass statistics\n";
+  os << llvm::left_justify("Pass", 40) << llvm::right_justify("Runs", 7)
+     << llvm::right_justify("Changes", 9)
+     << llvm::right_justify("Time (us)", 13)
+     << llvm::right_justify("Time %", 8)
+     << llvm::right_justify("Size delta", 11)
+     << llvm::right_justify("MaxRSS (KB)", 13)
+     << llvm::right_justify("RSS growth", 13) << "\n";
+  for (const auto &stats : passStats_) {
+    os << llvm::format("%-40s %6u %8u %12llu %6.1f%% %10lld %12llu %12llu\n",
+                       stats.name.c_str(), stats.numRuns, stats.numChanges,
+                       (unsigned long long)stats.totalTimeUs,
+                       totalTimeUs ? 100.0 * stats.totalTimeUs / totalTimeUs
+                                   : 0.0,
+                       (long long)stats.sizeDelta,
+                       (unsigned long long)stats.maxRSSKB,
+                       (unsigned long long)stats.maxRSSGrowthKB);
+  }
+}
+
+bool PassManagerBase::shouldCollectPassStatistics(
+    const CompilationContext &cctx) const {
+  return getOptions().timePassesOpt ||
+         (cctx.traceContext &&
+          cctx.traceContext->shouldLog(TraceLevel::COMPILE));
+}
+
+void PassManagerBase::recordPassRun(IRContainer *C,
+                                    const CompilationContext &cctx,
+                                    const PassBase &P, uint64_t startTime,
+                                    size_t sizeBefore, uint64_t maxRSSBefore,
+                                    bool changed) {
+  const uint64_t endTime = TraceEvent::now();
+  const size_t sizeAfter = getIRSize(C);
+  const uint64_t maxRSS = getMaxRSSKB();
+
+  const std::string name = P.getName().str();
+  auto it = passStatsIdx_.find(name);
+  if (it == passStatsIdx_.end()) {
+    it = passStatsIdx_.emplace(name, passStats_.size()).first;
+    passStats_.emplace_back();
+    passStats_.back().name = name;
+  }
+  PassStatistics &stats = passStats_[it->second];
+  stats.numRuns++;
+  stats.numChanges += changed;
+  stats.totalTimeUs += endTime - startTime;
+  stats.sizeDelta += int64_t(sizeAfter) - int64_t(sizeBefore);
+  stats.maxRSSKB = maxRSS;
+  stats.maxRSSGrowthKB += maxRSS - maxRSSBefore;
+
+  if (cctx.traceContext) {
+    cctx.traceContext->logCompleteTraceEvent(
+        P.getName(), TraceLevel::COMPILE, startTime,
+        {{"passManager", getOptions().passManagerID},
+         {"function", C->getName().str()},
+         {"changed", changed ? "true" : "false"},
+         {"sizeBefore", std::to_string(sizeBefore)},
+         {"sizeAfter", std::to_string(sizeAfter)},
+         {"maxRSSKB", std::to_string(maxRSS)}});
+  }
+}
+
 bool PassManagerBase::runPrePass(IRContainer *C, const CompilationContext &cctx,
                                  const PassBase &P) {
   if (getOptions().printPassesOpt) {
@@ -191,20 +271,33 @@ bool PassManagerBase::runPass(const PassConfigBase &passConfig, IRContainer *F,
   auto pass = createFunctionPass(passConfig);
   auto &P = *pass;
   bool changed = runPrePass(F, cctx, P);
-  changed |= runPassHook(passConfig, P, F, cctx);
+  if (shouldCollectPassStatistics(cctx)) {
+    const uint64_t startTime = TraceEvent::now();
+    const size_t sizeBefore = getIRSize(F);
+    const uint64_t maxRSSBefore = getMaxRSSKB();
+    bool passChanged = runPassHook(passConfig, P, F, cctx);
+    recordPassRun(F, cctx, P, startTime, sizeBefore, maxRSSBefore,
+                  passChanged);
+    changed |= passChanged;
+  } else {
+    changed |= runPassHook(passConfig, P, F, cctx);
+  }
   changed |= runPostPass(F, cctx, P);
   return changed;
 }
 
 bool PassManagerBase::run(IRContainer *C, const CompilationContext &cctx) {
   bool changed = false;
+  lastRunStamps_.clear();
+  passStats_.clear();
+  passStatsIdx_.clear();
   size_t e = getPipelineSize();
   for (passIdx_ = 0; passIdx_ < e; passIdx_++) {
     const PassConfigBase &passConfig = getPipelineElement(passIdx_);
 
     // If we've exceeded the number of passes to run then early exit.
     if (++globalPassCounter() > getOptions().stopAfterPassNumOpt) {
-      return changed;
+      break;
     }
 
     // Skip some passes if specified by the config that they shouldn't be
@@ -229,5 +322,8 @@ bool PassManagerBase::run(IRContainer *C, const CompilationContext &cctx) {
       break;
     }
   }
+  if (getOptions().timePassesOpt) {
+    dumpPassStatistics(glow::outs());
+  }
   return changed;
 }
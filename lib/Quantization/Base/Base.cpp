@@ -19,7 +19,9 @@
 #include "glow/Quantization/Base/Calibration.h"
 #include "glow/Quantization/Base/Profile.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 namespace glow {
 namespace quantization {
@@ -790,6 +792,158 @@ Tensor quantizeTensor(const Tensor &tensor, const Tensor &scales,
   return quantizeTensor(tensor, TQP, qTy, qDim, qStep);
 }
 
+void tensorInt4GroupwiseQuantization(const Tensor &input, Tensor &output,
+                                     Tensor &scales, Tensor &offsets,
+                                     dim_t groupSize) {
+  const dim_t numRows = input.dims()[0];
+  const dim_t numCols = input.dims()[1];
+  const dim_t numGroups = (numCols + groupSize - 1) / groupSize;
+  assert(output.dims().vec() == std::vector<dim_t>({numRows,
+                                                    (numCols + 1) / 2}) &&
+         "Output must pack two columns per byte.");
+  assert(scales.dims().vec() == std::vector<dim_t>({numRows, numGroups}) &&
+         offsets.dims() == scales.dims() &&
+         "Scales and offsets must have one element per group.");
+
+  auto srcH = input.getHandle<float>();
+  auto destH = output.getHandle<uint8_t>();
+  auto scalesH = scales.getHandle<float16_t>();
+  auto offsetsH = offsets.getHandle<float16_t>();
+  destH.clear(0);
+  for (dim_t i = 0; i < numRows; i++) {
+    for (dim_t g = 0; g < numGroups; g++) {
+      const dim_t begin = g * groupSize;
+      const dim_t end = std::min(begin + groupSize, numCols);
+      float min = srcH.at({i, begin});
+      float max = min;
+      for (dim_t j = begin + 1; j < end; j++) {
+        min = std::min(min, srcH.at({i, j}));
+        max = std::max(max, srcH.at({i, j}));
+      }
+      // Like tensorFusedRowwiseQuantization, groups of a single value are
+      // represented by their offset, as are groups whose scale underflows
+      // float16.
+      constexpr float kEqualityThreshold = 1e-10f;
+      float16_t scale(((max - min) < kEqualityThreshold)
+                          ? 1.0f
+                          : float(((double)max - (double)min) / 15.0));
+      if (float(scale) == 0) {
+        scale = float16_t(1.0f);
+      }
+      const float16_t offset(min);
+      scalesH.at({i, g}) = scale;
+      offsetsH.at({i, g}) = offset;
+      for (dim_t j = begin; j < end; j++) {
+        const uint8_t q = quantize4BitsWithFloatOffset(
+            srcH.at({i, j}), float(scale), float(offset));
+        destH.at({i, j / 2}) |= (j % 2) ? (q << 4) : q;
+      }
+    }
+  }
+}
+
+/// \returns the index of the centroid of the \p numCentroids centroids of
+/// \p dim elements at \p centroids which is closest to \p vec.
+static unsigned closestCentroid(const float *vec, const float *centroids,
+                                dim_t numCentroids, dim_t dim) {
+  unsigned best = 0;
+  float bestDist = std::numeric_limits<float>::infinity();
+  for (dim_t k = 0; k < numCentroids; k++) {
+    const float *centroid = centroids + k * dim;
+    float dist = 0;
+    for (dim_t j = 0; j < dim; j++) {
+      const float diff = vec[j] - centroid[j];
+      dist += diff * diff;
+    }
+    if (dist < bestDist) {
+      bestDist = dist;
+      best = k;
+    }
+  }
+  return best;
+}
+
+void tensorProductQuantization(const Tensor &input, Tensor &codes,
+                               Tensor &codebooks, unsigned numIterations,
+                               dim_t maxTrainingRows) {
+  const dim_t numRows = input.dims()[0];
+  const dim_t numCols = input.dims()[1];
+  const dim_t numSubspaces = codebooks.dims()[0];
+  const dim_t numCentroids = codebooks.dims()[1];
+  const dim_t subDim = codebooks.dims()[2];
+  assert(numSubspaces * subDim == numCols &&
+         "Subspaces must cover the rows exactly.");
+  assert(codes.dims().vec() == std::vector<dim_t>({numRows, numSubspaces}) &&
+         "Codes must have one element per subspace and row.");
+  assert(numCentroids >= 1 && numCentroids <= 256 &&
+         "Codes can only address 256 centroids.");
+
+  auto srcH = input.getHandle<float>();
+  auto codesH = codes.getHandle<uint8_t>();
+  auto codebooksH = codebooks.getHandle<float>();
+  const float *src = &srcH.raw(0);
+
+  // Train on rows evenly spread over the table, large tables would otherwise
+  // take too long to cluster.
+  const dim_t numTrainingRows =
+      std::max<dim_t>(1, std::min(numRows, maxTrainingRows));
+  std::vector<dim_t> trainingRows(numTrainingRows);
+  for (dim_t i = 0; i < numTrainingRows; i++) {
+    trainingRows[i] = i * numRows / numTrainingRows;
+  }
+
+  std::vector<float> subvectors(numTrainingRows * subDim);
+  std::vector<unsigned> assignment(numTrainingRows);
+  std::vector<double> sums(numCentroids * subDim);
+  std::vector<dim_t> counts(numCentroids);
+  for (dim_t s = 0; s < numSubspaces; s++) {
+    for (dim_t i = 0; i < numTrainingRows; i++) {
+      const float *row = src + trainingRows[i] * numCols + s * subDim;
+      std::copy(row, row + subDim, subvectors.begin() + i * subDim);
+    }
+    // Start from training rows spread over the table.
+    float *centroids = &codebooksH.at({s, 0, 0});
+    for (dim_t k = 0; k < numCentroids; k++) {
+      const dim_t i = k * numTrainingRows / numCentroids;
+      std::copy(subvectors.begin() + i * subDim,
+                subvectors.begin() + (i + 1) * subDim, centroids + k * subDim);
+    }
+    for (unsigned iter = 0; iter < numIterations; iter++) {
+      bool changed = iter == 0;
+      for (dim_t i = 0; i < numTrainingRows; i++) {
+        unsigned k = closestCentroid(&subvectors[i * subDim], centroids,
+                                     numCentroids, subDim);
+        changed |= k != assignment[i];
+        assignment[i] = k;
+      }
+      if (!changed) {
+        break;
+      }
+      std::fill(sums.begin(), sums.end(), 0.0);
+      std::fill(counts.begin(), counts.end(), 0);
+      for (dim_t i = 0; i < numTrainingRows; i++) {
+        counts[assignment[i]]++;
+        for (dim_t j = 0; j < subDim; j++) {
+          sums[assignment[i] * subDim + j] += subvectors[i * subDim + j];
+        }
+      }
+      // Centroids no row is closest to stay where they are.
+      for (dim_t k = 0; k < numCentroids; k++) {
+        if (!counts[k]) {
+          continue;
+        }
+        for (dim_t j = 0; j < subDim; j++) {
+          centroids[k * subDim + j] = sums[k * subDim + j] / counts[k];
+        }
+      }
+    }
+    for (dim_t r = 0; r < numRows; r++) {
+      codesH.at({r, s}) = closestCentroid(src + r * numCols + s * subDim,
+                                          centroids, numCentroids, subDim);
+    }
+  }
+}
+
 bool isFloatPowerOf2(float val) {
   // frexp returns mantissa normalized in [0.5,1) so compare with 0.5.
   int exp;
@@ -22,87 +22,199 @@
 namespace glow {
 namespace quantization {
 
-/// Function to prepare the histogram \p hist with length \p length before
-/// computing the relative entropy. The histogram is NOT normalized and is
-/// assumed to be a sequence of positive integers (0,1,...) stored as a float
-/// sequence to accommodate very large values. The histogram is conditioned
-/// in the following way: zero values are replaced with \p epsZero while the
-/// corresponding amount is subtracted from the non-zero values.
-static void conditionHistogram(float *hist, const size_t length,
-                               const float epsZero = 0.0001) {
-
-  // If histogram is empty then return.
-  if (length == 0) {
-    return;
+/// Value given by the conditioning of a histogram to its zero bins, whose
+/// amount is subtracted from its non-zero bins so that the histogram keeps
+/// its sum. The conditioning is skipped if that would subtract 1.0 or more from
+/// every non-zero bin, as well as for an all-zero histogram.
+static constexpr float epsZero = 0.0001;
+
+/// \returns the value subtracted from the non-zero bins of a histogram with
+/// \p numZeros zero bins out of \p length by its conditioning, or a negative
+/// value if the histogram is not conditioned, see epsZero.
+static float getEpsNonZero(size_t numZeros, size_t length) {
+  if (numZeros == length) {
+    return -1;
   }
+  float epsNonZero = epsZero * static_cast<float>(numZeros) /
+                     static_cast<float>(length - numZeros);
+  return epsNonZero >= 1.0 ? -1 : epsNonZero;
+}
 
-  // Get information about the zero values within the histogram.
-  std::vector<int> isZero(length);
-  size_t numZeros = 0;
-  for (size_t idx = 0, e = length; idx < e; idx++) {
-    isZero[idx] = static_cast<int>(hist[idx] == 0.f);
-    numZeros += isZero[idx];
+namespace {
+/// Prefix sums of a histogram, from which optimizeKL gets the sums of the
+/// bins of a window in constant time.
+struct HistogramPrefix {
+  /// Sum of the bins before every bin, and of all the bins.
+  std::vector<double> sum;
+  /// Number of non-zero bins before every bin, and among all the bins.
+  std::vector<size_t> nonZeros;
+
+  explicit HistogramPrefix(const std::vector<float> &hist)
+      : sum(hist.size() + 1, 0), nonZeros(hist.size() + 1, 0) {
+    for (size_t idx = 0, e = hist.size(); idx < e; idx++) {
+      sum[idx + 1] = sum[idx] + hist[idx];
+      nonZeros[idx + 1] = nonZeros[idx] + (hist[idx] != 0);
+    }
   }
 
-  // If histogram is all zeros then return.
-  if (numZeros == length) {
-    return;
+  /// \returns the sum of the bins [\p start, \p stop).
+  double getSum(size_t start, size_t stop) const {
+    return sum[stop] - sum[start];
   }
 
-  // Compute epsilon to subtract from non-zero histogram values.
-  size_t numNonZeros = length - numZeros;
-  float epsNonZero =
-      epsZero * static_cast<float>(numZeros) / static_cast<float>(numNonZeros);
+  /// \returns the number of non-zero bins among [\p start, \p stop).
+  size_t getNonZeros(size_t start, size_t stop) const {
+    return nonZeros[stop] - nonZeros[start];
+  }
+};
+} // namespace
 
-  // If value to subtract from non-zero values is higher than 1.0 then return.
-  if (epsNonZero >= 1.0) {
-    return;
+/// \returns the Kullback-Leibler divergence (relative entropy), defined as:
+///               D(P||Q) = sum(P[k] * log(P[k] / Q[k]))
+/// of the distribution Q with respect to the reference distribution P built
+/// from the histogram \p hist of prefix sums \p prefix for the window of
+/// bins [\p histWinIdxStart, \p histWinIdxStop] (inclusive):
+/// - P is the histogram saturated in the window, the bins out of the window
+///   being added to the first and last bins of the window.
+/// - Q is the window rescaled to \p numQuantizedBins and expanded back to the
+///   window length. The bins of the window are distributed equally in the
+///   quantized bins, the remainder going to the last quantized bin. Every
+///   non-zero bin of P gets the mean of the non-zero bins of its quantized
+///   bin.
+/// Both distributions are conditioned, see epsZero, and normalized. The
+/// divergence is the amount of information (entropy) lost when Q is used to
+/// approximate P and is always positive. Rather than building P and Q, the
+/// divergence is accumulated bin by bin, the bins of Q being the same across
+/// a quantized bin, and the bins which are zero in both P and Q contributing
+/// together. The sums and counts of bins come from \p prefix, so that the
+/// only work proportional to the window size is a logarithm per non-zero bin.
+/// The bins of Q of the quantized bins are stored in \p valQ, of
+/// \p numQuantizedBins elements. \returns 0 when one of the distributions is
+/// all zero.
+static float computeWindowKL(const std::vector<float> &hist,
+                             const HistogramPrefix &prefix,
+                             size_t histWinIdxStart, size_t histWinIdxStop,
+                             size_t numQuantizedBins,
+                             std::vector<double> &valQ) {
+  const size_t numBins = hist.size();
+  const size_t histWinSize = histWinIdxStop - histWinIdxStart + 1;
+  const float *histWinPtr = hist.data() + histWinIdxStart;
+
+  // Note: MXNet / TVM have an error in their programs since they explicitly
+  // extract the histogram window in the variable 'sliced_nd_hist' which has
+  // always 0 on the first position that is sliced_nd_hist.front() == 0.
+
+  // The first and last bins of P, saturated with the bins out of the window.
+  const double leftSum = prefix.getSum(0, histWinIdxStart + 1);
+  const double rightSum = prefix.getSum(histWinIdxStop, numBins);
+  double firstP = leftSum;
+  double lastP = rightSum;
+  if (histWinSize == 1) {
+    firstP = lastP = leftSum + rightSum;
   }
+  // \returns the bin \p idx of P.
+  auto getP = [&](size_t idx) -> double {
+    if (idx == 0) {
+      return firstP;
+    }
+    if (idx == histWinSize - 1) {
+      return lastP;
+    }
+    return histWinPtr[idx];
+  };
 
-  // Perform histogram conditioning:
-  // - zero histogram values are increased with epsZero.
-  // - non-zero histogram values are decreased with epsNonZero.
-  for (size_t idx = 0, e = length; idx < e; idx++) {
-    hist[idx] += epsZero * isZero[idx];
-    hist[idx] -= epsNonZero * (1 - isZero[idx]);
+  // Number of zero bins of P.
+  size_t numZerosP = histWinSize;
+  if (histWinSize > 2) {
+    numZerosP -= prefix.getNonZeros(histWinIdxStart + 1, histWinIdxStop);
+  }
+  numZerosP -= (firstP != 0);
+  if (histWinSize > 1) {
+    numZerosP -= (lastP != 0);
   }
-}
 
-/// Function to compute the Kullback-Leibler divergence (relative entropy)
-/// of the distribution \p P with respect to \p Q denoted with D(P||Q) and
-/// defined as:
-///               D(P||Q) = sum(P[k] * log(P[k] / Q[k]))
-/// Depending on the base of the logarithm, the unit of measurement for the
-/// divergence is "bits" for log2 and "nats" for ln (natural logarithm).
-/// This function does NOT require the distributions \p P and \p Q to be
-/// normalized because are normalized automatically in-place. The length
-/// of the distributions is \p length. \returns the relative entropy metric
-/// as a float scalar.
-/// The meaning of this metric is the amount of information (entropy) lost
-/// when the distribution \p Q is used to approximate the ground truth
-/// (reference) distribution \p P. The divergence metric is always positive
-/// that is D(P||Q) >= 0.
-static float computeKL(float *P, float *Q, size_t length) {
-
-  // Compute sum of P and Q to use for normalization.
-  float sumP = std::accumulate(P, P + length, 0.f);
-  float sumQ = std::accumulate(Q, Q + length, 0.f);
-
-  // Return 0 when one of the distributions is all zero.
-  if ((sumP == 0.f) || (sumQ == 0.f)) {
+  // The bins of the window are distributed equally in the quantized bins. The
+  // remainder is distributed in the last quantized bin.
+  assert(histWinSize >= numQuantizedBins && "Invalid histogram window size!");
+  const size_t numMergedBins = histWinSize / numQuantizedBins;
+  auto getQuantizedBinStop = [&](size_t qIdx) {
+    return (qIdx < (numQuantizedBins - 1)) ? (qIdx + 1) * numMergedBins
+                                           : histWinSize;
+  };
+
+  // Number of zero bins and sum of Q. The bin of Q for a quantized bin is the
+  // sum of its bins divided by the number of its non-zero bins.
+  size_t numNonZerosQ = 0;
+  double sumQ = 0;
+  for (size_t qIdx = 0; qIdx < numQuantizedBins; qIdx++) {
+    const size_t idxStart = qIdx * numMergedBins;
+    const size_t idxStop = getQuantizedBinStop(qIdx);
+    const size_t norm = prefix.getNonZeros(histWinIdxStart + idxStart,
+                                           histWinIdxStart + idxStop);
+    valQ[qIdx] = 0;
+    if (norm == 0) {
+      continue;
+    }
+    valQ[qIdx] =
+        prefix.getSum(histWinIdxStart + idxStart, histWinIdxStart + idxStop) /
+        norm;
+    // The non-zero bins of P within the window are the non-zero bins of the
+    // histogram, except for the saturated first and last bins.
+    size_t nonZerosP = norm;
+    if (idxStart == 0) {
+      nonZerosP += (firstP != 0) - (histWinPtr[0] != 0);
+    }
+    if (idxStop == histWinSize && histWinSize > 1) {
+      nonZerosP += (lastP != 0) - (histWinPtr[histWinSize - 1] != 0);
+    }
+    numNonZerosQ += nonZerosP;
+    sumQ += valQ[qIdx] * nonZerosP;
+  }
+
+  // The conditioning keeps the sums of the distributions, and all the mass of
+  // the histogram is in P.
+  const double sumP = prefix.getSum(0, numBins);
+  if ((sumP == 0) || (sumQ == 0)) {
     return 0;
   }
 
-  // Compute relative entropy.
-  float divergence = 0;
-  for (size_t idx = 0, e = length; idx < e; idx++) {
-    P[idx] /= sumP;
-    Q[idx] /= sumQ;
-    if ((P[idx] > 0) && (Q[idx] > 0)) {
-      divergence += P[idx] * std::log(P[idx] / Q[idx]);
+  // Values of the zero bins of P and Q after conditioning, and values
+  // subtracted from their non-zero bins.
+  const float epsNonZeroP = getEpsNonZero(numZerosP, histWinSize);
+  const float epsNonZeroQ =
+      getEpsNonZero(histWinSize - numNonZerosQ, histWinSize);
+  const double zeroP = epsNonZeroP < 0 ? 0 : epsZero;
+  const double zeroQ = epsNonZeroQ < 0 ? 0 : epsZero;
+  const double subP = std::max(epsNonZeroP, 0.f);
+  const double subQ = std::max(epsNonZeroQ, 0.f);
+
+  // With the normalized bins p / sumP and q / sumQ, every bin contributes
+  // p / sumP * (log(p / q) + logSumRatio).
+  const double logSumRatio = std::log(sumQ / sumP);
+  double divergence = 0;
+  if (zeroP > 0 && zeroQ > 0) {
+    // The zero bins of P are zero bins of Q.
+    divergence += numZerosP * zeroP * (std::log(zeroP / zeroQ) + logSumRatio);
+  }
+  for (size_t qIdx = 0; qIdx < numQuantizedBins; qIdx++) {
+    const double q = valQ[qIdx] != 0 ? valQ[qIdx] - subQ : zeroQ;
+    if (q <= 0) {
+      continue;
+    }
+    const double logQ = std::log(q);
+    for (size_t idx = qIdx * numMergedBins, e = getQuantizedBinStop(qIdx);
+         idx < e; idx++) {
+      const double rawP = getP(idx);
+      if (rawP == 0) {
+        continue;
+      }
+      const double p = rawP - subP;
+      if (p > 0) {
+        divergence += p * (std::log(p) - logQ + logSumRatio);
+      }
     }
   }
-  return divergence;
+  return divergence / sumP;
 }
 
 FloatRange optimizeKL(const std::vector<float> &hist, const float histMin,
@@ -129,6 +241,10 @@ FloatRange optimizeKL(const std::vector<float> &hist, const float histMin,
   float thresholdMinOpt = histMin;
   float thresholdMaxOpt = histMax;
 
+  // Prefix sums of the histogram for the divergence of every window.
+  const HistogramPrefix prefix(hist);
+  std::vector<double> valQ(numQuantizedBins);
+
   // Initialize start/stop bin indices (inclusive) with the first and last bin.
   size_t histWinIdxStart = 0;
   size_t histWinIdxStop = numBins - 1;
@@ -143,94 +259,9 @@ FloatRange optimizeKL(const std::vector<float> &hist, const float histMin,
   //     this algorithm hopes to achieve better ranges for quantizing a tensor.
   while ((histWinIdxStop - histWinIdxStart + 1) >= numQuantizedBins) {
 
-    // Current histogram window size.
-    const size_t histWinSize = histWinIdxStop - histWinIdxStart + 1;
-
-    // Current histogram window raw pointer.
-    const float *histWinPtr = hist.data() + histWinIdxStart;
-
-    // Note: MXNet / TVM have an error in their programs since they explicitly
-    // extract the histogram window in the variable 'sliced_nd_hist' which has
-    // always 0 on the first position that is sliced_nd_hist.front() == 0.
-
-    // -------------------------------------------------------------------------
-    // Compute the reference distribution P as the input histogram saturated in
-    // the current window given by histWinIdxStart and histWinIdxStop.
-    // -------------------------------------------------------------------------
-    std::vector<float> P(histWinSize);
-
-    // Saturate the histogram left.
-    float leftSum = 0;
-    for (size_t histIdx = 0; histIdx <= histWinIdxStart; histIdx++) {
-      leftSum += hist[histIdx];
-    }
-    P.front() += leftSum;
-
-    // Extract the non-saturated part of the histogram.
-    for (size_t histIdx = histWinIdxStart + 1; histIdx < histWinIdxStop;
-         histIdx++) {
-      P[histIdx - histWinIdxStart] = hist[histIdx];
-    }
-
-    // Saturate the histogram right.
-    float rightSum = 0;
-    for (size_t histIdx = histWinIdxStop; histIdx < numBins; histIdx++) {
-      rightSum += hist[histIdx];
-    }
-    P.back() += rightSum;
-
-    // -------------------------------------------------------------------------
-    // Compute the approximation distribution Q as the input histogram sliced in
-    // the current window given by histWinIdxStart and histWinIdxStop, rescaled
-    // to numQuantizedBins and then expanded back to the current window length.
-    // -------------------------------------------------------------------------
-    // The bins from the current histogram window are distributed equally in the
-    // quantized bins. The remainder is distributed in the last quantized bin.
-    assert(histWinSize >= numQuantizedBins && "Invalid histogram window size!");
-    const size_t numMergedBins = histWinSize / numQuantizedBins;
-
-    // Compute Q.
-    std::vector<float> Q(histWinSize, 0);
-    for (size_t qIdx = 0; qIdx < numQuantizedBins; qIdx++) {
-
-      // Histogram window bin start index (inclusive) for this quantized bin.
-      const size_t idxStart = qIdx * numMergedBins;
-
-      // Histogram window bin stop index (exclusive) for this quantized bin.
-      // If last quantized bin then go to the end of the window.
-      const size_t idxStop = (qIdx < (numQuantizedBins - 1))
-                                 ? (idxStart + numMergedBins)
-                                 : histWinSize;
-
-      // Sum all the values for this quantized bin.
-      // Count all the non-negative values for this quantized bin to use for
-      // normalization.
-      float sum = 0;
-      size_t norm = 0;
-      for (size_t idx = idxStart; idx < idxStop; idx++) {
-        sum += histWinPtr[idx];
-        norm += (histWinPtr[idx] != 0);
-      }
-
-      // Compute Q by expanding and normalizing the quantized bins.
-      if (norm != 0) {
-        for (size_t idx = idxStart; idx < idxStop; idx++) {
-          if (P[idx]) {
-            Q[idx] = sum / (float)norm;
-          }
-        }
-      }
-    }
-
-    // -------------------------------------------------------------------------
     // Compute the KL divergence metric and check for optimal values.
-    // -------------------------------------------------------------------------
-    // Condition the histograms P and Q.
-    conditionHistogram(P.data(), P.size());
-    conditionHistogram(Q.data(), Q.size());
-
-    // Compute the divergence of P with respect to Q.
-    float divergence = computeKL(P.data(), Q.data(), P.size());
+    float divergence = computeWindowKL(hist, prefix, histWinIdxStart,
+                                       histWinIdxStop, numQuantizedBins, valQ);
 
     // Check if current divergence is the new optimal.
     if (divergence < divergenceOpt) {
@@ -259,9 +290,13 @@ FloatRange optimizeKL(const std::vector<float> &hist, const float histMin,
       float leftLoss = hist[histWinIdxStart] + hist[histWinIdxStart + 1];
       float rightLoss = hist[histWinIdxStop] + hist[histWinIdxStop - 1];
 
-      std::vector<float> loss = {symmLoss, leftLoss, rightLoss};
-      auto lossMinIdx = std::distance(
-          loss.begin(), std::min_element(loss.begin(), loss.end()));
+      // Pick the first of the minimum losses, in the order above.
+      int lossMinIdx = 2;
+      if (symmLoss <= leftLoss && symmLoss <= rightLoss) {
+        lossMinIdx = 0;
+      } else if (leftLoss <= rightLoss) {
+        lossMinIdx = 1;
+      }
       if (lossMinIdx == 0) {
         // Saturate symmetrically.
         histWinIdxStart++;
@@ -17,6 +17,7 @@
 #include "glow/Quantization/Base/Profile.h"
 
 #include <cmath>
+#include <numeric>
 
 namespace glow {
 namespace quantization {
@@ -33,12 +34,112 @@ static size_t getBin(size_t nBins, float binWidth, float minValue,
   return result;
 }
 
+/// Number of elements whose bins are computed at once by
+/// generateTensorHistogram, sized for the bins to stay in L1.
+static constexpr size_t histogramBlockSize = 256;
+
+/// Redistribute the counts of the \p nBins bins of \p hist of range
+/// [\p min, \p max] to the bins of the range [\p newMin, \p newMax], which
+/// includes it, in place. Every source bin lands in at most two destination
+/// bins, of positions which increase with the position of the source bin, as
+/// the destination bins are wider. The bins moving up are visited from the
+/// top and the bins moving down from the bottom, so that no bin is written
+/// before being read, except for the two bins around the point where the
+/// direction changes, which are read beforehand.
+static void rescaleHistogramInPlace(Handle<float> hist, float min, float max,
+                                    float newMin, float newMax) {
+  const size_t nBins = hist.size();
+  const float destBinWidth = (newMax - newMin) / nBins;
+  const float srcBinWidth = (max - min) / nBins;
+
+  // \returns the two destination bins of the source bin \p i.
+  auto getDestBins = [&](size_t i) {
+    float srcBinBegin = min + srcBinWidth * i;
+    return std::make_pair(
+        getBin(nBins, destBinWidth, newMin, srcBinBegin),
+        getBin(nBins, destBinWidth, newMin, srcBinBegin + destBinWidth));
+  };
+
+  // Add the count \p count of the source bin \p i to its destination bins.
+  auto redistribute = [&](size_t i, float count) {
+    if (count == 0) {
+      return;
+    }
+    float srcBinBegin = min + srcBinWidth * i;
+    size_t destBin = (srcBinBegin - newMin) / destBinWidth;
+    float destBinEnd = newMin + destBinWidth * (destBin + 1);
+
+    float srcBinEnd = srcBinBegin + srcBinWidth;
+    size_t destBinToVerify = (srcBinEnd - newMin) / destBinWidth;
+    // Make sure that destination bin is mapped at most to 2 final bins, based
+    // on that redistribute percentage is calculated.
+    assert(destBinToVerify <= destBin + 2);
+    (void)destBinToVerify;
+
+    // Calculate how much we need to redistribute.
+    uint64_t dstBinCnt = static_cast<uint64_t>(std::min(
+        static_cast<float>(round((destBinEnd - srcBinBegin) / srcBinWidth *
+                                 count)),
+        count));
+
+    auto destBins = getDestBins(i);
+    hist.raw(destBins.first) += dstBinCnt;
+    if (dstBinCnt < count) {
+      hist.raw(destBins.second) += count - dstBinCnt;
+    }
+  };
+
+  // The first source bin moving down, all the bins below it moving up. The
+  // rounding of the bin positions may break the order the visit relies on,
+  // in which case the histogram is rescaled through a copy.
+  size_t pivot = 0;
+  while (pivot < nBins && getDestBins(pivot).first >= pivot) {
+    pivot++;
+  }
+  bool inPlace = pivot > 0;
+  for (size_t i = 0; inPlace && i < nBins; i++) {
+    if (i + 1 < pivot) {
+      inPlace = getDestBins(i).second <= pivot;
+    } else if (i > pivot) {
+      inPlace = getDestBins(i).second <= i;
+    }
+  }
+  if (!inPlace) {
+    std::vector<float> srcHist(nBins);
+    for (size_t i = 0; i < nBins; i++) {
+      srcHist[i] = hist.raw(i);
+      hist.raw(i) = 0;
+    }
+    for (size_t i = 0; i < nBins; i++) {
+      redistribute(i, srcHist[i]);
+    }
+    return;
+  }
+
+  auto take = [&](size_t i) {
+    float count = hist.raw(i);
+    hist.raw(i) = 0;
+    return count;
+  };
+  float lastUpCount = take(pivot - 1);
+  float firstDownCount = pivot < nBins ? take(pivot) : 0;
+  for (size_t i = pivot - 1; i-- > 0;) {
+    redistribute(i, take(i));
+  }
+  for (size_t i = pivot + 1; i < nBins; i++) {
+    redistribute(i, take(i));
+  }
+  redistribute(pivot - 1, lastUpCount);
+  if (pivot < nBins) {
+    redistribute(pivot, firstDownCount);
+  }
+}
+
 void generateTensorHistogram(const Handle<float> inputTensor,
                              Handle<float> existingHistogram, float &min,
                              float &max) {
-  auto minMaxPos = inputTensor.minMaxArg();
-  float minInput = inputTensor.raw(minMaxPos.first);
-  float maxInput = inputTensor.raw(minMaxPos.second);
+  float minInput, maxInput;
+  std::tie(minInput, maxInput) = inputTensor.minMax();
 
   if (existingHistogram.isZero()) {
     min = minInput;
@@ -51,60 +152,46 @@ void generateTensorHistogram(const Handle<float> inputTensor,
   if (minInput < min || maxInput > max) {
     float newMin = std::min(minInput, min);
     float newMax = std::max(maxInput, max);
-
-    float destBinWidth = (newMax - newMin) / nBins;
-    float srcBinWidth = (max - min) / nBins;
-
-    std::vector<float> scaledHistogram(nBins, 0);
-
-    for (size_t i = 0; i < nBins; ++i) {
-      if (existingHistogram.raw(i) == 0)
-        continue;
-
-      float srcBinBegin = min + srcBinWidth * i;
-      size_t destBin = (srcBinBegin - newMin) / destBinWidth;
-      float destBinEnd = newMin + destBinWidth * (destBin + 1);
-
-      float srcBinEnd = srcBinBegin + srcBinWidth;
-      size_t destBinToVerify = (srcBinEnd - newMin) / destBinWidth;
-      // Make sure that destination bin is mapped at most to 2 final bins, based
-      // on that redistribute percentage is calculated.
-      assert(destBinToVerify <= destBin + 2);
-      (void)destBinToVerify;
-
-      // Calculate how much we need to redistribute.
-      uint64_t dstBinCnt = static_cast<uint64_t>(std::min(
-          static_cast<float>(round((destBinEnd - srcBinBegin) / srcBinWidth *
-                                   existingHistogram.raw(i))),
-          existingHistogram.raw(i)));
-
-      size_t newBin = getBin(nBins, destBinWidth, newMin, srcBinBegin);
-      scaledHistogram[newBin] += dstBinCnt;
-
-      if (dstBinCnt < existingHistogram.raw(i)) {
-        size_t newBin =
-            getBin(nBins, destBinWidth, newMin, srcBinBegin + destBinWidth);
-        scaledHistogram[newBin] += existingHistogram.raw(i) - dstBinCnt;
-      }
-    }
-
-    // Copy scaled histogram back to the existing histogram.
-    for (size_t i = 0, e = scaledHistogram.size(); i < e; ++i) {
-      existingHistogram.raw(i) = scaledHistogram[i];
-    }
+    rescaleHistogramInPlace(existingHistogram, min, max, newMin, newMax);
 
     // Update global min and max.
     min = newMin;
     max = newMax;
   }
 
+  const float *data = &inputTensor.raw(0);
+  const size_t size = inputTensor.size();
+#ifndef NDEBUG
+  // Sanity check for NaN and Infinity.
+  for (size_t i = 0; i < size; i++) {
+    assert(!std::isnan(data[i]) && "NaN value found!");
+    assert(!std::isinf(data[i]) && "Infinity value found!");
+  }
+#endif
+
   float binWidth = (max - min) / nBins;
-  for (auto elem : inputTensor) {
-    size_t newBin = getBin(nBins, binWidth, min, elem);
-    existingHistogram.raw(newBin)++;
-    // Sanity check for NaN and Infinity.
-    assert(!std::isnan(elem) && "NaN value found!");
-    assert(!std::isinf(elem) && "Infinity value found!");
+  float *histogram = &existingHistogram.raw(0);
+  if (binWidth == 0) {
+    histogram[0] += size;
+    return;
+  }
+
+  // Compute the bins of a block of elements in a loop free of branches and
+  // of stores to the histogram, which vectorizes, then count them. Every
+  // element is at least min, so clamping the bin position before truncating
+  // it gives the same bin as getBin.
+  const float maxBin = nBins - 1;
+  uint32_t bins[histogramBlockSize];
+  for (size_t begin = 0; begin < size; begin += histogramBlockSize) {
+    const size_t blockSize = std::min(histogramBlockSize, size - begin);
+    const float *block = data + begin;
+    for (size_t i = 0; i < blockSize; i++) {
+      bins[i] = static_cast<uint32_t>(
+          std::min((block[i] - min) / binWidth, maxBin));
+    }
+    for (size_t i = 0; i < blockSize; i++) {
+      histogram[bins[i]]++;
+    }
   }
 }
 
@@ -192,5 +279,46 @@ std::vector<float> rescaleHistogram(const std::vector<float> &srcHist,
   return destHist;
 }
 
+void combineTensorProfilingParams(TensorProfilingParams &dest,
+                                  const TensorProfilingParams &src) {
+  if (src.min > src.max) {
+    return;
+  }
+  if (dest.min > dest.max) {
+    dest = src;
+    return;
+  }
+  assert(dest.histogram.size() == src.histogram.size() &&
+         "Histograms must have the same number of bins!");
+
+  const float min = std::min(dest.min, src.min);
+  const float max = std::max(dest.max, src.max);
+  const size_t nBins = dest.histogram.size();
+
+  // Rescale the histogram of the profile \p P to the combined range. A
+  // profile which has only seen one value has all its counts in one bin.
+  auto rescale = [&](const TensorProfilingParams &P) {
+    if (P.min == min && P.max == max) {
+      return P.histogram;
+    }
+    if (P.min == P.max) {
+      std::vector<float> hist(nBins, 0);
+      hist[getBin(nBins, (max - min) / nBins, min, P.min)] =
+          std::accumulate(P.histogram.begin(), P.histogram.end(), 0.0f);
+      return hist;
+    }
+    return rescaleHistogram(P.histogram, P.min, P.max, min, max);
+  };
+
+  std::vector<float> histogram = rescale(dest);
+  std::vector<float> srcHistogram = rescale(src);
+  for (size_t i = 0; i < nBins; i++) {
+    histogram[i] += srcHistogram[i];
+  }
+  dest.min = min;
+  dest.max = max;
+  dest.histogram = std::move(histogram);
+}
+
 } // namespace quantization
 } // namespace glow
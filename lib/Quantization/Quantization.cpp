@@ -18,8 +18,12 @@
 
 #include "glow/Backend/Backend.h"
 #include "glow/Converter/FunctionConverter.h"
+#include "glow/Support/ThreadPool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -182,8 +186,12 @@ protected:
   /// a LookupTable if the backend doesn't support the quantized node directly.
 #define CASES_FOR_INT_LOOKUP_TABLE_REPLACEMENT                                 \
   case Kinded::Kind::LogNodeKind:                                              \
+  case Kinded::Kind::ExpNodeKind:                                              \
   case Kinded::Kind::TanhNodeKind:                                             \
-  case Kinded::Kind::SigmoidNodeKind
+  case Kinded::Kind::SigmoidNodeKind:                                          \
+  case Kinded::Kind::HardSwishNodeKind:                                        \
+  case Kinded::Kind::GeluNodeKind:                                             \
+  case Kinded::Kind::ErfNodeKind
 
   /// \see FunctionConverter::canConvert.
   /// Only convert nodes that use floating point types and that
@@ -200,6 +208,13 @@ protected:
       return false;
     }
 
+    // Check if the node is kept in floating point by its precision.
+    if (const auto *P = quantConfig_.getNodePrecision(node.getName())) {
+      if (*P == NodePrecision::FP16 || *P == NodePrecision::FP32) {
+        return false;
+      }
+    }
+
     // Gather the input and output types that we will have once we quantize the
     // node, and check if the backend supports such a node. Note that if a node
     // has float inputs or outputs then we must have quantization parameters for
@@ -503,6 +518,11 @@ protected:
         quantizedNode = replaceQuantizedSigmoidWithLookupTable(
             function_, llvm::cast<SigmoidNode>(node), schema_);
         break;
+      case Kinded::Kind::HardSwishNodeKind:
+      case Kinded::Kind::GeluNodeKind:
+      case Kinded::Kind::ErfNodeKind:
+        quantizedNode = replaceQuantizedUnaryWithLookupTable(function_, node);
+        break;
       default:
         llvm_unreachable("Unsupported case for converting to lookup table.");
       }
@@ -583,6 +603,10 @@ private:
   // If true, don't apply quantization to FC bias inputs.
   const bool skipQuantizeFCBias_;
 
+  /// The quantization configuration, for the precisions of specific nodes and
+  /// whether to use channelwise quantization.
+  const QuantizationConfiguration &quantConfig_;
+
 public:
   /// Creates a function quantizer for function \p F using the quantization
   /// configuration \p quantConfig. This method quantizes as many nodes as
@@ -600,7 +624,8 @@ public:
         doNotQuantizeKinds_(doNotQuantizeKinds), loweredMap_(loweredMap),
         assertAllNodesQuantized_(quantConfig.assertAllNodesQuantized),
         quantizationPrecisionBias_(quantConfig.precisionBias),
-        skipQuantizeFCBias_(quantConfig.skipQuantizeFCBias) {
+        skipQuantizeFCBias_(quantConfig.skipQuantizeFCBias),
+        quantConfig_(quantConfig) {
 
     // Compute the TensorQuantizationParams using the profiling infos.
     auto quantizationInfos =
@@ -795,7 +820,17 @@ public:
       // if the filter and bias operands are constant. The node creation
       // function will be provided with the floating-point filter and
       // bias constants and will perform channel wise quantization.
-      if (auto *convNode = llvm::dyn_cast<ConvolutionNode>(Q->getInput())) {
+      // Convolutions with a precision only use channelwise quantization if
+      // it is ChannelwiseQuantized, the others if enabled for the Function.
+      auto *convNode = llvm::dyn_cast<ConvolutionNode>(Q->getInput());
+      if (convNode) {
+        const auto *P = quantConfig_.getNodePrecision(convNode->getName());
+        if (P ? *P != NodePrecision::ChannelwiseQuantized
+              : !quantConfig_.enableChannelwise) {
+          convNode = nullptr;
+        }
+      }
+      if (convNode) {
 
         NodeValue input = convNode->getInput();
         NodeValue filter = convNode->getFilter();
@@ -942,6 +977,47 @@ Node *replaceQuantizedSigmoidWithLookupTable(Function &F, const SigmoidNode &SN,
   return rescaleOutputNode->getResult();
 }
 
+Node *replaceQuantizedUnaryWithLookupTable(Function &F, const Node &node) {
+  NodeValue input = node.getNthInput(0);
+  NodeValue result = node.getNthResult(0);
+  TypeRef outTy = result.getType();
+  std::string name = node.getName().str() + ".lut";
+  IntLookupTableNode *ILT = nullptr;
+  switch (node.getKind()) {
+  case Kinded::Kind::HardSwishNodeKind:
+    ILT = F.createIntHardSwish(name, input, outTy);
+    break;
+  case Kinded::Kind::GeluNodeKind:
+    ILT = F.createIntGelu(name, input, outTy);
+    break;
+  case Kinded::Kind::SwishNodeKind:
+    ILT = F.createIntSwish(name, input, outTy);
+    break;
+  case Kinded::Kind::ErfNodeKind:
+    ILT = F.createIntErf(name, input, outTy);
+    break;
+  case Kinded::Kind::SigmoidNodeKind:
+    ILT = F.createIntSigmoid(name, input, outTy);
+    break;
+  case Kinded::Kind::TanhNodeKind:
+    ILT = F.createIntTanh(name, input, outTy);
+    break;
+  case Kinded::Kind::ExpNodeKind:
+    ILT = F.createIntExp(name, input, outTy);
+    break;
+  case Kinded::Kind::LogNodeKind:
+    if (input.getType()->getQuantizedValueRange().first < 0) {
+      return nullptr;
+    }
+    ILT = F.createIntLog(name, input, outTy);
+    break;
+  default:
+    return nullptr;
+  }
+  result.replaceAllUsesOfWith(ILT);
+  return ILT;
+}
+
 /// Helper which, given the output name \p currName of some node, looks for
 /// corresponding names in \p loweredMap which represent any names that this
 /// node was lowered from. If any are found then they are inserted into \p
@@ -1009,6 +1085,16 @@ generateNodeQuantizationInfos(Function *F,
                               const QuantizationConfiguration &quantConfig,
                               const LoweredInfoMap &loweredMap) {
   std::vector<NodeQuantizationInfo> quantizationInfos;
+
+  // Profile and quantization options of every entry of quantizationInfos.
+  struct QuantizationTask {
+    const TensorProfilingParams *TPP;
+    Schema schema;
+    ElemKind precision;
+    Calibration calibration;
+  };
+  std::vector<QuantizationTask> tasks;
+
   for (const auto &profilingInfo : quantConfig.infos) {
     // Get node value from node output name.
     std::string nodeOutputName = profilingInfo.nodeOutputName_;
@@ -1088,12 +1174,45 @@ generateNodeQuantizationInfos(Function *F,
       calibration = Calibration::None;
     }
 
-    // Compute the TensorQuantizationParams using the profiling information
-    // and the target precision and calibration.
-    TensorProfilingParams TPP = profilingInfo.tensorProfilingParams_;
-    TensorQuantizationParams TQP =
-        chooseQuantizationParams(TPP, schema, precision, calibration);
-    quantizationInfos.emplace_back(nodeOutputName, TQP);
+    // The TensorQuantizationParams are computed below using the profiling
+    // information and the target precision and calibration.
+    quantizationInfos.emplace_back(nodeOutputName, TensorQuantizationParams());
+    tasks.push_back({&profilingInfo.tensorProfilingParams_, schema, precision,
+                     calibration});
+  }
+
+  // The calibration of a tensor can take a while, so the tensors are
+  // calibrated on several threads. They are handed out one at a time, as only
+  // the calibrated ones take time.
+  auto runTask = [&](size_t i) {
+    const auto &task = tasks[i];
+    quantizationInfos[i].tensorQuantizationParams_ = chooseQuantizationParams(
+        *task.TPP, task.schema, task.precision, task.calibration);
+  };
+  size_t numCalibrated = std::count_if(
+      tasks.begin(), tasks.end(), [](const QuantizationTask &task) {
+        return task.calibration != Calibration::None;
+      });
+  size_t numThreads = std::min<size_t>(
+      numCalibrated, std::max(1u, std::thread::hardware_concurrency()));
+  if (numThreads <= 1) {
+    for (size_t i = 0, e = tasks.size(); i < e; i++) {
+      runTask(i);
+    }
+    return quantizationInfos;
+  }
+  std::atomic<size_t> nextTask{0};
+  ThreadPool pool(numThreads, "calibration");
+  std::vector<std::future<void>> futures;
+  for (size_t t = 0; t < numThreads; t++) {
+    futures.push_back(pool.submit([&]() {
+      for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+        runTask(i);
+      }
+    }));
+  }
+  for (auto &future : futures) {
+    future.wait();
   }
 
   return quantizationInfos;
@@ -1117,7 +1236,8 @@ void quantizeFunction(Function *F, const QuantizationConfiguration &quantConfig,
   }
 
   // Enable channelwise quantization for Convolution node.
-  if (quantConfig.enableChannelwise) {
+  if (quantConfig.enableChannelwise ||
+      quantConfig.hasNodePrecision(NodePrecision::ChannelwiseQuantized)) {
     quantizer.enableChannelwise();
   }
 }
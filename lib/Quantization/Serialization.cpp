@@ -19,13 +19,19 @@
 #include "glow/Quantization/Base/Base.h"
 #include "glow/Support/Support.h"
 
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/YAMLParser.h"
 #include "llvm/Support/YAMLTraits.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <glog/logging.h>
 
+#include <cstring>
+#include <fstream>
+
 /// Yaml serializer for the Glow tools version.
 LLVM_YAML_STRONG_TYPEDEF(std::string, YAMLGlowToolsVersion)
 
@@ -35,6 +41,17 @@ LLVM_YAML_STRONG_TYPEDEF(llvm::yaml::Hex64, YAMLGraphPreLowerHash)
 /// Yaml serializer for vector of NodeProfilingInfo.
 LLVM_YAML_IS_SEQUENCE_VECTOR(glow::NodeProfilingInfo);
 
+namespace {
+/// Precision of a node, as serialized to YAML.
+struct YAMLNodePrecision {
+  std::string nodeName;
+  glow::quantization::NodePrecision precision;
+};
+} // namespace
+
+/// Yaml serializer for vector of YAMLNodePrecision.
+LLVM_YAML_IS_SEQUENCE_VECTOR(YAMLNodePrecision);
+
 namespace llvm {
 namespace yaml {
 
@@ -105,11 +122,42 @@ template <> struct MappingTraits<glow::NodeProfilingInfo> {
   }
 };
 
+/// Mapping for NodePrecision yaml serializer.
+template <>
+struct ScalarEnumerationTraits<glow::quantization::NodePrecision> {
+  static void enumeration(IO &io, glow::quantization::NodePrecision &P) {
+    io.enumCase(P, "Quantized", glow::quantization::NodePrecision::Quantized);
+    io.enumCase(P, "ChannelwiseQuantized",
+                glow::quantization::NodePrecision::ChannelwiseQuantized);
+    io.enumCase(P, "FP16", glow::quantization::NodePrecision::FP16);
+    io.enumCase(P, "FP32", glow::quantization::NodePrecision::FP32);
+  }
+};
+
+/// Mapping for YAMLNodePrecision yaml serializer.
+template <> struct MappingTraits<YAMLNodePrecision> {
+  static void mapping(IO &io, YAMLNodePrecision &info) {
+    io.mapRequired("NodeName", info.nodeName);
+    io.mapRequired("Precision", info.precision);
+  }
+};
+
 } // end namespace yaml
 } // end namespace llvm
 
 namespace glow {
 
+namespace {
+/// Magic number at the start of the binary profile files.
+constexpr char binaryProfileMagic[] = {'G', 'L', 'O', 'W', 'P', 'R', 'O', 'F'};
+
+/// Version of the binary profile format.
+constexpr uint32_t binaryProfileVersion = 1;
+
+/// Extension of the file names the profiles are dumped to in binary.
+constexpr char binaryProfileExtension[] = ".bin";
+} // namespace
+
 void serializeProfilingInfosToYaml(
     llvm::StringRef fileName, llvm::hash_code graphPreLowerHash,
     std::vector<NodeProfilingInfo> &profilingInfos) {
@@ -185,4 +233,189 @@ bool deserializeProfilingInfosFromYaml(
   return true;
 }
 
+void serializeProfilingInfosToBinary(
+    llvm::StringRef fileName, llvm::hash_code graphPreLowerHash,
+    std::vector<NodeProfilingInfo> &profilingInfos) {
+  std::error_code EC;
+  llvm::raw_fd_ostream outputStream(fileName, EC, GET_FS_OPENFLAGS(F_None));
+  CHECK(!EC) << "Error opening binary profile file '" << fileName.str()
+             << "'!";
+  llvm::support::endian::Writer writer(outputStream, llvm::support::little);
+
+  // Write the header: magic number, format version, graph hash and number of
+  // profiling infos.
+  outputStream.write(binaryProfileMagic, sizeof(binaryProfileMagic));
+  writer.write<uint32_t>(binaryProfileVersion);
+  writer.write<uint64_t>(static_cast<uint64_t>(graphPreLowerHash));
+  writer.write<uint64_t>(profilingInfos.size());
+
+  // Write every profiling info as its name, min, max and histogram, each
+  // prefixed by its size where it has one.
+  for (const auto &PI : profilingInfos) {
+    writer.write<uint32_t>(PI.nodeOutputName_.size());
+    outputStream << PI.nodeOutputName_;
+    writer.write<float>(PI.min());
+    writer.write<float>(PI.max());
+    writer.write<uint32_t>(PI.histogram().size());
+    writer.write<float>(PI.histogram());
+  }
+}
+
+bool deserializeProfilingInfosFromBinary(
+    llvm::StringRef fileName, llvm::hash_code &graphPreLowerHash,
+    std::vector<NodeProfilingInfo> &profilingInfos) {
+
+  if (!llvm::sys::fs::exists(fileName)) {
+    return false;
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> bufferOrErr =
+      llvm::MemoryBuffer::getFile(fileName);
+  CHECK(!bufferOrErr.getError())
+      << "Unable to open file with name: " << fileName.str();
+  const char *cur = (*bufferOrErr)->getBufferStart();
+  const char *end = (*bufferOrErr)->getBufferEnd();
+
+  // Error message in case of incorrect profile format.
+  std::string profileErrMsg =
+      strFormat("Error reading binary profile file '%s'!", fileName.data());
+
+  // Readers of the fields of the profile, checking that they are not past the
+  // end of the file.
+  auto need = [&](size_t size) {
+    CHECK_LE(size, size_t(end - cur)) << profileErrMsg;
+  };
+  auto read32 = [&]() -> uint32_t {
+    need(sizeof(uint32_t));
+    uint32_t val = llvm::support::endian::read32le(cur);
+    cur += sizeof(uint32_t);
+    return val;
+  };
+  auto read64 = [&]() -> uint64_t {
+    need(sizeof(uint64_t));
+    uint64_t val = llvm::support::endian::read64le(cur);
+    cur += sizeof(uint64_t);
+    return val;
+  };
+
+  // Read the header.
+  need(sizeof(binaryProfileMagic));
+  CHECK(!memcmp(cur, binaryProfileMagic, sizeof(binaryProfileMagic)))
+      << profileErrMsg;
+  cur += sizeof(binaryProfileMagic);
+  const uint32_t version = read32();
+  CHECK_EQ(version, binaryProfileVersion)
+      << profileErrMsg << " Unsupported format version.";
+  graphPreLowerHash = llvm::hash_code(static_cast<size_t>(read64()));
+  const uint64_t numInfos = read64();
+
+  // Read the profiling infos. The histograms are copied as a whole when the
+  // host is little endian like the file.
+  profilingInfos.clear();
+  profilingInfos.reserve(numInfos);
+  for (uint64_t i = 0; i < numInfos; i++) {
+    profilingInfos.emplace_back();
+    NodeProfilingInfo &PI = profilingInfos.back();
+    const uint32_t nameSize = read32();
+    need(nameSize);
+    PI.nodeOutputName_.assign(cur, nameSize);
+    cur += nameSize;
+    PI.tensorProfilingParams_.min = llvm::BitsToFloat(read32());
+    PI.tensorProfilingParams_.max = llvm::BitsToFloat(read32());
+    const uint32_t histogramSize = read32();
+    need(size_t(histogramSize) * sizeof(float));
+    auto &histogram = PI.tensorProfilingParams_.histogram;
+    histogram.resize(histogramSize);
+    if (llvm::sys::IsLittleEndianHost) {
+      memcpy(histogram.data(), cur, histogramSize * sizeof(float));
+      cur += histogramSize * sizeof(float);
+    } else {
+      for (auto &val : histogram) {
+        val = llvm::BitsToFloat(read32());
+      }
+    }
+    CHECK_LE(PI.min(), PI.max())
+        << "Bad profile for node " << PI.nodeOutputName_.c_str();
+  }
+  CHECK(cur == end) << profileErrMsg;
+
+  return true;
+}
+
+void serializeProfilingInfos(llvm::StringRef fileName,
+                             llvm::hash_code graphPreLowerHash,
+                             std::vector<NodeProfilingInfo> &profilingInfos) {
+  if (llvm::sys::path::extension(fileName) == binaryProfileExtension) {
+    serializeProfilingInfosToBinary(fileName, graphPreLowerHash,
+                                    profilingInfos);
+  } else {
+    serializeProfilingInfosToYaml(fileName, graphPreLowerHash, profilingInfos);
+  }
+}
+
+bool deserializeProfilingInfos(llvm::StringRef fileName,
+                               llvm::hash_code &graphPreLowerHash,
+                               std::vector<NodeProfilingInfo> &profilingInfos) {
+  if (!llvm::sys::fs::exists(fileName)) {
+    return false;
+  }
+
+  // Binary profiles start with their magic number, which YAML can not.
+  char magic[sizeof(binaryProfileMagic)] = {};
+  {
+    std::ifstream file(fileName.str(), std::ios::binary);
+    file.read(magic, sizeof(magic));
+  }
+  if (!memcmp(magic, binaryProfileMagic, sizeof(magic))) {
+    return deserializeProfilingInfosFromBinary(fileName, graphPreLowerHash,
+                                               profilingInfos);
+  }
+  return deserializeProfilingInfosFromYaml(fileName, graphPreLowerHash,
+                                           profilingInfos);
+}
+
+void serializeNodePrecisions(
+    llvm::StringRef fileName,
+    const llvm::StringMap<quantization::NodePrecision> &nodePrecisions) {
+  std::error_code EC;
+  llvm::raw_fd_ostream outputStream(fileName, EC, GET_FS_OPENFLAGS(F_None));
+  CHECK(!EC) << "Error opening YAML file '" << fileName.str() << "'!";
+  llvm::yaml::Output yout(outputStream);
+
+  // Write the precisions sorted by node name, as StringMap is unordered.
+  std::vector<YAMLNodePrecision> precisions;
+  for (const auto &entry : nodePrecisions) {
+    precisions.push_back({entry.getKey().str(), entry.getValue()});
+  }
+  std::sort(precisions.begin(), precisions.end(),
+            [](const YAMLNodePrecision &a, const YAMLNodePrecision &b) {
+              return a.nodeName < b.nodeName;
+            });
+  yout << precisions;
+}
+
+bool deserializeNodePrecisions(
+    llvm::StringRef fileName,
+    llvm::StringMap<quantization::NodePrecision> &nodePrecisions) {
+  if (!llvm::sys::fs::exists(fileName)) {
+    return false;
+  }
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> text =
+      llvm::MemoryBuffer::getFileAsStream(fileName);
+  CHECK(!text.getError()) << "Unable to open file with name: "
+                          << fileName.str();
+  std::unique_ptr<llvm::MemoryBuffer> buffer = std::move(*text);
+  llvm::yaml::Input yin(buffer->getBuffer());
+
+  std::vector<YAMLNodePrecision> precisions;
+  yin >> precisions;
+  CHECK(!yin.error()) << strFormat("Error reading YAML file '%s'!",
+                                   fileName.data());
+  for (const auto &P : precisions) {
+    nodePrecisions[P.nodeName] = P.precision;
+  }
+  return true;
+}
+
 } // namespace glow
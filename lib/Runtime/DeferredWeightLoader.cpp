@@ -15,10 +15,81 @@
  */
 
 #include "glow/Runtime/DeferredWeightLoader.h"
+#include "glow/Support/ZipUtils.h"
+
+#include "llvm/Support/FileSystem.h"
+
+#include <cstring>
 
 namespace glow {
 namespace runtime {
 
+ZipDeferredWeightLoader::ZipDeferredWeightLoader() = default;
+
+ZipDeferredWeightLoader::~ZipDeferredWeightLoader() = default;
+
+Error ZipDeferredWeightLoader::setSrc(void *loaderObject) {
+  RETURN_ERR_IF_NOT(loaderObject, "No zip archive for the deferred weights",
+                    ErrorValue::ErrorCode::RUNTIME_DEFERRED_WEIGHT_ERROR);
+  const std::string path = static_cast<const char *>(loaderObject);
+  RETURN_ERR_IF_NOT(llvm::sys::fs::exists(path),
+                    strFormat("Can't find the deferred weights archive %s",
+                              path.c_str()),
+                    ErrorValue::ErrorCode::RUNTIME_DEFERRED_WEIGHT_ERROR);
+  weights_.clear();
+  zip_ = glow::make_unique<ZipReader>(path, /* mapFile */ true);
+  next_ = 0;
+  name_.clear();
+  return Error::success();
+}
+
+void ZipDeferredWeightLoader::setTypeInfo(std::map<std::string, Type> info) {
+  typeInfo_ = std::move(info);
+  names_.clear();
+  for (const auto &nameType : typeInfo_) {
+    names_.push_back(nameType.first);
+  }
+  next_ = 0;
+}
+
+Error ZipDeferredWeightLoader::loadNextWeight() {
+  RETURN_ERR_IF_NOT(zip_, "No zip archive for the deferred weights",
+                    ErrorValue::ErrorCode::RUNTIME_DEFERRED_WEIGHT_ERROR);
+  name_.clear();
+  // Skip the weights that are not in the archive, the Provisioner reports
+  // the static Placeholders left uninitialized.
+  while (next_ < names_.size() && !zip_->hasRecord(names_[next_])) {
+    next_++;
+  }
+  if (next_ == names_.size()) {
+    return Error::success();
+  }
+
+  const std::string &name = names_[next_++];
+  const Type &ty = typeInfo_.at(name);
+  // The view is valid as long as the reader, and the mapping of the archive
+  // is private so that the weights converted in place by the Provisioner do
+  // not modify the file.
+  llvm::MutableArrayRef<char> data = zip_->getMutableRecordView(name);
+  RETURN_ERR_IF_NOT(
+      data.size() == ty.getSizeInBytes(),
+      strFormat("Deferred weight %s has %zu bytes instead of %zu",
+                name.c_str(), data.size(), ty.getSizeInBytes()),
+      ErrorValue::ErrorCode::RUNTIME_DEFERRED_WEIGHT_ERROR);
+  weights_.emplace_back();
+  Tensor &T = weights_.back();
+  // ZipWriter aligns the data of the records to 64 bytes, which is enough for
+  // every element type.
+  if (reinterpret_cast<uintptr_t>(data.data()) % ty.getElementSize() == 0) {
+    T = Tensor(data.data(), &ty);
+  } else {
+    T.reset(ty);
+    memcpy(T.getUnsafePtr(), data.data(), data.size());
+  }
+  name_ = name;
+  return Error::success();
+}
+
 DeferredWeightLoader *DeferredWeightLoaderRegistry::getLoader() {
   return loader_;
 }
@@ -31,6 +31,25 @@ void DeviceHealthMonitorRegistry::revokeDeviceHealthMonitor(
                   monitors_.end());
 }
 
+void DeviceHealthMonitorRegistry::addListener(const void *owner,
+                                              DeviceHealthCB callback) {
+  std::lock_guard<std::mutex> lock(listenersLock_);
+  listeners_[owner] = std::move(callback);
+}
+
+void DeviceHealthMonitorRegistry::removeListener(const void *owner) {
+  std::lock_guard<std::mutex> lock(listenersLock_);
+  listeners_.erase(owner);
+}
+
+void DeviceHealthMonitorRegistry::reportDeviceHealth(unsigned deviceID,
+                                                     bool healthy) {
+  std::lock_guard<std::mutex> lock(listenersLock_);
+  for (auto &listener : listeners_) {
+    listener.second(deviceID, healthy);
+  }
+}
+
 std::shared_ptr<DeviceHealthMonitorRegistry>
 DeviceHealthMonitorRegistry::Monitors() {
   static auto monitors = std::make_shared<DeviceHealthMonitorRegistry>();
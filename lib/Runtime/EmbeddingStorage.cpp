@@ -0,0 +1,352 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/EmbeddingStorage.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+#include <llvm/Support/Casting.h>
+
+namespace glow {
+namespace runtime {
+
+/// Largest number of rows read at once, so that a long run of rows is split
+/// across the read threads.
+static constexpr size_t kMaxReadRows = 256;
+
+Expected<std::shared_ptr<EmbeddingTableFile>>
+EmbeddingTableFile::open(const std::string &fileName, size_t rowSize,
+                         size_t cacheRows, unsigned numReadThreads) {
+  RETURN_ERR_IF_NOT(rowSize, "Embedding table rows must not be empty");
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return MAKE_ERR(strFormat("Cannot open embedding table %s: %s",
+                              fileName.c_str(), strerror(errno)));
+  }
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size % rowSize) {
+    ::close(fd);
+    return MAKE_ERR(strFormat(
+        "Embedding table %s is not made of rows of %zu bytes",
+        fileName.c_str(), rowSize));
+  }
+#ifdef POSIX_FADV_RANDOM
+  // Lookups are random, readahead would only read rows nobody asked for.
+  posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+#endif
+  return std::shared_ptr<EmbeddingTableFile>(
+      new EmbeddingTableFile(fileName, fd, st.st_size / rowSize, rowSize,
+                             cacheRows, std::max(numReadThreads, 1u)));
+}
+
+EmbeddingTableFile::EmbeddingTableFile(const std::string &fileName, int fd,
+                                       size_t numRows, size_t rowSize,
+                                       size_t cacheRows,
+                                       unsigned numReadThreads)
+    : fileName_(fileName), fd_(fd), numRows_(numRows), rowSize_(rowSize),
+      cacheRows_(cacheRows), readPool_(numReadThreads, "EmbeddingTableFile"),
+      cacheData_(cacheRows * rowSize) {}
+
+EmbeddingTableFile::~EmbeddingTableFile() { ::close(fd_); }
+
+bool EmbeddingTableFile::readRange(uint64_t row, size_t numRows,
+                                   uint8_t *dst) {
+  size_t size = numRows * rowSize_;
+  off_t offset = row * rowSize_;
+  numReads_++;
+  while (size) {
+    ssize_t bytes = pread(fd_, dst, size, offset);
+    if (bytes < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytes <= 0) {
+      return false;
+    }
+    dst += bytes;
+    offset += bytes;
+    size -= bytes;
+  }
+  numRowsRead_ += numRows;
+  return true;
+}
+
+Error EmbeddingTableFile::readRows(llvm::ArrayRef<uint64_t> rows,
+                                   uint8_t *dst) {
+  // Positions in rows of the rows missing from the cache.
+  std::vector<size_t> misses;
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    for (size_t i = 0, e = rows.size(); i < e; i++) {
+      auto it = cache_.find(rows[i]);
+      if (it == cache_.end()) {
+        misses.push_back(i);
+        continue;
+      }
+      memcpy(dst + i * rowSize_, &cacheData_[it->second->second * rowSize_],
+             rowSize_);
+      lru_.splice(lru_.begin(), lru_, it->second);
+    }
+  }
+  numCacheHits_ += rows.size() - misses.size();
+
+  // Consecutive rows are also consecutive in dst since rows are sorted
+  // without duplicates, so each run of them is a single read.
+  std::vector<std::pair<size_t, size_t>> runs;
+  for (size_t i = 0, e = misses.size(); i < e;) {
+    size_t j = i + 1;
+    while (j < e && j - i < kMaxReadRows &&
+           rows[misses[j]] == rows[misses[j - 1]] + 1) {
+      j++;
+    }
+    runs.emplace_back(i, j);
+    i = j;
+  }
+  // Issue all the reads but the last one to the read threads, then read the
+  // last one on this thread.
+  std::vector<char> failed(runs.size(), 0);
+  std::vector<std::future<void>> reads;
+  for (size_t r = 0, e = runs.size(); r < e; r++) {
+    size_t first = misses[runs[r].first];
+    size_t numRows = runs[r].second - runs[r].first;
+    auto read = [this, &rows, &failed, dst, first, numRows, r]() {
+      failed[r] = !readRange(rows[first], numRows, dst + first * rowSize_);
+    };
+    if (r + 1 < e) {
+      reads.push_back(readPool_.submit(std::move(read)));
+    } else {
+      read();
+    }
+  }
+  for (auto &read : reads) {
+    read.wait();
+  }
+  if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+    return MAKE_ERR(strFormat("Failed to read embedding table %s",
+                              fileName_.c_str()));
+  }
+
+  if (!cacheRows_) {
+    return Error::success();
+  }
+  std::lock_guard<std::mutex> lock(cacheMutex_);
+  for (size_t i : misses) {
+    uint64_t row = rows[i];
+    if (cache_.count(row)) {
+      // Read by a concurrent request too.
+      continue;
+    }
+    size_t slot = lru_.size();
+    if (slot == cacheRows_) {
+      slot = lru_.back().second;
+      cache_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    memcpy(&cacheData_[slot * rowSize_], dst + i * rowSize_, rowSize_);
+    lru_.emplace_front(row, slot);
+    cache_[row] = lru_.begin();
+  }
+  return Error::success();
+}
+
+Error writeEmbeddingTableFile(const std::string &fileName,
+                              const Tensor &table) {
+  std::ofstream file(fileName, std::ios::binary);
+  file.write(table.getUnsafePtr(), table.getSizeInBytes());
+  file.close();
+  RETURN_ERR_IF_NOT(file, strFormat("Failed to write embedding table %s",
+                                    fileName.c_str()));
+  return Error::success();
+}
+
+/// Binds \p PH to the first \p size bytes of \p data, a tensor of the type
+/// of \p PH, which is moved into \p storage.
+static void rebind(PlaceholderBindings &bindings, Placeholder *PH,
+                   Tensor &&data, size_t size, std::vector<Tensor> &storage) {
+  storage.push_back(std::move(data));
+  bindings.erase(PH);
+  bindings.insert(
+      PH, Tensor(storage.back().getUnsafePtr(), PH->getType(), size));
+}
+
+/// Fetches the rows of \p table used by the indices of type \p T bound to
+/// \p indicesPH into a compact table bound to \p dataPH.
+template <class T>
+static Error fetchRows(EmbeddingTableFile &table, PlaceholderBindings &bindings,
+                       Placeholder *dataPH, Placeholder *indicesPH,
+                       std::vector<Tensor> &storage) {
+  const Tensor *indicesTensor = bindings.get(indicesPH);
+  const T *indices = reinterpret_cast<const T *>(indicesTensor->getUnsafePtr());
+  size_t numIndices = indicesTensor->getRealNumElements();
+
+  std::vector<uint64_t> rows(numIndices);
+  for (size_t i = 0; i < numIndices; i++) {
+    if (indices[i] < 0 || size_t(indices[i]) >= table.getNumRows()) {
+      return MAKE_ERR(strFormat(
+          "Indices sanitization failed on tensor %s: index %lld at pos %zu "
+          "is out of range [0, %zu)",
+          indicesPH->getName().str().c_str(), (long long)indices[i], i,
+          table.getNumRows()));
+    }
+    rows[i] = indices[i];
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+  Tensor data(dataPH->getType());
+  RETURN_IF_ERR(
+      table.readRows(rows, reinterpret_cast<uint8_t *>(data.getUnsafePtr())));
+  Tensor newIndices(indicesPH->getType());
+  T *newIndicesData = reinterpret_cast<T *>(newIndices.getUnsafePtr());
+  for (size_t i = 0; i < numIndices; i++) {
+    newIndicesData[i] =
+        std::lower_bound(rows.begin(), rows.end(), uint64_t(indices[i])) -
+        rows.begin();
+  }
+
+  size_t dataSize = data.getSizeInBytes();
+  rebind(bindings, dataPH, std::move(data), dataSize, storage);
+  rebind(bindings, indicesPH, std::move(newIndices), numIndices * sizeof(T),
+         storage);
+  return Error::success();
+}
+
+EmbeddingRowFetcher::EmbeddingRowFetcher(
+    std::shared_ptr<EmbeddingTableFile> table, Placeholder *dataPH,
+    Placeholder *indicesPH)
+    : table_(std::move(table)), dataPH_(dataPH), indicesPH_(indicesPH) {}
+
+Error EmbeddingRowFetcher::fetch(PlaceholderBindings &bindings,
+                                 std::vector<Tensor> &storage) {
+  auto *indices = bindings.get(indicesPH_);
+  RETURN_ERR_IF_NOT(indices, strFormat("Indices %s of embedding table %s "
+                                       "are not bound",
+                                       indicesPH_->getName().str().c_str(),
+                                       table_->getFileName().c_str()));
+  switch (indices->getElementType()) {
+  case ElemKind::Int32ITy:
+    return fetchRows<int32_t>(*table_, bindings, dataPH_, indicesPH_, storage);
+  case ElemKind::Int64ITy:
+    return fetchRows<int64_t>(*table_, bindings, dataPH_, indicesPH_, storage);
+  default:
+    return MAKE_ERR(strFormat(
+        "Embedding rows fetch failed on tensor %s: unsupported element type "
+        "%s",
+        indicesPH_->getName().str().c_str(),
+        Type::getElementName(indices->getElementType()).str().c_str()));
+  }
+}
+
+std::string EmbeddingRowFetcher::toString() {
+  std::ostringstream ss;
+  ss << "EmbeddingRowFetcher[";
+  ss << "file=" << table_->getFileName();
+  ss << ", data=" << dataPH_->getName().str();
+  ss << ", indices=" << indicesPH_->getName().str();
+  ss << "]";
+  return ss.str();
+}
+
+//
+// Public utility functions
+//
+Expected<std::vector<EmbeddingRowFetcherPtr>>
+getEmbeddingRowFetchers(const Function &function,
+                        const EmbeddingTableFileMap &tables) {
+  std::vector<EmbeddingRowFetcherPtr> result;
+
+  for (const auto &node : function.getNodes()) {
+    NodeValue data, indices;
+    if (auto *SLS =
+            llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumNode>(
+                &node)) {
+      data = SLS->getData();
+      indices = SLS->getIndices();
+    } else if (auto *SLS =
+                   llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsSumNode>(
+                       &node)) {
+      data = SLS->getData();
+      indices = SLS->getIndices();
+    } else if (auto *SLS = llvm::dyn_cast<SparseLengthsSumNode>(&node)) {
+      data = SLS->getData();
+      indices = SLS->getIndices();
+    } else if (auto *SLS =
+                   llvm::dyn_cast<SparseLengthsWeightedSumNode>(&node)) {
+      data = SLS->getData();
+      indices = SLS->getIndices();
+    } else if (auto *EBB = llvm::dyn_cast<EmbeddingBagNode>(&node)) {
+      data = EBB->getData();
+      indices = EBB->getIndices();
+    } else if (auto *EBB =
+                   llvm::dyn_cast<EmbeddingBagByteRowwiseOffsetsNode>(&node)) {
+      data = EBB->getData();
+      indices = EBB->getIndices();
+    } else {
+      continue;
+    }
+
+    auto *dataPH = llvm::dyn_cast<Placeholder>(data);
+    if (!dataPH) {
+      continue;
+    }
+    auto it = tables.find(dataPH->getName().str());
+    if (it == tables.end()) {
+      continue;
+    }
+    // Both inputs are rebound, so they must not be used by other nodes.
+    auto *indicesPH = llvm::dyn_cast<Placeholder>(indices);
+    RETURN_ERR_IF_NOT(
+        indicesPH && dataPH->hasOneUse() && indicesPH->hasOneUse(),
+        strFormat("Embedding table %s and its indices must be placeholders "
+                  "used by %s alone",
+                  dataPH->getName().str().c_str(),
+                  node.getName().str().c_str()));
+    TypeRef dataTy = dataPH->getType();
+    size_t rowSize = dataTy->getSizeInBytes() / dataTy->dims()[0];
+    RETURN_ERR_IF_NOT(
+        dataTy->dims()[0] >= indicesPH->dims()[0] &&
+            rowSize == it->second->getRowSize(),
+        strFormat("Embedding table %s must have rows of %zu bytes and at "
+                  "least as many rows as %s has indices",
+                  dataPH->getName().str().c_str(), it->second->getRowSize(),
+                  indicesPH->getName().str().c_str()));
+    result.push_back(
+        std::make_shared<EmbeddingRowFetcher>(it->second, dataPH, indicesPH));
+  }
+
+  return result;
+}
+
+Error fetchEmbeddingRows(const std::vector<EmbeddingRowFetcherPtr> &fetchers,
+                         PlaceholderBindings &bindings,
+                         std::vector<Tensor> &storage) {
+  for (auto &fetcher : fetchers) {
+    RETURN_IF_ERR(fetcher->fetch(bindings, storage));
+  }
+  return Error::success();
+}
+
+} // namespace runtime
+} // namespace glow
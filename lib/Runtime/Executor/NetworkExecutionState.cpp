@@ -16,6 +16,12 @@
 #include "glow/Runtime/Executor/NetworkExecutionState.h"
 #include "glow/Backends/DeviceManager.h"
 
+#include <algorithm>
+#include <glog/logging.h>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+
 using namespace glow;
 using namespace glow::runtime;
 
@@ -28,19 +34,274 @@ static void updateTensor(Tensor &tensor, const Tensor &seed) {
 }
 } // namespace
 
+namespace {
+/// Helpers for the tagged head of the NetworkExecutionStatePool free list.
+inline uint32_t headIndex(uint64_t head) { return head & 0xFFFFFFFF; }
+inline uint64_t makeHead(uint64_t oldHead, uint32_t index) {
+  return ((oldHead >> 32) + 1) << 32 | index;
+}
+} // namespace
+
+ExecutionPlan::ExecutionPlan(const DAGNode *root,
+                             const DeviceManagerMapTy &devices)
+    : root_(root), devices_(devices) {
+  // Number the nodes wave by wave, a node joining the wave after the one of
+  // its last parent.
+  std::unordered_map<const DAGNode *, unsigned> index;
+  std::unordered_map<const DAGNode *, unsigned> parentsDone;
+  std::vector<DAGNode *> wave;
+  auto releaseChildren = [&](const DAGNode *node,
+                             std::vector<DAGNode *> &nextWave) {
+    for (auto *child : node->children) {
+      if (++parentsDone[child] == child->parents.size()) {
+        nextWave.push_back(child);
+      }
+    }
+  };
+  releaseChildren(root, wave);
+  for (unsigned waveIdx = 0; !wave.empty(); waveIdx++) {
+    std::vector<DAGNode *> nextWave;
+    for (auto *node : wave) {
+      index.emplace(node, steps_.size());
+      Step step;
+      step.node = node;
+      step.wave = waveIdx;
+      step.numParents = node->parents.size();
+      {
+        std::lock_guard<std::mutex> lock(node->lock);
+        for (const auto &info : node->deviceRuntimeInfos) {
+          auto it = devices.find(info.first);
+          if (it != devices.end()) {
+            step.devices.emplace_back(info.first, it->second.get());
+          }
+        }
+      }
+      steps_.push_back(std::move(step));
+      releaseChildren(node, nextWave);
+    }
+    wave = std::move(nextWave);
+  }
+
+  for (auto &step : steps_) {
+    for (const auto *child : step.node->children) {
+      DCHECK(index.count(child)) << "DAG node " << child->name
+                                 << " doesn't have all its parents in the DAG";
+      step.children.push_back(index[child]);
+    }
+  }
+  for (const auto *node : root->children) {
+    rootSteps_.push_back(index[node]);
+  }
+}
+
+DeviceManager *ExecutionPlan::getDevice(unsigned idx, DeviceIDTy id) const {
+  for (const auto &device : steps_[idx].devices) {
+    if (device.first == id) {
+      return device.second;
+    }
+  }
+  auto it = devices_.find(id);
+  return it == devices_.end() ? nullptr : it->second.get();
+}
+
+NetworkExecutionStatePool::NetworkExecutionStatePool(
+    const DAGNode *root, const DeviceManagerMapTy &devices)
+    : plan_(root, devices),
+      statsExporterRegistry_(StatsExporterRegistry::Stats()) {}
+
+NetworkExecutionStatePool::~NetworkExecutionStatePool() {
+  flushStats();
+  // States hold pointers into the pipeline buffers, release them first.
+  states_.clear();
+  for (auto &slot : pipelineBuffers_) {
+    for (auto *buffer : slot) {
+      pipelineDevice_->freeAllocatedDeviceIOBuffer(buffer);
+    }
+  }
+}
+
 void NetworkExecutionStatePool::addNewState(
     std::unique_ptr<NetworkExecutionState> state) {
-
-  std::lock_guard<std::mutex> lock(stateLock_);
-  availableStates_.push_back(state.get());
+  DCHECK(&state->getPlan() == &plan_) << "State runs another plan";
+  state->pool_ = this;
+  state->poolIndex_ = states_.size();
+  bufferBytes_ += state->getBufferBytes();
+  nextFree_.emplace_back(0);
   states_.push_back(std::move(state));
+  returnNetworkExecutionState(states_.back().get());
+}
+
+NetworkExecutionState *NetworkExecutionStatePool::tryPop() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  while (headIndex(head) != 0) {
+    uint32_t idx = headIndex(head) - 1;
+    uint32_t next = nextFree_[idx].load(std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(head, makeHead(head, next),
+                                    std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      return states_[idx].get();
+    }
+  }
+  return nullptr;
+}
+
+NetworkExecutionState *
+NetworkExecutionStatePool::getNextNetworkExecutionState() {
+  if (auto *state = tryPop()) {
+    if (++numHits_ - flushedHits_ >= kStatsFlushInterval) {
+      flushStats();
+    }
+    return state;
+  }
+
+  // Other runs may be about to finish, give them a chance to return a state
+  // before refusing the request.
+  for (unsigned i = 0; i < kMaxAcquireRetries; i++) {
+    std::this_thread::yield();
+    if (auto *state = tryPop()) {
+      numMisses_++;
+      statsExporterRegistry_->incrementCounter(kStatePoolMisses);
+      return state;
+    }
+  }
+
+  numExhausted_++;
+  statsExporterRegistry_->incrementCounter(kStatePoolExhausted);
+  return nullptr;
+}
+
+void NetworkExecutionStatePool::returnNetworkExecutionState(
+    NetworkExecutionState *state) {
+  uint32_t idx = state->poolIndex_;
+  DCHECK(idx < states_.size() && states_[idx].get() == state)
+      << "State does not belong to this pool";
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  do {
+    nextFree_[idx].store(headIndex(head), std::memory_order_relaxed);
+  } while (!head_.compare_exchange_weak(head, makeHead(head, idx + 1),
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+void NetworkExecutionStatePool::createPipelineBuffers(const DAGNode *root,
+                                                      unsigned depth,
+                                                      DeviceManager *device) {
+  DCHECK(states_.empty()) << "Pipeline buffers must be created before states";
+  DCHECK(pipelineBuffers_.empty()) << "Pipeline buffers already created";
+  // Collect the nodes of the DAG and the Placeholders each of them outputs.
+  std::vector<const DAGNode *> nodes;
+  std::unordered_set<const DAGNode *> visited;
+  std::queue<const DAGNode *> bfsQueue;
+  bfsQueue.push(root);
+  while (!bfsQueue.empty()) {
+    const DAGNode *node = bfsQueue.front();
+    bfsQueue.pop();
+    for (const auto *child : node->children) {
+      if (visited.insert(child).second) {
+        nodes.push_back(child);
+        bfsQueue.push(child);
+      }
+    }
+  }
+
+  // A Placeholder written by one node and read by another is an
+  // intermediate, pass it through the pipeline buffers.
+  std::unordered_map<std::string, unsigned> numUsers;
+  std::unordered_set<std::string> outputs;
+  for (const auto *node : nodes) {
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      if (symbol.second.symbolCategory != SymbolCategory::Placeholder) {
+        continue;
+      }
+      numUsers[symbol.first]++;
+      if (symbol.second.output) {
+        outputs.insert(symbol.first);
+      }
+    }
+  }
+  for (const auto &name : outputs) {
+    if (numUsers[name] < 2) {
+      continue;
+    }
+    auto *PH = root->module->getPlaceholderByNameSlow(name);
+    DCHECK(PH) << "Placeholder: " << name << " is not in the module";
+    if (!PH->isStatic()) {
+      pipelinePlaceholders_.push_back(PH);
+    }
+  }
+  if (pipelinePlaceholders_.empty()) {
+    return;
+  }
+
+  pipelineDevice_ = device;
+  pipelineBuffers_.resize(depth);
+  for (unsigned slot = 0; slot < depth; slot++) {
+    for (auto *PH : pipelinePlaceholders_) {
+      pipelineBuffers_[slot].push_back(
+          device->allocateDeviceIOBuffer(PH->getType()->getSizeInBytes()));
+      bufferBytes_ += PH->getType()->getSizeInBytes();
+    }
+    freePipelineSlots_.push_back(depth - slot - 1);
+  }
+}
+
+bool NetworkExecutionStatePool::acquirePipelineBuffers(
+    NetworkExecutionState *state) {
+  unsigned slot;
+  {
+    std::lock_guard<std::mutex> lock(pipelineLock_);
+    if (freePipelineSlots_.empty()) {
+      pipelineWaiters_.push_back(state);
+      return false;
+    }
+    slot = freePipelineSlots_.back();
+    freePipelineSlots_.pop_back();
+  }
+  state->bindPipelineBuffers(slot, pipelineBuffers_[slot]);
+  return true;
 }
 
-NetworkExecutionState::NetworkExecutionState(const DAGNode *root,
+NetworkExecutionState *NetworkExecutionStatePool::releasePipelineBuffers(
+    NetworkExecutionState *state) {
+  const unsigned slot = state->getPipelineSlot();
+  NetworkExecutionState *next = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(pipelineLock_);
+    if (pipelineWaiters_.empty()) {
+      freePipelineSlots_.push_back(slot);
+      return nullptr;
+    }
+    next = pipelineWaiters_.front();
+    pipelineWaiters_.pop_front();
+  }
+  // Hand the set straight to the oldest waiter so it can't be starved.
+  next->bindPipelineBuffers(slot, pipelineBuffers_[slot]);
+  return next;
+}
+
+void NetworkExecutionStatePool::flushStats() {
+  uint64_t hits = numHits_.load();
+  uint64_t flushed = flushedHits_.load();
+  while (hits > flushed &&
+         !flushedHits_.compare_exchange_weak(flushed, hits)) {
+  }
+  if (hits > flushed) {
+    statsExporterRegistry_->incrementCounter(kStatePoolHits, hits - flushed);
+  }
+}
+
+NetworkExecutionState::NetworkExecutionState(const ExecutionPlan &plan,
                                              bool enableDRT, bool enableP2P,
                                              int64_t stateId)
-    : stateId_(stateId), enableDRT_(enableDRT), enableP2P_(enableP2P),
-      inflightNodes_(0), module_(root->module), root_(root) {}
+    : plan_(plan), stateId_(stateId), enableDRT_(enableDRT),
+      enableP2P_(enableP2P),
+      nodeParentsDone_(new std::atomic<unsigned>[plan.getSteps().size()]),
+      inflightNodes_(0), module_(plan.getRoot()->module),
+      root_(plan.getRoot()) {
+  for (size_t i = 0, e = plan.getSteps().size(); i < e; i++) {
+    nodeParentsDone_[i] = 0;
+  }
+}
 
 NetworkExecutionState::~NetworkExecutionState() {
   // Free all allocated buffers.
@@ -55,29 +316,53 @@ void NetworkExecutionState::bind(std::unique_ptr<ExecutionContext> resultCtx,
   cb_ = std::move(cb);
   runId_ = runId;
   // Reset execution state, inflight nodes, parents done, etc.
-  for (auto &count : nodeParentsDone_) {
-    count.second = 0;
+  for (size_t i = 0, e = intermediateContexts_.size(); i < e; i++) {
+    nodeParentsDone_[i].store(0, std::memory_order_relaxed);
   }
   inflightNodes_ = 0;
   // Setup tracing if desired.
   auto resultTraceContext = resultCtx_->getTraceContext();
   if (resultTraceContext) {
     for (auto &context : intermediateContexts_) {
-      context.second->setTraceContext(
+      context->setTraceContext(
           glow::make_unique<TraceContext>(resultTraceContext->getTraceLevel()));
     }
   } else {
     // Clear any trace context from a previous run.
     for (auto &context : intermediateContexts_) {
-      context.second->setTraceContext(nullptr);
+      context->setTraceContext(nullptr);
     }
   }
   // Configure to log perf data to the context if needed.
   if (resultCtx_->getPerfData() != nullptr) {
     for (auto &context : intermediateContexts_) {
-      context.second->setPerfData(resultCtx_->getPerfData());
+      context->setPerfData(resultCtx_->getPerfData());
+    }
+  }
+  // A pipelined run is only pointed at its IO once it holds a set of pipeline
+  // buffers, so the caller's bindings win over the pipeline buffers.
+  if (!isPipelined()) {
+    bindExternalIO();
+  }
+}
+
+void NetworkExecutionState::bindPipelineBuffers(
+    unsigned slot, llvm::ArrayRef<void *> buffers) {
+  DCHECK_EQ(buffers.size(), pipelinePlaceholders_.size());
+  pipelineSlot_ = slot;
+  for (size_t i = 0, e = buffers.size(); i < e; i++) {
+    for (auto &bindingIt : pipelinePlaceholders_[i]) {
+      Tensor &tensor = bindingIt->second;
+      if (auto *tensorPool = tensor.getOwningPool()) {
+        tensorPool->reclaim(std::move(tensor));
+      }
+      tensor = Tensor(buffers[i], bindingIt->first->getType());
     }
   }
+  bindExternalIO();
+}
+
+void NetworkExecutionState::bindExternalIO() {
   // Move inputs into tensors backing intermediate contexts.
   // Instead we point the tensors to the provided buffers to avoid copy in and
   // out. Once we have pinned allocations we will need to transfer.
@@ -128,36 +413,36 @@ void NetworkExecutionState::bind(std::unique_ptr<ExecutionContext> resultCtx,
 
 void NetworkExecutionState::init(
     const DeviceManagerMapTy &devices,
-    std::unordered_map<DAGNode *, DeviceIDTy> &staticAssignment) {
-  // Create a queue for the breadth-first traversal through the graph.
-  std::queue<DAGNode *> bfsQueue;
+    std::unordered_map<DAGNode *, DeviceIDTy> &staticAssignment,
+    llvm::ArrayRef<Placeholder *> pipelinePlaceholders) {
+  std::unordered_map<Placeholder *, size_t> pipelineIdx;
+  for (size_t i = 0, e = pipelinePlaceholders.size(); i < e; i++) {
+    pipelineIdx.emplace(pipelinePlaceholders[i], i);
+  }
+  pipelinePlaceholders_.resize(pipelinePlaceholders.size());
+
   // Marking the default err as checked so we don't get an unchecked error in
   // destructor if we never use this state.
   errContainer_.containsErr();
 
-  // Place the root nodes in the queue.
-  for (auto &node : root_->children) {
-    bfsQueue.push(node);
-    // Make a counter for the number of node parents done. This also is used for
-    // tracking if we've added the node already.
-    nodeParentsDone_[node] = 0;
-  }
-
-  // Breadth-first search.
-  while (!bfsQueue.empty()) {
-    // Get the next node in the BFS queue.
-    DAGNode *node = bfsQueue.front();
-    bfsQueue.pop();
-
-    // Push all unvisited children onto the BFS queue.
-    for (const auto &child : node->children) {
-      // Use nodeParentsDone_ as a set of nodes that have been visited already
-      // to avoid visiting a node more than once.
-      if (!nodeParentsDone_.count(child)) {
-        nodeParentsDone_[child] = 0;
-        bfsQueue.push(child);
+  // With DRT, collect the Placeholders some node outputs. All others are
+  // inputs of the run, which can be prefetched to the devices.
+  std::unordered_set<std::string> producedPlaceholders;
+  if (enableDRT_ && staticAssignment.size()) {
+    for (const auto &step : plan_.getSteps()) {
+      for (const auto &symbol : step.node->runtimeBundle->getSymbolTable()) {
+        if (symbol.second.output) {
+          producedPlaceholders.insert(symbol.first);
+        }
       }
     }
+  }
+
+  const auto steps = plan_.getSteps();
+  nodeOutputs_.resize(steps.size());
+  intermediateContexts_.reserve(steps.size());
+  for (size_t stepIdx = 0, e = steps.size(); stepIdx < e; stepIdx++) {
+    DAGNode *node = steps[stepIdx].node;
 
     // Make an (empty) context for the node.
     auto intermediateContext = glow::make_unique<ExecutionContext>();
@@ -167,12 +452,23 @@ void NetworkExecutionState::init(
       auto dm = devices.find(it->second)->second.get();
       intermediateContext->setBoundDeviceManager(dm);
     }
-    // Get a device to do allocation we can use the first device since the
-    // allocation is not device specific.
-    auto &device = devices.begin()->second;
+    // Allocate the IO buffers from the device the node is bound to, so that
+    // it can pin them for its transfers. Without an assignment use the first
+    // device, the allocation is then not device specific.
+    DeviceManager *device = intermediateContext->getBoundDeviceManager();
+    if (!device) {
+      device = devices.begin()->second.get();
+    }
 
     auto intermediatePHBindings = intermediateContext->getPlaceholderBindings();
 
+    // Nodes that run as soon as the run starts leave no time to prefetch.
+    DeviceManager *prefetchDevice = nullptr;
+    std::vector<PlaceholderBindings::PlaceholderMap::iterator> prefetchBindings;
+    if (enableDRT_ && staticAssignment.size() && steps[stepIdx].wave > 0) {
+      prefetchDevice = intermediateContext->getBoundDeviceManager();
+    }
+
     // Get the symbol table for the node.
     const SymbolTableTy &symbolTable = node->runtimeBundle->getSymbolTable();
 
@@ -188,6 +484,19 @@ void NetworkExecutionState::init(
         if (PH->isStatic()) {
           continue;
         }
+        if (symbolInfo.output) {
+          nodeOutputs_[stepIdx].push_back(PH);
+        }
+        // Intermediates passed through the pool's pipeline buffers are
+        // pointed at a buffer for every run in bindPipelineBuffers().
+        auto pipelineIt = pipelineIdx.find(PH);
+        if (pipelineIt != pipelineIdx.end()) {
+          auto itt = intermediatePHBindings->insert(
+              PH, Tensor(static_cast<void *>(nullptr), PH->getType()));
+          pipelinePlaceholders_[pipelineIt->second].push_back(itt);
+          addExternalPlaceholder(PH, itt);
+          continue;
+        }
         // If we haven't allocated a buffer for this PH yet do so, otherwise
         // reuse the allocation.
         // TODO: for intermediate placeholders in DRT/P2P cases, we don't need
@@ -197,37 +506,36 @@ void NetworkExecutionState::init(
           auto *deviceBuffer =
               device->allocateDeviceIOBuffer(PH->getType()->getSizeInBytes());
           buffers_[PH] = deviceBuffer;
-          deviceAllocations_.insert({deviceBuffer, device.get()});
+          bufferBytes_ += PH->getType()->getSizeInBytes();
+          deviceAllocations_.insert({deviceBuffer, device});
         }
         auto buffer = buffers_[PH];
         Tensor backingTensor(buffer, PH->getType());
         auto itt = intermediatePHBindings->insert(PH, std::move(backingTensor));
-        // TODO: Only add to externalPlaceholders_ of PH is external placeholder
-        auto idxIt = externalPlaceholdersIdx_.find(PH);
-        if (idxIt == externalPlaceholdersIdx_.end()) {
-          externalPlaceholdersIdx_.emplace(PH, externalPlaceholders_.size());
-          externalPlaceholders_.emplace_back();
-          auto &vec = externalPlaceholders_.back();
-          vec.push_back(itt);
-        } else {
-          auto &vec = externalPlaceholders_[idxIt->second];
-          vec.push_back(itt);
+        addExternalPlaceholder(PH, itt);
+        if (prefetchDevice && symbolInfo.input &&
+            !producedPlaceholders.count(symbolName)) {
+          prefetchBindings.push_back(itt);
         }
       }
     }
+    if (!prefetchBindings.empty()) {
+      prefetchInputs_.emplace_back(prefetchDevice, std::move(prefetchBindings));
+    }
 
-    // Insert the prepared ExecutionContext into the input contexts map.
-    intermediateContexts_.emplace(node, std::move(intermediateContext));
+    // Keep the prepared ExecutionContext at the index of the node.
+    intermediateContexts_.push_back(std::move(intermediateContext));
   }
   // If we used a static assignment call backend->bindContexts() on the new
   // contexts.
   if (staticAssignment.size()) {
     std::vector<runtime::ContextBinding> contexts;
-    for (auto &intermediate : intermediateContexts_) {
+    for (size_t stepIdx = 0, e = steps.size(); stepIdx < e; stepIdx++) {
+      auto &intermediate = intermediateContexts_[stepIdx];
       runtime::ContextBinding intermediateBinding;
-      intermediateBinding.context = intermediate.second.get();
-      intermediateBinding.networkName = intermediate.first->name;
-      intermediateBinding.device = intermediate.second->getBoundDeviceManager();
+      intermediateBinding.context = intermediate.get();
+      intermediateBinding.networkName = steps[stepIdx].node->name;
+      intermediateBinding.device = intermediate->getBoundDeviceManager();
       contexts.push_back(intermediateBinding);
     }
     const auto &backendName = devices.begin()->second->getBackendName();
@@ -242,21 +550,104 @@ void NetworkExecutionState::init(
   initialized_ = true;
 }
 
+void NetworkExecutionState::prefetchInputs() {
+  if (!prefetchSupported_) {
+    return;
+  }
+  for (auto &nodeInputs : prefetchInputs_) {
+    DeviceManager *device = nodeInputs.first;
+    for (auto &bindingIt : nodeInputs.second) {
+      Tensor &tensor = bindingIt->second;
+      if (tensor.isDeviceResident()) {
+        // Inputs left on another device move there directly, or staged on the
+        // host when the devices can't copy between them. They stay on the
+        // device after the run, like outputs and unlike prefetched inputs.
+        DeviceTensorTransferManager *owner = tensor.getDeviceManager();
+        if (owner != device) {
+          owner->transferToPeer(tensor, *device, [this](Error err) {
+            if (ERR_TO_BOOL(std::move(err))) {
+              prefetchSupported_ = false;
+            }
+          });
+        }
+        continue;
+      }
+      device->transferToDevice(tensor, /* locationContext */ nullptr,
+                               [this](Error err) {
+                                 if (ERR_TO_BOOL(std::move(err))) {
+                                   prefetchSupported_ = false;
+                                 }
+                               });
+      if (!prefetchSupported_) {
+        return;
+      }
+      prefetchedInputs_.emplace_back(device, &tensor);
+    }
+  }
+}
+
+void NetworkExecutionState::releasePrefetchedInputs() {
+  for (auto &prefetched : prefetchedInputs_) {
+    Tensor *tensor = prefetched.second;
+    // The device may have moved the tensor back to the host already.
+    if (tensor->isDeviceResident() &&
+        tensor->getDeviceManager() == prefetched.first) {
+      prefetched.first->releaseDeviceTensor(tensor->getLocationContext());
+      tensor->clearDeviceResidency();
+    }
+  }
+  prefetchedInputs_.clear();
+}
+
+void NetworkExecutionState::notifyOutputsReady(unsigned step) {
+  const auto &cb = resultCtx_->getOutputReadyCallback();
+  if (!cb) {
+    return;
+  }
+  // Intermediates aren't bound in the result context and are skipped.
+  auto &externalIOBindings = resultCtx_->getExternalIOBindings();
+  auto *resultPHBindings = resultCtx_->getPlaceholderBindings();
+  for (auto *PH : nodeOutputs_[step]) {
+    if (!externalIOBindings.empty()) {
+      for (auto &pair : externalIOBindings) {
+        if (pair.first == PH) {
+          cb(PH, pair.second);
+          break;
+        }
+      }
+    } else if (auto *tensor = resultPHBindings->get(PH)) {
+      cb(PH, *tensor);
+    }
+  }
+}
+
+void NetworkExecutionState::addExternalPlaceholder(
+    Placeholder *PH, PlaceholderBindings::PlaceholderMap::iterator binding) {
+  // TODO: Only add to externalPlaceholders_ of PH is external placeholder
+  auto idxIt = externalPlaceholdersIdx_.find(PH);
+  if (idxIt == externalPlaceholdersIdx_.end()) {
+    externalPlaceholdersIdx_.emplace(PH, externalPlaceholders_.size());
+    externalPlaceholders_.emplace_back();
+    externalPlaceholders_.back().push_back(binding);
+  } else {
+    externalPlaceholders_[idxIt->second].push_back(binding);
+  }
+}
+
 std::unique_ptr<ExecutionContext>
-NetworkExecutionState::getUniqueNodeContextPtr(const DAGNode *node) {
+NetworkExecutionState::getUniqueNodeContextPtr(unsigned step) {
   // The input PlaceholderBindings for the node should have been created in
-  // the constructor.
-  auto ctxIt = intermediateContexts_.find(node);
-
-  DCHECK(ctxIt != intermediateContexts_.end())
+  // init().
+  DCHECK(step < intermediateContexts_.size() && intermediateContexts_[step])
       << "Input bindings not found but should exist!";
-  ctxIt->second->setStateId(stateId_);
-  return std::move(ctxIt->second);
+  auto &ctx = intermediateContexts_[step];
+  ctx->setStateId(stateId_);
+  return std::move(ctx);
 }
 
 void NetworkExecutionState::returnUniqueNodeContextPtr(
-    const DAGNode *node, std::unique_ptr<ExecutionContext> ctx) {
-  intermediateContexts_[node] = std::move(ctx);
+    unsigned step, std::unique_ptr<ExecutionContext> ctx) {
+  intermediateContexts_[step] = std::move(ctx);
 }
 
 void NetworkExecutionState::incrementInflightNodes(unsigned increment) {
@@ -277,19 +668,19 @@ bool NetworkExecutionState::decrementInflightNodes(unsigned decrement) {
   return (previousValue == decrement);
 }
 
-bool NetworkExecutionState::incrementNodeParentsDone(const DAGNode *node,
+bool NetworkExecutionState::incrementNodeParentsDone(unsigned step,
                                                      unsigned increment) {
-  // Get the parents done counter for the node. It should have
-  // been created in the constructor.
-  auto it = nodeParentsDone_.find(node);
-
-  DCHECK(it != nodeParentsDone_.end())
-      << "Node parents done counter should exist but not found!";
+  unsigned numParents = plan_.getStep(step).numParents;
+  // The only parent of a node is done, no other thread can be updating it.
+  if (numParents == 1) {
+    DCHECK_EQ(increment, 1) << "Node parents done counter incremented beyond "
+                               "limit!";
+    return true;
+  }
 
   // fetch_add must be used here so that the function returns true to only
   // one caller.
-  unsigned numParents = (node->parents).size();
-  unsigned previousValue = (it->second).fetch_add(increment);
+  unsigned previousValue = nodeParentsDone_[step].fetch_add(increment);
   unsigned newValue = previousValue + increment;
 
   // The new value of the counter cannot exceed the number of parents that
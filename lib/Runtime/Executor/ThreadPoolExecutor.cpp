@@ -17,12 +17,14 @@
 #include "glow/Runtime/Executor/ThreadPoolExecutor.h"
 #include "glow/Backends/DeviceManager.h"
 #include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/TraceAnalysis.h"
 #include "glow/Flags/Flags.h"
 #include "glow/Runtime/ErrorReporter.h"
 
 #include <queue>
 #include <unordered_set>
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/FormatVariadic.h"
 #include <glog/logging.h>
 
@@ -61,10 +63,25 @@ void InflightBarrier::wait() {
 
 ThreadPoolExecutor::ThreadPoolExecutor(const DeviceManagerMapTy &deviceManagers,
                                        unsigned numWorkers,
-                                       const std::string &name)
-    : threadPool_(numWorkers,
-                  std::make_shared<folly::NamedThreadFactory>(name)),
-      deviceManagers_(deviceManagers) {}
+                                       const std::string &name,
+                                       bool workStealing)
+    : deviceManagers_(deviceManagers) {
+  if (workStealing) {
+    workStealingPool_ =
+        glow::make_unique<WorkStealingThreadPool>(numWorkers, name);
+  } else {
+    threadPool_ = glow::make_unique<folly::CPUThreadPoolExecutor>(
+        numWorkers, std::make_shared<folly::NamedThreadFactory>(name));
+  }
+}
+
+void ThreadPoolExecutor::schedule(folly::Func fn) {
+  if (workStealingPool_) {
+    workStealingPool_->add(std::move(fn));
+  } else {
+    threadPool_->add(std::move(fn));
+  }
+}
 
 void ThreadPoolExecutor::shutdown() {
   // Prevent more requests from being processed.
@@ -75,8 +92,13 @@ void ThreadPoolExecutor::shutdown() {
   // handleDeviceManagerResult().
   inflightBarrier_.wait();
 
-  threadPool_.stop();
-  threadPool_.join();
+  if (workStealingPool_) {
+    workStealingPool_->stop();
+    workStealingPool_->join();
+  } else {
+    threadPool_->stop();
+    threadPool_->join();
+  }
 }
 
 void ThreadPoolExecutor::run(const DAGNode *root,
@@ -116,15 +138,27 @@ void ThreadPoolExecutor::run(const DAGNode *root,
     return;
   }
 
-  auto numChildren = (root->children).size();
+  // Get and bind state.
+  auto *pool = states_.rlock()->at(root).get();
+  auto currentState = pool->getNextNetworkExecutionState();
+  if (!currentState) {
+    TRACE_EVENT_TAG_END(traceContext, TraceLevel::RUNTIME,
+                        "ThreadPoolExecutor::run", eventTag);
+    cb(runId,
+       MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
+                "ThreadPoolExecutor has no free execution state for network " +
+                    root->name),
+       std::move(context));
+    return;
+  }
+
+  auto numChildren = pool->getPlan().getRootSteps().size();
   // Mark the child nodes as "inflight" (i.e. currently executing). This must
   // be done here instead of inside executeDAGNode() so that a node can be
   // executed while placeholders are being propagated for the next node
   // without the callback for that node deleting the execution state.
   inflightBarrier_.increment(numChildren);
 
-  // Get and bind state.
-  auto currentState = states_.rlock()->at(root)->getNextNetworkExecutionState();
   TRACE_EVENT_TAG_BEGIN(traceContext, TraceLevel::RUNTIME,
                         "bind network execution state", eventTag);
 
@@ -138,14 +172,64 @@ void ThreadPoolExecutor::run(const DAGNode *root,
   // trace context.
   TRACE_EVENT_TAG_END(traceContext, TraceLevel::RUNTIME,
                       "ThreadPoolExecutor::run", eventTag);
-  for (auto const &node : root->children) {
+  // A pipelined run waits for a set of pipeline buffers, it is started by the
+  // run that frees one up.
+  if (pool->hasPipelineBuffers() &&
+      !pool->acquirePipelineBuffers(currentState)) {
+    return;
+  }
+  startRun(currentState);
+}
+
+void ThreadPoolExecutor::startRun(NetworkExecutionState *state) {
+  // Overlap the transfers of later partitions' inputs with the first ones.
+  if (glow::runtime::flags::DRTPrefetchInputs) {
+    state->prefetchInputs();
+  }
+  for (unsigned step : state->getPlan().getRootSteps()) {
     // Run with cached state
-    executeDAGNode(currentState, node);
+    executeDAGNode(state, step);
+  }
+}
+
+/// Logs the RequestTraceAnalysis event of the partition \p node of run
+/// \p runId into the trace of its result context \p ctx, as the
+/// DeviceManager returns it. The partition was dispatched at
+/// \p dispatchStartTime and handed to \p device at \p deviceStartTime.
+static void logPartitionEvent(ExecutionContext *ctx, RunIdentifierTy runId,
+                              const DAGNode *node, DeviceIDTy device,
+                              uint64_t dispatchStartTime,
+                              uint64_t deviceStartTime) {
+  TraceContext *traceContext = ctx ? ctx->getTraceContext() : nullptr;
+  if (!traceContext || !traceContext->shouldLog(TraceLevel::REQUEST)) {
+    return;
   }
+  std::vector<llvm::StringRef> parents;
+  for (const DAGNode *parent : node->parents) {
+    // The root of the DAG is not a partition.
+    if (!parent->parents.empty()) {
+      parents.push_back(parent->name);
+    }
+  }
+  uint64_t transfer =
+      RequestTraceAnalysis::getCopyTime(traceContext->getTraceEvents());
+  traceContext->logTraceEvent(TraceEvent(
+      RequestTraceAnalysis::kPartitionEvent, TraceLevel::REQUEST,
+      dispatchStartTime, TraceEvent::now() - dispatchStartTime,
+      threads::getThreadId(),
+      {{"request", std::to_string(runId)},
+       {"node", node->name},
+       {"parents", llvm::join(parents.begin(), parents.end(), ",")},
+       {"device", std::to_string(device)},
+       {"dispatch", std::to_string(deviceStartTime - dispatchStartTime)},
+       {"transfer", std::to_string(transfer)}}));
 }
 
 void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
-                                        DAGNode *node) {
+                                        unsigned step) {
+  uint64_t dispatchStartTime = TraceEvent::now();
+  const ExecutionPlan &plan = executionState->getPlan();
+  DAGNode *node = plan.getStep(step).node;
   std::string traceScopeStr;
   auto traceContext =
       executionState->getRawResultContextPtr()->getTraceContext();
@@ -165,6 +249,19 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
       executionState->getRawResultContextPtr()->getTraceContext(),
       TraceLevel::RUNTIME, traceScopeStr, eventTag);
 
+  // Skip the nodes of a cancelled run as if they failed, so that the run
+  // completes as soon as the nodes already on a device are done.
+  auto *runCtx = executionState->getRawResultContextPtr();
+  if (runCtx->isCancelled()) {
+    TRACE_EVENT_SCOPE_END();
+    handleDeviceManagerResult(
+        executionState,
+        MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_CANCELLED,
+                 "Run cancelled before running " + node->name),
+        executionState->getUniqueNodeContextPtr(step), step);
+    return;
+  }
+
   if (executionState->getErrorContainer().containsErr()) {
     // Mark the node as no longer executing.
     executionState->decrementInflightNodes();
@@ -174,7 +271,10 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
 
   // Get the PlaceholderBindings containing all of the inputs for the node.
   std::unique_ptr<ExecutionContext> nodeCtx =
-      executionState->getUniqueNodeContextPtr(node);
+      executionState->getUniqueNodeContextPtr(step);
+  // Let the DeviceManager drop the node if the run is cancelled while it is
+  // queued on the device.
+  nodeCtx->setCancellationToken(runCtx->getCancellationToken());
   if (tracingEnabled) {
     nodeCtx->getTraceContext()->setTracePerspectiveData(
         traceContext->getTracePerspectiveData());
@@ -190,11 +290,15 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
   TRACE_EVENT_TAG_BEGIN(
       executionState->getRawResultContextPtr()->getTraceContext(),
       TraceLevel::RUNTIME, traceNodeChildCreateStr, eventTag);
-  // Get the DeviceManager that can run the node.
-  auto currentDevice = node->getNextDevice();
-  auto deviceManagerIt = deviceManagers_.find(currentDevice);
-
-  if (deviceManagerIt == deviceManagers_.end()) {
+  // Get the DeviceManager that can run the node, the least loaded of the
+  // devices of its replicas. The plan resolved them when it was built.
+  auto currentDevice = node->getNextDevice([&plan, step](DeviceIDTy id) {
+    DeviceManager *device = plan.getDevice(step, id);
+    return device ? device->getNumOutstandingRuns() : uint64_t(0);
+  });
+  DeviceManager *deviceManager = plan.getDevice(step, currentDevice);
+
+  if (!deviceManager) {
     // Mark the node as no longer executing.
     executionState->getErrorContainer().set(
         MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_DEVICE_NOT_FOUND,
@@ -203,7 +307,6 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
     inflightBarrier_.decrement();
     return;
   }
-  DeviceManager *deviceManager = deviceManagerIt->second.get();
   // If the context has a deviceManager bound use that instead.
   if (nodeCtx->getBoundDeviceManager()) {
     deviceManager = nodeCtx->getBoundDeviceManager();
@@ -216,12 +319,31 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
       executionState->getRawResultContextPtr()->getTraceContext(),
       TraceLevel::RUNTIME, traceNodeChildCreateStr, eventTag);
   TRACE_EVENT_SCOPE_END();
+  // A network without replicas on a device always runs under its own name.
+  std::string functionName = node->replicationCount > 1
+                                 ? node->getNextName(currentDevice)
+                                 : node->name;
+  // The result of the only node of a network has no children to dispatch, it
+  // can be handled on the DeviceManager thread if asked to.
+  bool handleInline = glow::flags::ExecutorInlineSingleNode &&
+                      plan.getSteps().size() == 1;
   // Run the node using the DeviceManager.
+  uint64_t deviceStartTime = TraceEvent::now();
   deviceManager->runFunction(
-      node->getNextName(currentDevice), std::move(nodeCtx),
-      [this, executionState, currentDevice,
-       node](RunIdentifierTy id, Error err,
-             std::unique_ptr<ExecutionContext> resultCtx) {
+      std::move(functionName), std::move(nodeCtx),
+      [this, executionState, currentDevice, node, step, handleInline,
+       dispatchStartTime,
+       deviceStartTime](RunIdentifierTy id, Error err,
+                        std::unique_ptr<ExecutionContext> resultCtx) {
+        node->deviceLatency.record(TraceEvent::now() - deviceStartTime);
+        logPartitionEvent(resultCtx.get(), executionState->getRunId(), node,
+                          currentDevice, dispatchStartTime, deviceStartTime);
+        if (handleInline) {
+          node->markFinished(currentDevice);
+          this->handleDeviceManagerResult(executionState, std::move(err),
+                                          std::move(resultCtx), step);
+          return;
+        }
         if (!glow::flags::useInferencePerspectiveTrace) {
           TRACE_EVENT_LOG_ID(resultCtx->getTraceContext(), TraceLevel::REQUEST,
                              "handle result queuing",
@@ -230,9 +352,8 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
 
         // Immediately move the handling of the result onto this run's executor
         // to avoid doing work on the DeviceManager thread.
-        threadPool_.add([this, executionState, node, err = std::move(err),
-                         currentDevice, id,
-                         ctx = std::move(resultCtx)]() mutable {
+        schedule([this, executionState, node, step, err = std::move(err),
+                  currentDevice, id, ctx = std::move(resultCtx)]() mutable {
           if (!glow::flags::useInferencePerspectiveTrace) {
             TRACE_EVENT_LOG_ID(ctx->getTraceContext(), TraceLevel::REQUEST,
                                "handle result queuing",
@@ -240,14 +361,14 @@ void ThreadPoolExecutor::executeDAGNode(NetworkExecutionState *executionState,
           }
           node->markFinished(currentDevice);
           this->handleDeviceManagerResult(executionState, std::move(err),
-                                          std::move(ctx), node);
+                                          std::move(ctx), step);
         });
       });
 }
 
 void ThreadPoolExecutor::handleDeviceManagerResult(
     NetworkExecutionState *executionState, Error err,
-    std::unique_ptr<ExecutionContext> ctx, const DAGNode *node) {
+    std::unique_ptr<ExecutionContext> ctx, unsigned step) {
   TraceContext *traceContext = ctx->getTraceContext();
   size_t eventTag = threads::getThreadId();
   if (traceContext && glow::flags::useInferencePerspectiveTrace) {
@@ -267,7 +388,11 @@ void ThreadPoolExecutor::handleDeviceManagerResult(
   // If the DeviceManager executed the node, propagate its output Placeholders
   // to its children or the result PlaceholderBindings as appropriate.
   if (runWasSuccess) {
-    for (auto &child : node->children) {
+    executionState->notifyOutputsReady(step);
+    const auto &children = executionState->getPlan().getStep(step).children;
+    // Index of the ready child run by this thread with work stealing, or -1.
+    int inlineChild = -1;
+    for (unsigned child : children) {
       // Execute any child that has no parent nodes left to execute.
       bool childReadyToExecute =
           executionState->incrementNodeParentsDone(child);
@@ -275,9 +400,23 @@ void ThreadPoolExecutor::handleDeviceManagerResult(
         // Mark the node as "inflight" (i.e. currently executing).
         executionState->incrementInflightNodes();
         inflightBarrier_.increment();
-        executeDAGNode(executionState, child);
+        if (!workStealingPool_) {
+          executeDAGNode(executionState, child);
+          continue;
+        }
+        // With work stealing, keep one ready child for this thread and push
+        // the rest onto this worker's deque where idle workers can take them.
+        if (inlineChild >= 0) {
+          schedule([this, executionState, inlineChild]() {
+            executeDAGNode(executionState, inlineChild);
+          });
+        }
+        inlineChild = child;
       }
     }
+    if (inlineChild >= 0) {
+      executeDAGNode(executionState, inlineChild);
+    }
   } else if (err && err.peekErrorValue() &&
              err.peekErrorValue()->isFatalError()) {
     std::string msg = err.peekErrorValue()->logToString();
@@ -289,7 +428,7 @@ void ThreadPoolExecutor::handleDeviceManagerResult(
   }
 
   // Return intermediateContext to executionState.
-  executionState->returnUniqueNodeContextPtr(node, std::move(ctx));
+  executionState->returnUniqueNodeContextPtr(step, std::move(ctx));
 
   // This needs to happen before decrementInflightNodes(). Otherwise a race
   // condition can happen where two threads call into this function at the same
@@ -324,11 +463,20 @@ void ThreadPoolExecutor::handleDeviceManagerResult(
     auto runId = executionState->getRunId();
     auto err = executionState->getErrorContainer().get();
     auto resultCtx = executionState->getUniqueResultContextPtr();
-    states_.rlock()
-        ->at(executionState->getRoot())
-        ->returnNetworkExecutionState(executionState);
+    auto *pool = executionState->getPool();
+    executionState->releasePrefetchedInputs();
+    NetworkExecutionState *nextState = nullptr;
+    if (executionState->isPipelined()) {
+      nextState = pool->releasePipelineBuffers(executionState);
+    }
+    pool->returnNetworkExecutionState(executionState);
 
     cb(runId, std::move(err), std::move(resultCtx));
+
+    // Start the run that was waiting for this run's pipeline buffers.
+    if (nextState) {
+      startRun(nextState);
+    }
   }
 
   // Decrement the inflight barrier for the executor keeping track of all
@@ -341,7 +489,8 @@ void ThreadPoolExecutor::handleDeviceManagerResult(
 }
 
 void ThreadPoolExecutor::createPool(const DAGNode *root, unsigned poolSize,
-                                    bool enableP2P, bool enableDRT) {
+                                    bool enableP2P, bool enableDRT,
+                                    unsigned pipelineDepth) {
   std::unordered_map<DAGNode *, DeviceIDTy> assignment;
 
   // For static assignment we need to track devices each node is assigned to.
@@ -373,10 +522,15 @@ void ThreadPoolExecutor::createPool(const DAGNode *root, unsigned poolSize,
   }
 
   std::unique_ptr<NetworkExecutionStatePool> pool =
-      glow::make_unique<NetworkExecutionStatePool>();
+      glow::make_unique<NetworkExecutionStatePool>(root, deviceManagers_);
+  // P2P and DRT keep intermediates on the devices, there's nothing to share.
+  if (pipelineDepth && !enableP2P && !enableDRT) {
+    pool->createPipelineBuffers(root, pipelineDepth,
+                                deviceManagers_.begin()->second.get());
+  }
   for (unsigned i = 0; i < poolSize; i++) {
-    auto newState =
-        glow::make_unique<NetworkExecutionState>(root, enableDRT, enableP2P, i);
+    auto newState = glow::make_unique<NetworkExecutionState>(
+        pool->getPlan(), enableDRT, enableP2P, i);
     // If assignStatic, calculate the device assignments for this
     // executionState. For now we are assigning a round robin pattern per node.
     if (enableDRT || enableP2P) {
@@ -388,7 +542,8 @@ void ThreadPoolExecutor::createPool(const DAGNode *root, unsigned poolSize,
         currentAssignment[it.first] = newAssignmentIdx;
       }
     }
-    newState->init(deviceManagers_, assignment);
+    newState->init(deviceManagers_, assignment,
+                   pool->getPipelinePlaceholders());
     pool->addNewState(std::move(newState));
   }
 
@@ -400,5 +555,11 @@ void ThreadPoolExecutor::freePool(const DAGNode *root) {
   states_.wlock()->erase(root);
 }
 
+uint64_t ThreadPoolExecutor::getBufferBytes(const DAGNode *root) const {
+  auto states = states_.rlock();
+  auto it = states->find(root);
+  return it == states->end() ? 0 : it->second->getBufferBytes();
+}
+
 } // namespace runtime
 } // namespace glow
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/HostManager/ExecutionContextPool.h"
+#include "glow/Backends/DeviceManager.h"
+#include "glow/Graph/PlaceholderBindings.h"
+
+#include <glog/logging.h>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+/// \returns the allocation function of the IO buffers of \p device, none if
+/// \p device is null.
+TensorPool::BufferAllocFn getIOBufferAllocFn(DeviceManager *device) {
+  if (!device) {
+    return nullptr;
+  }
+  return [device](size_t size) {
+    return device->allocateDeviceIOBuffer(size);
+  };
+}
+
+/// \returns the function freeing the IO buffers of \p device, none if \p
+/// device is null.
+TensorPool::BufferFreeFn getIOBufferFreeFn(DeviceManager *device) {
+  if (!device) {
+    return nullptr;
+  }
+  return [device](void *buffer) {
+    device->freeAllocatedDeviceIOBuffer(buffer);
+  };
+}
+} // namespace
+
+ExecutionContextPool::ExecutionContextPool(std::shared_ptr<Module> module,
+                                           size_t count, DeviceManager *device)
+    : module_(std::move(module)),
+      tensorPool_(getIOBufferAllocFn(device), getIOBufferFreeFn(device)) {
+  for (auto *PH : module_->getPlaceholders()) {
+    // Static Placeholders are bound once for all the runs.
+    if (PH->isStatic()) {
+      continue;
+    }
+    placeholders_.push_back(PH);
+    tensorPool_.reserve(PH->getType(), count);
+  }
+}
+
+std::unique_ptr<ExecutionContext> ExecutionContextPool::get() {
+  auto context = glow::make_unique<ExecutionContext>();
+  auto *bindings = context->getPlaceholderBindings();
+  bindings->pairs().reserve(placeholders_.size());
+  for (auto *PH : placeholders_) {
+    auto T = tensorPool_.get(PH->getType());
+    DCHECK(T.hasValue()) << "Tensor pool could not allocate a tensor";
+    if (PH->allocZero()) {
+      T->zero();
+    }
+    bindings->insert(PH, std::move(T.getValue()));
+  }
+  return context;
+}
@@ -16,9 +16,11 @@
 
 #include "glow/Runtime/HostManager/HostManager.h"
 #include "glow/Backends/DeviceManager.h"
+#include "glow/ExecutionContext/TraceAnalysis.h"
 #include "glow/Exporter/ONNXModelWriter.h"
 #include "glow/Flags/Flags.h"
 #include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Importer/ONNXModelLoader.h"
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
 #include "glow/Partitioner/Partitioner.h"
 #include "glow/Runtime/DeferredWeightLoader.h"
@@ -28,11 +30,14 @@
 #include "glow/Runtime/Provisioner/Provisioner.h"
 #include "glow/Runtime/RequestData.h"
 #include "glow/Runtime/RuntimeTypes.h"
+#include "glow/Runtime/TraceExporter.h"
 #include "glow/Support/Support.h"
+#include "glow/Support/ZipUtils.h"
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/Path.h"
 
 #include <glog/logging.h>
 
@@ -40,9 +45,13 @@
 #include "folly/executors/CPUThreadPoolExecutor.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <fstream>
 #include <future>
 #include <queue>
 #include <shared_mutex>
+#include <sstream>
+#include <thread>
 
 constexpr uint64_t P2PInputLimit = 256;
 using namespace glow;
@@ -56,6 +65,130 @@ llvm::cl::opt<std::string> loadBackendSpecificOptionsOpt(
     llvm::cl::desc("Load backend-specific options for compilation."),
     llvm::cl::value_desc("options.yaml"), llvm::cl::Optional,
     llvm::cl::cat(hostManagerCat));
+
+/// A one-shot event that a thread blocking on a run waits for. It lives on the
+/// stack of the waiter, unlike the shared state of a std::promise.
+class RunLatch {
+public:
+  void set() {
+    // Notify under the lock, so the waiter can't return and destroy the latch
+    // before notify_one is done.
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    cv_.notify_one();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return done_; });
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool done_{false};
+};
+
+/// Files of a network snapshot. The DAG is an ONNX model in zip mode whose
+/// records are stored uncompressed and aligned, and the compiled functions
+/// are in another zip archive, one record per partition.
+constexpr const char *kSnapshotDAGFile = "dag.zip";
+constexpr const char *kSnapshotFunctionsFile = "functions.zip";
+
+/// \returns the path of the file \p file of the snapshot in \p dir.
+std::string getSnapshotPath(llvm::StringRef dir, llvm::StringRef file) {
+  llvm::SmallString<128> path(dir);
+  llvm::sys::path::append(path, file);
+  return path.str().str();
+}
+
+/// Write the optimized and partitioned \p nodeList with its Constants and
+/// the constant folding \p record to the snapshot in \p dir.
+Error writeSnapshotDAG(llvm::StringRef dir, DAGListTy &nodeList,
+                       const ConstantFoldingRecordMap &record,
+                       const CompilationContext &cctx) {
+  RETURN_ERR_IF_NOT(nodeList.size() == 1,
+                    "Network snapshots support a single DAG.");
+  std::error_code EC = llvm::sys::fs::create_directories(dir);
+  RETURN_ERR_IF_NOT(!EC, "Failed to create network snapshot directory " +
+                             dir.str() + ": " + EC.message());
+  llvm::StringMap<std::string> extraMetadataProps;
+  if (cctx.precisionConfig.originNameToTQPMap) {
+    RETURN_IF_ERR(ONNXModelWriter::insertLoaderNameUniqueOffsetMetadata(
+        extraMetadataProps, *cctx.precisionConfig.originNameToTQPMap));
+  }
+  if (cctx.precisionConfig.clipQuantRangeToFP16) {
+    extraMetadataProps[clipQuantRangeToFP16Key] = "1";
+  }
+  Error writeErr = Error::empty();
+  ONNXModelWriter onnxWR(getSnapshotPath(dir, kSnapshotDAGFile), nodeList, 7,
+                         9, &writeErr, /* textMode */ false,
+                         /* zipMode */ true, /* includeConstantData */ true,
+                         extraMetadataProps, record,
+                         cctx.backendOpts.backendSpecificNodeInfo);
+  return writeErr;
+}
+
+/// Write the compiled functions of the partitions of \p nodeList provisioned
+/// by \p provisioner to the snapshot in \p dir. Nothing is written unless
+/// the backends serialize all of them.
+Error writeSnapshotFunctions(llvm::StringRef dir, DAGListTy &nodeList,
+                             Provisioner &provisioner) {
+  std::vector<std::pair<std::string, std::unique_ptr<BlockStreamBase>>>
+      functions;
+  for (auto &dagNode : nodeList.front().nodes) {
+    auto stream = provisioner.serializeFunction(dagNode->name);
+    if (!stream) {
+      return Error::success();
+    }
+    functions.emplace_back(dagNode->name, std::move(stream));
+  }
+
+  const std::string path = getSnapshotPath(dir, kSnapshotFunctionsFile);
+  std::ofstream out(path, std::ios::binary);
+  RETURN_ERR_IF_NOT(out, "Failed to create " + path);
+  ZipWriter zip(&out, "functions");
+  std::stringstream names;
+  for (const auto &function : functions) {
+    names << function.first << "\n";
+  }
+  zip.writeRecord("functions", names.str().c_str(), names.str().size(),
+                  /* compress */ false);
+  for (size_t i = 0, e = functions.size(); i < e; i++) {
+    auto &stream = *functions[i].second;
+    std::vector<char> data(stream.getSize());
+    RETURN_ERR_IF_NOT(
+        stream.read(data.data(), data.size()) == data.size(),
+        "Failed to read serialized function " + functions[i].first);
+    stream.releaseMemory();
+    zip.writeRecord("function_" + std::to_string(i), data.data(), data.size(),
+                    /* compress */ false);
+  }
+  zip.writeEndOfFile();
+  RETURN_ERR_IF_NOT(out, "Failed to write " + path);
+  return Error::success();
+}
+
+/// Enables continuous sampled tracing, once for all HostManagers, when
+/// requested by the glow_trace_sample_rate flag.
+void enableSampledTracing() {
+  static std::once_flag once;
+  std::call_once(once, []() {
+    if (glow::flags::TraceSampleRate <= 0) {
+      return;
+    }
+    auto registry = TraceExporterRegistry::getInstance();
+    if (!registry->getSampler()) {
+      registry->setSampler(std::make_shared<TraceSampler>(
+          glow::flags::TraceSampleRate,
+          glow::flags::TraceOverheadBudgetPercent / 100.0));
+    }
+    if (!glow::flags::TraceStreamFile.empty()) {
+      static ChromeTraceStreamExporter exporter(glow::flags::TraceStreamFile);
+      registry->registerTraceExporter(&exporter);
+    }
+  });
+}
 } // namespace
 
 namespace glow {
@@ -91,6 +224,7 @@ HostManager::HostManager(const HostConfig &hostConfig)
     : config_(hostConfig),
       statsExporterRegistry_(StatsExporterRegistry::Stats()) {
   statsExporterRegistry_->setCounter(kMaxQueueSize, hostConfig.maxQueueSize);
+  enableSampledTracing();
 }
 
 HostManager::HostManager(
@@ -106,16 +240,55 @@ HostManager::HostManager(
 
   REPORT_AND_EXIT_ON_ERR(init(std::move(deviceConfigs)));
   statsExporterRegistry_->setCounter(kMaxQueueSize, hostConfig.maxQueueSize);
+  enableSampledTracing();
 }
 
 Expected<DAG *> HostManager::getNetworkDAG(llvm::StringRef network) {
-  auto it = networks_.find(network.str());
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  std::string name = getRoutedName(network.str());
+  auto bucketsIt = shapeBuckets_.find(name);
+  if (bucketsIt != shapeBuckets_.end()) {
+    name = bucketsIt->second->getBuckets().back().networkName;
+  }
+  auto loopIt = sequenceLoops_.find(name);
+  if (loopIt != sequenceLoops_.end()) {
+    name = loopIt->second->getNetworkName();
+  }
+  auto it = networks_.find(name);
   if (it == networks_.end()) {
     return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR, "Network not found.");
   }
   return &it->second.dag;
 }
 
+Expected<std::unique_ptr<ExecutionContextPool>>
+HostManager::createExecutionContextPool(llvm::StringRef network,
+                                        size_t count) {
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  std::string name = getRoutedName(network.str());
+  auto bucketsIt = shapeBuckets_.find(name);
+  if (bucketsIt != shapeBuckets_.end()) {
+    name = bucketsIt->second->getBuckets().back().networkName;
+  }
+  auto it = networks_.find(name);
+  if (it == networks_.end()) {
+    return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR, "Network not found.");
+  }
+  DeviceManager *device = nullptr;
+  const auto &partitions = it->second.dag.root->children;
+  if (!partitions.empty()) {
+    std::lock_guard<std::mutex> nodeLock(partitions.front()->lock);
+    const auto &infos = partitions.front()->deviceRuntimeInfos;
+    auto deviceIt =
+        infos.empty() ? devices_.end() : devices_.find(infos.begin()->first);
+    if (deviceIt != devices_.end()) {
+      device = deviceIt->second.get();
+    }
+  }
+  return glow::make_unique<ExecutionContextPool>(it->second.module, count,
+                                                 device);
+}
+
 Error HostManager::startDeviceTrace() {
   LOG(INFO) << "start device tracing" << std::endl;
   for (auto &dev : devices_) {
@@ -184,8 +357,9 @@ Error HostManager::init(std::vector<std::unique_ptr<DeviceConfig>> configs) {
 #endif
 
   provisioner_.reset(new Provisioner(devices_));
-  executor_.reset(
-      new ThreadPoolExecutor(devices_, config_.executorThreads, "HostManager"));
+  executor_.reset(new ThreadPoolExecutor(devices_, config_.executorThreads,
+                                         "HostManager",
+                                         config_.executorWorkStealing));
   exportMemoryCounters();
   if (flags::AvailableDevices.length()) {
     std::vector<unsigned> devices;
@@ -196,6 +370,16 @@ Error HostManager::init(std::vector<std::unique_ptr<DeviceConfig>> configs) {
                                                    devices.end());
     setAvailableDevices(convertedDevs);
   }
+  // Move the partitions off the devices the health monitors report failed.
+  DeviceHealthMonitorRegistry::Monitors()->addListener(
+      this, [this](unsigned deviceID, bool healthy) {
+        for (auto &device : devices_) {
+          if (device.second->getDeviceConfig().deviceID == deviceID) {
+            ERR_TO_VOID(healthy ? markDeviceHealthy(device.first)
+                                : markDeviceUnhealthy(device.first));
+          }
+        }
+      });
   // If no HostManager is registered yet, register this one.
   if (!ManagerRegistry()->getHostManager()) {
     ManagerRegistry()->registerHostManager(this);
@@ -233,10 +417,131 @@ void HostManager::exportMemoryCounters() {
   statsExporterRegistry_->setCounter(kDeviceMemoryUsed, maxMem - availableMem);
   statsExporterRegistry_->setCounter(kDeviceMemoryAvailable, availableMem);
   statsExporterRegistry_->setCounter(kDeviceMemoryMax, maxMem);
+
+  for (auto &dev : devices_) {
+    const std::string id = std::to_string(dev.first);
+    uint64_t devMax = dev.second->getMaximumMemory();
+    uint64_t devAvailable = dev.second->getAvailableMemory();
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kDeviceUsedMemory) + "." + id).str(),
+        devMax - devAvailable);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kDeviceAvailableMemory) + "." + id).str(), devAvailable);
+  }
+  for (auto &it : networks_) {
+    const std::string &name = it.first;
+    NetworkMemoryUsage usage = computeNetworkMemoryUsage(it.second);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kNetworkConstantMemory) + "." + name).str(),
+        usage.constantBytes);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kNetworkMutableMemory) + "." + name).str(),
+        usage.mutableWeightBytes);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kNetworkActivationMemory) + "." + name).str(),
+        usage.activationBytes);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kNetworkHostMemory) + "." + name).str(), usage.hostBytes);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kNetworkCompileTransientMemory) + "." + name).str(),
+        usage.compileTransientBytes);
+  }
+}
+
+void HostManager::clearNetworkMemoryCounters(llvm::StringRef name) {
+  for (const char *prefix :
+       {kNetworkConstantMemory, kNetworkMutableMemory, kNetworkActivationMemory,
+        kNetworkHostMemory, kNetworkCompileTransientMemory}) {
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(prefix) + "." + name).str(), 0);
+  }
+}
+
+NetworkMemoryUsage
+HostManager::computeNetworkMemoryUsage(const NetworkData &network) {
+  NetworkMemoryUsage usage;
+  for (const auto &node : network.dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    const RuntimeBundle &bundle = *node->runtimeBundle;
+    usage.constantBytes += bundle.getConstantWeightSize();
+    usage.mutableWeightBytes += bundle.getMutableWeightSize();
+    usage.activationBytes += bundle.getActivationsSize();
+    const uint64_t nodeBytes = bundle.getConstantWeightSize() +
+                               bundle.getMutableWeightSize() +
+                               bundle.getActivationsSize();
+    for (const auto &device : node->deviceRuntimeInfos) {
+      usage.deviceBytes[device.first] += nodeBytes;
+    }
+  }
+  if (network.dag.root) {
+    usage.hostBytes = executor_->getBufferBytes(network.dag.root.get());
+  }
+  usage.compileTransientBytes = network.compileTransientBytes;
+  return usage;
+}
+
+Expected<NetworkMemoryUsage>
+HostManager::getNetworkMemoryUsage(llvm::StringRef network) {
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  const std::string name = getRoutedName(network.str());
+  // A shape bucketed network holds the memory of all its batch sizes.
+  std::vector<std::string> names{name};
+  auto bucketsIt = shapeBuckets_.find(name);
+  if (bucketsIt != shapeBuckets_.end()) {
+    names.clear();
+    for (const auto &bucket : bucketsIt->second->getBuckets()) {
+      names.push_back(bucket.networkName);
+    }
+  }
+  auto loopIt = sequenceLoops_.find(name);
+  if (loopIt != sequenceLoops_.end()) {
+    names = {loopIt->second->getNetworkName()};
+  }
+  NetworkMemoryUsage usage;
+  for (const auto &bucketName : names) {
+    auto it = networks_.find(bucketName);
+    if (it == networks_.end() || processingNetworks_.count(bucketName)) {
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+                      llvm::formatv("Network {0} not found.", network).str());
+    }
+    NetworkMemoryUsage bucketUsage = computeNetworkMemoryUsage(it->second);
+    usage.constantBytes += bucketUsage.constantBytes;
+    usage.mutableWeightBytes += bucketUsage.mutableWeightBytes;
+    usage.activationBytes += bucketUsage.activationBytes;
+    usage.hostBytes += bucketUsage.hostBytes;
+    usage.compileTransientBytes += bucketUsage.compileTransientBytes;
+    for (const auto &device : bucketUsage.deviceBytes) {
+      usage.deviceBytes[device.first] += device.second;
+    }
+  }
+  return usage;
+}
+
+std::map<DeviceIDTy, DeviceMemoryUsage> HostManager::getDeviceMemoryUsage() {
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  std::map<DeviceIDTy, DeviceMemoryUsage> usage;
+  for (auto &dev : devices_) {
+    DeviceMemoryUsage &devUsage = usage[dev.first];
+    devUsage.maximumBytes = dev.second->getMaximumMemory();
+    devUsage.availableBytes = dev.second->getAvailableMemory();
+    devUsage.usedBytes = devUsage.maximumBytes - devUsage.availableBytes;
+  }
+  for (auto &it : networks_) {
+    if (processingNetworks_.count(it.first)) {
+      continue;
+    }
+    for (auto &device : computeNetworkMemoryUsage(it.second).deviceBytes) {
+      usage[device.first].networkBytes += device.second;
+    }
+  }
+  return usage;
 }
 
 HostManager::~HostManager() {
   LOG(INFO) << "Destroying host manager...";
+  DeviceHealthMonitorRegistry::Monitors()->removeListener(this);
   ERR_TO_VOID(clearHost());
   exportMemoryCounters();
 }
@@ -248,6 +553,11 @@ void HostManager::cleanupAddNetwork(llvm::ArrayRef<std::string> names) {
   exportMemoryCounters();
 }
 
+std::string HostManager::getRoutedName(const std::string &networkName) const {
+  auto it = networkRoutes_.find(networkName);
+  return it == networkRoutes_.end() ? networkName : it->second;
+}
+
 Error HostManager::addNetwork(std::unique_ptr<Module> module,
                               CompilationContext &cctx) {
 #ifdef FACEBOOK_INTERNAL
@@ -256,6 +566,7 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
 
 #endif /* FACEBOOK_INTERNAL */
   VLOG(1) << "addNetwork";
+  const uint64_t startRSSKB = getMaxRSSKB();
   ScopeGuard debugDumpDAGGuard([&]() {
     if (cctx.dumpFinalGraph) {
       for (Function *F : module->getFunctions()) {
@@ -282,7 +593,8 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
     for (auto &F : functions) {
       std::string name = F->getName().str();
       auto it = networks_.find(name);
-      if (it != networks_.end() ||
+      if (it != networks_.end() || networkRoutes_.count(name) ||
+          shapeBuckets_.count(name) || sequenceLoops_.count(name) ||
           processingNetworks_.find(name) != processingNetworks_.end()) {
         cleanupAddNetwork(names);
         return MAKE_ERR(
@@ -391,7 +703,8 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
       RETURN_IF_ERR(devices_[i]->init());
     }
     provisioner_.reset(new Provisioner(devices_));
-    executor_.reset(new ThreadPoolExecutor(devices_, config_.executorThreads));
+    executor_.reset(new ThreadPoolExecutor(devices_, config_.executorThreads,
+                                           "", config_.executorWorkStealing));
   }
 
   VLOG(1) << "Before replace dummy TQPs";
@@ -541,9 +854,23 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
     }
   }
 
+  if (!cctx.networkSnapshotDir.empty()) {
+    LOG(INFO) << "Writing network snapshot to " << cctx.networkSnapshotDir;
+    auto snapshotErr =
+        writeSnapshotDAG(cctx.networkSnapshotDir, nodeList, record, cctx);
+    if (snapshotErr) {
+      std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+      cleanupAddNetwork(names);
+      RETURN_ERR(snapshotErr);
+    }
+  }
+
   // Now that we've serialized the model if requested, cleanup the temporary
   // Functions and PHs used for constant folding.
   cleanupConstantFolding(*module, record);
+  if (config_.shareConstantPayloads) {
+    module->shareConstantPayloads();
+  }
   VLOG(1) << "Before provisioning";
   auto err = provisioner_->provision(nodeList, *module, cctx);
   if (err) {
@@ -557,6 +884,18 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
     RETURN_ERR(err);
   }
   debugDumpDAGGuard.dismiss();
+  if (!cctx.networkSnapshotDir.empty()) {
+    // Without its compiled functions the snapshot is still valid, its
+    // partitions are then compiled when it is added.
+    if (auto snapshotErr = writeSnapshotFunctions(cctx.networkSnapshotDir,
+                                                  nodeList, *provisioner_)) {
+      LOG(WARNING) << "Failed to write the compiled functions of the network "
+                      "snapshot: "
+                   << ERR_TO_STRING(std::move(snapshotErr));
+      llvm::sys::fs::remove(
+          getSnapshotPath(cctx.networkSnapshotDir, kSnapshotFunctionsFile));
+    }
+  }
   VLOG(1) << "Calculation of maxActiveRequests";
   {
     std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
@@ -588,7 +927,8 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
       // Note: currently getNextNetworkExecutionState assumes that pool size is
       // >= currentInFlight requests, so we set pool size to maxActiveRequests.
       executor_->createPool(node.root.get(), config_.maxActiveRequests,
-                            cctx.enableP2P, cctx.enableDRT);
+                            cctx.enableP2P, cctx.enableDRT,
+                            cctx.pipelineDepth);
     }
   }
   // Clear constants contents from the module then put it in a
@@ -600,6 +940,9 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
     module->strip();
   }
   VLOG(1) << "Cleanup";
+  const uint64_t endRSSKB = getMaxRSSKB();
+  const uint64_t compileTransientBytes =
+      endRSSKB > startRSSKB ? (endRSSKB - startRSSKB) * 1024 : 0;
   auto sharedModule = std::shared_ptr<Module>(std::move(module));
   {
     std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
@@ -610,6 +953,7 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
       auto &networkData = networks_[(node.root)->name];
       networkData.dag = std::move(node);
       networkData.module = sharedModule;
+      networkData.compileTransientBytes = compileTransientBytes;
     }
     cleanupAddNetwork(names);
   }
@@ -617,6 +961,47 @@ Error HostManager::addNetwork(std::unique_ptr<Module> module,
   return Error::success();
 }
 
+Error HostManager::addNetworkFromSnapshot(llvm::StringRef dir,
+                                          CompilationContext &cctx) {
+  const std::string dagPath = getSnapshotPath(dir, kSnapshotDAGFile);
+  RETURN_ERR_IF_NOT(llvm::sys::fs::exists(dagPath),
+                    "No network snapshot in " + dir.str());
+  // The records of the DAG are in a folder named after its root.
+  const std::string rootName = ZipReader(dagPath).getArchiveName();
+
+  auto module = glow::make_unique<Module>();
+  PrePartitionedConfig PPC;
+  {
+    Error err = Error::empty();
+    ONNXModelLoader loader(dagPath, {}, {}, *module, rootName, &PPC, &err,
+                           /* zipMode */ true,
+                           &cctx.backendOpts.backendSpecificNodeInfo,
+                           /* loadIntoExistingModule */ false,
+                           /* disableConstFoldInLoader */ true);
+    RETURN_IF_ERR(err);
+  }
+  cctx.prepartitionedConfig = &PPC;
+  cctx.loadingAOTModel = true;
+  cctx.networkSnapshotDir.clear();
+
+  const std::string functionsPath =
+      getSnapshotPath(dir, kSnapshotFunctionsFile);
+  if (llvm::sys::fs::exists(functionsPath)) {
+    ZipReader zip(functionsPath, /* mapFile */ true);
+    std::stringstream names(zip.getRecord("functions"));
+    std::string name;
+    for (size_t i = 0; std::getline(names, name); i++) {
+      auto data = zip.getRecordView("function_" + std::to_string(i));
+      cctx.nameToFunctions[name] =
+          std::make_shared<std::vector<char>>(data.begin(), data.end());
+    }
+    cctx.backendOpts.useDeserialize = true;
+  }
+  auto err = addNetwork(std::move(module), cctx);
+  cctx.prepartitionedConfig = nullptr;
+  return err;
+}
+
 #if FACEBOOK_INTERNAL
 Error HostManager::addNetworkFX(
     std::unique_ptr<Module> module, CompilationContext &cctx,
@@ -625,6 +1010,7 @@ Error HostManager::addNetworkFX(
 
   LOG(INFO) << "Adding Glow network built with revision hash: " << revisionHash;
   VLOG(1) << "addNetwork";
+  const uint64_t startRSSKB = getMaxRSSKB();
 
   std::vector<std::string> names;
   {
@@ -729,7 +1115,8 @@ Error HostManager::addNetworkFX(
       // Note: currently getNextNetworkExecutionState assumes that pool size is
       // >= currentInFlight requests, so we set pool size to maxActiveRequests.
       executor_->createPool(node.root.get(), config_.maxActiveRequests,
-                            cctx.enableP2P, cctx.enableDRT);
+                            cctx.enableP2P, cctx.enableDRT,
+                            cctx.pipelineDepth);
     }
   }
   // Clear constants contents from the module then put it in a
@@ -741,6 +1128,9 @@ Error HostManager::addNetworkFX(
     module->strip();
   }
   VLOG(1) << "Cleanup";
+  const uint64_t endRSSKB = getMaxRSSKB();
+  const uint64_t compileTransientBytes =
+      endRSSKB > startRSSKB ? (endRSSKB - startRSSKB) * 1024 : 0;
   auto sharedModule = std::shared_ptr<Module>(std::move(module));
   {
     std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
@@ -749,6 +1139,7 @@ Error HostManager::addNetworkFX(
       auto &networkData = networks_[(node.root)->name];
       networkData.dag = std::move(node);
       networkData.module = sharedModule;
+      networkData.compileTransientBytes = compileTransientBytes;
     }
     cleanupAddNetwork(names);
   }
@@ -760,7 +1151,8 @@ Error HostManager::addNetworkFX(
 std::unordered_map<std::string, std::vector<DeviceIDTy>>
 HostManager::getDevicePartitionMapping(llvm::StringRef network) {
   std::unordered_map<std::string, std::vector<DeviceIDTy>> mapping;
-  auto it = networks_.find(network.str());
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  auto it = networks_.find(getRoutedName(network.str()));
   if (it != networks_.end()) {
     auto &nodeList = it->second.dag.nodes;
     for (auto &node : nodeList) {
@@ -775,14 +1167,51 @@ HostManager::getDevicePartitionMapping(llvm::StringRef network) {
 }
 
 Error HostManager::removeNetwork(llvm::StringRef networkName) {
+  std::string name;
+  std::shared_ptr<const ShapeBuckets> buckets;
+  std::shared_ptr<const SequenceLoop> loop;
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    name = getRoutedName(networkName.str());
+    auto it = shapeBuckets_.find(name);
+    if (it != shapeBuckets_.end()) {
+      buckets = it->second;
+    }
+    auto loopIt = sequenceLoops_.find(name);
+    if (loopIt != sequenceLoops_.end()) {
+      loop = loopIt->second;
+    }
+  }
+  if (loop) {
+    RETURN_IF_ERR(removeNetworkImpl(loop->getNetworkName()));
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    sequenceLoops_.erase(name);
+    return Error::success();
+  }
+  if (!buckets) {
+    return removeNetworkImpl(name);
+  }
+  // Buckets that are done are removed even if another one is still busy, in
+  // which case removing the network again removes the rest.
+  for (const auto &bucket : buckets->getBuckets()) {
+    RETURN_IF_ERR(removeNetworkImpl(bucket.networkName));
+  }
   std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
-  auto networkIterator = networks_.find(networkName.str());
+  shapeBuckets_.erase(name);
+  return Error::success();
+}
+
+Error HostManager::removeNetworkImpl(std::string networkName) {
+  // Destroyed after networkLock is released, since its timer thread may be
+  // waiting on networkLock_ to submit a batch.
+  std::unique_ptr<RequestBatcher> batcher;
+  std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  auto networkIterator = networks_.find(networkName);
   if (networkIterator == networks_.end()) {
     return Error::success();
   }
 
-  if (processingNetworks_.find(networkName.str()) !=
-      processingNetworks_.end()) {
+  if (processingNetworks_.find(networkName) != processingNetworks_.end()) {
     // Return an error, the network is in an incomplete state likely because
     // it is still being added by a different call.
     return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_BUSY,
@@ -814,17 +1243,310 @@ Error HostManager::removeNetwork(llvm::StringRef networkName) {
     // Also remove compiledFunction from Provisioner.
     err.set(provisioner_->removeFunction(node->name));
   }
+  batcher = std::move(networkIterator->second.batcher);
   networks_.erase(networkIterator);
+  clearNetworkMemoryCounters(networkName);
+  // Drop the routes of replaced networks to this version.
+  for (auto it = networkRoutes_.begin(); it != networkRoutes_.end();) {
+    if (it->second == networkName) {
+      it = networkRoutes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  {
+    std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
+    inferQueues_.erase(networkName);
+  }
   exportMemoryCounters();
   RETURN_ERR(err.get());
 }
 
+Error HostManager::replaceNetwork(llvm::StringRef networkName,
+                                  std::unique_ptr<Module> module,
+                                  CompilationContext &cctx) {
+  const std::string publicName = networkName.str();
+  auto functions = module->getFunctions();
+  RETURN_ERR_IF_NOT(functions.size() == 1,
+                    "Replacing a network requires a module with one Function");
+  std::string oldName;
+  {
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    oldName = getRoutedName(publicName);
+    if (networks_.find(oldName) == networks_.end()) {
+      return MAKE_ERR(
+          ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+          llvm::formatv("Function {0} not found", networkName).str());
+    }
+    if (!replacingNetworks_.insert(publicName).second) {
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_BUSY,
+                      llvm::formatv("Cannot replace the network {0}, as it is "
+                                    "already being replaced.",
+                                    networkName)
+                          .str());
+    }
+  }
+  ScopeGuard replacingGuard([&]() {
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    replacingNetworks_.erase(publicName);
+  });
+
+  // Compile and provision the new version under a name of its own, the old
+  // version keeps serving requests meanwhile.
+  const std::string newName =
+      strFormat("%s__v%zu", publicName.c_str(), ++networkVersionCount_);
+  functions.front()->setName(newName);
+  RETURN_IF_ERR(addNetwork(std::move(module), cctx));
+
+  {
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    auto oldIt = networks_.find(oldName);
+    if (oldIt == networks_.end() || getRoutedName(publicName) != oldName) {
+      networkLock.unlock();
+      ERR_TO_BOOL(removeNetworkImpl(newName));
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+                      llvm::formatv("Network {0} was removed while it was "
+                                    "being replaced",
+                                    networkName)
+                          .str());
+    }
+    NetworkData &oldNetwork = oldIt->second;
+    NetworkData &newNetwork = networks_.at(newName);
+    newNetwork.latencyEstimate = oldNetwork.latencyEstimate.load();
+    if (oldNetwork.batcher) {
+      newNetwork.batcher =
+          createBatcher(newNetwork, newName, oldNetwork.batcher->getConfig());
+    }
+    if (oldNetwork.resultCache) {
+      newNetwork.resultCache = std::make_shared<ResultCache>(
+          newNetwork.dag, oldNetwork.resultCache->getConfig());
+    }
+    {
+      std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
+      auto queueIt = inferQueues_.find(oldName);
+      if (queueIt != inferQueues_.end()) {
+        inferQueues_[newName].config = queueIt->second.config;
+      }
+    }
+    // From here on new requests run on the new version.
+    networkRoutes_[publicName] = newName;
+  }
+
+  // Requests already routed to the old version hold a reference on it, remove
+  // it once they're done.
+  while (true) {
+    Error err = removeNetworkImpl(oldName);
+    if (!err.peekErrorValue() || err.peekErrorValue()->getErrorCode() !=
+                                     ErrorValue::ErrorCode::RUNTIME_NET_BUSY) {
+      RETURN_ERR(err);
+    }
+    ERR_TO_BOOL(std::move(err));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+Error HostManager::addShapeBucketedNetwork(
+    llvm::StringRef networkName, llvm::ArrayRef<dim_t> batchSizes,
+    const BucketModuleBuilderTy &buildModule, CompilationContext &cctx) {
+  const std::string publicName = networkName.str();
+  std::vector<dim_t> sizes(batchSizes.begin(), batchSizes.end());
+  std::sort(sizes.begin(), sizes.end());
+  sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+  RETURN_ERR_IF_NOT(!sizes.empty() && sizes.front() > 0,
+                    "Shape buckets require positive batch sizes");
+  {
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    if (networks_.count(publicName) || networkRoutes_.count(publicName) ||
+        shapeBuckets_.count(publicName) || sequenceLoops_.count(publicName) ||
+        !processingNetworks_.insert(publicName).second) {
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR,
+                      "Failed to add network: already have a function called " +
+                          publicName);
+    }
+  }
+  std::vector<std::string> added;
+  ScopeGuard cleanupGuard([&]() {
+    for (const auto &name : added) {
+      ERR_TO_BOOL(removeNetworkImpl(name));
+    }
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    processingNetworks_.erase(publicName);
+  });
+
+  auto buckets = std::make_shared<ShapeBuckets>();
+  for (dim_t batchSize : sizes) {
+    std::unique_ptr<Module> module;
+    ASSIGN_VALUE_OR_RETURN_ERR(module, buildModule(batchSize));
+    auto functions = module->getFunctions();
+    RETURN_ERR_IF_NOT(functions.size() == 1,
+                      "A shape bucket requires a module with one Function");
+    const std::string name = strFormat("%s__b%lu", publicName.c_str(),
+                                       (unsigned long)batchSize);
+    functions.front()->setName(name);
+    RETURN_IF_ERR(addNetwork(std::move(module), cctx));
+    added.push_back(name);
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    const NetworkData &network = networks_.at(name);
+    RETURN_IF_ERR(
+        buckets->addBucket(batchSize, name, network.dag, *network.module));
+  }
+
+  cleanupGuard.dismiss();
+  std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  processingNetworks_.erase(publicName);
+  shapeBuckets_[publicName] = std::move(buckets);
+  return Error::success();
+}
+
+Error HostManager::addSequenceLoopNetwork(llvm::StringRef networkName,
+                                          std::unique_ptr<Module> module,
+                                          const SequenceLoopConfig &config,
+                                          CompilationContext &cctx) {
+  const std::string publicName = networkName.str();
+  auto functions = module->getFunctions();
+  RETURN_ERR_IF_NOT(functions.size() == 1,
+                    "A sequence loop requires a module with one Function");
+  {
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    if (networks_.count(publicName) || networkRoutes_.count(publicName) ||
+        shapeBuckets_.count(publicName) || sequenceLoops_.count(publicName) ||
+        !processingNetworks_.insert(publicName).second) {
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR,
+                      "Failed to add network: already have a function called " +
+                          publicName);
+    }
+  }
+  const std::string name = publicName + "__cell";
+  bool added = false;
+  ScopeGuard cleanupGuard([&]() {
+    if (added) {
+      ERR_TO_BOOL(removeNetworkImpl(name));
+    }
+    std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    processingNetworks_.erase(publicName);
+  });
+
+  functions.front()->setName(name);
+  RETURN_IF_ERR(addNetwork(std::move(module), cctx));
+  added = true;
+  std::unique_ptr<SequenceLoop> loop;
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    const NetworkData &network = networks_.at(name);
+    ASSIGN_VALUE_OR_RETURN_ERR(
+        loop, SequenceLoop::create(config, name, network.dag, *network.module));
+  }
+
+  cleanupGuard.dismiss();
+  std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  processingNetworks_.erase(publicName);
+  sequenceLoops_[publicName] = std::move(loop);
+  return Error::success();
+}
+
+std::unique_ptr<RequestBatcher>
+HostManager::createBatcher(const NetworkData &network, const std::string &name,
+                           const RequestBatchingConfig &config) {
+  return glow::make_unique<RequestBatcher>(
+      network.dag, config,
+      [this, name](std::unique_ptr<ExecutionContext> context,
+                   ResultCBTy callback, uint64_t priority, uint64_t deadline) {
+        runNetworkImpl(name, std::move(context), std::move(callback), priority,
+                       deadline, /* allowBatching */ false);
+      });
+}
+
+Error HostManager::setRequestBatching(
+    llvm::StringRef networkName, llvm::Optional<RequestBatchingConfig> config) {
+  // Destroyed after networkLock is released, see removeNetwork.
+  std::unique_ptr<RequestBatcher> oldBatcher;
+  std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  auto networkIterator = networks_.find(getRoutedName(networkName.str()));
+  if (networkIterator == networks_.end()) {
+    return MAKE_ERR(
+        ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+        llvm::formatv("Function {0} not found", networkName).str());
+  }
+  auto &network = networkIterator->second;
+  // Requests waiting in the current batcher rely on it staying alive.
+  if (network.refcount != 0) {
+    return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_NET_BUSY,
+                    llvm::formatv("Cannot change request batching for the "
+                                  "network {0}, as there are still "
+                                  "outstanding runs",
+                                  networkName)
+                        .str());
+  }
+
+  oldBatcher = std::move(network.batcher);
+  if (config.hasValue()) {
+    network.batcher =
+        createBatcher(network, networkIterator->first, config.getValue());
+  }
+  return Error::success();
+}
+
+Error HostManager::setResultCache(llvm::StringRef networkName,
+                                  llvm::Optional<ResultCacheConfig> config) {
+  std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  const std::string name = getRoutedName(networkName.str());
+  auto networkIterator = networks_.find(name);
+  if (networkIterator == networks_.end()) {
+    return MAKE_ERR(
+        ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+        llvm::formatv("Function {0} not found", networkName).str());
+  }
+  auto &network = networkIterator->second;
+  // Runs in flight keep the old cache alive until they complete.
+  network.resultCache =
+      config.hasValue()
+          ? std::make_shared<ResultCache>(network.dag, config.getValue())
+          : nullptr;
+  statsExporterRegistry_->setCounter(
+      (llvm::Twine(kResultCacheBytes) + "." + name).str(), 0);
+  return Error::success();
+}
+
+Error HostManager::setNetworkScheduling(llvm::StringRef networkName,
+                                        const NetworkSchedulingConfig &config) {
+  RETURN_ERR_IF_NOT(config.weight > 0,
+                    "Network scheduling weight must be positive");
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  const std::string name = getRoutedName(networkName.str());
+  if (networks_.find(name) == networks_.end()) {
+    return MAKE_ERR(
+        ErrorValue::ErrorCode::RUNTIME_NET_NOT_FOUND,
+        llvm::formatv("Function {0} not found", networkName).str());
+  }
+  std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
+  inferQueues_[name].config = config;
+  return Error::success();
+}
+
 bool HostManager::networkAdded(llvm::StringRef networkName) {
   std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
-  return networks_.find(networkName.str()) != networks_.end();
+  const std::string name = getRoutedName(networkName.str());
+  return networks_.find(name) != networks_.end() || shapeBuckets_.count(name) ||
+         sequenceLoops_.count(name);
 }
 
 Error HostManager::clearHost() {
+  // Submit requests still waiting to be batched so they're drained along with
+  // everything else in flight. Batchers with pending requests hold a
+  // reference on their network, so they can't be removed meanwhile.
+  std::vector<RequestBatcher *> batchers;
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    for (auto &network : networks_) {
+      if (network.second.batcher) {
+        batchers.push_back(network.second.batcher.get());
+      }
+    }
+  }
+  for (auto *batcher : batchers) {
+    batcher->flush();
+  }
+
   // shutdown the executor, blocking on any current inflight and prevent new
   // requests from being serviced.
   executor_->shutdown();
@@ -834,8 +1556,10 @@ Error HostManager::clearHost() {
 
   // Remove all networks from the host and device(s).
   while (networks_.size() != 0) {
-    RETURN_IF_ERR(removeNetwork(networks_.begin()->first));
+    RETURN_IF_ERR(removeNetworkImpl(networks_.begin()->first));
   }
+  shapeBuckets_.clear();
+  sequenceLoops_.clear();
 
   // Now it's safe to stop the DeviceManagers.
   std::unique_lock<std::shared_timed_mutex> networkLock(networkLock_);
@@ -847,6 +1571,13 @@ Error HostManager::clearHost() {
   statsExporterRegistry_->setCounter(kDeviceMemoryUsed, 0);
   statsExporterRegistry_->setCounter(kDeviceMemoryAvailable, 0);
   statsExporterRegistry_->setCounter(kDeviceMemoryMax, 0);
+  for (auto &it : devices_) {
+    const std::string id = std::to_string(it.first);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kDeviceUsedMemory) + "." + id).str(), 0);
+    statsExporterRegistry_->setCounter(
+        (llvm::Twine(kDeviceAvailableMemory) + "." + id).str(), 0);
+  }
 
   if (glow::flags::DumpDebugTraces) {
     provisioner_->dumpBackendSpecificTraceEvents();
@@ -859,44 +1590,41 @@ Error HostManager::runNetworkBlocking(llvm::StringRef networkName,
   std::unique_ptr<PlaceholderBindings> phBindings(&bindings);
   std::unique_ptr<ExecutionContext> context =
       glow::make_unique<ExecutionContext>(std::move(phBindings));
-  std::promise<void> runPromise;
-  auto fut = runPromise.get_future();
-  std::unique_ptr<Error> runErr;
-  runNetwork(
-      networkName, std::move(context),
-      [&runPromise, &runErr](runtime::RunIdentifierTy, Error err,
-                             std::unique_ptr<ExecutionContext> contextPtr) {
-        // Don't delete ph bindings since they were created from a passed in
-        // reference.
-        std::unique_ptr<PlaceholderBindings> phBind =
-            contextPtr->movePlaceholderBindings();
-        phBind.release();
-
-        runErr = glow::make_unique<Error>(std::move(err));
-        runPromise.set_value();
-      });
+  RunLatch latch;
+  Error runErr = Error::empty();
+  runNetwork(networkName, std::move(context),
+             [&latch, &runErr](runtime::RunIdentifierTy, Error err,
+                               std::unique_ptr<ExecutionContext> contextPtr) {
+               // Don't delete ph bindings since they were created from a
+               // passed in reference.
+               std::unique_ptr<PlaceholderBindings> phBind =
+                   contextPtr->movePlaceholderBindings();
+               phBind.release();
 
-  fut.wait();
-  return std::move(*DCHECK_NOTNULL(runErr.get()));
+               runErr = std::move(err);
+               latch.set();
+             });
+
+  latch.wait();
+  return runErr;
 }
 
 Error HostManager::runNetworkBlocking(
     llvm::StringRef networkName, std::unique_ptr<ExecutionContext> &context) {
-  std::promise<void> runPromise;
-  auto fut = runPromise.get_future();
+  RunLatch latch;
   Error runErr = Error::empty();
   std::unique_ptr<ExecutionContext> tempContext;
 
   runNetwork(networkName, std::move(context),
-             [&runPromise, &runErr,
+             [&latch, &runErr,
               &tempContext](runtime::RunIdentifierTy, Error err,
                             std::unique_ptr<ExecutionContext> resultCtxt) {
                runErr = std::move(err);
                tempContext = std::move(resultCtxt);
-               runPromise.set_value();
+               latch.set();
              });
 
-  fut.wait();
+  latch.wait();
   context = std::move(tempContext);
   return runErr;
 }
@@ -905,32 +1633,61 @@ void HostManager::dispatchNextRun() {
   int requestId = -1;
   llvm::Optional<InferRequest> pRequest;
   std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
-  {
-    // hmm this lock is hot but I still have it as a unique lock because
-    // we always need to pop inferQueue and inferQueue is not thread safe
-    std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
-    if (inferQueue_.size()) {
-      // Get the next request, unfortunately priority_queue only
-      // provides a const ref to the top element, since we need to move
-      // it we first cast it to remove the const.
-      pRequest = std::move(const_cast<InferRequest &>(inferQueue_.top()));
-      requestId = static_cast<int>(pRequest->requestID);
-      inferQueue_.pop();
+  while (true) {
+    {
+      // hmm this lock is hot but I still have it as a unique lock because
+      // we always need to pop inferQueue and inferQueue is not thread safe
+      std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
+      pRequest = popNextRequest();
+      if (pRequest.hasValue()) {
+        requestId = static_cast<int>(pRequest->requestID);
+      } else {
+        // Decrement the activeRequest counter so new requests can
+        // launched.
+        --activeRequestCount_;
+        return;
+      }
+    }
+
+    // Drop cancelled requests and shed requests that can no longer make their
+    // deadline rather than let them hold up the requests behind them, and
+    // move on to the next one.
+    bool cancelled = pRequest->context->isCancelled();
+    if (!cancelled &&
+        (!pRequest->deadline ||
+         !missesDeadline(networks_[pRequest->networkName],
+                         pRequest->deadline))) {
+      break;
+    }
+    networkLock.unlock();
+    releaseNetworkSlot(pRequest->networkName);
+    if (cancelled) {
+      dropCancelledRequest(pRequest->networkName, pRequest->requestID,
+                           std::move(pRequest->context),
+                           std::move(pRequest->callback));
     } else {
-      // Decrement the activeRequest counter so new requests can
-      // launched.
-      --activeRequestCount_;
-      return;
+      shedRequest(pRequest->networkName, pRequest->requestID,
+                  pRequest->deadline, std::move(pRequest->context),
+                  std::move(pRequest->callback));
     }
+    networkLock.lock();
   }
 
   assert(pRequest.hasValue());
   InferRequest request = std::move(pRequest.getValue());
   auto startTime = TraceEvent::now();
   auto requestReceived = request.startTime;
+  auto &network = networks_[request.networkName];
+  network.queueWaitLatency.record(startTime - requestReceived);
+  if (auto *traceContext = request.context->getTraceContext()) {
+    traceContext->logTraceEvent(TraceEvent(
+        RequestTraceAnalysis::kQueueEvent, TraceLevel::REQUEST,
+        requestReceived, startTime - requestReceived, threads::getThreadId(),
+        {{"request", std::to_string(request.requestID)},
+         {"network", request.networkName}}));
+  }
   executor_->run(
-      networks_[request.networkName].dag.root.get(), std::move(request.context),
-      request.requestID,
+      network.dag.root.get(), std::move(request.context), request.requestID,
       [this, callback = request.callback, name = request.networkName, startTime,
        requestReceived](RunIdentifierTy runID, Error err,
                         std::unique_ptr<ExecutionContext> context) mutable {
@@ -938,9 +1695,13 @@ void HostManager::dispatchNextRun() {
           std::shared_lock<std::shared_timed_mutex> netLock(networkLock_);
           auto it = networks_.find(name);
           if (it != networks_.end()) {
+            uint64_t duration = TraceEvent::now() - startTime;
+            updateLatencyEstimate(it->second, duration);
+            it->second.executionLatency.record(duration);
             it->second.refcount--;
           }
         }
+        releaseNetworkSlot(name);
 
         updateExecutionStats(startTime, context, name, err);
         // Update request runtime.
@@ -951,17 +1712,306 @@ void HostManager::dispatchNextRun() {
           requestData->stopTime = end;
         }
 
+        uint64_t callbackStartTime = TraceEvent::now();
+        if (context && context->getTraceContext()) {
+          context->getTraceContext()->logTraceEvent(TraceEvent(
+              RequestTraceAnalysis::kRunEvent, TraceLevel::REQUEST, startTime,
+              callbackStartTime - startTime, threads::getThreadId(),
+              {{"request", std::to_string(runID)}}));
+        }
         callback(runID, std::move(err), std::move(context));
+        {
+          // The callback may have removed the network.
+          std::shared_lock<std::shared_timed_mutex> netLock(networkLock_);
+          auto it = networks_.find(name);
+          if (it != networks_.end()) {
+            it->second.callbackLatency.record(TraceEvent::now() -
+                                              callbackStartTime);
+          }
+        }
+        if (++numCompletedRequests_ % kHistogramExportInterval == 0) {
+          exportLatencyHistograms();
+        }
         dispatchNextRun();
       });
 }
 
+void HostManager::exportLatencyHistograms() {
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  for (auto &it : networks_) {
+    const std::string &name = it.first;
+    const NetworkData &network = it.second;
+    statsExporterRegistry_->addHistogram(
+        (llvm::Twine(kQueueWaitLatency) + "." + name).str(),
+        network.queueWaitLatency);
+    statsExporterRegistry_->addHistogram(
+        (llvm::Twine(kExecutionLatency) + "." + name).str(),
+        network.executionLatency);
+    statsExporterRegistry_->addHistogram(
+        (llvm::Twine(kCallbackLatency) + "." + name).str(),
+        network.callbackLatency);
+    for (const auto &node : network.dag.nodes) {
+      statsExporterRegistry_->addHistogram(
+          (llvm::Twine(kDeviceLatency) + "." + node->name).str(),
+          node->deviceLatency);
+    }
+  }
+}
+
+llvm::Optional<HostManager::InferRequest> HostManager::popNextRequest() {
+  NetworkQueue *next = nullptr;
+  for (auto &it : inferQueues_) {
+    NetworkQueue &queue = it.second;
+    if (!queue.isReady()) {
+      continue;
+    }
+    if (!next) {
+      next = &queue;
+      continue;
+    }
+    uint64_t priority = queue.requests.top().priority;
+    uint64_t nextPriority = next->requests.top().priority;
+    if (priority < nextPriority ||
+        (priority == nextPriority && queue.pass < next->pass)) {
+      next = &queue;
+    }
+  }
+  if (!next) {
+    return llvm::None;
+  }
+
+  schedulingVirtualTime_ = next->pass;
+  next->pass += kSchedulingStride / next->config.weight;
+  next->activeRequests++;
+  numQueuedRequests_--;
+  // Unfortunately priority_queue only provides a const ref to the top element,
+  // since we need to move it we first cast it to remove the const.
+  InferRequest request =
+      std::move(const_cast<InferRequest &>(next->requests.top()));
+  next->requests.pop();
+  return llvm::Optional<InferRequest>(std::move(request));
+}
+
+void HostManager::releaseNetworkSlot(llvm::StringRef networkName) {
+  std::unique_lock<std::shared_timed_mutex> queueLock(inferQueueLock_);
+  auto it = inferQueues_.find(networkName.str());
+  if (it != inferQueues_.end()) {
+    DCHECK_GT(it->second.activeRequests, 0);
+    it->second.activeRequests--;
+  }
+}
+
+struct HostManager::SequenceLoopRun {
+  std::shared_ptr<const SequenceLoop> loop;
+  /// The request, which waits for its last step to be done.
+  std::unique_ptr<ExecutionContext> context;
+  ResultCBTy callback;
+  RunIdentifierTy runID{0};
+  dim_t numSteps{0};
+  /// The step being run.
+  dim_t step{0};
+  uint64_t priority{0};
+  uint64_t deadline{0};
+};
+
 RunIdentifierTy
 HostManager::runNetwork(llvm::StringRef networkName,
                         std::unique_ptr<ExecutionContext> context,
-                        ResultCBTy callback, uint64_t priority) {
+                        ResultCBTy callback, uint64_t priority,
+                        uint64_t deadline,
+                        std::shared_ptr<CancellationToken> cancellationToken) {
+  if (cancellationToken) {
+    context->setCancellationToken(std::move(cancellationToken));
+  }
+  std::shared_ptr<const ShapeBuckets> buckets;
+  std::shared_ptr<const SequenceLoop> loop;
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    auto it = shapeBuckets_.find(networkName.str());
+    if (it != shapeBuckets_.end()) {
+      buckets = it->second;
+    }
+    auto loopIt = sequenceLoops_.find(networkName.str());
+    if (loopIt != sequenceLoops_.end()) {
+      loop = loopIt->second;
+    }
+  }
+  if (loop) {
+    RunIdentifierTy runID = totalRequestCount_++;
+    auto numStepsOrErr = loop->getNumSteps(*context);
+    if (!numStepsOrErr) {
+      callback(runID, numStepsOrErr.takeError(), std::move(context));
+      return runID;
+    }
+    if (!*numStepsOrErr) {
+      loop->finish(nullptr, *context);
+      callback(runID, Error::success(), std::move(context));
+      return runID;
+    }
+    auto stepCtx = loop->createStepContext(*context);
+    stepCtx->setTraceContext(context->setTraceContext(nullptr));
+    stepCtx->setCancellationToken(context->getCancellationToken());
+    auto run = std::make_shared<SequenceLoopRun>();
+    run->loop = std::move(loop);
+    run->context = std::move(context);
+    run->callback = std::move(callback);
+    run->runID = runID;
+    run->numSteps = *numStepsOrErr;
+    run->priority = priority;
+    run->deadline = deadline;
+    runSequenceLoopStep(std::move(run), std::move(stepCtx));
+    return runID;
+  }
+  if (!buckets) {
+    return runNetworkImpl(networkName, std::move(context), std::move(callback),
+                          priority, deadline, /* allowBatching */ true);
+  }
+
+  dim_t rows = 0;
+  auto bucketOrErr = buckets->getBucket(*context, rows);
+  if (!bucketOrErr) {
+    RunIdentifierTy runID = totalRequestCount_++;
+    callback(runID, bucketOrErr.takeError(), std::move(context));
+    return runID;
+  }
+  const ShapeBuckets::Bucket *bucket = *bucketOrErr;
+  auto bucketCtx = buckets->pad(*bucket, *context, rows);
+  bucketCtx->setTraceContext(context->setTraceContext(nullptr));
+  bucketCtx->setCancellationToken(context->getCancellationToken());
+  // The request waits in the callback for the run on its bucket to be done.
+  auto request =
+      std::make_shared<std::unique_ptr<ExecutionContext>>(std::move(context));
+  return runNetworkImpl(
+      bucket->networkName, std::move(bucketCtx),
+      [buckets, bucket, request, rows,
+       callback](RunIdentifierTy runID, Error err,
+                 std::unique_ptr<ExecutionContext> bucketCtx) {
+        std::unique_ptr<ExecutionContext> context = std::move(*request);
+        context->setTraceContext(bucketCtx->setTraceContext(nullptr));
+        if (!err.peekErrorValue()) {
+          buckets->unpad(*bucket, *bucketCtx, *context, rows);
+        }
+        callback(runID, std::move(err), std::move(context));
+      },
+      priority, deadline, /* allowBatching */ true);
+}
+
+void HostManager::runSequenceLoopStep(
+    std::shared_ptr<SequenceLoopRun> run,
+    std::unique_ptr<ExecutionContext> stepCtx) {
+  run->loop->bindStep(*run->context, *stepCtx, run->step);
+  const std::string &name = run->loop->getNetworkName();
+  runNetworkImpl(
+      name, std::move(stepCtx),
+      [this, run](RunIdentifierTy, Error err,
+                  std::unique_ptr<ExecutionContext> stepCtx) {
+        const bool failed = static_cast<bool>(err);
+        if (!failed && ++run->step < run->numSteps) {
+          run->loop->nextStep(*stepCtx);
+          runSequenceLoopStep(run, std::move(stepCtx));
+          return;
+        }
+        std::unique_ptr<ExecutionContext> context = std::move(run->context);
+        context->setTraceContext(stepCtx->setTraceContext(nullptr));
+        if (!failed) {
+          run->loop->finish(stepCtx.get(), *context);
+        }
+        run->callback(run->runID, std::move(err), std::move(context));
+      },
+      run->priority, run->deadline, /* allowBatching */ true);
+}
+
+bool HostManager::missesDeadline(const NetworkData &network,
+                                 uint64_t deadline) {
+  return TraceEvent::now() + network.latencyEstimate > deadline;
+}
+
+void HostManager::updateLatencyEstimate(NetworkData &network,
+                                        uint64_t duration) {
+  // Exponential moving average weighting the newest run by 1/8. Concurrent
+  // updates may drop a sample, which is fine for an estimate.
+  uint64_t estimate = network.latencyEstimate.load(std::memory_order_relaxed);
+  estimate = estimate ? estimate - estimate / 8 + duration / 8 : duration;
+  network.latencyEstimate.store(estimate, std::memory_order_relaxed);
+}
+
+void HostManager::shedRequest(llvm::StringRef networkName,
+                              RunIdentifierTy runID, uint64_t deadline,
+                              std::unique_ptr<ExecutionContext> context,
+                              ResultCBTy callback) {
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    auto it = networks_.find(networkName.str());
+    if (it != networks_.end()) {
+      it->second.refcount--;
+    }
+  }
+  statsExporterRegistry_->incrementCounter(
+      (llvm::Twine(kRequestsShed) + "." + networkName).str());
+  statsExporterRegistry_->incrementCounter(
+      (llvm::Twine(kRequestsShed) + ".global").str());
+  callback(runID,
+           MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
+                    strFormat("Request for network %s can't meet its "
+                              "deadline, %ld us left",
+                              networkName.str().c_str(),
+                              static_cast<long>(deadline - TraceEvent::now()))),
+           std::move(context));
+}
+
+void HostManager::dropCancelledRequest(
+    llvm::StringRef networkName, RunIdentifierTy runID,
+    std::unique_ptr<ExecutionContext> context, ResultCBTy callback) {
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    auto it = networks_.find(networkName.str());
+    if (it != networks_.end()) {
+      it->second.refcount--;
+    }
+  }
+  statsExporterRegistry_->incrementCounter(
+      (llvm::Twine(kRequestsCancelled) + "." + networkName).str());
+  statsExporterRegistry_->incrementCounter(
+      (llvm::Twine(kRequestsCancelled) + ".global").str());
+  callback(runID,
+           MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_CANCELLED,
+                    strFormat("Request for network %s was cancelled before "
+                              "being dispatched",
+                              networkName.str().c_str())),
+           std::move(context));
+}
+
+RunIdentifierTy
+HostManager::runNetworkImpl(llvm::StringRef networkName,
+                            std::unique_ptr<ExecutionContext> context,
+                            ResultCBTy callback, uint64_t priority,
+                            uint64_t deadline, bool allowBatching) {
   DCHECK(callback != nullptr);
 
+  // Requests the caller does not trace are traced as the continuous tracing
+  // sampler chooses, their trace being exported and dropped on completion.
+  auto sampler = context->getTraceContext()
+                     ? nullptr
+                     : TraceExporterRegistry::getInstance()->getSampler();
+  if (sampler) {
+    TraceLevel level = sampler->getRequestTraceLevel();
+    context->setTraceContext(glow::make_unique<TraceContext>(level));
+    uint64_t start = TraceEvent::now();
+    std::string netName = networkName.str();
+    callback = [callback, level, start, netName](
+                   RunIdentifierTy runID, Error err,
+                   std::unique_ptr<ExecutionContext> ctx) {
+      if (auto traceContext = ctx->setTraceContext(nullptr)) {
+        traceContext->logCompleteTraceEvent(
+            netName, TraceLevel::REQUEST, start,
+            {{"glowRequestId", std::to_string(runID)}});
+        TraceExporterRegistry::getInstance()->exportSampledTrace(
+            traceContext.get(), level, TraceEvent::now() - start);
+      }
+      callback(runID, std::move(err), std::move(ctx));
+    };
+  }
+
   auto *traceContext = context->getTraceContext();
   size_t eventTag = threads::getThreadId();
   if (traceContext && glow::flags::useInferencePerspectiveTrace) {
@@ -975,9 +2025,15 @@ HostManager::runNetwork(llvm::StringRef networkName,
   size_t queueSize = 0;
 
   NetworkData *network = nullptr;
+  RequestBatcher *batcher = nullptr;
+  bool shed = false;
+  bool cached = false;
+  // Name in networks_ of the version the request runs on.
+  std::string name;
   {
     std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
-    auto it = networks_.find(networkName.str());
+    name = getRoutedName(networkName.str());
+    auto it = networks_.find(name);
     if (it != networks_.end()) {
       network = &it->second;
       network->refcount++;
@@ -992,41 +2048,120 @@ HostManager::runNetwork(llvm::StringRef networkName,
           std::move(context));
       return currentRun;
     }
-    // Put the request in the queue.
-    {
-      std::shared_lock<std::shared_timed_mutex> lock(inferQueueLock_);
-      queueSize = inferQueue_.size();
-      if (queueSize >= config_.maxQueueSize) {
-        // The queue is full, return an error.
-        network->refcount--;
-        TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
-        callback(
-            currentRun,
-            MAKE_ERR(
-                ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
-                strFormat(
-                    "The number of allowed queued requests has been exceeded. "
-                    "queued requests: %lu allowed requests: %zu",
-                    queueSize, config_.maxQueueSize)),
-            std::move(context));
-        return currentRun;
+    // Requests the result cache has the outputs of are not run, the others
+    // fill it once they succeed. The runs batched by a RequestBatcher were
+    // looked up as separate requests.
+    if (allowBatching && network->resultCache) {
+      auto resultCache = network->resultCache;
+      auto key = resultCache->getKey(*context);
+      if (key.hasValue()) {
+        cached = resultCache->lookup(key.getValue(), *context);
+        const char *counter = cached ? kResultCacheHits : kResultCacheMisses;
+        statsExporterRegistry_->incrementCounter(
+            (llvm::Twine(counter) + "." + name).str());
+        statsExporterRegistry_->incrementCounter(
+            (llvm::Twine(counter) + ".global").str());
+      }
+      if (key.hasValue() && !cached) {
+        auto stats = statsExporterRegistry_;
+        const std::string bytesKey =
+            (llvm::Twine(kResultCacheBytes) + "." + name).str();
+        callback = [resultCache, key, stats, bytesKey, callback](
+                       RunIdentifierTy runID, Error err,
+                       std::unique_ptr<ExecutionContext> ctx) {
+          if (!err.peekErrorValue()) {
+            resultCache->insert(key.getValue(), *ctx);
+            stats->setCounter(bytesKey, resultCache->getSizeInBytes());
+          }
+          callback(runID, std::move(err), std::move(ctx));
+        };
       }
     }
-    reportCurrentQueueSize(queueSize);
-    // Setup the request
-    InferRequest queuedRequest(networkName.str(), std::move(context), callback,
-                               priority, currentRun, requestReceived);
-    {
-      TRACE_EVENT_TAG_BEGIN(traceContext, TraceLevel::RUNTIME,
+    shed = !cached && deadline && missesDeadline(*network, deadline);
+    // Requests to networks with batching enabled are held back until they
+    // can be combined with others into a single run.
+    if (cached) {
+      network->refcount--;
+      // Answered below, once networkLock_ has been released.
+    } else if (shed) {
+      // Refused below, once networkLock_ has been released.
+    } else if (allowBatching && network->batcher &&
+               network->batcher->getBatchRows(*context)) {
+      batcher = network->batcher.get();
+    } else {
+      // Put the request in the queue.
+      {
+        std::shared_lock<std::shared_timed_mutex> lock(inferQueueLock_);
+        queueSize = numQueuedRequests_;
+        if (queueSize >= config_.maxQueueSize) {
+          // The queue is full, return an error.
+          network->refcount--;
+          TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+          callback(currentRun,
+                   MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
+                            strFormat("The number of allowed queued requests "
+                                      "has been exceeded. queued requests: "
+                                      "%lu allowed requests: %zu",
+                                      queueSize, config_.maxQueueSize)),
+                   std::move(context));
+          return currentRun;
+        }
+      }
+      reportCurrentQueueSize(queueSize);
+      // Setup the request
+      InferRequest queuedRequest(name, std::move(context), callback, priority,
+                                 currentRun, requestReceived, deadline);
+      {
+        TRACE_EVENT_TAG_BEGIN(traceContext, TraceLevel::RUNTIME,
+                              "inferQueueLock (push)", eventTag);
+        std::unique_lock<std::shared_timed_mutex> lock(inferQueueLock_);
+        TRACE_EVENT_TAG_END(traceContext, TraceLevel::RUNTIME,
                             "inferQueueLock (push)", eventTag);
-      std::unique_lock<std::shared_timed_mutex> lock(inferQueueLock_);
-      TRACE_EVENT_TAG_END(traceContext, TraceLevel::RUNTIME,
-                          "inferQueueLock (push)", eventTag);
-      inferQueue_.push(std::move(queuedRequest));
-      TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+        auto &queue = inferQueues_[name];
+        if (queue.requests.empty()) {
+          queue.pass = std::max(queue.pass, schedulingVirtualTime_);
+        }
+        queue.requests.push(std::move(queuedRequest));
+        numQueuedRequests_++;
+        TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+      }
     }
   }
 
+  if (cached) {
+    TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+    callback(currentRun, Error::success(), std::move(context));
+    return currentRun;
+  }
+
+  if (shed) {
+    TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+    shedRequest(name, currentRun, deadline, std::move(context),
+                std::move(callback));
+    return currentRun;
+  }
+
+  if (batcher) {
+    TRACE_EVENT_SCOPE_END_NAMED(traceBlock);
+    // Each batched request keeps its reference on the network until its own
+    // callback is called.
+    batcher->enqueue(
+        std::move(context),
+        [this, name, callback](RunIdentifierTy runID, Error err,
+                               std::unique_ptr<ExecutionContext> context) {
+          {
+            std::shared_lock<std::shared_timed_mutex> netLock(networkLock_);
+            auto it = networks_.find(name);
+            if (it != networks_.end()) {
+              it->second.refcount--;
+            }
+          }
+          callback(runID, std::move(err), std::move(context));
+        },
+        currentRun, priority, deadline);
+    return currentRun;
+  }
+
   // If we haven't reached maxActiveRequests kick off next request.
   size_t activeRequestCount = activeRequestCount_++;
   if (activeRequestCount < config_.maxActiveRequests) {
@@ -1158,6 +2293,131 @@ Expected<Backend *> HostManager::getBackend() const {
   return provisioner_->getBackend();
 }
 
+Expected<DeviceInfo> HostManager::getDeviceInfo(DeviceIDTy deviceID) const {
+  auto it = devices_.find(deviceID);
+  RETURN_ERR_IF_NOT(it != devices_.end(),
+                    strFormat("Unknown device %zu", (size_t)deviceID));
+  return it->second->getDeviceInfo();
+}
+
+Error HostManager::addToHealthyDevice(DAGNode &node, const Module &module) {
+  DeviceIDTy targetID = 0;
+  DeviceManager *target = nullptr;
+  uint64_t targetMemory = 0;
+  for (auto &device : devices_) {
+    if (unhealthyDevices_.count(device.first) ||
+        node.deviceRuntimeInfos.count(device.first) ||
+        device.second->getBackendName() != node.backendName ||
+        !device.second->isMemoryAvailable(node.size)) {
+      continue;
+    }
+    uint64_t availableMemory = device.second->getAvailableMemory();
+    if (!target || availableMemory > targetMemory) {
+      targetID = device.first;
+      target = device.second.get();
+      targetMemory = availableMemory;
+    }
+  }
+  RETURN_ERR_IF_NOT(target, "No healthy device can run " + node.name);
+  RETURN_IF_ERR(provisioner_->addCompiledFunction(node.name, module, target));
+
+  {
+    std::lock_guard<std::mutex> nameLock(node.nameLock);
+    node.alternateFunction[targetID] = 0;
+  }
+  std::lock_guard<std::mutex> nodeLock(node.lock);
+  node.deviceRuntimeInfos[targetID] = DeviceRuntimeInfo();
+  LOG(INFO) << "Moved " << node.name << " to device " << targetID;
+  return Error::success();
+}
+
+Error HostManager::markDeviceUnhealthy(DeviceIDTy deviceID) {
+  RETURN_ERR_IF_NOT(devices_.count(deviceID),
+                    strFormat("Unknown device %zu", (size_t)deviceID));
+  std::lock_guard<std::mutex> healthLock(healthLock_);
+  if (unhealthyDevices_.count(deviceID)) {
+    return Error::success();
+  }
+  LOG(WARNING) << "Device " << deviceID << " is unhealthy";
+
+  // Stop adding new networks to the device.
+  std::vector<DeviceIDTy> healthyDevices;
+  bool wasAvailable = false;
+  for (auto device : availableDevices_) {
+    if (device == deviceID) {
+      wasAvailable = true;
+    } else {
+      healthyDevices.push_back(device);
+    }
+  }
+  unhealthyDevices_[deviceID] = wasAvailable;
+  if (wasAvailable) {
+    setAvailableDevices(healthyDevices);
+  }
+
+  // Route the runs of the partitions to their other devices, or add the
+  // partitions to a healthy device if they have none.
+  std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+  size_t numFailed = 0;
+  for (auto &network : networks_) {
+    for (auto &node : network.second.dag.nodes) {
+      {
+        std::lock_guard<std::mutex> nodeLock(node->lock);
+        auto &infos = node->deviceRuntimeInfos;
+        auto it = infos.find(deviceID);
+        if (it == infos.end()) {
+          continue;
+        }
+        it->second.available = false;
+        if (std::any_of(infos.begin(), infos.end(), [](const auto &info) {
+              return info.second.available;
+            })) {
+          continue;
+        }
+      }
+      if (Error err = addToHealthyDevice(*node, *network.second.module)) {
+        LOG(ERROR) << ERR_TO_STRING(std::move(err));
+        numFailed++;
+      }
+    }
+  }
+  RETURN_ERR_IF_NOT(numFailed == 0,
+                    strFormat("%zu partitions can't run without device %zu",
+                              numFailed, (size_t)deviceID));
+  return Error::success();
+}
+
+Error HostManager::markDeviceHealthy(DeviceIDTy deviceID) {
+  RETURN_ERR_IF_NOT(devices_.count(deviceID),
+                    strFormat("Unknown device %zu", (size_t)deviceID));
+  std::lock_guard<std::mutex> healthLock(healthLock_);
+  auto it = unhealthyDevices_.find(deviceID);
+  if (it == unhealthyDevices_.end()) {
+    return Error::success();
+  }
+  LOG(INFO) << "Device " << deviceID << " is healthy again";
+  bool wasAvailable = it->second;
+  unhealthyDevices_.erase(it);
+  {
+    std::shared_lock<std::shared_timed_mutex> networkLock(networkLock_);
+    for (auto &network : networks_) {
+      for (auto &node : network.second.dag.nodes) {
+        std::lock_guard<std::mutex> nodeLock(node->lock);
+        auto infoIt = node->deviceRuntimeInfos.find(deviceID);
+        if (infoIt != node->deviceRuntimeInfos.end()) {
+          infoIt->second.available = true;
+        }
+      }
+    }
+  }
+  if (wasAvailable) {
+    std::vector<DeviceIDTy> devices = availableDevices_;
+    devices.push_back(deviceID);
+    setAvailableDevices(devices);
+  }
+  return Error::success();
+}
+
 std::unique_ptr<
     std::unordered_map<std::string, std::unique_ptr<BlockStreamBase>>>
 HostManager::getAllSerializedFunctions() {
@@ -0,0 +1,282 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/HostManager/RequestBatcher.h"
+#include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Runtime/StatsExporter.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+/// \returns the number of bytes in a single row (dimension 0 slice) of \p T.
+size_t getRowSize(const Tensor &T) {
+  return T.dims()[0] ? T.getSizeInBytes() / T.dims()[0] : 0;
+}
+} // namespace
+
+RequestBatcher::RequestBatcher(const DAG &dag,
+                               const RequestBatchingConfig &config,
+                               SubmitFnTy submit)
+    : config_(config), submit_(std::move(submit)) {
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      if (symbol.second.symbolCategory == SymbolCategory::Placeholder &&
+          symbol.second.output) {
+        outputNames_.insert(symbol.first);
+      }
+    }
+  }
+  timer_ = std::thread([this]() { timerMain(); });
+}
+
+RequestBatcher::~RequestBatcher() {
+  flush();
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  timer_.join();
+}
+
+dim_t RequestBatcher::getBatchRows(const ExecutionContext &context) const {
+  if (!context.getExternalIOBindings().empty()) {
+    return 0;
+  }
+  const auto *bindings = context.getPlaceholderBindings();
+  if (!bindings || bindings->pairs().empty()) {
+    return 0;
+  }
+
+  dim_t rows = 0;
+  for (const auto &pair : bindings->pairs()) {
+    const TypeRef phTy = pair.first->getType();
+    const Tensor &T = pair.second;
+    if (T.getElementType() != phTy->getElementType() ||
+        T.dims().size() != phTy->dims().size() || T.dims().empty() ||
+        T.dims().drop_front() != phTy->dims().drop_front() ||
+        T.dims()[0] == 0 || T.dims()[0] > phTy->dims()[0] ||
+        T.getUnpaddedSizeInBytes() != T.getSizeInBytes()) {
+      return 0;
+    }
+    if (rows && rows != T.dims()[0]) {
+      return 0;
+    }
+    rows = T.dims()[0];
+  }
+  return rows;
+}
+
+bool RequestBatcher::matchesPending(const ExecutionContext &context) const {
+  const auto &pendingPairs =
+      pending_.front().context->getPlaceholderBindings()->pairs();
+  const auto &pairs = context.getPlaceholderBindings()->pairs();
+  if (pendingPairs.size() != pairs.size()) {
+    return false;
+  }
+  return std::all_of(pairs.begin(), pairs.end(), [&](const auto &pair) {
+    return pendingPairs.count(pair.first);
+  });
+}
+
+void RequestBatcher::enqueue(std::unique_ptr<ExecutionContext> context,
+                             ResultCBTy callback, RunIdentifierTy runId,
+                             uint64_t priority, uint64_t deadline) {
+  const dim_t rows = getBatchRows(*context);
+  DCHECK_GT(rows, 0) << "Request is not batchable";
+
+  std::vector<PendingRequest> ready;
+  std::vector<PendingRequest> full;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // Close off the current batch if the new request doesn't fit into it.
+    if (!pending_.empty() && (!matchesPending(*context) ||
+                              pendingRows_ + rows > pendingCapacity_)) {
+      ready = std::move(pending_);
+      pending_.clear();
+      pendingRows_ = 0;
+    }
+
+    if (pending_.empty()) {
+      // The batch can hold as many rows as the smallest Placeholder.
+      pendingCapacity_ = std::numeric_limits<dim_t>::max();
+      for (const auto &pair : context->getPlaceholderBindings()->pairs()) {
+        pendingCapacity_ =
+            std::min(pendingCapacity_, pair.first->getType()->dims()[0]);
+      }
+      if (config_.maxBatchSize) {
+        pendingCapacity_ = std::min(pendingCapacity_, config_.maxBatchSize);
+      }
+      oldestPending_ = std::chrono::steady_clock::now();
+    }
+
+    pending_.push_back({std::move(context), std::move(callback), runId,
+                        priority, deadline, rows});
+    pendingRows_ += rows;
+
+    if (pendingRows_ >= pendingCapacity_) {
+      full = std::move(pending_);
+      pending_.clear();
+      pendingRows_ = 0;
+    }
+  }
+  // Let the timer thread pick up the deadline of a new batch.
+  cv_.notify_one();
+
+  if (!ready.empty()) {
+    submitBatch(std::move(ready));
+  }
+  if (!full.empty()) {
+    submitBatch(std::move(full));
+  }
+}
+
+void RequestBatcher::flush() {
+  std::vector<PendingRequest> ready;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ready = std::move(pending_);
+    pending_.clear();
+    pendingRows_ = 0;
+  }
+  if (!ready.empty()) {
+    submitBatch(std::move(ready));
+  }
+}
+
+void RequestBatcher::timerMain() {
+  const auto maxWait = std::chrono::microseconds(config_.maxWaitUs);
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (!stopping_) {
+    if (pending_.empty()) {
+      cv_.wait(lock);
+      continue;
+    }
+    const auto deadline = oldestPending_ + maxWait;
+    if (std::chrono::steady_clock::now() < deadline) {
+      cv_.wait_until(lock, deadline);
+      continue;
+    }
+    std::vector<PendingRequest> ready = std::move(pending_);
+    pending_.clear();
+    pendingRows_ = 0;
+    lock.unlock();
+    submitBatch(std::move(ready));
+    lock.lock();
+  }
+}
+
+void RequestBatcher::submitBatch(std::vector<PendingRequest> batch) {
+  // A single request that already fills every Placeholder doesn't need to be
+  // copied around.
+  const auto &pairs = batch.front().context->getPlaceholderBindings()->pairs();
+  if (batch.size() == 1 &&
+      std::all_of(pairs.begin(), pairs.end(), [&](const auto &pair) {
+        return pair.first->getType()->dims()[0] == batch.front().rows;
+      })) {
+    auto &request = batch.front();
+    submit_(std::move(request.context), std::move(request.callback),
+            request.priority, request.deadline);
+    return;
+  }
+
+  StatsExporterRegistry::Stats()->addTimeSeriesValue(kBatchedRequests,
+                                                     batch.size());
+
+  // Concatenate the requests' tensors along dimension 0. Any rows past the
+  // last request are zeroed.
+  auto batchCtx = glow::make_unique<ExecutionContext>();
+  auto *batchBindings = batchCtx->getPlaceholderBindings();
+  uint64_t priority = batch.front().priority;
+  uint64_t deadline = 0;
+  for (const auto &pair : pairs) {
+    Placeholder *PH = pair.first;
+    Tensor *batchT = batchBindings->allocate(PH);
+    const size_t rowSize = getRowSize(*batchT);
+    char *dst = batchT->getUnsafePtr();
+    size_t offset = 0;
+    for (auto &request : batch) {
+      const Tensor *T = request.context->getPlaceholderBindings()->get(PH);
+      std::memcpy(dst + offset, T->getUnsafePtr(), request.rows * rowSize);
+      offset += request.rows * rowSize;
+    }
+    std::memset(dst + offset, 0, batchT->getSizeInBytes() - offset);
+  }
+  for (const auto &request : batch) {
+    priority = std::min(priority, request.priority);
+    if (request.deadline && (!deadline || request.deadline < deadline)) {
+      deadline = request.deadline;
+    }
+  }
+
+  auto members =
+      std::make_shared<std::vector<PendingRequest>>(std::move(batch));
+  submit_(std::move(batchCtx),
+          [this, members](RunIdentifierTy, Error err,
+                          std::unique_ptr<ExecutionContext> resultCtx) {
+            scatterResults(*members, std::move(err), std::move(resultCtx));
+          },
+          priority, deadline);
+}
+
+void RequestBatcher::scatterResults(
+    std::vector<PendingRequest> &batch, Error err,
+    std::unique_ptr<ExecutionContext> batchCtx) {
+  std::string errMsg;
+  ErrorValue::ErrorCode errCode = ErrorValue::ErrorCode::UNKNOWN;
+  if (err.peekErrorValue()) {
+    errCode = err.peekErrorValue()->getErrorCode();
+  }
+  const bool failed = static_cast<bool>(err);
+  if (failed) {
+    errMsg = ERR_TO_STRING(std::move(err));
+  }
+
+  auto *batchBindings = batchCtx->getPlaceholderBindings();
+  size_t rowOffset = 0;
+  for (auto &request : batch) {
+    if (!failed) {
+      for (auto &pair : request.context->getPlaceholderBindings()->pairs()) {
+        if (!outputNames_.count(pair.first->getName().str())) {
+          continue;
+        }
+        const Tensor *batchT = batchBindings->get(pair.first);
+        const size_t rowSize = getRowSize(*batchT);
+        std::memcpy(pair.second.getUnsafePtr(),
+                    batchT->getUnsafePtr() + rowOffset * rowSize,
+                    request.rows * rowSize);
+      }
+    }
+    rowOffset += request.rows;
+
+    Error requestErr = Error::success();
+    if (failed) {
+      requestErr = MAKE_ERR(errCode, "Batched run failed: " + errMsg);
+    }
+    request.callback(request.runId, std::move(requestErr),
+                     std::move(request.context));
+  }
+}
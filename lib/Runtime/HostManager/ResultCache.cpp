@@ -0,0 +1,174 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/HostManager/ResultCache.h"
+#include "glow/Graph/PlaceholderBindings.h"
+
+#include "llvm/ADT/Hashing.h"
+
+#include <cstring>
+
+using namespace glow;
+using namespace glow::runtime;
+
+ResultCache::ResultCache(const DAG &dag, const ResultCacheConfig &config)
+    : config_(config) {
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      if (symbol.second.symbolCategory == SymbolCategory::Placeholder &&
+          symbol.second.output) {
+        outputNames_.insert(symbol.first);
+        if (symbol.second.input) {
+          inOutNames_.insert(symbol.first);
+        }
+      }
+    }
+  }
+}
+
+bool ResultCache::isInput(const Placeholder *PH) const {
+  const std::string name = PH->getName().str();
+  return !outputNames_.count(name) || inOutNames_.count(name);
+}
+
+llvm::Optional<uint64_t>
+ResultCache::getKey(const ExecutionContext &context) const {
+  const auto *bindings = context.getPlaceholderBindings();
+  if (!context.getExternalIOBindings().empty() || !bindings) {
+    return llvm::None;
+  }
+  uint64_t key = 0;
+  for (const auto &pair : bindings->pairs()) {
+    const Tensor &T = pair.second;
+    if (T.isDeviceResident() ||
+        T.getUnpaddedSizeInBytes() != T.getSizeInBytes()) {
+      return llvm::None;
+    }
+    if (!isInput(pair.first)) {
+      continue;
+    }
+    // Summed so that the key doesn't depend on the order of the bindings.
+    key += llvm::hash_combine(
+        pair.first, T.getElementType(),
+        llvm::hash_combine_range(T.dims().begin(), T.dims().end()),
+        llvm::StringRef(T.getUnsafePtr(), T.getSizeInBytes()));
+  }
+  return key;
+}
+
+bool ResultCache::matches(const Entry &entry,
+                          const ExecutionContext &context) const {
+  const auto *bindings = context.getPlaceholderBindings();
+  size_t numInputs = 0;
+  for (const auto &pair : bindings->pairs()) {
+    numInputs += isInput(pair.first);
+  }
+  if (numInputs != entry.inputs.size()) {
+    return false;
+  }
+  for (const auto &input : entry.inputs) {
+    const Tensor *T = bindings->get(input.first);
+    if (!T || !T->getType().isEqual(input.second.getType()) ||
+        std::memcmp(T->getUnsafePtr(), input.second.getUnsafePtr(),
+                    T->getSizeInBytes())) {
+      return false;
+    }
+  }
+  for (const auto &output : entry.outputs) {
+    const Tensor *T = bindings->get(output.first);
+    if (!T || !T->getType().isEqual(output.second.getType())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ResultCache::lookup(uint64_t key, ExecutionContext &context) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto indexIt = index_.find(key);
+  if (indexIt == index_.end()) {
+    return false;
+  }
+  auto it = indexIt->second;
+  if (TraceEvent::now() > it->expiry) {
+    erase(it);
+    return false;
+  }
+  if (!matches(*it, context)) {
+    return false;
+  }
+  auto *bindings = context.getPlaceholderBindings();
+  for (const auto &output : it->outputs) {
+    bindings->get(output.first)->copyRawFrom(&output.second);
+  }
+  entries_.splice(entries_.begin(), entries_, it);
+  return true;
+}
+
+void ResultCache::insert(uint64_t key, const ExecutionContext &context) {
+  Entry entry;
+  entry.key = key;
+  entry.bytes = 0;
+  for (const auto &pair : context.getPlaceholderBindings()->pairs()) {
+    if (isInput(pair.first)) {
+      entry.inputs.emplace_back(pair.first, pair.second.clone());
+      entry.bytes += pair.second.getSizeInBytes();
+    }
+    if (outputNames_.count(pair.first->getName().str())) {
+      entry.outputs.emplace_back(pair.first, pair.second.clone());
+      entry.bytes += pair.second.getSizeInBytes();
+    }
+  }
+  if (entry.bytes > config_.maxBytes) {
+    return;
+  }
+  const uint64_t now = TraceEvent::now();
+  entry.expiry = now + config_.ttlUs;
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto indexIt = index_.find(key);
+  if (indexIt != index_.end()) {
+    erase(indexIt->second);
+  }
+  // Make room by dropping the stale results, then the least recently used.
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto next = std::next(it);
+    if (now > it->expiry) {
+      erase(it);
+    }
+    it = next;
+  }
+  while (bytes_ + entry.bytes > config_.maxBytes) {
+    erase(std::prev(entries_.end()));
+  }
+  bytes_ += entry.bytes;
+  entries_.push_front(std::move(entry));
+  index_[key] = entries_.begin();
+}
+
+uint64_t ResultCache::getSizeInBytes() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return bytes_;
+}
+
+void ResultCache::erase(EntryList::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
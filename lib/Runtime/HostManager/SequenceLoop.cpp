@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/HostManager/SequenceLoop.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Runtime/StatsExporter.h"
+#include "glow/Support/Support.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+/// \returns the tensor bound in \p bindings to the Placeholder named like
+/// \p PH, or nullptr if there is none.
+const Tensor *getTensorByName(const PlaceholderBindings *bindings,
+                              const Placeholder *PH) {
+  Placeholder *boundPH = bindings->getPlaceholderByNameSlow(PH->getName());
+  return boundPH ? bindings->get(boundPH) : nullptr;
+}
+
+/// \returns whether \p T has the element type of \p PH and the dimensions
+/// \p dims, and no padding.
+bool matches(const Tensor &T, const Placeholder *PH,
+             llvm::ArrayRef<dim_t> dims) {
+  return T.getElementType() == PH->getElementType() && T.dims() == dims &&
+         T.getUnpaddedSizeInBytes() == T.getSizeInBytes();
+}
+} // namespace
+
+Expected<std::unique_ptr<SequenceLoop>>
+SequenceLoop::create(const SequenceLoopConfig &config,
+                     const std::string &networkName, const DAG &dag,
+                     const Module &module) {
+  std::unique_ptr<SequenceLoop> loop(new SequenceLoop(config, networkName));
+  std::unordered_set<std::string> listed;
+  auto getPlaceholder =
+      [&](const std::string &name) -> Expected<Placeholder *> {
+    Placeholder *PH = module.getPlaceholderByNameSlow(name);
+    RETURN_ERR_IF_NOT(PH, strFormat("Placeholder %s of sequence loop %s not "
+                                    "found",
+                                    name.c_str(), networkName.c_str()));
+    RETURN_ERR_IF_NOT(listed.insert(name).second,
+                      strFormat("Placeholder %s of sequence loop %s is listed "
+                                "more than once",
+                                name.c_str(), networkName.c_str()));
+    return PH;
+  };
+
+  RETURN_ERR_IF_NOT(!config.stepInputs.empty(),
+                    "A sequence loop requires at least one step input");
+  for (const auto *names : {&config.stepInputs, &config.stepOutputs}) {
+    for (const auto &name : *names) {
+      Placeholder *PH;
+      ASSIGN_VALUE_OR_RETURN_ERR(PH, getPlaceholder(name));
+      loop->stepPlaceholders_.push_back(PH);
+    }
+  }
+  for (const auto &state : config.states) {
+    Placeholder *in;
+    Placeholder *out;
+    ASSIGN_VALUE_OR_RETURN_ERR(in, getPlaceholder(state.first));
+    ASSIGN_VALUE_OR_RETURN_ERR(out, getPlaceholder(state.second));
+    RETURN_ERR_IF_NOT(in->getType()->isEqual(*out->getType()),
+                      strFormat("State %s and %s of sequence loop %s don't "
+                                "have the same type",
+                                state.first.c_str(), state.second.c_str(),
+                                networkName.c_str()));
+    loop->statePlaceholders_.emplace_back(in, out);
+  }
+
+  // The other Placeholders requests bind are those the DAG reads or writes,
+  // except the ones passing results from one of its nodes to another, which
+  // the Executor allocates.
+  std::unordered_map<std::string, const DAGNode *> writers;
+  std::unordered_map<std::string, const DAGNode *> readers;
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      if (symbol.second.symbolCategory != SymbolCategory::Placeholder) {
+        continue;
+      }
+      if (symbol.second.output) {
+        writers.emplace(symbol.first, node.get());
+      }
+      if (symbol.second.input) {
+        readers.emplace(symbol.first, node.get());
+      }
+    }
+  }
+  std::unordered_set<std::string> seen;
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      const std::string &name = symbol.first;
+      if (symbol.second.symbolCategory != SymbolCategory::Placeholder ||
+          listed.count(name) || !seen.insert(name).second) {
+        continue;
+      }
+      auto writer = writers.find(name);
+      auto reader = readers.find(name);
+      if (writer != writers.end() && reader != readers.end() &&
+          writer->second != reader->second) {
+        continue;
+      }
+      Placeholder *PH = module.getPlaceholderByNameSlow(name);
+      RETURN_ERR_IF_NOT(PH, strFormat("Placeholder %s of sequence loop %s not "
+                                      "found",
+                                      name.c_str(), networkName.c_str()));
+      loop->otherPlaceholders_.push_back(PH);
+    }
+  }
+  return std::move(loop);
+}
+
+Expected<dim_t>
+SequenceLoop::getNumSteps(const ExecutionContext &context) const {
+  RETURN_ERR_IF_NOT(context.getExternalIOBindings().empty(),
+                    "Sequence loop requests can't use external IO bindings");
+  const auto *bindings = context.getPlaceholderBindings();
+  auto getTensor = [&](const Placeholder *PH) -> Expected<const Tensor *> {
+    const Tensor *T = getTensorByName(bindings, PH);
+    RETURN_ERR_IF_NOT(T, strFormat("Request doesn't bind the Placeholder %s",
+                                   PH->getName().data()));
+    return T;
+  };
+
+  dim_t steps = 0;
+  for (size_t i = 0, e = stepPlaceholders_.size(); i < e; i++) {
+    const Placeholder *PH = stepPlaceholders_[i];
+    const Tensor *T;
+    ASSIGN_VALUE_OR_RETURN_ERR(T, getTensor(PH));
+    if (i == 0 && !T->dims().empty()) {
+      steps = T->dims()[0];
+    }
+    std::vector<dim_t> dims{steps};
+    dims.insert(dims.end(), PH->dims().begin(), PH->dims().end());
+    RETURN_ERR_IF_NOT(matches(*T, PH, dims),
+                      strFormat("Tensor of the step Placeholder %s doesn't "
+                                "have %lu rows of its type",
+                                PH->getName().data(), (unsigned long)steps));
+  }
+  std::vector<const Placeholder *> others(otherPlaceholders_.begin(),
+                                          otherPlaceholders_.end());
+  for (const auto &state : statePlaceholders_) {
+    others.push_back(state.first);
+    others.push_back(state.second);
+  }
+  for (const Placeholder *PH : others) {
+    const Tensor *T;
+    ASSIGN_VALUE_OR_RETURN_ERR(T, getTensor(PH));
+    RETURN_ERR_IF_NOT(matches(*T, PH, PH->dims()),
+                      strFormat("Tensor of the Placeholder %s doesn't match "
+                                "its type",
+                                PH->getName().data()));
+  }
+  if (config_.maxSteps && steps > config_.maxSteps) {
+    return MAKE_ERR(
+        ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
+        strFormat("A request of %lu steps is longer than the %lu steps of "
+                  "sequence loop %s",
+                  (unsigned long)steps, (unsigned long)config_.maxSteps,
+                  networkName_.c_str()));
+  }
+  StatsExporterRegistry::Stats()->addTimeSeriesValue(kSteps, steps);
+  return steps;
+}
+
+std::unique_ptr<ExecutionContext>
+SequenceLoop::createStepContext(const ExecutionContext &context) const {
+  auto stepCtx = glow::make_unique<ExecutionContext>();
+  auto *stepBindings = stepCtx->getPlaceholderBindings();
+  const auto *bindings = context.getPlaceholderBindings();
+  for (Placeholder *PH : otherPlaceholders_) {
+    stepBindings->insert(PH, getTensorByName(bindings, PH)->getUnowned());
+  }
+  for (const auto &state : statePlaceholders_) {
+    const Tensor *initial = getTensorByName(bindings, state.first);
+    std::memcpy(stepBindings->allocate(state.first)->getUnsafePtr(),
+                initial->getUnsafePtr(), initial->getSizeInBytes());
+    stepBindings->allocate(state.second);
+  }
+  return stepCtx;
+}
+
+void SequenceLoop::bindStep(const ExecutionContext &context,
+                            ExecutionContext &stepCtx, dim_t step) const {
+  auto *stepBindings = stepCtx.getPlaceholderBindings();
+  const auto *bindings = context.getPlaceholderBindings();
+  for (Placeholder *PH : stepPlaceholders_) {
+    const Tensor *T = getTensorByName(bindings, PH);
+    std::vector<dim_t> offsets(T->dims().size(), 0);
+    offsets[0] = step;
+    Tensor row = T->getUnowned(PH->dims(), offsets);
+    if (stepBindings->count(PH)) {
+      stepBindings->update(PH, std::move(row));
+    } else {
+      stepBindings->insert(PH, std::move(row));
+    }
+  }
+}
+
+void SequenceLoop::nextStep(ExecutionContext &stepCtx) const {
+  auto *stepBindings = stepCtx.getPlaceholderBindings();
+  for (const auto &state : statePlaceholders_) {
+    std::swap(*stepBindings->get(state.first),
+              *stepBindings->get(state.second));
+  }
+}
+
+void SequenceLoop::finish(const ExecutionContext *stepCtx,
+                          ExecutionContext &context) const {
+  auto *bindings = context.getPlaceholderBindings();
+  for (const auto &state : statePlaceholders_) {
+    const Tensor *last =
+        stepCtx ? stepCtx->getPlaceholderBindings()->get(state.second)
+                : getTensorByName(bindings, state.first);
+    Tensor *T = bindings->get(
+        bindings->getPlaceholderByNameSlow(state.second->getName()));
+    std::memcpy(T->getUnsafePtr(), last->getUnsafePtr(), T->getSizeInBytes());
+  }
+}
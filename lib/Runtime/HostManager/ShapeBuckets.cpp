@@ -0,0 +1,212 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Runtime/HostManager/ShapeBuckets.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Graph/PlaceholderBindings.h"
+#include "glow/Runtime/StatsExporter.h"
+#include "glow/Support/Support.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+/// \returns the number of bytes in a single row (dimension 0 slice) of \p T.
+size_t getRowSize(const Tensor &T) {
+  return T.dims()[0] ? T.getSizeInBytes() / T.dims()[0] : 0;
+}
+
+/// \returns the tensor bound in \p bindings to the Placeholder named like
+/// \p PH, or nullptr if there is none.
+const Tensor *getTensorByName(const PlaceholderBindings *bindings,
+                              const Placeholder *PH) {
+  if (!bindings) {
+    return nullptr;
+  }
+  Placeholder *boundPH = bindings->getPlaceholderByNameSlow(PH->getName());
+  return boundPH ? bindings->get(boundPH) : nullptr;
+}
+} // namespace
+
+Error ShapeBuckets::addBucket(dim_t batchSize, const std::string &networkName,
+                              const DAG &dag, const Module &module) {
+  RETURN_ERR_IF_NOT(buckets_.empty() || buckets_.back().batchSize < batchSize,
+                    "Shape buckets must be added by increasing batch size");
+  Bucket bucket{batchSize, networkName, {}, {}, {}};
+
+  // Placeholders passing results from one partition of the network to
+  // another are written by one node of the DAG and read by another one. They
+  // are allocated by the Executor, and not bound by requests.
+  std::unordered_map<std::string, const DAGNode *> writers;
+  std::unordered_map<std::string, const DAGNode *> readers;
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      if (symbol.second.symbolCategory != SymbolCategory::Placeholder) {
+        continue;
+      }
+      if (symbol.second.output) {
+        writers.emplace(symbol.first, node.get());
+      }
+      if (symbol.second.input) {
+        readers.emplace(symbol.first, node.get());
+      }
+    }
+  }
+  auto isIntermediate = [&](const std::string &name) {
+    auto writer = writers.find(name);
+    auto reader = readers.find(name);
+    return writer != writers.end() && reader != readers.end() &&
+           writer->second != reader->second;
+  };
+
+  for (const auto &node : dag.nodes) {
+    if (!node->runtimeBundle) {
+      continue;
+    }
+    for (const auto &symbol : node->runtimeBundle->getSymbolTable()) {
+      const std::string &name = symbol.first;
+      if (symbol.second.symbolCategory != SymbolCategory::Placeholder ||
+          isIntermediate(name) || bucket.inputNames.count(name) ||
+          bucket.outputNames.count(name)) {
+        continue;
+      }
+      Placeholder *PH = module.getPlaceholderByNameSlow(name);
+      RETURN_ERR_IF_NOT(PH, strFormat("Placeholder %s of shape bucket %s not "
+                                      "found",
+                                      name.c_str(), networkName.c_str()));
+      auto dims = PH->getType()->dims();
+      RETURN_ERR_IF_NOT(!dims.empty() && dims[0] == batchSize,
+                        strFormat("Placeholder %s of shape bucket %s doesn't "
+                                  "have %lu rows",
+                                  name.c_str(), networkName.c_str(),
+                                  (unsigned long)batchSize));
+      if (writers.count(name)) {
+        bucket.outputNames.insert(name);
+      }
+      if (readers.count(name)) {
+        bucket.inputNames.insert(name);
+      }
+      bucket.placeholders.push_back(PH);
+    }
+  }
+
+  // Requests are checked against the first bucket, the others have to take
+  // the same tensors.
+  if (!buckets_.empty()) {
+    const Bucket &first = buckets_.front();
+    RETURN_ERR_IF_NOT(
+        first.placeholders.size() == bucket.placeholders.size(),
+        strFormat("Shape bucket %s doesn't have the Placeholders of %s",
+                  networkName.c_str(), first.networkName.c_str()));
+    for (const Placeholder *PH : bucket.placeholders) {
+      auto it = std::find_if(first.placeholders.begin(),
+                             first.placeholders.end(), [&](Placeholder *P) {
+                               return P->getName() == PH->getName();
+                             });
+      RETURN_ERR_IF_NOT(
+          it != first.placeholders.end() &&
+              (*it)->getElementType() == PH->getElementType() &&
+              (*it)->dims().drop_front() == PH->dims().drop_front(),
+          strFormat("Placeholder %s of shape bucket %s doesn't match %s",
+                    PH->getName().data(), networkName.c_str(),
+                    first.networkName.c_str()));
+    }
+  }
+  buckets_.push_back(std::move(bucket));
+  return Error::success();
+}
+
+Expected<const ShapeBuckets::Bucket *>
+ShapeBuckets::getBucket(const ExecutionContext &context, dim_t &rows) const {
+  RETURN_ERR_IF_NOT(!buckets_.empty(), "No shape buckets");
+  RETURN_ERR_IF_NOT(context.getExternalIOBindings().empty(),
+                    "Shape bucketed requests can't use external IO bindings");
+  const auto *bindings = context.getPlaceholderBindings();
+  rows = 0;
+  for (const Placeholder *PH : buckets_.front().placeholders) {
+    const Tensor *T = getTensorByName(bindings, PH);
+    RETURN_ERR_IF_NOT(T, strFormat("Request doesn't bind the Placeholder %s",
+                                   PH->getName().data()));
+    const TypeRef phTy = PH->getType();
+    RETURN_ERR_IF_NOT(
+        T->getElementType() == phTy->getElementType() &&
+            T->dims().size() == phTy->dims().size() &&
+            T->dims().drop_front() == phTy->dims().drop_front() &&
+            T->getUnpaddedSizeInBytes() == T->getSizeInBytes(),
+        strFormat("Tensor of the Placeholder %s doesn't match its type",
+                  PH->getName().data()));
+    RETURN_ERR_IF_NOT(!rows || rows == T->dims()[0],
+                      "All the tensors of a shape bucketed request must have "
+                      "the same number of rows");
+    rows = T->dims()[0];
+  }
+  for (const auto &bucket : buckets_) {
+    if (rows && rows <= bucket.batchSize) {
+      return &bucket;
+    }
+  }
+  return MAKE_ERR(
+      ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED,
+      strFormat("A request of %lu rows doesn't fit any shape bucket of %s",
+                (unsigned long)rows, buckets_.back().networkName.c_str()));
+}
+
+std::unique_ptr<ExecutionContext>
+ShapeBuckets::pad(const Bucket &bucket, const ExecutionContext &context,
+                  dim_t rows) const {
+  StatsExporterRegistry::Stats()->addTimeSeriesValue(kPaddedRows,
+                                                     bucket.batchSize - rows);
+  auto bucketCtx = glow::make_unique<ExecutionContext>();
+  auto *bucketBindings = bucketCtx->getPlaceholderBindings();
+  const auto *bindings = context.getPlaceholderBindings();
+  for (Placeholder *PH : bucket.placeholders) {
+    Tensor *bucketT = bucketBindings->allocate(PH);
+    char *dst = bucketT->getUnsafePtr();
+    size_t size = 0;
+    // Outputs the network doesn't read are not copied, only zeroed.
+    if (bucket.inputNames.count(PH->getName().str())) {
+      const Tensor *T = getTensorByName(bindings, PH);
+      size = rows * getRowSize(*bucketT);
+      std::memcpy(dst, T->getUnsafePtr(), size);
+    }
+    std::memset(dst + size, 0, bucketT->getSizeInBytes() - size);
+  }
+  return bucketCtx;
+}
+
+void ShapeBuckets::unpad(const Bucket &bucket,
+                         const ExecutionContext &bucketCtx,
+                         ExecutionContext &context, dim_t rows) const {
+  const auto *bucketBindings = bucketCtx.getPlaceholderBindings();
+  auto *bindings = context.getPlaceholderBindings();
+  for (Placeholder *PH : bucket.placeholders) {
+    if (!bucket.outputNames.count(PH->getName().str())) {
+      continue;
+    }
+    const Tensor *bucketT = bucketBindings->get(PH);
+    Tensor *T =
+        bindings->get(bindings->getPlaceholderByNameSlow(PH->getName()));
+    std::memcpy(T->getUnsafePtr(), bucketT->getUnsafePtr(),
+                rows * getRowSize(*bucketT));
+  }
+}
@@ -17,6 +17,8 @@
 #include "glow/Runtime/InputSanitizer.h"
 #include "glow/Flags/Flags.h"
 
+#include <algorithm>
+
 #include <folly/Conv.h>
 #include <folly/Random.h>
 #include <glog/logging.h>
@@ -27,11 +29,34 @@ namespace runtime {
 
 namespace {
 
+/// \returns the elements of \p tensor as a pointer to \p T, so that the
+/// reductions below are plain loops the compiler vectorizes.
+template <class T> static const T *getRawData(const Tensor *tensor) {
+  return reinterpret_cast<const T *>(tensor->getUnsafePtr());
+}
+
 template <class T>
 static Error sanitizeIndices(const Tensor *indicesTensor, size_t tableHeight,
                              llvm::StringRef tensorName) {
+  const T *data = getRawData<T>(indicesTensor);
+  size_t indicesLen = indicesTensor->getRealNumElements();
+  // Branch free min/max reduction, only looking for the bad index when the
+  // range check fails.
+  T minIndex = 0;
+  T maxIndex = 0;
+  if (indicesLen) {
+    minIndex = data[0];
+    maxIndex = data[0];
+  }
+  for (size_t i = 0; i < indicesLen; i++) {
+    minIndex = std::min(minIndex, data[i]);
+    maxIndex = std::max(maxIndex, data[i]);
+  }
+  if (minIndex >= 0 && size_t(maxIndex) < tableHeight) {
+    return Error::success();
+  }
+
   auto indices = indicesTensor->getHandle<T>();
-  size_t indicesLen = indices.getRealNumElements();
   // indices in [0, tableHeight)
   for (auto i = 0; i < indicesLen; i++) {
     RETURN_ERR_IF_NOT(
@@ -49,17 +74,25 @@ template <class T>
 static Error sanitizeLengths(const Tensor *lengthsTensor,
                              const size_t indicesLen,
                              llvm::StringRef tensorName) {
-  auto lengths = lengthsTensor->getHandle<T>();
+  const T *data = getRawData<T>(lengthsTensor);
+  size_t lengthsLen = lengthsTensor->getRealNumElements();
 
+  T minLength = 0;
   size_t totalLensSum = 0;
-  for (auto i = 0; i < lengths.getRealNumElements(); ++i) {
-    auto length = lengths.raw(i);
-    RETURN_ERR_IF_NOT(
-        length >= 0,
-        folly::to<std::string>("SLS lengths sanitization failed on tensor ",
-                               tensorName.str(), ": length ", length,
-                               " at pos ", i, " is negative"));
-    totalLensSum += length;
+  for (size_t i = 0; i < lengthsLen; ++i) {
+    minLength = std::min(minLength, data[i]);
+    totalLensSum += data[i];
+  }
+  if (minLength < 0) {
+    auto lengths = lengthsTensor->getHandle<T>();
+    for (auto i = 0; i < lengths.getRealNumElements(); ++i) {
+      auto length = lengths.raw(i);
+      RETURN_ERR_IF_NOT(
+          length >= 0,
+          folly::to<std::string>("SLS lengths sanitization failed on tensor ",
+                                 tensorName.str(), ": length ", length,
+                                 " at pos ", i, " is negative"));
+    }
   }
 
   RETURN_ERR_IF_NOT(
@@ -83,18 +116,24 @@ static Error sanitizeOffsets(const Tensor *offsetsTensor,
                         tensorName.str(), ": the first offset is not zero ",
                         offsets.raw(0)));
 
-  bool zeroTensor = true;
+  const T *data = getRawData<T>(offsetsTensor);
   size_t offsetsLen = offsets.getRealNumElements();
-  for (auto i = 0; i < offsetsLen - 1; i++) {
-    RETURN_ERR_IF_NOT(
-        offsets.raw(i) <= offsets.raw(i + 1),
-        folly::to<std::string>("EBB offsets sanitization failed on tensor ",
-                               tensorName.str(), ": decreasing offsets ",
-                               offsets.raw(i), " and ", offsets.raw(i + 1),
-                               " at pos ", i));
-
-    if (zeroTensor && offsets.raw(i + 1) != 0) {
-      zeroTensor = false;
+  // Offsets start at zero so the tensor is all zeros when its max is zero.
+  bool decreasing = false;
+  T maxOffset = 0;
+  for (size_t i = 0; i + 1 < offsetsLen; i++) {
+    decreasing |= data[i] > data[i + 1];
+    maxOffset = std::max(maxOffset, data[i + 1]);
+  }
+  bool zeroTensor = maxOffset == 0;
+  if (decreasing) {
+    for (auto i = 0; i < offsetsLen - 1; i++) {
+      RETURN_ERR_IF_NOT(
+          offsets.raw(i) <= offsets.raw(i + 1),
+          folly::to<std::string>("EBB offsets sanitization failed on tensor ",
+                                 tensorName.str(), ": decreasing offsets ",
+                                 offsets.raw(i), " and ", offsets.raw(i + 1),
+                                 " at pos ", i));
     }
   }
 
@@ -109,6 +148,106 @@ static Error sanitizeOffsets(const Tensor *offsetsTensor,
   return Error::success();
 }
 
+/// Number of runs skipped by an InputDeduplicator after measuring a duplicate
+/// rate too low to deduplicate.
+constexpr unsigned kDedupRecheckRuns = 64;
+
+/// Sorts the indices of each segment of \p lengthsTensor and merges the
+/// duplicates, adding their weights, into \p entries and \p mergedLengths.
+/// \returns false if the lengths do not match the indices.
+template <class IT, class LT>
+static bool mergeDuplicates(const Tensor *indicesTensor,
+                            const Tensor *weightsTensor,
+                            const Tensor *lengthsTensor,
+                            std::vector<std::pair<IT, float>> &entries,
+                            std::vector<LT> &mergedLengths) {
+  const IT *indices = getRawData<IT>(indicesTensor);
+  const float *weights = getRawData<float>(weightsTensor);
+  const LT *lengths = getRawData<LT>(lengthsTensor);
+  size_t numIndices = indicesTensor->getRealNumElements();
+  size_t numLengths = lengthsTensor->getRealNumElements();
+  if (weightsTensor->getRealNumElements() != numIndices) {
+    return false;
+  }
+
+  entries.reserve(numIndices);
+  mergedLengths.resize(numLengths);
+  size_t pos = 0;
+  for (size_t i = 0; i < numLengths; i++) {
+    if (lengths[i] < 0 || size_t(lengths[i]) > numIndices - pos) {
+      return false;
+    }
+    size_t begin = entries.size();
+    for (size_t end = pos + lengths[i]; pos < end; pos++) {
+      entries.emplace_back(indices[pos], weights[pos]);
+    }
+    // Stable so that the weights of duplicates are added in their order.
+    std::stable_sort(entries.begin() + begin, entries.end(),
+                     [](const std::pair<IT, float> &lhs,
+                        const std::pair<IT, float> &rhs) {
+                       return lhs.first < rhs.first;
+                     });
+    size_t out = begin;
+    for (size_t j = begin; j < entries.size(); j++) {
+      if (out > begin && entries[out - 1].first == entries[j].first) {
+        entries[out - 1].second += entries[j].second;
+      } else {
+        entries[out++] = entries[j];
+      }
+    }
+    entries.resize(out);
+    mergedLengths[i] = out - begin;
+  }
+  return pos == numIndices;
+}
+
+/// Binds \p PH to a new partial tensor of \p numElements elements owned by
+/// \p storage. \returns its data.
+template <class T>
+static T *rebind(PlaceholderBindings &bindings, Placeholder *PH,
+                 size_t numElements, std::vector<Tensor> &storage) {
+  storage.emplace_back(PH->getType());
+  T *data = reinterpret_cast<T *>(storage.back().getUnsafePtr());
+  bindings.erase(PH);
+  bindings.insert(
+      PH, Tensor(data, PH->getType(),
+                 numElements * PH->getType()->getElementSize()));
+  return data;
+}
+
+/// Deduplicates the inputs of a weighted SLS with indices of type \p IT and
+/// lengths of type \p LT. \returns false if the duplicate rate is below
+/// \p minPercent or the inputs are not consistent, leaving them unchanged.
+template <class IT, class LT>
+static bool deduplicateIndices(PlaceholderBindings &bindings,
+                               Placeholder *indicesPH, Placeholder *weightsPH,
+                               Placeholder *lengthsPH, unsigned minPercent,
+                               std::vector<Tensor> &storage) {
+  const Tensor *indices = bindings.get(indicesPH);
+  size_t numIndices = indices->getRealNumElements();
+  std::vector<std::pair<IT, float>> entries;
+  std::vector<LT> mergedLengths;
+  if (!numIndices ||
+      !mergeDuplicates<IT, LT>(indices, bindings.get(weightsPH),
+                               bindings.get(lengthsPH), entries,
+                               mergedLengths) ||
+      (numIndices - entries.size()) * 100 < minPercent * numIndices) {
+    return false;
+  }
+
+  IT *newIndices = rebind<IT>(bindings, indicesPH, entries.size(), storage);
+  float *newWeights =
+      rebind<float>(bindings, weightsPH, entries.size(), storage);
+  for (size_t i = 0; i < entries.size(); i++) {
+    newIndices[i] = entries[i].first;
+    newWeights[i] = entries[i].second;
+  }
+  LT *newLengths =
+      rebind<LT>(bindings, lengthsPH, mergedLengths.size(), storage);
+  std::copy(mergedLengths.begin(), mergedLengths.end(), newLengths);
+  return true;
+}
+
 } // namespace
 
 //
@@ -369,6 +508,123 @@ std::vector<InputSanitizerPtr> getInputSanitizers(const Function &function) {
   return result;
 }
 
+//
+// SparseLengthsSum input deduplication
+//
+InputDeduplicator::InputDeduplicator(Placeholder *indicesPH,
+                                     Placeholder *weightsPH,
+                                     Placeholder *lengthsPH)
+    : indicesPH_{indicesPH}, weightsPH_{weightsPH}, lengthsPH_{lengthsPH} {}
+
+Error InputDeduplicator::deduplicate(PlaceholderBindings &bindings,
+                                     std::vector<Tensor> &storage) {
+  unsigned skip = skipRuns_.load();
+  if (skip && skipRuns_.compare_exchange_strong(skip, skip - 1)) {
+    return Error::success();
+  }
+
+  auto *indices = bindings.get(indicesPH_);
+  auto *weights = bindings.get(weightsPH_);
+  auto *lengths = bindings.get(lengthsPH_);
+  // Inputs that are constants or internal to the function are left alone.
+  if (!indices || !weights || !lengths ||
+      weights->getElementType() != ElemKind::FloatTy) {
+    return Error::success();
+  }
+
+  unsigned minPercent = flags::DedupInputsMinPercent;
+  bool isInt64Indices = indices->getElementType() == ElemKind::Int64ITy;
+  bool isInt64Lengths = lengths->getElementType() == ElemKind::Int64ITy;
+  if ((!isInt64Indices && indices->getElementType() != ElemKind::Int32ITy) ||
+      (!isInt64Lengths && lengths->getElementType() != ElemKind::Int32ITy)) {
+    return MAKE_ERR(strFormat(
+        "SLS indices deduplication failed on tensor %s: unsupported "
+        "element types %s and %s",
+        indicesPH_->getName().str().c_str(),
+        Type::getElementName(indices->getElementType()).str().c_str(),
+        Type::getElementName(lengths->getElementType()).str().c_str()));
+  }
+
+  bool deduplicated;
+  if (isInt64Indices && isInt64Lengths) {
+    deduplicated = deduplicateIndices<int64_t, int64_t>(
+        bindings, indicesPH_, weightsPH_, lengthsPH_, minPercent, storage);
+  } else if (isInt64Indices) {
+    deduplicated = deduplicateIndices<int64_t, int32_t>(
+        bindings, indicesPH_, weightsPH_, lengthsPH_, minPercent, storage);
+  } else if (isInt64Lengths) {
+    deduplicated = deduplicateIndices<int32_t, int64_t>(
+        bindings, indicesPH_, weightsPH_, lengthsPH_, minPercent, storage);
+  } else {
+    deduplicated = deduplicateIndices<int32_t, int32_t>(
+        bindings, indicesPH_, weightsPH_, lengthsPH_, minPercent, storage);
+  }
+  if (!deduplicated) {
+    skipRuns_ = kDedupRecheckRuns;
+  }
+
+  return Error::success();
+}
+
+std::string InputDeduplicator::toString() {
+  std::ostringstream ss;
+  ss << "InputDeduplicator[";
+  ss << "indices=" << indicesPH_->getName().str();
+  ss << ", weigths=" << weightsPH_->getName().str();
+  ss << ", lengths=" << lengthsPH_->getName().str();
+  ss << "]";
+  return ss.str();
+}
+
+std::vector<InputDeduplicatorPtr>
+getInputDeduplicators(const Function &function) {
+  std::vector<InputDeduplicatorPtr> result;
+
+  for (const auto &node : function.getNodes()) {
+    NodeValue indices, weights, lengths;
+    if (auto *SLS =
+            llvm::dyn_cast<FusedRowwiseQuantizedSparseLengthsWeightedSumNode>(
+                &node)) {
+      indices = SLS->getIndices();
+      weights = SLS->getWeights();
+      lengths = SLS->getLengths();
+    } else if (auto *SLS =
+                   llvm::dyn_cast<SparseLengthsWeightedSumNode>(&node)) {
+      indices = SLS->getIndices();
+      weights = SLS->getWeights();
+      lengths = SLS->getLengths();
+    } else {
+      continue;
+    }
+
+    // The inputs are rebound, so they must not be used by other nodes.
+    auto *indicesPH = llvm::dyn_cast<Placeholder>(indices);
+    auto *weightsPH = llvm::dyn_cast<Placeholder>(weights);
+    auto *lengthsPH = llvm::dyn_cast<Placeholder>(lengths);
+    if (indicesPH && weightsPH && lengthsPH && indicesPH->hasOneUse() &&
+        weightsPH->hasOneUse() && lengthsPH->hasOneUse()) {
+      result.push_back(std::make_shared<InputDeduplicator>(
+          indicesPH, weightsPH, lengthsPH));
+    }
+  }
+
+  return result;
+}
+
+Error deduplicateInputs(const std::vector<InputDeduplicatorPtr> &deduplicators,
+                        PlaceholderBindings &bindings,
+                        std::vector<Tensor> &storage) {
+  if (flags::DedupInputsMinPercent == 0) {
+    return Error::success();
+  }
+
+  for (auto &deduplicator : deduplicators) {
+    RETURN_IF_ERR(deduplicator->deduplicate(bindings, storage));
+  }
+
+  return Error::success();
+}
+
 Error sanitizeInputs(const std::vector<InputSanitizerPtr> &sanitizers,
                      const PlaceholderBindings &bindings) {
   if (flags::SanitizeInputsPercent == 0 ||
@@ -376,8 +632,18 @@ Error sanitizeInputs(const std::vector<InputSanitizerPtr> &sanitizers,
     return Error::success();
   }
 
-  for (auto &sanitizer : sanitizers) {
-    RETURN_IF_ERR(sanitizer->sanitize(bindings));
+  // Only sanitize a window of SanitizeInputsTables tables starting at a
+  // random one, so that over many requests every table gets checked.
+  size_t numSanitizers = sanitizers.size();
+  size_t numChecked = numSanitizers;
+  size_t first = 0;
+  if (flags::SanitizeInputsTables && flags::SanitizeInputsTables < numChecked) {
+    numChecked = flags::SanitizeInputsTables;
+    first = folly::Random::rand32(numSanitizers);
+  }
+
+  for (size_t i = 0; i < numChecked; i++) {
+    RETURN_IF_ERR(sanitizers[(first + i) % numSanitizers]->sanitize(bindings));
   }
 
   return Error::success();
@@ -0,0 +1,147 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "glow/Runtime/Provisioner/CompiledFunctionCache.h"
+#include "glow/Backend/Backend.h"
+#include "glow/Graph/Graph.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <map>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+/// Add the string \p str to \p hasher, prefixed with its length so that
+/// adjacent fields can't run into each other.
+void hashString(llvm::SHA1 &hasher, llvm::StringRef str) {
+  uint64_t size = str.size();
+  hasher.update(llvm::ArrayRef<uint8_t>(
+      reinterpret_cast<const uint8_t *>(&size), sizeof(size)));
+  hasher.update(str);
+}
+} // namespace
+
+std::string CompiledFunctionCache::getKey(const Function &F,
+                                          const Backend &backend,
+                                          const BackendOptions &opts) {
+  llvm::SHA1 hasher;
+  hashString(hasher, std::to_string(kFormatVersion));
+  hashString(hasher, backend.getCompilationFingerprint());
+
+  // The deserialization switch is set by the cache itself on a hit.
+  BackendOptions keyOpts = opts;
+  keyOpts.useDeserialize = false;
+  hashString(hasher, keyOpts.dump());
+  hashString(hasher, std::to_string(opts.backendHints.executionUnits));
+  for (const auto &name : opts.backendHints.SRAMPrioritization) {
+    hashString(hasher, name);
+  }
+
+  // Per-Node options are keyed by pointer, use the Node names instead and
+  // sort them so the key doesn't depend on hashing order.
+  auto nodeInfoIt = opts.backendSpecificNodeInfo.find(&F);
+  if (nodeInfoIt != opts.backendSpecificNodeInfo.end()) {
+    std::map<std::string, std::map<std::string, std::vector<std::string>>>
+        nodeInfo;
+    for (const auto &nodeOpts : nodeInfoIt->second) {
+      auto &named = nodeInfo[nodeOpts.first->getName().str()];
+      for (const auto &opt : nodeOpts.second) {
+        named[opt.getKey().str()] = opt.getValue();
+      }
+    }
+    for (const auto &nodeOpts : nodeInfo) {
+      hashString(hasher, nodeOpts.first);
+      for (const auto &opt : nodeOpts.second) {
+        hashString(hasher, opt.first);
+        for (const auto &val : opt.second) {
+          hashString(hasher, val);
+        }
+      }
+    }
+  }
+
+  hashString(hasher, F.toString(/* skipUsersForStorage */ true,
+                                /* skipName */ true));
+  for (const Constant *C : F.findConstants()) {
+    const Tensor &payload = C->getPayload();
+    hashString(hasher, C->getName());
+    hashString(hasher, llvm::StringRef(payload.getUnsafePtr(),
+                                       payload.getSizeInBytes()));
+  }
+
+  return llvm::toHex(hasher.final(), /* LowerCase */ true);
+}
+
+std::string CompiledFunctionCache::getPath(llvm::StringRef key) const {
+  llvm::SmallString<128> path(dir_);
+  llvm::sys::path::append(path, key + ".bin");
+  return path.str().str();
+}
+
+llvm::Optional<std::vector<char>>
+CompiledFunctionCache::load(llvm::StringRef key) const {
+  auto bufOrErr = llvm::MemoryBuffer::getFile(getPath(key));
+  if (!bufOrErr) {
+    return llvm::None;
+  }
+  const auto &buf = *bufOrErr;
+  return std::vector<char>(buf->getBufferStart(), buf->getBufferEnd());
+}
+
+Error CompiledFunctionCache::store(llvm::StringRef key,
+                                   BlockStreamBase &stream) const {
+  std::vector<char> data(stream.getSize());
+  RETURN_ERR_IF_NOT(stream.read(data.data(), data.size()) == data.size(),
+                    "Failed to read serialized function for " + key.str());
+
+  std::error_code EC = llvm::sys::fs::create_directories(dir_);
+  RETURN_ERR_IF_NOT(!EC, "Failed to create compiled function cache directory " +
+                             dir_ + ": " + EC.message());
+
+  int fd;
+  llvm::SmallString<128> tmpPath;
+  EC = llvm::sys::fs::createUniqueFile(getPath(key) + ".tmp-%%%%%%", fd,
+                                       tmpPath);
+  RETURN_ERR_IF_NOT(!EC, "Failed to create compiled function cache entry " +
+                             getPath(key) + ": " + EC.message());
+  {
+    llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+    os.write(data.data(), data.size());
+    os.close();
+    if (os.has_error()) {
+      os.clear_error();
+      llvm::sys::fs::remove(tmpPath);
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR,
+                      "Failed to write compiled function cache entry " +
+                          tmpPath.str().str());
+    }
+  }
+
+  EC = llvm::sys::fs::rename(tmpPath, getPath(key));
+  if (EC) {
+    llvm::sys::fs::remove(tmpPath);
+    return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR,
+                    "Failed to store compiled function cache entry " +
+                        getPath(key) + ": " + EC.message());
+  }
+  return Error::success();
+}
@@ -21,12 +21,15 @@
 #include "glow/Flags/Flags.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Runtime/DeferredWeightLoader.h"
+#include "glow/Runtime/StatsExporter.h"
 #include "glow/Support/Debug.h"
 
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormatVariadic.h"
 
 #include <folly/dynamic.h>
+#include <algorithm>
+#include <chrono>
 #include <future>
 #include <map>
 #include <mutex>
@@ -72,6 +75,12 @@ Provisioner::Provisioner(DeviceManagerMapTy &devices) {
       backends_.emplace(std::string(backendName), std::move(newBackend));
     }
   }
+  compilePool_ = glow::make_unique<ThreadPool>(
+      std::max(1u, flags::NumCompilationThreads), "ProvisionerCompile");
+  if (!flags::CompiledFunctionCacheDir.empty()) {
+    compiledFunctionCache_ = glow::make_unique<CompiledFunctionCache>(
+        flags::CompiledFunctionCacheDir);
+  }
 }
 
 Error Provisioner::checkActiveNetworks(
@@ -165,7 +174,24 @@ Provisioner::generateDeviceAssignments(
   // device has enough space we continue, otherwise we return an error.
   // This approach is to prevent many small networks from clumping on a single
   // device.
-  for (auto logicalDevice : logicalDeviceSize) {
+  // The logical devices added by saturateHost to replicate nodes only use the
+  // memory left after all the others: they are assigned last, and the ones
+  // that don't fit are dropped rather than failing the whole network.
+  auto isReplica = [&](DeviceIDTy logicalID) {
+    return std::all_of(logicalDevices[logicalID].begin(),
+                       logicalDevices[logicalID].end(), [&](DAGNode *node) {
+                         return node->logicalDevices.front() != logicalID;
+                       });
+  };
+  std::vector<std::pair<DeviceIDTy, uint64_t>> orderedLogicalDevices(
+      logicalDeviceSize);
+  std::stable_partition(
+      orderedLogicalDevices.begin(), orderedLogicalDevices.end(),
+      [&](const std::pair<DeviceIDTy, uint64_t> &logicalDevice) {
+        return !isReplica(logicalDevice.first);
+      });
+  std::vector<DeviceIDTy> droppedReplicas;
+  for (auto logicalDevice : orderedLogicalDevices) {
     // First check that there the requested backend kind is available.
     auto backendName = logicalDevices[logicalDevice.first][0]->backendName;
     if (deviceMemoryMap.find(backendName) == deviceMemoryMap.end()) {
@@ -217,6 +243,10 @@ Provisioner::generateDeviceAssignments(
         // 1 device.
         currentPosition = 1 % deviceMemoryMap[backendName].size();
         positions[backendName] = currentPosition;
+      } else if (isReplica(logicalDevice.first)) {
+        // The replica doesn't fit in the spare memory, the nodes keep their
+        // other instances.
+        droppedReplicas.push_back(logicalDevice.first);
       } else {
         // Return an error there is insufficient space for the logical device on
         // any available device.
@@ -230,6 +260,22 @@ Provisioner::generateDeviceAssignments(
     }
   }
 
+  for (auto logicalID : droppedReplicas) {
+    for (auto *node : logicalDevices[logicalID]) {
+      auto &nodeDevices = node->logicalDevices;
+      nodeDevices.erase(
+          std::remove(nodeDevices.begin(), nodeDevices.end(), logicalID),
+          nodeDevices.end());
+      node->instanceCount =
+          std::min<unsigned>(node->instanceCount, nodeDevices.size());
+    }
+    logicalDevices.erase(logicalID);
+  }
+  if (!droppedReplicas.empty()) {
+    LOG(INFO) << "Dropped " << droppedReplicas.size()
+              << " replicas of saturateHost that don't fit in device memory";
+  }
+
   // Update nodes in logicalDevices with their assignments.
   for (auto &assignment : deviceAssignment) {
     for (auto &node : logicalDevices[assignment.first]) {
@@ -255,7 +301,8 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
   // cleanupGuard, hence this needs to be declared before cleanupGuard. We
   // probably should clean up the compiledFunctions logic to make this more
   // intuitive.
-  llvm::StringMap<std::unique_ptr<CompiledFunction>> compiledFunctions;
+  // Identical functions share a compiled function.
+  llvm::StringMap<std::shared_ptr<CompiledFunction>> compiledFunctions;
 
   // If any error happens during the provison process, we will clean up the
   // compiled networks.
@@ -327,14 +374,32 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
   llvm::StringMap<BackendOptions> optsMap;
 
   // Compile and load.
-  // This is done one logical device at a time. All functions in a logical
-  // device are compiled and then added to their assigned device. If a function
-  // is in multiple logical devices it is stored so that it only needs to be
-  // compiled once.
+  // All functions of all logical devices are collected first, so that every
+  // partition can be compiled in parallel on compilePool_. If a function is in
+  // multiple logical devices, or another function has the same contents, it
+  // only needs to be compiled once. The compiled functions are then added to
+  // their assigned devices one logical device at a time.
   if (network->networkType == NetworkType::GLOW_NETWORK) {
+    // Functions to compile, in the order they were found.
+    std::vector<Function *> functionsToCompile;
+    // Mapping from function name to the name of the identical function it
+    // shares its compiled function with.
+    llvm::StringMap<std::string> duplicateOf;
+    // Functions already collected bucketed by backend and structural hash,
+    // used to find duplicates without hashing every Constant.
+    std::map<std::pair<std::string, size_t>, std::vector<Function *>>
+        structuralBuckets;
+    // Mapping from function name to the backend it is compiled for.
+    llvm::StringMap<std::string> functionBackends;
+    // Content keys computed so far, see CompiledFunctionCache::getKey().
+    llvm::StringMap<std::string> contentKeys;
+    // Serialized functions found in the persistent cache, and cache keys of
+    // the functions which were not found.
+    llvm::StringMap<std::vector<char>> cachedFunctions;
+    llvm::StringMap<std::string> cacheKeys;
+
     for (auto &assignment : assignments) {
       auto logicalDevice = assignment.first;
-      auto physicalDevice = assignment.second;
       auto deviceBackendName = logicalDevices[logicalDevice][0]->backendName;
 
       if (backends_.find(deviceBackendName) == backends_.end()) {
@@ -342,11 +407,7 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
         return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_DEVICE_NOT_FOUND,
                         "Unable to find device of type: " + deviceBackendName);
       }
-
-      // Stores all the functions in a logical device.
-      std::vector<glow::Function *> functionsToCompile;
-      // Stores the compiled functions that will be added to physical device.
-      FunctionMapTy functionMap;
+      Backend &backend = *backends_[deviceBackendName];
 
       // Collect all the functions in a logical device.
       for (auto &node : logicalDevices[logicalDevice]) {
@@ -364,89 +425,209 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
         for (auto &it : node->backendSpecificOpts) {
           options.backendSpecificOpts[it.first] = it.second;
         }
-        std::lock_guard<std::mutex> functionsLock(functionsLock_);
-        Function *function = module.getFunction(node->name);
-
-        functionsToCompile.push_back(function);
+        Function *function;
+        {
+          std::lock_guard<std::mutex> functionsLock(functionsLock_);
+          function = module.getFunction(node->name);
+        }
         optsMap.insert({function->getName(), options});
+        functionBackends.try_emplace(node->name, deviceBackendName);
         functionReplicaCount_.emplace(node->name, node->replicationCount);
         remainingDeviceCount.insert(
             {node->name, node->logicalDevices.size() - 1});
-      }
 
-      // Compile all the functions in the logical device together.
-      // We add a lock here because some backends are not threadsafe (CPU
-      // backend).
-      std::unique_lock<std::mutex> compileLock(functionsLock_);
-      auto compiledOrErr = backends_[deviceBackendName]->compileFunctions(
-          functionsToCompile, optsMap);
-      VLOG(1) << "After compile";
-      compileLock.unlock();
-
-      // Dump graph and logs
-      for (auto *function : functionsToCompile) {
-        // Note: This needs to come after compile above because compile may
-        // modify the Function as well.
-        if (cctx.dumpFinalGraph) {
-          auto fname = strFormat(
-              "%sfinal_graph_%s_%s.dot", cctx.dumpGraphPath.c_str(),
-              deviceBackendName.c_str(), function->getName().str().c_str());
-          LOG(INFO) << "Dumping final graph to " << fname;
-          function->dumpDAG(fname);
-          // print stats of node
-          std::map<std::string, int> opCounter;
-          for (const auto &node : function->getNodes()) {
-            opCounter[node.getKindName()]++;
+        // Keys must be computed before compilation modifies the Function.
+        auto getContentKey = [&](Function *F) -> const std::string & {
+          auto it = contentKeys.find(F->getName());
+          if (it == contentKeys.end()) {
+            it = contentKeys
+                     .try_emplace(F->getName(),
+                                  CompiledFunctionCache::getKey(
+                                      *F, backend, optsMap[F->getName()]))
+                     .first;
           }
-          std::ostringstream ss;
-          ss << "Dump of Node stats for Function:\n";
-          ss << folly::stringPrintf("%30s %13s \n", "NodeKind", "Count");
-          for (const auto &p : opCounter) {
-            ss << folly::stringPrintf("%30s %13d \n", p.first.c_str(),
-                                      p.second);
+          return it->second;
+        };
+
+        // Look for an identical function collected earlier. Deserialized
+        // functions are left alone as each one has its own serialized data.
+        if (!options.useDeserialize) {
+          auto &bucket = structuralBuckets[{deviceBackendName,
+                                            size_t(function->getHash())}];
+          for (Function *candidate : bucket) {
+            if (getContentKey(candidate) == getContentKey(function)) {
+              duplicateOf.try_emplace(node->name, candidate->getName().str());
+              break;
+            }
           }
-          LOG(INFO) << ss.str();
+          if (duplicateOf.count(node->name)) {
+            VLOG(1) << "Sharing compiled function of "
+                    << duplicateOf[node->name] << " with " << node->name;
+            continue;
+          }
+          bucket.push_back(function);
         }
 
-        if (glow::flags::DumpCompilationLog) {
-          llvm::SmallString<64> path;
-          std::string prefix =
-              llvm::formatv("{0}-{1}", cctx.compilationLogPrefix,
-                            function->getName())
-                  .str();
-          auto tempFileRes =
-              llvm::sys::fs::createTemporaryFile(prefix, "log", path);
-          if (tempFileRes.value() != 0) {
-            LOG(ERROR)
-                << "Failed to create temp file for Glow compilation log: "
-                << tempFileRes;
+        if (compiledFunctionCache_ && !options.useDeserialize) {
+          const auto &key = getContentKey(function);
+          if (auto data = compiledFunctionCache_->load(key)) {
+            VLOG(1) << "Found " << node->name
+                    << " in compiled function cache: " << key;
+            optsMap[node->name].useDeserialize = true;
+            cachedFunctions.try_emplace(node->name, std::move(*data));
+          } else {
+            cacheKeys.try_emplace(node->name, key);
           }
+        }
+
+        functionsToCompile.push_back(function);
+      }
+    }
 
-          function->getLogContext()->dumpLog(path);
+    // Compile all the collected functions in parallel.
+    std::vector<std::unique_ptr<CompiledFunction>> compiled(
+        functionsToCompile.size());
+    OneErrOnly compileErr;
+    std::vector<std::future<void>> compileDone;
+    for (size_t i = 0, e = functionsToCompile.size(); i < e; i++) {
+      Function *function = functionsToCompile[i];
+      compileDone.push_back(compilePool_->submit([&, i, function]() {
+        const auto &options = optsMap.find(function->getName())->second;
+        Backend &backend =
+            *backends_.find(functionBackends.find(function->getName())->second)
+                 ->second;
+        auto startTime = std::chrono::steady_clock::now();
+        auto compiledOrErr = backend.compile(function, options);
+        auto compileUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - startTime)
+                             .count();
+        VLOG(1) << "Compiled " << function->getName().str() << " for "
+                << backend.getBackendName() << " in " << compileUs << "us";
+        StatsExporterRegistry::Stats()->addTimeSeriesValue(
+            kPartitionCompileTimeUs, compileUs);
+        if (!compiledOrErr) {
+          compileErr.set(compiledOrErr.takeError());
+          return;
+        }
+        compiled[i] = std::move(*compiledOrErr);
+      }));
+    }
+    for (auto &done : compileDone) {
+      done.wait();
+    }
+    VLOG(1) << "After compile";
+
+    // Dump graph and logs
+    for (auto *function : functionsToCompile) {
+      // Note: This needs to come after compile above because compile may
+      // modify the Function as well.
+      if (cctx.dumpFinalGraph) {
+        auto fname = strFormat(
+            "%sfinal_graph_%s_%s.dot", cctx.dumpGraphPath.c_str(),
+            functionBackends[function->getName()].c_str(),
+            function->getName().str().c_str());
+        LOG(INFO) << "Dumping final graph to " << fname;
+        function->dumpDAG(fname);
+        // print stats of node
+        std::map<std::string, int> opCounter;
+        for (const auto &node : function->getNodes()) {
+          opCounter[node.getKindName()]++;
+        }
+        std::ostringstream ss;
+        ss << "Dump of Node stats for Function:\n";
+        ss << folly::stringPrintf("%30s %13s \n", "NodeKind", "Count");
+        for (const auto &p : opCounter) {
+          ss << folly::stringPrintf("%30s %13d \n", p.first.c_str(), p.second);
         }
+        LOG(INFO) << ss.str();
       }
 
-      // If err return it, else store compiled functions into compiledFunctions.
-      if (!compiledOrErr) {
-        RETURN_ERR(compiledOrErr.takeError());
+      if (glow::flags::DumpCompilationLog) {
+        llvm::SmallString<64> path;
+        std::string prefix = llvm::formatv("{0}-{1}", cctx.compilationLogPrefix,
+                                           function->getName())
+                                 .str();
+        auto tempFileRes =
+            llvm::sys::fs::createTemporaryFile(prefix, "log", path);
+        if (tempFileRes.value() != 0) {
+          LOG(ERROR) << "Failed to create temp file for Glow compilation log: "
+                     << tempFileRes;
+        }
+
+        function->getLogContext()->dumpLog(path);
       }
-      auto compiled = std::move(*compiledOrErr);
-      for (auto &compiledFunction : compiled) {
+    }
 
-        // Deserialize compiled function from cctx.nameToFunctions
-        if (cctx.backendOpts.useDeserialize) {
-          std::string name = compiledFunction.first().str();
-          if (cctx.nameToFunctions.find(name) == cctx.nameToFunctions.end()) {
-            return MAKE_ERR(
-                ErrorValue::ErrorCode::UNKNOWN,
-                "Cannot find compiled function when deserializing " + name);
+    // If err return it, else store compiled functions into compiledFunctions.
+    RETURN_IF_ERR(compileErr.get());
+    for (size_t i = 0, e = functionsToCompile.size(); i < e; i++) {
+      std::string name = functionsToCompile[i]->getName().str();
+      auto &compiledFunction = compiled[i];
+
+      // Deserialize compiled function from cctx.nameToFunctions
+      if (cctx.backendOpts.useDeserialize) {
+        if (cctx.nameToFunctions.find(name) == cctx.nameToFunctions.end()) {
+          return MAKE_ERR(
+              ErrorValue::ErrorCode::UNKNOWN,
+              "Cannot find compiled function when deserializing " + name);
+        }
+        RETURN_IF_ERR(compiledFunction->deserialize(
+            *(cctx.nameToFunctions.find(name)->second)));
+      }
+      auto cachedIt = cachedFunctions.find(name);
+      if (cachedIt != cachedFunctions.end()) {
+        RETURN_IF_ERR(compiledFunction->deserialize(cachedIt->second));
+      }
+      auto keyIt = cacheKeys.find(name);
+      if (keyIt != cacheKeys.end()) {
+        if (auto stream = compiledFunction->serialize()) {
+          // A failure to populate the cache only costs a later compile.
+          if (auto err =
+                  compiledFunctionCache_->store(keyIt->second, *stream)) {
+            LOG(WARNING) << "Failed to cache compiled function " << name
+                         << ": " << ERR_TO_STRING(std::move(err));
           }
-          RETURN_IF_ERR(compiledFunction.second->deserialize(
-              *(cctx.nameToFunctions.find(name)->second)));
+          stream->releaseMemory();
         }
-        compiledFunctions.try_emplace(compiledFunction.first(),
-                                      std::move(compiledFunction.second));
       }
+      compiledFunctions.try_emplace(name, std::move(compiledFunction));
+    }
+    for (const auto &duplicate : duplicateOf) {
+      auto shared = compiledFunctions[duplicate.second];
+      compiledFunctions.try_emplace(duplicate.first(), std::move(shared));
+    }
+
+    // The DeviceManagers copy the Constants to the devices when the functions
+    // are added, after which the host payloads are only needed by the
+    // functions still to be added. Unless the module is kept intact, release
+    // the payload of every Constant once all the functions using it are on
+    // their devices, instead of when HostManager strips the module, so that
+    // the host copies of the weights of all partitions don't stay alive
+    // together.
+    bool releaseConstants = !cctx.skipModuleStrip;
+    for (const auto &functionBackend : functionBackends) {
+      releaseConstants &=
+          backends_.find(functionBackend.second)->second->shouldStripModule();
+    }
+    // Number of Functions of the module using each Constant which have not
+    // been added to all their devices yet.
+    llvm::DenseMap<Constant *, unsigned> pendingConstantUsers;
+    if (releaseConstants) {
+      for (Constant *C : module.getConstants()) {
+        llvm::SmallPtrSet<const Function *, 4> users;
+        for (const auto &use : C->getUsers()) {
+          users.insert(use.getUser()->getParent());
+        }
+        pendingConstantUsers[C] = users.size();
+      }
+    }
+
+    for (auto &assignment : assignments) {
+      auto logicalDevice = assignment.first;
+      auto physicalDevice = assignment.second;
+
+      // Stores the compiled functions that will be added to physical device.
+      FunctionMapTy functionMap;
       // Construnct functionMap for physical device.
       for (auto &node : logicalDevices[logicalDevice]) {
         RETURN_ERR_IF_NOT(compiledFunctions.count(node->name),
@@ -508,8 +689,14 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
         // and before move on to next logical device. If
         // DisableFreeCompilationResource is true, we will not free it here.
         // This is used in scenarios like model serialization.
-        auto &funtionPtr = compiledFunctions[node->name];
-        if (!glow::flags::DisableFreeCompilationResource) {
+        // Identical functions sharing the compiled function may still have to
+        // be added to other devices.
+        auto funtionPtr = std::move(compiledFunctions[node->name]);
+        compiledFunctions.erase(node->name);
+        bool stillNeeded = std::any_of(
+            compiledFunctions.begin(), compiledFunctions.end(),
+            [&](const auto &kv) { return kv.second == funtionPtr; });
+        if (!stillNeeded && !glow::flags::DisableFreeCompilationResource) {
           funtionPtr->freeCompilationResources();
         }
 
@@ -519,7 +706,19 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
           functions_.emplace(node->name, std::move(funtionPtr));
         }
 
-        compiledFunctions.erase(node->name);
+        if (releaseConstants) {
+          Function *function;
+          {
+            std::lock_guard<std::mutex> functionsLock(functionsLock_);
+            function = module.getFunction(node->name);
+          }
+          for (Constant *C : function->findConstants()) {
+            auto it = pendingConstantUsers.find(C);
+            if (it != pendingConstantUsers.end() && --it->second == 0) {
+              C->clearPayload();
+            }
+          }
+        }
       }
     }
   } else if (network->networkType == NetworkType::FX_NETWORK) {
@@ -696,6 +895,48 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
                       msg);
     }
     std::string weightName = loader->getName();
+
+    // Weights being transferred to their devices. When the loader keeps the
+    // loaded weights, the next weights are loaded and converted while up to
+    // DeferredWeightsInFlight weights are transferred.
+    struct WeightTransfer {
+      std::list<Error> errors;
+      std::list<std::future<void>> futures;
+    };
+    std::list<WeightTransfer> transfers;
+    const size_t maxTransfers =
+        loader->keepsLoadedWeights()
+            ? std::max(1u, flags::DeferredWeightsInFlight) : 1;
+    auto finishOldestTransfer = [&]() -> Error {
+      WeightTransfer &transfer = transfers.front();
+      for (auto &done : transfer.futures) {
+        done.get();
+      }
+      Error firstErr = Error::empty();
+      for (auto &error : transfer.errors) {
+        if (!error) {
+          continue;
+        }
+        if (!firstErr) {
+          firstErr = std::move(error);
+        } else {
+          ERR_TO_VOID(std::move(error));
+        }
+      }
+      transfers.pop_front();
+      if (firstErr) {
+        return firstErr;
+      }
+      return Error::success();
+    };
+    // The transfer callbacks refer to the errors of the transfers, so all of
+    // them have to be done before leaving.
+    ScopeGuard transfersGuard([&]() {
+      while (!transfers.empty()) {
+        ERR_TO_VOID(finishOldestTransfer());
+      }
+    });
+
     // Load weights while there are weights to be loaded.
     unsigned int weightCount = 0;
     while (weightName != "") {
@@ -715,6 +956,13 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
       auto oldKind = weight->getElementType();
       // Ensure we are working with a static PH.
       assert(PH->isStatic());
+      // Apply the transposes folded into the placeholder, see
+      // FoldElemKindConversionIntoInputs.
+      if (!PH->getLoadShuffle().empty()) {
+        Tensor TT;
+        weight->transpose(&TT, PH->getLoadShuffle());
+        weight->assign(&TT);
+      }
       if (!weight->getType().isEqual(newTy)) {
         ElemKind newK = newTy->getElementType();
 
@@ -722,31 +970,35 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
           Tensor QT = quantization::quantizeTensor(
               *weight, {newTy->getScale(), newTy->getOffset()}, newK);
           weight->assign(&QT);
+        } else if (isQuantizedElemKind(oldKind) && isQuantizedElemKind(newK) &&
+                   !isFusedQuantizedElemKind(newK)) {
+          // Rescale the quantized weight to the type of the placeholder.
+          Tensor FT =
+              quantization::dequantizeTensor(*weight, ElemKind::FloatTy);
+          Tensor QT = quantization::quantizeTensor(
+              FT, {newTy->getScale(), newTy->getOffset()}, newK);
+          weight->assign(&QT);
         } else {
           weight->convertToType(newK);
         }
       }
       // Transfer weight to all devices needed.
-      std::list<Error> errors;
-      std::list<std::future<void>> futures;
+      transfers.emplace_back();
+      WeightTransfer &transfer = transfers.back();
       for (const auto &device : placeholderToDeviceManager[PH]) {
-        std::promise<void> transferPromise;
-        errors.emplace_back(Error::empty());
-        futures.emplace_back(transferPromise.get_future());
+        auto transferPromise = std::make_shared<std::promise<void>>();
+        transfer.errors.emplace_back(Error::empty());
+        transfer.futures.emplace_back(transferPromise->get_future());
         devices_[device]->transferStaticPlaceholderToDevice(
             PH, weight,
-            [&transferPromise, &error = errors.back()](Error err) mutable {
+            [transferPromise,
+             &error = transfer.errors.back()](Error err) mutable {
               error = std::move(err);
-              transferPromise.set_value();
+              transferPromise->set_value();
             });
       }
-
-      for (auto &done : futures) {
-        done.get();
-      }
-
-      for (auto &error : errors) {
-        RETURN_IF_ERR(error);
+      if (transfers.size() >= maxTransfers) {
+        RETURN_IF_ERR(finishOldestTransfer());
       }
 
       err = loader->loadNextWeight();
@@ -761,6 +1013,9 @@ Error Provisioner::provisionNetwork(std::unique_ptr<Network> network) {
       // PH's
       placeholderToDeviceManager.erase(PH);
     }
+    while (!transfers.empty()) {
+      RETURN_IF_ERR(finishOldestTransfer());
+    }
     if (placeholderToDeviceManager.size()) {
       return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_DEFERRED_WEIGHT_ERROR,
                       "Error not all static placeholders were initialized.");
@@ -867,6 +1122,38 @@ Error Provisioner::evictFunction(llvm::StringRef name, DeviceManager *device,
   return evictErr.get();
 }
 
+Error Provisioner::addCompiledFunction(llvm::StringRef name,
+                                       const Module &module,
+                                       DeviceManager *device) {
+  FunctionMapTy functionMap;
+  {
+    std::lock_guard<std::mutex> functionsLock(functionsLock_);
+    auto it = functions_.find(name.str());
+    if (it == functions_.end()) {
+      return MAKE_ERR(ErrorValue::ErrorCode::RUNTIME_ERROR,
+                      "No compiled function " + name.str());
+    }
+    functionMap.emplace(name.str(), it->second.get());
+    auto replicaIt = functionReplicaCount_.find(name.str());
+    unsigned replicaCount =
+        replicaIt == functionReplicaCount_.end() ? 1 : replicaIt->second;
+    for (unsigned i = 1; i < replicaCount; i++) {
+      functionMap.emplace(getReplicatedName(name.str(), i), it->second.get());
+    }
+  }
+
+  std::promise<void> addPromise;
+  auto ready = addPromise.get_future();
+  std::unique_ptr<Error> addErr;
+  device->addNetwork(&module, functionMap,
+                     [&addErr, &addPromise](const Module *, Error err) {
+                       addErr = glow::make_unique<Error>(std::move(err));
+                       addPromise.set_value();
+                     });
+  ready.wait();
+  return std::move(*addErr);
+}
+
 void Provisioner::cleanupProvision(
     llvm::ArrayRef<std::string> names,
     std::map<DeviceIDTy, std::vector<std::string>> const
@@ -911,6 +1198,16 @@ void Provisioner::cleanUpSerializedFunctionMap() {
   serializedFunctionMap_.clear();
 }
 
+std::unique_ptr<BlockStreamBase>
+Provisioner::serializeFunction(llvm::StringRef name) {
+  std::lock_guard<std::mutex> functionsLock(functionsLock_);
+  auto it = functions_.find(name.str());
+  if (it == functions_.end()) {
+    return nullptr;
+  }
+  return it->second->serialize();
+}
+
 // Get the hash as a string from a function's name
 std::string getNameHash(std::string name) {
   return name.substr(name.find_last_of("_") + 1);
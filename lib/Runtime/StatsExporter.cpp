@@ -16,11 +16,21 @@
 
 #include "glow/Runtime/StatsExporter.h"
 
+#include "llvm/ADT/Twine.h"
+
 #include <memory>
 #include <vector>
 
 namespace glow {
 
+void StatsExporter::addHistogram(llvm::StringRef key,
+                                 const LatencyHistogram &histogram) {
+  setCounter((key + ".count").str(), histogram.getCount());
+  setCounter((key + ".p50").str(), histogram.getPercentile(0.5));
+  setCounter((key + ".p99").str(), histogram.getPercentile(0.99));
+  setCounter((key + ".p999").str(), histogram.getPercentile(0.999));
+}
+
 void StatsExporterRegistry::registerStatsExporter(StatsExporter *exporter) {
   exporters_.push_back(exporter);
 }
@@ -43,6 +53,13 @@ void StatsExporterRegistry::setCounter(llvm::StringRef key, int64_t value) {
   }
 }
 
+void StatsExporterRegistry::addHistogram(llvm::StringRef key,
+                                         const LatencyHistogram &histogram) {
+  for (auto const &exporter : exporters_) {
+    exporter->addHistogram(key, histogram);
+  }
+}
+
 void StatsExporterRegistry::incrementCounter(llvm::StringRef key,
                                              int64_t value) {
   for (auto const &exporter : exporters_) {
@@ -15,11 +15,112 @@
  */
 
 #include "glow/Runtime/TraceExporter.h"
+#include "glow/Support/Memory.h"
 
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
 #include <vector>
 
 namespace glow {
 
+namespace {
+/// Number of recent request latencies the p99 is computed from.
+constexpr size_t kLatencyWindow = 1024;
+
+/// Number of recorded latencies between two computations of the p99, and the
+/// minimum number of latencies to compute it.
+constexpr size_t kTailLatencyPeriod = 128;
+} // namespace
+
+TraceSampler::TraceSampler(unsigned sampleRate, double overheadBudget)
+    : sampleRate_(std::max(sampleRate, 1u)), overheadBudget_(overheadBudget) {
+  latencies_.reserve(kLatencyWindow);
+}
+
+TraceLevel TraceSampler::getRequestTraceLevel() {
+  bool sampled = numRequests_++ % sampleRate_ == 0;
+  return sampled && !overBudget_ ? TraceLevel::STANDARD : TraceLevel::REQUEST;
+}
+
+bool TraceSampler::shouldExport(TraceLevel level, uint64_t latency) {
+  std::lock_guard<std::mutex> g(mutex_);
+  if (latencies_.size() < kLatencyWindow) {
+    latencies_.push_back(latency);
+  } else {
+    latencies_[numLatencies_ % kLatencyWindow] = latency;
+  }
+  if (++numLatencies_ % kTailLatencyPeriod == 0) {
+    std::vector<uint64_t> sorted(latencies_);
+    auto p99 = sorted.begin() + sorted.size() * 99 / 100;
+    std::nth_element(sorted.begin(), p99, sorted.end());
+    tailLatency_ = *p99;
+  }
+  runTime_ += latency;
+  if (numLatencies_ % kLatencyWindow == 0) {
+    runTime_ /= 2;
+    exportTime_ /= 2;
+  }
+  overBudget_ = exportTime_ > overheadBudget_ * runTime_;
+  if (overBudget_) {
+    return false;
+  }
+  return level == TraceLevel::STANDARD ||
+         (tailLatency_ && latency > tailLatency_);
+}
+
+void TraceSampler::recordOverhead(uint64_t overhead) {
+  std::lock_guard<std::mutex> g(mutex_);
+  exportTime_ += overhead;
+  overBudget_ = exportTime_ > overheadBudget_ * runTime_;
+}
+
+uint64_t TraceSampler::getTailLatency() {
+  std::lock_guard<std::mutex> g(mutex_);
+  return tailLatency_;
+}
+
+ChromeTraceStreamExporter::ChromeTraceStreamExporter(llvm::StringRef filename) {
+  std::error_code EC;
+  os_ = glow::make_unique<llvm::raw_fd_ostream>(filename, EC,
+                                                llvm::sys::fs::OF_None);
+  if (EC) {
+    LOG(ERROR) << "Unable to open trace file " << filename.str();
+    os_.reset();
+    return;
+  }
+  *os_ << "[\n";
+  TraceEvent::dumpMetadataEvent(*os_, "process_name", 0, "glow");
+}
+
+ChromeTraceStreamExporter::~ChromeTraceStreamExporter() {
+  if (os_) {
+    *os_ << "\n]";
+  }
+}
+
+void ChromeTraceStreamExporter::exportTrace(TraceContext *context) {
+  std::lock_guard<std::mutex> g(mutex_);
+  if (!os_) {
+    return;
+  }
+  for (const auto &nameMap : context->getThreadNames()) {
+    if (threadNames_.insert(nameMap).second) {
+      *os_ << ",\n";
+      TraceEvent::dumpMetadataEvent(
+          *os_, "thread_name", nameMap.first,
+          llvm::formatv("{1}: {0,7}", nameMap.first, nameMap.second).str());
+    }
+  }
+  for (const auto &event : context->getTraceEvents()) {
+    *os_ << ",\n";
+    TraceEvent::dumpTraceEvent(*os_, event);
+  }
+  os_->flush();
+}
+
 void TraceExporterRegistry::registerTraceExporter(TraceExporter *exporter) {
   /// This function can be called in static init, hence do not use
   /// glog here as it may not have been initialized yet.
@@ -47,11 +148,35 @@ void TraceExporterRegistry::exportTrace(TraceContext *tcontext) {
   if (!tcontext) {
     return;
   }
+  // Merge the per-thread buffers once for all the exporters.
+  tcontext->flushEventBuffers();
   for (auto const &exporter : exporters_) {
     exporter->exportTrace(tcontext);
   }
 }
 
+void TraceExporterRegistry::setSampler(std::shared_ptr<TraceSampler> sampler) {
+  std::lock_guard<std::mutex> g(mutex_);
+  sampler_ = std::move(sampler);
+}
+
+std::shared_ptr<TraceSampler> TraceExporterRegistry::getSampler() {
+  std::lock_guard<std::mutex> g(mutex_);
+  return sampler_;
+}
+
+void TraceExporterRegistry::exportSampledTrace(TraceContext *tcontext,
+                                               TraceLevel level,
+                                               uint64_t latency) {
+  auto sampler = getSampler();
+  if (!tcontext || !sampler || !sampler->shouldExport(level, latency)) {
+    return;
+  }
+  uint64_t start = TraceEvent::now();
+  exportTrace(tcontext);
+  sampler->recordOverhead(TraceEvent::now() - start);
+}
+
 std::shared_ptr<TraceExporterRegistry> TraceExporterRegistry::getInstance() {
   static auto texp = std::make_shared<TraceExporterRegistry>();
   return texp;
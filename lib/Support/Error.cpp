@@ -91,6 +91,8 @@ std::string GlowErrorValue::errorCodeToString(const ErrorCode &ec) {
     return "RUNTIME_DEVICE_NONRECOVERABLE";
   case ErrorCode::RUNTIME_NET_BUSY:
     return "RUNTIME_NET_BUSY";
+  case ErrorCode::RUNTIME_REQUEST_CANCELLED:
+    return "RUNTIME_REQUEST_CANCELLED";
   case ErrorCode::DEVICE_FEATURE_NOT_SUPPORTED:
     return "DEVICE_FEATURE_NOT_SUPPORTED";
   case ErrorCode::COMPILE_UNSUPPORTED_NODE_AFTER_OPTIMIZE:
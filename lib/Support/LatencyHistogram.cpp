@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "glow/Support/LatencyHistogram.h"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace glow {
+
+size_t LatencyHistogram::getBucketIndex(uint64_t value) {
+  if (value < kSubBuckets) {
+    return value;
+  }
+  // Position of the most significant bit, at least kSubBucketBits here.
+  unsigned msb = 63 - llvm::countLeadingZeros(value);
+  unsigned shift = msb - kSubBucketBits;
+  size_t subBucket = (value >> shift) & (kSubBuckets - 1);
+  return (shift + 1) * kSubBuckets + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t idx) {
+  if (idx < kSubBuckets) {
+    return idx;
+  }
+  unsigned shift = idx / kSubBuckets - 1;
+  uint64_t subBucket = idx % kSubBuckets;
+  uint64_t lower = (kSubBuckets + subBucket) << shift;
+  return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+  buckets_[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t prevMax = max_.load(std::memory_order_relaxed);
+  while (value > prevMax &&
+         !max_.compare_exchange_weak(prevMax, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t LatencyHistogram::getPercentile(double q) const {
+  uint64_t count = getCount();
+  if (count == 0) {
+    return 0;
+  }
+  q = std::min(std::max(q, 0.0), 1.0);
+  // Rank of the requested value, 1-based.
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(q * count));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(getBucketUpperBound(i), getMax());
+    }
+  }
+  // Buckets may lag behind count_ while values are being recorded.
+  return getMax();
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace glow
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "glow/Support/Memory.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+namespace glow {
+
+#ifdef __linux__
+/// Size of the huge pages the buffers are aligned to.
+static constexpr size_t hugePageSize = 2 << 20;
+
+/// \returns \p size bytes of anonymous memory aligned to hugePageSize, on the
+/// reserved huge pages of the system if \p explicitPages, or nullptr if the
+/// mapping fails.
+static void *mapAligned(size_t size, bool explicitPages) {
+  if (explicitPages) {
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+  }
+  // Map a huge page more and trim the ends to align the mapping.
+  void *p = mmap(nullptr, size + hugePageSize, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(p);
+  uintptr_t aligned = alignedSize(begin, hugePageSize);
+  if (aligned != begin) {
+    munmap(p, aligned - begin);
+  }
+  size_t tail = hugePageSize - (aligned - begin);
+  if (tail) {
+    munmap(reinterpret_cast<void *>(aligned + size), tail);
+  }
+  return reinterpret_cast<void *>(aligned);
+}
+
+/// Binds the \p size bytes of \p p to the NUMA node \p node. The pages are
+/// not touched yet, so they are all allocated on the node.
+static void bindToNode(void *p, size_t size, int node) {
+#ifdef SYS_mbind
+  constexpr int mpolBind = 2;
+  constexpr size_t maskBits = 8 * sizeof(unsigned long);
+  if (size_t(node) >= 16 * maskBits) {
+    LOG(WARNING) << "NUMA node " << node << " is out of range";
+    return;
+  }
+  unsigned long mask[16] = {0};
+  mask[node / maskBits] = 1UL << (node % maskBits);
+  if (syscall(SYS_mbind, p, size, mpolBind, mask, 16 * maskBits, 0) != 0) {
+    LOG(WARNING) << "Failed to bind memory to NUMA node " << node;
+  }
+#else
+  LOG(WARNING) << "NUMA binding is not supported on this system";
+#endif
+}
+#endif
+
+void *largeAlloc(size_t size, const LargeAllocPolicy &policy, bool &mapped) {
+  mapped = false;
+#ifdef __linux__
+  if (size == 0 ||
+      (policy.numaNode < 0 &&
+       (policy.hugePageMinBytes == 0 || size < policy.hugePageMinBytes))) {
+    return alignedAlloc(size, TensorAlignment);
+  }
+  const bool onHugePages =
+      policy.hugePageMinBytes != 0 && size >= policy.hugePageMinBytes;
+  const size_t mapSize = alignedSize(size, hugePageSize);
+  void *p = nullptr;
+  if (onHugePages && policy.explicitHugePages) {
+    p = mapAligned(mapSize, /* explicitPages */ true);
+  }
+  if (!p) {
+    p = mapAligned(mapSize, /* explicitPages */ false);
+    if (!p) {
+      return alignedAlloc(size, TensorAlignment);
+    }
+    if (onHugePages) {
+      madvise(p, mapSize, MADV_HUGEPAGE);
+    }
+  }
+  if (policy.numaNode >= 0) {
+    bindToNode(p, mapSize, policy.numaNode);
+  }
+  mapped = true;
+  return p;
+#else
+  return alignedAlloc(size, TensorAlignment);
+#endif
+}
+
+void largeFree(void *p, size_t size) {
+#ifdef __linux__
+  munmap(p, alignedSize(size, hugePageSize));
+#else
+  LOG(FATAL) << "No memory is mapped on this system";
+#endif
+}
+
+} // namespace glow
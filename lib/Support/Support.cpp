@@ -34,6 +34,10 @@
 
 #include <unordered_map>
 
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
 namespace llvm {
 namespace yaml {
 template <> struct BlockScalarTraits<glow::MultiLineStr> {
@@ -148,7 +152,12 @@ std::string escapeDottyString(const std::string &str) {
   return out;
 }
 
-void report(const char *msg) { errs() << msg; }
+void report(const char *msg) {
+  // Verification reports from several threads.
+  static std::mutex reportLock;
+  std::lock_guard<std::mutex> lock(reportLock);
+  errs() << msg;
+}
 
 const std::string strFormat(const char *format, ...) {
   // Initialize use of varargs.
@@ -290,4 +299,19 @@ Expected<float> getFloatFromStr(llvm::StringRef input) {
   return (float)val;
 }
 
+uint64_t getMaxRSSKB() {
+#ifndef _WIN32
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+    // Reported in bytes on macOS.
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+  }
+#endif
+  return 0;
+}
+
 } // namespace glow
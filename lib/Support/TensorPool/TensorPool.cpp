@@ -15,81 +15,150 @@
  */
 
 #include "glow/Support/TensorPool.h"
+#include "glow/Support/Memory.h"
 
-namespace glow {
+#include "llvm/Support/MathExtras.h"
 
-llvm::Optional<Tensor> TensorPool::get(TypeRef ty) {
-  stats_.totalGets++;
+#include <functional>
+#include <thread>
 
-  std::unique_lock<std::mutex> l(lock_);
+namespace glow {
 
-  auto it = pools_.find(*ty);
+constexpr size_t TensorPool::numShards;
 
-  if (it == pools_.end()) {
-    if (preventInlineAllocs_) {
-      return llvm::Optional<Tensor>();
-    }
+size_t TensorPool::getSizeClass(size_t size) {
+  if (size <= 64) {
+    return llvm::PowerOf2Ceil(size);
+  }
+  return llvm::alignTo(size, llvm::PowerOf2Ceil(size) / 4);
+}
 
+TensorPool::Shard &TensorPool::getHomeShard() {
+  static thread_local const size_t home =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) % numShards;
+  return shards_[home];
+}
+
+void TensorPool::addSizeClass(size_t sizeClass) {
+  std::lock_guard<std::mutex> l(sizeClassesLock_);
+  if (sizeClasses_.insert(sizeClass).second) {
     stats_.totalTypes++;
-    it = pools_.emplace(*ty, std::vector<Tensor>()).first;
   }
+}
 
-  if (it->second.empty()) {
-    if (preventInlineAllocs_) {
-      return llvm::Optional<Tensor>();
-    }
+Tensor TensorPool::allocate(TypeRef ty) {
+  const size_t capacity = getSizeClass(ty->getSizeInBytes());
+  stats_.totalAllocs++;
+  stats_.allocatedBytes += capacity;
+  Tensor t;
+  t.type_ = *ty;
+  t.tensorPool_ = this;
+  t.resetDeviceInfo();
+  if (capacity == 0) {
+    t.data_ = nullptr;
+  } else if (allocFn_) {
+    // The Tensor must not free a buffer of allocFn_, see clear().
+    t.data_ = reinterpret_cast<char *>(allocFn_(capacity));
+    t.isUnowned_ = true;
+  } else {
+    t.data_ =
+        reinterpret_cast<char *>(alignedAlloc(capacity, TensorAlignment));
+  }
+  t.unpaddedSize_ = ty->getSizeInBytes();
+  return t;
+}
+
+llvm::Optional<Tensor> TensorPool::get(TypeRef ty) {
+  stats_.totalGets++;
 
-    // Don't need to alloc under the lock.
+  const size_t size = ty->getSizeInBytes();
+  const size_t sizeClass = getSizeClass(size);
+  Shard *home = &getHomeShard();
+  const size_t homeIdx = home - shards_.data();
+
+  // Look in the home shard first, then in the others.
+  for (size_t i = 0; i < numShards; i++) {
+    Shard &shard = shards_[(homeIdx + i) % numShards];
+    std::unique_lock<std::mutex> l(shard.lock);
+    auto it = shard.buffers.find(sizeClass);
+    if (it == shard.buffers.end() || it->second.empty()) {
+      continue;
+    }
+    Tensor t = std::move(it->second.back());
+    it->second.pop_back();
     l.unlock();
-    stats_.totalAllocs++;
-    stats_.inlineAllocs++;
-    // Don't add it to the queue because it's being claimed now.
-    return Tensor(ty, this);
+
+    stats_.currentBuffers--;
+    stats_.availableBytes -= sizeClass;
+    stats_.totalHits++;
+    if (i != 0) {
+      stats_.sharedHits++;
+    }
+    stats_.totalWastedBytes += sizeClass - size;
+    // The buffer may have held a Type of another size of the size class.
+    t.type_ = *ty;
+    t.unpaddedSize_ = size;
+    return t;
   }
 
-  auto &queue = it->second;
-  Tensor t = std::move(queue.back());
-  queue.pop_back();
-  stats_.currentBuffers--;
-  return t;
+  if (preventInlineAllocs_) {
+    return llvm::Optional<Tensor>();
+  }
+
+  // Don't add it to the queue because it's being claimed now.
+  addSizeClass(sizeClass);
+  stats_.inlineAllocs++;
+  stats_.totalWastedBytes += sizeClass - size;
+  return allocate(ty);
 }
 
 void TensorPool::reclaim(Tensor &&t) {
-  std::lock_guard<std::mutex> l(lock_);
-  auto it = pools_.find(t.getType());
-  assert(it != pools_.end() && "Type has not been initialized");
+  assert(t.getOwningPool() == this && "Tensor is not managed by this pool");
+  const size_t sizeClass = getSizeClass(t.getSizeInBytes());
+  Shard &shard = getHomeShard();
+  std::lock_guard<std::mutex> l(shard.lock);
   stats_.totalReclaims++;
   stats_.currentBuffers++;
-  it->second.emplace_back(std::move(t));
+  stats_.availableBytes += sizeClass;
+  shard.buffers[sizeClass].emplace_back(std::move(t));
 }
 
 void TensorPool::reserve(TypeRef ty, size_t count) {
   std::vector<Tensor> temp;
   temp.reserve(count);
   for (unsigned i = 0; i < count; ++i) {
-    stats_.totalAllocs++;
-    temp.emplace_back(ty, this);
+    temp.emplace_back(allocate(ty));
   }
 
+  const size_t sizeClass = getSizeClass(ty->getSizeInBytes());
+  addSizeClass(sizeClass);
   {
-    std::lock_guard<std::mutex> l(lock_);
-    auto it = pools_.find(*ty);
-    if (it == pools_.end()) {
-      stats_.totalTypes++;
-    }
-
-    std::vector<Tensor> &queue = pools_[*ty];
+    Shard &shard = getHomeShard();
+    std::lock_guard<std::mutex> l(shard.lock);
+    std::vector<Tensor> &queue = shard.buffers[sizeClass];
     std::move(temp.begin(), temp.end(), std::back_inserter(queue));
     stats_.currentBuffers += count;
+    stats_.availableBytes += sizeClass * count;
   }
 }
 
 void TensorPool::clear() {
-  std::lock_guard<std::mutex> l(lock_);
-  for (auto &p : pools_) {
-    stats_.currentBuffers -= p.second.size();
-    stats_.totalFrees += p.second.size();
-    p.second.clear();
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> l(shard.lock);
+    for (auto &p : shard.buffers) {
+      stats_.currentBuffers -= p.second.size();
+      stats_.totalFrees += p.second.size();
+      stats_.availableBytes -= p.first * p.second.size();
+      stats_.allocatedBytes -= p.first * p.second.size();
+      if (freeFn_) {
+        for (auto &t : p.second) {
+          if (t.isUnowned() && t.getData()) {
+            freeFn_(t.getData());
+          }
+        }
+      }
+      p.second.clear();
+    }
   }
   assert(stats_.currentBuffers == 0);
 }
@@ -16,6 +16,13 @@
 #include "glow/Support/ThreadPool.h"
 #include "folly/system/ThreadName.h"
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
 namespace glow {
 
 namespace threads {
@@ -29,10 +36,49 @@ size_t getThreadId() {
 
 size_t createThreadId() { return thread_idx++; }
 
+bool parseCPUList(llvm::StringRef list, std::vector<unsigned> &cpus) {
+  llvm::SmallVector<llvm::StringRef, 8> items;
+  list.trim().split(items, ',', -1, false);
+  for (llvm::StringRef item : items) {
+    auto range = item.trim().split('-');
+    unsigned first, last;
+    if (!llvm::to_integer(range.first, first)) {
+      return false;
+    }
+    last = first;
+    if (!range.second.empty() &&
+        (!llvm::to_integer(range.second, last) || last < first)) {
+      return false;
+    }
+    for (unsigned cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return !cpus.empty();
+}
+
+bool setAffinity(const std::vector<unsigned> &cpus) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (unsigned cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
 } // namespace threads
 
-ThreadExecutor::ThreadExecutor(const std::string &name)
-    : shouldStop_(false), worker_([this, name]() {
+ThreadExecutor::ThreadExecutor(const std::string &name,
+                               unsigned spinIterations)
+    : shouldStop_(false), spinIterations_(spinIterations),
+      worker_([this, name]() {
         if (!name.empty()) {
           folly::setThreadName(name);
         }
@@ -56,51 +102,86 @@ void ThreadExecutor::stop(bool block) {
   }
 }
 
-void ThreadExecutor::threadPoolWorkerMain() {
-  std::unique_lock<std::mutex> lock(workQueueMtx_, std::defer_lock);
+bool ThreadExecutor::popTask(InlineTask &task) {
+  // Items only overflow into workQueue_ after those of the lock-free queue.
+  if (taskQueue_.tryPop(task)) {
+    return true;
+  }
+  if (workQueueSize_.load(std::memory_order_acquire) == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(workQueueMtx_);
+  task = std::move(workQueue_.front());
+  workQueue_.pop();
+  workQueueSize_.fetch_sub(1, std::memory_order_release);
+  return true;
+}
 
+void ThreadExecutor::threadPoolWorkerMain() {
+  unsigned spins = 0;
+  InlineTask workItem;
   while (!shouldStop_) {
-    // Lock the lock after processing a work item.
-    lock.lock();
-
-    // If work queue is empty, wait to be signalled when
-    // a work item is submitted.
-    while (workQueue_.empty() && !shouldStop_) {
-      queueNotEmpty_.wait(lock);
+    if (popTask(workItem)) {
+      // Process work item.
+      workItem();
+      workItem.reset();
+      spins = 0;
+      continue;
     }
-
-    // If shouldStop_ was set to false while the thread
-    // was asleep, break out of the main loop.
-    if (shouldStop_) {
-      break;
+    if (spins < spinIterations_) {
+      spins++;
+      std::this_thread::yield();
+      continue;
     }
 
-    // Pop a work item from the queue, and make sure to unlock
-    // the lock before processing it.
-    auto workItem = std::move(workQueue_.front());
-    workQueue_.pop();
-    lock.unlock();
+    // Sleep until a work item is submitted. The fence pairs with the one of
+    // notifyWorker: either the submitter sees sleeping_ and signals us, or we
+    // see its work item below.
+    std::unique_lock<std::mutex> lock(workQueueMtx_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    queueNotEmpty_.wait(lock, [this]() {
+      return shouldStop_ || !taskQueue_.empty() ||
+             workQueueSize_.load(std::memory_order_relaxed) != 0;
+    });
+    sleeping_.store(false, std::memory_order_relaxed);
+    spins = 0;
+  }
+}
+
+void ThreadExecutor::notifyWorker() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    // Taking the lock makes sure the worker is either waiting, or hasn't
+    // checked for work yet.
+    std::lock_guard<std::mutex> lock(workQueueMtx_);
+    queueNotEmpty_.notify_one();
+  }
+}
 
-    // Process work item.
-    workItem();
+void ThreadExecutor::post(InlineTask &&task) {
+  if (workQueueSize_.load(std::memory_order_acquire) != 0 ||
+      !taskQueue_.tryPush(std::move(task))) {
+    std::lock_guard<std::mutex> lock(workQueueMtx_);
+    workQueue_.push(std::move(task));
+    workQueueSize_.fetch_add(1, std::memory_order_release);
   }
+  notifyWorker();
 }
 
 std::future<void>
 ThreadExecutor::submit(std::packaged_task<void(void)> &&task) {
-  std::unique_lock<std::mutex> lock(workQueueMtx_);
   auto future = task.get_future();
-  workQueue_.push(std::move(task));
-  lock.unlock();
-  queueNotEmpty_.notify_one();
+  post(InlineTask(std::move(task)));
   return future;
 }
 
-ThreadPool::ThreadPool(unsigned numWorkers, const std::string &name) {
+ThreadPool::ThreadPool(unsigned numWorkers, const std::string &name,
+                       unsigned spinIterations) {
   // Intialize all workers and make each one run threadPoolWorkerMain.
   workers_.reserve(kNumWorkers);
   for (unsigned i = 0; i < numWorkers; i++) {
-    workers_.push_back(new ThreadExecutor(name));
+    workers_.push_back(new ThreadExecutor(name, spinIterations));
     size_t threadId{0};
     workers_.back()
         ->submit([&threadId] { threadId = threads::getThreadId(); })
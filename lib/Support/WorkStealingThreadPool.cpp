@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "glow/Support/WorkStealingThreadPool.h"
+#include "folly/system/ThreadName.h"
+
+namespace glow {
+
+namespace {
+/// The pool the current thread is a worker of, if any.
+thread_local const WorkStealingThreadPool *currentPool = nullptr;
+/// Index of the current thread inside currentPool.
+thread_local unsigned currentWorkerIdx = 0;
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(unsigned numWorkers,
+                                               const std::string &name) {
+  if (numWorkers == 0) {
+    numWorkers = 1;
+  }
+  workers_.reserve(numWorkers);
+  for (unsigned i = 0; i < numWorkers; i++) {
+    workers_.emplace_back(new Worker());
+  }
+  // Only start the threads once every deque exists since workers steal from
+  // each other right away.
+  for (unsigned i = 0; i < numWorkers; i++) {
+    workers_[i]->thread = std::thread([this, name, i]() {
+      if (!name.empty()) {
+        folly::setThreadName(name);
+      }
+      workerMain(i);
+    });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  stop();
+  join();
+}
+
+void WorkStealingThreadPool::add(Task fn) {
+  Task *task = new Task(std::move(fn));
+  if (currentPool == this) {
+    // Keep work created by a worker local to it; idle peers will steal it.
+    workers_[currentWorkerIdx]->deque.push(task);
+    pending_.fetch_add(1);
+    // Take the lock so a worker that just found no work cannot miss this
+    // notification between its check and its wait.
+    std::lock_guard<std::mutex> g(mtx_);
+  } else {
+    std::lock_guard<std::mutex> g(mtx_);
+    injectionQueue_.push_back(task);
+    pending_.fetch_add(1);
+  }
+  idleCV_.notify_one();
+}
+
+void WorkStealingThreadPool::stop() {
+  {
+    std::lock_guard<std::mutex> g(mtx_);
+    stopping_ = true;
+  }
+  idleCV_.notify_all();
+}
+
+void WorkStealingThreadPool::join() {
+  for (auto &w : workers_) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+}
+
+WorkStealingThreadPool::Task *WorkStealingThreadPool::findTask(unsigned idx) {
+  // Local work first, newest first.
+  if (Task *task = workers_[idx]->deque.pop()) {
+    return task;
+  }
+
+  // Then work submitted from outside the pool, oldest first.
+  {
+    std::lock_guard<std::mutex> g(mtx_);
+    if (!injectionQueue_.empty()) {
+      Task *task = injectionQueue_.front();
+      injectionQueue_.pop_front();
+      return task;
+    }
+  }
+
+  // Finally try to steal the oldest item from each peer, starting with the
+  // next one so that thieves spread out over their victims.
+  const unsigned numWorkers = workers_.size();
+  for (unsigned i = 1; i < numWorkers; i++) {
+    unsigned victim = (idx + i) % numWorkers;
+    if (Task *task = workers_[victim]->deque.steal()) {
+      numSteals_.fetch_add(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void WorkStealingThreadPool::workerMain(unsigned idx) {
+  currentPool = this;
+  currentWorkerIdx = idx;
+
+  while (true) {
+    if (Task *task = findTask(idx)) {
+      pending_.fetch_sub(1);
+      (*task)();
+      delete task;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    // pending_ may be positive while a steal lost a race, in which case we
+    // go around again instead of sleeping.
+    idleCV_.wait(lock, [this]() { return pending_ > 0 || stopping_; });
+    if (stopping_ && pending_ == 0) {
+      break;
+    }
+  }
+
+  currentPool = nullptr;
+}
+
+} // namespace glow
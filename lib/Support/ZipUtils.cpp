@@ -19,6 +19,8 @@
 
 #include "llvm/ADT/STLExtras.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 namespace glow {
@@ -59,9 +61,20 @@ size_t istreamReadFunc(void *pOpaque, mz_uint64 file_ofs, void *pBuf,
   return self->read(file_ofs, static_cast<char *>(pBuf), n);
 }
 
-ZipReader::ZipReader(const std::string &file_name)
-    : ar_(glow::make_unique<mz_zip_archive>()),
-      in_(glow::make_unique<FileAdapter>(file_name)) {
+ZipReader::ZipReader(const std::string &file_name, bool mapFile)
+    : ar_(glow::make_unique<mz_zip_archive>()) {
+  if (mapFile) {
+    auto mappingOrErr = llvm::WritableMemoryBuffer::getFile(file_name);
+    if (mappingOrErr) {
+      mapping_ = std::move(*mappingOrErr);
+    } else {
+      LOG(ERROR) << "Cannot map file " << file_name << ": "
+                 << mappingOrErr.getError().message();
+    }
+  }
+  if (!mapping_) {
+    in_ = glow::make_unique<FileAdapter>(file_name);
+  }
   init();
 }
 
@@ -70,11 +83,23 @@ ZipReader::~ZipReader() {
   valid("closing reader for archive ", archive_name_.c_str());
 }
 
+size_t ZipReader::read(uint64_t pos, char *buf, size_t n) {
+  if (!mapping_) {
+    return in_->read(pos, buf, n, "reading file");
+  }
+  if (pos >= mapping_->getBufferSize()) {
+    return 0;
+  }
+  n = std::min<uint64_t>(n, mapping_->getBufferSize() - pos);
+  memcpy(buf, mapping_->getBufferStart() + pos, n);
+  return n;
+}
+
 void ZipReader::init() {
-  assert(in_ != nullptr);
+  assert(in_ != nullptr || mapping_ != nullptr);
   assert(ar_ != nullptr);
   memset(ar_.get(), 0, sizeof(mz_zip_archive));
-  size_t size = in_->size();
+  size_t size = mapping_ ? mapping_->getBufferSize() : in_->size();
   ar_->m_pIO_opaque = this;
   ar_->m_pRead = istreamReadFunc;
   mz_zip_reader_init(ar_.get(), size, 0);
@@ -133,6 +158,43 @@ std::string ZipReader::getRecord(const std::string &name) {
   return data;
 }
 
+bool ZipReader::getStoredRecordLocation(const std::string &name,
+                                        uint64_t &offset, uint64_t &size) {
+  size_t key = getRecordID(name);
+  mz_zip_archive_file_stat stat;
+  mz_zip_reader_file_stat(ar_.get(), key, &stat);
+  valid("retrieving file meta-data for ", name.c_str());
+  if (stat.m_method != 0 || stat.m_comp_size != stat.m_uncomp_size) {
+    return false;
+  }
+  // The data follows the local header, the file name and the extra field,
+  // which holds the padding of ZipWriter.
+  uint8_t header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
+  if (read(stat.m_local_header_ofs, reinterpret_cast<char *>(header),
+           sizeof(header)) != sizeof(header)) {
+    return false;
+  }
+  const uint64_t nameSize = header[26] | (header[27] << 8);
+  const uint64_t extraSize = header[28] | (header[29] << 8);
+  offset = stat.m_local_header_ofs + sizeof(header) + nameSize + extraSize;
+  size = stat.m_uncomp_size;
+  return true;
+}
+
+llvm::MutableArrayRef<char>
+ZipReader::getMutableRecordView(const std::string &name) {
+  uint64_t offset;
+  uint64_t size;
+  if (mapping_ && getStoredRecordLocation(name, offset, size) &&
+      offset + size <= mapping_->getBufferSize()) {
+    return llvm::MutableArrayRef<char>(mapping_->getBufferStart() + offset,
+                                       size);
+  }
+  extracted_.push_back(getRecord(name));
+  std::string &data = extracted_.back();
+  return llvm::MutableArrayRef<char>(&data[0], data.size());
+}
+
 void ZipReader::valid(const char *what, const char *info) {
   auto err = mz_zip_get_last_error(ar_.get());
   if (err != MZ_ZIP_NO_ERROR) {
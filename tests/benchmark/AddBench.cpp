@@ -189,4 +189,12 @@ int main(int argc, char *argv[]) {
       n, numLayers, reps, asyncLaunches, numCores, backendStr, dtypeStr,
       median_runtime, min_runtime, b.gbytes() / median_runtime,
       b.gbytes() / min_runtime);
+      reportBench("AddBench",
+                  {{"n", std::to_string(n)},
+                   {"numLayers", std::to_string(numLayers)},
+                   {"numAsyncLaunches", std::to_string(asyncLaunches)},
+                   {"numAddChains", std::to_string(numCores)},
+                   {"backendStr", backendStr},
+                   {"dtypeStr", dtypeStr}},
+                  times, asyncLaunches, 0, b.gbytes());
 }
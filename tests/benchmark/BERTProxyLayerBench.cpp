@@ -477,4 +477,15 @@ int main(int argc, char *argv[]) {
          maxSequenceLength, batchSize, hiddenSize, numHeads, numCores, numReps,
          numAsyncLaunches, backendStr, dtypeStr, useInt8FCs, median_runtime,
          min_runtime, b.gflops() / median_runtime, b.gflops() / min_runtime);
+  reportBench("BERTProxyLayerBench",
+              {{"maxSequenceLength", std::to_string(maxSequenceLength)},
+               {"batchSize", std::to_string(batchSize)},
+               {"hiddenSize", std::to_string(hiddenSize)},
+               {"numHeads", std::to_string(numHeads)},
+               {"numCores", std::to_string(numCores)},
+               {"numAsyncLaunches", std::to_string(numAsyncLaunches)},
+               {"backendStr", backendStr},
+               {"dtypeStr", dtypeStr},
+               {"useInt8FCs", useInt8FCs}},
+              times, numAsyncLaunches, b.gflops(), 0);
 }
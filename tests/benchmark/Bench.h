@@ -18,15 +18,51 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <limits>
+#include <string>
+#include <thread>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "glow/Base/DimType.h"
+#include "glow/Support/ThreadPool.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "glow/IR/LLVMAPIMacros.h"
 
 namespace glow {
 
+/// Options of the benchmark harness, passed with GLOW_OPTS like the other
+/// Glow options, see benchParseGlowOpts.
+static llvm::cl::OptionCategory benchCat("Benchmark Harness Options");
+
+static llvm::cl::opt<unsigned>
+    benchWarmupOpt("bench-warmup",
+                   llvm::cl::desc("Number of untimed runs of a benchmark "
+                                  "before its timed ones"),
+                   llvm::cl::init(1), llvm::cl::cat(benchCat));
+
+static llvm::cl::opt<std::string> benchCPUsOpt(
+    "bench-cpus",
+    llvm::cl::desc("Pin the benchmark, and the threads it starts, to the CPUs "
+                   "and CPU ranges of this list, such as \"0-3,8\""),
+    llvm::cl::init(""), llvm::cl::cat(benchCat));
+
+static llvm::cl::opt<std::string> benchJSONOpt(
+    "bench-json",
+    llvm::cl::desc("Append the statistics of every benchmark, one JSON object "
+                   "per line, to this file"),
+    llvm::cl::init(""), llvm::cl::cat(benchCat));
+
 /// Interface for benchmarks
 class Benchmark {
 public:
@@ -36,10 +72,29 @@ public:
   virtual void teardown() = 0;
 };
 
-/// Run a benchmark \p reps times and return the execution times
+/// Pin the current thread, and the threads it starts from now on, to the CPUs
+/// of -bench-cpus if set.
+inline void pinBenchThread() {
+  if (benchCPUsOpt.empty()) {
+    return;
+  }
+  std::vector<unsigned> cpus;
+  if (!threads::parseCPUList(benchCPUsOpt, cpus) ||
+      !threads::setAffinity(cpus)) {
+    fprintf(stderr, "Failed to pin the benchmark to CPUs %s\n",
+            benchCPUsOpt.c_str());
+  }
+}
+
+/// Run a benchmark \p reps times and return the execution times, after
+/// -bench-warmup untimed runs.
 std::vector<double> bench(Benchmark *b, size_t reps) {
   std::vector<double> times(reps);
+  pinBenchThread();
   b->setup();
+  for (unsigned i = 0; i < benchWarmupOpt; i++) {
+    b->run();
+  }
   for (size_t i = 0; i < reps; i++) {
     auto start = std::chrono::high_resolution_clock::now();
     b->run();
@@ -51,6 +106,152 @@ std::vector<double> bench(Benchmark *b, size_t reps) {
   return times;
 }
 
+/// Statistics of the execution times of a benchmark, in seconds.
+struct BenchStats {
+  size_t reps{0};
+  /// Number of times further than 3 scaled median absolute deviations from
+  /// the median, which the mean and the standard deviation leave out.
+  size_t outliers{0};
+  double min{0};
+  double max{0};
+  double median{0};
+  double p99{0};
+  double mean{0};
+  double stddev{0};
+  /// Bounds of the 95% confidence interval of the median.
+  double medianLow{0};
+  double medianHigh{0};
+};
+
+/// \returns the statistics of the execution times \p times.
+inline BenchStats computeBenchStats(std::vector<double> times) {
+  BenchStats stats;
+  stats.reps = times.size();
+  if (times.empty()) {
+    return stats;
+  }
+  std::sort(times.begin(), times.end());
+  size_t n = times.size();
+  auto rank = [&](double r) {
+    return times[std::min<size_t>(std::max(r, 0.0), n - 1)];
+  };
+  stats.min = times.front();
+  stats.max = times.back();
+  stats.median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+  stats.p99 = rank(std::ceil(0.99 * n) - 1);
+  // The ranks of the confidence interval of the median follow from the
+  // normal approximation of the binomial distribution.
+  double halfWidth = 1.96 * std::sqrt((double)n) / 2;
+  stats.medianLow = rank(std::floor(n / 2.0 - halfWidth));
+  stats.medianHigh = rank(std::ceil(n / 2.0 + halfWidth));
+
+  std::vector<double> deviations(n);
+  for (size_t i = 0; i < n; i++) {
+    deviations[i] = std::abs(times[i] - stats.median);
+  }
+  std::nth_element(deviations.begin(), deviations.begin() + n / 2,
+                   deviations.end());
+  double limit = 3 * 1.4826 * deviations[n / 2];
+  double sum = 0, sumSquares = 0;
+  size_t count = 0;
+  for (double t : times) {
+    if (limit > 0 && std::abs(t - stats.median) > limit) {
+      stats.outliers++;
+      continue;
+    }
+    sum += t;
+    sumSquares += t * t;
+    count++;
+  }
+  stats.mean = sum / count;
+  stats.stddev =
+      count > 1 ? std::sqrt(std::max(
+                      (sumSquares - sum * sum / count) / (count - 1), 0.0))
+                : 0;
+  return stats;
+}
+
+/// \returns the named parameters of a benchmark printed as \p values, the
+/// comma separated values of the CSV columns \p header except the first. The
+/// columns named "_" are left out.
+inline std::vector<std::pair<std::string, std::string>>
+getBenchParams(llvm::StringRef header, llvm::StringRef values) {
+  llvm::SmallVector<llvm::StringRef, 16> names, fields;
+  header.trim().split(names, ',');
+  values.trim().split(fields, ',');
+  std::vector<std::pair<std::string, std::string>> params;
+  for (size_t i = 1; i < names.size() && i - 1 < fields.size(); i++) {
+    if (names[i].trim() != "_") {
+      params.emplace_back(names[i].trim().str(), fields[i - 1].trim().str());
+    }
+  }
+  return params;
+}
+
+/// Print the statistics of the execution times \p times of the benchmark
+/// \p name, of parameters \p params, and append them to the -bench-json file.
+/// Each run performs \p launches launches, of \p gflop GFLOP and \p gbyte GB
+/// each, 0 if the benchmark does not count them. \returns the statistics of
+/// the time of a launch.
+inline BenchStats
+reportBench(const std::string &name,
+            const std::vector<std::pair<std::string, std::string>> &params,
+            const std::vector<double> &times, size_t launches, double gflop,
+            double gbyte) {
+  std::vector<double> launchTimes;
+  for (double t : times) {
+    launchTimes.push_back(t / launches);
+  }
+  BenchStats stats = computeBenchStats(launchTimes);
+  double gflopPerSec = stats.median > 0 ? gflop / stats.median : 0;
+  double gbytePerSec = stats.median > 0 ? gbyte / stats.median : 0;
+  printf("BenchStats,%s,median,p99,stddev,medianLow,medianHigh,outliers,"
+         "gflopPerSec,gbytePerSec\n",
+         name.c_str());
+  printf("BenchStats,%s,%f,%f,%f,%f,%f,%zu,%f,%f\n", name.c_str(),
+         stats.median, stats.p99, stats.stddev, stats.medianLow,
+         stats.medianHigh, stats.outliers, gflopPerSec, gbytePerSec);
+  if (benchJSONOpt.empty()) {
+    return stats;
+  }
+
+  std::error_code EC;
+  llvm::raw_fd_ostream os(benchJSONOpt, EC, GET_FS_OPENFLAGS(F_Append));
+  if (EC) {
+    fprintf(stderr, "Failed to open %s: %s\n", benchJSONOpt.c_str(),
+            EC.message().c_str());
+    return stats;
+  }
+  auto quote = [](llvm::StringRef str) {
+    std::string quoted = "\"";
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+      }
+      quoted += c;
+    }
+    return quoted + "\"";
+  };
+  os << "{\"name\": " << quote(name) << ", \"params\": {";
+  for (size_t i = 0; i < params.size(); i++) {
+    os << (i ? ", " : "") << quote(params[i].first) << ": "
+       << quote(params[i].second);
+  }
+  os << "}, \"host\": {\"cpu\": " << quote(llvm::sys::getHostCPUName())
+     << ", \"threads\": " << std::thread::hardware_concurrency()
+     << ", \"cpus\": " << quote(benchCPUsOpt) << "}";
+  os << ", \"reps\": " << stats.reps << ", \"warmup\": " << benchWarmupOpt
+     << ", \"outliers\": " << stats.outliers;
+  os << llvm::format(", \"seconds\": {\"min\": %g, \"max\": %g, "
+                     "\"median\": %g, \"p99\": %g, \"mean\": %g, "
+                     "\"stddev\": %g, \"medianCI95\": [%g, %g]}",
+                     stats.min, stats.max, stats.median, stats.p99, stats.mean,
+                     stats.stddev, stats.medianLow, stats.medianHigh);
+  os << llvm::format(", \"gflopPerSec\": %g, \"gbytePerSec\": %g}\n",
+                     gflopPerSec, gbytePerSec);
+  return stats;
+}
+
 std::vector<dim_t> getBatchSizePerCore(size_t batchSize, dim_t numCores) {
   std::vector<dim_t> batchSizePerCore(numCores);
   for (dim_t core = 0; core < numCores; core++) {
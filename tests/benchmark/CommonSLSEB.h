@@ -604,7 +604,8 @@ preMain(const int argc, char *argv[], const BenchmarkType benchType) {
          "sortedStr(\"Sorted\"|\"Unsorted\") backendStr(String) "
          "dtypeStr(\"Float16\"|\"Float32\") "
          "addClipStr(\"True\"|\"False\")\nQuantized only options: "
-         "quantizationDtypeStr(\"Int8\"|\"Int4\") "
+         "quantizationDtypeStr(\"Int8\"|\"Int8_Fp32\"|\"Int4\"|"
+         "\"Int4_Fp32\") "
          "useFP16AccumulationStr(\"True\"|\"False\") \n"
          "Optional: dev_id(Int)\n",
          benchPrefix.c_str(), benchPrefix.c_str());
@@ -662,7 +663,9 @@ preMain(const int argc, char *argv[], const BenchmarkType benchType) {
         (size_t)param.numIndicesPerBatchPad, (size_t)param.numTableEntries,
         (size_t)param.numElementsPerRow, (size_t)param.numReps,
         (size_t)param.numAsyncLaunches, (size_t)param.numSLSNodes, argv[9],
-        argv[10], argv[11], argv[12], argv[13], argv[14], argv[15]));
+        argv[10], argv[11], argv[12], argv[13],
+        argc > ROWWISE_QUANT ? argv[ROWWISE_QUANT] : "Int8",
+        argc > ACCUM_TYPE ? argv[ACCUM_TYPE] : "False"));
   } else {
     llvm_unreachable("Invalid command line");
   }
@@ -689,6 +692,9 @@ inline void printSummary(const std::string &runPrefix,
          runHeader.c_str());
   printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
          minRuntime, gb / medianRuntime, gb / minRuntime);
+  reportBench(llvm::StringRef(runPrefix).split(',').first.str(),
+              getBenchParams(runHeader, runPrefix), times,
+              param.numAsyncLaunches, 0, gb);
 }
 }; // namespace benchmark
 }; // namespace glow
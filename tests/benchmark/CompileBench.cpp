@@ -0,0 +1,423 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <chrono>
+#include <future>
+
+#include "Bench.h"
+
+#include "glow/Backend/Backend.h"
+#include "glow/Backends/DeviceManager.h"
+#include "glow/Graph/Graph.h"
+#include "glow/IR/IR.h"
+#include "glow/Importer/ONNXModelLoader.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Optimizer/IROptimizer/IROptimizer.h"
+#include "glow/Partitioner/Partitioner.h"
+#include "glow/Support/Error.h"
+#include "glow/Support/Random.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/ADT/StringExtras.h"
+
+using namespace glow;
+
+/// Compilation time benchmark. Reference models are built, or imported, and
+/// compiled phase by phase the way the HostManager compiles them, and the
+/// time and the peak memory usage of the process are reported per phase:
+/// - import: building the graph, or loading the -model ONNX file;
+/// - optimizeBeforeLowering: glow::optimizeFunctionBeforeLowering;
+/// - lower: glow::lower for the backend;
+/// - optimizeFunction: the rest of glow::optimizeFunction on the lowered graph
+///   (precision transforms, backend post-lowering transforms, verification);
+/// - partition: the Partitioner, on the optimized Module;
+/// - irgen, irOptimize: IR generation and optimization of every partition;
+/// - codegen: BackendUsingGlowIR::compileIR, the LLVM code generation on the
+///   LLVM backends;
+/// - provision: loading the compiled partitions on a device.
+
+namespace {
+llvm::cl::OptionCategory category("CompileBench Options");
+
+llvm::cl::opt<std::string> backend("backend", llvm::cl::desc("Backend to use"),
+                                   llvm::cl::Optional, llvm::cl::init("CPU"),
+                                   llvm::cl::cat(category));
+
+llvm::cl::list<std::string>
+    models("models",
+           llvm::cl::desc("Comma separated list of the reference models to "
+                          "compile, among resnet50, bert and dlrm"),
+           llvm::cl::CommaSeparated, llvm::cl::ZeroOrMore,
+           llvm::cl::cat(category));
+
+llvm::cl::opt<std::string> modelPath(
+    "model",
+    llvm::cl::desc("ONNX model to compile, with inputs of static shapes, "
+                   "instead of the reference models"),
+    llvm::cl::init(""), llvm::cl::value_desc("model.onnx"),
+    llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> reps("reps",
+                             llvm::cl::desc("Number of compilations of each "
+                                            "model"),
+                             llvm::cl::init(3), llvm::cl::value_desc("N"),
+                             llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> batchSize("batchSize",
+                                  llvm::cl::desc("Batch size of the models"),
+                                  llvm::cl::init(1), llvm::cl::value_desc("N"),
+                                  llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> bertLayers("bertLayers",
+                                   llvm::cl::desc("Number of encoder layers of "
+                                                  "the bert model"),
+                                   llvm::cl::init(12),
+                                   llvm::cl::value_desc("N"),
+                                   llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> dlrmTables("dlrmTables",
+                                   llvm::cl::desc("Number of embedding tables "
+                                                  "of the dlrm model"),
+                                   llvm::cl::init(10),
+                                   llvm::cl::value_desc("N"),
+                                   llvm::cl::cat(category));
+
+/// The compilation phases, in order.
+const char *const kPhases[] = {"import",     "optimizeBeforeLowering",
+                               "lower",      "optimizeFunction",
+                               "partition",  "irgen",
+                               "irOptimize", "codegen",
+                               "provision"};
+constexpr size_t kNumPhases = sizeof(kPhases) / sizeof(kPhases[0]);
+
+/// Measurements of a phase over the compilations of a model.
+struct PhaseStats {
+  /// Time of the phase in each compilation, in seconds.
+  std::vector<double> seconds;
+  /// Peak resident set size of the process at the end of the phase, in KB.
+  uint64_t maxRSSKB{0};
+  /// Largest growth of the peak resident set size during the phase, in KB.
+  uint64_t maxRSSGrowthKB{0};
+};
+
+/// \returns a float constant of dimensions \p dims, random in [-1, 1),
+/// created in \p mod.
+Constant *createRandomConstant(Module &mod, llvm::ArrayRef<dim_t> dims,
+                               llvm::StringRef name, PseudoRNG &PRNG) {
+  Constant *C = mod.createConstant(ElemKind::FloatTy, dims, name);
+  C->getPayloadMutable().getHandle().randomize(-1, 1, PRNG);
+  return C;
+}
+
+/// \returns a FullyConnected layer of \p F of \p outDim outputs on \p input.
+NodeValue createFC(Function *F, NodeValue input, dim_t outDim,
+                   llvm::StringRef name, PseudoRNG &PRNG) {
+  Module &mod = *F->getParent();
+  dim_t inDim = input.dims()[1];
+  auto *W = createRandomConstant(mod, {inDim, outDim}, name.str() + ".W", PRNG);
+  auto *B = createRandomConstant(mod, {outDim}, name.str() + ".B", PRNG);
+  return F->createFullyConnected(name, input, W, B);
+}
+
+/// \returns a Convolution of \p F of \p outC channels, kernel \p kernel,
+/// stride \p stride and pads \p kernel / 2 on the NHWC \p input.
+NodeValue createConv(Function *F, NodeValue input, dim_t outC,
+                     unsigned_t kernel, unsigned_t stride,
+                     llvm::StringRef name, PseudoRNG &PRNG) {
+  Module &mod = *F->getParent();
+  auto dims = input.dims();
+  unsigned_t pad = kernel / 2;
+  dim_t outH = (dims[1] + 2 * pad - kernel) / stride + 1;
+  dim_t outW = (dims[2] + 2 * pad - kernel) / stride + 1;
+  auto *filter = createRandomConstant(mod, {outC, kernel, kernel, dims[3]},
+                                      name.str() + ".filter", PRNG);
+  auto *bias = createRandomConstant(mod, {outC}, name.str() + ".bias", PRNG);
+  auto outTy = mod.uniqueType(ElemKind::FloatTy, {dims[0], outH, outW, outC});
+  return F->createConv(name, input, filter, bias, outTy, kernel, stride, pad,
+                       /* group */ 1);
+}
+
+/// Builds ResNet-50 into \p F, with the batch normalizations folded.
+void buildResNet50(Function *F, PseudoRNG &PRNG) {
+  Module &mod = *F->getParent();
+  NodeValue cur = mod.createPlaceholder(ElemKind::FloatTy,
+                                        {batchSize, 224, 224, 3}, "input",
+                                        false);
+  cur = createConv(F, cur, 64, 7, 2, "conv1", PRNG);
+  cur = F->createRELU("conv1.relu", cur);
+  cur = F->createMaxPool("pool1", cur, 3, 2, 1)->getResult();
+  const dim_t stageChannels[] = {64, 128, 256, 512};
+  const unsigned stageBlocks[] = {3, 4, 6, 3};
+  for (unsigned s = 0; s < 4; s++) {
+    for (unsigned b = 0; b < stageBlocks[s]; b++) {
+      std::string name = strFormat("res%u.%u", s + 2, b);
+      dim_t c = stageChannels[s];
+      unsigned_t stride = (b == 0 && s > 0) ? 2 : 1;
+      NodeValue shortcut = cur;
+      if (b == 0) {
+        shortcut = createConv(F, cur, 4 * c, 1, stride, name + ".proj", PRNG);
+      }
+      NodeValue x = createConv(F, cur, c, 1, 1, name + ".a", PRNG);
+      x = F->createRELU(name + ".a.relu", x);
+      x = createConv(F, x, c, 3, stride, name + ".b", PRNG);
+      x = F->createRELU(name + ".b.relu", x);
+      x = createConv(F, x, 4 * c, 1, 1, name + ".c", PRNG);
+      cur = F->createRELU(name + ".relu", F->createAdd(name, x, shortcut));
+    }
+  }
+  cur = F->createAvgPool("pool5", cur, 7, 1, 0)->getResult();
+  cur = F->createReshape("flatten", cur, {batchSize, 2048});
+  F->createSave("output", createFC(F, cur, 1000, "fc1000", PRNG));
+}
+
+/// Builds BERT-base encoder layers, of sequence length 128, into \p F.
+void buildBERT(Function *F, PseudoRNG &PRNG) {
+  Module &mod = *F->getParent();
+  const dim_t seq = 128, hidden = 768, heads = 12, headDim = hidden / heads;
+  const dim_t rows = batchSize * seq;
+  NodeValue cur = mod.createPlaceholder(ElemKind::FloatTy, {rows, hidden},
+                                        "input", false);
+  auto *selected = mod.createPlaceholder(
+      ElemKind::Int64ITy, {batchSize * heads * seq, 1}, "selected", false);
+  // \returns \p x of {rows, hidden} as {batch * heads, seq, headDim}.
+  auto splitHeads = [&](NodeValue x, const std::string &name) {
+    x = F->createReshape(name + ".reshape", x,
+                         {batchSize, seq, heads, headDim});
+    x = F->createTranspose(name + ".transpose", x, {0, 2, 1, 3});
+    return F->createReshape(name + ".heads", x,
+                            {batchSize * heads, seq, headDim});
+  };
+  auto layerNorm = [&](NodeValue x, const std::string &name) {
+    auto *scale = createRandomConstant(mod, {hidden}, name + ".scale", PRNG);
+    auto *bias = createRandomConstant(mod, {hidden}, name + ".bias", PRNG);
+    return F->createLayerNormalization(name, x.getType(), x, scale, bias);
+  };
+  for (unsigned l = 0; l < bertLayers; l++) {
+    std::string name = strFormat("layer%u", l);
+    NodeValue q = splitHeads(createFC(F, cur, hidden, name + ".q", PRNG),
+                             name + ".q");
+    NodeValue k = splitHeads(createFC(F, cur, hidden, name + ".k", PRNG),
+                             name + ".k");
+    NodeValue v = splitHeads(createFC(F, cur, hidden, name + ".v", PRNG),
+                             name + ".v");
+    NodeValue kT = F->createTranspose(name + ".kT", k, {0, 2, 1});
+    NodeValue scores = F->createBatchMatMul(name + ".scores", q, kT);
+    scores = F->createReshape(name + ".scores2d", scores,
+                              {batchSize * heads * seq, seq});
+    NodeValue probs = F->createSoftMax(name + ".softmax", scores, selected);
+    probs = F->createReshape(name + ".probs", probs,
+                             {batchSize * heads, seq, seq});
+    NodeValue ctx = F->createBatchMatMul(name + ".context", probs, v);
+    ctx = F->createReshape(name + ".context4d", ctx,
+                           {batchSize, heads, seq, headDim});
+    ctx = F->createTranspose(name + ".merge", ctx, {0, 2, 1, 3});
+    ctx = F->createReshape(name + ".context2d", ctx, {rows, hidden});
+    NodeValue attn = createFC(F, ctx, hidden, name + ".attnOut", PRNG);
+    cur = layerNorm(F->createAdd(name + ".attnAdd", attn, cur), name + ".ln1");
+    NodeValue ff = createFC(F, cur, 4 * hidden, name + ".ff1", PRNG);
+    ff = createFC(F, F->createGelu(name + ".gelu", ff), hidden,
+                  name + ".ff2", PRNG);
+    cur = layerNorm(F->createAdd(name + ".ffAdd", ff, cur), name + ".ln2");
+  }
+  F->createSave("output", cur);
+}
+
+/// Builds a DLRM-like recommendation model into \p F, with the default
+/// configuration of RecommendationSystemTest: float embedding tables of 64
+/// columns summed with SparseLengthsSum, a dense input of 800 features and
+/// bottom and top MLPs of three 1024 wide layers.
+void buildDLRM(Function *F, PseudoRNG &PRNG) {
+  Module &mod = *F->getParent();
+  const dim_t embDim = 64, denseDim = 800, mlpDim = 1024, lengthAvg = 100;
+  const dim_t tableSizes[] = {8000, 6000, 7000, 9000, 12000};
+  NodeValue dense = mod.createPlaceholder(
+      ElemKind::FloatTy, {batchSize, denseDim}, "dense", false);
+  for (unsigned i = 0; i < 3; i++) {
+    dense = F->createRELU(
+        strFormat("bottom%u.relu", i),
+        createFC(F, dense, mlpDim, strFormat("bottom%u", i), PRNG));
+  }
+  std::vector<NodeValue> features = {
+      createFC(F, dense, embDim, "bottomOut", PRNG)};
+  for (unsigned t = 0; t < dlrmTables; t++) {
+    auto *data = createRandomConstant(mod, {tableSizes[t % 5], embDim},
+                                      strFormat("table%u", t), PRNG);
+    auto *indices =
+        mod.createPlaceholder(ElemKind::Int64ITy, {batchSize * lengthAvg},
+                              strFormat("indices%u", t), false);
+    auto *lengths = mod.createPlaceholder(ElemKind::Int32ITy, {batchSize},
+                                          strFormat("lengths%u", t), false);
+    features.push_back(F->createSparseLengthsSum(strFormat("sls%u", t), data,
+                                                 indices, lengths));
+  }
+  NodeValue top = F->createConcat("interaction", features, 1);
+  for (unsigned i = 0; i < 3; i++) {
+    top = F->createRELU(strFormat("top%u.relu", i),
+                        createFC(F, top, mlpDim, strFormat("top%u", i), PRNG));
+  }
+  top = F->createSigmoid("prediction",
+                         createFC(F, top, 1, "topOut", PRNG));
+  F->createSave("output", top);
+}
+
+/// Builds, or imports, the model \p name into \p F.
+void importModel(llvm::StringRef name, Function *F) {
+  PseudoRNG PRNG;
+  if (name == "onnx") {
+    Error err = Error::empty();
+    ONNXModelLoader loader(modelPath, {}, {}, *F, &err);
+    EXIT_ON_ERR(std::move(err));
+  } else if (name == "resnet50") {
+    buildResNet50(F, PRNG);
+  } else if (name == "bert") {
+    buildBERT(F, PRNG);
+  } else if (name == "dlrm") {
+    buildDLRM(F, PRNG);
+  } else {
+    LOG(FATAL) << "Unknown model: " << name.str();
+  }
+}
+
+/// Runs \p fn, recording its time and memory usage in \p stats.
+template <typename Fn> void timePhase(PhaseStats &stats, Fn fn) {
+  uint64_t rssBefore = getMaxRSSKB();
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  auto end = std::chrono::steady_clock::now();
+  stats.seconds.push_back(std::chrono::duration<double>(end - start).count());
+  stats.maxRSSKB = getMaxRSSKB();
+  stats.maxRSSGrowthKB =
+      std::max(stats.maxRSSGrowthKB, stats.maxRSSKB - rssBefore);
+}
+
+/// Compiles the model \p name once on \p device, phase by phase, recording
+/// the measurements of every phase in \p stats.
+void compileModel(llvm::StringRef name, runtime::DeviceManager &device,
+                  std::vector<PhaseStats> &stats) {
+  std::unique_ptr<Backend> B(createBackend(backend));
+  auto *glowIRBackend = dynamic_cast<BackendUsingGlowIR *>(B.get());
+  CHECK(glowIRBackend) << "Backend " << backend.getValue()
+                       << " does not compile Glow IR";
+  CompilationContext cctx;
+  cctx.verboseCompile = false;
+  Module mod;
+  Function *F = mod.createFunction("network");
+  DAGListTy dags;
+  std::vector<Function *> partitions;
+  std::vector<std::unique_ptr<IRFunction>> IRs;
+  std::vector<std::unique_ptr<CompiledFunction>> compiled;
+
+  timePhase(stats[0], [&]() { importModel(name, F); });
+  timePhase(stats[1], [&]() {
+    EXIT_ON_ERR(::glow::optimizeFunctionBeforeLowering(F, cctx));
+  });
+  timePhase(stats[2], [&]() { ::glow::lower(F, cctx, B.get()); });
+  timePhase(stats[3],
+            [&]() { EXIT_ON_ERR(::glow::optimizeFunction(F, *B, cctx)); });
+  timePhase(stats[4], [&]() {
+    Partitioner partitioner(&mod, {device.getDeviceInfo()},
+                            /* optimized */ true);
+    ASSIGN_VALUE_OR_FATAL(dags, partitioner.partition(cctx));
+  });
+  for (const auto &dag : dags) {
+    for (const auto &node : dag.nodes) {
+      partitions.push_back(mod.getFunction(node->name));
+    }
+  }
+  timePhase(stats[5], [&]() {
+    for (Function *P : partitions) {
+      IRs.push_back(glow::make_unique<IRFunction>(P));
+      IRs.back()->generateIR(*B);
+    }
+  });
+  timePhase(stats[6], [&]() {
+    for (auto &IR : IRs) {
+      ::glow::optimize(*IR, *B, B->shouldShareBuffers());
+    }
+  });
+  timePhase(stats[7], [&]() {
+    for (auto &IR : IRs) {
+      compiled.push_back(glowIRBackend->compileIR(std::move(IR)));
+    }
+  });
+
+  runtime::FunctionMapTy functions;
+  for (size_t i = 0, e = partitions.size(); i < e; i++) {
+    functions.emplace(partitions[i]->getName().str(), compiled[i].get());
+  }
+  timePhase(stats[8], [&]() {
+    std::promise<void> ready;
+    Error addErr = Error::empty();
+    device.addNetwork(&mod, functions, [&](const Module *, Error err) {
+      addErr = std::move(err);
+      ready.set_value();
+    });
+    ready.get_future().wait();
+    EXIT_ON_ERR(std::move(addErr));
+  });
+  for (const auto &function : functions) {
+    std::promise<void> evicted;
+    device.evictNetwork(function.first, [&](std::string, Error err) {
+      EXIT_ON_ERR(std::move(err));
+      evicted.set_value();
+    });
+    evicted.get_future().wait();
+  }
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  llvm::cl::ParseCommandLineOptions(argc, argv, "Compilation time benchmark",
+                                    nullptr, "GLOW_OPTS");
+
+  std::vector<std::string> names(models.begin(), models.end());
+  if (!modelPath.empty()) {
+    names = {"onnx"};
+  } else if (names.empty()) {
+    names = {"resnet50", "bert", "dlrm"};
+  }
+
+  std::unique_ptr<runtime::DeviceManager> device(
+      runtime::DeviceManager::createDeviceManager(
+          runtime::DeviceConfig(backend)));
+  EXIT_ON_ERR(device->init());
+
+  printf("model,phase,medianMs,maxRSSMB,maxRSSGrowthMB\n");
+  for (const auto &name : names) {
+    std::vector<PhaseStats> stats(kNumPhases);
+    for (unsigned r = 0; r < reps; r++) {
+      compileModel(name, *device, stats);
+    }
+    double totalMs = 0;
+    for (size_t p = 0; p < kNumPhases; p++) {
+      BenchStats phaseStats = computeBenchStats(stats[p].seconds);
+      totalMs += phaseStats.median * 1e3;
+      printf("%s,%s,%.3f,%.1f,%.1f\n", name.c_str(), kPhases[p],
+             phaseStats.median * 1e3, stats[p].maxRSSKB / 1024.0,
+             stats[p].maxRSSGrowthKB / 1024.0);
+      reportBench("CompileBench",
+                  {{"model", name == "onnx" ? modelPath.getValue() : name},
+                   {"phase", kPhases[p]},
+                   {"backend", backend.getValue()},
+                   {"batchSize", std::to_string(batchSize)},
+                   {"maxRSSKB", std::to_string(stats[p].maxRSSKB)},
+                   {"maxRSSGrowthKB", std::to_string(stats[p].maxRSSGrowthKB)}},
+                  stats[p].seconds, 1, 0, 0);
+    }
+    printf("%s,total,%.3f,,\n", name.c_str(), totalMs);
+  }
+  EXIT_ON_ERR(device->stop());
+  return 0;
+}
@@ -298,4 +298,13 @@ int main(int argc, char *argv[]) {
          static_cast<unsigned>(param.numAsyncLaunches_),
          param.backendStr_.c_str(), argv[8], medianRuntime, minRuntime,
          b.gbytes() / medianRuntime, b.gbytes() / minRuntime);
+  reportBench("ConcatBench",
+              {{"m", std::to_string(param.m_)},
+               {"n", std::to_string(param.n_)},
+               {"numTensors", std::to_string(param.numTensors_)},
+               {"numLayers", std::to_string(param.numLayers_)},
+               {"numAsyncLaunches", std::to_string(param.numAsyncLaunches_)},
+               {"backendStr", param.backendStr_},
+               {"dtypeStr", argv[8]}},
+              times, param.numAsyncLaunches_, 0, b.gbytes());
 }
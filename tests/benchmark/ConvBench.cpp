@@ -27,9 +27,24 @@ extern void libjit_conv2d_f(float *outW, const float *inW, const float *filterW,
                             const size_t *inWdims, const size_t *filterWdims,
                             const size_t *biasWdims, const size_t *kernelSizes,
                             const size_t *strides, const size_t *pads,
-                            size_t group, unsigned depthUnroll);
+                            size_t group, unsigned depthUnroll,
+                            const size_t *dilation, int32_t actType,
+                            const float *actArgs);
+extern void libjit_conv_winograd_f(float *outW, const float *inW,
+                                   const float *filterW, const float *biasW,
+                                   const size_t *outWdims,
+                                   const size_t *inWdims, const size_t *pads);
+extern void libjit_conv_im2col_f(float *outW, const float *inW,
+                                 const float *filterW, const float *biasW,
+                                 const size_t *outWdims, const size_t *inWdims,
+                                 const size_t *kernelSizes,
+                                 const size_t *strides, const size_t *pads,
+                                 const size_t *dilation);
 }
 
+/// Convolution kernels the CPU backend chooses from.
+enum class ConvAlgo { Direct, Winograd, Im2Col };
+
 /// Benchmark a convolution with specified parameters on square inputs.
 class ConvBench : public Benchmark {
   /// Matrices
@@ -42,23 +57,28 @@ class ConvBench : public Benchmark {
   // [batch, h, w, channels]
   size_t outWdims[4];
   size_t inWdims[4];
-  // [outputChannels, h, w, inputChannels]
+  // [outputChannels, h, w, inputChannels], or [36, inputChannels,
+  // outputChannels] for Winograd. The im2col kernel uses the transposed
+  // [h * w * inputChannels, outputChannels] filter, of the same size.
   size_t filterWdims[4];
 
   /// Parameters
   size_t kernelSizes[2];
   size_t strides[2];
-  size_t pads[2];
+  size_t pads[4];
+  size_t dilation[2];
   size_t group;
   unsigned depthUnroll;
+  /// Kernel to run.
+  ConvAlgo algo;
 
 public:
   ConvBench(size_t inputBatch, size_t inputEdgeSize, size_t inputChannels,
             size_t filterMultiplier, size_t kernelSize, size_t stride,
-            size_t pad, size_t group)
-      : kernelSizes{kernelSize, kernelSize}, strides{stride, stride}, pads{pad,
-                                                                           pad},
-        group(group) {
+            size_t pad, size_t group, ConvAlgo algo)
+      : kernelSizes{kernelSize, kernelSize}, strides{stride, stride},
+        pads{pad, pad, pad, pad}, dilation{1, 1}, group(group),
+        algo(algo) {
 
     inWdims[0] = inputBatch;
     inWdims[1] = inputEdgeSize;
@@ -83,7 +103,10 @@ public:
   virtual void setup() override {
     size_t outSize = mapMult(outWdims, 4);
     size_t inSize = mapMult(inWdims, 4);
-    size_t filterSize = mapMult(filterWdims, 4);
+    // The transformed Winograd filter has 36 values per channel pair.
+    size_t filterSize = algo == ConvAlgo::Winograd
+                            ? 36 * filterWdims[0] * filterWdims[3]
+                            : mapMult(filterWdims, 4);
     size_t biasSize = filterWdims[0];
 
     outW.resize(outSize);
@@ -97,16 +120,34 @@ public:
   }
 
   virtual void run() override {
+    if (algo == ConvAlgo::Winograd) {
+      libjit_conv_winograd_f(outW.data(), inW.data(), filterW.data(),
+                             biasW.data(), outWdims, inWdims, pads);
+      return;
+    }
+    if (algo == ConvAlgo::Im2Col) {
+      libjit_conv_im2col_f(outW.data(), inW.data(), filterW.data(),
+                           biasW.data(), outWdims, inWdims, kernelSizes,
+                           strides, pads, dilation);
+      return;
+    }
     // biasWDims isn't used in libjit_conv2d_f, so we're passing NULL.
     libjit_conv2d_f(outW.data(), inW.data(), filterW.data(), biasW.data(),
                     outWdims, inWdims, filterWdims, NULL, kernelSizes, strides,
-                    pads, group, depthUnroll);
+                    pads, group, depthUnroll, dilation, /* actType */ 0,
+                    NULL);
   }
 
   virtual void teardown() override {}
 
+  /// A multiply and an add per MAC of the convolution.
+  double gflops() const {
+    return 2.0 * mapMult(outWdims, 4) * kernelSizes[0] *
+           kernelSizes[1] * filterWdims[3] / 1e9;
+  }
+
 private:
-  size_t mapMult(size_t *vec, int size) {
+  size_t mapMult(const size_t *vec, int size) const {
     size_t result = 1;
     for (int i = 0; i < size; i++) {
       result *= vec[i];
@@ -123,10 +164,11 @@ private:
   }
 };
 
-int main() {
+int main(int argc, char *argv[]) {
+  benchParseGlowOpts(argc, argv);
   constexpr int reps = 10;
   printf("inputBatch, inputEdgeSize, inputChannels, filterMultiplier, "
-         "kernelSize, stride, pad, group, bestInSeconds\n");
+         "kernelSize, stride, pad, group, algo, bestInSeconds\n");
 
   for (size_t inputBatch : {1, 3}) {
     for (size_t inputEdgeSize : {7, 56, 224}) {
@@ -140,14 +182,37 @@ int main() {
               for (size_t group : {1, 112}) {
                 if (inputChannels % group != 0)
                   continue;
-                ConvBench b(inputBatch, inputEdgeSize, inputChannels,
-                            filterMultiplier, kernelSize, stride, pad, group);
-                auto times = bench(&b, reps);
-                double time = *(std::min_element(times.begin(), times.end()));
-                printf("%zu, %zu, %zu, %zu, %zu, %zu, %zu, %zu, %f\n",
-                       inputBatch, inputEdgeSize, inputChannels,
-                       filterMultiplier, kernelSize, stride, pad, group, time);
-              } // group
+                for (ConvAlgo algo : {ConvAlgo::Direct, ConvAlgo::Winograd,
+                                      ConvAlgo::Im2Col}) {
+                  if (algo != ConvAlgo::Direct && group != 1)
+                    continue;
+                  if (algo == ConvAlgo::Winograd &&
+                      (kernelSize != 3 || stride != 1))
+                    continue;
+                  ConvBench b(inputBatch, inputEdgeSize, inputChannels,
+                              filterMultiplier, kernelSize, stride, pad, group,
+                              algo);
+                  auto times = bench(&b, reps);
+                  double time =
+                      *(std::min_element(times.begin(), times.end()));
+                  printf("%zu, %zu, %zu, %zu, %zu, %zu, %zu, %zu, %d, %f\n",
+                         inputBatch, inputEdgeSize, inputChannels,
+                         filterMultiplier, kernelSize, stride, pad, group,
+                         int(algo), time);
+                  reportBench("ConvBench",
+                              {{"inputBatch", std::to_string(inputBatch)},
+                               {"inputEdgeSize", std::to_string(inputEdgeSize)},
+                               {"inputChannels", std::to_string(inputChannels)},
+                               {"filterMultiplier",
+                                std::to_string(filterMultiplier)},
+                               {"kernelSize", std::to_string(kernelSize)},
+                               {"stride", std::to_string(stride)},
+                               {"pad", std::to_string(pad)},
+                               {"group", std::to_string(group)},
+                               {"algo", std::to_string(int(algo))}},
+                              times, 1, b.gflops(), 0);
+                } // algo
+              }   // group
             }   // stride
           }     // kernelSize
         }       // filterMultiplier
@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <future>
+
+#include "Bench.h"
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+
+#include "tests/unittests/BackendTestUtils.h"
+
+using namespace glow;
+
+/*
+ * This class implements a microbenchmark of the TFLiteDetectionPostProcess
+ * node, the box decoding and non-max suppression at the end of SSD-style
+ * detectors. The defaults are the ones of SSD MobileNet: 1917 anchors, 90
+ * classes plus the background one and 10 detections.
+ *
+ * Microbenchmarks are generally useful for understanding performance
+ * through targeted experiementation and are not representative of
+ * end-to-end workloads.
+ */
+
+namespace {
+llvm::cl::OptionCategory
+    DetectionPostProcessBenchCat("DetectionPostProcessBench Category");
+llvm::cl::opt<unsigned>
+    numBoxesOpt("boxes", llvm::cl::desc("Number of anchor boxes"),
+                llvm::cl::init(1917),
+                llvm::cl::cat(DetectionPostProcessBenchCat));
+llvm::cl::opt<unsigned>
+    numClassesOpt("classes",
+                  llvm::cl::desc("Number of classes, without the background"),
+                  llvm::cl::init(90),
+                  llvm::cl::cat(DetectionPostProcessBenchCat));
+llvm::cl::opt<unsigned>
+    maxDetectionsOpt("max-detections",
+                     llvm::cl::desc("Maximum number of detections"),
+                     llvm::cl::init(10),
+                     llvm::cl::cat(DetectionPostProcessBenchCat));
+llvm::cl::opt<float>
+    scoreThresholdOpt("score-threshold",
+                      llvm::cl::desc("Minimum score of the detections"),
+                      llvm::cl::init(0.3f),
+                      llvm::cl::cat(DetectionPostProcessBenchCat));
+llvm::cl::opt<unsigned> numRepsOpt("reps", llvm::cl::desc("Number of runs"),
+                                   llvm::cl::init(100),
+                                   llvm::cl::cat(DetectionPostProcessBenchCat));
+llvm::cl::opt<std::string>
+    backendOpt("backend", llvm::cl::desc("Backend to use"),
+               llvm::cl::init("CPU"),
+               llvm::cl::cat(DetectionPostProcessBenchCat));
+} // namespace
+
+struct DetectionPostProcessParam {
+  dim_t numBoxes_;
+  dim_t numClasses_;
+  dim_t maxDetections_;
+  float scoreThreshold_;
+  bool regularNMS_;
+};
+
+class DetectionPostProcessBench : public Benchmark {
+  DetectionPostProcessParam param_;
+  ExecutionContext context_;
+  PlaceholderBindings &bindings_;
+  std::unique_ptr<runtime::HostManager> hostManager_;
+
+public:
+  explicit DetectionPostProcessBench(DetectionPostProcessParam param)
+      : param_(param), bindings_(*context_.getPlaceholderBindings()) {}
+
+  void setup() override {
+    std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+    configs.push_back(
+        glow::make_unique<runtime::DeviceConfig>(backendOpt.c_str()));
+    hostManager_ = glow::make_unique<runtime::HostManager>(std::move(configs));
+
+    std::unique_ptr<Module> mod(new Module);
+    auto *fn = mod->createFunction("singleNode");
+    dim_t B = param_.numBoxes_;
+    dim_t C = param_.numClasses_ + 1;
+    auto *boxes =
+        mod->createPlaceholder(ElemKind::FloatTy, {1, B, 4}, "boxes", false);
+    bindings_.allocate(boxes)->getHandle<float>().randomize(-1.f, 1.f,
+                                                            mod->getPRNG());
+    auto *scores =
+        mod->createPlaceholder(ElemKind::FloatTy, {1, B, C}, "scores", false);
+    bindings_.allocate(scores)->getHandle<float>().randomize(0.f, 1.f,
+                                                             mod->getPRNG());
+
+    // Anchors of random centers and sizes in the unit square, as
+    // [ycenter, xcenter, h, w], so that many boxes overlap.
+    auto *anchors = mod->createConstant(ElemKind::FloatTy, {B, 4}, "anchors");
+    auto AH = anchors->getPayloadMutable().getHandle<float>();
+    for (dim_t b = 0; b < B; b++) {
+      AH.at({b, 0}) = mod->getPRNG().nextRandReal(0.f, 1.f);
+      AH.at({b, 1}) = mod->getPRNG().nextRandReal(0.f, 1.f);
+      AH.at({b, 2}) = mod->getPRNG().nextRandReal(0.05f, 0.5f);
+      AH.at({b, 3}) = mod->getPRNG().nextRandReal(0.05f, 0.5f);
+    }
+
+    auto *DPP = fn->createTFLiteDetectionPostProcess(
+        "detection", boxes, scores, anchors, param_.numClasses_,
+        param_.maxDetections_, /* maxClassesPerDetection */ 1,
+        /* maxDetectionsPerClass */ 100, /* iouThreshold */ 0.6f,
+        param_.scoreThreshold_, /* xScale */ 10.f, /* yScale */ 10.f,
+        /* hScale */ 5.f, /* wScale */ 5.f, param_.regularNMS_);
+    for (unsigned i = 0, e = DPP->getNumResults(); i < e; i++) {
+      auto *save =
+          fn->createSave("save" + std::to_string(i), DPP->getNthResult(i));
+      bindings_.allocate(save->getPlaceholder());
+    }
+
+    CompilationContext ctx;
+    EXIT_ON_ERR(hostManager_->addNetwork(std::move(mod), ctx));
+  }
+
+  void run() override {
+    dispatchInference("singleNode", hostManager_.get(), context_,
+                      /* numInferences */ 1,
+                      /* useNewExecutionContext */ true);
+  }
+
+  void teardown() override {}
+};
+
+int main(int argc, char *argv[]) {
+  printf("TFLiteDetectionPostProcess Microbenchmark\n");
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "DetectionPostProcessBench\n");
+
+  std::string runHeader =
+      "_,benchName,_,boxes,classes,maxDetections,scoreThreshold,nms,"
+      "backendStr";
+  for (bool regularNMS : {false, true}) {
+    DetectionPostProcessParam param{numBoxesOpt, numClassesOpt,
+                                    maxDetectionsOpt, scoreThresholdOpt,
+                                    regularNMS};
+    auto b = glow::make_unique<DetectionPostProcessBench>(param);
+    auto times = bench(b.get(), numRepsOpt);
+    std::string runPrefix =
+        strFormat("DetectionPostProcessBench,SW,%u,%u,%u,%f,%s,%s",
+                  unsigned(numBoxesOpt), unsigned(numClassesOpt),
+                  unsigned(maxDetectionsOpt), float(scoreThresholdOpt),
+                  regularNMS ? "regular" : "fast", backendOpt.c_str());
+    double min = *(std::min_element(times.begin(), times.end()));
+    dim_t midElt = times.size() / 2;
+    std::nth_element(times.begin(), times.begin() + midElt, times.end());
+    double median = times[midElt];
+    printf("%s,medianRuntime,minRuntime\n", runHeader.c_str());
+    printf("BenchSummary,%s,%f,%f\n", runPrefix.c_str(), median, min);
+    reportBench("DetectionPostProcessBench",
+                getBenchParams(runHeader, runPrefix), times, 1, 0, 0);
+  }
+}
@@ -279,6 +279,9 @@ int main(int argc, char *argv[]) {
          "sortedStr(\"Sorted\"|\"Unsorted\") backendStr(String) "
          "dtypeStr(\"Float16\"|\"Float32\") "
          "dev_id(Int)\n");
+  printf("Standard Glow command-line options may be passed via the GLOW_OPTS "
+         "environment variable\n");
+  benchParseGlowOpts(argc, argv);
   printf("\n");
 
   std::vector<GatherParam> params;
@@ -316,7 +319,7 @@ int main(int argc, char *argv[]) {
     params.push_back(param);
 
     runHeader =
-        std::string("_,benchName,_numIndices,"
+        std::string("_,benchName,_,numIndices,"
                     "numTableEntries,"
                     "numElementsPerRow,numReps,numAsyncLaunches,numGatherNodes,"
                     "sorted,backendStr,dtypeStr");
@@ -352,4 +355,6 @@ int main(int argc, char *argv[]) {
   printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
          minRuntime, b.inputgbytes() / medianRuntime,
          b.inputgbytes() / minRuntime);
+  reportBench("GatherBench", getBenchParams(runHeader, runPrefix), times,
+              param.numAsyncLaunches, 0, b.inputgbytes());
 }
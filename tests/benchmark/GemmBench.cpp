@@ -347,5 +347,7 @@ int main(int argc, char *argv[]) {
            runHeader.c_str());
     printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
            minRuntime, b.gflops() / medianRuntime, b.gflops() / minRuntime);
+    reportBench("GemmBench", getBenchParams(runHeader, runPrefix), times,
+                param.numAsyncLaunches_, b.gflops(), 0);
   }
 }
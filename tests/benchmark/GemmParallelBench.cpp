@@ -189,4 +189,13 @@ int main(int argc, char *argv[]) {
       m, n, numLayers, reps, asyncLaunches, numCores, backendStr, dtypeStr,
       median_runtime, min_runtime, b.gflops() / median_runtime,
       b.gflops() / min_runtime);
+      reportBench("GemmParallelBench",
+                  {{"m", std::to_string(m)},
+                   {"n", std::to_string(n)},
+                   {"numLayers", std::to_string(numLayers)},
+                   {"numAsyncLaunches", std::to_string(asyncLaunches)},
+                   {"numCores", std::to_string(numCores)},
+                   {"backendStr", backendStr},
+                   {"dtypeStr", dtypeStr}},
+                  times, asyncLaunches, b.gflops(), 0);
 }
@@ -313,6 +313,13 @@ int main(int argc, char *argv[]) {
            "2.6lf,%2.6lf,%5.2lf,%5.2lf\n",
            numLayers, reps, asyncLaunches, numCores, backendStr, median_runtime,
            min_runtime, gflops / median_runtime, gflops / min_runtime);
+    reportBench("Int8Conv3dParallelBench",
+                {{"shape", shape_info},
+                 {"numLayers", std::to_string(numLayers)},
+                 {"numAsyncLaunches", std::to_string(asyncLaunches)},
+                 {"numCores", std::to_string(numCores)},
+                 {"backendStr", backendStr}},
+                times, asyncLaunches, gflops, 0);
     shape_idx++;
   }
 }
@@ -352,5 +352,7 @@ int main(int argc, char *argv[]) {
            runHeader.c_str());
     printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
            minRuntime, b.gops() / medianRuntime, b.gops() / minRuntime);
+    reportBench("Int8GemmBench", getBenchParams(runHeader, runPrefix), times,
+                param.numAsyncLaunches_, b.gops(), 0);
   }
 }
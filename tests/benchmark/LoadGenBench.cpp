@@ -0,0 +1,373 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "Bench.h"
+
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Graph/Graph.h"
+#include "glow/Importer/ONNXModelLoader.h"
+#include "glow/Runtime/HostManager/HostManager.h"
+#include "glow/Support/Error.h"
+#include "glow/Support/Random.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+
+using namespace glow;
+
+/// Serving load generator for the HostManager. Requests are sent to a single
+/// network with runNetwork(), either at target rates of Poisson arrivals
+/// (open loop) or keeping a fixed number of requests in flight (closed loop),
+/// and the throughput, latency percentiles and queue times of every rate are
+/// reported, giving the latency/throughput curve of the runtime.
+
+namespace {
+llvm::cl::OptionCategory category("LoadGenBench Options");
+
+llvm::cl::opt<std::string> backend("backend", llvm::cl::desc("Backend to use"),
+                                   llvm::cl::Optional, llvm::cl::init("CPU"),
+                                   llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> numDevices("numDevices",
+                                   llvm::cl::desc("Number of devices to use"),
+                                   llvm::cl::init(1), llvm::cl::value_desc("N"),
+                                   llvm::cl::cat(category));
+
+llvm::cl::opt<std::string> modelPath(
+    "model",
+    llvm::cl::desc("ONNX model to serve, with inputs of static shapes. A "
+                   "chain of FullyConnected layers is served by default"),
+    llvm::cl::init(""), llvm::cl::value_desc("model.onnx"),
+    llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned>
+    fcSize("fcSize",
+           llvm::cl::desc("Width of the layers of the default network"),
+           llvm::cl::init(256), llvm::cl::value_desc("N"),
+           llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned>
+    numLayers("numLayers",
+              llvm::cl::desc("Number of layers of the default network"),
+              llvm::cl::init(4), llvm::cl::value_desc("N"),
+              llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned>
+    batchSize("batchSize", llvm::cl::desc("Batch size of the default network"),
+              llvm::cl::init(16), llvm::cl::value_desc("N"),
+              llvm::cl::cat(category));
+
+llvm::cl::opt<std::string> qpsList(
+    "qps",
+    llvm::cl::desc("Comma separated target rates in requests per second, one "
+                   "load level each. Ignored with -closedLoop"),
+    llvm::cl::init("100,200,400,800,1600"), llvm::cl::cat(category));
+
+llvm::cl::opt<bool> closedLoop(
+    "closedLoop",
+    llvm::cl::desc("Keep -concurrency requests in flight, sending a new one "
+                   "as soon as one completes, instead of Poisson arrivals"),
+    llvm::cl::init(false), llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> concurrency(
+    "concurrency",
+    llvm::cl::desc("Maximum number of requests in flight. Open loop arrivals "
+                   "beyond it are dropped and counted"),
+    llvm::cl::init(64), llvm::cl::value_desc("N"), llvm::cl::cat(category));
+
+llvm::cl::opt<double>
+    duration("duration", llvm::cl::desc("Seconds of load per level"),
+             llvm::cl::init(5), llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> seed("seed",
+                             llvm::cl::desc("Seed of the arrival process"),
+                             llvm::cl::init(0), llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> maxActiveRequests(
+    "maxActiveRequests",
+    llvm::cl::desc("Number of requests the HostManager runs concurrently"),
+    llvm::cl::init(runtime::HostConfig().maxActiveRequests),
+    llvm::cl::value_desc("N"), llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> maxQueueSize(
+    "maxQueueSize",
+    llvm::cl::desc("Number of requests the HostManager queues"),
+    llvm::cl::init(runtime::HostConfig().maxQueueSize),
+    llvm::cl::value_desc("N"), llvm::cl::cat(category));
+
+llvm::cl::opt<unsigned> executorThreads(
+    "executorThreads", llvm::cl::desc("Number of threads of the Executor"),
+    llvm::cl::init(runtime::HostConfig().executorThreads),
+    llvm::cl::value_desc("N"), llvm::cl::cat(category));
+
+using Clock = std::chrono::steady_clock;
+
+/// Name of the served network.
+constexpr const char *kNetworkName = "loadgen";
+
+/// Prefix of the trace events the Executor logs when it starts running a
+/// partition of a request, which end the request's queue time.
+constexpr const char *kExecuteEventPrefix =
+    "ThreadPoolExecutor::executeDAGNode";
+
+/// Build the served network into \p mod.
+void buildNetwork(Module &mod) {
+  Function *F = mod.createFunction(kNetworkName);
+  if (!modelPath.empty()) {
+    Error err = Error::empty();
+    ONNXModelLoader loader(modelPath, {}, {}, *F, &err);
+    EXIT_ON_ERR(std::move(err));
+    return;
+  }
+  PseudoRNG PRNG;
+  NodeValue cur = mod.createPlaceholder(ElemKind::FloatTy, {batchSize, fcSize},
+                                        "input", false);
+  for (unsigned i = 0; i < numLayers; i++) {
+    auto *W = mod.createConstant(ElemKind::FloatTy, {fcSize, fcSize},
+                                 strFormat("W%u", i));
+    auto *B = mod.createConstant(ElemKind::FloatTy, {fcSize},
+                                 strFormat("B%u", i));
+    W->getPayloadMutable().getHandle().randomize(-1, 1, PRNG);
+    B->getPayloadMutable().getHandle().randomize(-1, 1, PRNG);
+    auto *FC = F->createFullyConnected(strFormat("fc%u", i), cur, W, B);
+    cur = F->createRELU(strFormat("relu%u", i), FC);
+  }
+  F->createSave("output", cur);
+}
+
+/// Results of a load level.
+struct LevelResult {
+  /// End to end latencies in seconds, from the scheduled arrival of the
+  /// requests, so that a late generator does not hide queueing.
+  std::vector<double> latencies;
+  /// Times in seconds between the submission of the requests and the start
+  /// of their first partition.
+  std::vector<double> queueTimes;
+  size_t dropped{0};
+  size_t errors{0};
+  double elapsed{0};
+};
+
+/// Drives the network with requests from a pool of ExecutionContexts, one
+/// per request in flight.
+class LoadGenerator {
+  runtime::HostManager &hostManager_;
+  std::vector<std::unique_ptr<ExecutionContext>> pool_;
+  std::mutex lock_;
+  std::condition_variable done_;
+  size_t inFlight_{0};
+  LevelResult result_;
+
+public:
+  LoadGenerator(runtime::HostManager &hostManager, Module &mod, size_t size)
+      : hostManager_(hostManager) {
+    PseudoRNG PRNG;
+    for (size_t i = 0; i < size; i++) {
+      auto context = glow::make_unique<ExecutionContext>();
+      context->getPlaceholderBindings()->allocate(mod.getPlaceholders());
+      for (auto &p : context->getPlaceholderBindings()->pairs()) {
+        if (p.second.getElementType() == ElemKind::FloatTy) {
+          p.second.getHandle().randomize(-1, 1, PRNG);
+        }
+      }
+      pool_.push_back(std::move(context));
+    }
+  }
+
+  /// Send a request scheduled to arrive at \p arrival, counting it as dropped
+  /// if all the contexts are in flight. With \p resubmitUntil in the future,
+  /// a new request is sent as soon as this one completes.
+  void submit(Clock::time_point arrival,
+              Clock::time_point resubmitUntil = Clock::time_point()) {
+    std::unique_ptr<ExecutionContext> context;
+    {
+      std::lock_guard<std::mutex> g(lock_);
+      if (pool_.empty()) {
+        result_.dropped++;
+        return;
+      }
+      context = std::move(pool_.back());
+      pool_.pop_back();
+      inFlight_++;
+    }
+    context->setTraceContext(
+        glow::make_unique<TraceContext>(TraceLevel::RUNTIME));
+    uint64_t submitTime = TraceEvent::now();
+    hostManager_.runNetwork(
+        kNetworkName, std::move(context),
+        [this, arrival, resubmitUntil,
+         submitTime](runtime::RunIdentifierTy, Error err,
+                     std::unique_ptr<ExecutionContext> context) {
+          auto now = Clock::now();
+          uint64_t startTime = 0;
+          auto &events = context->getTraceContext()->getTraceEvents();
+          for (const auto &event : events) {
+            if (llvm::StringRef(event.name).startswith(kExecuteEventPrefix) &&
+                (!startTime || event.timestamp < startTime)) {
+              startTime = event.timestamp;
+            }
+          }
+          bool failed = ERR_TO_BOOL(std::move(err), /* log */ false);
+          {
+            std::lock_guard<std::mutex> g(lock_);
+            if (failed) {
+              result_.errors++;
+            } else {
+              result_.latencies.push_back(
+                  std::chrono::duration<double>(now - arrival).count());
+              if (startTime > submitTime) {
+                result_.queueTimes.push_back((startTime - submitTime) / 1e6);
+              }
+            }
+            pool_.push_back(std::move(context));
+            inFlight_--;
+          }
+          if (now < resubmitUntil) {
+            submit(now, resubmitUntil);
+          }
+          done_.notify_all();
+        });
+  }
+
+  /// Send requests at \p qps requests per second of Poisson arrivals for
+  /// \p seconds, or keep the whole pool in flight if \p qps is 0. \returns
+  /// the results once all the requests completed.
+  LevelResult run(double qps, double seconds) {
+    {
+      std::lock_guard<std::mutex> g(lock_);
+      result_ = LevelResult();
+    }
+    auto start = Clock::now();
+    auto end = start + std::chrono::duration_cast<Clock::duration>(
+                           std::chrono::duration<double>(seconds));
+    if (qps > 0) {
+      std::mt19937_64 gen(seed);
+      std::exponential_distribution<double> interArrival(qps);
+      auto arrival = start;
+      while (true) {
+        arrival += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(interArrival(gen)));
+        if (arrival >= end) {
+          break;
+        }
+        std::this_thread::sleep_until(arrival);
+        submit(arrival);
+      }
+    } else {
+      size_t size;
+      {
+        std::lock_guard<std::mutex> g(lock_);
+        size = pool_.size();
+      }
+      for (size_t i = 0; i < size; i++) {
+        submit(start, end);
+      }
+    }
+    std::this_thread::sleep_until(end);
+    std::unique_lock<std::mutex> g(lock_);
+    done_.wait(g, [&]() { return inFlight_ == 0; });
+    result_.elapsed =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    return std::move(result_);
+  }
+};
+} // namespace
+
+int main(int argc, char *argv[]) {
+  llvm::cl::ParseCommandLineOptions(argc, argv, "Serving load benchmark",
+                                    nullptr, "GLOW_OPTS");
+
+  std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+  for (unsigned i = 0; i < numDevices; ++i) {
+    auto config = glow::make_unique<runtime::DeviceConfig>(backend);
+    config->deviceID = i;
+    configs.push_back(std::move(config));
+  }
+  runtime::HostConfig hostConfig;
+  hostConfig.maxActiveRequests = maxActiveRequests;
+  hostConfig.maxQueueSize = maxQueueSize;
+  hostConfig.executorThreads = executorThreads;
+  runtime::HostManager hostManager(std::move(configs), hostConfig);
+
+  auto mod = glow::make_unique<Module>();
+  buildNetwork(*mod);
+  Module *modPtr = mod.get();
+  CompilationContext cctx;
+  EXIT_ON_ERR(hostManager.addNetwork(std::move(mod), cctx));
+
+  LoadGenerator generator(hostManager, *modPtr, concurrency);
+  // Warm up the caches and the lazily started threads.
+  generator.run(0, 0.1);
+
+  std::vector<double> rates;
+  if (closedLoop) {
+    rates.push_back(0);
+  } else {
+    llvm::SmallVector<llvm::StringRef, 8> items;
+    llvm::StringRef(qpsList).split(items, ',', -1, false);
+    for (llvm::StringRef item : items) {
+      double qps;
+      CHECK(!item.trim().getAsDouble(qps) && qps > 0)
+          << "Invalid -qps rate: " << item.str();
+      rates.push_back(qps);
+    }
+  }
+
+  printf("mode,targetQps,achievedQps,completed,dropped,errors,p50Us,p90Us,"
+         "p99Us,p999Us,maxUs,queueP50Us,queueP99Us\n");
+  for (double qps : rates) {
+    LevelResult result = generator.run(qps, duration);
+    std::vector<double> sorted = result.latencies;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double q) {
+      return sorted.empty()
+                 ? 0
+                 : sorted[std::min<size_t>(q * sorted.size(),
+                                           sorted.size() - 1)] *
+                       1e6;
+    };
+    BenchStats queueStats = computeBenchStats(result.queueTimes);
+    double achievedQps = result.latencies.size() / result.elapsed;
+    printf("%s,%.1f,%.1f,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+           closedLoop ? "closed" : "open", qps, achievedQps,
+           result.latencies.size(), result.dropped, result.errors,
+           percentile(0.5), percentile(0.9), percentile(0.99),
+           percentile(0.999), sorted.empty() ? 0 : sorted.back() * 1e6,
+           queueStats.median * 1e6, queueStats.p99 * 1e6);
+    reportBench("LoadGenBench",
+                {{"mode", closedLoop ? "closed" : "open"},
+                 {"targetQps", strFormat("%.1f", qps)},
+                 {"achievedQps", strFormat("%.1f", achievedQps)},
+                 {"concurrency", std::to_string(concurrency)},
+                 {"dropped", std::to_string(result.dropped)},
+                 {"errors", std::to_string(result.errors)},
+                 {"queueP50Us", strFormat("%.1f", queueStats.median * 1e6)},
+                 {"queueP99Us", strFormat("%.1f", queueStats.p99 * 1e6)},
+                 {"backend", backend.getValue()},
+                 {"model", modelPath.empty() ? "fc" : modelPath.getValue()}},
+                result.latencies, 1, 0, 0);
+  }
+  return 0;
+}
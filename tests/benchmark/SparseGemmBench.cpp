@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+#include "Bench.h"
+
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Flags/Flags.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+
+#include "tests/unittests/BackendTestUtils.h"
+
+using namespace glow;
+
+/*
+ * This class implements a block-sparse FC microbenchmark. There are a set of
+ * (m x k) * (k x n) = (m x n) FullyConnected layers, chained together, whose
+ * constant weights are made of 1x8 blocks of 8 consecutive output columns, a
+ * given percentage of which are zero. Each sparsity level is run with the
+ * dense kernel and with the block-sparse kernel of the CPU backend, which is
+ * selected by -glow_cpu_sparse_fc_min_zero_blocks_percent.
+ *
+ * Microbenchmarks are generally useful for understanding performance
+ * through targeted experiementation and are not representative of
+ * end-to-end workloads.
+ */
+
+namespace {
+llvm::cl::OptionCategory SparseGemmBenchCat("SparseGemmBench Category");
+llvm::cl::opt<unsigned> mOpt("m", llvm::cl::desc("Rows of the input"),
+                             llvm::cl::init(16),
+                             llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<unsigned> nOpt("n", llvm::cl::desc("Outputs of the layers"),
+                             llvm::cl::init(1024),
+                             llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<unsigned> kOpt("k", llvm::cl::desc("Inputs of the first layer"),
+                             llvm::cl::init(1024),
+                             llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<unsigned> numLayersOpt("layers",
+                                     llvm::cl::desc("Number of FC layers"),
+                                     llvm::cl::init(4),
+                                     llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<unsigned> numRepsOpt("reps", llvm::cl::desc("Number of runs"),
+                                   llvm::cl::init(50),
+                                   llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<std::string> backendOpt("backend",
+                                      llvm::cl::desc("Backend to use"),
+                                      llvm::cl::init("CPU"),
+                                      llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::list<unsigned> sparsityOpt(
+    "sparsity",
+    llvm::cl::desc("Comma separated list of the percentages of zero blocks "
+                   "of the weights, 50,70,80,90,95 by default"),
+    llvm::cl::CommaSeparated, llvm::cl::ZeroOrMore,
+    llvm::cl::cat(SparseGemmBenchCat));
+llvm::cl::opt<bool> checkCorrectness(
+    "check-results",
+    llvm::cl::desc("Check the correctness of the block-sparse results against "
+                   "the dense ones"),
+    llvm::cl::Optional, llvm::cl::init(false),
+    llvm::cl::cat(SparseGemmBenchCat));
+} // namespace
+
+struct SparseGemmParam {
+  dim_t m_;
+  dim_t n_;
+  dim_t k_;
+  dim_t numLayers_;
+  unsigned sparsity_;
+  bool sparseKernel_;
+};
+
+class SparseGemmBench : public Benchmark {
+  SparseGemmParam param_;
+  ExecutionContext context_;
+  PlaceholderBindings &bindings_;
+  std::unique_ptr<runtime::HostManager> hostManager_;
+
+public:
+  explicit SparseGemmBench(SparseGemmParam param)
+      : param_(param), bindings_(*context_.getPlaceholderBindings()) {}
+
+  /// Zero \p sparsity percent of the 1x8 blocks of the {K, N} \p weights,
+  /// picked at random.
+  static void sparsify(Tensor *weights, unsigned sparsity, PseudoRNG &PRNG) {
+    auto WH = weights->getHandle<float>();
+    dim_t K = WH.dims()[0];
+    dim_t N = WH.dims()[1];
+    for (dim_t k = 0; k < K; k++) {
+      for (dim_t b = 0; b < N; b += 8) {
+        if (unsigned(PRNG.nextRandInt(0, 99)) >= sparsity) {
+          continue;
+        }
+        for (dim_t j = b; j < std::min(N, b + 8); j++) {
+          WH.at({k, j}) = 0;
+        }
+      }
+    }
+  }
+
+  void setup() override {
+    std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+    configs.push_back(
+        glow::make_unique<runtime::DeviceConfig>(backendOpt.c_str()));
+    hostManager_ = glow::make_unique<runtime::HostManager>(std::move(configs));
+
+    std::unique_ptr<Module> mod(new Module);
+    auto *fn = mod->createFunction("singleNode");
+    auto *input = mod->createPlaceholder(
+        ElemKind::FloatTy, {param_.m_, param_.k_}, "input", false);
+    bindings_.allocate(input)->getHandle<float>().randomize(-1.f, 1.f,
+                                                            mod->getPRNG());
+    auto *output = mod->createPlaceholder(
+        ElemKind::FloatTy, {param_.m_, param_.n_}, "output", false);
+    bindings_.allocate(output);
+
+    // The same seed gives the same weights to the dense and sparse runs.
+    PseudoRNG PRNG;
+    NodeValue cur = input;
+    for (dim_t layer = 0; layer < param_.numLayers_; layer++) {
+      dim_t inputs = layer ? param_.n_ : param_.k_;
+      auto *weights =
+          mod->createPlaceholder(ElemKind::FloatTy, {inputs, param_.n_},
+                                 "weights" + std::to_string(layer), false);
+      auto *bias =
+          mod->createPlaceholder(ElemKind::FloatTy, {param_.n_},
+                                 "bias" + std::to_string(layer), false);
+      // Keep the outputs of the layers of the same magnitude as the input.
+      float range = 1.f / std::sqrt(float(inputs));
+      Tensor *W = bindings_.allocate(weights);
+      W->getHandle<float>().randomize(-range, range, PRNG);
+      sparsify(W, param_.sparsity_, PRNG);
+      bindings_.allocate(bias)->getHandle<float>().randomize(-1.f, 1.f, PRNG);
+      cur = fn->createFullyConnected("fc_" + std::to_string(layer), cur,
+                                     weights, bias);
+    }
+    fn->createSave("save", cur, output);
+    ::glow::convertPlaceholdersToConstants(fn, bindings_, {input, output});
+
+    unsigned &minZeroPercent =
+        glow::runtime::flags::CPUSparseFCMinZeroBlocksPercent;
+    unsigned oldPercent = minZeroPercent;
+    minZeroPercent = param_.sparseKernel_ ? 1 : 0;
+    CompilationContext ctx;
+    EXIT_ON_ERR(hostManager_->addNetwork(std::move(mod), ctx));
+    minZeroPercent = oldPercent;
+  }
+
+  void run() override {
+    dispatchInference("singleNode", hostManager_.get(), context_,
+                      /* numInferences */ 1,
+                      /* useNewExecutionContext */ true);
+  }
+
+  void teardown() override {}
+
+  Tensor *getOutput() {
+    return bindings_.get(bindings_.getPlaceholderByNameSlow("output"));
+  }
+
+  /// \returns the GFLOP of a dense run, so that the throughput of the sparse
+  /// runs is the one of the equivalent dense computation.
+  double gflops() const {
+    dim_t firstLayer = param_.m_ * param_.n_ * param_.k_;
+    dim_t otherLayers =
+        param_.m_ * param_.n_ * param_.n_ * (param_.numLayers_ - 1);
+    return 2.0 * (firstLayer + otherLayers) / 1e9;
+  }
+};
+
+int main(int argc, char *argv[]) {
+  printf("Block-sparse GEMM Microbenchmark\n");
+  llvm::cl::ParseCommandLineOptions(argc, argv, "SparseGemmBench\n");
+
+  std::vector<unsigned> sparsities(sparsityOpt.begin(), sparsityOpt.end());
+  if (sparsities.empty()) {
+    sparsities = {50, 70, 80, 90, 95};
+  }
+
+  std::string runHeader =
+      "_,benchName,_,m,n,k,numLayers,sparsity,kernel,backendStr";
+  for (unsigned sparsity : sparsities) {
+    if (sparsity > 100) {
+      LOG(FATAL) << "Invalid sparsity " << sparsity;
+    }
+    std::unique_ptr<SparseGemmBench> dense;
+    for (bool sparseKernel : {false, true}) {
+      SparseGemmParam param{mOpt,     nOpt,        kOpt, numLayersOpt,
+                            sparsity, sparseKernel};
+      auto b = glow::make_unique<SparseGemmBench>(param);
+      auto times = bench(b.get(), numRepsOpt);
+      std::string runPrefix = strFormat(
+          "SparseGemmBench,SW,%u,%u,%u,%u,%u,%s,%s", unsigned(mOpt),
+          unsigned(nOpt), unsigned(kOpt), unsigned(numLayersOpt), sparsity,
+          sparseKernel ? "sparse" : "dense", backendOpt.c_str());
+      double min = *(std::min_element(times.begin(), times.end()));
+      dim_t midElt = times.size() / 2;
+      std::nth_element(times.begin(), times.begin() + midElt, times.end());
+      double median = times[midElt];
+      printf("%s,medianRuntime,minRuntime,medianGflopPerSec,maxGflopPerSec\n",
+             runHeader.c_str());
+      printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), median, min,
+             b->gflops() / median, b->gflops() / min);
+      reportBench("SparseGemmBench", getBenchParams(runHeader, runPrefix),
+                  times, 1, b->gflops(), 0);
+
+      if (!checkCorrectness) {
+        continue;
+      }
+      if (!sparseKernel) {
+        dense = std::move(b);
+      } else if (!b->getOutput()->isEqual(*dense->getOutput(), 1e-3)) {
+        LOG(FATAL) << "Tensors don't match at sparsity " << sparsity;
+      } else {
+        LOG(INFO) << "Tensors match at sparsity " << sparsity;
+      }
+    }
+  }
+}
@@ -505,7 +505,7 @@ int main(int argc, char *argv[]) {
         (size_t)param.numIndicesPerBatchPad_, (size_t)param.numTableEntries_,
         (size_t)param.numTables_, (size_t)param.numElementsPerRow_,
         (size_t)param.numReps_, (size_t)param.numAsyncLaunches_,
-        (size_t)param.numTBENodes_, argv[9], argv[10], argv[11], argv[12]));
+        (size_t)param.numTBENodes_, argv[10], argv[12], argv[13], argv[14]));
 
     TBEBench b(param);
 
@@ -527,5 +527,7 @@ int main(int argc, char *argv[]) {
            runHeader.c_str());
     printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
            minRuntime, b.gbytes() / medianRuntime, b.gbytes() / minRuntime);
+    reportBench("TBEBench", getBenchParams(runHeader, runPrefix), times,
+                param.numAsyncLaunches_, 0, b.gbytes());
   }
 }
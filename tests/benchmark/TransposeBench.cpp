@@ -307,4 +307,6 @@ int main(int argc, char *argv[]) {
          runHeader.c_str());
   printf("BenchSummary,%s,%f,%f,%f,%f\n", runPrefix.c_str(), medianRuntime,
          minRuntime, b.gbytes() / medianRuntime, b.gbytes() / minRuntime);
+  reportBench("TransposeBench", getBenchParams(runHeader, runPrefix), times,
+              param.numAsyncLaunches_, 0, b.gbytes());
 }
@@ -27,6 +27,7 @@
 #include "gtest/gtest.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace glow;
 using llvm::cast;
@@ -264,6 +265,62 @@ TEST_P(BackendCorrectnessTest, dataParallelStackingTest) {
   EXPECT_EQ(H.at(1), 4);
 }
 
+TEST_P(BackendCorrectnessTest, dataParallelHoistingTest) {
+  CHECK_IF_ENABLED();
+  // Interleave data-parallel instructions with a transpose. The backend may
+  // move the data-parallel instructions that do not depend on the transpose
+  // into the stacked kernel that precedes it, and stack in-place instructions
+  // of the same buffer, but it must not move an instruction writing a buffer
+  // that the transpose reads.
+  Module mod;
+  Function *F = mod.createFunction("DataParallelHoisting");
+  auto M = glow::make_unique<IRFunction>(F);
+
+  auto *var =
+      mod.createPlaceholder(glow::ElemKind::FloatTy, {2, 2}, "output", false);
+  auto ctx = glow::make_unique<ExecutionContext>();
+  auto *outputTensor = ctx->getPlaceholderBindings()->allocate(var);
+  {
+    IRBuilder bb(M.get());
+
+    auto *output = bb.createWeightVar(glow::ElemKind::FloatTy, {2, 2},
+                                      "output1",
+                                      WeightVar::MutabilityKind::Mutable);
+
+    M->getVariableMap()[var] = output;
+
+    auto *ty = mod.uniqueType(glow::ElemKind::FloatTy, {2, 2});
+    auto *act1 = bb.createAllocActivationInst("act1", ty);
+    auto *act2 = bb.createAllocActivationInst("act2", ty);
+    auto *act3 = bb.createAllocActivationInst("act3", ty);
+    bb.createSplatInst("one", act1, 1.0);
+    // act2 will be: 1
+    bb.createTransposeInst("transpose", act2, act1, {1, 0});
+    // These two instructions do not depend on the transpose and can be
+    // stacked with the first splat.
+    // act3 will be: 4
+    bb.createSplatInst("three", act3, 3.0);
+    bb.createElementAddInst("add1", act3, act3, act1);
+    // This instruction writes the input of the transpose and has to stay
+    // after it.
+    // act1 will be: 5
+    bb.createElementAddInst("add2", act1, act1, act3);
+    // output will be: 6
+    bb.createElementAddInst("add3", output, act2, act1);
+    bb.createDeallocActivationInst("dealloc3", act3);
+    bb.createDeallocActivationInst("dealloc2", act2);
+    bb.createDeallocActivationInst("dealloc1", act1);
+  }
+
+  MockCPUBackend backend;
+  auto function = backend.compileIR(std::move(M));
+  ASSERT_FALSE(ERR_TO_BOOL(function->execute(ctx.get())));
+  auto H = outputTensor->getHandle();
+  for (dim_t i = 0; i < H.size(); i++) {
+    EXPECT_EQ(H.raw(i), 6);
+  }
+}
+
 TEST_P(BackendCorrectnessTest, AvgPoolGradTest) {
   CHECK_IF_ENABLED();
   PseudoRNG PRNG;
@@ -434,6 +491,146 @@ TEST_P(BackendCorrectnessTest, convDKKC8Test) {
   EXPECT_TRUE(out1.isEqual(out2, 0.00013));
 }
 
+/// Check that the CPU kernels splitting their work across intra-op threads
+/// match the Interpreter.
+TEST_P(BackendCorrectnessTest, intraOpParallelMatMul) {
+  CHECK_IF_ENABLED();
+  if (backendName_ != "CPU") {
+    GTEST_SKIP();
+  }
+  PseudoRNG PRNG;
+  Tensor lhs(ElemKind::FloatTy, {37, 300});
+  Tensor rhs(ElemKind::FloatTy, {300, 131});
+  lhs.getHandle().randomize(-1.0, 1.0, PRNG);
+  rhs.getHandle().randomize(-1.0, 1.0, PRNG);
+
+  auto infer = [&](llvm::StringRef backendName, unsigned numThreads) {
+    ExecutionEngine EE(backendName);
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    auto *lhsPH =
+        mod.createPlaceholder(ElemKind::FloatTy, lhs.dims(), "lhs", false);
+    auto *rhsPH =
+        mod.createPlaceholder(ElemKind::FloatTy, rhs.dims(), "rhs", false);
+    auto *save = F->createSave("save", F->createMatMul("matmul", lhsPH, rhsPH));
+
+    CompilationContext cctx;
+    if (numThreads) {
+      cctx.backendOpts.backendSpecificOpts["CPUIntraOpThreads"] =
+          std::to_string(numThreads);
+    }
+    EE.compile(cctx);
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    updateInputPlaceholders(bindings, {lhsPH, rhsPH}, {&lhs, &rhs});
+    EE.run(bindings);
+    return bindings.get(save->getPlaceholder())->clone();
+  };
+
+  Tensor expected = infer("Interpreter", 0);
+  for (unsigned numThreads : {1, 3, 8}) {
+    Tensor out = infer(backendName_, numThreads);
+    EXPECT_TRUE(out.isEqual(expected, 0.001)) << numThreads << " threads";
+  }
+}
+
+/// Check that the stacked data parallel kernels of a tensor large enough to be
+/// split into several tasks across intra-op threads match the Interpreter.
+TEST_P(BackendCorrectnessTest, intraOpParallelDataParallelChain) {
+  CHECK_IF_ENABLED();
+  if (backendName_ != "CPU") {
+    GTEST_SKIP();
+  }
+  PseudoRNG PRNG;
+  Tensor lhs(ElemKind::FloatTy, {3, 100003});
+  Tensor rhs(ElemKind::FloatTy, {3, 100003});
+  lhs.getHandle().randomize(-1.0, 1.0, PRNG);
+  rhs.getHandle().randomize(-1.0, 1.0, PRNG);
+
+  auto infer = [&](llvm::StringRef backendName, unsigned numThreads) {
+    ExecutionEngine EE(backendName);
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    auto *lhsPH =
+        mod.createPlaceholder(ElemKind::FloatTy, lhs.dims(), "lhs", false);
+    auto *rhsPH =
+        mod.createPlaceholder(ElemKind::FloatTy, rhs.dims(), "rhs", false);
+    auto *add = F->createAdd("add", lhsPH, rhsPH);
+    auto *mul = F->createMul("mul", add, lhsPH);
+    auto *max = F->createMax("max", mul, rhsPH);
+    auto *save = F->createSave("save", F->createTanh("tanh", max));
+
+    CompilationContext cctx;
+    if (numThreads) {
+      cctx.backendOpts.backendSpecificOpts["CPUIntraOpThreads"] =
+          std::to_string(numThreads);
+    }
+    EE.compile(cctx);
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    updateInputPlaceholders(bindings, {lhsPH, rhsPH}, {&lhs, &rhs});
+    EE.run(bindings);
+    return bindings.get(save->getPlaceholder())->clone();
+  };
+
+  Tensor expected = infer("Interpreter", 0);
+  for (unsigned numThreads : {1, 3, 8}) {
+    Tensor out = infer(backendName_, numThreads);
+    EXPECT_TRUE(out.isEqual(expected, 0.001)) << numThreads << " threads";
+  }
+}
+
+/// Check that compiling the LLVM module in parts on several threads gives the
+/// same results as compiling it as a whole.
+TEST_P(BackendCorrectnessTest, parallelLLVMCodeGen) {
+  CHECK_IF_ENABLED();
+  if (backendName_ != "CPU") {
+    GTEST_SKIP();
+  }
+  auto &llvmOpts = llvm::cl::getRegisteredOptions();
+  auto *threadsOpt = static_cast<llvm::cl::opt<unsigned> *>(
+      llvmOpts.lookup("llvm-codegen-threads"));
+  ASSERT_TRUE(threadsOpt);
+  const unsigned oldThreads = *threadsOpt;
+
+  PseudoRNG PRNG;
+  Tensor input(ElemKind::FloatTy, {4, 32});
+  Tensor weights(ElemKind::FloatTy, {32, 16});
+  Tensor bias(ElemKind::FloatTy, {16});
+  input.getHandle().randomize(-1.0, 1.0, PRNG);
+  weights.getHandle().randomize(-1.0, 1.0, PRNG);
+  bias.getHandle().randomize(-1.0, 1.0, PRNG);
+
+  auto infer = [&](llvm::StringRef backendName) {
+    ExecutionEngine EE(backendName);
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    auto *inputPH =
+        mod.createPlaceholder(ElemKind::FloatTy, input.dims(), "input", false);
+    auto *FC = F->createFullyConnected(
+        "fc", inputPH, mod.createConstant("weights", weights.clone()),
+        mod.createConstant("bias", bias.clone()));
+    auto *tanh = F->createTanh("tanh", FC);
+    auto *save = F->createSave("save", F->createTranspose("tr", tanh, {1, 0}));
+    EE.compile(CompilationMode::Infer);
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    updateInputPlaceholders(bindings, {inputPH}, {&input});
+    EE.run(bindings);
+    return bindings.get(save->getPlaceholder())->clone();
+  };
+
+  *threadsOpt = 1;
+  Tensor expected = infer(backendName_);
+  *threadsOpt = 4;
+  Tensor out = infer(backendName_);
+  *threadsOpt = oldThreads;
+  EXPECT_TRUE(out.isEqual(expected));
+}
+
 TEST_P(BackendCorrectnessTest, softmaxGradTest) {
   CHECK_IF_ENABLED();
   PseudoRNG PRNG;
@@ -591,4 +788,45 @@ TEST_P(BackendCorrectnessTest, AsymmetricQuantizedConvReluFusionTest) {
                               FusedActivation::NONE);
 }
 
+/// Profile two inputs of a size which is not a multiple of the vector width
+/// on \p backendName, the second one widening the range so that the
+/// histogram gets rescaled. \returns the histogram in \p histogram and the
+/// min and max in \p compInfo.
+static void profileInputs(llvm::StringRef backendName, Tensor &inputs1,
+                          Tensor &inputs2, Tensor &histogram,
+                          Tensor &compInfo) {
+  ExecutionEngine EE(backendName);
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  PlaceholderBindings bindings;
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, inputs1.dims(), "input", false);
+  auto *QP = F->createQuantizationProfile(bindings, "qp", input);
+  bindings.allocate(input);
+
+  EE.compile(CompilationMode::Infer);
+  for (Tensor *inputs : {&inputs1, &inputs2}) {
+    updateInputPlaceholders(bindings, {input}, {inputs});
+    EE.run(bindings);
+  }
+  histogram.assign(bindings.get(QP->getHistogramPlaceholder()));
+  compInfo.assign(bindings.get(QP->getComputationInfoPlaceholder()));
+}
+
+TEST_P(BackendCorrectnessTest, quantizationProfileTest) {
+  CHECK_IF_ENABLED();
+  PseudoRNG PRNG;
+  Tensor inputs1(ElemKind::FloatTy, {3, 37});
+  Tensor inputs2(ElemKind::FloatTy, {3, 37});
+  inputs1.getHandle().randomize(-1, 1, PRNG);
+  inputs2.getHandle().randomize(-3, 2, PRNG);
+
+  Tensor histogram1, compInfo1, histogram2, compInfo2;
+  profileInputs(backendName_, inputs1, inputs2, histogram1, compInfo1);
+  profileInputs("Interpreter", inputs1, inputs2, histogram2, compInfo2);
+
+  EXPECT_TRUE(compInfo1.isEqual(compInfo2, 0));
+  EXPECT_TRUE(histogram1.isEqual(histogram2, 0));
+}
+
 INSTANTIATE_BACKEND_TEST(BackendCorrectnessTest);
@@ -24,6 +24,7 @@
 #include "glow/IR/IRBuilder.h"
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
 #include "glow/Optimizer/IROptimizer/IROptimizer.h"
+#include "glow/Support/Memory.h"
 
 #include "gtest/gtest.h"
 
@@ -32,6 +33,7 @@
 #include "llvm/Support/FileSystem.h"
 
 #include <future>
+#include <thread>
 
 using namespace glow;
 
@@ -995,6 +997,75 @@ TEST_P(BackendExecTest, CompileWithoutConstants) {
   auto function = EXIT_ON_ERR(backend->compile(F, opts));
 }
 
+/// Test that a function runs correctly on bindings that were bound to a
+/// caller provided buffer via RuntimeBundle::bindIOBuffer().
+TEST_P(BackendExecTest, BoundIOBuffer) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *X = mod.createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  auto *pow = F->createPow("Pow1", X, 2.0);
+  auto *save = F->createSave("save", pow);
+  std::unique_ptr<Backend> backend(createBackend(GetParam()));
+  auto function = EXIT_ON_ERR(backend->compile(F, BackendOptions()));
+
+  auto &bundle = function->getRuntimeBundle();
+  auto *ioBuffer = static_cast<uint8_t *>(
+      alignedAlloc(bundle.getMutableWeightSize(), TensorAlignment));
+  ExecutionContext context;
+  auto *bindings = context.getPlaceholderBindings();
+  bundle.bindIOBuffer(mod, *bindings, ioBuffer);
+  ASSERT_TRUE(bindings->get(X));
+  ASSERT_TRUE(bindings->get(save->getPlaceholder()));
+  bindings->get(X)->getHandle() = {1., 2., 3.};
+
+  // Run twice to make sure the buffer can be reused.
+  for (unsigned i = 0; i < 2; i++) {
+    FAIL_TEST_IF_ERR(function->execute(&context));
+    auto H = bindings->get(save->getPlaceholder())->getHandle();
+    EXPECT_NEAR(H.at({0}), 1, 1E-5);
+    EXPECT_NEAR(H.at({1}), 4, 1E-5);
+    EXPECT_NEAR(H.at({2}), 9, 1E-5);
+  }
+  bindings->clear();
+  alignedFree(ioBuffer);
+}
+
+/// Test that concurrent and repeated runs of one compiled function, which may
+/// reuse each other's run buffers, each see only their own inputs.
+TEST_P(BackendExecTest, RepeatedConcurrentRuns) {
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *X = mod.createPlaceholder(ElemKind::FloatTy, {64}, "X", false);
+  auto *pow = F->createPow("Pow1", X, 2.0);
+  auto *add = F->createAdd("add", pow, X);
+  auto *save = F->createSave("save", add);
+  std::unique_ptr<Backend> backend(createBackend(GetParam()));
+  auto function = EXIT_ON_ERR(backend->compile(F, BackendOptions()));
+
+  constexpr unsigned numThreads = 4;
+  constexpr unsigned numRuns = 8;
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (unsigned i = 0; i < numRuns; i++) {
+        ExecutionContext context;
+        auto *bindings = context.getPlaceholderBindings();
+        bindings->allocate(X)->getHandle().clear(float(t * numRuns + i));
+        bindings->allocate(save->getPlaceholder());
+        EXIT_ON_ERR(function->execute(&context));
+        float x = t * numRuns + i;
+        auto H = bindings->get(save->getPlaceholder())->getHandle();
+        for (dim_t j = 0; j < H.size(); j++) {
+          EXPECT_NEAR(H.raw(j), x * x + x, 1E-3);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
 /// Test that the runtimeBundle includes only symbols from its function and not
 /// the whole module.
 TEST_P(BackendExecTest, BundleFunctionSymbolsOnly) {
@@ -1233,6 +1304,47 @@ TEST(PlaceholderBindings, basicPlaceholderBindingsTest) {
   EXPECT_EQ(nullptr, C.getFirstUnallocated(mod.getPlaceholders()));
 }
 
+/// Test that the Tensors of the bindings stay in place as Placeholders are
+/// added and removed, and as the bindings are moved.
+TEST(PlaceholderBindings, stableTensorsTest) {
+  Module mod;
+  TypeRef ty = mod.uniqueType(ElemKind::FloatTy, {4});
+  std::vector<Placeholder *> PHs;
+  for (unsigned i = 0; i < 64; i++) {
+    PHs.push_back(mod.createPlaceholder(ty, "ph" + std::to_string(i), false));
+  }
+
+  PlaceholderBindings C;
+  Tensor *first = C.allocate(PHs[0]);
+  auto firstIt = C.pairs().find(PHs[0]);
+  for (unsigned i = 1; i < PHs.size(); i++) {
+    C.allocate(PHs[i])->getHandle().clear(i);
+  }
+  EXPECT_EQ(first, C.get(PHs[0]));
+  EXPECT_EQ(&firstIt->second, first);
+
+  // Erased entries are skipped and reused.
+  C.erase(PHs[1]);
+  C.erase(PHs[2]);
+  EXPECT_EQ(C.pairs().size(), PHs.size() - 2);
+  EXPECT_EQ(C.get(PHs[1]), nullptr);
+  EXPECT_EQ(size_t(std::distance(C.pairs().begin(), C.pairs().end())),
+            PHs.size() - 2);
+  C.allocate(PHs[1])->getHandle().clear(1);
+  EXPECT_EQ(C.pairs().size(), PHs.size() - 1);
+
+  PlaceholderBindings moved(std::move(C));
+  EXPECT_EQ(first, moved.get(PHs[0]));
+  EXPECT_EQ(firstIt->first, PHs[0]);
+  for (unsigned i = 1; i < PHs.size(); i++) {
+    if (i == 2) {
+      EXPECT_EQ(moved.get(PHs[i]), nullptr);
+      continue;
+    }
+    EXPECT_EQ(moved.get(PHs[i])->getHandle().raw(0), i);
+  }
+}
+
 /// Check if the dump function works for Type.
 TEST(BackendExecTest, dumpType) {
   Module mod;
@@ -20,6 +20,8 @@
 #include "glow/Graph/Node.h"
 #include "glow/Graph/Nodes.h"
 #include "glow/Graph/Utils.h"
+#include "glow/LLVMIRCodeGen/CommandLine.h"
+#include "glow/LLVMIRCodeGen/WeightsCompression.h"
 
 #include "gtest/gtest.h"
 
@@ -74,3 +76,80 @@ TEST(BundleSaver, testSaveMultipleFunctions) {
   bundleEntries.emplace_back(BundleEntry{"testMainEntry2", F2});
   backend->saveFunctions(bundleEntries, outputDir, bundleName);
 }
+
+/// Test that the first convolutions of a bundle are split in patches and that
+/// the bundle is saved in the memory minimization mode.
+TEST(BundleSaver, testPatchLayers) {
+  Module M;
+  Function *F = M.createFunction("F");
+  auto *input =
+      M.createPlaceholder(ElemKind::FloatTy, {1, 32, 32, 3}, "input", false);
+  auto *filter1 = M.createConstant(ElemKind::FloatTy, {8, 3, 3, 3}, "filter1");
+  auto *filter2 = M.createConstant(ElemKind::FloatTy, {8, 3, 3, 8}, "filter2");
+  auto *bias = M.createConstant(ElemKind::FloatTy, {8}, "bias");
+  filter1->getPayloadMutable().zero();
+  filter2->getPayloadMutable().zero();
+  bias->getPayloadMutable().zero();
+  auto outTy = M.uniqueType(ElemKind::FloatTy, {1, 32, 32, 8});
+  auto *conv1 =
+      F->createConv("conv1", input, filter1, bias, outTy, 3, 1, 1, 1);
+  auto *relu1 = F->createRELU("relu1", conv1);
+  auto *conv2 =
+      F->createConv("conv2", relu1, filter2, bias, outTy, 3, 1, 1, 1);
+  auto *relu2 = F->createRELU("relu2", conv2);
+  F->createSave("output", relu2);
+
+  bundleMinMemory = true;
+  bundlePatchLayers = 2;
+  bundlePatchCount = 4;
+  std::unique_ptr<Backend> backend(createBackend("CPU"));
+  backend->save(F, ".", "testBundle", "testMainEntry");
+  bundleMinMemory = false;
+  bundlePatchLayers = 0;
+
+  unsigned numConvs = 0;
+  for (auto &N : F->getNodes()) {
+    numConvs += llvm::isa<ConvolutionNode>(&N);
+  }
+  EXPECT_EQ(numConvs, 8u);
+}
+
+/// Test that sparse and low entropy weights are compressed, and that the
+/// blocks of the compressed weights cover the whole data.
+TEST(BundleSaver, testCompressWeights) {
+  std::vector<uint8_t> data(3 * kWeightsBlockSize + 100, 0);
+  // The first block is zero, the second one sparse and the others only hold
+  // a few distinct values.
+  for (size_t i = kWeightsBlockSize; i < data.size(); i++) {
+    if (i < 2 * kWeightsBlockSize) {
+      data[i] = (i % 13 == 0) ? uint8_t(i) : 0;
+    } else {
+      data[i] = uint8_t((i * 7) % 5);
+    }
+  }
+  std::vector<uint8_t> compressed = compressWeights(data);
+  ASSERT_GE(compressed.size(), kWeightsHeaderSize);
+  EXPECT_LT(compressed.size(), data.size() / 2);
+  auto readU32 = [&](size_t pos) {
+    return uint32_t(compressed[pos]) | (uint32_t(compressed[pos + 1]) << 8) |
+           (uint32_t(compressed[pos + 2]) << 16) |
+           (uint32_t(compressed[pos + 3]) << 24);
+  };
+  EXPECT_EQ(readU32(0), kWeightsMagic);
+  EXPECT_EQ(readU32(4), kWeightsVersion);
+  EXPECT_EQ(readU32(8), data.size());
+
+  std::vector<WeightsBlockMethod> methods;
+  size_t decodedSize = 0;
+  for (size_t pos = kWeightsHeaderSize; pos < compressed.size();) {
+    ASSERT_LE(pos + kWeightsBlockHeaderSize, compressed.size());
+    methods.push_back(WeightsBlockMethod(compressed[pos]));
+    decodedSize += readU32(pos + 4);
+    pos += kWeightsBlockHeaderSize + readU32(pos + 8);
+  }
+  EXPECT_EQ(decodedSize, data.size());
+  ASSERT_EQ(methods.size(), 4u);
+  EXPECT_EQ(methods[0], WeightsBlockMethod::Zero);
+  EXPECT_EQ(methods[1], WeightsBlockMethod::Bitmask);
+  EXPECT_EQ(methods[2], WeightsBlockMethod::Huffman);
+}
@@ -19,6 +19,10 @@
 #include "glow/Importer/Caffe2ModelLoader.h"
 #include "gtest/gtest.h"
 
+#include "llvm/Support/FileSystem.h"
+
+#include <fstream>
+
 #ifndef GLOW_DATA_PATH
 #define GLOW_DATA_PATH
 #endif
@@ -1159,6 +1163,63 @@ TEST_F(Caffe2ImporterTest, FC) {
   // already covered in the Operator.FC/* tests.
 }
 
+/// Test loading the weights of the FC test from a binary init net, which is
+/// parsed a few ops at a time.
+TEST_F(Caffe2ImporterTest, FCBinaryInitNet) {
+  ExecutionEngine EE{};
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  std::string NetDescFilename(GLOW_DATA_PATH
+                              "tests/models/caffe2Models/fc_predict_net.pbtxt");
+
+  // Same weights as fc_init_net.pbtxt, after a field which is not an op.
+  caffe2::NetDef initNet;
+  initNet.set_name("fc_init");
+  auto addFill = [&](const std::string &name, std::vector<int64_t> shape,
+                     std::vector<float> values) {
+    auto *op = initNet.add_op();
+    op->set_type("GivenTensorFill");
+    op->add_output(name);
+    auto *shapeArg = op->add_arg();
+    shapeArg->set_name("shape");
+    for (auto dim : shape) {
+      shapeArg->add_ints(dim);
+    }
+    auto *valuesArg = op->add_arg();
+    valuesArg->set_name("values");
+    for (auto value : values) {
+      valuesArg->add_floats(value);
+    }
+  };
+  addFill("weights", {4, 3}, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  addFill("bias", {4}, {0.1f, 0.2f, 0.3f, 0.4f});
+
+  llvm::SmallString<64> NetWeightFilename;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("fc_init_net", "pb",
+                                                  NetWeightFilename));
+  {
+    std::ofstream out(NetWeightFilename.c_str(), std::ios::binary);
+    ASSERT_TRUE(initNet.SerializeToOstream(&out));
+  }
+
+  {
+    Tensor inputs(ElemKind::FloatTy, {2, 3});
+    Caffe2ModelLoader caffe2LD(NetDescFilename, NetWeightFilename.str().str(),
+                               {"inputs"}, {&inputs.getType()}, *F);
+  }
+  llvm::sys::fs::remove(NetWeightFilename);
+
+  const Constant *weights = mod.getConstantByName("weights");
+  ASSERT_TRUE(weights);
+  EXPECT_EQ(weights->getType()->dims().vec(), std::vector<dim_t>({4, 3}));
+  EXPECT_FLOAT_EQ(weights->getPayload().getHandle().raw(11), 12);
+  const Constant *bias = mod.getConstantByName("bias");
+  ASSERT_TRUE(bias);
+  EXPECT_EQ(bias->getType()->dims().vec(), std::vector<dim_t>({4}));
+  EXPECT_FLOAT_EQ(bias->getPayload().getHandle().raw(3), 0.4f);
+}
+
 /// Test loading a FC node : I * transpose(W) + B, where I is need to be
 /// flatten.
 TEST_F(Caffe2ImporterTest, FCWithFlatten) {
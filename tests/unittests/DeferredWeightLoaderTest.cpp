@@ -19,9 +19,14 @@
 #include "glow/ExecutionContext/ExecutionContext.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Runtime/Provisioner/Provisioner.h"
+#include "glow/Support/ZipUtils.h"
+
+#include "llvm/Support/FileSystem.h"
 
 #include "gtest/gtest.h"
 
+#include <fstream>
+
 using namespace glow;
 using namespace glow::runtime;
 
@@ -248,4 +253,111 @@ TEST_P(DeferredWeightLoaderTest, FP16StaticPlaceholderInference) {
   EXPECT_NEAR(resHandle.at({0}), 12.0, 1E-5);
 }
 
+/// Test that the Transpose, Quantize and RescaleQuantized of a static
+/// Placeholder are folded into it, and applied when the weight is loaded.
+TEST_P(DeferredWeightLoaderTest, FoldedWeightTransformsInference) {
+  CHECK_IF_ENABLED();
+  auto hostmanager = createHostManager(GetParam());
+  ExecutionEngine EE{GetParam()};
+  auto &module = EE.getModule();
+  auto F = module.createFunction("main");
+  auto *X = module.createPlaceholder(ElemKind::FloatTy, {2, 3}, "X", false);
+  auto *Z = module.createPlaceholder(ElemKind::FloatTy, {3, 2}, "Z", false);
+  auto *output =
+      module.createPlaceholder(ElemKind::FloatTy, {3, 2}, "output", false);
+  X->setStatic(true);
+  auto *TN = F->createTranspose("transpose", X, {1, 0});
+  auto *QN = F->createQuantize(
+      "quantize", TN, module.uniqueType(ElemKind::Int8QTy, {3, 2}, 0.05, 0));
+  auto *RN = F->createRescaleQuantized(
+      "rescale", QN, module.uniqueType(ElemKind::Int8QTy, {3, 2}, 0.1, 2));
+  auto *QZ = F->createQuantize(
+      "quantizeZ", Z, module.uniqueType(ElemKind::Int8QTy, {3, 2}, 0.1, 0));
+  auto *add = F->createAdd(
+      "add", module.uniqueType(ElemKind::Int8QTy, {3, 2}, 0.1, 0), RN, QZ);
+  auto *DN = F->createDequantize("dequantize", add, ElemKind::FloatTy);
+  F->createSave("save", DN, output);
+  auto xTensor = Tensor(X->getType());
+  xTensor.getHandle() = {1.0, 2.0, 3.0, -1.0, -2.0, -3.0};
+  auto zTensor = Tensor(Z->getType());
+  zTensor.getHandle().clear(0.5);
+
+  TestDeferredWeightLoader loader;
+  loader.addWeight(&xTensor);
+  loader.addName("X");
+  DeferredLoader()->registerLoader(&loader);
+
+  CompilationContext cctx;
+  cctx.deferredWeightLoader = &loader;
+  cctx.optimizationOpts.foldStaticPlaceholderConversions = true;
+  EE.compile(cctx);
+
+  // The weight is stored transposed and quantized.
+  EXPECT_EQ(X->getElementType(), ElemKind::Int8QTy);
+  EXPECT_EQ(X->dims(), llvm::ArrayRef<dim_t>({3, 2}));
+  EXPECT_EQ(X->getLoadShuffle(), llvm::ArrayRef<unsigned_t>({1, 0}));
+
+  PlaceholderBindings pBindings;
+  pBindings.allocate(Z);
+  pBindings.allocate(output);
+  updateInputPlaceholders(pBindings, {Z}, {&zTensor});
+  EE.run(pBindings);
+  auto resHandle = pBindings.get(output)->getHandle();
+  for (dim_t i = 0; i < 3; i++) {
+    EXPECT_NEAR(resHandle.at({i, 0}), (i + 1) + 0.5, 0.05);
+    EXPECT_NEAR(resHandle.at({i, 1}), -(float)(i + 1) + 0.5, 0.05);
+  }
+}
+
+/// Test loading the static Placeholders from a zip archive, with one weight
+/// stored uncompressed and pointed into, the other compressed and copied.
+TEST_P(DeferredWeightLoaderTest, zipStaticPlaceholderInference) {
+  CHECK_IF_ENABLED();
+  auto hostmanager = createHostManager(GetParam());
+  ExecutionEngine EE{GetParam()};
+  auto &module = EE.getModule();
+  auto F = module.createFunction("main");
+  auto *X = module.createPlaceholder(ElemKind::FloatTy, {1}, "X", false);
+  auto *Y = module.createPlaceholder(ElemKind::FloatTy, {1}, "Y", false);
+  auto *Z = module.createPlaceholder(ElemKind::FloatTy, {1}, "Z", false);
+  auto *output =
+      module.createPlaceholder(ElemKind::FloatTy, {1}, "output", false);
+  X->setStatic(true);
+  Y->setStatic(true);
+  auto pow1 = F->createPow("pow", X, Y);
+  auto pow2 = F->createPow("pow2", Z, pow1);
+  F->createSave("save", pow2, output);
+  auto zTensor = Tensor(Z->getType());
+  zTensor.getHandle().clear(2.0);
+
+  llvm::SmallString<64> path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("weights", "zip", path));
+  {
+    std::ofstream out(path.c_str(), std::ios::binary);
+    ZipWriter zip(&out, "weights");
+    const float x = 2.0;
+    const float y = 3.0;
+    zip.writeRecord("X", &x, sizeof(x), /* compress */ false);
+    zip.writeRecord("Y", &y, sizeof(y), /* compress */ true);
+    zip.writeEndOfFile();
+  }
+
+  ZipDeferredWeightLoader loader;
+  loader.setTypeInfo({{"X", *X->getType()}, {"Y", *Y->getType()}});
+  ASSERT_FALSE(ERR_TO_BOOL(loader.setSrc(const_cast<char *>(path.c_str()))));
+  DeferredLoader()->registerLoader(&loader);
+
+  CompilationContext cctx;
+  cctx.deferredWeightLoader = &loader;
+  EE.compile(cctx);
+  PlaceholderBindings pBindings;
+  pBindings.allocate(Z);
+  pBindings.allocate(output);
+  updateInputPlaceholders(pBindings, {Z}, {&zTensor});
+  EE.run(pBindings);
+  auto resHandle = pBindings.get(output)->getHandle();
+  EXPECT_NEAR(resHandle.at({0}), 256.0, 1E-5);
+  llvm::sys::fs::remove(path);
+}
+
 INSTANTIATE_BACKEND_TEST(DeferredWeightLoaderTest);
@@ -783,6 +783,184 @@ TEST(DeviceManagerTest, AvailableMemory) {
   EXPECT_EQ(cpuDeviceDefault->getMaximumMemory(), 2000000000);
 }
 
+/// Check that a CPU device with several execution threads runs many
+/// in-flight requests for the same function correctly.
+TEST(DeviceManagerTest, CPUConcurrentRuns) {
+  auto module = makeBasicModule();
+  std::vector<std::unique_ptr<CompiledFunction>> backing;
+  FunctionMapTy functions = compileFunctions("CPU", module.get(), backing);
+
+  auto config = DeviceConfig("CPU");
+  config.parameters["numThreads"] = "4";
+  auto device = std::unique_ptr<DeviceManager>(
+      DeviceManager::createDeviceManager(config));
+  ASSERT_FALSE(ERR_TO_BOOL(device->init()));
+
+  std::promise<const Module *> promise;
+  std::future<const Module *> future;
+  std::tie(promise, future) = getFutureHelper<const Module *>();
+  device->addNetwork(module.get(), std::move(functions),
+                     [&promise](const Module *module, Error err) {
+                       callbackHelper(promise, module, std::move(err));
+                     });
+  future.wait_for(std::chrono::seconds(2));
+  ASSERT_EQ(future.get(), module.get());
+
+  auto *inputPH = module->getPlaceholderByNameSlow("main_input");
+  auto *outputPH = module->getPlaceholderByNameSlow("main_output");
+  constexpr unsigned numRuns = 32;
+  std::vector<std::promise<std::unique_ptr<ExecutionContext>>> runPromises(
+      numRuns);
+  std::vector<std::future<std::unique_ptr<ExecutionContext>>> runFutures;
+  for (unsigned i = 0; i < numRuns; i++) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->getPlaceholderBindings()->allocate(module->getPlaceholders());
+    Tensor input(ElemKind::FloatTy, {1});
+    input.getHandle().clear(0.1f * i);
+    updateInputPlaceholders(*context->getPlaceholderBindings(), {inputPH},
+                            {&input});
+    runFutures.push_back(runPromises[i].get_future());
+    device->runFunction("main", std::move(context),
+                        [&runPromises, i](RunIdentifierTy, Error err,
+                                          std::unique_ptr<ExecutionContext> c) {
+                          callbackHelper(runPromises[i], std::move(c),
+                                         std::move(err));
+                        });
+  }
+
+  for (unsigned i = 0; i < numRuns; i++) {
+    auto context = runFutures[i].get();
+    ASSERT_TRUE(context);
+    context->getPlaceholderBindings()->ensureOnHost();
+    Tensor *result = context->getPlaceholderBindings()->get(outputPH);
+    ASSERT_TRUE(result);
+    EXPECT_FLOAT_EQ(result->getHandle().at({0}),
+                    std::max(std::tanh(0.1f * i), 0.25f));
+  }
+
+  EXPECT_FALSE(ERR_TO_BOOL(device->stop()));
+}
+
+/// Check that a CPU device pinned to a CPU and a NUMA node runs correctly.
+TEST(DeviceManagerTest, CPUPinnedDevice) {
+  auto module = makeBasicModule();
+  std::vector<std::unique_ptr<CompiledFunction>> backing;
+  FunctionMapTy functions = compileFunctions("CPU", module.get(), backing);
+
+  auto config = DeviceConfig("CPU");
+  config.parameters["cpuSet"] = "0";
+  config.parameters["numaNode"] = "0";
+  auto device = std::unique_ptr<DeviceManager>(
+      DeviceManager::createDeviceManager(config));
+  ASSERT_FALSE(ERR_TO_BOOL(device->init()));
+
+  std::promise<const Module *> promise;
+  std::future<const Module *> future;
+  std::tie(promise, future) = getFutureHelper<const Module *>();
+  device->addNetwork(module.get(), std::move(functions),
+                     [&promise](const Module *module, Error err) {
+                       callbackHelper(promise, module, std::move(err));
+                     });
+  future.wait_for(std::chrono::seconds(2));
+  ASSERT_EQ(future.get(), module.get());
+
+  auto context = glow::make_unique<ExecutionContext>();
+  context->getPlaceholderBindings()->allocate(module->getPlaceholders());
+  Tensor input(ElemKind::FloatTy, {1});
+  input.getHandle().clear(0.5f);
+  updateInputPlaceholders(*context->getPlaceholderBindings(),
+                          {module->getPlaceholderByNameSlow("main_input")},
+                          {&input});
+  std::promise<std::unique_ptr<ExecutionContext>> runPromise;
+  std::future<std::unique_ptr<ExecutionContext>> runFuture;
+  std::tie(runPromise, runFuture) =
+      getFutureHelper<std::unique_ptr<ExecutionContext>>();
+  device->runFunction("main", std::move(context),
+                      [&runPromise](RunIdentifierTy, Error err,
+                                    std::unique_ptr<ExecutionContext> c) {
+                        callbackHelper(runPromise, std::move(c),
+                                       std::move(err));
+                      });
+  context = runFuture.get();
+  ASSERT_TRUE(context);
+  context->getPlaceholderBindings()->ensureOnHost();
+  Tensor *result = context->getPlaceholderBindings()->get(
+      module->getPlaceholderByNameSlow("main_output"));
+  ASSERT_TRUE(result);
+  EXPECT_FLOAT_EQ(result->getHandle().at({0}),
+                  std::max(std::tanh(0.5f), 0.25f));
+
+  EXPECT_FALSE(ERR_TO_BOOL(device->stop()));
+}
+
+/// Check that CPU devices adding the same compiled function concurrently, as
+/// the replicas of a saturated host do, share one copy of its constants.
+TEST(DeviceManagerTest, CPUSharedConstants) {
+  auto module = makeBasicModule();
+  std::vector<std::unique_ptr<CompiledFunction>> backing;
+  FunctionMapTy functions = compileFunctions("CPU", module.get(), backing);
+  ASSERT_EQ(backing.size(), 1);
+  auto &bundle = backing[0]->getRuntimeBundle();
+  ASSERT_EQ(bundle.getConstants(), nullptr);
+
+  constexpr unsigned numDevices = 4;
+  std::vector<std::unique_ptr<DeviceManager>> devices;
+  std::vector<std::promise<const Module *>> addPromises(numDevices);
+  std::vector<std::future<const Module *>> addFutures;
+  for (unsigned i = 0; i < numDevices; i++) {
+    auto config = DeviceConfig("CPU");
+    config.deviceID = i;
+    devices.emplace_back(DeviceManager::createDeviceManager(config));
+    ASSERT_FALSE(ERR_TO_BOOL(devices.back()->init()));
+  }
+  for (unsigned i = 0; i < numDevices; i++) {
+    addFutures.push_back(addPromises[i].get_future());
+    devices[i]->addNetwork(module.get(), functions,
+                           [&addPromises, i](const Module *module, Error err) {
+                             callbackHelper(addPromises[i], module,
+                                            std::move(err));
+                           });
+  }
+  for (auto &future : addFutures) {
+    ASSERT_EQ(future.get(), module.get());
+  }
+  uint8_t *constants = bundle.getConstants();
+  ASSERT_NE(constants, nullptr);
+
+  for (unsigned i = 0; i < numDevices; i++) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->getPlaceholderBindings()->allocate(module->getPlaceholders());
+    Tensor input(ElemKind::FloatTy, {1});
+    input.getHandle().clear(0.1f * i);
+    updateInputPlaceholders(*context->getPlaceholderBindings(),
+                            {module->getPlaceholderByNameSlow("main_input")},
+                            {&input});
+    std::promise<std::unique_ptr<ExecutionContext>> runPromise;
+    std::future<std::unique_ptr<ExecutionContext>> runFuture;
+    std::tie(runPromise, runFuture) =
+        getFutureHelper<std::unique_ptr<ExecutionContext>>();
+    devices[i]->runFunction("main", std::move(context),
+                            [&runPromise](RunIdentifierTy, Error err,
+                                          std::unique_ptr<ExecutionContext> c) {
+                              callbackHelper(runPromise, std::move(c),
+                                             std::move(err));
+                            });
+    context = runFuture.get();
+    ASSERT_TRUE(context);
+    context->getPlaceholderBindings()->ensureOnHost();
+    Tensor *result = context->getPlaceholderBindings()->get(
+        module->getPlaceholderByNameSlow("main_output"));
+    ASSERT_TRUE(result);
+    EXPECT_FLOAT_EQ(result->getHandle().at({0}),
+                    std::max(std::tanh(0.1f * i), 0.25f));
+  }
+  EXPECT_EQ(bundle.getConstants(), constants);
+
+  for (auto &device : devices) {
+    EXPECT_FALSE(ERR_TO_BOOL(device->stop()));
+  }
+}
+
 TEST(DeviceManagerTest, DummyDeviceManager) {
   DummyDeviceManager deviceManager{DeviceConfig("Interpreter")};
   ASSERT_FALSE(ERR_TO_BOOL(deviceManager.init()));
@@ -886,21 +1064,23 @@ public:
 
   void transferToDevice(
       Tensor &tensor, void *locationContext = nullptr,
-      std::function<void(Error)> resultCB = [](Error) {}) override {
+      std::function<void(Error)> resultCB = GLOW_DRT_DEFAULT_CB) override {
     if (locationContext == nullptr) {
       locationContext = malloc(tensor.getSizeInBytes());
     }
     memcpy(locationContext, tensor.getUnsafePtr(), tensor.getSizeInBytes());
     tensor.moveToDevice(this, locationContext);
+    resultCB(Error::success());
   }
 
   void transferFromDevice(
       Tensor &tensor, bool release = true,
-      std::function<void(Error)> resultCB = [](Error) {}) override {
+      std::function<void(Error)> resultCB = GLOW_DRT_DEFAULT_CB) override {
     memcpy(tensor.getUnsafePtr(), tensor.getLocationContext(),
            tensor.getSizeInBytes());
     free(tensor.getLocationContext());
     tensor.clearDeviceResidency();
+    resultCB(Error::success());
   }
 
   bool releaseDeviceTensor(void *locationContext) override { return true; }
@@ -970,4 +1150,36 @@ TEST_P(DeviceManagerTest, TensorCopyRawToDevice) {
   }
 }
 
+/// Check that a tensor moves between devices without device-to-device copies
+/// by staging it on the host.
+TEST_P(DeviceManagerTest, TensorTransferToPeer) {
+  MockDM srcDM;
+  MockDM destDM;
+  ASSERT_FALSE(srcDM.canTransferToPeer(destDM));
+
+  Tensor T(ElemKind::FloatTy, {10});
+  T.getHandle().clear(3);
+  srcDM.transferToDevice(T);
+  ASSERT_TRUE(T.isDeviceResident());
+
+  bool done = false;
+  srcDM.transferToPeer(T, destDM, [&done](Error err) {
+    EXPECT_FALSE(ERR_TO_BOOL(std::move(err)));
+    done = true;
+  });
+  ASSERT_TRUE(done);
+  ASSERT_TRUE(T.isDeviceResident());
+  EXPECT_EQ(T.getDeviceManager(), &destDM);
+  for (unsigned i = 0; i < 10; ++i) {
+    EXPECT_EQ(static_cast<float *>(T.getLocationContext())[i], 3);
+  }
+
+  destDM.transferFromDevice(T);
+  ASSERT_FALSE(T.isDeviceResident());
+  auto handle = T.getHandle();
+  for (unsigned i = 0; i < 10; ++i) {
+    EXPECT_EQ(handle.at({i}), 3);
+  }
+}
+
 INSTANTIATE_BACKEND_TEST(DeviceManagerTest);
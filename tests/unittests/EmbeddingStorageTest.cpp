@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "glow/Runtime/EmbeddingStorage.h"
+#include "glow/ExecutionEngine/ExecutionEngine.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "gtest/gtest.h"
+
+#include <cstring>
+
+using namespace glow;
+using namespace glow::runtime;
+
+namespace {
+
+constexpr dim_t kTableRows = 1000;
+constexpr dim_t kWidth = 8;
+constexpr size_t kRowSize = kWidth * sizeof(float);
+
+/// Writes a random {kTableRows, kWidth} float table to a temporary file.
+/// \returns the table.
+Tensor writeTable(llvm::SmallString<64> &path) {
+  Tensor table(ElemKind::FloatTy, {kTableRows, kWidth});
+  PseudoRNG PRNG;
+  table.getHandle().randomize(-1.f, 1.f, PRNG);
+  EXPECT_FALSE(llvm::sys::fs::createTemporaryFile("table", "bin", path));
+  EXIT_ON_ERR(writeEmbeddingTableFile(path.str().str(), table));
+  return table;
+}
+
+} // namespace
+
+/// Test that an SLWS over a table in a file gives the results of the SLWS
+/// over the whole table, with duplicate indices and both index types.
+TEST(EmbeddingStorage, slwsMatchesTable) {
+  llvm::SmallString<64> path;
+  Tensor table = writeTable(path);
+  auto tableFile = EXIT_ON_ERR(EmbeddingTableFile::open(
+      path.str().str(), kRowSize, /* cacheRows */ 16));
+
+  for (ElemKind indicesKind : {ElemKind::Int32ITy, ElemKind::Int64ITy}) {
+    ExecutionEngine EE("Interpreter");
+    auto &mod = EE.getModule();
+    Function *F = mod.createFunction("main");
+    constexpr dim_t numIndices = 10;
+    auto *data = mod.createPlaceholder(ElemKind::FloatTy,
+                                       {numIndices, kWidth}, "data", false);
+    auto *weights = mod.createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                          "weights", false);
+    auto *indices =
+        mod.createPlaceholder(indicesKind, {numIndices}, "indices", false);
+    auto *lengths =
+        mod.createPlaceholder(ElemKind::Int32ITy, {3}, "lengths", false);
+    auto *SLWS = F->createSparseLengthsWeightedSum("SLWS", data, weights,
+                                                   indices, lengths);
+    auto *save = F->createSave("save", SLWS);
+    EE.compile(CompilationMode::Infer);
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    std::vector<int64_t> rows = {999, 3, 4, 3, 500, 0, 4, 998, 999, 5};
+    std::vector<float> weightValues = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    bindings.get(weights)->getHandle() = weightValues;
+    bindings.get(lengths)->getHandle<int32_t>() = {3, 0, 7};
+    for (dim_t i = 0; i < numIndices; i++) {
+      if (indicesKind == ElemKind::Int32ITy) {
+        bindings.get(indices)->getHandle<int32_t>().raw(i) = rows[i];
+      } else {
+        bindings.get(indices)->getHandle<int64_t>().raw(i) = rows[i];
+      }
+    }
+
+    auto fetchers =
+        EXIT_ON_ERR(getEmbeddingRowFetchers(*F, {{"data", tableFile}}));
+    ASSERT_EQ(fetchers.size(), 1);
+    std::vector<Tensor> storage;
+    ASSERT_FALSE(ERR_TO_BOOL(fetchEmbeddingRows(fetchers, bindings, storage)));
+    // The 7 rows used are the only ones of the compact table.
+    for (dim_t i = 0; i < numIndices; i++) {
+      int64_t index = indicesKind == ElemKind::Int32ITy
+                          ? bindings.get(indices)->getHandle<int32_t>().raw(i)
+                          : bindings.get(indices)->getHandle<int64_t>().raw(i);
+      EXPECT_LT(index, 7);
+    }
+    EE.run(bindings);
+
+    auto TH = table.getHandle();
+    auto RH = bindings.get(save->getPlaceholder())->getHandle();
+    std::vector<size_t> segments = {0, 3, 3, 10};
+    for (dim_t s = 0; s < 3; s++) {
+      for (dim_t j = 0; j < kWidth; j++) {
+        float expected = 0;
+        for (size_t i = segments[s]; i < segments[s + 1]; i++) {
+          expected += weightValues[i] * TH.at({dim_t(rows[i]), j});
+        }
+        EXPECT_NEAR(RH.at({s, j}), expected, 1e-5);
+      }
+    }
+  }
+  llvm::sys::fs::remove(path);
+}
+
+/// Test that rows missing from the cache are read once per run of
+/// consecutive rows, and that cached rows are not read again.
+TEST(EmbeddingStorage, cacheAndBatchedReads) {
+  llvm::SmallString<64> path;
+  Tensor table = writeTable(path);
+  auto tableFile = EXIT_ON_ERR(EmbeddingTableFile::open(
+      path.str().str(), kRowSize, /* cacheRows */ 4));
+  EXPECT_EQ(tableFile->getNumRows(), kTableRows);
+
+  std::vector<uint8_t> dst(5 * kRowSize);
+  auto checkRows = [&](const std::vector<uint64_t> &rows) {
+    ASSERT_FALSE(ERR_TO_BOOL(tableFile->readRows(rows, dst.data())));
+    for (size_t i = 0; i < rows.size(); i++) {
+      EXPECT_EQ(memcmp(&dst[i * kRowSize],
+                       table.getUnsafePtr() + rows[i] * kRowSize, kRowSize),
+                0);
+    }
+  };
+
+  checkRows({3, 4, 5, 9});
+  EXPECT_EQ(tableFile->getNumReads(), 2);
+  EXPECT_EQ(tableFile->getNumRowsRead(), 4);
+  EXPECT_EQ(tableFile->getNumCacheHits(), 0);
+
+  // 4 and 9 are cached, 10 is read and evicts the least recently used 3.
+  checkRows({4, 9, 10});
+  EXPECT_EQ(tableFile->getNumReads(), 3);
+  EXPECT_EQ(tableFile->getNumRowsRead(), 5);
+  EXPECT_EQ(tableFile->getNumCacheHits(), 2);
+
+  checkRows({3, 5});
+  EXPECT_EQ(tableFile->getNumRowsRead(), 6);
+  EXPECT_EQ(tableFile->getNumCacheHits(), 3);
+  llvm::sys::fs::remove(path);
+}
+
+/// Test that indices out of the rows of the file are rejected.
+TEST(EmbeddingStorage, indexOutOfRange) {
+  llvm::SmallString<64> path;
+  writeTable(path);
+  auto tableFile = EXIT_ON_ERR(
+      EmbeddingTableFile::open(path.str().str(), kRowSize, /* cacheRows */ 0));
+
+  Module mod;
+  Function *F = mod.createFunction("main");
+  auto *data =
+      mod.createPlaceholder(ElemKind::FloatTy, {4, kWidth}, "data", false);
+  auto *indices =
+      mod.createPlaceholder(ElemKind::Int64ITy, {4}, "indices", false);
+  auto *lengths =
+      mod.createPlaceholder(ElemKind::Int32ITy, {1}, "lengths", false);
+  F->createSparseLengthsSum("SLS", data, indices, lengths);
+
+  PlaceholderBindings bindings;
+  bindings.allocate(mod.getPlaceholders());
+  bindings.get(indices)->getHandle<int64_t>() = {1, 2, kTableRows, 3};
+  auto fetchers =
+      EXIT_ON_ERR(getEmbeddingRowFetchers(*F, {{"data", tableFile}}));
+  ASSERT_EQ(fetchers.size(), 1);
+  std::vector<Tensor> storage;
+  EXPECT_TRUE(ERR_TO_BOOL(fetchEmbeddingRows(fetchers, bindings, storage)));
+  llvm::sys::fs::remove(path);
+}
@@ -34,6 +34,26 @@ extern "C" {
 extern void libjit_matmul_f(float *c, const float *a, const float *b,
                             const dim_t *cDims, const dim_t *aDims,
                             const dim_t *bDims);
+extern void libjit_matmul_avx2_f(float *c, const float *a, const float *b,
+                                 const dim_t *cDims, const dim_t *aDims,
+                                 const dim_t *bDims);
+extern void libjit_matmul_avx512_f(float *c, const float *a, const float *b,
+                                   const dim_t *cDims, const dim_t *aDims,
+                                   const dim_t *bDims);
+extern void libjit_matmul_i8(int8_t *outW, const int8_t *lhsW,
+                             const int8_t *rhsW, const dim_t *outWdims,
+                             const dim_t *lhsWdims, const dim_t *rhsWdims,
+                             int32_t outOffset, int32_t lhsOffset,
+                             int32_t rhsOffset, int32_t outPre,
+                             int32_t outPost, int32_t outScale);
+#if defined(__x86_64__) || defined(__i386__)
+extern void libjit_matmul_vnni_i8(int8_t *outW, const int8_t *lhsW,
+                                  const int8_t *rhsW, const dim_t *outWdims,
+                                  const dim_t *lhsWdims, const dim_t *rhsWdims,
+                                  int32_t outOffset, int32_t lhsOffset,
+                                  int32_t rhsOffset, int32_t outPre,
+                                  int32_t outPost, int32_t outScale);
+#endif
 }
 
 void infer(Tensor *out, Tensor *lhs, Tensor *rhs) {
@@ -91,3 +111,68 @@ TEST(Gemm, Sweep) {
 }
 
 TEST(Gemm, Big) { testGemm(1, 1028, 32); }
+
+/// Check that the kernels for every register block compute the same result.
+TEST(Gemm, Kernels) {
+  PseudoRNG PRNG;
+  for (dim_t m : {1, 7, 33, 70}) {
+    for (dim_t n : {1, 6, 19, 64}) {
+      for (dim_t k : {1, 5, 130}) {
+        Tensor lhs(ElemKind::FloatTy, {m, k});
+        Tensor rhs(ElemKind::FloatTy, {k, n});
+        lhs.getHandle().randomize(-7.2, 8.3, PRNG);
+        rhs.getHandle().randomize(-6.3, 10.1, PRNG);
+        Tensor expected(ElemKind::FloatTy, {m, n});
+        Tensor avx2(ElemKind::FloatTy, {m, n});
+        Tensor avx512(ElemKind::FloatTy, {m, n});
+        auto *lhsPtr = (float *)lhs.getUnsafePtr();
+        auto *rhsPtr = (float *)rhs.getUnsafePtr();
+        libjit_matmul_f((float *)expected.getUnsafePtr(), lhsPtr, rhsPtr,
+                        expected.dims().data(), lhs.dims().data(),
+                        rhs.dims().data());
+        libjit_matmul_avx2_f((float *)avx2.getUnsafePtr(), lhsPtr, rhsPtr,
+                             avx2.dims().data(), lhs.dims().data(),
+                             rhs.dims().data());
+        libjit_matmul_avx512_f((float *)avx512.getUnsafePtr(), lhsPtr, rhsPtr,
+                               avx512.dims().data(), lhs.dims().data(),
+                               rhs.dims().data());
+        EXPECT_TRUE(expected.isEqual(avx2, 2e-2));
+        EXPECT_TRUE(expected.isEqual(avx512, 2e-2));
+      }
+    }
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/// Check that the AVX512-VNNI int8 kernel matches the reference kernel
+/// exactly, including offsets, rounding and saturation.
+TEST(Gemm, Int8VNNI) {
+  if (!__builtin_cpu_supports("avx512vnni") ||
+      !__builtin_cpu_supports("avx512bw") ||
+      !__builtin_cpu_supports("avx512vl")) {
+    GTEST_SKIP() << "AVX512-VNNI is not supported by the host";
+  }
+  PseudoRNG PRNG;
+  for (dim_t m : {1, 3, 4, 9}) {
+    for (dim_t n : {1, 16, 33}) {
+      for (dim_t k : {1, 5, 130}) {
+        Tensor lhs(ElemKind::Int8QTy, {m, k}, 1.0, 0);
+        Tensor rhs(ElemKind::Int8QTy, {k, n}, 1.0, 0);
+        lhs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+        rhs.getHandle<int8_t>().randomize(-128, 127, PRNG);
+        Tensor expected(ElemKind::Int8QTy, {m, n}, 1.0, 0);
+        Tensor vnni(ElemKind::Int8QTy, {m, n}, 1.0, 0);
+        auto *lhsPtr = (int8_t *)lhs.getUnsafePtr();
+        auto *rhsPtr = (int8_t *)rhs.getUnsafePtr();
+        libjit_matmul_i8((int8_t *)expected.getUnsafePtr(), lhsPtr, rhsPtr,
+                         expected.dims().data(), lhs.dims().data(),
+                         rhs.dims().data(), 3, -5, 7, 2, 14, 97);
+        libjit_matmul_vnni_i8((int8_t *)vnni.getUnsafePtr(), lhsPtr, rhsPtr,
+                              vnni.dims().data(), lhs.dims().data(),
+                              rhs.dims().data(), 3, -5, 7, 2, 14, 97);
+        EXPECT_TRUE(expected.isEqual(vnni, 0));
+      }
+    }
+  }
+}
+#endif
@@ -51,6 +51,43 @@ TEST(GlowOnnxifiManagerTest, EventTest) {
   EXPECT_FALSE(manager.isValid(event));
 }
 
+TEST(GlowOnnxifiManagerTest, EventCallbackTest) {
+  auto &manager = GlowOnnxifiManager::get();
+  struct Result {
+    onnxEvent event = nullptr;
+    onnxStatus status = ONNXIFI_STATUS_SUCCESS;
+    int calls = 0;
+  };
+  auto callback = [](onnxEvent event, onnxStatus status, void *userData) {
+    auto *result = static_cast<Result *>(userData);
+    result->event = event;
+    result->status = status;
+    result->calls++;
+  };
+
+  // Callback set before the event is signalled runs when it is signalled.
+  auto *event = manager.createEvent();
+  Result before;
+  EXPECT_TRUE(event->setCallback(callback, &before));
+  EXPECT_FALSE(event->setCallback(callback, &before));
+  EXPECT_EQ(before.calls, 0);
+  EXPECT_TRUE(event->signal(ONNXIFI_STATUS_INTERNAL_ERROR));
+  EXPECT_EQ(before.calls, 1);
+  EXPECT_EQ(before.event, event);
+  EXPECT_EQ(before.status, ONNXIFI_STATUS_INTERNAL_ERROR);
+  manager.release(event);
+
+  // Callback set after the event is signalled runs immediately.
+  event = manager.createEvent();
+  Result after;
+  EXPECT_TRUE(event->signal(ONNXIFI_STATUS_SUCCESS));
+  EXPECT_TRUE(event->setCallback(callback, &after));
+  EXPECT_EQ(after.calls, 1);
+  EXPECT_EQ(after.event, event);
+  EXPECT_EQ(after.status, ONNXIFI_STATUS_SUCCESS);
+  manager.release(event);
+}
+
 TEST(GlowOnnxifiManagerTest, GraphTest) {
   auto &manager = GlowOnnxifiManager::get();
   auto *backend = manager.createBackend("Interpreter",
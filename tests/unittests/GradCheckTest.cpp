@@ -17,6 +17,7 @@
 
 #include "glow/Base/Tensor.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
+#include "glow/Graph/Grad.h"
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Nodes.h"
 #include "glow/IR/IR.h"
@@ -1155,4 +1156,62 @@ TEST_P(GradCheck, gradientCheckFC2) {
   EXPECT_NEAR(bindings.get(Y)->getHandle().raw(0), 0.01656, 1E-5);
 }
 
+/// Check that checkpointing the activations of a chain of layers recomputes
+/// some of them for the backward pass and gives the same gradients as keeping
+/// all of them.
+TEST_P(GradCheck, gradientCheckpointedActivations) {
+  CHECK_IF_ENABLED();
+
+  PlaceholderBindings bindings;
+  Module &mod = EET_.getModule();
+  Function *F = mod.createFunction("main");
+  const dim_t batchSize = 4;
+  const dim_t width = 16;
+
+  auto *A =
+      mod.createPlaceholder(ElemKind::FloatTy, {batchSize, width}, "A", false);
+  auto *Exp = mod.createPlaceholder(ElemKind::FloatTy, {batchSize, width},
+                                    "Exp", false);
+  NodeValue cur = A;
+  for (unsigned layer = 0; layer < 6; layer++) {
+    auto *FC = F->createFullyConnected(bindings, "fc" + std::to_string(layer),
+                                       cur, width);
+    cur = F->createTanh("tanh" + std::to_string(layer), FC);
+  }
+  auto *reg = F->createRegression("reg", cur, Exp);
+  F->createSave("ret", reg);
+
+  TrainingConfig TC;
+  VariableGradientsList plainGrads;
+  Function *plain = glow::differentiate(F, TC, "plain", &plainGrads);
+  TC.checkpointActivations = true;
+  VariableGradientsList ckptGrads;
+  Function *ckpt = glow::differentiate(F, TC, "ckpt", &ckptGrads);
+
+  unsigned numRecomputed = 0;
+  for (auto &N : ckpt->getNodes()) {
+    numRecomputed += isRecomputedNode(N);
+  }
+  EXPECT_GT(numRecomputed, 0);
+  for (auto &N : plain->getNodes()) {
+    EXPECT_FALSE(isRecomputedNode(N));
+  }
+  ASSERT_EQ(plainGrads.size(), ckptGrads.size());
+
+  EET_.compile(CompilationMode::Train);
+  bindings.allocate(mod.getPlaceholders());
+  bindings.get(A)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(Exp)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  EET_.run(bindings, "plain");
+  EET_.run(bindings, "ckpt");
+
+  auto plainIt = plainGrads.begin();
+  for (auto &p : ckptGrads) {
+    ASSERT_EQ(p.first, plainIt->first);
+    EXPECT_TRUE(bindings.get(p.second)->isEqual(*bindings.get(plainIt->second),
+                                                1e-5));
+    ++plainIt;
+  }
+}
+
 INSTANTIATE_BACKEND_TEST(GradCheck);
@@ -1273,6 +1273,68 @@ TEST_F(GraphOptz, SinkTransposeBelowPRelu) {
   checkNumericalEquivalence();
 }
 
+/// Test that a region of element-wise nodes between two Transposes which
+/// cancel out runs in the order of the Transposes when only one of its other
+/// inputs needs to be transposed, which SinkCode can't do since the Add has a
+/// single transposed input.
+TEST_F(GraphOptz, MinimizeTransposesAroundRegion) {
+  auto *A =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 4, 6, 8}, "A", false);
+  auto *B =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 6, 8, 4}, "B", false);
+  auto *C = mod_.createConstant(ElemKind::FloatTy, {2, 6, 8, 4}, "C");
+  C->getPayloadMutable().getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *TA = F_->createTranspose("transposeA", A, NCHW2NHWC);
+  auto *add = F_->createAdd("add", TA, B);
+  auto *relu = F_->createRELU("relu", add);
+  auto *mul = F_->createMul("mul", relu, C);
+  auto *TO = F_->createTranspose("transposeOut", mul, NHWC2NCHW);
+  auto *save = F_->createSave("save", TO);
+
+  optimizedF_ = optimizeFunctionForTest(
+      F_, {FunctionPassID::MinimizeTransposes, getDCEPassConfig()});
+
+  EXPECT_EQ(countNodeKind(F_, Kinded::Kind::TransposeNodeKind), 2);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 1);
+  auto *saveOpt =
+      findFunctionNodeByName<SaveNode>(optimizedF_, save->getName());
+  auto *mulOpt = llvm::dyn_cast<MulNode>(saveOpt->getInput());
+  ASSERT_TRUE(mulOpt);
+  EXPECT_EQ(mulOpt->getResult().dims(), A->dims());
+  auto *reluOpt = llvm::dyn_cast<ReluNode>(mulOpt->getLHS());
+  ASSERT_TRUE(reluOpt);
+  auto *addOpt = llvm::dyn_cast<AddNode>(reluOpt->getInput());
+  ASSERT_TRUE(addOpt);
+  EXPECT_EQ(addOpt->getLHS().getNode(), A);
+  auto *TB = llvm::dyn_cast<TransposeNode>(addOpt->getRHS());
+  ASSERT_TRUE(TB);
+  EXPECT_EQ(TB->getInput().getNode(), B);
+  EXPECT_TRUE(llvm::isa<Constant>(mulOpt->getRHS()));
+
+  bindings_.allocate(mod_.getPlaceholders());
+  bindings_.get(A)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  bindings_.get(B)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  checkNumericalEquivalence();
+}
+
+/// Test that a region of element-wise nodes is left alone when changing its
+/// order would add more Transposes than it removes.
+TEST_F(GraphOptz, MinimizeTransposesNotProfitable) {
+  auto *A =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 4, 6, 8}, "A", false);
+  auto *B =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 6, 8, 4}, "B", false);
+  auto *TA = F_->createTranspose("transposeA", A, NCHW2NHWC);
+  auto *add = F_->createAdd("add", TA, B);
+  F_->createSave("save", add);
+
+  optimizedF_ = optimizeFunctionForTest(
+      F_, {FunctionPassID::MinimizeTransposes, getDCEPassConfig()});
+
+  EXPECT_EQ(optimizedF_->getNodes().size(), 3);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::TransposeNodeKind), 1);
+}
+
 TEST_F(GraphOptz, SinkTransposeBelowTile) {
   auto *in =
       mod_.createPlaceholder(ElemKind::FloatTy, {1, 5, 10, 15}, "input", false);
@@ -3921,6 +3983,28 @@ TEST_F(GraphOptz, VarsCSE) {
   EXPECT_TRUE(input3->getUsers().begin()->getUser() == RN);
 }
 
+/// Check that Variable CSE sees the changes of the payloads of Constants
+/// between runs, for which it keeps hashes.
+TEST_F(GraphOptz, VarsCSEAfterPayloadChange) {
+  auto *input1 = mod_.createConstant(ElemKind::FloatTy, {10}, "input1");
+  auto *input2 = mod_.createConstant(ElemKind::FloatTy, {10}, "input2");
+  input1->getHandle() = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  input2->getHandle() = {0, 1, 2, 3, 4, 5, 6, 7, 8, -1};
+  auto *TN = F_->createTanh("tanh", input1);
+  auto *SN = F_->createSigmoid("sigmoid", input2);
+  F_->createSave("ret", F_->createConcat("concat", {TN, SN}, /* axis */ 0));
+
+  cctx_.compMode = CompilationMode::Infer;
+  cctx_.optimizationOpts.enableConstantFolding = false;
+  ::glow::optimize(F_, cctx_);
+  EXPECT_EQ(mod_.getConstants().size(), 2);
+
+  input2->getPayloadMutable().getHandle().raw(9) = 9;
+  ::glow::optimize(F_, cctx_);
+  ASSERT_EQ(mod_.getConstants().size(), 1);
+  EXPECT_EQ(TN->getInput().getNode(), SN->getInput().getNode());
+}
+
 TEST_F(GraphOptz, VarsCSENaN) {
   // Create two variables that are Private, are not trainable, have no writers
   // and include NaNs. The first two variables have the same data, and so should
@@ -4956,6 +5040,52 @@ TEST_F(GraphOptz, constantFoldWholeFunction) {
   EXPECT_EQ(CH.at({1, 1}), 76.0f);
 }
 
+/// Test that constant folding a function with several constant subgraphs,
+/// some of them used by each other, computes all of them correctly.
+TEST_F(GraphOptz, constantFoldMultipleSubgraphs) {
+  auto *const1 = mod_.createConstant(ElemKind::FloatTy, {2, 2}, "const1");
+  auto *const2 = mod_.createConstant(ElemKind::FloatTy, {2, 2}, "const2");
+  auto *ph1 = mod_.createPlaceholder(ElemKind::FloatTy, {2, 2}, "input1",
+                                     /* isTrainable */ false);
+  setConstValue(const1, 1.0f);
+  setConstValue(const2, 2.0f);
+  auto *splat3 = F_->createSplat(
+      "splat3", mod_.uniqueType(ElemKind::FloatTy, {2, 2}), 3.0f);
+
+  // add1 is used both by a non-constant operation and by mul1.
+  auto *add1 = F_->createAdd("add1", const1, const2);
+  auto *mul1 = F_->createMul("mul1", add1, splat3);
+  auto *sub1 = F_->createSub("sub1", const2, splat3);
+  auto *SN1 = F_->createSave("save1", F_->createAdd("addPH1", add1, ph1));
+  auto *SN2 = F_->createSave("save2", F_->createAdd("addPH2", mul1, ph1));
+  auto *SN3 = F_->createSave("save3", F_->createMul("mulPH3", sub1, ph1));
+
+  ::glow::optimize(F_, CompilationMode::Infer);
+
+  // \returns the value of the folded operand of the input of \p SN.
+  auto getFoldedValue = [](SaveNode *SN) {
+    Node *N = SN->getInput().getNode();
+    for (unsigned idx = 0, e = N->getNumInputs(); idx < e; ++idx) {
+      Node *input = N->getNthInput(idx).getNode();
+      if (auto *splat = llvm::dyn_cast<SplatNode>(input)) {
+        return splat->getValue();
+      }
+      if (auto *C = llvm::dyn_cast<Constant>(input)) {
+        auto CH = C->getHandle();
+        for (dim_t i = 1, e = CH.size(); i < e; i++) {
+          EXPECT_EQ(CH.raw(i), CH.raw(0));
+        }
+        return CH.raw(0);
+      }
+    }
+    ADD_FAILURE() << "Expected a folded input of " << N->getName().str();
+    return 0.0f;
+  };
+  EXPECT_EQ(getFoldedValue(SN1), 3.0f);
+  EXPECT_EQ(getFoldedValue(SN2), 9.0f);
+  EXPECT_EQ(getFoldedValue(SN3), -1.0f);
+}
+
 /// Test constant folding for operators which are lowered in Interpreter
 /// backend.
 TEST_F(GraphOptz, constantFoldWithLowering) {
@@ -5032,6 +5162,64 @@ TEST_F(GraphOptz, SplitFCIntoMultipleOps) {
   checkNumericalEquivalence();
 }
 
+/// Test the splits picked by planParallelization(): model parallel for the
+/// FCs with constant weights, mirrored by the Relu, and no split for an FC
+/// too small to pay for its Concat.
+TEST_F(GraphOptz, ParallelizeGraph_PlanFromCostModel) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {64, 256}, "input", false);
+  bindings_.allocate(input)->getHandle<float>().randomize(-1.0, 1.0,
+                                                          mod_.getPRNG());
+  auto *weights1 =
+      mod_.createConstant(ElemKind::FloatTy, {256, 256}, "weights1");
+  weights1->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *bias1 = mod_.createConstant(ElemKind::FloatTy, {256}, "bias1");
+  bias1->getHandle().randomize(0.0, 0.5, mod_.getPRNG());
+  auto *weights2 = mod_.createConstant(ElemKind::FloatTy, {256, 4}, "weights2");
+  weights2->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *bias2 = mod_.createConstant(ElemKind::FloatTy, {4}, "bias2");
+  bias2->getHandle().randomize(0.0, 0.5, mod_.getPRNG());
+  auto *weights3 = mod_.createConstant(ElemKind::FloatTy, {4, 2}, "weights3");
+  weights3->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  auto *bias3 = mod_.createConstant(ElemKind::FloatTy, {2}, "bias3");
+  bias3->getHandle().randomize(0.0, 0.5, mod_.getPRNG());
+  auto *output =
+      mod_.createPlaceholder(ElemKind::FloatTy, {64, 2}, "output", false);
+  bindings_.allocate(output);
+
+  auto *fc1 = F_->createFullyConnected("fc1", input, weights1, bias1);
+  auto *relu1 = F_->createRELU("relu1", fc1);
+  auto *fc2 = F_->createFullyConnected("fc2", relu1, weights2, bias2);
+  auto *fc3 = F_->createFullyConnected("fc3", fc2, weights3, bias3);
+  F_->createSave("save", fc3, output);
+
+  ::glow::optimize(F_, CompilationMode::Infer);
+  optimizedF_ = F_->clone(F_->getName().str() + "_optimized");
+
+  ParallelCostModel costModel;
+  costModel.numCores = 4;
+  llvm::DenseMap<Node *, size_t> numChunks;
+  llvm::DenseMap<Node *, ParallelTransformKind> parOpts;
+  planParallelization(F_, costModel, numChunks, parOpts);
+  ASSERT_EQ(parOpts.size(), 3);
+  EXPECT_EQ(parOpts[fc1], ParallelTransformKind::Model);
+  EXPECT_EQ(numChunks[fc1], 4);
+  EXPECT_EQ(parOpts[relu1], ParallelTransformKind::Model);
+  EXPECT_EQ(numChunks[relu1], 4);
+  EXPECT_EQ(parOpts[fc2], ParallelTransformKind::Model);
+  EXPECT_EQ(numChunks[fc2], 4);
+  EXPECT_FALSE(parOpts.count(fc3));
+
+  std::unordered_map<Node *, ConcatNode *> replacedMap;
+  ASSIGN_VALUE_OR_FAIL_TEST(replacedMap,
+                            ::glow::parallelizeOps(F_, numChunks, parOpts));
+  EXPECT_EQ(replacedMap.size(), parOpts.size());
+  runDCEPass(F_, cctx_);
+  EXPECT_EQ(9, countNodeKind(F_, Kinded::Kind::FullyConnectedNodeKind));
+
+  checkNumericalEquivalence();
+}
+
 /// Test Splitting FC into multiple FCs.
 TEST_F(GraphOptz, ParallelizeGraph_FC_ModelParallel) {
   auto *input =
@@ -8352,6 +8540,72 @@ TEST_F(GraphOptz, FoldExpSumDivIntoSoftmax) {
   checkNumericalEquivalence(1e-7f);
 }
 
+/// Test that BatchMatMul+Mul+Add+SoftMax+BatchMatMul, with the Reshapes around
+/// the 2D SoftMax, is replaced with ScaledDotProductAttention.
+TEST_F(GraphOptz, FoldScaledDotProductAttention) {
+  auto *Q = mod_.createPlaceholder(ElemKind::FloatTy, {2, 5, 4}, "Q", false);
+  auto *K = mod_.createPlaceholder(ElemKind::FloatTy, {2, 6, 4}, "K", false);
+  auto *V = mod_.createPlaceholder(ElemKind::FloatTy, {2, 6, 3}, "V", false);
+  auto *mask =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 5, 6}, "mask", false);
+  for (auto *PH : {Q, K, V, mask}) {
+    bindings_.allocate(PH)->getHandle<float>().randomize(-2, 2,
+                                                         mod_.getPRNG());
+  }
+
+  auto *KT = F_->createTranspose("kt", K, {0, 2, 1});
+  auto *scores = F_->createBatchMatMul("scores", Q, KT);
+  auto *scale = F_->createSplat("scale", scores->getResult().getType(), 0.5);
+  auto *scaled = F_->createMul("scaled", scores, scale);
+  auto *masked = F_->createAdd("masked", scaled, mask);
+  auto *flat = F_->createReshape("flat", masked, {10, 6});
+  auto *selected = mod_.createConstant(ElemKind::Int64ITy, {10, 1}, "selected");
+  auto *SM = F_->createSoftMax("softmax", flat, selected);
+  auto *probs = F_->createReshape("probs", SM, {2, 5, 6});
+  auto *out = F_->createBatchMatMul("out", probs, V);
+  F_->createSave("save", out);
+
+  optimizedF_ = optimizeFunctionForTest(
+      F_, {FunctionPassID::FoldScaledDotProductAttention, getDCEPassConfig()});
+
+  ASSERT_EQ(1, countNodeKind(optimizedF_,
+                             Kinded::Kind::ScaledDotProductAttentionNodeKind));
+  EXPECT_EQ(0, countNodeKind(optimizedF_, Kinded::Kind::BatchMatMulNodeKind));
+  EXPECT_EQ(0, countNodeKind(optimizedF_, Kinded::Kind::SoftMaxNodeKind));
+  for (auto &N : optimizedF_->getNodes()) {
+    if (auto *SDPA = llvm::dyn_cast<ScaledDotProductAttentionNode>(&N)) {
+      EXPECT_EQ(SDPA->getScale(), 0.5f);
+      EXPECT_EQ(SDPA->getKey().getNode(), K);
+    }
+  }
+
+  checkNumericalEquivalence(1e-6f);
+}
+
+/// Test that the attention pattern is not folded when the scores have another
+/// user.
+TEST_F(GraphOptz, FoldScaledDotProductAttentionScoresUsed) {
+  auto *Q = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 4}, "Q", false);
+  auto *KT = mod_.createPlaceholder(ElemKind::FloatTy, {1, 4, 3}, "KT", false);
+  auto *V = mod_.createPlaceholder(ElemKind::FloatTy, {1, 3, 2}, "V", false);
+
+  auto *scores = F_->createBatchMatMul("scores", Q, KT);
+  auto *flat = F_->createReshape("flat", scores, {3, 3});
+  auto *selected = mod_.createConstant(ElemKind::Int64ITy, {3, 1}, "selected");
+  auto *SM = F_->createSoftMax("softmax", flat, selected);
+  auto *probs = F_->createReshape("probs", SM, {1, 3, 3});
+  auto *out = F_->createBatchMatMul("out", probs, V);
+  F_->createSave("save", out);
+  F_->createSave("saveScores", scores);
+
+  optimizedF_ = optimizeFunctionForTest(
+      F_, {FunctionPassID::FoldScaledDotProductAttention, getDCEPassConfig()});
+
+  EXPECT_EQ(0, countNodeKind(optimizedF_,
+                             Kinded::Kind::ScaledDotProductAttentionNodeKind));
+  EXPECT_EQ(2, countNodeKind(optimizedF_, Kinded::Kind::BatchMatMulNodeKind));
+}
+
 /// Test that identity Relu is removed.
 TEST_F(GraphOptz, RemoveIdentityRelu) {
 
@@ -8616,3 +8870,94 @@ TEST_F(GraphOptz, MergeMatMulsOnRHSWhenSkippingOne) {
 
   checkNumericalEquivalence(0.f);
 }
+
+/// Test that adding nodes and changing their inputs updates the change stamps
+/// of the nodes involved.
+TEST_F(GraphOptz, NodeChangeStamps) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {1, 4}, "input", false);
+  auto *relu = F_->createRELU("relu", input);
+  auto *tanh = F_->createTanh("tanh", input);
+  auto *save = F_->createSave("save", relu);
+  EXPECT_LT(relu->getChangeStamp(), save->getChangeStamp());
+  EXPECT_EQ(save->getChangeStamp(), F_->getChangeStamp());
+
+  const uint64_t stamp = F_->getChangeStamp();
+  save->setNthInput(SaveNode::InputIdx, tanh);
+  EXPECT_GT(save->getChangeStamp(), stamp);
+  EXPECT_GT(relu->getChangeStamp(), stamp);
+  EXPECT_GT(tanh->getChangeStamp(), stamp);
+}
+
+/// Test that running the graph optimizations incrementally gives the same
+/// Function as running them on the whole Function.
+TEST_F(GraphOptz, IncrementalGraphOptimization) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 3, 4, 5}, "input", false);
+  auto *other =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 4, 5, 3}, "other", false);
+  bindings_.allocate(input)->getHandle().randomize(-1.f, 1.f, mod_.getPRNG());
+  bindings_.allocate(other)->getHandle().randomize(-1.f, 1.f, mod_.getPRNG());
+  NodeValue V = F_->createTranspose("tr1", input, NCHW2NHWC);
+  V = F_->createRELU("relu", V);
+  V = F_->createSigmoid("sigmoid", V);
+  V = F_->createTranspose("tr2", V, NHWC2NCHW);
+  V = F_->createSlice("noopSlice", V, {0, 0, 0, 0}, {2, 3, 4, 5});
+  V = F_->createTranspose("tr3", V, NCHW2NHWC);
+  V = F_->createAdd("add", V, other);
+  V = F_->createMul("mul", V, F_->createSplat("one", V.getType(), 1.0f));
+  F_->createSave("save", V);
+
+  Function *fullF = optimizeFunctionForTest(F_);
+  cctx_.optimizationOpts.enableIncrementalGraphOptimization = true;
+  optimizedF_ = optimizeFunctionForTest(F_, {}, cctx_);
+  ASSERT_TRUE(optimizedF_->verify());
+
+  EXPECT_EQ(fullF->getNodes().size(), optimizedF_->getNodes().size());
+  for (auto kind :
+       {Kinded::Kind::TransposeNodeKind, Kinded::Kind::SliceNodeKind,
+        Kinded::Kind::MulNodeKind, Kinded::Kind::ReluNodeKind}) {
+    EXPECT_EQ(countNodeKind(fullF, kind), countNodeKind(optimizedF_, kind));
+  }
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::SliceNodeKind), 0);
+  EXPECT_EQ(countNodeKind(optimizedF_, Kinded::Kind::MulNodeKind), 0);
+
+  checkNumericalEquivalence(0.f);
+}
+
+/// Check that the pass manager records the statistics of its passes and logs
+/// them to the trace of the CompilationContext.
+TEST_F(GraphOptz, PassStatisticsAndCompileTrace) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 3}, "input", false);
+  F_->createSigmoid("dead", input);
+  F_->createSave("save", F_->createRELU("relu", input));
+  const size_t numNodes = F_->getNodes().size();
+
+  TraceContext traceContext(TraceLevel::COMPILE);
+  cctx_.traceContext = &traceContext;
+  FunctionPassManager FPM("TestFPM", {getDCEPassConfig()});
+  FPM.run(F_, cctx_);
+
+  EXPECT_EQ(F_->getNodes().size(), numNodes - 1);
+  const auto &stats = FPM.getPassStatistics();
+  ASSERT_EQ(stats.size(), 1);
+  EXPECT_EQ(stats[0].name, "DCE");
+  EXPECT_EQ(stats[0].numRuns, 1);
+  EXPECT_EQ(stats[0].numChanges, 1);
+  EXPECT_EQ(stats[0].sizeDelta, -1);
+
+  auto &events = traceContext.getTraceEvents();
+  ASSERT_EQ(events.size(), 1);
+  const TraceEvent &ev = events.front();
+  EXPECT_EQ(ev.name, "DCE");
+  EXPECT_EQ(ev.type, TraceEvent::CompleteType);
+  EXPECT_EQ(ev.level, TraceLevel::COMPILE);
+  EXPECT_EQ(ev.args.at("sizeBefore"), std::to_string(numNodes));
+  EXPECT_EQ(ev.args.at("sizeAfter"), std::to_string(numNodes - 1));
+
+  // Nothing is collected when the passes are neither timed nor traced.
+  cctx_.traceContext = nullptr;
+  FPM.run(F_, cctx_);
+  EXPECT_TRUE(FPM.getPassStatistics().empty());
+}
@@ -161,3 +161,86 @@ TEST(GraphScheduler, ScheduleQuantizationProfileRightAfterNodeBeingProfiled) {
   // Expect the save node to be the last in the schedule.
   EXPECT_EQ(save, schedule.back());
 }
+
+/// \returns whether \p schedule runs every node of \p F once, after the
+/// nodes it reads.
+static bool isValidSchedule(Function *F, const NodesPtrList &schedule) {
+  if (schedule.size() != F->getNodes().size()) {
+    return false;
+  }
+  for (auto &N : F->getNodes()) {
+    auto it = std::find(schedule.begin(), schedule.end(), &N);
+    if (it == schedule.end()) {
+      return false;
+    }
+    for (unsigned idx = 0, e = N.getNumInputs(); idx < e; ++idx) {
+      Node *input = N.getNthInput(idx).getNode();
+      if (llvm::isa<Storage>(input)) {
+        continue;
+      }
+      if (std::find(schedule.begin(), it, input) == it) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Tests that PeakMemoryBasedScheduler does not keep the large intermediate
+/// results of two branches live at the same time, and that its schedule does
+/// not use more memory than the ones of the other schedulers.
+TEST(GraphScheduler, peakMemoryBasedSchedulesBranchesOneAfterTheOther) {
+  Module MD;
+  auto *input =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 4, 4}, "input", false);
+  Function *F = MD.createFunction("F");
+  Node *tileA = F->createTile("tileA", input, 100, 0);
+  Node *sliceA = F->createSlice("sliceA", tileA, {0, 0, 0}, {1, 4, 4});
+  Node *tileB = F->createTile("tileB", input, 100, 0);
+  Node *sliceB = F->createSlice("sliceB", tileB, {0, 0, 0}, {1, 4, 4});
+  Node *concat = F->createConcat("concat", {sliceA, sliceB}, 0);
+  F->createSave("save", concat);
+
+  NodesPtrList schedule;
+  PeakMemoryBasedScheduler scheduler(*F, schedule);
+  scheduler.schedule();
+  ASSERT_TRUE(isValidSchedule(F, schedule));
+
+  const int64_t tileSize = tileA->getType(0)->getSizeInBytes();
+  const int64_t peak = getSchedulePeakMemory(*F, schedule);
+  EXPECT_LT(peak, 2 * tileSize);
+
+  NodesPtrList childMemSizeSchedule;
+  ChildMemSizeBasedScheduler(*F, childMemSizeSchedule).schedule();
+  EXPECT_LE(peak, getSchedulePeakMemory(*F, childMemSizeSchedule));
+  NodesPtrList topologicalSchedule;
+  TopologicalSortBasedScheduler(*F, topologicalSchedule).schedule();
+  EXPECT_LE(peak, getSchedulePeakMemory(*F, topologicalSchedule));
+}
+
+/// Tests that PeakMemoryBasedScheduler runs a node overwriting a placeholder
+/// after the other readers of the placeholder, even with no search budget.
+TEST(GraphScheduler, peakMemoryBasedHonorsOverwrittenInputs) {
+  Module MD;
+  auto *input1 =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 4, 4}, "input1", false);
+  auto *input2 =
+      MD.createPlaceholder(ElemKind::FloatTy, {1, 4, 4}, "input2", false);
+  Function *F = MD.createFunction("F");
+  Node *add = F->createAdd("add", input1, input2);
+  Node *saveAdd = F->createSave("saveAdd", add, input2);
+  Node *sub = F->createSub("sub", input1, input2);
+  F->createSave("saveSub", sub);
+
+  for (uint64_t budget : {uint64_t(0), uint64_t(1) << 24}) {
+    NodesPtrList schedule;
+    PeakMemoryBasedScheduler scheduler(*F, schedule, budget);
+    scheduler.schedule();
+    ASSERT_TRUE(isValidSchedule(F, schedule));
+    EXPECT_LT(std::distance(schedule.begin(),
+                            std::find(schedule.begin(), schedule.end(), sub)),
+              std::distance(schedule.begin(), std::find(schedule.begin(),
+                                                        schedule.end(),
+                                                        saveAdd)));
+  }
+}
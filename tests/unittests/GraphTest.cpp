@@ -207,6 +207,39 @@ TEST(Graph, testNodeNames) {
   llvm::sys::fs::remove(filePath);
 }
 
+/// Check that the kind tables agree with the node and instruction classes.
+TEST(Graph, kindInfo) {
+  Module MD;
+  Function *F = MD.createFunction("F");
+  auto *A = MD.createPlaceholder(ElemKind::FloatTy, {4, 8}, "A", false);
+  auto *B = MD.createPlaceholder(ElemKind::FloatTy, {4, 8}, "B", false);
+  auto *add = F->createAdd("add", A, B);
+  auto *concat = F->createConcat("concat", {A, B, add}, 0);
+  auto *save = F->createSave("save", concat);
+
+  EXPECT_EQ(add->getNumInputs(), AddNode::getKindInfo().numFixedInputs);
+  EXPECT_TRUE(Node::getNodeKindInfo(add->getKind()).isDataParallel);
+  EXPECT_TRUE(static_cast<Node *>(add)->isDataParallel());
+  EXPECT_FALSE(static_cast<Node *>(add)->hasSideEffects());
+  EXPECT_TRUE(ConcatNode::getKindInfo().hasVariadicInputs);
+  EXPECT_EQ(static_cast<Node *>(concat)->getNumInputs(), 3);
+  EXPECT_TRUE(static_cast<Node *>(save)->hasSideEffects());
+  EXPECT_EQ(static_cast<Node *>(A)->getNumInputs(), 0);
+  EXPECT_TRUE(static_cast<Node *>(A)->isCanonical());
+
+  IRFunction M(F);
+  M.generateIR(MockBackend());
+  for (const auto &I : M.getInstrs()) {
+    const InstrKindInfo &info = Instruction::getInstrKindInfo(I.getKind());
+    EXPECT_EQ(I.getNumFixedOperands(), info.numFixedOperands);
+    if (const auto *EA = llvm::dyn_cast<ElementAddInst>(&I)) {
+      EXPECT_TRUE(EA->isDataParallel());
+      EXPECT_EQ(info.numFixedOperands, 3);
+      EXPECT_TRUE(static_cast<const Instruction *>(EA)->isDataParallel());
+    }
+  }
+}
+
 /// Check that a createConv3D can be run.
 TEST(Graph, simpleTestConv3D) {
   Module MD;
@@ -731,7 +764,7 @@ TEST(Graph, useListIteration) {
   // Check that the first user of K is conv1.
   EXPECT_EQ(K->getUsers().begin()->getUser(), conv1);
   // Check that the second user of K is conv2.
-  EXPECT_EQ((++K->getUsers().begin())->getUser(), conv2);
+  EXPECT_EQ(std::next(K->getUsers().begin())->getUser(), conv2);
 }
 
 TEST(Graph, simpleTestFC) {
@@ -1772,6 +1805,31 @@ TEST(Graph, verifyConstantNoWriters) {
   EXPECT_FALSE(M.verify());
 }
 
+/// Check that verifyNodes() only checks the given nodes, and that functions
+/// large enough to be verified on several threads are verified.
+TEST(Graph, verifyNodes) {
+  Module M;
+  auto *F = M.createFunction("main");
+  auto *G = M.createFunction("other");
+  auto *input = M.createPlaceholder(ElemKind::FloatTy, {5}, "input", false);
+  auto *first = F->createTanh("tanh0", input);
+  NodeValue cur = first;
+  for (unsigned i = 1; i < 5000; i++) {
+    cur = F->createTanh("tanh" + std::to_string(i), cur);
+  }
+  auto *relu = F->createRELU("relu", cur);
+  F->createSave("save", relu);
+  EXPECT_TRUE(F->verify());
+  EXPECT_TRUE(F->verifyNodes({relu}));
+
+  // Make the ReLU use a node of another function.
+  auto *other = G->createTanh("other", input);
+  relu->setNthInput(ReluNode::InputIdx, other);
+  EXPECT_FALSE(F->verifyNodes({relu}));
+  EXPECT_TRUE(F->verifyNodes({first}));
+  EXPECT_FALSE(F->verify());
+}
+
 TEST(Graph, typeUnsafeReplaceAllUsesOfWith) {
   Module M;
   auto *F = M.createFunction("main");
@@ -2645,3 +2703,33 @@ TEST(Graph, testFusionGroupNodeChain) {
   EXPECT_GT(M.getInstrs().size(), 0);
   llvm::sys::fs::remove(filePath);
 }
+
+/// Check that the identical payloads of the Constants of two Modules are kept
+/// once, and are copied again when modified.
+TEST(Graph, shareConstantPayloads) {
+  Module M1, M2;
+  PseudoRNG PRNG;
+  Tensor T(ElemKind::FloatTy, {4, 8});
+  T.getHandle().randomize(-1.0, 1.0, PRNG);
+  auto *C1 = M1.createConstant("C", T.clone());
+  auto *C2 = M2.createConstant("C", T.clone());
+  auto *C3 = M2.createConstant(ElemKind::FloatTy, {4, 8}, "other");
+  C3->getPayloadMutable().zero();
+  EXPECT_NE(C1->getPayload().getUnsafePtr(), C2->getPayload().getUnsafePtr());
+
+  M1.shareConstantPayloads();
+  M2.shareConstantPayloads();
+  EXPECT_TRUE(C1->isPayloadShared());
+  EXPECT_TRUE(C2->isPayloadShared());
+  EXPECT_TRUE(C3->isPayloadShared());
+  EXPECT_EQ(C1->getPayload().getUnsafePtr(), C2->getPayload().getUnsafePtr());
+  EXPECT_NE(C1->getPayload().getUnsafePtr(), C3->getPayload().getUnsafePtr());
+  EXPECT_TRUE(C2->getPayload().isEqual(T));
+
+  // Modifying a shared payload leaves the other Constants untouched.
+  C1->getPayloadMutable().getHandle().raw(0) += 1;
+  EXPECT_FALSE(C1->isPayloadShared());
+  EXPECT_NE(C1->getPayload().getUnsafePtr(), C2->getPayload().getUnsafePtr());
+  EXPECT_TRUE(C2->getPayload().isEqual(T));
+  EXPECT_FALSE(C1->getPayload().isEqual(T));
+}
@@ -19,9 +19,14 @@
 #include "glow/Flags/Flags.h"
 #include "glow/Runtime/HostManager/HostManager.h"
 
+#include "llvm/Support/FileSystem.h"
+
 #include "gtest/gtest.h"
 
+#include <algorithm>
 #include <future>
+#include <map>
+#include <mutex>
 #include <thread>
 
 using namespace glow;
@@ -214,6 +219,47 @@ TEST_P(HostManagerTest, runNetwork) {
   EXPECT_FALSE(ERR_TO_BOOL(std::move(*DCHECK_NOTNULL(runErr.get()))));
 }
 
+/// Test that the output ready callback is notified of every output of the run
+/// before the result callback.
+TEST_P(HostManagerTest, outputReadyCallback) {
+  CHECK_IF_ENABLED();
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  auto context = glow::make_unique<ExecutionContext>();
+
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  context->getPlaceholderBindings()->allocate(X)->getHandle() = {1., 2., 3.};
+  auto *square = F->createSave("square", F->createPow("Pow2", X, 2.0));
+  auto *cube = F->createSave("cube", F->createPow("Pow3", X, 3.0));
+  context->getPlaceholderBindings()->allocate(square->getPlaceholder());
+  context->getPlaceholderBindings()->allocate(cube->getPlaceholder());
+
+  std::mutex outputsMutex;
+  std::map<std::string, std::vector<float>> outputs;
+  context->setOutputReadyCallback([&](const Placeholder *PH, Tensor &T) {
+    std::lock_guard<std::mutex> lock(outputsMutex);
+    outputs[PH->getName().str()] = std::vector<float>(
+        T.getHandle().begin(), T.getHandle().end());
+  });
+
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  std::promise<size_t> outputsAtResult;
+  auto ready = outputsAtResult.get_future();
+  hostManager->runNetwork(
+      "main", std::move(context),
+      [&](RunIdentifierTy, Error err, std::unique_ptr<ExecutionContext>) {
+        EXPECT_FALSE(ERR_TO_BOOL(std::move(err)));
+        std::lock_guard<std::mutex> lock(outputsMutex);
+        outputsAtResult.set_value(outputs.size());
+      });
+  EXPECT_EQ(ready.get(), 2);
+  EXPECT_EQ(outputs["square"], std::vector<float>({1., 4., 9.}));
+  EXPECT_EQ(outputs["cube"], std::vector<float>({1., 8., 27.}));
+}
+
 /// Test that HostManager properly handles concurrent add/remove requests with
 /// unique network names.
 TEST_P(HostManagerTest, ConcurrentAddRemoveUnique) {
@@ -959,4 +1005,568 @@ TEST_P(HostManagerTest, testTimeout) {
   EXPECT_TRUE(ERR_TO_BOOL(std::move(*DCHECK_NOTNULL(runErr.get()))));
 }
 
+/// Test that requests smaller than the compiled batch size are combined into a
+/// single run when request batching is enabled, both when the batch fills up
+/// and when the oldest request times out.
+TEST_P(HostManagerTest, requestBatching) {
+  CHECK_IF_ENABLED();
+  constexpr dim_t batchSize = 4;
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X =
+      module->createPlaceholder(ElemKind::FloatTy, {batchSize, 3}, "X", false);
+  auto *pow = F->createPow("Pow1", X, 2.0);
+  auto *save = F->createSave("save", pow);
+  auto *output = save->getPlaceholder();
+
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  RequestBatchingConfig config;
+  config.maxWaitUs = 1000;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->setRequestBatching("main", config)));
+
+  // One full batch followed by a single request that only gets submitted once
+  // it times out.
+  constexpr unsigned numRequests = batchSize + 1;
+  std::vector<std::promise<void>> promises(numRequests);
+  std::vector<std::unique_ptr<ExecutionContext>> results(numRequests);
+  std::vector<std::unique_ptr<Error>> errors(numRequests);
+  for (unsigned i = 0; i < numRequests; i++) {
+    auto context = glow::make_unique<ExecutionContext>();
+    auto *bindings = context->getPlaceholderBindings();
+    bindings->insert(X, Tensor(ElemKind::FloatTy, {1, 3}));
+    bindings->get(X)->getHandle() = {float(i), float(i + 1), float(i + 2)};
+    bindings->insert(output, Tensor(ElemKind::FloatTy, {1, 3}));
+    hostManager->runNetwork(
+        "main", std::move(context),
+        [i, &promises, &results, &errors](
+            RunIdentifierTy, Error err,
+            std::unique_ptr<ExecutionContext> context) {
+          results[i] = std::move(context);
+          errors[i] = glow::make_unique<Error>(std::move(err));
+          promises[i].set_value();
+        });
+  }
+
+  for (unsigned i = 0; i < numRequests; i++) {
+    promises[i].get_future().wait();
+    EXPECT_FALSE(ERR_TO_BOOL(std::move(*DCHECK_NOTNULL(errors[i].get()))));
+    auto *resultT = results[i]->getPlaceholderBindings()->get(output);
+    ASSERT_TRUE(resultT);
+    ASSERT_EQ(resultT->dims()[0], 1);
+    auto H = resultT->getHandle();
+    for (dim_t j = 0; j < 3; j++) {
+      EXPECT_NEAR(H.at({0, j}), float((i + j) * (i + j)), 1E-5);
+    }
+  }
+
+  // Batching can be turned off again once nothing is outstanding.
+  EXPECT_FALSE(
+      ERR_TO_BOOL(hostManager->setRequestBatching("main", llvm::None)));
+}
+
+/// Test that a request whose deadline has already passed is refused, and that
+/// one with a deadline that can be met runs normally.
+TEST_P(HostManagerTest, requestDeadline) {
+  CHECK_IF_ENABLED();
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  auto *pow = F->createPow("Pow1", X, 2.0);
+  auto *save = F->createSave("save", pow);
+
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  auto runWithDeadline = [&](uint64_t deadline) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->getPlaceholderBindings()->allocate(X)->getHandle() = {1., 2., 3.};
+    context->getPlaceholderBindings()->allocate(save->getPlaceholder());
+    std::promise<void> runPromise;
+    auto fut = runPromise.get_future();
+    std::unique_ptr<Error> runErr;
+    hostManager->runNetwork(
+        "main", std::move(context),
+        [&runPromise, &runErr](RunIdentifierTy, Error err,
+                               std::unique_ptr<ExecutionContext>) {
+          runErr = glow::make_unique<Error>(std::move(err));
+          runPromise.set_value();
+        },
+        /* priority */ 0, deadline);
+    fut.wait();
+    return std::move(*DCHECK_NOTNULL(runErr.get()));
+  };
+
+  Error expired = runWithDeadline(1);
+  ASSERT_TRUE(expired.peekErrorValue());
+  EXPECT_EQ(expired.peekErrorValue()->getErrorCode(),
+            ErrorValue::ErrorCode::RUNTIME_REQUEST_REFUSED);
+  ERR_TO_BOOL(std::move(expired));
+
+  // A minute is plenty of time for a single Pow.
+  EXPECT_FALSE(ERR_TO_BOOL(runWithDeadline(TraceEvent::now() + 60000000)));
+}
+
+/// Test that a request cancelled before it is dispatched is dropped, and that
+/// a token that isn't cancelled doesn't affect the run.
+TEST_P(HostManagerTest, requestCancellation) {
+  CHECK_IF_ENABLED();
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  auto *pow = F->createPow("Pow1", X, 2.0);
+  auto *save = F->createSave("save", pow);
+
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  auto runWithToken = [&](std::shared_ptr<CancellationToken> token) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->getPlaceholderBindings()->allocate(X)->getHandle() = {1., 2., 3.};
+    context->getPlaceholderBindings()->allocate(save->getPlaceholder());
+    std::promise<void> runPromise;
+    auto fut = runPromise.get_future();
+    std::unique_ptr<Error> runErr;
+    hostManager->runNetwork(
+        "main", std::move(context),
+        [&runPromise, &runErr](RunIdentifierTy, Error err,
+                               std::unique_ptr<ExecutionContext>) {
+          runErr = glow::make_unique<Error>(std::move(err));
+          runPromise.set_value();
+        },
+        /* priority */ 0, /* deadline */ 0, std::move(token));
+    fut.wait();
+    return std::move(*DCHECK_NOTNULL(runErr.get()));
+  };
+
+  auto token = std::make_shared<CancellationToken>();
+  EXPECT_FALSE(ERR_TO_BOOL(runWithToken(token)));
+
+  token->cancel();
+  Error cancelled = runWithToken(token);
+  ASSERT_TRUE(cancelled.peekErrorValue());
+  EXPECT_EQ(cancelled.peekErrorValue()->getErrorCode(),
+            ErrorValue::ErrorCode::RUNTIME_REQUEST_CANCELLED);
+  ERR_TO_BOOL(std::move(cancelled));
+
+  // The HostManager is still usable after dropping a request.
+  EXPECT_FALSE(ERR_TO_BOOL(runWithToken(nullptr)));
+}
+
+/// Test that queued requests of different networks are dispatched in
+/// proportion to the networks' scheduling weights.
+TEST_P(HostManagerTest, fairShareScheduling) {
+  CHECK_IF_ENABLED();
+  HostConfig config;
+  // Only one request runs at a time so that completion order is dispatch
+  // order.
+  config.maxActiveRequests = 1;
+  auto hostManager = createHostManager(backendName_, std::move(config));
+  ASSERT_FALSE(ERR_TO_BOOL(addNetwork(hostManager.get(), "heavy")));
+  ASSERT_FALSE(ERR_TO_BOOL(addNetwork(hostManager.get(), "light")));
+
+  NetworkSchedulingConfig heavyConfig;
+  heavyConfig.weight = 4;
+  ASSERT_FALSE(
+      ERR_TO_BOOL(hostManager->setNetworkScheduling("heavy", heavyConfig)));
+  EXPECT_TRUE(ERR_TO_BOOL(
+      hostManager->setNetworkScheduling("missing", heavyConfig)));
+  heavyConfig.weight = 0;
+  EXPECT_TRUE(
+      ERR_TO_BOOL(hostManager->setNetworkScheduling("heavy", heavyConfig)));
+
+  // Block the only active slot so everything below gets queued.
+  std::promise<void> release;
+  auto releaseFuture = release.get_future().share();
+  std::promise<void> blockerDone;
+  hostManager->runNetwork(
+      "heavy", glow::make_unique<ExecutionContext>(),
+      [releaseFuture, &blockerDone](RunIdentifierTy, Error err,
+                                    std::unique_ptr<ExecutionContext>) {
+        EXIT_ON_ERR(std::move(err));
+        blockerDone.set_value();
+        releaseFuture.wait();
+      });
+
+  constexpr unsigned numRequests = 8;
+  std::mutex orderMutex;
+  std::vector<std::string> order;
+  std::vector<std::promise<void>> done(2 * numRequests);
+  for (unsigned i = 0; i < 2 * numRequests; i++) {
+    std::string name = i % 2 ? "light" : "heavy";
+    hostManager->runNetwork(
+        name, glow::make_unique<ExecutionContext>(),
+        [name, i, &orderMutex, &order, &done](
+            RunIdentifierTy, Error err, std::unique_ptr<ExecutionContext>) {
+          EXIT_ON_ERR(std::move(err));
+          {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(name);
+          }
+          done[i].set_value();
+        });
+  }
+  blockerDone.get_future().wait();
+  release.set_value();
+  for (auto &p : done) {
+    p.get_future().wait();
+  }
+
+  // The heavy network gets four dispatches for every one of the light one.
+  // It already used one on the blocker, so light goes first and heavy gets
+  // the next three.
+  ASSERT_EQ(order.size(), 2 * numRequests);
+  EXPECT_EQ(order[0], "light");
+  EXPECT_EQ(std::count(order.begin(), order.begin() + 4, "heavy"), 3);
+}
+
+/// Test that replaceNetwork() swaps in a new version of a network under the
+/// same name, and that requests run on the new version afterwards.
+TEST_P(HostManagerTest, replaceNetwork) {
+  CHECK_IF_ENABLED();
+  auto hostManager = createHostManager(backendName_);
+
+  // \returns a module computing X to the power of \p exp into "save".
+  auto makeModule = [](float exp) {
+    auto module = glow::make_unique<Module>();
+    Function *F = module->createFunction("main");
+    auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+    F->createSave("save", F->createPow("Pow", X, exp));
+    return module;
+  };
+  // \returns the result of running "main" on {1, 2, 3}.
+  auto runMain = [&]() {
+    Module *module =
+        EXIT_ON_ERR(hostManager->getNetworkDAG("main"))->root->module;
+    auto context = glow::make_unique<ExecutionContext>();
+    auto *bindings = context->getPlaceholderBindings();
+    bindings->allocate(module->getPlaceholderByNameSlow("X"))->getHandle() = {
+        1., 2., 3.};
+    auto *saveTensor =
+        bindings->allocate(module->getPlaceholderByNameSlow("save"));
+    EXPECT_FALSE(ERR_TO_BOOL(hostManager->runNetworkBlocking("main", context)));
+    return std::vector<float>(saveTensor->getHandle().begin(),
+                              saveTensor->getHandle().end());
+  };
+
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(makeModule(2.0), cctx)));
+  EXPECT_EQ(runMain(), std::vector<float>({1., 4., 9.}));
+
+  CompilationContext replaceCctx;
+  ASSERT_FALSE(ERR_TO_BOOL(
+      hostManager->replaceNetwork("main", makeModule(3.0), replaceCctx)));
+  EXPECT_TRUE(hostManager->networkAdded("main"));
+  EXPECT_EQ(runMain(), std::vector<float>({1., 8., 27.}));
+
+  // Replacing again swaps out the version added by replaceNetwork().
+  ASSERT_FALSE(ERR_TO_BOOL(
+      hostManager->replaceNetwork("main", makeModule(1.0), replaceCctx)));
+  EXPECT_EQ(runMain(), std::vector<float>({1., 2., 3.}));
+
+  // A network that doesn't exist can't be replaced.
+  EXPECT_TRUE(ERR_TO_BOOL(
+      hostManager->replaceNetwork("other", makeModule(2.0), replaceCctx)));
+
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->removeNetwork("main")));
+  EXPECT_FALSE(hostManager->networkAdded("main"));
+}
+
+/// Test that a network added for several batch sizes runs requests of any
+/// number of rows up to the largest one on the smallest batch size fitting
+/// them.
+TEST_P(HostManagerTest, shapeBucketedNetwork) {
+  CHECK_IF_ENABLED();
+  auto hostManager = createHostManager(backendName_);
+
+  std::vector<dim_t> builtSizes;
+  auto buildModule =
+      [&](dim_t batchSize) -> Expected<std::unique_ptr<Module>> {
+    builtSizes.push_back(batchSize);
+    auto module = glow::make_unique<Module>();
+    Function *F = module->createFunction("main");
+    auto *X = module->createPlaceholder(ElemKind::FloatTy, {batchSize, 2},
+                                        "X", false);
+    F->createSave("save", F->createPow("Pow", X, 2.0));
+    return std::move(module);
+  };
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(
+      hostManager->addShapeBucketedNetwork("main", {4, 2}, buildModule, cctx)));
+  EXPECT_EQ(builtSizes, std::vector<dim_t>({2, 4}));
+  EXPECT_TRUE(hostManager->networkAdded("main"));
+  EXPECT_TRUE(hostManager->networkAdded("main__b2"));
+  EXPECT_TRUE(hostManager->networkAdded("main__b4"));
+  // The name of the network can't be reused.
+  EXPECT_TRUE(ERR_TO_BOOL(
+      hostManager->addShapeBucketedNetwork("main", {8}, buildModule, cctx)));
+
+  // getNetworkDAG() gives the Placeholders of the largest batch size.
+  Module *module =
+      EXIT_ON_ERR(hostManager->getNetworkDAG("main"))->root->module;
+  auto run = [&](dim_t rows, std::vector<float> &result) {
+    auto context = glow::make_unique<ExecutionContext>();
+    auto *bindings = context->getPlaceholderBindings();
+    Tensor X(ElemKind::FloatTy, {rows, 2});
+    for (dim_t i = 0; i < X.size(); i++) {
+      X.getHandle().raw(i) = i + 1;
+    }
+    bindings->insert(module->getPlaceholderByNameSlow("X"), std::move(X));
+    bindings->insert(module->getPlaceholderByNameSlow("save"),
+                     Tensor(ElemKind::FloatTy, {rows, 2}));
+    Error err = hostManager->runNetworkBlocking("main", context);
+    Tensor *save = context->getPlaceholderBindings()->get(
+        module->getPlaceholderByNameSlow("save"));
+    result = std::vector<float>(save->getHandle().begin(),
+                                save->getHandle().end());
+    return err;
+  };
+
+  std::vector<float> result;
+  ASSERT_FALSE(ERR_TO_BOOL(run(1, result)));
+  EXPECT_EQ(result, std::vector<float>({1., 4.}));
+  ASSERT_FALSE(ERR_TO_BOOL(run(3, result)));
+  EXPECT_EQ(result, std::vector<float>({1., 4., 9., 16., 25., 36.}));
+  ASSERT_FALSE(ERR_TO_BOOL(run(4, result)));
+  EXPECT_EQ(result.size(), 8u);
+  EXPECT_EQ(result.back(), 64.);
+  // No batch size fits 5 rows.
+  EXPECT_TRUE(ERR_TO_BOOL(run(5, result)));
+
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->removeNetwork("main")));
+  EXPECT_FALSE(hostManager->networkAdded("main"));
+  EXPECT_FALSE(hostManager->networkAdded("main__b2"));
+  EXPECT_FALSE(hostManager->networkAdded("main__b4"));
+}
+
+/// Test that a sequence loop network runs its cell once per step of each
+/// request, carrying the state from one step to the next.
+TEST_P(HostManagerTest, sequenceLoopNetwork) {
+  CHECK_IF_ENABLED();
+  auto hostManager = createHostManager(backendName_);
+
+  // Hout = Hin + X, Y = Hout * W.
+  auto module = glow::make_unique<Module>();
+  Function *F = module->createFunction("cell");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {2}, "X", false);
+  auto *Hin = module->createPlaceholder(ElemKind::FloatTy, {2}, "Hin", false);
+  auto *Hout = module->createPlaceholder(ElemKind::FloatTy, {2}, "Hout", false);
+  auto *W = module->createPlaceholder(ElemKind::FloatTy, {2}, "W", false);
+  auto *add = F->createAdd("add", Hin, X);
+  F->createSave("saveH", add, Hout);
+  F->createSave("saveY", F->createMul("mul", add, W));
+  SequenceLoopConfig config;
+  config.stepInputs = {"X"};
+  config.stepOutputs = {"saveY"};
+  config.states = {{"Hin", "Hout"}};
+  config.maxSteps = 4;
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addSequenceLoopNetwork(
+      "main", std::move(module), config, cctx)));
+  EXPECT_TRUE(hostManager->networkAdded("main"));
+  EXPECT_TRUE(hostManager->networkAdded("main__cell"));
+
+  Module *cell = EXIT_ON_ERR(hostManager->getNetworkDAG("main"))->root->module;
+  auto run = [&](dim_t steps, std::vector<float> &Y, std::vector<float> &H) {
+    auto context = glow::make_unique<ExecutionContext>();
+    auto *bindings = context->getPlaceholderBindings();
+    Tensor XT(ElemKind::FloatTy, {steps, 2});
+    for (dim_t i = 0; i < XT.size(); i++) {
+      XT.getHandle().raw(i) = i + 1;
+    }
+    bindings->insert(cell->getPlaceholderByNameSlow("X"), std::move(XT));
+    bindings->insert(cell->getPlaceholderByNameSlow("saveY"),
+                     Tensor(ElemKind::FloatTy, {steps, 2}));
+    bindings->allocate(cell->getPlaceholderByNameSlow("Hin"))->getHandle() = {
+        10., 20.};
+    bindings->allocate(cell->getPlaceholderByNameSlow("W"))->getHandle() = {
+        1., -1.};
+    Tensor *HT = bindings->allocate(cell->getPlaceholderByNameSlow("Hout"));
+    Error err = hostManager->runNetworkBlocking("main", context);
+    bindings = context->getPlaceholderBindings();
+    Tensor *YT = bindings->get(cell->getPlaceholderByNameSlow("saveY"));
+    Y = std::vector<float>(YT->getHandle().begin(), YT->getHandle().end());
+    H = std::vector<float>(HT->getHandle().begin(), HT->getHandle().end());
+    return err;
+  };
+
+  std::vector<float> Y;
+  std::vector<float> H;
+  ASSERT_FALSE(ERR_TO_BOOL(run(1, Y, H)));
+  EXPECT_EQ(Y, std::vector<float>({11., -22.}));
+  EXPECT_EQ(H, std::vector<float>({11., 22.}));
+  ASSERT_FALSE(ERR_TO_BOOL(run(3, Y, H)));
+  EXPECT_EQ(Y, std::vector<float>({11., -22., 14., -26., 19., -32.}));
+  EXPECT_EQ(H, std::vector<float>({19., 32.}));
+  // Without steps the final state is the initial one.
+  ASSERT_FALSE(ERR_TO_BOOL(run(0, Y, H)));
+  EXPECT_EQ(H, std::vector<float>({10., 20.}));
+  // Sequences are at most 4 steps long.
+  EXPECT_TRUE(ERR_TO_BOOL(run(5, Y, H)));
+
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->removeNetwork("main")));
+  EXPECT_FALSE(hostManager->networkAdded("main"));
+  EXPECT_FALSE(hostManager->networkAdded("main__cell"));
+}
+
+/// Test that a network added again from the snapshot written when it was
+/// first added computes the same results.
+TEST_P(HostManagerTest, networkSnapshot) {
+  CHECK_IF_ENABLED();
+  llvm::SmallString<64> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("snapshot", dir));
+
+  // \returns the result of running "main" of \p hostManager on {1, 2, 3}.
+  auto runMain = [](HostManager &hostManager) {
+    Module *module =
+        EXIT_ON_ERR(hostManager.getNetworkDAG("main"))->root->module;
+    auto context = glow::make_unique<ExecutionContext>();
+    auto *bindings = context->getPlaceholderBindings();
+    bindings->allocate(module->getPlaceholderByNameSlow("X"))->getHandle() = {
+        1., 2., 3.};
+    auto *saveTensor =
+        bindings->allocate(module->getPlaceholderByNameSlow("save"));
+    EXPECT_FALSE(ERR_TO_BOOL(hostManager.runNetworkBlocking("main", context)));
+    return std::vector<float>(saveTensor->getHandle().begin(),
+                              saveTensor->getHandle().end());
+  };
+
+  {
+    auto module = glow::make_unique<Module>();
+    Function *F = module->createFunction("main");
+    auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+    auto *W = module->createConstant(ElemKind::FloatTy, {3}, "W");
+    W->getPayloadMutable().getHandle() = {10., 20., 30.};
+    F->createSave("save", F->createAdd("add", F->createPow("pow", X, 2.0), W));
+    auto hostManager = createHostManager(backendName_);
+    CompilationContext cctx;
+    cctx.networkSnapshotDir = dir.str().str();
+    ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+    EXPECT_EQ(runMain(*hostManager), std::vector<float>({11., 24., 39.}));
+  }
+
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetworkFromSnapshot(dir, cctx)));
+  EXPECT_EQ(runMain(*hostManager), std::vector<float>({11., 24., 39.}));
+
+  // There is no snapshot in a directory without the files.
+  llvm::SmallString<64> emptyDir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("snapshot", emptyDir));
+  CompilationContext emptyCctx;
+  EXPECT_TRUE(ERR_TO_BOOL(
+      createHostManager(backendName_)->addNetworkFromSnapshot(emptyDir,
+                                                              emptyCctx)));
+  llvm::sys::fs::remove_directories(dir);
+  llvm::sys::fs::remove_directories(emptyDir);
+}
+
+/// Test that the contexts of an ExecutionContextPool run the network and give
+/// their tensors back to the pool when done with. The tensors are IO buffers
+/// of the device of the network.
+TEST_P(HostManagerTest, executionContextPool) {
+  CHECK_IF_ENABLED();
+  auto module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  F->createSave("save", F->createPow("pow", X, 2.0));
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  EXPECT_TRUE(ERR_TO_BOOL(
+      hostManager->createExecutionContextPool("missing", 2).takeError()));
+  auto pool = EXIT_ON_ERR(hostManager->createExecutionContextPool("main", 2));
+  EXPECT_EQ(pool->getPlaceholders().size(), 2);
+  Module *M = EXIT_ON_ERR(hostManager->getNetworkDAG("main"))->root->module;
+  for (unsigned i = 0; i < 4; i++) {
+    auto context = pool->get();
+    auto *bindings = context->getPlaceholderBindings();
+    bindings->get(M->getPlaceholderByNameSlow("X"))->getHandle() = {
+        1., 2., float(i)};
+    auto *saveTensor = bindings->get(M->getPlaceholderByNameSlow("save"));
+    ASSERT_TRUE(saveTensor);
+    EXPECT_TRUE(saveTensor->isUnowned());
+    EXPECT_FALSE(ERR_TO_BOOL(hostManager->runNetworkBlocking("main", context)));
+    auto H = saveTensor->getHandle();
+    EXPECT_NEAR(H.at({0}), 1, 1E-5);
+    EXPECT_NEAR(H.at({1}), 4, 1E-5);
+    EXPECT_NEAR(H.at({2}), i * i, 1E-5);
+  }
+  // The tensors of the released contexts are reused.
+  EXPECT_EQ(pool->getStats().totalAllocs, 4);
+  EXPECT_EQ(pool->getStats().inlineAllocs, 0);
+}
+
+/// A partition on a device marked unhealthy is added to the other device from
+/// its compiled function and runs there, and new networks avoid the device.
+TEST_P(HostManagerTest, deviceFailover) {
+  CHECK_IF_ENABLED();
+  auto hostManager = glow::make_unique<HostManager>(
+      generateConfigs(backendName_, 2), HostConfig());
+  ASSERT_FALSE(ERR_TO_BOOL(addNetwork(hostManager.get(), "main")));
+  DAG *dag = EXIT_ON_ERR(hostManager->getNetworkDAG("main"));
+  DAGNode *node = dag->nodes[0].get();
+  ASSERT_EQ(node->deviceRuntimeInfos.size(), 1);
+  DeviceIDTy failed = node->deviceRuntimeInfos.begin()->first;
+
+  EXPECT_TRUE(ERR_TO_BOOL(hostManager->markDeviceUnhealthy(2)));
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->markDeviceUnhealthy(failed)));
+  ASSERT_EQ(node->deviceRuntimeInfos.size(), 2);
+  EXPECT_FALSE(node->deviceRuntimeInfos[failed].available);
+
+  Module *M = dag->root->module;
+  auto context = glow::make_unique<ExecutionContext>();
+  auto *bindings = context->getPlaceholderBindings();
+  bindings->allocate(M->getPlaceholderByNameSlow("X_main"))->getHandle() = {
+      1., 2., 3.};
+  Tensor *result = bindings->allocate(M->getPlaceholderByNameSlow("savemain"));
+  EXPECT_FALSE(ERR_TO_BOOL(hostManager->runNetworkBlocking("main", context)));
+  EXPECT_NEAR(result->getHandle().at({2}), 9, 1E-5);
+
+  ASSERT_FALSE(ERR_TO_BOOL(addNetwork(hostManager.get(), "other")));
+  DAG *otherDag = EXIT_ON_ERR(hostManager->getNetworkDAG("other"));
+  EXPECT_EQ(otherDag->nodes[0]->deviceRuntimeInfos.count(failed), 0);
+
+  EXPECT_FALSE(ERR_TO_BOOL(hostManager->markDeviceHealthy(failed)));
+  EXPECT_TRUE(node->deviceRuntimeInfos[failed].available);
+}
+
+/// The memory of a network is accounted to it and to its device.
+TEST_P(HostManagerTest, memoryUsage) {
+  CHECK_IF_ENABLED();
+  auto module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {16}, "X", false);
+  auto *C = module->createConstant(ElemKind::FloatTy, {16}, "C");
+  C->getPayloadMutable().getHandle().clear(2.0);
+  F->createSave("save", F->createAdd("add", X, C));
+  auto hostManager = createHostManager(backendName_);
+  CompilationContext cctx;
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->addNetwork(std::move(module), cctx)));
+
+  EXPECT_TRUE(
+      ERR_TO_BOOL(hostManager->getNetworkMemoryUsage("missing").takeError()));
+  auto usage = EXIT_ON_ERR(hostManager->getNetworkMemoryUsage("main"));
+  EXPECT_GE(usage.constantBytes, 16 * sizeof(float));
+  EXPECT_GE(usage.mutableWeightBytes, 2 * 16 * sizeof(float));
+  ASSERT_EQ(usage.deviceBytes.count(0), 1);
+  EXPECT_EQ(usage.deviceBytes[0], usage.constantBytes +
+                                      usage.mutableWeightBytes +
+                                      usage.activationBytes);
+
+  auto devices = hostManager->getDeviceMemoryUsage();
+  ASSERT_EQ(devices.count(0), 1);
+  EXPECT_EQ(devices[0].networkBytes, usage.deviceBytes[0]);
+  EXPECT_EQ(devices[0].usedBytes,
+            devices[0].maximumBytes - devices[0].availableBytes);
+
+  ASSERT_FALSE(ERR_TO_BOOL(hostManager->removeNetwork("main")));
+  EXPECT_EQ(hostManager->getDeviceMemoryUsage()[0].networkBytes, 0);
+}
+
 INSTANTIATE_BACKEND_TEST(HostManagerTest);
@@ -129,6 +129,38 @@ TEST(Optimizer, shareBuffers) {
   EXPECT_EQ(M.getInstrs().size(), 2);
 }
 
+/// Check that buffers are shared by the operands of an element-wise
+/// instruction which only differ by their quantization parameters.
+TEST(Optimizer, shareBuffersWithDifferentQuantizationParams) {
+  Module mod;
+  Function *F = mod.createFunction("ShareBuffers");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *input =
+      bb.createWeightVar(glow::ElemKind::Int8QTy, {10}, 0.1, 0, "input",
+                         WeightVar::MutabilityKind::Constant);
+  auto *output =
+      bb.createWeightVar(glow::ElemKind::Int8QTy, {10}, 0.2, 0, "output",
+                         WeightVar::MutabilityKind::Mutable);
+
+  auto *alloc = bb.createAllocActivationInst(
+      "alloc", mod.uniqueType(glow::ElemKind::Int8QTy, {10}, 0.1, 0));
+  bb.createElementAddInst("elem_add1", alloc, input, input);
+  // alloc is not live after this instruction.
+  bb.createElementAddInst("elem_add2", output, alloc, input);
+  bb.createDeallocActivationInst("dealloc", alloc);
+
+  optimize(M, MockBackend().shouldShareBuffers());
+
+  // alloc is replaced by a view of output.
+  auto &instrs = M.getInstrs();
+  EXPECT_TRUE(std::none_of(instrs.begin(), instrs.end(),
+                           [](const Instruction &I) -> bool {
+                             return isa<AllocActivationInst>(&I);
+                           }));
+}
+
 TEST(Optimizer, deleteDeadViews) {
   Module mod;
   Function *F = mod.createFunction("DeleteDeadViews");
@@ -494,6 +526,96 @@ TEST(Optimizer, twoInsertsWithBuffersOptimizer) {
       }));
 }
 
+/// Check that an inserted buffer with other readers than the InsertTensor is
+/// replaced by a TensorView into the destination.
+TEST(Optimizer, insertOfBufferWithOtherReadersOptimizer) {
+  Module mod;
+  Function *F = mod.createFunction("InsertOfBufferWithOtherReaders");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *input = bb.createWeightVar(glow::ElemKind::FloatTy, {2, 5}, "input",
+                                   WeightVar::MutabilityKind::Constant);
+  auto *output1 =
+      bb.createWeightVar(glow::ElemKind::FloatTy, {4, 5}, "output1",
+                         WeightVar::MutabilityKind::Mutable);
+  auto *output2 =
+      bb.createWeightVar(glow::ElemKind::FloatTy, {2, 5}, "output2",
+                         WeightVar::MutabilityKind::Mutable);
+
+  auto *allocSrc1 = bb.createAllocActivationInst(
+      "allocSrc1", glow::ElemKind::FloatTy, {2, 5});
+  auto *allocSrc2 = bb.createAllocActivationInst(
+      "allocSrc2", glow::ElemKind::FloatTy, {2, 5});
+  auto *allocDest = bb.createAllocActivationInst(
+      "allocDest", glow::ElemKind::FloatTy, {4, 5});
+
+  bb.createSplatInst("splatSrc1", allocSrc1, 1.0);
+  bb.createElementAddInst("addSrc1", allocSrc1, allocSrc1, input);
+  bb.createSplatInst("splatSrc2", allocSrc2, 2.0);
+  bb.createInsertTensorInst("insert1", allocDest, allocSrc1, {0, 0}, 1, 0);
+  bb.createInsertTensorInst("insert2", allocDest, allocSrc2, {2, 0}, 1, 0);
+  bb.createElementMulInst("mulSrc1", output2, allocSrc1, input);
+  bb.createCopyInst("copy", output1, allocDest);
+
+  bb.createDeallocActivationInst("deallocDest", allocDest);
+  bb.createDeallocActivationInst("deallocSrc2", allocSrc2);
+  bb.createDeallocActivationInst("deallocSrc1", allocSrc1);
+
+  optimize(M, MockBackend().shouldShareBuffers());
+
+  // Both inserts are gone, allocSrc1 being written twice and read after the
+  // insert.
+  EXPECT_TRUE(M.verify());
+  auto &instrs = M.getInstrs();
+  EXPECT_TRUE(std::none_of(instrs.begin(), instrs.end(),
+                           [](const Instruction &I) -> bool {
+                             return isa<InsertTensorInst>(&I);
+                           }));
+  EXPECT_EQ(std::count_if(instrs.begin(), instrs.end(),
+                          [](const Instruction &I) -> bool {
+                            return isa<ElementMulInst>(&I);
+                          }),
+            1);
+}
+
+/// Check that an inserted buffer is not replaced by a TensorView into the
+/// destination when the destination is written while the buffer is live.
+TEST(Optimizer, insertOfBufferWithOtherReadersNotOptimized) {
+  Module mod;
+  Function *F = mod.createFunction("InsertOfBufferWithOtherReaders");
+  IRFunction M(F);
+  IRBuilder bb(&M);
+
+  auto *input = bb.createWeightVar(glow::ElemKind::FloatTy, {2, 5}, "input",
+                                   WeightVar::MutabilityKind::Constant);
+  auto *output1 =
+      bb.createWeightVar(glow::ElemKind::FloatTy, {4, 5}, "output1",
+                         WeightVar::MutabilityKind::Mutable);
+  auto *output2 =
+      bb.createWeightVar(glow::ElemKind::FloatTy, {2, 5}, "output2",
+                         WeightVar::MutabilityKind::Mutable);
+
+  auto *allocSrc = bb.createAllocActivationInst(
+      "allocSrc", glow::ElemKind::FloatTy, {2, 5});
+
+  bb.createElementAddInst("addSrc", allocSrc, input, input);
+  bb.createSplatInst("splatDest", output1, 2.0);
+  bb.createInsertTensorInst("insert", output1, allocSrc, {1, 0}, 1, 0);
+  bb.createElementMulInst("mulSrc", output2, allocSrc, input);
+  bb.createDeallocActivationInst("deallocSrc", allocSrc);
+
+  optimize(M, MockBackend().shouldShareBuffers());
+
+  // The splat overwrites the slice of output1 after allocSrc is written.
+  auto &instrs = M.getInstrs();
+  EXPECT_EQ(std::count_if(instrs.begin(), instrs.end(),
+                          [](const Instruction &I) -> bool {
+                            return isa<InsertTensorInst>(&I);
+                          }),
+            1);
+}
+
 /// This is representative of what a SliceNode is IRGen'd into: src is the
 /// original source tensor, and then two slices are created into dest1 and
 /// dest2.
@@ -679,14 +801,15 @@ TEST(Optimizer, inoutCopy) {
   optimize(M, MockBackend().shouldShareBuffers());
 
   // After optimization, the copies shouldn't have been touched.
-  // tmp1 = copy input cannot be coalesced because tmp1 is inout.
+  // tmp1 = copy input cannot be coalesced because tmp1 is inout. tmp1 is
+  // however replaced by the slice of output it is inserted into.
   // output2 = copy input cannot be coalesced because they are both
   // externally visible.
   EXPECT_EQ(input->getNumUsers(), 2);
   EXPECT_TRUE(
       std::all_of(input->getUsers().begin(), input->getUsers().end(),
                   [](const Use &I) -> bool { return isa<CopyInst>(I.get()); }));
-  const Value *expectedDest[] = {tmp1, output2};
+  const Value *expectedDest[] = {output, output2};
   unsigned idx = 0;
   for (const Use &use : input->getUsers()) {
     if (idx == sizeof(expectedDest) / sizeof(expectedDest[0])) {
@@ -694,7 +817,7 @@ TEST(Optimizer, inoutCopy) {
       EXPECT_FALSE(true);
       break;
     }
-    EXPECT_EQ(use.get()->getOperand(0).first, expectedDest[idx++]);
+    EXPECT_EQ(getOrigin(use.get()->getOperand(0).first), expectedDest[idx++]);
   }
 }
 
@@ -329,6 +329,25 @@ TEST_F(ImageTest, readPpmImageAndPreprocess) {
   EXPECT_TRUE(ppmExp.isEqual(pngRef, 0.01));
 }
 
+/// Test that preprocessing a batch of images directly into the batched tensor
+/// gives the images preprocessed one at a time.
+TEST_F(ImageTest, readPngPpmImagesAndPreprocessBatch) {
+  std::vector<std::string> filenames = {"tests/images/imagenet/cat_285.png",
+                                        "tests/images/ppm/cat_285.ppm"};
+  Tensor batch;
+  readPngPpmImagesAndPreprocess(batch, filenames, ImageNormalizationMode::k0to1,
+                                ImageChannelOrder::BGR, ImageLayout::NCHW,
+                                imagenetNormMean, imagenetNormStd);
+  ASSERT_EQ(batch.dims()[0], filenames.size());
+
+  for (dim_t n = 0; n < filenames.size(); n++) {
+    auto image = readPngPpmImageAndPreprocess(
+        filenames[n], ImageNormalizationMode::k0to1, ImageChannelOrder::BGR,
+        ImageLayout::NCHW, imagenetNormMean, imagenetNormStd);
+    EXPECT_TRUE(batch.getHandle().extractSlice(n).isEqual(image, 0.0));
+  }
+}
+
 TEST_F(ImageTest, writePngImage) {
   auto range = std::make_pair(0.f, 1.f);
   Tensor localCopy;
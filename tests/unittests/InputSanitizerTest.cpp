@@ -602,3 +602,119 @@ TEST(InputSanitizerTest, CheckEBBRO_HappyPath) {
       /* shouldSucceed */ true,
       /* expectedErrorMessage */ "");
 }
+
+/// With SanitizeInputsTables set only some of the tables are checked per
+/// inference, so an invalid table is caught by some inferences only.
+TEST(InputSanitizerTest, CheckSampledTables) {
+  glow::runtime::flags::SanitizeInputsPercent = 100;
+  glow::runtime::flags::SanitizeInputsTables = 1;
+
+  const dim_t embeddingRows = 100;
+  auto m = std::make_shared<Module>();
+  auto f = m->createFunction("testFunction");
+  auto *data = m->createPlaceholder(ElemKind::FloatTy, {embeddingRows, 1},
+                                    "data", false);
+  auto *goodIndices =
+      m->createPlaceholder(ElemKind::Int32ITy, {4}, "goodIndices", false);
+  auto *badIndices =
+      m->createPlaceholder(ElemKind::Int32ITy, {4}, "badIndices", false);
+  auto *lengths =
+      m->createPlaceholder(ElemKind::Int32ITy, {2}, "lengths", false);
+  auto *goodSLS =
+      f->createSparseLengthsSum("goodSLS", data, goodIndices, lengths);
+  auto *badSLS = f->createSparseLengthsSum("badSLS", data, badIndices, lengths);
+  auto *saveGood = f->createSave("saveGood", goodSLS);
+  auto *saveBad = f->createSave("saveBad", badSLS);
+
+  auto sanitizers = getInputSanitizers(*f);
+  ASSERT_EQ(2, sanitizers.size());
+
+  PlaceholderBindings bindings;
+  bindings.allocate(goodIndices)->getHandle<int32_t>() = {0, 1, 2, 3};
+  bindings.allocate(badIndices)->getHandle<int32_t>() = {0, 1, 2,
+                                                         embeddingRows};
+  bindings.allocate(lengths)->getHandle<int32_t>() = {2, 2};
+  bindings.allocate(saveGood->getPlaceholder());
+  bindings.allocate(saveBad->getPlaceholder());
+
+  unsigned numFailed = 0;
+  const unsigned numRuns = 64;
+  for (unsigned i = 0; i < numRuns; i++) {
+    if (ERR_TO_BOOL(sanitizeInputs(sanitizers, bindings))) {
+      numFailed++;
+    }
+  }
+  EXPECT_GT(numFailed, 0);
+  EXPECT_LT(numFailed, numRuns);
+
+  // All the tables are checked by default.
+  glow::runtime::flags::SanitizeInputsTables = 0;
+  EXPECT_TRUE(ERR_TO_BOOL(sanitizeInputs(sanitizers, bindings)));
+}
+
+/// Duplicate indices of each segment of a weighted SLS are merged, adding
+/// their weights, into copies of the inputs.
+TEST(InputSanitizerTest, DeduplicateSLWS) {
+  auto m = std::make_shared<Module>();
+  auto f = m->createFunction("testFunction");
+  auto *data = m->createPlaceholder(ElemKind::FloatTy, {10, 1}, "data", false);
+  auto *indices =
+      m->createPlaceholder(ElemKind::Int64ITy, {8}, "indices", false);
+  auto *weights =
+      m->createPlaceholder(ElemKind::FloatTy, {8}, "weights", false);
+  auto *lengths =
+      m->createPlaceholder(ElemKind::Int32ITy, {2}, "lengths", false);
+  auto *SLWS = f->createSparseLengthsWeightedSum("SLWS", data, weights,
+                                                 indices, lengths);
+  auto *save = f->createSave("save", SLWS);
+
+  auto deduplicators = getInputDeduplicators(*f);
+  ASSERT_EQ(1, deduplicators.size());
+
+  Tensor indicesReal(ElemKind::Int64ITy, {6});
+  Tensor weightsReal(ElemKind::FloatTy, {6});
+  indicesReal.getHandle<int64_t>() = {3, 1, 3, 2, 5, 5};
+  weightsReal.getHandle<float>() = {1, 2, 3, 4, 5, 6};
+  PlaceholderBindings bindings;
+  bindings.insert(indices,
+                  Tensor(indicesReal.getUnsafePtr(), indices->getType(),
+                         indicesReal.getSizeInBytes()));
+  bindings.insert(weights,
+                  Tensor(weightsReal.getUnsafePtr(), weights->getType(),
+                         weightsReal.getSizeInBytes()));
+  bindings.allocate(lengths)->getHandle<int32_t>() = {4, 2};
+  bindings.allocate(save->getPlaceholder());
+
+  // 2 of the 6 indices are duplicates, below the threshold.
+  glow::runtime::flags::DedupInputsMinPercent = 50;
+  std::vector<Tensor> storage;
+  EXPECT_FALSE(
+      ERR_TO_BOOL(deduplicateInputs(deduplicators, bindings, storage)));
+  EXPECT_EQ(bindings.get(indices)->getRealNumElements(), 6);
+
+  // Having skipped, the deduplicator waits some runs before measuring the
+  // duplicate rate again, a new one measures it right away.
+  glow::runtime::flags::DedupInputsMinPercent = 30;
+  auto newDeduplicators = getInputDeduplicators(*f);
+  EXPECT_FALSE(
+      ERR_TO_BOOL(deduplicateInputs(newDeduplicators, bindings, storage)));
+  glow::runtime::flags::DedupInputsMinPercent = 0;
+
+  auto *newIndices = bindings.get(indices);
+  auto *newWeights = bindings.get(weights);
+  auto *newLengths = bindings.get(lengths);
+  ASSERT_EQ(newIndices->getRealNumElements(), 4);
+  ASSERT_EQ(newWeights->getRealNumElements(), 4);
+  std::vector<int64_t> expectedIndices = {1, 2, 3, 5};
+  std::vector<float> expectedWeights = {2, 4, 4, 11};
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(newIndices->getHandle<int64_t>().raw(i), expectedIndices[i]);
+    EXPECT_EQ(newWeights->getHandle<float>().raw(i), expectedWeights[i]);
+  }
+  EXPECT_EQ(newLengths->getHandle<int32_t>().raw(0), 3);
+  EXPECT_EQ(newLengths->getHandle<int32_t>().raw(1), 1);
+
+  // The original inputs are not modified.
+  EXPECT_EQ(indicesReal.getHandle<int64_t>().raw(0), 3);
+  EXPECT_EQ(weightsReal.getHandle<float>().raw(0), 1);
+}
@@ -16,9 +16,21 @@
 
 #include "glow/LLVMIRCodeGen/LLVMIRGen.h"
 #include "glow/LLVMIRCodeGen/AllocationsInfo.h"
+#include "glow/LLVMIRCodeGen/JITObjectCache.h"
 
 #include "glow/IR/IR.h"
 
+#include "llvm/IR/Function.h"
+#include "llvm/IR/LLVMContext.h"
+#if LLVM_VERSION_MAJOR >= 14
+#include "llvm/MC/TargetRegistry.h"
+#else
+#include "llvm/Support/TargetRegistry.h"
+#endif
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetSelect.h"
+
 #include "gtest/gtest.h"
 
 using namespace glow;
@@ -41,3 +53,50 @@ TEST(LLVMIRGen, getEntryName) {
   llvmIRGen.setMainEntryName("");
   EXPECT_EQ(llvmIRGen.getMainEntryName(), "main");
 }
+
+/// \returns a TargetMachine for the host with the CPU \p cpu.
+static std::unique_ptr<llvm::TargetMachine>
+createHostTargetMachine(llvm::StringRef cpu) {
+  llvm::InitializeNativeTarget();
+  std::string triple = llvm::sys::getProcessTriple();
+  std::string err;
+  const llvm::Target *target = llvm::TargetRegistry::lookupTarget(triple, err);
+  EXPECT_TRUE(target) << err;
+  return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      triple, cpu, "", llvm::TargetOptions(), llvm::None));
+}
+
+/// Check that JITObjectCache returns the objects of identical modules compiled
+/// for the same target, and only these.
+TEST(LLVMIRGen, jitObjectCache) {
+  llvm::SmallString<128> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("jit-cache", dir));
+  auto TM = createHostTargetMachine("generic");
+  auto otherTM = createHostTargetMachine(llvm::sys::getHostCPUName());
+  JITObjectCache cache(dir, *TM);
+  JITObjectCache otherCache(dir, *otherTM);
+
+  llvm::LLVMContext ctx;
+  auto createModule = [&](llvm::StringRef fnName) {
+    auto M = glow::make_unique<llvm::Module>("m", ctx);
+    llvm::Function::Create(
+        llvm::FunctionType::get(llvm::Type::getVoidTy(ctx), false),
+        llvm::Function::ExternalLinkage, fnName, M.get());
+    return M;
+  };
+  auto M = createModule("f");
+  EXPECT_FALSE(cache.getObject(M.get()));
+  cache.notifyObjectCompiled(M.get(), llvm::MemoryBufferRef("obj", "obj"));
+
+  // An identical module, e.g. from another compilation, hits the cache.
+  auto sameM = createModule("f");
+  auto obj = cache.getObject(sameM.get());
+  ASSERT_TRUE(obj);
+  EXPECT_EQ(obj->getBuffer(), "obj");
+
+  EXPECT_FALSE(cache.getObject(createModule("g").get()));
+  if (otherTM->getTargetCPU() != TM->getTargetCPU()) {
+    EXPECT_FALSE(otherCache.getObject(M.get()));
+  }
+  llvm::sys::fs::remove_directories(dir);
+}
@@ -828,6 +828,138 @@ TEST_P(MLTest, trainSimpleLinearRegression) {
   EXPECT_NEAR(bindings.get(B)->getHandle<>().at({0}), referenceB, 0.01);
 }
 
+/// Check that runBatchAsync and evalBatchAsync, which load the next batch while
+/// the current one runs, give the same results as runBatch and evalBatch.
+TEST_P(MLTest, runAndEvalBatchAsync) {
+  CHECK_IF_ENABLED();
+  TrainingConfig TC;
+  PlaceholderBindings bindings;
+
+  unsigned numSamples = 500;
+  unsigned batchSize = 100;
+  TC.learningRate = 0.1;
+  TC.batchSize = batchSize;
+
+  auto &mod = EET_.getModule();
+  Function *F = mod.createFunction("linear_regression");
+
+  Tensor tensorX(ElemKind::FloatTy, {numSamples, 1});
+  Tensor tensorY(ElemKind::FloatTy, {numSamples, 1});
+  Tensor labels(ElemKind::Int64ITy, {numSamples, 1});
+  for (unsigned i = 0; i < numSamples; i++) {
+    float x_i = -2.0 + 4.0 * i / numSamples;
+    tensorX.getHandle<>().at({i, 0}) = x_i;
+    tensorY.getHandle<>().at({i, 0}) = 3.0 * x_i + 6.0;
+  }
+
+  Placeholder *inputX =
+      mod.createPlaceholder(ElemKind::FloatTy, {batchSize, 1}, "input", false);
+  Placeholder *expectedY = mod.createPlaceholder(
+      ElemKind::FloatTy, {batchSize, 1}, "expected", false);
+  FullyConnectedNode *FC = F->createFullyConnected(bindings, "fc", inputX, 1);
+  Node *R = F->createRegression("reg", FC, expectedY);
+  SaveNode *SN = F->createSave("return", R);
+  Placeholder *M = llvm::cast<Placeholder>(FC->getWeights());
+  Placeholder *B = llvm::cast<Placeholder>(FC->getBias());
+
+  auto *TF = glow::differentiate(F, TC);
+  auto tfName = TF->getName().str();
+  auto fName = F->getName().str();
+  EET_.compile(CompilationMode::Train);
+  bindings.allocate(mod.getPlaceholders());
+  PlaceholderBindings asyncBindings = bindings.clone();
+
+  // Run an odd number of iterations to end on the second context.
+  size_t sampleCounter = 0;
+  size_t asyncSampleCounter = 0;
+  runBatch(EET_, bindings, 7, sampleCounter, {inputX, expectedY},
+           {&tensorX, &tensorY}, tfName);
+  runBatchAsync(EET_, asyncBindings, 7, asyncSampleCounter,
+                {inputX, expectedY}, {&tensorX, &tensorY}, tfName);
+  EXPECT_EQ(sampleCounter, asyncSampleCounter);
+  EXPECT_TRUE(bindings.get(M)->isEqual(*asyncBindings.get(M), 0.0));
+  EXPECT_TRUE(bindings.get(B)->isEqual(*asyncBindings.get(B), 0.0));
+
+  std::vector<float> outputs;
+  std::vector<float> asyncOutputs;
+  std::vector<size_t> asyncIndices;
+  evalBatch(EET_, bindings, 3, sampleCounter, inputX, SN->getPlaceholder(),
+            tensorX, labels, fName,
+            [&](const Tensor &, const Tensor &sampleOut, const Tensor &,
+                size_t) { outputs.push_back(sampleOut.getHandle().raw(0)); });
+  evalBatchAsync(
+      EET_, asyncBindings, 3, asyncSampleCounter, inputX, SN->getPlaceholder(),
+      tensorX, labels, fName,
+      [&](const Tensor &, const Tensor &sampleOut, const Tensor &,
+          size_t sampleIndex) {
+        asyncOutputs.push_back(sampleOut.getHandle().raw(0));
+        asyncIndices.push_back(sampleIndex);
+      });
+  EXPECT_EQ(sampleCounter, asyncSampleCounter);
+  EXPECT_EQ(outputs, asyncOutputs);
+  ASSERT_EQ(asyncIndices.size(), 3 * batchSize);
+  for (size_t i = 0; i < asyncIndices.size(); i++) {
+    EXPECT_EQ(asyncIndices[i], 7 * batchSize + i);
+  }
+}
+
+/// Learn the linear regression of trainSimpleLinearRegression with its batch
+/// split in 4 shards, trained on 4 devices by a DataParallelTrainer.
+TEST_P(MLTest, trainDataParallelLinearRegression) {
+  CHECK_IF_ENABLED();
+  const unsigned numReplicas = 4;
+  ExecutionEngine EE(GetParam(), /* deviceMemory */ 0,
+                     /* ignoreUserDeviceConfig */ true, numReplicas);
+  TrainingConfig TC;
+  PlaceholderBindings bindings;
+
+  unsigned numSamples = 500;
+  unsigned shardSize = numSamples / numReplicas;
+  size_t sampleCounter = 0;
+
+  TC.learningRate = 0.1;
+  TC.batchSize = shardSize;
+
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("linear_regression");
+
+  float referenceM = 3.0;
+  float referenceB = 6.0;
+
+  Tensor tensorX(ElemKind::FloatTy, {numSamples, 1});
+  Tensor tensorY(ElemKind::FloatTy, {numSamples, 1});
+  for (unsigned i = 0; i < numSamples; i++) {
+    float x_i = -2.0 + 4.0 * i / numSamples;
+    float y_i = referenceM * x_i + referenceB + mod.getPRNG().nextRand() / 10.0;
+    tensorX.getHandle<>().at({i, 0}) = x_i;
+    tensorY.getHandle<>().at({i, 0}) = y_i;
+  }
+
+  Placeholder *inputX =
+      mod.createPlaceholder(ElemKind::FloatTy, {shardSize, 1}, "input", false);
+  Placeholder *expectedY = mod.createPlaceholder(
+      ElemKind::FloatTy, {shardSize, 1}, "expected", false);
+
+  FullyConnectedNode *FC = F->createFullyConnected(bindings, "fc", inputX, 1);
+  Node *R = F->createRegression("reg", FC, expectedY);
+  F->createSave("return", R);
+
+  Placeholder *M = llvm::cast<Placeholder>(FC->getWeights());
+  Placeholder *B = llvm::cast<Placeholder>(FC->getBias());
+
+  DataParallelTrainer trainer(EE, F, TC, numReplicas);
+  CompilationContext cctx;
+  trainer.compile(cctx);
+
+  // Each step goes over the 500 samples, like trainSimpleLinearRegression.
+  trainer.runBatch(bindings, 100, sampleCounter, {inputX, expectedY},
+                   {&tensorX, &tensorY});
+  EXPECT_EQ(sampleCounter, 100 * numSamples);
+
+  EXPECT_NEAR(bindings.get(M)->getHandle<>().at({0, 0}), referenceM, 0.01);
+  EXPECT_NEAR(bindings.get(B)->getHandle<>().at({0}), referenceB, 0.01);
+}
+
 enum class Sport : size_t { BASKETBALL = 0, SOCCER = 1 };
 
 void generatePlayerData(Tensor &players, Tensor &labels,
@@ -19,6 +19,7 @@
 #include "gtest/gtest.h"
 
 #include <fstream>
+#include <functional>
 
 #ifndef GLOW_DATA_PATH
 #define GLOW_DATA_PATH
@@ -573,17 +574,21 @@ static void testAllocateAllForModel(size_t alignment,
   EXPECT_FLOAT_EQ(MA.getAllocationEfficiency(), expectedEfficiency);
 }
 
-/// Test memory allocation for multiple models using a text file with the
-/// following format:
+/// Call \p testModel for each model of the text file with the following
+/// format:
 /// MODEL <model_name>
 /// ALIGN <alignment>
 /// ALLOC <id> <size>
 /// FREE <id>
 /// MEM <expected_memory_usage>
 /// EFF <expected_efficiency>
-TEST(MemAlloc, testAllocateAllForModels) {
+/// with the name, alignment, allocations, expected memory usage and expected
+/// efficiency of the model.
+static void forEachTestModel(
+    const std::function<void(const std::string &, size_t,
+                             const std::list<Allocation> &, uint64_t, float)>
+        &testModel) {
   std::string modelName;
-  unsigned modelIdx = 1;
   size_t alignment;
   uint64_t expectedUsedSize;
   float expectedEfficiency;
@@ -623,17 +628,95 @@ TEST(MemAlloc, testAllocateAllForModels) {
     }
     // Test allocation for model.
     if (key == "EFF") {
-      std::cout << "[" << modelIdx++
-                << "] Testing memory allocation for model: " << modelName
-                << "\n";
-      testAllocateAllForModel(alignment, allocs, expectedUsedSize,
-                              expectedEfficiency);
+      testModel(modelName, alignment, allocs, expectedUsedSize,
+                expectedEfficiency);
       allocs.clear();
     }
   }
   fs.close();
 }
 
+/// Test memory allocation for multiple models, see forEachTestModel.
+TEST(MemAlloc, testAllocateAllForModels) {
+  unsigned modelIdx = 1;
+  forEachTestModel([&](const std::string &modelName, size_t alignment,
+                       const std::list<Allocation> &allocs,
+                       uint64_t expectedUsedSize, float expectedEfficiency) {
+    std::cout << "[" << modelIdx++
+              << "] Testing memory allocation for model: " << modelName
+              << "\n";
+    testAllocateAllForModel(alignment, allocs, expectedUsedSize,
+                            expectedEfficiency);
+  });
+}
+
+/// Test the memory planners for multiple models: all of them keep the sizes of
+/// the allocations, none uses less than the maximum live size, and the search
+/// never uses more memory than the other planners.
+TEST(MemAlloc, testAllocateAllPlannersForModels) {
+  unsigned numImproved = 0;
+  forEachTestModel([&](const std::string &modelName, size_t alignment,
+                       const std::list<Allocation> &allocs,
+                       uint64_t expectedUsedSize, float expectedEfficiency) {
+    uint64_t usedSizeMin = MemoryAllocator::npos;
+    for (auto planner : {MemoryPlanner::LiveSize, MemoryPlanner::GreedyBySize,
+                         MemoryPlanner::BestFit, MemoryPlanner::Search}) {
+      MemoryAllocator MA("mem", 0, alignment);
+      MA.setPlanner(planner);
+      uint64_t usedSize = MA.allocateAll(allocs);
+      for (const auto &alloc : allocs) {
+        if (alloc.alloc) {
+          EXPECT_EQ(MA.getSize(alloc.handle), alloc.size);
+        }
+      }
+      EXPECT_LE(MA.getAllocationEfficiency(), 1.0f);
+      if (planner == MemoryPlanner::LiveSize) {
+        EXPECT_EQ(usedSize, expectedUsedSize) << modelName;
+      }
+      if (planner == MemoryPlanner::Search) {
+        EXPECT_LE(usedSize, usedSizeMin) << modelName;
+        numImproved += usedSize < expectedUsedSize;
+      }
+      usedSizeMin = std::min(usedSizeMin, usedSize);
+    }
+  });
+  // The search finds better allocations than LiveSize for some models.
+  EXPECT_GT(numImproved, 0);
+}
+
+/// Test the names of the memory planners.
+TEST(MemAlloc, testMemoryPlannerNames) {
+  for (auto planner : {MemoryPlanner::LiveSize, MemoryPlanner::GreedyBySize,
+                       MemoryPlanner::BestFit, MemoryPlanner::Search}) {
+    MemoryPlanner parsed;
+    ASSERT_TRUE(
+        getMemoryPlannerFromName(getMemoryPlannerName(planner), parsed));
+    EXPECT_EQ(parsed, planner);
+  }
+  MemoryPlanner parsed;
+  EXPECT_FALSE(getMemoryPlannerFromName("first-fit", parsed));
+}
+
+/// Test the search budget of MemoryPlanner::Search: without budget the search
+/// keeps the best allocation of the other planners.
+TEST(MemAlloc, testAllocateAllSearchBudget) {
+  forEachTestModel([&](const std::string &modelName, size_t alignment,
+                       const std::list<Allocation> &allocs,
+                       uint64_t expectedUsedSize, float expectedEfficiency) {
+    uint64_t usedSizeMin = MemoryAllocator::npos;
+    for (auto planner : {MemoryPlanner::LiveSize, MemoryPlanner::GreedyBySize,
+                         MemoryPlanner::BestFit}) {
+      MemoryAllocator MA("mem", 0, alignment);
+      MA.setPlanner(planner);
+      usedSizeMin = std::min(usedSizeMin, MA.allocateAll(allocs));
+    }
+    MemoryAllocator MA("mem", 0, alignment);
+    MA.setPlanner(MemoryPlanner::Search);
+    MA.setSearchBudget(0);
+    EXPECT_EQ(MA.allocateAll(allocs), usedSizeMin) << modelName;
+  });
+}
+
 /// Test allocating multiple functions with memory reusage for allocateAll.
 TEST(MemAlloc, testAllocateAllMultipleFunctionsWithReuse) {
 
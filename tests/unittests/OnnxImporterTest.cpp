@@ -20,6 +20,7 @@
 #include "glow/Graph/PlaceholderBindings.h"
 #include "glow/Importer/ONNXModelLoader.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "gtest/gtest.h"
 
 #ifndef GLOW_DATA_PATH
@@ -5928,3 +5929,198 @@ TEST_F(OnnxImporterTest, logsoftmax) {
                -0.12692806, -0.12692806, -2.1269281, -2.1269281, -0.12692806,
                -0.12692806});
 }
+
+/// Test loading an initializer whose payload is in an external data file,
+/// which is mapped into an unowned Constant payload.
+TEST_F(OnnxImporterTest, externalDataInitializer) {
+  llvm::SmallString<64> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("external_data", dir));
+  const std::vector<float> weights = {1.0, 2.0, 3.0, 4.0};
+  {
+    llvm::SmallString<64> dataPath(dir);
+    llvm::sys::path::append(dataPath, "weights.bin");
+    std::ofstream data(dataPath.str().str(), std::ios::binary);
+    // The payload is preceded by another one, which is skipped by its offset.
+    const std::vector<float> header = {-1.0, -1.0, -1.0, -1.0};
+    data.write(reinterpret_cast<const char *>(header.data()), 16);
+    data.write(reinterpret_cast<const char *>(weights.data()), 16);
+  }
+
+  ONNX_NAMESPACE::ModelProto MP;
+  MP.set_ir_version(7);
+  MP.add_opset_import()->set_version(13);
+  auto *graph = MP.mutable_graph();
+  auto *W = graph->add_initializer();
+  W->set_name("W");
+  W->set_data_type(ONNX_NAMESPACE::TensorProto::FLOAT);
+  W->add_dims(2);
+  W->add_dims(2);
+  W->set_data_location(ONNX_NAMESPACE::TensorProto::EXTERNAL);
+  auto addExternalData = [&](const char *key, const char *value) {
+    auto *entry = W->add_external_data();
+    entry->set_key(key);
+    entry->set_value(value);
+  };
+  addExternalData("location", "weights.bin");
+  addExternalData("offset", "16");
+  addExternalData("length", "16");
+  auto *input = graph->add_input();
+  input->set_name("X");
+  auto *tensorType = input->mutable_type()->mutable_tensor_type();
+  tensorType->set_elem_type(ONNX_NAMESPACE::TensorProto::FLOAT);
+  tensorType->mutable_shape()->add_dim()->set_dim_value(2);
+  tensorType->mutable_shape()->add_dim()->set_dim_value(2);
+  *graph->add_output() = *input;
+  graph->mutable_output(0)->set_name("Y");
+  auto *add = graph->add_node();
+  add->set_op_type("Add");
+  add->add_input("X");
+  add->add_input("W");
+  add->add_output("Y");
+
+  llvm::SmallString<64> modelPath(dir);
+  llvm::sys::path::append(modelPath, "model.onnx");
+  {
+    std::ofstream model(modelPath.str().str(), std::ios::binary);
+    ASSERT_TRUE(MP.SerializeToOstream(&model));
+  }
+
+  ExecutionEngine EE{};
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  Type inputType(ElemKind::FloatTy, {2, 2});
+  ONNXModelLoader onnxLD(modelPath.str().str(), {"X"}, {&inputType}, *F);
+  Placeholder *output = EXIT_ON_ERR(onnxLD.getSingleOutput());
+
+  Constant *C = mod.getConstantByName("W");
+  ASSERT_TRUE(C);
+  EXPECT_TRUE(C->getPayload().isUnowned());
+  auto CH = C->getPayload().getHandle();
+  for (size_t i = 0; i < weights.size(); i++) {
+    EXPECT_EQ(CH.raw(i), weights[i]);
+  }
+
+  PlaceholderBindings bindings;
+  bindings.allocate(mod.getPlaceholders());
+  bindings.get(mod.getPlaceholderByNameSlow("X"))->getHandle() = {1, 1, 1, 1};
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+  auto result = bindings.get(output)->getHandle();
+  for (size_t i = 0; i < weights.size(); i++) {
+    EXPECT_EQ(result.raw(i), weights[i] + 1);
+  }
+}
+
+/// Test that initializers deserialized on several loader threads are loaded
+/// into Constants created in the order of the initializers. Constant folding
+/// is disabled by the fixture, so the Concat of the initializers is kept.
+TEST_F(OnnxImporterTest, parallelInitializers) {
+  constexpr unsigned numInitializers = 16;
+  ONNX_NAMESPACE::ModelProto MP;
+  MP.set_ir_version(7);
+  MP.add_opset_import()->set_version(13);
+  auto *graph = MP.mutable_graph();
+  for (unsigned i = 0; i < numInitializers; i++) {
+    auto *W = graph->add_initializer();
+    W->set_name(strFormat("W%u", i));
+    W->set_data_type(ONNX_NAMESPACE::TensorProto::FLOAT);
+    W->add_dims(i + 1);
+    for (unsigned j = 0; j <= i; j++) {
+      W->add_float_data(i * 100 + j);
+    }
+  }
+  auto *output = graph->add_output();
+  output->set_name("Y");
+  auto *tensorType = output->mutable_type()->mutable_tensor_type();
+  tensorType->set_elem_type(ONNX_NAMESPACE::TensorProto::FLOAT);
+  tensorType->mutable_shape()->add_dim()->set_dim_value(
+      numInitializers * (numInitializers + 1) / 2);
+  auto *concat = graph->add_node();
+  concat->set_op_type("Concat");
+  for (unsigned i = 0; i < numInitializers; i++) {
+    concat->add_input(strFormat("W%u", i));
+  }
+  concat->add_output("Y");
+  auto *axis = concat->add_attribute();
+  axis->set_name("axis");
+  axis->set_type(ONNX_NAMESPACE::AttributeProto::INT);
+  axis->set_i(0);
+
+  llvm::SmallString<64> modelPath;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("parallel", "onnx", modelPath));
+  {
+    std::ofstream model(modelPath.str().str(), std::ios::binary);
+    ASSERT_TRUE(MP.SerializeToOstream(&model));
+  }
+
+  setLoaderThreads(4);
+  Module mod;
+  Function *F = mod.createFunction("main");
+  Error err = Error::empty();
+  { ONNXModelLoader onnxLD(modelPath.str().str(), {}, {}, *F, &err); }
+  setLoaderThreads(0);
+  ASSERT_FALSE(ERR_TO_BOOL(std::move(err)));
+
+  unsigned i = 0;
+  for (Constant *C : mod.getConstants()) {
+    ASSERT_EQ(C->getName(), strFormat("W%u", i));
+    auto CH = C->getPayload().getHandle();
+    ASSERT_EQ(CH.size(), i + 1);
+    for (unsigned j = 0; j <= i; j++) {
+      EXPECT_EQ(CH.raw(j), i * 100 + j);
+    }
+    i++;
+  }
+  EXPECT_EQ(i, numInitializers);
+}
+
+/// Test that the Functions loaded through an ONNXModelCache for several batch
+/// sizes share the Constants of the model and compute the right results.
+TEST_F(OnnxImporterTest, modelCacheSharesConstants) {
+  ExecutionEngine EE{};
+  auto &mod = EE.getModule();
+  std::string netFilename(
+      GLOW_DATA_PATH "tests/models/onnxModels/"
+                     "mulUniBroadcastOp6NoAxis.onnxtxt");
+
+  ONNXModelCache cache;
+  const std::vector<dim_t> batchSizes = {1, 4};
+  std::vector<Function *> functions;
+  for (dim_t batch : batchSizes) {
+    Tensor data(ElemKind::FloatTy, {batch, 3, 4, 2});
+    Function *F;
+    ASSIGN_VALUE_OR_FAIL_TEST(
+        F, cache.load(netFilename, {"data"}, {&data.getType()}, mod,
+                      "main" + std::to_string(batch)));
+    functions.push_back(F);
+  }
+  EXPECT_EQ(mod.getFunctions().size(), batchSizes.size());
+  EXPECT_EQ(mod.getConstants().size(), 1);
+
+  EE.compile(CompilationMode::Infer);
+  for (size_t i = 0; i < functions.size(); i++) {
+    Function *F = functions[i];
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    Placeholder *output = nullptr;
+    for (auto &N : F->getNodes()) {
+      if (auto *save = llvm::dyn_cast<SaveNode>(&N)) {
+        output = save->getPlaceholder();
+      }
+    }
+    ASSERT_TRUE(output);
+    for (Placeholder *PH : F->findPlaceholders()) {
+      if (PH != output) {
+        EXPECT_EQ(PH->dims()[0], batchSizes[i]);
+        bindings.get(PH)->getHandle().clear(3);
+      }
+    }
+    EE.run(bindings, F->getName());
+    auto outH = bindings.get(output)->getHandle();
+    EXPECT_EQ(outH.dims()[0], batchSizes[i]);
+    for (dim_t j = 0, e = outH.size(); j < e; j++) {
+      EXPECT_FLOAT_EQ(outH.raw(j), 6);
+    }
+  }
+}
@@ -2722,8 +2722,8 @@ TEST_P(OperatorTest, LSTMUnitFP16) {
 
   auto lstmUnitNode = F_->createLSTMUnit("lstm_unit", Input, C);
 
-  auto hRes = lstmUnitNode->getNthResult(0);
-  auto cRes = lstmUnitNode->getNthResult(1);
+  auto hRes = lstmUnitNode->getnewH();
+  auto cRes = lstmUnitNode->getnewC();
 
   auto *hSave = F_->createSave("saveH", hRes);
   auto *hTensor = bindings_.allocate(hSave->getPlaceholder());
@@ -2745,6 +2745,135 @@ TEST_P(OperatorTest, LSTMUnitFP16) {
   }
 }
 
+/// Test the LSTMUnit cell on float, fused on the backends with a cell kernel,
+/// against a reference computation of the gates.
+TEST_P(OperatorTest, LSTMUnit) {
+  CHECK_IF_ENABLED();
+
+  dim_t batch = 3;
+  dim_t hidden = 5;
+
+  auto *Input = mod_.createPlaceholder(ElemKind::FloatTy, {batch, 4 * hidden},
+                                       "Input", false);
+  auto IH = bindings_.allocate(Input)->getHandle<float>();
+  IH.randomize(-3.0, 3.0, mod_.getPRNG());
+  auto *C =
+      mod_.createPlaceholder(ElemKind::FloatTy, {batch, hidden}, "C", false);
+  auto CH = bindings_.allocate(C)->getHandle<float>();
+  CH.randomize(-2.0, 2.0, mod_.getPRNG());
+
+  auto *LU = F_->createLSTMUnit("lstm_unit", Input, C);
+  auto *hSave = F_->createSave("saveH", LU->getnewH());
+  auto *hTensor = bindings_.allocate(hSave->getPlaceholder());
+  auto *cSave = F_->createSave("saveC", LU->getnewC());
+  auto *cTensor = bindings_.allocate(cSave->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto sigmoid = [](float x) { return 1 / (1 + std::exp(-x)); };
+  auto hHandle = hTensor->getHandle<float>();
+  auto cHandle = cTensor->getHandle<float>();
+  for (dim_t b = 0; b < batch; b++) {
+    for (dim_t j = 0; j < hidden; j++) {
+      float i = sigmoid(IH.at({b, j}));
+      float f = sigmoid(IH.at({b, hidden + j}));
+      float g = std::tanh(IH.at({b, 2 * hidden + j}));
+      float o = sigmoid(IH.at({b, 3 * hidden + j}));
+      float c = f * CH.at({b, j}) + i * g;
+      EXPECT_NEAR(cHandle.at({b, j}), c, 1E-5);
+      EXPECT_NEAR(hHandle.at({b, j}), o * std::tanh(c), 1E-5);
+    }
+  }
+}
+
+/// Helper to test BeamSearchStep with indices of type \p IndexTy, against a
+/// reference log-softmax and top-k over all the beam/token pairs.
+template <typename IndexTy>
+static void testBeamSearchStep(glow::PlaceholderBindings &bindings,
+                               glow::Module &mod, glow::Function *F,
+                               glow::ExecutionEngine &EE, ElemKind indicesTy) {
+  dim_t beam = 3;
+  dim_t vocab = 7;
+  dim_t stateSize = 2;
+
+  auto *logits =
+      mod.createPlaceholder(ElemKind::FloatTy, {beam, vocab}, "logits", false);
+  auto LH = bindings.allocate(logits)->getHandle<float>();
+  // Distinct logits, so that the selected tokens have no ties.
+  for (dim_t i = 0; i < beam * vocab; i++) {
+    LH.raw(i) = float((i * 5) % (beam * vocab)) / 4;
+  }
+  auto *scores =
+      mod.createPlaceholder(ElemKind::FloatTy, {beam}, "scores", false);
+  auto SH = bindings.allocate(scores)->getHandle<float>();
+  SH = {-0.5, -0.25, -2.0};
+  auto *state = mod.createPlaceholder(ElemKind::FloatTy, {beam, stateSize},
+                                      "state", false);
+  auto STH = bindings.allocate(state)->getHandle<float>();
+  STH = {1, 2, 3, 4, 5, 6};
+
+  auto *BSS =
+      F->createBeamSearchStep("beam_step", logits, scores, state, indicesTy);
+  auto *scoresT =
+      bindings.allocate(F->createSave("saveScores", BSS->getNewScores())
+                            ->getPlaceholder());
+  auto *tokensT = bindings.allocate(
+      F->createSave("saveTokens", BSS->getTokens())->getPlaceholder());
+  auto *prevT = bindings.allocate(
+      F->createSave("savePrev", BSS->getPrevIndices())->getPlaceholder());
+  auto *stateT = bindings.allocate(
+      F->createSave("saveState", BSS->getNewState())->getPlaceholder());
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  std::vector<std::pair<float, dim_t>> candidates;
+  for (dim_t b = 0; b < beam; b++) {
+    float max = LH.at({b, 0});
+    for (dim_t v = 1; v < vocab; v++) {
+      max = std::max(max, LH.at({b, v}));
+    }
+    float sum = 0;
+    for (dim_t v = 0; v < vocab; v++) {
+      sum += std::exp(LH.at({b, v}) - max);
+    }
+    for (dim_t v = 0; v < vocab; v++) {
+      float logProb = LH.at({b, v}) - max - std::log(sum);
+      candidates.push_back({SH.at({b}) + logProb, b * vocab + v});
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const std::pair<float, dim_t> &a,
+               const std::pair<float, dim_t> &b) { return a.first > b.first; });
+
+  auto newScoresH = scoresT->getHandle<float>();
+  auto tokensH = tokensT->getHandle<IndexTy>();
+  auto prevH = prevT->getHandle<IndexTy>();
+  auto newStateH = stateT->getHandle<float>();
+  for (dim_t k = 0; k < beam; k++) {
+    dim_t prev = candidates[k].second / vocab;
+    EXPECT_NEAR(newScoresH.at({k}), candidates[k].first, 1E-5);
+    EXPECT_EQ(tokensH.at({k}), IndexTy(candidates[k].second % vocab));
+    EXPECT_EQ(prevH.at({k}), IndexTy(prev));
+    for (dim_t j = 0; j < stateSize; j++) {
+      EXPECT_EQ(newStateH.at({k, j}), STH.at({prev, j}));
+    }
+  }
+}
+
+/// Test BeamSearchStep with Int64 indices.
+TEST_P(OperatorTest, BeamSearchStep) {
+  CHECK_IF_ENABLED();
+  testBeamSearchStep<int64_t>(bindings_, mod_, F_, EE_, ElemKind::Int64ITy);
+}
+
+/// Test BeamSearchStep with Int32 indices.
+TEST_P(OperatorTest, BeamSearchStep_Int32) {
+  CHECK_IF_ENABLED();
+  testBeamSearchStep<int32_t>(bindings_, mod_, F_, EE_, ElemKind::Int32ITy);
+}
+
 TEST_P(OperatorTest, PyTorchLSTMFP16) {
   CHECK_IF_ENABLED();
 
@@ -3560,6 +3689,64 @@ TEST_P(OperatorStatelessTest, ParallelBatchMatMul_Int8) {
       ElemKind::Int8QTy, 0.002f, parCloneCountOpt);
 }
 
+/// Test ScaledDotProductAttention with a mask broadcast along the queries,
+/// with more keys than fit a single block of the CPU kernel.
+TEST_P(OperatorTest, ScaledDotProductAttention_Float) {
+  CHECK_IF_ENABLED();
+
+  const dim_t N = 2, Lq = 10, Lk = 70, D = 12, Dv = 9;
+  const float scale = 0.25;
+  auto *Q = mod_.createPlaceholder(ElemKind::FloatTy, {N, Lq, D}, "Q", false);
+  auto *K = mod_.createPlaceholder(ElemKind::FloatTy, {N, Lk, D}, "K", false);
+  auto *V = mod_.createPlaceholder(ElemKind::FloatTy, {N, Lk, Dv}, "V", false);
+  auto *mask =
+      mod_.createPlaceholder(ElemKind::FloatTy, {N, 1, Lk}, "mask", false);
+  auto QH = bindings_.allocate(Q)->getHandle();
+  auto KH = bindings_.allocate(K)->getHandle();
+  auto VH = bindings_.allocate(V)->getHandle();
+  auto MH = bindings_.allocate(mask)->getHandle();
+  QH.randomize(-3, 3, mod_.getPRNG());
+  KH.randomize(-3, 3, mod_.getPRNG());
+  VH.randomize(-1, 1, mod_.getPRNG());
+  MH.randomize(-10, 0, mod_.getPRNG());
+
+  auto *R = F_->createScaledDotProductAttention("attention", Q, K, V, mask,
+                                                scale);
+  auto *save = F_->createSave("save", R);
+  auto *result = bindings_.allocate(save->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto H = result->getHandle();
+  for (dim_t n = 0; n < N; n++) {
+    for (dim_t q = 0; q < Lq; q++) {
+      std::vector<float> scores(Lk);
+      float max = -std::numeric_limits<float>::infinity();
+      for (dim_t k = 0; k < Lk; k++) {
+        float dot = 0;
+        for (dim_t d = 0; d < D; d++) {
+          dot += QH.at({n, q, d}) * KH.at({n, k, d});
+        }
+        scores[k] = dot * scale + MH.at({n, 0, k});
+        max = std::max(max, scores[k]);
+      }
+      float sum = 0;
+      for (dim_t k = 0; k < Lk; k++) {
+        scores[k] = std::exp(scores[k] - max);
+        sum += scores[k];
+      }
+      for (dim_t d = 0; d < Dv; d++) {
+        float expected = 0;
+        for (dim_t k = 0; k < Lk; k++) {
+          expected += scores[k] * VH.at({n, k, d});
+        }
+        EXPECT_NEAR(H.at({n, q, d}), expected / sum, 1e-5);
+      }
+    }
+  }
+}
+
 /// Helper to test BatchedReduceSumSquare using \p DTy.
 template <typename DataType>
 static void testBatchedReduceSumSquare(glow::PlaceholderBindings &bindings,
@@ -5543,6 +5730,59 @@ TEST_P(OperatorTest, TopK1int32) {
   topK1Template<int32_t>(mod_, F_, EE_, bindings_, ElemKind::Int32ITy);
 }
 
+/// Check TopK on long rows, with a K small enough to select with a heap and
+/// with a K large enough to select with a partition of the row.
+TEST_P(OperatorTest, TopKLongRows) {
+  CHECK_IF_ENABLED();
+
+  dim_t rows = 3;
+  dim_t n = 1000;
+  auto *inp =
+      mod_.createPlaceholder(ElemKind::FloatTy, {rows, n}, "input", false);
+  auto IH = bindings_.allocate(inp)->getHandle();
+  // Distinct values, each row a different permutation.
+  for (dim_t r = 0; r < rows; r++) {
+    for (dim_t i = 0; i < n; i++) {
+      IH.at({r, i}) = float(((i + r) * 379) % n) - 500;
+    }
+  }
+
+  std::vector<dim_t> ks = {10, 600};
+  std::vector<std::pair<Tensor *, Tensor *>> results;
+  for (dim_t k : ks) {
+    auto *TK = F_->createTopK("TopK" + std::to_string(k), inp, k);
+    auto *values =
+        F_->createSave("values" + std::to_string(k), TK->getValues());
+    auto *indices =
+        F_->createSave("indices" + std::to_string(k), TK->getIndices());
+    results.push_back({bindings_.allocate(values->getPlaceholder()),
+                       bindings_.allocate(indices->getPlaceholder())});
+  }
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  for (size_t t = 0; t < ks.size(); t++) {
+    auto VH = results[t].first->getHandle();
+    auto IdxH = results[t].second->getHandle<int64_t>();
+    for (dim_t r = 0; r < rows; r++) {
+      std::vector<std::pair<float, dim_t>> row;
+      for (dim_t i = 0; i < n; i++) {
+        row.push_back({IH.at({r, i}), i});
+      }
+      std::sort(row.begin(), row.end(),
+                [](const std::pair<float, dim_t> &a,
+                   const std::pair<float, dim_t> &b) {
+                  return a.first > b.first;
+                });
+      for (dim_t i = 0; i < ks[t]; i++) {
+        EXPECT_EQ(VH.at({r, i}), row[i].first);
+        EXPECT_EQ(IdxH.at({r, i}), int64_t(row[i].second));
+      }
+    }
+  }
+}
+
 TEST_P(OperatorTest, QuantizedTopK) {
   CHECK_IF_ENABLED();
 
@@ -6303,6 +6543,52 @@ TEST_P(OperatorTest, Transpose3Dims_Int8) {
   testTranspose3Dims<int8_t>(bindings_, mod_, F_, EE_, ElemKind::Int8QTy);
 }
 
+/// Helper to check the transposes between the NHWC and NCHW layouts and of
+/// the last two dimensions using \p DTy, with dimensions which are not
+/// multiples of the tiles of the backends.
+template <typename DataType>
+static void testTransposeLayouts(glow::PlaceholderBindings &bindings,
+                                 glow::Module &mod, glow::Function *F,
+                                 glow::ExecutionEngine &EE, ElemKind DTy) {
+  constexpr dim_t dims[] = {2, 37, 29, 43};
+  auto *A = createPlaceholderConditionallyQuantized(mod, DTy, dims, "A", false);
+  bindings.allocate(A)->getHandle<DataType>().randomize(-3.0, 3.0,
+                                                        mod.getPRNG());
+
+  const std::vector<std::vector<unsigned_t>> shuffles = {
+      {0, 3, 1, 2}, {0, 2, 3, 1}, {0, 1, 3, 2}};
+  std::vector<SaveNode *> saves;
+  for (const auto &shuffle : shuffles) {
+    auto *tr = F->createTranspose("tr", A, shuffle);
+    saves.push_back(F->createSave("saveTranspose", tr));
+    bindings.allocate(saves.back()->getPlaceholder());
+  }
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  for (size_t i = 0; i < shuffles.size(); ++i) {
+    const auto &shuffle = shuffles[i];
+    auto dest = createTensorConditionallyQuantized(
+        DTy, {dims[shuffle[0]], dims[shuffle[1]], dims[shuffle[2]],
+              dims[shuffle[3]]});
+    bindings.get(A)->transpose(&dest, shuffle);
+    EXPECT_TRUE(bindings.get(saves[i]->getPlaceholder())->isEqual(dest));
+  }
+}
+
+/// Test TransposeLayouts with Float.
+TEST_P(OperatorTest, TransposeLayouts_Float) {
+  CHECK_IF_ENABLED();
+  testTransposeLayouts<float>(bindings_, mod_, F_, EE_, ElemKind::FloatTy);
+}
+
+/// Test TransposeLayouts with Int8.
+TEST_P(OperatorTest, TransposeLayouts_Int8) {
+  CHECK_IF_ENABLED();
+  testTransposeLayouts<int8_t>(bindings_, mod_, F_, EE_, ElemKind::Int8QTy);
+}
+
 /// Test that Transpose optimization into Reshape yields expected results.
 TEST_P(OperatorTest, TransposeIntoReshapeOptim) {
   CHECK_IF_ENABLED();
@@ -6741,6 +7027,54 @@ TEST_P(OperatorTest, BatchedGather) {
   EXPECT_FLOAT_EQ(H.at({2, 1}), 1.2);
 }
 
+/// Test Gather of rows with runs of consecutive and repeated indices, with
+/// rows which are not a multiple of the vector size, with and without a
+/// batch dimension.
+TEST_P(OperatorTest, GatherConsecutiveRows) {
+  CHECK_IF_ENABLED();
+
+  auto *data =
+      mod_.createPlaceholder(ElemKind::FloatTy, {40, 3, 5}, "data", false);
+  auto *indices =
+      mod_.createPlaceholder(ElemKind::Int64ITy, {12}, "indices", false);
+  auto *batchedIndices =
+      mod_.createPlaceholder(ElemKind::Int64ITy, {5}, "batchedIndices", false);
+  bindings_.allocate(data)->getHandle().randomize(-1.0, 1.0, mod_.getPRNG());
+  bindings_.allocate(indices)->getHandle<int64_t>() = {3,  4,  5,  6, 6, 39,
+                                                       10, 11, 12, 0, 1, 2};
+  bindings_.allocate(batchedIndices)->getHandle<int64_t>() = {1, 2, 0, 0, 1};
+
+  auto *R = F_->createGather("gather", data, indices, 0);
+  auto *batchedR = F_->createGather("batchedGather", data, batchedIndices, 1);
+  auto *result = F_->createSave("save", R);
+  auto *batchedResult = F_->createSave("batchedSave", batchedR);
+  bindings_.allocate(result->getPlaceholder());
+  bindings_.allocate(batchedResult->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto D = bindings_.get(data)->getHandle();
+  auto IH = bindings_.get(indices)->getHandle<int64_t>();
+  auto BIH = bindings_.get(batchedIndices)->getHandle<int64_t>();
+  auto H = bindings_.get(result->getPlaceholder())->getHandle();
+  auto BH = bindings_.get(batchedResult->getPlaceholder())->getHandle();
+  for (dim_t i = 0; i < 12; i++) {
+    for (dim_t j = 0; j < 3; j++) {
+      for (dim_t k = 0; k < 5; k++) {
+        EXPECT_EQ(H.at({i, j, k}), D.at({dim_t(IH.raw(i)), j, k}));
+      }
+    }
+  }
+  for (dim_t b = 0; b < 40; b++) {
+    for (dim_t i = 0; i < 5; i++) {
+      for (dim_t k = 0; k < 5; k++) {
+        EXPECT_EQ(BH.at({b, i, k}), D.at({b, dim_t(BIH.raw(i)), k}));
+      }
+    }
+  }
+}
+
 TEST_P(OperatorTest, ScatterData) {
   CHECK_IF_ENABLED();
 
@@ -7665,6 +7999,103 @@ createAndInitConvDepthTest(glow::PlaceholderBindings &bindings,
   return std::make_pair(F, resultTensor);
 }
 
+/// Create a 3x3 stride-1 convolution eligible for the Winograd CPU kernel,
+/// whose output sizes are not multiples of the 4x4 Winograd tile.
+static FunctionTensorPair
+createAndInitWinogradConvTest(glow::PlaceholderBindings &bindings,
+                              glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {2, 9, 11, 16}, "in", false);
+  auto *conv = F->createConv(bindings, "conv", input, 24, 3, 1, 1, 1);
+  auto *bias = llvm::cast<Placeholder>(conv->getBias().getNode());
+
+  bindings.allocate(input)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(bias)->getHandle().randomize(-2.0, 2.0, mod.getPRNG());
+
+  auto *res = F->createSave("save", conv);
+  ::glow::convertPlaceholdersToConstants(F, bindings,
+                                         {input, res->getPlaceholder()});
+  auto *resultTensor = bindings.allocate(res->getPlaceholder());
+
+  return std::make_pair(F, resultTensor);
+}
+
+/// Test a float 3x3 stride-1 convolution, which the CPU backend runs with
+/// Winograd F(4x4, 3x3).
+TEST_P(OperatorStatelessTest, WinogradConvolution) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(), createAndInitWinogradConvTest,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.001f,
+                            parCloneCountOpt);
+}
+
+/// Create a convolution eligible for the im2col CPU kernel, with a
+/// \p kernel x \p kernel filter, stride \p stride and padding \p pad.
+template <unsigned_t kernel, unsigned_t stride, unsigned_t pad>
+static FunctionTensorPair
+createAndInitIm2ColConvTest(glow::PlaceholderBindings &bindings,
+                            glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {2, 9, 11, 16}, "in", false);
+  auto *conv =
+      F->createConv(bindings, "conv", input, 20, kernel, stride, pad, 1);
+  auto *bias = llvm::cast<Placeholder>(conv->getBias().getNode());
+
+  bindings.allocate(input)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(bias)->getHandle().randomize(-2.0, 2.0, mod.getPRNG());
+
+  auto *res = F->createSave("save", conv);
+  ::glow::convertPlaceholdersToConstants(F, bindings,
+                                         {input, res->getPlaceholder()});
+  auto *resultTensor = bindings.allocate(res->getPlaceholder());
+
+  return std::make_pair(F, resultTensor);
+}
+
+/// Test a float 1x1 convolution, which the CPU backend runs as a matrix
+/// product of the input rows with the filter.
+TEST_P(OperatorStatelessTest, Im2ColConvolution1x1) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitIm2ColConvTest<1, 1, 0>,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+}
+
+/// Test a float strided and padded convolution, which the CPU backend runs as
+/// an im2col matrix product.
+TEST_P(OperatorStatelessTest, Im2ColConvolution3x3Stride2) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitIm2ColConvTest<3, 2, 1>,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+}
+
+/// Test convolutions which the CPU backend splits in chunks fitting in a
+/// small cache: in rows of each sample for the Winograd convolution, and one
+/// chunk per sample for the strided im2col one.
+TEST_P(OperatorStatelessTest, CacheSplitConvolution) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  unsigned oldCacheBytes = glow::runtime::flags::CPUSplitCacheBytes;
+  glow::runtime::flags::CPUSplitCacheBytes = 28 * 1024;
+  compareAgainstInterpreter(getBackendName(), createAndInitWinogradConvTest,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.001f,
+                            parCloneCountOpt);
+  glow::runtime::flags::CPUSplitCacheBytes = 24 * 1024;
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitIm2ColConvTest<3, 2, 1>,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+  glow::runtime::flags::CPUSplitCacheBytes = oldCacheBytes;
+}
+
 TEST_P(OperatorStatelessTest, Int8ConvolutionDepth10) {
   CHECK_IF_ENABLED();
   compareAgainstInterpreter(getBackendName(), createAndInitConvDepthTest<10>,
@@ -7738,6 +8169,72 @@ TEST_P(OperatorStatelessTest, ConvolutionDepth10_Int8_BiasInt32) {
       quantization::Schema::Asymmetric, ElemKind::Int32QTy);
 }
 
+/// Create a depthwise convolution, with one filter per input channel, of a
+/// \p kernel x \p kernel filter and stride \p stride. The 70 channels are
+/// more than the block of channels of the CPU depthwise kernels.
+template <unsigned_t kernel, unsigned_t stride>
+static FunctionTensorPair
+createAndInitDepthwiseConvTest(glow::PlaceholderBindings &bindings,
+                               glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {2, 9, 11, 70}, "in", false);
+  auto *conv = F->createConv(bindings, "conv", input, 70, kernel, stride,
+                             kernel / 2, /* group */ 70);
+  auto *bias = llvm::cast<Placeholder>(conv->getBias().getNode());
+
+  bindings.allocate(input)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(bias)->getHandle().randomize(-2.0, 2.0, mod.getPRNG());
+
+  auto *res = F->createSave("save", conv);
+  ::glow::convertPlaceholdersToConstants(F, bindings,
+                                         {input, res->getPlaceholder()});
+  auto *resultTensor = bindings.allocate(res->getPlaceholder());
+
+  return std::make_pair(F, resultTensor);
+}
+
+/// Test float depthwise convolutions, which the CPU backend runs with its
+/// 3x3 and 5x5 depthwise kernels.
+TEST_P(OperatorStatelessTest, DepthwiseConvolution3x3) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitDepthwiseConvTest<3, 1>,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+}
+
+TEST_P(OperatorStatelessTest, DepthwiseConvolution5x5Stride2) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitDepthwiseConvTest<5, 2>,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+}
+
+/// Test Int8 depthwise convolutions quantized per tensor and per channel.
+TEST_P(OperatorStatelessTest, DepthwiseConvolution3x3_Int8) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(),
+                            createAndInitDepthwiseConvTest<3, 1>,
+                            ElemKind::FloatTy, ElemKind::Int8QTy, 0.05f,
+                            parCloneCountOpt);
+}
+
+TEST_P(OperatorStatelessTest, ChannelwiseQuantizedDepthwiseConvolution5x5) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(
+      getBackendName(), createAndInitDepthwiseConvTest<5, 2>,
+      ElemKind::FloatTy, ElemKind::Int8QTy, 0.05f, parCloneCountOpt,
+      /* convertToRowwiseQuantization */ false,
+      quantization::Schema::Asymmetric, ElemKind::Int32QTy,
+      /* forceFP16AccumSLS */ false,
+      PrecisionConfiguration::Float16Format::None,
+      /* convertToChannelwiseQuantization */ true);
+}
+
 TEST_P(OperatorStatelessTest, ConvolutionDepth10_Int16_BiasInt16) {
   ENABLED_BACKENDS("Interpreter");
   compareAgainstInterpreter(
@@ -7822,6 +8319,65 @@ TEST_P(OperatorTest, DynamicRowwiseQuantizedFullyConnectedBasic) {
   }
 }
 
+/// Test Int4GroupwiseQuantizedFullyConnected against the FullyConnected of
+/// its dequantized weights, on an odd number of input columns which leaves the
+/// last group partial and the last byte of the weight rows half used.
+TEST_P(OperatorTest, Int4GroupwiseQuantizedFullyConnected_Float) {
+  CHECK_IF_ENABLED();
+
+  const dim_t M = 5, K = 37, N = 11, groupSize = 16;
+  auto *input = mod_.createPlaceholder(ElemKind::FloatTy, {M, K}, "input",
+                                       false);
+  auto *weights = mod_.createConstant(ElemKind::FloatTy, {K, N}, "weights");
+  auto *bias = mod_.createConstant(ElemKind::FloatTy, {N}, "bias");
+  auto IH = bindings_.allocate(input)->getHandle();
+  IH.randomize(-1, 1, mod_.getPRNG());
+  weights->getPayloadMutable().getHandle().randomize(-2, 2, mod_.getPRNG());
+  bias->getPayloadMutable().getHandle().randomize(-1, 1, mod_.getPRNG());
+
+  auto *FC = F_->createInt4GroupwiseQuantizedFullyConnected(
+      "fc", input, weights, bias, groupSize);
+  auto *save = F_->createSave("save", FC);
+  auto *result = bindings_.allocate(save->getPlaceholder());
+
+  // Copy the weights, which the compilation may lower or erase.
+  Tensor qW = llvm::cast<Constant>(FC->getWeights().getNode())
+                  ->getPayload()
+                  .clone();
+  Tensor scales =
+      llvm::cast<Constant>(FC->getScales().getNode())->getPayload().clone();
+  Tensor offsets =
+      llvm::cast<Constant>(FC->getOffsets().getNode())->getPayload().clone();
+  Tensor B = bias->getPayload().clone();
+  Tensor W = weights->getPayload().clone();
+  auto qH = qW.getHandle<uint8_t>();
+  auto scalesH = scales.getHandle<float16_t>();
+  auto offsetsH = offsets.getHandle<float16_t>();
+  auto BH = B.getHandle();
+  auto WH = W.getHandle();
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto H = result->getHandle();
+  for (dim_t i = 0; i < M; i++) {
+    for (dim_t j = 0; j < N; j++) {
+      float expected = BH.at({j});
+      for (dim_t k = 0; k < K; k++) {
+        const uint8_t packed = qH.at({j, k / 2});
+        const uint8_t q = (k % 2) ? (packed >> 4) : (packed & 0x0f);
+        const float scale = scalesH.at({j, k / groupSize});
+        const float dequantized =
+            scale * q + float(offsetsH.at({j, k / groupSize}));
+        // The quantization error is about half a step of the group.
+        EXPECT_NEAR(dequantized, WH.at({k, j}), scale / 2 + 5e-3);
+        expected += dequantized * IH.at({i, k});
+      }
+      EXPECT_NEAR(H.at({i, j}), expected, 1e-4);
+    }
+  }
+}
+
 TEST_P(OperatorTest, DynamicQuantizedFullyConnectedBasic) {
   CHECK_IF_ENABLED();
   auto *input =
@@ -7885,6 +8441,58 @@ TEST_P(OperatorTest, DynamicQuantizedFullyConnectedStrongWeights) {
   }
 }
 
+/// Test DynamicQuantizedFullyConnected of float input and weights of nonzero
+/// offset against the FullyConnected of its dequantized weights, with more
+/// output channels than fit a block of the CPU kernel.
+TEST_P(OperatorTest, DynamicQuantizedFullyConnected_Float) {
+  CHECK_IF_ENABLED();
+
+  const dim_t M = 3, K = 21, N = 70;
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {M, K}, "input", false);
+  Constant *weights =
+      mod_.createConstant(ElemKind::Int8QTy, {K, N}, 0.02, 3, "weights");
+  Constant *bias = mod_.createConstant(ElemKind::FloatTy, {N}, "bias");
+  auto IH = bindings_.allocate(input)->getHandle();
+  IH.randomize(-2, 3, mod_.getPRNG());
+  weights->getPayloadMutable().getHandle<int8_t>().randomize(-128, 127,
+                                                             mod_.getPRNG());
+  bias->getPayloadMutable().getHandle().randomize(-1, 1, mod_.getPRNG());
+  Tensor W = weights->getPayload().clone();
+  Tensor B = bias->getPayload().clone();
+
+  auto *DQFC =
+      F_->createDynamicQuantizedFullyConnected("dqfc", input, weights, bias);
+  auto *S = F_->createSave("save", DQFC);
+  auto *result = bindings_.allocate(S->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto H = result->getHandle();
+  auto WH = W.getHandle<int8_t>();
+  auto BH = B.getHandle();
+  for (dim_t i = 0; i < M; i++) {
+    // The input row is quantized symmetrically, with an error of at most
+    // half a step of its range.
+    float absMax = 0;
+    for (dim_t k = 0; k < K; k++) {
+      absMax = std::max(absMax, std::abs(IH.at({i, k})));
+    }
+    const float step = absMax / 127;
+    for (dim_t j = 0; j < N; j++) {
+      float expected = BH.at({j});
+      float tolerance = 1e-4;
+      for (dim_t k = 0; k < K; k++) {
+        const float w = 0.02f * (WH.at({k, j}) - 3);
+        expected += w * IH.at({i, k});
+        tolerance += std::abs(w) * step / 2;
+      }
+      EXPECT_NEAR(H.at({i, j}), expected, tolerance);
+    }
+  }
+}
+
 TEST_P(OperatorTest, FCWithFlatten) {
   CHECK_IF_ENABLED();
 
@@ -8024,6 +8632,96 @@ TEST_P(OperatorStatelessTest, FullyConnected_Int8_BiasInt32) {
       quantization::Schema::Asymmetric, ElemKind::Int32QTy);
 }
 
+/// Create a FullyConnected whose input depth and output width are not
+/// multiples of the block sizes used by the packed int8 CPU kernels.
+static FunctionTensorPair
+createAndInitOddFCTest(glow::PlaceholderBindings &bindings,
+                       glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {3, 7}, "in", false);
+  auto *fc = F->createFullyConnected(bindings, "FC", input, 13);
+
+  auto *weights = llvm::cast<Placeholder>(fc->getWeights());
+  auto *bias = llvm::cast<Placeholder>(fc->getBias());
+
+  bindings.allocate(input)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(bias)->getHandle().randomize(-0.1, 0.1, mod.getPRNG());
+  bindings.get(weights)->getHandle().randomize(-0.7, 0.7, mod.getPRNG());
+
+  auto *res = F->createSave("save", fc);
+  ::glow::convertPlaceholdersToConstants(F, bindings,
+                                         {input, res->getPlaceholder()});
+  auto *resultTensor = bindings.allocate(res->getPlaceholder());
+
+  return std::make_pair(F, resultTensor);
+}
+
+/// Test Int8 FullyConnected with odd sizes and Int8 bias.
+TEST_P(OperatorStatelessTest, FullyConnected_Int8_BiasInt8_OddSizes) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(
+      getBackendName(), createAndInitOddFCTest, ElemKind::FloatTy,
+      ElemKind::Int8QTy, 0.05f, parCloneCountOpt,
+      /* convertToRowwiseQuantization */ false,
+      quantization::Schema::Asymmetric, ElemKind::Int8QTy);
+}
+
+/// Test Int8 FullyConnected with odd sizes and Int32 bias.
+TEST_P(OperatorStatelessTest, FullyConnected_Int8_BiasInt32_OddSizes) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(
+      getBackendName(), createAndInitOddFCTest, ElemKind::FloatTy,
+      ElemKind::Int8QTy, 0.05f, parCloneCountOpt,
+      /* convertToRowwiseQuantization */ false,
+      quantization::Schema::Asymmetric, ElemKind::Int32QTy);
+}
+
+/// Create a float FullyConnected whose weights are made of 1x8 blocks of 8
+/// consecutive output columns, 80% of which are zero, with sizes which are not
+/// multiples of the blocks used by the block-sparse CPU kernel.
+static FunctionTensorPair
+createAndInitSparseFCTest(glow::PlaceholderBindings &bindings,
+                          glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {5, 19}, "in", false);
+  auto *fc = F->createFullyConnected(bindings, "FC", input, 21);
+
+  auto *weights = llvm::cast<Placeholder>(fc->getWeights());
+  auto *bias = llvm::cast<Placeholder>(fc->getBias());
+
+  bindings.allocate(input)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.get(bias)->getHandle().randomize(-0.1, 0.1, mod.getPRNG());
+  auto WH = bindings.get(weights)->getHandle();
+  WH.randomize(-0.7, 0.7, mod.getPRNG());
+  for (dim_t k = 0; k < 19; k++) {
+    for (dim_t j = 0; j < 21; j++) {
+      if ((k * 3 + j / 8) % 5) {
+        WH.at({k, j}) = 0;
+      }
+    }
+  }
+
+  auto *res = F->createSave("save", fc);
+  ::glow::convertPlaceholdersToConstants(F, bindings,
+                                         {input, res->getPlaceholder()});
+  auto *resultTensor = bindings.allocate(res->getPlaceholder());
+
+  return std::make_pair(F, resultTensor);
+}
+
+/// Test a float FullyConnected with block-sparse weights, which the CPU
+/// backend runs skipping the zero blocks.
+TEST_P(OperatorStatelessTest, FullyConnected_Float_BlockSparse) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  compareAgainstInterpreter(getBackendName(), createAndInitSparseFCTest,
+                            ElemKind::FloatTy, ElemKind::FloatTy, 0.0001f,
+                            parCloneCountOpt);
+}
+
 /// Test Int16 FullyConnected with Int16 bias.
 TEST_P(OperatorStatelessTest, FullyConnected_Int16_BiasInt16) {
   ENABLED_BACKENDS("Interpreter");
@@ -8063,6 +8761,62 @@ TEST_P(OperatorTest, EntropyLossTest) {
   EXPECT_NEAR(R.at({0}), -log(0.5) - log(0.3), 0.1);
 }
 
+/// Helper to test FusedSGD with and without \p momentum, on a weight whose
+/// size is not a multiple of the vector width.
+static void testFusedSGD(glow::PlaceholderBindings &bindings, glow::Module &mod,
+                         glow::Function *F, glow::ExecutionEngine &EE,
+                         float momentum) {
+  const float L1Decay = 0.01f, L2Decay = 0.02f, learningRate = 0.1f;
+  const unsigned batchSize = 4;
+  auto *G = mod.createPlaceholder(ElemKind::FloatTy, {37}, "G", false);
+  auto *W = mod.createPlaceholder(ElemKind::FloatTy, {37}, "W", false);
+  auto *V = mod.createPlaceholder(ElemKind::FloatTy, {37}, "V", false);
+  bindings.allocate(G)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.allocate(W)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+  bindings.allocate(V)->getHandle().randomize(-1.0, 1.0, mod.getPRNG());
+
+  auto *SGD = F->addNode(new FusedSGDNode("sgd", G, W, V, L1Decay, L2Decay,
+                                          learningRate, momentum, batchSize));
+  auto *newW = F->createSave("saveW", SGD->getUpdatedWeight());
+  bindings.allocate(newW->getPlaceholder());
+  SaveNode *newV = nullptr;
+  if (momentum > 0) {
+    newV = F->createSave("saveV", SGD->getUpdatedVelocity());
+    bindings.allocate(newV->getPlaceholder());
+  }
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  auto GH = bindings.get(G)->getHandle();
+  auto WH = bindings.get(W)->getHandle();
+  auto VH = bindings.get(V)->getHandle();
+  auto newWH = bindings.get(newW->getPlaceholder())->getHandle();
+  for (dim_t i = 0; i < 37; i++) {
+    float w = WH.raw(i);
+    float g = GH.raw(i) + L1Decay * (w >= 0 ? 1 : -1) + L2Decay * w;
+    float dx = -learningRate * g / batchSize;
+    if (momentum > 0) {
+      dx += momentum * VH.raw(i);
+      EXPECT_NEAR(bindings.get(newV->getPlaceholder())->getHandle().raw(i), dx,
+                  1e-6);
+    }
+    EXPECT_NEAR(newWH.raw(i), w + dx, 1e-6);
+  }
+}
+
+/// Test the whole SGD update in a single node, without momentum.
+TEST_P(OperatorTest, FusedSGD) {
+  CHECK_IF_ENABLED();
+  testFusedSGD(bindings_, mod_, F_, EE_, /* momentum */ 0);
+}
+
+/// Test the whole SGD update in a single node, with momentum.
+TEST_P(OperatorTest, FusedSGDMomentum) {
+  CHECK_IF_ENABLED();
+  testFusedSGD(bindings_, mod_, F_, EE_, /* momentum */ 0.9);
+}
+
 /// Check that the max operator works properly with FP16.
 TEST_P(OperatorTest, FP16Max) {
   CHECK_IF_ENABLED();
@@ -12605,6 +13359,53 @@ TEST_MAX_POOL2D_LARGE_PADS(FloatTy, FloatTy, 1e-5)
 TEST_MAX_POOL2D_LARGE_PADS(Int8QTy, Int8QTy, 0.005)
 #undef TEST_MAX_POOL2D_LARGE_PADS
 
+/// Create a simple MaxPool or AvgPool network with windows large enough to be
+/// reduced in separable passes, and pads large enough to give empty windows.
+template <bool isMax, bool countIncludePads>
+static FunctionTensorPair
+createAndInitPool2DLargeWindows(glow::PlaceholderBindings &bindings,
+                                glow::ExecutionEngine &EE) {
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  std::vector<dim_t> inputDims = {2, 9, 11, 10};
+  std::vector<unsigned_t> kernels = {5, 7};
+  std::vector<unsigned_t> strides = {1, 1};
+  std::vector<unsigned_t> pads = {2, 3, 6, 8};
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, inputDims, "input", false);
+  bindings.allocate(input)->getHandle<float>().randomize(-1.0, 1.0,
+                                                         mod.getPRNG());
+  NodeValue pool;
+  if (isMax) {
+    pool = F->createMaxPool("pool", input, kernels, strides, pads)
+               ->getResult();
+  } else {
+    pool = F->createAvgPool("pool", input, kernels, strides, pads,
+                            ConvolutionLayout::NHWC, countIncludePads);
+  }
+  SaveNode *save = F->createSave("save", pool);
+  auto *resultTensor = bindings.allocate(save->getPlaceholder());
+  return std::make_pair(F, resultTensor);
+}
+
+/// Pool2D tests with large windows.
+/// Compare with the Interpreter float implementation.
+#define TEST_POOL2D_LARGE_WINDOWS(NAME, IS_MAX, COUNT_INCLUDE_PADS, TYPE, TOL) \
+  TEST_P(OperatorStatelessTest, Pool2DLargeWindows_##NAME) {                   \
+    CHECK_IF_ENABLED();                                                        \
+    compareAgainstInterpreter(                                                 \
+        getBackendName(),                                                      \
+        createAndInitPool2DLargeWindows<IS_MAX, COUNT_INCLUDE_PADS>,           \
+        ElemKind::FloatTy, ElemKind::TYPE, TOL);                               \
+  }
+TEST_POOL2D_LARGE_WINDOWS(MaxFloatTy, true, true, FloatTy, 1e-5)
+TEST_POOL2D_LARGE_WINDOWS(MaxInt8QTy, true, true, Int8QTy, 0.005)
+TEST_POOL2D_LARGE_WINDOWS(AvgFloatTy_CountIncludePads, false, true, FloatTy,
+                          1e-5)
+TEST_POOL2D_LARGE_WINDOWS(AvgFloatTy_CountExcludePads, false, false, FloatTy,
+                          1e-5)
+#undef TEST_POOL2D_LARGE_WINDOWS
+
 /// Verify that the AdaptiveAvgPool operator works correctly.
 TEST_P(OperatorTest, AdaptiveAvgPool) {
   CHECK_IF_ENABLED();
@@ -16719,6 +17520,68 @@ TEST_P(OperatorTest, RepeatedSLWSWithPartialTensors) {
   unownedTensors_.push_back(std::move(weightsReal));
 }
 
+/// Test a FullyConnected followed by a Relu with an input of which only the
+/// first rows of the batch are provided, against the same rows computed from
+/// the zero padded input.
+TEST_P(OperatorTest, FCWithPartialBatch) {
+  CHECK_IF_ENABLED();
+
+  // This test is only meaningful if the backend supports partial tensors.
+  ASSERT_TRUE(EE_.getBackend(getBackendName()).supportsPartialTensors());
+
+  constexpr dim_t maxBatch = 16;
+  constexpr dim_t batch = 5;
+  constexpr dim_t inputSize = 8;
+  constexpr dim_t outputSize = 4;
+
+  auto *input = mod_.createPlaceholder(
+      ElemKind::FloatTy, {maxBatch, inputSize}, "input", false);
+  auto *weights =
+      mod_.createConstant(ElemKind::FloatTy, {inputSize, outputSize}, "W");
+  weights->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                            mod_.getPRNG());
+  auto *bias = mod_.createConstant(ElemKind::FloatTy, {outputSize}, "B");
+  bias->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                         mod_.getPRNG());
+  auto *FC = F_->createFullyConnected("FC", input, weights, bias);
+  auto *relu = F_->createRelu("relu", FC);
+  auto *save = F_->createSave("save", relu);
+  auto *outPH = save->getPlaceholder();
+  EE_.compile(CompilationMode::Infer);
+
+  Tensor inputReal(ElemKind::FloatTy, {batch, inputSize});
+  inputReal.getHandle<float>().randomize(-1.0, 1.0, mod_.getPRNG());
+  Tensor inputPartial(inputReal.getUnsafePtr(), input->getType(),
+                      inputReal.getSizeInBytes());
+  Tensor inputPadded(input->getType());
+  inputPadded.zero();
+  memcpy(inputPadded.getUnsafePtr(), inputReal.getUnsafePtr(),
+         inputReal.getSizeInBytes());
+
+  bindings_.insert(input, std::move(inputPartial));
+  bindings_.allocate(outPH);
+
+  PlaceholderBindings paddedBindings;
+  paddedBindings.insert(input, std::move(inputPadded));
+  paddedBindings.allocate(outPH);
+
+  EE_.run(bindings_);
+  EE_.run(paddedBindings);
+
+  auto resultH = bindings_.get(outPH)->getHandle<float>();
+  auto expectedH = paddedBindings.get(outPH)->getHandle<float>();
+  for (dim_t i = 0; i < batch; i++) {
+    for (dim_t j = 0; j < outputSize; j++) {
+      EXPECT_FLOAT_EQ(resultH.at({i, j}), expectedH.at({i, j}));
+    }
+  }
+
+  // Keep this around so its memory is not freed at the end of the
+  // test/scope. This is so that inside TearDown during import/export testing
+  // the data is still around.
+  unownedTensors_.push_back(std::move(inputReal));
+}
+
 /// Helper to test gathers using partial inputs using \p ITy.
 template <typename IndicesType>
 static void
@@ -17060,6 +17923,78 @@ TEST_P(
       /* useFP16Accumulation */ true);
 }
 
+/// Helper to test ProductQuantizedSparseLengthsWeightedSum with indices of
+/// \p ITy. Each subspace of the table has exactly as many distinct subvectors
+/// as centroids, so the product quantization is lossless and the result must
+/// match the SparseLengthsWeightedSum of the float table.
+template <typename IndexType>
+static void testProductQuantizedSparseLengthsWeightedSum(
+    glow::PlaceholderBindings &bindings, glow::Module &mod, glow::Function *F,
+    glow::ExecutionEngine &EE, ElemKind ITy) {
+  Tensor data(ElemKind::FloatTy, {6, 4});
+  data.getHandle() = {
+      1.0, 2.0,  2.0,  -1.0, -1.0, 0.5, -3.0, 1.0, 1.0, 2.0, 0.5, 0.5,
+      3.0, -2.0, 1.0,  1.5,  0.0,  4.0, 0.5,  0.5, -1.0, 0.5, 2.0, -1.0,
+  };
+  Constant *weights = mod.createConstant(ElemKind::FloatTy, {8}, "weights");
+  weights->getPayloadMutable().getHandle<float>() = {
+      3., 1., 0., 0.5, 1., -2., 2., -0.5,
+  };
+  Placeholder *indices = mod.createPlaceholder(ITy, {8}, "indices",
+                                               /* isTrainable */ false);
+  Placeholder *lengths =
+      mod.createPlaceholder(ElemKind::Int32ITy, {4}, "lengths",
+                            /* isTrainable */ false);
+  bindings.allocate(indices)->getHandle<IndexType>() = {
+      1, 0, 5, 3, 4, 2, 2, 0,
+  };
+  bindings.allocate(lengths)->getHandle<int32_t>() = {
+      3,
+      0,
+      3,
+      2,
+  };
+
+  auto *R = F->createProductQuantizedSparseLengthsWeightedSum(
+      "PQSLWS", data, /* numSubspaces */ 2, weights, indices, lengths,
+      /* numCentroids */ 4);
+  SaveNode *S = F->createSave("save", R);
+  bindings.allocate(S->getPlaceholder());
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  Tensor expected(ElemKind::FloatTy, {4, 4});
+  auto DH = data.getHandle();
+  auto EH = expected.getHandle();
+  auto WH = weights->getPayload().getHandle<float>();
+  auto IH = bindings.get(indices)->getHandle<IndexType>();
+  auto LH = bindings.get(lengths)->getHandle<int32_t>();
+  expected.zero();
+  for (dim_t i = 0, curIdx = 0; i < 4; i++) {
+    for (int32_t j = 0; j < LH.raw(i); j++, curIdx++) {
+      for (dim_t k = 0; k < 4; k++) {
+        EH.at({i, k}) += WH.raw(curIdx) * DH.at({dim_t(IH.raw(curIdx)), k});
+      }
+    }
+  }
+  EXPECT_TRUE(expected.isEqual(*bindings.get(S->getPlaceholder()), 1e-5));
+}
+
+/// Test PQ-SLWS in Float.
+TEST_P(OperatorTest, ProductQuantizedSparseLengthsWeightedSum_Float) {
+  CHECK_IF_ENABLED();
+  testProductQuantizedSparseLengthsWeightedSum<int64_t>(
+      bindings_, mod_, F_, EE_, ElemKind::Int64ITy);
+}
+
+/// Test PQ-SLWS in Float. Int32 indices.
+TEST_P(OperatorTest, ProductQuantizedSparseLengthsWeightedSum_Float_Int32) {
+  CHECK_IF_ENABLED();
+  testProductQuantizedSparseLengthsWeightedSum<int32_t>(
+      bindings_, mod_, F_, EE_, ElemKind::Int32ITy);
+}
+
 static void testRowwiseQuantizedSparseLengthsSum_ConvertedFloat16(
     glow::PlaceholderBindings &bindings, glow::Module &mod, glow::Function *F,
     glow::ExecutionEngine &EE, float allowedError, bool convertFusedToFP16,
@@ -17540,12 +18475,80 @@ TEST_P(OperatorTest,
 /// Uses Float accumulation, Float for scale/offset.
 TEST_P(OperatorTest,
        FusedRowwiseQuantizedSLWSTwoColumn_Fused4Bit_Float_AccumFloat) {
-  ENABLED_BACKENDS("Interpreter");
+  ENABLED_BACKENDS("Interpreter", "CPU");
   testSLWSTwoColumn<float>(bindings_, mod_, F_, EE_, ElemKind::UInt4FusedQTy,
                            0.1,
                            /* useFP16Accumulation */ false);
 }
 
+/// Helper to test Fused-RWQ-SLWS with rows of random data that are wide
+/// enough to cover both the vectorized and the remainder parts of rows with
+/// data of type \p fusedDTy. The result is compared to that of a float SLWS
+/// on the same data with \p allowedError.
+static void testFusedRowwiseQuantizedSLWSWideRows(
+    glow::PlaceholderBindings &bindings, glow::Module &mod, glow::Function *F,
+    glow::ExecutionEngine &EE, ElemKind fusedDTy, float allowedError) {
+  const dim_t numRows = 50;
+  const dim_t rowSize = 37;
+  const dim_t numIndices = 40;
+  const dim_t numSegments = 12;
+
+  Tensor data(ElemKind::FloatTy, {numRows, rowSize});
+  data.getHandle().randomize(-1.f, 1.f, mod.getPRNG());
+
+  Placeholder *indices =
+      mod.createPlaceholder(ElemKind::Int64ITy, {numIndices}, "indices",
+                            /* isTrainable */ false);
+  Placeholder *lengths =
+      mod.createPlaceholder(ElemKind::Int32ITy, {numSegments}, "lengths",
+                            /* isTrainable */ false);
+  Placeholder *weights =
+      mod.createPlaceholder(ElemKind::FloatTy, {numIndices}, "weights",
+                            /* isTrainable */ false);
+
+  bindings.allocate(indices)->getHandle<int64_t>().randomize(0, numRows - 1,
+                                                             mod.getPRNG());
+  bindings.allocate(lengths)->getHandle<int32_t>() = {
+      3, 0, 5, 1, 4, 2, 6, 3, 0, 7, 4, 5,
+  };
+  bindings.allocate(weights)->getHandle().randomize(0.f, 0.25f,
+                                                    mod.getPRNG());
+
+  Placeholder *dataP = mod.createPlaceholder(&data.getType(), "data",
+                                             /* isTrainable */ false);
+  auto *RQSLWS = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+      "RQSLWS", data, weights, indices, lengths, fusedDTy);
+  bindings.insert(dataP, std::move(data));
+  auto *SLWS = F->createSparseLengthsWeightedSum("SLWS", dataP, weights,
+                                                 indices, lengths);
+  SaveNode *S = F->createSave("save", RQSLWS);
+  SaveNode *ref = F->createSave("ref", SLWS);
+  bindings.allocate(S->getPlaceholder());
+  bindings.allocate(ref->getPlaceholder());
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+
+  Tensor &result = *bindings.get(S->getPlaceholder());
+  Tensor &expected = *bindings.get(ref->getPlaceholder());
+  EXPECT_TRUE(expected.isEqual(result, allowedError));
+}
+
+/// Test Fused-RWQ-SLWS with wide rows in Float.
+TEST_P(OperatorTest, FusedRowwiseQuantizedSLWSWideRows_Float) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  testFusedRowwiseQuantizedSLWSWideRows(bindings_, mod_, F_, EE_,
+                                        ElemKind::UInt8FusedQTy, 0.01);
+}
+
+/// Test Fused-RWQ-SLWS with wide rows in Float with 4-bit quantization for
+/// the embedding.
+TEST_P(OperatorTest, FusedRowwiseQuantizedSLWSWideRows_Fused4Bit_Float) {
+  ENABLED_BACKENDS("Interpreter", "CPU");
+  testFusedRowwiseQuantizedSLWSWideRows(bindings_, mod_, F_, EE_,
+                                        ElemKind::UInt4FusedQTy, 0.15);
+}
+
 /// Helper to test SLWS with different lengths modes, with precision \p DTy,
 /// and precision for data \p dataDTy.
 template <typename DataType>
@@ -19110,6 +20113,43 @@ TEST_P(OperatorTest, SoftMax) {
   EXPECT_TRUE(out.isEqual(*result, 0.001));
 }
 
+/// Check SoftMax on rows which are longer than a vector and whose size is not
+/// a multiple of the vector size.
+TEST_P(OperatorTest, SoftMaxWideRows) {
+  CHECK_IF_ENABLED();
+
+  constexpr dim_t numRows = 3;
+  constexpr dim_t rowSize = 37;
+  auto *input = mod_.createPlaceholder(ElemKind::FloatTy, {numRows, rowSize},
+                                       "input", false);
+  auto inH = bindings_.allocate(input)->getHandle<float>();
+  inH.randomize(-20.0f, 20.0f, mod_.getPRNG());
+  auto *selected = mod_.createPlaceholder(ElemKind::Int64ITy, {numRows, 1},
+                                          "expected", false);
+  auto *SM = F_->createSoftMax("sm", input, selected);
+  auto *S = F_->createSave("save", SM);
+  bindings_.allocate(S->getPlaceholder());
+
+  EE_.compile(CompilationMode::Infer);
+  EE_.run(bindings_);
+
+  auto resultH = bindings_.get(S->getPlaceholder())->getHandle<float>();
+  for (dim_t n = 0; n < numRows; n++) {
+    float max = inH.at({n, 0});
+    for (dim_t i = 1; i < rowSize; i++) {
+      max = std::max(max, inH.at({n, i}));
+    }
+    double sum = 0;
+    for (dim_t i = 0; i < rowSize; i++) {
+      sum += std::exp(inH.at({n, i}) - max);
+    }
+    for (dim_t i = 0; i < rowSize; i++) {
+      EXPECT_NEAR(resultH.at({n, i}), std::exp(inH.at({n, i}) - max) / sum,
+                  1E-6);
+    }
+  }
+}
+
 /// Check that the softmax operator works properly with quantized input
 /// (int8_t). See the test that check the SoftMax operator for more details.
 TEST_P(OperatorTest, SoftMaxI8QTy) {
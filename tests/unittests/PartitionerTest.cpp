@@ -19,12 +19,16 @@
 #include "glow/Graph/Graph.h"
 #include "glow/Importer/ONNXModelLoader.h"
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Partitioner/NodeCostProfile.h"
 #include "glow/Partitioner/PartitionerUtils.h"
+#include "glow/Partitioner/RooflineReport.h"
 
 #include "llvm/Support/FileSystem.h"
 
 #include "gtest/gtest.h"
 
+#include <set>
+
 using namespace glow;
 
 class PartitionerTest : public ::testing::Test {
@@ -1305,6 +1309,61 @@ TEST_F(PartitionerTest, heterogeneousPartitioningWithSupportedNodes) {
   mod_.clear();
 }
 
+/// Test that two independent towers assigned to different backends in
+/// Heterogeneous Partition end up in partitions that don't depend on each
+/// other, instead of being interleaved into a chain of partitions. "Mul" is
+/// not supported in Interpreter backend, and "Sub" is not supported in CPU
+/// backend.
+TEST_F(PartitionerTest, heterogeneousPartitioningIndependentBranches) {
+#ifndef GLOW_WITH_CPU
+  return;
+#endif
+  auto *F = mod_.createFunction("test");
+  auto *input1 =
+      mod_.createPlaceholder(ElemKind::FloatTy, {16}, "input1", false);
+  auto *input2 =
+      mod_.createPlaceholder(ElemKind::FloatTy, {16}, "input2", false);
+  NodeValue mul = input1;
+  NodeValue sub = input2;
+  for (unsigned i = 0; i < 3; i++) {
+    mul = F->createMul("mul" + std::to_string(i), mul, input1);
+    sub = F->createSub("sub" + std::to_string(i), sub, input2);
+  }
+  auto *add = F->createAdd("add", mul, sub);
+  F->createSave("ret", add);
+
+  std::vector<DeviceInfo> devices = {{3072, "Interpreter", "Mul"},
+                                     {3072, "CPU", "Sub"}};
+  Partitioner partitioner(&mod_, devices);
+  CompilationContext cctx;
+  auto dagList = partitioner.partition(cctx);
+  ASSERT_TRUE((bool)dagList);
+  ASSERT_EQ(dagList->size(), 1);
+  ASSERT_TRUE(checkSaveNode(mod_));
+
+  // The Mul tower, the Sub tower and the Add that joins them.
+  auto &dag = dagList->front();
+  ASSERT_EQ(dag.nodes.size(), 3);
+  ASSERT_EQ(dag.root->children.size(), 2);
+  std::set<std::string> towerBackends;
+  for (auto *tower : dag.root->children) {
+    ASSERT_EQ(tower->parents.size(), 1);
+    EXPECT_EQ(tower->parents[0], dag.root.get());
+    ASSERT_EQ(tower->children.size(), 1);
+    EXPECT_EQ(tower->children[0]->backendName, "Interpreter");
+    EXPECT_EQ(tower->children[0]->parents.size(), 2);
+    towerBackends.insert(tower->backendName);
+    auto *func = mod_.getFunction(tower->name);
+    EXPECT_TRUE(findNodeInFunction(func, tower->backendName == "CPU"
+                                             ? Kinded::Kind::MulNodeKind
+                                             : Kinded::Kind::SubNodeKind));
+    EXPECT_FALSE(findNodeInFunction(func, Kinded::Kind::AddNodeKind));
+  }
+  EXPECT_EQ(towerBackends, std::set<std::string>({"CPU", "Interpreter"}));
+
+  mod_.clear();
+}
+
 /// Test assigning more than one partitions in to one device for single
 /// backendName.
 TEST_F(PartitionerTest, logicalIDTest0) {
@@ -1725,6 +1784,47 @@ TEST_F(PartitionerTest, dagValidation2) {
   EXPECT_TRUE(ERR_TO_BOOL(dagList.takeError()));
 }
 
+/// Test that partitioning moves the nodes of the partitioned function into the
+/// partitions instead of copying them.
+TEST_F(PartitionerTest, partitionMovesNodes) {
+  auto *input1 =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 10}, "input1", false);
+  auto *input2 =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 10}, "input2", false);
+  auto *input3 =
+      mod_.createPlaceholder(ElemKind::FloatTy, {2, 10}, "input3", false);
+  auto *add1 = F_->createAdd("add1", input1, input2);
+  auto *add2 = F_->createAdd("add2", add1, input3);
+  auto *sub1 = F_->createSub("sub1", add1, add2);
+  F_->createSave("save", sub1);
+
+  std::vector<DeviceInfo> devices = {{3072, "Interpreter"},
+                                     {3072, "Interpreter"}};
+
+  // User-defined partition: p1->p2.
+  PartitionConfig partitionConfig;
+  partitionConfig.funcName = "main";
+  partitionConfig.numOfPartitions = 2;
+  partitionConfig.backendNames = {"Interpreter", "Interpreter"};
+  partitionConfig.partitionNames = {"p1", "p2"};
+  partitionConfig.nodeToPartition = {{"add1", 0}};
+  auto partitioner = Partitioner(&mod_, devices, false, partitionConfig);
+  CompilationContext cctx;
+  auto dagList = partitioner.partition(cctx);
+  ASSERT_TRUE((bool)dagList);
+  EXPECT_EQ(mod_.getFunctions().size(), 2);
+
+  Function *p1 = mod_.getFunction("p1");
+  Function *p2 = mod_.getFunction("p2");
+  ASSERT_TRUE(p1 && p2);
+  EXPECT_EQ(add1->getParent(), p1);
+  EXPECT_EQ(add2->getParent(), p2);
+  EXPECT_EQ(sub1->getParent(), p2);
+  // The uses of add1 in p2 now read the placeholder saved by p1.
+  EXPECT_TRUE(llvm::isa<Placeholder>(sub1->getLHS().getNode()));
+  EXPECT_EQ(sub1->getLHS().getNode(), add2->getLHS().getNode());
+}
+
 /// This one tests partition from a user-defined config.
 TEST_F(PartitionerTest, partitionFromConfig) {
 #ifndef GLOW_WITH_CPU
@@ -2272,3 +2372,275 @@ TEST_F(PartitionerTest, saturateKDevicesTest) {
   }
   EXPECT_EQ(numOfInterpreterBackends, 1);
 }
+
+/// Test that NodeCostProfile averages measurements, survives a save/load round
+/// trip and takes precedence over the roofline estimate.
+TEST_F(PartitionerTest, nodeCostProfile) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {1, 32}, "input", false);
+  auto *w = mod_.createConstant(ElemKind::FloatTy, {32, 16}, "w");
+  auto *b = mod_.createConstant(ElemKind::FloatTy, {16}, "b");
+  auto *FC = F_->createFullyConnected("fc", input, w, b);
+  auto *sigmoid = F_->createSigmoid("sigmoid", FC);
+  F_->createSave("save", sigmoid);
+
+  NodeCostProfile profile;
+  EXPECT_TRUE(profile.empty());
+  profile.record("CPU", "fc", 10);
+  profile.record("CPU", "fc", 30);
+
+  // Only operator events, which carry a "kind" argument, are recorded.
+  std::list<TraceEvent> events;
+  events.emplace_back("sigmoid", TraceLevel::OPERATOR, 0, uint64_t(5), 0,
+                      std::map<std::string, std::string>{{"kind", "Sigmoid"}});
+  events.emplace_back("runFunction", TraceLevel::RUNTIME, 0, uint64_t(100), 0);
+  profile.addTraceEvents("CPU", events);
+  EXPECT_EQ(profile.size(), 2);
+  EXPECT_FALSE(profile.getLatencyUs("CPU", "runFunction").hasValue());
+  EXPECT_FALSE(profile.getLatencyUs("Interpreter", "fc").hasValue());
+
+  llvm::SmallString<64> path;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("nodeCostProfile", "yaml", path));
+  EXIT_ON_ERR(profile.save(path));
+  auto loaded = EXIT_ON_ERR(NodeCostProfile::load(path));
+  llvm::sys::fs::remove(path);
+  EXPECT_EQ(loaded.size(), 2);
+  EXPECT_DOUBLE_EQ(loaded.getLatencyUs("CPU", "fc").getValue(), 20);
+  EXPECT_DOUBLE_EQ(loaded.getLatencyUs("CPU", "sigmoid").getValue(), 5);
+
+  std::unique_ptr<Backend> backend(createBackend("CPU"));
+  BackendInfo backendInfo;
+  backendInfo.backend = backend.get();
+  backendInfo.peakCompute = 10e10;
+  backendInfo.peakDramBw = 40e9;
+  backendInfo.peakSramBw = 256e9;
+  backendInfo.sramCapacity = 0;
+  backendInfo.peakPCIeBw = 16e9;
+  float rooflineTime = getNodeComputeTime(FC, backendInfo);
+  backendInfo.costProfile = &loaded;
+  EXPECT_FLOAT_EQ(getNodeComputeTime(FC, backendInfo), 20e-6f);
+  EXPECT_NE(getNodeComputeTime(FC, backendInfo), rooflineTime);
+}
+
+/// Test that RooflineReport computes the FLOPs and bytes of the Nodes and
+/// flags the measured ones far from their roofline bound.
+TEST_F(PartitionerTest, rooflineReport) {
+  auto *input =
+      mod_.createPlaceholder(ElemKind::FloatTy, {1, 32}, "input", false);
+  auto *w = mod_.createConstant(ElemKind::FloatTy, {32, 16}, "w");
+  auto *b = mod_.createConstant(ElemKind::FloatTy, {16}, "b");
+  auto *FC = F_->createFullyConnected("fc", input, w, b);
+  auto *tanh = F_->createTanh("tanh", FC);
+  F_->createSave("save", tanh);
+
+  EXPECT_EQ(getNodeFlops(FC), 2u * 32 * 16);
+  EXPECT_EQ(getNodeBytesMoved(FC), (32 + 32 * 16 + 16 + 16) * sizeof(float));
+  EXPECT_EQ(getNodeFlops(tanh), 16u);
+  EXPECT_EQ(getNodeBytesMoved(tanh), 2 * 16 * sizeof(float));
+
+  DeviceInfo deviceInfo = DeviceInfo();
+  deviceInfo.sramCapacity = 1 << 20;
+  deviceInfo.peakCompute = 1e9;
+  deviceInfo.peakDramBw = 1e9;
+  deviceInfo.peakSramBw = 1e9;
+  RooflineReport report(deviceInfo, 0.5);
+  report.addFunction(F_);
+
+  std::list<TraceEvent> events;
+  events.emplace_back(
+      "fc", TraceLevel::OPERATOR, 0, uint64_t(4), 0,
+      std::map<std::string, std::string>{{"kind", "FullyConnected"}});
+  events.emplace_back("tanh", TraceLevel::OPERATOR, 0, uint64_t(100), 0,
+                      std::map<std::string, std::string>{{"kind", "Tanh"}});
+  report.addTraceEvents(events);
+
+  const auto *fcEntry = report.getEntry("fc");
+  ASSERT_TRUE(fcEntry);
+  EXPECT_NEAR(fcEntry->rooflineUs, 2.304, 1e-3);
+  EXPECT_FALSE(fcEntry->computeBound);
+  EXPECT_NEAR(fcEntry->getEfficiency(), 2.304 / 4, 1e-3);
+  EXPECT_FALSE(report.isFlagged(*fcEntry));
+
+  const auto *tanhEntry = report.getEntry("tanh");
+  ASSERT_TRUE(tanhEntry);
+  EXPECT_TRUE(report.isFlagged(*tanhEntry));
+
+  const auto *saveEntry = report.getEntry("save");
+  ASSERT_TRUE(saveEntry);
+  EXPECT_EQ(saveEntry->count, 0u);
+  EXPECT_FALSE(report.isFlagged(*saveEntry));
+  EXPECT_FALSE(report.getEntry("missing"));
+}
+
+/// Test that sampled SLS lookups are counted per table and that tables with
+/// hot lookups are spread across devices even when their cost says otherwise.
+TEST_F(PartitionerTest, SLSTableLookupBandwidthBalancing) {
+  const dim_t tableEntries = 10, tableWidth = 16;
+  const std::vector<dim_t> numIndices = {100, 100, 1};
+  std::vector<Node *> slsNodes;
+  std::vector<std::string> tableNames;
+  for (size_t i = 0; i < numIndices.size(); i++) {
+    auto *data = mod_.createConstant(ElemKind::FloatTy,
+                                     {tableEntries, tableWidth}, "table");
+    auto *indices = mod_.createPlaceholder(
+        ElemKind::Int64ITy, {numIndices[i]}, "indices", false);
+    auto *lengths =
+        mod_.createPlaceholder(ElemKind::Int32ITy, {1}, "lengths", false);
+    auto *SLS = F_->createSparseLengthsSum("SLS", data, indices, lengths);
+    F_->createSave("save", SLS);
+    bindings_.allocate(indices);
+    slsNodes.push_back(SLS);
+    tableNames.push_back(data->getName().str());
+  }
+
+  std::map<std::string, uint64_t> tableLookups;
+  accumulateSLSTableLookups(*F_, bindings_, tableLookups);
+  accumulateSLSTableLookups(*F_, bindings_, tableLookups);
+  ASSERT_EQ(tableLookups.size(), numIndices.size());
+  for (size_t i = 0; i < numIndices.size(); i++) {
+    EXPECT_EQ(tableLookups[tableNames[i]], 2 * numIndices[i]);
+    EXPECT_EQ(getSLSTableLookupBytes(slsNodes[i], tableLookups),
+              2 * numIndices[i] * tableWidth * sizeof(float));
+  }
+
+  // The cold table is the most expensive one, so balancing on cost alone
+  // puts both hot tables on the same device.
+  std::vector<SLSTableInfo> slsTables;
+  for (size_t i = 0; i < numIndices.size(); i++) {
+    const uint64_t cost = numIndices[i] == 1 ? 10 : 1;
+    slsTables.push_back({slsNodes[i], {}, {}, tableEntries * tableWidth, 0,
+                         slsNodes[i]->getNthResult(0), cost,
+                         getSLSTableLookupBytes(slsNodes[i], tableLookups)});
+  }
+  std::vector<SLSDeviceInfo> slsDevices = {{0, 1 << 20, 0}, {1, 1 << 20, 0}};
+  std::vector<std::unordered_set<NodeValue>> frontierValues(2);
+  EXIT_ON_ERR(assignSlsTablesToDevices(slsTables, slsDevices, frontierValues,
+                                       /* contextCount */ 1));
+
+  std::map<const Node *, unsigned> deviceOf;
+  for (const auto &table : slsTables) {
+    deviceOf[table.node] = table.deviceId;
+  }
+  EXPECT_NE(deviceOf[slsNodes[0]], deviceOf[slsNodes[1]]);
+  for (const auto &device : slsDevices) {
+    EXPECT_EQ(device.currentLookupBytes,
+              getSLSTableLookupBytes(slsNodes[0], tableLookups) +
+                  (deviceOf[slsNodes[2]] == device.deviceId
+                       ? getSLSTableLookupBytes(slsNodes[2], tableLookups)
+                       : 0));
+  }
+}
+
+/// Test that sharding an SLS table row-wise computes the same result as the
+/// original table.
+TEST_F(PartitionerTest, shardLargeSLSTables) {
+  const dim_t numRows = 10, width = 8, numIndices = 12, batchSize = 3;
+  Tensor table(ElemKind::FloatTy, {numRows, width});
+  table.getHandle<>().randomize(-1.0, 1.0, mod_.getPRNG());
+  Tensor indices(ElemKind::Int64ITy, {numIndices});
+  indices.getHandle<int64_t>() = {0, 9, 3, 4, 5, 1, 8, 2, 7, 6, 9, 0};
+  Tensor weights(ElemKind::FloatTy, {numIndices});
+  weights.getHandle<>().randomize(-1.0, 1.0, mod_.getPRNG());
+  Tensor lengths(ElemKind::Int32ITy, {batchSize});
+  lengths.getHandle<int32_t>() = {5, 0, 7};
+
+  auto run = [&](bool shard) {
+    ExecutionEngine EE;
+    auto &mod = EE.getModule();
+    auto *F = mod.createFunction("main");
+    auto *indicesPH = mod.createPlaceholder(ElemKind::Int64ITy, {numIndices},
+                                            "indices", false);
+    auto *weightsPH = mod.createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                            "weights", false);
+    auto *lengthsPH = mod.createPlaceholder(ElemKind::Int32ITy, {batchSize},
+                                            "lengths", false);
+    auto *SLS = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+        "SLS", table, weightsPH, indicesPH, lengthsPH);
+    auto *save = F->createSave("save", SLS);
+    if (shard) {
+      // Every fused row holds the data plus a float scale and offset.
+      const uint64_t rowBytes = width + 2 * sizeof(float);
+      unsigned numSharded = EXIT_ON_ERR(shardLargeSLSTables(F, 4 * rowBytes));
+      EXPECT_EQ(numSharded, 1);
+      unsigned numSLS = 0;
+      for (const auto &N : F->getNodes()) {
+        numSLS += isSLSNode(&N);
+      }
+      EXPECT_EQ(numSLS, 3);
+      EXPECT_TRUE(F->verify());
+    }
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    updateInputPlaceholders(bindings, {indicesPH, weightsPH, lengthsPH},
+                            {&indices, &weights, &lengths});
+    EE.compile(CompilationMode::Infer);
+    EE.run(bindings);
+    return bindings.get(save->getPlaceholder())->clone();
+  };
+
+  Tensor ref = run(/* shard */ false);
+  Tensor test = run(/* shard */ true);
+  EXPECT_TRUE(ref.isEqual(test, 1e-5));
+}
+
+/// Test that the most looked up rows are selected as hot, and that splitting
+/// them off into a hot table computes the same result as the original table.
+TEST_F(PartitionerTest, splitHotSLSTableRows) {
+  const dim_t numRows = 10, width = 8, numIndices = 12, batchSize = 3;
+  Tensor table(ElemKind::FloatTy, {numRows, width});
+  table.getHandle<>().randomize(-1.0, 1.0, mod_.getPRNG());
+  Tensor indices(ElemKind::Int64ITy, {numIndices});
+  indices.getHandle<int64_t>() = {7, 9, 3, 7, 5, 1, 7, 2, 3, 6, 9, 7};
+  Tensor weights(ElemKind::FloatTy, {numIndices});
+  weights.getHandle<>().randomize(-1.0, 1.0, mod_.getPRNG());
+  Tensor lengths(ElemKind::Int32ITy, {batchSize});
+  lengths.getHandle<int32_t>() = {5, 0, 7};
+
+  auto run = [&](bool split) {
+    ExecutionEngine EE;
+    auto &mod = EE.getModule();
+    auto *F = mod.createFunction("main");
+    auto *indicesPH = mod.createPlaceholder(ElemKind::Int64ITy, {numIndices},
+                                            "indices", false);
+    auto *weightsPH = mod.createPlaceholder(ElemKind::FloatTy, {numIndices},
+                                            "weights", false);
+    auto *lengthsPH = mod.createPlaceholder(ElemKind::Int32ITy, {batchSize},
+                                            "lengths", false);
+    auto *SLS = F->createFusedRowwiseQuantizedSparseLengthsWeightedSum(
+        "SLS", table, weightsPH, indicesPH, lengthsPH);
+    auto *save = F->createSave("save", SLS);
+
+    PlaceholderBindings bindings;
+    bindings.allocate(mod.getPlaceholders());
+    updateInputPlaceholders(bindings, {indicesPH, weightsPH, lengthsPH},
+                            {&indices, &weights, &lengths});
+    if (split) {
+      std::map<std::string, std::unordered_map<dim_t, uint64_t>> rowLookups;
+      accumulateSLSTableRowLookups(*F, bindings, rowLookups);
+      const std::string tableName = SLS->getData().getNode()->getName().str();
+      EXPECT_EQ(rowLookups[tableName][7], 4);
+      EXPECT_EQ(rowLookups[tableName][0], 0);
+
+      auto hotRows = selectHotSLSTableRows(rowLookups, /* maxHotRows */ 3);
+      EXPECT_EQ(hotRows[tableName], std::vector<dim_t>({7, 3, 9}));
+      unsigned numSplit = EXIT_ON_ERR(splitHotSLSTableRows(F, hotRows));
+      EXPECT_EQ(numSplit, 1);
+      unsigned numSLS = 0;
+      for (const auto &N : F->getNodes()) {
+        numSLS += isSLSNode(&N);
+      }
+      EXPECT_EQ(numSLS, 2);
+      EXPECT_TRUE(F->verify());
+    }
+
+    EE.compile(CompilationMode::Infer);
+    EE.run(bindings);
+    return bindings.get(save->getPlaceholder())->clone();
+  };
+
+  Tensor ref = run(/* split */ false);
+  Tensor test = run(/* split */ true);
+  EXPECT_TRUE(ref.isEqual(test, 1e-5));
+}
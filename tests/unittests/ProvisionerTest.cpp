@@ -15,10 +15,14 @@
  */
 #include "glow/Runtime/Provisioner/Provisioner.h"
 #include "../../lib/Backends/CPU/CPUDeviceManager.h"
+#include "glow/Flags/Flags.h"
 #include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Runtime/Provisioner/CompiledFunctionCache.h"
 
 #include "gtest/gtest.h"
 
+#include "llvm/Support/FileSystem.h"
+
 using namespace glow;
 using namespace glow::runtime;
 
@@ -127,3 +131,158 @@ TEST_F(ProvisionerTest, provisionFailCleanup) {
   // Expect that there was an Error when provisioning
   EXPECT_TRUE(ERR_TO_BOOL(std::move(err)));
 }
+
+/// A saturateHost replica that doesn't fit in the memory left on the devices
+/// is dropped, the network is still added with its other instances.
+TEST_F(ProvisionerTest, provisionDropsReplicasWithoutMemory) {
+  DeviceConfig configBig("CPU");
+  configBig.setDeviceMemory(6 * 1024 * 1024);
+  DeviceConfig configSmall("CPU");
+  configSmall.setDeviceMemory(1000);
+  DeviceManagerMapTy devices;
+  devices.emplace(0, glow::make_unique<CPUDeviceManager>(configBig));
+  devices.emplace(1, glow::make_unique<CPUDeviceManager>(configSmall));
+
+  auto mod = setupModule(1);
+  auto networks = setupDAG(1, 0);
+  DAGNode *node = networks[0].nodes[0].get();
+  node->size = 5 * 1024 * 1024;
+  node->instanceCount = 2;
+  CompilationContext cctx;
+  Provisioner provisioner(devices);
+  EXPECT_FALSE(ERR_TO_BOOL(provisioner.provision(networks, *mod, cctx)));
+  EXPECT_EQ(node->logicalDevices, std::vector<DeviceIDTy>({0}));
+  EXPECT_EQ(node->instanceCount, 1);
+  ASSERT_EQ(node->deviceRuntimeInfos.size(), 1);
+  EXPECT_EQ(node->deviceRuntimeInfos.count(0), 1);
+}
+
+TEST_F(ProvisionerTest, provisionIdenticalPartitionsInParallel) {
+  // function1 is an exact copy of function0, using the same Placeholders and
+  // Constants, so both partitions share a single compiled function.
+  auto mod = setupModule(1);
+  mod->getFunction("function0")->clone("function1");
+  mod->getFunction("function0")->clone("function2");
+  auto networks = setupDAG(1, 2);
+
+  DeviceManagerMapTy devices;
+  for (int i = 0; i < 2; i++) {
+    std::unique_ptr<DeviceManager> device(
+        new CPUDeviceManager(DeviceConfig("CPU")));
+    devices.emplace(i, std::move(device));
+  }
+
+  const unsigned oldThreads = runtime::flags::NumCompilationThreads;
+  runtime::flags::NumCompilationThreads = 4;
+  CompilationContext cctx;
+  Provisioner provisioner(devices);
+  runtime::flags::NumCompilationThreads = oldThreads;
+  auto err = provisioner.provision(networks, *mod.get(), cctx);
+  ASSERT_FALSE(ERR_TO_BOOL(std::move(err)));
+  for (auto &node : networks.front().nodes) {
+    ASSERT_TRUE(node->runtimeBundle);
+    EXPECT_EQ(node->runtimeBundle->getConstantWeightSize(),
+              networks.front().nodes.front()->runtimeBundle
+                  ->getConstantWeightSize());
+  }
+}
+
+/// Test that the payloads of the Constants are released once all the
+/// Functions using them are added to their devices, unless the module is kept.
+TEST_F(ProvisionerTest, provisionReleasesConstants) {
+  for (bool skipModuleStrip : {false, true}) {
+    // function2 uses the Constants of function0 but is not provisioned.
+    auto mod = setupModule(2);
+    mod->getFunction("function0")->clone("function2");
+    auto networks = setupDAG(1, 1);
+
+    DeviceManagerMapTy devices;
+    for (int i = 0; i < 2; i++) {
+      std::unique_ptr<DeviceManager> device(
+          new CPUDeviceManager(DeviceConfig("CPU")));
+      devices.emplace(i, std::move(device));
+    }
+
+    CompilationContext cctx;
+    cctx.skipModuleStrip = skipModuleStrip;
+    Provisioner provisioner(devices);
+    ASSERT_FALSE(
+        ERR_TO_BOOL(provisioner.provision(networks, *mod.get(), cctx)));
+    for (Constant *C : mod->getFunction("function0")->findConstants()) {
+      EXPECT_FALSE(C->getPayload().isUnowned());
+    }
+    for (Constant *C : mod->getFunction("function1")->findConstants()) {
+      EXPECT_EQ(C->getPayload().isUnowned(), !skipModuleStrip);
+    }
+  }
+}
+
+namespace {
+/// Minimal in-memory BlockStream used to feed CompiledFunctionCache.
+class VectorBlockStream : public BlockStreamBase {
+public:
+  size_t read(char *buffer, size_t size) override {
+    size = std::min(size, data_.size() - readPos_);
+    std::copy_n(data_.data() + readPos_, size, buffer);
+    readPos_ += size;
+    return size;
+  }
+  size_t write(const char *buffer, size_t size) override {
+    data_.insert(data_.end(), buffer, buffer + size);
+    return size;
+  }
+  size_t getSize() override { return data_.size(); }
+  void releaseMemory() override { data_.clear(); }
+
+private:
+  std::vector<char> data_;
+  size_t readPos_{0};
+};
+} // namespace
+
+TEST_F(ProvisionerTest, compiledFunctionCacheKey) {
+  auto mod = setupModule(1);
+  std::unique_ptr<Backend> backend(createBackend("CPU"));
+  BackendOptions opts;
+  auto *F0 = mod->getFunction("function0");
+  auto *F1 = F0->clone("function1");
+
+  // Identical graphs using the same weights share a key regardless of the
+  // Function name.
+  auto key0 = CompiledFunctionCache::getKey(*F0, *backend, opts);
+  EXPECT_EQ(key0, CompiledFunctionCache::getKey(*F1, *backend, opts));
+
+  // The deserialization switch doesn't affect the key.
+  opts.useDeserialize = true;
+  EXPECT_EQ(key0, CompiledFunctionCache::getKey(*F0, *backend, opts));
+  opts.useDeserialize = false;
+
+  // Backend options do.
+  opts.backendSpecificOpts["CPU_opt"] = "1";
+  EXPECT_NE(key0, CompiledFunctionCache::getKey(*F0, *backend, opts));
+  opts.backendSpecificOpts.clear();
+
+  // So do the weights.
+  F0->findConstants().front()->getPayloadMutable().getHandle<float>().raw(0) +=
+      1;
+  EXPECT_NE(key0, CompiledFunctionCache::getKey(*F0, *backend, opts));
+}
+
+TEST_F(ProvisionerTest, compiledFunctionCacheStore) {
+  llvm::SmallString<64> dir;
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory("glow-cfc", dir));
+  CompiledFunctionCache cache(dir);
+
+  EXPECT_FALSE(cache.load("missing").hasValue());
+
+  const std::string payload = "serialized function";
+  VectorBlockStream stream;
+  stream.write(payload.data(), payload.size());
+  ASSERT_FALSE(ERR_TO_BOOL(cache.store("entry", stream)));
+
+  auto data = cache.load("entry");
+  ASSERT_TRUE(data.hasValue());
+  EXPECT_EQ(std::string(data->begin(), data->end()), payload);
+
+  llvm::sys::fs::remove_directories(dir);
+}
@@ -104,6 +104,91 @@ public:
 };
 
 /// Simple tests to verify the histogram rescale.
+/// Reference scalar version of quantization::generateTensorHistogram, which
+/// rescales the histogram through a copy and bins every element with a
+/// division.
+static void referenceTensorHistogram(const std::vector<float> &input,
+                                     std::vector<float> &hist, float &min,
+                                     float &max) {
+  float minInput = *std::min_element(input.begin(), input.end());
+  float maxInput = *std::max_element(input.begin(), input.end());
+  if (std::all_of(hist.begin(), hist.end(), [](float h) { return h == 0; })) {
+    min = minInput;
+    max = maxInput;
+  }
+  const size_t nBins = hist.size();
+  auto getBin = [&](float binWidth, float minValue, float value) -> size_t {
+    return binWidth == 0
+               ? 0
+               : std::min(static_cast<size_t>((value - minValue) / binWidth),
+                          nBins - 1);
+  };
+  if (minInput < min || maxInput > max) {
+    float newMin = std::min(minInput, min);
+    float newMax = std::max(maxInput, max);
+    float destBinWidth = (newMax - newMin) / nBins;
+    float srcBinWidth = (max - min) / nBins;
+    std::vector<float> scaledHist(nBins, 0);
+    for (size_t i = 0; i < nBins; ++i) {
+      if (hist[i] == 0) {
+        continue;
+      }
+      float srcBinBegin = min + srcBinWidth * i;
+      size_t destBin = (srcBinBegin - newMin) / destBinWidth;
+      float destBinEnd = newMin + destBinWidth * (destBin + 1);
+      uint64_t dstBinCnt = static_cast<uint64_t>(std::min(
+          static_cast<float>(
+              round((destBinEnd - srcBinBegin) / srcBinWidth * hist[i])),
+          hist[i]));
+      scaledHist[getBin(destBinWidth, newMin, srcBinBegin)] += dstBinCnt;
+      if (dstBinCnt < hist[i]) {
+        scaledHist[getBin(destBinWidth, newMin, srcBinBegin + destBinWidth)] +=
+            hist[i] - dstBinCnt;
+      }
+    }
+    hist = scaledHist;
+    min = newMin;
+    max = newMax;
+  }
+  float binWidth = (max - min) / nBins;
+  for (float elem : input) {
+    hist[getBin(binWidth, min, elem)]++;
+  }
+}
+
+/// Verify that generateTensorHistogram, which rescales the histogram in place
+/// and bins blocks of elements, matches the reference version while the range
+/// grows in one or both directions.
+TEST(Quantization, generateTensorHistogramTest) {
+  PseudoRNG PRNG;
+  const size_t nBins = 1000;
+  Tensor hist(ElemKind::FloatTy, {nBins});
+  hist.zero();
+  std::vector<float> refHist(nBins, 0);
+  float min = 0, max = 0;
+  float refMin = 0, refMax = 0;
+  const std::vector<std::pair<float, float>> ranges = {
+      {-1.0f, 1.0f}, {-1.0f, 3.0f}, {-7.0f, 3.0f}, {-9.0f, 30.0f},
+      {-9.0f, 30.0f}, {-200.0f, 31.0f}, {5.0f, 5.0f}};
+  for (const auto &range : ranges) {
+    Tensor input(ElemKind::FloatTy, {1000});
+    input.getHandle().randomize(range.first, range.second, PRNG);
+    input.getHandle().raw(0) = range.first;
+    input.getHandle().raw(1) = range.second;
+    std::vector<float> inputVec(input.getHandle().begin(),
+                                input.getHandle().end());
+    quantization::generateTensorHistogram(input.getHandle(),
+                                          hist.getHandle(), min, max);
+    referenceTensorHistogram(inputVec, refHist, refMin, refMax);
+    EXPECT_EQ(min, refMin);
+    EXPECT_EQ(max, refMax);
+    auto histH = hist.getHandle();
+    for (size_t i = 0; i < nBins; i++) {
+      EXPECT_EQ(histH.raw(i), refHist[i]);
+    }
+  }
+}
+
 TEST(Quantization, rescaleHistogramTest) {
   EXPECT_EQ(quantization::rescaleHistogram({}, 0.0f, 1.0f, 0.0f, 2.0).size(),
             0);
@@ -115,6 +200,36 @@ TEST(Quantization, rescaleHistogramTest) {
       std::vector<float>({3, 3, 4, 4}));
 }
 
+TEST(Quantization, combineTensorProfilingParamsTest) {
+  // A profile which has not seen any value is ignored.
+  TensorProfilingParams dest(0.0f, 1.0f, std::vector<float>({1, 2, 3, 4}));
+  TensorProfilingParams emptyTPP(1.0f, 0.0f, std::vector<float>(4, 0));
+  quantization::combineTensorProfilingParams(dest, emptyTPP);
+  EXPECT_EQ(dest.min, 0.0f);
+  EXPECT_EQ(dest.max, 1.0f);
+  EXPECT_EQ(dest.histogram, std::vector<float>({1, 2, 3, 4}));
+
+  // Profiles of the same range add up.
+  TensorProfilingParams sameRangeTPP(0.0f, 1.0f,
+                                     std::vector<float>({4, 3, 2, 1}));
+  quantization::combineTensorProfilingParams(dest, sameRangeTPP);
+  EXPECT_EQ(dest.histogram, std::vector<float>({5, 5, 5, 5}));
+
+  // Profiles of different ranges are rescaled to the union of the ranges.
+  TensorProfilingParams otherRangeTPP(-1.0f, 0.0f,
+                                      std::vector<float>({1, 1, 1, 1}));
+  quantization::combineTensorProfilingParams(dest, otherRangeTPP);
+  EXPECT_EQ(dest.min, -1.0f);
+  EXPECT_EQ(dest.max, 1.0f);
+  EXPECT_EQ(dest.histogram, std::vector<float>({2, 2, 10, 10}));
+
+  // A profile of a single value lands in the bin of that value.
+  TensorProfilingParams singleValueTPP(0.9f, 0.9f,
+                                       std::vector<float>({3, 0, 0, 0}));
+  quantization::combineTensorProfilingParams(dest, singleValueTPP);
+  EXPECT_EQ(dest.histogram, std::vector<float>({2, 2, 10, 13}));
+}
+
 /// Simple tests to verify the KL optimization.
 TEST(Quantization, optimizeKLTest) {
   // Test that an all-zero histogram does not raise exceptions.
@@ -146,6 +261,21 @@ void testProfilingInfosSerialization(std::vector<NodeProfilingInfo> &expected) {
   EXPECT_TRUE(fileExists);
   EXPECT_EQ(static_cast<size_t>(hash), static_cast<size_t>(hashDeserialized));
   EXPECT_EQ(expected, deserialized);
+
+  // Round trip through both formats, detected when loading.
+  for (const char *suffix : {"yaml", "bin"}) {
+    llvm::SmallVector<char, 10> path;
+    llvm::sys::fs::createTemporaryFile("prefix", suffix, path);
+    std::string fileName(path.begin(), path.end());
+    serializeProfilingInfos(fileName, hash, expected);
+    std::vector<NodeProfilingInfo> loaded;
+    llvm::hash_code hashLoaded;
+    fileExists = deserializeProfilingInfos(fileName, hashLoaded, loaded);
+    llvm::sys::fs::remove(fileName);
+    EXPECT_TRUE(fileExists);
+    EXPECT_EQ(static_cast<size_t>(hash), static_cast<size_t>(hashLoaded));
+    EXPECT_EQ(expected, loaded);
+  }
 }
 
 TEST(Quantization, DeserializeNonExistingFile) {
@@ -157,6 +287,29 @@ TEST(Quantization, DeserializeNonExistingFile) {
   EXPECT_FALSE(fileExists);
 }
 
+TEST(Quantization, NodePrecisionsSerialize) {
+  llvm::StringMap<quantization::NodePrecision> expected;
+  expected["conv"] = quantization::NodePrecision::ChannelwiseQuantized;
+  expected["fc"] = quantization::NodePrecision::Quantized;
+  expected["softmax"] = quantization::NodePrecision::FP32;
+  expected["tanh"] = quantization::NodePrecision::FP16;
+  llvm::SmallVector<char, 10> resultPath;
+  llvm::sys::fs::createTemporaryFile("prefix", "yaml", resultPath);
+  std::string filePath(resultPath.begin(), resultPath.end());
+  serializeNodePrecisions(filePath, expected);
+  llvm::StringMap<quantization::NodePrecision> deserialized;
+  auto fileExists = deserializeNodePrecisions(filePath, deserialized);
+  llvm::sys::fs::remove(filePath);
+  EXPECT_TRUE(fileExists);
+  ASSERT_EQ(expected.size(), deserialized.size());
+  for (const auto &entry : expected) {
+    auto it = deserialized.find(entry.getKey());
+    ASSERT_NE(it, deserialized.end());
+    EXPECT_EQ(entry.getValue(), it->getValue());
+  }
+  EXPECT_FALSE(deserializeNodePrecisions("/fake", deserialized));
+}
+
 TEST(Quantization, ProfilingSerialize) {
   std::vector<float> histEmpty;
   std::vector<float> hist = {0, 1, 2, 3, 4};
@@ -1321,6 +1474,68 @@ TEST(Quantization, quantizeLookupTables) {
   EXPECT_EQ(logILT->getInput().getType()->getOffset(), logInpTQP.offset);
 }
 
+/// Quantize HardSwish and Gelu nodes and make sure that quantized versions are
+/// implemented as IntLookupTables mapping between the profiled types, because
+/// the Interpreter does not support them as quantized.
+TEST(Quantization, quantizeActivationLookupTables) {
+  ExecutionEngine EE{};
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  auto *input = mod.createPlaceholder(ElemKind::FloatTy, {1, 3}, "input", true);
+  auto *HSN = F->createHardSwish("hardswish", input);
+  auto *GN = F->createGelu("gelu", HSN);
+  auto *ret = F->createSave("ret", GN);
+
+  quantization::QuantizationConfiguration quantConfig{
+      {{input->getOutput().generateNodeOutputName(), {-4.0f, 4.0f}},
+       {HSN->getResult().generateNodeOutputName(), {-0.5f, 4.0f}},
+       {GN->getResult().generateNodeOutputName(), {-0.2f, 4.0f}}}};
+  quantConfig.assertAllNodesQuantized = true;
+  std::unique_ptr<Backend> backend(createBackend(EE.getBackendName()));
+  quantization::quantizeFunction(F, quantConfig, *backend);
+  optimize(F, CompilationMode::Infer);
+
+  auto inpTQP = chooseQuantizationParams({-4.0, 4.0}, quantConfig.schema,
+                                         quantConfig.precision);
+  auto hardSwishTQP = chooseQuantizationParams(
+      {-0.5, 4.0}, quantConfig.schema, quantConfig.precision);
+  auto geluTQP = chooseQuantizationParams({-0.2, 4.0}, quantConfig.schema,
+                                          quantConfig.precision);
+
+  auto *save = llvm::cast<SaveNode>(F->getNodeByName(ret->getName()));
+  auto *dequantizeGelu =
+      llvm::dyn_cast<DequantizeNode>(save->getInput().getNode());
+  ASSERT_TRUE(dequantizeGelu);
+  auto *geluILT =
+      llvm::dyn_cast<IntLookupTableNode>(dequantizeGelu->getInput().getNode());
+  ASSERT_TRUE(geluILT);
+  EXPECT_FLOAT_EQ(geluILT->getResult().getType()->getScale(), geluTQP.scale);
+  EXPECT_EQ(geluILT->getResult().getType()->getOffset(), geluTQP.offset);
+
+  auto *hardSwishILT =
+      llvm::dyn_cast<IntLookupTableNode>(geluILT->getInput().getNode());
+  ASSERT_TRUE(hardSwishILT);
+  EXPECT_FLOAT_EQ(hardSwishILT->getResult().getType()->getScale(),
+                  hardSwishTQP.scale);
+  EXPECT_EQ(hardSwishILT->getResult().getType()->getOffset(),
+            hardSwishTQP.offset);
+  EXPECT_FLOAT_EQ(hardSwishILT->getInput().getType()->getScale(),
+                  inpTQP.scale);
+  EXPECT_EQ(hardSwishILT->getInput().getType()->getOffset(), inpTQP.offset);
+
+  // The entries of the table are the quantized results of HardSwish, up to
+  // the rounding of the inputs the table is computed for.
+  auto *hardSwishMapping =
+      llvm::cast<Constant>(hardSwishILT->getMapping().getNode());
+  auto mappingH = hardSwishMapping->getPayload().getHandle<int8_t>();
+  for (int i = -128; i < 128; i++) {
+    float x = quantization::dequantize<int8_t>(i, inpTQP);
+    float expected = x * std::min(std::max(x + 3.0f, 0.0f), 6.0f) / 6.0f;
+    EXPECT_NEAR(mappingH.raw(i + 128),
+                quantization::quantize<int8_t>(expected, hardSwishTQP), 1);
+  }
+}
+
 /// Quantize Log, Sigmoid, and Tanh nodes and make sure that they are not
 /// replaced by LookupTables because the backend supports them directly.
 TEST(Quantization, quantizeWithoutLookupTables) {
@@ -2361,6 +2576,58 @@ TEST(Quantization, quantizeGraphPartially) {
   }
 }
 
+/// Test the precisions of specific nodes: a Convolution quantized channelwise
+/// without the enableChannelwise option and a Tanh kept in floating point.
+TEST(Quantization, quantizeGraphWithNodePrecisions) {
+  ExecutionEngine EE{};
+  PlaceholderBindings bindings;
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {5, 3, 3, 2}, "input", false);
+  bindings.allocate(input)->getHandle<float>().randomize(-1.0, 1.0,
+                                                         mod.getPRNG());
+  auto *filterC = mod.createConstant(ElemKind::FloatTy, {4, 2, 2, 2}, "filter");
+  filterC->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                            mod.getPRNG());
+  auto *biasC = mod.createConstant(ElemKind::FloatTy, {4}, "bias");
+  biasC->getPayloadMutable().getHandle<float>().randomize(-1.0, 1.0,
+                                                          mod.getPRNG());
+  auto *outTy = mod.uniqueType(ElemKind::FloatTy, {5, 2, 2, 4});
+  auto *conv = F->createConv("conv", input, filterC, biasC, outTy, {2, 2},
+                             {1, 1}, {0, 0, 0, 0}, 1);
+  auto *TN = F->createTanh("tanh", conv);
+  auto *save = F->createSave("ret", TN);
+  bindings.allocate(save->getPlaceholder());
+
+  quantization::QuantizationConfiguration quantConfig{{
+      {input->getOutput().generateNodeOutputName(), {-1.0f, 1.0f}},
+      {filterC->getOutput().generateNodeOutputName(), {-1.0f, 1.0f}},
+      {biasC->getOutput().generateNodeOutputName(), {-1.0f, 1.0f}},
+      {conv->getResult().generateNodeOutputName(), {-4.0f, 4.0f}},
+      {TN->getResult().generateNodeOutputName(), {-1.0f, 1.0f}},
+  }};
+  quantConfig.nodePrecisions["conv"] =
+      quantization::NodePrecision::ChannelwiseQuantized;
+  quantConfig.nodePrecisions["tanh"] = quantization::NodePrecision::FP32;
+  quantConfig.assertAllNodesQuantized = true;
+  std::unique_ptr<Backend> backend(createBackend(EE.getBackendName()));
+  quantization::quantizeFunction(F, quantConfig, *backend);
+
+  auto *SN = llvm::dyn_cast<SaveNode>(F->getNodeByName(save->getName()));
+  ASSERT_TRUE(SN);
+  auto *tanh = llvm::dyn_cast<TanhNode>(SN->getInput());
+  ASSERT_TRUE(tanh);
+  EXPECT_FALSE(tanh->getResult().getType()->isQuantizedType());
+  auto *DN = llvm::dyn_cast<DequantizeNode>(tanh->getInput());
+  ASSERT_TRUE(DN);
+  EXPECT_TRUE(llvm::isa<ChannelwiseQuantizedConvolutionNode>(DN->getInput()));
+
+  EE.compile(CompilationMode::Infer);
+  EE.run(bindings);
+}
+
 /// Test option to disable quantization of specific node kinds in the graph,
 /// where there are multiple of that node kind.
 TEST(Quantization, quantizeGraphPartiallyMultipleNodes) {
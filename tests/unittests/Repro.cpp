@@ -321,7 +321,7 @@ class ZipFileBackedDeferredBlobLoader
     : public ::glow::runtime::DeferredWeightLoader {
 public:
   explicit ZipFileBackedDeferredBlobLoader(const std::string &path) {
-    zip_ = ::glow::make_unique<::glow::ZipReader>(path);
+    zip_ = ::glow::make_unique<::glow::ZipReader>(path, /* mapFile */ true);
     CHECK(zip_);
     auto numWeightsStr = zip_->getRecord("weights");
     weightsToLoad_ = atoi(numWeightsStr.c_str());
@@ -339,9 +339,9 @@ public:
 
     std::stringstream ss;
     ss << "weight_" << i_;
-    largeBuffer_ = zip_->getRecord(ss.str());
+    auto tensorProto = zip_->getRecordView(ss.str());
     ::ONNX_NAMESPACE::TensorProto t;
-    t.ParseFromString(largeBuffer_);
+    t.ParseFromArray(tensorProto.data(), tensorProto.size());
 
     currentBlobName_ = glow::legalizeName(t.name());
     auto tyIdx = typeInfo_.find(currentBlobName_);
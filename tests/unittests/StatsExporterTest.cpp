@@ -85,6 +85,18 @@ TEST(StatsExporter, TimeSeries) {
   EXPECT_EQ(ts[2], 2.71);
 }
 
+TEST(StatsExporter, Histogram) {
+  LatencyHistogram histogram;
+  for (unsigned i = 0; i < 100; i++) {
+    histogram.record(10);
+  }
+  StatsExporterRegistry::Stats()->addHistogram("baz", histogram);
+  EXPECT_EQ(MockStats.counters["baz.count"], 100);
+  EXPECT_EQ(MockStats.counters["baz.p50"], 10);
+  EXPECT_EQ(MockStats.counters["baz.p99"], 10);
+  EXPECT_EQ(MockStats.counters["baz.p999"], 10);
+}
+
 TEST(StatsExporter, Device) {
   using namespace glow::runtime;
   EXPECT_EQ(MockStats.counters.count("glow.devices_used.interpreter"), 0);
@@ -139,3 +151,78 @@ TEST(StatsExporter, HostManager) {
   }
   EXPECT_EQ(MockStats.counters["glow.devices_used.interpreter"], 0);
 }
+
+TEST(StatsExporter, HostManagerLatencyHistograms) {
+  using namespace glow::runtime;
+  auto deviceConfig = glow::make_unique<DeviceConfig>("Interpreter");
+  std::vector<std::unique_ptr<DeviceConfig>> configs;
+  configs.push_back(std::move(deviceConfig));
+  std::unique_ptr<HostManager> HM =
+      glow::make_unique<HostManager>(std::move(configs), HostConfig());
+
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  auto *pow = F->createPow("Pow", X, 2.0);
+  auto *save = F->createSave("save", pow);
+  CompilationContext cctx;
+  EXIT_ON_ERR(HM->addNetwork(std::move(module), cctx));
+
+  auto context = glow::make_unique<ExecutionContext>();
+  context->getPlaceholderBindings()->allocate(X)->zero();
+  context->getPlaceholderBindings()->allocate(save->getPlaceholder());
+  EXIT_ON_ERR(HM->runNetworkBlocking("main", context));
+  HM->exportLatencyHistograms();
+
+  EXPECT_EQ(MockStats.counters["glow.latency.queue_wait.main.count"], 1);
+  EXPECT_EQ(MockStats.counters["glow.latency.execution.main.count"], 1);
+  // The callback histogram is updated after the blocking call returns, so
+  // only check it was exported.
+  EXPECT_EQ(MockStats.counters.count("glow.latency.callback.main.count"), 1);
+  EXPECT_EQ(MockStats.counters.count("glow.latency.device.main.count"), 1);
+}
+
+TEST(StatsExporter, HostManagerResultCache) {
+  using namespace glow::runtime;
+  auto deviceConfig = glow::make_unique<DeviceConfig>("Interpreter");
+  std::vector<std::unique_ptr<DeviceConfig>> configs;
+  configs.push_back(std::move(deviceConfig));
+  std::unique_ptr<HostManager> HM =
+      glow::make_unique<HostManager>(std::move(configs), HostConfig());
+
+  std::unique_ptr<Module> module = glow::make_unique<Module>();
+  Function *F = module->createFunction("main");
+  auto *X = module->createPlaceholder(ElemKind::FloatTy, {3}, "X", false);
+  auto *pow = F->createPow("Pow", X, 2.0);
+  auto *save = F->createSave("save", pow);
+  auto *output = save->getPlaceholder();
+  CompilationContext cctx;
+  EXIT_ON_ERR(HM->addNetwork(std::move(module), cctx));
+  EXIT_ON_ERR(HM->setResultCache("main", ResultCacheConfig()));
+
+  auto run = [&](float x) {
+    auto context = glow::make_unique<ExecutionContext>();
+    context->getPlaceholderBindings()->allocate(X)->getHandle() = {x, x, x};
+    context->getPlaceholderBindings()->allocate(output)->zero();
+    EXIT_ON_ERR(HM->runNetworkBlocking("main", context));
+    EXPECT_EQ(context->getPlaceholderBindings()->get(output)->getHandle().at(
+                  {0}),
+              x * x);
+  };
+
+  // The second run with the same input is served from the cache, the one
+  // with another input is not.
+  run(2);
+  run(2);
+  run(3);
+  EXPECT_EQ(MockStats.counters["glow.result_cache.hits.main"], 1);
+  EXPECT_EQ(MockStats.counters["glow.result_cache.misses.main"], 2);
+  EXPECT_EQ(MockStats.counters["glow.result_cache.bytes.main"],
+            4 * 3 * sizeof(float));
+
+  // Disabling the cache drops its results.
+  EXIT_ON_ERR(HM->setResultCache("main", llvm::None));
+  run(2);
+  EXPECT_EQ(MockStats.counters["glow.result_cache.hits.main"], 1);
+  EXPECT_EQ(MockStats.counters["glow.result_cache.bytes.main"], 0);
+}
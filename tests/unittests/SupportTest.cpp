@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "glow/Support/LatencyHistogram.h"
+#include "glow/Support/Memory.h"
 #include "glow/Support/Support.h"
 #include "glow/Testing/StrCheck.h"
 #include "gtest/gtest.h"
@@ -171,3 +173,60 @@ TEST(Support, ArrayRefPrinting) {
   oss << shortArr << longArr;
   EXPECT_TRUE(oss.str().compare("[0, 0, 0, 0][0, 0, 0, 0, ...]") == 0);
 }
+
+TEST(Support, LatencyHistogramBuckets) {
+  // Every value falls into a bucket whose bounds contain it, and buckets are
+  // at most 1/kSubBuckets wide relative to their values.
+  for (uint64_t v : {0ul, 1ul, 15ul, 16ul, 17ul, 31ul, 32ul, 33ul, 1000ul,
+                     123456789ul, ~0ul}) {
+    size_t idx = LatencyHistogram::getBucketIndex(v);
+    ASSERT_LT(idx, LatencyHistogram::kNumBuckets);
+    uint64_t upper = LatencyHistogram::getBucketUpperBound(idx);
+    EXPECT_GE(upper, v);
+    EXPECT_LE(upper - v, v / LatencyHistogram::kSubBuckets);
+    if (idx > 0) {
+      EXPECT_LT(LatencyHistogram::getBucketUpperBound(idx - 1), v);
+    }
+  }
+}
+
+TEST(Support, LatencyHistogramPercentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.getPercentile(0.5), 0);
+  for (uint64_t v = 1; v <= 1000; v++) {
+    histogram.record(v);
+  }
+  EXPECT_EQ(histogram.getCount(), 1000);
+  EXPECT_EQ(histogram.getSum(), 500500);
+  EXPECT_EQ(histogram.getMax(), 1000);
+  EXPECT_NEAR(histogram.getPercentile(0.5), 500, 500 / 16);
+  EXPECT_NEAR(histogram.getPercentile(0.99), 990, 990 / 16);
+  EXPECT_EQ(histogram.getPercentile(1), 1000);
+
+  histogram.reset();
+  EXPECT_EQ(histogram.getCount(), 0);
+  EXPECT_EQ(histogram.getMax(), 0);
+}
+
+/// Test that the memory of largeAlloc is aligned and usable with every policy.
+TEST(Support, LargeAlloc) {
+  const size_t size = (3 << 20) + 5;
+  for (int numaNode : {-1, 0}) {
+    for (size_t hugePageMinBytes : {size_t(0), size_t(1 << 20)}) {
+      LargeAllocPolicy policy;
+      policy.hugePageMinBytes = hugePageMinBytes;
+      policy.numaNode = numaNode;
+      bool mapped = false;
+      auto *p = static_cast<char *>(largeAlloc(size, policy, mapped));
+      ASSERT_TRUE(p);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % TensorAlignment, 0);
+      memset(p, 1, size);
+      EXPECT_EQ(p[size - 1], 1);
+      if (mapped) {
+        largeFree(p, size);
+      } else {
+        alignedFree(p);
+      }
+    }
+  }
+}
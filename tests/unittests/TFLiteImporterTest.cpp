@@ -450,3 +450,17 @@ TEST(TFLiteImporterTest, TFLiteDetectionPostProcessFast) {
   }
   EXPECT_EQ(numDetectionsH.raw(0), numDetectionsRef);
 }
+
+/// Test that the weights of a model point into the mapped model file instead
+/// of being copied, and stay valid after the loader is gone.
+TEST(TFLiteImporterTest, ConstantsPointIntoModelFile) {
+  ExecutionEngine EE;
+  auto &mod = EE.getModule();
+  Function *F = mod.createFunction("main");
+  { TFLiteModelLoader(getModelPath("conv2d_valid.tflite"), F); }
+
+  ASSERT_GT(mod.getConstants().size(), 0);
+  EXPECT_TRUE(std::any_of(
+      mod.getConstants().begin(), mod.getConstants().end(),
+      [](const Constant *C) { return C->getPayload().isUnowned(); }));
+}
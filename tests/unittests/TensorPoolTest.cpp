@@ -21,6 +21,7 @@
 #include "llvm/ADT/STLExtras.h"
 
 #include <future>
+#include <set>
 #include <vector>
 
 using namespace glow;
@@ -221,6 +222,67 @@ TEST(TensorPool, MultipleTypesReclaim) {
   EXPECT_EQ(stats.totalReclaims, 4);
 }
 
+/// Types of the same size class share the buffers of the pool.
+TEST(TensorPool, SizeClasses) {
+  EXPECT_EQ(TensorPool::getSizeClass(24), 32);
+  EXPECT_EQ(TensorPool::getSizeClass(64), 64);
+  EXPECT_EQ(TensorPool::getSizeClass(65), 96);
+  EXPECT_EQ(TensorPool::getSizeClass(1000), 1024);
+  EXPECT_EQ(TensorPool::getSizeClass(1025), 1536);
+
+  TensorPool pool;
+  Type ty(ElemKind::FloatTy, {1, 2, 3});
+  Type ty2(ElemKind::Int8QTy, {30}, 1.0, 4);
+  pool.reserve(&ty, 1);
+
+  Tensor T = std::move(pool.get(&ty).getValue());
+  auto *backingPtr = T.getUnsafePtr();
+  pool.reclaim(std::move(T));
+
+  Tensor T2 = std::move(pool.get(&ty2).getValue());
+  EXPECT_EQ(T2.getUnsafePtr(), backingPtr);
+  EXPECT_TRUE(T2.getType().isEqual(ty2));
+  EXPECT_EQ(T2.getUnpaddedSizeInBytes(), 30);
+  pool.reclaim(std::move(T2));
+
+  const auto &stats = pool.getStats();
+  EXPECT_EQ(stats.totalTypes, 1);
+  EXPECT_EQ(stats.currentBuffers, 1);
+  EXPECT_EQ(stats.totalAllocs, 1);
+  EXPECT_EQ(stats.totalGets, 2);
+  EXPECT_EQ(stats.totalHits, 2);
+  EXPECT_EQ(stats.sharedHits, 0);
+  EXPECT_EQ(stats.totalWastedBytes, 8 + 2);
+}
+
+/// A thread takes the buffers returned by other threads when it has none.
+TEST(TensorPool, SharedBuffers) {
+  TensorPool pool;
+  Type ty(ElemKind::FloatTy, {1, 2, 3});
+  std::vector<Tensor> tensors;
+  for (unsigned i = 0; i < 4; i++) {
+    tensors.emplace_back(std::move(pool.get(&ty).getValue()));
+  }
+  std::async(std::launch::async, [&]() {
+    for (auto &t : tensors) {
+      pool.reclaim(std::move(t));
+    }
+  }).wait();
+  tensors.clear();
+
+  for (unsigned i = 0; i < 4; i++) {
+    tensors.emplace_back(std::move(pool.get(&ty).getValue()));
+  }
+  const auto &stats = pool.getStats();
+  EXPECT_EQ(stats.totalAllocs, 4);
+  EXPECT_EQ(stats.totalHits, 4);
+  EXPECT_EQ(stats.currentBuffers, 0);
+
+  for (auto &t : tensors) {
+    pool.reclaim(std::move(t));
+  }
+}
+
 /// Inserting a managed Tensor into the PlaceholderBindings does reclaim when
 /// the bindings are cleared or destroyed.
 TEST(TensorPool, PlaceholderBindingsReclaim) {
@@ -274,8 +336,12 @@ TEST(TensorPool, Clear) {
   EXPECT_EQ(stats.totalGets, 1);
   EXPECT_EQ(stats.totalReclaims, 1);
   EXPECT_EQ(stats.totalFrees, 0);
+  EXPECT_EQ(stats.allocatedBytes, TensorPool::getSizeClass(24));
+  EXPECT_EQ(stats.availableBytes, TensorPool::getSizeClass(24));
 
   pool.clear();
+  EXPECT_EQ(stats.allocatedBytes, 0);
+  EXPECT_EQ(stats.availableBytes, 0);
 
   T = std::move(pool.get(&ty).getValue());
   pool.reclaim(std::move(T));
@@ -289,3 +355,35 @@ TEST(TensorPool, Clear) {
   EXPECT_EQ(stats2.totalReclaims, 2);
   EXPECT_EQ(stats2.totalFrees, 1);
 }
+
+/// The buffers of a pool with allocation functions come from them and go back
+/// to them when the pool is cleared.
+TEST(TensorPool, AllocationFunctions) {
+  std::set<void *> buffers;
+  size_t numFrees = 0;
+  {
+    TensorPool pool(
+        [&](size_t size) {
+          void *buffer = alignedAlloc(size, TensorAlignment);
+          buffers.insert(buffer);
+          return buffer;
+        },
+        [&](void *buffer) {
+          EXPECT_EQ(buffers.erase(buffer), 1);
+          alignedFree(buffer);
+          numFrees++;
+        });
+    Type ty(ElemKind::FloatTy, {1, 2, 3});
+    pool.reserve(&ty, 2);
+    EXPECT_EQ(buffers.size(), 2);
+
+    Tensor T = std::move(pool.get(&ty).getValue());
+    EXPECT_TRUE(T.isUnowned());
+    EXPECT_EQ(buffers.count(T.getUnsafePtr()), 1);
+    T.getHandle().clear(1.0);
+    pool.reclaim(std::move(T));
+    EXPECT_EQ(numFrees, 0);
+  }
+  EXPECT_EQ(numFrees, 2);
+  EXPECT_TRUE(buffers.empty());
+}
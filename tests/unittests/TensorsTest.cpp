@@ -549,6 +549,49 @@ TEST(Tensor, convertToType) {
   EXPECT_TRUE(B.isEqual(A, 0.001));
 }
 
+/// Check that tensors large enough to be converted on several threads give
+/// the same results as the element-wise conversions.
+TEST(Tensor, convertLargeTensors) {
+  PseudoRNG PRNG;
+  Tensor A(ElemKind::FloatTy, {3000, 3001});
+  A.getHandle<>().randomize(-100.0, 100.0, PRNG);
+  Tensor B = A.getCopyConvertedToType(ElemKind::Float16Ty);
+  auto AH = A.getHandle<>();
+  auto BH = B.getHandle<float16_t>();
+  for (size_t idx = 0, end = A.size(); idx != end; ++idx) {
+    ASSERT_EQ(BH.raw(idx), float16_t(AH.raw(idx)));
+  }
+  Tensor C = B.getCopyConvertedToType(ElemKind::FloatTy);
+  auto CH = C.getHandle<>();
+  for (size_t idx = 0, end = A.size(); idx != end; ++idx) {
+    ASSERT_EQ(CH.raw(idx), float(BH.raw(idx)));
+  }
+
+  const dim_t rows = 4000;
+  const dim_t dataCol = 5000;
+  Tensor F(ElemKind::UInt8FusedQTy, {rows, dataCol + 2 * sizeof(float)}, 1.0,
+           0);
+  auto FH = F.getHandle<uint8_t>();
+  for (dim_t i = 0; i < rows; i++) {
+    FH.setFusedScaleOffsetInRow<float>(i, i, -float(i));
+    for (dim_t j = 0; j < dataCol; j++) {
+      FH.at({i, j}) = i + j;
+    }
+  }
+  Tensor F16 = F.getCopyConvertedToType(ElemKind::UInt8FusedFP16QTy);
+  auto F16H = F16.getHandle<uint8_t>();
+  ASSERT_EQ(F16H.dims()[1], dataCol + 2 * sizeof(float16_t));
+  for (dim_t i = 0; i < rows; i++) {
+    float16_t scale, offset;
+    std::tie(scale, offset) = F16H.getFusedScaleOffsetFromRow<float16_t>(i);
+    ASSERT_EQ(scale, float16_t(i));
+    ASSERT_EQ(offset, float16_t(-float(i)));
+    for (dim_t j = 0; j < dataCol; j++) {
+      ASSERT_EQ(F16H.at({i, j}), uint8_t(i + j));
+    }
+  }
+}
+
 TEST(Tensor, reset) {
   Tensor A(ElemKind::FloatTy, {2, 3});
   Tensor QA(ElemKind::Int8QTy, {3, 4}, 2.2, 7);
@@ -621,6 +664,64 @@ TEST(Tensor, transpose2) {
   }
 }
 
+/// Check the tiled transpose of the last two dimensions with matrices larger
+/// and not a multiple of the tile size.
+TEST(Tensor, transposeLastTwoDims) {
+  PseudoRNG PRNG;
+  Tensor X(ElemKind::FloatTy, {3, 37, 21});
+  auto H = X.getHandle<>();
+  H.randomize(-2.0, 2.0, PRNG);
+
+  Tensor Xhat;
+  X.transpose(&Xhat, {0, 2, 1});
+
+  auto XhatH = Xhat.getHandle<>();
+  for (dim_t i = 0; i < 3; i++) {
+    for (dim_t j = 0; j < 37; j++) {
+      for (dim_t k = 0; k < 21; k++) {
+        EXPECT_EQ(H.at({i, j, k}), XhatH.at({i, k, j}));
+      }
+    }
+  }
+}
+
+/// Check the bulk Handle operations on contiguous and padded tensors.
+TEST(Tensor, handleBulkOps) {
+  Tensor X(ElemKind::FloatTy, {2, 3});
+  Type alignedTy(ElemKind::FloatTy, {2, 3}, {32, 1});
+  Tensor aligned(alignedTy);
+  for (Tensor *T : {&X, &aligned}) {
+    auto H = T->getHandle<>();
+    EXPECT_EQ(H.isContiguous(), T == &X);
+    H.clear(7);
+    EXPECT_EQ(H.sum(), 42);
+    for (dim_t i = 0; i < 2; i++) {
+      for (dim_t j = 0; j < 3; j++) {
+        H.at({i, j}) = float(i * 3 + j) - 2;
+      }
+    }
+    auto minMax = H.minMax();
+    EXPECT_EQ(minMax.first, -2);
+    EXPECT_EQ(minMax.second, 3);
+    EXPECT_EQ(H.sum(), 3);
+
+    H.clip(-1, 2);
+    minMax = H.minMax();
+    EXPECT_EQ(minMax.first, -1);
+    EXPECT_EQ(minMax.second, 2);
+    EXPECT_EQ(H.sum(), 3);
+
+    Tensor I(ElemKind::Int32ITy, {2, 3});
+    auto IH = I.getHandle<int32_t>();
+    IH.copyConvertedFrom(H);
+    for (dim_t i = 0; i < 2; i++) {
+      for (dim_t j = 0; j < 3; j++) {
+        EXPECT_EQ(IH.at({i, j}), int32_t(H.at({i, j})));
+      }
+    }
+  }
+}
+
 TEST(Tensor, nonOwnedTensor) {
   Tensor T1 = {1.2f, 12.1f, 51.0f, 1515.2f};
 
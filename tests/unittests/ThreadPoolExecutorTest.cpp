@@ -16,6 +16,7 @@
 
 #include "glow/Runtime/Executor/ThreadPoolExecutor.h"
 #include "glow/Backends/DeviceManager.h"
+#include "glow/Flags/Flags.h"
 #include "glow/Support/Support.h"
 #include "glow/Support/ThreadPool.h"
 
@@ -23,6 +24,7 @@
 
 #include <chrono>
 #include <future>
+#include <set>
 #include <thread>
 #include <unordered_set>
 
@@ -226,6 +228,15 @@ public:
     executor_->createPool(root_.get(), 1000, false, false);
   }
 
+  /// Cancel the run of the test before it starts, it is then expected to
+  /// fail without running any node.
+  void cancel() {
+    auto token = std::make_shared<CancellationToken>();
+    token->cancel();
+    inputContext_->setCancellationToken(std::move(token));
+    expectSuccess_ = false;
+  }
+
   /// Run the test.
   bool run() {
     if (testRun_) {
@@ -602,8 +613,10 @@ private:
 /// DeviceManagerMapTy instances to all tests.
 class ThreadPoolExecutorTest : public ::testing::Test {
 protected:
-  ThreadPoolExecutorTest()
-      : executor_(std::make_shared<ThreadPoolExecutor>(deviceManagerMap_)),
+  ThreadPoolExecutorTest(bool workStealing = false)
+      : executor_(std::make_shared<ThreadPoolExecutor>(
+            deviceManagerMap_, /* numWorkers */ 3, /* name */ "",
+            workStealing)),
         testBuilder_(executor_, deviceManagerMap_) {}
   ~ThreadPoolExecutorTest() = default;
 
@@ -694,6 +707,28 @@ TEST_F(ThreadPoolExecutorTest, SingleNode) {
   EXPECT_TRUE(test.run());
 }
 
+/// Tests that a single node runs correctly when its result is handled on the
+/// DeviceManager thread.
+TEST_F(ThreadPoolExecutorTest, SingleNodeInlineResult) {
+  constexpr RunIdentifierTy testRunId = 10;
+  constexpr DeviceIDTy testDeviceId = 111;
+  constexpr unsigned deviceManagerThreads = 1;
+
+  auto deviceManager = glow::make_unique<TestDeviceManager>(
+      deviceManagerThreads, DeviceConfig("Interpreter"));
+  deviceManagerMap_.emplace(testDeviceId, std::move(deviceManager));
+
+  testBuilder_.addNode("net", testDeviceId,
+                       /*parents=*/{}, {"netInput"}, {"netOutput"}, testRunId,
+                       true);
+
+  ExecutorTest test = testBuilder_.emitTest();
+  bool oldInline = glow::flags::ExecutorInlineSingleNode;
+  glow::flags::ExecutorInlineSingleNode = true;
+  EXPECT_TRUE(test.run());
+  glow::flags::ExecutorInlineSingleNode = oldInline;
+}
+
 /// Tests that several instances of a single node DAG can be run in parallel.
 TEST_F(ThreadPoolExecutorTest, ConcurrentSingleNode) {
   constexpr RunIdentifierTy baseTestRunId = 10;
@@ -937,6 +972,34 @@ TEST_F(ThreadPoolExecutorTest, MultiNodeWithFailure) {
   EXPECT_TRUE(test.run());
 }
 
+/// Tests that a cancelled run of a DAG skips its nodes and completes with an
+/// error.
+TEST_F(ThreadPoolExecutorTest, MultiNodeCancelled) {
+  constexpr RunIdentifierTy testRunId = 10;
+  constexpr DeviceIDTy testDeviceId = 111;
+  constexpr unsigned deviceManagerThreads = 3;
+
+  auto deviceManager = glow::make_unique<TestDeviceManager>(
+      deviceManagerThreads, DeviceConfig("Interpreter"));
+  deviceManagerMap_.emplace(testDeviceId, std::move(deviceManager));
+
+  // Two roots so that the last node skipped is not the first one.
+  testBuilder_.addNode("alpha", testDeviceId,
+                       /*parents=*/{}, /*inputs=*/{"alphaIn"},
+                       /*outputs=*/{"alphaOut"}, testRunId, true);
+  testBuilder_.addNode("beta", testDeviceId,
+                       /*parents=*/{}, /*inputs=*/{"betaIn"},
+                       /*outputs=*/{"betaOut"}, testRunId, true);
+  testBuilder_.addNode("gamma", testDeviceId,
+                       /*parents=*/{"alpha", "beta"},
+                       /*inputs=*/{"alphaOut", "betaOut"},
+                       /*outputs=*/{"gammaOut"}, testRunId, true);
+
+  ExecutorTest test = testBuilder_.emitTest();
+  test.cancel();
+  EXPECT_TRUE(test.run());
+}
+
 /// Tests that a DAG with nodes spread across multiple devices can run
 /// correctly.
 TEST_F(ThreadPoolExecutorTest, MultiNodeMultiDevice) {
@@ -1106,3 +1169,344 @@ TEST_F(ThreadPoolExecutorTest, ConcurrentMultiNode) {
   // All tests should pass.
   EXPECT_EQ(testsPassed, numConcurrentRuns);
 }
+
+/// Same as ThreadPoolExecutorTest, but with work-stealing dispatch enabled.
+class WorkStealingThreadPoolExecutorTest : public ThreadPoolExecutorTest {
+protected:
+  WorkStealingThreadPoolExecutorTest()
+      : ThreadPoolExecutorTest(/* workStealing */ true) {}
+};
+
+/// Tests that a DAG where one node fans out to several ready children runs
+/// correctly when ready children are pushed to the completing worker's deque.
+TEST_F(WorkStealingThreadPoolExecutorTest, FanOutMultiNode) {
+  constexpr RunIdentifierTy testRunId = 10;
+  constexpr DeviceIDTy testDeviceId = 111;
+  constexpr unsigned deviceManagerThreads = 3;
+
+  ASSERT_TRUE(executor_->isWorkStealing());
+
+  auto deviceManager = glow::make_unique<TestDeviceManager>(
+      deviceManagerThreads, DeviceConfig("Interpreter"));
+  deviceManagerMap_.emplace(testDeviceId, std::move(deviceManager));
+
+  // Build the DAG. The DAG created below looks like this:
+  /**
+   *           root
+   *            |
+   *            v
+   *          alpha
+   *        /   |   \
+   *       v    v    v
+   *     beta gamma delta
+   *       \    |    /
+   *        v   v   v
+   *           eps
+   **/
+
+  testBuilder_.addNode("alpha", testDeviceId,
+                       /*parents=*/{}, /*inputs=*/{"alphaIn"},
+                       /*outputs=*/{"betaIn", "gammaIn", "deltaIn"}, testRunId,
+                       true);
+  testBuilder_.addNode("beta", testDeviceId,
+                       /*parents=*/{"alpha"}, /*inputs=*/{"betaIn"},
+                       /*outputs=*/{"betaOut"}, testRunId, true);
+  testBuilder_.addNode("gamma", testDeviceId,
+                       /*parents=*/{"alpha"}, /*inputs=*/{"gammaIn"},
+                       /*outputs=*/{"gammaOut"}, testRunId, true);
+  testBuilder_.addNode("delta", testDeviceId,
+                       /*parents=*/{"alpha"}, /*inputs=*/{"deltaIn"},
+                       /*outputs=*/{"deltaOut"}, testRunId, true);
+  testBuilder_.addNode("eps", testDeviceId,
+                       /*parents=*/{"beta", "gamma", "delta"},
+                       /*inputs=*/{"betaOut", "gammaOut", "deltaOut"},
+                       /*outputs=*/{"epsOut"}, testRunId, true);
+
+  ExecutorTest test = testBuilder_.emitTest();
+  EXPECT_TRUE(test.run());
+}
+
+/// Tests that a DAG with a node that fails is handled correctly with
+/// work-stealing dispatch.
+TEST_F(WorkStealingThreadPoolExecutorTest, MultiNodeWithFailure) {
+  constexpr RunIdentifierTy testRunId = 10;
+  constexpr DeviceIDTy testDeviceId = 111;
+  constexpr unsigned deviceManagerThreads = 3;
+
+  auto deviceManager = glow::make_unique<TestDeviceManager>(
+      deviceManagerThreads, DeviceConfig("Interpreter"));
+  deviceManagerMap_.emplace(testDeviceId, std::move(deviceManager));
+
+  testBuilder_.addNode("alpha", testDeviceId,
+                       /*parents=*/{}, /*inputs=*/{"alphaIn"},
+                       /*outputs=*/{"betaIn", "gammaIn"}, testRunId, true);
+  testBuilder_.addNode("beta", testDeviceId,
+                       /*parents=*/{"alpha"}, /*inputs=*/{"betaIn"},
+                       /*outputs=*/{"betaOut"}, testRunId, false);
+  testBuilder_.addNode("gamma", testDeviceId,
+                       /*parents=*/{"alpha"}, /*inputs=*/{"gammaIn"},
+                       /*outputs=*/{"gammaOut"}, testRunId, true);
+
+  ExecutorTest test = testBuilder_.emitTest();
+  EXPECT_TRUE(test.run());
+}
+
+/// Tests that ExecutionPlan numbers the nodes of a DAG in topological waves
+/// and resolves the devices of the nodes.
+TEST(ExecutionPlan, TopologicalWaves) {
+  constexpr DeviceIDTy testDeviceId = 3;
+  DeviceManagerMapTy devices;
+  devices.emplace(testDeviceId, glow::make_unique<TestDeviceManager>(
+                                    1, DeviceConfig("Interpreter")));
+
+  // Build the DAG below, where delta only runs once gamma is done.
+  /**
+   *       root
+   *      /    \
+   *  alpha    beta
+   *    |  \   /
+   *    |  gamma
+   *     \  |
+   *     delta
+   **/
+  DAGNode root, alpha, beta, gamma, delta;
+  root.children = {&alpha, &beta};
+  alpha.parents = {&root};
+  alpha.children = {&gamma, &delta};
+  beta.parents = {&root};
+  beta.children = {&gamma};
+  gamma.parents = {&alpha, &beta};
+  gamma.children = {&delta};
+  delta.parents = {&alpha, &gamma};
+  gamma.deviceRuntimeInfos[testDeviceId] = DeviceRuntimeInfo();
+
+  ExecutionPlan plan(&root, devices);
+  auto steps = plan.getSteps();
+  ASSERT_EQ(steps.size(), 4);
+  std::vector<DAGNode *> order;
+  std::vector<unsigned> waves;
+  for (const auto &step : steps) {
+    order.push_back(step.node);
+    waves.push_back(step.wave);
+  }
+  EXPECT_EQ(order, std::vector<DAGNode *>({&alpha, &beta, &gamma, &delta}));
+  EXPECT_EQ(waves, std::vector<unsigned>({0, 0, 1, 2}));
+  EXPECT_EQ(plan.getRootSteps().vec(), std::vector<unsigned>({0, 1}));
+  EXPECT_EQ(steps[0].children, std::vector<unsigned>({2, 3}));
+  EXPECT_EQ(steps[3].numParents, 2);
+
+  EXPECT_EQ(plan.getDevice(2, testDeviceId), devices.at(testDeviceId).get());
+  EXPECT_EQ(plan.getDevice(2, testDeviceId + 1), nullptr);
+}
+
+/// Tests that NetworkExecutionStatePool hands out every state once, reports
+/// exhaustion when all states are in use, and reuses returned states.
+TEST(NetworkExecutionStatePool, AcquireReturnAndExhaust) {
+  constexpr unsigned poolSize = 4;
+  DAGNode root;
+  DeviceManagerMapTy devices;
+  NetworkExecutionStatePool pool(&root, devices);
+  for (unsigned i = 0; i < poolSize; i++) {
+    pool.addNewState(glow::make_unique<NetworkExecutionState>(
+        pool.getPlan(), /* enableDRT */ false, /* enableP2P */ false, i));
+  }
+  EXPECT_EQ(pool.getNumStates(), poolSize);
+
+  std::set<NetworkExecutionState *> acquired;
+  for (unsigned i = 0; i < poolSize; i++) {
+    auto *state = pool.getNextNetworkExecutionState();
+    ASSERT_NE(state, nullptr);
+    EXPECT_TRUE(acquired.insert(state).second);
+  }
+  EXPECT_EQ(pool.getNumHits(), poolSize);
+
+  EXPECT_EQ(pool.getNextNetworkExecutionState(), nullptr);
+  EXPECT_EQ(pool.getNumExhausted(), 1);
+
+  auto *returned = *acquired.begin();
+  pool.returnNetworkExecutionState(returned);
+  EXPECT_EQ(pool.getNextNetworkExecutionState(), returned);
+  EXPECT_EQ(pool.getNumHits(), poolSize + 1);
+}
+
+/// Tests that concurrent acquire/return cycles never hand out the same state
+/// to two threads at once.
+TEST(NetworkExecutionStatePool, ConcurrentAcquireReturn) {
+  constexpr unsigned poolSize = 8;
+  constexpr unsigned numThreads = 4;
+  constexpr unsigned numIters = 10000;
+  DAGNode root;
+  DeviceManagerMapTy devices;
+  NetworkExecutionStatePool pool(&root, devices);
+  for (unsigned i = 0; i < poolSize; i++) {
+    pool.addNewState(glow::make_unique<NetworkExecutionState>(
+        pool.getPlan(), /* enableDRT */ false, /* enableP2P */ false, i));
+  }
+
+  std::mutex mtx;
+  std::set<NetworkExecutionState *> inUse;
+  std::atomic<bool> failed{false};
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < numThreads; t++) {
+    threads.emplace_back([&]() {
+      for (unsigned i = 0; i < numIters; i++) {
+        auto *state = pool.getNextNetworkExecutionState();
+        if (!state) {
+          failed = true;
+          return;
+        }
+        {
+          std::lock_guard<std::mutex> g(mtx);
+          failed = failed || !inUse.insert(state).second;
+        }
+        {
+          std::lock_guard<std::mutex> g(mtx);
+          inUse.erase(state);
+        }
+        pool.returnNetworkExecutionState(state);
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  EXPECT_FALSE(failed);
+  EXPECT_EQ(pool.getNumExhausted(), 0);
+  EXPECT_EQ(pool.getNumHits() + pool.getNumMisses(), numThreads * numIters);
+}
+
+/// Tests that pipeline buffers are shared by the nodes of a run, that at most
+/// pipelineDepth runs hold them at once, and that a released set goes to the
+/// oldest waiting run.
+TEST(NetworkExecutionStatePool, PipelineBuffers) {
+  constexpr unsigned poolSize = 3;
+  constexpr unsigned pipelineDepth = 2;
+  constexpr DeviceIDTy testDeviceId = 0;
+  DeviceManagerMapTy devices;
+  devices.emplace(testDeviceId, glow::make_unique<TestDeviceManager>(
+                                    1, DeviceConfig("Interpreter")));
+
+  // Build the DAG root -> alpha -> beta, passing "mid" from alpha to beta.
+  Module module;
+  Type type(ElemKind::FloatTy, {4, 8});
+  for (const char *name : {"in", "mid", "out"}) {
+    module.createPlaceholder(&type, name, false);
+  }
+  auto makeSymbol = [&](bool input, bool output) {
+    RuntimeSymbolInfo info;
+    info.size = type.getSizeInBytes();
+    info.offset = 0;
+    info.type = type;
+    info.input = input;
+    info.output = output;
+    info.symbolCategory = SymbolCategory::Placeholder;
+    return info;
+  };
+  DAGNode root, alpha, beta;
+  root.module = &module;
+  root.children = {&alpha};
+  alpha.parents = {&root};
+  alpha.children = {&beta};
+  beta.parents = {&alpha};
+  alpha.name = "alpha";
+  beta.name = "beta";
+  SymbolTableTy alphaSymbols{{"in", makeSymbol(true, false)},
+                             {"mid", makeSymbol(false, true)}};
+  SymbolTableTy betaSymbols{{"mid", makeSymbol(true, false)},
+                            {"out", makeSymbol(false, true)}};
+  alpha.runtimeBundle = glow::make_unique<RuntimeBundle>(alphaSymbols, 0, 0, 0);
+  beta.runtimeBundle = glow::make_unique<RuntimeBundle>(betaSymbols, 0, 0, 0);
+
+  NetworkExecutionStatePool pool(&root, devices);
+  pool.createPipelineBuffers(&root, pipelineDepth,
+                             devices.begin()->second.get());
+  ASSERT_TRUE(pool.hasPipelineBuffers());
+  ASSERT_EQ(pool.getPipelinePlaceholders().size(), 1);
+  Placeholder *mid = pool.getPipelinePlaceholders()[0];
+  EXPECT_EQ(mid->getName(), "mid");
+
+  std::unordered_map<DAGNode *, DeviceIDTy> assignment;
+  for (unsigned i = 0; i < poolSize; i++) {
+    auto state = glow::make_unique<NetworkExecutionState>(
+        pool.getPlan(), /* enableDRT */ false, /* enableP2P */ false, i);
+    state->init(devices, assignment, pool.getPipelinePlaceholders());
+    pool.addNewState(std::move(state));
+  }
+
+  // \returns the buffer backing "mid" in the context of the node at index
+  // \p step of the plan in \p state.
+  auto midBuffer = [&](NetworkExecutionState *state, unsigned step) {
+    auto ctx = state->getUniqueNodeContextPtr(step);
+    char *buffer = ctx->getPlaceholderBindings()->get(mid)->getUnsafePtr();
+    state->returnUniqueNodeContextPtr(step, std::move(ctx));
+    return buffer;
+  };
+  // The plan numbers the nodes in topological order.
+  constexpr unsigned alphaStep = 0;
+  constexpr unsigned betaStep = 1;
+  ASSERT_EQ(pool.getPlan().getStep(alphaStep).node, &alpha);
+  ASSERT_EQ(pool.getPlan().getStep(betaStep).node, &beta);
+
+  std::vector<NetworkExecutionState *> states;
+  for (unsigned i = 0; i < poolSize; i++) {
+    auto *state = pool.getNextNetworkExecutionState();
+    ASSERT_NE(state, nullptr);
+    EXPECT_TRUE(state->isPipelined());
+    ResultCBTy cb = [](RunIdentifierTy, Error,
+                       std::unique_ptr<ExecutionContext>) {};
+    state->bind(glow::make_unique<ExecutionContext>(), std::move(cb), i);
+    states.push_back(state);
+  }
+
+  EXPECT_TRUE(pool.acquirePipelineBuffers(states[0]));
+  EXPECT_TRUE(pool.acquirePipelineBuffers(states[1]));
+  EXPECT_FALSE(pool.acquirePipelineBuffers(states[2]));
+  EXPECT_NE(states[0]->getPipelineSlot(), states[1]->getPipelineSlot());
+  for (unsigned i = 0; i < pipelineDepth; i++) {
+    EXPECT_NE(midBuffer(states[i], alphaStep), nullptr);
+    EXPECT_EQ(midBuffer(states[i], alphaStep), midBuffer(states[i], betaStep));
+  }
+  EXPECT_NE(midBuffer(states[0], alphaStep), midBuffer(states[1], alphaStep));
+
+  // Releasing a set hands it to the waiting run.
+  char *releasedBuffer = midBuffer(states[0], alphaStep);
+  EXPECT_EQ(pool.releasePipelineBuffers(states[0]), states[2]);
+  EXPECT_EQ(states[2]->getPipelineSlot(), states[0]->getPipelineSlot());
+  EXPECT_EQ(midBuffer(states[2], betaStep), releasedBuffer);
+
+  // With no waiters the set goes back to the free list.
+  EXPECT_EQ(pool.releasePipelineBuffers(states[1]), nullptr);
+  EXPECT_EQ(pool.releasePipelineBuffers(states[2]), nullptr);
+  EXPECT_TRUE(pool.acquirePipelineBuffers(states[1]));
+  EXPECT_TRUE(pool.acquirePipelineBuffers(states[2]));
+  EXPECT_EQ(pool.releasePipelineBuffers(states[1]), nullptr);
+  EXPECT_EQ(pool.releasePipelineBuffers(states[2]), nullptr);
+
+  for (auto *state : states) {
+    state->getUniqueResultContextPtr();
+    pool.returnNetworkExecutionState(state);
+  }
+}
+
+/// Runs of a node go to the device of its replicas with the fewest queued
+/// runs, counting the runs of the other networks on the devices.
+TEST(DAGNode, NextDeviceAvoidsLoadedDevices) {
+  DAGNode node;
+  for (DeviceIDTy id = 0; id < 3; id++) {
+    node.deviceRuntimeInfos[id] = DeviceRuntimeInfo();
+  }
+  std::map<DeviceIDTy, uint64_t> queued = {{0, 4}, {1, 1}, {2, 3}};
+  auto deviceLoad = [&](DeviceIDTy id) { return queued[id]; };
+
+  EXPECT_EQ(node.getNextDevice(deviceLoad), 1);
+  // Device 1 got busy with other networks.
+  queued[1] = 5;
+  EXPECT_EQ(node.getNextDevice(deviceLoad), 2);
+  // The runs of the node count while the queues of the devices don't show
+  // them.
+  queued = {{0, 0}, {1, 0}, {2, 0}};
+  EXPECT_EQ(node.getNextDevice(deviceLoad), 0);
+  node.markFinished(0);
+  node.markFinished(1);
+  node.markFinished(2);
+}
@@ -16,11 +16,13 @@
 
 #include "glow/Support/ThreadPool.h"
 #include "glow/Support/Memory.h"
+#include "glow/Support/WorkStealingThreadPool.h"
 
 #include "gtest/gtest.h"
 
 #include "llvm/ADT/STLExtras.h"
 
+#include <array>
 #include <future>
 #include <vector>
 
@@ -157,3 +159,166 @@ TEST(ThreadPool, runOnAllThreads) {
   ASSERT_NE(threadIds[1], threadIds[2]);
   ASSERT_NE(threadIds[2], threadIds[0]);
 }
+
+/// Check that InlineTask runs and destroys small and large callables exactly
+/// once across moves.
+TEST(InlineTask, SmallAndLarge) {
+  auto counter = std::make_shared<int>(0);
+  std::array<int, 32> big{};
+  big[31] = 2;
+  {
+    InlineTask small([counter]() { (*counter)++; });
+    InlineTask large([counter, big]() { *counter += big[31]; });
+    EXPECT_EQ(counter.use_count(), 3);
+    InlineTask movedSmall(std::move(small));
+    InlineTask movedLarge;
+    movedLarge = std::move(large);
+    EXPECT_FALSE(small);
+    EXPECT_FALSE(large);
+    movedSmall();
+    movedLarge();
+    EXPECT_EQ(*counter, 3);
+    EXPECT_EQ(counter.use_count(), 3);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+/// Push from several threads to a small queue while popping from several
+/// others, and check that every element is popped exactly once.
+TEST(BoundedMPMCQueue, ConcurrentPushPop) {
+  constexpr unsigned numProducers = 4;
+  constexpr unsigned numPerProducer = 10000;
+  BoundedMPMCQueue<unsigned> queue(/* capacity */ 64);
+  std::vector<std::atomic<unsigned>> seen(numProducers * numPerProducer);
+  std::atomic<unsigned> popped{0};
+
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < numProducers; p++) {
+    threads.emplace_back([&queue, p]() {
+      for (unsigned i = 0; i < numPerProducer; i++) {
+        unsigned value = p * numPerProducer + i;
+        while (!queue.tryPush(std::move(value))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    threads.emplace_back([&]() {
+      unsigned value;
+      while (popped < numProducers * numPerProducer) {
+        if (queue.tryPop(value)) {
+          seen[value]++;
+          popped++;
+        }
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  EXPECT_TRUE(queue.empty());
+  for (auto &s : seen) {
+    EXPECT_EQ(s, 1);
+  }
+}
+
+/// Post more work items than the lock-free queue holds while the worker is
+/// busy, and check that they run in order once it is free.
+TEST(ThreadPool, postKeepsOrder) {
+  ThreadExecutor executor;
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  executor.post([released]() { released.wait(); });
+
+  constexpr unsigned numItems = 3000;
+  std::vector<unsigned> order;
+  for (unsigned i = 0; i < numItems; i++) {
+    executor.post([&order, i]() { order.push_back(i); });
+  }
+  auto done = executor.submit([]() {});
+  release.set_value();
+  done.wait();
+
+  ASSERT_EQ(order.size(), numItems);
+  for (unsigned i = 0; i < numItems; i++) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+/// Check that workers spinning before they sleep run all the posted work.
+TEST(ThreadPool, postWithSpinningWorkers) {
+  constexpr unsigned numItems = 1000;
+  std::atomic<unsigned> count{0};
+  std::promise<void> done;
+  auto doneFuture = done.get_future();
+  ThreadPool tp(4, "spin", /* spinIterations */ 100);
+  for (unsigned i = 0; i < numItems; i++) {
+    tp.post([&]() {
+      if (count.fetch_add(1) + 1 == numItems) {
+        done.set_value();
+      }
+    });
+  }
+  doneFuture.wait();
+  EXPECT_EQ(count, numItems);
+}
+
+/// Check that the work-stealing deque preserves LIFO order for its owner and
+/// FIFO order for thieves, including across buffer growth.
+TEST(WorkStealingDeque, PushPopSteal) {
+  WorkStealingDeque<int> deque(/* initialCapacity */ 2);
+  std::vector<int> values(100);
+  for (auto &v : values) {
+    deque.push(&v);
+  }
+  EXPECT_EQ(deque.sizeApprox(), values.size());
+  EXPECT_EQ(deque.steal(), &values.front());
+  EXPECT_EQ(deque.pop(), &values.back());
+  for (size_t i = values.size() - 2; i >= 1; i--) {
+    EXPECT_EQ(deque.pop(), &values[i]);
+  }
+  EXPECT_EQ(deque.pop(), nullptr);
+  EXPECT_EQ(deque.steal(), nullptr);
+}
+
+/// Run tasks that spawn more tasks from inside the pool and check that all of
+/// them are executed exactly once.
+TEST(WorkStealingThreadPool, NestedTasks) {
+  constexpr unsigned numOuter = 100;
+  constexpr unsigned numInner = 50;
+  std::atomic<unsigned> count{0};
+  std::promise<void> done;
+  auto doneFuture = done.get_future();
+
+  WorkStealingThreadPool tp(4);
+  EXPECT_EQ(tp.getNumWorkers(), 4);
+  auto finishOne = [&]() {
+    if (count.fetch_add(1) + 1 == numOuter * (numInner + 1)) {
+      done.set_value();
+    }
+  };
+  for (unsigned i = 0; i < numOuter; i++) {
+    tp.add([&]() {
+      for (unsigned j = 0; j < numInner; j++) {
+        tp.add(finishOne);
+      }
+      finishOne();
+    });
+  }
+
+  doneFuture.wait();
+  EXPECT_EQ(count, numOuter * (numInner + 1));
+}
+
+/// Check that stopping the pool still drains work that was already queued.
+TEST(WorkStealingThreadPool, StopDrainsQueue) {
+  std::atomic<unsigned> count{0};
+  {
+    WorkStealingThreadPool tp(2);
+    for (unsigned i = 0; i < 1000; i++) {
+      tp.add([&count]() { count++; });
+    }
+    tp.stop();
+    tp.join();
+  }
+  EXPECT_EQ(count, 1000);
+}
@@ -18,6 +18,7 @@
 
 #include "glow/Backends/DeviceManager.h"
 #include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/TraceAnalysis.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Graph/Graph.h"
 #include "glow/IR/IRBuilder.h"
@@ -27,6 +28,7 @@
 
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <chrono>
@@ -344,6 +346,47 @@ TEST_P(TraceEventsTest, automaticInstrumentation) {
   checkEventTimestamps(traceEvents);
 }
 
+/// Check that the automatic instrumentation of the CPU backend can attach the
+/// hardware counters of the operators to their events.
+TEST_P(TraceEventsTest, automaticInstrumentationCounters) {
+  CHECK_IF_ENABLED();
+  if (GetParam() != "CPU") {
+    GTEST_SKIP();
+  }
+  ExecutionContext context;
+  context.setTraceContext(
+      glow::make_unique<TraceContext>(TraceLevel::OPERATOR));
+
+  auto n = part_one(F, context);
+  n = part_two(F, context, n);
+  n = part_three(F, context, n);
+  part_four(F, context, n);
+
+  context.getPlaceholderBindings()->allocate(EE_.getModule().getPlaceholders());
+  CompilationContext cctx;
+  cctx.compMode = CompilationMode::Infer;
+  cctx.backendOpts.autoInstrument = true;
+  cctx.backendOpts.autoInstrumentCounters = true;
+  EE_.compile(cctx);
+
+  auto expectedKinds = prepareKindsForComparison(EE_);
+
+  updateInputPlaceholders(*context.getPlaceholderBindings(), {inputPH},
+                          {&inputs});
+  EE_.run(context);
+
+  auto &traceEvents = context.getTraceContext()->getTraceEvents();
+
+  ASSERT_GT(traceEvents.size(), 0);
+  checkEventMetadata(traceEvents, expectedKinds);
+  checkEventTimestamps(traceEvents);
+  for (const auto &event : traceEvents) {
+    EXPECT_EQ(event.args.count("cycles"), 1);
+    EXPECT_EQ(event.args.count("instructions"), 1);
+    EXPECT_EQ(event.args.count("llc_misses"), 1);
+  }
+}
+
 TEST_P(TraceEventsTest, manualAndAutomatic) {
   CHECK_IF_ENABLED();
   ExecutionContext context;
@@ -846,4 +889,113 @@ TEST(TraceEventsTest, MergeEvents) {
   ASSERT_EQ(tc2->getTraceEvents().size(), 4);
 }
 
+/// Check that the events logged by several threads are all kept, with the
+/// events of each thread in logging order and their arguments.
+TEST(TraceEventsTest, MultiThreadedLogging) {
+  constexpr int numThreads = 4;
+  constexpr int numEvents = 1000;
+  TraceContext context(TraceLevel::RUNTIME);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < numThreads; t++) {
+    threads.emplace_back([&context, t]() {
+      for (int i = 0; i < numEvents; i++) {
+        context.logTraceEvent("event", TraceLevel::RUNTIME,
+                              TraceEvent::InstantType,
+                              {{"index", std::to_string(i)}}, t);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  auto &traceEvents = context.getTraceEvents();
+  ASSERT_EQ(traceEvents.size(), numThreads * numEvents);
+  std::vector<int> nextIndex(numThreads, 0);
+  for (const auto &event : traceEvents) {
+    ASSERT_EQ(event.name, "event");
+    ASSERT_GE(event.tid, 0);
+    ASSERT_LT(event.tid, numThreads);
+    EXPECT_EQ(event.args.at("index"), std::to_string(nextIndex[event.tid]++));
+  }
+
+  // Events logged after a flush are appended to the list.
+  context.logTraceEvent("last", TraceLevel::RUNTIME);
+  ASSERT_EQ(context.getTraceEvents().size(), numThreads * numEvents + 1);
+  EXPECT_EQ(context.getTraceEvents().back().name, "last");
+}
+
+/// Check the critical path and blame of a request whose partitions form a
+/// diamond, read back from a dumped trace.
+TEST(TraceEventsTest, RequestCriticalPath) {
+  auto requestEvent = [](const char *name, uint64_t ts, uint64_t dur,
+                         std::map<std::string, std::string> args) {
+    return TraceEvent(name, TraceLevel::REQUEST, ts, dur, 0, std::move(args));
+  };
+  auto partition = [&](const char *node, const char *parents, uint64_t ts,
+                       uint64_t dur, uint64_t dispatch, uint64_t transfer) {
+    return requestEvent(RequestTraceAnalysis::kPartitionEvent, ts, dur,
+                        {{"request", "0"},
+                         {"node", node},
+                         {"parents", parents},
+                         {"device", "0"},
+                         {"dispatch", std::to_string(dispatch)},
+                         {"transfer", std::to_string(transfer)}});
+  };
+  std::list<TraceEvent> events;
+  events.push_back(requestEvent(RequestTraceAnalysis::kQueueEvent, 100, 50,
+                                {{"request", "0"}, {"network", "net"}}));
+  events.push_back(requestEvent(RequestTraceAnalysis::kRunEvent, 150, 250,
+                                {{"request", "0"}}));
+  events.push_back(partition("A", "", 160, 100, 10, 20));
+  events.push_back(partition("B", "A", 270, 60, 5, 0));
+  events.push_back(partition("C", "A", 265, 115, 5, 15));
+  events.push_back(partition("D", "B,C", 385, 10, 2, 0));
+  // A request without its run event, and an event of another level.
+  events.push_back(requestEvent(RequestTraceAnalysis::kQueueEvent, 100, 20,
+                                {{"request", "1"}, {"network", "net"}}));
+  events.emplace_back("other", TraceLevel::RUNTIME, 100, uint64_t(10), 0);
+
+  llvm::SmallString<64> path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("trace", "json", path));
+  TraceEvent::dumpTraceEvents(events, path, "test", {});
+  auto loaded = RequestTraceAnalysis::loadTrace(path);
+  llvm::sys::fs::remove(path);
+  ASSERT_TRUE((bool)loaded);
+
+  RequestTraceAnalysis analysis;
+  analysis.addTraceEvents(*loaded);
+  analysis.analyze();
+  EXPECT_EQ(analysis.getNumIncomplete(), 1);
+  ASSERT_EQ(analysis.getRequests().size(), 1);
+  const auto &request = analysis.getRequests()[0];
+  EXPECT_EQ(request.network, "net");
+  EXPECT_EQ(request.getLatency(), 300);
+
+  std::vector<std::string> criticalPath;
+  for (size_t idx : request.criticalPath) {
+    criticalPath.push_back(request.partitions[idx].node);
+  }
+  EXPECT_EQ(criticalPath, std::vector<std::string>({"A", "C", "D"}));
+
+  const auto &blame = request.blame;
+  EXPECT_EQ(blame.queue, 50);
+  EXPECT_EQ(blame.dispatch, 37);
+  EXPECT_EQ(blame.transfer, 35);
+  EXPECT_EQ(blame.device, 173);
+  EXPECT_EQ(blame.callback, 5);
+  EXPECT_EQ(blame.getTotal(), request.getLatency());
+}
+
+/// Check that the copy time of a partition sums complete events and pairs
+/// of begin and end events.
+TEST(TraceEventsTest, RequestCopyTime) {
+  std::list<TraceEvent> events;
+  events.emplace_back("copy", TraceLevel::COPY, 10, uint64_t(5), 0);
+  events.emplace_back("dma", TraceLevel::COPY, 20, TraceEvent::BeginType, 1);
+  events.emplace_back("dma", TraceLevel::COPY, 27, TraceEvent::EndType, 1);
+  events.emplace_back("run", TraceLevel::RUNTIME, 0, uint64_t(100), 0);
+  EXPECT_EQ(RequestTraceAnalysis::getCopyTime(events), 12);
+}
+
 INSTANTIATE_BACKEND_TEST(TraceEventsTest);
@@ -101,3 +101,49 @@ TEST(TraceExporter, traceEvents) {
   auto traceEvents = mockExporter.mergedTraceContext_->getTraceEvents();
   EXPECT_EQ(traceEvents.size(), 10);
 }
+
+TEST(TraceExporter, sampler) {
+  TraceSampler sampler(/* sampleRate */ 4, /* overheadBudget */ 1.0);
+  EXPECT_EQ(sampler.getRequestTraceLevel(), TraceLevel::STANDARD);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(sampler.getRequestTraceLevel(), TraceLevel::REQUEST);
+  }
+  EXPECT_EQ(sampler.getRequestTraceLevel(), TraceLevel::STANDARD);
+
+  // Sampled requests are exported, the others only when slower than the p99
+  // once enough latencies are known.
+  EXPECT_TRUE(sampler.shouldExport(TraceLevel::STANDARD, 10));
+  EXPECT_FALSE(sampler.shouldExport(TraceLevel::REQUEST, 10));
+  for (int i = 0; i < 200; i++) {
+    sampler.shouldExport(TraceLevel::REQUEST, 10);
+  }
+  EXPECT_EQ(sampler.getTailLatency(), 10);
+  EXPECT_FALSE(sampler.shouldExport(TraceLevel::REQUEST, 10));
+  EXPECT_TRUE(sampler.shouldExport(TraceLevel::REQUEST, 1000));
+}
+
+TEST(TraceExporter, samplerOverheadBudget) {
+  TraceSampler sampler(/* sampleRate */ 1, /* overheadBudget */ 0.01);
+  EXPECT_TRUE(sampler.shouldExport(TraceLevel::STANDARD, 100));
+  sampler.recordOverhead(100);
+  EXPECT_FALSE(sampler.shouldExport(TraceLevel::STANDARD, 100));
+  EXPECT_EQ(sampler.getRequestTraceLevel(), TraceLevel::REQUEST);
+}
+
+TEST(TraceExporter, exportSampledTrace) {
+  auto traceExporter = TraceExporterRegistry::getInstance();
+  MockTraceExporter mockExporter;
+  TraceContext glowTrace{TraceLevel::STANDARD};
+  glowTrace.logTraceEvent("foo_function", TraceLevel::RUNTIME, 'B');
+  glowTrace.logTraceEvent("foo_function", TraceLevel::RUNTIME, 'E');
+
+  // Without a sampler nothing is exported.
+  traceExporter->exportSampledTrace(&glowTrace, TraceLevel::STANDARD, 10);
+  EXPECT_EQ(mockExporter.mergedTraceContext_->getTraceEvents().size(), 0);
+
+  traceExporter->setSampler(std::make_shared<TraceSampler>(1, 1.0));
+  traceExporter->exportSampledTrace(&glowTrace, TraceLevel::STANDARD, 10);
+  traceExporter->exportSampledTrace(&glowTrace, TraceLevel::REQUEST, 10);
+  traceExporter->setSampler(nullptr);
+  EXPECT_EQ(mockExporter.mergedTraceContext_->getTraceEvents().size(), 2);
+}
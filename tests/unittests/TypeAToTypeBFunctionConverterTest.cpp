@@ -1614,3 +1614,57 @@ TEST(TypeAToTypeBFunctionConverter, FRWLWSConvert8Bit) {
 TEST(TypeAToTypeBFunctionConverter, FRWLWSConvert4Bit) {
   testFRWQSLWSDataIndicesConvert(ElemKind::UInt4FusedFP16QTy, 10, 10);
 }
+
+/// Backend only supporting FullyConnected in BFloat16, which asks to keep the
+/// nodes it does not support in float.
+class BFloat16FCMockBackend : public MockBackend {
+public:
+  bool isOpSupported(const NodeInfo &NI) const override {
+    return NI.getKind() == Kinded::Kind::FullyConnectedNodeKind &&
+           NI.allInputsAndOutputsHaveSameElemKind({ElemKind::BFloat16Ty});
+  }
+
+  bool convertsOnlySupportedNodesToFloat16(ElemKind toTy) const override {
+    return toTy == ElemKind::BFloat16Ty;
+  }
+};
+
+/// Check that only the nodes the backend supports in BFloat16 are converted
+/// when the backend asks for it: the FC of FC -> ReLU -> Save is converted,
+/// while the ReLU stays in float.
+TEST(TypeAToTypeBFunctionConverter, convertOnlyBackendSupportedNodes) {
+  Module mod;
+  Function *F = mod.createFunction("test");
+  PlaceholderBindings bindings;
+
+  auto *input =
+      mod.createPlaceholder(ElemKind::FloatTy, {20, 13}, "Input", false);
+  auto *output =
+      mod.createPlaceholder(ElemKind::FloatTy, {20, 10}, "Output", false);
+
+  auto *FC = F->createFullyConnected(bindings, "FC", input, 10);
+  auto *ReLU =
+      F->createRELU("ReLU", FC, FC->getType(FullyConnectedNode::ResultIdx));
+  auto *result = F->createSave("save", ReLU, output);
+
+  CompilationContext cctx;
+  PrecisionConfiguration &precConfig = cctx.precisionConfig;
+  precConfig.convertToFP16 = true;
+  precConfig.float16Format = PrecisionConfiguration::Float16Format::BFloat16;
+  transformForPrecisionMode(BFloat16FCMockBackend(), F, cctx);
+
+  auto *savedReLU = llvm::dyn_cast<ReluNode>(result->getInput());
+  ASSERT_NE(savedReLU, nullptr);
+  EXPECT_EQ(savedReLU->getResult().getElementType(), ElemKind::FloatTy);
+
+  auto *convertedFCResult =
+      llvm::dyn_cast<ConvertToNode>(savedReLU->getInput());
+  ASSERT_NE(convertedFCResult, nullptr);
+  auto *convertedFC =
+      llvm::dyn_cast<FullyConnectedNode>(convertedFCResult->getInput());
+  ASSERT_NE(convertedFC, nullptr);
+  EXPECT_EQ(convertedFC->getResult().getElementType(), ElemKind::BFloat16Ty);
+  EXPECT_EQ(convertedFC->getInput().getElementType(), ElemKind::BFloat16Ty);
+
+  EXPECT_TRUE(F->verify());
+}
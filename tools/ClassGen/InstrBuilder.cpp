@@ -203,10 +203,18 @@ void InstrBuilder::emitDataParallelProperty(std::ostream &os) const {
   os << "    return " << (isDataParallel_ ? "true" : "false") << ";\n  }\n";
 }
 
+void InstrBuilder::emitKindInfo(std::ostream &os) const {
+  os << "\n  static constexpr InstrKindInfo getKindInfo() {\n";
+  os << "    return {" << operands_.size() << ", "
+     << (isBackendSpecific_ ? "false" : "true") << ", "
+     << (isDataParallel_ ? "true" : "false") << "};\n  }\n";
+}
+
 void InstrBuilder::emitProperties(std::ostream &os) const {
   emitInplaceMethod(os);
   emitCanonicalProperty(os);
   emitDataParallelProperty(os);
+  emitKindInfo(os);
 }
 
 void InstrBuilder::emitClassMembers(std::ostream &os) const {
@@ -267,6 +267,9 @@ private:
   /// Emits the property that returns true if the instruction is data parallel.
   void emitDataParallelProperty(std::ostream &os) const;
 
+  /// Emits the table entry of the kind of the instruction, see InstrKindInfo.
+  void emitKindInfo(std::ostream &os) const;
+
   /// Emits the methods that are properties of the instructions.
   void emitProperties(std::ostream &os) const;
 
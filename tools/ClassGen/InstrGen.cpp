@@ -232,6 +232,18 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameElementType,
                   {"Dest", "Src", "ElemKind::Int8QTy"});
 
+  BB.newInstr("Int4GroupwiseQuantizedFullyConnected")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Src", OperandKind::In)
+      .addOperand("Weights", OperandKind::In)
+      .addOperand("Scales", OperandKind::In)
+      .addOperand("Offsets", OperandKind::In)
+      .addOperand("Bias", OperandKind::In)
+      .addMember(MemberType::Unsigned, "GroupSize")
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Src", "Bias", "ElemKind::FloatTy"});
+
   BB.newInstr("DynamicQuantizedFullyConnected")
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Src", OperandKind::In)
@@ -316,6 +328,33 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameShape, {"Dest", "Src"})
       .autoIRGen();
 
+  BB.newInstr("FusedSGD")
+      .addOperand("UpdatedWeight", OperandKind::Out)
+      .addOperand("UpdatedVelocity", OperandKind::Out)
+      .addOperand("Gradient", OperandKind::In)
+      .addOperand("Weight", OperandKind::In)
+      .addOperand("Velocity", OperandKind::In)
+      .addMember(MemberType::Float, "L1Decay")
+      .addMember(MemberType::Float, "L2Decay")
+      .addMember(MemberType::Float, "LearningRate")
+      .addMember(MemberType::Float, "Momentum")
+      .addMember(MemberType::Unsigned, "BatchSize")
+      .inplaceOperand({"UpdatedWeight", "Weight"})
+      .inplaceOperand({"UpdatedVelocity", "Velocity"})
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameType, {"UpdatedWeight", "UpdatedVelocity",
+                                         "Gradient", "Weight", "Velocity"});
+
+  BB.newInstr("LSTMUnit")
+      .addOperand("newC", OperandKind::Out)
+      .addOperand("newH", OperandKind::Out)
+      .addOperand("Input", OperandKind::In)
+      .addOperand("C", OperandKind::In)
+      .inplaceOperand({"newC", "C"})
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameType, {"newC", "newH", "C"})
+      .autoVerify(VerifyKind::SameElementType, {"newC", "Input"});
+
   BB.newInstr("CrossEntropyLoss")
       .addOperand("P", OperandKind::In)
       .addOperand("Labels", OperandKind::In)
@@ -353,6 +392,17 @@ int main(int argc, char **argv) {
       .autoIRGen()
       .autoVerify(VerifyKind::SameElementType, {"Dest", "LHS", "RHS"});
 
+  BB.newInstr("ScaledDotProductAttention")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Query", OperandKind::In)
+      .addOperand("Key", OperandKind::In)
+      .addOperand("Values", OperandKind::In)
+      .addOperand("Mask", OperandKind::In)
+      .addMember(MemberType::Float, "Scale")
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Query", "Key", "Values", "Mask"});
+
   /// Accumulates all of the layers in the batch along the Axis dimension and
   /// produce a tensor that has the same dimensions as the input tensor without
   /// the Axis dimension.
@@ -517,6 +567,22 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameElementType,
                   {"Lengths", "ElemKind::Int32ITy"});
 
+  BB.newInstr("ProductQuantizedSparseLengthsWeightedSum")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Codes", OperandKind::In)
+      .addOperand("Codebooks", OperandKind::In)
+      .addOperand("Weights", OperandKind::In)
+      .addOperand("Indices", OperandKind::In)
+      .addOperand("Lengths", OperandKind::In)
+      .autoIRGen()
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Dest", "Codebooks", "Weights", "ElemKind::FloatTy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Codes", "ElemKind::UInt8ITy"})
+      .autoVerify(VerifyKind::SameElementType,
+                  {"Lengths", "ElemKind::Int32ITy"})
+      .autoVerify(VerifyKind::SameShape, {"Weights", "Indices"});
+
   BB.newInstr("EmbeddingBagByteRowwiseOffsets")
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Data", OperandKind::In)
@@ -1179,6 +1245,18 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameElementType, {"Dest", "Src"})
       .autoIRGen();
 
+  BB.newInstr("Gelu")
+      .addOperand("Dest", OperandKind::Out)
+      .addOperand("Src", OperandKind::In)
+      .inplaceOperand({
+          "Dest",
+          "Src",
+      })
+      .dataParallel()
+      .autoVerify(VerifyKind::SameShape, {"Dest", "Src"})
+      .autoVerify(VerifyKind::SameElementType, {"Dest", "Src"})
+      .autoIRGen();
+
   BB.newInstr("SoftPlus")
       .addOperand("Dest", OperandKind::Out)
       .addOperand("Src", OperandKind::In)
@@ -1420,6 +1498,21 @@ int main(int argc, char **argv) {
       .autoVerify(VerifyKind::SameElementType, {"Values", "Input"})
       .autoVerify(VerifyKind::SameShape, {"Values", "Indices"});
 
+  BB.newInstr("BeamSearchStep")
+      .addOperand("NewScores", OperandKind::Out)
+      .addOperand("Tokens", OperandKind::Out)
+      .addOperand("PrevIndices", OperandKind::Out)
+      .addOperand("NewState", OperandKind::Out)
+      .addOperand("Logits", OperandKind::In)
+      .addOperand("Scores", OperandKind::In)
+      .addOperand("State", OperandKind::In)
+      .addOperand("Scratch", OperandKind::Scratch)
+      .autoVerify(VerifyKind::SameElementType,
+                  {"NewScores", "Logits", "Scores"})
+      .autoVerify(VerifyKind::SameElementType, {"Tokens", "PrevIndices"})
+      .autoVerify(VerifyKind::SameType, {"NewState", "State"})
+      .autoIRGen();
+
   //===--------------------------------------------------------------------===//
   //                   Conversions
   //===--------------------------------------------------------------------===//
@@ -655,6 +655,13 @@ void NodeBuilder::emitNodeClass(std::ostream &os) const {
      << "  bool hasSideEffects() const { return " << hasSideEffects_ << "; }\n"
      << "  bool isCanonical() const { return " << !isBackendSpecific_ << "; }\n"
      << "  bool isDataParallel() const { return " << isDataParallel_ << "; }\n"
+     << "  static constexpr NodeKindInfo getKindInfo() {\n"
+     << "    return {" << nodeInputs_.size() << ", "
+     << (hasVariadicInputs() ? "true" : "false") << ", "
+     << (hasSideEffects_ ? "true" : "false") << ", "
+     << (isBackendSpecific_ ? "false" : "true") << ", "
+     << (isDataParallel_ ? "true" : "false") << "};\n"
+     << "  }\n"
      << "  std::string getDebugDesc() const;\n"
      << "  bool isEqual(const " << name_ << "Node &other) const;\n"
      << "  llvm::hash_code getHash() const;\n"
@@ -701,6 +708,15 @@ void NodeBuilder::emitCppMethods(std::ostream &os) const {
   }
 }
 
+bool NodeBuilder::hasVariadicInputs() const {
+  for (const auto &op : members_) {
+    if ((op.first).type == MemberType::VectorNodeValue) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool NodeBuilder::hasCtorTypeParams(llvm::StringRef res) const {
   for (const std::string &s : ctorTypeParams_) {
     if (s == res) {
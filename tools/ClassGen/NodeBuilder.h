@@ -298,6 +298,9 @@ private:
   /// Emit cases for exporting to \p os.
   void emitExportMethods(std::ostream &os) const;
 
+  /// \returns whether the node has inputs of VectorNodeValue members.
+  bool hasVariadicInputs() const;
+
   // \returns whether \p res is contained in \ref ctorTypeParams_.
   bool hasCtorTypeParams(llvm::StringRef res) const;
 };
@@ -274,6 +274,24 @@ int main(int argc, char **argv) {
           "while weights are pre-rowwise-quantized to int8, whose rowwise "
           "params stored in Scales and Offsets, and bias are whether float "
           "or int32");
+
+  BB.newNode("Int4GroupwiseQuantizedFullyConnected")
+      .addInput("Input")
+      .addInput("Weights")
+      .addInput("Scales")
+      .addInput("Offsets")
+      .addInput("Bias")
+      .addMember(MemberType::Unsigned, "GroupSize")
+      .addResultFromCtorArg()
+      .setDocstring(
+          "Creates an Int4GroupwiseQuantizedFullyConnected node where the "
+          "float Input matrix and the transpose of the Weights matrix are "
+          "multiplied, and then the float Bias vector is broadcast-added to "
+          "the result. Only the Weights are quantized: each of the N rows of "
+          "K 4-bit values is packed two per byte, the even elements in the "
+          "low nibbles, and split into groups of GroupSize elements, each "
+          "dequantized as Scales * q + Offsets with the float16 Scales and "
+          "Offsets of shape {N, numGroups} of the group.");
   //===--------------------------------------------------------------------===//
   //                     Normalization
   //===--------------------------------------------------------------------===//
@@ -745,6 +763,21 @@ int main(int argc, char **argv) {
                     "RHS. The operands are a stack of two dimensional "
                     "matrices. Example: (N, A, Z) x (N, Z, B) => (N, A, B)");
 
+  BB.newNode("ScaledDotProductAttention")
+      .addInput("Query")
+      .addInput("Key")
+      .addInput("Values")
+      .addInput("Mask")
+      .addMember(MemberType::Float, "Scale")
+      .addResultFromCtorArg()
+      .setDocstring(
+          "Computes SoftMax(Query x Key^T * Scale + Mask) x Values for each "
+          "batch, with the SoftMax over the last dimension. Query is (N, Lq, "
+          "D), Key is (N, Lk, D), Values is (N, Lk, Dv) and the Result is (N, "
+          "Lq, Dv). Multi-head attention folds the heads into N. Mask is "
+          "added to the attention scores and each of its dimensions is "
+          "either 1 or that of the (N, Lq, Lk) scores.");
+
   BB.newNode("BatchedReduceAdd")
       .addInput("Batch")
       .addMember(MemberType::Unsigned, "Axis")
@@ -973,6 +1006,23 @@ int main(int argc, char **argv) {
                     "Offsets are appended to the end of each row. Thus, Data "
                     "must be a two-dimensional tensor.");
 
+  BB.newNode("ProductQuantizedSparseLengthsWeightedSum")
+      .addInput("Codes")
+      .addInput("Codebooks")
+      .addInput("Weights")
+      .addInput("Indices")
+      .addInput("Lengths")
+      .addResultFromCtorArg()
+      .setDocstring("Same as SparseLengthsWeightedSum, but the rows of the "
+                    "table are product-quantized. Each row is split into "
+                    "numSubspaces contiguous subvectors of subDim elements, "
+                    "and every subvector is stored as a byte code into the "
+                    "codebook of its subspace. Codes has shape {numRows, "
+                    "numSubspaces} of UInt8ITy and the float Codebooks have "
+                    "shape {numSubspaces, numCentroids, subDim}, so that "
+                    "subvector s of row r is Codebooks[s][Codes[r][s]]. The "
+                    "Result has shape {len(Lengths), numSubspaces * subDim}.");
+
   BB.newNode("LengthsToRanges")
       .addInput("Lengths")
       .addResultFromCtorArg()
@@ -1456,6 +1506,24 @@ int main(int argc, char **argv) {
                     "Produces the updated weight that needs to be used "
                     "instead of Weight for the next iteration.");
 
+  BB.newNode("FusedSGD")
+      .addInput("Gradient")
+      .addInput("Weight")
+      .addInput("Velocity")
+      .addMember(MemberType::Float, "L1Decay")
+      .addMember(MemberType::Float, "L2Decay")
+      .addMember(MemberType::Float, "LearningRate")
+      .addMember(MemberType::Float, "Momentum")
+      .addMember(MemberType::Unsigned, "BatchSize")
+      .addResult("Weight.getType()", "UpdatedWeight")
+      .addResult("Weight.getType()", "UpdatedVelocity")
+      .setDocstring("The whole update of an SGD node in a single pass over "
+                    "the weight and its gradient. Velocity is the momentum "
+                    "sum of the previous updates and UpdatedVelocity its new "
+                    "value, which is undefined unless Momentum is positive. "
+                    "Backends without a fused kernel lower it into "
+                    "element-wise nodes.");
+
   //===--------------------------------------------------------------------===//
   //             Nodes used for debugging/profiling/printing
   //===--------------------------------------------------------------------===//
@@ -1550,6 +1618,24 @@ int main(int argc, char **argv) {
                     "the outputs {D_0, D_1, ... D_n-1, K}, sorted in "
                     "non-decreasing order.");
 
+  BB.newNode("BeamSearchStep")
+      .addInput("Logits")
+      .addInput("Scores")
+      .addInput("State")
+      .addResultFromCtorArg("NewScores")
+      .addResultFromCtorArg("Tokens")
+      .addResultFromCtorArg("PrevIndices")
+      .addResult("State.getType()", "NewState")
+      .setDocstring(
+          "One step of a beam search over B beams. Logits {B, V} are the "
+          "scores of the next token of each beam and Scores {B} the log "
+          "probabilities of the beams. The B best candidates of "
+          "Scores[b] + LogSoftMax(Logits[b])[v] across all the beams and "
+          "tokens, best first with ties broken by b * V + v, give NewScores, "
+          "their tokens v in Tokens and their beams b in PrevIndices. "
+          "NewState is State {B, ...} with its rows reordered by "
+          "PrevIndices.");
+
   BB.newNode("LSTMUnit")
       .addInput("Input")
       .addInput("C")
@@ -1560,7 +1646,8 @@ int main(int argc, char **argv) {
           "takes F from forget gate, I from input gate,"
           "O from output gate, G from cell gate and C from cell state. "
           "Calulates newC = sigmoid(F) * C + sigmoid(I) * tanh(G), "
-          "newH = tanh(newC) * sigmoid(O).");
+          "newH = tanh(newC) * sigmoid(O). Backends with a fused cell "
+          "kernel keep it whole, others lower it into element-wise nodes.");
 
   //===--------------------------------------------------------------------===//
   //                Conversions
@@ -19,6 +19,8 @@
 #include "glow/Graph/Graph.h"
 #include "glow/Graph/Node.h"
 
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/TraceEvents.h"
 #include "glow/ExecutionEngine/ExecutionEngine.h"
 #include "glow/Graph/Hook.h"
 #include "glow/Graph/Utils.h"
@@ -26,6 +28,9 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/FormatVariadic.h"
 
+#include <algorithm>
+#include <fstream>
+
 #define DEBUG_TYPE "verifier"
 
 using namespace glow;
@@ -361,3 +366,183 @@ IntermediateLayerComparator::IntermediateLayerComparator(
     bool dumpTensorsForBadLayer)
     : NetworkComparatorBase(mod, referenceBackend, testBackend,
                             numericCmpThreshold, dumpTensorsForBadLayer) {}
+
+LayerLatencyComparator::LayerLatencyComparator(
+    Module &mod, const std::string &referenceBackend,
+    const std::string &testBackend, float latencyThreshold,
+    uint64_t minRegressionUs, unsigned numRuns,
+    const std::string &baselinePath, const std::string &savePath)
+    : NetworkComparatorBase(mod, referenceBackend, testBackend,
+                            /* numericCmpThreshold */ 0,
+                            /* dumpTensorsForBadLayer */ false),
+      latencyThreshold_(latencyThreshold), minRegressionUs_(minRegressionUs),
+      numRuns_(std::max(numRuns, 1u)), baselinePath_(baselinePath),
+      savePath_(savePath) {}
+
+LayerLatencyComparator::LayerLatencyMap
+LayerLatencyComparator::measure(ExecutionEngine &EE,
+                                PlaceholderBindings *bindings) {
+  ExecutionContext context;
+  PlaceholderBindings *runBindings = context.getPlaceholderBindings();
+  runBindings->allocate(EE.getModule().getPlaceholders());
+  for (auto &PH : bindings->pairs()) {
+    auto *iPH = runBindings->getPlaceholderByNameSlow(PH.first->getName());
+    if (iPH) {
+      runBindings->get(iPH)->assign(&PH.second);
+    }
+  }
+
+  std::map<std::string, std::vector<uint64_t>> times;
+  std::map<std::string, std::string> kinds;
+  // The first run is not timed, it warms up the caches and the lazily
+  // allocated state of the backend.
+  for (unsigned run = 0; run <= numRuns_; run++) {
+    context.setTraceContext(
+        glow::make_unique<TraceContext>(TraceLevel::OPERATOR));
+    EE.run(context);
+    if (run == 0) {
+      continue;
+    }
+    // A layer lowered to several instructions of the same name, or run more
+    // than once, is charged the sum of their times.
+    std::map<std::string, uint64_t> runTimes;
+    std::map<std::string, uint64_t> begins;
+    for (const auto &event : context.getTraceContext()->getTraceEvents()) {
+      if (event.level != TraceLevel::OPERATOR) {
+        continue;
+      }
+      auto kindIt = event.args.find("kind");
+      if (kindIt != event.args.end()) {
+        kinds[event.name] = kindIt->second;
+      }
+      if (event.type == TraceEvent::CompleteType) {
+        runTimes[event.name] += event.duration;
+      } else if (event.type == TraceEvent::BeginType) {
+        begins[event.name] = event.timestamp;
+      } else if (event.type == TraceEvent::EndType) {
+        auto beginIt = begins.find(event.name);
+        if (beginIt != begins.end()) {
+          runTimes[event.name] += event.timestamp - beginIt->second;
+          begins.erase(beginIt);
+        }
+      }
+    }
+    for (const auto &time : runTimes) {
+      times[time.first].push_back(time.second);
+    }
+  }
+
+  LayerLatencyMap latencies;
+  for (auto &time : times) {
+    auto &samples = time.second;
+    auto median = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), median, samples.end());
+    LayerLatency &latency = latencies[time.first];
+    latency.kind = kinds[time.first];
+    latency.medianUs = *median;
+  }
+  return latencies;
+}
+
+void LayerLatencyComparator::saveLatencies(const LayerLatencyMap &latencies,
+                                           llvm::StringRef path) {
+  std::ofstream os(path.str());
+  CHECK(os) << "Cannot write the layer latencies to " << path.str();
+  os << "layer,kind,median_us\n";
+  for (const auto &latency : latencies) {
+    os << latency.first << "," << latency.second.kind << ","
+       << latency.second.medianUs << "\n";
+  }
+}
+
+LayerLatencyComparator::LayerLatencyMap
+LayerLatencyComparator::loadLatencies(llvm::StringRef path) {
+  std::ifstream is(path.str());
+  CHECK(is) << "Cannot read the layer latencies from " << path.str();
+  LayerLatencyMap latencies;
+  std::string line;
+  // Skip the header.
+  std::getline(is, line);
+  while (std::getline(is, line)) {
+    // Split from the right since layer names may contain commas.
+    auto medianSplit = llvm::StringRef(line).rsplit(',');
+    auto kindSplit = medianSplit.first.rsplit(',');
+    uint64_t median;
+    if (kindSplit.first.empty() ||
+        medianSplit.second.trim().getAsInteger(10, median)) {
+      LOG(WARNING) << "Skipping malformed line of " << path.str() << ": "
+                   << line;
+      continue;
+    }
+    LayerLatency &latency = latencies[kindSplit.first.str()];
+    latency.kind = kindSplit.second.str();
+    latency.medianUs = median;
+  }
+  return latencies;
+}
+
+bool LayerLatencyComparator::verify(PlaceholderBindings *bindings) {
+  if (!compiled_) {
+    CompilationContext refCctx;
+    refCctx.backendOpts.autoInstrument = true;
+    if (baselinePath_.empty()) {
+      EERefNet_.compile(refCctx);
+    }
+    CompilationContext testCctx;
+    testCctx.backendOpts.autoInstrument = true;
+    EETestNet_.compile(testCctx);
+    compiled_ = true;
+  }
+
+  LayerLatencyMap test = measure(EETestNet_, bindings);
+  LayerLatencyMap ref = baselinePath_.empty() ? measure(EERefNet_, bindings)
+                                              : loadLatencies(baselinePath_);
+  if (!savePath_.empty()) {
+    saveLatencies(test, savePath_);
+  }
+  if (test.empty()) {
+    LOG(ERROR) << "The " << EETestNet_.getBackendName()
+               << " backend recorded no operator events, it may not support "
+                  "auto instrumentation";
+    return false;
+  }
+
+  bool allPassed = true;
+  uint64_t refTotal = 0;
+  uint64_t testTotal = 0;
+  unsigned unmatched = 0;
+  LOG(INFO) << llvm::formatv("{0,-40} {1,-20} {2,10} {3,10} {4,8}", "Layer",
+                             "Kind", "Ref (us)", "Test (us)", "Ratio")
+                   .str();
+  for (const auto &testIt : test) {
+    auto refIt = ref.find(testIt.first);
+    if (refIt == ref.end()) {
+      unmatched++;
+      continue;
+    }
+    uint64_t refUs = refIt->second.medianUs;
+    uint64_t testUs = testIt.second.medianUs;
+    refTotal += refUs;
+    testTotal += testUs;
+    bool regressed = testUs > refUs * (1 + latencyThreshold_) &&
+                     testUs - refUs > minRegressionUs_;
+    LOG(INFO) << llvm::formatv("{0,-40} {1,-20} {2,10} {3,10} {4,8:f2}{5}",
+                               testIt.first, testIt.second.kind, refUs,
+                               testUs, refUs ? double(testUs) / refUs : 0.0,
+                               regressed ? "  REGRESSED" : "")
+                     .str();
+    if (regressed) {
+      brokenLayers_.push_back(testIt.first);
+      allPassed = false;
+    }
+  }
+  LOG(INFO) << llvm::formatv("{0,-40} {1,-20} {2,10} {3,10}", "Total", "",
+                             refTotal, testTotal)
+                   .str();
+  if (unmatched) {
+    LOG(INFO) << unmatched
+              << " layers of the test run have no reference time, e.g. "
+                 "because the backends lower them differently";
+  }
+  return allPassed;
+}
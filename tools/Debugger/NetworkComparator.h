@@ -21,6 +21,7 @@
 #include "glow/Graph/PlaceholderBindings.h"
 #include "llvm/ADT/StringRef.h"
 #include <list>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -190,6 +191,68 @@ public:
   virtual bool verify(PlaceholderBindings *bindings) override;
 };
 
+/// A comparator class that compares the latency of the layers of the network
+/// instead of their results. The whole network is run with auto
+/// instrumentation on the reference and test backends, and the per layer
+/// times recorded in the operator trace events are aligned by layer name. A
+/// layer regressed when its median time on the test backend exceeds the
+/// reference one by more than the relative threshold and by more than a
+/// minimum number of microseconds. The reference times can also be loaded
+/// from a file saved by a previous run, e.g. of another build of Glow.
+class LayerLatencyComparator : public NetworkComparatorBase {
+public:
+  /// Median time and kind of a layer.
+  struct LayerLatency {
+    std::string kind;
+    uint64_t medianUs{0};
+  };
+  using LayerLatencyMap = std::map<std::string, LayerLatency>;
+
+private:
+  /// Accepted relative increase of the latency of a layer.
+  float latencyThreshold_;
+  /// Increases of at most this many microseconds are never regressions.
+  uint64_t minRegressionUs_;
+  /// Number of timed runs per backend.
+  unsigned numRuns_;
+  /// If not empty, file the reference latencies are loaded from instead of
+  /// running the reference backend.
+  std::string baselinePath_;
+  /// If not empty, file the test latencies are saved to.
+  std::string savePath_;
+  /// Whether the execution engines have been compiled.
+  bool compiled_{false};
+
+  /// Runs the network of \p EE numRuns_ times with the inputs in \p bindings
+  /// and \returns the median time of each of its layers.
+  LayerLatencyMap measure(ExecutionEngine &EE, PlaceholderBindings *bindings);
+
+public:
+  /// Constructor for the LayerLatencyComparator tester that times the network
+  /// passed in \p mod on the \p testBackend and the \p referenceBackend over
+  /// \p numRuns runs each. A layer regressed when it is slower by more than
+  /// \p latencyThreshold (relative) and \p minRegressionUs. If \p baselinePath
+  /// is not empty the reference latencies are loaded from it, and if
+  /// \p savePath is not empty the test latencies are saved to it.
+  LayerLatencyComparator(Module &mod, const std::string &referenceBackend,
+                         const std::string &testBackend,
+                         float latencyThreshold, uint64_t minRegressionUs,
+                         unsigned numRuns, const std::string &baselinePath,
+                         const std::string &savePath);
+
+  /// Writes \p latencies to the CSV file \p path.
+  static void saveLatencies(const LayerLatencyMap &latencies,
+                            llvm::StringRef path);
+
+  /// \returns the latencies read from the CSV file \p path written by
+  /// saveLatencies().
+  static LayerLatencyMap loadLatencies(llvm::StringRef path);
+
+  /// Times the network on both backends with the inputs in \p bindings and
+  /// reports the layers that regressed. \returns True if none did.
+  bool verify(PlaceholderBindings *bindings) override;
+};
+
 } // namespace glow
 
 #endif // GLOW_GRAPH_NETWORKCOMPARATOR_H
@@ -28,6 +28,15 @@
  * output tensors for the layers will be printed from the reference network to
  * disk.
  *
+ *  With -comparator=Latency the tool compares the per layer latencies of the
+ * two backends instead and fails when a layer regressed. To compare two builds
+ * of Glow, save the latencies of one with -latency_save and pass them to the
+ * other with -latency_baseline:
+ *  ./network-debugger --model function_0.zip --inputs input_0.onnx
+ *      -backend=CPU -comparator=Latency -latency_save=base.csv
+ *  ./network-debugger --model function_0.zip --inputs input_0.onnx
+ *      -backend=CPU -comparator=Latency -latency_baseline=base.csv
+ *
  */
 
 #include "glow/ExecutionEngine/ExecutionEngine.h"
@@ -60,11 +69,46 @@ llvm::cl::opt<std::string>
                 llvm::cl::desc("Backend to use, e.g. Interpreter, CPU, NNPI:"),
                 llvm::cl::init("Interpreter"), llvm::cl::cat(debuggerTestCat));
 
+llvm::cl::opt<std::string> referenceBackend(
+    "reference_backend",
+    llvm::cl::desc("Backend the test backend is compared against"),
+    llvm::cl::init("Interpreter"), llvm::cl::cat(debuggerTestCat));
+
 llvm::cl::opt<std::string> comparatorType(
     "comparator",
-    llvm::cl::desc("The type of comparator to use, Recursive or Intermediate"),
+    llvm::cl::desc("The type of comparator to use, Recursive, Intermediate or "
+                   "Latency"),
     llvm::cl::init("Intermediate"), llvm::cl::cat(debuggerTestCat));
 
+llvm::cl::opt<float> latencyThreshold(
+    "latency_threshold",
+    llvm::cl::desc("Relative latency increase after which a layer regressed, "
+                   "for the Latency comparator"),
+    llvm::cl::Optional, llvm::cl::init(0.1), llvm::cl::cat(debuggerTestCat));
+
+llvm::cl::opt<unsigned> latencyMinUs(
+    "latency_min_us",
+    llvm::cl::desc("Latency increases of at most this many microseconds are "
+                   "not regressions, for the Latency comparator"),
+    llvm::cl::Optional, llvm::cl::init(5), llvm::cl::cat(debuggerTestCat));
+
+llvm::cl::opt<unsigned> latencyRuns(
+    "latency_runs",
+    llvm::cl::desc("Number of timed runs per backend, for the Latency "
+                   "comparator"),
+    llvm::cl::Optional, llvm::cl::init(10), llvm::cl::cat(debuggerTestCat));
+
+llvm::cl::opt<std::string> latencyBaseline(
+    "latency_baseline",
+    llvm::cl::desc("CSV file of reference latencies saved by -latency_save, "
+                   "used instead of running the reference backend"),
+    llvm::cl::Optional, llvm::cl::cat(debuggerTestCat));
+
+llvm::cl::opt<std::string> latencySave(
+    "latency_save",
+    llvm::cl::desc("CSV file the latencies of the test backend are saved to"),
+    llvm::cl::Optional, llvm::cl::cat(debuggerTestCat));
+
 llvm::cl::opt<float> numericCmpThreshold(
     "threshold", llvm::cl::desc("Threshold for tensor numeric comparison"),
     llvm::cl::Optional, llvm::cl::init(1e-5), llvm::cl::cat(debuggerTestCat));
@@ -147,9 +191,8 @@ void loadModelIntoFunc(Function *F) {
 }
 
 bool run() {
-  LOG(INFO) << "Comparing the " << testBackend
-            << " backend against the Interpreter "
-               "(reference backend)";
+  LOG(INFO) << "Comparing the " << testBackend << " backend against the "
+            << referenceBackend << " (reference backend)";
   Module mod;
   bool allPass = true;
   loadModelIntoFunc(mod.createFunction("test"));
@@ -158,10 +201,14 @@ bool run() {
   std::unique_ptr<NetworkComparatorBase> netCompare;
   if (comparatorType == "comparatorType") {
     netCompare.reset(new IntermediateLayerComparator(
-        mod, "Interpreter", testBackend, numericCmpThreshold, dumpTensors));
+        mod, referenceBackend, testBackend, numericCmpThreshold, dumpTensors));
+  } else if (comparatorType == "Latency") {
+    netCompare.reset(new LayerLatencyComparator(
+        mod, referenceBackend, testBackend, latencyThreshold, latencyMinUs,
+        latencyRuns, latencyBaseline, latencySave));
   } else {
     netCompare.reset(new RecursiveLayerComparator(
-        mod, "Interpreter", testBackend, numericCmpThreshold, dumpTensors));
+        mod, referenceBackend, testBackend, numericCmpThreshold, dumpTensors));
   }
   PlaceholderBindings inputBindings;
   inputBindings.allocate(mod.getPlaceholders());
@@ -179,7 +226,9 @@ bool run() {
 int main(int argc, char **argv) {
   parseCommandLine(argc, argv);
   if (run()) {
-    LOG(INFO) << "All layers match with no errors\n";
+    LOG(INFO) << (comparatorType == "Latency"
+                      ? "No layer latency regressed\n"
+                      : "All layers match with no errors\n");
     return 0;
   } else {
     LOG(ERROR) << "Errors found!";
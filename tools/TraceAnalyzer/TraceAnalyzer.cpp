@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reads Chrome trace JSON files written with -trace-path, rebuilds the
+// timeline of every inference request from its REQUEST level events and
+// prints where the latency of the requests went along their critical paths,
+// see RequestTraceAnalysis.
+
+#include "glow/ExecutionContext/TraceAnalysis.h"
+#include "glow/IR/LLVMAPIMacros.h"
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace glow;
+
+namespace {
+llvm::cl::OptionCategory traceAnalyzerCat("trace-analyzer Options");
+llvm::cl::list<std::string> traceFiles(llvm::cl::Positional,
+                                       llvm::cl::desc("<trace files>"),
+                                       llvm::cl::OneOrMore,
+                                       llvm::cl::cat(traceAnalyzerCat));
+llvm::cl::opt<unsigned>
+    numSlowest("slowest",
+               llvm::cl::desc("Number of the slowest requests to print"),
+               llvm::cl::init(10), llvm::cl::cat(traceAnalyzerCat));
+llvm::cl::opt<std::string>
+    outputFile("o", llvm::cl::desc("Write the report to this file"),
+               llvm::cl::value_desc("file"), llvm::cl::init(""),
+               llvm::cl::cat(traceAnalyzerCat));
+} // namespace
+
+int main(int argc, char **argv) {
+  llvm::cl::ParseCommandLineOptions(
+      argc, argv,
+      "Critical path analysis of the inference requests of Glow traces.\n"
+      "Traces must be recorded with the REQUEST trace level, which the\n"
+      "STANDARD level includes.\n");
+
+  RequestTraceAnalysis analysis;
+  for (const auto &file : traceFiles) {
+    auto events = EXIT_ON_ERR(RequestTraceAnalysis::loadTrace(file));
+    // Each trace comes from its own HostManager, whose request ids start
+    // from 0.
+    analysis.addTraceEvents(events, traceFiles.size() > 1 ? file : "");
+  }
+  analysis.analyze();
+
+  if (outputFile.empty()) {
+    analysis.dump(llvm::outs(), numSlowest);
+    return 0;
+  }
+  std::error_code EC;
+  llvm::raw_fd_ostream os(outputFile, EC, GET_FS_OPENFLAGS(F_Text));
+  if (EC) {
+    llvm::errs() << "Unable to open " << outputFile << ": " << EC.message()
+                 << "\n";
+    return 1;
+  }
+  analysis.dump(os, numSlowest);
+  return 0;
+}
@@ -25,6 +25,8 @@
 #include "glow/Importer/Caffe2ModelLoader.h"
 #include "glow/Importer/ONNXModelLoader.h"
 #include "glow/Optimizer/IROptimizer/CommandLine.h"
+#include "glow/Partitioner/NodeCostProfile.h"
+#include "glow/Partitioner/RooflineReport.h"
 #include "glow/Support/Support.h"
 
 #include "llvm/ADT/StringSwitch.h"
@@ -35,9 +37,11 @@
 
 #include <atomic>
 #include <cfloat>
+#include <condition_variable>
 #include <fstream>
 #include <future>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -86,6 +90,135 @@ private:
   UniquePtrVec<PreProcessInputDataExtension> extensions_;
 };
 
+/// Loads the mini-batches of a range of input images ahead of their inference
+/// with a pool of threads. At most \p depth mini-batches are loaded or waiting
+/// to be consumed at any time, and they are consumed in order.
+class InputPrefetcher {
+public:
+  /// Loads the input tensors of a mini-batch from the filenames of its images,
+  /// one list per input.
+  using LoadFn = std::function<void(VecVecRef<std::string> filenames,
+                                    llvm::ArrayRef<Tensor *> inputData)>;
+
+  /// Starts \p numThreads threads loading with \p load the mini-batches of
+  /// size \p miniBatchSize of \p filenames in [\p startIndex, \p endIndex).
+  InputPrefetcher(VecVecRef<std::string> filenames, size_t startIndex,
+                  size_t endIndex, size_t miniBatchSize, unsigned depth,
+                  unsigned numThreads, LoadFn load);
+
+  /// Stops the threads once the mini-batches they are loading are done.
+  ~InputPrefetcher();
+
+  /// Waits for the next mini-batch and moves its image filenames into
+  /// \p batchFilenames and its input tensors into \p inputData. \returns
+  /// false once all the mini-batches have been consumed.
+  bool next(VecVec<std::string> &batchFilenames,
+            std::vector<Tensor> &inputData);
+
+private:
+  struct Batch {
+    VecVec<std::string> filenames;
+    std::vector<Tensor> inputData;
+  };
+
+  void loadBatches();
+
+  VecVecRef<std::string> filenames_;
+  size_t startIndex_;
+  size_t miniBatchSize_;
+  size_t numBatches_;
+  unsigned depth_;
+  LoadFn load_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  /// Index of the next mini-batch to load and to consume.
+  size_t nextToLoad_{0};
+  size_t nextToConsume_{0};
+  /// Loaded mini-batches, not consumed yet.
+  std::map<size_t, Batch> ready_;
+  bool stop_{false};
+  std::vector<std::thread> threads_;
+};
+
+InputPrefetcher::InputPrefetcher(VecVecRef<std::string> filenames,
+                                 size_t startIndex, size_t endIndex,
+                                 size_t miniBatchSize, unsigned depth,
+                                 unsigned numThreads, LoadFn load)
+    : filenames_(filenames), startIndex_(startIndex),
+      miniBatchSize_(miniBatchSize),
+      numBatches_((endIndex - startIndex) / miniBatchSize), depth_(depth),
+      load_(std::move(load)) {
+  CHECK_GT(depth_, 0) << "The prefetch depth must be positive.";
+  for (unsigned i = 0; i < std::max(numThreads, 1u); i++) {
+    threads_.emplace_back(&InputPrefetcher::loadBatches, this);
+  }
+}
+
+InputPrefetcher::~InputPrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &t : threads_) {
+    t.join();
+  }
+}
+
+void InputPrefetcher::loadBatches() {
+  while (true) {
+    size_t batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&] {
+        return stop_ || nextToLoad_ >= numBatches_ ||
+               nextToLoad_ < nextToConsume_ + depth_;
+      });
+      if (stop_ || nextToLoad_ >= numBatches_) {
+        return;
+      }
+      batch = nextToLoad_++;
+    }
+
+    Batch loaded;
+    size_t miniBatchIndex = startIndex_ + batch * miniBatchSize_;
+    getNextMiniBatch(loaded.filenames, filenames_, miniBatchIndex,
+                     miniBatchSize_, miniBatchIndex + miniBatchSize_);
+    loaded.inputData.resize(loaded.filenames.size());
+    std::vector<Tensor *> inputData;
+    for (auto &data : loaded.inputData) {
+      inputData.push_back(&data);
+    }
+    load_(loaded.filenames, inputData);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_.emplace(batch, std::move(loaded));
+    }
+    cv_.notify_all();
+  }
+}
+
+bool InputPrefetcher::next(VecVec<std::string> &batchFilenames,
+                           std::vector<Tensor> &inputData) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (nextToConsume_ >= numBatches_) {
+    return false;
+  }
+  cv_.wait(lock, [&] { return ready_.count(nextToConsume_) != 0; });
+  auto it = ready_.find(nextToConsume_);
+  batchFilenames = std::move(it->second.filenames);
+  for (size_t i = 0, e = inputData.size(); i < e; i++) {
+    inputData[i] = std::move(it->second.inputData[i]);
+  }
+  ready_.erase(it);
+  nextToConsume_++;
+  lock.unlock();
+  cv_.notify_all();
+  return true;
+}
+
 void PostProcessExecutor::registerPostProcessOutputExtensions(
     const std::vector<PostProcessExtFuncPtr> &extVector) {
   for (auto &f : extVector) {
@@ -311,10 +444,18 @@ int Executor::executeNetwork() {
   CHECK(!iterationsOpt || (modelInputsOpt.size() == 1))
       << "Benchmark mode doesn't support networks with multiple inputs.";
 
+  CHECK(!prefetchDepth ||
+        (miniBatchMode && !preloadAllImages && !streamInputFilenamesMode &&
+         !singleBatchRepeatedMode && !iterationsOpt))
+      << "prefetch-depth requires the minibatch mode, and is not compatible "
+         "with preload-all-images, stream input mode, "
+         "repeat-single-batch-count and benchmark mode.";
+
   // Print out the inferred image classification.
   llvm::outs() << "Model: " << Loader::getModelOptPath() << "\n";
   std::mutex ioMu;
   int numErrors = 0;
+  std::unique_ptr<RooflineReport> rooflineReport;
 
   if (runAllInputsOnAllDevices) {
     if (numDevices != miniBatchThreads) {
@@ -425,6 +566,23 @@ int Executor::executeNetwork() {
 
     unsigned repeatedLoopCountRemaining = repeatSingleBatchCount;
 
+    // Load the mini-batches of this thread ahead of their inference. The
+    // input preprocessing extensions still run on this thread.
+    std::unique_ptr<InputPrefetcher> prefetcher;
+    if (prefetchDepth && !emittingBundle()) {
+      prefetcher = glow::make_unique<InputPrefetcher>(
+          inputImageFilenames_, startIndex, endIndex, miniBatch, prefetchDepth,
+          prefetchThreads,
+          [](VecVecRef<std::string> filenames, llvm::ArrayRef<Tensor *> data) {
+            if (!inputTensorListFile.empty()) {
+              loadInputImageFromFileWithType(filenames[0], data[0],
+                                             imageLayoutOpt[0]);
+            } else {
+              loadImagesAndPreprocess(filenames, data);
+            }
+          });
+    }
+
     auto loopCond = [&]() {
       // If in stream mode then get the next image filenames if they exist,
       // otherwise exit.
@@ -438,6 +596,15 @@ int Executor::executeNetwork() {
         return repeatedLoopCountRemaining-- != 0;
       }
 
+      // If prefetching then get the next mini-batch once it is loaded.
+      if (prefetcher) {
+        if (!prefetcher->next(inputImageBatchFilenames, inputData)) {
+          return false;
+        }
+        miniBatchIndex += miniBatch;
+        return true;
+      }
+
       // If in miniBatchMode then continue if we have already preloaded all
       // images (will break inside loop once done), or otherwise get the next
       // miniBatch image filenames if they exist, otherwise exit.
@@ -453,11 +620,17 @@ int Executor::executeNetwork() {
     while (loopCond()) {
       if (!preloadAllImages && (!singleBatchRepeatedMode || isFirstRun)) {
         // Load and process the image data into the inputImageData Tensor.
+        // When prefetching, the data was loaded by the prefetcher.
         if (!inputTensorListFile.empty()) {
-          loadInputImageFromFileWithType(inputImageBatchFilenames[0],
-                                         inputImageData[0], imageLayoutOpt[0]);
+          if (!prefetcher) {
+            loadInputImageFromFileWithType(inputImageBatchFilenames[0],
+                                           inputImageData[0],
+                                           imageLayoutOpt[0]);
+          }
         } else {
-          loadImagesAndPreprocess(inputImageBatchFilenames, inputImageData);
+          if (!prefetcher) {
+            loadImagesAndPreprocess(inputImageBatchFilenames, inputImageData);
+          }
           ppImageExecutor.processInputTensor(inputImageData, startIndex,
                                              endIndex,
                                              inputImageData[0]->dims()[0]);
@@ -635,6 +808,21 @@ int Executor::executeNetwork() {
       loader.generateAndSerializeProfilingInfos(bindings);
     }
 
+    // All the threads compile the same model, so the functions of the first
+    // one to get here are enough for the roofline report.
+    if (!rooflineReportPath.empty()) {
+      std::lock_guard<std::mutex> lock(ioMu);
+      if (!rooflineReport) {
+        auto deviceInfo =
+            EXIT_ON_ERR(loader.getHostManager()->getDeviceInfo(0));
+        rooflineReport = glow::make_unique<RooflineReport>(
+            deviceInfo, rooflineEfficiencyThreshold);
+        for (const auto *F : loader.getModule()->getFunctions()) {
+          rooflineReport->addFunction(F);
+        }
+      }
+    }
+
     if (!tracePath.empty()) {
       Error err = loader.getHostManager()->stopDeviceTrace();
       if (err) {
@@ -699,5 +887,27 @@ int Executor::executeNetwork() {
     traceContext->dump(tracePath, appName_);
   }
 
+  if (!nodeCostProfilePath.empty()) {
+    CHECK(traceContext) << "-node-cost-profile requires -trace-path";
+    NodeCostProfile profile;
+    profile.addTraceEvents(ExecutionBackend, traceContext->getTraceEvents());
+    LOG_IF(WARNING, profile.empty())
+        << "No operator latencies were traced, was -auto-instrument set?";
+    EXIT_ON_ERR(profile.save(nodeCostProfilePath));
+  }
+
+  if (!rooflineReportPath.empty()) {
+    CHECK(traceContext) << "-roofline-report requires -trace-path";
+    CHECK(rooflineReport) << "No function was compiled for -roofline-report";
+    rooflineReport->addTraceEvents(traceContext->getTraceEvents());
+    EXIT_ON_ERR(rooflineReport->save(rooflineReportPath));
+  }
+
+  if (autoInstrumentCounters) {
+    CHECK(traceContext) << "-auto-instrument-counters requires -trace-path";
+    TraceEvent::dumpOperatorSummary(llvm::outs(),
+                                    traceContext->getTraceEvents());
+  }
+
   return numErrors;
 }
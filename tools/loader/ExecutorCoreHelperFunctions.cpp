@@ -130,12 +130,41 @@ llvm::cl::opt<std::string> tracePath("trace-path",
                                      llvm::cl::init(""),
                                      llvm::cl::cat(executorCat));
 
+llvm::cl::opt<std::string> nodeCostProfilePath(
+    "node-cost-profile",
+    llvm::cl::desc("Write the measured latency of every operator to a YAML "
+                   "profile the partitioner can balance partitions with, see "
+                   "-glow_partitioner_cost_profile. Requires -trace-path and "
+                   "-auto-instrument"),
+    llvm::cl::init(""), llvm::cl::cat(executorCat));
+
+llvm::cl::opt<std::string> rooflineReportPath(
+    "roofline-report",
+    llvm::cl::desc("Write the FLOPs, bytes moved and measured latency of "
+                   "every operator next to its roofline bound on the first "
+                   "device, flagging the operators far from it. Requires "
+                   "-trace-path and -auto-instrument"),
+    llvm::cl::init(""), llvm::cl::cat(executorCat));
+
+llvm::cl::opt<double> rooflineEfficiencyThreshold(
+    "roofline-efficiency-threshold",
+    llvm::cl::desc("Fraction of the roofline bound below which "
+                   "-roofline-report flags an operator (default 0.1)"),
+    llvm::cl::Optional, llvm::cl::init(0.1), llvm::cl::cat(executorCat));
+
 llvm::cl::opt<bool>
     autoInstrument("auto-instrument",
                    llvm::cl::desc("Add instrumentation for operator tracing"),
                    llvm::cl::Optional, llvm::cl::init(false),
                    llvm::cl::cat(executorCat));
 
+llvm::cl::opt<bool> autoInstrumentCounters(
+    "auto-instrument-counters",
+    llvm::cl::desc("With -auto-instrument, also record the hardware "
+                   "performance counters of the operators (CPU backend) and "
+                   "print a summary per operator kind. Requires -trace-path"),
+    llvm::cl::Optional, llvm::cl::init(false), llvm::cl::cat(executorCat));
+
 llvm::cl::opt<unsigned> traceLevel(
     "trace-level",
     llvm::cl::desc(
@@ -173,6 +202,23 @@ llvm::cl::opt<unsigned> repeatSingleBatchCount(
         "and all other inputs are ignored."),
     llvm::cl::init(0), llvm::cl::cat(executorCat));
 
+llvm::cl::opt<unsigned> prefetchDepth(
+    "prefetch-depth",
+    llvm::cl::desc(
+        "Number of mini-batches each worker thread loads and preprocesses "
+        "ahead of the one being inferred, so that decoding the inputs "
+        "overlaps with the inference. By default it is 0 and the inputs of a "
+        "mini-batch are loaded right before running it. Not compatible with "
+        "preload-all-images, stream input mode, repeat-single-batch-count and "
+        "benchmark mode."),
+    llvm::cl::Optional, llvm::cl::init(0), llvm::cl::cat(executorCat));
+
+llvm::cl::opt<unsigned> prefetchThreads(
+    "prefetch-threads",
+    llvm::cl::desc("Number of threads loading the mini-batches of each worker "
+                   "thread when prefetch-depth is set; default:1"),
+    llvm::cl::Optional, llvm::cl::init(1), llvm::cl::cat(executorCat));
+
 /// Read all images from \p inputImageDir into \p imageFilenames.
 void parseInputDir(const std::string &inputImageDir,
                    std::vector<std::string> &imageFilenames) {
@@ -341,6 +387,7 @@ buildAndCompileAndGetInAndOutPair(Loader &loader, PlaceholderBindings &bindings,
   CompilationContext cctx = loader.getCompilationContext();
   cctx.bindings = &bindings;
   cctx.backendOpts.autoInstrument = autoInstrument;
+  cctx.backendOpts.autoInstrumentCounters = autoInstrumentCounters;
   loader.compile(cctx);
 
   // Get input/output placeholder maps.
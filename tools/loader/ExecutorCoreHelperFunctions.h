@@ -39,11 +39,17 @@ extern llvm::cl::opt<unsigned> excludedFirstWarmupRuns;
 
 extern llvm::cl::opt<unsigned> warmup;
 extern llvm::cl::opt<std::string> tracePath;
+extern llvm::cl::opt<std::string> nodeCostProfilePath;
+extern llvm::cl::opt<std::string> rooflineReportPath;
+extern llvm::cl::opt<double> rooflineEfficiencyThreshold;
+extern llvm::cl::opt<bool> autoInstrumentCounters;
 extern llvm::cl::opt<bool> convertInAndOutToFp16;
 extern llvm::cl::opt<unsigned> miniBatch;
 extern llvm::cl::opt<unsigned> miniBatchThreads;
 extern llvm::cl::opt<bool> preloadAllImages;
 extern llvm::cl::opt<unsigned> repeatSingleBatchCount;
+extern llvm::cl::opt<unsigned> prefetchDepth;
+extern llvm::cl::opt<unsigned> prefetchThreads;
 
 extern std::unique_ptr<glow::TraceContext> traceContext;
 
@@ -69,7 +69,9 @@ llvm::cl::opt<bool>
 llvm::cl::opt<std::string> dumpProfileFileOpt(
     "dump-profile",
     llvm::cl::desc("Perform quantization profiling for a given graph "
-                   "and dump result to the file."),
+                   "and dump result to the file. The profile is dumped in "
+                   "the compact binary format if the file has the extension "
+                   ".bin, and in YAML otherwise."),
     llvm::cl::value_desc("profile.yaml"), llvm::cl::Optional,
     llvm::cl::cat(loaderCat));
 
@@ -140,10 +142,19 @@ llvm::cl::opt<bool> enableChannelwiseOpt(
 
 llvm::cl::opt<std::string> loadProfileFileOpt(
     "load-profile",
-    llvm::cl::desc("Load quantization profile file and quantize the graph"),
+    llvm::cl::desc("Load quantization profile file and quantize the graph. "
+                   "The file may be in YAML or in the compact binary format."),
     llvm::cl::value_desc("profile.yaml"), llvm::cl::Optional,
     llvm::cl::cat(loaderCat));
 
+llvm::cl::opt<std::string> loadNodePrecisionsFileOpt(
+    "load-node-precisions",
+    llvm::cl::desc("Load the precisions of specific nodes, e.g. as dumped by "
+                   "the precision-tuner tool, which take precedence over the "
+                   "quantization and fp16 options for these nodes."),
+    llvm::cl::value_desc("precisions.yaml"), llvm::cl::Optional,
+    llvm::cl::cat(loaderCat));
+
 llvm::cl::list<std::string> keepOriginalPrecisionForNodesOpt(
     "keep-original-precision-for-nodes",
     llvm::cl::desc(
@@ -207,6 +218,39 @@ llvm::cl::opt<PrecisionConfiguration::Float16Format> fp16Format(
     llvm::cl::init(PrecisionConfiguration::Float16Format::FP16),
     llvm::cl::cat(loaderCat));
 
+llvm::cl::opt<bool> convertFCWeightsToInt4Opt(
+    "convert-fc-weights-to-int4",
+    llvm::cl::desc("Quantize the float constant weights of FullyConnected "
+                   "nodes to 4 bits in groups, keeping the activations float, "
+                   "for the backends which support it."),
+    llvm::cl::init(false), llvm::cl::cat(loaderCat));
+
+llvm::cl::opt<bool> convertFCToDynamicQuantizedOpt(
+    "convert-fc-to-dynamic-quantized",
+    llvm::cl::desc("Quantize the float constant weights of FullyConnected "
+                   "nodes to int8 and their inputs at run time, without a "
+                   "profile, for the backends which support it."),
+    llvm::cl::init(false), llvm::cl::cat(loaderCat));
+
+llvm::cl::opt<unsigned> int4FCGroupSizeOpt(
+    "int4-fc-group-size",
+    llvm::cl::desc("Number of weights of a row sharing a scale and offset "
+                   "when using -convert-fc-weights-to-int4. Must be even."),
+    llvm::cl::init(64), llvm::cl::cat(loaderCat));
+
+llvm::cl::opt<bool> convertSLWSTablesToPQOpt(
+    "convert-slws-tables-to-pq",
+    llvm::cl::desc("Product-quantize the float constant tables of "
+                   "SparseLengthsWeightedSum nodes into byte codes and "
+                   "codebooks, for the backends which support it."),
+    llvm::cl::init(false), llvm::cl::cat(loaderCat));
+
+llvm::cl::opt<unsigned> pqSLWSSubspaceDimOpt(
+    "pq-slws-subspace-dim",
+    llvm::cl::desc("Number of columns of the tables encoded by each byte code "
+                   "when using -convert-slws-tables-to-pq."),
+    llvm::cl::init(4), llvm::cl::cat(loaderCat));
+
 llvm::cl::opt<bool> convertPlaceholdersOpt(
     "convert-placeholders",
     llvm::cl::desc("Convert model placeholders by merging ConvertTo, Quantize "
@@ -624,11 +668,18 @@ quantization::QuantizationConfiguration Loader::getQuantizationConfiguration() {
   quantConfig.enableChannelwise = enableChannelwiseOpt;
   quantConfig.assertAllNodesQuantized = assertAllNodesQuantizedOpt;
   if (!loadProfileFileOpt.empty()) {
-    auto fileExists = deserializeProfilingInfosFromYaml(
+    auto fileExists = deserializeProfilingInfos(
         loadProfileFileOpt, quantConfig.graphPreLowerHash, quantConfig.infos);
     CHECK(fileExists) << strFormat("Profile file \"%s\" does not exist!",
                                    loadProfileFileOpt.c_str());
   }
+  if (!loadNodePrecisionsFileOpt.empty()) {
+    auto fileExists = deserializeNodePrecisions(loadNodePrecisionsFileOpt,
+                                                quantConfig.nodePrecisions);
+    CHECK(fileExists) << strFormat("Node precisions file \"%s\" does not "
+                                   "exist!",
+                                   loadNodePrecisionsFileOpt.c_str());
+  }
   quantConfig.checkGraphPreLowerHash = true;
   return quantConfig;
 }
@@ -641,6 +692,11 @@ CompilationContext Loader::getCompilationContext(QuantizationMode mode) {
   PrecisionConfiguration &precConfig = cctx.precisionConfig;
   precConfig.convertToFP16 = convertToFP16;
   precConfig.float16Format = fp16Format;
+  precConfig.convertFCWeightsToInt4 = convertFCWeightsToInt4Opt;
+  precConfig.convertFCToDynamicQuantized = convertFCToDynamicQuantizedOpt;
+  precConfig.int4FCGroupSize = int4FCGroupSizeOpt;
+  precConfig.convertSLWSTablesToPQ = convertSLWSTablesToPQOpt;
+  precConfig.pqSLWSSubspaceDim = pqSLWSSubspaceDimOpt;
 
   // Specific configurations.
   precConfig.quantMode = mode;
@@ -833,8 +889,8 @@ void Loader::generateAndSerializeProfilingInfos(PlaceholderBindings &bindings) {
     PI.insert(PI.end(), tmp.begin(), tmp.end());
   }
   std::sort(PI.begin(), PI.end(), comparePI);
-  serializeProfilingInfosToYaml(dumpProfileFileOpt,
-                                compilationInfo_.graphPreLowerHash, PI);
+  serializeProfilingInfos(dumpProfileFileOpt,
+                          compilationInfo_.graphPreLowerHash, PI);
 }
 
 Loader &Loader::registerExtension(std::unique_ptr<LoaderExtension> extension) {
@@ -41,6 +41,9 @@ extern llvm::cl::opt<bool> timeOpt;
 /// -iterations.
 extern llvm::cl::opt<unsigned> iterationsOpt;
 
+/// Backend the model runs on -backend.
+extern llvm::cl::opt<std::string> ExecutionBackend;
+
 namespace glow {
 
 class Tensor;
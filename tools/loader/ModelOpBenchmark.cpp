@@ -0,0 +1,316 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Loader.h"
+#include "LoaderUtils.h"
+
+#include "glow/Backend/Backend.h"
+#include "glow/Graph/Nodes.h"
+#include "glow/Optimizer/GraphOptimizer/GraphOptimizer.h"
+#include "glow/Partitioner/PartitionerUtils.h"
+#include "glow/Runtime/HostManager/HostManager.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace glow;
+
+llvm::cl::OptionCategory modelOpBenchCat("Model Op Benchmark Options");
+
+namespace {
+llvm::cl::list<std::string> benchBackendsOpt(
+    "op-bench-backends", llvm::cl::CommaSeparated, llvm::cl::ZeroOrMore,
+    llvm::cl::desc(
+        "Comma separated list of the backends on which every operator of the \n"
+        "model is benchmarked, e.g. -op-bench-backends=CPU,Interpreter. The  \n"
+        "'backend' option is used when the list is empty."),
+    llvm::cl::value_desc("backend,..."), llvm::cl::cat(modelOpBenchCat));
+
+llvm::cl::opt<unsigned> benchWarmupOpt(
+    "op-bench-warmup",
+    llvm::cl::desc("Number of untimed runs of every operator."),
+    llvm::cl::init(2), llvm::cl::value_desc("N"),
+    llvm::cl::cat(modelOpBenchCat));
+
+llvm::cl::opt<unsigned> benchRepsOpt(
+    "op-bench-reps", llvm::cl::desc("Number of timed runs of every operator."),
+    llvm::cl::init(20), llvm::cl::value_desc("N"),
+    llvm::cl::cat(modelOpBenchCat));
+
+llvm::cl::opt<bool> benchLoweredOpt(
+    "op-bench-lowered",
+    llvm::cl::desc(
+        "Optimize and lower the model for the 'backend' backend before the   \n"
+        "operators are extracted, such that the operators benchmarked are the\n"
+        "ones the backend executes instead of the ones of the model file."),
+    llvm::cl::init(false), llvm::cl::cat(modelOpBenchCat));
+
+llvm::cl::opt<std::string> benchCSVOpt(
+    "op-bench-csv",
+    llvm::cl::desc("File to which the results are also written as CSV."),
+    llvm::cl::value_desc("file.csv"), llvm::cl::cat(modelOpBenchCat));
+
+llvm::cl::opt<bool> benchDumpOpsOpt(
+    "op-bench-dump-ops",
+    llvm::cl::desc("Print the full description (attributes, layout) of every "
+                   "operator benchmarked."),
+    llvm::cl::init(false), llvm::cl::cat(modelOpBenchCat));
+
+/// One distinct operator of the model: a Module holding a Function "op" with
+/// the node alone, its inputs replaced by placeholders "in<N>", or by copies
+/// of the constants they were in the model.
+struct ModelOp {
+  /// The node in the model, used for the description and the cost model.
+  const Node *node;
+  /// Number of nodes of the model with the same kind, types and attributes.
+  unsigned count{1};
+  /// The single node Module.
+  std::unique_ptr<Module> mod;
+  /// Median time of a run on each of the benchmarked backends, in us.
+  std::vector<double> medianUs;
+};
+
+using Clock = std::chrono::steady_clock;
+
+/// \returns the key under which \p N is deduplicated: its description with
+/// the name and the users dropped, and whether each input is a constant.
+std::string getOpKey(const Node &N) {
+  Node *copy = N.clone();
+  copy->setName("op");
+  std::string key = copy->getDebugDesc();
+  Node::destroyNode(copy);
+  for (unsigned i = 0, e = N.getNumInputs(); i < e; i++) {
+    key += llvm::isa<Constant>(N.getNthInput(i).getNode()) ? 'C' : 'P';
+  }
+  return key;
+}
+
+/// \returns a Module with a Function "op" running a copy of \p N alone.
+std::unique_ptr<Module> createOpModule(const Node &N) {
+  auto mod = glow::make_unique<Module>();
+  Function *F = mod->createFunction("op");
+  Node *copy = N.clone();
+  copy->setName("op");
+  for (unsigned i = 0, e = N.getNumInputs(); i < e; i++) {
+    NodeValue in = N.getNthInput(i);
+    std::string name = "in" + std::to_string(i);
+    if (auto *C = llvm::dyn_cast<Constant>(in.getNode())) {
+      Constant *newC = mod->createConstant(name, C->getPayload().clone());
+      copy->setNthInput(i, newC->getOutput());
+    } else {
+      Placeholder *PH = mod->createPlaceholder(in.getType(), name, false);
+      copy->setNthInput(i, PH->getOutput());
+    }
+  }
+  F->addNode(copy);
+  for (unsigned i = 0, e = copy->getNumResults(); i < e; i++) {
+    F->createSave("out" + std::to_string(i), copy->getNthResult(i));
+  }
+  return mod;
+}
+
+/// \returns a Module with a Function "op" saving a one element placeholder,
+/// whose run time is the overhead of running a network on a backend.
+std::unique_ptr<Module> createNoopModule() {
+  auto mod = glow::make_unique<Module>();
+  Function *F = mod->createFunction("op");
+  F->createSave("out", mod->createPlaceholder(ElemKind::FloatTy, {1}, "in0",
+                                              false));
+  return mod;
+}
+
+/// Fills the input \p T of an operator. Float and quantized tensors get
+/// random values; integer tensors, which are often indices or lengths, are
+/// zero such that they are always in range.
+void fillInput(Tensor &T, PseudoRNG &PRNG) {
+  switch (T.getElementType()) {
+  case ElemKind::FloatTy:
+  case ElemKind::Float16Ty:
+  case ElemKind::BFloat16Ty:
+    T.init(Tensor::InitKind::Xavier, 1, PRNG);
+    break;
+  case ElemKind::Int8QTy:
+    T.getHandle<int8_t>().randomize(-128, 127, PRNG);
+    break;
+  case ElemKind::UInt8QTy:
+    T.getHandle<uint8_t>().randomize(0, 255, PRNG);
+    break;
+  default:
+    T.zero();
+    break;
+  }
+}
+
+/// Compiles a copy of \p mod on \p hostManager and \returns the median time
+/// of a run in us, or a negative value if the backend rejects the network.
+double benchModule(runtime::HostManager &hostManager, const Module &mod,
+                   Loader &loader, PseudoRNG &PRNG) {
+  auto copy = glow::make_unique<Module>();
+  mod.clone(copy.get());
+  const Module *copyPtr = copy.get();
+  auto ctx = glow::make_unique<ExecutionContext>();
+  PlaceholderBindings &bindings = *ctx->getPlaceholderBindings();
+  bindings.allocate(copyPtr->getPlaceholders());
+  for (auto &PT : bindings.pairs()) {
+    fillInput(PT.second, PRNG);
+  }
+  CompilationContext cctx = loader.getCompilationContext();
+  if (ERR_TO_BOOL(hostManager.addNetwork(std::move(copy), cctx))) {
+    return -1;
+  }
+  std::vector<double> times;
+  for (unsigned i = 0, e = benchWarmupOpt + benchRepsOpt; i < e; i++) {
+    auto start = Clock::now();
+    EXIT_ON_ERR(hostManager.runNetworkBlocking("op", ctx));
+    auto end = Clock::now();
+    if (i >= benchWarmupOpt) {
+      times.push_back(
+          std::chrono::duration<double, std::micro>(end - start).count());
+    }
+  }
+  EXIT_ON_ERR(hostManager.removeNetwork("op"));
+  std::nth_element(times.begin(), times.begin() + times.size() / 2,
+                   times.end());
+  return times[times.size() / 2];
+}
+
+/// \returns the types of the inputs of \p N when \p inputs, else of its
+/// results, separated by spaces.
+std::string getTypesDesc(const Node &N, bool inputs) {
+  std::string desc;
+  unsigned num = inputs ? N.getNumInputs() : N.getNumResults();
+  for (unsigned i = 0; i < num; i++) {
+    TypeRef T = inputs ? N.getNthInput(i).getType() : N.getType(i);
+    desc += (i ? " " : "") + T->toString();
+  }
+  return desc;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+
+  // Parse command line parameters. All the options will be available as part of
+  // the loader object.
+  parseCommandLine(argc, argv);
+  checkCond(benchRepsOpt > 0, "The 'op-bench-reps' option must be positive!");
+
+  std::vector<std::string> backends(benchBackendsOpt.begin(),
+                                    benchBackendsOpt.end());
+  if (backends.empty()) {
+    backends.push_back(ExecutionBackend);
+  }
+
+  // Initialize the loader object and load the model.
+  Loader loader;
+  loader.loadModel();
+  Function *F = loader.getFunction();
+  if (benchLoweredOpt) {
+    std::unique_ptr<Backend> backend(createBackend(ExecutionBackend));
+    CompilationContext cctx = loader.getCompilationContext();
+    EXIT_ON_ERR(::glow::optimizeFunction(F, *backend, cctx));
+  }
+
+  // Extract the distinct operators of the model, in the model order.
+  std::vector<ModelOp> ops;
+  llvm::StringMap<size_t> opIndex;
+  for (const auto &N : F->getNodes()) {
+    if (llvm::isa<SaveNode>(&N)) {
+      continue;
+    }
+    auto it = opIndex.try_emplace(getOpKey(N), ops.size());
+    if (!it.second) {
+      ops[it.first->second].count++;
+      continue;
+    }
+    ModelOp op;
+    op.node = &N;
+    op.mod = createOpModule(N);
+    ops.push_back(std::move(op));
+  }
+  llvm::outs() << "Benchmarking " << ops.size() << " distinct operators of "
+               << F->getNodes().size() << " nodes on "
+               << llvm::join(backends, ",") << ".\n";
+
+  // Run every operator alone on every backend, the overhead of running a
+  // network being measured first with a network saving one element.
+  PseudoRNG PRNG;
+  std::vector<double> overheadUs;
+  auto noop = createNoopModule();
+  for (const auto &name : backends) {
+    std::vector<std::unique_ptr<runtime::DeviceConfig>> configs;
+    configs.push_back(glow::make_unique<runtime::DeviceConfig>(name));
+    runtime::HostManager hostManager(std::move(configs));
+    double noopUs = benchModule(hostManager, *noop, loader, PRNG);
+    checkCond(noopUs >= 0, strFormat("Backend '%s' could not run an empty "
+                                     "network!",
+                                     name.c_str()));
+    overheadUs.push_back(noopUs);
+    for (auto &op : ops) {
+      op.medianUs.push_back(benchModule(hostManager, *op.mod, loader, PRNG));
+    }
+  }
+
+  // Report one row per operator and backend. The net time is the median run
+  // time minus the overhead of running a network on the backend, and the
+  // rates are computed with the cost model of the Partitioner.
+  std::string csv = "id,kind,count,inputs,outputs,backend,median_us,net_us,"
+                    "total_us,gflops,gbytes_s\n";
+  for (size_t i = 0, e = ops.size(); i < e; i++) {
+    const ModelOp &op = ops[i];
+    uint64_t flops = getNodeFlops(op.node);
+    uint64_t bytes = getNodeBytesMoved(op.node);
+    if (benchDumpOpsOpt) {
+      llvm::outs() << "op" << i << ": " << op.node->getDebugDesc() << "\n";
+    }
+    for (size_t b = 0, be = backends.size(); b < be; b++) {
+      std::string row =
+          strFormat("op%zu,%s,%u,\"%s\",\"%s\",%s,", i,
+                    op.node->getKindName(), op.count,
+                    getTypesDesc(*op.node, /* inputs */ true).c_str(),
+                    getTypesDesc(*op.node, /* inputs */ false).c_str(),
+                    backends[b].c_str());
+      double medianUs = op.medianUs[b];
+      if (medianUs < 0) {
+        csv += row + "unsupported,,,,\n";
+        continue;
+      }
+      double netUs = std::max(medianUs - overheadUs[b], 0.0);
+      double secs = std::max(netUs, 1e-3) * 1e-6;
+      csv += row + strFormat("%.2f,%.2f,%.2f,%.3f,%.3f\n", medianUs, netUs,
+                             netUs * op.count, flops / secs * 1e-9,
+                             bytes / secs * 1e-9);
+    }
+  }
+  for (size_t b = 0, be = backends.size(); b < be; b++) {
+    llvm::outs() << "Overhead of a network run on " << backends[b] << ": "
+                 << strFormat("%.2f", overheadUs[b]) << " us\n";
+  }
+  llvm::outs() << csv;
+
+  if (!benchCSVOpt.empty()) {
+    std::error_code EC;
+    llvm::raw_fd_ostream os(benchCSVOpt, EC);
+    checkCond(!EC, strFormat("Could not open the file '%s'!",
+                             benchCSVOpt.c_str()));
+    os << csv;
+  }
+  return 0;
+}
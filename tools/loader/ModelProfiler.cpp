@@ -17,8 +17,12 @@
 #include "Loader.h"
 #include "LoaderUtils.h"
 #include "glow/Base/TensorSerialization.h"
+#include "glow/Graph/Nodes.h"
+#include "glow/Quantization/Base/Profile.h"
 #include "llvm/Support/CommandLine.h"
 
+#include <thread>
+
 using namespace glow;
 
 llvm::cl::OptionCategory modelProfilerCat("Model Profiler Options");
@@ -104,8 +108,52 @@ llvm::cl::list<std::string> inputDatasetOpts(
         "    files are assumed to be in raw text format.\n"),
     llvm::cl::value_desc("name,format,source,opts"),
     llvm::cl::cat(modelProfilerCat));
+
+llvm::cl::opt<unsigned> profilingThreadsOpt(
+    "profiling-threads",
+    llvm::cl::desc(
+        "Number of threads between which the dataset is split. Every thread  \n"
+        "profiles its share of the dataset in its own bindings, the profiles \n"
+        "of the threads being merged at the end. Use together with the       \n"
+        "'num-devices' option to run the threads on several devices."),
+    llvm::cl::init(1), llvm::cl::value_desc("N"),
+    llvm::cl::cat(modelProfilerCat));
 } // namespace
 
+/// Merge into \p bindings the profiles collected in \p shardBindings by the
+/// QuantizationProfile nodes of \p M.
+static void mergeProfiles(Module &M, PlaceholderBindings &bindings,
+                          std::vector<PlaceholderBindings> &shardBindings) {
+  for (auto *F : M.getFunctions()) {
+    for (auto &node : F->getNodes()) {
+      auto *QPN = llvm::dyn_cast<QuantizationProfileNode>(&node);
+      if (!QPN) {
+        continue;
+      }
+      auto getParams = [&](PlaceholderBindings &B) {
+        auto compInfoH =
+            B.get(QPN->getComputationInfoPlaceholder())->getHandle<float>();
+        return TensorProfilingParams(
+            compInfoH.raw(0), compInfoH.raw(1),
+            *B.get(QPN->getHistogramPlaceholder()));
+      };
+      auto params = getParams(bindings);
+      for (auto &B : shardBindings) {
+        quantization::combineTensorProfilingParams(params, getParams(B));
+      }
+      auto compInfoH = bindings.get(QPN->getComputationInfoPlaceholder())
+                           ->getHandle<float>();
+      compInfoH.raw(0) = params.min;
+      compInfoH.raw(1) = params.max;
+      auto histogramH =
+          bindings.get(QPN->getHistogramPlaceholder())->getHandle<float>();
+      for (dim_t idx = 0, e = histogramH.size(); idx < e; idx++) {
+        histogramH.raw(idx) = params.histogram[idx];
+      }
+    }
+  }
+}
+
 /// Parse the 'input-dataset' option and get the arguments.
 static void
 getInputDatasets(std::vector<std::string> &inputNames,
@@ -243,13 +291,10 @@ int main(int argc, char **argv) {
   // Compile the function.
   loader.compile(cctx);
 
-  // Run profiling for all the dataset entries. The profiling information is
-  // automatically aggregated for all the inference runs.
-  for (size_t entryIdx = 0; entryIdx < entryNum; entryIdx++) {
-
-    // Load tensor data.
+  // Load into \p B the tensor data of the dataset entry \p entryIdx.
+  auto loadEntry = [&](PlaceholderBindings &B, size_t entryIdx) {
     for (size_t inputIdx = 0; inputIdx < modelNumInputs; inputIdx++) {
-      Tensor *inputTensor = bindings.get(inputPlaceholders[inputIdx]);
+      Tensor *inputTensor = B.get(inputPlaceholders[inputIdx]);
       std::string filePath = inputDatasets[inputIdx][entryIdx];
       std::string fileFormat = inputFormats[inputIdx];
       if (fileFormat == "rawbin") {
@@ -265,10 +310,37 @@ int main(int argc, char **argv) {
                               fileFormat.c_str()));
       }
     }
+  };
 
-    // Run inference.
-    loader.runInference(bindings, 1 /*batchSize*/);
+  // Run profiling for all the dataset entries. The profiling information is
+  // automatically aggregated for all the inference runs of a thread. Every
+  // thread but the first profiles a contiguous range of the entries in a copy
+  // of the bindings, its profile being merged into the bindings afterwards.
+  size_t numThreads =
+      std::max<size_t>(1, std::min<size_t>(profilingThreadsOpt, entryNum));
+  std::vector<PlaceholderBindings> shardBindings;
+  for (size_t idx = 1; idx < numThreads; idx++) {
+    shardBindings.emplace_back(bindings.clone());
+  }
+  auto runShard = [&](size_t shardIdx) {
+    PlaceholderBindings &B =
+        shardIdx == 0 ? bindings : shardBindings[shardIdx - 1];
+    size_t begin = entryNum * shardIdx / numThreads;
+    size_t end = entryNum * (shardIdx + 1) / numThreads;
+    for (size_t entryIdx = begin; entryIdx < end; entryIdx++) {
+      loadEntry(B, entryIdx);
+      loader.runInference(B, 1 /*batchSize*/);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t idx = 1; idx < numThreads; idx++) {
+    threads.emplace_back(runShard, idx);
+  }
+  runShard(0);
+  for (auto &thread : threads) {
+    thread.join();
   }
+  mergeProfiles(*loader.getModule(), bindings, shardBindings);
 
   // Dump the final profile.
   loader.generateAndSerializeProfilingInfos(bindings);
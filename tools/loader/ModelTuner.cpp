@@ -333,8 +333,8 @@ int main(int argc, char **argv) {
                             totMin);
 
   // Serialize the tuned output profile.
-  serializeProfilingInfosToYaml(dumpTunedProfileFileOpt,
-                                quantConfig.graphPreLowerHash, pInfosTune);
+  serializeProfilingInfos(dumpTunedProfileFileOpt,
+                          quantConfig.graphPreLowerHash, pInfosTune);
 
   return 0;
 }
@@ -0,0 +1,320 @@
+/**
+ * Copyright (c) Glow Contributors. See CONTRIBUTORS file.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Loader.h"
+#include "LoaderUtils.h"
+
+#include "glow/Base/Image.h"
+#include "glow/ExecutionContext/ExecutionContext.h"
+#include "glow/ExecutionContext/TraceEvents.h"
+#include "glow/Quantization/Serialization.h"
+#include "glow/Support/Support.h"
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+
+using namespace glow;
+using quantization::NodePrecision;
+
+namespace {
+
+/// Precision Tuner options
+llvm::cl::OptionCategory precisionTunerCat("Precision Tuner Options");
+
+llvm::cl::opt<std::string> datasetFileOpt(
+    "dataset-file", llvm::cl::Required,
+    llvm::cl::desc("Path to the dataset description file which contains on "
+                   "each line a file path and an integer label separated by "
+                   "space or comma. The integer labels start with 0 (0,1,..)."
+                   "An example might look like this:\n"
+                   "  image0.png 0   \n"
+                   "  image1.png 13  \n"
+                   "  .............  \n"),
+    llvm::cl::value_desc("file.txt|file.csv"),
+    llvm::cl::cat(precisionTunerCat));
+
+llvm::cl::opt<std::string> datasetPathOpt(
+    "dataset-path", llvm::cl::Required,
+    llvm::cl::desc("The path of the directory where the dataset entries are "
+                   "located."),
+    llvm::cl::value_desc("directory path"), llvm::cl::cat(precisionTunerCat));
+
+llvm::cl::opt<std::string> dumpNodePrecisionsFileOpt(
+    "dump-node-precisions",
+    llvm::cl::desc("Output node precisions obtained after tuning, to be used "
+                   "with the -load-node-precisions option."),
+    llvm::cl::value_desc("precisions_output.yaml"), llvm::cl::Required,
+    llvm::cl::cat(precisionTunerCat));
+
+llvm::cl::opt<float> accuracyBudgetOpt(
+    "accuracy-budget",
+    llvm::cl::desc("Maximum accuracy drop allowed with respect to the float \n"
+                   "model. A float value between 0.0 and 1.0 is expected. \n"
+                   "The default value is 0.01 (1%)."),
+    llvm::cl::value_desc("float"), llvm::cl::Optional, llvm::cl::init(0.01),
+    llvm::cl::cat(precisionTunerCat));
+
+llvm::cl::opt<unsigned> maxSearchStepsOpt(
+    "max-search-steps",
+    llvm::cl::desc("Maximum number of nodes whose precision is raised "
+                   "(default 100)."),
+    llvm::cl::value_desc("int"), llvm::cl::Optional, llvm::cl::init(100),
+    llvm::cl::cat(precisionTunerCat));
+} // namespace
+
+/// Accuracy and latency of a model on a dataset.
+struct RunResult {
+  /// Fraction of the dataset correctly classified.
+  float accuracy;
+  /// Average latency of an inference in microseconds.
+  float latency;
+};
+
+/// Get maximum confidence class index for the model output.
+static unsigned getOutputClass(Tensor *T) {
+  CHECK(T->getElementType() == ElemKind::FloatTy)
+      << "Model output is expected to be float!";
+  auto TH = T->getHandle<float>();
+  float maxVal = TH.raw(0);
+  unsigned maxIdx = 0;
+  for (unsigned idx = 1; idx < TH.size(); ++idx) {
+    if (TH.raw(idx) > maxVal) {
+      maxVal = TH.raw(idx);
+      maxIdx = idx;
+    }
+  }
+  return maxIdx;
+}
+
+/// \returns the sum of the durations of the backend operator events in
+/// \p events, 0 if the backend does not instrument its operators.
+static uint64_t getOperatorTime(const std::list<TraceEvent> &events) {
+  uint64_t time = 0;
+  for (const auto &event : events) {
+    if (event.level == TraceLevel::OPERATOR &&
+        event.type == TraceEvent::CompleteType) {
+      time += event.duration;
+    }
+  }
+  return time;
+}
+
+/// Run the model on \p dataset and compute its accuracy and latency. If
+/// \p precisions is given then the model is quantized using the profile of
+/// the -load-profile option and the precisions of \p precisions, otherwise
+/// it runs as-is. The latency is the time spent in the backend operators, as
+/// recorded by their instrumentation, or the wall time of the inferences if
+/// the backend records no operator events.
+static RunResult
+runModel(LabeledDataSet &dataset,
+         const llvm::StringMap<NodePrecision> *precisions) {
+  // Initialize the loader object.
+  Loader loader;
+
+  // Load the model.
+  loader.loadModel();
+
+  // Allocate tensors for all placeholders.
+  ExecutionContext context;
+  PlaceholderBindings &bindings = *context.getPlaceholderBindings();
+  bindings.allocate(loader.getModule()->getPlaceholders());
+
+  // Get input/output placeholders.
+  auto inpPHMap = loader.getInputPlaceholderMap();
+  auto outPHMap = loader.getOutputPlaceholderMap();
+  CHECK(inpPHMap.size() == 1) << "Model is expected to have only 1 input!";
+  CHECK(outPHMap.size() == 1) << "Model is expected to have only 1 output!";
+  Placeholder *input = inpPHMap.begin()->second;
+  Placeholder *output = outPHMap.begin()->second;
+
+  // Get compilation options.
+  CompilationContext cctx;
+  if (precisions) {
+    cctx = loader.getCompilationContext(QuantizationMode::Quantize);
+    cctx.precisionConfig.quantConfig.nodePrecisions = *precisions;
+  } else {
+    cctx = loader.getCompilationContext(QuantizationMode::None);
+  }
+  cctx.bindings = &bindings;
+  cctx.backendOpts.autoInstrument = true;
+
+  // Compile the function.
+  loader.compile(cctx);
+
+  // Run the function for all the dataset.
+  size_t correct = 0;
+  uint64_t operatorTime = 0;
+  uint64_t wallTime = 0;
+  for (const auto &data : dataset) {
+    // Read the image and preprocess.
+    Tensor inputImg = readPngPpmImageAndPreprocess(data.first, imageNormMode[0],
+                                                   imageChannelOrderOpt[0],
+                                                   imageLayoutOpt[0]);
+    auto imgShape = inputImg.getType().dims();
+    Tensor inputTensor =
+        inputImg.getUnowned({1, imgShape[0], imgShape[1], imgShape[2]});
+    updateInputPlaceholders(bindings, {input}, {&inputTensor});
+    // Run inference, collecting the events of the backend operators.
+    context.setTraceContext(
+        glow::make_unique<TraceContext>(TraceLevel::OPERATOR));
+    uint64_t startTime = TraceEvent::now();
+    loader.runInference(&context);
+    wallTime += TraceEvent::now() - startTime;
+    operatorTime +=
+        getOperatorTime(context.getTraceContext()->getTraceEvents());
+    // Get output class.
+    if (getOutputClass(bindings.get(output)) == data.second) {
+      ++correct;
+    }
+  }
+
+  RunResult result;
+  result.accuracy = ((float)correct) / dataset.size();
+  result.latency = ((float)(operatorTime ? operatorTime : wallTime)) /
+                   dataset.size();
+  return result;
+}
+
+/// \returns the name of the node of the profiled output \p outputName.
+static llvm::StringRef getNodeName(llvm::StringRef outputName) {
+  return outputName.split(':').first;
+}
+
+/// \returns the name of the precision \p P.
+static const char *getPrecisionName(NodePrecision P) {
+  switch (P) {
+  case NodePrecision::Quantized:
+    return "Quantized";
+  case NodePrecision::ChannelwiseQuantized:
+    return "ChannelwiseQuantized";
+  case NodePrecision::FP16:
+    return "FP16";
+  case NodePrecision::FP32:
+    return "FP32";
+  }
+  llvm_unreachable("Unknown node precision!");
+}
+
+int main(int argc, char **argv) {
+
+  // Parse command line parameters. All the options will be available as part of
+  // the loader object.
+  parseCommandLine(argc, argv);
+
+  // The tuned nodes are the nodes of the input profile.
+  auto quantConfig = Loader::getQuantizationConfiguration();
+  CHECK(quantConfig.infos.size())
+      << "Input profile not found. Use the -load-profile option!";
+  std::set<std::string> nodeNames;
+  for (const auto &PI : quantConfig.infos) {
+    nodeNames.insert(getNodeName(PI.nodeOutputName_).str());
+  }
+
+  // Read tuning dataset.
+  LabeledDataSet dataset = readLabeledDataSet(datasetFileOpt, datasetPathOpt);
+
+  // Set output stream to unbuffered state to flush every time.
+  llvm::outs().SetUnbuffered();
+
+  // Start from all the nodes quantized.
+  llvm::StringMap<NodePrecision> precisions;
+  for (const auto &name : nodeNames) {
+    precisions[name] = NodePrecision::Quantized;
+  }
+
+  llvm::outs() << strFormat("\nComputing initial accuracy ... \n");
+  RunResult floatResult = runModel(dataset, nullptr);
+  RunResult result = runModel(dataset, &precisions);
+  float targetAcc = floatResult.accuracy - accuracyBudgetOpt;
+  llvm::outs() << strFormat("Initial accuracy: %.4f %% (FLOAT), "
+                            "latency: %.1f us\n",
+                            floatResult.accuracy * 100, floatResult.latency);
+  llvm::outs() << strFormat("Initial accuracy: %.4f %% (QUANTIZED), "
+                            "latency: %.1f us\n",
+                            result.accuracy * 100, result.latency);
+  llvm::outs() << strFormat("Target  accuracy: %.4f %%\n", targetAcc * 100);
+  llvm::outs() << strFormat("Number of nodes: %d\n\n", (int)nodeNames.size());
+
+  // Raise the precision of one node at a time, picking among all the nodes and
+  // higher precisions the change of best accuracy gain per latency increase,
+  // until the accuracy is within the budget or no change improves it.
+  auto startTime = getTimeStamp();
+  for (unsigned step = 0;
+       step < maxSearchStepsOpt && result.accuracy < targetAcc; ++step) {
+    std::string bestNode;
+    NodePrecision bestPrecision = NodePrecision::Quantized;
+    RunResult bestResult = result;
+    float bestScore = 0;
+    for (const auto &name : nodeNames) {
+      NodePrecision current = precisions[name];
+      for (NodePrecision P :
+           {NodePrecision::ChannelwiseQuantized, NodePrecision::FP16,
+            NodePrecision::FP32}) {
+        if (P <= current) {
+          continue;
+        }
+        precisions[name] = P;
+        RunResult candidate = runModel(dataset, &precisions);
+        precisions[name] = current;
+        float accGain = candidate.accuracy - result.accuracy;
+        if (accGain <= 0) {
+          continue;
+        }
+        // Count latency decreases and increases below a microsecond as a
+        // microsecond, preferring the change of best accuracy among those.
+        float score =
+            accGain / std::max(candidate.latency - result.latency, 1.0f);
+        if (score > bestScore) {
+          bestScore = score;
+          bestNode = name;
+          bestPrecision = P;
+          bestResult = candidate;
+        }
+      }
+    }
+    if (bestNode.empty()) {
+      llvm::outs() << "No precision change improves the accuracy! Tuning is "
+                      "stopped ...\n";
+      break;
+    }
+    precisions[bestNode] = bestPrecision;
+    result = bestResult;
+    llvm::outs() << strFormat(
+        "[%d] Node \"%s\" set to %s: accuracy %.4f %%, latency %.1f us\n",
+        step + 1, bestNode.c_str(), getPrecisionName(bestPrecision),
+        result.accuracy * 100, result.latency);
+  }
+
+  // Print final accuracy.
+  llvm::outs() << strFormat("\nFinal accuracy: %.4f %%, latency: %.1f us\n\n",
+                            result.accuracy * 100, result.latency);
+
+  // Print total time.
+  unsigned totSec, totMin, totHrs;
+  getDuration(startTime, totSec, totMin, totHrs);
+  llvm::outs() << strFormat("Total time: %d hours %d minutes\n\n", totHrs,
+                            totMin);
+
+  // Serialize the tuned node precisions.
+  serializeNodePrecisions(dumpNodePrecisionsFileOpt, precisions);
+
+  return 0;
+}
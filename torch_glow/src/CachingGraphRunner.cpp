@@ -26,8 +26,15 @@
 #include "glow/Runtime/RuntimeTypes.h"
 #include "glow/Runtime/TraceExporter.h"
 #include "glow/Support/Support.h"
+#include "glow/Support/ZipUtils.h"
 
+#include "llvm/Support/FileSystem.h"
+
+#include <chrono>
+#include <fstream>
 #include <mutex>
+#include <sstream>
+#include <thread>
 
 namespace glow {
 
@@ -453,6 +460,10 @@ Error saveGlowDeserializationSpec(
   return Error::success();
 }
 
+/// The maximum number of traces waiting to be merged by the trace thread of a
+/// CachingGraphRunner, see aggregateAndDumpTraces.
+constexpr size_t kMaxPendingTraces = 64;
+
 glow::Expected<std::string> getOnnxFilePath(const std::string &filePrefix,
                                             bool writeOnnxToTmp,
                                             const char *extension = ".onnx") {
@@ -465,37 +476,102 @@ glow::Expected<std::string> getOnnxFilePath(const std::string &filePrefix,
   }
 }
 
-} // namespace
-
-void CachingGraphRunner::aggregateAndDumpTraces(TraceContext *traceContext,
-                                                bool flush) {
-  size_t numTracesPerDump = defaultSettings_.numTracesPerDump;
-  bool doDump = false;
-  std::string filename;
-  {
-    std::unique_lock<std::mutex> lock(tracesMutex_);
-
-    if (traceContext) {
-      mergedTraceContext_->merge(traceContext);
-      numTraces_++;
-    } else if (mergedTraceContext_->getTraceEvents().empty()) {
-      return;
+/// \returns \p metaStack with the first dimension of every input rounded up to
+/// the smallest of \p buckets that holds it, see
+/// PyTorchLoaderSettings::shapeBuckets.
+InputMetaStack bucketInputMetaStack(InputMetaStack metaStack,
+                                    const std::vector<int64_t> &buckets) {
+  for (auto &meta : metaStack.inputMetas) {
+    if (meta.dims.empty()) {
+      continue;
+    }
+    int64_t bucketed = -1;
+    for (int64_t bucket : buckets) {
+      if (bucket >= meta.dims[0] && (bucketed < 0 || bucket < bucketed)) {
+        bucketed = bucket;
+      }
     }
-    size_t numTraces = numTraces_;
-
-    // If numTracesPerDump <= 0, it means we don't merge unless there is a flush
-    if (flush || (numTracesPerDump > 0 && numTraces % numTracesPerDump == 0)) {
-      // Initial way of differentiating the dump files when there are multiple
-      // graph runners
-      // TODO(allwu): find a better way to generate trace file names
-      size_t hash = reinterpret_cast<size_t>(this);
-      size_t dumpNum = numTraceDumps_++;
-      filename =
-          strFormat("glow-trace-%04lx-%zu.json", hash % (1 << 16), dumpNum);
-      doDump = true;
+    if (bucketed >= 0) {
+      meta.dims[0] = bucketed;
     }
   }
-  if (doDump) {
+  return metaStack;
+}
+
+/// Sets the TraceContext of \p ctx for a run: at the STANDARD level when
+/// \p enableGlowTracing or a TraceExporter asks for it, else at the level the
+/// continuous tracing sampler picks, if enabled. \returns the level picked by
+/// the sampler, NONE if not sampled.
+TraceLevel startRunTrace(ExecutionContext &ctx, bool enableGlowTracing) {
+  auto registry = TraceExporterRegistry::getInstance();
+  TraceLevel sampledLevel = TraceLevel::NONE;
+  if (enableGlowTracing || registry->shouldTrace()) {
+    ctx.setTraceContext(glow::make_unique<TraceContext>(TraceLevel::STANDARD));
+  } else if (auto sampler = registry->getSampler()) {
+    sampledLevel = sampler->getRequestTraceLevel();
+    ctx.setTraceContext(glow::make_unique<TraceContext>(sampledLevel));
+  }
+  if (auto *traceContext = ctx.getTraceContext()) {
+    traceContext->setThreadName("torch_glow");
+  }
+  return sampledLevel;
+}
+
+/// Exports \p traceContext, the trace of a run started at \p startTime whose
+/// level the sampler picked as \p sampledLevel, see startRunTrace.
+void exportRunTrace(TraceContext *traceContext, TraceLevel sampledLevel,
+                    uint64_t startTime) {
+  auto registry = TraceExporterRegistry::getInstance();
+  if (sampledLevel == TraceLevel::NONE) {
+    registry->exportTrace(traceContext);
+  } else {
+    registry->exportSampledTrace(traceContext, sampledLevel,
+                                 TraceEvent::now() - startTime);
+  }
+}
+
+} // namespace
+
+void CachingGraphRunner::aggregateAndDumpTraces(
+    std::unique_ptr<TraceContext> traceContext) {
+  if (!traceContext) {
+    return;
+  }
+  std::call_once(traceThreadOnce_, [this]() {
+    traceThread_ = glow::make_unique<ThreadPool>(1, "torch_glow_traces");
+  });
+  // Drop the trace rather than queue up memory when the dumps fall behind.
+  if (pendingTraces_++ >= kMaxPendingTraces) {
+    pendingTraces_--;
+    LOG_EVERY_N(WARNING, 100) << "Dropping trace, " << kMaxPendingTraces
+                              << " traces are pending";
+    return;
+  }
+  traceThread_->submit([this, trace = std::move(traceContext)]() mutable {
+    mergeAndDumpTraces(std::move(trace), /* flush */ false);
+  });
+}
+
+void CachingGraphRunner::mergeAndDumpTraces(
+    std::unique_ptr<TraceContext> traceContext, bool flush) {
+  size_t numTracesPerDump = defaultSettings_.numTracesPerDump;
+  if (traceContext) {
+    mergedTraceContext_->merge(traceContext.get());
+    numTraces_++;
+    pendingTraces_--;
+  } else if (mergedTraceContext_->getTraceEvents().empty()) {
+    return;
+  }
+
+  // If numTracesPerDump <= 0, it means we don't merge unless there is a flush
+  if (flush || (numTracesPerDump > 0 && numTraces_ % numTracesPerDump == 0)) {
+    // Initial way of differentiating the dump files when there are multiple
+    // graph runners
+    // TODO(allwu): find a better way to generate trace file names
+    size_t hash = reinterpret_cast<size_t>(this);
+    size_t dumpNum = numTraceDumps_++;
+    std::string filename =
+        strFormat("glow-trace-%04lx-%zu.json", hash % (1 << 16), dumpNum);
     mergedTraceContext_->dump(filename);
     mergedTraceContext_ = glow::make_unique<TraceContext>(TraceLevel::STANDARD);
   }
@@ -510,7 +586,8 @@ CachingGraphRunner::getAllSerializedFunctionsMap() {
 Expected<std::shared_ptr<CachingGraphRunner::PerGlowGraphInfo>>
 CachingGraphRunner::loadImpl(torch::jit::Stack &stack,
                              const PyTorchLoaderSettings &settings,
-                             TraceContext *traceContext) {
+                             TraceContext *traceContext,
+                             bool compileInBackground) {
   TRACE_EVENT_SCOPE(traceContext, TraceLevel::RUNTIME, "torch_glow::loadImpl");
   RECORD_USER_SCOPE("torch_glow::loadImpl");
   const auto inputs = torch::jit::last(stack, graph_->inputs().size());
@@ -525,15 +602,53 @@ CachingGraphRunner::loadImpl(torch::jit::Stack &stack,
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "InputMetaStack_creation");
 
+  // Inputs of varying sizes share the function of their shape bucket, they
+  // are padded to its placeholders when they are set up for the run.
+  const bool bucketed = !settings.shapeBuckets.empty() &&
+                        metaStack.inputMetas.size() == inputs.size();
+  if (bucketed) {
+    metaStack = bucketInputMetaStack(std::move(metaStack),
+                                     settings.shapeBuckets);
+  }
+
   // If we already have a Glow function compiled for this graph with and the
   // given inputs then use that.
   TRACE_EVENT_BEGIN(traceContext, TraceLevel::RUNTIME,
                     "perGlowGraphInfoMap__lookup");
-  std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
   size_t hash = getGraphMapKeyFromInputStack(metaStack);
   {
+    // Every run looks its graph up while graphs are only added on the first
+    // run of every input shape, so lookups share the lock.
+    auto lookupStart = std::chrono::steady_clock::now();
+    std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
+    auto it = perGlowGraphInfoMap_.find(hash);
+    if (it != perGlowGraphInfoMap_.end()) {
+      std::shared_ptr<PerGlowGraphInfo> info = it->second;
+      rlock.unlock();
+      recordGraphCacheHit(lookupStart);
+      TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME,
+                      "perGlowGraphInfoMap__lookup");
+      return info;
+    }
+  }
+  if (compileInBackground) {
+    scheduleBackgroundCompile(stack, hash, settings);
+    TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME,
+                    "perGlowGraphInfoMap__lookup");
+    return std::shared_ptr<PerGlowGraphInfo>();
+  }
+  graphCacheMisses_++;
+
+  // Compile holding compileMutex_ only, so that the runs of the compiled
+  // graphs go on meanwhile, unless another thread compiled the graph since the
+  // lookup.
+  std::lock_guard<std::mutex> compileLock(compileMutex_);
+  {
+    std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
     auto it = perGlowGraphInfoMap_.find(hash);
     if (it != perGlowGraphInfoMap_.end()) {
+      TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME,
+                      "perGlowGraphInfoMap__lookup");
       return it->second;
     }
   }
@@ -567,11 +682,13 @@ CachingGraphRunner::loadImpl(torch::jit::Stack &stack,
     RECORD_USER_SCOPE("loadJITGraph");
     RETURN_IF_ERR(PyTorchModelLoader::loadJITGraph(
         *f, *graph_, info->inputPlaceholders, info->outputPlaceholders,
-        outputCorrectTypes_, loadSettings, inputs, {}));
+        outputCorrectTypes_, loadSettings, inputs,
+        bucketed ? metaStack : InputMetaStack()));
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "loadJITGraph");
 
   info->inputSanitizers = runtime::getInputSanitizers(*f);
+  info->inputDeduplicators = runtime::getInputDeduplicators(*f);
 
   if (loadSettings.convertToFP16) {
     cctx.precisionConfig.precisionModeKindSet.insert(
@@ -599,6 +716,7 @@ CachingGraphRunner::loadImpl(torch::jit::Stack &stack,
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "addNetwork");
 
+  std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
   auto ret = perGlowGraphInfoMap_.emplace(hash, info);
   RETURN_ERR_IF_NOT(ret.second,
                     strFormat("Tried to store duplicate Glow graph for %s",
@@ -607,6 +725,33 @@ CachingGraphRunner::loadImpl(torch::jit::Stack &stack,
   return info;
 }
 
+void CachingGraphRunner::scheduleBackgroundCompile(
+    const torch::jit::Stack &stack, size_t hash,
+    const PyTorchLoaderSettings &settings) {
+  {
+    std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
+    if (perGlowGraphInfoMap_.count(hash) ||
+        !backgroundCompiles_.insert(hash).second) {
+      return;
+    }
+  }
+
+  // The request goes on with its inputs, so the compilation gets copies.
+  auto inputs = std::make_shared<torch::jit::Stack>();
+  for (const auto &ival : torch::jit::last(stack, graph_->inputs().size())) {
+    inputs->push_back(ival.isTensor() ? ival.deepcopy() : ival);
+  }
+  compileThread_->submit([this, inputs, hash, settings]() {
+    auto infoOrErr = loadImpl(*inputs, settings, /* traceContext */ nullptr);
+    if (!infoOrErr) {
+      LOG(ERROR) << "Background compilation failed: "
+                 << ERR_TO_STRING(infoOrErr.takeError());
+    }
+    std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
+    backgroundCompiles_.erase(hash);
+  });
+}
+
 Expected<MetaStack *>
 CachingGraphRunner::loadShape(const c10::ArrayRef<c10::IValue> &inputs,
                               TraceContext *traceContext) {
@@ -627,12 +772,14 @@ CachingGraphRunner::loadShape(const c10::ArrayRef<c10::IValue> &inputs,
   // If we already have a shape info for this graph output with and the
   // given inputs then use that.
   size_t hash = getGraphMapKeyFromInputStack(metaStack);
+  std::shared_ptr<const ShapeInferenceEngine::Plan> plan;
   {
     std::lock_guard<std::mutex> graphShapeLock(glowGraphShapeMapMutex_);
     auto it = perGlowGraphShapeMap_.find(hash);
     if (it != perGlowGraphShapeMap_.end()) {
       return &(it->second);
     }
+    plan = shapeInferencePlan_;
   }
 
   VLOG(1) << "Compiling graph with tensor shape:\n" << metaStack.print();
@@ -644,32 +791,53 @@ CachingGraphRunner::loadShape(const c10::ArrayRef<c10::IValue> &inputs,
   {
     RECORD_USER_SCOPE("runShapeInference");
 
-    ShapeInferenceEngine shapeG(*graph_, inputs);
+    ShapeInferenceEngine shapeG(*graph_, inputs, "ShapeInf",
+                                /* compilationMode */ false, plan);
     RETURN_IF_ERR(shapeG.run());
     outputShape = shapeG.getGraphOutputShape();
+    plan = shapeG.getPlan();
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "runShapeInference");
 
   {
     std::lock_guard<std::mutex> graphShapeLock(glowGraphShapeMapMutex_);
+    if (!shapeInferencePlan_) {
+      shapeInferencePlan_ = std::move(plan);
+    }
     auto ret = perGlowGraphShapeMap_.emplace(hash, outputShape);
     return &(ret.first->second);
   }
 }
 
 int64_t CachingGraphRunner::runOnJit(torch::jit::Stack &stack) {
-  static std::mutex runJitLock;
-  std::lock_guard<std::mutex> guard(runJitLock);
-  bool temp = getGlobalPyTorchLoaderSettingsMutable().fusionPassEnabled;
-  getGlobalPyTorchLoaderSettingsMutable().fusionPassEnabled = false;
+  // The graph must not be fused back into Glow when the executor optimizes
+  // it. The pass is only disabled on this thread, so that JIT runs of several
+  // threads go on concurrently.
+  GlowFusionPassDisabler disableFusion;
   int64_t startTime;
   startTime = TraceEvent::now();
   ptGraphExecutor_.run(stack);
   int64_t runTime = TraceEvent::now() - startTime;
-  getGlobalPyTorchLoaderSettingsMutable().fusionPassEnabled = temp;
   return runTime;
 }
 
+void CachingGraphRunner::runOnJitFallback(torch::jit::Stack &stack) {
+  const size_t numInputs = graph_->inputs().size();
+  torch::jit::Stack jitStack;
+  // The original graph takes the module as first input, see runOnJit.
+  if (origGraph_ != nullptr) {
+    jitStack.push_back(module_);
+  }
+  for (auto &ival : torch::jit::last(stack, numInputs)) {
+    jitStack.push_back(ival);
+  }
+  torch::jit::drop(stack, numInputs);
+  runOnJit(jitStack);
+  for (auto &ival : jitStack) {
+    stack.push_back(std::move(ival));
+  }
+}
+
 struct TensorCompareResult {
   double relErr;
   double maxErr;
@@ -868,15 +1036,30 @@ CachingGraphRunner::convertPyTorchInputToGlowInput(
 
   // If the tensor is an int64 tensor but should be an int32 tensor in Glow,
   // convert it.
-  if (ptTensor.scalar_type() == at::kLong &&
-      ty->getElementType() == ElemKind::Int32ITy) {
+  const bool narrowToInt32 = ptTensor.scalar_type() == at::kLong &&
+                             ty->getElementType() == ElemKind::Int32ITy;
+  const at::ScalarType scalarType =
+      narrowToInt32 ? at::kInt : ptTensor.scalar_type();
+
+  // Tensors that are smaller than the placeholder, for backends that do not
+  // support partial tensors, are copied into a padded tensor anyway. The copy
+  // also converts them and makes them contiguous, instead of making
+  // intermediate copies for that.
+  const bool isFullTensor =
+      ty->dims().size() == ptTensor.ndimension() &&
+      std::equal(ty->dims().begin(), ty->dims().end(),
+                 ptTensor.sizes().begin());
+  const bool convertWhilePadding = !isFullTensor && ptTensor.numel() > 0 &&
+                                   !backend_.supportsPartialTensors() &&
+                                   !ptTensor.is_quantized();
+  if (narrowToInt32 && !convertWhilePadding) {
     ptTensor = ptTensor.to(at::kInt);
   }
 
   // Make sure the runtime pytorch tensor type matches the placeholder.
   // Note this needs to be placed after convertQuantizedToDtype to
   // correctly handle quantized types.
-  if (ty->getElementType() != scalarTypeToElemKind(ptTensor.scalar_type())) {
+  if (ty->getElementType() != scalarTypeToElemKind(scalarType)) {
     std::stringstream ss;
     ss << "Found type mismatch for input \"" << ph->getName().str() << "\""
        << ": pytorch tensor is " << ptTensor.toString() << ", ph type is "
@@ -884,7 +1067,7 @@ CachingGraphRunner::convertPyTorchInputToGlowInput(
     return MAKE_ERR(ss.str());
   }
 
-  if (!ptTensor.is_contiguous()) {
+  if (!ptTensor.is_contiguous() && !convertWhilePadding) {
     ptTensor = ptTensor.contiguous();
   }
 
@@ -896,9 +1079,7 @@ CachingGraphRunner::convertPyTorchInputToGlowInput(
     return MAKE_ERR(ss.str());
   }
 
-  if (ty->dims().size() == ptTensor.ndimension() &&
-      std::equal(ty->dims().begin(), ty->dims().end(),
-                 ptTensor.sizes().begin())) {
+  if (isFullTensor) {
     glowTensor = glow::Tensor(ptTensor.data_ptr(), ty);
   } else if (ptTensor.data_ptr() && ptTensor.numel() > 0 &&
              backend_.supportsPartialTensors()) {
@@ -923,9 +1104,15 @@ CachingGraphRunner::convertPyTorchInputToGlowInput(
     inputTensor.resetDeviceInfo();
     if (ptTensor.data_ptr()) {
       auto *inTensorPtr = inputTensor.getUnsafePtr();
-      memcpy(inTensorPtr, ptTensor.data_ptr(), ptTensor.nbytes());
+      if (convertWhilePadding) {
+        at::from_blob(inTensorPtr, ptTensor.sizes(),
+                      at::TensorOptions().dtype(scalarType))
+            .copy_(ptTensor);
+      } else {
+        memcpy(inTensorPtr, ptTensor.data_ptr(), ptTensor.nbytes());
+      }
       auto hostElementSize = inputTensor.getType().getElementSize();
-      int numElements = ptTensor.nbytes() / hostElementSize;
+      int numElements = ptTensor.numel();
       int numPaddedElements = inputTensor.getSizeInBytes() / hostElementSize;
       if (hostElementSize == 1) {
         std::fill(
@@ -1094,12 +1281,8 @@ Error CachingGraphRunner::runImpl(const PerGlowGraphInfo &info,
     {
       RECORD_USER_SCOPE("setupOutput");
 
+      // Glow writes the outputs straight into the PyTorch tensors returned.
       for (auto *ph : info.outputPlaceholders) {
-        std::vector<int64_t> sizes;
-        for (auto size : ph->dims()) {
-          sizes.push_back(static_cast<int64_t>(size));
-        }
-
         auto ptT = glowTypeToEmptyPTTensor(*ph->getType());
 
         glow::Tensor t(ptT.data_ptr(), ph->getType());
@@ -1115,6 +1298,15 @@ Error CachingGraphRunner::runImpl(const PerGlowGraphInfo &info,
     RETURN_IF_ERR(sanitizeInputs(info.inputSanitizers, *bindings));
     TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "runInputSanitization");
 
+    // Owns the deduplicated inputs until the run is done.
+    std::vector<glow::Tensor> dedupStorage;
+    TRACE_EVENT_BEGIN(traceContext, TraceLevel::RUNTIME,
+                      "runInputDeduplication");
+    RETURN_IF_ERR(deduplicateInputs(info.inputDeduplicators, *bindings,
+                                    dedupStorage));
+    TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME,
+                    "runInputDeduplication");
+
     TRACE_EVENT_BEGIN(traceContext, TraceLevel::RUNTIME, "runNetwork");
     int64_t glowRunStartTime, glowRunningTime;
     {
@@ -1143,6 +1335,17 @@ Error CachingGraphRunner::runImpl(const PerGlowGraphInfo &info,
         }
       }
 
+      // Outputs of a function compiled for a shape bucket that are as large as
+      // its first input are sliced back to the size of the actual input.
+      int64_t bucketSize = 0;
+      int64_t actualSize = 0;
+      if (!settings.runShapeInference && !settings.shapeBuckets.empty() &&
+          !info.inputPlaceholders.empty() && inputs[0].isTensor() &&
+          inputs[0].toTensor().dim() > 0) {
+        bucketSize = info.inputPlaceholders[0]->dims()[0];
+        actualSize = inputs[0].toTensor().size(0);
+      }
+
       torch::jit::drop(stack, numInputs);
       std::vector<glow::Tensor> convertedGlowTensors;
       for (int i = 0; i < outputs.size(); i++) {
@@ -1182,6 +1385,9 @@ Error CachingGraphRunner::runImpl(const PerGlowGraphInfo &info,
                 (*ptrOutputShape)[i].shape<TensorShape>();
             ptTensor = sliceTensor(ptTensor, expectedShape);
           }
+        } else if (actualSize < bucketSize && ptTensor.dim() > 0 &&
+                   ptTensor.size(0) == bucketSize) {
+          ptTensor = at::native::slice(ptTensor, 0, 0, actualSize);
         }
 
         // Run comparison between Glow and JIT outputs
@@ -1246,13 +1452,10 @@ Error CachingGraphRunner::run(torch::jit::Stack &stack) {
   }
   std::unique_ptr<ExecutionContext> ctx = glow::make_unique<ExecutionContext>();
 
-  TraceContext *traceContext = nullptr;
-  if (defaultSettings_.enableGlowTracing ||
-      TraceExporterRegistry::getInstance()->shouldTrace()) {
-    ctx->setTraceContext(glow::make_unique<TraceContext>(TraceLevel::STANDARD));
-    traceContext = ctx->getTraceContext();
-    traceContext->setThreadName("torch_glow");
-  }
+  uint64_t startTime = TraceEvent::now();
+  TraceLevel sampledLevel =
+      startRunTrace(*ctx, defaultSettings_.enableGlowTracing);
+  TraceContext *traceContext = ctx->getTraceContext();
 
   TRACE_EVENT_BEGIN(traceContext, TraceLevel::RUNTIME, "torch_glow::run");
   detail::GlowError err = detail::GlowError::empty();
@@ -1263,26 +1466,62 @@ Error CachingGraphRunner::run(torch::jit::Stack &stack) {
 
     std::shared_ptr<PerGlowGraphInfo> info;
     ASSIGN_VALUE_OR_RETURN_ERR(info,
-                               loadImpl(stack, defaultSettings_, traceContext));
-    err = runImpl(*DCHECK_NOTNULL(info.get()), stack, ctx);
+                               loadImpl(stack, defaultSettings_, traceContext,
+                                        defaultSettings_.asyncCompile));
+    if (info) {
+      err = runImpl(*info, stack, ctx);
+    } else {
+      // The Glow function of the inputs compiles in the background.
+      DCHECK(defaultSettings_.asyncCompile);
+      runOnJitFallback(stack);
+    }
 
     // Reset the traceContext again in case it was changed during run.
     traceContext = ctx->getTraceContext();
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "torch_glow::run");
 
-  TraceExporterRegistry::getInstance()->exportTrace(traceContext);
+  exportRunTrace(traceContext, sampledLevel, startTime);
   if (defaultSettings_.enableGlowTracing) {
-    aggregateAndDumpTraces(traceContext);
+    aggregateAndDumpTraces(ctx->setTraceContext(nullptr));
   }
 
   return err;
 }
 
+Error CachingGraphRunner::runBatch(std::vector<torch::jit::Stack> &stacks) {
+  std::vector<Error> errs;
+  errs.reserve(stacks.size());
+  for (size_t i = 0; i < stacks.size(); ++i) {
+    errs.emplace_back(Error::empty());
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(stacks.size());
+  for (size_t i = 1; i < stacks.size(); ++i) {
+    threads.emplace_back([&, i]() { errs[i] = run(stacks[i]); });
+  }
+  if (!stacks.empty()) {
+    errs[0] = run(stacks[0]);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  Error firstErr = Error::empty();
+  for (auto &err : errs) {
+    if (!firstErr) {
+      firstErr = std::move(err);
+    } else {
+      ERR_TO_VOID(std::move(err));
+    }
+  }
+  return firstErr;
+}
+
 Expected<std::shared_ptr<CachingGraphRunner::PerGlowGraphInfo>>
 CachingGraphRunner::findGraphInfoForStack(const torch::jit::Stack &stack) {
   if (useMaxSizeCompilation_) {
-    std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
+    std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
     if (perGlowGraphInfoMap_.size() != 1) {
       return MAKE_ERR(strFormat(
           "There should be one and only one compiled graph, but got %lu",
@@ -1295,7 +1534,11 @@ CachingGraphRunner::findGraphInfoForStack(const torch::jit::Stack &stack) {
     InputMetaStack metaStack;
     ASSIGN_VALUE_OR_RETURN_ERR(metaStack,
                                inputMetaStackFromStack(relevantInputs));
-    std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
+    if (!defaultSettings_.shapeBuckets.empty()) {
+      metaStack = bucketInputMetaStack(std::move(metaStack),
+                                       defaultSettings_.shapeBuckets);
+    }
+    std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
     size_t hash = getGraphMapKeyFromInputStack(metaStack);
     auto it = perGlowGraphInfoMap_.find(hash);
     if (it == perGlowGraphInfoMap_.end()) {
@@ -1320,13 +1563,9 @@ Error CachingGraphRunner::runOnly(torch::jit::Stack &stack) {
   const PyTorchLoaderSettings &settings = info->settings;
 
   std::unique_ptr<ExecutionContext> ctx = glow::make_unique<ExecutionContext>();
-  TraceContext *traceContext = nullptr;
-  if (settings.enableGlowTracing ||
-      TraceExporterRegistry::getInstance()->shouldTrace()) {
-    ctx->setTraceContext(glow::make_unique<TraceContext>(TraceLevel::STANDARD));
-    traceContext = ctx->getTraceContext();
-    traceContext->setThreadName("torch_glow");
-  }
+  uint64_t startTime = TraceEvent::now();
+  TraceLevel sampledLevel = startRunTrace(*ctx, settings.enableGlowTracing);
+  TraceContext *traceContext = ctx->getTraceContext();
   TRACE_EVENT_BEGIN(traceContext, TraceLevel::RUNTIME, "torch_glow::runOnly");
   detail::GlowError err = detail::GlowError::empty();
   {
@@ -1338,13 +1577,93 @@ Error CachingGraphRunner::runOnly(torch::jit::Stack &stack) {
   }
   TRACE_EVENT_END(traceContext, TraceLevel::RUNTIME, "torch_glow::runOnly");
 
-  TraceExporterRegistry::getInstance()->exportTrace(traceContext);
+  exportRunTrace(traceContext, sampledLevel, startTime);
   if (settings.enableGlowTracing) {
-    aggregateAndDumpTraces(traceContext);
+    aggregateAndDumpTraces(ctx->setTraceContext(nullptr));
   }
   return err;
 }
 
+size_t CachingGraphRunner::getGraphHash() const {
+  return std::hash<std::string>()(graph_->toString());
+}
+
+Expected<bool> CachingGraphRunner::loadCompiledFunctionsBundle(
+    const std::string &path,
+    std::unordered_map<std::string, std::vector<char>> &nameToFunctions) {
+  ZipReader zip(path, /* mapFile */ true);
+  RETURN_ERR_IF_NOT(zip.hasRecord("graph") && zip.hasRecord("functions"),
+                    "Invalid compiled functions bundle " + path);
+  if (zip.getRecord("graph") != strFormat("%lu", getGraphHash())) {
+    return false;
+  }
+  std::stringstream names(zip.getRecord("functions"));
+  std::string name;
+  for (size_t i = 0; std::getline(names, name); i++) {
+    auto data = zip.getRecordView("function_" + std::to_string(i));
+    nameToFunctions[name] = std::vector<char>(data.begin(), data.end());
+  }
+  return true;
+}
+
+Error CachingGraphRunner::saveCompiledFunctionsBundle(const std::string &path) {
+  auto functions = getAllSerializedFunctionsMap();
+  std::vector<std::string> names;
+  {
+    std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
+    for (const auto &kv : perGlowGraphInfoMap_) {
+      std::string name = strFormat("%lu", kv.first);
+      if (functions->count(name)) {
+        names.push_back(std::move(name));
+      }
+    }
+  }
+  if (names.empty()) {
+    LOG(INFO) << "No serialized compiled function to save in " << path;
+    return Error::success();
+  }
+
+  // The bundle is written to a temporary file renamed into place, so that
+  // processes starting meanwhile never load a partial bundle.
+  llvm::SmallString<128> tmpPath;
+  std::error_code EC =
+      llvm::sys::fs::createUniqueFile(path + ".tmp-%%%%%%", tmpPath);
+  RETURN_ERR_IF_NOT(!EC, "Failed to create compiled functions bundle " + path +
+                             ": " + EC.message());
+  {
+    std::ofstream out(tmpPath.str().str(), std::ios::binary);
+    ZipWriter zip(&out, "bundle");
+    const std::string graphHash = strFormat("%lu", getGraphHash());
+    zip.writeRecord("graph", graphHash.c_str(), graphHash.size(),
+                    /* compress */ false);
+    std::stringstream nameList;
+    for (const auto &name : names) {
+      nameList << name << "\n";
+    }
+    zip.writeRecord("functions", nameList.str().c_str(), nameList.str().size(),
+                    /* compress */ false);
+    for (size_t i = 0, e = names.size(); i < e; i++) {
+      auto &stream = *functions->at(names[i]);
+      std::vector<char> data(stream.getSize());
+      RETURN_ERR_IF_NOT(
+          stream.read(data.data(), data.size()) == data.size(),
+          "Failed to read serialized compiled function " + names[i]);
+      zip.writeRecord("function_" + std::to_string(i), data.data(),
+                      data.size(), /* compress */ false);
+    }
+    zip.writeEndOfFile();
+    RETURN_ERR_IF_NOT(out, "Failed to write " + tmpPath.str().str());
+  }
+  EC = llvm::sys::fs::rename(tmpPath, path);
+  if (EC) {
+    llvm::sys::fs::remove(tmpPath);
+    return MAKE_ERR("Failed to save compiled functions bundle " + path + ": " +
+                    EC.message());
+  }
+  LOG(INFO) << "Saved " << names.size() << " compiled functions in " << path;
+  return Error::success();
+}
+
 Error CachingGraphRunner::warmCache(
     const std::vector<InputMetaStack> &metaStacks,
     const PyTorchLoaderSettings &settings,
@@ -1399,13 +1718,50 @@ Error CachingGraphRunner::warmCache(
                       "torch_glow::warmCache");
     RECORD_USER_SCOPE("torch_glow::warmCache");
 
+    // Load the functions of a bundle saved by an earlier warmCache of the graph
+    // unless the functions were given.
+    const std::string &bundle = settings.compiledFunctionsBundle;
+    if (!bundle.empty() && !useDeserialize &&
+        llvm::sys::fs::exists(bundle)) {
+      auto bundleFunctions = std::make_shared<
+          std::unordered_map<std::string, std::vector<char>>>();
+      bool loaded;
+      ASSIGN_VALUE_OR_RETURN_ERR(
+          loaded, loadCompiledFunctionsBundle(bundle, *bundleFunctions));
+      if (loaded) {
+        nameToFunctions = std::move(bundleFunctions);
+        useDeserialize = true;
+      } else {
+        LOG(WARNING) << "Ignoring compiled functions bundle " << bundle
+                     << " of another graph";
+      }
+    }
+
+    // The functions of all the input sets are added as one network, so they
+    // are only deserialized if every one of them was serialized.
+    if (useDeserialize) {
+      for (const auto &metaStack : metaStacks) {
+        if (!nameToFunctions ||
+            !nameToFunctions->count(
+                strFormat("%lu", getGraphMapKeyFromInputStack(metaStack)))) {
+          LOG(WARNING) << "No compiled function for inputs:" << std::endl
+                       << metaStack.print() << "compiling all input sets";
+          useDeserialize = false;
+          break;
+        }
+      }
+    }
+    if (useDeserialize) {
+      cctx.backendOpts.useDeserialize = true;
+    }
+
     runtime::PrePartitionedConfig PPC;
 
     for (const auto &metaStack : metaStacks) {
       size_t hash = getGraphMapKeyFromInputStack(metaStack);
 
       {
-        std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
+        std::shared_lock<std::shared_timed_mutex> rlock(graphInfoMapMutex);
         if (perGlowGraphInfoMap_.find(hash) != perGlowGraphInfoMap_.end()) {
           return MAKE_ERR(strFormat("There is already a compiled graph for %s",
                                     metaStack.print().c_str()));
@@ -1421,13 +1777,10 @@ Error CachingGraphRunner::warmCache(
       // If this function has already been compiled, the compiled stream is
       // already stored in nameToFunction, and deserialize is enabled, we use
       // the compiled stream instead of compiling it again.
-      if (useDeserialize &&
-          nameToFunctions->find(functionNameHash) != nameToFunctions->end()) {
+      if (useDeserialize) {
         cctx.nameToFunctions.emplace(std::make_pair(
-            info->functionName,
-            std::make_shared<std::vector<char>>(
-                nameToFunctions->find(functionNameHash)->second)));
-        cctx.backendOpts.useDeserialize = true;
+            info->functionName, std::make_shared<std::vector<char>>(
+                                    nameToFunctions->at(functionNameHash))));
       }
 
       // Type table for deferred weight loader
@@ -1523,6 +1876,7 @@ Error CachingGraphRunner::warmCache(
               *f, *graph_, info->inputPlaceholders, info->outputPlaceholders,
               outputCorrectTypes_, info->settings, {}, metaStack));
           info->inputSanitizers = runtime::getInputSanitizers(*f);
+          info->inputDeduplicators = runtime::getInputDeduplicators(*f);
           // Prepare GlowDeserializationSpec and cctx for serializing Glow IR
           if (settings.saveGlowIRIntoONNX) {
             GlowDeserializationSpec spec;
@@ -1583,11 +1937,15 @@ Error CachingGraphRunner::warmCache(
       TRACE_EVENT_END(traceContext.get(), TraceLevel::RUNTIME, "addNetwork");
     }
 
+    if (!bundle.empty() && !useDeserialize) {
+      RETURN_IF_ERR(saveCompiledFunctionsBundle(bundle));
+    }
+
     TRACE_EVENT_END(traceContext.get(), TraceLevel::RUNTIME,
                     "torch_glow::warmCache");
   }
   if (settings.enableGlowTracing) {
-    aggregateAndDumpTraces(traceContext.get());
+    aggregateAndDumpTraces(std::move(traceContext));
   }
   return Error::success();
 }
@@ -1608,11 +1966,27 @@ CachingGraphRunner::CachingGraphRunner(
     ptGraphExecutor_ = torch::jit::GraphExecutor(graph_, "forward");
   }
   mergedTraceContext_ = glow::make_unique<TraceContext>(TraceLevel::STANDARD);
+  if (defaultSettings_.asyncCompile) {
+    compileThread_ = glow::make_unique<ThreadPool>(1, "torch_glow_compile");
+  }
 }
 
 CachingGraphRunner::~CachingGraphRunner() {
-  // Dump trace for the last time if there are remaining
-  aggregateAndDumpTraces(nullptr, true);
+  // Stop the background compilations before removing their functions.
+  compileThread_.reset();
+
+  // Dump trace for the last time if there are remaining, after the pending
+  // ones are merged.
+  if (traceThread_) {
+    traceThread_
+        ->submit([this]() { mergeAndDumpTraces(nullptr, /* flush */ true); })
+        .wait();
+    traceThread_.reset();
+  }
+
+  if (graphCacheHits_ || graphCacheMisses_) {
+    exportGraphCacheStats();
+  }
 
   // Remove Glow functions saved in HostManager when being destroyed.
   std::unique_lock<std::shared_timed_mutex> wlock(graphInfoMapMutex);
@@ -1689,6 +2063,24 @@ Error CachingGraphRunner::setNominalInputIndex(
 
 int CachingGraphRunner::getNominalInputIndex() { return nominalInputIndex_; }
 
+void CachingGraphRunner::recordGraphCacheHit(
+    std::chrono::steady_clock::time_point lookupStart) {
+  graphCacheLookupLatency_.record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - lookupStart)
+          .count());
+  if (++graphCacheHits_ % kGraphCacheStatsExportInterval == 0) {
+    exportGraphCacheStats();
+  }
+}
+
+void CachingGraphRunner::exportGraphCacheStats() {
+  auto stats = StatsExporterRegistry::Stats();
+  stats->setCounter(kGraphCacheHits, graphCacheHits_);
+  stats->setCounter(kGraphCacheMisses, graphCacheMisses_);
+  stats->addHistogram(kGraphCacheLookupLatency, graphCacheLookupLatency_);
+}
+
 size_t CachingGraphRunner::getGraphMapKeyFromInputStack(
     const InputMetaStack &metaStack) {
   size_t hash;
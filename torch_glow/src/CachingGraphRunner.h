@@ -21,13 +21,19 @@
 #include "glow/Backend/BlockStreamBase.h"
 #include "glow/Runtime/HostManager/HostManager.h"
 #include "glow/Runtime/InputSanitizer.h"
+#include "glow/Support/LatencyHistogram.h"
 #include "glow/Support/TensorPool.h"
+#include "glow/Support/ThreadPool.h"
 
 #include <torch/csrc/jit/ir/ir.h>
 #include <torch/csrc/jit/serialization/import.h>
 
 #include "ShapeInferenceEngine.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <shared_mutex>
+#include <unordered_set>
 
 namespace glow {
 /// For a given PyTorch JIT graph, this class is responsible for maintaining a
@@ -55,6 +61,9 @@ public:
     /// inputs to the backend.
     std::vector<runtime::InputSanitizerPtr> inputSanitizers;
 
+    /// Deduplicators of the indices of the weighted SLS inputs.
+    std::vector<runtime::InputDeduplicatorPtr> inputDeduplicators;
+
     /// Name of the Glow function maintained by HostManager for this subgraph.
     std::string functionName;
 
@@ -101,7 +110,11 @@ private:
   /// function that will run inputs matching that hash.
   std::unordered_map<size_t, MetaStack> perGlowGraphShapeMap_;
 
-  /// Mutex that protects perGlowGraphShapeMap_.
+  /// Shape inference plan of graph_, built by the first shape inference and
+  /// reused by the ones of new input shapes.
+  std::shared_ptr<const ShapeInferenceEngine::Plan> shapeInferencePlan_;
+
+  /// Mutex that protects perGlowGraphShapeMap_ and shapeInferencePlan_.
   std::mutex glowGraphShapeMapMutex_;
 
   /// In AOT flow, compile a single Glow function and use it for all input
@@ -116,26 +129,66 @@ private:
   /// Use for quantization int8/uint8 rescale.
   std::vector<at::ScalarType> outputCorrectTypes_;
 
-  /// Mutex that protects numTraces_ and mergedTraceContext_.
-  std::mutex tracesMutex_;
-
-  /// The number of runs traced
+  /// The number of runs traced, only accessed on traceThread_.
   size_t numTraces_{0};
 
-  /// The number of trace dumps already generated
+  /// The number of trace dumps already generated, only accessed on
+  /// traceThread_.
   size_t numTraceDumps_{0};
 
   /// TraceContext used to aggregate traces from runs before dumping them
-  /// in groups to file.
+  /// in groups to file, only accessed on traceThread_.
   std::unique_ptr<TraceContext> mergedTraceContext_;
 
+  /// Thread merging and dumping the traces of the runs, created by the first
+  /// traced run.
+  std::unique_ptr<ThreadPool> traceThread_;
+
+  /// Creates traceThread_ once.
+  std::once_flag traceThreadOnce_;
+
+  /// The number of traces submitted to traceThread_ and not merged yet.
+  std::atomic<size_t> pendingTraces_{0};
+
   /// Lock for concurrent accessing to perGlowGraphInfoMap_.
   std::shared_timed_mutex graphInfoMapMutex;
 
+  /// Serializes the compilations of loadImpl, which share outputCorrectTypes_,
+  /// without holding graphInfoMapMutex.
+  std::mutex compileMutex_;
+
+  /// Hashes of the inputs whose Glow functions are being compiled on
+  /// compileThread_, protected by graphInfoMapMutex.
+  std::unordered_set<size_t> backgroundCompiles_;
+
+  /// Thread compiling the Glow functions of the inputs which run on the JIT
+  /// meanwhile, if asyncCompile is set in the default settings.
+  std::unique_ptr<ThreadPool> compileThread_;
+
   /// The number of times any Glow graph managed by this CachingGraphRunner has
   /// been run.
   std::atomic<size_t> numRuns_{0};
 
+  /// The number of lookups of perGlowGraphInfoMap_ by loadImpl that found a
+  /// compiled graph, and that did not.
+  std::atomic<uint64_t> graphCacheHits_{0};
+  std::atomic<uint64_t> graphCacheMisses_{0};
+
+  /// Latency in nanoseconds of the lookups of perGlowGraphInfoMap_ by
+  /// loadImpl that found a compiled graph.
+  LatencyHistogram graphCacheLookupLatency_;
+
+  /// Keys of the graph cache statistics, see exportGraphCacheStats.
+  static constexpr const char *kGraphCacheHits = "glow.torch_glow.cache_hits";
+  static constexpr const char *kGraphCacheMisses =
+      "glow.torch_glow.cache_misses";
+  static constexpr const char *kGraphCacheLookupLatency =
+      "glow.latency.torch_glow.cache_lookup";
+
+  /// The graph cache statistics are exported every
+  /// kGraphCacheStatsExportInterval hits and on destruction.
+  static constexpr uint64_t kGraphCacheStatsExportInterval = 1024;
+
   /// The maximum size of input tensors, to allocate the zerolength tensor
   size_t maxSeqLength_ = 1;
 
@@ -159,9 +212,17 @@ private:
   /// info is returned immediately. Otherwise this loads the
   /// subgraph into the owned HostManager, creates a PerGlowGraphInfo which is
   /// cached for the given inputs, and then \returns this PerGlowGraphInfo.
+  /// If \p compileInBackground then the subgraph is instead loaded on
+  /// compileThread_, unless it is already being loaded there, and this
+  /// \returns nullptr.
   Expected<std::shared_ptr<PerGlowGraphInfo>>
   loadImpl(torch::jit::Stack &stack, const PyTorchLoaderSettings &settings,
-           TraceContext *traceContext);
+           TraceContext *traceContext, bool compileInBackground = false);
+
+  /// Load on compileThread_ the subgraph for the inputs on \p stack, of hash
+  /// \p hash, with \p settings, see loadImpl.
+  void scheduleBackgroundCompile(const torch::jit::Stack &stack, size_t hash,
+                                 const PyTorchLoaderSettings &settings);
 
   /// Given a PyTorch inputs \p inputs, this generates a hash from the input
   /// shape and checks to see if the graph output shape with the given input
@@ -183,11 +244,22 @@ private:
   /// debugging purposes only. \returns how long running took in usecs.
   int64_t runOnJit(torch::jit::Stack &stack);
 
+  /// Run the inputs on \p stack on the JIT, replacing them with the outputs
+  /// like runImpl does. This is used while the Glow function of the inputs
+  /// compiles in the background.
+  void runOnJitFallback(torch::jit::Stack &stack);
+
   /// Given a TraceContext \p traceContext, aggregate it with previous
   /// TraceContexts and if enough have been aggregated according to settings
-  /// then dump them to file. If flush is true then dump aggregated traces to
-  /// file no matter what.
-  void aggregateAndDumpTraces(TraceContext *traceContext, bool flush = false);
+  /// then dump them to file. This is done on traceThread_, so that the run
+  /// does not wait for it; traces are dropped while too many are pending.
+  void aggregateAndDumpTraces(std::unique_ptr<TraceContext> traceContext);
+
+  /// Merges \p traceContext, if any, with the previous TraceContexts and dumps
+  /// them to file if enough have been aggregated or if \p flush is true. Runs
+  /// on traceThread_.
+  void mergeAndDumpTraces(std::unique_ptr<TraceContext> traceContext,
+                          bool flush);
 
   /// Converts PyTorch input tensor \p ptTensor to a Glow input tensor for the
   /// Placeholder \p ph. \returns the pair of the created Glow tensor and
@@ -208,6 +280,28 @@ private:
   /// The Glow Function should've already been created. Returns an error if not.
   Error runOnly(torch::jit::Stack &stack);
 
+  /// Record a lookup of perGlowGraphInfoMap_ started at \p lookupStart that
+  /// found a compiled graph.
+  void recordGraphCacheHit(std::chrono::steady_clock::time_point lookupStart);
+
+  /// Export the graph cache hits, misses and lookup latencies to the
+  /// registered StatsExporters.
+  void exportGraphCacheStats();
+
+  /// \returns a hash of graph_ that is the same in every process.
+  size_t getGraphHash() const;
+
+  /// Loads into \p nameToFunctions the compiled functions of the bundle
+  /// \p path, keyed like getAllSerializedFunctionsMap(). \returns false if
+  /// the bundle was saved for another graph than graph_.
+  Expected<bool> loadCompiledFunctionsBundle(
+      const std::string &path,
+      std::unordered_map<std::string, std::vector<char>> &nameToFunctions);
+
+  /// Saves the compiled functions of the Glow functions of this runner in the
+  /// bundle \p path, so that warmCache loads them instead of compiling them.
+  Error saveCompiledFunctionsBundle(const std::string &path);
+
   /// Get key of caching graph map from inputMetaStack.
   size_t getGraphMapKeyFromInputStack(const InputMetaStack &metaStack);
 
@@ -230,6 +324,25 @@ public:
   /// it as a Glow Function and compiles. \returns error of failure.
   Error run(torch::jit::Stack &stack);
 
+  /// Runs every stack of \p stacks like run(), the first one on the calling
+  /// thread and the others on their own threads, so that their Glow runs are
+  /// dispatched to the HostManager together. \returns the first error of the
+  /// runs.
+  Error runBatch(std::vector<torch::jit::Stack> &stacks);
+
+  /// \returns the number of runs that found their Glow function compiled.
+  uint64_t getGraphCacheHits() const { return graphCacheHits_; }
+
+  /// \returns the number of runs that did not find their Glow function
+  /// compiled.
+  uint64_t getGraphCacheMisses() const { return graphCacheMisses_; }
+
+  /// \returns the latencies in nanoseconds of the lookups of the runs that
+  /// found their Glow function compiled.
+  const LatencyHistogram &getGraphCacheLookupLatency() const {
+    return graphCacheLookupLatency_;
+  }
+
   /// Warm up the cache by compiling one Glow function per metaStack and storing
   /// its info in perGlowGraphInfoMap_ with the hash computed using metaStack in
   /// \p metaStacks. Each metaStack in \p metaStacks is used to pass Glow shapes
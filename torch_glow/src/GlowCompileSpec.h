@@ -899,6 +899,7 @@ struct GlowPyTorchLoaderSettings : public JsonSerializableCustomClass {
     obj["onnxFileNamePrefix"] = settings_.onnxFileNamePrefix;
     obj["jitVsGlowCompare"] = settings_.jitVsGlowCompare;
     obj["backendOptionsFile"] = settings_.backendOptionsFile;
+    obj["compiledFunctionsBundle"] = settings_.compiledFunctionsBundle;
     obj["saturateHost"] = settings_.saturateHost;
     obj["saturateKDevices"] = settings_.saturateKDevices;
     obj["randomizeConstants"] = settings_.randomizeConstants;
@@ -915,6 +916,8 @@ struct GlowPyTorchLoaderSettings : public JsonSerializableCustomClass {
     obj["availableDevices"] = dynArrayFromVec(settings_.availableDevices);
     obj["dumpFailedInputsToOnnxFiles"] = settings_.dumpFailedInputsToOnnxFiles;
     obj["lazyCompile"] = settings_.lazyCompile;
+    obj["asyncCompile"] = settings_.asyncCompile;
+    obj["shapeBuckets"] = dynArrayFromVec(settings_.shapeBuckets);
     obj["enableDeviceTracing"] = settings_.enableDeviceTracing;
     obj["use_dag_optimizer"] = settings_.use_dag_optimizer;
     obj["apl_parallelization_alg"] = settings_.apl_parallelization_alg;
@@ -1065,6 +1068,10 @@ struct GlowPyTorchLoaderSettings : public JsonSerializableCustomClass {
       ASSIGN_STRING_FROM_DYN_FIELD_OR_RETURN_ERR(
           dyn, settings_.backendOptionsFile, "backendOptionsFile");
     }
+    if (dyn.count("compiledFunctionsBundle")) {
+      ASSIGN_STRING_FROM_DYN_FIELD_OR_RETURN_ERR(
+          dyn, settings_.compiledFunctionsBundle, "compiledFunctionsBundle");
+    }
     if (dyn.count("saturateHost")) {
       ASSIGN_BOOL_FROM_DYN_FIELD_OR_RETURN_ERR(dyn, settings_.saturateHost,
                                                "saturateHost");
@@ -1129,6 +1136,16 @@ struct GlowPyTorchLoaderSettings : public JsonSerializableCustomClass {
       ASSIGN_BOOL_FROM_DYN_FIELD_OR_RETURN_ERR(dyn, settings_.lazyCompile,
                                                "lazyCompile");
     }
+    if (dyn.count("asyncCompile")) {
+      ASSIGN_BOOL_FROM_DYN_FIELD_OR_RETURN_ERR(dyn, settings_.asyncCompile,
+                                               "asyncCompile");
+    }
+    if (dyn.count("shapeBuckets")) {
+      CHECK_DYN_CONTAINS_ARRAY(dyn, "shapeBuckets");
+      ASSIGN_VALUE_OR_RETURN_ERR(
+          settings_.shapeBuckets,
+          dynArrayToVec<int64_t>(dyn.at("shapeBuckets")));
+    }
     if (dyn.count("enableDeviceTracing")) {
       ASSIGN_BOOL_FROM_DYN_FIELD_OR_RETURN_ERR(
           dyn, settings_.enableDeviceTracing, "enableDeviceTracing");
@@ -225,6 +225,66 @@ void fuseJITNodesToGlow(std::shared_ptr<torch::jit::Graph> graph,
   } while (changed);
 }
 
+/// \returns true if no use of the output of \p node may write to it.
+bool hasNoWriters(const torch::jit::Node *node) {
+  for (const auto &use : node->output()->uses()) {
+    if (use.user->kind() == torch::jit::prim::ListUnpack ||
+        use.user->kind() == torch::jit::prim::TupleUnpack) {
+      continue;
+    }
+    const auto *schema = use.user->maybeSchema();
+    if (!schema || schema->is_mutable()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Gives every use of the list or tuple built by a prim::ListConstruct or
+/// prim::TupleConstruct its own copy of the node. canMerge only merges the
+/// producers of non-tensor values into their single consumer, so a list
+/// shared by several nodes would otherwise be left in JIT, splitting the
+/// fusion groups around it.
+void duplicateSharedGlueNodes(std::shared_ptr<torch::jit::Graph> &graph) {
+  for (auto *node : graph->nodes()) {
+    if (node->kind() != torch::jit::prim::ListConstruct &&
+        node->kind() != torch::jit::prim::TupleConstruct) {
+      continue;
+    }
+    const auto uses = node->output()->uses();
+    if (uses.size() < 2 || !hasNoWriters(node)) {
+      continue;
+    }
+    for (size_t i = 1; i < uses.size(); ++i) {
+      torch::jit::Node *copy = graph->createClone(
+          node, [](torch::jit::Value *v) -> torch::jit::Value * { return v; });
+      copy->insertBefore(uses[i].user);
+      copy->output()->copyMetadata(node->output());
+      uses[i].user->replaceInput(uses[i].offset, copy->output());
+    }
+  }
+}
+
+/// Logs the number of fusion groups of kind \p kind in \p graph and of the
+/// nodes fused into them.
+void logFusionGroups(const std::shared_ptr<torch::jit::Graph> &graph,
+                     at::Symbol kind) {
+  size_t numGroups = 0;
+  size_t numFusedNodes = 0;
+  size_t numNodes = 0;
+  for (const auto *node : graph->nodes()) {
+    if (node->kind() == kind) {
+      numGroups++;
+      numFusedNodes += graphSize(getSubgraph(node));
+    } else if (node->kind() != torch::jit::prim::Constant) {
+      numNodes++;
+    }
+  }
+  LOG(INFO) << "Fused " << numFusedNodes << " nodes into " << numGroups
+            << " fusion groups of kind " << kind.toQualString() << ", "
+            << numNodes << " nodes remain in JIT";
+}
+
 void unmergeSubgraph(torch::jit::Node *subgraphNode) {
   // Inline the graph, replace uses of node outputs and destroy the node
   auto outerGraph = subgraphNode->owningGraph();
@@ -456,6 +516,8 @@ void glowCustomFuseImpl(std::shared_ptr<torch::jit::Graph> graph,
   // of the graph that Glow will not be running.
   fuseKnownPatterns(graph, settings.opBlocklist);
 
+  duplicateSharedGlueNodes(graph);
+
   fuseJITNodesToGlow(graph, nodeSupportedFn, kind, maxFusionMergeSize);
 
   if (minFusionGroupSize > 0) {
@@ -470,6 +532,8 @@ void glowCustomFuseImpl(std::shared_ptr<torch::jit::Graph> graph,
 
   verifyFusions(graph, kind);
 
+  logFusionGroups(graph, kind);
+
   if (settings.dumpOperatorInventory) {
     dumpOperatorStats(graph, fn, kind);
   }
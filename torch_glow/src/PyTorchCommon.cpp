@@ -101,6 +101,10 @@ DEFINE_bool(debugContinuouslyVerifyDuringModelLoading, false,
 DEFINE_int32(nominalBatchIdx, -1, "See PyTorchLoaderSettings");
 DEFINE_bool(dumpFailedInputsToOnnxFiles, false, "See PyTorchLoaderSettings");
 DEFINE_bool(lazyCompile, false, "see PyTorchLoaderSettings");
+DEFINE_bool(asyncCompile, false, "See PyTorchLoaderSettings");
+DEFINE_string(compiledFunctionsBundle, "", "See PyTorchLoaderSettings");
+DEFINE_string(shapeBuckets, "",
+              "Comma separated list of sizes, see PyTorchLoaderSettings");
 DEFINE_bool(enableDeviceTracing, false, "See PyTorchLoaderSettings");
 DEFINE_int32(debugLayers, 5, "See PyTorchLoaderSettings");
 
@@ -209,6 +213,7 @@ getHostManager(const PyTorchLoaderSettings &settings) {
     hostConfig.maxActiveRequests = glow::flags::MaxActiveRequests;
     hostConfig.maxQueueSize = glow::flags::MaxQueueSize;
     hostConfig.executorThreads = glow::flags::ExecutorThreads;
+    hostConfig.executorWorkStealing = glow::flags::ExecutorWorkStealing;
 
     // now overwrite existing config if torch_glow gflag is present
     hostConfig.maxActiveRequests = FLAGS_maxActiveRequests;
@@ -384,6 +389,8 @@ void PyTorchLoaderSettings::initSettings() {
       FLAGS_debugContinuouslyVerifyDuringModelLoading;
   nominalBatchIdx = FLAGS_nominalBatchIdx;
   lazyCompile = FLAGS_lazyCompile;
+  asyncCompile = FLAGS_asyncCompile;
+  compiledFunctionsBundle = FLAGS_compiledFunctionsBundle;
   use_dag_optimizer = glow::flags::UseDAGOptimizer;
   apl_parallelization_alg =
       glow::flags::DAGOptimizerParallelizationTaggingAlgorithm;
@@ -419,6 +426,12 @@ void PyTorchLoaderSettings::initSettings() {
     }
   }
 
+  if (!FLAGS_shapeBuckets.empty()) {
+    for (const auto &bucket : splitString(FLAGS_shapeBuckets)) {
+      shapeBuckets.push_back(std::stoll(bucket));
+    }
+  }
+
   glow::flags::processBackendSpecificOpts(backendSpecificOpts,
                                           FLAGS_backendSpecificOpts);
 }
@@ -432,6 +445,19 @@ PyTorchLoaderSettings &getGlobalPyTorchLoaderSettingsMutable() {
   return getPyTorchLoaderSettingsInternalOnly();
 }
 
+namespace {
+/// Number of GlowFusionPassDisablers living on the current thread.
+thread_local unsigned numFusionPassDisablers = 0;
+} // namespace
+
+GlowFusionPassDisabler::GlowFusionPassDisabler() { numFusionPassDisablers++; }
+
+GlowFusionPassDisabler::~GlowFusionPassDisabler() {
+  numFusionPassDisablers--;
+}
+
+bool GlowFusionPassDisabler::isActive() { return numFusionPassDisablers > 0; }
+
 std::string PyTorchLoaderSettings::toString() const {
 #define INSERT_BOOL_TO_STREAM(value, stream)                                   \
   (stream) << #value << ": " << ((value) ? "true" : "false") << std::endl;
@@ -451,6 +477,7 @@ std::string PyTorchLoaderSettings::toString() const {
   INSERT_BOOL_TO_STREAM(forceFP16AccumSLS, s);
   INSERT_BOOL_TO_STREAM(saturateHost, s);
   INSERT_VALUE_TO_STREAM(backendOptionsFile, s);
+  INSERT_VALUE_TO_STREAM(compiledFunctionsBundle, s);
   INSERT_VALUE_TO_STREAM(replicationCount, s);
   INSERT_BOOL_TO_STREAM(fusionPassEnabled, s);
   INSERT_BOOL_TO_STREAM(dumpGlowDag, s);
@@ -480,6 +507,7 @@ std::string PyTorchLoaderSettings::toString() const {
   INSERT_BOOL_TO_STREAM(debugContinuouslyVerifyDuringModelLoading, s);
   INSERT_BOOL_TO_STREAM(dumpFailedInputsToOnnxFiles, s);
   INSERT_BOOL_TO_STREAM(lazyCompile, s);
+  INSERT_BOOL_TO_STREAM(asyncCompile, s);
   INSERT_BOOL_TO_STREAM(enableDeviceTracing, s);
   INSERT_VALUE_TO_STREAM(debugLayers, s);
   INSERT_BOOL_TO_STREAM(useMaxSizeCompilation, s);
@@ -496,6 +524,13 @@ std::string PyTorchLoaderSettings::toString() const {
     }
     s << "]" << std::endl;
   }
+  if (shapeBuckets.size() > 0) {
+    s << "shapeBuckets: [";
+    for (const auto &bucket : shapeBuckets) {
+      s << bucket << ",";
+    }
+    s << "]" << std::endl;
+  }
   if (backendSpecificOpts.size() > 0) {
     s << "backendSpecificOpts: [";
     for (const auto &kv : backendSpecificOpts) {
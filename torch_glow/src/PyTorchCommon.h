@@ -225,6 +225,24 @@ public:
   ///       development testing.
   bool lazyCompile = false;
 
+  /// Whether the inputs of a shape without a compiled Glow function are run
+  /// on the JIT while the function compiles in the background, instead of
+  /// compiling it on the request thread.
+  bool asyncCompile = false;
+
+  /// Sizes that the first dimension of the inputs is rounded up to, the
+  /// smallest that holds it, when compiling Glow functions. This bounds the
+  /// number of functions compiled for inputs of varying batch sizes; the
+  /// inputs are padded to the compiled shape and the outputs are sliced back.
+  /// Inputs larger than every size keep their size. Empty means no rounding.
+  std::vector<int64_t> shapeBuckets;
+
+  /// Path of a bundle of the compiled functions of warmCache. If the file
+  /// exists then the functions it holds for the graph and input shapes are
+  /// loaded instead of compiled, otherwise it is written with the functions
+  /// that were compiled, when the backend can serialize them.
+  std::string compiledFunctionsBundle;
+
   /// Whether to enable device tracing from HostManger. NOTE: this must be set
   /// before network compilation.
   bool enableDeviceTracing = false;
@@ -323,6 +341,20 @@ PyTorchLoaderSettings getGlobalPyTorchLoaderSettingsSnapshot();
 /// singleton, this should almost never be used outside of binding.cpp.
 PyTorchLoaderSettings &getGlobalPyTorchLoaderSettingsMutable();
 
+/// Disables the Glow fusion pass on the current thread while it lives,
+/// whatever fusionPassEnabled is set to, so that a graph run on the JIT from
+/// this thread is not fused while other threads keep fusing.
+class GlowFusionPassDisabler final {
+public:
+  GlowFusionPassDisabler();
+  ~GlowFusionPassDisabler();
+  GlowFusionPassDisabler(const GlowFusionPassDisabler &) = delete;
+  GlowFusionPassDisabler &operator=(const GlowFusionPassDisabler &) = delete;
+
+  /// \returns whether a GlowFusionPassDisabler lives on the current thread.
+  static bool isActive();
+};
+
 /// \returns the HostManager singleton used to run all PyTorch graphs with for
 /// the Glow backend specified by \p settings. The HostManager will have the
 /// number of devices specified by settings. If a previous HostManager is
@@ -200,7 +200,7 @@ void registerGlowOp(const c10::Symbol &symbol) {
 void registerGlowFusionPass(std::function<bool()> enablePassFn) {
   torch::jit::registerPostPass([enablePassFn = std::move(enablePassFn)](
                                    std::shared_ptr<torch::jit::Graph> &g) {
-    if (enablePassFn()) {
+    if (enablePassFn() && !GlowFusionPassDisabler::isActive()) {
       auto settings = getGlobalPyTorchLoaderSettingsSnapshot();
       glow::glowCustomFuse(g, settings, getGlowSymbol());
     }
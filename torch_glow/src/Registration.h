@@ -27,7 +27,8 @@ void registerGlowOp(const c10::Symbol &symbol);
 
 /// Register the pass that fuses parts of the graph into a glow::FusionGroup. \p
 /// enablePassFn is used to enable/disable the glow fusion pass once it's
-/// registered.
+/// registered. The pass is also disabled on the threads where a
+/// GlowFusionPassDisabler lives.
 void registerGlowFusionPass(std::function<bool()> enablePassFn);
 
 /// Convenience method to register the glow fusion op and pass. \p
@@ -208,10 +208,12 @@ static std::vector<std::string> splitStr(const std::string &s,
 
 ShapeInferenceEngine::ShapeInferenceEngine(
     const torch::jit::Graph &graph, const at::ArrayRef<at::IValue> &inputs,
-    const std::string &fusionNodeSymbol, const bool &compilationMode)
+    const std::string &fusionNodeSymbol, const bool &compilationMode,
+    std::shared_ptr<const Plan> plan)
     : graph_(graph), inputs_(inputs), fusionNodeSymbol_(fusionNodeSymbol),
-      compilationMode_(compilationMode) {
-  if (!FLAGS_shapeInferenceOpBlocklist.empty()) {
+      compilationMode_(compilationMode), plan_(std::move(plan)) {
+  // The block list is only used to build the plan.
+  if (!plan_ && !FLAGS_shapeInferenceOpBlocklist.empty()) {
     auto ret = splitStr(FLAGS_shapeInferenceOpBlocklist);
     for (const auto &s : ret) {
       blockList_.insert(s);
@@ -221,6 +223,7 @@ ShapeInferenceEngine::ShapeInferenceEngine(
 
 bool ShapeInferenceEngine::getNodeInputShape(const torch::jit::Node *node,
                                              MetaStack &inputMetas) {
+  inputMetas.reserve(node->inputs().size());
   for (size_t i = 0; i < node->inputs().size(); ++i) {
     auto &input = node->inputs()[i];
     auto it = shapeMap_.find(input);
@@ -229,7 +232,7 @@ bool ShapeInferenceEngine::getNodeInputShape(const torch::jit::Node *node,
                    << "' for node: " << *node;
       return false;
     }
-    inputMetas.emplace_back(shapeMap_[input]);
+    inputMetas.emplace_back(it->second);
   }
   return true;
 }
@@ -243,25 +246,8 @@ ShapeInferenceEngine::getVariableMap() {
   return shapeMap_;
 }
 
-Error ShapeInferenceEngine::shapeOnNode(const torch::jit::Node *node) {
-
-  /// Get op symbol
-  const auto kind = node->kind();
-  const std::string symbol = kind.toQualString();
-
-  auto &mapping = getShapeSymbolMapping();
-  if (!mapping.count(symbol)) {
-    LOG(WARNING) << "Skip shape inference for unsupported op '" << symbol
-                 << "' at " << *node;
-    return Error::success();
-  }
-
-  if (blockList_.count(symbol)) {
-    // Skip shape inference for this node. If other nodes have dependency
-    // on this one then later their shape inference would fail explicitly.
-    LOG(INFO) << "Skip shape inference for " << symbol << " due to block list";
-    return Error::success();
-  }
+Error ShapeInferenceEngine::shapeOnNode(const torch::jit::Node *node,
+                                        const ShapeInference &inference) {
   /// Extract shapes of inputs from shape mapping
   MetaStack inputMetas;
 
@@ -270,16 +256,12 @@ Error ShapeInferenceEngine::shapeOnNode(const torch::jit::Node *node) {
   /// generated by prim::consant or prim::ListContruct.
   bool ret = getNodeInputShape(node, inputMetas);
   if (!ret) {
-    LOG(WARNING) << "Skip shape inference for " << symbol
+    LOG(WARNING) << "Skip shape inference for " << node->kind().toQualString()
                  << " due to prior missing shapes";
     return Error::success();
   }
 
-  auto symbolItem = mapping.find(symbol);
-  if (symbolItem != mapping.end()) {
-    return symbolItem->second.infer(this, inputMetas, node);
-  }
-  return Error::success();
+  return inference.infer(this, inputMetas, node);
 }
 
 Error ShapeInferenceEngine::ShapeInference::infer(
@@ -599,38 +581,77 @@ void ShapeInferenceEngine::addShapeSlice(const torch::jit::Node *node,
       });
 }
 
+Expected<std::shared_ptr<const ShapeInferenceEngine::Plan>>
+ShapeInferenceEngine::buildPlan(const torch::jit::Graph &graph,
+                                bool isSubgraph) const {
+  auto &mapping = getShapeSymbolMapping();
+  int totalFusionNodes = 0;
+  for (auto *node : graph.nodes()) {
+    if (node->kind().toQualString() == fusionNodeSymbol_) {
+      totalFusionNodes += 1;
+    }
+  }
+  auto plan = std::make_shared<Plan>();
+  int fusionNodeIndex = 0;
+  for (auto *node : graph.nodes()) {
+    const std::string symbol = node->kind().toQualString();
+    Plan::Step step;
+    step.node = node;
+    if (node->hasAttribute(torch::jit::attr::Subgraph)) {
+      RETURN_ERR_IF_NOT(!isSubgraph,
+                        "Fusion nodes in fusion groups are not supported");
+      CHECK_EQ(symbol.find(fusionNodeSymbol_), 0);
+      ASSIGN_VALUE_OR_RETURN_ERR(
+          step.subgraph, buildPlan(*node->g(torch::jit::attr::Subgraph),
+                                   /* isSubgraph */ true));
+      fusionNodeIndex += 1;
+    } else if (!isSubgraph && compilationMode_ &&
+               fusionNodeIndex == totalFusionNodes &&
+               FLAGS_skipReferOperatorsOnCpu) {
+      LOG(INFO)
+          << "Skip shape inference for node after fusion groups with kind: "
+          << symbol;
+      continue;
+    } else {
+      auto it = mapping.find(symbol);
+      if (it == mapping.end()) {
+        LOG(WARNING) << "Skip shape inference for unsupported op '" << symbol
+                     << "' at " << *node;
+        continue;
+      }
+      if (blockList_.count(symbol)) {
+        // Skip shape inference for this node. If other nodes have dependency
+        // on this one then later their shape inference would fail explicitly.
+        LOG(INFO) << "Skip shape inference for " << symbol
+                  << " due to block list";
+        continue;
+      }
+      step.inference = &it->second;
+    }
+    plan->steps.push_back(std::move(step));
+  }
+  return std::shared_ptr<const Plan>(std::move(plan));
+}
+
 Error ShapeInferenceEngine::runSubGraph(
-    const torch::jit::Graph &graph,
+    const torch::jit::Graph &graph, const Plan &plan,
     const at::ArrayRef<torch::jit::IValue> &inputs) {
   RETURN_IF_ERR(getGraphInputShapeType(graph, inputs));
-  for (auto *node : graph.nodes()) {
-    CHECK(!node->hasAttribute(torch::jit::attr::Subgraph));
-    RETURN_IF_ERR(shapeOnNode(node));
+  for (const auto &step : plan.steps) {
+    RETURN_IF_ERR(shapeOnNode(step.node, *step.inference));
   }
   return Error::success();
 }
 
 Error ShapeInferenceEngine::runGraph(
-    const torch::jit::Graph &graph,
+    const torch::jit::Graph &graph, const Plan &plan,
     const at::ArrayRef<torch::jit::IValue> &inputs) {
-  {
-    std::ofstream f{"shape_graph.txt"};
-    f << graph;
-  }
   // Populate input shapes
   RETURN_IF_ERR(getGraphInputShapeType(graph, inputs));
-  int totalFusionNodes = 0;
-  for (auto *node : graph.nodes()) {
-    if (node->kind().toQualString() == fusionNodeSymbol_) {
-      totalFusionNodes += 1;
-    }
-  }
-  int fusionNodeIndex = 0;
   /// Run shape inference for each node
-  for (auto *node : graph.nodes()) {
-    if (node->hasAttribute(torch::jit::attr::Subgraph)) {
-      std::string kind = node->kind().toQualString();
-      CHECK_EQ(kind.find(fusionNodeSymbol_), 0);
+  for (const auto &step : plan.steps) {
+    const torch::jit::Node *node = step.node;
+    if (step.subgraph) {
       // After fusion the input Value of the subgraph and
       // input Value of the fusion node are different
       // in memory objects. Therefore we populate inputMeta
@@ -657,23 +678,14 @@ Error ShapeInferenceEngine::runGraph(
       const at::ArrayRef<torch::jit::IValue> inputRefs(subgraphInputs);
 
       auto subgraph = node->g(torch::jit::attr::Subgraph);
-      RETURN_IF_ERR(runSubGraph(*subgraph, subgraphInputs));
+      RETURN_IF_ERR(runSubGraph(*subgraph, *step.subgraph, subgraphInputs));
 
       CHECK_EQ(subgraph->outputs().size(), node->outputs().size());
       for (int i = 0; i < subgraph->outputs().size(); ++i) {
         shapeMap_[node->outputs()[i]] = shapeMap_[subgraph->outputs()[i]];
       }
-      fusionNodeIndex += 1;
     } else {
-      if (compilationMode_ && fusionNodeIndex == totalFusionNodes &&
-          FLAGS_skipReferOperatorsOnCpu) {
-        LOG(INFO)
-            << "Skip shape inference for node after fusion groups with kind: "
-            << node->kind().toQualString();
-        continue;
-      } else {
-        RETURN_IF_ERR(shapeOnNode(node));
-      }
+      RETURN_IF_ERR(shapeOnNode(node, *step.inference));
     }
   }
   return Error::success();
@@ -687,9 +699,15 @@ Error ShapeInferenceEngine::run() {
       "Number of inputs mismatch between Graph and actual inputs");
   if (FLAGS_print_shape_inference_graph) {
     printGraph(graph_, 0);
+    std::ofstream f{"shape_graph.txt"};
+    f << graph_;
+  }
+  if (!plan_) {
+    ASSIGN_VALUE_OR_RETURN_ERR(plan_,
+                               buildPlan(graph_, /* isSubgraph */ false));
   }
   /// Put graph input into shape mapping
-  RETURN_IF_ERR(runGraph(graph_, inputs_));
+  RETURN_IF_ERR(runGraph(graph_, *plan_, inputs_));
   if (!compilationMode_) {
     /// Extract output from shape mapping
     RETURN_IF_ERR(generateGraphOutputShape());
@@ -18,6 +18,7 @@
 #define GLOW_TORCH_GLOW_SRC_SHAPEINFERENCEENGINE_H
 
 #include "boost/variant.hpp"
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -68,10 +69,22 @@ using MetaStack = std::vector<VariableMeta>;
 
 class ShapeInferenceEngine {
 public:
+  /// The shape functions of the nodes of a graph, looked up once so that only
+  /// the functions run when the shapes of new inputs of the graph are inferred.
+  struct Plan;
+
+  /// Infers the shapes of \p graph for \p inputs. If \p plan is given then it
+  /// must come from getPlan() of an engine of the same \p graph,
+  /// \p fusionNodeSymbol and \p compilationMode, otherwise it is built by
+  /// run().
   ShapeInferenceEngine(const torch::jit::Graph &graph,
                        const at::ArrayRef<torch::jit::IValue> &inputs,
                        const std::string &fusionNodeSymbol = "ShapeInf",
-                       const bool &compilationMode = false);
+                       const bool &compilationMode = false,
+                       std::shared_ptr<const Plan> plan = nullptr);
+
+  /// \returns the plan of the graph, nullptr before run().
+  std::shared_ptr<const Plan> getPlan() const { return plan_; }
 
   /// Get all VariableMeta for outputs of the given graph.
   const MetaStack &getGraphOutputShape();
@@ -119,6 +132,9 @@ private:
   /// A set containing all ops that should be skipped during shape inference
   std::unordered_set<std::string> blockList_;
 
+  /// Plan of \p graph_.
+  std::shared_ptr<const Plan> plan_;
+
   /// Store shapes of all the outputs in a graph.
   MetaStack outputShape_;
 
@@ -126,14 +142,19 @@ private:
   /// In Glow, \p hasEndOffset_ always true
   static bool const hasEndOffset_ = true;
 
-  /// Run shape inference on a graph
-  Error runGraph(const torch::jit::Graph &,
+  /// Run shape inference on a graph with its \p plan
+  Error runGraph(const torch::jit::Graph &, const Plan &plan,
                  const at::ArrayRef<torch::jit::IValue> &);
 
-  /// Run shape inference on a sub graph
-  Error runSubGraph(const torch::jit::Graph &,
+  /// Run shape inference on a sub graph with its \p plan
+  Error runSubGraph(const torch::jit::Graph &, const Plan &plan,
                     const at::ArrayRef<torch::jit::IValue> &);
 
+  /// \returns the plan of \p graph, which is the subgraph of a fusion node if
+  /// \p isSubgraph.
+  Expected<std::shared_ptr<const Plan>>
+  buildPlan(const torch::jit::Graph &graph, bool isSubgraph) const;
+
   /// Collects the list of unsupported symbols present in a \p graph
   /// populates the provided set of symbol names
   void findUnsupportedGraphSymbols(const torch::jit::Graph &,
@@ -156,9 +177,6 @@ private:
   /// Extract shape info of node inputs from \p shapeMap_.
   bool getNodeInputShape(const torch::jit::Node *node, MetaStack &inputMetas);
 
-  /// Infer shapes of node outputs
-  Error shapeOnNode(const torch::jit::Node *node);
-
   struct ShapeInference {
     using InferenceFn0 = Expected<TensorOutput> (*)(const MetaStack &);
     using InferenceFn1 = Expected<TensorOutput> (*)(const torch::jit::Node *);
@@ -195,6 +213,26 @@ private:
 
   using SymbolToFunctionMap = std::unordered_map<std::string, ShapeInference>;
 
+  /// Infer shapes of node outputs with its shape function \p inference
+  Error shapeOnNode(const torch::jit::Node *node,
+                    const ShapeInference &inference);
+
+public:
+  struct Plan {
+    struct Step {
+      /// The node whose shapes are inferred.
+      const torch::jit::Node *node;
+      /// Shape function of \p node, nullptr for fusion nodes.
+      const ShapeInference *inference = nullptr;
+      /// Plan of the subgraph of the fusion node \p node.
+      std::shared_ptr<const Plan> subgraph;
+    };
+    /// The nodes in graph order, without the skipped ones.
+    std::vector<Step> steps;
+  };
+
+private:
+
   /// Build mapping from jit symbols to inference functions
   static SymbolToFunctionMap buildShapeSymbolMapping();
 
@@ -297,6 +297,11 @@ PYBIND11_MODULE(_torch_glow, m) {
   m.def("enable_lazy_compile",
         []() { getGlobalPyTorchLoaderSettingsMutable().lazyCompile = true; });
 
+  /// Run the inputs of new shapes on the JIT while Glow compiles them in the
+  /// background.
+  m.def("enable_async_compile",
+        []() { getGlobalPyTorchLoaderSettingsMutable().asyncCompile = true; });
+
   /// Set the number of layers to print when dumpContextOnError is true.
   m.def("set_debug_layers", [](size_t debugLayers) {
     getGlobalPyTorchLoaderSettingsMutable().debugLayers = debugLayers;
@@ -495,6 +500,17 @@ PYBIND11_MODULE(_torch_glow, m) {
     getGlobalPyTorchLoaderSettingsMutable().availableDevices = {};
   });
 
+  /// Load and save the functions compiled by warmCache in the bundle \p path.
+  m.def("set_compiled_functions_bundle", [](const std::string &path) {
+    getGlobalPyTorchLoaderSettingsMutable().compiledFunctionsBundle = path;
+  });
+
+  /// Round the first dimension of the inputs up to one of \p shapeBuckets
+  /// when compiling.
+  m.def("set_shape_buckets", [](std::vector<int64_t> shapeBuckets) {
+    getGlobalPyTorchLoaderSettingsMutable().shapeBuckets = shapeBuckets;
+  });
+
   /// \returns the list of avaialble devices
   m.def("get_available_devices", []() {
     return getGlobalPyTorchLoaderSettingsMutable().availableDevices;
@@ -550,6 +566,41 @@ PYBIND11_MODULE(_torch_glow, m) {
     }
   });
 
+  /// Runs the graph runner registered for \p key on each of the tuples of
+  /// inputs \p batch at once, see CachingGraphRunner::runBatch. \returns the
+  /// list of outputs of every tuple.
+  m.def("run_graph_runner_batch", [](const std::string &key,
+                                     const std::vector<py::tuple> &batch) {
+    auto graphRunner = getGraphRunnerForKey(key);
+    if (!graphRunner) {
+      throw std::runtime_error("No graph runner registered for key: " + key);
+    }
+    std::vector<torch::jit::Stack> stacks(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      for (const auto &arg : batch[i]) {
+        stacks[i].emplace_back(
+            torch::jit::toIValue(arg, c10::TensorType::get()));
+      }
+    }
+    {
+      py::gil_scoped_release release;
+      auto err = graphRunner->runBatch(stacks);
+      if (err) {
+        auto error_message = ERR_TO_STRING(std::move(err));
+        LOG(ERROR) << error_message;
+        throw std::runtime_error("batched run failed with error: " +
+                                 error_message);
+      }
+    }
+    std::vector<py::list> results(stacks.size());
+    for (size_t i = 0; i < stacks.size(); ++i) {
+      for (auto &output : stacks[i]) {
+        results[i].append(torch::jit::toPyObject(std::move(output)));
+      }
+    }
+    return results;
+  });
+
   m.def(
       "glow_shape_inference_find_unsupported_symbols",
       [](std::shared_ptr<torch::jit::Graph> graph, const py::tuple &args,